@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <sstream>
+
+#include "gc/heap.h"
+#include "jni.h"
+#include "runtime.h"
+
+namespace art {
+
+namespace {
+
+extern "C" JNIEXPORT void JNICALL Java_GcBenchmark_resetGcMetrics(JNIEnv*, jclass) {
+  Runtime::Current()->GetHeap()->ResetGcPerformanceInfo();
+}
+
+// The counters of the heap and its collectors as "key=value" lines, see Heap::DumpGcMetrics.
+extern "C" JNIEXPORT jstring JNICALL Java_GcBenchmark_getGcMetrics(JNIEnv* env, jclass) {
+  gc::Heap* heap = Runtime::Current()->GetHeap();
+  std::ostringstream os;
+  os << "collector-type=" << heap->CurrentCollectorType() << "\n"
+     << "gc-count=" << heap->GetGcCount() << "\n"
+     << "gc-time=" << heap->GetGcTime() << "\n"
+     << "blocking-gc-count=" << heap->GetBlockingGcCount() << "\n"
+     << "blocking-gc-time=" << heap->GetBlockingGcTime() << "\n"
+     << "allocation-stall-count=" << heap->GetAllocationStallCount() << "\n"
+     << "allocation-stall-time=" << heap->GetAllocationStallTime() << "\n";
+  heap->DumpGcMetrics(os);
+  return env->NewStringUTF(os.str().c_str());
+}
+
+}  // namespace
+
+}  // namespace art
@@ -0,0 +1,233 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import java.lang.ref.SoftReference;
+import java.util.ArrayList;
+import java.util.Arrays;
+
+// Benchmarks of allocation and garbage collection.
+//
+// The time* methods are run by the benchmark harness. Running the class directly runs each of
+// them once and prints its time followed by the counters of the heap and of its collectors,
+// which include the pause percentiles and the CPU time of the collections, e.g.
+//
+//   dalvikvm -Xgc:CMS -cp gc.jar GcBenchmark [<name of benchmark> ...]
+//
+// The collector is chosen when the runtime starts, so run it with each of -Xgc:MS, -Xgc:CMS,
+// -Xgc:SS, -Xgc:GSS and, on read barrier builds, -Xgc:CC to compare them.
+public class GcBenchmark {
+    // Below the large object threshold of the heap.
+    private static final int SMALL_ARRAY_LENGTH = 64;
+    // Above the large object threshold of the heap, allocated in the large object space.
+    private static final int LARGE_ARRAY_LENGTH = 64 * 1024;
+
+    private static final int TREE_DEPTH = 14;
+    private static final int LONG_LIVED_TREE_DEPTH = 18;
+
+    private static final int CACHE_SIZE = 4096;
+    private static final int CACHE_ENTRY_LENGTH = 1024;
+
+    private static final int ALLOCATIONS_PER_THREAD = 1000000;
+
+    // Written by the benchmarks so that the allocations are not optimized away.
+    public static volatile Object sink;
+
+    static class Node {
+        Node left;
+        Node right;
+        int value;
+
+        Node(Node left, Node right) {
+            this.left = left;
+            this.right = right;
+        }
+    }
+
+    static class Finalizable {
+        static volatile int finalized;
+
+        @Override
+        protected void finalize() {
+            ++finalized;
+        }
+    }
+
+    public void timeAllocSmallObjects(int count) {
+        for (int i = 0; i < count; ++i) {
+            sink = new Node(null, null);
+        }
+    }
+
+    public void timeAllocSmallArrays(int count) {
+        for (int i = 0; i < count; ++i) {
+            sink = new int[SMALL_ARRAY_LENGTH];
+        }
+    }
+
+    public void timeAllocObjectArrays(int count) {
+        for (int i = 0; i < count; ++i) {
+            sink = new Object[SMALL_ARRAY_LENGTH];
+        }
+    }
+
+    public void timeAllocLargeArrays(int count) {
+        for (int i = 0; i < count; ++i) {
+            sink = new byte[LARGE_ARRAY_LENGTH];
+        }
+    }
+
+    private static Node bottomUpTree(int depth) {
+        return (depth == 0) ? new Node(null, null)
+                            : new Node(bottomUpTree(depth - 1), bottomUpTree(depth - 1));
+    }
+
+    private static int itemCheck(Node node) {
+        return (node.left == null) ? 1 : 1 + itemCheck(node.left) + itemCheck(node.right);
+    }
+
+    // Churn of short-lived trees while a long-lived one stays reachable, as in binary-trees.
+    public void timeBinaryTrees(int count) {
+        Node longLivedTree = bottomUpTree(LONG_LIVED_TREE_DEPTH);
+        int check = 0;
+        for (int i = 0; i < count; ++i) {
+            check += itemCheck(bottomUpTree(TREE_DEPTH));
+        }
+        sink = longLivedTree;
+        if (check != count * ((1 << (TREE_DEPTH + 1)) - 1)) {
+            throw new Error("Unexpected check " + check);
+        }
+    }
+
+    // A long-lived cache of softly reachable entries refilled as the collections clear them.
+    public void timeSoftReferenceCache(int count) {
+        @SuppressWarnings("unchecked")
+        SoftReference<byte[]>[] cache = new SoftReference[CACHE_SIZE];
+        for (int i = 0; i < count; ++i) {
+            int index = i % CACHE_SIZE;
+            SoftReference<byte[]> reference = cache[index];
+            byte[] entry = (reference != null) ? reference.get() : null;
+            if (entry == null) {
+                cache[index] = new SoftReference<byte[]>(new byte[CACHE_ENTRY_LENGTH]);
+            }
+            sink = new Node(null, null);
+        }
+        sink = cache;
+    }
+
+    public void timeFinalization(int count) {
+        for (int i = 0; i < count; ++i) {
+            sink = new Finalizable();
+        }
+        System.runFinalization();
+    }
+
+    private static void allocateInThreads(int threadCount) {
+        Thread[] threads = new Thread[threadCount];
+        for (int i = 0; i < threadCount; ++i) {
+            threads[i] = new Thread() {
+                public void run() {
+                    ArrayList<Object> retained = new ArrayList<Object>();
+                    for (int j = 0; j < ALLOCATIONS_PER_THREAD; ++j) {
+                        Object object = new Node(null, null);
+                        // Keep a few objects alive so that the collections have work to do.
+                        if (j % 1024 == 0) {
+                            retained.add(object);
+                        }
+                    }
+                    sink = retained;
+                }
+            };
+        }
+        for (Thread thread : threads) {
+            thread.start();
+        }
+        try {
+            for (Thread thread : threads) {
+                thread.join();
+            }
+        } catch (InterruptedException e) {
+            throw new Error(e);
+        }
+    }
+
+    // The same allocations per thread, the time should not grow with the number of threads.
+    public void timeAllocThreads1(int count) {
+        for (int i = 0; i < count; ++i) {
+            allocateInThreads(1);
+        }
+    }
+
+    public void timeAllocThreads2(int count) {
+        for (int i = 0; i < count; ++i) {
+            allocateInThreads(2);
+        }
+    }
+
+    public void timeAllocThreads4(int count) {
+        for (int i = 0; i < count; ++i) {
+            allocateInThreads(4);
+        }
+    }
+
+    public void timeAllocThreads8(int count) {
+        for (int i = 0; i < count; ++i) {
+            allocateInThreads(8);
+        }
+    }
+
+    static native void resetGcMetrics();
+    static native String getGcMetrics();
+
+    private static final String[] BENCHMARKS = {
+        "AllocSmallObjects", "10000000",
+        "AllocSmallArrays", "5000000",
+        "AllocObjectArrays", "5000000",
+        "AllocLargeArrays", "20000",
+        "BinaryTrees", "200",
+        "SoftReferenceCache", "5000000",
+        "Finalization", "1000000",
+        "AllocThreads1", "5",
+        "AllocThreads2", "5",
+        "AllocThreads4", "5",
+        "AllocThreads8", "5",
+    };
+
+    public static void main(String[] args) throws Exception {
+        GcBenchmark benchmark = new GcBenchmark();
+        for (int i = 0; i < BENCHMARKS.length; i += 2) {
+            String name = BENCHMARKS[i];
+            if (args.length != 0 && !Arrays.asList(args).contains(name)) {
+                continue;
+            }
+            int count = Integer.parseInt(BENCHMARKS[i + 1]);
+            // Start from a collected heap with cleared counters.
+            Runtime.getRuntime().gc();
+            resetGcMetrics();
+            long start = System.nanoTime();
+            GcBenchmark.class.getMethod("time" + name, int.class).invoke(benchmark, count);
+            long time = System.nanoTime() - start;
+            System.out.println("benchmark=" + name);
+            System.out.println("count=" + count);
+            System.out.println("time=" + time);
+            System.out.print(getGcMetrics());
+        }
+        sink = null;
+    }
+
+    static {
+        System.loadLibrary("artbenchmark");
+    }
+}
@@ -0,0 +1,43 @@
+#!/bin/bash
+#
+# Copyright (C) 2017 The Android Open Source Project
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+#
+# Runs InterpreterBenchmark with -Xint under mterp and under the switch interpreter, and writes
+# the results of each to <output directory>/<interpreter>.txt.
+#
+
+if [[ "$#" -lt 2 ]]; then
+  echo "Usage $0 <benchmark dex or jar> <output directory> [<kernel> ...]"
+  echo 'Example: run-interpreter.sh interpreter.jar interpreter InvokeVirtual ThrowCatch'
+  exit 1
+fi
+
+JAR=$1
+OUT_DIR=$2
+shift 2
+
+mkdir -p "$OUT_DIR"
+
+for interpreter in mterp switch; do
+  interpreter_args=()
+  if [[ $interpreter == switch ]]; then
+    interpreter_args+=(-XX:UseSwitchInterpreter)
+  fi
+  output="$OUT_DIR/$interpreter.txt"
+  echo "Running with $interpreter: $output"
+  art -Xint "${interpreter_args[@]}" -cp "$JAR" InterpreterBenchmark "$@" > "$output" || exit 1
+  cat "$output"
+done
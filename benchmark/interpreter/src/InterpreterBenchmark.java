@@ -0,0 +1,225 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import java.util.Arrays;
+
+// Bytecode kernels measuring the dispatch cost of the interpreter.
+//
+// The time* methods are run by the benchmark harness. Running the class directly runs each
+// kernel and prints its time per loop iteration and per bytecode. It is meant to be run with
+// -Xint, with mterp and with the switch interpreter, see run-interpreter.sh, e.g.
+//
+//   dalvikvm -Xint [-XX:UseSwitchInterpreter] -cp interpreter.jar InterpreterBenchmark
+//
+// The number of bytecodes executed per loop iteration of each kernel, in KERNELS, is that of
+// the dx output and has to be updated with the kernel, see dexdump -d.
+public class InterpreterBenchmark {
+    static final Error ERROR = new Error();
+
+    static int staticField;
+    int field;
+
+    interface Callee {
+        int interfaceCallee(int value);
+    }
+
+    static class Base implements Callee {
+        int virtualCallee(int value) {
+            return value + 1;
+        }
+
+        public int interfaceCallee(int value) {
+            return value + 1;
+        }
+
+        int superCallee(int value) {
+            return value + 1;
+        }
+    }
+
+    static class Derived extends Base {
+        int callSuper(int count) {
+            int sum = 0;
+            for (int i = 0; i < count; ++i) {
+                sum += super.superCallee(i);
+            }
+            return sum;
+        }
+    }
+
+    private static final Base BASE = new Base();
+    private static final Callee CALLEE = BASE;
+    private static final Derived DERIVED = new Derived();
+
+    private static int[] array = new int[1024];
+
+    // Written by the kernels so that their results are not unused.
+    public static volatile int sink;
+
+    private static int staticCallee(int value) {
+        return value + 1;
+    }
+
+    private int directCallee(int value) {
+        return value + 1;
+    }
+
+    // if-ge, add-int/2addr, xor-int/2addr, mul-int/lit8, shr-int/lit8, add-int/lit8, goto.
+    public void timeArithmetic(int count) {
+        int a = 1;
+        int b = 2;
+        for (int i = 0; i < count; ++i) {
+            a += i;
+            b ^= a;
+            a *= 3;
+            b >>= 1;
+        }
+        sink = a + b;
+    }
+
+    // if-ge, iget, add-int/2addr, iput, add-int/lit8, goto.
+    public void timeInstanceField(int count) {
+        for (int i = 0; i < count; ++i) {
+            field += i;
+        }
+    }
+
+    // if-ge, sget, add-int/2addr, sput, add-int/lit8, goto.
+    public void timeStaticField(int count) {
+        for (int i = 0; i < count; ++i) {
+            staticField += i;
+        }
+    }
+
+    // if-ge, invoke, move-result, add-int/2addr, add-int/lit8, goto, and add-int/lit8, return
+    // in the callee.
+    public void timeInvokeStatic(int count) {
+        int sum = 0;
+        for (int i = 0; i < count; ++i) {
+            sum += staticCallee(i);
+        }
+        sink = sum;
+    }
+
+    public void timeInvokeDirect(int count) {
+        int sum = 0;
+        for (int i = 0; i < count; ++i) {
+            sum += directCallee(i);
+        }
+        sink = sum;
+    }
+
+    public void timeInvokeVirtual(int count) {
+        Base base = BASE;
+        int sum = 0;
+        for (int i = 0; i < count; ++i) {
+            sum += base.virtualCallee(i);
+        }
+        sink = sum;
+    }
+
+    public void timeInvokeInterface(int count) {
+        Callee callee = CALLEE;
+        int sum = 0;
+        for (int i = 0; i < count; ++i) {
+            sum += callee.interfaceCallee(i);
+        }
+        sink = sum;
+    }
+
+    public void timeInvokeSuper(int count) {
+        sink = DERIVED.callSuper(count);
+    }
+
+    // if-ge, aget, add-int/2addr, add-int/lit8, goto.
+    public void timeArrayRead(int count) {
+        int[] values = array;
+        int length = values.length;
+        int sum = 0;
+        for (int n = 0; n < count; n += length) {
+            for (int i = 0; i < length; ++i) {
+                sum += values[i];
+            }
+        }
+        sink = sum;
+    }
+
+    // if-ge, aput, add-int/lit8, goto.
+    public void timeArrayWrite(int count) {
+        int[] values = array;
+        int length = values.length;
+        for (int n = 0; n < count; n += length) {
+            for (int i = 0; i < length; ++i) {
+                values[i] = i;
+            }
+        }
+    }
+
+    // if-ge, sget-object, throw, move-exception, add-int/lit8, add-int/lit8, goto. The throw and
+    // the search of the catch handler dominate.
+    public void timeThrowCatch(int count) {
+        int caught = 0;
+        for (int i = 0; i < count; ++i) {
+            try {
+                throw ERROR;
+            } catch (Error e) {
+                ++caught;
+            }
+        }
+        sink = caught;
+    }
+
+    // Name, loop iterations, bytecodes per loop iteration.
+    private static final Object[][] KERNELS = {
+        { "Arithmetic", 10000000, 7 },
+        { "InstanceField", 10000000, 6 },
+        { "StaticField", 10000000, 6 },
+        { "InvokeStatic", 5000000, 8 },
+        { "InvokeDirect", 5000000, 8 },
+        { "InvokeVirtual", 5000000, 8 },
+        { "InvokeInterface", 5000000, 8 },
+        { "InvokeSuper", 5000000, 8 },
+        // Multiples of the length of `array`.
+        { "ArrayRead", 10240000, 5 },
+        { "ArrayWrite", 10240000, 4 },
+        { "ThrowCatch", 200000, 7 },
+    };
+
+    public static void main(String[] args) throws Exception {
+        InterpreterBenchmark benchmark = new InterpreterBenchmark();
+        for (Object[] kernel : KERNELS) {
+            String name = (String) kernel[0];
+            if (args.length != 0 && !Arrays.asList(args).contains(name)) {
+                continue;
+            }
+            int count = (Integer) kernel[1];
+            int bytecodes = (Integer) kernel[2];
+            java.lang.reflect.Method method =
+                InterpreterBenchmark.class.getMethod("time" + name, int.class);
+            // Resolve the classes, methods and fields of the kernel before measuring.
+            method.invoke(benchmark, count / 100);
+            long start = System.nanoTime();
+            method.invoke(benchmark, count);
+            long time = System.nanoTime() - start;
+            System.out.println("benchmark=" + name +
+                               " iterations=" + count +
+                               " time-ns=" + time +
+                               " ns-per-iteration=" + ((double) time / count) +
+                               " bytecodes-per-iteration=" + bytecodes +
+                               " ns-per-bytecode=" + ((double) time / count / bytecodes));
+        }
+    }
+}
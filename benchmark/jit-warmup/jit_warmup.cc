@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jit/jit.h"
+#include "jit/jit_code_cache.h"
+#include "jni.h"
+#include "runtime.h"
+#include "thread.h"
+#include "thread_pool.h"
+
+namespace art {
+
+namespace {
+
+// Indices in the array returned by sampleJit, keep in sync with JitWarmupBenchmark.java.
+enum JitSample {
+  kQueueDepth,
+  kCompilations,
+  kOsrCompilations,
+  kCodeCacheSize,
+  kDataCacheSize,
+  kNumberOfSamples,
+};
+
+extern "C" JNIEXPORT jlongArray JNICALL Java_JitWarmupBenchmark_sampleJit(JNIEnv* env, jclass) {
+  jlong samples[kNumberOfSamples] = {};
+  jit::Jit* jit = Runtime::Current()->GetJit();
+  if (jit != nullptr) {
+    ThreadPool* thread_pool = jit->GetThreadPool();
+    if (thread_pool != nullptr) {
+      samples[kQueueDepth] = thread_pool->GetTaskCount(Thread::Current());
+    }
+    jit::JitCodeCache* code_cache = jit->GetCodeCache();
+    samples[kCompilations] = code_cache->NumberOfCompilations();
+    samples[kOsrCompilations] = code_cache->NumberOfOsrCompilations();
+    samples[kCodeCacheSize] = code_cache->CodeCacheSize();
+    samples[kDataCacheSize] = code_cache->DataCacheSize();
+  }
+  jlongArray result = env->NewLongArray(kNumberOfSamples);
+  if (result != nullptr) {
+    env->SetLongArrayRegion(result, 0, kNumberOfSamples, samples);
+  }
+  return result;
+}
+
+}  // namespace
+
+}  // namespace art
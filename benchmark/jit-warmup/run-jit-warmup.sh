@@ -0,0 +1,53 @@
+#!/bin/bash
+#
+# Copyright (C) 2017 The Android Open Source Project
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+#
+# Runs JitWarmupBenchmark with the JIT for each of the JIT thresholds, with and without a
+# profile saved by a previous run, and writes the warmup curve of each run to
+# <output directory>/<threshold>-<profile>.csv.
+#
+
+if [[ "$#" -lt 2 ]]; then
+  echo "Usage $0 <benchmark dex or jar> <output directory> [<iterations> [<thresholds>]]"
+  echo 'Example: run-jit-warmup.sh jit-warmup.jar warmup 200 "default 100 1000 10000"'
+  exit 1
+fi
+
+JAR=$1
+OUT_DIR=$2
+ITERATIONS=${3:-200}
+THRESHOLDS=${4:-"default 100 1000 10000"}
+
+mkdir -p "$OUT_DIR"
+
+for threshold in $THRESHOLDS; do
+  threshold_args=()
+  if [[ $threshold != default ]]; then
+    threshold_args+=("-Xjitthreshold:$threshold")
+  fi
+  for profile in no-profile profile; do
+    art_args=()
+    if [[ $profile == profile ]]; then
+      # Run once to save a profile, then compile with it before the measured run.
+      art_args+=(--profile)
+    fi
+    output="$OUT_DIR/$threshold-$profile.csv"
+    echo "Running with threshold $threshold, $profile: $output"
+    art "${art_args[@]}" -Xusejit:true "${threshold_args[@]}" -cp "$JAR" \
+        JitWarmupBenchmark "$ITERATIONS" > "$output" || exit 1
+    grep -v , "$output"
+  done
+done
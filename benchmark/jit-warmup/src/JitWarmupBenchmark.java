@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.Collections;
+import java.util.Comparator;
+import java.util.HashMap;
+
+// Warmup curve of a workload mixing loops, calls, strings and collections.
+//
+// timeWorkload is run by the benchmark harness, which measures the steady state. Running the
+// class directly runs the workload the given number of times in a fresh runtime and prints, for
+// each iteration, its time and the state of the JIT after it: the depth of the compilation
+// queue, the number of compilations and the size of the code cache. It then prints the warmup
+// summary, see printSummary. run-jit-warmup.sh runs it with several JIT thresholds, with and
+// without a saved profile.
+public class JitWarmupBenchmark {
+    // Indices in the array returned by sampleJit, keep in sync with jit_warmup.cc.
+    private static final int QUEUE_DEPTH = 0;
+    private static final int COMPILATIONS = 1;
+    private static final int OSR_COMPILATIONS = 2;
+    private static final int CODE_CACHE_SIZE = 3;
+    private static final int DATA_CACHE_SIZE = 4;
+
+    // An iteration has reached the steady state when it is within this ratio of the median of
+    // the last quarter of the iterations.
+    private static final double STEADY_STATE_TOLERANCE = 1.10;
+
+    private static final int DEFAULT_ITERATIONS = 200;
+
+    // Written by the workload so that its results are not optimized away.
+    public static volatile int sink;
+
+    static native long[] sampleJit();
+
+    private static int sieve(int limit) {
+        boolean[] composite = new boolean[limit + 1];
+        int primes = 0;
+        for (int i = 2; i <= limit; ++i) {
+            if (!composite[i]) {
+                ++primes;
+                for (int j = i * 2; j <= limit; j += i) {
+                    composite[j] = true;
+                }
+            }
+        }
+        return primes;
+    }
+
+    private static int strings(int count) {
+        int hash = 0;
+        for (int i = 0; i < count; ++i) {
+            StringBuilder builder = new StringBuilder();
+            builder.append("item").append(i).append('-').append(i * 31);
+            hash = hash * 31 + builder.toString().hashCode();
+        }
+        return hash;
+    }
+
+    private static int collections(int count) {
+        HashMap<Integer, Integer> map = new HashMap<Integer, Integer>();
+        ArrayList<Integer> list = new ArrayList<Integer>();
+        for (int i = 0; i < count; ++i) {
+            int key = (i * 7919) % count;
+            Integer previous = map.get(key);
+            map.put(key, (previous == null) ? 1 : previous + 1);
+            list.add(key);
+        }
+        Collections.sort(list, new Comparator<Integer>() {
+            public int compare(Integer lhs, Integer rhs) {
+                return rhs.compareTo(lhs);
+            }
+        });
+        return list.get(0) + map.size();
+    }
+
+    // A small stack machine, for the megamorphic virtual calls.
+    static abstract class Op {
+        abstract int apply(int[] stack, int top);
+    }
+
+    static class Push extends Op {
+        final int value;
+        Push(int value) { this.value = value; }
+        int apply(int[] stack, int top) { stack[top] = value; return top + 1; }
+    }
+
+    static class Add extends Op {
+        int apply(int[] stack, int top) { stack[top - 2] += stack[top - 1]; return top - 1; }
+    }
+
+    static class Mul extends Op {
+        int apply(int[] stack, int top) { stack[top - 2] *= stack[top - 1]; return top - 1; }
+    }
+
+    private static final Op[] PROGRAM = {
+        new Push(3), new Push(4), new Add(), new Push(5), new Mul(), new Push(7), new Add(),
+    };
+
+    private static int interpret(int count) {
+        int[] stack = new int[8];
+        int result = 0;
+        for (int i = 0; i < count; ++i) {
+            int top = 0;
+            for (Op op : PROGRAM) {
+                top = op.apply(stack, top);
+            }
+            result += stack[0];
+        }
+        return result;
+    }
+
+    private static void runWorkload() {
+        sink = sieve(20000) + strings(2000) + collections(5000) + interpret(20000);
+    }
+
+    public void timeWorkload(int count) {
+        for (int i = 0; i < count; ++i) {
+            runWorkload();
+        }
+    }
+
+    private static long median(long[] values, int from, int to) {
+        long[] sorted = Arrays.copyOfRange(values, from, to);
+        Arrays.sort(sorted);
+        return sorted[sorted.length / 2];
+    }
+
+    // Print the time of the first iteration, the steady state time, and the time to peak: the
+    // time spent until the first iteration of the steady state.
+    private static void printSummary(long[] times) {
+        int lastQuarter = Math.max(times.length / 4, 1);
+        long steadyState = median(times, times.length - lastQuarter, times.length);
+        int peakIteration = times.length - 1;
+        long timeToPeak = 0;
+        for (int i = 0; i < times.length; ++i) {
+            if (times[i] <= steadyState * STEADY_STATE_TOLERANCE) {
+                peakIteration = i;
+                break;
+            }
+            timeToPeak += times[i];
+        }
+        System.out.println("first-iteration-time=" + times[0]);
+        System.out.println("steady-state-time=" + steadyState);
+        System.out.println("peak-iteration=" + peakIteration);
+        System.out.println("time-to-peak=" + timeToPeak);
+    }
+
+    public static void main(String[] args) {
+        int iterations = (args.length != 0) ? Integer.parseInt(args[0]) : DEFAULT_ITERATIONS;
+        long[] times = new long[iterations];
+        System.out.println(
+            "iteration,time,queue-depth,compilations,osr-compilations,code-cache,data-cache");
+        for (int i = 0; i < iterations; ++i) {
+            long start = System.nanoTime();
+            runWorkload();
+            times[i] = System.nanoTime() - start;
+            long[] jit = sampleJit();
+            System.out.println(i + "," + times[i] + "," + jit[QUEUE_DEPTH] + "," +
+                               jit[COMPILATIONS] + "," + jit[OSR_COMPILATIONS] + "," +
+                               jit[CODE_CACHE_SIZE] + "," + jit[DATA_CACHE_SIZE]);
+        }
+        printSummary(times);
+    }
+
+    static {
+        System.loadLibrary("artbenchmark");
+    }
+}
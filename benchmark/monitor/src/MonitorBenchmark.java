@@ -0,0 +1,248 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import java.util.Arrays;
+import java.util.concurrent.CyclicBarrier;
+
+// Benchmarks of the monitors: thin locks, recursive locks, contention that inflates the locks,
+// wait/notify, and hash codes that inflate locked objects.
+//
+// The time* methods are run by the benchmark harness. Running the class directly runs each of
+// them and prints the operations per second and the percentiles of the latency of an operation,
+// measured over batches of operations, e.g.
+//
+//   dalvikvm -cp monitor.jar MonitorBenchmark [<name of benchmark> ...]
+public class MonitorBenchmark {
+    // Number of operations of a latency sample.
+    private static final int BATCH_SIZE = 1000;
+
+    private static final int RECURSION_DEPTH = 8;
+
+    private int counter;
+
+    private static void sync(Object lock, MonitorBenchmark benchmark) {
+        synchronized (lock) {
+            ++benchmark.counter;
+        }
+    }
+
+    private static void recursiveSync(Object lock, MonitorBenchmark benchmark, int depth) {
+        synchronized (lock) {
+            if (depth != 0) {
+                recursiveSync(lock, benchmark, depth - 1);
+            } else {
+                ++benchmark.counter;
+            }
+        }
+    }
+
+    public void timeUncontendedThinLock(int count) {
+        Object lock = new Object();
+        for (int i = 0; i < count; ++i) {
+            sync(lock, this);
+        }
+    }
+
+    public void timeRecursiveThinLock(int count) {
+        Object lock = new Object();
+        for (int i = 0; i < count; ++i) {
+            recursiveSync(lock, this, RECURSION_DEPTH);
+        }
+    }
+
+    // A lock inflated by a hash code, then locked without contention.
+    public void timeUncontendedFatLock(int count) {
+        Object lock = new Object();
+        synchronized (lock) {
+            lock.hashCode();
+        }
+        for (int i = 0; i < count; ++i) {
+            sync(lock, this);
+        }
+    }
+
+    // The hash code of a locked object needs the lock to be inflated.
+    public void timeHashCodeInflation(int count) {
+        for (int i = 0; i < count; ++i) {
+            Object lock = new Object();
+            synchronized (lock) {
+                counter += lock.hashCode();
+            }
+        }
+    }
+
+    // Threads ping-pong a token with wait() and notify().
+    public void timeWaitNotifyPingPong(int count) throws Exception {
+        final Object lock = new Object();
+        final boolean[] token = new boolean[1];
+        final int rounds = count;
+        Thread other = new Thread() {
+            public void run() {
+                synchronized (lock) {
+                    for (int i = 0; i < rounds; ++i) {
+                        while (!token[0]) {
+                            waitUninterruptibly(lock);
+                        }
+                        token[0] = false;
+                        lock.notify();
+                    }
+                }
+            }
+        };
+        other.start();
+        synchronized (lock) {
+            for (int i = 0; i < rounds; ++i) {
+                token[0] = true;
+                lock.notify();
+                while (token[0]) {
+                    waitUninterruptibly(lock);
+                }
+            }
+        }
+        other.join();
+    }
+
+    private static void waitUninterruptibly(Object lock) {
+        try {
+            lock.wait();
+        } catch (InterruptedException e) {
+            throw new Error(e);
+        }
+    }
+
+    // `threadCount` threads lock the same object `count` times each, which keeps it inflated.
+    // Records the latency of every batch of operations of every thread in `latencies`, if not
+    // null.
+    private void contend(final int threadCount, final int count, final long[] latencies)
+            throws Exception {
+        final Object lock = new Object();
+        final CyclicBarrier barrier = new CyclicBarrier(threadCount);
+        final MonitorBenchmark benchmark = this;
+        final int batches = count / BATCH_SIZE;
+        Thread[] threads = new Thread[threadCount];
+        for (int t = 0; t < threadCount; ++t) {
+            final int thread = t;
+            threads[t] = new Thread() {
+                public void run() {
+                    try {
+                        barrier.await();
+                    } catch (Exception e) {
+                        throw new Error(e);
+                    }
+                    for (int b = 0; b < batches; ++b) {
+                        long start = System.nanoTime();
+                        for (int i = 0; i < BATCH_SIZE; ++i) {
+                            sync(lock, benchmark);
+                        }
+                        if (latencies != null) {
+                            latencies[thread * batches + b] = System.nanoTime() - start;
+                        }
+                    }
+                }
+            };
+        }
+        for (Thread thread : threads) {
+            thread.start();
+        }
+        for (Thread thread : threads) {
+            thread.join();
+        }
+    }
+
+    public void timeContended2(int count) throws Exception {
+        contend(2, count, null);
+    }
+
+    public void timeContended4(int count) throws Exception {
+        contend(4, count, null);
+    }
+
+    public void timeContended8(int count) throws Exception {
+        contend(8, count, null);
+    }
+
+    public void timeContended16(int count) throws Exception {
+        contend(16, count, null);
+    }
+
+    public void timeContended32(int count) throws Exception {
+        contend(32, count, null);
+    }
+
+    public void timeContended64(int count) throws Exception {
+        contend(64, count, null);
+    }
+
+    private static final String[] SINGLE_THREADED_BENCHMARKS = {
+        "UncontendedThinLock", "RecursiveThinLock", "UncontendedFatLock", "HashCodeInflation",
+        "WaitNotifyPingPong",
+    };
+
+    private static final int[] CONTENDED_THREAD_COUNTS = { 2, 4, 8, 16, 32, 64 };
+
+    private static final int OPERATIONS = 1000000;
+
+    private static void report(String name, long operations, long time, long[] latencies) {
+        Arrays.sort(latencies);
+        System.out.println("benchmark=" + name +
+                           " ops-per-second=" + (operations * 1000000000L / Math.max(time, 1)) +
+                           " latency-p50-ns=" + percentile(latencies, 0.50) +
+                           " latency-p90-ns=" + percentile(latencies, 0.90) +
+                           " latency-p99-ns=" + percentile(latencies, 0.99) +
+                           " latency-max-ns=" + latencies[latencies.length - 1]);
+    }
+
+    // The latencies are per batch, return the latency of an operation.
+    private static long percentile(long[] sortedLatencies, double percentile) {
+        int index = (int) Math.min(sortedLatencies.length - 1, sortedLatencies.length * percentile);
+        return sortedLatencies[index] / BATCH_SIZE;
+    }
+
+    private static boolean selected(String[] args, String name) {
+        return args.length == 0 || Arrays.asList(args).contains(name);
+    }
+
+    public static void main(String[] args) throws Exception {
+        MonitorBenchmark benchmark = new MonitorBenchmark();
+        for (String name : SINGLE_THREADED_BENCHMARKS) {
+            if (!selected(args, name)) {
+                continue;
+            }
+            java.lang.reflect.Method method =
+                MonitorBenchmark.class.getMethod("time" + name, int.class);
+            long[] latencies = new long[OPERATIONS / BATCH_SIZE];
+            long start = System.nanoTime();
+            for (int b = 0; b < latencies.length; ++b) {
+                long batchStart = System.nanoTime();
+                method.invoke(benchmark, BATCH_SIZE);
+                latencies[b] = System.nanoTime() - batchStart;
+            }
+            report(name, OPERATIONS, System.nanoTime() - start, latencies);
+        }
+        for (int threadCount : CONTENDED_THREAD_COUNTS) {
+            String name = "Contended" + threadCount;
+            if (!selected(args, name)) {
+                continue;
+            }
+            int count = OPERATIONS / threadCount;
+            long[] latencies = new long[threadCount * (count / BATCH_SIZE)];
+            long start = System.nanoTime();
+            benchmark.contend(threadCount, count, latencies);
+            report(name, (long) threadCount * (count / BATCH_SIZE) * BATCH_SIZE,
+                   System.nanoTime() - start, latencies);
+        }
+    }
+}
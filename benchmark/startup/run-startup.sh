@@ -0,0 +1,52 @@
+#!/bin/bash
+#
+# Copyright (C) 2017 The Android Open Source Project
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+#
+# Runs dalvikvm with -XX:DumpStartupPhases, cold (after dropping the page cache, which needs
+# root) and warm, and prints the startup phases of every run, one "key=value" line per phase:
+#
+#   run=cold iteration=0 startup-phase name=Heap start-ns=... wall-time-ns=... major-faults=...
+#
+# The phases and their counters are described in runtime/startup_phases.h.
+#
+
+if [[ "$#" -lt 2 ]]; then
+  echo "Usage $0 <iterations> <dalvikvm arguments>"
+  echo 'Example: run-startup.sh 10 -cp hello.jar Main'
+  exit 1
+fi
+
+ITERATIONS=$1
+shift
+
+drop_caches() {
+  sync
+  if ! echo 3 > /proc/sys/vm/drop_caches; then
+    echo "Cannot drop the page cache, run as root for cold runs" >&2
+    exit 1
+  fi
+}
+
+for run in cold warm; do
+  for ((i = 0; i < ITERATIONS; ++i)); do
+    if [[ $run == cold ]]; then
+      drop_caches
+    fi
+    # The phases are logged at INFO level when the runtime shuts down.
+    ANDROID_LOG_TAGS="*:i" dalvikvm -XX:DumpStartupPhases "$@" 2>&1 >/dev/null \
+        | grep -o "startup-.*" | sed -e "s/^/run=$run iteration=$i /"
+  done
+done
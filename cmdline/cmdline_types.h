@@ -510,6 +510,9 @@ struct XGcOption {
   // Do no measurements for kUseTableLookupReadBarrier to avoid test timeouts. b/31679493
   bool measure_ = kIsDebugBuild && !kUseTableLookupReadBarrier;
   bool gcstress_ = false;
+  // Use young (sticky) collections in between full collections with the concurrent copying
+  // collector.
+  bool generational_cc_ = false;
 };
 
 template <>
@@ -553,6 +556,10 @@ struct CmdlineType<XGcOption> : CmdlineTypeParser<XGcOption> {
         xgc.gcstress_ = false;
       } else if (gc_option == "measure") {
         xgc.measure_ = true;
+      } else if (gc_option == "generational_cc") {
+        xgc.generational_cc_ = true;
+      } else if (gc_option == "nogenerational_cc") {
+        xgc.generational_cc_ = false;
       } else if ((gc_option == "precise") ||
                  (gc_option == "noprecise") ||
                  (gc_option == "verifycardtable") ||
@@ -717,6 +724,11 @@ struct CmdlineType<ProfileSaverOptions> : CmdlineTypeParser<ProfileSaverOptions>
       return Result::SuccessNoValue();
     }
 
+    if (option == "delta-writes") {
+      existing.delta_writes_ = true;
+      return Result::SuccessNoValue();
+    }
+
     // The rest of these options are always the wildcard from '-Xps-*'
     std::string suffix = RemovePrefix(option);
 
@@ -25,6 +25,7 @@ namespace art {
 
 namespace jit {
   class JitCodeCache;
+  class JitDebugInfoPacker;
   class JitLogger;
 }  // namespace jit
 namespace mirror {
@@ -78,7 +79,9 @@ class Compiler {
                           jit::JitCodeCache* code_cache ATTRIBUTE_UNUSED,
                           ArtMethod* method ATTRIBUTE_UNUSED,
                           bool osr ATTRIBUTE_UNUSED,
-                          jit::JitLogger* jit_logger ATTRIBUTE_UNUSED)
+                          bool baseline ATTRIBUTE_UNUSED,
+                          jit::JitLogger* jit_logger ATTRIBUTE_UNUSED,
+                          jit::JitDebugInfoPacker* debug_info_packer ATTRIBUTE_UNUSED)
       REQUIRES_SHARED(Locks::mutator_lock_) {
     return false;
   }
@@ -167,6 +167,40 @@ static void WriteCIE(InstructionSet isa,
   UNREACHABLE();
 }
 
+// Writes .eh_frame and .eh_frame_hdr for a single method into an empty buffer. Addresses are
+// relative to the start of the code, with .eh_frame at the code size rounded up to 8 bytes and
+// .eh_frame_hdr right after it. Returns the size of the .eh_frame_hdr part.
+static size_t WriteEhFrameAfterCode(InstructionSet isa,
+                                    const MethodDebugInfo& method_info,
+                                    std::vector<uint8_t>* buffer) {
+  DCHECK(buffer->empty());
+  DCHECK(!method_info.cfi.empty());
+  const bool is64bit = Is64BitInstructionSet(isa);
+  const uint64_t code_address = 0;
+  const uint64_t cfi_address = RoundUp(method_info.code_size, 8);
+  WriteCIE(isa, dwarf::DW_EH_FRAME_FORMAT, buffer);
+  const uint64_t fde_address = cfi_address + buffer->size();
+  std::vector<uintptr_t> patch_locations;  // Not used for .eh_frame.
+  WriteFDE(is64bit, cfi_address, cfi_address,
+           code_address, method_info.code_size,
+           method_info.cfi, dwarf::DW_EH_FRAME_FORMAT, cfi_address, buffer,
+           &patch_locations);
+  const size_t cfi_size = buffer->size();
+
+  // Same .eh_frame_hdr as in WriteCFISection, with a single binary search table entry.
+  const uint64_t header_address = cfi_address + cfi_size;
+  dwarf::Writer<> header(buffer);
+  header.PushUint8(1);  // Version.
+  header.PushUint8(dwarf::DW_EH_PE_pcrel | dwarf::DW_EH_PE_sdata4);
+  header.PushUint8(dwarf::DW_EH_PE_udata4);
+  header.PushUint8(dwarf::DW_EH_PE_datarel | dwarf::DW_EH_PE_sdata4);
+  header.PushInt32(static_cast<int32_t>(cfi_address - (header_address + 4u)));
+  header.PushUint32(1u);
+  header.PushInt32(static_cast<int32_t>(code_address - header_address));
+  header.PushInt32(static_cast<int32_t>(fde_address - header_address));
+  return buffer->size() - cfi_size;
+}
+
 template<typename ElfTypes>
 void WriteCFISection(ElfBuilder<ElfTypes>* builder,
                      const ArrayRef<const MethodDebugInfo>& method_infos,
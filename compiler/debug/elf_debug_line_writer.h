@@ -24,6 +24,7 @@
 #include "debug/dwarf/debug_line_opcode_writer.h"
 #include "debug/dwarf/headers.h"
 #include "debug/elf_compilation_unit.h"
+#include "debug/elf_debug_writer.h"
 #include "dex_file-inl.h"
 #include "elf_builder.h"
 #include "stack_map.h"
@@ -38,6 +39,108 @@ static bool PositionInfoCallback(void* ctx, const DexFile::PositionInfo& entry)
   return false;
 }
 
+// Computes the line table of the method. Consecutive rows with the same line are merged.
+// Returns false if the method has no stack maps or no dex position information.
+static bool MakeLineTable(const MethodDebugInfo* mi, InstructionSet isa, LineTable* line_table) {
+  uint32_t prologue_end = std::numeric_limits<uint32_t>::max();
+  std::vector<SrcMapElem> pc2dex_map;
+  if (mi->code_info != nullptr) {
+    // Use stack maps to create mapping table from pc to dex.
+    const CodeInfo code_info(mi->code_info);
+    const CodeInfoEncoding encoding = code_info.ExtractEncoding();
+    pc2dex_map.reserve(code_info.GetNumberOfStackMaps(encoding));
+    for (uint32_t s = 0; s < code_info.GetNumberOfStackMaps(encoding); s++) {
+      StackMap stack_map = code_info.GetStackMapAt(s, encoding);
+      DCHECK(stack_map.IsValid());
+      const uint32_t pc = stack_map.GetNativePcOffset(encoding.stack_map.encoding, isa);
+      const int32_t dex = stack_map.GetDexPc(encoding.stack_map.encoding);
+      pc2dex_map.push_back({pc, dex});
+      if (stack_map.HasDexRegisterMap(encoding.stack_map.encoding)) {
+        // Guess that the first map with local variables is the end of prologue.
+        prologue_end = std::min(prologue_end, pc);
+      }
+    }
+    std::sort(pc2dex_map.begin(), pc2dex_map.end());
+  }
+
+  if (pc2dex_map.empty()) {
+    return false;
+  }
+
+  // Compensate for compiler's off-by-one-instruction error.
+  //
+  // The compiler generates stackmap with PC *after* the branch instruction
+  // (because this is the PC which is easier to obtain when unwinding).
+  //
+  // However, the debugger is more clever and it will ask us for line-number
+  // mapping at the location of the branch instruction (since the following
+  // instruction could belong to other line, this is the correct thing to do).
+  //
+  // So we really want to just decrement the PC by one instruction so that the
+  // branch instruction is covered as well. However, we do not know the size
+  // of the previous instruction, and we can not subtract just a fixed amount
+  // (the debugger would trust us that the PC is valid; it might try to set
+  // breakpoint there at some point, and setting breakpoint in mid-instruction
+  // would make the process crash in spectacular way).
+  //
+  // Therefore, we say that the PC which the compiler gave us for the stackmap
+  // is the end of its associated address range, and we use the PC from the
+  // previous stack map as the start of the range. This ensures that the PC is
+  // valid and that the branch instruction is covered.
+  //
+  // This ensures we have correct line number mapping at call sites (which is
+  // important for backtraces), but there is nothing we can do for non-call
+  // sites (so stepping through optimized code in debugger is not possible).
+  //
+  // We do not adjust the stackmaps if the code was compiled as debuggable.
+  // In that case, the stackmaps should accurately cover all instructions.
+  if (!mi->is_native_debuggable) {
+    for (size_t i = pc2dex_map.size() - 1; i > 0; --i) {
+      pc2dex_map[i].from_ = pc2dex_map[i - 1].from_;
+    }
+    pc2dex_map[0].from_ = 0;
+  }
+
+  PositionInfos dex2line_map;
+  DCHECK(mi->dex_file != nullptr);
+  const DexFile* dex = mi->dex_file;
+  if (!dex->DecodeDebugPositionInfo(mi->code_item, PositionInfoCallback, &dex2line_map)) {
+    return false;
+  }
+
+  if (dex2line_map.empty()) {
+    return false;
+  }
+
+  line_table->clear();
+  for (SrcMapElem pc2dex : pc2dex_map) {
+    uint32_t pc = pc2dex.from_;
+    int dex_pc = pc2dex.to_;
+    // Find mapping with address with is greater than our dex pc; then go back one step.
+    auto dex2line = std::upper_bound(
+        dex2line_map.begin(),
+        dex2line_map.end(),
+        dex_pc,
+        [](uint32_t address, const DexFile::PositionInfo& entry) {
+            return address < entry.address_;
+        });
+    // Look for first valid mapping after the prologue.
+    if (dex2line != dex2line_map.begin() && pc >= prologue_end) {
+      int line = (--dex2line)->line_;
+      if (line_table->empty()) {
+        if (pc > 0) {
+          // Assume that any preceding code is prologue.
+          line_table->push_back({0, static_cast<int32_t>(dex2line_map.front().line_), true});
+        }
+        line_table->push_back({pc, line, false});
+      } else if (line != line_table->back().line) {
+        line_table->push_back({pc, line, false});
+      }
+    }
+  }
+  return true;
+}
+
 template<typename ElfTypes>
 class ElfDebugLineWriter {
   using Elf_Addr = typename ElfTypes::Addr;
@@ -94,77 +197,13 @@ class ElfDebugLineWriter {
         continue;
       }
 
-      uint32_t prologue_end = std::numeric_limits<uint32_t>::max();
-      std::vector<SrcMapElem> pc2dex_map;
-      if (mi->code_info != nullptr) {
-        // Use stack maps to create mapping table from pc to dex.
-        const CodeInfo code_info(mi->code_info);
-        const CodeInfoEncoding encoding = code_info.ExtractEncoding();
-        pc2dex_map.reserve(code_info.GetNumberOfStackMaps(encoding));
-        for (uint32_t s = 0; s < code_info.GetNumberOfStackMaps(encoding); s++) {
-          StackMap stack_map = code_info.GetStackMapAt(s, encoding);
-          DCHECK(stack_map.IsValid());
-          const uint32_t pc = stack_map.GetNativePcOffset(encoding.stack_map.encoding, isa);
-          const int32_t dex = stack_map.GetDexPc(encoding.stack_map.encoding);
-          pc2dex_map.push_back({pc, dex});
-          if (stack_map.HasDexRegisterMap(encoding.stack_map.encoding)) {
-            // Guess that the first map with local variables is the end of prologue.
-            prologue_end = std::min(prologue_end, pc);
-          }
-        }
-        std::sort(pc2dex_map.begin(), pc2dex_map.end());
-      }
-
-      if (pc2dex_map.empty()) {
+      LineTable line_table;
+      if (!MakeLineTable(mi, isa, &line_table)) {
         continue;
       }
 
-      // Compensate for compiler's off-by-one-instruction error.
-      //
-      // The compiler generates stackmap with PC *after* the branch instruction
-      // (because this is the PC which is easier to obtain when unwinding).
-      //
-      // However, the debugger is more clever and it will ask us for line-number
-      // mapping at the location of the branch instruction (since the following
-      // instruction could belong to other line, this is the correct thing to do).
-      //
-      // So we really want to just decrement the PC by one instruction so that the
-      // branch instruction is covered as well. However, we do not know the size
-      // of the previous instruction, and we can not subtract just a fixed amount
-      // (the debugger would trust us that the PC is valid; it might try to set
-      // breakpoint there at some point, and setting breakpoint in mid-instruction
-      // would make the process crash in spectacular way).
-      //
-      // Therefore, we say that the PC which the compiler gave us for the stackmap
-      // is the end of its associated address range, and we use the PC from the
-      // previous stack map as the start of the range. This ensures that the PC is
-      // valid and that the branch instruction is covered.
-      //
-      // This ensures we have correct line number mapping at call sites (which is
-      // important for backtraces), but there is nothing we can do for non-call
-      // sites (so stepping through optimized code in debugger is not possible).
-      //
-      // We do not adjust the stackmaps if the code was compiled as debuggable.
-      // In that case, the stackmaps should accurately cover all instructions.
-      if (!mi->is_native_debuggable) {
-        for (size_t i = pc2dex_map.size() - 1; i > 0; --i) {
-          pc2dex_map[i].from_ = pc2dex_map[i - 1].from_;
-        }
-        pc2dex_map[0].from_ = 0;
-      }
-
       Elf_Addr method_address = base_address + mi->code_address;
-
-      PositionInfos dex2line_map;
-      DCHECK(mi->dex_file != nullptr);
       const DexFile* dex = mi->dex_file;
-      if (!dex->DecodeDebugPositionInfo(mi->code_item, PositionInfoCallback, &dex2line_map)) {
-        continue;
-      }
-
-      if (dex2line_map.empty()) {
-        continue;
-      }
 
       opcodes.SetAddress(method_address);
       if (dwarf_isa != -1) {
@@ -222,37 +261,15 @@ class ElfDebugLineWriter {
         // lines, but we try to prevent the debugger from stepping and setting breakpoints since
         // the information is too inaccurate for that (breakpoints would be set after the calls).
         const bool default_is_stmt = mi->is_native_debuggable;
-        bool first = true;
-        for (SrcMapElem pc2dex : pc2dex_map) {
-          uint32_t pc = pc2dex.from_;
-          int dex_pc = pc2dex.to_;
-          // Find mapping with address with is greater than our dex pc; then go back one step.
-          auto dex2line = std::upper_bound(
-              dex2line_map.begin(),
-              dex2line_map.end(),
-              dex_pc,
-              [](uint32_t address, const DexFile::PositionInfo& entry) {
-                  return address < entry.address_;
-              });
-          // Look for first valid mapping after the prologue.
-          if (dex2line != dex2line_map.begin() && pc >= prologue_end) {
-            int line = (--dex2line)->line_;
-            if (first) {
-              first = false;
-              if (pc > 0) {
-                // Assume that any preceding code is prologue.
-                int first_line = dex2line_map.front().line_;
-                // Prologue is not a sensible place for a breakpoint.
-                opcodes.SetIsStmt(false);
-                opcodes.AddRow(method_address, first_line);
-                opcodes.SetPrologueEnd();
-              }
-              opcodes.SetIsStmt(default_is_stmt);
-              opcodes.AddRow(method_address + pc, line);
-            } else if (line != opcodes.CurrentLine()) {
-              opcodes.SetIsStmt(default_is_stmt);
-              opcodes.AddRow(method_address + pc, line);
-            }
+        for (const LineTableRow& row : line_table) {
+          if (row.is_prologue) {
+            // Prologue is not a sensible place for a breakpoint.
+            opcodes.SetIsStmt(false);
+            opcodes.AddRow(method_address + row.pc, row.line);
+            opcodes.SetPrologueEnd();
+          } else {
+            opcodes.SetIsStmt(default_is_stmt);
+            opcodes.AddRow(method_address + row.pc, row.line);
           }
         }
       } else {
@@ -94,19 +94,22 @@ std::vector<uint8_t> MakeMiniDebugInfo(
     const InstructionSetFeatures* features,
     size_t rodata_size,
     size_t text_size,
-    const ArrayRef<const MethodDebugInfo>& method_infos) {
+    const ArrayRef<const MethodDebugInfo>& method_infos,
+    size_t thread_count) {
   if (Is64BitInstructionSet(isa)) {
     return MakeMiniDebugInfoInternal<ElfTypes64>(isa,
                                                  features,
                                                  rodata_size,
                                                  text_size,
-                                                 method_infos);
+                                                 method_infos,
+                                                 thread_count);
   } else {
     return MakeMiniDebugInfoInternal<ElfTypes32>(isa,
                                                  features,
                                                  rodata_size,
                                                  text_size,
-                                                 method_infos);
+                                                 method_infos,
+                                                 thread_count);
   }
 }
 
@@ -174,6 +177,18 @@ std::vector<uint8_t> WriteDebugElfFileForClasses(InstructionSet isa,
   }
 }
 
+size_t WriteEhFrameForMethodAfterCode(InstructionSet isa,
+                                      const MethodDebugInfo& method_info,
+                                      std::vector<uint8_t>* buffer) {
+  return WriteEhFrameAfterCode(isa, method_info, buffer);
+}
+
+bool MakeLineTableForMethod(InstructionSet isa,
+                            const MethodDebugInfo& method_info,
+                            LineTable* line_table) {
+  return MakeLineTable(&method_info, isa, line_table);
+}
+
 std::vector<MethodDebugInfo> MakeTrampolineInfos(const OatHeader& header) {
   std::map<const char*, uint32_t> trampolines = {
     { "interpreterToInterpreterBridge", header.GetInterpreterToInterpreterBridgeOffset() },
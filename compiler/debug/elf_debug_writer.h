@@ -45,7 +45,8 @@ std::vector<uint8_t> MakeMiniDebugInfo(
     const InstructionSetFeatures* features,
     size_t rodata_section_size,
     size_t text_section_size,
-    const ArrayRef<const MethodDebugInfo>& method_infos);
+    const ArrayRef<const MethodDebugInfo>& method_infos,
+    size_t thread_count);
 
 std::vector<uint8_t> WriteDebugElfFileForMethods(
     InstructionSet isa,
@@ -60,6 +61,28 @@ std::vector<uint8_t> WriteDebugElfFileForClasses(
 
 std::vector<MethodDebugInfo> MakeTrampolineInfos(const OatHeader& oat_header);
 
+// Writes the .eh_frame of a single method followed by its .eh_frame_hdr, laid out as if both
+// directly followed the code, aligned to 8 bytes. This is what the unwinding info records of
+// perf jitdump files expect. Returns the size of the .eh_frame_hdr part.
+size_t WriteEhFrameForMethodAfterCode(InstructionSet isa,
+                                      const MethodDebugInfo& method_info,
+                                      std::vector<uint8_t>* buffer);
+
+// A row of the mapping from native pc (relative to the start of the method) to Java line.
+struct LineTableRow {
+  uint32_t pc;
+  int32_t line;
+  bool is_prologue;
+};
+
+typedef std::vector<LineTableRow> LineTable;
+
+// Computes the line table of the method, the same one that goes into .debug_line.
+// Returns false if the method has no stack maps or no dex position information.
+bool MakeLineTableForMethod(InstructionSet isa,
+                            const MethodDebugInfo& method_info,
+                            LineTable* line_table);
+
 }  // namespace debug
 }  // namespace art
 
@@ -20,69 +20,214 @@
 #include <vector>
 
 #include "arch/instruction_set.h"
+#include "base/array_ref.h"
 #include "elf_builder.h"
 #include "linker/vector_output_stream.h"
+#include "thread-current-inl.h"
+#include "thread_pool.h"
 
 // liblzma.
 #include "7zCrc.h"
+#include "Xz.h"
 #include "XzCrc64.h"
 #include "XzEnc.h"
 
 namespace art {
 namespace debug {
 
-static void XzCompress(const std::vector<uint8_t>* src, std::vector<uint8_t>* dst) {
-  // Configure the compression library.
+// Uncompressed size of the blocks of the xz stream compressed on several threads.
+static constexpr size_t kXzBlockSize = 1 * MB;
+
+// Implement the required interface for communication (written in C so no virtual methods).
+struct XzCallbacks : public ISeqInStream, public ISeqOutStream, public ICompressProgress {
+  XzCallbacks(ArrayRef<const uint8_t> src, std::vector<uint8_t>* dst)
+      : src_pos_(0), src_(src), dst_(dst) {
+    Read = ReadImpl;
+    Write = WriteImpl;
+    Progress = ProgressImpl;
+  }
+
+  static SRes ReadImpl(void* p, void* buf, size_t* size) {
+    auto* ctx = static_cast<XzCallbacks*>(reinterpret_cast<ISeqInStream*>(p));
+    *size = std::min(*size, ctx->src_.size() - ctx->src_pos_);
+    memcpy(buf, ctx->src_.data() + ctx->src_pos_, *size);
+    ctx->src_pos_ += *size;
+    return SZ_OK;
+  }
+  static size_t WriteImpl(void* p, const void* buf, size_t size) {
+    auto* ctx = static_cast<XzCallbacks*>(reinterpret_cast<ISeqOutStream*>(p));
+    const uint8_t* buffer = reinterpret_cast<const uint8_t*>(buf);
+    ctx->dst_->insert(ctx->dst_->end(), buffer, buffer + size);
+    return size;
+  }
+  static SRes ProgressImpl(void* , UInt64, UInt64) {
+    return SZ_OK;
+  }
+  size_t src_pos_;
+  ArrayRef<const uint8_t> src_;
+  std::vector<uint8_t>* dst_;
+};
+
+static void XzInitProps(CLzma2EncProps* lzma2Props) {
   CrcGenerateTable();
   Crc64GenerateTable();
+  Lzma2EncProps_Init(lzma2Props);
+  lzma2Props->lzmaProps.level = 1;  // Fast compression.
+  Lzma2EncProps_Normalize(lzma2Props);
+}
+
+static void XzCompressSingleBlock(const std::vector<uint8_t>* src, std::vector<uint8_t>* dst) {
+  // Configure the compression library.
   CLzma2EncProps lzma2Props;
-  Lzma2EncProps_Init(&lzma2Props);
-  lzma2Props.lzmaProps.level = 1;  // Fast compression.
-  Lzma2EncProps_Normalize(&lzma2Props);
+  XzInitProps(&lzma2Props);
   CXzProps props;
   XzProps_Init(&props);
   props.lzma2Props = &lzma2Props;
-  // Implement the required interface for communication (written in C so no virtual methods).
-  struct XzCallbacks : public ISeqInStream, public ISeqOutStream, public ICompressProgress {
-    static SRes ReadImpl(void* p, void* buf, size_t* size) {
-      auto* ctx = static_cast<XzCallbacks*>(reinterpret_cast<ISeqInStream*>(p));
-      *size = std::min(*size, ctx->src_->size() - ctx->src_pos_);
-      memcpy(buf, ctx->src_->data() + ctx->src_pos_, *size);
-      ctx->src_pos_ += *size;
-      return SZ_OK;
-    }
-    static size_t WriteImpl(void* p, const void* buf, size_t size) {
-      auto* ctx = static_cast<XzCallbacks*>(reinterpret_cast<ISeqOutStream*>(p));
-      const uint8_t* buffer = reinterpret_cast<const uint8_t*>(buf);
-      ctx->dst_->insert(ctx->dst_->end(), buffer, buffer + size);
-      return size;
-    }
-    static SRes ProgressImpl(void* , UInt64, UInt64) {
-      return SZ_OK;
-    }
-    size_t src_pos_;
-    const std::vector<uint8_t>* src_;
-    std::vector<uint8_t>* dst_;
-  };
-  XzCallbacks callbacks;
-  callbacks.Read = XzCallbacks::ReadImpl;
-  callbacks.Write = XzCallbacks::WriteImpl;
-  callbacks.Progress = XzCallbacks::ProgressImpl;
-  callbacks.src_pos_ = 0;
-  callbacks.src_ = src;
-  callbacks.dst_ = dst;
+  XzCallbacks callbacks(ArrayRef<const uint8_t>(*src), dst);
   // Compress.
   SRes res = Xz_Encode(&callbacks, &callbacks, &props, &callbacks);
   CHECK_EQ(res, SZ_OK);
 }
 
+static void* XzAlloc(void* , size_t size) {
+  return malloc(size);
+}
+
+static void XzFree(void* , void* address) {
+  free(address);
+}
+
+// Compress `src` to raw LZMA2 data, returns the LZMA2 dictionary size property.
+static uint8_t XzCompressRawBlock(ArrayRef<const uint8_t> src,
+                                  const CLzma2EncProps* lzma2Props,
+                                  std::vector<uint8_t>* dst) {
+  ISzAlloc alloc = { XzAlloc, XzFree };
+  CLzma2EncHandle encoder = Lzma2Enc_Create(&alloc, &alloc);
+  CHECK(encoder != nullptr);
+  CHECK_EQ(Lzma2Enc_SetProps(encoder, lzma2Props), SZ_OK);
+  uint8_t dict_size_prop = Lzma2Enc_WriteProperties(encoder);
+  XzCallbacks callbacks(src, dst);
+  SRes res = Lzma2Enc_Encode(encoder, &callbacks, &callbacks, &callbacks);
+  CHECK_EQ(res, SZ_OK);
+  Lzma2Enc_Destroy(encoder);
+  return dict_size_prop;
+}
+
+static void XzWriteUint32(uint32_t value, std::vector<uint8_t>* dst) {
+  for (size_t i = 0; i != sizeof(uint32_t); ++i) {
+    dst->push_back(static_cast<uint8_t>(value >> (8 * i)));
+  }
+}
+
+static void XzWriteVarInt(uint64_t value, std::vector<uint8_t>* dst) {
+  Byte buffer[9];
+  unsigned size = Xz_WriteVarInt(buffer, value);
+  dst->insert(dst->end(), buffer, buffer + size);
+}
+
+static void XzWriteCrc32(size_t begin, std::vector<uint8_t>* dst) {
+  XzWriteUint32(CrcCalc(dst->data() + begin, dst->size() - begin), dst);
+}
+
+// Compress `src` to an xz stream. With several threads, the stream has blocks of kXzBlockSize
+// bytes compressed independently in parallel, which decompress to the same data. This costs
+// little compression since the dictionary of the fast level is much smaller than a block.
+static void XzCompress(const std::vector<uint8_t>* src,
+                       std::vector<uint8_t>* dst,
+                       size_t thread_count) {
+  size_t num_blocks = RoundUp(src->size(), kXzBlockSize) / kXzBlockSize;
+  if (thread_count <= 1u || num_blocks <= 1u) {
+    XzCompressSingleBlock(src, dst);
+    return;
+  }
+  CLzma2EncProps lzma2Props;
+  XzInitProps(&lzma2Props);
+  std::vector<std::vector<uint8_t>> blocks(num_blocks);
+  std::vector<uint8_t> dict_size_props(num_blocks);
+  class XzBlockTask FINAL : public Task {
+   public:
+    XzBlockTask(ArrayRef<const uint8_t> src,
+                const CLzma2EncProps* lzma2Props,
+                std::vector<uint8_t>* dst,
+                uint8_t* dict_size_prop)
+        : src_(src), lzma2Props_(lzma2Props), dst_(dst), dict_size_prop_(dict_size_prop) {}
+
+    void Run(Thread*) OVERRIDE {
+      *dict_size_prop_ = XzCompressRawBlock(src_, lzma2Props_, dst_);
+    }
+
+   private:
+    const ArrayRef<const uint8_t> src_;
+    const CLzma2EncProps* const lzma2Props_;
+    std::vector<uint8_t>* const dst_;
+    uint8_t* const dict_size_prop_;
+  };
+  std::vector<std::unique_ptr<XzBlockTask>> tasks;
+  tasks.reserve(num_blocks);
+  Thread* self = Thread::Current();
+  // The current thread is one of the threads.
+  ThreadPool thread_pool("Mini-debug-info compressor", std::min(thread_count, num_blocks) - 1u);
+  for (size_t i = 0; i != num_blocks; ++i) {
+    size_t begin = i * kXzBlockSize;
+    ArrayRef<const uint8_t> block_src = ArrayRef<const uint8_t>(*src).SubArray(
+        begin, std::min(kXzBlockSize, src->size() - begin));
+    tasks.emplace_back(new XzBlockTask(block_src, &lzma2Props, &blocks[i], &dict_size_props[i]));
+    thread_pool.AddTask(self, tasks.back().get());
+  }
+  thread_pool.StartWorkers(self);
+  thread_pool.Wait(self, /* do_work */ true, /* may_hold_locks */ false);
+
+  // Stream header.
+  const uint8_t stream_flags[XZ_STREAM_FLAGS_SIZE] = { 0u, XZ_CHECK_CRC32 };
+  dst->insert(dst->end(), XZ_SIG, XZ_SIG + XZ_SIG_SIZE);
+  size_t flags_begin = dst->size();
+  dst->insert(dst->end(), stream_flags, stream_flags + XZ_STREAM_FLAGS_SIZE);
+  XzWriteCrc32(flags_begin, dst);
+  // Blocks, each with a header describing only the LZMA2 filter, and a CRC32 of its data.
+  static constexpr size_t kBlockHeaderSize = 12u;
+  static constexpr size_t kCheckSize = sizeof(uint32_t);
+  for (size_t i = 0; i != num_blocks; ++i) {
+    size_t header_begin = dst->size();
+    const uint8_t block_header[] = {
+        kBlockHeaderSize / 4u - 1u, 0u, XZ_ID_LZMA2, 1u, dict_size_props[i], 0u, 0u, 0u
+    };
+    dst->insert(dst->end(), block_header, block_header + arraysize(block_header));
+    XzWriteCrc32(header_begin, dst);
+    DCHECK_EQ(dst->size() - header_begin, kBlockHeaderSize);
+    dst->insert(dst->end(), blocks[i].begin(), blocks[i].end());
+    dst->resize(RoundUp(dst->size(), 4u), 0u);
+    size_t begin = i * kXzBlockSize;
+    XzWriteUint32(CrcCalc(src->data() + begin, std::min(kXzBlockSize, src->size() - begin)), dst);
+  }
+  // Index, with the unpadded and uncompressed sizes of the blocks.
+  size_t index_begin = dst->size();
+  dst->push_back(0u);
+  XzWriteVarInt(num_blocks, dst);
+  for (size_t i = 0; i != num_blocks; ++i) {
+    size_t begin = i * kXzBlockSize;
+    XzWriteVarInt(kBlockHeaderSize + blocks[i].size() + kCheckSize, dst);
+    XzWriteVarInt(std::min(kXzBlockSize, src->size() - begin), dst);
+  }
+  dst->resize(RoundUp(dst->size(), 4u), 0u);
+  XzWriteCrc32(index_begin, dst);
+  size_t index_size = dst->size() - index_begin;
+  // Stream footer.
+  std::vector<uint8_t> footer;
+  XzWriteUint32(index_size / 4u - 1u, &footer);
+  footer.insert(footer.end(), stream_flags, stream_flags + XZ_STREAM_FLAGS_SIZE);
+  XzWriteUint32(CrcCalc(footer.data(), footer.size()), dst);
+  dst->insert(dst->end(), footer.begin(), footer.end());
+  dst->insert(dst->end(), XZ_FOOTER_SIG, XZ_FOOTER_SIG + XZ_FOOTER_SIG_SIZE);
+}
+
 template <typename ElfTypes>
 static std::vector<uint8_t> MakeMiniDebugInfoInternal(
     InstructionSet isa,
     const InstructionSetFeatures* features,
     size_t rodata_section_size,
     size_t text_section_size,
-    const ArrayRef<const MethodDebugInfo>& method_infos) {
+    const ArrayRef<const MethodDebugInfo>& method_infos,
+    size_t thread_count) {
   std::vector<uint8_t> buffer;
   buffer.reserve(KB);
   VectorOutputStream out("Mini-debug-info ELF file", &buffer);
@@ -101,7 +246,7 @@ static std::vector<uint8_t> MakeMiniDebugInfoInternal(
   CHECK(builder->Good());
   std::vector<uint8_t> compressed_buffer;
   compressed_buffer.reserve(buffer.size() / 4);
-  XzCompress(&buffer, &compressed_buffer);
+  XzCompress(&buffer, &compressed_buffer, thread_count);
   return compressed_buffer;
 }
 
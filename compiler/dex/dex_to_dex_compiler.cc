@@ -41,6 +41,8 @@ using android::base::StringPrintf;
 const bool kEnableQuickening = true;
 // Control check-cast elision.
 const bool kEnableCheckCastEllision = true;
+// Controls fusing of common instruction pairs into superinstructions for the interpreter.
+const bool kEnableSuperinstructions = true;
 
 struct QuickenedInfo {
   QuickenedInfo(uint32_t pc, uint16_t index) : dex_pc(pc), dex_member_index(index) {}
@@ -89,6 +91,11 @@ class DexCompiler {
   void CompileInstanceFieldAccess(Instruction* inst, uint32_t dex_pc,
                                   Instruction::Code new_opcode, bool is_put);
 
+  // Fuses an IGET_OBJECT_QUICK with the IF_EQZ or IF_NEZ testing its result that follows it.
+  // The branch instruction is left in place, so that the code item keeps the same dex pcs and
+  // branch targets, and the interpreter may execute both instructions with a single dispatch.
+  void CompileIGetObjectQuickAndBranch(Instruction* inst, uint32_t dex_pc);
+
   // Compiles a virtual method invocation into a quick virtual method invocation.
   // The method index is replaced by the vtable index where the corresponding
   // Executable can be found. Therefore, this does not involve any resolution
@@ -139,6 +146,7 @@ void DexCompiler::Compile() {
 
       case Instruction::IGET_OBJECT:
         CompileInstanceFieldAccess(inst, dex_pc, Instruction::IGET_OBJECT_QUICK, false);
+        CompileIGetObjectQuickAndBranch(inst, dex_pc);
         break;
 
       case Instruction::IGET_BOOLEAN:
@@ -282,6 +290,32 @@ void DexCompiler::CompileInstanceFieldAccess(Instruction* inst,
   }
 }
 
+void DexCompiler::CompileIGetObjectQuickAndBranch(Instruction* inst, uint32_t dex_pc) {
+  if (!kEnableSuperinstructions || inst->Opcode() != Instruction::IGET_OBJECT_QUICK) {
+    return;
+  }
+  // Verified code cannot fall off the end of the code item, so there is a next instruction.
+  const Instruction* next = inst->Next();
+  Instruction::Code new_opcode;
+  if (next->Opcode() == Instruction::IF_EQZ) {
+    new_opcode = Instruction::IGET_OBJECT_QUICK_IF_EQZ;
+  } else if (next->Opcode() == Instruction::IF_NEZ) {
+    new_opcode = Instruction::IGET_OBJECT_QUICK_IF_NEZ;
+  } else {
+    return;
+  }
+  if (next->VRegA_21t() != inst->VRegA_22c()) {
+    return;
+  }
+  VLOG(compiler) << "Fusing " << Instruction::Name(inst->Opcode())
+                 << " and " << Instruction::Name(next->Opcode())
+                 << " to " << Instruction::Name(new_opcode)
+                 << " at dex pc " << StringPrintf("0x%x", dex_pc) << " in method "
+                 << GetDexFile().PrettyMethod(unit_.GetDexMethodIndex(), true);
+  // The field index was recorded for the IGET_OBJECT_QUICK already.
+  inst->SetOpcode(new_opcode);
+}
+
 void DexCompiler::CompileInvokeVirtual(Instruction* inst, uint32_t dex_pc,
                                        Instruction::Code new_opcode, bool is_range) {
   if (!kEnableQuickening) {
@@ -0,0 +1,695 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "compiled_method_cache.h"
+
+#include <string.h>
+
+#include <memory>
+
+#include "android-base/stringprintf.h"
+
+#include "base/array_ref.h"
+#include "base/unix_file/fd_file.h"
+#include "compiled_method.h"
+#include "dex_file-inl.h"
+#include "driver/compiler_driver.h"
+#include "oat.h"
+#include "os.h"
+#include "thread-current-inl.h"
+
+namespace art {
+
+using android::base::StringPrintf;
+
+static constexpr uint8_t kCacheMagic[] = { 'c', 'm', 'c', '\n' };
+static constexpr uint32_t kCacheVersion = 1u;
+
+// 64-bit FNV-1a.
+class CacheHasher {
+ public:
+  CacheHasher() : hash_(UINT64_C(14695981039346656037)) {}
+
+  void Update(const void* data, size_t size) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+    for (size_t i = 0; i != size; ++i) {
+      hash_ = (hash_ ^ bytes[i]) * UINT64_C(1099511628211);
+    }
+  }
+
+  void Update(uint32_t value) {
+    Update(&value, sizeof(value));
+  }
+
+  void Update(const char* string) {
+    size_t length = strlen(string);
+    Update(static_cast<uint32_t>(length));
+    Update(string, length);
+  }
+
+  void Update(const DexFile::TypeList* types) {
+    uint32_t size = (types != nullptr) ? types->Size() : 0u;
+    Update(size);
+    for (uint32_t i = 0; i != size; ++i) {
+      Update(types->GetTypeItem(i).type_idx_.index_);
+    }
+  }
+
+  uint64_t GetHash() const {
+    return hash_;
+  }
+
+ private:
+  uint64_t hash_;
+};
+
+// Hashes everything the compiled code may depend on in `dex_file`, except for the code items.
+static void HashDexFileLayout(const DexFile& dex_file, CacheHasher* hasher) {
+  hasher->Update(static_cast<uint32_t>(dex_file.NumStringIds()));
+  for (size_t i = 0; i != dex_file.NumStringIds(); ++i) {
+    uint32_t utf16_length;
+    hasher->Update(dex_file.StringDataAndUtf16LengthByIdx(dex::StringIndex(i), &utf16_length));
+  }
+  hasher->Update(dex_file.NumTypeIds());
+  for (uint32_t i = 0; i != dex_file.NumTypeIds(); ++i) {
+    hasher->Update(dex_file.GetTypeId(dex::TypeIndex(i)).descriptor_idx_.index_);
+  }
+  hasher->Update(static_cast<uint32_t>(dex_file.NumProtoIds()));
+  for (size_t i = 0; i != dex_file.NumProtoIds(); ++i) {
+    const DexFile::ProtoId& proto_id = dex_file.GetProtoId(i);
+    hasher->Update(proto_id.shorty_idx_.index_);
+    hasher->Update(proto_id.return_type_idx_.index_);
+    hasher->Update(dex_file.GetProtoParameters(proto_id));
+  }
+  hasher->Update(static_cast<uint32_t>(dex_file.NumFieldIds()));
+  for (size_t i = 0; i != dex_file.NumFieldIds(); ++i) {
+    const DexFile::FieldId& field_id = dex_file.GetFieldId(i);
+    hasher->Update(field_id.class_idx_.index_);
+    hasher->Update(field_id.type_idx_.index_);
+    hasher->Update(field_id.name_idx_.index_);
+  }
+  hasher->Update(static_cast<uint32_t>(dex_file.NumMethodIds()));
+  for (size_t i = 0; i != dex_file.NumMethodIds(); ++i) {
+    const DexFile::MethodId& method_id = dex_file.GetMethodId(i);
+    hasher->Update(method_id.class_idx_.index_);
+    hasher->Update(method_id.proto_idx_);
+    hasher->Update(method_id.name_idx_.index_);
+  }
+  hasher->Update(dex_file.NumClassDefs());
+  for (uint32_t i = 0; i != dex_file.NumClassDefs(); ++i) {
+    const DexFile::ClassDef& class_def = dex_file.GetClassDef(i);
+    hasher->Update(class_def.class_idx_.index_);
+    hasher->Update(class_def.access_flags_);
+    hasher->Update(class_def.superclass_idx_.index_);
+    hasher->Update(dex_file.GetInterfacesList(class_def));
+    const uint8_t* class_data = dex_file.GetClassData(class_def);
+    if (class_data == nullptr) {
+      hasher->Update(0u);
+      continue;
+    }
+    ClassDataItemIterator it(dex_file, class_data);
+    hasher->Update(it.NumStaticFields());
+    hasher->Update(it.NumInstanceFields());
+    hasher->Update(it.NumDirectMethods());
+    hasher->Update(it.NumVirtualMethods());
+    for (; it.HasNext(); it.Next()) {
+      hasher->Update(it.GetMemberIndex());
+      hasher->Update(it.GetRawMemberAccessFlags());
+    }
+  }
+}
+
+static uint64_t ComputeCompilationKey(const std::vector<const DexFile*>& dex_files,
+                                      const std::string& config) {
+  CacheHasher hasher;
+  hasher.Update(OatHeader::kOatVersion, sizeof(OatHeader::kOatVersion));
+  hasher.Update(config.c_str());
+  hasher.Update(static_cast<uint32_t>(dex_files.size()));
+  for (const DexFile* dex_file : dex_files) {
+    hasher.Update(dex_file->GetLocation().c_str());
+    HashDexFileLayout(*dex_file, &hasher);
+  }
+  return hasher.GetHash();
+}
+
+static uint64_t HashCodeItem(const DexFile::CodeItem& code_item) {
+  CacheHasher hasher;
+  hasher.Update(&code_item, DexFile::GetCodeItemSize(code_item));
+  // Reserve 0 for methods without a code item.
+  return (hasher.GetHash() != 0u) ? hasher.GetHash() : 1u;
+}
+
+class CacheWriter {
+ public:
+  explicit CacheWriter(std::vector<uint8_t>* data) : data_(data) {}
+
+  void Write(const void* bytes, size_t size) {
+    const uint8_t* begin = reinterpret_cast<const uint8_t*>(bytes);
+    data_->insert(data_->end(), begin, begin + size);
+  }
+
+  template <typename T>
+  void Write(T value) {
+    static_assert(std::is_integral<T>::value, "Only integral values are written raw");
+    Write(&value, sizeof(value));
+  }
+
+  void WriteArray(ArrayRef<const uint8_t> array) {
+    Write(static_cast<uint32_t>(array.size()));
+    Write(array.data(), array.size());
+  }
+
+ private:
+  std::vector<uint8_t>* const data_;
+};
+
+class CacheReader {
+ public:
+  CacheReader(const std::vector<uint8_t>& data, size_t offset) : data_(data), offset_(offset) {}
+
+  size_t GetOffset() const {
+    return offset_;
+  }
+
+  bool Read(void* bytes, size_t size) {
+    if (data_.size() - offset_ < size) {
+      return false;
+    }
+    memcpy(bytes, data_.data() + offset_, size);
+    offset_ += size;
+    return true;
+  }
+
+  template <typename T>
+  bool Read(T* value) {
+    static_assert(std::is_integral<T>::value, "Only integral values are read raw");
+    return Read(value, sizeof(*value));
+  }
+
+  bool ReadArray(ArrayRef<const uint8_t>* array) {
+    uint32_t size;
+    if (!Read(&size) || data_.size() - offset_ < size) {
+      return false;
+    }
+    *array = ArrayRef<const uint8_t>(data_.data() + offset_, size);
+    offset_ += size;
+    return true;
+  }
+
+ private:
+  const std::vector<uint8_t>& data_;
+  size_t offset_;
+};
+
+CompiledMethodCache::CompiledMethodCache(const std::vector<const DexFile*>& dex_files,
+                                         const std::string& config)
+    : dex_files_(dex_files),
+      code_item_hashes_(dex_files.size()),
+      compilation_key_(ComputeCompilationKey(dex_files, config)),
+      data_(),
+      entries_(),
+      lock_("Compiled method cache lock"),
+      hits_(0u) {
+  for (size_t i = 0; i != dex_files_.size(); ++i) {
+    const DexFile& dex_file = *dex_files_[i];
+    code_item_hashes_[i].resize(dex_file.NumMethodIds(), 0u);
+    for (uint32_t class_def_index = 0; class_def_index != dex_file.NumClassDefs();
+         ++class_def_index) {
+      const uint8_t* class_data = dex_file.GetClassData(dex_file.GetClassDef(class_def_index));
+      if (class_data == nullptr) {
+        continue;
+      }
+      ClassDataItemIterator it(dex_file, class_data);
+      it.SkipAllFields();
+      for (; it.HasNext(); it.Next()) {
+        const DexFile::CodeItem* code_item = it.GetMethodCodeItem();
+        if (code_item != nullptr) {
+          code_item_hashes_[i][it.GetMemberIndex()] = HashCodeItem(*code_item);
+        }
+      }
+    }
+  }
+}
+
+uint32_t CompiledMethodCache::GetDexFileIndex(const DexFile* dex_file) const {
+  for (size_t i = 0; i != dex_files_.size(); ++i) {
+    if (dex_files_[i] == dex_file) {
+      return i;
+    }
+  }
+  return kNoDexFile;
+}
+
+// Reads the entry at the reader's position up to and including its dependencies.
+static bool ReadEntryHeader(CacheReader* reader,
+                            uint32_t* dex_file_index,
+                            uint32_t* method_index,
+                            uint64_t* code_item_hash,
+                            uint32_t* num_dependencies) {
+  return reader->Read(dex_file_index) &&
+      reader->Read(method_index) &&
+      reader->Read(code_item_hash) &&
+      reader->Read(num_dependencies);
+}
+
+static bool ReadDependency(CacheReader* reader,
+                           uint32_t* dex_file_index,
+                           uint32_t* method_index,
+                           uint64_t* code_item_hash) {
+  return reader->Read(dex_file_index) && reader->Read(method_index) && reader->Read(code_item_hash);
+}
+
+// Reads the compiled code following the dependencies of an entry.
+static bool ReadCode(CacheReader* reader,
+                     const std::vector<const DexFile*>& dex_files,
+                     uint32_t* instruction_set,
+                     uint32_t* frame_size_in_bytes,
+                     uint32_t* core_spill_mask,
+                     uint32_t* fp_spill_mask,
+                     ArrayRef<const uint8_t>* quick_code,
+                     ArrayRef<const uint8_t>* method_info,
+                     ArrayRef<const uint8_t>* vmap_table,
+                     ArrayRef<const uint8_t>* cfi_info,
+                     std::vector<LinkerPatch>* patches) {
+  uint32_t num_patches;
+  if (!reader->Read(instruction_set) ||
+      !reader->Read(frame_size_in_bytes) ||
+      !reader->Read(core_spill_mask) ||
+      !reader->Read(fp_spill_mask) ||
+      !reader->ReadArray(quick_code) ||
+      !reader->ReadArray(method_info) ||
+      !reader->ReadArray(vmap_table) ||
+      !reader->ReadArray(cfi_info) ||
+      !reader->Read(&num_patches)) {
+    return false;
+  }
+  for (uint32_t i = 0; i != num_patches; ++i) {
+    uint8_t type;
+    uint32_t literal_offset;
+    uint32_t dex_file_index;
+    uint32_t value1;
+    uint32_t value2;
+    if (!reader->Read(&type) ||
+        !reader->Read(&literal_offset) ||
+        !reader->Read(&dex_file_index) ||
+        !reader->Read(&value1) ||
+        !reader->Read(&value2) ||
+        literal_offset >= quick_code->size()) {
+      return false;
+    }
+    const DexFile* dex_file = nullptr;
+    if (static_cast<LinkerPatch::Type>(type) != LinkerPatch::Type::kBakerReadBarrierBranch) {
+      if (dex_file_index >= dex_files.size()) {
+        return false;
+      }
+      dex_file = dex_files[dex_file_index];
+    }
+    if (patches == nullptr) {
+      continue;
+    }
+    switch (static_cast<LinkerPatch::Type>(type)) {
+      case LinkerPatch::Type::kMethodRelative:
+        patches->push_back(
+            LinkerPatch::RelativeMethodPatch(literal_offset, dex_file, value2, value1));
+        break;
+      case LinkerPatch::Type::kMethodBssEntry:
+        patches->push_back(
+            LinkerPatch::MethodBssEntryPatch(literal_offset, dex_file, value2, value1));
+        break;
+      case LinkerPatch::Type::kCall:
+        patches->push_back(LinkerPatch::CodePatch(literal_offset, dex_file, value1));
+        break;
+      case LinkerPatch::Type::kCallRelative:
+        patches->push_back(LinkerPatch::RelativeCodePatch(literal_offset, dex_file, value1));
+        break;
+      case LinkerPatch::Type::kTypeRelative:
+        patches->push_back(
+            LinkerPatch::RelativeTypePatch(literal_offset, dex_file, value2, value1));
+        break;
+      case LinkerPatch::Type::kTypeBssEntry:
+        patches->push_back(
+            LinkerPatch::TypeBssEntryPatch(literal_offset, dex_file, value2, value1));
+        break;
+      case LinkerPatch::Type::kStringRelative:
+        patches->push_back(
+            LinkerPatch::RelativeStringPatch(literal_offset, dex_file, value2, value1));
+        break;
+      case LinkerPatch::Type::kStringBssEntry:
+        patches->push_back(
+            LinkerPatch::StringBssEntryPatch(literal_offset, dex_file, value2, value1));
+        break;
+      case LinkerPatch::Type::kBakerReadBarrierBranch:
+        patches->push_back(
+            LinkerPatch::BakerReadBarrierBranchPatch(literal_offset, value1, value2));
+        break;
+      default:
+        return false;
+    }
+  }
+  return true;
+}
+
+bool CompiledMethodCache::Load(const std::string& file_name, std::string* error_msg) {
+  std::unique_ptr<File> file(OS::OpenFileForReading(file_name.c_str()));
+  if (file == nullptr) {
+    *error_msg = StringPrintf("Failed to open compiled method cache %s", file_name.c_str());
+    return false;
+  }
+  int64_t length = file->GetLength();
+  if (length < 0) {
+    *error_msg = StringPrintf("Failed to get the length of %s", file_name.c_str());
+    return false;
+  }
+  std::vector<uint8_t> data(static_cast<size_t>(length));
+  if (!file->ReadFully(data.data(), data.size())) {
+    *error_msg = StringPrintf("Failed to read compiled method cache %s", file_name.c_str());
+    return false;
+  }
+
+  CacheReader reader(data, 0u);
+  uint8_t magic[sizeof(kCacheMagic)];
+  uint32_t version;
+  uint64_t compilation_key;
+  uint32_t num_entries;
+  if (!reader.Read(magic, sizeof(magic)) ||
+      memcmp(magic, kCacheMagic, sizeof(kCacheMagic)) != 0 ||
+      !reader.Read(&version) ||
+      version != kCacheVersion ||
+      !reader.Read(&compilation_key) ||
+      !reader.Read(&num_entries)) {
+    *error_msg = StringPrintf("Invalid compiled method cache header in %s", file_name.c_str());
+    return false;
+  }
+  if (compilation_key != compilation_key_) {
+    *error_msg = StringPrintf("Compiled method cache %s was written for other inputs",
+                              file_name.c_str());
+    return false;
+  }
+
+  // Check the whole file before using any of it.
+  std::map<MethodReference, size_t, MethodReferenceComparator> entries;
+  for (uint32_t i = 0; i != num_entries; ++i) {
+    size_t offset = reader.GetOffset();
+    uint32_t dex_file_index;
+    uint32_t method_index;
+    uint64_t code_item_hash;
+    uint32_t num_dependencies;
+    bool valid = ReadEntryHeader(
+        &reader, &dex_file_index, &method_index, &code_item_hash, &num_dependencies);
+    valid = valid &&
+        dex_file_index < dex_files_.size() &&
+        method_index < dex_files_[dex_file_index]->NumMethodIds();
+    for (uint32_t j = 0; valid && j != num_dependencies; ++j) {
+      uint32_t dependency_dex_file_index;
+      uint32_t dependency_method_index;
+      uint64_t dependency_code_item_hash;
+      valid = ReadDependency(
+          &reader, &dependency_dex_file_index, &dependency_method_index,
+          &dependency_code_item_hash) &&
+          dependency_dex_file_index < dex_files_.size() &&
+          dependency_method_index < dex_files_[dependency_dex_file_index]->NumMethodIds();
+    }
+    uint32_t instruction_set;
+    uint32_t frame_size_in_bytes;
+    uint32_t core_spill_mask;
+    uint32_t fp_spill_mask;
+    ArrayRef<const uint8_t> quick_code;
+    ArrayRef<const uint8_t> method_info;
+    ArrayRef<const uint8_t> vmap_table;
+    ArrayRef<const uint8_t> cfi_info;
+    valid = valid && ReadCode(&reader,
+                              dex_files_,
+                              &instruction_set,
+                              &frame_size_in_bytes,
+                              &core_spill_mask,
+                              &fp_spill_mask,
+                              &quick_code,
+                              &method_info,
+                              &vmap_table,
+                              &cfi_info,
+                              /* patches */ nullptr);
+    if (!valid) {
+      *error_msg = StringPrintf("Corrupt compiled method cache entry %u in %s",
+                                i,
+                                file_name.c_str());
+      return false;
+    }
+    entries.emplace(MethodReference(dex_files_[dex_file_index], method_index), offset);
+  }
+  data_.swap(data);
+  entries_.swap(entries);
+  return true;
+}
+
+CompiledMethod* CompiledMethodCache::Lookup(CompilerDriver* driver, MethodReference method_ref) {
+  auto it = entries_.find(method_ref);
+  if (it == entries_.end()) {
+    return nullptr;
+  }
+  CacheReader reader(data_, it->second);
+  uint32_t dex_file_index;
+  uint32_t method_index;
+  uint64_t code_item_hash;
+  uint32_t num_dependencies;
+  // Load() has checked the entries.
+  CHECK(ReadEntryHeader(&reader, &dex_file_index, &method_index, &code_item_hash,
+                        &num_dependencies));
+  if (code_item_hashes_[dex_file_index][method_index] != code_item_hash) {
+    return nullptr;
+  }
+  for (uint32_t i = 0; i != num_dependencies; ++i) {
+    CHECK(ReadDependency(&reader, &dex_file_index, &method_index, &code_item_hash));
+    if (code_item_hashes_[dex_file_index][method_index] != code_item_hash) {
+      return nullptr;
+    }
+  }
+  uint32_t instruction_set;
+  uint32_t frame_size_in_bytes;
+  uint32_t core_spill_mask;
+  uint32_t fp_spill_mask;
+  ArrayRef<const uint8_t> quick_code;
+  ArrayRef<const uint8_t> method_info;
+  ArrayRef<const uint8_t> vmap_table;
+  ArrayRef<const uint8_t> cfi_info;
+  std::vector<LinkerPatch> patches;
+  CHECK(ReadCode(&reader,
+                 dex_files_,
+                 &instruction_set,
+                 &frame_size_in_bytes,
+                 &core_spill_mask,
+                 &fp_spill_mask,
+                 &quick_code,
+                 &method_info,
+                 &vmap_table,
+                 &cfi_info,
+                 &patches));
+  if (static_cast<InstructionSet>(instruction_set) != driver->GetInstructionSet()) {
+    return nullptr;
+  }
+  {
+    MutexLock mu(Thread::Current(), lock_);
+    reused_.insert(method_ref);
+  }
+  hits_.FetchAndAddRelaxed(1u);
+  return CompiledMethod::SwapAllocCompiledMethod(driver,
+                                                 driver->GetInstructionSet(),
+                                                 quick_code,
+                                                 frame_size_in_bytes,
+                                                 core_spill_mask,
+                                                 fp_spill_mask,
+                                                 method_info,
+                                                 vmap_table,
+                                                 cfi_info,
+                                                 ArrayRef<const LinkerPatch>(patches));
+}
+
+void CompiledMethodCache::RecordDependency(MethodReference caller, MethodReference callee) {
+  MutexLock mu(Thread::Current(), lock_);
+  dependencies_[caller].insert(callee);
+}
+
+bool CompiledMethodCache::EncodeMethod(MethodReference method_ref,
+                                       const CompiledMethod& compiled_method,
+                                       const std::vector<Dependency>& dependencies,
+                                       std::vector<uint8_t>* out) const {
+  uint32_t dex_file_index = GetDexFileIndex(method_ref.dex_file);
+  DCHECK_NE(dex_file_index, kNoDexFile);
+  std::vector<uint8_t> data;
+  CacheWriter writer(&data);
+  writer.Write(dex_file_index);
+  writer.Write(method_ref.dex_method_index);
+  writer.Write(code_item_hashes_[dex_file_index][method_ref.dex_method_index]);
+  writer.Write(static_cast<uint32_t>(dependencies.size()));
+  for (const Dependency& dependency : dependencies) {
+    writer.Write(dependency.dex_file_index);
+    writer.Write(dependency.method_index);
+    writer.Write(dependency.code_item_hash);
+  }
+  writer.Write(static_cast<uint32_t>(compiled_method.GetInstructionSet()));
+  writer.Write(static_cast<uint32_t>(compiled_method.GetFrameSizeInBytes()));
+  writer.Write(compiled_method.GetCoreSpillMask());
+  writer.Write(compiled_method.GetFpSpillMask());
+  writer.WriteArray(compiled_method.GetQuickCode());
+  writer.WriteArray(compiled_method.GetMethodInfo());
+  writer.WriteArray(compiled_method.GetVmapTable());
+  writer.WriteArray(compiled_method.GetCFIInfo());
+  writer.Write(static_cast<uint32_t>(compiled_method.GetPatches().size()));
+  for (const LinkerPatch& patch : compiled_method.GetPatches()) {
+    const DexFile* target_dex_file = nullptr;
+    uint32_t value1 = 0u;
+    uint32_t value2 = 0u;
+    switch (patch.GetType()) {
+      case LinkerPatch::Type::kMethodRelative:
+      case LinkerPatch::Type::kMethodBssEntry:
+        value2 = patch.PcInsnOffset();
+        FALLTHROUGH_INTENDED;
+      case LinkerPatch::Type::kCall:
+      case LinkerPatch::Type::kCallRelative:
+        target_dex_file = patch.TargetMethod().dex_file;
+        value1 = patch.TargetMethod().dex_method_index;
+        break;
+      case LinkerPatch::Type::kTypeRelative:
+      case LinkerPatch::Type::kTypeBssEntry:
+        target_dex_file = patch.TargetTypeDexFile();
+        value1 = patch.TargetTypeIndex().index_;
+        value2 = patch.PcInsnOffset();
+        break;
+      case LinkerPatch::Type::kStringRelative:
+      case LinkerPatch::Type::kStringBssEntry:
+        target_dex_file = patch.TargetStringDexFile();
+        value1 = patch.TargetStringIndex().index_;
+        value2 = patch.PcInsnOffset();
+        break;
+      case LinkerPatch::Type::kBakerReadBarrierBranch:
+        value1 = patch.GetBakerCustomValue1();
+        value2 = patch.GetBakerCustomValue2();
+        break;
+      default:
+        return false;
+    }
+    uint32_t target_dex_file_index = kNoDexFile;
+    if (target_dex_file != nullptr) {
+      // Indexes into the boot class path or the class path cannot be recorded.
+      target_dex_file_index = GetDexFileIndex(target_dex_file);
+      if (target_dex_file_index == kNoDexFile) {
+        return false;
+      }
+    }
+    writer.Write(static_cast<uint8_t>(patch.GetType()));
+    writer.Write(static_cast<uint32_t>(patch.LiteralOffset()));
+    writer.Write(target_dex_file_index);
+    writer.Write(value1);
+    writer.Write(value2);
+  }
+  out->insert(out->end(), data.begin(), data.end());
+  return true;
+}
+
+bool CompiledMethodCache::Write(const std::string& file_name,
+                                CompilerDriver* driver,
+                                std::string* error_msg) {
+  std::vector<uint8_t> data;
+  CacheWriter writer(&data);
+  writer.Write(kCacheMagic, sizeof(kCacheMagic));
+  writer.Write(kCacheVersion);
+  writer.Write(compilation_key_);
+  size_t num_entries_offset = data.size();
+  writer.Write(0u);
+
+  uint32_t num_entries = 0u;
+  {
+    MutexLock mu(Thread::Current(), lock_);
+    std::vector<Dependency> dependencies;
+    for (const DexFile* dex_file : dex_files_) {
+      std::set<uint32_t> written;
+      for (uint32_t i = 0; i != dex_file->NumClassDefs(); ++i) {
+        const uint8_t* class_data = dex_file->GetClassData(dex_file->GetClassDef(i));
+        if (class_data == nullptr) {
+          continue;
+        }
+        ClassDataItemIterator it(*dex_file, class_data);
+        it.SkipAllFields();
+        for (; it.HasNext(); it.Next()) {
+          MethodReference method_ref(dex_file, it.GetMemberIndex());
+          if (it.GetMethodCodeItem() == nullptr || !written.insert(it.GetMemberIndex()).second) {
+            continue;
+          }
+          const CompiledMethod* compiled_method = driver->GetCompiledMethod(method_ref);
+          // Only keep code from the optimizing backend, not dex-to-dex quickening data.
+          if (compiled_method == nullptr ||
+              compiled_method->GetInstructionSet() != driver->GetInstructionSet()) {
+            continue;
+          }
+          dependencies.clear();
+          if (reused_.find(method_ref) != reused_.end()) {
+            CacheReader reader(data_, entries_.find(method_ref)->second);
+            uint32_t dex_file_index;
+            uint32_t method_index;
+            uint64_t code_item_hash;
+            uint32_t num_dependencies;
+            CHECK(ReadEntryHeader(&reader, &dex_file_index, &method_index, &code_item_hash,
+                                  &num_dependencies));
+            for (uint32_t j = 0; j != num_dependencies; ++j) {
+              Dependency dependency;
+              CHECK(ReadDependency(&reader,
+                                   &dependency.dex_file_index,
+                                   &dependency.method_index,
+                                   &dependency.code_item_hash));
+              dependencies.push_back(dependency);
+            }
+          } else {
+            auto deps_it = dependencies_.find(method_ref);
+            if (deps_it != dependencies_.end()) {
+              for (MethodReference callee : deps_it->second) {
+                // Methods outside of the dex files being compiled are covered by the
+                // compilation key.
+                uint32_t callee_dex_file_index = GetDexFileIndex(callee.dex_file);
+                if (callee_dex_file_index != kNoDexFile) {
+                  uint64_t hash =
+                      code_item_hashes_[callee_dex_file_index][callee.dex_method_index];
+                  dependencies.push_back(
+                      Dependency { callee_dex_file_index, callee.dex_method_index, hash });
+                }
+              }
+            }
+          }
+          if (EncodeMethod(method_ref, *compiled_method, dependencies, &data)) {
+            ++num_entries;
+          }
+        }
+      }
+    }
+  }
+  memcpy(data.data() + num_entries_offset, &num_entries, sizeof(num_entries));
+
+  std::unique_ptr<File> file(OS::CreateEmptyFile(file_name.c_str()));
+  if (file == nullptr) {
+    *error_msg = StringPrintf("Failed to create compiled method cache %s", file_name.c_str());
+    return false;
+  }
+  if (!file->WriteFully(data.data(), data.size())) {
+    *error_msg = StringPrintf("Failed to write compiled method cache %s", file_name.c_str());
+    file->Erase();
+    return false;
+  }
+  if (file->FlushCloseOrErase() != 0) {
+    *error_msg = StringPrintf("Failed to flush compiled method cache %s", file_name.c_str());
+    return false;
+  }
+  return true;
+}
+
+}  // namespace art
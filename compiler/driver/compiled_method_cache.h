@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_DRIVER_COMPILED_METHOD_CACHE_H_
+#define ART_COMPILER_DRIVER_COMPILED_METHOD_CACHE_H_
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "atomic.h"
+#include "base/mutex.h"
+#include "method_reference.h"
+
+namespace art {
+
+class CompiledMethod;
+class CompilerDriver;
+class DexFile;
+
+// Carries compiled code over from one dex2oat invocation to the next for the methods whose
+// inputs did not change. The oat file only holds linked code, so the cache keeps the unlinked
+// CompiledMethods, with their linker patches, in a file of its own.
+//
+// A cache file is only used by a compilation with the same key. The key covers the compiler
+// configuration passed by the caller (boot image, class path, profile, options) and everything
+// in the dex files but the code items: the string, type, proto, field and method ids, and the
+// classes with their interfaces, fields and methods. With those unchanged, class layouts,
+// vtables and dex indices are the same, and the code of a method only depends on its own code
+// item and on the code items of the methods the inliner looked at. A cached method is reused
+// when all of these code items are unchanged.
+class CompiledMethodCache {
+ public:
+  CompiledMethodCache(const std::vector<const DexFile*>& dex_files, const std::string& config);
+
+  uint64_t GetCompilationKey() const {
+    return compilation_key_;
+  }
+
+  // Reads the cache written by a previous compilation. Returns false and leaves the cache empty
+  // if the file cannot be read, is corrupt or was written for another compilation key.
+  bool Load(const std::string& file_name, std::string* error_msg);
+
+  // Returns the cached code for `method_ref` if it is still valid, null otherwise.
+  CompiledMethod* Lookup(CompilerDriver* driver, MethodReference method_ref) REQUIRES(!lock_);
+
+  // Records that the code of `caller` depends on the code item of `callee`.
+  void RecordDependency(MethodReference caller, MethodReference callee) REQUIRES(!lock_);
+
+  // Writes the methods compiled by `driver` for use by the next compilation.
+  bool Write(const std::string& file_name, CompilerDriver* driver, std::string* error_msg)
+      REQUIRES(!lock_);
+
+  size_t GetNumberOfHits() const {
+    return hits_.LoadRelaxed();
+  }
+
+ private:
+  static constexpr uint32_t kNoDexFile = static_cast<uint32_t>(-1);
+
+  struct Dependency {
+    uint32_t dex_file_index;
+    uint32_t method_index;
+    uint64_t code_item_hash;
+  };
+
+  uint32_t GetDexFileIndex(const DexFile* dex_file) const;
+  bool EncodeMethod(MethodReference method_ref,
+                    const CompiledMethod& compiled_method,
+                    const std::vector<Dependency>& dependencies,
+                    std::vector<uint8_t>* out) const;
+
+  const std::vector<const DexFile*> dex_files_;
+  // The hash of the code item of each method of each dex file, 0 for methods without one.
+  std::vector<std::vector<uint64_t>> code_item_hashes_;
+  const uint64_t compilation_key_;
+
+  // The loaded cache file and the offset of each entry in it.
+  std::vector<uint8_t> data_;
+  std::map<MethodReference, size_t, MethodReferenceComparator> entries_;
+
+  Mutex lock_;
+  std::map<MethodReference, std::set<MethodReference, MethodReferenceComparator>,
+           MethodReferenceComparator> dependencies_ GUARDED_BY(lock_);
+  // Methods taken from the cache, their dependencies are copied from the loaded entry.
+  std::set<MethodReference, MethodReferenceComparator> reused_ GUARDED_BY(lock_);
+  Atomic<size_t> hits_;
+
+  DISALLOW_COPY_AND_ASSIGN(CompiledMethodCache);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_DRIVER_COMPILED_METHOD_CACHE_H_
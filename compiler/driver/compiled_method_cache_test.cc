@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "driver/compiled_method_cache.h"
+
+#include "base/timing_logger.h"
+#include "common_compiler_test.h"
+#include "compiled_method.h"
+#include "dex_file-inl.h"
+#include "driver/compiler_driver.h"
+#include "scoped_thread_state_change-inl.h"
+
+namespace art {
+
+class CompiledMethodCacheTest : public CommonCompilerTest {
+ protected:
+  void CompileAll(jobject class_loader) {
+    TimingLogger timings("CompiledMethodCacheTest::CompileAll", false, false);
+    dex_files_ = GetDexFiles(class_loader);
+    compiler_driver_->SetDexFilesForOatFile(dex_files_);
+    compiler_driver_->CompileAll(class_loader, dex_files_, &timings);
+  }
+
+  std::vector<const DexFile*> dex_files_;
+};
+
+TEST_F(CompiledMethodCacheTest, CompilationKey) {
+  std::vector<std::unique_ptr<const DexFile>> dex_files = OpenTestDexFiles("StaticLeafMethods");
+  std::vector<const DexFile*> dex_file_ptrs;
+  for (const std::unique_ptr<const DexFile>& dex_file : dex_files) {
+    dex_file_ptrs.push_back(dex_file.get());
+  }
+  CompiledMethodCache cache1(dex_file_ptrs, "config");
+  CompiledMethodCache cache2(dex_file_ptrs, "config");
+  CompiledMethodCache cache3(dex_file_ptrs, "other config");
+  EXPECT_EQ(cache1.GetCompilationKey(), cache2.GetCompilationKey());
+  EXPECT_NE(cache1.GetCompilationKey(), cache3.GetCompilationKey());
+}
+
+TEST_F(CompiledMethodCacheTest, WriteAndLoad) {
+  jobject class_loader;
+  {
+    ScopedObjectAccess soa(Thread::Current());
+    class_loader = LoadDex("StaticLeafMethods");
+  }
+  ASSERT_NE(class_loader, nullptr);
+  CompileAll(class_loader);
+
+  ScratchFile file;
+  std::string error_msg;
+  CompiledMethodCache cache(dex_files_, "config");
+  ASSERT_TRUE(cache.Write(file.GetFilename(), compiler_driver_.get(), &error_msg)) << error_msg;
+
+  CompiledMethodCache other_config(dex_files_, "other config");
+  EXPECT_FALSE(other_config.Load(file.GetFilename(), &error_msg));
+
+  CompiledMethodCache loaded(dex_files_, "config");
+  ASSERT_TRUE(loaded.Load(file.GetFilename(), &error_msg)) << error_msg;
+  size_t num_compiled_methods = 0u;
+  for (const DexFile* dex_file : dex_files_) {
+    for (size_t method_index = 0; method_index != dex_file->NumMethodIds(); ++method_index) {
+      MethodReference method_ref(dex_file, method_index);
+      const CompiledMethod* compiled_method = compiler_driver_->GetCompiledMethod(method_ref);
+      CompiledMethod* cached_method = loaded.Lookup(compiler_driver_.get(), method_ref);
+      if (compiled_method == nullptr ||
+          compiled_method->GetInstructionSet() != compiler_driver_->GetInstructionSet()) {
+        EXPECT_EQ(cached_method, nullptr);
+        continue;
+      }
+      ++num_compiled_methods;
+      ASSERT_NE(cached_method, nullptr) << dex_file->PrettyMethod(method_index);
+      EXPECT_EQ(cached_method->GetFrameSizeInBytes(), compiled_method->GetFrameSizeInBytes());
+      EXPECT_EQ(cached_method->GetCoreSpillMask(), compiled_method->GetCoreSpillMask());
+      EXPECT_EQ(cached_method->GetQuickCode(), compiled_method->GetQuickCode());
+      EXPECT_EQ(cached_method->GetVmapTable(), compiled_method->GetVmapTable());
+      EXPECT_EQ(cached_method->GetPatches().size(), compiled_method->GetPatches().size());
+      CompiledMethod::ReleaseSwapAllocatedCompiledMethod(compiler_driver_.get(), cached_method);
+    }
+  }
+  EXPECT_NE(num_compiled_methods, 0u);
+  EXPECT_EQ(loaded.GetNumberOfHits(), num_compiled_methods);
+}
+
+}  // namespace art
@@ -185,6 +185,26 @@ CompiledMethodStorage::~CompiledMethodStorage() {
   // All done by member destructors.
 }
 
+void CompiledMethodStorage::Reserve(size_t expected_methods) {
+  if (!DedupeEnabled()) {
+    return;
+  }
+  dedupe_code_.Reserve(expected_methods);
+  dedupe_method_info_.Reserve(expected_methods);
+  dedupe_vmap_table_.Reserve(expected_methods);
+  dedupe_cfi_info_.Reserve(expected_methods);
+  dedupe_linker_patches_.Reserve(expected_methods);
+}
+
+void CompiledMethodStorage::ReleaseDeduplicatedArrays() {
+  Thread* self = Thread::Current();
+  dedupe_code_.Clear(self);
+  dedupe_method_info_.Clear(self);
+  dedupe_vmap_table_.Clear(self);
+  dedupe_cfi_info_.Clear(self);
+  dedupe_linker_patches_.Clear(self);
+}
+
 void CompiledMethodStorage::DumpMemoryUsage(std::ostream& os, bool extended) const {
   if (swap_space_.get() != nullptr) {
     const size_t swap_size = swap_space_->GetSize();
@@ -48,6 +48,14 @@ class CompiledMethodStorage {
     return SwapAllocator<void>(swap_space_.get());
   }
 
+  // Move the swap-allocated data out of the resident set, see SwapSpace::WriteBack().
+  // Does nothing without a swap file.
+  void WriteBackSwapSpace() {
+    if (swap_space_ != nullptr) {
+      swap_space_->WriteBack();
+    }
+  }
+
   const LengthPrefixedArray<uint8_t>* DeduplicateCode(const ArrayRef<const uint8_t>& code);
   void ReleaseCode(const LengthPrefixedArray<uint8_t>* code);
 
@@ -65,6 +73,14 @@ class CompiledMethodStorage {
       const ArrayRef<const LinkerPatch>& linker_patches);
   void ReleaseLinkerPatches(const LengthPrefixedArray<LinkerPatch>* linker_patches);
 
+  // Prepare the dedupe sets for about `expected_methods` compiled methods, see
+  // DedupeSet::Reserve(). Must be called before the compiler threads start.
+  void Reserve(size_t expected_methods);
+
+  // Release the arrays kept for deduplication. All the CompiledMethods using them must have
+  // been released.
+  void ReleaseDeduplicatedArrays();
+
  private:
   template <typename T, typename DedupeSetType>
   const LengthPrefixedArray<T>* AllocateOrDeduplicateArray(const ArrayRef<const T>& data,
@@ -47,6 +47,7 @@
 #include "dex_compilation_unit.h"
 #include "dex_file-inl.h"
 #include "dex_instruction-inl.h"
+#include "driver/compiled_method_cache.h"
 #include "driver/compiler_options.h"
 #include "gc/accounting/card_table-inl.h"
 #include "gc/accounting/heap_bitmap.h"
@@ -54,10 +55,12 @@
 #include "gc/space/space.h"
 #include "handle_scope-inl.h"
 #include "intrinsics_enum.h"
+#include "jit/profiling_info.h"
 #include "jni_internal.h"
 #include "mirror/class-inl.h"
 #include "mirror/class_loader.h"
 #include "mirror/dex_cache-inl.h"
+#include "mirror/iftable-inl.h"
 #include "mirror/object-inl.h"
 #include "mirror/object-refvisitor-inl.h"
 #include "mirror/object_array-inl.h"
@@ -297,6 +300,8 @@ CompilerDriver::CompilerDriver(
       methods_to_compile_(compiled_methods),
       had_hard_verifier_failure_(false),
       parallel_thread_count_(thread_count),
+      max_active_threads_(thread_count),
+      only_hot_methods_(false),
       stats_(new AOTCompilationStats),
       dump_stats_(dump_stats),
       dump_passes_(dump_passes),
@@ -304,6 +309,7 @@ CompilerDriver::CompilerDriver(
       compiler_context_(nullptr),
       support_boot_image_fixup_(true),
       compiled_method_storage_(swap_fd),
+      compiled_method_cache_(nullptr),
       profile_compilation_info_(profile_compilation_info),
       max_arena_alloc_(0),
       dex_to_dex_references_lock_("dex-to-dex references lock"),
@@ -392,13 +398,29 @@ void CompilerDriver::CompileAll(jobject class_loader,
 
   InitializeThreadPools();
 
+  if (parallel_thread_count_ > 1u && GetCompilerOptions().IsAnyCompilationEnabled()) {
+    // Let the compiler threads deduplicate without contending for the dedupe set locks. About
+    // half of the method ids of a dex file are defined in it and have code.
+    size_t num_method_ids = 0u;
+    for (const DexFile* dex_file : dex_files) {
+      num_method_ids += dex_file->NumMethodIds();
+    }
+    compiled_method_storage_.Reserve(num_method_ids / 2u);
+  }
+
   VLOG(compiler) << "Before precompile " << GetMemoryUsageString(false);
   // Precompile:
   // 1) Load image classes
   // 2) Resolve all classes
   // 3) Attempt to verify all classes
   // 4) Attempt to initialize image classes, and trivially initialized classes
-  PreCompile(class_loader, dex_files, timings);
+  // The pipelined compilation does 3), 4) and the compilation below class by class.
+  bool pipelined = UsePipelinedCompilation();
+  if (pipelined) {
+    PipelinedCompile(class_loader, dex_files, timings);
+  } else {
+    PreCompile(class_loader, dex_files, timings);
+  }
   if (GetCompilerOptions().IsBootImage()) {
     // We don't need to setup the intrinsics for non boot image compilation, as
     // those compilations will pick up a boot image that have the ArtMethod already
@@ -415,7 +437,7 @@ INTRINSICS_LIST(SETUP_INTRINSICS)
   // Compile:
   // 1) Compile all classes and methods enabled for compilation. May fall back to dex-to-dex
   //    compilation.
-  if (GetCompilerOptions().IsAnyCompilationEnabled()) {
+  if (GetCompilerOptions().IsAnyCompilationEnabled() && !pipelined) {
     Compile(class_loader, dex_files, timings);
   }
   if (dump_stats_) {
@@ -589,7 +611,10 @@ static void CompileMethod(Thread* self,
         driver->IsMethodToCompile(method_ref) &&
         driver->ShouldCompileBasedOnProfile(method_ref);
 
-    if (compile) {
+    if (compile && driver->GetCompiledMethodCache() != nullptr) {
+      compiled_method = driver->GetCompiledMethodCache()->Lookup(driver, method_ref);
+    }
+    if (compile && compiled_method == nullptr) {
       // NOTE: if compiler declines to compile this method, it will return null.
       compiled_method = driver->GetCompiler()->Compile(code_item,
                                                        access_flags,
@@ -882,6 +907,67 @@ static void EnsureVerifiedOrVerifyAtRuntime(jobject jclass_loader,
   }
 }
 
+void CompilerDriver::ComputeClosedWorldSubtypes(jobject class_loader,
+                                                const std::vector<const DexFile*>& dex_files,
+                                                TimingLogger* timings) {
+  // The hierarchy of the boot class path is open to the apps.
+  if (!compiler_options_->IsClosedWorldDevirtualization() ||
+      compiler_options_->IsBootImage() ||
+      !CompilerFilter::IsAsGoodAs(compiler_options_->GetCompilerFilter(),
+                                  CompilerFilter::kSpeed)) {
+    return;
+  }
+  TimingLogger::ScopedTiming t("Compute closed world subtypes", timings);
+  ScopedObjectAccess soa(Thread::Current());
+  StackHandleScope<1> hs(soa.Self());
+  Handle<mirror::ClassLoader> loader(
+      hs.NewHandle(soa.Decode<mirror::ClassLoader>(class_loader)));
+  ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
+  std::set<const DexFile*> compiled_dex_files(dex_files.begin(), dex_files.end());
+  auto add_subtype = [&](ObjPtr<mirror::Class> type, TypeReference subtype)
+      REQUIRES_SHARED(Locks::mutator_lock_) {
+    if (type->IsProxyClass() ||
+        compiled_dex_files.find(&type->GetDexFile()) == compiled_dex_files.end()) {
+      return;
+    }
+    std::vector<TypeReference>& subtypes =
+        closed_world_subtypes_[TypeReference(&type->GetDexFile(), type->GetDexTypeIndex())];
+    if (subtypes.size() <= InlineCache::kIndividualCacheSize) {
+      subtypes.push_back(subtype);
+    }
+  };
+  for (const DexFile* dex_file : dex_files) {
+    ObjPtr<mirror::DexCache> dex_cache = class_linker->FindDexCache(soa.Self(), *dex_file);
+    for (size_t i = 0; i < dex_file->NumClassDefs(); ++i) {
+      dex::TypeIndex type_index = dex_file->GetClassDef(i).class_idx_;
+      ObjPtr<mirror::Class> klass =
+          ClassLinker::LookupResolvedType(type_index, dex_cache, loader.Get());
+      // Skip the classes that failed to resolve or are shadowed by an earlier definition.
+      if (klass == nullptr ||
+          klass->IsErroneous() ||
+          !klass->IsInstantiable() ||
+          &klass->GetDexFile() != dex_file) {
+        continue;
+      }
+      TypeReference subtype(dex_file, type_index);
+      for (ObjPtr<mirror::Class> k = klass; k != nullptr; k = k->GetSuperClass()) {
+        add_subtype(k, subtype);
+      }
+      ObjPtr<mirror::IfTable> iftable = klass->GetIfTable();
+      for (int32_t j = 0, count = klass->GetIfTableCount(); j != count; ++j) {
+        add_subtype(iftable->GetInterface(j), subtype);
+      }
+    }
+  }
+  VLOG(compiler) << "Closed world subtypes of " << closed_world_subtypes_.size() << " types";
+}
+
+const std::vector<TypeReference>* CompilerDriver::GetClosedWorldSubtypes(
+    TypeReference type) const {
+  auto it = closed_world_subtypes_.find(type);
+  return (it != closed_world_subtypes_.end()) ? &it->second : nullptr;
+}
+
 void CompilerDriver::PreCompile(jobject class_loader,
                                 const std::vector<const DexFile*>& dex_files,
                                 TimingLogger* timings) {
@@ -902,6 +988,7 @@ void CompilerDriver::PreCompile(jobject class_loader,
     // Resolve eagerly to prepare for compilation.
     Resolve(class_loader, dex_files, timings);
     VLOG(compiler) << "Resolve: " << GetMemoryUsageString(false);
+    ComputeClosedWorldSubtypes(class_loader, dex_files, timings);
   }
 
   if (compiler_options_->AssumeClassesAreVerified()) {
@@ -965,7 +1052,18 @@ bool CompilerDriver::IsMethodToCompile(const MethodReference& method_ref) const
   return methods_to_compile_->find(tmp.c_str()) != methods_to_compile_->end();
 }
 
+void CompilerDriver::ThrottleCompilation(size_t max_threads, bool only_hot_methods) {
+  max_active_threads_.StoreRelaxed(max_threads);
+  only_hot_methods_.StoreRelaxed(only_hot_methods);
+}
+
 bool CompilerDriver::ShouldCompileBasedOnProfile(const MethodReference& method_ref) const {
+  if (UNLIKELY(only_hot_methods_.LoadRelaxed())) {
+    // Throttled for memory, leave the methods that are not known to be hot to the dex-to-dex
+    // compiler.
+    return profile_compilation_info_ != nullptr &&
+        profile_compilation_info_->GetMethodHotness(method_ref).IsHot();
+  }
   // Profile compilation info may be null if no profile is passed.
   if (!CompilerFilter::DependsOnProfile(compiler_options_->GetCompilerFilter())) {
     // Use the compiler filter instead of the presence of profile_compilation_info_ since
@@ -1506,13 +1604,15 @@ class ParallelCompilationManager {
                              const DexFile* dex_file,
                              const std::vector<const DexFile*>& dex_files,
                              ThreadPool* thread_pool)
-    : index_(0),
-      class_linker_(class_linker),
+    : class_linker_(class_linker),
       class_loader_(class_loader),
       compiler_(compiler),
       dex_file_(dex_file),
       dex_files_(dex_files),
-      thread_pool_(thread_pool) {}
+      thread_pool_(thread_pool),
+      busy_ns_(0u),
+      wall_ns_(0u),
+      max_work_units_(0u) {}
 
   ClassLinker* GetClassLinker() const {
     CHECK(class_linker_ != nullptr);
@@ -1539,13 +1639,73 @@ class ParallelCompilationManager {
 
   void ForAll(size_t begin, size_t end, CompilationVisitor* visitor, size_t work_units)
       REQUIRES(!*Locks::mutator_lock_) {
+    ForAllRanges(
+        WorkStealingRanges::SplitByCost(begin,
+                                        end,
+                                        work_units * kRangesPerWorkUnit,
+                                        [](size_t index ATTRIBUTE_UNUSED) { return 1u; }),
+        visitor,
+        work_units);
+  }
+
+  // Visits the class definitions of the dex file, balancing the work units by the size of the
+  // code of each class.
+  void ForAllClassDefs(CompilationVisitor* visitor, size_t work_units)
+      REQUIRES(!*Locks::mutator_lock_) {
+    const DexFile& dex_file = *GetDexFile();
+    std::vector<size_t> costs(dex_file.NumClassDefs(), 1u);
+    for (size_t i = 0; i != costs.size(); ++i) {
+      const uint8_t* class_data = dex_file.GetClassData(dex_file.GetClassDef(i));
+      if (class_data == nullptr) {
+        continue;
+      }
+      ClassDataItemIterator it(dex_file, class_data);
+      it.SkipAllFields();
+      for (; it.HasNextDirectMethod() || it.HasNextVirtualMethod(); it.Next()) {
+        const DexFile::CodeItem* code_item = it.GetMethodCodeItem();
+        if (code_item != nullptr) {
+          costs[i] += code_item->insns_size_in_code_units_;
+        }
+      }
+    }
+    ForAllRanges(
+        WorkStealingRanges::SplitByCost(0u,
+                                        costs.size(),
+                                        work_units * kRangesPerWorkUnit,
+                                        [&costs](size_t index) { return costs[index]; }),
+        visitor,
+        work_units);
+  }
+
+  // Records the CPU time the work units spent in the visitors against the wall time of the
+  // visits, to show how well the threads were kept busy.
+  void AddUtilization(TimingLogger* timings, const char* label) const {
+    AddUtilization(timings, label, busy_ns_.LoadRelaxed());
+  }
+
+  // As above, for the part `busy_ns` of the CPU time that the visitor accounted to `label`.
+  void AddUtilization(TimingLogger* timings, const char* label, uint64_t busy_ns) const {
+    timings->AddUtilization(label, busy_ns, wall_ns_, max_work_units_);
+  }
+
+ private:
+  // Ranges per work unit, enough for stealing to even out the costs that were misestimated.
+  static constexpr size_t kRangesPerWorkUnit = 16u;
+
+  void ForAllRanges(std::vector<WorkStealingRanges::Range>&& ranges,
+                    CompilationVisitor* visitor,
+                    size_t work_units)
+      REQUIRES(!*Locks::mutator_lock_) {
     Thread* self = Thread::Current();
     self->AssertNoPendingException();
     CHECK_GT(work_units, 0U);
 
-    index_.StoreRelaxed(begin);
+    uint64_t start_ns = NanoTime();
+    WorkStealingRanges work_stealing_ranges(std::move(ranges), work_units);
+    work_stealing_ranges.SetActiveWorkerLimit(GetCompiler()->GetMaxActiveThreads());
     for (size_t i = 0; i < work_units; ++i) {
-      thread_pool_->AddTask(self, new ForAllClosure(this, end, visitor));
+      thread_pool_->AddTask(self,
+                            new ForAllClosure(&work_stealing_ranges, i, visitor, &busy_ns_));
     }
     thread_pool_->StartWorkers(self);
 
@@ -1558,42 +1718,42 @@ class ParallelCompilationManager {
 
     // And stop the workers accepting jobs.
     thread_pool_->StopWorkers(self);
+    wall_ns_ += NanoTime() - start_ns;
+    max_work_units_ = std::max(max_work_units_, work_units);
+    VLOG(compiler) << "Work stealing: " << work_stealing_ranges.GetNumberOfSteals() << " steals";
   }
 
-  size_t NextIndex() {
-    return index_.FetchAndAddSequentiallyConsistent(1);
-  }
-
- private:
-  class ForAllClosure : public Task {
+  class ForAllClosure : public WorkStealingWorker {
    public:
-    ForAllClosure(ParallelCompilationManager* manager, size_t end, CompilationVisitor* visitor)
-        : manager_(manager),
-          end_(end),
-          visitor_(visitor) {}
-
-    virtual void Run(Thread* self) {
-      while (true) {
-        const size_t index = manager_->NextIndex();
-        if (UNLIKELY(index >= end_)) {
-          break;
-        }
-        visitor_->Visit(index);
-        self->AssertNoPendingException();
-      }
+    ForAllClosure(WorkStealingRanges* ranges,
+                  size_t worker_index,
+                  CompilationVisitor* visitor,
+                  Atomic<uint64_t>* busy_ns)
+        : WorkStealingWorker(ranges, worker_index),
+          visitor_(visitor),
+          busy_ns_(busy_ns) {}
+
+    void Run(Thread* self) OVERRIDE {
+      uint64_t start_ns = ThreadCpuNanoTime();
+      WorkStealingWorker::Run(self);
+      busy_ns_->FetchAndAddRelaxed(ThreadCpuNanoTime() - start_ns);
     }
 
     virtual void Finalize() {
       delete this;
     }
 
+   protected:
+    virtual void Visit(Thread* self, size_t index) {
+      visitor_->Visit(index);
+      self->AssertNoPendingException();
+    }
+
    private:
-    ParallelCompilationManager* const manager_;
-    const size_t end_;
     CompilationVisitor* const visitor_;
+    Atomic<uint64_t>* const busy_ns_;
   };
 
-  AtomicInteger index_;
   ClassLinker* const class_linker_;
   const jobject class_loader_;
   CompilerDriver* const compiler_;
@@ -1601,6 +1761,11 @@ class ParallelCompilationManager {
   const std::vector<const DexFile*>& dex_files_;
   ThreadPool* const thread_pool_;
 
+  // CPU time of the work units, wall time and largest number of work units of the visits.
+  Atomic<uint64_t> busy_ns_;
+  uint64_t wall_ns_;
+  size_t max_work_units_;
+
   DISALLOW_COPY_AND_ASSIGN(ParallelCompilationManager);
 };
 
@@ -1840,7 +2005,8 @@ void CompilerDriver::ResolveDexFile(jobject class_loader,
 
   TimingLogger::ScopedTiming t("Resolve MethodsAndFields", timings);
   ResolveClassFieldsAndMethodsVisitor visitor(&context);
-  context.ForAll(0, dex_file.NumClassDefs(), &visitor, thread_count);
+  context.ForAllClassDefs(&visitor, thread_count);
+  context.AddUtilization(timings, "Resolve");
 }
 
 void CompilerDriver::SetVerified(jobject class_loader,
@@ -1906,9 +2072,11 @@ static void LoadAndUpdateStatus(const DexFile& dex_file,
   }
 }
 
-bool CompilerDriver::FastVerify(jobject jclass_loader,
-                                const std::vector<const DexFile*>& dex_files,
-                                TimingLogger* timings) {
+bool CompilerDriver::FastVerify(
+    jobject jclass_loader,
+    const std::vector<const DexFile*>& dex_files,
+    std::map<const DexFile*, std::set<dex::TypeIndex>>* classes_to_reverify,
+    TimingLogger* timings) {
   verifier::VerifierDeps* verifier_deps =
       Runtime::Current()->GetCompilerCallbacks()->GetVerifierDeps();
   // If there exist VerifierDeps that aren't the ones we just created to output, use them to verify.
@@ -1920,7 +2088,8 @@ bool CompilerDriver::FastVerify(jobject jclass_loader,
   StackHandleScope<2> hs(soa.Self());
   Handle<mirror::ClassLoader> class_loader(
       hs.NewHandle(soa.Decode<mirror::ClassLoader>(jclass_loader)));
-  if (!verifier_deps->ValidateDependencies(class_loader, soa.Self())) {
+  if (!verifier_deps->ValidateDependenciesPerClass(
+          class_loader, soa.Self(), classes_to_reverify)) {
     return false;
   }
 
@@ -1935,8 +2104,13 @@ bool CompilerDriver::FastVerify(jobject jclass_loader,
     // Fetch the list of unverified classes.
     const std::set<dex::TypeIndex>& unverified_classes =
         verifier_deps->GetUnverifiedClasses(*dex_file);
+    // The classes to verify again get their status from ReverifyClasses().
+    const std::set<dex::TypeIndex>& reverified_classes = (*classes_to_reverify)[dex_file];
     for (uint32_t i = 0; i < dex_file->NumClassDefs(); ++i) {
       const DexFile::ClassDef& class_def = dex_file->GetClassDef(i);
+      if (reverified_classes.find(class_def.class_idx_) != reverified_classes.end()) {
+        continue;
+      }
       if (unverified_classes.find(class_def.class_idx_) == unverified_classes.end()) {
         if (compiler_only_verifies) {
           // Just update the compiled_classes_ map. The compiler doesn't need to resolve
@@ -1977,7 +2151,9 @@ bool CompilerDriver::FastVerify(jobject jclass_loader,
 void CompilerDriver::Verify(jobject jclass_loader,
                             const std::vector<const DexFile*>& dex_files,
                             TimingLogger* timings) {
-  if (FastVerify(jclass_loader, dex_files, timings)) {
+  std::map<const DexFile*, std::set<dex::TypeIndex>> classes_to_reverify;
+  if (FastVerify(jclass_loader, dex_files, &classes_to_reverify, timings)) {
+    ReverifyClasses(jclass_loader, dex_files, classes_to_reverify, timings);
     return;
   }
 
@@ -1986,17 +2162,7 @@ void CompilerDriver::Verify(jobject jclass_loader,
   // non boot image compilation. The verifier will need it to record the new dependencies.
   // Then dex2oat can update the vdex file with these new dependencies.
   if (!GetCompilerOptions().IsBootImage()) {
-    // Dex2oat creates the verifier deps.
-    // Create the main VerifierDeps, and set it to this thread.
-    verifier::VerifierDeps* verifier_deps =
-        Runtime::Current()->GetCompilerCallbacks()->GetVerifierDeps();
-    CHECK(verifier_deps != nullptr);
-    Thread::Current()->SetVerifierDeps(verifier_deps);
-    // Create per-thread VerifierDeps to avoid contention on the main one.
-    // We will merge them after verification.
-    for (ThreadPoolWorker* worker : parallel_thread_pool_->GetWorkers()) {
-      worker->GetThread()->SetVerifierDeps(new verifier::VerifierDeps(dex_files_for_oat_file_));
-    }
+    CreateThreadVerifierDeps();
   }
 
   // Verification updates VerifierDeps and needs to run single-threaded to be deterministic.
@@ -2015,18 +2181,36 @@ void CompilerDriver::Verify(jobject jclass_loader,
   }
 
   if (!GetCompilerOptions().IsBootImage()) {
-    // Merge all VerifierDeps into the main one.
-    verifier::VerifierDeps* verifier_deps = Thread::Current()->GetVerifierDeps();
-    for (ThreadPoolWorker* worker : parallel_thread_pool_->GetWorkers()) {
-      verifier::VerifierDeps* thread_deps = worker->GetThread()->GetVerifierDeps();
-      worker->GetThread()->SetVerifierDeps(nullptr);
-      verifier_deps->MergeWith(*thread_deps, dex_files_for_oat_file_);
-      delete thread_deps;
-    }
-    Thread::Current()->SetVerifierDeps(nullptr);
+    MergeThreadVerifierDeps();
   }
 }
 
+void CompilerDriver::CreateThreadVerifierDeps() {
+  // Dex2oat creates the verifier deps.
+  // Create the main VerifierDeps, and set it to this thread.
+  verifier::VerifierDeps* verifier_deps =
+      Runtime::Current()->GetCompilerCallbacks()->GetVerifierDeps();
+  CHECK(verifier_deps != nullptr);
+  Thread::Current()->SetVerifierDeps(verifier_deps);
+  // Create per-thread VerifierDeps to avoid contention on the main one.
+  // We will merge them after verification.
+  for (ThreadPoolWorker* worker : parallel_thread_pool_->GetWorkers()) {
+    worker->GetThread()->SetVerifierDeps(new verifier::VerifierDeps(dex_files_for_oat_file_));
+  }
+}
+
+void CompilerDriver::MergeThreadVerifierDeps() {
+  // Merge all VerifierDeps into the main one.
+  verifier::VerifierDeps* verifier_deps = Thread::Current()->GetVerifierDeps();
+  for (ThreadPoolWorker* worker : parallel_thread_pool_->GetWorkers()) {
+    verifier::VerifierDeps* thread_deps = worker->GetThread()->GetVerifierDeps();
+    worker->GetThread()->SetVerifierDeps(nullptr);
+    verifier_deps->MergeWith(*thread_deps, dex_files_for_oat_file_);
+    delete thread_deps;
+  }
+  Thread::Current()->SetVerifierDeps(nullptr);
+}
+
 class VerifyClassVisitor : public CompilationVisitor {
  public:
   VerifyClassVisitor(const ParallelCompilationManager* manager, verifier::HardFailLogMode log_level)
@@ -2132,6 +2316,66 @@ class VerifyClassVisitor : public CompilationVisitor {
   const verifier::HardFailLogMode log_level_;
 };
 
+// Visits the class definitions at the given indexes only.
+class ClassDefSubsetVisitor : public CompilationVisitor {
+ public:
+  ClassDefSubsetVisitor(CompilationVisitor* visitor, const std::vector<size_t>& class_def_indexes)
+      : visitor_(visitor), class_def_indexes_(class_def_indexes) {}
+
+  virtual void Visit(size_t index) REQUIRES(!Locks::mutator_lock_) OVERRIDE {
+    visitor_->Visit(class_def_indexes_[index]);
+  }
+
+ private:
+  CompilationVisitor* const visitor_;
+  const std::vector<size_t>& class_def_indexes_;
+};
+
+void CompilerDriver::ReverifyClasses(
+    jobject class_loader,
+    const std::vector<const DexFile*>& dex_files,
+    const std::map<const DexFile*, std::set<dex::TypeIndex>>& classes,
+    TimingLogger* timings) {
+  bool has_classes = false;
+  for (const auto& entry : classes) {
+    has_classes = has_classes || !entry.second.empty();
+  }
+  if (!has_classes) {
+    return;
+  }
+  TimingLogger::ScopedTiming t("Reverify Classes", timings);
+  // Record the new dependencies of the classes into the existing VerifierDeps.
+  CreateThreadVerifierDeps();
+  bool force_determinism = GetCompilerOptions().IsForceDeterminism();
+  ThreadPool* verify_thread_pool =
+      force_determinism ? single_thread_pool_.get() : parallel_thread_pool_.get();
+  size_t verify_thread_count = force_determinism ? 1U : parallel_thread_count_;
+  verifier::HardFailLogMode log_level = GetCompilerOptions().AbortOnHardVerifierFailure()
+                              ? verifier::HardFailLogMode::kLogInternalFatal
+                              : verifier::HardFailLogMode::kLogWarning;
+  for (const DexFile* dex_file : dex_files) {
+    auto it = classes.find(dex_file);
+    if (it == classes.end() || it->second.empty()) {
+      continue;
+    }
+    std::vector<size_t> class_def_indexes;
+    for (uint32_t i = 0; i < dex_file->NumClassDefs(); ++i) {
+      if (it->second.find(dex_file->GetClassDef(i).class_idx_) != it->second.end()) {
+        class_def_indexes.push_back(i);
+      }
+    }
+    VLOG(compiler) << "Verifying " << class_def_indexes.size() << " classes of "
+                   << dex_file->GetLocation() << " again";
+    ParallelCompilationManager context(Runtime::Current()->GetClassLinker(), class_loader, this,
+                                       dex_file, dex_files, verify_thread_pool);
+    VerifyClassVisitor visitor(&context, log_level);
+    ClassDefSubsetVisitor subset_visitor(&visitor, class_def_indexes);
+    context.ForAll(0, class_def_indexes.size(), &subset_visitor, verify_thread_count);
+    context.AddUtilization(timings, "Reverify");
+  }
+  MergeThreadVerifierDeps();
+}
+
 void CompilerDriver::VerifyDexFile(jobject class_loader,
                                    const DexFile& dex_file,
                                    const std::vector<const DexFile*>& dex_files,
@@ -2146,7 +2390,8 @@ void CompilerDriver::VerifyDexFile(jobject class_loader,
                               ? verifier::HardFailLogMode::kLogInternalFatal
                               : verifier::HardFailLogMode::kLogWarning;
   VerifyClassVisitor visitor(&context, log_level);
-  context.ForAll(0, dex_file.NumClassDefs(), &visitor, thread_count);
+  context.ForAllClassDefs(&visitor, thread_count);
+  context.AddUtilization(timings, "Verify");
 }
 
 class SetVerifiedClassVisitor : public CompilationVisitor {
@@ -2210,7 +2455,7 @@ void CompilerDriver::SetVerifiedDexFile(jobject class_loader,
   ParallelCompilationManager context(class_linker, class_loader, this, &dex_file, dex_files,
                                      thread_pool);
   SetVerifiedClassVisitor visitor(&context);
-  context.ForAll(0, dex_file.NumClassDefs(), &visitor, thread_count);
+  context.ForAllClassDefs(&visitor, thread_count);
 }
 
 class InitializeClassVisitor : public CompilationVisitor {
@@ -2289,12 +2534,18 @@ class InitializeClassVisitor : public CompilationVisitor {
         if (!is_boot_image && klass->NumStaticFields() > kMaxEncodedFields) {
           too_many_encoded_fields = true;
         }
+        // Why the static initializer is not run below, reported with --dump-init-failures.
+        const char* skip_reason = nullptr;
+        if (!is_superclass_initialized) {
+          skip_reason = "a superclass or interface could not be initialized";
+        } else if (too_many_encoded_fields) {
+          skip_reason = "too many static fields";
+        }
         // If the class was not initialized, we can proceed to see if we can initialize static
         // fields. Limit the max number of encoded fields.
         if (!klass->IsInitialized() &&
             (is_app_image || is_boot_image) &&
-            is_superclass_initialized &&
-            !too_many_encoded_fields &&
+            skip_reason == nullptr &&
             manager_->GetCompiler()->IsImageClass(descriptor)) {
           bool can_init_static_fields = false;
           if (is_boot_image) {
@@ -2315,6 +2566,15 @@ class InitializeClassVisitor : public CompilationVisitor {
             // processing of intern strings. Will be removed later when intern strings
             // and clinit are both initialized.
           }
+          if (!can_init_static_fields) {
+            if (is_boot_image) {
+              skip_reason = "marked as $NoPreloadHolder";
+            } else if (soa.Self()->IsExceptionPending()) {
+              skip_reason = "an exception is pending";
+            } else {
+              skip_reason = "a superclass or interface has its own static initializer";
+            }
+          }
 
           if (can_init_static_fields) {
             VLOG(compiler) << "Initializing: " << descriptor;
@@ -2370,6 +2630,15 @@ class InitializeClassVisitor : public CompilationVisitor {
             }
           }
         }
+        if (!klass->IsInitialized() && (is_app_image || is_boot_image) && skip_reason != nullptr) {
+          VLOG(compiler) << "Initialization of " << descriptor << " skipped: " << skip_reason;
+          std::ostream* file_log =
+              manager_->GetCompiler()->GetCompilerOptions().GetInitFailureOutput();
+          if (file_log != nullptr) {
+            *file_log << descriptor << "\n";
+            *file_log << "Skipped: " << skip_reason << "\n";
+          }
+        }
         // If the class still isn't initialized, at least try some checks that initialization
         // would do so they can be skipped at runtime.
         if (!klass->IsInitialized() &&
@@ -2599,7 +2868,8 @@ void CompilerDriver::InitializeClasses(jobject jni_class_loader,
     init_thread_count = 1U;
   }
   InitializeClassVisitor visitor(&context);
-  context.ForAll(0, dex_file.NumClassDefs(), &visitor, init_thread_count);
+  context.ForAllClassDefs(&visitor, init_thread_count);
+  context.AddUtilization(timings, "InitializeNoClinit");
 }
 
 class InitializeArrayClassesAndCreateConflictTablesVisitor : public ClassVisitor {
@@ -2710,6 +2980,15 @@ void CompilerDriver::Compile(jobject class_loader,
     Runtime::Current()->ReclaimArenaPoolMemory();
   }
 
+  CompileDexToDexMethods(class_loader, dex_files, timings);
+
+  VLOG(compiler) << "Compile: " << GetMemoryUsageString(false);
+}
+
+void CompilerDriver::CompileDexToDexMethods(jobject class_loader,
+                                            const std::vector<const DexFile*>& dex_files,
+                                            TimingLogger* timings) {
+  Thread* const self = Thread::Current();
   ArrayRef<DexFileMethodSet> dex_to_dex_references;
   {
     // From this point on, we shall not modify dex_to_dex_references_, so
@@ -2727,8 +3006,6 @@ void CompilerDriver::Compile(jobject class_loader,
                    timings);
   }
   current_dex_to_dex_methods_ = nullptr;
-
-  VLOG(compiler) << "Compile: " << GetMemoryUsageString(false);
 }
 
 class CompileClassVisitor : public CompilationVisitor {
@@ -2852,7 +3129,152 @@ void CompilerDriver::CompileDexFile(jobject class_loader,
   ParallelCompilationManager context(Runtime::Current()->GetClassLinker(), class_loader, this,
                                      &dex_file, dex_files, thread_pool);
   CompileClassVisitor visitor(&context);
-  context.ForAll(0, dex_file.NumClassDefs(), &visitor, thread_count);
+  context.ForAllClassDefs(&visitor, thread_count);
+  context.AddUtilization(timings, "Compile");
+}
+
+bool CompilerDriver::UsePipelinedCompilation() const {
+  const CompilerOptions& options = GetCompilerOptions();
+  // Images need a deterministic class initialization under a single thread and the
+  // deterministic compilation needs the phases to complete in order.
+  return options.IsPipelinedCompilation() &&
+      !options.IsBootImage() &&
+      !options.IsAppImage() &&
+      !options.IsForceDeterminism() &&
+      options.IsAnyCompilationEnabled() &&
+      options.IsVerificationEnabled() &&
+      !options.AssumeClassesAreVerified();
+}
+
+// Verifies, initializes and compiles one class after the other. The class linker verifies and
+// initializes the superclasses first, so each class is compiled when it and its superclasses
+// are done, no matter the progress of the other classes. Methods of classes still pending are
+// compiled without the benefit of their verification and initialization: they are not inlined
+// and accesses to their static members keep the class initialization checks.
+class PipelinedClassVisitor : public CompilationVisitor {
+ public:
+  PipelinedClassVisitor(const ParallelCompilationManager* manager,
+                        verifier::HardFailLogMode log_level,
+                        bool verify)
+      : verify_visitor_(manager, log_level),
+        initialize_visitor_(manager),
+        compile_visitor_(manager),
+        verify_(verify),
+        verify_ns_(0u),
+        initialize_ns_(0u),
+        compile_ns_(0u) {}
+
+  void Visit(size_t class_def_index) OVERRIDE REQUIRES(!Locks::mutator_lock_) {
+    uint64_t start_ns = ThreadCpuNanoTime();
+    if (verify_) {
+      verify_visitor_.Visit(class_def_index);
+    }
+    uint64_t verified_ns = ThreadCpuNanoTime();
+    initialize_visitor_.Visit(class_def_index);
+    uint64_t initialized_ns = ThreadCpuNanoTime();
+    compile_visitor_.Visit(class_def_index);
+    uint64_t compiled_ns = ThreadCpuNanoTime();
+    verify_ns_.FetchAndAddRelaxed(verified_ns - start_ns);
+    initialize_ns_.FetchAndAddRelaxed(initialized_ns - verified_ns);
+    compile_ns_.FetchAndAddRelaxed(compiled_ns - initialized_ns);
+  }
+
+  uint64_t GetVerifyNs() const {
+    return verify_ns_.LoadRelaxed();
+  }
+
+  uint64_t GetInitializeNs() const {
+    return initialize_ns_.LoadRelaxed();
+  }
+
+  uint64_t GetCompileNs() const {
+    return compile_ns_.LoadRelaxed();
+  }
+
+ private:
+  VerifyClassVisitor verify_visitor_;
+  InitializeClassVisitor initialize_visitor_;
+  CompileClassVisitor compile_visitor_;
+  // False if the classes have been verified with the VerifierDeps of the vdex file.
+  const bool verify_;
+  // CPU time spent in each step.
+  Atomic<uint64_t> verify_ns_;
+  Atomic<uint64_t> initialize_ns_;
+  Atomic<uint64_t> compile_ns_;
+};
+
+void CompilerDriver::PipelinedCompile(jobject class_loader,
+                                      const std::vector<const DexFile*>& dex_files,
+                                      TimingLogger* timings) {
+  CheckThreadPools();
+
+  LoadImageClasses(timings);
+  VLOG(compiler) << "LoadImageClasses: " << GetMemoryUsageString(false);
+
+  for (const DexFile* dex_file : dex_files) {
+    // Can be already inserted if the caller is CompileOne. This happens for gtests.
+    if (!compiled_methods_.HaveDexFile(dex_file)) {
+      compiled_methods_.AddDexFile(dex_file, dex_file->NumMethodIds());
+    }
+  }
+  // Resolve eagerly to prepare for verification and compilation. Verification needs the
+  // classes of all the dex files, so this remains a separate phase.
+  Resolve(class_loader, dex_files, timings);
+  VLOG(compiler) << "Resolve: " << GetMemoryUsageString(false);
+  ComputeClosedWorldSubtypes(class_loader, dex_files, timings);
+
+  std::map<const DexFile*, std::set<dex::TypeIndex>> classes_to_reverify;
+  bool verify = !FastVerify(class_loader, dex_files, &classes_to_reverify, timings);
+  if (verify) {
+    CreateThreadVerifierDeps();
+  } else {
+    ReverifyClasses(class_loader, dex_files, classes_to_reverify, timings);
+  }
+
+  current_dex_to_dex_methods_ = nullptr;
+  {
+    // Clear in case we aren't the first call to Compile.
+    MutexLock mu(Thread::Current(), dex_to_dex_references_lock_);
+    dex_to_dex_references_.clear();
+  }
+
+  verifier::HardFailLogMode log_level = GetCompilerOptions().AbortOnHardVerifierFailure()
+                              ? verifier::HardFailLogMode::kLogInternalFatal
+                              : verifier::HardFailLogMode::kLogWarning;
+  for (const DexFile* dex_file : dex_files) {
+    CHECK(dex_file != nullptr);
+    {
+      TimingLogger::ScopedTiming t("Verify, Initialize and Compile Dex File", timings);
+      ParallelCompilationManager context(Runtime::Current()->GetClassLinker(), class_loader, this,
+                                         dex_file, dex_files, parallel_thread_pool_.get());
+      PipelinedClassVisitor visitor(&context, log_level, verify);
+      context.ForAllClassDefs(&visitor, parallel_thread_count_);
+      context.AddUtilization(timings, "Pipelined");
+      context.AddUtilization(timings, "Pipelined: Verify", visitor.GetVerifyNs());
+      context.AddUtilization(timings, "Pipelined: InitializeNoClinit", visitor.GetInitializeNs());
+      context.AddUtilization(timings, "Pipelined: Compile", visitor.GetCompileNs());
+    }
+    const ArenaPool* const arena_pool = Runtime::Current()->GetArenaPool();
+    const size_t arena_alloc = arena_pool->GetBytesAllocated();
+    max_arena_alloc_ = std::max(arena_alloc, max_arena_alloc_);
+    Runtime::Current()->ReclaimArenaPoolMemory();
+  }
+
+  if (verify) {
+    MergeThreadVerifierDeps();
+  }
+
+  if (had_hard_verifier_failure_ && GetCompilerOptions().AbortOnHardVerifierFailure()) {
+    LOG(FATAL) << "Had a hard failure verifying all classes, and was asked to abort in such "
+               << "situations. Please check the log.";
+  }
+  if (kIsDebugBuild) {
+    EnsureVerifiedOrVerifyAtRuntime(class_loader, dex_files);
+  }
+  UpdateImageClasses(timings);
+
+  CompileDexToDexMethods(class_loader, dex_files, timings);
+  VLOG(compiler) << "Pipelined compile: " << GetMemoryUsageString(false);
 }
 
 void CompilerDriver::AddCompiledMethod(const MethodReference& method_ref,
@@ -2930,6 +3352,28 @@ CompiledMethod* CompilerDriver::GetCompiledMethod(MethodReference ref) const {
   return compiled_method;
 }
 
+void CompilerDriver::ReleaseCompiledMethods(const std::vector<const DexFile*>& dex_files) {
+  for (const DexFile* dex_file : dex_files) {
+    for (size_t method_index = 0; method_index != dex_file->NumMethodIds(); ++method_index) {
+      DexFileReference ref(dex_file, method_index);
+      CompiledMethod* compiled_method = nullptr;
+      if (compiled_methods_.Get(ref, &compiled_method) && compiled_method != nullptr) {
+        MethodTable::InsertResult result = compiled_methods_.Insert(ref, compiled_method, nullptr);
+        CHECK(result == MethodTable::kInsertResultSuccess);
+        CompiledMethod::ReleaseSwapAllocatedCompiledMethod(this, compiled_method);
+      }
+    }
+  }
+  bool all_released = true;
+  compiled_methods_.Visit([&all_released](const DexFileReference& ref ATTRIBUTE_UNUSED,
+                                          CompiledMethod* method) {
+    all_released = all_released && (method == nullptr);
+  });
+  if (all_released && compiled_method_storage_.DedupeEnabled()) {
+    compiled_method_storage_.ReleaseDeduplicatedArrays();
+  }
+}
+
 bool CompilerDriver::IsMethodVerifiedWithoutFailures(uint32_t method_idx,
                                                      uint16_t class_def_idx,
                                                      const DexFile& dex_file) const {
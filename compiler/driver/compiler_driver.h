@@ -17,6 +17,7 @@
 #ifndef ART_COMPILER_DRIVER_COMPILER_DRIVER_H_
 #define ART_COMPILER_DRIVER_COMPILER_DRIVER_H_
 
+#include <map>
 #include <set>
 #include <string>
 #include <unordered_set>
@@ -39,6 +40,7 @@
 #include "os.h"
 #include "safe_map.h"
 #include "thread_pool.h"
+#include "type_reference.h"
 #include "utils/atomic_dex_ref_map.h"
 #include "utils/dex_cache_arrays_layout.h"
 
@@ -55,6 +57,7 @@ class VerifierDepsTest;
 
 class BitVector;
 class CompiledMethod;
+class CompiledMethodCache;
 class CompilerOptions;
 class DexCompilationUnit;
 struct InlineIGetIPutData;
@@ -157,6 +160,9 @@ class CompilerDriver {
   void AddCompiledMethod(const MethodReference& method_ref,
                          CompiledMethod* const compiled_method,
                          size_t non_relative_linker_patch_count);
+  // Release the compiled methods of `dex_files` once their code has been written. The arrays
+  // shared through deduplication are released together with the last compiled method.
+  void ReleaseCompiledMethods(const std::vector<const DexFile*>& dex_files);
 
   void SetRequiresConstructorBarrier(Thread* self,
                                      const DexFile* dex_file,
@@ -328,6 +334,15 @@ class CompilerDriver {
   // according to the profile file.
   bool ShouldCompileBasedOnProfile(const MethodReference& method_ref) const;
 
+  // Limit the compilation while memory is short. Parallel loops run on at most `max_threads`
+  // threads, including loops that are already running. With `only_hot_methods`, the methods
+  // that are not hot in the profile are not compiled but left to the dex-to-dex compiler.
+  void ThrottleCompilation(size_t max_threads, bool only_hot_methods);
+
+  const Atomic<size_t>* GetMaxActiveThreads() const {
+    return &max_active_threads_;
+  }
+
   // Checks whether profile guided verification is enabled and if the method should be verified
   // according to the profile file.
   bool ShouldVerifyClassBasedOnProfile(const DexFile& dex_file, uint16_t class_idx) const;
@@ -355,6 +370,15 @@ class CompilerDriver {
     return &compiled_method_storage_;
   }
 
+  // The cache of code from a previous compilation, if any. Not owned.
+  CompiledMethodCache* GetCompiledMethodCache() const {
+    return compiled_method_cache_;
+  }
+
+  void SetCompiledMethodCache(CompiledMethodCache* compiled_method_cache) {
+    compiled_method_cache_ = compiled_method_cache;
+  }
+
   // Can we assume that the klass is loaded?
   bool CanAssumeClassIsLoaded(mirror::Class* klass)
       REQUIRES_SHARED(Locks::mutator_lock_);
@@ -379,6 +403,13 @@ class CompilerDriver {
 
   bool CanAssumeVerified(ClassReference ref) const;
 
+  // Return the instantiable classes of the compiled dex files that are assignable to `type`,
+  // a class or interface defined in those dex files. Only computed with
+  // --closed-world-devirtualization. Returns null if `type` is unknown. More than
+  // InlineCache::kIndividualCacheSize classes are not recorded, a vector of that size
+  // plus one means there are too many to be of use.
+  const std::vector<TypeReference>* GetClosedWorldSubtypes(TypeReference type) const;
+
  private:
   void PreCompile(jobject class_loader,
                   const std::vector<const DexFile*>& dex_files,
@@ -387,6 +418,13 @@ class CompilerDriver {
 
   void LoadImageClasses(TimingLogger* timings) REQUIRES(!Locks::mutator_lock_);
 
+  // Index the resolved classes of `dex_files` by their supertypes for closed-world
+  // devirtualization.
+  void ComputeClosedWorldSubtypes(jobject class_loader,
+                                  const std::vector<const DexFile*>& dex_files,
+                                  TimingLogger* timings)
+      REQUIRES(!Locks::mutator_lock_);
+
   // Attempt to resolve all type, methods, fields, and strings
   // referenced from code in the dex file following PathClassLoader
   // ordering semantics.
@@ -403,15 +441,27 @@ class CompilerDriver {
       REQUIRES(!Locks::mutator_lock_);
 
   // Do fast verification through VerifierDeps if possible. Return whether
-  // verification was successful.
+  // verification was successful. The classes whose dependencies no longer hold are
+  // left for `ReverifyClasses()` in `classes_to_reverify`.
   bool FastVerify(jobject class_loader,
                   const std::vector<const DexFile*>& dex_files,
+                  std::map<const DexFile*, std::set<dex::TypeIndex>>* classes_to_reverify,
                   TimingLogger* timings);
 
+  // Verify again the classes that fast verification could not validate.
+  void ReverifyClasses(jobject class_loader,
+                       const std::vector<const DexFile*>& dex_files,
+                       const std::map<const DexFile*, std::set<dex::TypeIndex>>& classes,
+                       TimingLogger* timings);
+
   void Verify(jobject class_loader,
               const std::vector<const DexFile*>& dex_files,
               TimingLogger* timings);
 
+  // Give the worker threads their own VerifierDeps, merged into the main one after verification.
+  void CreateThreadVerifierDeps();
+  void MergeThreadVerifierDeps();
+
   void VerifyDexFile(jobject class_loader,
                      const DexFile& dex_file,
                      const std::vector<const DexFile*>& dex_files,
@@ -453,6 +503,18 @@ class CompilerDriver {
                       size_t thread_count,
                       TimingLogger* timings)
       REQUIRES(!Locks::mutator_lock_);
+  // Compiles the methods that were left for the dex-to-dex compiler by Compile().
+  void CompileDexToDexMethods(jobject class_loader,
+                              const std::vector<const DexFile*>& dex_files,
+                              TimingLogger* timings) REQUIRES(!dex_to_dex_references_lock_);
+
+  // Whether CompileAll() runs PipelinedCompile() instead of PreCompile() and Compile().
+  bool UsePipelinedCompilation() const;
+  // Resolves all classes, then verifies, initializes and compiles each class in one pass.
+  void PipelinedCompile(jobject class_loader,
+                        const std::vector<const DexFile*>& dex_files,
+                        TimingLogger* timings)
+      REQUIRES(!Locks::mutator_lock_, !dex_to_dex_references_lock_);
 
   bool MayInlineInternal(const DexFile* inlined_from, const DexFile* inlined_into) const;
 
@@ -477,6 +539,11 @@ class CompilerDriver {
   std::map<ClassReference, bool> requires_constructor_barrier_
       GUARDED_BY(requires_constructor_barrier_lock_);
 
+  // The instantiable classes of the compiled dex files, by supertype. Written before the
+  // compilation starts and read-only afterwards.
+  std::map<TypeReference, std::vector<TypeReference>, TypeReferenceComparator>
+      closed_world_subtypes_;
+
   // All class references that this compiler has compiled. Indexed by class defs.
   using ClassStateTable = AtomicDexRefMap<mirror::Class::Status>;
   ClassStateTable compiled_classes_;
@@ -511,6 +578,10 @@ class CompilerDriver {
   std::unique_ptr<ThreadPool> parallel_thread_pool_;
   size_t parallel_thread_count_;
 
+  // Set by ThrottleCompilation().
+  Atomic<size_t> max_active_threads_;
+  Atomic<bool> only_hot_methods_;
+
   // A thread pool that guarantees running single-threaded on the main thread.
   std::unique_ptr<ThreadPool> single_thread_pool_;
 
@@ -534,6 +605,8 @@ class CompilerDriver {
 
   CompiledMethodStorage compiled_method_storage_;
 
+  CompiledMethodCache* compiled_method_cache_;
+
   // Info for profile guided compilation.
   const ProfileCompilationInfo* const profile_compilation_info_;
 
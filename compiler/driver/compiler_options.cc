@@ -42,9 +42,12 @@ CompilerOptions::CompilerOptions()
       compile_pic_(false),
       verbose_methods_(),
       abort_on_hard_verifier_failure_(false),
+      pipelined_compilation_(false),
+      closed_world_devirtualization_(false),
       init_failure_output_(nullptr),
       dump_cfg_file_name_(""),
       dump_cfg_append_(false),
+      dump_pass_profile_file_name_(""),
       force_determinism_(false),
       register_allocation_strategy_(RegisterAllocator::kRegisterAllocatorDefault),
       passes_to_run_(nullptr) {
@@ -101,8 +104,10 @@ void CompilerOptions::ParseRegisterAllocationStrategy(const StringPiece& option,
     register_allocation_strategy_ = RegisterAllocator::Strategy::kRegisterAllocatorLinearScan;
   } else if (choice == "graph-color") {
     register_allocation_strategy_ = RegisterAllocator::Strategy::kRegisterAllocatorGraphColor;
+  } else if (choice == "hybrid") {
+    register_allocation_strategy_ = RegisterAllocator::Strategy::kRegisterAllocatorHybrid;
   } else {
-    Usage("Unrecognized register allocation strategy. Try linear-scan, or graph-color.");
+    Usage("Unrecognized register allocation strategy. Try linear-scan, graph-color, or hybrid.");
   }
 }
 
@@ -144,12 +149,18 @@ bool CompilerOptions::ParseCompilerOption(const StringPiece& option, UsageFn Usa
     ParseDouble(option.data(), '=', 0.0, 100.0, &top_k_profile_threshold_, Usage);
   } else if (option == "--abort-on-hard-verifier-error") {
     abort_on_hard_verifier_failure_ = true;
+  } else if (option == "--pipelined-compilation") {
+    pipelined_compilation_ = true;
+  } else if (option == "--closed-world-devirtualization") {
+    closed_world_devirtualization_ = true;
   } else if (option.starts_with("--dump-init-failures=")) {
     ParseDumpInitFailures(option, Usage);
   } else if (option.starts_with("--dump-cfg=")) {
     dump_cfg_file_name_ = option.substr(strlen("--dump-cfg=")).data();
   } else if (option == "--dump-cfg-append") {
     dump_cfg_append_ = true;
+  } else if (option.starts_with("--dump-pass-profile=")) {
+    dump_pass_profile_file_name_ = option.substr(strlen("--dump-pass-profile=")).data();
   } else if (option.starts_with("--register-allocation-strategy=")) {
     ParseRegisterAllocationStrategy(option, Usage);
   } else if (option.starts_with("--verbose-methods=")) {
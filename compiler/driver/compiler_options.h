@@ -177,6 +177,10 @@ class CompilerOptions FINAL {
     return implicit_suspend_checks_;
   }
 
+  void SetImplicitSuspendChecks(bool value) {
+    implicit_suspend_checks_ = value;
+  }
+
   bool IsBootImage() const {
     return boot_image_;
   }
@@ -215,6 +219,14 @@ class CompilerOptions FINAL {
     return abort_on_hard_verifier_failure_;
   }
 
+  bool IsPipelinedCompilation() const {
+    return pipelined_compilation_;
+  }
+
+  bool IsClosedWorldDevirtualization() const {
+    return closed_world_devirtualization_;
+  }
+
   const std::vector<const DexFile*>* GetNoInlineFromDexFile() const {
     return no_inline_from_;
   }
@@ -233,6 +245,10 @@ class CompilerOptions FINAL {
     return dump_cfg_append_;
   }
 
+  const std::string& GetDumpPassProfileFileName() const {
+    return dump_pass_profile_file_name_;
+  }
+
   bool IsForceDeterminism() const {
     return force_determinism_;
   }
@@ -289,12 +305,24 @@ class CompilerOptions FINAL {
   // failure.
   bool abort_on_hard_verifier_failure_;
 
+  // Verify, initialize and compile each class in one pass instead of one pass per phase, so
+  // that the threads do not wait for the slowest class at the end of each phase. Code quality
+  // may be lower as classes that are not verified or initialized yet are not inlined from and
+  // keep their class initialization checks.
+  bool pipelined_compilation_;
+  // Devirtualize calls based on the class hierarchy of the compiled dex files alone.
+  bool closed_world_devirtualization_;
+
   // Log initialization of initialization failures to this stream if not null.
   std::unique_ptr<std::ostream> init_failure_output_;
 
   std::string dump_cfg_file_name_;
   bool dump_cfg_append_;
 
+  // If not empty, per-pass compile time, arena usage and graph sizes are aggregated over the
+  // session and written to this file as JSON.
+  std::string dump_pass_profile_file_name_;
+
   // Whether the compiler should trade performance for determinism to guarantee exactly reproducible
   // outcomes.
   bool force_determinism_;
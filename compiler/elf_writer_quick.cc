@@ -54,12 +54,14 @@ class DebugInfoTask : public Task {
                 const InstructionSetFeatures* features,
                 size_t rodata_section_size,
                 size_t text_section_size,
-                const ArrayRef<const debug::MethodDebugInfo>& method_infos)
+                const ArrayRef<const debug::MethodDebugInfo>& method_infos,
+                size_t thread_count)
       : isa_(isa),
         instruction_set_features_(features),
         rodata_section_size_(rodata_section_size),
         text_section_size_(text_section_size),
-        method_infos_(method_infos) {
+        method_infos_(method_infos),
+        thread_count_(thread_count) {
   }
 
   void Run(Thread*) {
@@ -67,7 +69,8 @@ class DebugInfoTask : public Task {
                                        instruction_set_features_,
                                        rodata_section_size_,
                                        text_section_size_,
-                                       method_infos_);
+                                       method_infos_,
+                                       thread_count_);
   }
 
   std::vector<uint8_t>* GetResult() {
@@ -80,6 +83,7 @@ class DebugInfoTask : public Task {
   size_t rodata_section_size_;
   size_t text_section_size_;
   const ArrayRef<const debug::MethodDebugInfo> method_infos_;
+  const size_t thread_count_;
   std::vector<uint8_t> result_;
 };
 
@@ -89,7 +93,8 @@ class ElfWriterQuick FINAL : public ElfWriter {
   ElfWriterQuick(InstructionSet instruction_set,
                  const InstructionSetFeatures* features,
                  const CompilerOptions* compiler_options,
-                 File* elf_file);
+                 File* elf_file,
+                 size_t thread_count);
   ~ElfWriterQuick();
 
   void Start() OVERRIDE;
@@ -118,6 +123,7 @@ class ElfWriterQuick FINAL : public ElfWriter {
   const InstructionSetFeatures* instruction_set_features_;
   const CompilerOptions* const compiler_options_;
   File* const elf_file_;
+  const size_t thread_count_;
   size_t rodata_size_;
   size_t text_size_;
   size_t bss_size_;
@@ -134,17 +140,20 @@ class ElfWriterQuick FINAL : public ElfWriter {
 std::unique_ptr<ElfWriter> CreateElfWriterQuick(InstructionSet instruction_set,
                                                 const InstructionSetFeatures* features,
                                                 const CompilerOptions* compiler_options,
-                                                File* elf_file) {
+                                                File* elf_file,
+                                                size_t thread_count) {
   if (Is64BitInstructionSet(instruction_set)) {
     return std::make_unique<ElfWriterQuick<ElfTypes64>>(instruction_set,
                                                         features,
                                                         compiler_options,
-                                                        elf_file);
+                                                        elf_file,
+                                                        thread_count);
   } else {
     return std::make_unique<ElfWriterQuick<ElfTypes32>>(instruction_set,
                                                         features,
                                                         compiler_options,
-                                                        elf_file);
+                                                        elf_file,
+                                                        thread_count);
   }
 }
 
@@ -152,11 +161,13 @@ template <typename ElfTypes>
 ElfWriterQuick<ElfTypes>::ElfWriterQuick(InstructionSet instruction_set,
                                          const InstructionSetFeatures* features,
                                          const CompilerOptions* compiler_options,
-                                         File* elf_file)
+                                         File* elf_file,
+                                         size_t thread_count)
     : ElfWriter(),
       instruction_set_features_(features),
       compiler_options_(compiler_options),
       elf_file_(elf_file),
+      thread_count_(thread_count),
       rodata_size_(0u),
       text_size_(0u),
       bss_size_(0u),
@@ -243,7 +254,8 @@ void ElfWriterQuick<ElfTypes>::PrepareDebugInfo(
                           instruction_set_features_,
                           rodata_size_,
                           text_size_,
-                          method_infos));
+                          method_infos,
+                          thread_count_));
     debug_info_thread_pool_ = std::unique_ptr<ThreadPool>(
         new ThreadPool("Mini-debug-info writer", 1));
     debug_info_thread_pool_->AddTask(self, debug_info_task_.get());
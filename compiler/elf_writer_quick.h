@@ -28,10 +28,12 @@ namespace art {
 class CompilerOptions;
 class InstructionSetFeatures;
 
+// The mini-debug-info, if any, is compressed on up to `thread_count` threads.
 std::unique_ptr<ElfWriter> CreateElfWriterQuick(InstructionSet instruction_set,
                                                 const InstructionSetFeatures* features,
                                                 const CompilerOptions* compiler_options,
-                                                File* elf_file);
+                                                File* elf_file,
+                                                size_t thread_count);
 
 }  // namespace art
 
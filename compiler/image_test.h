@@ -242,11 +242,13 @@ inline void CompilationHelper::Compile(CompilerDriver* driver,
         elf_writers.emplace_back(CreateElfWriterQuick(driver->GetInstructionSet(),
                                                       driver->GetInstructionSetFeatures(),
                                                       &driver->GetCompilerOptions(),
-                                                      oat_file.GetFile()));
+                                                      oat_file.GetFile(),
+                                                      driver->GetThreadCount()));
         elf_writers.back()->Start();
         oat_writers.emplace_back(new OatWriter(/*compiling_boot_image*/true,
                                                &timings,
-                                               /*profile_compilation_info*/nullptr));
+                                               /*profile_compilation_info*/nullptr,
+                                               CompactDexLevel::kCompactDexLevelNone));
       }
 
       std::vector<OutputStream*> rodata;
@@ -273,6 +275,7 @@ inline void CompilationHelper::Compile(CompilerDriver* driver,
             &key_value_store,
             /* verify */ false,           // Dex files may be dex-to-dex-ed, don't verify.
             /* update_input_vdex */ false,
+            /* copy_dex_files */ true,
             &cur_opened_dex_files_map,
             &cur_opened_dex_files);
         ASSERT_TRUE(dex_files_ok);
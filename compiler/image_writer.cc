@@ -72,6 +72,7 @@
 #include "oat_file_manager.h"
 #include "runtime.h"
 #include "scoped_thread_state_change-inl.h"
+#include "thread_pool.h"
 #include "utils/dex_cache_arrays_layout-inl.h"
 
 using ::art::mirror::Class;
@@ -180,20 +181,33 @@ bool ImageWriter::Write(int image_fd,
   CHECK(!oat_filenames.empty());
   CHECK_EQ(image_filenames.size(), oat_filenames.size());
 
+  // Each object is copied to the location assigned by CalculateNewObjectOffsets(), so the copies
+  // can be made in any order and the image does not depend on the number of threads.
+  std::unique_ptr<ThreadPool> thread_pool;
+  if (compiler_driver_.GetThreadCount() > 1u) {
+    thread_pool.reset(
+        new ThreadPool("Image writer thread pool", compiler_driver_.GetThreadCount() - 1u));
+  }
+
   {
     ScopedObjectAccess soa(Thread::Current());
     for (size_t i = 0; i < oat_filenames.size(); ++i) {
       CreateHeader(i);
-      CopyAndFixupNativeData(i);
     }
+    ForAll(thread_pool.get(),
+           oat_filenames.size(),
+           [&](size_t oat_index) REQUIRES_SHARED(Locks::mutator_lock_) {
+             CopyAndFixupNativeData(oat_index);
+           });
   }
 
   {
     // TODO: heap validation can't handle these fix up passes.
     ScopedObjectAccess soa(Thread::Current());
     Runtime::Current()->GetHeap()->DisableObjectValidation();
-    CopyAndFixupObjects();
+    CopyAndFixupObjects(thread_pool.get());
   }
+  thread_pool.reset();
 
   for (size_t i = 0; i < image_filenames.size(); ++i) {
     const char* image_filename = image_filenames[i];
@@ -2151,12 +2165,78 @@ void ImageWriter::CopyAndFixupNativeData(size_t oat_index) {
   }
 }
 
-void ImageWriter::CopyAndFixupObjects() {
+// Ranges per thread of ImageWriter::ForAll(), enough for stealing to even out the object sizes.
+static constexpr size_t kRangesPerWorker = 16u;
+
+// Runs the ranges of one thread of ImageWriter::ForAll().
+class ImageWriterTask FINAL : public WorkStealingWorker {
+ public:
+  ImageWriterTask(WorkStealingRanges* ranges,
+                  size_t worker_index,
+                  const std::function<void(size_t)>* visit)
+      : WorkStealingWorker(ranges, worker_index), visit_(visit) {}
+
+  void Run(Thread* self) OVERRIDE {
+    ScopedObjectAccess soa(self);
+    WorkStealingWorker::Run(self);
+  }
+
+  void Finalize() OVERRIDE {
+    delete this;
+  }
+
+ protected:
+  void Visit(Thread* self ATTRIBUTE_UNUSED, size_t index) OVERRIDE {
+    (*visit_)(index);
+  }
+
+ private:
+  const std::function<void(size_t)>* const visit_;
+};
+
+void ImageWriter::ForAll(ThreadPool* thread_pool,
+                         size_t end,
+                         const std::function<void(size_t)>& visit) {
+  if (thread_pool == nullptr) {
+    for (size_t i = 0; i != end; ++i) {
+      visit(i);
+    }
+    return;
+  }
+  // The pool threads and this thread.
+  const size_t num_workers = thread_pool->GetThreadCount() + 1u;
+  WorkStealingRanges ranges(
+      WorkStealingRanges::SplitByCost(0u,
+                                      end,
+                                      num_workers * kRangesPerWorker,
+                                      [](size_t index ATTRIBUTE_UNUSED) { return 1u; }),
+      num_workers);
+  Thread* self = Thread::Current();
+  for (size_t i = 0; i != num_workers; ++i) {
+    thread_pool->AddTask(self, new ImageWriterTask(&ranges, i, &visit));
+  }
+  // The tasks run with the mutator lock, including the ones run by this thread in Wait().
+  ScopedThreadSuspension sts(self, kNative);
+  thread_pool->StartWorkers(self);
+  thread_pool->Wait(self, /* do_work */ true, /* may_hold_locks */ false);
+  thread_pool->StopWorkers(self);
+}
+
+void ImageWriter::CopyAndFixupObjects(ThreadPool* thread_pool) {
+  std::vector<Object*> objects;
   auto visitor = [&](Object* obj) REQUIRES_SHARED(Locks::mutator_lock_) {
     DCHECK(obj != nullptr);
-    CopyAndFixupObject(obj);
+    if (!IsInBootImage(obj)) {
+      objects.push_back(obj);
+    }
   };
   Runtime::Current()->GetHeap()->VisitObjects(visitor);
+  ForAll(thread_pool,
+         objects.size(),
+         [&](size_t index) REQUIRES_SHARED(Locks::mutator_lock_) {
+           CopyAndFixupObject(objects[index]);
+         });
+  pointer_arrays_.clear();
   // Fix up the object previously had hash codes.
   for (const auto& hash_pair : saved_hashcode_map_) {
     Object* obj = hash_pair.first;
@@ -2211,7 +2291,8 @@ void ImageWriter::CopyAndFixupObject(Object* obj) {
   DCHECK_LT(offset, image_info.image_end_);
   const auto* src = reinterpret_cast<const uint8_t*>(obj);
 
-  image_info.image_bitmap_->Set(dst);  // Mark the obj as live.
+  // Mark the obj as live. The objects are copied in parallel and neighbours share bitmap words.
+  image_info.image_bitmap_->AtomicTestAndSet(dst);
 
   const size_t n = obj->SizeOf();
   DCHECK_LE(offset + n, image_info.image_->Size());
@@ -2363,11 +2444,10 @@ void ImageWriter::FixupObject(Object* orig, Object* copy) {
   auto* klass = orig->GetClass();
   if (klass->IsIntArrayClass() || klass->IsLongArrayClass()) {
     // Is this a native pointer array?
+    // Objects are copied in parallel, so leave the map unmodified until all of them are done.
     auto it = pointer_arrays_.find(down_cast<mirror::PointerArray*>(orig));
     if (it != pointer_arrays_.end()) {
-      // Should only need to fixup every pointer array exactly once.
       FixupPointerArray(copy, down_cast<mirror::PointerArray*>(orig), klass, it->second);
-      pointer_arrays_.erase(it);
       return;
     }
   }
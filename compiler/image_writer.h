@@ -21,6 +21,7 @@
 #include "base/memory_tool.h"
 
 #include <cstddef>
+#include <functional>
 #include <memory>
 #include <set>
 #include <stack>
@@ -63,6 +64,7 @@ class ClassLoader;
 
 class ClassLoaderVisitor;
 class ImtConflictTable;
+class ThreadPool;
 
 static constexpr int kInvalidFd = -1;
 
@@ -414,9 +416,14 @@ class ImageWriter FINAL {
   void UnbinObjectsIntoOffset(mirror::Object* obj)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Calls `visit` for each index in [0, end) on the threads of `thread_pool` and this thread,
+  // or on this thread only if `thread_pool` is null.
+  void ForAll(ThreadPool* thread_pool, size_t end, const std::function<void(size_t)>& visit)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
   // Creates the contiguous image in memory and adjusts pointers.
   void CopyAndFixupNativeData(size_t oat_index) REQUIRES_SHARED(Locks::mutator_lock_);
-  void CopyAndFixupObjects() REQUIRES_SHARED(Locks::mutator_lock_);
+  void CopyAndFixupObjects(ThreadPool* thread_pool) REQUIRES_SHARED(Locks::mutator_lock_);
   void CopyAndFixupObject(mirror::Object* obj) REQUIRES_SHARED(Locks::mutator_lock_);
   void CopyAndFixupMethod(ArtMethod* orig, ArtMethod* copy, const ImageInfo& image_info)
       REQUIRES_SHARED(Locks::mutator_lock_);
@@ -59,11 +59,11 @@ extern "C" void jit_unload(void* handle) {
 }
 
 extern "C" bool jit_compile_method(
-    void* handle, ArtMethod* method, Thread* self, bool osr)
+    void* handle, ArtMethod* method, Thread* self, bool osr, bool baseline)
     REQUIRES_SHARED(Locks::mutator_lock_) {
   auto* jit_compiler = reinterpret_cast<JitCompiler*>(handle);
   DCHECK(jit_compiler != nullptr);
-  return jit_compiler->CompileMethod(self, method, osr);
+  return jit_compiler->CompileMethod(self, method, osr, baseline);
 }
 
 extern "C" void jit_types_loaded(void* handle, mirror::Class** types, size_t count)
@@ -100,6 +100,9 @@ JitCompiler::JitCompiler() {
   // Set debuggability based on the runtime value.
   compiler_options_->SetDebuggable(Runtime::Current()->IsJavaDebuggable());
 
+  // Implicit suspend checks need the runtime's suspension fault handler.
+  compiler_options_->SetImplicitSuspendChecks(Runtime::Current()->ImplicitSuspendChecks());
+
   // Special case max code units for inlining, whose default is "unset" (implictly
   // meaning no limit).
   compiler_options_->SetInlineMaxCodeUnits(CompilerOptions::kDefaultInlineMaxCodeUnits);
@@ -162,16 +165,20 @@ JitCompiler::JitCompiler() {
         << "Generating debug info only works with one compiler thread";
     jit_logger_.reset(new JitLogger());
     jit_logger_->OpenLog();
+    debug_info_packer_.reset(
+        new JitDebugInfoPacker(instruction_set, instruction_set_features_.get()));
+    SetJITCodeEntryPacker(debug_info_packer_.get());
   }
 }
 
 JitCompiler::~JitCompiler() {
   if (compiler_options_->GetGenerateDebugInfo()) {
     jit_logger_->CloseLog();
+    SetJITCodeEntryPacker(nullptr);
   }
 }
 
-bool JitCompiler::CompileMethod(Thread* self, ArtMethod* method, bool osr) {
+bool JitCompiler::CompileMethod(Thread* self, ArtMethod* method, bool osr, bool baseline) {
   DCHECK(!method->IsProxyMethod());
   DCHECK(method->GetDeclaringClass()->IsResolved());
 
@@ -185,15 +192,11 @@ bool JitCompiler::CompileMethod(Thread* self, ArtMethod* method, bool osr) {
     TimingLogger::ScopedTiming t2("Compiling", &logger);
     JitCodeCache* const code_cache = runtime->GetJit()->GetCodeCache();
     success = compiler_driver_->GetCompiler()->JitCompile(
-        self, code_cache, method, osr, jit_logger_.get());
+        self, code_cache, method, osr, baseline, jit_logger_.get(), debug_info_packer_.get());
   }
 
-  // Trim maps to reduce memory usage.
-  // TODO: move this to an idle phase.
-  {
-    TimingLogger::ScopedTiming t2("TrimMaps", &logger);
-    runtime->GetJitArenaPool()->TrimMaps();
-  }
+  // The arena pool is trimmed by the JIT at the end of the compile batch, so that the next
+  // compilation reuses the arenas of this one.
 
   runtime->GetJit()->AddTimingLogger(logger);
   return success;
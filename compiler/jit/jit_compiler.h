@@ -19,6 +19,7 @@
 
 #include "base/mutex.h"
 #include "compiled_method.h"
+#include "jit_debug_info_packer.h"
 #include "jit_logger.h"
 #include "driver/compiler_driver.h"
 #include "driver/compiler_options.h"
@@ -36,7 +37,7 @@ class JitCompiler {
   virtual ~JitCompiler();
 
   // Compilation entrypoint. Returns whether the compilation succeeded.
-  bool CompileMethod(Thread* self, ArtMethod* method, bool osr)
+  bool CompileMethod(Thread* self, ArtMethod* method, bool osr, bool baseline)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
   CompilerOptions* GetCompilerOptions() const {
@@ -52,6 +53,7 @@ class JitCompiler {
   std::unique_ptr<CompilerDriver> compiler_driver_;
   std::unique_ptr<const InstructionSetFeatures> instruction_set_features_;
   std::unique_ptr<JitLogger> jit_logger_;
+  std::unique_ptr<JitDebugInfoPacker> debug_info_packer_;
 
   JitCompiler();
 
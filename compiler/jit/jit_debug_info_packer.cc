@@ -0,0 +1,66 @@
+/*
+ * Copyright 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jit_debug_info_packer.h"
+
+#include "debug/elf_debug_writer.h"
+#include "thread-current-inl.h"
+
+namespace art {
+namespace jit {
+
+JitDebugInfoPacker::JitDebugInfoPacker(InstructionSet isa, const InstructionSetFeatures* features)
+    : isa_(isa),
+      features_(features),
+      lock_("JIT debug info packer lock", kJitDebugInfoPackerLock) {}
+
+void JitDebugInfoPacker::AddMethod(const debug::MethodDebugInfo& info) {
+  DCHECK(info.trampoline_name == nullptr);
+  DCHECK(!info.is_code_address_text_relative);
+  PackableMethod method;
+  method.info = info;
+  method.cfi.assign(info.cfi.begin(), info.cfi.end());
+  method.info.cfi = ArrayRef<const uint8_t>(method.cfi);
+  uintptr_t address = static_cast<uintptr_t>(info.code_address);
+  MutexLock mu(Thread::Current(), lock_);
+  // Moving the vector keeps its storage, so `info.cfi` stays valid.
+  bool inserted = methods_.emplace(address, std::move(method)).second;
+  DCHECK(inserted) << "Debug info for 0x" << std::hex << address << " added twice";
+}
+
+std::vector<uint8_t> JitDebugInfoPacker::Pack(ArrayRef<const uintptr_t> addresses) {
+  std::vector<debug::MethodDebugInfo> infos;
+  infos.reserve(addresses.size());
+  MutexLock mu(Thread::Current(), lock_);
+  for (uintptr_t address : addresses) {
+    auto it = methods_.find(address);
+    if (it == methods_.end()) {
+      // Registered before the packer was set.
+      return std::vector<uint8_t>();
+    }
+    infos.push_back(it->second.info);
+  }
+  return debug::WriteDebugElfFileForMethods(
+      isa_, features_, ArrayRef<const debug::MethodDebugInfo>(infos));
+}
+
+void JitDebugInfoPacker::Remove(uintptr_t address) {
+  MutexLock mu(Thread::Current(), lock_);
+  methods_.erase(address);
+}
+
+}  // namespace jit
+}  // namespace art
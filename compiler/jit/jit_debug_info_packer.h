@@ -0,0 +1,68 @@
+/*
+ * Copyright 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_JIT_JIT_DEBUG_INFO_PACKER_H_
+#define ART_COMPILER_JIT_JIT_DEBUG_INFO_PACKER_H_
+
+#include <unordered_map>
+#include <vector>
+
+#include "arch/instruction_set.h"
+#include "base/mutex.h"
+#include "debug/method_debug_info.h"
+#include "jit/debugger_interface.h"
+
+namespace art {
+
+class InstructionSetFeatures;
+
+namespace jit {
+
+// Keeps the debug info of the JITed methods registered with the native debugger, so that the
+// debugger interface can replace their entries by one ELF file describing many methods.
+//
+// The debug info refers to the stack maps in the code cache, which stay alive as long as the
+// method is registered, and to a copy of the CFI, which is only live during the compilation.
+class JitDebugInfoPacker FINAL : public JITCodeEntryPacker {
+ public:
+  JitDebugInfoPacker(InstructionSet isa, const InstructionSetFeatures* features);
+
+  // Remember the debug info of a method. Must be called before creating its entry.
+  void AddMethod(const debug::MethodDebugInfo& info) REQUIRES(!lock_);
+
+  std::vector<uint8_t> Pack(ArrayRef<const uintptr_t> addresses) OVERRIDE REQUIRES(!lock_);
+
+  void Remove(uintptr_t address) OVERRIDE REQUIRES(!lock_);
+
+ private:
+  struct PackableMethod {
+    debug::MethodDebugInfo info;
+    std::vector<uint8_t> cfi;  // Pointed to by `info.cfi`.
+  };
+
+  const InstructionSet isa_;
+  const InstructionSetFeatures* const features_;
+
+  Mutex lock_;
+  std::unordered_map<uintptr_t, PackableMethod> methods_ GUARDED_BY(lock_);
+
+  DISALLOW_COPY_AND_ASSIGN(JitDebugInfoPacker);
+};
+
+}  // namespace jit
+}  // namespace art
+
+#endif  // ART_COMPILER_JIT_JIT_DEBUG_INFO_PACKER_H_
@@ -18,12 +18,16 @@
 
 #include "arch/instruction_set.h"
 #include "art_method-inl.h"
+#include "base/bit_utils.h"
 #include "base/time_utils.h"
 #include "base/unix_file/fd_file.h"
+#include "debug/elf_debug_writer.h"
+#include "debug/method_debug_info.h"
 #include "driver/compiler_driver.h"
 #include "jit/jit.h"
 #include "jit/jit_code_cache.h"
 #include "oat_file-inl.h"
+#include "thread-current-inl.h"
 
 namespace art {
 namespace jit {
@@ -50,6 +54,15 @@ void JitLogger::OpenPerfMapLog() {
   }
 }
 
+void JitLogger::WriteLog(const void* ptr,
+                         size_t code_size,
+                         ArtMethod* method,
+                         const debug::MethodDebugInfo* method_info) {
+  MutexLock mu(Thread::Current(), lock_);
+  WritePerfMapLog(ptr, code_size, method);
+  WriteJitDumpLog(ptr, code_size, method, method_info);
+}
+
 void JitLogger::WritePerfMapLog(const void* ptr, size_t code_size, ArtMethod* method) {
   if (perf_file_ != nullptr) {
     std::string method_name = method->PrettyMethod();
@@ -84,7 +97,23 @@ void JitLogger::ClosePerfMapLog() {
 //  +--------------------------------+
 //  |  PerfJitHeader                 |
 //  +--------------------------------+
-//  |  PerfJitCodeLoad {             | .
+//  |  PerfJitCodeDebugInfo     {    | .
+//  |    struct PerfJitBase;         |  .
+//  |    uint64_t address_;          |   .
+//  |    uint64_t entry_count_;      |   .
+//  |    struct PerfJitDebugEntry;   |   .
+//  |  }                             |   .
+//  +--------------------------------+   .
+//  |  PerfJitCodeUnwindingInfo {    |   .
+//  |    struct PerfJitBase;         |   .
+//  |    uint64_t unwinding_size_;   |   .
+//  |    uint64_t eh_frame_hdr_size_;|   .
+//  |    uint64_t mapped_size_;      |   .
+//  |  }                             |   .
+//  +-                              -+   .
+//  |  .eh_frame, .eh_frame_hdr      |   .
+//  +--------------------------------+   .
+//  |  PerfJitCodeLoad {             |   .
 //  |    struct PerfJitBase;         |  .
 //  |    uint32_t process_id_;       |   .
 //  |    uint32_t thread_id_;        |   .
@@ -96,19 +125,15 @@ void JitLogger::ClosePerfMapLog() {
 //  +-                              -+   .
 //  |  method_name'\0'               |   +--> one jitted method
 //  +-                              -+   .
-//  |  jitted code binary            |   .
-//  |  ...                           |   .
-//  +--------------------------------+   .
-//  |  PerfJitCodeDebugInfo     {    |   .
-//  |    struct PerfJitBase;         |   .
-//  |    uint64_t address_;          |   .
-//  |    uint64_t entry_count_;      |   .
-//  |    struct PerfJitDebugEntry;   |  .
-//  |  }                             | .
+//  |  jitted code binary            |  .
+//  |  ...                           | .
 //  +--------------------------------+
-//  |  PerfJitCodeLoad               |
+//  |  PerfJitCodeDebugInfo          |
 //     ...
 //
+//  The debug and unwinding info records of a method precede its load record, and are only
+//  written if the method was compiled with debug info.
+//
 struct PerfJitHeader {
   uint32_t magic_;            // Characters "JiTD"
   uint32_t version_;          // Header version
@@ -148,7 +173,10 @@ struct PerfJitBase {
     kDebugInfo = 2,
 
     // Logs JIT VM end of life event.
-    kClose = 3
+    kClose = 3,
+
+    // Logs the .eh_frame and .eh_frame_hdr of a jitted method.
+    kUnwindingInfo = 4
   };
   uint32_t event_;       // Must be one of the events defined in PerfJitEvent.
   uint32_t size_;        // Total size of this event record.
@@ -172,7 +200,6 @@ struct PerfJitCodeLoad : PerfJitBase {
 };
 
 // This structure is for source line/column mapping.
-// Currently this feature is not implemented in ART JIT yet.
 struct PerfJitDebugEntry {
   uint64_t address_;      // Code address which maps to the line/column in source.
   uint32_t line_number_;  // Source line number starting at 1.
@@ -182,13 +209,25 @@ struct PerfJitDebugEntry {
 
 // Logs debug line information (kDebugInfo).
 // This structure is for source line/column mapping.
-// Currently this feature is not implemented in ART JIT yet.
 struct PerfJitCodeDebugInfo : PerfJitBase {
   uint64_t address_;              // Starting code address which the debug info describes.
   uint64_t entry_count_;          // How many instances of PerfJitDebugEntry.
   PerfJitDebugEntry entries_[0];  // Followed by entry_count_ instances of PerfJitDebugEntry.
 };
 
+// Logs unwinding information (kUnwindingInfo).
+// 'perf inject' copies the data into the .eh_frame and .eh_frame_hdr sections of the ELF file it
+// generates for the next loaded method, which it places right after the code.
+struct PerfJitCodeUnwindingInfo : PerfJitBase {
+  uint64_t unwinding_size_;     // Size of the unwinding data, .eh_frame followed by .eh_frame_hdr.
+  uint64_t eh_frame_hdr_size_;  // Size of the .eh_frame_hdr at the end of the unwinding data.
+  uint64_t mapped_size_;        // Size of the unwinding data mapped in memory, 0 since it is not.
+                                // Followed by unwinding data, padded to 8 bytes.
+};
+
+// Name of the PerfJitDebugEntry if it is in the same file as the previous one.
+static const char kPerfJitSameFileName[] = "\xff";
+
 static uint32_t GetElfMach() {
 #if defined(__arm__)
   static const uint32_t kElfMachARM = 0x28;
@@ -225,8 +264,108 @@ void JitLogger::CloseMarkerFile() {
   }
 }
 
-void JitLogger::WriteJitDumpDebugInfo() {
-  // In the future, we can add java source file line/column mapping here.
+void JitLogger::AppendJitDump(const void* data, size_t size) {
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+  jit_dump_buffer_.insert(jit_dump_buffer_.end(), bytes, bytes + size);
+}
+
+void JitLogger::PadJitDump(size_t padding) {
+  jit_dump_buffer_.resize(jit_dump_buffer_.size() + padding, 0u);
+}
+
+void JitLogger::FlushJitDump() {
+  if (!jit_dump_buffer_.empty()) {
+    if (!jit_dump_file_->WriteFully(jit_dump_buffer_.data(), jit_dump_buffer_.size())) {
+      LOG(WARNING) << "Failed to write jitted method info in jit dump file.";
+    }
+    jit_dump_buffer_.clear();
+  }
+}
+
+void JitLogger::WriteJitDumpDebugInfo(const void* ptr, const debug::MethodDebugInfo& method_info) {
+  debug::LineTable line_table;
+  if (method_info.dex_file == nullptr ||
+      !debug::MakeLineTableForMethod(method_info.isa, method_info, &line_table) ||
+      line_table.empty()) {
+    return;
+  }
+  const DexFile* dex_file = method_info.dex_file;
+  const DexFile::ClassDef& class_def = dex_file->GetClassDef(method_info.class_def_index);
+  const char* source_file = dex_file->GetSourceFile(class_def);
+  if (source_file == nullptr) {
+    return;
+  }
+  // Guess the directory from the package name, like the .debug_line writer does.
+  std::string file_name(source_file);
+  std::string class_name(dex_file->GetClassDescriptor(class_def));
+  size_t class_name_slash = class_name.find_last_of('/');
+  if (file_name.find('/') == std::string::npos &&
+      class_name.front() == 'L' &&
+      class_name_slash != std::string::npos) {
+    file_name = class_name.substr(1, class_name_slash) + file_name;
+  }
+
+  const uint64_t code_address = reinterpret_cast<uint64_t>(ptr);
+  size_t size = sizeof(PerfJitCodeDebugInfo) +
+      line_table.size() * sizeof(PerfJitDebugEntry) +
+      file_name.size() + 1 +
+      (line_table.size() - 1) * sizeof(kPerfJitSameFileName);
+  size_t padding = RoundUp(size, 8) - size;
+
+  // PerfJitCodeDebugInfo itself is not default constructible because of the trailing entries.
+  struct : PerfJitBase {
+    uint64_t address_;
+    uint64_t entry_count_;
+  } debug_info;
+  static_assert(sizeof(debug_info) == sizeof(PerfJitCodeDebugInfo), "Unexpected debug layout");
+  std::memset(&debug_info, 0, sizeof(debug_info));
+  debug_info.event_ = PerfJitCodeDebugInfo::kDebugInfo;
+  debug_info.size_ = size + padding;
+  debug_info.time_stamp_ = art::NanoTime();    // CLOCK_MONOTONIC clock is required.
+  debug_info.address_ = code_address;
+  debug_info.entry_count_ = line_table.size();
+  AppendJitDump(&debug_info, sizeof(debug_info));
+  for (size_t i = 0; i != line_table.size(); ++i) {
+    struct {
+      uint64_t address_;
+      uint32_t line_number_;
+      uint32_t column_;
+    } entry;
+    static_assert(sizeof(entry) == sizeof(PerfJitDebugEntry), "Unexpected debug entry layout");
+    entry.address_ = code_address + line_table[i].pc;
+    entry.line_number_ = static_cast<uint32_t>(line_table[i].line);
+    entry.column_ = 0;
+    AppendJitDump(&entry, sizeof(entry));
+    if (i == 0) {
+      AppendJitDump(file_name.c_str(), file_name.size() + 1);
+    } else {
+      AppendJitDump(kPerfJitSameFileName, sizeof(kPerfJitSameFileName));
+    }
+  }
+  PadJitDump(padding);
+}
+
+void JitLogger::WriteJitDumpUnwindingInfo(const debug::MethodDebugInfo& method_info) {
+  if (method_info.cfi.empty()) {
+    return;
+  }
+  std::vector<uint8_t> unwinding_data;
+  size_t eh_frame_hdr_size =
+      debug::WriteEhFrameForMethodAfterCode(method_info.isa, method_info, &unwinding_data);
+  size_t size = sizeof(PerfJitCodeUnwindingInfo) + unwinding_data.size();
+  size_t padding = RoundUp(size, 8) - size;
+
+  PerfJitCodeUnwindingInfo unwinding_info;
+  std::memset(&unwinding_info, 0, sizeof(unwinding_info));
+  unwinding_info.event_ = PerfJitCodeUnwindingInfo::kUnwindingInfo;
+  unwinding_info.size_ = size + padding;
+  unwinding_info.time_stamp_ = art::NanoTime();    // CLOCK_MONOTONIC clock is required.
+  unwinding_info.unwinding_size_ = unwinding_data.size();
+  unwinding_info.eh_frame_hdr_size_ = eh_frame_hdr_size;
+  unwinding_info.mapped_size_ = 0;
+  AppendJitDump(&unwinding_info, sizeof(unwinding_info));
+  AppendJitDump(unwinding_data.data(), unwinding_data.size());
+  PadJitDump(padding);
 }
 
 void JitLogger::WriteJitDumpHeader() {
@@ -267,10 +406,18 @@ void JitLogger::OpenJitDumpLog() {
   WriteJitDumpHeader();
 }
 
-void JitLogger::WriteJitDumpLog(const void* ptr, size_t code_size, ArtMethod* method) {
+void JitLogger::WriteJitDumpLog(const void* ptr,
+                                size_t code_size,
+                                ArtMethod* method,
+                                const debug::MethodDebugInfo* method_info) {
   if (jit_dump_file_ != nullptr) {
     std::string method_name = method->PrettyMethod();
 
+    if (method_info != nullptr) {
+      WriteJitDumpDebugInfo(ptr, *method_info);
+      WriteJitDumpUnwindingInfo(*method_info);
+    }
+
     PerfJitCodeLoad jit_code;
     std::memset(&jit_code, 0, sizeof(jit_code));
     jit_code.event_ = PerfJitCodeLoad::kLoad;
@@ -287,18 +434,22 @@ void JitLogger::WriteJitDumpLog(const void* ptr, size_t code_size, ArtMethod* me
     // - PerfJitCodeLoad structure
     // - Method name
     // - Complete generated code of this method
-    //
-    // Use UNUSED() here to avoid compiler warnings.
-    UNUSED(jit_dump_file_->WriteFully(reinterpret_cast<const char*>(&jit_code), sizeof(jit_code)));
-    UNUSED(jit_dump_file_->WriteFully(method_name.c_str(), method_name.size() + 1));
-    UNUSED(jit_dump_file_->WriteFully(ptr, code_size));
+    AppendJitDump(&jit_code, sizeof(jit_code));
+    AppendJitDump(method_name.c_str(), method_name.size() + 1);
+    AppendJitDump(ptr, code_size);
 
-    WriteJitDumpDebugInfo();
+    if (jit_dump_buffer_.size() >= kJitDumpBufferSize) {
+      FlushJitDump();
+    }
   }
 }
 
 void JitLogger::CloseJitDumpLog() {
   if (jit_dump_file_ != nullptr) {
+    {
+      MutexLock mu(Thread::Current(), lock_);
+      FlushJitDump();
+    }
     CloseMarkerFile();
     UNUSED(jit_dump_file_->Flush());
     UNUSED(jit_dump_file_->Close());
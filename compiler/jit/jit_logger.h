@@ -26,6 +26,10 @@ namespace art {
 
 class ArtMethod;
 
+namespace debug {
+struct MethodDebugInfo;
+}  // namespace debug
+
 namespace jit {
 
 //
@@ -84,21 +88,30 @@ namespace jit {
 //         Source code can also be displayed if the ELF file has debug symbols.
 //       - Make sure above small ELF files are available for 'perf annotate' tool to access,
 //         so that jitted code can be displayed in assembly view.
+//       UNWINDING AND LINE NUMBERS
+//       - With --generate-debug-info, the jit-PID.dump file also records the .eh_frame of each
+//         jitted method and its native pc to Java line mapping. 'perf inject' puts them into the
+//         small ELF files, so that perf can unwind through jitted frames and show source lines.
+//         Use 'perf record -k mono --call-graph=dwarf' to get call graphs through jitted code.
+//       - Records are buffered in memory and written out in chunks; the file is only complete
+//         once the runtime shuts down.
 //
 class JitLogger {
   public:
-    JitLogger() : code_index_(0), marker_address_(nullptr) {}
+    JitLogger() : code_index_(0), marker_address_(nullptr), lock_("JIT logger lock") {}
 
     void OpenLog() {
       OpenPerfMapLog();
       OpenJitDumpLog();
     }
 
-    void WriteLog(const void* ptr, size_t code_size, ArtMethod* method)
-        REQUIRES_SHARED(Locks::mutator_lock_) {
-      WritePerfMapLog(ptr, code_size, method);
-      WriteJitDumpLog(ptr, code_size, method);
-    }
+    // May be called concurrently by the JIT compiler threads. The method_info, if not null,
+    // provides the unwinding and line information of the code.
+    void WriteLog(const void* ptr,
+                  size_t code_size,
+                  ArtMethod* method,
+                  const debug::MethodDebugInfo* method_info)
+        REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(!lock_);
 
     void CloseLog() {
       ClosePerfMapLog();
@@ -109,24 +122,39 @@ class JitLogger {
     // For perf-map profiling
     void OpenPerfMapLog();
     void WritePerfMapLog(const void* ptr, size_t code_size, ArtMethod* method)
-        REQUIRES_SHARED(Locks::mutator_lock_);
+        REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(lock_);
     void ClosePerfMapLog();
 
     // For perf-inject profiling
     void OpenJitDumpLog();
-    void WriteJitDumpLog(const void* ptr, size_t code_size, ArtMethod* method)
-        REQUIRES_SHARED(Locks::mutator_lock_);
-    void CloseJitDumpLog();
+    void WriteJitDumpLog(const void* ptr,
+                         size_t code_size,
+                         ArtMethod* method,
+                         const debug::MethodDebugInfo* method_info)
+        REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(lock_);
+    void CloseJitDumpLog() REQUIRES(!lock_);
 
     void OpenMarkerFile();
     void CloseMarkerFile();
     void WriteJitDumpHeader();
-    void WriteJitDumpDebugInfo();
+    void WriteJitDumpDebugInfo(const void* ptr, const debug::MethodDebugInfo& method_info)
+        REQUIRES(lock_);
+    void WriteJitDumpUnwindingInfo(const debug::MethodDebugInfo& method_info) REQUIRES(lock_);
+
+    // The jit-PID.dump records are collected in jit_dump_buffer_ and written to the file once
+    // there are kJitDumpBufferSize bytes, instead of doing several writes per jitted method.
+    void AppendJitDump(const void* data, size_t size) REQUIRES(lock_);
+    void PadJitDump(size_t padding) REQUIRES(lock_);
+    void FlushJitDump() REQUIRES(lock_);
+
+    static constexpr size_t kJitDumpBufferSize = 64 * KB;
 
     std::unique_ptr<File> perf_file_;
     std::unique_ptr<File> jit_dump_file_;
-    uint64_t code_index_;
+    std::vector<uint8_t> jit_dump_buffer_ GUARDED_BY(lock_);
+    uint64_t code_index_ GUARDED_BY(lock_);
     void* marker_address_;
+    Mutex lock_;
 
     DISALLOW_COPY_AND_ASSIGN(JitLogger);
 };
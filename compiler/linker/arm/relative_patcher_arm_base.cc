@@ -27,8 +27,9 @@ namespace linker {
 
 class ArmBaseRelativePatcher::ThunkData {
  public:
-  ThunkData(std::vector<uint8_t> code, uint32_t max_next_offset)
-      : code_(code),
+  ThunkData(const ThunkKey& key, std::vector<uint8_t> code, uint32_t max_next_offset)
+      : key_(key),
+        code_(code),
         offsets_(),
         max_next_offset_(max_next_offset),
         pending_offset_(0u) {
@@ -37,6 +38,10 @@ class ArmBaseRelativePatcher::ThunkData {
 
   ThunkData(ThunkData&& src) = default;
 
+  const ThunkKey& GetKey() const {
+    return key_;
+  }
+
   size_t CodeSize() const {
     return code_.size();
   }
@@ -120,6 +125,7 @@ class ArmBaseRelativePatcher::ThunkData {
   }
 
  private:
+  ThunkKey key_;                    // The key of the thunk.
   std::vector<uint8_t> code_;       // The code of the thunk.
   std::vector<uint32_t> offsets_;   // Offsets at which the thunk needs to be written.
   uint32_t max_next_offset_;        // The maximum offset at which the next thunk can be placed.
@@ -253,6 +259,7 @@ uint32_t ArmBaseRelativePatcher::ReserveSpaceInternal(uint32_t offset,
                 MaxPositiveDisplacement(GetMethodCallKey()));
       unprocessed_method_call_patches_.clear();
     }
+    offset = ReserveNearbyThunks(offset);
   }
 
   // Process patches and check that adding thunks for the current method did not push any
@@ -267,6 +274,30 @@ uint32_t ArmBaseRelativePatcher::ReserveSpaceInternal(uint32_t offset,
   return offset;
 }
 
+uint32_t ArmBaseRelativePatcher::ReserveNearbyThunks(uint32_t offset) {
+  // We are placing thunks here anyway. Place also the thunks that would otherwise need
+  // another island shortly after this one, trading a bit of their backward reach for fewer
+  // islands. The method call thunk is left alone as its reservation is tied to resolving
+  // the unprocessed method call patches.
+  auto it = unreserved_thunks_.begin();
+  while (it != unreserved_thunks_.end()) {
+    ThunkData* data = *it;
+    uint32_t thunk_offset = CompiledCode::AlignCode(offset, instruction_set_);
+    DCHECK_GE(data->MaxNextOffset(), thunk_offset);
+    uint32_t merge_distance = MaxPositiveDisplacement(data->GetKey()) / kThunkMergeDivisor;
+    if (data->MaxNextOffset() - thunk_offset > merge_distance) {
+      break;
+    }
+    if (data == method_call_thunk_) {
+      ++it;
+      continue;
+    }
+    it = unreserved_thunks_.erase(it);
+    offset = data->ReserveOffset(thunk_offset);
+  }
+  return offset;
+}
+
 uint32_t ArmBaseRelativePatcher::CalculateMethodCallDisplacement(uint32_t patch_offset,
                                                                  uint32_t target_offset) {
   DCHECK(method_call_thunk_ != nullptr);
@@ -334,7 +365,7 @@ void ArmBaseRelativePatcher::ProcessPatches(const CompiledMethod* compiled_metho
       unprocessed_method_call_patches_.emplace_back(patch_offset, patch.TargetMethod());
       if (method_call_thunk_ == nullptr) {
         uint32_t max_next_offset = CalculateMaxNextOffset(patch_offset, key);
-        auto it = thunks_.Put(key, ThunkData(CompileThunk(key), max_next_offset));
+        auto it = thunks_.Put(key, ThunkData(key, CompileThunk(key), max_next_offset));
         method_call_thunk_ = &it->second;
         AddUnreservedThunk(method_call_thunk_);
       } else {
@@ -345,7 +376,7 @@ void ArmBaseRelativePatcher::ProcessPatches(const CompiledMethod* compiled_metho
       auto lb = thunks_.lower_bound(key);
       if (lb == thunks_.end() || thunks_.key_comp()(key, lb->first)) {
         uint32_t max_next_offset = CalculateMaxNextOffset(patch_offset, key);
-        auto it = thunks_.PutBefore(lb, key, ThunkData(CompileThunk(key), max_next_offset));
+        auto it = thunks_.PutBefore(lb, key, ThunkData(key, CompileThunk(key), max_next_offset));
         AddUnreservedThunk(&it->second);
       } else {
         old_data = &lb->second;
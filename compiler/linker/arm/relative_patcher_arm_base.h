@@ -100,8 +100,13 @@ class ArmBaseRelativePatcher : public RelativePatcher {
  private:
   class ThunkData;
 
+  // When an island of thunks is placed, unreserved thunks that must be placed within
+  // 1/kThunkMergeDivisor of their maximum positive displacement are placed in it as well.
+  static constexpr uint32_t kThunkMergeDivisor = 8u;
+
   void ProcessPatches(const CompiledMethod* compiled_method, uint32_t code_offset);
   void AddUnreservedThunk(ThunkData* data);
+  uint32_t ReserveNearbyThunks(uint32_t offset);
 
   void ResolveMethodCalls(uint32_t quick_code_offset, MethodReference method_ref);
 
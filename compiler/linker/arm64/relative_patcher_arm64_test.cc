@@ -1146,6 +1146,67 @@ TEST_F(Arm64RelativePatcherTestDefault, BakerOffsetThunkInTheMiddleUnreachableFr
   ASSERT_TRUE(CheckLinkedMethod(MethodRef(5), ArrayRef<const uint8_t>(expected_code2)));
 }
 
+TEST_F(Arm64RelativePatcherTestDefault, BakerOffsetThunksShareIsland) {
+  // Two different thunks needed 64KiB apart are placed in a single island when the first one
+  // needs to be placed.
+  constexpr uint32_t kLiteralOffset = 4;
+  const uint32_t ldr1 = kLdrWInsn | (/* base_reg */ 1 << 5);
+  const std::vector<uint8_t> raw_code1 = RawCode({kNopInsn, kCbnzIP1Plus0Insn, kLdrWInsn});
+  const std::vector<uint8_t> raw_code3 = RawCode({kNopInsn, kCbnzIP1Plus0Insn, ldr1});
+  uint32_t encoded_data1 =
+      Arm64RelativePatcher::EncodeBakerReadBarrierFieldData(/* base_reg */ 0, /* holder_reg */ 0);
+  uint32_t encoded_data3 =
+      Arm64RelativePatcher::EncodeBakerReadBarrierFieldData(/* base_reg */ 1, /* holder_reg */ 1);
+  const LinkerPatch patches1[] = {
+      LinkerPatch::BakerReadBarrierBranchPatch(kLiteralOffset, encoded_data1),
+  };
+  const LinkerPatch patches3[] = {
+      LinkerPatch::BakerReadBarrierBranchPatch(kLiteralOffset, encoded_data3),
+  };
+  AddCompiledMethod(MethodRef(1u),
+                    ArrayRef<const uint8_t>(raw_code1),
+                    ArrayRef<const LinkerPatch>(patches1));
+
+  // Let the code of method 3 start 64KiB after the code of method 1.
+  size_t filler1_size =
+      64 * KB - RoundUp(raw_code1.size() + sizeof(OatQuickMethodHeader), kArm64Alignment)
+              - sizeof(OatQuickMethodHeader);
+  std::vector<uint8_t> raw_filler1_code = GenNops(filler1_size / 4u);
+  AddCompiledMethod(MethodRef(2u), ArrayRef<const uint8_t>(raw_filler1_code));
+  AddCompiledMethod(MethodRef(3u),
+                    ArrayRef<const uint8_t>(raw_code3),
+                    ArrayRef<const LinkerPatch>(patches3));
+
+  // Let the code of method 4 end 1MiB after the start of method 1, where the first thunk must
+  // be placed, and enforce thunk reservation with a tiny method.
+  size_t filler2_size =
+      1 * MB - 64 * KB
+             - RoundUp(raw_code3.size() + sizeof(OatQuickMethodHeader), kArm64Alignment);
+  std::vector<uint8_t> raw_filler2_code = GenNops(filler2_size / 4u);
+  AddCompiledMethod(MethodRef(4u), ArrayRef<const uint8_t>(raw_filler2_code));
+  AddCompiledMethod(MethodRef(5u), kNopCode);
+
+  Link();
+
+  uint32_t method1_offset = GetMethodOffset(1u);
+  uint32_t method3_offset = GetMethodOffset(3u);
+  ASSERT_EQ(64 * KB, method3_offset - method1_offset);
+  uint32_t thunk1_offset = method1_offset + 1 * MB;
+  size_t thunk1_size = CompileBakerOffsetThunk(/* base_reg */ 0, /* holder_reg */ 0).size();
+  uint32_t thunk3_offset = thunk1_offset + RoundUp(thunk1_size, kArm64Alignment);
+  size_t thunk3_size = CompileBakerOffsetThunk(/* base_reg */ 1, /* holder_reg */ 1).size();
+  ASSERT_LT(thunk3_offset + thunk3_size, GetMethodOffset(5u));
+
+  uint32_t cbnz1 =
+      kCbnzIP1Plus0Insn | ((thunk1_offset - (method1_offset + kLiteralOffset)) << (5 - 2));
+  uint32_t cbnz3 =
+      kCbnzIP1Plus0Insn | ((thunk3_offset - (method3_offset + kLiteralOffset)) << (5 - 2));
+  const std::vector<uint8_t> expected_code1 = RawCode({kNopInsn, cbnz1, kLdrWInsn});
+  const std::vector<uint8_t> expected_code3 = RawCode({kNopInsn, cbnz3, ldr1});
+  ASSERT_TRUE(CheckLinkedMethod(MethodRef(1), ArrayRef<const uint8_t>(expected_code1)));
+  ASSERT_TRUE(CheckLinkedMethod(MethodRef(3), ArrayRef<const uint8_t>(expected_code3)));
+}
+
 TEST_F(Arm64RelativePatcherTestDefault, BakerArray) {
   uint32_t valid_regs[] = {
       0,  1,  2,  3,  4,  5,  6,  7,  8,  9,
@@ -44,6 +44,7 @@
 #include "oat_writer.h"
 #include "scoped_thread_state_change-inl.h"
 #include "utils/test_dex_file_builder.h"
+#include "vdex_file.h"
 
 namespace art {
 
@@ -132,7 +133,8 @@ class OatTest : public CommonCompilerTest {
     TimingLogger timings("WriteElf", false, false);
     OatWriter oat_writer(/*compiling_boot_image*/false,
                          &timings,
-                         /*profile_compilation_info*/nullptr);
+                         /*profile_compilation_info*/nullptr,
+                         CompactDexLevel::kCompactDexLevelNone);
     for (const DexFile* dex_file : dex_files) {
       ArrayRef<const uint8_t> raw_dex_file(
           reinterpret_cast<const uint8_t*>(&dex_file->GetHeader()),
@@ -151,9 +153,13 @@ class OatTest : public CommonCompilerTest {
                 const std::vector<const char*>& dex_filenames,
                 SafeMap<std::string, std::string>& key_value_store,
                 bool verify,
-                ProfileCompilationInfo* profile_compilation_info) {
+                ProfileCompilationInfo* profile_compilation_info,
+                CompactDexLevel compact_dex_level = CompactDexLevel::kCompactDexLevelNone) {
     TimingLogger timings("WriteElf", false, false);
-    OatWriter oat_writer(/*compiling_boot_image*/false, &timings, profile_compilation_info);
+    OatWriter oat_writer(/*compiling_boot_image*/false,
+                         &timings,
+                         profile_compilation_info,
+                         compact_dex_level);
     for (const char* dex_filename : dex_filenames) {
       if (!oat_writer.AddDexFileSource(dex_filename, dex_filename)) {
         return false;
@@ -167,27 +173,31 @@ class OatTest : public CommonCompilerTest {
                 File&& zip_fd,
                 const char* location,
                 SafeMap<std::string, std::string>& key_value_store,
-                bool verify) {
+                bool verify,
+                bool copy_dex_files = true) {
     TimingLogger timings("WriteElf", false, false);
     OatWriter oat_writer(/*compiling_boot_image*/false,
                          &timings,
-                         /*profile_compilation_info*/nullptr);
+                         /*profile_compilation_info*/nullptr,
+                         CompactDexLevel::kCompactDexLevelNone);
     if (!oat_writer.AddZippedDexFilesSource(std::move(zip_fd), location)) {
       return false;
     }
-    return DoWriteElf(vdex_file, oat_file, oat_writer, key_value_store, verify);
+    return DoWriteElf(vdex_file, oat_file, oat_writer, key_value_store, verify, copy_dex_files);
   }
 
   bool DoWriteElf(File* vdex_file,
                   File* oat_file,
                   OatWriter& oat_writer,
                   SafeMap<std::string, std::string>& key_value_store,
-                  bool verify) {
+                  bool verify,
+                  bool copy_dex_files = true) {
     std::unique_ptr<ElfWriter> elf_writer = CreateElfWriterQuick(
         compiler_driver_->GetInstructionSet(),
         compiler_driver_->GetInstructionSetFeatures(),
         &compiler_driver_->GetCompilerOptions(),
-        oat_file);
+        oat_file,
+        compiler_driver_->GetThreadCount());
     elf_writer->Start();
     OutputStream* oat_rodata = elf_writer->StartRoData();
     std::unique_ptr<MemMap> opened_dex_files_map;
@@ -199,6 +209,7 @@ class OatTest : public CommonCompilerTest {
                                          &key_value_store,
                                          verify,
                                          /* update_input_vdex */ false,
+                                         copy_dex_files,
                                          &opened_dex_files_map,
                                          &opened_dex_files)) {
       return false;
@@ -257,7 +268,9 @@ class OatTest : public CommonCompilerTest {
       return false;
     }
 
-    opened_dex_files_maps_.emplace_back(std::move(opened_dex_files_map));
+    if (opened_dex_files_map != nullptr) {
+      opened_dex_files_maps_.emplace_back(std::move(opened_dex_files_map));
+    }
     for (std::unique_ptr<const DexFile>& dex_file : opened_dex_files) {
       opened_dex_files_.emplace_back(dex_file.release());
     }
@@ -279,7 +292,8 @@ class ZipBuilder {
  public:
   explicit ZipBuilder(File* zip_file) : zip_file_(zip_file) { }
 
-  bool AddFile(const char* location, const void* data, size_t size) {
+  // Add a stored entry, with its data at an offset aligned to `alignment` in the zip.
+  bool AddFile(const char* location, const void* data, size_t size, size_t alignment = 1u) {
     off_t offset = lseek(zip_file_->Fd(), 0, SEEK_CUR);
     if (offset == static_cast<off_t>(-1)) {
       return false;
@@ -290,9 +304,14 @@ class ZipBuilder {
     file_header.compressed_size = size;
     file_header.uncompressed_size = size;
     file_header.filename_length = strlen(location);
+    // Pad with a zero-filled extra field, like zipalign.
+    size_t data_offset = offset + sizeof(file_header) + file_header.filename_length;
+    file_header.extra_field_length = RoundUp(data_offset, alignment) - data_offset;
+    std::vector<uint8_t> padding(file_header.extra_field_length, 0u);
 
     if (!zip_file_->WriteFully(&file_header, sizeof(file_header)) ||
         !zip_file_->WriteFully(location, file_header.filename_length) ||
+        !zip_file_->WriteFully(padding.data(), padding.size()) ||
         !zip_file_->WriteFully(data, size)) {
       return false;
     }
@@ -343,7 +362,7 @@ class ZipBuilder {
     uint32_t compressed_size;
     uint32_t uncompressed_size;
     uint16_t filename_length;
-    uint16_t extra_field_length = 0u;           // No extra fields.
+    uint16_t extra_field_length = 0u;           // No extra fields but the padding.
   };
 
   struct PACKED(1) CentralDirectoryFileHeader {
@@ -671,6 +690,73 @@ TEST_F(OatTest, DexFileFailsVerifierWithLayout) {
   TestDexFileInput(/*verify*/true, /*low_4gb*/false, /*use_profile*/true);
 }
 
+TEST_F(OatTest, DexFileInputCompactDex) {
+  std::vector<const char*> input_filenames;
+  std::vector<std::unique_ptr<const DexFile>> input_dex_files;
+  ScratchFile dex_file1;
+  ScratchFile dex_file2;
+  for (ScratchFile* dex_file : { &dex_file1, &dex_file2 }) {
+    // The dex files have most of their strings in common.
+    TestDexFileBuilder builder;
+    builder.AddField("Lsome.TestClass;", "int", "someField");
+    builder.AddMethod("Lsome.TestClass;", "()I", "foo");
+    if (dex_file == &dex_file2) {
+      builder.AddMethod("Lsome.TestClass;", "()J", "bar");
+    }
+    input_dex_files.push_back(builder.Build(dex_file->GetFilename()));
+    const DexFile::Header& header = input_dex_files.back()->GetHeader();
+    ASSERT_TRUE(dex_file->GetFile()->WriteFully(&header, header.file_size_));
+    ASSERT_EQ(0, dex_file->GetFile()->Flush());
+    input_filenames.push_back(dex_file->GetFilename().c_str());
+  }
+
+  ScratchFile oat_file, vdex_file(oat_file, ".vdex");
+  SafeMap<std::string, std::string> key_value_store;
+  key_value_store.Put(OatHeader::kImageLocationKey, "test.art");
+  ASSERT_TRUE(WriteElf(vdex_file.GetFile(),
+                       oat_file.GetFile(),
+                       input_filenames,
+                       key_value_store,
+                       /* verify */ false,
+                       /* profile_compilation_info */ nullptr,
+                       CompactDexLevel::kCompactDexLevelFast));
+
+  std::string error_msg;
+  std::unique_ptr<OatFile> opened_oat_file(OatFile::Open(oat_file.GetFilename(),
+                                                         oat_file.GetFilename(),
+                                                         nullptr,
+                                                         nullptr,
+                                                         false,
+                                                         /*low_4gb*/false,
+                                                         nullptr,
+                                                         &error_msg));
+  ASSERT_TRUE(opened_oat_file != nullptr) << error_msg;
+  ASSERT_EQ(2u, opened_oat_file->GetOatDexFiles().size());
+  size_t input_data_size = 0u;
+  for (size_t i = 0; i != input_dex_files.size(); ++i) {
+    const DexFile* input_dex_file = input_dex_files[i].get();
+    std::unique_ptr<const DexFile> opened_dex_file =
+        opened_oat_file->GetOatDexFiles()[i]->OpenDexFile(&error_msg);
+    ASSERT_TRUE(opened_dex_file != nullptr) << error_msg;
+    EXPECT_TRUE(opened_dex_file->IsCompactDexFile());
+    EXPECT_EQ(opened_oat_file->GetVdexFile()->GetSharedData().data(),
+              opened_dex_file->DataBegin());
+    ASSERT_EQ(input_dex_file->NumStringIds(), opened_dex_file->NumStringIds());
+    for (size_t j = 0; j != input_dex_file->NumStringIds(); ++j) {
+      dex::StringIndex string_idx(j);
+      EXPECT_STREQ(input_dex_file->StringDataByIdx(string_idx),
+                   opened_dex_file->StringDataByIdx(string_idx));
+    }
+    ASSERT_EQ(input_dex_file->NumMethodIds(), opened_dex_file->NumMethodIds());
+    for (size_t j = 0; j != input_dex_file->NumMethodIds(); ++j) {
+      EXPECT_EQ(input_dex_file->PrettyMethod(j), opened_dex_file->PrettyMethod(j));
+    }
+    input_data_size += input_dex_file->GetHeader().data_size_;
+  }
+  // The common strings are stored once.
+  EXPECT_LT(opened_oat_file->GetVdexFile()->GetSharedData().size(), input_data_size);
+}
+
 void OatTest::TestZipFileInput(bool verify) {
   TimingLogger timings("OatTest::DexFileInput", false, false);
 
@@ -821,6 +907,85 @@ TEST_F(OatTest, ZipFileInputCheckVerifier) {
   TestZipFileInput(true);
 }
 
+TEST_F(OatTest, ZipFileInputMappedFromZip) {
+  ScratchFile zip_file;
+  ZipBuilder zip_builder(zip_file.GetFile());
+
+  ScratchFile dex_file1;
+  TestDexFileBuilder builder1;
+  builder1.AddField("Lsome.TestClass;", "long", "someField");
+  builder1.AddMethod("Lsome.TestClass;", "()D", "foo");
+  std::unique_ptr<const DexFile> dex_file1_data = builder1.Build(dex_file1.GetFilename());
+  bool success = zip_builder.AddFile("classes.dex",
+                                     &dex_file1_data->GetHeader(),
+                                     dex_file1_data->GetHeader().file_size_,
+                                     kPageSize);
+  ASSERT_TRUE(success);
+
+  ScratchFile dex_file2;
+  TestDexFileBuilder builder2;
+  builder2.AddField("Land.AnotherTestClass;", "boolean", "someOtherField");
+  builder2.AddMethod("Land.AnotherTestClass;", "()J", "bar");
+  std::unique_ptr<const DexFile> dex_file2_data = builder2.Build(dex_file2.GetFilename());
+  success = zip_builder.AddFile("classes2.dex",
+                                &dex_file2_data->GetHeader(),
+                                dex_file2_data->GetHeader().file_size_,
+                                kPageSize);
+  ASSERT_TRUE(success);
+
+  success = zip_builder.Finish();
+  ASSERT_TRUE(success) << strerror(errno);
+
+  SafeMap<std::string, std::string> key_value_store;
+  key_value_store.Put(OatHeader::kImageLocationKey, "test.art");
+  File zip_fd(dup(zip_file.GetFd()), /* check_usage */ false);
+  ASSERT_NE(-1, zip_fd.Fd());
+
+  ScratchFile oat_file, vdex_file(oat_file, ".vdex");
+  success = WriteElf(vdex_file.GetFile(),
+                     oat_file.GetFile(),
+                     std::move(zip_fd),
+                     zip_file.GetFilename().c_str(),
+                     key_value_store,
+                     /* verify */ false,
+                     /* copy_dex_files */ false);
+  ASSERT_TRUE(success);
+
+  std::string error_msg;
+  std::unique_ptr<OatFile> opened_oat_file(OatFile::Open(oat_file.GetFilename(),
+                                                         oat_file.GetFilename(),
+                                                         nullptr,
+                                                         nullptr,
+                                                         false,
+                                                         /*low_4gb*/false,
+                                                         nullptr,
+                                                         &error_msg));
+  ASSERT_TRUE(opened_oat_file != nullptr) << error_msg;
+  if (kIsVdexEnabled) {
+    // The dex files are not in the vdex.
+    ASSERT_FALSE(opened_oat_file->GetVdexFile()->HasDexSection());
+  }
+  ASSERT_EQ(2u, opened_oat_file->GetOatDexFiles().size());
+  std::unique_ptr<const DexFile> opened_dex_file1 =
+      opened_oat_file->GetOatDexFiles()[0]->OpenDexFile(&error_msg);
+  ASSERT_TRUE(opened_dex_file1 != nullptr) << error_msg;
+  std::unique_ptr<const DexFile> opened_dex_file2 =
+      opened_oat_file->GetOatDexFiles()[1]->OpenDexFile(&error_msg);
+  ASSERT_TRUE(opened_dex_file2 != nullptr) << error_msg;
+
+  ASSERT_EQ(dex_file1_data->GetHeader().file_size_, opened_dex_file1->GetHeader().file_size_);
+  ASSERT_EQ(0, memcmp(&dex_file1_data->GetHeader(),
+                      &opened_dex_file1->GetHeader(),
+                      dex_file1_data->GetHeader().file_size_));
+  ASSERT_TRUE(IsAligned<kPageSize>(opened_dex_file1->Begin()));
+  ASSERT_EQ(dex_file2_data->GetHeader().file_size_, opened_dex_file2->GetHeader().file_size_);
+  ASSERT_EQ(0, memcmp(&dex_file2_data->GetHeader(),
+                      &opened_dex_file2->GetHeader(),
+                      dex_file2_data->GetHeader().file_size_));
+  ASSERT_EQ(DexFile::GetMultiDexLocation(1, zip_file.GetFilename().c_str()),
+            opened_dex_file2->GetLocation());
+}
+
 void OatTest::TestZipFileInputWithEmptyDex() {
   ScratchFile zip_file;
   ZipBuilder zip_builder(zip_file.GetFile());
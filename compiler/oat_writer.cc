@@ -16,6 +16,8 @@
 
 #include "oat_writer.h"
 
+#include <algorithm>
+
 #include <unistd.h>
 #include <zlib.h>
 
@@ -28,6 +30,8 @@
 #include "base/stl_util.h"
 #include "base/unix_file/fd_file.h"
 #include "class_linker.h"
+#include "compact_dex_file.h"
+#include "compact_dex_writer.h"
 #include "compiled_method.h"
 #include "debug/method_debug_info.h"
 #include "dex/verification_results.h"
@@ -39,6 +43,7 @@
 #include "gc/space/space.h"
 #include "handle_scope-inl.h"
 #include "image_writer.h"
+#include "jit/profile_compilation_info.h"
 #include "linker/buffered_output_stream.h"
 #include "linker/file_output_stream.h"
 #include "linker/method_bss_mapping_encoder.h"
@@ -311,7 +316,46 @@ class OatWriter::OatDexFile {
   DCHECK_EQ(static_cast<off_t>(file_offset + offset_), out->Seek(0, kSeekCurrent)) \
     << "file_offset=" << file_offset << " offset_=" << offset_
 
-OatWriter::OatWriter(bool compiling_boot_image, TimingLogger* timings, ProfileCompilationInfo* info)
+// The code hotness groups, in the order of their code in the .text section.
+enum class CodeHotness : uint32_t {
+  kStartup,
+  kHot,
+  kPostStartup,
+  kOther,
+};
+
+static CodeHotness GetCodeHotness(const ProfileCompilationInfo* profile,
+                                  MethodReference method_ref) {
+  if (profile == nullptr) {
+    return CodeHotness::kOther;
+  }
+  ProfileCompilationInfo::MethodHotness hotness = profile->GetMethodHotness(method_ref);
+  if (hotness.IsStartup()) {
+    return CodeHotness::kStartup;
+  } else if (hotness.IsHot()) {
+    return CodeHotness::kHot;
+  } else if (hotness.IsPostStartup()) {
+    return CodeHotness::kPostStartup;
+  } else {
+    return CodeHotness::kOther;
+  }
+}
+
+struct OatWriter::OrderedMethodData {
+  CodeHotness hotness;
+  size_t oat_class_index;
+  CompiledMethod* compiled_method;
+  MethodReference method_reference;
+  size_t method_offsets_index;
+  size_t class_def_index;
+  uint32_t access_flags;
+  const DexFile::CodeItem* code_item;
+};
+
+OatWriter::OatWriter(bool compiling_boot_image,
+                     TimingLogger* timings,
+                     ProfileCompilationInfo* info,
+                     CompactDexLevel compact_dex_level)
   : write_state_(WriteState::kAddingDexFileSources),
     timings_(timings),
     raw_dex_files_(),
@@ -324,6 +368,7 @@ OatWriter::OatWriter(bool compiling_boot_image, TimingLogger* timings, ProfileCo
     dex_files_(nullptr),
     vdex_size_(0u),
     vdex_dex_files_offset_(0u),
+    vdex_shared_data_offset_(0u),
     vdex_verifier_deps_offset_(0u),
     vdex_quickening_info_offset_(0u),
     oat_size_(0u),
@@ -344,6 +389,7 @@ OatWriter::OatWriter(bool compiling_boot_image, TimingLogger* timings, ProfileCo
     size_oat_header_(0),
     size_oat_header_key_value_store_(0),
     size_dex_file_(0),
+    size_shared_dex_data_(0),
     size_verifier_deps_(0),
     size_verifier_deps_alignment_(0),
     size_quickening_info_(0),
@@ -384,7 +430,12 @@ OatWriter::OatWriter(bool compiling_boot_image, TimingLogger* timings, ProfileCo
     size_method_bss_mappings_(0u),
     relative_patcher_(nullptr),
     absolute_patch_locations_(),
-    profile_compilation_info_(info) {
+    profile_compilation_info_(info),
+    compact_dex_level_(compact_dex_level),
+    compact_dex_shared_data_(nullptr),
+    input_vdex_shared_data_(),
+    extract_dex_files_into_vdex_(true),
+    ordered_methods_(nullptr) {
 }
 
 bool OatWriter::AddDexFileSource(const char* filename,
@@ -460,7 +511,10 @@ bool OatWriter::AddVdexDexFilesSource(const VdexFile& vdex_file,
       LOG(ERROR) << "Unexpected number of dex files in vdex " << location;
       return false;
     }
-    if (!DexFile::IsMagicValid(current_dex_data)) {
+    if (CompactDexFile::IsMagicValid(current_dex_data)) {
+      // The data items of compact dex files are in the shared data of the vdex.
+      input_vdex_shared_data_ = vdex_file.GetSharedData();
+    } else if (!DexFile::IsMagicValid(current_dex_data)) {
       LOG(ERROR) << "Invalid magic in vdex file created from " << location;
       return false;
     }
@@ -533,6 +587,7 @@ bool OatWriter::WriteAndOpenDexFiles(
     SafeMap<std::string, std::string>* key_value_store,
     bool verify,
     bool update_input_vdex,
+    bool copy_dex_files,
     /*out*/ std::unique_ptr<MemMap>* opened_dex_files_map,
     /*out*/ std::vector<std::unique_ptr<const DexFile>>* opened_dex_files) {
   CHECK(write_state_ == WriteState::kAddingDexFileSources);
@@ -557,7 +612,17 @@ bool OatWriter::WriteAndOpenDexFiles(
 
   ChecksumUpdatingOutputStream checksum_updating_rodata(oat_rodata, oat_header_.get());
 
-  if (kIsVdexEnabled) {
+  // An input vdex with zip sources was written without its dex files, keep it that way.
+  if (kIsVdexEnabled && (!copy_dex_files || update_input_vdex) && CanMapDexFilesFromZip()) {
+    // Map the DEX files from their zip and leave them out of the VDEX.
+    extract_dex_files_into_vdex_ = false;
+    if (!MapDexFilesFromZip(verify, &dex_files)) {
+      return false;
+    }
+    vdex_dex_files_offset_ = vdex_size_;
+    vdex_shared_data_offset_ = vdex_size_;
+    CloseSources();
+  } else if (kIsVdexEnabled) {
     std::unique_ptr<BufferedOutputStream> vdex_out =
         std::make_unique<BufferedOutputStream>(std::make_unique<FileOutputStream>(vdex_file));
     // Write DEX files into VDEX, mmap and open them.
@@ -859,153 +924,250 @@ class OatWriter::InitOatClassesMethodVisitor : public DexMethodVisitor {
   size_t compiled_methods_with_code_;
 };
 
-class OatWriter::InitCodeMethodVisitor : public OatDexMethodVisitor {
+// Collects the methods with compiled code and sorts them in the order of their code in the
+// .text section. With a profile, the code of the startup methods comes first, followed by
+// the hot methods, the post-startup methods and the remaining methods, so that the code
+// executed during startup and in steady state occupies as few pages as possible. Otherwise,
+// and within each of these groups, the code is in the order of the method definitions.
+class OatWriter::LayoutCodeMethodVisitor : public OatDexMethodVisitor {
  public:
-  InitCodeMethodVisitor(OatWriter* writer, size_t offset)
-      : OatDexMethodVisitor(writer, offset),
+  LayoutCodeMethodVisitor(OatWriter* writer, size_t offset)
+      : OatDexMethodVisitor(writer, offset) {}
+
+  bool VisitMethod(size_t class_def_method_index, const ClassDataItemIterator& it) OVERRIDE {
+    OatClass* oat_class = &writer_->oat_classes_[oat_class_index_];
+    CompiledMethod* compiled_method = oat_class->GetCompiledMethod(class_def_method_index);
+    if (HasCompiledCode(compiled_method)) {
+      MethodReference method_ref(dex_file_, it.GetMemberIndex());
+      ordered_methods_.push_back(OrderedMethodData {
+          GetCodeHotness(writer_->profile_compilation_info_, method_ref),
+          oat_class_index_,
+          compiled_method,
+          method_ref,
+          method_offsets_index_,
+          class_def_index_,
+          it.GetMethodAccessFlags(),
+          it.GetMethodCodeItem()
+      });
+      ++method_offsets_index_;
+    }
+    return true;
+  }
+
+  OrderedMethodList ReleaseOrderedMethods() {
+    // A stable sort keeps the definition order within each hotness group.
+    std::stable_sort(ordered_methods_.begin(),
+                     ordered_methods_.end(),
+                     [](const OrderedMethodData& lhs, const OrderedMethodData& rhs) {
+                       return static_cast<uint32_t>(lhs.hotness) <
+                           static_cast<uint32_t>(rhs.hotness);
+                     });
+    return std::move(ordered_methods_);
+  }
+
+ private:
+  OrderedMethodList ordered_methods_;
+};
+
+// Visits the methods of an OrderedMethodList in the order of their code.
+class OatWriter::OrderedMethodVisitor {
+ public:
+  explicit OrderedMethodVisitor(const OrderedMethodList& ordered_methods)
+      : ordered_methods_(ordered_methods) {}
+
+  virtual ~OrderedMethodVisitor() {}
+
+  bool Visit() REQUIRES_SHARED(Locks::mutator_lock_) {
+    for (const OrderedMethodData& method_data : ordered_methods_) {
+      if (UNLIKELY(!VisitMethod(method_data))) {
+        return false;
+      }
+    }
+    return VisitComplete();
+  }
+
+  virtual bool VisitMethod(const OrderedMethodData& method_data)
+      REQUIRES_SHARED(Locks::mutator_lock_) = 0;
+
+  // Called after the last method.
+  virtual bool VisitComplete() REQUIRES_SHARED(Locks::mutator_lock_) = 0;
+
+ private:
+  const OrderedMethodList& ordered_methods_;
+};
+
+class OatWriter::InitCodeMethodVisitor : public OrderedMethodVisitor {
+ public:
+  InitCodeMethodVisitor(OatWriter* writer,
+                        size_t offset,
+                        const OrderedMethodList& ordered_methods)
+      : OrderedMethodVisitor(ordered_methods),
+        writer_(writer),
+        offset_(offset),
+        hot_code_begin_(0u),
+        hot_code_end_(0u),
         debuggable_(writer->GetCompilerDriver()->GetCompilerOptions().GetDebuggable()) {
     writer_->absolute_patch_locations_.reserve(
         writer_->compiler_driver_->GetNonRelativeLinkerPatchCount());
   }
 
-  bool EndClass() OVERRIDE {
-    OatDexMethodVisitor::EndClass();
-    if (oat_class_index_ == writer_->oat_classes_.size()) {
+  bool VisitComplete() OVERRIDE {
+    if (!writer_->oat_classes_.empty()) {
       offset_ = writer_->relative_patcher_->ReserveSpaceEnd(offset_);
     }
     return true;
   }
 
-  bool VisitMethod(size_t class_def_method_index, const ClassDataItemIterator& it) OVERRIDE
+  bool VisitMethod(const OrderedMethodData& method_data) OVERRIDE
       REQUIRES_SHARED(Locks::mutator_lock_) {
-    OatClass* oat_class = &writer_->oat_classes_[oat_class_index_];
-    CompiledMethod* compiled_method = oat_class->GetCompiledMethod(class_def_method_index);
-
-    if (HasCompiledCode(compiled_method)) {
-      // Derived from CompiledMethod.
-      uint32_t quick_code_offset = 0;
-
-      ArrayRef<const uint8_t> quick_code = compiled_method->GetQuickCode();
-      uint32_t code_size = quick_code.size() * sizeof(uint8_t);
-      uint32_t thumb_offset = compiled_method->CodeDelta();
-
-      // Deduplicate code arrays if we are not producing debuggable code.
-      bool deduped = true;
-      MethodReference method_ref(dex_file_, it.GetMemberIndex());
-      if (debuggable_) {
-        quick_code_offset = writer_->relative_patcher_->GetOffset(method_ref);
-        if (quick_code_offset != 0u) {
-          // Duplicate methods, we want the same code for both of them so that the oat writer puts
-          // the same code in both ArtMethods so that we do not get different oat code at runtime.
-        } else {
-          quick_code_offset = NewQuickCodeOffset(compiled_method, it, thumb_offset);
-          deduped = false;
-        }
+    OatClass* oat_class = &writer_->oat_classes_[method_data.oat_class_index];
+    CompiledMethod* compiled_method = method_data.compiled_method;
+    DCHECK(HasCompiledCode(compiled_method));
+
+    // Derived from CompiledMethod.
+    uint32_t quick_code_offset = 0;
+
+    ArrayRef<const uint8_t> quick_code = compiled_method->GetQuickCode();
+    uint32_t code_size = quick_code.size() * sizeof(uint8_t);
+    uint32_t thumb_offset = compiled_method->CodeDelta();
+
+    // Deduplicate code arrays if we are not producing debuggable code.
+    bool deduped = true;
+    MethodReference method_ref = method_data.method_reference;
+    if (debuggable_) {
+      quick_code_offset = writer_->relative_patcher_->GetOffset(method_ref);
+      if (quick_code_offset != 0u) {
+        // Duplicate methods, we want the same code for both of them so that the oat writer puts
+        // the same code in both ArtMethods so that we do not get different oat code at runtime.
       } else {
-        quick_code_offset = dedupe_map_.GetOrCreate(
-            compiled_method,
-            [this, &deduped, compiled_method, &it, thumb_offset]() {
-              deduped = false;
-              return NewQuickCodeOffset(compiled_method, it, thumb_offset);
-            });
+        quick_code_offset = NewQuickCodeOffset(compiled_method, method_ref, thumb_offset);
+        deduped = false;
       }
-
-      if (code_size != 0) {
-        if (writer_->relative_patcher_->GetOffset(method_ref) != 0u) {
-          // TODO: Should this be a hard failure?
-          LOG(WARNING) << "Multiple definitions of "
-              << method_ref.dex_file->PrettyMethod(method_ref.dex_method_index)
-              << " offsets " << writer_->relative_patcher_->GetOffset(method_ref)
-              << " " << quick_code_offset;
-        } else {
-          writer_->relative_patcher_->SetOffset(method_ref, quick_code_offset);
-        }
+    } else {
+      quick_code_offset = dedupe_map_.GetOrCreate(
+          compiled_method,
+          [this, &deduped, compiled_method, method_ref, thumb_offset]() {
+            deduped = false;
+            return NewQuickCodeOffset(compiled_method, method_ref, thumb_offset);
+          });
+    }
+
+    if (code_size != 0) {
+      if (writer_->relative_patcher_->GetOffset(method_ref) != 0u) {
+        // TODO: Should this be a hard failure?
+        LOG(WARNING) << "Multiple definitions of "
+            << method_ref.dex_file->PrettyMethod(method_ref.dex_method_index)
+            << " offsets " << writer_->relative_patcher_->GetOffset(method_ref)
+            << " " << quick_code_offset;
+      } else {
+        writer_->relative_patcher_->SetOffset(method_ref, quick_code_offset);
       }
+    }
 
-      // Update quick method header.
-      DCHECK_LT(method_offsets_index_, oat_class->method_headers_.size());
-      OatQuickMethodHeader* method_header = &oat_class->method_headers_[method_offsets_index_];
-      uint32_t vmap_table_offset = method_header->GetVmapTableOffset();
-      uint32_t method_info_offset = method_header->GetMethodInfoOffset();
-      // The code offset was 0 when the mapping/vmap table offset was set, so it's set
-      // to 0-offset and we need to adjust it by code_offset.
-      uint32_t code_offset = quick_code_offset - thumb_offset;
-      if (!compiled_method->GetQuickCode().empty()) {
-        // If the code is compiled, we write the offset of the stack map relative
-        // to the code,
-        if (vmap_table_offset != 0u) {
-          vmap_table_offset += code_offset;
-          DCHECK_LT(vmap_table_offset, code_offset);
-        }
-        if (method_info_offset != 0u) {
-          method_info_offset += code_offset;
-          DCHECK_LT(method_info_offset, code_offset);
-        }
-      } else {
-        CHECK(!kIsVdexEnabled);
-        // We write the offset of the quickening info relative to the code.
+    // Update quick method header.
+    const size_t method_offsets_index = method_data.method_offsets_index;
+    DCHECK_LT(method_offsets_index, oat_class->method_headers_.size());
+    OatQuickMethodHeader* method_header = &oat_class->method_headers_[method_offsets_index];
+    uint32_t vmap_table_offset = method_header->GetVmapTableOffset();
+    uint32_t method_info_offset = method_header->GetMethodInfoOffset();
+    // The code offset was 0 when the mapping/vmap table offset was set, so it's set
+    // to 0-offset and we need to adjust it by code_offset.
+    uint32_t code_offset = quick_code_offset - thumb_offset;
+    if (!compiled_method->GetQuickCode().empty()) {
+      // If the code is compiled, we write the offset of the stack map relative
+      // to the code,
+      if (vmap_table_offset != 0u) {
         vmap_table_offset += code_offset;
         DCHECK_LT(vmap_table_offset, code_offset);
       }
-      uint32_t frame_size_in_bytes = compiled_method->GetFrameSizeInBytes();
-      uint32_t core_spill_mask = compiled_method->GetCoreSpillMask();
-      uint32_t fp_spill_mask = compiled_method->GetFpSpillMask();
-      *method_header = OatQuickMethodHeader(vmap_table_offset,
-                                            method_info_offset,
-                                            frame_size_in_bytes,
-                                            core_spill_mask,
-                                            fp_spill_mask,
-                                            code_size);
-
-      if (!deduped) {
-        // Update offsets. (Checksum is updated when writing.)
-        offset_ += sizeof(*method_header);  // Method header is prepended before code.
-        offset_ += code_size;
-        // Record absolute patch locations.
-        if (!compiled_method->GetPatches().empty()) {
-          uintptr_t base_loc = offset_ - code_size - writer_->oat_header_->GetExecutableOffset();
-          for (const LinkerPatch& patch : compiled_method->GetPatches()) {
-            if (!patch.IsPcRelative()) {
-              writer_->absolute_patch_locations_.push_back(base_loc + patch.LiteralOffset());
-            }
-          }
+      if (method_info_offset != 0u) {
+        method_info_offset += code_offset;
+        DCHECK_LT(method_info_offset, code_offset);
+      }
+    } else {
+      CHECK(!kIsVdexEnabled);
+      // We write the offset of the quickening info relative to the code.
+      vmap_table_offset += code_offset;
+      DCHECK_LT(vmap_table_offset, code_offset);
+    }
+    uint32_t frame_size_in_bytes = compiled_method->GetFrameSizeInBytes();
+    uint32_t core_spill_mask = compiled_method->GetCoreSpillMask();
+    uint32_t fp_spill_mask = compiled_method->GetFpSpillMask();
+    *method_header = OatQuickMethodHeader(vmap_table_offset,
+                                          method_info_offset,
+                                          frame_size_in_bytes,
+                                          core_spill_mask,
+                                          fp_spill_mask,
+                                          code_size);
+
+    if (!deduped) {
+      // Update offsets. (Checksum is updated when writing.)
+      offset_ += sizeof(*method_header);  // Method header is prepended before code.
+      offset_ += code_size;
+      // The startup and hot methods are sorted first, so their code is contiguous.
+      if (method_data.hotness == CodeHotness::kStartup ||
+          method_data.hotness == CodeHotness::kHot) {
+        if (hot_code_end_ == 0u) {
+          hot_code_begin_ = code_offset - sizeof(*method_header);
         }
+        hot_code_end_ = offset_;
       }
-
-      const CompilerOptions& compiler_options = writer_->compiler_driver_->GetCompilerOptions();
-      // Exclude quickened dex methods (code_size == 0) since they have no native code.
-      if (compiler_options.GenerateAnyDebugInfo() && code_size != 0) {
-        bool has_code_info = method_header->IsOptimized();
-        // Record debug information for this function if we are doing that.
-        debug::MethodDebugInfo info = debug::MethodDebugInfo();
-        info.trampoline_name = nullptr;
-        info.dex_file = dex_file_;
-        info.class_def_index = class_def_index_;
-        info.dex_method_index = it.GetMemberIndex();
-        info.access_flags = it.GetMethodAccessFlags();
-        info.code_item = it.GetMethodCodeItem();
-        info.isa = compiled_method->GetInstructionSet();
-        info.deduped = deduped;
-        info.is_native_debuggable = compiler_options.GetNativeDebuggable();
-        info.is_optimized = method_header->IsOptimized();
-        info.is_code_address_text_relative = true;
-        info.code_address = code_offset - writer_->oat_header_->GetExecutableOffset();
-        info.code_size = code_size;
-        info.frame_size_in_bytes = compiled_method->GetFrameSizeInBytes();
-        info.code_info = has_code_info ? compiled_method->GetVmapTable().data() : nullptr;
-        info.cfi = compiled_method->GetCFIInfo();
-        writer_->method_info_.push_back(info);
+      // Record absolute patch locations.
+      if (!compiled_method->GetPatches().empty()) {
+        uintptr_t base_loc = offset_ - code_size - writer_->oat_header_->GetExecutableOffset();
+        for (const LinkerPatch& patch : compiled_method->GetPatches()) {
+          if (!patch.IsPcRelative()) {
+            writer_->absolute_patch_locations_.push_back(base_loc + patch.LiteralOffset());
+          }
+        }
       }
-
-      DCHECK_LT(method_offsets_index_, oat_class->method_offsets_.size());
-      OatMethodOffsets* offsets = &oat_class->method_offsets_[method_offsets_index_];
-      offsets->code_offset_ = quick_code_offset;
-      ++method_offsets_index_;
     }
 
+    const CompilerOptions& compiler_options = writer_->compiler_driver_->GetCompilerOptions();
+    // Exclude quickened dex methods (code_size == 0) since they have no native code.
+    if (compiler_options.GenerateAnyDebugInfo() && code_size != 0) {
+      bool has_code_info = method_header->IsOptimized();
+      // Record debug information for this function if we are doing that.
+      debug::MethodDebugInfo info = debug::MethodDebugInfo();
+      info.trampoline_name = nullptr;
+      info.dex_file = method_ref.dex_file;
+      info.class_def_index = method_data.class_def_index;
+      info.dex_method_index = method_ref.dex_method_index;
+      info.access_flags = method_data.access_flags;
+      info.code_item = method_data.code_item;
+      info.isa = compiled_method->GetInstructionSet();
+      info.deduped = deduped;
+      info.is_native_debuggable = compiler_options.GetNativeDebuggable();
+      info.is_optimized = method_header->IsOptimized();
+      info.is_code_address_text_relative = true;
+      info.code_address = code_offset - writer_->oat_header_->GetExecutableOffset();
+      info.code_size = code_size;
+      info.frame_size_in_bytes = compiled_method->GetFrameSizeInBytes();
+      info.code_info = has_code_info ? compiled_method->GetVmapTable().data() : nullptr;
+      info.cfi = compiled_method->GetCFIInfo();
+      writer_->method_info_.push_back(info);
+    }
+
+    DCHECK_LT(method_offsets_index, oat_class->method_offsets_.size());
+    OatMethodOffsets* offsets = &oat_class->method_offsets_[method_offsets_index];
+    offsets->code_offset_ = quick_code_offset;
+
     return true;
   }
 
+  size_t GetOffset() const {
+    return offset_;
+  }
+
+  // The code of the startup and hot methods, including their method headers.
+  size_t GetHotCodeBegin() const {
+    return hot_code_begin_;
+  }
+
+  size_t GetHotCodeSize() const {
+    return hot_code_end_ - hot_code_begin_;
+  }
+
  private:
   struct CodeOffsetsKeyComparator {
     bool operator()(const CompiledMethod* lhs, const CompiledMethod* rhs) const {
@@ -1028,16 +1190,24 @@ class OatWriter::InitCodeMethodVisitor : public OatDexMethodVisitor {
   };
 
   uint32_t NewQuickCodeOffset(CompiledMethod* compiled_method,
-                              const ClassDataItemIterator& it,
+                              MethodReference method_ref,
                               uint32_t thumb_offset) {
-    offset_ = writer_->relative_patcher_->ReserveSpace(
-        offset_, compiled_method, MethodReference(dex_file_, it.GetMemberIndex()));
+    offset_ = writer_->relative_patcher_->ReserveSpace(offset_, compiled_method, method_ref);
     offset_ += CodeAlignmentSize(offset_, *compiled_method);
     DCHECK_ALIGNED_PARAM(offset_ + sizeof(OatQuickMethodHeader),
                          GetInstructionSetAlignment(compiled_method->GetInstructionSet()));
     return offset_ + sizeof(OatQuickMethodHeader) + thumb_offset;
   }
 
+  OatWriter* const writer_;
+
+  // Offset of the code of the next method.
+  size_t offset_;
+
+  // Range of the code of the startup and hot methods, empty if there are none.
+  size_t hot_code_begin_;
+  size_t hot_code_end_;
+
   // Deduplication is already done on a pointer basis by the compiler driver,
   // so we can simply compare the pointers to find out if things are duplicated.
   SafeMap<const CompiledMethod*, uint32_t, CodeOffsetsKeyComparator> dedupe_map_;
@@ -1271,11 +1441,15 @@ class OatWriter::InitImageMethodVisitor : public OatDexMethodVisitor {
   std::vector<std::pair<ArtMethod*, ArtMethod*>> methods_to_process_;
 };
 
-class OatWriter::WriteCodeMethodVisitor : public OatDexMethodVisitor {
+class OatWriter::WriteCodeMethodVisitor : public OrderedMethodVisitor {
  public:
   WriteCodeMethodVisitor(OatWriter* writer, OutputStream* out, const size_t file_offset,
-                         size_t relative_offset) SHARED_LOCK_FUNCTION(Locks::mutator_lock_)
-      : OatDexMethodVisitor(writer, relative_offset),
+                         size_t relative_offset, const OrderedMethodList& ordered_methods)
+      SHARED_LOCK_FUNCTION(Locks::mutator_lock_)
+      : OrderedMethodVisitor(ordered_methods),
+        writer_(writer),
+        offset_(relative_offset),
+        dex_file_(nullptr),
         pointer_size_(GetInstructionSetPointerSize(writer_->compiler_driver_->GetInstructionSet())),
         class_loader_(writer->HasImage() ? writer->image_writer_->GetClassLoader() : nullptr),
         out_(out),
@@ -1294,9 +1468,9 @@ class OatWriter::WriteCodeMethodVisitor : public OatDexMethodVisitor {
   ~WriteCodeMethodVisitor() UNLOCK_FUNCTION(Locks::mutator_lock_) {
   }
 
-  bool StartClass(const DexFile* dex_file, size_t class_def_index) OVERRIDE
+  void UpdateDexFileAndDexCache(const DexFile* dex_file)
       REQUIRES_SHARED(Locks::mutator_lock_) {
-    OatDexMethodVisitor::StartClass(dex_file, class_def_index);
+    dex_file_ = dex_file;
     if (writer_->GetCompilerDriver()->GetCompilerOptions().IsAotCompilationEnabled()) {
       // Only need to set the dex cache if we have compilation. Other modes might have unloaded it.
       if (dex_cache_ == nullptr || dex_cache_->GetDexFile() != dex_file) {
@@ -1304,169 +1478,181 @@ class OatWriter::WriteCodeMethodVisitor : public OatDexMethodVisitor {
         DCHECK(dex_cache_ != nullptr);
       }
     }
-    return true;
   }
 
-  bool EndClass() OVERRIDE REQUIRES_SHARED(Locks::mutator_lock_) {
-    bool result = OatDexMethodVisitor::EndClass();
-    if (oat_class_index_ == writer_->oat_classes_.size()) {
-      DCHECK(result);  // OatDexMethodVisitor::EndClass() never fails.
+  bool VisitComplete() OVERRIDE REQUIRES_SHARED(Locks::mutator_lock_) {
+    if (!writer_->oat_classes_.empty()) {
       offset_ = writer_->relative_patcher_->WriteThunks(out_, offset_);
       if (UNLIKELY(offset_ == 0u)) {
         PLOG(ERROR) << "Failed to write final relative call thunks";
-        result = false;
+        return false;
       }
     }
-    return result;
+    return true;
   }
 
-  bool VisitMethod(size_t class_def_method_index, const ClassDataItemIterator& it) OVERRIDE
+  size_t GetOffset() const {
+    return offset_;
+  }
+
+  bool VisitMethod(const OrderedMethodData& method_data) OVERRIDE
       REQUIRES_SHARED(Locks::mutator_lock_) {
-    OatClass* oat_class = &writer_->oat_classes_[oat_class_index_];
-    const CompiledMethod* compiled_method = oat_class->GetCompiledMethod(class_def_method_index);
+    const MethodReference& method_ref = method_data.method_reference;
+    UpdateDexFileAndDexCache(method_ref.dex_file);
+
+    OatClass* oat_class = &writer_->oat_classes_[method_data.oat_class_index];
+    const CompiledMethod* compiled_method = method_data.compiled_method;
+    const size_t method_offsets_index = method_data.method_offsets_index;
 
     // No thread suspension since dex_cache_ that may get invalidated if that occurs.
     ScopedAssertNoThreadSuspension tsc(__FUNCTION__);
-    if (HasCompiledCode(compiled_method)) {
-      size_t file_offset = file_offset_;
-      OutputStream* out = out_;
+    DCHECK(HasCompiledCode(compiled_method));
 
-      ArrayRef<const uint8_t> quick_code = compiled_method->GetQuickCode();
-      uint32_t code_size = quick_code.size() * sizeof(uint8_t);
+    size_t file_offset = file_offset_;
+    OutputStream* out = out_;
 
-      // Deduplicate code arrays.
-      const OatMethodOffsets& method_offsets = oat_class->method_offsets_[method_offsets_index_];
-      if (method_offsets.code_offset_ > offset_) {
-        offset_ = writer_->relative_patcher_->WriteThunks(out, offset_);
-        if (offset_ == 0u) {
-          ReportWriteFailure("relative call thunk", it);
-          return false;
-        }
-        uint32_t alignment_size = CodeAlignmentSize(offset_, *compiled_method);
-        if (alignment_size != 0) {
-          if (!writer_->WriteCodeAlignment(out, alignment_size)) {
-            ReportWriteFailure("code alignment padding", it);
-            return false;
-          }
-          offset_ += alignment_size;
-          DCHECK_OFFSET_();
-        }
-        DCHECK_ALIGNED_PARAM(offset_ + sizeof(OatQuickMethodHeader),
-                             GetInstructionSetAlignment(compiled_method->GetInstructionSet()));
-        DCHECK_EQ(method_offsets.code_offset_,
-                  offset_ + sizeof(OatQuickMethodHeader) + compiled_method->CodeDelta())
-            << dex_file_->PrettyMethod(it.GetMemberIndex());
-        const OatQuickMethodHeader& method_header =
-            oat_class->method_headers_[method_offsets_index_];
-        if (!out->WriteFully(&method_header, sizeof(method_header))) {
-          ReportWriteFailure("method header", it);
+    ArrayRef<const uint8_t> quick_code = compiled_method->GetQuickCode();
+    uint32_t code_size = quick_code.size() * sizeof(uint8_t);
+
+    // Deduplicate code arrays.
+    const OatMethodOffsets& method_offsets = oat_class->method_offsets_[method_offsets_index];
+    if (method_offsets.code_offset_ > offset_) {
+      offset_ = writer_->relative_patcher_->WriteThunks(out, offset_);
+      if (offset_ == 0u) {
+        ReportWriteFailure("relative call thunk", method_ref);
+        return false;
+      }
+      uint32_t alignment_size = CodeAlignmentSize(offset_, *compiled_method);
+      if (alignment_size != 0) {
+        if (!writer_->WriteCodeAlignment(out, alignment_size)) {
+          ReportWriteFailure("code alignment padding", method_ref);
           return false;
         }
-        writer_->size_method_header_ += sizeof(method_header);
-        offset_ += sizeof(method_header);
+        offset_ += alignment_size;
         DCHECK_OFFSET_();
+      }
+      DCHECK_ALIGNED_PARAM(offset_ + sizeof(OatQuickMethodHeader),
+                           GetInstructionSetAlignment(compiled_method->GetInstructionSet()));
+      DCHECK_EQ(method_offsets.code_offset_,
+                offset_ + sizeof(OatQuickMethodHeader) + compiled_method->CodeDelta())
+          << dex_file_->PrettyMethod(method_ref.dex_method_index);
+      const OatQuickMethodHeader& method_header =
+          oat_class->method_headers_[method_offsets_index];
+      if (!out->WriteFully(&method_header, sizeof(method_header))) {
+        ReportWriteFailure("method header", method_ref);
+        return false;
+      }
+      writer_->size_method_header_ += sizeof(method_header);
+      offset_ += sizeof(method_header);
+      DCHECK_OFFSET_();
 
-        if (!compiled_method->GetPatches().empty()) {
-          patched_code_.assign(quick_code.begin(), quick_code.end());
-          quick_code = ArrayRef<const uint8_t>(patched_code_);
-          for (const LinkerPatch& patch : compiled_method->GetPatches()) {
-            uint32_t literal_offset = patch.LiteralOffset();
-            switch (patch.GetType()) {
-              case LinkerPatch::Type::kMethodBssEntry: {
-                uint32_t target_offset =
-                    writer_->bss_start_ + writer_->bss_method_entries_.Get(patch.TargetMethod());
-                writer_->relative_patcher_->PatchPcRelativeReference(&patched_code_,
-                                                                     patch,
-                                                                     offset_ + literal_offset,
-                                                                     target_offset);
-                break;
-              }
-              case LinkerPatch::Type::kCallRelative: {
-                // NOTE: Relative calls across oat files are not supported.
-                uint32_t target_offset = GetTargetOffset(patch);
-                writer_->relative_patcher_->PatchCall(&patched_code_,
-                                                      literal_offset,
-                                                      offset_ + literal_offset,
-                                                      target_offset);
-                break;
-              }
-              case LinkerPatch::Type::kStringRelative: {
-                uint32_t target_offset = GetTargetObjectOffset(GetTargetString(patch));
-                writer_->relative_patcher_->PatchPcRelativeReference(&patched_code_,
-                                                                     patch,
-                                                                     offset_ + literal_offset,
-                                                                     target_offset);
-                break;
-              }
-              case LinkerPatch::Type::kStringBssEntry: {
-                StringReference ref(patch.TargetStringDexFile(), patch.TargetStringIndex());
-                uint32_t target_offset =
-                    writer_->bss_start_ + writer_->bss_string_entries_.Get(ref);
-                writer_->relative_patcher_->PatchPcRelativeReference(&patched_code_,
-                                                                     patch,
-                                                                     offset_ + literal_offset,
-                                                                     target_offset);
-                break;
-              }
-              case LinkerPatch::Type::kTypeRelative: {
-                uint32_t target_offset = GetTargetObjectOffset(GetTargetType(patch));
-                writer_->relative_patcher_->PatchPcRelativeReference(&patched_code_,
-                                                                     patch,
-                                                                     offset_ + literal_offset,
-                                                                     target_offset);
-                break;
-              }
-              case LinkerPatch::Type::kTypeBssEntry: {
-                TypeReference ref(patch.TargetTypeDexFile(), patch.TargetTypeIndex());
-                uint32_t target_offset = writer_->bss_start_ + writer_->bss_type_entries_.Get(ref);
-                writer_->relative_patcher_->PatchPcRelativeReference(&patched_code_,
-                                                                     patch,
-                                                                     offset_ + literal_offset,
-                                                                     target_offset);
-                break;
-              }
-              case LinkerPatch::Type::kCall: {
-                uint32_t target_offset = GetTargetOffset(patch);
-                PatchCodeAddress(&patched_code_, literal_offset, target_offset);
-                break;
-              }
-              case LinkerPatch::Type::kMethodRelative: {
-                uint32_t target_offset = GetTargetMethodOffset(GetTargetMethod(patch));
-                writer_->relative_patcher_->PatchPcRelativeReference(&patched_code_,
-                                                                     patch,
-                                                                     offset_ + literal_offset,
-                                                                     target_offset);
-                break;
-              }
-              case LinkerPatch::Type::kBakerReadBarrierBranch: {
-                writer_->relative_patcher_->PatchBakerReadBarrierBranch(&patched_code_,
-                                                                        patch,
-                                                                        offset_ + literal_offset);
-                break;
-              }
-              default: {
-                DCHECK(false) << "Unexpected linker patch type: " << patch.GetType();
-                break;
-              }
+      if (!compiled_method->GetPatches().empty()) {
+        patched_code_.assign(quick_code.begin(), quick_code.end());
+        quick_code = ArrayRef<const uint8_t>(patched_code_);
+        for (const LinkerPatch& patch : compiled_method->GetPatches()) {
+          uint32_t literal_offset = patch.LiteralOffset();
+          switch (patch.GetType()) {
+            case LinkerPatch::Type::kMethodBssEntry: {
+              uint32_t target_offset =
+                  writer_->bss_start_ + writer_->bss_method_entries_.Get(patch.TargetMethod());
+              writer_->relative_patcher_->PatchPcRelativeReference(&patched_code_,
+                                                                   patch,
+                                                                   offset_ + literal_offset,
+                                                                   target_offset);
+              break;
+            }
+            case LinkerPatch::Type::kCallRelative: {
+              // NOTE: Relative calls across oat files are not supported.
+              uint32_t target_offset = GetTargetOffset(patch);
+              writer_->relative_patcher_->PatchCall(&patched_code_,
+                                                    literal_offset,
+                                                    offset_ + literal_offset,
+                                                    target_offset);
+              break;
+            }
+            case LinkerPatch::Type::kStringRelative: {
+              uint32_t target_offset = GetTargetObjectOffset(GetTargetString(patch));
+              writer_->relative_patcher_->PatchPcRelativeReference(&patched_code_,
+                                                                   patch,
+                                                                   offset_ + literal_offset,
+                                                                   target_offset);
+              break;
+            }
+            case LinkerPatch::Type::kStringBssEntry: {
+              StringReference ref(patch.TargetStringDexFile(), patch.TargetStringIndex());
+              uint32_t target_offset =
+                  writer_->bss_start_ + writer_->bss_string_entries_.Get(ref);
+              writer_->relative_patcher_->PatchPcRelativeReference(&patched_code_,
+                                                                   patch,
+                                                                   offset_ + literal_offset,
+                                                                   target_offset);
+              break;
+            }
+            case LinkerPatch::Type::kTypeRelative: {
+              uint32_t target_offset = GetTargetObjectOffset(GetTargetType(patch));
+              writer_->relative_patcher_->PatchPcRelativeReference(&patched_code_,
+                                                                   patch,
+                                                                   offset_ + literal_offset,
+                                                                   target_offset);
+              break;
+            }
+            case LinkerPatch::Type::kTypeBssEntry: {
+              TypeReference ref(patch.TargetTypeDexFile(), patch.TargetTypeIndex());
+              uint32_t target_offset = writer_->bss_start_ + writer_->bss_type_entries_.Get(ref);
+              writer_->relative_patcher_->PatchPcRelativeReference(&patched_code_,
+                                                                   patch,
+                                                                   offset_ + literal_offset,
+                                                                   target_offset);
+              break;
+            }
+            case LinkerPatch::Type::kCall: {
+              uint32_t target_offset = GetTargetOffset(patch);
+              PatchCodeAddress(&patched_code_, literal_offset, target_offset);
+              break;
+            }
+            case LinkerPatch::Type::kMethodRelative: {
+              uint32_t target_offset = GetTargetMethodOffset(GetTargetMethod(patch));
+              writer_->relative_patcher_->PatchPcRelativeReference(&patched_code_,
+                                                                   patch,
+                                                                   offset_ + literal_offset,
+                                                                   target_offset);
+              break;
+            }
+            case LinkerPatch::Type::kBakerReadBarrierBranch: {
+              writer_->relative_patcher_->PatchBakerReadBarrierBranch(&patched_code_,
+                                                                      patch,
+                                                                      offset_ + literal_offset);
+              break;
+            }
+            default: {
+              DCHECK(false) << "Unexpected linker patch type: " << patch.GetType();
+              break;
             }
           }
         }
+      }
 
-        if (!out->WriteFully(quick_code.data(), code_size)) {
-          ReportWriteFailure("method code", it);
-          return false;
-        }
-        writer_->size_code_ += code_size;
-        offset_ += code_size;
+      if (!out->WriteFully(quick_code.data(), code_size)) {
+        ReportWriteFailure("method code", method_ref);
+        return false;
       }
-      DCHECK_OFFSET_();
-      ++method_offsets_index_;
+      writer_->size_code_ += code_size;
+      offset_ += code_size;
     }
+    DCHECK_OFFSET_();
 
     return true;
   }
 
  private:
+  OatWriter* const writer_;
+
+  // Offset of the code of the next method.
+  size_t offset_;
+
+  // The dex file of the method being written.
+  const DexFile* dex_file_;
+
   const PointerSize pointer_size_;
   ObjPtr<mirror::ClassLoader> class_loader_;
   OutputStream* const out_;
@@ -1477,9 +1663,10 @@ class OatWriter::WriteCodeMethodVisitor : public OatDexMethodVisitor {
   ObjPtr<mirror::DexCache> dex_cache_;
   std::vector<uint8_t> patched_code_;
 
-  void ReportWriteFailure(const char* what, const ClassDataItemIterator& it) {
+  void ReportWriteFailure(const char* what, const MethodReference& method_ref) {
     PLOG(ERROR) << "Failed to write " << what << " for "
-        << dex_file_->PrettyMethod(it.GetMemberIndex()) << " to " << out_->GetLocation();
+        << method_ref.dex_file->PrettyMethod(method_ref.dex_method_index) << " to "
+        << out_->GetLocation();
   }
 
   ArtMethod* GetTargetMethod(const LinkerPatch& patch)
@@ -1917,10 +2104,16 @@ size_t OatWriter::InitOatCodeDexFiles(size_t offset) {
   if (!compiler_driver_->GetCompilerOptions().IsAnyCompilationEnabled()) {
     return offset;
   }
-  InitCodeMethodVisitor code_visitor(this, offset);
-  bool success = VisitDexMethods(&code_visitor);
+  LayoutCodeMethodVisitor layout_visitor(this, offset);
+  bool success = VisitDexMethods(&layout_visitor);
+  DCHECK(success);
+  ordered_methods_.reset(new OrderedMethodList(layout_visitor.ReleaseOrderedMethods()));
+
+  InitCodeMethodVisitor code_visitor(this, offset, *ordered_methods_);
+  success = code_visitor.Visit();
   DCHECK(success);
   offset = code_visitor.GetOffset();
+  oat_header_->SetHotCodeRange(code_visitor.GetHotCodeBegin(), code_visitor.GetHotCodeSize());
 
   if (HasImage()) {
     InitImageMethodVisitor image_visitor(this, offset, dex_files_);
@@ -2178,7 +2371,10 @@ bool OatWriter::WriteQuickeningInfo(OutputStream* vdex_out) {
     return false;
   }
 
-  if (compiler_driver_->GetCompilerOptions().IsAnyCompilationEnabled()) {
+  // The quickened dex files are only written to the vdex, there is no quickening info to record
+  // for dex files mapped from their zip.
+  if (compiler_driver_->GetCompilerOptions().IsAnyCompilationEnabled() &&
+      extract_dex_files_into_vdex_) {
     std::vector<uint32_t> dex_files_indices;
     SafeMap<const uint8_t*, uint32_t> offset_map;
     WriteQuickeningInfoMethodVisitor visitor1(this, vdex_out, start_offset, &offset_map);
@@ -2310,6 +2506,7 @@ bool OatWriter::WriteCode(OutputStream* out) {
     DO_STAT(size_oat_header_);
     DO_STAT(size_oat_header_key_value_store_);
     DO_STAT(size_dex_file_);
+    DO_STAT(size_shared_dex_data_);
     DO_STAT(size_verifier_deps_);
     DO_STAT(size_verifier_deps_alignment_);
     DO_STAT(size_quickening_info_);
@@ -2599,18 +2796,19 @@ size_t OatWriter::WriteCode(OutputStream* out, size_t file_offset, size_t relati
 size_t OatWriter::WriteCodeDexFiles(OutputStream* out,
                                     size_t file_offset,
                                     size_t relative_offset) {
-  #define VISIT(VisitorType)                                              \
-    do {                                                                  \
-      VisitorType visitor(this, out, file_offset, relative_offset);       \
-      if (UNLIKELY(!VisitDexMethods(&visitor))) {                         \
-        return 0;                                                         \
-      }                                                                   \
-      relative_offset = visitor.GetOffset();                              \
-    } while (false)
-
-  VISIT(WriteCodeMethodVisitor);
-
-  #undef VISIT
+  if (!compiler_driver_->GetCompilerOptions().IsAnyCompilationEnabled()) {
+    // As with InitOatCodeDexFiles(), there is no code to write.
+    return relative_offset;
+  }
+  DCHECK(ordered_methods_ != nullptr);
+  {
+    WriteCodeMethodVisitor visitor(this, out, file_offset, relative_offset, *ordered_methods_);
+    if (UNLIKELY(!visitor.Visit())) {
+      return 0;
+    }
+    relative_offset = visitor.GetOffset();
+  }
+  ordered_methods_.reset();
 
   size_code_alignment_ += relative_patcher_->CodeAlignmentSize();
   size_relative_call_thunks_ += relative_patcher_->RelativeCallThunksSize();
@@ -2650,11 +2848,13 @@ bool OatWriter::ReadDexFileHeader(File* file, OatDexFile* oat_dex_file) {
 }
 
 bool OatWriter::ValidateDexFileHeader(const uint8_t* raw_header, const char* location) {
-  if (!DexFile::IsMagicValid(raw_header)) {
+  const bool is_compact_dex = CompactDexFile::IsMagicValid(raw_header);
+  if (!is_compact_dex && !DexFile::IsMagicValid(raw_header)) {
     LOG(ERROR) << "Invalid magic number in dex file header. " << " File: " << location;
     return false;
   }
-  if (!DexFile::IsVersionValid(raw_header)) {
+  if (is_compact_dex ? !CompactDexFile::IsVersionValid(raw_header)
+                     : !DexFile::IsVersionValid(raw_header)) {
     LOG(ERROR) << "Invalid version number in dex file header. " << " File: " << location;
     return false;
   }
@@ -2672,6 +2872,12 @@ bool OatWriter::WriteDexFiles(OutputStream* out, File* file, bool update_input_v
 
   vdex_dex_files_offset_ = vdex_size_;
 
+  if (compact_dex_level_ != CompactDexLevel::kCompactDexLevelNone) {
+    DCHECK(kIsVdexEnabled);
+    DCHECK(!update_input_vdex);
+    compact_dex_shared_data_.reset(new CompactDexSharedData());
+  }
+
   // Write dex files.
   for (OatDexFile& oat_dex_file : oat_dex_files_) {
     if (!WriteDexFile(out, file, &oat_dex_file, update_input_vdex)) {
@@ -2679,10 +2885,58 @@ bool OatWriter::WriteDexFiles(OutputStream* out, File* file, bool update_input_v
     }
   }
 
+  // The shared data refers to the sources, write it before closing them.
+  if (!WriteSharedDexData(out, file, update_input_vdex)) {
+    return false;
+  }
+
   CloseSources();
   return true;
 }
 
+bool OatWriter::WriteSharedDexData(OutputStream* out, File* file, bool update_input_vdex) {
+  ArrayRef<const uint8_t> shared_data = input_vdex_shared_data_;
+  if (compact_dex_shared_data_ != nullptr) {
+    DCHECK(shared_data.empty()) << "Compact dex files from the input vdex are not laid out";
+    shared_data = ArrayRef<const uint8_t>(compact_dex_shared_data_->GetData());
+  }
+  if (shared_data.empty()) {
+    // Nothing to write, the section is empty.
+    vdex_shared_data_offset_ = vdex_size_;
+    return true;
+  }
+  DCHECK(kIsVdexEnabled);
+
+  // Code items in the shared data need the same 4 byte alignment as in dex files.
+  size_t initial_offset = vdex_size_;
+  size_t start_offset = RoundUp(initial_offset, 4u);
+  size_dex_file_alignment_ += start_offset - initial_offset;
+  vdex_shared_data_offset_ = start_offset;
+  vdex_size_ = start_offset + shared_data.size();
+  size_shared_dex_data_ += shared_data.size();
+
+  if (update_input_vdex) {
+    // The vdex already contains the shared data, no need to write it again.
+    return true;
+  }
+  off_t actual_offset = out->Seek(start_offset, kSeekSet);
+  if (actual_offset != static_cast<off_t>(start_offset)) {
+    PLOG(ERROR) << "Failed to seek to the shared dex data. Actual: " << actual_offset
+                << " Expected: " << start_offset << " Output: " << file->GetPath();
+    return false;
+  }
+  if (!out->WriteFully(shared_data.data(), shared_data.size())) {
+    PLOG(ERROR) << "Failed to write the shared dex data to " << out->GetLocation();
+    return false;
+  }
+  if (!out->Flush()) {
+    PLOG(ERROR) << "Failed to flush stream after writing the shared dex data."
+                << " Output: " << file->GetPath();
+    return false;
+  }
+  return true;
+}
+
 void OatWriter::CloseSources() {
   for (OatDexFile& oat_dex_file : oat_dex_files_) {
     oat_dex_file.source_.Clear();  // Get rid of the reference, it's about to be invalidated.
@@ -2699,7 +2953,11 @@ bool OatWriter::WriteDexFile(OutputStream* out,
   if (!SeekToDexFile(out, file, oat_dex_file)) {
     return false;
   }
-  if (profile_compilation_info_ != nullptr) {
+  // Compact dex files from an input vdex are copied along with their shared data.
+  const bool is_compact_dex_source = oat_dex_file->source_.IsRawData() &&
+      CompactDexFile::IsMagicValid(oat_dex_file->source_.GetRawData());
+  if ((profile_compilation_info_ != nullptr || compact_dex_shared_data_ != nullptr) &&
+      !is_compact_dex_source) {
     CHECK(!update_input_vdex) << "We should never update the input vdex when doing dexlayout";
     if (!LayoutAndWriteDexFile(out, oat_dex_file)) {
       return false;
@@ -2820,7 +3078,9 @@ bool OatWriter::LayoutAndWriteDexFile(OutputStream* out, OatDexFile* oat_dex_fil
   }
   Options options;
   options.output_to_memmap_ = true;
+  options.compact_dex_level_ = compact_dex_level_;
   DexLayout dex_layout(options, profile_compilation_info_, nullptr);
+  dex_layout.SetCompactDexSharedData(compact_dex_shared_data_.get());
   dex_layout.ProcessDexFile(location.c_str(), dex_file.get(), 0);
   std::unique_ptr<MemMap> mem_map(dex_layout.GetAndReleaseMemMap());
   if (!WriteDexFile(out, oat_dex_file, mem_map->Begin(), /* update_input_vdex */ false)) {
@@ -3042,6 +3302,13 @@ bool OatWriter::OpenDexFiles(
                << " error: " << error_msg;
     return false;
   }
+  // The shared data of compact dex files, if any, follows the dex files.
+  const uint8_t* shared_data = nullptr;
+  size_t shared_data_size = 0u;
+  if (kIsVdexEnabled && vdex_size_ != vdex_shared_data_offset_) {
+    shared_data = dex_files_map->Begin() + vdex_shared_data_offset_ - map_offset;
+    shared_data_size = vdex_size_ - vdex_shared_data_offset_;
+  }
   std::vector<std::unique_ptr<const DexFile>> dex_files;
   for (OatDexFile& oat_dex_file : oat_dex_files_) {
     // Make sure no one messed with input files while we were copying data.
@@ -3069,14 +3336,18 @@ bool OatWriter::OpenDexFiles(
       return false;
     }
 
-    // Now, open the dex file.
+    // Now, open the dex file. The verifier does not support compact dex files, which are
+    // written by dexlayout or copied from a vdex and not verified.
+    const bool is_compact_dex = CompactDexFile::IsMagicValid(raw_dex_file);
     dex_files.emplace_back(DexFile::Open(raw_dex_file,
                                          oat_dex_file.dex_file_size_,
+                                         is_compact_dex ? shared_data : nullptr,
+                                         is_compact_dex ? shared_data_size : 0u,
                                          oat_dex_file.GetLocation(),
                                          oat_dex_file.dex_file_location_checksum_,
                                          /* oat_dex_file */ nullptr,
-                                         verify,
-                                         verify,
+                                         verify && !is_compact_dex,
+                                         verify && !is_compact_dex,
                                          &error_msg));
     if (dex_files.back() == nullptr) {
       LOG(ERROR) << "Failed to open dex file from oat file. File: " << oat_dex_file.GetLocation()
@@ -3090,6 +3361,80 @@ bool OatWriter::OpenDexFiles(
   return true;
 }
 
+bool OatWriter::CanMapDexFilesFromZip() const {
+  if (oat_dex_files_.empty() ||
+      profile_compilation_info_ != nullptr ||
+      compact_dex_level_ != CompactDexLevel::kCompactDexLevelNone) {
+    // Dexlayout writes new dex files.
+    return false;
+  }
+  for (const OatDexFile& oat_dex_file : oat_dex_files_) {
+    if (!oat_dex_file.source_.IsZipEntry()) {
+      return false;
+    }
+    // The runtime maps entries aligned to the dex file header. Require page alignment so that
+    // the dex file does not share pages with the rest of the zip.
+    ZipEntry* zip_entry = oat_dex_file.source_.GetZipEntry();
+    if (!zip_entry->IsUncompressed() || !zip_entry->IsAlignedTo(kPageSize)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool OatWriter::MapDexFilesFromZip(
+    bool verify,
+    /*out*/ std::vector<std::unique_ptr<const DexFile>>* opened_dex_files) {
+  TimingLogger::ScopedTiming split("MapDexFilesFromZip", timings_);
+
+  std::vector<std::unique_ptr<const DexFile>> dex_files;
+  for (OatDexFile& oat_dex_file : oat_dex_files_) {
+    std::string error_msg;
+    ZipEntry* zip_entry = oat_dex_file.source_.GetZipEntry();
+    std::unique_ptr<MemMap> map(
+        zip_entry->MapDirectlyFromFile(oat_dex_file.GetLocation(), &error_msg));
+    if (map == nullptr) {
+      LOG(ERROR) << "Failed to map dex file from ZIP entry: " << error_msg
+                 << " File: " << oat_dex_file.GetLocation();
+      return false;
+    }
+    if (map->Size() < sizeof(DexFile::Header) ||
+        !ValidateDexFileHeader(map->Begin(), oat_dex_file.GetLocation())) {
+      LOG(ERROR) << "Invalid dex file header in ZIP entry. File: " << oat_dex_file.GetLocation();
+      return false;
+    }
+    const UnalignedDexFileHeader* header = AsUnalignedDexFileHeader(map->Begin());
+    if (map->Size() < header->file_size_) {
+      LOG(ERROR) << "Truncated dex file in ZIP entry. Entry size: " << map->Size()
+                 << " file size from header: " << header->file_size_
+                 << " File: " << oat_dex_file.GetLocation();
+      return false;
+    }
+    // A zero offset tells the runtime to map the dex file from the zip as well. The checksum
+    // is the CRC of the entry, like for extracted dex files.
+    oat_dex_file.dex_file_offset_ = 0u;
+    oat_dex_file.dex_file_size_ = header->file_size_;
+    oat_dex_file.dex_file_location_checksum_ = zip_entry->GetCrc32();
+    oat_dex_file.class_offsets_.resize(header->class_defs_size_);
+
+    // The mapping is private and writable, so dex-to-dex transformations do not reach the zip.
+    dex_files.emplace_back(DexFile::Open(oat_dex_file.GetLocation(),
+                                         oat_dex_file.dex_file_location_checksum_,
+                                         std::move(map),
+                                         verify,
+                                         verify,
+                                         &error_msg));
+    if (dex_files.back() == nullptr) {
+      LOG(ERROR) << "Failed to open dex file from ZIP entry. File: " << oat_dex_file.GetLocation()
+                 << " Error: " << error_msg;
+      return false;
+    }
+  }
+
+  *opened_dex_files = std::move(dex_files);
+  return true;
+}
+
 bool OatWriter::WriteTypeLookupTables(
     OutputStream* oat_rodata,
     const std::vector<std::unique_ptr<const DexFile>>& opened_dex_files) {
@@ -3270,12 +3615,14 @@ bool OatWriter::WriteChecksumsAndVdexHeader(OutputStream* vdex_out) {
   DCHECK_NE(vdex_dex_files_offset_, 0u);
   DCHECK_NE(vdex_verifier_deps_offset_, 0u);
 
-  size_t dex_section_size = vdex_verifier_deps_offset_ - vdex_dex_files_offset_;
+  size_t dex_section_size = vdex_shared_data_offset_ - vdex_dex_files_offset_;
+  size_t shared_data_section_size = vdex_verifier_deps_offset_ - vdex_shared_data_offset_;
   size_t verifier_deps_section_size = vdex_quickening_info_offset_ - vdex_verifier_deps_offset_;
   size_t quickening_info_section_size = vdex_size_ - vdex_quickening_info_offset_;
 
   VdexFile::Header vdex_header(oat_dex_files_.size(),
                                dex_section_size,
+                               shared_data_section_size,
                                verifier_deps_section_size,
                                quickening_info_section_size);
   if (!vdex_out->WriteFully(&vdex_header, sizeof(VdexFile::Header))) {
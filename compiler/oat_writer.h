@@ -20,9 +20,11 @@
 #include <stdint.h>
 #include <cstddef>
 #include <memory>
+#include <vector>
 
 #include "base/array_ref.h"
 #include "base/dchecked_vector.h"
+#include "compact_dex_level.h"
 #include "linker/relative_patcher.h"  // For linker::RelativePatcherTargetProvider.
 #include "mem_map.h"
 #include "method_reference.h"
@@ -36,6 +38,7 @@
 namespace art {
 
 class BitVector;
+class CompactDexSharedData;
 class CompiledMethod;
 class CompilerDriver;
 class ImageWriter;
@@ -113,7 +116,10 @@ class OatWriter {
     kDefault = kCreate
   };
 
-  OatWriter(bool compiling_boot_image, TimingLogger* timings, ProfileCompilationInfo* info);
+  OatWriter(bool compiling_boot_image,
+            TimingLogger* timings,
+            ProfileCompilationInfo* info,
+            CompactDexLevel compact_dex_level);
 
   // To produce a valid oat file, the user must first add sources with any combination of
   //   - AddDexFileSource(),
@@ -161,6 +167,9 @@ class OatWriter {
   // This is generally the case, and should only be false for tests.
   // If `update_input_vdex` is true, then this method won't actually write the dex files,
   // and the compiler will just re-use the existing vdex file.
+  // If `copy_dex_files` is false and all the dex files are stored uncompressed and page aligned
+  // in zips, they are not written either but mapped from the zips, and `opened_dex_files_map`
+  // is null. The runtime maps them from the zips too.
   bool WriteAndOpenDexFiles(File* vdex_file,
                             OutputStream* oat_rodata,
                             InstructionSet instruction_set,
@@ -168,6 +177,7 @@ class OatWriter {
                             SafeMap<std::string, std::string>* key_value_store,
                             bool verify,
                             bool update_input_vdex,
+                            bool copy_dex_files,
                             /*out*/ std::unique_ptr<MemMap>* opened_dex_files_map,
                             /*out*/ std::vector<std::unique_ptr<const DexFile>>* opened_dex_files);
   bool WriteQuickeningInfo(OutputStream* vdex_out);
@@ -268,6 +278,15 @@ class OatWriter {
   class WriteQuickeningInfoMethodVisitor;
   class WriteQuickeningIndicesMethodVisitor;
 
+  // With a profile, the code of the compiled methods is laid out in the order of their hotness
+  // rather than in their definition order. The LayoutCodeMethodVisitor collects the methods
+  // with compiled code into an OrderedMethodList and the code passes visit that list with an
+  // OrderedMethodVisitor.
+  struct OrderedMethodData;
+  using OrderedMethodList = std::vector<OrderedMethodData>;
+  class LayoutCodeMethodVisitor;
+  class OrderedMethodVisitor;
+
   // Visit all the methods in all the compiled dex files in their definition order
   // with a given DexMethodVisitor.
   bool VisitDexMethods(DexMethodVisitor* visitor);
@@ -293,10 +312,16 @@ class OatWriter {
                     OatDexFile* oat_dex_file,
                     const uint8_t* dex_file,
                     bool update_input_vdex);
+  // Write the data section shared by the compact dex files, if any, after the dex files.
+  bool WriteSharedDexData(OutputStream* out, File* file, bool update_input_vdex);
   bool OpenDexFiles(File* file,
                     bool verify,
                     /*out*/ std::unique_ptr<MemMap>* opened_dex_files_map,
                     /*out*/ std::vector<std::unique_ptr<const DexFile>>* opened_dex_files);
+  // Whether all the dex files can be mapped from uncompressed, page aligned zip entries.
+  bool CanMapDexFilesFromZip() const;
+  bool MapDexFilesFromZip(bool verify,
+                          /*out*/ std::vector<std::unique_ptr<const DexFile>>* opened_dex_files);
 
   size_t InitOatHeader(InstructionSet instruction_set,
                        const InstructionSetFeatures* instruction_set_features,
@@ -368,6 +393,9 @@ class OatWriter {
   // Offset of section holding Dex files inside Vdex.
   size_t vdex_dex_files_offset_;
 
+  // Offset of section holding the data shared by compact dex files inside Vdex.
+  size_t vdex_shared_data_offset_;
+
   // Offset of section holding VerifierDeps inside Vdex.
   size_t vdex_verifier_deps_offset_;
 
@@ -432,6 +460,7 @@ class OatWriter {
   uint32_t size_oat_header_;
   uint32_t size_oat_header_key_value_store_;
   uint32_t size_dex_file_;
+  uint32_t size_shared_dex_data_;
   uint32_t size_verifier_deps_;
   uint32_t size_verifier_deps_alignment_;
   uint32_t size_quickening_info_;
@@ -480,6 +509,20 @@ class OatWriter {
   // Profile info used to generate new layout of files.
   ProfileCompilationInfo* profile_compilation_info_;
 
+  // Whether to write compact dex files, and the data section they share.
+  const CompactDexLevel compact_dex_level_;
+  std::unique_ptr<CompactDexSharedData> compact_dex_shared_data_;
+
+  // The shared data of the compact dex files of the input vdex, copied as is with them.
+  ArrayRef<const uint8_t> input_vdex_shared_data_;
+
+  // Whether the dex files are written to the vdex, rather than mapped from their zip.
+  bool extract_dex_files_into_vdex_;
+
+  // The methods with compiled code in the order of their code, from InitOatCodeDexFiles()
+  // until WriteCodeDexFiles().
+  std::unique_ptr<OrderedMethodList> ordered_methods_;
+
   DISALLOW_COPY_AND_ASSIGN(OatWriter);
 };
 
@@ -97,6 +97,9 @@ bool HBasicBlockBuilder::CreateBranchTargets() {
           MaybeCreateBlockAt(dex_pc, s_it.GetDexPcForCurrentIndex());
         }
       }
+      if (table.ShouldBuildBinarySearchTree()) {
+        CreateSwitchTreeBlocks(table, dex_pc, 0u, table.GetNumEntries());
+      }
     } else if (instruction.Opcode() == Instruction::MOVE_EXCEPTION) {
       // End the basic block after MOVE_EXCEPTION. This simplifies the later
       // stage of TryBoundary-block insertion.
@@ -168,6 +171,13 @@ void HBasicBlockBuilder::ConnectBasicBlocks() {
       block->AddSuccessor(graph_->GetExitBlock());
     } else if (instruction.IsSwitch()) {
       DexSwitchTable table(instruction, dex_pc);
+      if (table.ShouldBuildBinarySearchTree()) {
+        // The leaves of the tree fall through to the next instruction.
+        HBasicBlock* default_block = GetBlockAt(dex_pc + instruction.SizeInCodeUnits());
+        ConnectSwitchTree(table, dex_pc, block, 0u, table.GetNumEntries(), default_block);
+        block = nullptr;
+        continue;
+      }
       for (DexSwitchTableIterator s_it(table); !s_it.Done(); s_it.Advance()) {
         uint32_t target_dex_pc = dex_pc + s_it.CurrentTargetOffset();
         block->AddSuccessor(GetBlockAt(target_dex_pc));
@@ -197,6 +207,59 @@ void HBasicBlockBuilder::ConnectBasicBlocks() {
   graph_->AddBlock(graph_->GetExitBlock());
 }
 
+void HBasicBlockBuilder::CreateSwitchTreeBlocks(const DexSwitchTable& table,
+                                                uint32_t dex_pc,
+                                                size_t lo,
+                                                size_t hi) {
+  if (DexSwitchTable::IsBinarySearchLeaf(lo, hi)) {
+    // The first key is compared in the block of the leaf itself.
+    for (size_t i = lo + 1; i < hi; ++i) {
+      MaybeCreateBlockAt(dex_pc, table.GetDexPcForCaseBlock(i));
+    }
+  } else {
+    size_t mid = DexSwitchTable::GetBinarySearchSplit(lo, hi);
+    MaybeCreateBlockAt(dex_pc, table.GetDexPcForBinarySearchNode(lo, mid));
+    MaybeCreateBlockAt(dex_pc, table.GetDexPcForBinarySearchNode(mid, hi));
+    CreateSwitchTreeBlocks(table, dex_pc, lo, mid);
+    CreateSwitchTreeBlocks(table, dex_pc, mid, hi);
+  }
+}
+
+void HBasicBlockBuilder::ConnectSwitchTree(const DexSwitchTable& table,
+                                           uint32_t dex_pc,
+                                           HBasicBlock* block,
+                                           size_t lo,
+                                           size_t hi,
+                                           HBasicBlock* default_block) {
+  if (DexSwitchTable::IsBinarySearchLeaf(lo, hi)) {
+    // Same as the decision tree: the true successor is the case target, the false
+    // successor is the comparison against the next key, or the default after the last.
+    for (size_t i = lo; i < hi; ++i) {
+      uint32_t target_dex_pc = dex_pc + table.GetEntryAt(table.GetFirstValueIndex() + i);
+      block->AddSuccessor(GetBlockAt(target_dex_pc));
+      if (i + 1 < hi) {
+        HBasicBlock* next_case_block = GetBlockAt(table.GetDexPcForCaseBlock(i + 1));
+        block->AddSuccessor(next_case_block);
+        block = next_case_block;
+        graph_->AddBlock(block);
+      } else {
+        block->AddSuccessor(default_block);
+      }
+    }
+  } else {
+    // The true successor handles the keys below the split, the false successor the rest.
+    size_t mid = DexSwitchTable::GetBinarySearchSplit(lo, hi);
+    HBasicBlock* lower_block = GetBlockAt(table.GetDexPcForBinarySearchNode(lo, mid));
+    HBasicBlock* upper_block = GetBlockAt(table.GetDexPcForBinarySearchNode(mid, hi));
+    block->AddSuccessor(lower_block);
+    block->AddSuccessor(upper_block);
+    graph_->AddBlock(lower_block);
+    ConnectSwitchTree(table, dex_pc, lower_block, lo, mid, default_block);
+    graph_->AddBlock(upper_block);
+    ConnectSwitchTree(table, dex_pc, upper_block, mid, hi, default_block);
+  }
+}
+
 // Returns the TryItem stored for `block` or nullptr if there is no info for it.
 static const DexFile::TryItem* GetTryItem(
     HBasicBlock* block,
@@ -24,6 +24,8 @@
 
 namespace art {
 
+class DexSwitchTable;
+
 class HBasicBlockBuilder : public ValueObject {
  public:
   HBasicBlockBuilder(HGraph* graph,
@@ -62,6 +64,16 @@ class HBasicBlockBuilder : public ValueObject {
 
   bool CreateBranchTargets();
   void ConnectBasicBlocks();
+
+  // Create and connect the blocks below the binary search node over the keys [lo, hi)
+  // of the sparse switch at `dex_pc`, whose own block is `block` when connecting.
+  void CreateSwitchTreeBlocks(const DexSwitchTable& table, uint32_t dex_pc, size_t lo, size_t hi);
+  void ConnectSwitchTree(const DexSwitchTable& table,
+                         uint32_t dex_pc,
+                         HBasicBlock* block,
+                         size_t lo,
+                         size_t hi,
+                         HBasicBlock* default_block);
   void InsertTryBoundaryBlocks();
 
   // Helper method which decides whether `catch_block` may have live normal
@@ -525,6 +525,7 @@ class BCEVisitor : public HGraphVisitor {
             std::less<uint32_t>(),
             graph->GetArena()->Adapter(kArenaAllocBoundsCheckElimination)),
         finite_loop_(graph->GetArena()->Adapter(kArenaAllocBoundsCheckElimination)),
+        strided_loop_(graph->GetArena()->Adapter(kArenaAllocBoundsCheckElimination)),
         has_dom_based_dynamic_bce_(false),
         initial_block_size_(graph->GetBlocks().size()),
         side_effects_(side_effects),
@@ -887,9 +888,10 @@ class BCEVisitor : public HGraphVisitor {
       bool needs_finite_test = false;
       bool needs_taken_test = false;
       if (DynamicBCESeemsProfitable(loop, bounds_check->GetBlock()) &&
-          induction_range_.CanGenerateRange(
-              bounds_check, index, &needs_finite_test, &needs_taken_test) &&
-          CanHandleInfiniteLoop(loop, index, needs_finite_test) &&
+          ((induction_range_.CanGenerateRange(
+                bounds_check, index, &needs_finite_test, &needs_taken_test) &&
+            CanHandleInfiniteLoop(loop, index, needs_finite_test)) ||
+           induction_range_.CanGenerateStridedRange(bounds_check, index, &needs_taken_test)) &&
           // Do this test last, since it may generate code.
           CanHandleLength(loop, array_length, needs_taken_test)) {
         TransformLoopForDeoptimizationIfNeeded(loop, needs_taken_test);
@@ -1344,6 +1346,10 @@ class BCEVisitor : public HGraphVisitor {
     DCHECK(loop->DominatesAllBackEdges(bounds_check->GetBlock()));
     // Collect all bounds checks in the same loop that are related as "a[base + constant]"
     // for a base instruction (possibly absent) and various constants.
+    // Related bounds checks advance with the same stride. A non-unit stride is only
+    // handled within the loop-body, protected by further deoptimization tests.
+    bool b1 = false, b2 = false;
+    const bool is_strided = !induction_range_.CanGenerateRange(bounds_check, index, &b1, &b2);
     ValueBound value = ValueBound::AsValueBound(index);
     HInstruction* base = value.GetInstruction();
     int32_t min_c = base == nullptr ? 0 : value.GetConstant();
@@ -1362,8 +1368,9 @@ class BCEVisitor : public HGraphVisitor {
         int32_t other_c = other_value.GetConstant();
         if (array_length == other_array_length && base == other_value.GetInstruction()) {
           // Ensure every candidate could be picked for code generation.
-          bool b1 = false, b2 = false;
-          if (!induction_range_.CanGenerateRange(other_bounds_check, other_index, &b1, &b2)) {
+          if (is_strided
+                  ? !induction_range_.CanGenerateStridedRange(other_bounds_check, other_index, &b2)
+                  : !induction_range_.CanGenerateRange(other_bounds_check, other_index, &b1, &b2)) {
             continue;
           }
           // Does the current basic block dominate all back edges? If not,
@@ -1393,6 +1400,9 @@ class BCEVisitor : public HGraphVisitor {
     if ((base != nullptr || min_c >= 0) &&  // reject certain OOB
         distance <= kMaxLengthForAddingDeoptimize) {  // reject likely/certain deopt
       HBasicBlock* block = GetPreHeader(loop, bounds_check);
+      if (is_strided) {
+        InsertStrideTestsInLoop(loop, block, bounds_check);
+      }
       HInstruction* min_lower = nullptr;
       HInstruction* min_upper = nullptr;
       HInstruction* max_lower = nullptr;
@@ -1406,7 +1416,7 @@ class BCEVisitor : public HGraphVisitor {
           int32_t other_c = ValueBound::AsValueBound(other_index).GetConstant();
           // Generate code for either the maximum or minimum. Range analysis already was queried
           // whether code generation on the original and, thus, related bounds check was possible.
-          // It handles either loop invariants (lower is not set) or unit strides.
+          // It handles either loop invariants (lower is not set) or strides of the loop control.
           if (other_c == max_c) {
             induction_range_.GenerateRange(
                 other_bounds_check, other_index, GetGraph(), block, &max_lower, &max_upper);
@@ -1423,7 +1433,7 @@ class BCEVisitor : public HGraphVisitor {
       // (2) two symbolic invariants
       //       if (min_upper >  max_upper) deoptimize;   unless min_c == max_c
       //       if (max_upper >= a.length ) deoptimize;
-      // (3) general case, unit strides (where lower would exceed upper for arithmetic wrap-around)
+      // (3) general case, strides (where lower would exceed upper for arithmetic wrap-around)
       //       if (min_lower >  max_lower) deoptimize;   unless min_c == max_c
       //       if (max_lower >  max_upper) deoptimize;
       //       if (max_upper >= a.length ) deoptimize;
@@ -1443,7 +1453,7 @@ class BCEVisitor : public HGraphVisitor {
                  max_lower == nullptr && max_upper != nullptr);
         }
       } else {
-        // General case, unit strides.
+        // General case, strides.
         if (min_c != max_c) {
           DCHECK(min_lower != nullptr && min_upper != nullptr &&
                  max_lower != nullptr && max_upper != nullptr);
@@ -1633,6 +1643,29 @@ class BCEVisitor : public HGraphVisitor {
     }
   }
 
+  /**
+   * Inserts the deoptimization tests that guard range evaluation in a loop with a
+   * non-unit stride, if not already done for the loop.
+   */
+  void InsertStrideTestsInLoop(HLoopInformation* loop,
+                               HBasicBlock* block,
+                               HBoundsCheck* bounds_check) {
+    const uint32_t loop_id = loop->GetHeader()->GetBlockId();
+    if (strided_loop_.find(loop_id) != strided_loop_.end()) {
+      return;
+    }
+    strided_loop_.insert(loop_id);
+    HInstruction* finite_test = nullptr;
+    HInstruction* wrap_test = nullptr;
+    induction_range_.GenerateStrideTests(bounds_check, GetGraph(), block, &finite_test, &wrap_test);
+    if (finite_test != nullptr) {
+      InsertDeoptInLoop(loop, block, finite_test);
+    }
+    if (wrap_test != nullptr) {
+      InsertDeoptInLoop(loop, block, wrap_test);
+    }
+  }
+
   /** Inserts a deoptimization test right before a bounds check. */
   void InsertDeoptInBlock(HBoundsCheck* bounds_check, HInstruction* condition) {
     HBasicBlock* block = bounds_check->GetBlock();
@@ -1830,6 +1863,9 @@ class BCEVisitor : public HGraphVisitor {
   // Finite loop bookkeeping.
   ArenaSet<uint32_t> finite_loop_;
 
+  // Non-unit stride loop bookkeeping.
+  ArenaSet<uint32_t> strided_loop_;
+
   // Flag that denotes whether dominator-based dynamic elimination has occurred.
   bool has_dom_based_dynamic_bce_;
 
@@ -15,6 +15,7 @@
  */
 
 #include "base/arena_allocator.h"
+#include "base/scoped_arena_allocator.h"
 #include "bounds_check_elimination.h"
 #include "builder.h"
 #include "gvn.h"
@@ -33,8 +34,8 @@ namespace art {
  */
 class BoundsCheckEliminationTest : public testing::Test {
  public:
-  BoundsCheckEliminationTest()  : pool_(), allocator_(&pool_) {
-    graph_ = CreateGraph(&allocator_);
+  BoundsCheckEliminationTest()  : pool_(), allocator_(&pool_), arena_stack_(&pool_) {
+    graph_ = CreateGraph(&allocator_, &arena_stack_);
     graph_->SetHasBoundsChecks(true);
   }
 
@@ -58,6 +59,7 @@ class BoundsCheckEliminationTest : public testing::Test {
 
   ArenaPool pool_;
   ArenaAllocator allocator_;
+  ArenaStack arena_stack_;
   HGraph* graph_;
 };
 
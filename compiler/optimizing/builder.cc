@@ -37,6 +37,11 @@ void HGraphBuilder::MaybeRecordStat(MethodCompilationStat compilation_stat) {
   }
 }
 
+// The environment of every instruction that can throw or suspend holds all the dex registers,
+// so the graph of a huge method grows with its dex registers times its instructions. Huge
+// methods with more dex registers than this are not compiled for OSR.
+static constexpr size_t kMaxHugeMethodOsrVRegs = 256;
+
 bool HGraphBuilder::SkipCompilation(size_t number_of_branches) {
   if (compiler_driver_ == nullptr) {
     // Note that the compiler driver is null when unit testing.
@@ -50,6 +55,18 @@ bool HGraphBuilder::SkipCompilation(size_t number_of_branches) {
   }
 
   if (compiler_options.IsHugeMethod(code_item_.insns_size_in_code_units_)) {
+    if (graph_->IsCompilingOsr() &&
+        number_of_branches != 0 &&
+        code_item_.registers_size_ <= kMaxHugeMethodOsrVRegs) {
+      // The interpreter is spending time in a loop of this method. Compiling it, with the
+      // cheaper pipeline used for baseline code, beats staying in the interpreter. The
+      // compilation also gives up when it goes over its memory and time budget, see
+      // OptimizingCompiler::TryCompile().
+      VLOG(compiler) << "Compile huge method "
+                     << dex_file_->PrettyMethod(dex_compilation_unit_->GetDexMethodIndex())
+                     << " for OSR: " << code_item_.insns_size_in_code_units_ << " code units";
+      return false;
+    }
     VLOG(compiler) << "Skip compilation of huge method "
                    << dex_file_->PrettyMethod(dex_compilation_unit_->GetDexMethodIndex())
                    << ": " << code_item_.insns_size_in_code_units_ << " code units";
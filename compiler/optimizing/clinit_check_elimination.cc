@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "clinit_check_elimination.h"
+
+#include <algorithm>
+
+#include "mirror/class-inl.h"
+#include "scoped_thread_state_change-inl.h"
+
+namespace art {
+
+/**
+ * Returns whether a successful check of the class loaded by `dominator` implies
+ * that the class loaded by `load_class` is initialized.
+ */
+static bool ImpliesInitialized(HLoadClass* dominator, HLoadClass* load_class)
+    REQUIRES_SHARED(Locks::mutator_lock_) {
+  if (dominator == load_class) {
+    return true;
+  }
+  ObjPtr<mirror::Class> dominator_class = dominator->GetClass().Get();
+  ObjPtr<mirror::Class> klass = load_class->GetClass().Get();
+  if (dominator_class == nullptr || klass == nullptr) {
+    // Unresolved classes can only be matched by the instruction loading them.
+    return false;
+  }
+  // IsSubClass() only follows the superclass chain. Interfaces are not necessarily
+  // initialized with the classes implementing them.
+  return dominator_class->IsSubClass(klass);
+}
+
+void ClinitCheckElimination::Run() {
+  ScopedObjectAccess soa(Thread::Current());
+  ArenaAllocator* arena = graph_->GetArena();
+  // For each block, the classes of the checks that have executed at its end.
+  ArenaVector<ArenaVector<HLoadClass*>> initialized_at_end(
+      graph_->GetBlocks().size(),
+      ArenaVector<HLoadClass*>(arena->Adapter(kArenaAllocOptimization)),
+      arena->Adapter(kArenaAllocOptimization));
+
+  // Visiting in reverse post order guarantees that the dominator of a block is visited first.
+  for (HBasicBlock* block : graph_->GetReversePostOrder()) {
+    ArenaVector<HLoadClass*>& initialized = initialized_at_end[block->GetBlockId()];
+    HBasicBlock* dominator = block->GetDominator();
+    if (dominator != nullptr) {
+      initialized = initialized_at_end[dominator->GetBlockId()];
+    }
+    for (HInstructionIterator it(block->GetInstructions()); !it.Done(); it.Advance()) {
+      if (!it.Current()->IsClinitCheck()) {
+        continue;
+      }
+      HClinitCheck* check = it.Current()->AsClinitCheck();
+      HLoadClass* load_class = check->GetLoadClass();
+      bool redundant = std::any_of(initialized.begin(),
+                                   initialized.end(),
+                                   [load_class](HLoadClass* dominating) {
+        return ImpliesInitialized(dominating, load_class);
+      });
+      if (redundant) {
+        RemoveCheck(check);
+      } else {
+        initialized.push_back(load_class);
+      }
+    }
+  }
+}
+
+void ClinitCheckElimination::RemoveCheck(HClinitCheck* check) {
+  // Static invokes with an explicit check no longer need it. Other users, i.e. static field
+  // accesses and new-instances, take the class directly as if it had been known to be
+  // initialized when building the graph.
+  const HUseList<HInstruction*>& uses = check->GetUses();
+  for (auto it = uses.begin(), end = uses.end(); it != end; /* ++it below */) {
+    HInstruction* user = it->GetUser();
+    ++it;  // Advance before we remove the node, reference to the next node is preserved.
+    if (user->IsInvokeStaticOrDirect()) {
+      user->AsInvokeStaticOrDirect()->RemoveExplicitClinitCheck(
+          HInvokeStaticOrDirect::ClinitCheckRequirement::kNone);
+    }
+  }
+  check->ReplaceWith(check->GetLoadClass());
+  check->GetBlock()->RemoveInstruction(check);
+  MaybeRecordStat(MethodCompilationStat::kClinitCheckEliminated);
+}
+
+}  // namespace art
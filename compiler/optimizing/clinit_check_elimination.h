@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_CLINIT_CHECK_ELIMINATION_H_
+#define ART_COMPILER_OPTIMIZING_CLINIT_CHECK_ELIMINATION_H_
+
+#include "nodes.h"
+#include "optimization.h"
+
+namespace art {
+
+/**
+ * Removes class initialization checks that are dominated by a check of the same class or of
+ * one of its subclasses. Once a class is initialized, or being initialized by the current
+ * thread, so are all of its superclasses, so the dominated check would always succeed
+ * without calling the runtime. Unlike GVN, this also catches checks whose HLoadClass is a
+ * different instruction, for example after inlining a method from another dex file.
+ */
+class ClinitCheckElimination : public HOptimization {
+ public:
+  ClinitCheckElimination(HGraph* graph, OptimizingCompilerStats* stats)
+      : HOptimization(graph, kClinitCheckEliminationPassName, stats) {}
+
+  void Run() OVERRIDE;
+
+  static constexpr const char* kClinitCheckEliminationPassName = "clinit_check_elimination";
+
+ private:
+  void RemoveCheck(HClinitCheck* check);
+
+  DISALLOW_COPY_AND_ASSIGN(ClinitCheckElimination);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_CLINIT_CHECK_ELIMINATION_H_
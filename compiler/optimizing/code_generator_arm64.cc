@@ -2199,6 +2199,11 @@ void CodeGeneratorARM64::GenerateMemoryBarrier(MemBarrierKind kind) {
 
 void InstructionCodeGeneratorARM64::GenerateSuspendCheck(HSuspendCheck* instruction,
                                                          HBasicBlock* successor) {
+  // The runtime only saves the lower half of the SIMD registers, the slow path spills them.
+  if (codegen_->GetCompilerOptions().GetImplicitSuspendChecks() && !GetGraph()->HasSIMD()) {
+    GenerateImplicitSuspendCheck(instruction, successor);
+    return;
+  }
   SuspendCheckSlowPathARM64* slow_path =
       down_cast<SuspendCheckSlowPathARM64*>(instruction->GetSlowPath());
   if (slow_path == nullptr) {
@@ -2227,11 +2232,37 @@ void InstructionCodeGeneratorARM64::GenerateSuspendCheck(HSuspendCheck* instruct
   }
 }
 
+void InstructionCodeGeneratorARM64::GenerateImplicitSuspendCheck(HSuspendCheck* instruction,
+                                                                 HBasicBlock* successor) {
+  if (successor != nullptr) {
+    DCHECK(successor->IsLoopHeader());
+    codegen_->ClearSpillSlotsFromLoopPhisInStackMap(instruction);
+  }
+  // The suspend trigger is null while a suspension or checkpoint is requested, making the
+  // second load fault. SuspensionHandler in fault_handler_arm64.cc matches this exact sequence
+  // and calls art_quick_implicit_suspend, which returns after the faulting load.
+  int32_t trigger_offset = Thread::ThreadSuspendTriggerOffset<kArm64PointerSize>().Int32Value();
+  UseScratchRegisterScope temps(codegen_->GetVIXLAssembler());
+  temps.Exclude(ip0);
+  {
+    ExactAssemblyScope eas(GetVIXLAssembler(),
+                           2 * kInstructionSize,
+                           CodeBufferCheckScope::kExactSize);
+    __ ldr(ip0, MemOperand(tr, trigger_offset));
+    __ ldr(wzr, MemOperand(ip0, 0));
+    codegen_->RecordPcInfo(instruction, instruction->GetDexPc());
+  }
+  if (successor != nullptr) {
+    __ B(codegen_->GetLabelOf(successor));
+  }
+}
+
 InstructionCodeGeneratorARM64::InstructionCodeGeneratorARM64(HGraph* graph,
                                                              CodeGeneratorARM64* codegen)
       : InstructionCodeGenerator(graph, codegen),
         assembler_(codegen->GetAssembler()),
-        codegen_(codegen) {}
+        codegen_(codegen),
+        paired_field_access_(nullptr) {}
 
 #define FOR_EACH_UNIMPLEMENTED_INSTRUCTION(M)              \
   /* No unimplemented IR. */
@@ -2327,6 +2358,14 @@ void LocationsBuilderARM64::HandleFieldGet(HInstruction* instruction,
 void InstructionCodeGeneratorARM64::HandleFieldGet(HInstruction* instruction,
                                                    const FieldInfo& field_info) {
   DCHECK(instruction->IsInstanceFieldGet() || instruction->IsStaticFieldGet());
+  if (instruction == paired_field_access_) {
+    // Already loaded by the LDP emitted for the previous instruction.
+    paired_field_access_ = nullptr;
+    return;
+  }
+  if (TryGenerateFieldGetPair(instruction, field_info)) {
+    return;
+  }
   LocationSummary* locations = instruction->GetLocations();
   Location base_loc = locations->InAt(0);
   Location out = locations->Out();
@@ -2390,6 +2429,14 @@ void InstructionCodeGeneratorARM64::HandleFieldSet(HInstruction* instruction,
                                                    const FieldInfo& field_info,
                                                    bool value_can_be_null) {
   DCHECK(instruction->IsInstanceFieldSet() || instruction->IsStaticFieldSet());
+  if (instruction == paired_field_access_) {
+    // Already stored by the STP emitted for the previous instruction.
+    paired_field_access_ = nullptr;
+    return;
+  }
+  if (TryGenerateFieldSetPair(instruction, field_info, value_can_be_null)) {
+    return;
+  }
 
   Register obj = InputRegisterAt(instruction, 0);
   CPURegister value = InputCPURegisterOrZeroRegAt(instruction, 1);
@@ -2426,6 +2473,141 @@ void InstructionCodeGeneratorARM64::HandleFieldSet(HInstruction* instruction,
   }
 }
 
+static const FieldInfo& FieldAccessInfo(HInstruction* instruction) {
+  switch (instruction->GetKind()) {
+    case HInstruction::kInstanceFieldGet:
+      return instruction->AsInstanceFieldGet()->GetFieldInfo();
+    case HInstruction::kStaticFieldGet:
+      return instruction->AsStaticFieldGet()->GetFieldInfo();
+    case HInstruction::kInstanceFieldSet:
+      return instruction->AsInstanceFieldSet()->GetFieldInfo();
+    case HInstruction::kStaticFieldSet:
+      return instruction->AsStaticFieldSet()->GetFieldInfo();
+    default:
+      LOG(FATAL) << "Unexpected field access " << instruction->DebugName();
+      UNREACHABLE();
+  }
+}
+
+static bool FieldSetValueCanBeNull(HInstruction* instruction) {
+  return instruction->IsInstanceFieldSet()
+      ? instruction->AsInstanceFieldSet()->GetValueCanBeNull()
+      : instruction->AsStaticFieldSet()->GetValueCanBeNull();
+}
+
+HInstruction* InstructionCodeGeneratorARM64::GetPairableFieldAccess(
+    HInstruction* instruction, const FieldInfo& field_info) {
+  // The two accesses must be adjacent, without even a parallel move in between, so that
+  // nothing else observes the memory or the registers between them.
+  HInstruction* next = instruction->GetNext();
+  if (next == nullptr ||
+      next->GetKind() != instruction->GetKind() ||
+      next->InputAt(0) != instruction->InputAt(0)) {
+    return nullptr;
+  }
+  const FieldInfo& next_field_info = FieldAccessInfo(next);
+  if (field_info.IsVolatile() || next_field_info.IsVolatile()) {
+    return nullptr;
+  }
+  // LDP and STP only exist for 32-bit and 64-bit accesses.
+  size_t size = Primitive::ComponentSize(field_info.GetFieldType());
+  if ((size != kWRegSizeInBytes && size != kXRegSizeInBytes) ||
+      Primitive::ComponentSize(next_field_info.GetFieldType()) != size) {
+    return nullptr;
+  }
+  uint32_t offset = field_info.GetFieldOffset().Uint32Value();
+  uint32_t next_offset = next_field_info.GetFieldOffset().Uint32Value();
+  uint32_t low_offset = std::min(offset, next_offset);
+  if (std::max(offset, next_offset) - low_offset != size ||
+      !IsAlignedParam(low_offset, size) ||
+      !IsUint<6>(low_offset / size)) {
+    // Not adjacent, or not encodable in the scaled 7-bit signed immediate of a pair.
+    return nullptr;
+  }
+  // A pending implicit null check is recorded for the pair by `instruction`, both halves
+  // fault at the same PC. `next` never needs its own as it directly follows `instruction`.
+  return next;
+}
+
+bool InstructionCodeGeneratorARM64::TryGenerateFieldGetPair(HInstruction* instruction,
+                                                            const FieldInfo& field_info) {
+  if (kEmitCompilerReadBarrier && field_info.GetFieldType() == Primitive::kPrimNot) {
+    return false;
+  }
+  HInstruction* next = GetPairableFieldAccess(instruction, field_info);
+  if (next == nullptr) {
+    return false;
+  }
+  CPURegister out = OutputCPURegister(instruction);
+  CPURegister next_out = OutputCPURegister(next);
+  // LDP is unpredictable if both destinations are the same register.
+  if (!out.IsSameSizeAndType(next_out) || out.Is(next_out)) {
+    return false;
+  }
+  uint32_t offset = field_info.GetFieldOffset().Uint32Value();
+  uint32_t next_offset = FieldAccessInfo(next).GetFieldOffset().Uint32Value();
+  Register base = InputRegisterAt(instruction, 0);
+  {
+    // Ensure that between load and MaybeRecordImplicitNullCheck there are no pools emitted.
+    EmissionCheckScope guard(GetVIXLAssembler(), kMaxMacroInstructionSizeInBytes);
+    if (offset < next_offset) {
+      __ Ldp(out, next_out, HeapOperand(base, offset));
+    } else {
+      __ Ldp(next_out, out, HeapOperand(base, next_offset));
+    }
+    codegen_->MaybeRecordImplicitNullCheck(instruction);
+  }
+  if (field_info.GetFieldType() == Primitive::kPrimNot) {
+    GetAssembler()->MaybeUnpoisonHeapReference(Register(out));
+  }
+  if (FieldAccessInfo(next).GetFieldType() == Primitive::kPrimNot) {
+    GetAssembler()->MaybeUnpoisonHeapReference(Register(next_out));
+  }
+  paired_field_access_ = next;
+  return true;
+}
+
+bool InstructionCodeGeneratorARM64::TryGenerateFieldSetPair(HInstruction* instruction,
+                                                            const FieldInfo& field_info,
+                                                            bool value_can_be_null) {
+  HInstruction* next = GetPairableFieldAccess(instruction, field_info);
+  if (next == nullptr) {
+    return false;
+  }
+  Primitive::Type field_type = field_info.GetFieldType();
+  Primitive::Type next_field_type = FieldAccessInfo(next).GetFieldType();
+  if (kPoisonHeapReferences &&
+      (field_type == Primitive::kPrimNot || next_field_type == Primitive::kPrimNot)) {
+    return false;
+  }
+  CPURegister value = InputCPURegisterOrZeroRegAt(instruction, 1);
+  CPURegister next_value = InputCPURegisterOrZeroRegAt(next, 1);
+  if (!value.IsSameSizeAndType(next_value)) {
+    return false;
+  }
+  uint32_t offset = field_info.GetFieldOffset().Uint32Value();
+  uint32_t next_offset = FieldAccessInfo(next).GetFieldOffset().Uint32Value();
+  Register obj = InputRegisterAt(instruction, 0);
+  {
+    // Ensure that between store and MaybeRecordImplicitNullCheck there are no pools emitted.
+    EmissionCheckScope guard(GetVIXLAssembler(), kMaxMacroInstructionSizeInBytes);
+    if (offset < next_offset) {
+      __ Stp(value, next_value, HeapOperand(obj, offset));
+    } else {
+      __ Stp(next_value, value, HeapOperand(obj, next_offset));
+    }
+    codegen_->MaybeRecordImplicitNullCheck(instruction);
+  }
+  if (CodeGenerator::StoreNeedsWriteBarrier(field_type, instruction->InputAt(1))) {
+    codegen_->MarkGCCard(obj, Register(value), value_can_be_null);
+  }
+  if (CodeGenerator::StoreNeedsWriteBarrier(next_field_type, next->InputAt(1))) {
+    codegen_->MarkGCCard(obj, Register(next_value), FieldSetValueCanBeNull(next));
+  }
+  paired_field_access_ = next;
+  return true;
+}
+
 void InstructionCodeGeneratorARM64::HandleBinaryOp(HBinaryOperation* instr) {
   Primitive::Type type = instr->GetType();
 
@@ -5068,6 +5250,9 @@ void LocationsBuilderARM64::VisitLoadString(HLoadString* load) {
 void InstructionCodeGeneratorARM64::VisitLoadString(HLoadString* load) NO_THREAD_SAFETY_ANALYSIS {
   Register out = OutputRegister(load);
   Location out_loc = load->GetLocations()->Out();
+  const ReadBarrierOption read_barrier_option = load->IsInBootImage()
+      ? kWithoutReadBarrier
+      : kCompilerReadBarrierOption;
 
   switch (load->GetLoadKind()) {
     case HLoadString::LoadKind::kBootImageLinkTimePcRelative: {
@@ -5107,7 +5292,7 @@ void InstructionCodeGeneratorARM64::VisitLoadString(HLoadString* load) NO_THREAD
                               temp,
                               /* offset placeholder */ 0u,
                               ldr_label,
-                              kCompilerReadBarrierOption);
+                              read_barrier_option);
       SlowPathCodeARM64* slow_path =
           new (GetGraph()->GetArena()) LoadStringSlowPathARM64(load, temp, adrp_label);
       codegen_->AddSlowPath(slow_path);
@@ -5124,7 +5309,7 @@ void InstructionCodeGeneratorARM64::VisitLoadString(HLoadString* load) NO_THREAD
                               out.X(),
                               /* offset */ 0,
                               /* fixup_label */ nullptr,
-                              kCompilerReadBarrierOption);
+                              read_barrier_option);
       return;
     }
     default:
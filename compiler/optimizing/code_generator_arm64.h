@@ -265,6 +265,7 @@ class InstructionCodeGeneratorARM64 : public InstructionCodeGenerator {
   void GenerateClassInitializationCheck(SlowPathCodeARM64* slow_path,
                                         vixl::aarch64::Register class_reg);
   void GenerateSuspendCheck(HSuspendCheck* instruction, HBasicBlock* successor);
+  void GenerateImplicitSuspendCheck(HSuspendCheck* instruction, HBasicBlock* successor);
   void HandleBinaryOp(HBinaryOperation* instr);
 
   void HandleFieldSet(HInstruction* instruction,
@@ -273,6 +274,16 @@ class InstructionCodeGeneratorARM64 : public InstructionCodeGenerator {
   void HandleFieldGet(HInstruction* instruction, const FieldInfo& field_info);
   void HandleCondition(HCondition* instruction);
 
+  // Return the field access directly following `instruction` if both access adjacent
+  // fields of the same object and can be emitted as a single LDP or STP, null otherwise.
+  HInstruction* GetPairableFieldAccess(HInstruction* instruction, const FieldInfo& field_info);
+  // Try to emit the field get `instruction` together with the following one as an LDP.
+  bool TryGenerateFieldGetPair(HInstruction* instruction, const FieldInfo& field_info);
+  // Try to emit the field set `instruction` together with the following one as an STP.
+  bool TryGenerateFieldSetPair(HInstruction* instruction,
+                               const FieldInfo& field_info,
+                               bool value_can_be_null);
+
   // Generate a heap reference load using one register `out`:
   //
   //   out <- *(out + offset)
@@ -340,6 +351,9 @@ class InstructionCodeGeneratorARM64 : public InstructionCodeGenerator {
   Arm64Assembler* const assembler_;
   CodeGeneratorARM64* const codegen_;
 
+  // The field access that was already emitted as the second half of a load/store pair.
+  HInstruction* paired_field_access_;
+
   DISALLOW_COPY_AND_ASSIGN(InstructionCodeGeneratorARM64);
 };
 
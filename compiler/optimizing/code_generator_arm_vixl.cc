@@ -7498,6 +7498,9 @@ void InstructionCodeGeneratorARMVIXL::VisitLoadString(HLoadString* load) NO_THRE
   Location out_loc = locations->Out();
   vixl32::Register out = OutputRegister(load);
   HLoadString::LoadKind load_kind = load->GetLoadKind();
+  const ReadBarrierOption read_barrier_option = load->IsInBootImage()
+      ? kWithoutReadBarrier
+      : kCompilerReadBarrierOption;
 
   switch (load_kind) {
     case HLoadString::LoadKind::kBootImageLinkTimePcRelative: {
@@ -7522,7 +7525,7 @@ void InstructionCodeGeneratorARMVIXL::VisitLoadString(HLoadString* load) NO_THRE
       CodeGeneratorARMVIXL::PcRelativePatchInfo* labels =
           codegen_->NewPcRelativeStringPatch(load->GetDexFile(), load->GetStringIndex());
       codegen_->EmitMovwMovtPlaceholder(labels, temp);
-      GenerateGcRootFieldLoad(load, out_loc, temp, /* offset */ 0, kCompilerReadBarrierOption);
+      GenerateGcRootFieldLoad(load, out_loc, temp, /* offset */ 0, read_barrier_option);
       LoadStringSlowPathARMVIXL* slow_path =
           new (GetGraph()->GetArena()) LoadStringSlowPathARMVIXL(load);
       codegen_->AddSlowPath(slow_path);
@@ -7535,7 +7538,7 @@ void InstructionCodeGeneratorARMVIXL::VisitLoadString(HLoadString* load) NO_THRE
                                                         load->GetStringIndex(),
                                                         load->GetString()));
       // /* GcRoot<mirror::String> */ out = *out
-      GenerateGcRootFieldLoad(load, out_loc, out, /* offset */ 0, kCompilerReadBarrierOption);
+      GenerateGcRootFieldLoad(load, out_loc, out, /* offset */ 0, read_barrier_option);
       return;
     }
     default:
@@ -7575,6 +7575,9 @@ void InstructionCodeGeneratorMIPS::VisitLoadString(HLoadString* load) NO_THREAD_
   Register out = out_loc.AsRegister<Register>();
   Register base_or_current_method_reg;
   bool isR6 = codegen_->GetInstructionSetFeatures().IsR6();
+  const ReadBarrierOption read_barrier_option = load->IsInBootImage()
+      ? kWithoutReadBarrier
+      : kCompilerReadBarrierOption;
   switch (load_kind) {
     // We need an extra register for PC-relative literals on R2.
     case HLoadString::LoadKind::kBootImageAddress:
@@ -7629,7 +7632,7 @@ void InstructionCodeGeneratorMIPS::VisitLoadString(HLoadString* load) NO_THREAD_
                               out_loc,
                               temp,
                               /* placeholder */ 0x5678,
-                              kCompilerReadBarrierOption);
+                              read_barrier_option);
       __ SetReorder(reordering);
       SlowPathCodeMIPS* slow_path =
           new (GetGraph()->GetArena()) LoadStringSlowPathMIPS(load, info_high);
@@ -7650,7 +7653,7 @@ void InstructionCodeGeneratorMIPS::VisitLoadString(HLoadString* load) NO_THREAD_
                               out_loc,
                               out,
                               /* placeholder */ 0x5678,
-                              kCompilerReadBarrierOption);
+                              read_barrier_option);
       __ SetReorder(reordering);
       return;
     }
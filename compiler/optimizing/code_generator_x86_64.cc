@@ -5196,6 +5196,11 @@ void InstructionCodeGeneratorX86_64::VisitSuspendCheck(HSuspendCheck* instructio
 
 void InstructionCodeGeneratorX86_64::GenerateSuspendCheck(HSuspendCheck* instruction,
                                                           HBasicBlock* successor) {
+  // The runtime only saves the lower half of the SIMD registers, the slow path spills them.
+  if (codegen_->GetCompilerOptions().GetImplicitSuspendChecks() && !GetGraph()->HasSIMD()) {
+    GenerateImplicitSuspendCheck(instruction, successor);
+    return;
+  }
   SuspendCheckSlowPathX86_64* slow_path =
       down_cast<SuspendCheckSlowPathX86_64*>(instruction->GetSlowPath());
   if (slow_path == nullptr) {
@@ -5222,6 +5227,25 @@ void InstructionCodeGeneratorX86_64::GenerateSuspendCheck(HSuspendCheck* instruc
   }
 }
 
+void InstructionCodeGeneratorX86_64::GenerateImplicitSuspendCheck(HSuspendCheck* instruction,
+                                                                  HBasicBlock* successor) {
+  if (successor != nullptr) {
+    DCHECK(successor->IsLoopHeader());
+    codegen_->ClearSpillSlotsFromLoopPhisInStackMap(instruction);
+  }
+  // The suspend trigger is null while a suspension or checkpoint is requested, making the
+  // test fault. SuspensionHandler in fault_handler_x86.cc matches this exact sequence and
+  // calls art_quick_test_suspend, which returns after the faulting test.
+  __ gs()->movq(CpuRegister(TMP),
+                Address::Absolute(Thread::ThreadSuspendTriggerOffset<kX86_64PointerSize>(),
+                                  /* no_rip */ true));
+  __ testl(CpuRegister(TMP), Address(CpuRegister(TMP), 0));
+  codegen_->RecordPcInfo(instruction, instruction->GetDexPc());
+  if (successor != nullptr) {
+    __ jmp(codegen_->GetLabelOf(successor));
+  }
+}
+
 X86_64Assembler* ParallelMoveResolverX86_64::GetAssembler() const {
   return codegen_->GetAssembler();
 }
@@ -5672,6 +5696,9 @@ void InstructionCodeGeneratorX86_64::VisitLoadString(HLoadString* load) NO_THREA
   LocationSummary* locations = load->GetLocations();
   Location out_loc = locations->Out();
   CpuRegister out = out_loc.AsRegister<CpuRegister>();
+  const ReadBarrierOption read_barrier_option = load->IsInBootImage()
+      ? kWithoutReadBarrier
+      : kCompilerReadBarrierOption;
 
   switch (load->GetLoadKind()) {
     case HLoadString::LoadKind::kBootImageLinkTimePcRelative: {
@@ -5692,7 +5719,7 @@ void InstructionCodeGeneratorX86_64::VisitLoadString(HLoadString* load) NO_THREA
                                           /* no_rip */ false);
       Label* fixup_label = codegen_->NewStringBssEntryPatch(load);
       // /* GcRoot<mirror::Class> */ out = *address  /* PC-relative */
-      GenerateGcRootFieldLoad(load, out_loc, address, fixup_label, kCompilerReadBarrierOption);
+      GenerateGcRootFieldLoad(load, out_loc, address, fixup_label, read_barrier_option);
       SlowPathCode* slow_path = new (GetGraph()->GetArena()) LoadStringSlowPathX86_64(load);
       codegen_->AddSlowPath(slow_path);
       __ testl(out, out);
@@ -5706,7 +5733,7 @@ void InstructionCodeGeneratorX86_64::VisitLoadString(HLoadString* load) NO_THREA
       Label* fixup_label = codegen_->NewJitRootStringPatch(
           load->GetDexFile(), load->GetStringIndex(), load->GetString());
       // /* GcRoot<mirror::String> */ out = *address
-      GenerateGcRootFieldLoad(load, out_loc, address, fixup_label, kCompilerReadBarrierOption);
+      GenerateGcRootFieldLoad(load, out_loc, address, fixup_label, read_barrier_option);
       return;
     }
     default:
@@ -15,6 +15,7 @@
  */
 
 #include "base/arena_allocator.h"
+#include "base/scoped_arena_allocator.h"
 #include "builder.h"
 #include "gvn.h"
 #include "nodes.h"
@@ -28,8 +29,9 @@ class GVNTest : public CommonCompilerTest {};
 TEST_F(GVNTest, LocalFieldElimination) {
   ArenaPool pool;
   ArenaAllocator allocator(&pool);
+  ArenaStack arena_stack(&pool);
 
-  HGraph* graph = CreateGraph(&allocator);
+  HGraph* graph = CreateGraph(&allocator, &arena_stack);
   HBasicBlock* entry = new (&allocator) HBasicBlock(graph);
   graph->AddBlock(entry);
   graph->SetEntryBlock(entry);
@@ -112,8 +114,9 @@ TEST_F(GVNTest, LocalFieldElimination) {
 TEST_F(GVNTest, GlobalFieldElimination) {
   ArenaPool pool;
   ArenaAllocator allocator(&pool);
+  ArenaStack arena_stack(&pool);
 
-  HGraph* graph = CreateGraph(&allocator);
+  HGraph* graph = CreateGraph(&allocator, &arena_stack);
   HBasicBlock* entry = new (&allocator) HBasicBlock(graph);
   graph->AddBlock(entry);
   graph->SetEntryBlock(entry);
@@ -194,8 +197,9 @@ TEST_F(GVNTest, GlobalFieldElimination) {
 TEST_F(GVNTest, LoopFieldElimination) {
   ArenaPool pool;
   ArenaAllocator allocator(&pool);
+  ArenaStack arena_stack(&pool);
 
-  HGraph* graph = CreateGraph(&allocator);
+  HGraph* graph = CreateGraph(&allocator, &arena_stack);
   HBasicBlock* entry = new (&allocator) HBasicBlock(graph);
   graph->AddBlock(entry);
   graph->SetEntryBlock(entry);
@@ -316,10 +320,11 @@ TEST_F(GVNTest, LoopFieldElimination) {
 TEST_F(GVNTest, LoopSideEffects) {
   ArenaPool pool;
   ArenaAllocator allocator(&pool);
+  ArenaStack arena_stack(&pool);
 
   static const SideEffects kCanTriggerGC = SideEffects::CanTriggerGC();
 
-  HGraph* graph = CreateGraph(&allocator);
+  HGraph* graph = CreateGraph(&allocator, &arena_stack);
   HBasicBlock* entry = new (&allocator) HBasicBlock(graph);
   graph->AddBlock(entry);
   graph->SetEntryBlock(entry);
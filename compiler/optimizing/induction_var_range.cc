@@ -306,6 +306,59 @@ HInstruction* InductionVarRange::GenerateTakenTest(HInstruction* context,
   return taken_test;
 }
 
+bool InductionVarRange::CanGenerateStridedRange(HInstruction* context,
+                                                HInstruction* instruction,
+                                                /*out*/bool* needs_taken_test) {
+  HLoopInformation* loop = nullptr;
+  HInductionVarAnalysis::InductionInfo* info = nullptr;
+  HInductionVarAnalysis::InductionInfo* trip = nullptr;
+  if (!HasInductionInfo(context, instruction, &loop, &info, &trip) ||
+      trip == nullptr ||
+      context->GetBlock() == loop->GetHeader() ||  // the header also sees the exit value
+      info->induction_class != HInductionVarAnalysis::kLinear) {
+    return false;
+  }
+  // Only accept inductions with the stride of the loop control (e.g. i + c, but not 2 * i in
+  // a unit stride loop), since those cannot wrap around inside a loop that passed the tests.
+  int64_t stride_value = 0;
+  int64_t trip_stride_value = 0;
+  if (!IsConstant(info->op_a, kExact, &stride_value) ||
+      !IsStridedTripCount(trip, &trip_stride_value) ||
+      stride_value != trip_stride_value) {
+    return false;
+  }
+  bool is_last_value = false;
+  bool needs_finite_test = false;  // subsumed by the stride tests
+  return GenerateRangeOrLastValue(context,
+                                  instruction,
+                                  is_last_value,
+                                  nullptr,
+                                  nullptr,
+                                  nullptr,
+                                  nullptr,
+                                  nullptr,  // nothing generated yet
+                                  &stride_value,
+                                  &needs_finite_test,
+                                  needs_taken_test)
+      && GenerateStrideTestsOrCheck(trip, trip_stride_value, nullptr, nullptr, nullptr, nullptr);
+}
+
+void InductionVarRange::GenerateStrideTests(HInstruction* context,
+                                            HGraph* graph,
+                                            HBasicBlock* block,
+                                            /*out*/HInstruction** finite_test,
+                                            /*out*/HInstruction** wrap_test) {
+  HLoopInformation* loop = context->GetBlock()->GetLoopInformation();  // closest enveloping loop
+  HInductionVarAnalysis::InductionInfo* trip =
+      induction_analysis_->LookupInfo(loop, GetLoopControl(loop));
+  int64_t stride_value = 0;
+  if (trip == nullptr ||
+      !IsStridedTripCount(trip, &stride_value) ||
+      !GenerateStrideTestsOrCheck(trip, stride_value, graph, block, finite_test, wrap_test)) {
+    LOG(FATAL) << "Failed precondition: CanGenerateStridedRange()";
+  }
+}
+
 bool InductionVarRange::CanGenerateLastValue(HInstruction* instruction) {
   bool is_last_value = true;
   int64_t stride_value = 0;
@@ -537,6 +590,28 @@ bool InductionVarRange::IsUnsafeTripCount(HInductionVarAnalysis::InductionInfo*
   return false;
 }
 
+bool InductionVarRange::IsStridedTripCount(HInductionVarAnalysis::InductionInfo* trip,
+                                           /*out*/ int64_t* stride_value) const {
+  // Non-unit stride trip-counts have the form (U' + S - L) / S with taken-test L op U,
+  // see HInductionVarAnalysis::VisitTripCount().
+  if (trip->type == Primitive::kPrimInt &&
+      trip->op_a->operation == HInductionVarAnalysis::kDiv &&
+      IsConstant(trip->op_a->op_b, kExact, stride_value) &&
+      *stride_value != -1 && *stride_value != 0 && *stride_value != 1) {
+    switch (trip->op_b->operation) {
+      case HInductionVarAnalysis::kLT:
+      case HInductionVarAnalysis::kLE:
+        return *stride_value > 0;
+      case HInductionVarAnalysis::kGT:
+      case HInductionVarAnalysis::kGE:
+        return *stride_value < 0;
+      default:
+        break;
+    }
+  }
+  return false;
+}
+
 InductionVarRange::Value InductionVarRange::GetLinear(HInductionVarAnalysis::InductionInfo* info,
                                                       HInductionVarAnalysis::InductionInfo* trip,
                                                       bool in_body,
@@ -1200,6 +1275,80 @@ bool InductionVarRange::GenerateLastValuePeriodic(HInductionVarAnalysis::Inducti
   return false;
 }
 
+bool InductionVarRange::GenerateStrideTestsOrCheck(HInductionVarAnalysis::InductionInfo* trip,
+                                                   int64_t stride_value,
+                                                   HGraph* graph,
+                                                   HBasicBlock* block,
+                                                   /*out*/HInstruction** finite_test,
+                                                   /*out*/HInstruction** wrap_test) const {
+  // In the loop-body, the taken-test L op U holds. With the inclusive bound U' (U - 1 for
+  // i < U, U + 1 for i > U, U otherwise), the trip-count is valid if the loop is finite,
+  //   S > 0: U' <= MAX - S,      viz. the value after the last one does not wrap around,
+  //   S < 0: U' >= MIN - S,
+  // and the dividend of the trip-count expression does not wrap around,
+  //   S > 0: U' - L <= MAX - S,  (unsigned)
+  //   S < 0: L - U' <= MAX + S + 1.
+  HInductionVarAnalysis::InductionInfo* taken = trip->op_b;
+  HInductionVarAnalysis::InductionInfo* lower_expr = taken->op_a;
+  HInductionVarAnalysis::InductionInfo* upper_expr = taken->op_b;
+  const bool is_ascending = stride_value > 0;
+  int32_t adjust = 0;
+  if (taken->operation == HInductionVarAnalysis::kLT) {
+    adjust = -1;
+  } else if (taken->operation == HInductionVarAnalysis::kGT) {
+    adjust = 1;
+  }
+  const int64_t max = std::numeric_limits<int32_t>::max();
+  const int64_t min = std::numeric_limits<int32_t>::min();
+  const int64_t finite_limit = is_ascending ? max - stride_value : min - stride_value;
+  const int64_t wrap_limit = is_ascending ? max - stride_value : max + stride_value + 1;
+  // Finiteness is known if induction analysis found a safe trip-count. The dividend cannot
+  // wrap around for a finite loop if L >= 0 (ascending) or L < 0 (descending), or if it is
+  // known at compile-time.
+  const bool needs_finite_test = IsUnsafeTripCount(trip);
+  int64_t l_value = 0;
+  int64_t u_value = 0;
+  bool needs_wrap_test = true;
+  if (is_ascending) {
+    if (IsConstant(lower_expr, kAtLeast, &l_value)) {
+      needs_wrap_test = l_value < 0 &&
+          !(IsConstant(upper_expr, kAtMost, &u_value) && u_value + adjust - l_value <= wrap_limit);
+    }
+  } else if (IsConstant(lower_expr, kAtMost, &l_value)) {
+    needs_wrap_test = l_value >= 0 &&
+        !(IsConstant(upper_expr, kAtLeast, &u_value) && l_value - u_value - adjust <= wrap_limit);
+  }
+  HInstruction* lower = nullptr;
+  HInstruction* upper = nullptr;
+  if (!GenerateCode(upper_expr, nullptr, graph, block, &upper, /* in_body */ false, false) ||
+      (needs_wrap_test &&
+       !GenerateCode(lower_expr, nullptr, graph, block, &lower, /* in_body */ false, false))) {
+    return false;
+  }
+  if (graph != nullptr) {
+    if (adjust != 0) {
+      upper = Insert(block, new (graph->GetArena()) HAdd(
+          Primitive::kPrimInt, upper, graph->GetIntConstant(adjust)));
+    }
+    *finite_test = nullptr;
+    if (needs_finite_test) {
+      HInstruction* limit = graph->GetIntConstant(static_cast<int32_t>(finite_limit));
+      *finite_test = is_ascending
+          ? static_cast<HInstruction*>(new (graph->GetArena()) HGreaterThan(upper, limit))
+          : static_cast<HInstruction*>(new (graph->GetArena()) HLessThan(upper, limit));
+    }
+    *wrap_test = nullptr;
+    if (needs_wrap_test) {
+      HInstruction* diff = Insert(block, is_ascending
+          ? new (graph->GetArena()) HSub(Primitive::kPrimInt, upper, lower)
+          : new (graph->GetArena()) HSub(Primitive::kPrimInt, lower, upper));
+      *wrap_test = new (graph->GetArena()) HAbove(
+          diff, graph->GetIntConstant(static_cast<int32_t>(wrap_limit)));
+    }
+  }
+  return true;
+}
+
 bool InductionVarRange::GenerateCode(HInductionVarAnalysis::InductionInfo* info,
                                      HInductionVarAnalysis::InductionInfo* trip,
                                      HGraph* graph,  // when set, code is generated
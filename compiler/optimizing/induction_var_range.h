@@ -112,6 +112,33 @@ class InductionVarRange {
    */
   HInstruction* GenerateTakenTest(HInstruction* context, HGraph* graph, HBasicBlock* block);
 
+  /**
+   * Returns true if range analysis is able to generate code for the lower and upper bound
+   * expressions on an induction with a non-unit stride in the loop-body proper of the given
+   * context, for example on i and i + 1 in for (int i = 0; i < n; i += 2). Only inductions
+   * that advance with the stride of the loop control are accepted, so that every value lies
+   * within the generated bounds. The need_taken_test flag denotes if an additional taken-test
+   * is needed. The range evaluation must always be protected by GenerateStrideTests().
+   */
+  bool CanGenerateStridedRange(HInstruction* context,
+                               HInstruction* instruction,
+                               /*out*/ bool* needs_taken_test);
+
+  /**
+   * Generates code for the tests that must both be false for the trip-count of the loop in the
+   * given context to be valid despite its non-unit stride: a finite-test, for a loop that may
+   * be infinite, and a wrap-test, for a trip-count expression that may wrap around. Operands
+   * are generated in given block and graph, the returned conditions are not inserted yet.
+   * An output is set to nullptr if that test is known to be false at compile-time.
+   *
+   * Precondition: CanGenerateStridedRange() returns true.
+   */
+  void GenerateStrideTests(HInstruction* context,
+                           HGraph* graph,
+                           HBasicBlock* block,
+                           /*out*/ HInstruction** finite_test,
+                           /*out*/ HInstruction** wrap_test);
+
   /**
    * Returns true if induction analysis is able to generate code for last value of
    * the given instruction inside the closest enveloping loop.
@@ -204,6 +231,8 @@ class InductionVarRange {
   bool IsBodyTripCount(HInductionVarAnalysis::InductionInfo* trip) const;
   bool IsUnsafeTripCount(HInductionVarAnalysis::InductionInfo* trip) const;
   bool IsWellBehavedTripCount(HInductionVarAnalysis::InductionInfo* trip) const;
+  bool IsStridedTripCount(HInductionVarAnalysis::InductionInfo* trip,
+                          /*out*/ int64_t* stride_value) const;
 
   Value GetLinear(HInductionVarAnalysis::InductionInfo* info,
                   HInductionVarAnalysis::InductionInfo* trip,
@@ -299,6 +328,13 @@ class InductionVarRange {
                                  /*out*/HInstruction** result,
                                  /*out*/ bool* needs_taken_test) const;
 
+  bool GenerateStrideTestsOrCheck(HInductionVarAnalysis::InductionInfo* trip,
+                                  int64_t stride_value,
+                                  HGraph* graph,
+                                  HBasicBlock* block,
+                                  /*out*/ HInstruction** finite_test,
+                                  /*out*/ HInstruction** wrap_test) const;
+
   bool GenerateCode(HInductionVarAnalysis::InductionInfo* info,
                     HInductionVarAnalysis::InductionInfo* trip,
                     HGraph* graph,
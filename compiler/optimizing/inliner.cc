@@ -16,6 +16,7 @@
 
 #include "inliner.h"
 
+#include "art_field-inl.h"
 #include "art_method-inl.h"
 #include "base/enums.h"
 #include "builder.h"
@@ -25,6 +26,7 @@
 #include "dex/inline_method_analyser.h"
 #include "dex/verified_method.h"
 #include "dex/verification_results.h"
+#include "driver/compiled_method_cache.h"
 #include "driver/compiler_driver-inl.h"
 #include "driver/compiler_options.h"
 #include "driver/dex_compilation_unit.h"
@@ -34,6 +36,8 @@
 #include "jit/jit_code_cache.h"
 #include "mirror/class_loader.h"
 #include "mirror/dex_cache.h"
+#include "mirror/method_handle_impl-inl.h"
+#include "mirror/method_type.h"
 #include "nodes.h"
 #include "optimizing_compiler.h"
 #include "reference_type_propagation.h"
@@ -62,6 +66,13 @@ static constexpr size_t kMaximumNumberOfCumulatedDexRegisters = 32;
 // much inlining compared to code locality.
 static constexpr size_t kMaximumNumberOfRecursiveCalls = 4;
 
+// Factor by which the code item limit is raised for call sites that are hot in the profile.
+static constexpr size_t kHotCallSiteCodeUnitsFactor = 2;
+
+// Maximum code item size of a method inlined at a call site that is cold in the profile.
+// Inlining such trivial methods (getters, setters, etc.) does not increase code size.
+static constexpr size_t kMaximumCodeUnitsForColdCallSite = 4;
+
 // Controls the use of inline caches in AOT mode.
 static constexpr bool kUseAOTInlineCaches = true;
 
@@ -392,13 +403,15 @@ ArtMethod* HInliner::TryCHADevirtualization(ArtMethod* resolved_method) {
 }
 
 bool HInliner::TryInline(HInvoke* invoke_instruction) {
-  if (invoke_instruction->IsInvokeUnresolved() ||
-      invoke_instruction->IsInvokePolymorphic()) {
-    return false;  // Don't bother to move further if we know the method is unresolved or an
-                   // invoke-polymorphic.
+  if (invoke_instruction->IsInvokeUnresolved()) {
+    return false;  // Don't bother to move further if we know the method is unresolved.
   }
 
   ScopedObjectAccess soa(Thread::Current());
+  if (invoke_instruction->IsInvokePolymorphic()) {
+    return TryInlineMethodHandleInvoke(invoke_instruction->AsInvokePolymorphic());
+  }
+
   uint32_t method_index = invoke_instruction->GetDexMethodIndex();
   const DexFile& caller_dex_file = *caller_compilation_unit_.GetDexFile();
   LOG_TRY() << caller_dex_file.PrettyMethod(method_index);
@@ -453,6 +466,289 @@ bool HInliner::TryInline(HInvoke* invoke_instruction) {
   return TryInlineFromInlineCache(caller_dex_file, invoke_instruction, resolved_method);
 }
 
+// Returns whether a value of type `from` can be passed as a value of type `to` without a runtime
+// check. Exact invokes need the same type, other invokes also allow widening conversions.
+static bool IsMethodHandleConversionStatic(ObjPtr<mirror::Class> from,
+                                           ObjPtr<mirror::Class> to,
+                                           bool is_exact)
+    REQUIRES_SHARED(Locks::mutator_lock_) {
+  if (from == to) {
+    return true;
+  } else if (is_exact) {
+    return false;
+  } else if (!from->IsPrimitive() && !to->IsPrimitive()) {
+    return to->IsAssignableFrom(from);
+  } else {
+    return from->IsPrimitive() &&
+           to->IsPrimitive() &&
+           Primitive::IsWidenable(from->GetPrimitiveType(), to->GetPrimitiveType());
+  }
+}
+
+bool HInliner::TryInlineMethodHandleInvoke(HInvokePolymorphic* invoke_instruction) {
+  // The method handle is known when it is read from a static final field of an initialized
+  // class, final fields cannot be set through reflection. Only the JIT can look at the value.
+  if (!Runtime::Current()->UseJitCompilation()) {
+    return false;
+  }
+  HInstruction* handle_null_check = invoke_instruction->InputAt(0);
+  HInstruction* handle_value = handle_null_check->IsNullCheck()
+      ? handle_null_check->InputAt(0)
+      : handle_null_check;
+  if (!handle_value->IsStaticFieldGet()) {
+    return false;
+  }
+  ArtField* handle_field = handle_value->AsStaticFieldGet()->GetFieldInfo().GetField();
+  if (handle_field == nullptr ||
+      !handle_field->IsFinal() ||
+      !handle_field->GetDeclaringClass()->IsInitialized()) {
+    return false;
+  }
+  ObjPtr<mirror::Object> value = handle_field->GetObject(handle_field->GetDeclaringClass());
+  if (value == nullptr || !value->InstanceOf(mirror::MethodHandle::StaticClass())) {
+    return false;
+  }
+  ObjPtr<mirror::MethodHandle> method_handle = ObjPtr<mirror::MethodHandle>::DownCast(value);
+  if (method_handle->GetNominalType() != nullptr) {
+    // The handle was adapted with asType(), leave the conversions to the runtime.
+    return false;
+  }
+
+  mirror::MethodHandle::Kind kind = method_handle->GetHandleKind();
+  ArtMethod* target_method = nullptr;
+  ArtField* target_field = nullptr;
+  switch (kind) {
+    case mirror::MethodHandle::kInvokeStatic:
+    case mirror::MethodHandle::kInvokeDirect:
+      target_method = method_handle->GetTargetMethod();
+      // Static methods of classes not initialized yet need a class initialization check, and
+      // String constructors are replaced with StringFactory methods by the runtime.
+      if (!target_method->GetDeclaringClass()->IsInitialized() ||
+          target_method->IsConstructor()) {
+        return false;
+      }
+      break;
+    case mirror::MethodHandle::kInvokeVirtual:
+      target_method = method_handle->GetTargetMethod();
+      if (target_method->GetDeclaringClass()->IsInterface()) {
+        return false;
+      }
+      break;
+    case mirror::MethodHandle::kInstanceGet:
+    case mirror::MethodHandle::kInstancePut:
+      target_field = method_handle->GetTargetField();
+      break;
+    default:
+      // Super and interface calls, transformers and static field accesses go to the runtime.
+      return false;
+  }
+
+  // Check the type of the call site against the type of the handle.
+  const DexFile& caller_dex_file = *caller_compilation_unit_.GetDexFile();
+  const DexFile::MethodId& method_id =
+      caller_dex_file.GetMethodId(invoke_instruction->GetDexMethodIndex());
+  bool is_exact = strcmp(caller_dex_file.GetMethodName(method_id), "invokeExact") == 0;
+  const DexFile::ProtoId& proto_id =
+      caller_dex_file.GetProtoId(invoke_instruction->GetProtoIndex());
+  const DexFile::TypeList* parameters = caller_dex_file.GetProtoParameters(proto_id);
+  size_t number_of_parameters = (parameters == nullptr) ? 0u : parameters->Size();
+  ObjPtr<mirror::MethodType> handle_type = method_handle->GetMethodType();
+  ObjPtr<mirror::ObjectArray<mirror::Class>> handle_ptypes = handle_type->GetPTypes();
+  if (number_of_parameters != static_cast<size_t>(handle_ptypes->GetLength())) {
+    return false;
+  }
+  ClassLinker* class_linker = caller_compilation_unit_.GetClassLinker();
+  for (size_t i = 0; i != number_of_parameters; ++i) {
+    ObjPtr<mirror::Class> ptype = class_linker->LookupResolvedType(
+        caller_dex_file,
+        parameters->GetTypeItem(i).type_idx_,
+        caller_compilation_unit_.GetDexCache().Get(),
+        caller_compilation_unit_.GetClassLoader().Get());
+    if (ptype == nullptr ||
+        !IsMethodHandleConversionStatic(ptype, handle_ptypes->Get(i), is_exact)) {
+      return false;
+    }
+  }
+  ObjPtr<mirror::Class> rtype = class_linker->LookupResolvedType(
+      caller_dex_file,
+      proto_id.return_type_idx_,
+      caller_compilation_unit_.GetDexCache().Get(),
+      caller_compilation_unit_.GetClassLoader().Get());
+  ObjPtr<mirror::Class> handle_rtype = handle_type->GetRType();
+  if (rtype == nullptr) {
+    return false;
+  }
+  // A non-exact call site may drop the result. Otherwise the result must not need a conversion,
+  // so that the value is also right for the interpreter if the target deoptimizes.
+  if (is_exact || rtype->GetPrimitiveType() != Primitive::kPrimVoid) {
+    if (!IsMethodHandleConversionStatic(handle_rtype, rtype, is_exact) ||
+        Primitive::PrimitiveKind(handle_rtype->GetPrimitiveType()) !=
+            Primitive::PrimitiveKind(rtype->GetPrimitiveType())) {
+      return false;
+    }
+  }
+
+  // Convert the arguments to the types of the handle. Only widening to long, float and double
+  // needs code, the other types share their representation.
+  ArenaAllocator* arena = graph_->GetArena();
+  uint32_t dex_pc = invoke_instruction->GetDexPc();
+  ArenaVector<HInstruction*> arguments(arena->Adapter(kArenaAllocMisc));
+  for (size_t i = 0; i != number_of_parameters; ++i) {
+    HInstruction* argument = invoke_instruction->InputAt(i + 1u);
+    Primitive::Type type = handle_ptypes->Get(i)->GetPrimitiveType();
+    if (Primitive::PrimitiveKind(argument->GetType()) != Primitive::PrimitiveKind(type)) {
+      argument = new (arena) HTypeConversion(type, argument, dex_pc);
+      invoke_instruction->GetBlock()->InsertInstructionBefore(argument, invoke_instruction);
+    }
+    arguments.push_back(argument);
+  }
+  HNullCheck* receiver_null_check = nullptr;
+  if (kind != mirror::MethodHandle::kInvokeStatic) {
+    receiver_null_check = new (arena) HNullCheck(arguments[0], dex_pc);
+    invoke_instruction->GetBlock()->InsertInstructionBefore(receiver_null_check,
+                                                            invoke_instruction);
+    receiver_null_check->CopyEnvironmentFrom(invoke_instruction->GetEnvironment());
+    receiver_null_check->SetReferenceTypeInfo(arguments[0]->GetReferenceTypeInfo());
+    arguments[0] = receiver_null_check;
+  }
+
+  HInstruction* replacement = nullptr;
+  if (target_field != nullptr) {
+    HInstruction* access;
+    if (kind == mirror::MethodHandle::kInstanceGet) {
+      access = new (arena) HInstanceFieldGet(
+          arguments[0],
+          target_field,
+          target_field->GetTypeAsPrimitiveType(),
+          target_field->GetOffset(),
+          target_field->IsVolatile(),
+          target_field->GetDexFieldIndex(),
+          target_field->GetDeclaringClass()->GetDexClassDefIndex(),
+          *target_field->GetDexFile(),
+          dex_pc);
+      replacement = access;
+    } else {
+      access = new (arena) HInstanceFieldSet(
+          arguments[0],
+          arguments[1],
+          target_field,
+          target_field->GetTypeAsPrimitiveType(),
+          target_field->GetOffset(),
+          target_field->IsVolatile(),
+          target_field->GetDexFieldIndex(),
+          target_field->GetDeclaringClass()->GetDexClassDefIndex(),
+          *target_field->GetDexFile(),
+          dex_pc);
+    }
+    invoke_instruction->GetBlock()->InsertInstructionBefore(access, invoke_instruction);
+    if (access->GetType() == Primitive::kPrimNot) {
+      Handle<mirror::DexCache> dex_cache = handles_->NewHandle(target_field->GetDexCache().Ptr());
+      ReferenceTypePropagation rtp(graph_,
+                                   outer_compilation_unit_.GetClassLoader(),
+                                   dex_cache,
+                                   handles_,
+                                   /* is_first_run */ false);
+      rtp.Visit(access);
+    }
+  } else {
+    // Without inlining, the call remains and its method index must be one of the caller.
+    uint32_t dex_method_index = IsSameDexFile(*target_method->GetDexFile(), caller_dex_file)
+        ? target_method->GetDexMethodIndex()
+        : DexFile::kDexNoIndex;
+    Primitive::Type return_type = handle_rtype->GetPrimitiveType();
+    HInvoke* new_invoke;
+    if (kind == mirror::MethodHandle::kInvokeVirtual) {
+      new_invoke = new (arena) HInvokeVirtual(arena,
+                                              number_of_parameters,
+                                              return_type,
+                                              dex_pc,
+                                              dex_method_index,
+                                              target_method,
+                                              target_method->GetMethodIndex());
+    } else {
+      // Like HSharpening does for the JIT, use the address of the method.
+      HInvokeStaticOrDirect::DispatchInfo dispatch_info = {
+          HInvokeStaticOrDirect::MethodLoadKind::kDirectAddress,
+          HInvokeStaticOrDirect::CodePtrLocation::kCallArtMethod,
+          reinterpret_cast<uintptr_t>(target_method)
+      };
+      new_invoke = new (arena) HInvokeStaticOrDirect(
+          arena,
+          number_of_parameters,
+          return_type,
+          dex_pc,
+          dex_method_index,
+          target_method,
+          dispatch_info,
+          (kind == mirror::MethodHandle::kInvokeStatic) ? kStatic : kDirect,
+          MethodReference(target_method->GetDexFile(), target_method->GetDexMethodIndex()),
+          HInvokeStaticOrDirect::ClinitCheckRequirement::kNone);
+    }
+    for (size_t i = 0; i != number_of_parameters; ++i) {
+      new_invoke->SetArgumentAt(i, arguments[i]);
+    }
+    invoke_instruction->GetBlock()->InsertInstructionBefore(new_invoke, invoke_instruction);
+    new_invoke->CopyEnvironmentFrom(invoke_instruction->GetEnvironment());
+    if (return_type == Primitive::kPrimNot) {
+      new_invoke->SetReferenceTypeInfo(
+          ReferenceTypeInfo::Create(handles_->NewHandle(handle_rtype.Ptr()), /* is_exact */ false));
+    }
+
+    ArtMethod* actual_method = (kind == mirror::MethodHandle::kInvokeVirtual)
+        ? FindVirtualOrInterfaceTarget(new_invoke, target_method)
+        : target_method;
+    bool cha_devirtualize = false;
+    if (actual_method == nullptr) {
+      actual_method = TryCHADevirtualization(target_method);
+      cha_devirtualize = (actual_method != nullptr);
+    }
+    HInstruction* cursor = new_invoke->GetPrevious();
+    HBasicBlock* bb_cursor = new_invoke->GetBlock();
+    HInstruction* return_replacement = nullptr;
+    if (actual_method != nullptr &&
+        TryBuildAndInline(new_invoke,
+                          actual_method,
+                          ReferenceTypeInfo::CreateInvalid(),
+                          &return_replacement)) {
+      if (cha_devirtualize) {
+        AddCHAGuard(new_invoke, dex_pc, cursor, bb_cursor);
+        outermost_graph_->AddCHASingleImplementationDependency(target_method);
+        MaybeRecordStat(kCHAInline);
+      }
+      new_invoke->GetBlock()->RemoveInstruction(new_invoke);
+      FixUpReturnReferenceType(actual_method, return_replacement);
+      replacement = return_replacement;
+    } else if (dex_method_index != DexFile::kDexNoIndex) {
+      replacement = new_invoke;
+    } else {
+      // Leave the invoke-polymorphic alone and remove what was built for the call.
+      new_invoke->GetBlock()->RemoveInstruction(new_invoke);
+      if (receiver_null_check != nullptr) {
+        receiver_null_check->ReplaceWith(receiver_null_check->InputAt(0));
+        receiver_null_check->GetBlock()->RemoveInstruction(receiver_null_check);
+      }
+      for (size_t i = 0; i != number_of_parameters; ++i) {
+        if (arguments[i]->IsTypeConversion() && !arguments[i]->HasUses()) {
+          arguments[i]->GetBlock()->RemoveInstruction(arguments[i]);
+        }
+      }
+      return false;
+    }
+  }
+
+  LOG_SUCCESS() << "Replaced invoke of method handle " << handle_field->PrettyField();
+  MaybeRecordStat(kSpecializedMethodHandleInvoke);
+  if (invoke_instruction->GetType() != Primitive::kPrimVoid) {
+    invoke_instruction->ReplaceWith(replacement);
+  }
+  invoke_instruction->GetBlock()->RemoveInstruction(invoke_instruction);
+  // The handle is not null, its null check can go with the invoke.
+  if (handle_null_check->IsNullCheck() && !handle_null_check->HasUses()) {
+    handle_null_check->GetBlock()->RemoveInstruction(handle_null_check);
+  }
+  return true;
+}
+
 static Handle<mirror::ObjectArray<mirror::Class>> AllocateInlineCacheHolder(
     const DexCompilationUnit& compilation_unit,
     StackHandleScope<1>* hs)
@@ -510,9 +806,23 @@ bool HInliner::TryInlineFromInlineCache(const DexFile& caller_dex_file,
 
   StackHandleScope<1> hs(Thread::Current());
   Handle<mirror::ObjectArray<mirror::Class>> inline_cache;
+  // Only JIT inline caches count the calls of each receiver.
+  uint16_t counts[InlineCache::kIndividualCacheSize] = {};
+  uint16_t megamorphic_count = 0u;
   InlineCacheType inline_cache_type = Runtime::Current()->IsAotCompiler()
       ? GetInlineCacheAOT(caller_dex_file, invoke_instruction, &hs, &inline_cache)
-      : GetInlineCacheJIT(invoke_instruction, &hs, &inline_cache);
+      : GetInlineCacheJIT(invoke_instruction, &hs, &inline_cache, counts, &megamorphic_count);
+  // Without profile data for the call, fall back to the compiled class hierarchy.
+  StackHandleScope<1> closed_world_hs(Thread::Current());
+  if (Runtime::Current()->IsAotCompiler() &&
+      (inline_cache_type == kInlineCacheNoData ||
+       inline_cache_type == kInlineCacheUninitialized)) {
+    InlineCacheType closed_world_type =
+        GetInlineCacheClosedWorld(resolved_method, &closed_world_hs, &inline_cache);
+    if (closed_world_type != kInlineCacheNoData) {
+      inline_cache_type = closed_world_type;
+    }
+  }
 
   switch (inline_cache_type) {
     case kInlineCacheNoData: {
@@ -546,11 +856,16 @@ bool HInliner::TryInlineFromInlineCache(const DexFile& caller_dex_file,
     }
 
     case kInlineCacheMegamorphic: {
+      MaybeRecordStat(kMegamorphicCall);
+      if (!Runtime::Current()->IsAotCompiler() &&
+          TryInlineMegamorphicCall(
+              invoke_instruction, resolved_method, inline_cache, counts, megamorphic_count)) {
+        return true;
+      }
       LOG_FAIL_NO_STAT()
           << "Interface or virtual call to "
           << caller_dex_file.PrettyMethod(invoke_instruction->GetDexMethodIndex())
           << " is megamorphic and not inlined";
-      MaybeRecordStat(kMegamorphicCall);
       return false;
     }
 
@@ -568,7 +883,9 @@ bool HInliner::TryInlineFromInlineCache(const DexFile& caller_dex_file,
 HInliner::InlineCacheType HInliner::GetInlineCacheJIT(
     HInvoke* invoke_instruction,
     StackHandleScope<1>* hs,
-    /*out*/Handle<mirror::ObjectArray<mirror::Class>>* inline_cache)
+    /*out*/Handle<mirror::ObjectArray<mirror::Class>>* inline_cache,
+    /*out*/uint16_t* counts,
+    /*out*/uint16_t* megamorphic_count)
     REQUIRES_SHARED(Locks::mutator_lock_) {
   DCHECK(Runtime::Current()->UseJitCompilation());
 
@@ -589,7 +906,9 @@ HInliner::InlineCacheType HInliner::GetInlineCacheJIT(
   } else {
     Runtime::Current()->GetJit()->GetCodeCache()->CopyInlineCacheInto(
         *profiling_info->GetInlineCache(invoke_instruction->GetDexPc()),
-        *inline_cache);
+        *inline_cache,
+        counts,
+        megamorphic_count);
     return GetInlineCacheType(*inline_cache);
   }
 }
@@ -625,6 +944,49 @@ HInliner::InlineCacheType HInliner::GetInlineCacheAOT(
   }
 }
 
+HInliner::InlineCacheType HInliner::GetInlineCacheClosedWorld(
+    ArtMethod* resolved_method,
+    StackHandleScope<1>* hs,
+    /*out*/Handle<mirror::ObjectArray<mirror::Class>>* inline_cache)
+    REQUIRES_SHARED(Locks::mutator_lock_) {
+  DCHECK(Runtime::Current()->IsAotCompiler());
+  ObjPtr<mirror::Class> declaring_class = resolved_method->GetDeclaringClass();
+  if (declaring_class->IsProxyClass()) {
+    return kInlineCacheNoData;
+  }
+  const std::vector<TypeReference>* subtypes = compiler_driver_->GetClosedWorldSubtypes(
+      TypeReference(&declaring_class->GetDexFile(), declaring_class->GetDexTypeIndex()));
+  if (subtypes == nullptr) {
+    return kInlineCacheNoData;
+  }
+  if (subtypes->size() > InlineCache::kIndividualCacheSize) {
+    return kInlineCacheMegamorphic;
+  }
+
+  *inline_cache = AllocateInlineCacheHolder(caller_compilation_unit_, hs);
+  if (inline_cache->Get() == nullptr) {
+    // We can't extract any data if we failed to allocate;
+    return kInlineCacheNoData;
+  }
+  Thread* self = Thread::Current();
+  ClassLinker* class_linker = caller_compilation_unit_.GetClassLinker();
+  int ic_index = 0;
+  for (const TypeReference& subtype : *subtypes) {
+    ObjPtr<mirror::Class> klass = ClassLinker::LookupResolvedType(
+        subtype.type_index,
+        class_linker->FindDexCache(self, *subtype.dex_file),
+        caller_compilation_unit_.GetClassLoader().Get());
+    if (klass == nullptr) {
+      return kInlineCacheMissingTypes;
+    }
+    (*inline_cache)->Set(ic_index++, klass);
+  }
+  // The classes are only those of the compiled dex files: the call is never devirtualized
+  // without a type guard and a fallback to the original invoke, see
+  // UseOnlyPolymorphicInliningWithNoDeopt().
+  return GetInlineCacheType(*inline_cache);
+}
+
 HInliner::InlineCacheType HInliner::ExtractClassesFromOfflineProfile(
     const HInvoke* invoke_instruction,
     const ProfileCompilationInfo::OfflineProfileMethodInfo& offline_profile,
@@ -908,11 +1270,13 @@ HInstruction* HInliner::AddTypeGuard(HInstruction* receiver,
 
 bool HInliner::TryInlinePolymorphicCall(HInvoke* invoke_instruction,
                                         ArtMethod* resolved_method,
-                                        Handle<mirror::ObjectArray<mirror::Class>> classes) {
+                                        Handle<mirror::ObjectArray<mirror::Class>> classes,
+                                        bool allow_deoptimization) {
   DCHECK(invoke_instruction->IsInvokeVirtual() || invoke_instruction->IsInvokeInterface())
       << invoke_instruction->DebugName();
 
-  if (TryInlinePolymorphicCallToSameTarget(invoke_instruction, resolved_method, classes)) {
+  if (allow_deoptimization &&
+      TryInlinePolymorphicCallToSameTarget(invoke_instruction, resolved_method, classes)) {
     return true;
   }
 
@@ -959,7 +1323,8 @@ bool HInliner::TryInlinePolymorphicCall(HInvoke* invoke_instruction,
 
       // If we have inlined all targets before, and this receiver is the last seen,
       // we deoptimize instead of keeping the original invoke instruction.
-      bool deoptimize = !UseOnlyPolymorphicInliningWithNoDeopt() &&
+      bool deoptimize = allow_deoptimization &&
+          !UseOnlyPolymorphicInliningWithNoDeopt() &&
           all_targets_inlined &&
           (i != InlineCache::kIndividualCacheSize - 1) &&
           (classes->Get(i + 1) == nullptr);
@@ -1005,6 +1370,59 @@ bool HInliner::TryInlinePolymorphicCall(HInvoke* invoke_instruction,
   return true;
 }
 
+bool HInliner::TryInlineMegamorphicCall(HInvoke* invoke_instruction,
+                                        ArtMethod* resolved_method,
+                                        Handle<mirror::ObjectArray<mirror::Class>> classes,
+                                        const uint16_t* counts,
+                                        uint16_t megamorphic_count) {
+  size_t number_of_types = 0;
+  uint32_t total_count = megamorphic_count;
+  for (; number_of_types < InlineCache::kIndividualCacheSize; ++number_of_types) {
+    if (classes->Get(number_of_types) == nullptr) {
+      break;
+    }
+    total_count += counts[number_of_types];
+  }
+
+  // Keep the receivers that take a large enough share of the calls, the most frequent first.
+  std::vector<size_t> dominant;
+  for (size_t i = 0; i < number_of_types; ++i) {
+    if (counts[i] != 0u && counts[i] * 100u >= total_count * kMegamorphicDominantPercent) {
+      dominant.push_back(i);
+    }
+  }
+  if (dominant.empty()) {
+    LOG_FAIL_NO_STAT() << "Megamorphic call to " << ArtMethod::PrettyMethod(resolved_method)
+                       << " has no dominant receiver";
+    return false;
+  }
+  std::sort(dominant.begin(), dominant.end(), [counts](size_t a, size_t b) {
+    return counts[a] > counts[b];
+  });
+
+  StackHandleScope<1> hs(Thread::Current());
+  Handle<mirror::ObjectArray<mirror::Class>> dominant_classes =
+      AllocateInlineCacheHolder(caller_compilation_unit_, &hs);
+  if (dominant_classes == nullptr) {
+    return false;
+  }
+  for (size_t i = 0; i < dominant.size(); ++i) {
+    dominant_classes->Set(i, classes->Get(dominant[i]));
+  }
+
+  // Other receivers go through the original invoke, so don't deoptimize on a guard miss.
+  if (!TryInlinePolymorphicCall(invoke_instruction,
+                                resolved_method,
+                                dominant_classes,
+                                /* allow_deoptimization */ false)) {
+    return false;
+  }
+  LOG_SUCCESS() << "Megamorphic call to " << ArtMethod::PrettyMethod(resolved_method)
+                << " has inlined " << dominant.size() << " dominant receivers";
+  MaybeRecordStat(kInlinedMegamorphicCall);
+  return true;
+}
+
 void HInliner::CreateDiamondPatternForPolymorphicInline(HInstruction* compare,
                                                         HInstruction* return_replacement,
                                                         HInstruction* invoke_instruction) {
@@ -1306,6 +1724,15 @@ bool HInliner::TryBuildAndInline(HInvoke* invoke_instruction,
     return false;
   }
 
+  // Whatever the outcome, the code we generate now depends on the callee's code item.
+  CompiledMethodCache* compiled_method_cache = compiler_driver_->GetCompiledMethodCache();
+  if (compiled_method_cache != nullptr) {
+    compiled_method_cache->RecordDependency(
+        MethodReference(outer_compilation_unit_.GetDexFile(),
+                        outer_compilation_unit_.GetDexMethodIndex()),
+        MethodReference(method->GetDexFile(), method->GetDexMethodIndex()));
+  }
+
   if (CountRecursiveCallsOf(method) > kMaximumNumberOfRecursiveCalls) {
     LOG_FAIL(kNotInlinedRecursiveBudget)
         << "Method "
@@ -1343,6 +1770,16 @@ bool HInliner::TryBuildAndInline(HInvoke* invoke_instruction,
   }
 
   size_t inline_max_code_units = compiler_driver_->GetCompilerOptions().GetInlineMaxCodeUnits();
+  CallSiteHotness hotness = GetCallSiteHotness(method);
+  if (hotness == kCallSiteHot) {
+    inline_max_code_units *= kHotCallSiteCodeUnitsFactor;
+  } else if (hotness == kCallSiteCold &&
+             code_item->insns_size_in_code_units_ > kMaximumCodeUnitsForColdCallSite) {
+    LOG_FAIL(kNotInlinedColdCallSite)
+        << "Method " << method->PrettyMethod()
+        << " is not inlined because the call site is cold in the profile";
+    return false;
+  }
   if (code_item->insns_size_in_code_units_ > inline_max_code_units) {
     LOG_FAIL(kNotInlinedCodeItem)
         << "Method " << method->PrettyMethod()
@@ -1394,9 +1831,38 @@ bool HInliner::TryBuildAndInline(HInvoke* invoke_instruction,
 
   LOG_SUCCESS() << method->PrettyMethod();
   MaybeRecordStat(kInlinedInvoke);
+  if (hotness == kCallSiteHot) {
+    MaybeRecordStat(kInlinedHotCallSite);
+  }
   return true;
 }
 
+HInliner::CallSiteHotness HInliner::GetCallSiteHotness(ArtMethod* method) const {
+  DCHECK(method->GetCodeItem() != nullptr);
+  // Tests compiled against the core image keep the fixed limits, so that the
+  // inlining directives in method names are honored independently of profiles.
+  if (IsCompilingWithCoreImage()) {
+    return kCallSiteUnknown;
+  }
+  if (Runtime::Current()->UseJitCompilation()) {
+    // The JIT only allocates a ProfilingInfo for methods that reached the warm threshold.
+    // Methods without one are not known to be cold, as they may run as AOT code.
+    PointerSize pointer_size = Runtime::Current()->GetClassLinker()->GetImagePointerSize();
+    return method->GetProfilingInfo(pointer_size) != nullptr ? kCallSiteHot : kCallSiteUnknown;
+  }
+  const ProfileCompilationInfo* pci = compiler_driver_->GetProfileCompilationInfo();
+  const DexFile* dex_file = method->GetDexFile();
+  if (pci == nullptr || !pci->ContainsDexFile(*dex_file)) {
+    return kCallSiteUnknown;
+  }
+  ProfileCompilationInfo::MethodHotness hotness =
+      pci->GetMethodHotness(MethodReference(dex_file, method->GetDexMethodIndex()));
+  if (hotness.IsHot()) {
+    return kCallSiteHot;
+  }
+  return hotness.IsInProfile() ? kCallSiteUnknown : kCallSiteCold;
+}
+
 static HInstruction* GetInvokeInputForArgVRegIndex(HInvoke* invoke_instruction,
                                                    size_t arg_vreg_index)
     REQUIRES_SHARED(Locks::mutator_lock_) {
@@ -1642,6 +2108,7 @@ bool HInliner::TryBuildAndInlineHelper(HInvoke* invoke_instruction,
   const int32_t caller_instruction_counter = graph_->GetCurrentInstructionId();
   HGraph* callee_graph = new (graph_->GetArena()) HGraph(
       graph_->GetArena(),
+      graph_->GetArenaStack(),
       callee_dex_file,
       method_index,
       compiler_driver_->GetInstructionSet(),
@@ -73,8 +73,20 @@ class HInliner : public HOptimization {
     kInlineCacheMissingTypes = 5
   };
 
+  enum CallSiteHotness {
+    kCallSiteUnknown,  // no profile information, use the default budget
+    kCallSiteCold,     // the callee has not been executed while profiling
+    kCallSiteHot       // the callee is hot in the JIT or AOT profile
+  };
+
   bool TryInline(HInvoke* invoke_instruction);
 
+  // Try to replace an invoke-polymorphic on a method handle known at compile time with what the
+  // handle does: a call to its target, which may get inlined, or a field access. The arguments
+  // are converted to the type of the handle when that needs no runtime check.
+  bool TryInlineMethodHandleInvoke(HInvokePolymorphic* invoke_instruction)
+    REQUIRES_SHARED(Locks::mutator_lock_);
+
   // Try to inline `resolved_method` in place of `invoke_instruction`. `do_rtp` is whether
   // reference type propagation can run after the inlining. If the inlining is successful, this
   // method will replace and remove the `invoke_instruction`. If `cha_devirtualize` is true,
@@ -131,10 +143,14 @@ class HInliner : public HOptimization {
   // Try getting the inline cache from JIT code cache.
   // Return true if the inline cache was successfully allocated and the
   // invoke info was found in the profile info.
+  // Also return the number of calls seen for each class of the inline cache, and for the
+  // receivers that did not fit in it.
   InlineCacheType GetInlineCacheJIT(
       HInvoke* invoke_instruction,
       StackHandleScope<1>* hs,
-      /*out*/Handle<mirror::ObjectArray<mirror::Class>>* inline_cache)
+      /*out*/Handle<mirror::ObjectArray<mirror::Class>>* inline_cache,
+      /*out*/uint16_t* counts,
+      /*out*/uint16_t* megamorphic_count)
     REQUIRES_SHARED(Locks::mutator_lock_);
 
   // Try getting the inline cache from AOT offline profile.
@@ -146,6 +162,14 @@ class HInliner : public HOptimization {
       /*out*/Handle<mirror::ObjectArray<mirror::Class>>* inline_cache)
     REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Try building the inline cache from the classes of the compiled dex files that can
+  // receive the call, see --closed-world-devirtualization.
+  InlineCacheType GetInlineCacheClosedWorld(
+      ArtMethod* resolved_method,
+      StackHandleScope<1>* hs,
+      /*out*/Handle<mirror::ObjectArray<mirror::Class>>* inline_cache)
+    REQUIRES_SHARED(Locks::mutator_lock_);
+
   // Extract the mirror classes from the offline profile and add them to the `inline_cache`.
   // Note that even if we have profile data for the invoke the inline_cache might contain
   // only null entries if the types cannot be resolved.
@@ -169,12 +193,26 @@ class HInliner : public HOptimization {
                                 Handle<mirror::ObjectArray<mirror::Class>> classes)
     REQUIRES_SHARED(Locks::mutator_lock_);
 
-  // Try to inline targets of a polymorphic call.
+  // Try to inline targets of a polymorphic call. Without `allow_deoptimization`,
+  // receivers of other classes always reach the original invoke.
   bool TryInlinePolymorphicCall(HInvoke* invoke_instruction,
                                 ArtMethod* resolved_method,
-                                Handle<mirror::ObjectArray<mirror::Class>> classes)
+                                Handle<mirror::ObjectArray<mirror::Class>> classes,
+                                bool allow_deoptimization = true)
+    REQUIRES_SHARED(Locks::mutator_lock_);
+
+  // Try to inline the targets of a megamorphic call for the receivers of the inline cache
+  // that got at least kMegamorphicDominantPercent of the calls, each behind a type guard,
+  // with the original invoke as the fallback.
+  bool TryInlineMegamorphicCall(HInvoke* invoke_instruction,
+                                ArtMethod* resolved_method,
+                                Handle<mirror::ObjectArray<mirror::Class>> classes,
+                                const uint16_t* counts,
+                                uint16_t megamorphic_count)
     REQUIRES_SHARED(Locks::mutator_lock_);
 
+  static constexpr uint32_t kMegamorphicDominantPercent = 15;
+
   bool TryInlinePolymorphicCallToSameTarget(HInvoke* invoke_instruction,
                                             ArtMethod* resolved_method,
                                             Handle<mirror::ObjectArray<mirror::Class>> classes)
@@ -269,6 +307,11 @@ class HInliner : public HOptimization {
   // Update the inlining budget based on `total_number_of_instructions_`.
   void UpdateInliningBudget();
 
+  // Classify a call of `method` from the JIT or AOT profile, which records hotness per
+  // method. Hot call sites get a larger code item limit, cold ones only inline trivial methods.
+  CallSiteHotness GetCallSiteHotness(ArtMethod* method) const
+    REQUIRES_SHARED(Locks::mutator_lock_);
+
   // Count the number of calls of `method` being inlined recursively.
   size_t CountRecursiveCallsOf(ArtMethod* method) const;
 
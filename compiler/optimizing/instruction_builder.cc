@@ -22,6 +22,9 @@
 #include "dex_instruction-inl.h"
 #include "driver/compiler_options.h"
 #include "imtable-inl.h"
+#include "jit/jit.h"
+#include "jit/jit_code_cache.h"
+#include "jit/profiling_info.h"
 #include "quicken_info.h"
 #include "sharpening.h"
 #include "scoped_thread_state_change-inl.h"
@@ -283,6 +286,8 @@ bool HInstructionBuilder::Build() {
     FindNativeDebugInfoLocations(native_debug_info_locations);
   }
 
+  FindUncommonBranches();
+
   for (HBasicBlock* block : graph_->GetReversePostOrder()) {
     current_block_ = block;
     uint32_t block_dex_pc = current_block_->GetDexPc();
@@ -393,6 +398,54 @@ void HInstructionBuilder::FindNativeDebugInfoLocations(ArenaBitVector* locations
   }
 }
 
+void HInstructionBuilder::FindUncommonBranches() {
+  // Only the JIT has branch profiles, and only when it collects them.
+  jit::Jit* jit = Runtime::Current()->GetJit();
+  ArtMethod* method = graph_->GetArtMethod();
+  if (jit == nullptr || !jit->ProfileBranches() || method == nullptr) {
+    return;
+  }
+  // A branch is uncommon one way if it was never seen going that way in a reasonable
+  // number of executions.
+  static constexpr uint32_t kMinimumBranchSamples = 100;
+  Thread* self = Thread::Current();
+  ScopedObjectAccess soa(self);
+  ProfilingInfo* info = jit->GetCodeCache()->NotifyCompilerUse(method, self);
+  if (info == nullptr) {
+    return;
+  }
+  const BranchCache* branch_caches = info->GetBranchCaches();
+  for (size_t i = 0; i < info->GetNumberOfBranchCaches(); ++i) {
+    const BranchCache& branch = branch_caches[i];
+    uint32_t taken = branch.GetTakenCount();
+    uint32_t not_taken = branch.GetNotTakenCount();
+    if (taken + not_taken < kMinimumBranchSamples) {
+      continue;
+    }
+    if (taken == 0) {
+      uncommon_branches_.Put(branch.GetDexPc(), /* taken is uncommon */ true);
+    } else if (not_taken == 0) {
+      uncommon_branches_.Put(branch.GetDexPc(), /* taken is uncommon */ false);
+    }
+  }
+  jit->GetCodeCache()->DoneCompilerUse(method, self);
+}
+
+void HInstructionBuilder::BuildIf(HInstruction* condition, uint32_t dex_pc) {
+  HIf* if_instruction = new (arena_) HIf(condition, dex_pc);
+  auto it = uncommon_branches_.find(dex_pc);
+  if (it != uncommon_branches_.end()) {
+    // The true successor is the branch target.
+    if (it->second) {
+      if_instruction->SetTrueSuccessorUncommon();
+    } else {
+      if_instruction->SetFalseSuccessorUncommon();
+    }
+  }
+  AppendInstruction(if_instruction);
+  current_block_ = nullptr;
+}
+
 HInstruction* HInstructionBuilder::LoadLocal(uint32_t reg_number, Primitive::Type type) const {
   HInstruction* value = (*current_locals_)[reg_number];
   DCHECK(value != nullptr);
@@ -498,8 +551,7 @@ void HInstructionBuilder::If_22t(const Instruction& instruction, uint32_t dex_pc
   HInstruction* second = LoadLocal(instruction.VRegB(), Primitive::kPrimInt);
   T* comparison = new (arena_) T(first, second, dex_pc);
   AppendInstruction(comparison);
-  AppendInstruction(new (arena_) HIf(comparison, dex_pc));
-  current_block_ = nullptr;
+  BuildIf(comparison, dex_pc);
 }
 
 template<typename T>
@@ -507,8 +559,7 @@ void HInstructionBuilder::If_21t(const Instruction& instruction, uint32_t dex_pc
   HInstruction* value = LoadLocal(instruction.VRegA(), Primitive::kPrimInt);
   T* comparison = new (arena_) T(value, graph_->GetIntConstant(0, dex_pc), dex_pc);
   AppendInstruction(comparison);
-  AppendInstruction(new (arena_) HIf(comparison, dex_pc));
-  current_block_ = nullptr;
+  BuildIf(comparison, dex_pc);
 }
 
 template<typename T>
@@ -636,6 +687,8 @@ void HInstructionBuilder::BuildSwitch(const Instruction& instruction, uint32_t d
     // Empty Switch. Code falls through to the next block.
     DCHECK(IsFallthroughInstruction(instruction, dex_pc, current_block_));
     AppendInstruction(new (arena_) HGoto(dex_pc));
+  } else if (table.ShouldBuildBinarySearchTree()) {
+    BuildSwitchTree(table, value, dex_pc, 0u, table.GetNumEntries());
   } else if (table.ShouldBuildDecisionTree()) {
     for (DexSwitchTableIterator it(table); !it.Done(); it.Advance()) {
       HInstruction* case_value = graph_->GetIntConstant(it.CurrentKey(), dex_pc);
@@ -655,6 +708,35 @@ void HInstructionBuilder::BuildSwitch(const Instruction& instruction, uint32_t d
   current_block_ = nullptr;
 }
 
+void HInstructionBuilder::BuildSwitchTree(const DexSwitchTable& table,
+                                          HInstruction* value,
+                                          uint32_t dex_pc,
+                                          size_t lo,
+                                          size_t hi) {
+  if (DexSwitchTable::IsBinarySearchLeaf(lo, hi)) {
+    for (size_t i = lo; i < hi; ++i) {
+      if (i != lo) {
+        current_block_ = FindBlockStartingAt(table.GetDexPcForCaseBlock(i));
+      }
+      HInstruction* case_value = graph_->GetIntConstant(table.GetEntryAt(i), dex_pc);
+      HEqual* comparison = new (arena_) HEqual(value, case_value, dex_pc);
+      AppendInstruction(comparison);
+      AppendInstruction(new (arena_) HIf(comparison, dex_pc));
+    }
+  } else {
+    // Sparse switch keys are sorted, so compare against the middle one.
+    size_t mid = DexSwitchTable::GetBinarySearchSplit(lo, hi);
+    HInstruction* split_value = graph_->GetIntConstant(table.GetEntryAt(mid), dex_pc);
+    HLessThan* comparison = new (arena_) HLessThan(value, split_value, dex_pc);
+    AppendInstruction(comparison);
+    AppendInstruction(new (arena_) HIf(comparison, dex_pc));
+    current_block_ = FindBlockStartingAt(table.GetDexPcForBinarySearchNode(lo, mid));
+    BuildSwitchTree(table, value, dex_pc, lo, mid);
+    current_block_ = FindBlockStartingAt(table.GetDexPcForBinarySearchNode(mid, hi));
+    BuildSwitchTree(table, value, dex_pc, mid, hi);
+  }
+}
+
 void HInstructionBuilder::BuildReturn(const Instruction& instruction,
                                       Primitive::Type type,
                                       uint32_t dex_pc) {
@@ -945,7 +1027,8 @@ bool HInstructionBuilder::BuildInvokePolymorphic(const Instruction& instruction
                                                     number_of_arguments,
                                                     return_type,
                                                     dex_pc,
-                                                    method_idx);
+                                                    method_idx,
+                                                    proto_idx);
   return HandleInvoke(invoke,
                       number_of_vreg_arguments,
                       args,
@@ -2657,6 +2740,8 @@ bool HInstructionBuilder::ProcessDexInstruction(const Instruction& instruction,
     case Instruction::IGET_WIDE_QUICK:
     case Instruction::IGET_OBJECT:
     case Instruction::IGET_OBJECT_QUICK:
+    case Instruction::IGET_OBJECT_QUICK_IF_EQZ:
+    case Instruction::IGET_OBJECT_QUICK_IF_NEZ:
     case Instruction::IGET_BOOLEAN:
     case Instruction::IGET_BOOLEAN_QUICK:
     case Instruction::IGET_BYTE:
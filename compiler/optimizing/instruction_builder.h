@@ -33,6 +33,7 @@
 namespace art {
 
 class CodeGenerator;
+class DexSwitchTable;
 class Instruction;
 
 class HInstructionBuilder : public ValueObject {
@@ -71,7 +72,9 @@ class HInstructionBuilder : public ValueObject {
         quicken_info_(interpreter_metadata),
         compilation_stats_(compiler_stats),
         dex_cache_(dex_cache),
-        loop_headers_(graph->GetArena()->Adapter(kArenaAllocGraphBuilder)) {
+        loop_headers_(graph->GetArena()->Adapter(kArenaAllocGraphBuilder)),
+        uncommon_branches_(std::less<uint32_t>(),
+                           graph->GetArena()->Adapter(kArenaAllocGraphBuilder)) {
     loop_headers_.reserve(kDefaultNumberOfLoops);
   }
 
@@ -87,6 +90,14 @@ class HInstructionBuilder : public ValueObject {
   bool ProcessDexInstruction(const Instruction& instruction, uint32_t dex_pc, size_t quicken_index);
   void FindNativeDebugInfoLocations(ArenaBitVector* locations);
 
+  // Find the conditional branches that the JIT's branch profile shows to (almost) always
+  // go the same way, and record them in `uncommon_branches_`.
+  void FindUncommonBranches();
+
+  // Build the HIf of a conditional branch, with the uncommon successor flags set from
+  // the branch profile.
+  void BuildIf(HInstruction* condition, uint32_t dex_pc);
+
   bool CanDecodeQuickenedInfo() const;
   uint16_t LookupQuickenedInfo(uint32_t quicken_index);
 
@@ -232,6 +243,14 @@ class HInstructionBuilder : public ValueObject {
   // Builds an instruction sequence for a switch statement.
   void BuildSwitch(const Instruction& instruction, uint32_t dex_pc);
 
+  // Builds the comparisons of the binary search node over the keys [lo, hi) of a
+  // sparse switch, starting in `current_block_`.
+  void BuildSwitchTree(const DexSwitchTable& table,
+                       HInstruction* value,
+                       uint32_t dex_pc,
+                       size_t lo,
+                       size_t hi);
+
   // Builds a `HLoadClass` loading the given `type_index`. If `outer` is true,
   // this method will use the outer class's dex file to lookup the type at
   // `type_index`.
@@ -359,6 +378,10 @@ class HInstructionBuilder : public ValueObject {
 
   ArenaVector<HBasicBlock*> loop_headers_;
 
+  // Maps the dex pc of a profiled conditional branch to whether it is the taken (true)
+  // or the not taken (false) successor that is uncommon.
+  ArenaSafeMap<uint32_t, bool> uncommon_branches_;
+
   static constexpr int kDefaultNumberOfLoops = 2;
 
   DISALLOW_COPY_AND_ASSIGN(HInstructionBuilder);
@@ -71,6 +71,7 @@ class InstructionSimplifierVisitor : public HGraphDelegateVisitor {
   void VisitEqual(HEqual* equal) OVERRIDE;
   void VisitNotEqual(HNotEqual* equal) OVERRIDE;
   void VisitBooleanNot(HBooleanNot* bool_not) OVERRIDE;
+  void VisitInstanceFieldGet(HInstanceFieldGet* instruction) OVERRIDE;
   void VisitInstanceFieldSet(HInstanceFieldSet* equal) OVERRIDE;
   void VisitStaticFieldSet(HStaticFieldSet* equal) OVERRIDE;
   void VisitArraySet(HArraySet* equal) OVERRIDE;
@@ -589,6 +590,63 @@ void InstructionSimplifierVisitor::VisitInstanceOf(HInstanceOf* instruction) {
   }
 }
 
+// Returns the descriptor of the box class returned by the box cache intrinsic
+// `intrinsic`, or null if `intrinsic` is not a box cache intrinsic.
+static const char* GetValueOfBoxDescriptor(Intrinsics intrinsic) {
+  switch (intrinsic) {
+    case Intrinsics::kIntegerValueOf:
+      return "Ljava/lang/Integer;";
+    case Intrinsics::kLongValueOf:
+      return "Ljava/lang/Long;";
+    case Intrinsics::kShortValueOf:
+      return "Ljava/lang/Short;";
+    case Intrinsics::kCharacterValueOf:
+      return "Ljava/lang/Character;";
+    case Intrinsics::kByteValueOf:
+      return "Ljava/lang/Byte;";
+    default:
+      return nullptr;
+  }
+}
+
+void InstructionSimplifierVisitor::VisitInstanceFieldGet(HInstanceFieldGet* instruction) {
+  // Unboxing a value that was just boxed, for example `Integer.valueOf(x).intValue()`
+  // once `intValue()` is inlined, yields the original value. The `value` field of the
+  // boxes is final, so no store can have happened in between.
+  HInstruction* object = instruction->InputAt(0);
+  if (object->IsNullCheck()) {
+    object = object->InputAt(0);
+  }
+  if (!object->IsInvokeStaticOrDirect()) {
+    return;
+  }
+  const char* box_descriptor = GetValueOfBoxDescriptor(object->AsInvoke()->GetIntrinsic());
+  if (box_descriptor == nullptr) {
+    return;
+  }
+  const FieldInfo& field_info = instruction->GetFieldInfo();
+  const DexFile& dex_file = field_info.GetDexFile();
+  const DexFile::FieldId& field_id = dex_file.GetFieldId(field_info.GetFieldIndex());
+  if (strcmp(dex_file.GetFieldName(field_id), "value") != 0 ||
+      strcmp(dex_file.GetFieldDeclaringClassDescriptor(field_id), box_descriptor) != 0) {
+    return;
+  }
+  HInstruction* value = object->InputAt(0);
+  Primitive::Type type = instruction->GetType();
+  if (value->GetType() != type) {
+    // Only a constant of a wider type is known to be unchanged by the narrowing store.
+    if (!value->IsIntConstant() ||
+        Primitive::PrimitiveKind(type) != Primitive::kPrimInt ||
+        value->AsIntConstant()->GetValue() < Primitive::MinValueOfIntegralType(type) ||
+        value->AsIntConstant()->GetValue() > Primitive::MaxValueOfIntegralType(type)) {
+      return;
+    }
+  }
+  instruction->ReplaceWith(value);
+  instruction->GetBlock()->RemoveInstruction(instruction);
+  RecordSimplification();
+}
+
 void InstructionSimplifierVisitor::VisitInstanceFieldSet(HInstanceFieldSet* instruction) {
   if ((instruction->GetValue()->GetType() == Primitive::kPrimNot)
       && CanEnsureNotNullAt(instruction->GetValue(), instruction)) {
@@ -790,6 +848,7 @@ void InstructionSimplifierVisitor::VisitIf(HIf* instruction) {
     // Swap successors if input is negated.
     instruction->ReplaceInput(condition->InputAt(0), 0);
     instruction->GetBlock()->SwapSuccessors();
+    instruction->SwapUncommonSuccessors();
     RecordSimplification();
   }
 }
@@ -180,10 +180,10 @@ INTRINSICS_LIST(OPTIMIZING_INTRINSICS)
   return os;
 }
 
-void IntrinsicVisitor::ComputeIntegerValueOfLocations(HInvoke* invoke,
-                                                      CodeGenerator* codegen,
-                                                      Location return_location,
-                                                      Location first_argument_location) {
+void IntrinsicVisitor::ComputeValueOfLocations(HInvoke* invoke,
+                                               CodeGenerator* codegen,
+                                               Location return_location,
+                                               Location first_argument_location) {
   if (Runtime::Current()->IsAotCompiler()) {
     if (codegen->GetCompilerOptions().IsBootImage() ||
         codegen->GetCompilerOptions().GetCompilePic()) {
@@ -192,22 +192,19 @@ void IntrinsicVisitor::ComputeIntegerValueOfLocations(HInvoke* invoke,
     }
   }
 
-  IntegerValueOfInfo info = ComputeIntegerValueOfInfo();
+  ValueOfInfo info = ComputeValueOfInfo(invoke->GetIntrinsic());
 
   // Most common case is that we have found all we needed (classes are initialized
   // and in the boot image). Bail if not.
-  if (info.integer_cache == nullptr ||
-      info.integer == nullptr ||
+  if (info.cache_class == nullptr ||
+      info.boxed_class == nullptr ||
       info.cache == nullptr ||
-      info.value_offset == 0 ||
-      // low and high cannot be 0, per the spec.
-      info.low == 0 ||
-      info.high == 0) {
-    LOG(INFO) << "Integer.valueOf will not be optimized";
+      info.value_offset == 0) {
+    LOG(INFO) << invoke->GetIntrinsic() << " will not be optimized";
     return;
   }
 
-  // The intrinsic will call if it needs to allocate a j.l.Integer.
+  // The intrinsic will call if it needs to allocate a box.
   LocationSummary* locations = new (invoke->GetBlock()->GetGraph()->GetArena()) LocationSummary(
       invoke, LocationSummary::kCallOnMainOnly, kIntrinsified);
   if (!invoke->InputAt(0)->IsConstant()) {
@@ -217,13 +214,60 @@ void IntrinsicVisitor::ComputeIntegerValueOfLocations(HInvoke* invoke,
   locations->SetOut(return_location);
 }
 
-IntrinsicVisitor::IntegerValueOfInfo IntrinsicVisitor::ComputeIntegerValueOfInfo() {
+IntrinsicVisitor::ValueOfInfo IntrinsicVisitor::ComputeValueOfInfo(Intrinsics intrinsic) {
   // Note that we could cache all of the data looked up here. but there's no good
   // location for it. We don't want to add it to WellKnownClasses, to avoid creating global
   // jni values. Adding it as state to the compiler singleton seems like wrong
   // separation of concerns.
   // The need for this data should be pretty rare though.
 
+  const char* cache_descriptor;
+  const char* boxed_descriptor;
+  const char* cache_array_descriptor;
+  Primitive::Type value_type;
+  // The lower bound of the caches other than the configurable Integer one.
+  int32_t fixed_low;
+  switch (intrinsic) {
+    case Intrinsics::kIntegerValueOf:
+      cache_descriptor = "Ljava/lang/Integer$IntegerCache;";
+      boxed_descriptor = "Ljava/lang/Integer;";
+      cache_array_descriptor = "[Ljava/lang/Integer;";
+      value_type = Primitive::kPrimInt;
+      fixed_low = 0;  // Unused.
+      break;
+    case Intrinsics::kLongValueOf:
+      cache_descriptor = "Ljava/lang/Long$LongCache;";
+      boxed_descriptor = "Ljava/lang/Long;";
+      cache_array_descriptor = "[Ljava/lang/Long;";
+      value_type = Primitive::kPrimLong;
+      fixed_low = -128;
+      break;
+    case Intrinsics::kShortValueOf:
+      cache_descriptor = "Ljava/lang/Short$ShortCache;";
+      boxed_descriptor = "Ljava/lang/Short;";
+      cache_array_descriptor = "[Ljava/lang/Short;";
+      value_type = Primitive::kPrimShort;
+      fixed_low = -128;
+      break;
+    case Intrinsics::kCharacterValueOf:
+      cache_descriptor = "Ljava/lang/Character$CharacterCache;";
+      boxed_descriptor = "Ljava/lang/Character;";
+      cache_array_descriptor = "[Ljava/lang/Character;";
+      value_type = Primitive::kPrimChar;
+      fixed_low = 0;
+      break;
+    case Intrinsics::kByteValueOf:
+      cache_descriptor = "Ljava/lang/Byte$ByteCache;";
+      boxed_descriptor = "Ljava/lang/Byte;";
+      cache_array_descriptor = "[Ljava/lang/Byte;";
+      value_type = Primitive::kPrimByte;
+      fixed_low = -128;
+      break;
+    default:
+      LOG(FATAL) << "Unexpected box cache intrinsic " << intrinsic;
+      UNREACHABLE();
+  }
+
   // The most common case is that the classes are in the boot image and initialized,
   // which is easy to generate code for. We bail if not.
   Thread* self = Thread::Current();
@@ -231,60 +275,73 @@ IntrinsicVisitor::IntegerValueOfInfo IntrinsicVisitor::ComputeIntegerValueOfInfo
   Runtime* runtime = Runtime::Current();
   ClassLinker* class_linker = runtime->GetClassLinker();
   gc::Heap* heap = runtime->GetHeap();
-  IntegerValueOfInfo info;
-  info.integer_cache = class_linker->FindSystemClass(self, "Ljava/lang/Integer$IntegerCache;");
-  if (info.integer_cache == nullptr) {
+  ValueOfInfo info;
+  info.value_type = value_type;
+  info.cache_class = class_linker->FindSystemClass(self, cache_descriptor);
+  if (info.cache_class == nullptr) {
     self->ClearException();
     return info;
   }
-  if (!heap->ObjectIsInBootImageSpace(info.integer_cache) || !info.integer_cache->IsInitialized()) {
+  if (!heap->ObjectIsInBootImageSpace(info.cache_class) || !info.cache_class->IsInitialized()) {
     // Optimization only works if the class is initialized and in the boot image.
     return info;
   }
-  info.integer = class_linker->FindSystemClass(self, "Ljava/lang/Integer;");
-  if (info.integer == nullptr) {
+  info.boxed_class = class_linker->FindSystemClass(self, boxed_descriptor);
+  if (info.boxed_class == nullptr) {
     self->ClearException();
     return info;
   }
-  if (!heap->ObjectIsInBootImageSpace(info.integer) || !info.integer->IsInitialized()) {
+  if (!heap->ObjectIsInBootImageSpace(info.boxed_class) || !info.boxed_class->IsInitialized()) {
     // Optimization only works if the class is initialized and in the boot image.
     return info;
   }
 
-  ArtField* field = info.integer_cache->FindDeclaredStaticField("cache", "[Ljava/lang/Integer;");
+  ArtField* field = info.cache_class->FindDeclaredStaticField("cache", cache_array_descriptor);
   if (field == nullptr) {
     return info;
   }
-  info.cache = static_cast<mirror::ObjectArray<mirror::Object>*>(
-      field->GetObject(info.integer_cache).Ptr());
-  if (info.cache == nullptr) {
+  mirror::ObjectArray<mirror::Object>* cache = static_cast<mirror::ObjectArray<mirror::Object>*>(
+      field->GetObject(info.cache_class).Ptr());
+  if (cache == nullptr) {
     return info;
   }
 
-  if (!heap->ObjectIsInBootImageSpace(info.cache)) {
+  if (!heap->ObjectIsInBootImageSpace(cache)) {
     // Optimization only works if the object is in the boot image.
     return info;
   }
 
-  field = info.integer->FindDeclaredInstanceField("value", "I");
+  field = info.boxed_class->FindDeclaredInstanceField("value", Primitive::Descriptor(value_type));
   if (field == nullptr) {
     return info;
   }
   info.value_offset = field->GetOffset().Int32Value();
 
-  field = info.integer_cache->FindDeclaredStaticField("low", "I");
-  if (field == nullptr) {
-    return info;
-  }
-  info.low = field->GetInt(info.integer_cache);
+  if (intrinsic == Intrinsics::kIntegerValueOf) {
+    field = info.cache_class->FindDeclaredStaticField("low", "I");
+    if (field == nullptr) {
+      return info;
+    }
+    info.low = field->GetInt(info.cache_class);
 
-  field = info.integer_cache->FindDeclaredStaticField("high", "I");
-  if (field == nullptr) {
-    return info;
-  }
-  info.high = field->GetInt(info.integer_cache);
+    field = info.cache_class->FindDeclaredStaticField("high", "I");
+    if (field == nullptr) {
+      return info;
+    }
+    info.high = field->GetInt(info.cache_class);
 
-  DCHECK_EQ(info.cache->GetLength(), info.high - info.low + 1);
+    // low and high cannot be 0, per the spec.
+    if (info.low == 0 || info.high == 0) {
+      return info;
+    }
+    DCHECK_EQ(cache->GetLength(), info.high - info.low + 1);
+  } else {
+    // The other caches have a fixed size that is not recorded in a field.
+    info.low = fixed_low;
+    info.high = fixed_low + cache->GetLength() - 1;
+  }
+  // Only publish the cache once all the data is known to be valid.
+  info.cache = cache;
   return info;
 }
 
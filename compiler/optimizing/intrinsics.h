@@ -113,38 +113,42 @@ INTRINSICS_LIST(OPTIMIZING_INTRINSICS)
     codegen->GetMoveResolver()->EmitNativeCode(&parallel_move);
   }
 
-  static void ComputeIntegerValueOfLocations(HInvoke* invoke,
-                                             CodeGenerator* codegen,
-                                             Location return_location,
-                                             Location first_argument_location);
-
-  // Temporary data structure for holding Integer.valueOf useful data. We only
+  // Used for Integer.valueOf and the other box cache intrinsics, Long.valueOf,
+  // Short.valueOf, Character.valueOf and Byte.valueOf.
+  static void ComputeValueOfLocations(HInvoke* invoke,
+                                      CodeGenerator* codegen,
+                                      Location return_location,
+                                      Location first_argument_location);
+
+  // Temporary data structure for holding useful data of a box cache intrinsic. We only
   // use it if the mirror::Class* are in the boot image, so it is fine to keep raw
   // mirror::Class pointers in this structure.
-  struct IntegerValueOfInfo {
-    IntegerValueOfInfo()
-        : integer_cache(nullptr),
-          integer(nullptr),
+  struct ValueOfInfo {
+    ValueOfInfo()
+        : cache_class(nullptr),
+          boxed_class(nullptr),
           cache(nullptr),
           low(0),
           high(0),
-          value_offset(0) {}
-
-    // The java.lang.IntegerCache class.
-    mirror::Class* integer_cache;
-    // The java.lang.Integer class.
-    mirror::Class* integer;
-    // Value of java.lang.IntegerCache#cache.
+          value_offset(0),
+          value_type(Primitive::kPrimVoid) {}
+
+    // The cache holder class, for example java.lang.Integer$IntegerCache.
+    mirror::Class* cache_class;
+    // The box class, for example java.lang.Integer.
+    mirror::Class* boxed_class;
+    // Value of the cache holder's `cache` field.
     mirror::ObjectArray<mirror::Object>* cache;
-    // Value of java.lang.IntegerCache#low.
+    // The smallest and largest cached values. For Integer, the values of
+    // java.lang.Integer$IntegerCache#low and #high, which can be configured.
     int32_t low;
-    // Value of java.lang.IntegerCache#high.
     int32_t high;
-    // The offset of java.lang.Integer.value.
+    // The offset and type of the box's `value` field.
     int32_t value_offset;
+    Primitive::Type value_type;
   };
 
-  static IntegerValueOfInfo ComputeIntegerValueOfInfo();
+  static ValueOfInfo ComputeValueOfInfo(Intrinsics intrinsic);
 
  protected:
   IntrinsicVisitor() {}
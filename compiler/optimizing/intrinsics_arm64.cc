@@ -751,6 +751,141 @@ void IntrinsicCodeGeneratorARM64::VisitMathRoundFloat(HInvoke* invoke) {
   GenMathRound(invoke, /* is_double */ false, GetVIXLAssembler());
 }
 
+static void CreateExactArithmeticLocations(ArenaAllocator* arena, HInvoke* invoke) {
+  LocationSummary* locations = new (arena) LocationSummary(invoke,
+                                                           LocationSummary::kCallOnSlowPath,
+                                                           kIntrinsified);
+  for (size_t i = 0, e = invoke->GetNumberOfArguments(); i < e; ++i) {
+    locations->SetInAt(i, Location::RequiresRegister());
+  }
+  // The inputs must survive the computation for the slow path, which calls the original
+  // method to throw the ArithmeticException.
+  locations->SetOut(Location::RequiresRegister(), Location::kOutputOverlap);
+}
+
+enum class ExactOp {
+  kAdd,
+  kSubtract,
+  kMultiply,
+  kNegate,
+};
+
+static void GenExactArithmetic(HInvoke* invoke,
+                               CodeGeneratorARM64* codegen,
+                               ArenaAllocator* allocator,
+                               ExactOp op) {
+  MacroAssembler* masm = codegen->GetVIXLAssembler();
+  LocationSummary* locations = invoke->GetLocations();
+  const bool is_long = invoke->GetType() == Primitive::kPrimLong;
+
+  Register lhs = is_long ? XRegisterFrom(locations->InAt(0)) : WRegisterFrom(locations->InAt(0));
+  Register out = is_long ? XRegisterFrom(locations->Out()) : WRegisterFrom(locations->Out());
+
+  SlowPathCodeARM64* slow_path = new (allocator) IntrinsicSlowPathARM64(invoke);
+  codegen->AddSlowPath(slow_path);
+
+  if (op == ExactOp::kNegate) {
+    __ Negs(out, lhs);
+    __ B(vs, slow_path->GetEntryLabel());
+  } else {
+    Register rhs =
+        is_long ? XRegisterFrom(locations->InAt(1)) : WRegisterFrom(locations->InAt(1));
+    switch (op) {
+      case ExactOp::kAdd:
+        __ Adds(out, lhs, rhs);
+        __ B(vs, slow_path->GetEntryLabel());
+        break;
+      case ExactOp::kSubtract:
+        __ Subs(out, lhs, rhs);
+        __ B(vs, slow_path->GetEntryLabel());
+        break;
+      case ExactOp::kMultiply:
+        if (is_long) {
+          // The product fits if the high half is the sign extension of the low half.
+          UseScratchRegisterScope temps(masm);
+          Register high = temps.AcquireX();
+          __ Smulh(high, lhs, rhs);
+          __ Mul(out, lhs, rhs);
+          __ Cmp(high, Operand(out, ASR, 63));
+        } else {
+          // The 64-bit product fits if it is the sign extension of its low word.
+          __ Smull(out.X(), lhs, rhs);
+          __ Cmp(out.X(), Operand(out, SXTW));
+        }
+        __ B(ne, slow_path->GetEntryLabel());
+        break;
+      default:
+        LOG(FATAL) << "Unexpected exact operation";
+        UNREACHABLE();
+    }
+  }
+  __ Bind(slow_path->GetExitLabel());
+}
+
+void IntrinsicLocationsBuilderARM64::VisitMathAddExactInt(HInvoke* invoke) {
+  CreateExactArithmeticLocations(arena_, invoke);
+}
+
+void IntrinsicCodeGeneratorARM64::VisitMathAddExactInt(HInvoke* invoke) {
+  GenExactArithmetic(invoke, codegen_, GetAllocator(), ExactOp::kAdd);
+}
+
+void IntrinsicLocationsBuilderARM64::VisitMathAddExactLong(HInvoke* invoke) {
+  CreateExactArithmeticLocations(arena_, invoke);
+}
+
+void IntrinsicCodeGeneratorARM64::VisitMathAddExactLong(HInvoke* invoke) {
+  GenExactArithmetic(invoke, codegen_, GetAllocator(), ExactOp::kAdd);
+}
+
+void IntrinsicLocationsBuilderARM64::VisitMathSubtractExactInt(HInvoke* invoke) {
+  CreateExactArithmeticLocations(arena_, invoke);
+}
+
+void IntrinsicCodeGeneratorARM64::VisitMathSubtractExactInt(HInvoke* invoke) {
+  GenExactArithmetic(invoke, codegen_, GetAllocator(), ExactOp::kSubtract);
+}
+
+void IntrinsicLocationsBuilderARM64::VisitMathSubtractExactLong(HInvoke* invoke) {
+  CreateExactArithmeticLocations(arena_, invoke);
+}
+
+void IntrinsicCodeGeneratorARM64::VisitMathSubtractExactLong(HInvoke* invoke) {
+  GenExactArithmetic(invoke, codegen_, GetAllocator(), ExactOp::kSubtract);
+}
+
+void IntrinsicLocationsBuilderARM64::VisitMathMultiplyExactInt(HInvoke* invoke) {
+  CreateExactArithmeticLocations(arena_, invoke);
+}
+
+void IntrinsicCodeGeneratorARM64::VisitMathMultiplyExactInt(HInvoke* invoke) {
+  GenExactArithmetic(invoke, codegen_, GetAllocator(), ExactOp::kMultiply);
+}
+
+void IntrinsicLocationsBuilderARM64::VisitMathMultiplyExactLong(HInvoke* invoke) {
+  CreateExactArithmeticLocations(arena_, invoke);
+}
+
+void IntrinsicCodeGeneratorARM64::VisitMathMultiplyExactLong(HInvoke* invoke) {
+  GenExactArithmetic(invoke, codegen_, GetAllocator(), ExactOp::kMultiply);
+}
+
+void IntrinsicLocationsBuilderARM64::VisitMathNegateExactInt(HInvoke* invoke) {
+  CreateExactArithmeticLocations(arena_, invoke);
+}
+
+void IntrinsicCodeGeneratorARM64::VisitMathNegateExactInt(HInvoke* invoke) {
+  GenExactArithmetic(invoke, codegen_, GetAllocator(), ExactOp::kNegate);
+}
+
+void IntrinsicLocationsBuilderARM64::VisitMathNegateExactLong(HInvoke* invoke) {
+  CreateExactArithmeticLocations(arena_, invoke);
+}
+
+void IntrinsicCodeGeneratorARM64::VisitMathNegateExactLong(HInvoke* invoke) {
+  GenExactArithmetic(invoke, codegen_, GetAllocator(), ExactOp::kNegate);
+}
+
 void IntrinsicLocationsBuilderARM64::VisitMemoryPeekByte(HInvoke* invoke) {
   CreateIntToIntLocations(arena_, invoke);
 }
@@ -1239,6 +1374,79 @@ void IntrinsicCodeGeneratorARM64::VisitUnsafeCASObject(HInvoke* invoke) {
   GenCas(invoke, Primitive::kPrimNot, codegen_);
 }
 
+static void CreateIntIntIntIntToInt(ArenaAllocator* arena, HInvoke* invoke, bool is_add) {
+  LocationSummary* locations = new (arena) LocationSummary(invoke,
+                                                           LocationSummary::kNoCall,
+                                                           kIntrinsified);
+  locations->SetInAt(0, Location::NoLocation());        // Unused receiver.
+  locations->SetInAt(1, Location::RequiresRegister());
+  locations->SetInAt(2, Location::RequiresRegister());
+  locations->SetInAt(3, Location::RequiresRegister());
+  // The output is written in the loop, before the inputs are last read.
+  locations->SetOut(Location::RequiresRegister(), Location::kOutputOverlap);
+  if (is_add) {
+    // The sum to store.
+    locations->AddTemp(Location::RequiresRegister());
+  }
+}
+
+// Generates Unsafe.getAndAdd* and Unsafe.getAndSet* with an exclusive load-acquire/
+// store-release loop, which gives them the same ordering as GenCas.
+static void GenGetAndUpdate(HInvoke* invoke,
+                            Primitive::Type type,
+                            bool is_add,
+                            CodeGeneratorARM64* codegen) {
+  MacroAssembler* masm = codegen->GetVIXLAssembler();
+  LocationSummary* locations = invoke->GetLocations();
+
+  Register base = WRegisterFrom(locations->InAt(1));               // Object pointer.
+  Register offset = XRegisterFrom(locations->InAt(2));             // Long offset.
+  Register value = RegisterFrom(locations->InAt(3), type);         // Delta or new value.
+  Register out = RegisterFrom(locations->Out(), type);             // Old value.
+  Register new_value = is_add ? RegisterFrom(locations->GetTemp(0), type) : value;
+
+  UseScratchRegisterScope temps(masm);
+  Register tmp_ptr = temps.AcquireX();                             // Pointer to actual memory.
+  Register status = temps.AcquireW();                              // Store-exclusive status.
+
+  __ Add(tmp_ptr, base.X(), Operand(offset));
+
+  vixl::aarch64::Label loop_head;
+  __ Bind(&loop_head);
+  __ Ldaxr(out, MemOperand(tmp_ptr));
+  if (is_add) {
+    __ Add(new_value, out, value);
+  }
+  __ Stlxr(status, new_value, MemOperand(tmp_ptr));
+  __ Cbnz(status, &loop_head);
+}
+
+void IntrinsicLocationsBuilderARM64::VisitUnsafeGetAndAddInt(HInvoke* invoke) {
+  CreateIntIntIntIntToInt(arena_, invoke, /* is_add */ true);
+}
+void IntrinsicLocationsBuilderARM64::VisitUnsafeGetAndAddLong(HInvoke* invoke) {
+  CreateIntIntIntIntToInt(arena_, invoke, /* is_add */ true);
+}
+void IntrinsicLocationsBuilderARM64::VisitUnsafeGetAndSetInt(HInvoke* invoke) {
+  CreateIntIntIntIntToInt(arena_, invoke, /* is_add */ false);
+}
+void IntrinsicLocationsBuilderARM64::VisitUnsafeGetAndSetLong(HInvoke* invoke) {
+  CreateIntIntIntIntToInt(arena_, invoke, /* is_add */ false);
+}
+
+void IntrinsicCodeGeneratorARM64::VisitUnsafeGetAndAddInt(HInvoke* invoke) {
+  GenGetAndUpdate(invoke, Primitive::kPrimInt, /* is_add */ true, codegen_);
+}
+void IntrinsicCodeGeneratorARM64::VisitUnsafeGetAndAddLong(HInvoke* invoke) {
+  GenGetAndUpdate(invoke, Primitive::kPrimLong, /* is_add */ true, codegen_);
+}
+void IntrinsicCodeGeneratorARM64::VisitUnsafeGetAndSetInt(HInvoke* invoke) {
+  GenGetAndUpdate(invoke, Primitive::kPrimInt, /* is_add */ false, codegen_);
+}
+void IntrinsicCodeGeneratorARM64::VisitUnsafeGetAndSetLong(HInvoke* invoke) {
+  GenGetAndUpdate(invoke, Primitive::kPrimLong, /* is_add */ false, codegen_);
+}
+
 void IntrinsicLocationsBuilderARM64::VisitStringCompareTo(HInvoke* invoke) {
   LocationSummary* locations = new (arena_) LocationSummary(invoke,
                                                             invoke->InputAt(1)->CanBeNull()
@@ -1652,6 +1860,263 @@ void IntrinsicCodeGeneratorARM64::VisitStringEquals(HInvoke* invoke) {
   __ Bind(&end);
 }
 
+static void CreateArraysEqualsLocations(ArenaAllocator* arena, HInvoke* invoke) {
+  LocationSummary* locations = new (arena) LocationSummary(invoke,
+                                                           LocationSummary::kNoCall,
+                                                           kIntrinsified);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::RequiresRegister());
+  // Temporaries for the remaining byte count, the two data pointers and the second pair of
+  // loaded values; the output register holds a loaded value until the comparison is done.
+  locations->AddTemp(Location::RequiresRegister());
+  locations->AddTemp(Location::RequiresRegister());
+  locations->AddTemp(Location::RequiresRegister());
+  locations->AddTemp(Location::RequiresRegister());
+  locations->SetOut(Location::RequiresRegister(), Location::kOutputOverlap);
+}
+
+static void GenArraysEquals(HInvoke* invoke, MacroAssembler* masm, Primitive::Type type) {
+  LocationSummary* locations = invoke->GetLocations();
+  const size_t element_size = Primitive::ComponentSize(type);
+  const int32_t length_offset = mirror::Array::LengthOffset().Int32Value();
+  const int32_t data_offset = mirror::Array::DataOffset(element_size).Int32Value();
+
+  Register array = WRegisterFrom(locations->InAt(0));
+  Register arg = WRegisterFrom(locations->InAt(1));
+  Register out = XRegisterFrom(locations->Out());
+  Register count = WRegisterFrom(locations->GetTemp(0));
+  Register array_ptr = XRegisterFrom(locations->GetTemp(1));
+  Register arg_ptr = XRegisterFrom(locations->GetTemp(2));
+  Register temp2 = XRegisterFrom(locations->GetTemp(3));
+
+  UseScratchRegisterScope scratch_scope(masm);
+  Register temp = scratch_scope.AcquireX();
+  Register temp1 = scratch_scope.AcquireX();
+
+  vixl::aarch64::Label loop;
+  vixl::aarch64::Label tail;
+  vixl::aarch64::Label tail4;
+  vixl::aarch64::Label tail2;
+  vixl::aarch64::Label tail1;
+  vixl::aarch64::Label end;
+  vixl::aarch64::Label return_true;
+  vixl::aarch64::Label return_false;
+
+  // Reference equality check, also covers both arrays being null.
+  __ Cmp(array, arg);
+  __ B(&return_true, eq);
+  __ Cbz(array, &return_false);
+  __ Cbz(arg, &return_false);
+
+  // Compare the lengths and return true if both arrays are empty.
+  __ Ldr(count, MemOperand(array.X(), length_offset));
+  __ Ldr(temp1.W(), MemOperand(arg.X(), length_offset));
+  __ Cmp(count, temp1.W());
+  __ B(&return_false, ne);
+  __ Cbz(count, &return_true);
+
+  // From here on, `count` is the number of bytes to compare. It fits in 32 bits as the
+  // size of any array is bounded by the heap size.
+  if (element_size != 1u) {
+    __ Lsl(count, count, Primitive::ComponentSizeShift(type));
+  }
+  __ Add(array_ptr, array.X(), data_offset);
+  __ Add(arg_ptr, arg.X(), data_offset);
+
+  // Compare 16 bytes per iteration with paired loads.
+  __ Subs(count, count, 16);
+  __ B(&tail, lt);
+  __ Bind(&loop);
+  __ Ldp(temp, temp1, MemOperand(array_ptr, 2 * sizeof(uint64_t), PostIndex));
+  __ Ldp(out, temp2, MemOperand(arg_ptr, 2 * sizeof(uint64_t), PostIndex));
+  __ Cmp(temp, out);
+  __ Ccmp(temp1, temp2, NoFlag, eq);
+  __ B(&return_false, ne);
+  __ Subs(count, count, 16);
+  __ B(&loop, ge);
+
+  // Unrolled tail. `count` is now in [-16, -1] and its low four bits hold the number of
+  // remaining bytes, which is a multiple of the element size.
+  __ Bind(&tail);
+  __ Tbz(count, 3, &tail4);
+  __ Ldr(temp, MemOperand(array_ptr, sizeof(uint64_t), PostIndex));
+  __ Ldr(out, MemOperand(arg_ptr, sizeof(uint64_t), PostIndex));
+  __ Cmp(temp, out);
+  __ B(&return_false, ne);
+  __ Bind(&tail4);
+  if (element_size <= 4u) {
+    __ Tbz(count, 2, &tail2);
+    __ Ldr(temp.W(), MemOperand(array_ptr, sizeof(uint32_t), PostIndex));
+    __ Ldr(out.W(), MemOperand(arg_ptr, sizeof(uint32_t), PostIndex));
+    __ Cmp(temp.W(), out.W());
+    __ B(&return_false, ne);
+  }
+  __ Bind(&tail2);
+  if (element_size <= 2u) {
+    __ Tbz(count, 1, &tail1);
+    __ Ldrh(temp.W(), MemOperand(array_ptr, sizeof(uint16_t), PostIndex));
+    __ Ldrh(out.W(), MemOperand(arg_ptr, sizeof(uint16_t), PostIndex));
+    __ Cmp(temp.W(), out.W());
+    __ B(&return_false, ne);
+  }
+  __ Bind(&tail1);
+  if (element_size == 1u) {
+    __ Tbz(count, 0, &return_true);
+    __ Ldrb(temp.W(), MemOperand(array_ptr));
+    __ Ldrb(out.W(), MemOperand(arg_ptr));
+    __ Cmp(temp.W(), out.W());
+    __ B(&return_false, ne);
+  }
+
+  __ Bind(&return_true);
+  __ Mov(out, 1);
+  __ B(&end);
+
+  __ Bind(&return_false);
+  __ Mov(out, 0);
+  __ Bind(&end);
+}
+
+void IntrinsicLocationsBuilderARM64::VisitArraysEqualsByte(HInvoke* invoke) {
+  CreateArraysEqualsLocations(arena_, invoke);
+}
+
+void IntrinsicCodeGeneratorARM64::VisitArraysEqualsByte(HInvoke* invoke) {
+  GenArraysEquals(invoke, GetVIXLAssembler(), Primitive::kPrimByte);
+}
+
+void IntrinsicLocationsBuilderARM64::VisitArraysEqualsChar(HInvoke* invoke) {
+  CreateArraysEqualsLocations(arena_, invoke);
+}
+
+void IntrinsicCodeGeneratorARM64::VisitArraysEqualsChar(HInvoke* invoke) {
+  GenArraysEquals(invoke, GetVIXLAssembler(), Primitive::kPrimChar);
+}
+
+void IntrinsicLocationsBuilderARM64::VisitArraysEqualsInt(HInvoke* invoke) {
+  CreateArraysEqualsLocations(arena_, invoke);
+}
+
+void IntrinsicCodeGeneratorARM64::VisitArraysEqualsInt(HInvoke* invoke) {
+  GenArraysEquals(invoke, GetVIXLAssembler(), Primitive::kPrimInt);
+}
+
+void IntrinsicLocationsBuilderARM64::VisitArraysEqualsLong(HInvoke* invoke) {
+  CreateArraysEqualsLocations(arena_, invoke);
+}
+
+void IntrinsicCodeGeneratorARM64::VisitArraysEqualsLong(HInvoke* invoke) {
+  GenArraysEquals(invoke, GetVIXLAssembler(), Primitive::kPrimLong);
+}
+
+void IntrinsicLocationsBuilderARM64::VisitCRC32Update(HInvoke* invoke) {
+  if (!codegen_->GetInstructionSetFeatures().HasCRC()) {
+    return;
+  }
+
+  LocationSummary* locations = new (arena_) LocationSummary(invoke,
+                                                            LocationSummary::kNoCall,
+                                                            kIntrinsified);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::RequiresRegister());
+  locations->SetOut(Location::RequiresRegister(), Location::kOutputOverlap);
+}
+
+// Lower the invoke of CRC32.update(int crc, int b).
+void IntrinsicCodeGeneratorARM64::VisitCRC32Update(HInvoke* invoke) {
+  DCHECK(codegen_->GetInstructionSetFeatures().HasCRC());
+
+  MacroAssembler* masm = GetVIXLAssembler();
+  LocationSummary* locations = invoke->GetLocations();
+
+  Register crc = WRegisterFrom(locations->InAt(0));
+  Register val = WRegisterFrom(locations->InAt(1));
+  Register out = WRegisterFrom(locations->Out());
+
+  // The CRC32 instructions do not pre- or post-condition the value, java.util.zip.CRC32 keeps
+  // the final checksum which is the bitwise complement of the running value.
+  __ Mvn(out, crc);
+  // Only the low byte of `b` is used.
+  __ Crc32b(out, out, val);
+  __ Mvn(out, out);
+}
+
+void IntrinsicLocationsBuilderARM64::VisitCRC32UpdateBytes(HInvoke* invoke) {
+  if (!codegen_->GetInstructionSetFeatures().HasCRC()) {
+    return;
+  }
+
+  LocationSummary* locations = new (arena_) LocationSummary(invoke,
+                                                            LocationSummary::kNoCall,
+                                                            kIntrinsified);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::RequiresRegister());
+  locations->SetInAt(2, Location::RequiresRegister());
+  locations->SetInAt(3, Location::RequiresRegister());
+  // Temporaries for the data pointer and the remaining byte count.
+  locations->AddTemp(Location::RequiresRegister());
+  locations->AddTemp(Location::RequiresRegister());
+  locations->SetOut(Location::RequiresRegister(), Location::kOutputOverlap);
+}
+
+// Lower the invoke of CRC32.updateBytes(int crc, byte[] b, int off, int len).
+// The bounds of the range have been checked by the caller.
+void IntrinsicCodeGeneratorARM64::VisitCRC32UpdateBytes(HInvoke* invoke) {
+  DCHECK(codegen_->GetInstructionSetFeatures().HasCRC());
+
+  MacroAssembler* masm = GetVIXLAssembler();
+  LocationSummary* locations = invoke->GetLocations();
+
+  Register crc = WRegisterFrom(locations->InAt(0));
+  Register array = XRegisterFrom(locations->InAt(1));
+  Register offset = WRegisterFrom(locations->InAt(2));
+  Register length = WRegisterFrom(locations->InAt(3));
+  Register ptr = XRegisterFrom(locations->GetTemp(0));
+  Register count = WRegisterFrom(locations->GetTemp(1));
+  Register out = WRegisterFrom(locations->Out());
+
+  UseScratchRegisterScope scratch_scope(masm);
+  Register temp = scratch_scope.AcquireX();
+
+  vixl::aarch64::Label loop;
+  vixl::aarch64::Label tail;
+  vixl::aarch64::Label tail2;
+  vixl::aarch64::Label tail1;
+  vixl::aarch64::Label done;
+
+  const int32_t data_offset = mirror::Array::DataOffset(sizeof(int8_t)).Int32Value();
+
+  __ Mvn(out, crc);
+  __ Add(ptr, array, data_offset);
+  __ Add(ptr, ptr, Operand(offset, UXTW));
+
+  // Process 8 bytes per iteration with CRC32X.
+  __ Subs(count, length, sizeof(uint64_t));
+  __ B(&tail, lt);
+  __ Bind(&loop);
+  __ Ldr(temp, MemOperand(ptr, sizeof(uint64_t), PostIndex));
+  __ Crc32x(out, out, temp);
+  __ Subs(count, count, sizeof(uint64_t));
+  __ B(&loop, ge);
+
+  // Unrolled tail. `count` is now in [-8, -1] and its low three bits hold the number of
+  // remaining bytes.
+  __ Bind(&tail);
+  __ Tbz(count, 2, &tail2);
+  __ Ldr(temp.W(), MemOperand(ptr, sizeof(uint32_t), PostIndex));
+  __ Crc32w(out, out, temp.W());
+  __ Bind(&tail2);
+  __ Tbz(count, 1, &tail1);
+  __ Ldrh(temp.W(), MemOperand(ptr, sizeof(uint16_t), PostIndex));
+  __ Crc32h(out, out, temp.W());
+  __ Bind(&tail1);
+  __ Tbz(count, 0, &done);
+  __ Ldrb(temp.W(), MemOperand(ptr));
+  __ Crc32b(out, out, temp.W());
+  __ Bind(&done);
+  __ Mvn(out, out);
+}
+
 static void GenerateVisitStringIndexOf(HInvoke* invoke,
                                        MacroAssembler* masm,
                                        CodeGeneratorARM64* codegen,
@@ -1981,6 +2446,130 @@ void IntrinsicCodeGeneratorARM64::VisitMathNextAfter(HInvoke* invoke) {
   GenFPToFPCall(invoke, codegen_, kQuickNextAfter);
 }
 
+void IntrinsicLocationsBuilderARM64::VisitStringHashCode(HInvoke* invoke) {
+  LocationSummary* locations = new (arena_) LocationSummary(invoke,
+                                                            LocationSummary::kNoCall,
+                                                            kIntrinsified);
+  locations->SetInAt(0, Location::RequiresRegister());
+  // Temporaries for the remaining length, the data pointer, the four characters of an
+  // iteration and two of the multiplier constants.
+  for (size_t i = 0; i != 7u; ++i) {
+    locations->AddTemp(Location::RequiresRegister());
+  }
+  locations->SetOut(Location::RequiresRegister(), Location::kOutputOverlap);
+}
+
+// Emits the hash loop over the characters of `str` for one character width. The loop consumes
+// four characters per iteration as h' = h * 31^4 + (c0 * 31^3 + c1 * 31^2 + c2 * 31 + c3), where
+// only the final multiply-add depends on the previous iteration.
+static void GenStringHashCodeLoop(MacroAssembler* masm,
+                                  LocationSummary* locations,
+                                  Register str,
+                                  Register count,
+                                  bool compressed,
+                                  vixl::aarch64::Label* store) {
+  Register out = WRegisterFrom(locations->Out());
+  Register ptr = XRegisterFrom(locations->GetTemp(1));
+  Register c0 = WRegisterFrom(locations->GetTemp(2));
+  Register c1 = WRegisterFrom(locations->GetTemp(3));
+  Register c2 = WRegisterFrom(locations->GetTemp(4));
+  Register c3 = WRegisterFrom(locations->GetTemp(5));
+  Register k2 = WRegisterFrom(locations->GetTemp(6));
+
+  UseScratchRegisterScope scratch_scope(masm);
+  Register k3 = scratch_scope.AcquireW();
+  Register k4 = scratch_scope.AcquireW();
+
+  const int32_t value_offset = mirror::String::ValueOffset().Int32Value();
+  const int32_t char_size = compressed ? sizeof(uint8_t) : sizeof(uint16_t);
+
+  vixl::aarch64::Label loop;
+  vixl::aarch64::Label tail;
+  vixl::aarch64::Label tail_loop;
+
+  auto load_char = [&](Register dst, const MemOperand& src) {
+    if (compressed) {
+      __ Ldrb(dst, src);
+    } else {
+      __ Ldrh(dst, src);
+    }
+  };
+
+  __ Add(ptr, str.X(), value_offset);
+  __ Subs(count, count, 4);
+  __ B(&tail, lt);
+  __ Mov(k2, 31 * 31);
+  __ Mov(k3, 31 * 31 * 31);
+  __ Mov(k4, 31 * 31 * 31 * 31);
+  __ Bind(&loop);
+  load_char(c0, MemOperand(ptr));
+  load_char(c1, MemOperand(ptr, char_size));
+  load_char(c2, MemOperand(ptr, 2 * char_size));
+  load_char(c3, MemOperand(ptr, 3 * char_size));
+  __ Add(ptr, ptr, 4 * char_size);
+  __ Mul(c0, c0, k3);
+  __ Madd(c0, c1, k2, c0);
+  __ Add(c3, c3, Operand(c2, LSL, 5));
+  __ Sub(c3, c3, c2);
+  __ Add(c0, c0, c3);
+  __ Madd(out, out, k4, c0);
+  __ Subs(count, count, 4);
+  __ B(&loop, ge);
+
+  // At most three characters remain, h' = h * 31 + c.
+  __ Bind(&tail);
+  __ Adds(count, count, 4);
+  __ B(store, eq);
+  __ Bind(&tail_loop);
+  load_char(c0, MemOperand(ptr, char_size, PostIndex));
+  __ Add(c0, c0, Operand(out, LSL, 5));
+  __ Sub(out, c0, out);
+  __ Subs(count, count, 1);
+  __ B(&tail_loop, ne);
+  __ B(store);
+}
+
+void IntrinsicCodeGeneratorARM64::VisitStringHashCode(HInvoke* invoke) {
+  MacroAssembler* masm = GetVIXLAssembler();
+  LocationSummary* locations = invoke->GetLocations();
+
+  Register str = WRegisterFrom(locations->InAt(0));
+  Register out = WRegisterFrom(locations->Out());
+  Register count = WRegisterFrom(locations->GetTemp(0));
+
+  vixl::aarch64::Label store;
+  vixl::aarch64::Label done;
+
+  const int32_t count_offset = mirror::String::CountOffset().Int32Value();
+  const int32_t hash_offset = mirror::String::HashCodeOffset().Int32Value();
+
+  // Note that the null check must have been done earlier.
+  DCHECK(!invoke->CanDoImplicitNullCheckOn(invoke->InputAt(0)));
+
+  // Return the cached hash code if there is one.
+  __ Ldr(out, MemOperand(str.X(), hash_offset));
+  __ Cbnz(out, &done);
+
+  __ Ldr(count, MemOperand(str.X(), count_offset));
+  if (mirror::kUseStringCompression) {
+    vixl::aarch64::Label uncompressed;
+    static_assert(static_cast<uint32_t>(mirror::StringCompressionFlag::kCompressed) == 0u,
+                  "Expecting 0=compressed, 1=uncompressed");
+    __ Tbnz(count, 0, &uncompressed);
+    __ Lsr(count, count, 1u);
+    GenStringHashCodeLoop(masm, locations, str, count, /* compressed */ true, &store);
+    __ Bind(&uncompressed);
+    __ Lsr(count, count, 1u);
+  }
+  GenStringHashCodeLoop(masm, locations, str, count, /* compressed */ false, &store);
+
+  // Cache a non-zero hash code. Racing stores write the same value.
+  __ Bind(&store);
+  __ Cbz(out, &done);
+  __ Str(out, MemOperand(str.X(), hash_offset));
+  __ Bind(&done);
+}
+
 void IntrinsicLocationsBuilderARM64::VisitStringGetCharsNoCheck(HInvoke* invoke) {
   LocationSummary* locations = new (arena_) LocationSummary(invoke,
                                                             LocationSummary::kNoCall,
@@ -2897,79 +3486,127 @@ void IntrinsicCodeGeneratorARM64::VisitDoubleIsInfinite(HInvoke* invoke) {
   GenIsInfinite(invoke->GetLocations(), /* is64bit */ true, GetVIXLAssembler());
 }
 
-void IntrinsicLocationsBuilderARM64::VisitIntegerValueOf(HInvoke* invoke) {
+static void CreateValueOfLocations(HInvoke* invoke, CodeGeneratorARM64* codegen) {
   InvokeRuntimeCallingConvention calling_convention;
-  IntrinsicVisitor::ComputeIntegerValueOfLocations(
+  IntrinsicVisitor::ComputeValueOfLocations(
       invoke,
-      codegen_,
+      codegen,
       calling_convention.GetReturnLocation(Primitive::kPrimNot),
       Location::RegisterLocation(calling_convention.GetRegisterAt(0).GetCode()));
 }
 
-void IntrinsicCodeGeneratorARM64::VisitIntegerValueOf(HInvoke* invoke) {
-  IntrinsicVisitor::IntegerValueOfInfo info = IntrinsicVisitor::ComputeIntegerValueOfInfo();
+// Generates code for Integer.valueOf and the other box cache intrinsics.
+static void GenValueOf(HInvoke* invoke, CodeGeneratorARM64* codegen) {
+  IntrinsicVisitor::ValueOfInfo info = IntrinsicVisitor::ComputeValueOfInfo(invoke->GetIntrinsic());
   LocationSummary* locations = invoke->GetLocations();
-  MacroAssembler* masm = GetVIXLAssembler();
+  MacroAssembler* masm = codegen->GetVIXLAssembler();
+  const Primitive::Type type = info.value_type;
+  const bool is_long = type == Primitive::kPrimLong;
 
   Register out = RegisterFrom(locations->Out(), Primitive::kPrimNot);
   UseScratchRegisterScope temps(masm);
-  Register temp = temps.AcquireW();
+  Register temp = is_long ? temps.AcquireX() : temps.AcquireW();
   InvokeRuntimeCallingConvention calling_convention;
   Register argument = calling_convention.GetRegisterAt(0);
   if (invoke->InputAt(0)->IsConstant()) {
-    int32_t value = invoke->InputAt(0)->AsIntConstant()->GetValue();
+    int64_t value = Int64FromConstant(invoke->InputAt(0)->AsConstant());
     if (value >= info.low && value <= info.high) {
-      // Just embed the j.l.Integer in the code.
+      // Just embed the box in the code.
       ScopedObjectAccess soa(Thread::Current());
-      mirror::Object* boxed = info.cache->Get(value + (-info.low));
+      mirror::Object* boxed = info.cache->Get(static_cast<int32_t>(value - info.low));
       DCHECK(boxed != nullptr && Runtime::Current()->GetHeap()->ObjectIsInBootImageSpace(boxed));
       uint32_t address = dchecked_integral_cast<uint32_t>(reinterpret_cast<uintptr_t>(boxed));
-      __ Ldr(out.W(), codegen_->DeduplicateBootImageAddressLiteral(address));
+      __ Ldr(out.W(), codegen->DeduplicateBootImageAddressLiteral(address));
     } else {
-      // Allocate and initialize a new j.l.Integer.
-      // TODO: If we JIT, we could allocate the j.l.Integer now, and store it in the
+      // Allocate and initialize a new box.
+      // TODO: If we JIT, we could allocate the box now, and store it in the
       // JIT object table.
       uint32_t address =
-          dchecked_integral_cast<uint32_t>(reinterpret_cast<uintptr_t>(info.integer));
-      __ Ldr(argument.W(), codegen_->DeduplicateBootImageAddressLiteral(address));
-      codegen_->InvokeRuntime(kQuickAllocObjectInitialized, invoke, invoke->GetDexPc());
+          dchecked_integral_cast<uint32_t>(reinterpret_cast<uintptr_t>(info.boxed_class));
+      __ Ldr(argument.W(), codegen->DeduplicateBootImageAddressLiteral(address));
+      codegen->InvokeRuntime(kQuickAllocObjectInitialized, invoke, invoke->GetDexPc());
       CheckEntrypointTypes<kQuickAllocObjectWithChecks, void*, mirror::Class*>();
-      __ Mov(temp.W(), value);
-      __ Str(temp.W(), HeapOperand(out.W(), info.value_offset));
+      __ Mov(temp, value);
+      codegen->Store(type, temp, HeapOperand(out.W(), info.value_offset));
       // `value` is a final field :-( Ideally, we'd merge this memory barrier with the allocation
       // one.
-      codegen_->GenerateMemoryBarrier(MemBarrierKind::kStoreStore);
+      codegen->GenerateMemoryBarrier(MemBarrierKind::kStoreStore);
     }
   } else {
-    Register in = RegisterFrom(locations->InAt(0), Primitive::kPrimInt);
-    // Check bounds of our cache.
-    __ Add(out.W(), in.W(), -info.low);
-    __ Cmp(out.W(), info.high - info.low + 1);
+    Register in = RegisterFrom(locations->InAt(0), is_long ? type : Primitive::kPrimInt);
+    // Check bounds of our cache. A long index must be checked in 64 bits.
     vixl::aarch64::Label allocate, done;
+    if (is_long) {
+      __ Sub(out.X(), in, info.low);
+      __ Cmp(out.X(), info.high - info.low + 1);
+    } else {
+      __ Add(out.W(), in, -info.low);
+      __ Cmp(out.W(), info.high - info.low + 1);
+    }
     __ B(&allocate, hs);
-    // If the value is within the bounds, load the j.l.Integer directly from the array.
+    // If the value is within the bounds, load the box directly from the array.
     uint32_t data_offset = mirror::Array::DataOffset(kHeapReferenceSize).Uint32Value();
     uint32_t address = dchecked_integral_cast<uint32_t>(reinterpret_cast<uintptr_t>(info.cache));
-    __ Ldr(temp.W(), codegen_->DeduplicateBootImageAddressLiteral(data_offset + address));
+    __ Ldr(temp.W(), codegen->DeduplicateBootImageAddressLiteral(data_offset + address));
     MemOperand source = HeapOperand(
-        temp, out.X(), LSL, Primitive::ComponentSizeShift(Primitive::kPrimNot));
-    codegen_->Load(Primitive::kPrimNot, out, source);
-    codegen_->GetAssembler()->MaybeUnpoisonHeapReference(out);
+        temp.W(), out.X(), LSL, Primitive::ComponentSizeShift(Primitive::kPrimNot));
+    codegen->Load(Primitive::kPrimNot, out, source);
+    codegen->GetAssembler()->MaybeUnpoisonHeapReference(out);
     __ B(&done);
     __ Bind(&allocate);
-    // Otherwise allocate and initialize a new j.l.Integer.
-    address = dchecked_integral_cast<uint32_t>(reinterpret_cast<uintptr_t>(info.integer));
-    __ Ldr(argument.W(), codegen_->DeduplicateBootImageAddressLiteral(address));
-    codegen_->InvokeRuntime(kQuickAllocObjectInitialized, invoke, invoke->GetDexPc());
+    // Otherwise allocate and initialize a new box.
+    address = dchecked_integral_cast<uint32_t>(reinterpret_cast<uintptr_t>(info.boxed_class));
+    __ Ldr(argument.W(), codegen->DeduplicateBootImageAddressLiteral(address));
+    codegen->InvokeRuntime(kQuickAllocObjectInitialized, invoke, invoke->GetDexPc());
     CheckEntrypointTypes<kQuickAllocObjectWithChecks, void*, mirror::Class*>();
-    __ Str(in.W(), HeapOperand(out.W(), info.value_offset));
+    codegen->Store(type, in, HeapOperand(out.W(), info.value_offset));
     // `value` is a final field :-( Ideally, we'd merge this memory barrier with the allocation
     // one.
-    codegen_->GenerateMemoryBarrier(MemBarrierKind::kStoreStore);
+    codegen->GenerateMemoryBarrier(MemBarrierKind::kStoreStore);
     __ Bind(&done);
   }
 }
 
+void IntrinsicLocationsBuilderARM64::VisitIntegerValueOf(HInvoke* invoke) {
+  CreateValueOfLocations(invoke, codegen_);
+}
+
+void IntrinsicCodeGeneratorARM64::VisitIntegerValueOf(HInvoke* invoke) {
+  GenValueOf(invoke, codegen_);
+}
+
+void IntrinsicLocationsBuilderARM64::VisitLongValueOf(HInvoke* invoke) {
+  CreateValueOfLocations(invoke, codegen_);
+}
+
+void IntrinsicCodeGeneratorARM64::VisitLongValueOf(HInvoke* invoke) {
+  GenValueOf(invoke, codegen_);
+}
+
+void IntrinsicLocationsBuilderARM64::VisitShortValueOf(HInvoke* invoke) {
+  CreateValueOfLocations(invoke, codegen_);
+}
+
+void IntrinsicCodeGeneratorARM64::VisitShortValueOf(HInvoke* invoke) {
+  GenValueOf(invoke, codegen_);
+}
+
+void IntrinsicLocationsBuilderARM64::VisitCharacterValueOf(HInvoke* invoke) {
+  CreateValueOfLocations(invoke, codegen_);
+}
+
+void IntrinsicCodeGeneratorARM64::VisitCharacterValueOf(HInvoke* invoke) {
+  GenValueOf(invoke, codegen_);
+}
+
+void IntrinsicLocationsBuilderARM64::VisitByteValueOf(HInvoke* invoke) {
+  CreateValueOfLocations(invoke, codegen_);
+}
+
+void IntrinsicCodeGeneratorARM64::VisitByteValueOf(HInvoke* invoke) {
+  GenValueOf(invoke, codegen_);
+}
+
 void IntrinsicLocationsBuilderARM64::VisitThreadInterrupted(HInvoke* invoke) {
   LocationSummary* locations = new (arena_) LocationSummary(invoke,
                                                             LocationSummary::kNoCall,
@@ -3008,10 +3645,6 @@ UNIMPLEMENTED_INTRINSIC(ARM64, StringBuilderLength);
 UNIMPLEMENTED_INTRINSIC(ARM64, StringBuilderToString);
 
 // 1.8.
-UNIMPLEMENTED_INTRINSIC(ARM64, UnsafeGetAndAddInt)
-UNIMPLEMENTED_INTRINSIC(ARM64, UnsafeGetAndAddLong)
-UNIMPLEMENTED_INTRINSIC(ARM64, UnsafeGetAndSetInt)
-UNIMPLEMENTED_INTRINSIC(ARM64, UnsafeGetAndSetLong)
 UNIMPLEMENTED_INTRINSIC(ARM64, UnsafeGetAndSetObject)
 
 UNREACHABLE_INTRINSICS(ARM64)
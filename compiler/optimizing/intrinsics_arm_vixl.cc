@@ -3025,7 +3025,7 @@ void IntrinsicCodeGeneratorARMVIXL::VisitMathFloor(HInvoke* invoke) {
 
 void IntrinsicLocationsBuilderARMVIXL::VisitIntegerValueOf(HInvoke* invoke) {
   InvokeRuntimeCallingConventionARMVIXL calling_convention;
-  IntrinsicVisitor::ComputeIntegerValueOfLocations(
+  IntrinsicVisitor::ComputeValueOfLocations(
       invoke,
       codegen_,
       LocationFrom(r0),
@@ -3033,7 +3033,7 @@ void IntrinsicLocationsBuilderARMVIXL::VisitIntegerValueOf(HInvoke* invoke) {
 }
 
 void IntrinsicCodeGeneratorARMVIXL::VisitIntegerValueOf(HInvoke* invoke) {
-  IntrinsicVisitor::IntegerValueOfInfo info = IntrinsicVisitor::ComputeIntegerValueOfInfo();
+  IntrinsicVisitor::ValueOfInfo info = IntrinsicVisitor::ComputeValueOfInfo(invoke->GetIntrinsic());
   LocationSummary* locations = invoke->GetLocations();
   ArmVIXLAssembler* const assembler = GetAssembler();
 
@@ -3056,7 +3056,7 @@ void IntrinsicCodeGeneratorARMVIXL::VisitIntegerValueOf(HInvoke* invoke) {
       // TODO: If we JIT, we could allocate the j.l.Integer now, and store it in the
       // JIT object table.
       uint32_t address =
-          dchecked_integral_cast<uint32_t>(reinterpret_cast<uintptr_t>(info.integer));
+          dchecked_integral_cast<uint32_t>(reinterpret_cast<uintptr_t>(info.boxed_class));
       __ Ldr(argument, codegen_->DeduplicateBootImageAddressLiteral(address));
       codegen_->InvokeRuntime(kQuickAllocObjectInitialized, invoke, invoke->GetDexPc());
       CheckEntrypointTypes<kQuickAllocObjectWithChecks, void*, mirror::Class*>();
@@ -3082,7 +3082,7 @@ void IntrinsicCodeGeneratorARMVIXL::VisitIntegerValueOf(HInvoke* invoke) {
     __ B(&done);
     __ Bind(&allocate);
     // Otherwise allocate and initialize a new j.l.Integer.
-    address = dchecked_integral_cast<uint32_t>(reinterpret_cast<uintptr_t>(info.integer));
+    address = dchecked_integral_cast<uint32_t>(reinterpret_cast<uintptr_t>(info.boxed_class));
     __ Ldr(argument, codegen_->DeduplicateBootImageAddressLiteral(address));
     codegen_->InvokeRuntime(kQuickAllocObjectInitialized, invoke, invoke->GetDexPc());
     CheckEntrypointTypes<kQuickAllocObjectWithChecks, void*, mirror::Class*>();
@@ -3129,6 +3129,28 @@ UNIMPLEMENTED_INTRINSIC(ARMVIXL, LongHighestOneBit)
 UNIMPLEMENTED_INTRINSIC(ARMVIXL, IntegerLowestOneBit)
 UNIMPLEMENTED_INTRINSIC(ARMVIXL, LongLowestOneBit)
 
+UNIMPLEMENTED_INTRINSIC(ARMVIXL, ArraysEqualsByte)
+UNIMPLEMENTED_INTRINSIC(ARMVIXL, ArraysEqualsChar)
+UNIMPLEMENTED_INTRINSIC(ARMVIXL, ArraysEqualsInt)
+UNIMPLEMENTED_INTRINSIC(ARMVIXL, ArraysEqualsLong)
+
+UNIMPLEMENTED_INTRINSIC(ARMVIXL, CRC32Update)
+UNIMPLEMENTED_INTRINSIC(ARMVIXL, CRC32UpdateBytes)
+
+UNIMPLEMENTED_INTRINSIC(ARMVIXL, MathAddExactInt)
+UNIMPLEMENTED_INTRINSIC(ARMVIXL, MathAddExactLong)
+UNIMPLEMENTED_INTRINSIC(ARMVIXL, MathSubtractExactInt)
+UNIMPLEMENTED_INTRINSIC(ARMVIXL, MathSubtractExactLong)
+UNIMPLEMENTED_INTRINSIC(ARMVIXL, MathMultiplyExactInt)
+UNIMPLEMENTED_INTRINSIC(ARMVIXL, MathMultiplyExactLong)
+UNIMPLEMENTED_INTRINSIC(ARMVIXL, MathNegateExactInt)
+UNIMPLEMENTED_INTRINSIC(ARMVIXL, MathNegateExactLong)
+
+UNIMPLEMENTED_INTRINSIC(ARMVIXL, StringHashCode)
+UNIMPLEMENTED_INTRINSIC(ARMVIXL, LongValueOf)
+UNIMPLEMENTED_INTRINSIC(ARMVIXL, ShortValueOf)
+UNIMPLEMENTED_INTRINSIC(ARMVIXL, CharacterValueOf)
+UNIMPLEMENTED_INTRINSIC(ARMVIXL, ByteValueOf)
 UNIMPLEMENTED_INTRINSIC(ARMVIXL, StringStringIndexOf);
 UNIMPLEMENTED_INTRINSIC(ARMVIXL, StringStringIndexOfAfter);
 UNIMPLEMENTED_INTRINSIC(ARMVIXL, StringBufferAppend);
@@ -3149,7 +3149,7 @@ void IntrinsicCodeGeneratorMIPS::VisitSystemArrayCopyChar(HInvoke* invoke) {
 // long java.lang.Integer.valueOf(long)
 void IntrinsicLocationsBuilderMIPS::VisitIntegerValueOf(HInvoke* invoke) {
   InvokeRuntimeCallingConvention calling_convention;
-  IntrinsicVisitor::ComputeIntegerValueOfLocations(
+  IntrinsicVisitor::ComputeValueOfLocations(
       invoke,
       codegen_,
       calling_convention.GetReturnLocation(Primitive::kPrimNot),
@@ -3157,7 +3157,7 @@ void IntrinsicLocationsBuilderMIPS::VisitIntegerValueOf(HInvoke* invoke) {
 }
 
 void IntrinsicCodeGeneratorMIPS::VisitIntegerValueOf(HInvoke* invoke) {
-  IntrinsicVisitor::IntegerValueOfInfo info = IntrinsicVisitor::ComputeIntegerValueOfInfo();
+  IntrinsicVisitor::ValueOfInfo info = IntrinsicVisitor::ComputeValueOfInfo(invoke->GetIntrinsic());
   LocationSummary* locations = invoke->GetLocations();
   MipsAssembler* assembler = GetAssembler();
   InstructionCodeGeneratorMIPS* icodegen =
@@ -3179,7 +3179,7 @@ void IntrinsicCodeGeneratorMIPS::VisitIntegerValueOf(HInvoke* invoke) {
       // TODO: If we JIT, we could allocate the j.l.Integer now, and store it in the
       // JIT object table.
       uint32_t address =
-          dchecked_integral_cast<uint32_t>(reinterpret_cast<uintptr_t>(info.integer));
+          dchecked_integral_cast<uint32_t>(reinterpret_cast<uintptr_t>(info.boxed_class));
       __ LoadConst32(calling_convention.GetRegisterAt(0), address);
       codegen_->InvokeRuntime(kQuickAllocObjectInitialized, invoke, invoke->GetDexPc());
       CheckEntrypointTypes<kQuickAllocObjectWithChecks, void*, mirror::Class*>();
@@ -3217,7 +3217,7 @@ void IntrinsicCodeGeneratorMIPS::VisitIntegerValueOf(HInvoke* invoke) {
 
     __ Bind(&allocate);
     // Otherwise allocate and initialize a new j.l.Integer.
-    address = dchecked_integral_cast<uint32_t>(reinterpret_cast<uintptr_t>(info.integer));
+    address = dchecked_integral_cast<uint32_t>(reinterpret_cast<uintptr_t>(info.boxed_class));
     __ LoadConst32(calling_convention.GetRegisterAt(0), address);
     codegen_->InvokeRuntime(kQuickAllocObjectInitialized, invoke, invoke->GetDexPc());
     CheckEntrypointTypes<kQuickAllocObjectWithChecks, void*, mirror::Class*>();
@@ -3242,6 +3242,28 @@ UNIMPLEMENTED_INTRINSIC(MIPS, UnsafeCASLong)
 UNIMPLEMENTED_INTRINSIC(MIPS, ReferenceGetReferent)
 UNIMPLEMENTED_INTRINSIC(MIPS, SystemArrayCopy)
 
+UNIMPLEMENTED_INTRINSIC(MIPS, ArraysEqualsByte)
+UNIMPLEMENTED_INTRINSIC(MIPS, ArraysEqualsChar)
+UNIMPLEMENTED_INTRINSIC(MIPS, ArraysEqualsInt)
+UNIMPLEMENTED_INTRINSIC(MIPS, ArraysEqualsLong)
+
+UNIMPLEMENTED_INTRINSIC(MIPS, CRC32Update)
+UNIMPLEMENTED_INTRINSIC(MIPS, CRC32UpdateBytes)
+
+UNIMPLEMENTED_INTRINSIC(MIPS, MathAddExactInt)
+UNIMPLEMENTED_INTRINSIC(MIPS, MathAddExactLong)
+UNIMPLEMENTED_INTRINSIC(MIPS, MathSubtractExactInt)
+UNIMPLEMENTED_INTRINSIC(MIPS, MathSubtractExactLong)
+UNIMPLEMENTED_INTRINSIC(MIPS, MathMultiplyExactInt)
+UNIMPLEMENTED_INTRINSIC(MIPS, MathMultiplyExactLong)
+UNIMPLEMENTED_INTRINSIC(MIPS, MathNegateExactInt)
+UNIMPLEMENTED_INTRINSIC(MIPS, MathNegateExactLong)
+
+UNIMPLEMENTED_INTRINSIC(MIPS, StringHashCode)
+UNIMPLEMENTED_INTRINSIC(MIPS, LongValueOf)
+UNIMPLEMENTED_INTRINSIC(MIPS, ShortValueOf)
+UNIMPLEMENTED_INTRINSIC(MIPS, CharacterValueOf)
+UNIMPLEMENTED_INTRINSIC(MIPS, ByteValueOf)
 UNIMPLEMENTED_INTRINSIC(MIPS, StringStringIndexOf);
 UNIMPLEMENTED_INTRINSIC(MIPS, StringStringIndexOfAfter);
 UNIMPLEMENTED_INTRINSIC(MIPS, StringBufferAppend);
@@ -2528,7 +2528,7 @@ void IntrinsicCodeGeneratorMIPS64::VisitMathTanh(HInvoke* invoke) {
 // long java.lang.Integer.valueOf(long)
 void IntrinsicLocationsBuilderMIPS64::VisitIntegerValueOf(HInvoke* invoke) {
   InvokeRuntimeCallingConvention calling_convention;
-  IntrinsicVisitor::ComputeIntegerValueOfLocations(
+  IntrinsicVisitor::ComputeValueOfLocations(
       invoke,
       codegen_,
       calling_convention.GetReturnLocation(Primitive::kPrimNot),
@@ -2536,7 +2536,7 @@ void IntrinsicLocationsBuilderMIPS64::VisitIntegerValueOf(HInvoke* invoke) {
 }
 
 void IntrinsicCodeGeneratorMIPS64::VisitIntegerValueOf(HInvoke* invoke) {
-  IntrinsicVisitor::IntegerValueOfInfo info = IntrinsicVisitor::ComputeIntegerValueOfInfo();
+  IntrinsicVisitor::ValueOfInfo info = IntrinsicVisitor::ComputeValueOfInfo(invoke->GetIntrinsic());
   LocationSummary* locations = invoke->GetLocations();
   Mips64Assembler* assembler = GetAssembler();
   InstructionCodeGeneratorMIPS64* icodegen =
@@ -2558,7 +2558,7 @@ void IntrinsicCodeGeneratorMIPS64::VisitIntegerValueOf(HInvoke* invoke) {
       // TODO: If we JIT, we could allocate the j.l.Integer now, and store it in the
       // JIT object table.
       uint32_t address =
-          dchecked_integral_cast<uint32_t>(reinterpret_cast<uintptr_t>(info.integer));
+          dchecked_integral_cast<uint32_t>(reinterpret_cast<uintptr_t>(info.boxed_class));
       __ LoadConst64(calling_convention.GetRegisterAt(0), address);
       codegen_->InvokeRuntime(kQuickAllocObjectInitialized, invoke, invoke->GetDexPc());
       CheckEntrypointTypes<kQuickAllocObjectWithChecks, void*, mirror::Class*>();
@@ -2591,7 +2591,7 @@ void IntrinsicCodeGeneratorMIPS64::VisitIntegerValueOf(HInvoke* invoke) {
 
     __ Bind(&allocate);
     // Otherwise allocate and initialize a new j.l.Integer.
-    address = dchecked_integral_cast<uint32_t>(reinterpret_cast<uintptr_t>(info.integer));
+    address = dchecked_integral_cast<uint32_t>(reinterpret_cast<uintptr_t>(info.boxed_class));
     __ LoadConst64(calling_convention.GetRegisterAt(0), address);
     codegen_->InvokeRuntime(kQuickAllocObjectInitialized, invoke, invoke->GetDexPc());
     CheckEntrypointTypes<kQuickAllocObjectWithChecks, void*, mirror::Class*>();
@@ -2606,6 +2606,28 @@ void IntrinsicCodeGeneratorMIPS64::VisitIntegerValueOf(HInvoke* invoke) {
 UNIMPLEMENTED_INTRINSIC(MIPS64, ReferenceGetReferent)
 UNIMPLEMENTED_INTRINSIC(MIPS64, SystemArrayCopy)
 
+UNIMPLEMENTED_INTRINSIC(MIPS64, ArraysEqualsByte)
+UNIMPLEMENTED_INTRINSIC(MIPS64, ArraysEqualsChar)
+UNIMPLEMENTED_INTRINSIC(MIPS64, ArraysEqualsInt)
+UNIMPLEMENTED_INTRINSIC(MIPS64, ArraysEqualsLong)
+
+UNIMPLEMENTED_INTRINSIC(MIPS64, CRC32Update)
+UNIMPLEMENTED_INTRINSIC(MIPS64, CRC32UpdateBytes)
+
+UNIMPLEMENTED_INTRINSIC(MIPS64, MathAddExactInt)
+UNIMPLEMENTED_INTRINSIC(MIPS64, MathAddExactLong)
+UNIMPLEMENTED_INTRINSIC(MIPS64, MathSubtractExactInt)
+UNIMPLEMENTED_INTRINSIC(MIPS64, MathSubtractExactLong)
+UNIMPLEMENTED_INTRINSIC(MIPS64, MathMultiplyExactInt)
+UNIMPLEMENTED_INTRINSIC(MIPS64, MathMultiplyExactLong)
+UNIMPLEMENTED_INTRINSIC(MIPS64, MathNegateExactInt)
+UNIMPLEMENTED_INTRINSIC(MIPS64, MathNegateExactLong)
+
+UNIMPLEMENTED_INTRINSIC(MIPS64, StringHashCode)
+UNIMPLEMENTED_INTRINSIC(MIPS64, LongValueOf)
+UNIMPLEMENTED_INTRINSIC(MIPS64, ShortValueOf)
+UNIMPLEMENTED_INTRINSIC(MIPS64, CharacterValueOf)
+UNIMPLEMENTED_INTRINSIC(MIPS64, ByteValueOf)
 UNIMPLEMENTED_INTRINSIC(MIPS64, StringStringIndexOf);
 UNIMPLEMENTED_INTRINSIC(MIPS64, StringStringIndexOfAfter);
 UNIMPLEMENTED_INTRINSIC(MIPS64, StringBufferAppend);
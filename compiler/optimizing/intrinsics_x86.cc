@@ -3289,7 +3289,7 @@ void IntrinsicCodeGeneratorX86::VisitSystemArrayCopy(HInvoke* invoke) {
 
 void IntrinsicLocationsBuilderX86::VisitIntegerValueOf(HInvoke* invoke) {
   InvokeRuntimeCallingConvention calling_convention;
-  IntrinsicVisitor::ComputeIntegerValueOfLocations(
+  IntrinsicVisitor::ComputeValueOfLocations(
       invoke,
       codegen_,
       Location::RegisterLocation(EAX),
@@ -3297,7 +3297,7 @@ void IntrinsicLocationsBuilderX86::VisitIntegerValueOf(HInvoke* invoke) {
 }
 
 void IntrinsicCodeGeneratorX86::VisitIntegerValueOf(HInvoke* invoke) {
-  IntrinsicVisitor::IntegerValueOfInfo info = IntrinsicVisitor::ComputeIntegerValueOfInfo();
+  IntrinsicVisitor::ValueOfInfo info = IntrinsicVisitor::ComputeValueOfInfo(invoke->GetIntrinsic());
   LocationSummary* locations = invoke->GetLocations();
   X86Assembler* assembler = GetAssembler();
 
@@ -3316,7 +3316,8 @@ void IntrinsicCodeGeneratorX86::VisitIntegerValueOf(HInvoke* invoke) {
       // Allocate and initialize a new j.l.Integer.
       // TODO: If we JIT, we could allocate the j.l.Integer now, and store it in the
       // JIT object table.
-      uint32_t address = dchecked_integral_cast<uint32_t>(reinterpret_cast<uintptr_t>(info.integer));
+      uint32_t address =
+          dchecked_integral_cast<uint32_t>(reinterpret_cast<uintptr_t>(info.boxed_class));
       __ movl(calling_convention.GetRegisterAt(0), Immediate(address));
       codegen_->InvokeRuntime(kQuickAllocObjectInitialized, invoke, invoke->GetDexPc());
       CheckEntrypointTypes<kQuickAllocObjectWithChecks, void*, mirror::Class*>();
@@ -3337,7 +3338,7 @@ void IntrinsicCodeGeneratorX86::VisitIntegerValueOf(HInvoke* invoke) {
     __ jmp(&done);
     __ Bind(&allocate);
     // Otherwise allocate and initialize a new j.l.Integer.
-    address = dchecked_integral_cast<uint32_t>(reinterpret_cast<uintptr_t>(info.integer));
+    address = dchecked_integral_cast<uint32_t>(reinterpret_cast<uintptr_t>(info.boxed_class));
     __ movl(calling_convention.GetRegisterAt(0), Immediate(address));
     codegen_->InvokeRuntime(kQuickAllocObjectInitialized, invoke, invoke->GetDexPc());
     CheckEntrypointTypes<kQuickAllocObjectWithChecks, void*, mirror::Class*>();
@@ -3376,6 +3377,28 @@ UNIMPLEMENTED_INTRINSIC(X86, LongHighestOneBit)
 UNIMPLEMENTED_INTRINSIC(X86, IntegerLowestOneBit)
 UNIMPLEMENTED_INTRINSIC(X86, LongLowestOneBit)
 
+UNIMPLEMENTED_INTRINSIC(X86, ArraysEqualsByte)
+UNIMPLEMENTED_INTRINSIC(X86, ArraysEqualsChar)
+UNIMPLEMENTED_INTRINSIC(X86, ArraysEqualsInt)
+UNIMPLEMENTED_INTRINSIC(X86, ArraysEqualsLong)
+
+UNIMPLEMENTED_INTRINSIC(X86, CRC32Update)
+UNIMPLEMENTED_INTRINSIC(X86, CRC32UpdateBytes)
+
+UNIMPLEMENTED_INTRINSIC(X86, MathAddExactInt)
+UNIMPLEMENTED_INTRINSIC(X86, MathAddExactLong)
+UNIMPLEMENTED_INTRINSIC(X86, MathSubtractExactInt)
+UNIMPLEMENTED_INTRINSIC(X86, MathSubtractExactLong)
+UNIMPLEMENTED_INTRINSIC(X86, MathMultiplyExactInt)
+UNIMPLEMENTED_INTRINSIC(X86, MathMultiplyExactLong)
+UNIMPLEMENTED_INTRINSIC(X86, MathNegateExactInt)
+UNIMPLEMENTED_INTRINSIC(X86, MathNegateExactLong)
+
+UNIMPLEMENTED_INTRINSIC(X86, StringHashCode)
+UNIMPLEMENTED_INTRINSIC(X86, LongValueOf)
+UNIMPLEMENTED_INTRINSIC(X86, ShortValueOf)
+UNIMPLEMENTED_INTRINSIC(X86, CharacterValueOf)
+UNIMPLEMENTED_INTRINSIC(X86, ByteValueOf)
 UNIMPLEMENTED_INTRINSIC(X86, StringStringIndexOf);
 UNIMPLEMENTED_INTRINSIC(X86, StringStringIndexOfAfter);
 UNIMPLEMENTED_INTRINSIC(X86, StringBufferAppend);
@@ -701,6 +701,148 @@ void IntrinsicCodeGeneratorX86_64::VisitMathRoundFloat(HInvoke* invoke) {
   __ Bind(&done);
 }
 
+static void CreateExactArithmeticLocations(ArenaAllocator* arena, HInvoke* invoke) {
+  LocationSummary* locations = new (arena) LocationSummary(invoke,
+                                                           LocationSummary::kCallOnSlowPath,
+                                                           kIntrinsified);
+  for (size_t i = 0, e = invoke->GetNumberOfArguments(); i < e; ++i) {
+    locations->SetInAt(i, Location::RequiresRegister());
+  }
+  // The inputs must survive the computation for the slow path, which calls the original
+  // method to throw the ArithmeticException.
+  locations->SetOut(Location::RequiresRegister(), Location::kOutputOverlap);
+}
+
+enum class ExactOp {
+  kAdd,
+  kSubtract,
+  kMultiply,
+  kNegate,
+};
+
+static void GenExactArithmetic(HInvoke* invoke,
+                               CodeGeneratorX86_64* codegen,
+                               ArenaAllocator* allocator,
+                               ExactOp op) {
+  X86_64Assembler* assembler = codegen->GetAssembler();
+  LocationSummary* locations = invoke->GetLocations();
+  const bool is_long = invoke->GetType() == Primitive::kPrimLong;
+
+  CpuRegister lhs = locations->InAt(0).AsRegister<CpuRegister>();
+  CpuRegister out = locations->Out().AsRegister<CpuRegister>();
+
+  SlowPathCode* slow_path = new (allocator) IntrinsicSlowPathX86_64(invoke);
+  codegen->AddSlowPath(slow_path);
+
+  // All the operations set the overflow flag exactly when the result does not fit.
+  if (is_long) {
+    __ movq(out, lhs);
+  } else {
+    __ movl(out, lhs);
+  }
+  if (op == ExactOp::kNegate) {
+    if (is_long) {
+      __ negq(out);
+    } else {
+      __ negl(out);
+    }
+  } else {
+    CpuRegister rhs = locations->InAt(1).AsRegister<CpuRegister>();
+    switch (op) {
+      case ExactOp::kAdd:
+        if (is_long) {
+          __ addq(out, rhs);
+        } else {
+          __ addl(out, rhs);
+        }
+        break;
+      case ExactOp::kSubtract:
+        if (is_long) {
+          __ subq(out, rhs);
+        } else {
+          __ subl(out, rhs);
+        }
+        break;
+      case ExactOp::kMultiply:
+        if (is_long) {
+          __ imulq(out, rhs);
+        } else {
+          __ imull(out, rhs);
+        }
+        break;
+      default:
+        LOG(FATAL) << "Unexpected exact operation";
+        UNREACHABLE();
+    }
+  }
+  __ j(kOverflow, slow_path->GetEntryLabel());
+  __ Bind(slow_path->GetExitLabel());
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitMathAddExactInt(HInvoke* invoke) {
+  CreateExactArithmeticLocations(arena_, invoke);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitMathAddExactInt(HInvoke* invoke) {
+  GenExactArithmetic(invoke, codegen_, GetAllocator(), ExactOp::kAdd);
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitMathAddExactLong(HInvoke* invoke) {
+  CreateExactArithmeticLocations(arena_, invoke);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitMathAddExactLong(HInvoke* invoke) {
+  GenExactArithmetic(invoke, codegen_, GetAllocator(), ExactOp::kAdd);
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitMathSubtractExactInt(HInvoke* invoke) {
+  CreateExactArithmeticLocations(arena_, invoke);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitMathSubtractExactInt(HInvoke* invoke) {
+  GenExactArithmetic(invoke, codegen_, GetAllocator(), ExactOp::kSubtract);
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitMathSubtractExactLong(HInvoke* invoke) {
+  CreateExactArithmeticLocations(arena_, invoke);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitMathSubtractExactLong(HInvoke* invoke) {
+  GenExactArithmetic(invoke, codegen_, GetAllocator(), ExactOp::kSubtract);
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitMathMultiplyExactInt(HInvoke* invoke) {
+  CreateExactArithmeticLocations(arena_, invoke);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitMathMultiplyExactInt(HInvoke* invoke) {
+  GenExactArithmetic(invoke, codegen_, GetAllocator(), ExactOp::kMultiply);
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitMathMultiplyExactLong(HInvoke* invoke) {
+  CreateExactArithmeticLocations(arena_, invoke);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitMathMultiplyExactLong(HInvoke* invoke) {
+  GenExactArithmetic(invoke, codegen_, GetAllocator(), ExactOp::kMultiply);
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitMathNegateExactInt(HInvoke* invoke) {
+  CreateExactArithmeticLocations(arena_, invoke);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitMathNegateExactInt(HInvoke* invoke) {
+  GenExactArithmetic(invoke, codegen_, GetAllocator(), ExactOp::kNegate);
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitMathNegateExactLong(HInvoke* invoke) {
+  CreateExactArithmeticLocations(arena_, invoke);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitMathNegateExactLong(HInvoke* invoke) {
+  GenExactArithmetic(invoke, codegen_, GetAllocator(), ExactOp::kNegate);
+}
+
 void IntrinsicLocationsBuilderX86_64::VisitMathRoundDouble(HInvoke* invoke) {
   CreateSSE41FPToIntLocations(arena_, invoke, codegen_);
 }
@@ -1642,6 +1784,155 @@ void IntrinsicCodeGeneratorX86_64::VisitStringEquals(HInvoke* invoke) {
   __ Bind(&end);
 }
 
+static void CreateArraysEqualsLocations(ArenaAllocator* arena, HInvoke* invoke) {
+  LocationSummary* locations = new (arena) LocationSummary(invoke,
+                                                           LocationSummary::kNoCall,
+                                                           kIntrinsified);
+  locations->SetInAt(0, Location::RequiresRegister());
+  locations->SetInAt(1, Location::RequiresRegister());
+  // Temporaries for the remaining byte count, the current offset and a loaded value.
+  locations->AddTemp(Location::RequiresRegister());
+  locations->AddTemp(Location::RequiresRegister());
+  locations->AddTemp(Location::RequiresRegister());
+  // Temporaries for the 16-byte vector comparison.
+  locations->AddTemp(Location::RequiresFpuRegister());
+  locations->AddTemp(Location::RequiresFpuRegister());
+  locations->SetOut(Location::RequiresRegister(), Location::kOutputOverlap);
+}
+
+static void GenArraysEquals(HInvoke* invoke, X86_64Assembler* assembler, Primitive::Type type) {
+  LocationSummary* locations = invoke->GetLocations();
+  const size_t element_size = Primitive::ComponentSize(type);
+  const uint32_t length_offset = mirror::Array::LengthOffset().Uint32Value();
+  const uint32_t data_offset = mirror::Array::DataOffset(element_size).Uint32Value();
+
+  CpuRegister array = locations->InAt(0).AsRegister<CpuRegister>();
+  CpuRegister arg = locations->InAt(1).AsRegister<CpuRegister>();
+  CpuRegister count = locations->GetTemp(0).AsRegister<CpuRegister>();
+  CpuRegister index = locations->GetTemp(1).AsRegister<CpuRegister>();
+  CpuRegister temp = locations->GetTemp(2).AsRegister<CpuRegister>();
+  XmmRegister vector = locations->GetTemp(3).AsFpuRegister<XmmRegister>();
+  XmmRegister vector1 = locations->GetTemp(4).AsFpuRegister<XmmRegister>();
+  CpuRegister out = locations->Out().AsRegister<CpuRegister>();
+
+  NearLabel loop, tail, tail4, tail2, tail1, end, return_true, return_false;
+
+  // Reference equality check, also covers both arrays being null.
+  __ cmpl(array, arg);
+  __ j(kEqual, &return_true);
+  __ testl(array, array);
+  __ j(kEqual, &return_false);
+  __ testl(arg, arg);
+  __ j(kEqual, &return_false);
+
+  // Compare the lengths and return true if both arrays are empty.
+  __ movl(count, Address(array, length_offset));
+  __ cmpl(count, Address(arg, length_offset));
+  __ j(kNotEqual, &return_false);
+  __ testl(count, count);
+  __ j(kEqual, &return_true);
+
+  // From here on, `count` is the number of bytes to compare. It fits in 32 bits as the
+  // size of any array is bounded by the heap size.
+  if (element_size != 1u) {
+    __ shll(count, Immediate(Primitive::ComponentSizeShift(type)));
+  }
+  __ xorl(index, index);
+
+  // Compare 16 bytes per iteration. PCMPEQB sets each byte lane that matches to all ones,
+  // so the arrays differ if any bit of the PMOVMSKB mask is clear.
+  __ subl(count, Immediate(16));
+  __ j(kLess, &tail);
+  __ Bind(&loop);
+  __ movdqu(vector, Address(array, index, TIMES_1, data_offset));
+  __ movdqu(vector1, Address(arg, index, TIMES_1, data_offset));
+  __ pcmpeqb(vector, vector1);
+  __ pmovmskb(out, vector);
+  __ cmpl(out, Immediate(0xffff));
+  __ j(kNotEqual, &return_false);
+  __ addq(index, Immediate(16));
+  __ subl(count, Immediate(16));
+  __ j(kGreaterEqual, &loop);
+
+  // Unrolled tail. `count` is now in [-16, -1] and its low four bits hold the number of
+  // remaining bytes, which is a multiple of the element size.
+  __ Bind(&tail);
+  __ testl(count, Immediate(8));
+  __ j(kZero, &tail4);
+  __ movq(out, Address(array, index, TIMES_1, data_offset));
+  __ cmpq(out, Address(arg, index, TIMES_1, data_offset));
+  __ j(kNotEqual, &return_false);
+  __ addq(index, Immediate(8));
+  __ Bind(&tail4);
+  if (element_size <= 4u) {
+    __ testl(count, Immediate(4));
+    __ j(kZero, &tail2);
+    __ movl(out, Address(array, index, TIMES_1, data_offset));
+    __ cmpl(out, Address(arg, index, TIMES_1, data_offset));
+    __ j(kNotEqual, &return_false);
+    __ addq(index, Immediate(4));
+  }
+  __ Bind(&tail2);
+  if (element_size <= 2u) {
+    __ testl(count, Immediate(2));
+    __ j(kZero, &tail1);
+    __ movzxw(out, Address(array, index, TIMES_1, data_offset));
+    __ movzxw(temp, Address(arg, index, TIMES_1, data_offset));
+    __ cmpl(out, temp);
+    __ j(kNotEqual, &return_false);
+    __ addq(index, Immediate(2));
+  }
+  __ Bind(&tail1);
+  if (element_size == 1u) {
+    __ testl(count, Immediate(1));
+    __ j(kZero, &return_true);
+    __ movzxb(out, Address(array, index, TIMES_1, data_offset));
+    __ movzxb(temp, Address(arg, index, TIMES_1, data_offset));
+    __ cmpl(out, temp);
+    __ j(kNotEqual, &return_false);
+  }
+
+  __ Bind(&return_true);
+  __ movl(out, Immediate(1));
+  __ jmp(&end);
+
+  __ Bind(&return_false);
+  __ xorl(out, out);
+  __ Bind(&end);
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitArraysEqualsByte(HInvoke* invoke) {
+  CreateArraysEqualsLocations(arena_, invoke);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitArraysEqualsByte(HInvoke* invoke) {
+  GenArraysEquals(invoke, GetAssembler(), Primitive::kPrimByte);
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitArraysEqualsChar(HInvoke* invoke) {
+  CreateArraysEqualsLocations(arena_, invoke);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitArraysEqualsChar(HInvoke* invoke) {
+  GenArraysEquals(invoke, GetAssembler(), Primitive::kPrimChar);
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitArraysEqualsInt(HInvoke* invoke) {
+  CreateArraysEqualsLocations(arena_, invoke);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitArraysEqualsInt(HInvoke* invoke) {
+  GenArraysEquals(invoke, GetAssembler(), Primitive::kPrimInt);
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitArraysEqualsLong(HInvoke* invoke) {
+  CreateArraysEqualsLocations(arena_, invoke);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitArraysEqualsLong(HInvoke* invoke) {
+  GenArraysEquals(invoke, GetAssembler(), Primitive::kPrimLong);
+}
+
 static void CreateStringIndexOfLocations(HInvoke* invoke,
                                          ArenaAllocator* allocator,
                                          bool start_at_zero) {
@@ -1900,6 +2191,123 @@ void IntrinsicCodeGeneratorX86_64::VisitStringNewStringFromString(HInvoke* invok
   __ Bind(slow_path->GetExitLabel());
 }
 
+void IntrinsicLocationsBuilderX86_64::VisitStringHashCode(HInvoke* invoke) {
+  LocationSummary* locations = new (arena_) LocationSummary(invoke,
+                                                            LocationSummary::kNoCall,
+                                                            kIntrinsified);
+  locations->SetInAt(0, Location::RequiresRegister());
+  // Temporaries for the remaining length, the data pointer and two characters.
+  locations->AddTemp(Location::RequiresRegister());
+  locations->AddTemp(Location::RequiresRegister());
+  locations->AddTemp(Location::RequiresRegister());
+  locations->AddTemp(Location::RequiresRegister());
+  locations->SetOut(Location::RequiresRegister(), Location::kOutputOverlap);
+}
+
+// Emits the hash loop over the characters of `str` for one character width. The loop consumes
+// four characters per iteration as h' = h * 31^4 + (c0 * 31^3 + c1 * 31^2 + c2 * 31 + c3), where
+// only the final multiply and add depend on the previous iteration.
+static void GenStringHashCodeLoop(X86_64Assembler* assembler,
+                                  LocationSummary* locations,
+                                  CpuRegister str,
+                                  CpuRegister count,
+                                  bool compressed,
+                                  Label* store) {
+  CpuRegister out = locations->Out().AsRegister<CpuRegister>();
+  CpuRegister ptr = locations->GetTemp(1).AsRegister<CpuRegister>();
+  CpuRegister c0 = locations->GetTemp(2).AsRegister<CpuRegister>();
+  CpuRegister c1 = locations->GetTemp(3).AsRegister<CpuRegister>();
+
+  const int32_t value_offset = mirror::String::ValueOffset().Int32Value();
+  const int32_t char_size = compressed ? sizeof(uint8_t) : sizeof(uint16_t);
+
+  NearLabel loop, tail, tail_loop;
+
+  auto load_char = [&](CpuRegister dst, const Address& src) {
+    if (compressed) {
+      __ movzxb(dst, src);
+    } else {
+      __ movzxw(dst, src);
+    }
+  };
+
+  __ leaq(ptr, Address(str, value_offset));
+  __ subl(count, Immediate(4));
+  __ j(kLess, &tail);
+  __ Bind(&loop);
+  load_char(c0, Address(ptr, 0));
+  __ imull(c0, c0, Immediate(31 * 31 * 31));
+  load_char(c1, Address(ptr, char_size));
+  __ imull(c1, c1, Immediate(31 * 31));
+  __ addl(c0, c1);
+  load_char(c1, Address(ptr, 2 * char_size));
+  __ imull(c1, c1, Immediate(31));
+  __ addl(c0, c1);
+  load_char(c1, Address(ptr, 3 * char_size));
+  __ addl(c0, c1);
+  __ imull(out, out, Immediate(31 * 31 * 31 * 31));
+  __ addl(out, c0);
+  __ addq(ptr, Immediate(4 * char_size));
+  __ subl(count, Immediate(4));
+  __ j(kGreaterEqual, &loop);
+
+  // At most three characters remain, h' = h * 31 + c.
+  __ Bind(&tail);
+  __ addl(count, Immediate(4));
+  __ j(kEqual, store);
+  __ Bind(&tail_loop);
+  load_char(c0, Address(ptr, 0));
+  __ imull(out, out, Immediate(31));
+  __ addl(out, c0);
+  __ addq(ptr, Immediate(char_size));
+  __ subl(count, Immediate(1));
+  __ j(kNotEqual, &tail_loop);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitStringHashCode(HInvoke* invoke) {
+  X86_64Assembler* assembler = GetAssembler();
+  LocationSummary* locations = invoke->GetLocations();
+
+  CpuRegister str = locations->InAt(0).AsRegister<CpuRegister>();
+  CpuRegister out = locations->Out().AsRegister<CpuRegister>();
+  CpuRegister count = locations->GetTemp(0).AsRegister<CpuRegister>();
+
+  // The two loops are too long for near jumps to these labels.
+  Label store, done;
+
+  const int32_t count_offset = mirror::String::CountOffset().Int32Value();
+  const int32_t hash_offset = mirror::String::HashCodeOffset().Int32Value();
+
+  // Note that the null check must have been done earlier.
+  DCHECK(!invoke->CanDoImplicitNullCheckOn(invoke->InputAt(0)));
+
+  // Return the cached hash code if there is one.
+  __ movl(out, Address(str, hash_offset));
+  __ testl(out, out);
+  __ j(kNotEqual, &done);
+
+  __ movl(count, Address(str, count_offset));
+  if (mirror::kUseStringCompression) {
+    NearLabel uncompressed;
+    static_assert(static_cast<uint32_t>(mirror::StringCompressionFlag::kCompressed) == 0u,
+                  "Expecting 0=compressed, 1=uncompressed");
+    // Extract the length, the compression flag goes to the carry flag.
+    __ shrl(count, Immediate(1));
+    __ j(kCarrySet, &uncompressed);
+    GenStringHashCodeLoop(assembler, locations, str, count, /* compressed */ true, &store);
+    __ jmp(&store);
+    __ Bind(&uncompressed);
+  }
+  GenStringHashCodeLoop(assembler, locations, str, count, /* compressed */ false, &store);
+
+  // Cache a non-zero hash code. Racing stores write the same value.
+  __ Bind(&store);
+  __ testl(out, out);
+  __ j(kEqual, &done);
+  __ movl(Address(str, hash_offset), out);
+  __ Bind(&done);
+}
+
 void IntrinsicLocationsBuilderX86_64::VisitStringGetCharsNoCheck(HInvoke* invoke) {
   // public void getChars(int srcBegin, int srcEnd, char[] dst, int dstBegin);
   LocationSummary* locations = new (arena_) LocationSummary(invoke,
@@ -2532,6 +2940,82 @@ void IntrinsicCodeGeneratorX86_64::VisitUnsafeCASObject(HInvoke* invoke) {
   GenCAS(Primitive::kPrimNot, invoke, codegen_);
 }
 
+static void CreateIntIntIntIntToInt(ArenaAllocator* arena, HInvoke* invoke) {
+  LocationSummary* locations = new (arena) LocationSummary(invoke,
+                                                           LocationSummary::kNoCall,
+                                                           kIntrinsified);
+  locations->SetInAt(0, Location::NoLocation());        // Unused receiver.
+  locations->SetInAt(1, Location::RequiresRegister());
+  locations->SetInAt(2, Location::RequiresRegister());
+  locations->SetInAt(3, Location::RequiresRegister());
+  // The output is written before the inputs are last read.
+  locations->SetOut(Location::RequiresRegister(), Location::kOutputOverlap);
+}
+
+// Generates Unsafe.getAndAdd* with LOCK XADD and Unsafe.getAndSet* with XCHG, which is
+// implicitly locked with a memory operand. Both are full barriers.
+static void GenGetAndUpdate(HInvoke* invoke,
+                            Primitive::Type type,
+                            bool is_add,
+                            CodeGeneratorX86_64* codegen) {
+  X86_64Assembler* assembler = down_cast<X86_64Assembler*>(codegen->GetAssembler());
+  LocationSummary* locations = invoke->GetLocations();
+  CpuRegister base = locations->InAt(1).AsRegister<CpuRegister>();
+  CpuRegister offset = locations->InAt(2).AsRegister<CpuRegister>();
+  CpuRegister value = locations->InAt(3).AsRegister<CpuRegister>();
+  CpuRegister out = locations->Out().AsRegister<CpuRegister>();
+  Address field_address(base, offset, ScaleFactor::TIMES_1, 0);
+
+  if (type == Primitive::kPrimLong) {
+    __ movq(out, value);
+    if (is_add) {
+      __ LockXaddq(field_address, out);
+    } else {
+      __ xchgq(out, field_address);
+    }
+  } else {
+    DCHECK_EQ(type, Primitive::kPrimInt);
+    __ movl(out, value);
+    if (is_add) {
+      __ LockXaddl(field_address, out);
+    } else {
+      __ xchgl(out, field_address);
+    }
+  }
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitUnsafeGetAndAddInt(HInvoke* invoke) {
+  CreateIntIntIntIntToInt(arena_, invoke);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitUnsafeGetAndAddInt(HInvoke* invoke) {
+  GenGetAndUpdate(invoke, Primitive::kPrimInt, /* is_add */ true, codegen_);
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitUnsafeGetAndAddLong(HInvoke* invoke) {
+  CreateIntIntIntIntToInt(arena_, invoke);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitUnsafeGetAndAddLong(HInvoke* invoke) {
+  GenGetAndUpdate(invoke, Primitive::kPrimLong, /* is_add */ true, codegen_);
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitUnsafeGetAndSetInt(HInvoke* invoke) {
+  CreateIntIntIntIntToInt(arena_, invoke);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitUnsafeGetAndSetInt(HInvoke* invoke) {
+  GenGetAndUpdate(invoke, Primitive::kPrimInt, /* is_add */ false, codegen_);
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitUnsafeGetAndSetLong(HInvoke* invoke) {
+  CreateIntIntIntIntToInt(arena_, invoke);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitUnsafeGetAndSetLong(HInvoke* invoke) {
+  GenGetAndUpdate(invoke, Primitive::kPrimLong, /* is_add */ false, codegen_);
+}
+
 void IntrinsicLocationsBuilderX86_64::VisitIntegerReverse(HInvoke* invoke) {
   LocationSummary* locations = new (arena_) LocationSummary(invoke,
                                                            LocationSummary::kNoCall,
@@ -2957,73 +3441,146 @@ void IntrinsicCodeGeneratorX86_64::VisitLongNumberOfTrailingZeros(HInvoke* invok
   GenTrailingZeros(GetAssembler(), codegen_, invoke, /* is_long */ true);
 }
 
-void IntrinsicLocationsBuilderX86_64::VisitIntegerValueOf(HInvoke* invoke) {
+static void CreateValueOfLocations(HInvoke* invoke, CodeGeneratorX86_64* codegen) {
   InvokeRuntimeCallingConvention calling_convention;
-  IntrinsicVisitor::ComputeIntegerValueOfLocations(
+  IntrinsicVisitor::ComputeValueOfLocations(
       invoke,
-      codegen_,
+      codegen,
       Location::RegisterLocation(RAX),
       Location::RegisterLocation(calling_convention.GetRegisterAt(0)));
 }
 
-void IntrinsicCodeGeneratorX86_64::VisitIntegerValueOf(HInvoke* invoke) {
-  IntrinsicVisitor::IntegerValueOfInfo info = IntrinsicVisitor::ComputeIntegerValueOfInfo();
+// Stores `value` to the `value` field of the freshly allocated box `out`.
+static void StoreBoxValue(X86_64Assembler* assembler,
+                          Primitive::Type type,
+                          const Address& address,
+                          CpuRegister value) {
+  switch (type) {
+    case Primitive::kPrimLong:
+      __ movq(address, value);
+      break;
+    case Primitive::kPrimInt:
+      __ movl(address, value);
+      break;
+    case Primitive::kPrimShort:
+    case Primitive::kPrimChar:
+      __ movw(address, value);
+      break;
+    case Primitive::kPrimByte:
+      __ movb(address, value);
+      break;
+    default:
+      LOG(FATAL) << "Unexpected box value type " << type;
+      UNREACHABLE();
+  }
+}
+
+// Generates code for Integer.valueOf and the other box cache intrinsics.
+static void GenValueOf(HInvoke* invoke, CodeGeneratorX86_64* codegen) {
+  IntrinsicVisitor::ValueOfInfo info = IntrinsicVisitor::ComputeValueOfInfo(invoke->GetIntrinsic());
   LocationSummary* locations = invoke->GetLocations();
-  X86_64Assembler* assembler = GetAssembler();
+  X86_64Assembler* assembler = codegen->GetAssembler();
+  const Primitive::Type type = info.value_type;
 
   CpuRegister out = locations->Out().AsRegister<CpuRegister>();
   InvokeRuntimeCallingConvention calling_convention;
+  CpuRegister argument = CpuRegister(calling_convention.GetRegisterAt(0));
   if (invoke->InputAt(0)->IsConstant()) {
-    int32_t value = invoke->InputAt(0)->AsIntConstant()->GetValue();
+    int64_t value = Int64FromConstant(invoke->InputAt(0)->AsConstant());
     if (value >= info.low && value <= info.high) {
-      // Just embed the j.l.Integer in the code.
+      // Just embed the box in the code.
       ScopedObjectAccess soa(Thread::Current());
-      mirror::Object* boxed = info.cache->Get(value + (-info.low));
+      mirror::Object* boxed = info.cache->Get(static_cast<int32_t>(value - info.low));
       DCHECK(boxed != nullptr && Runtime::Current()->GetHeap()->ObjectIsInBootImageSpace(boxed));
       uint32_t address = dchecked_integral_cast<uint32_t>(reinterpret_cast<uintptr_t>(boxed));
       __ movl(out, Immediate(static_cast<int32_t>(address)));
     } else {
-      // Allocate and initialize a new j.l.Integer.
-      // TODO: If we JIT, we could allocate the j.l.Integer now, and store it in the
+      // Allocate and initialize a new box.
+      // TODO: If we JIT, we could allocate the box now, and store it in the
       // JIT object table.
-      CpuRegister argument = CpuRegister(calling_convention.GetRegisterAt(0));
-      uint32_t address = dchecked_integral_cast<uint32_t>(reinterpret_cast<uintptr_t>(info.integer));
+      uint32_t address =
+          dchecked_integral_cast<uint32_t>(reinterpret_cast<uintptr_t>(info.boxed_class));
       __ movl(argument, Immediate(static_cast<int32_t>(address)));
-      codegen_->InvokeRuntime(kQuickAllocObjectInitialized, invoke, invoke->GetDexPc());
+      codegen->InvokeRuntime(kQuickAllocObjectInitialized, invoke, invoke->GetDexPc());
       CheckEntrypointTypes<kQuickAllocObjectWithChecks, void*, mirror::Class*>();
-      __ movl(Address(out, info.value_offset), Immediate(value));
+      // The argument register is free again after the call.
+      codegen->Load64BitValue(argument, value);
+      StoreBoxValue(assembler, type, Address(out, info.value_offset), argument);
     }
   } else {
     CpuRegister in = locations->InAt(0).AsRegister<CpuRegister>();
     // Check bounds of our cache.
-    __ leal(out, Address(in, -info.low));
-    __ cmpl(out, Immediate(info.high - info.low + 1));
+    if (type == Primitive::kPrimLong) {
+      __ leaq(out, Address(in, -info.low));
+      __ cmpq(out, Immediate(info.high - info.low + 1));
+    } else {
+      __ leal(out, Address(in, -info.low));
+      __ cmpl(out, Immediate(info.high - info.low + 1));
+    }
     NearLabel allocate, done;
     __ j(kAboveEqual, &allocate);
-    // If the value is within the bounds, load the j.l.Integer directly from the array.
+    // If the value is within the bounds, load the box directly from the array.
     uint32_t data_offset = mirror::Array::DataOffset(kHeapReferenceSize).Uint32Value();
     uint32_t address = dchecked_integral_cast<uint32_t>(reinterpret_cast<uintptr_t>(info.cache));
     if (data_offset + address <= std::numeric_limits<int32_t>::max()) {
       __ movl(out, Address(out, TIMES_4, data_offset + address));
     } else {
-      CpuRegister temp = CpuRegister(calling_convention.GetRegisterAt(0));
-      __ movl(temp, Immediate(static_cast<int32_t>(data_offset + address)));
-      __ movl(out, Address(temp, out, TIMES_4, 0));
+      __ movl(argument, Immediate(static_cast<int32_t>(data_offset + address)));
+      __ movl(out, Address(argument, out, TIMES_4, 0));
     }
     __ MaybeUnpoisonHeapReference(out);
     __ jmp(&done);
     __ Bind(&allocate);
-    // Otherwise allocate and initialize a new j.l.Integer.
-    CpuRegister argument = CpuRegister(calling_convention.GetRegisterAt(0));
-    address = dchecked_integral_cast<uint32_t>(reinterpret_cast<uintptr_t>(info.integer));
+    // Otherwise allocate and initialize a new box.
+    address = dchecked_integral_cast<uint32_t>(reinterpret_cast<uintptr_t>(info.boxed_class));
     __ movl(argument, Immediate(static_cast<int32_t>(address)));
-    codegen_->InvokeRuntime(kQuickAllocObjectInitialized, invoke, invoke->GetDexPc());
+    codegen->InvokeRuntime(kQuickAllocObjectInitialized, invoke, invoke->GetDexPc());
     CheckEntrypointTypes<kQuickAllocObjectWithChecks, void*, mirror::Class*>();
-    __ movl(Address(out, info.value_offset), in);
+    StoreBoxValue(assembler, type, Address(out, info.value_offset), in);
     __ Bind(&done);
   }
 }
 
+void IntrinsicLocationsBuilderX86_64::VisitIntegerValueOf(HInvoke* invoke) {
+  CreateValueOfLocations(invoke, codegen_);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitIntegerValueOf(HInvoke* invoke) {
+  GenValueOf(invoke, codegen_);
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitLongValueOf(HInvoke* invoke) {
+  CreateValueOfLocations(invoke, codegen_);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitLongValueOf(HInvoke* invoke) {
+  GenValueOf(invoke, codegen_);
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitShortValueOf(HInvoke* invoke) {
+  CreateValueOfLocations(invoke, codegen_);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitShortValueOf(HInvoke* invoke) {
+  GenValueOf(invoke, codegen_);
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitCharacterValueOf(HInvoke* invoke) {
+  CreateValueOfLocations(invoke, codegen_);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitCharacterValueOf(HInvoke* invoke) {
+  GenValueOf(invoke, codegen_);
+}
+
+void IntrinsicLocationsBuilderX86_64::VisitByteValueOf(HInvoke* invoke) {
+  CreateValueOfLocations(invoke, codegen_);
+}
+
+void IntrinsicCodeGeneratorX86_64::VisitByteValueOf(HInvoke* invoke) {
+  GenValueOf(invoke, codegen_);
+}
+
 void IntrinsicLocationsBuilderX86_64::VisitThreadInterrupted(HInvoke* invoke) {
   LocationSummary* locations = new (arena_) LocationSummary(invoke,
                                                             LocationSummary::kNoCall,
@@ -3049,6 +3606,9 @@ UNIMPLEMENTED_INTRINSIC(X86_64, ReferenceGetReferent)
 UNIMPLEMENTED_INTRINSIC(X86_64, FloatIsInfinite)
 UNIMPLEMENTED_INTRINSIC(X86_64, DoubleIsInfinite)
 
+UNIMPLEMENTED_INTRINSIC(X86_64, CRC32Update)
+UNIMPLEMENTED_INTRINSIC(X86_64, CRC32UpdateBytes)
+
 UNIMPLEMENTED_INTRINSIC(X86_64, StringStringIndexOf);
 UNIMPLEMENTED_INTRINSIC(X86_64, StringStringIndexOfAfter);
 UNIMPLEMENTED_INTRINSIC(X86_64, StringBufferAppend);
@@ -3059,10 +3619,6 @@ UNIMPLEMENTED_INTRINSIC(X86_64, StringBuilderLength);
 UNIMPLEMENTED_INTRINSIC(X86_64, StringBuilderToString);
 
 // 1.8.
-UNIMPLEMENTED_INTRINSIC(X86_64, UnsafeGetAndAddInt)
-UNIMPLEMENTED_INTRINSIC(X86_64, UnsafeGetAndAddLong)
-UNIMPLEMENTED_INTRINSIC(X86_64, UnsafeGetAndSetInt)
-UNIMPLEMENTED_INTRINSIC(X86_64, UnsafeGetAndSetLong)
 UNIMPLEMENTED_INTRINSIC(X86_64, UnsafeGetAndSetObject)
 
 UNREACHABLE_INTRINSICS(X86_64)
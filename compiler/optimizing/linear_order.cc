@@ -50,6 +50,81 @@ static void AddToListForLinearization(ArenaVector<HBasicBlock*>* worklist, HBasi
   worklist->insert(insert_pos.base(), block);
 }
 
+// Returns whether the branch profile shows that the edge from `predecessor` to `block`
+// is (almost) never taken.
+static bool IsUncommonEdge(HBasicBlock* predecessor, HBasicBlock* block) {
+  HInstruction* last_instruction = predecessor->GetLastInstruction();
+  if (!last_instruction->IsIf()) {
+    return false;
+  }
+  HIf* if_instruction = last_instruction->AsIf();
+  if (if_instruction->IfTrueSuccessor() == if_instruction->IfFalseSuccessor()) {
+    return false;
+  }
+  return block == if_instruction->IfTrueSuccessor()
+      ? if_instruction->IsTrueSuccessorUncommon()
+      : if_instruction->IsFalseSuccessorUncommon();
+}
+
+// Helper method to find the blocks that can be placed after all the other ones: blocks outside
+// of loops and try/catch regions that only lead to the exit, and which are either post
+// dominated by a throw (see CodeSinking) or only reached through uncommon branches.
+static void FindUncommonBlocks(const HGraph* graph,
+                               ArenaAllocator* allocator,
+                               ArenaBitVector* uncommon_blocks) {
+  ArenaBitVector leads_to_exit(
+      allocator, graph->GetBlocks().size(), /* expandable */ false, kArenaAllocLinearOrder);
+  // (1): Walk backwards from the exit for the blocks post dominated by a throw.
+  for (HBasicBlock* block : graph->GetPostOrder()) {
+    if (block->IsEntryBlock() ||
+        block->IsExitBlock() ||
+        block->GetLoopInformation() != nullptr ||
+        block->GetTryCatchInformation() != nullptr) {
+      continue;
+    }
+    bool only_exit_successors = true;
+    bool only_uncommon_successors = true;
+    bool is_leading_to_exit = true;
+    for (HBasicBlock* successor : block->GetSuccessors()) {
+      if (successor->IsExitBlock()) {
+        continue;
+      }
+      only_exit_successors = false;
+      if (!leads_to_exit.IsBitSet(successor->GetBlockId())) {
+        is_leading_to_exit = false;
+        break;
+      }
+      only_uncommon_successors &= uncommon_blocks->IsBitSet(successor->GetBlockId());
+    }
+    if (!is_leading_to_exit) {
+      continue;
+    }
+    leads_to_exit.SetBit(block->GetBlockId());
+    if (block->GetLastInstruction()->IsThrow() ||
+        (!only_exit_successors && only_uncommon_successors)) {
+      uncommon_blocks->SetBit(block->GetBlockId());
+    }
+  }
+  // (2): Walk forwards for the blocks only reached through uncommon branches.
+  for (HBasicBlock* block : graph->GetReversePostOrder()) {
+    if (!leads_to_exit.IsBitSet(block->GetBlockId()) ||
+        uncommon_blocks->IsBitSet(block->GetBlockId())) {
+      continue;
+    }
+    bool is_uncommon = true;
+    for (HBasicBlock* predecessor : block->GetPredecessors()) {
+      if (!uncommon_blocks->IsBitSet(predecessor->GetBlockId()) &&
+          !IsUncommonEdge(predecessor, block)) {
+        is_uncommon = false;
+        break;
+      }
+    }
+    if (is_uncommon) {
+      uncommon_blocks->SetBit(block->GetBlockId());
+    }
+  }
+}
+
 // Helper method to validate linear order.
 static bool IsLinearOrderWellFormed(const HGraph* graph, ArenaVector<HBasicBlock*>* linear_order) {
   for (HBasicBlock* header : graph->GetBlocks()) {
@@ -85,7 +160,8 @@ void LinearizeGraph(const HGraph* graph,
   DCHECK(linear_order->empty());
   // Create a reverse post ordering with the following properties:
   // - Blocks in a loop are consecutive,
-  // - Back-edge is the last block before loop exits.
+  // - Back-edge is the last block before loop exits,
+  // - Uncommon blocks are after all the other blocks, which keeps the common path dense.
   //
   // (1): Record the number of forward predecessors for each block. This is to
   //      ensure the resulting order is reverse post order. We could use the
@@ -105,22 +181,41 @@ void LinearizeGraph(const HGraph* graph,
   //      iterate over the successors. When all non-back edge predecessors of a
   //      successor block are visited, the successor block is added in the worklist
   //      following an order that satisfies the requirements to build our linear graph.
+  //      Uncommon blocks are set aside until the worklist is empty. They only lead to
+  //      the exit, so placing them last keeps the order a reverse post order.
+  ArenaBitVector uncommon_blocks(
+      allocator, graph->GetBlocks().size(), /* expandable */ false, kArenaAllocLinearOrder);
+  FindUncommonBlocks(graph, allocator, &uncommon_blocks);
   linear_order->reserve(graph->GetReversePostOrder().size());
   ArenaVector<HBasicBlock*> worklist(allocator->Adapter(kArenaAllocLinearOrder));
+  ArenaVector<HBasicBlock*> uncommon_worklist(allocator->Adapter(kArenaAllocLinearOrder));
+  bool placing_uncommon_blocks = false;
   worklist.push_back(graph->GetEntryBlock());
-  do {
-    HBasicBlock* current = worklist.back();
-    worklist.pop_back();
-    linear_order->push_back(current);
-    for (HBasicBlock* successor : current->GetSuccessors()) {
-      int block_id = successor->GetBlockId();
-      size_t number_of_remaining_predecessors = forward_predecessors[block_id];
-      if (number_of_remaining_predecessors == 1) {
-        AddToListForLinearization(&worklist, successor);
+  while (true) {
+    while (!worklist.empty()) {
+      HBasicBlock* current = worklist.back();
+      worklist.pop_back();
+      linear_order->push_back(current);
+      for (HBasicBlock* successor : current->GetSuccessors()) {
+        int block_id = successor->GetBlockId();
+        size_t number_of_remaining_predecessors = forward_predecessors[block_id];
+        if (number_of_remaining_predecessors == 1) {
+          if (!placing_uncommon_blocks && uncommon_blocks.IsBitSet(block_id)) {
+            uncommon_worklist.push_back(successor);
+          } else {
+            AddToListForLinearization(&worklist, successor);
+          }
+        }
+        forward_predecessors[block_id] = number_of_remaining_predecessors - 1;
       }
-      forward_predecessors[block_id] = number_of_remaining_predecessors - 1;
     }
-  } while (!worklist.empty());
+    if (placing_uncommon_blocks || uncommon_worklist.empty()) {
+      break;
+    }
+    // (3): Place the uncommon blocks, in the order they were found.
+    placing_uncommon_blocks = true;
+    worklist.assign(uncommon_worklist.rbegin(), uncommon_worklist.rend());
+  }
 
   DCHECK(graph->HasIrreducibleLoops() || IsLinearOrderWellFormed(graph, linear_order));
 }
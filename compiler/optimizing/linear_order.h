@@ -23,7 +23,9 @@ namespace art {
 
 // Linearizes the 'graph' such that:
 // (1): a block is always after its dominator,
-// (2): blocks of loops are contiguous.
+// (2): blocks of loops are contiguous,
+// (3): uncommon blocks (throwing paths, and paths the branch profile shows are almost never
+//      taken) are after all the other blocks.
 //
 // Storage is obtained through 'allocator' and the linear order it computed
 // into 'linear_order'. Once computed, iteration can be expressed as:
@@ -242,4 +242,47 @@ TEST_F(LinearizeTest, CFG7) {
   TestCode(data, blocks);
 }
 
+TEST_F(LinearizeTest, ThrowingBlockIsLast) {
+  // Structure of this graph
+  //            Block0
+  //              |
+  //            Block1
+  //            /    \
+  //   Block(throw) Block(return)
+  //             \   /
+  //             Exit
+  //
+  // The throwing block is uncommon and must be placed after the returning one.
+  const uint16_t data[] = ONE_REGISTER_CODE_ITEM(
+    Instruction::CONST_4 | 0 | 0,
+    Instruction::IF_NEZ, 3,
+    Instruction::THROW | 0 << 8,
+    Instruction::RETURN_VOID);
+
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+  HGraph* graph = CreateCFG(&allocator, data);
+  std::unique_ptr<const X86InstructionSetFeatures> features_x86(
+      X86InstructionSetFeatures::FromCppDefines());
+  x86::CodeGeneratorX86 codegen(graph, *features_x86.get(), CompilerOptions());
+  SsaLivenessAnalysis liveness(graph, &codegen);
+  liveness.Analyze();
+
+  size_t throw_index = graph->GetLinearOrder().size();
+  size_t return_index = graph->GetLinearOrder().size();
+  for (size_t i = 0; i < graph->GetLinearOrder().size(); ++i) {
+    HInstruction* last_instruction = graph->GetLinearOrder()[i]->GetLastInstruction();
+    if (last_instruction->IsThrow()) {
+      throw_index = i;
+    } else if (last_instruction->IsReturnVoid()) {
+      return_index = i;
+    }
+  }
+  ASSERT_LT(return_index, throw_index);
+  ASSERT_LT(throw_index, graph->GetLinearOrder().size());
+  // Only the exit block follows the throwing block.
+  ASSERT_EQ(throw_index + 2, graph->GetLinearOrder().size());
+  ASSERT_TRUE(graph->GetLinearOrder().back()->IsExitBlock());
+}
+
 }  // namespace art
@@ -214,6 +214,17 @@ class HeapLocationCollector : public HGraphVisitor {
     return nullptr;
   }
 
+  size_t GetFieldHeapLocation(HInstruction* object, const FieldInfo* field) const {
+    DCHECK(object != nullptr);
+    DCHECK(field != nullptr);
+    HInstruction* original_ref = HuntForOriginalReference(object);
+    ReferenceInfo* ref_info = FindReferenceInfoOf(original_ref);
+    return FindHeapLocationIndex(ref_info,
+                                 field->GetFieldOffset().SizeValue(),
+                                 nullptr,
+                                 field->GetDeclaringClassDefIndex());
+  }
+
   size_t GetArrayAccessHeapLocation(HInstruction* array, HInstruction* index) const {
     DCHECK(array != nullptr);
     DCHECK(index != nullptr);
@@ -31,6 +31,13 @@ namespace art {
 // Enables vectorization (SIMDization) in the loop optimizer.
 static constexpr bool kEnableVectorization = true;
 
+// Enables full unrolling of scalar loops with a small known trip count.
+static constexpr bool kEnableScalarUnrolling = true;
+
+// Scalar unrolling limits: trip count and total number of body instructions after unrolling.
+static constexpr int64_t kMaxScalarUnrollTripCount = 8;
+static constexpr size_t kMaxScalarUnrollInstructions = 48;
+
 // All current SIMD targets want 16-byte alignment.
 static constexpr size_t kAlignedBase = 16;
 
@@ -254,6 +261,27 @@ static bool IsAddConst(HInstruction* instruction,
   return false;
 }
 
+// Create a condition of the same kind as the given one on new operands.
+static HInstruction* CloneCondition(ArenaAllocator* allocator,
+                                    HInstruction* condition,
+                                    HInstruction* lhs,
+                                    HInstruction* rhs) {
+  switch (condition->AsCondition()->GetCondition()) {
+    case kCondEQ: return new (allocator) HEqual(lhs, rhs);
+    case kCondNE: return new (allocator) HNotEqual(lhs, rhs);
+    case kCondLT: return new (allocator) HLessThan(lhs, rhs);
+    case kCondLE: return new (allocator) HLessThanOrEqual(lhs, rhs);
+    case kCondGT: return new (allocator) HGreaterThan(lhs, rhs);
+    case kCondGE: return new (allocator) HGreaterThanOrEqual(lhs, rhs);
+    case kCondB:  return new (allocator) HBelow(lhs, rhs);
+    case kCondBE: return new (allocator) HBelowOrEqual(lhs, rhs);
+    case kCondA:  return new (allocator) HAbove(lhs, rhs);
+    case kCondAE: return new (allocator) HAboveOrEqual(lhs, rhs);
+  }
+  LOG(FATAL) << "Unexpected condition";
+  UNREACHABLE();
+}
+
 // Test vector restrictions.
 static bool HasVectorRestrictions(uint64_t restrictions, uint64_t tested) {
   return (restrictions & tested) != 0;
@@ -287,8 +315,10 @@ HLoopOptimization::HLoopOptimization(HGraph* graph,
       vector_length_(0),
       vector_refs_(nullptr),
       vector_peeling_candidate_(nullptr),
-      vector_runtime_test_a_(nullptr),
-      vector_runtime_test_b_(nullptr),
+      vector_runtime_test_a_(),
+      vector_runtime_test_b_(),
+      vector_runtime_test_range_(),
+      vector_num_runtime_tests_(0),
       vector_map_(nullptr) {
 }
 
@@ -561,6 +591,92 @@ void HLoopOptimization::OptimizeInnerLoop(LoopNode* node) {
       return;
     }
   }
+
+  // Otherwise, fully unroll a loop with a small known trip count, if possible.
+  if (kEnableScalarUnrolling) {
+    iset_->clear();  // prepare phi induction
+    if (TrySetSimpleLoopHeader(header) &&
+        ShouldUnrollScalar(node, body, trip_count) &&
+        TryAssignLastValue(node->loop_info, phi, preheader, /*collect_loop_uses*/ true)) {
+      UnrollScalar(node, body, exit, trip_count);
+      return;
+    }
+  }
+}
+
+//
+// Scalar loop unrolling. This reuses the sequential mode of the vectorizer
+// synthesis below, and thus only applies to loop-bodies it accepts.
+//
+
+bool HLoopOptimization::ShouldUnrollScalar(LoopNode* node,
+                                           HBasicBlock* block,
+                                           int64_t trip_count) {
+  // Only consider a known trip count that is small, but larger than one (which is
+  // already handled above), with a body that fits the code size budget once unrolled.
+  if (trip_count <= 1 ||
+      trip_count > kMaxScalarUnrollTripCount ||
+      block->GetInstructions().CountSize() * trip_count > kMaxScalarUnrollInstructions) {
+    return false;
+  }
+
+  // Reset vector bookkeeping.
+  vector_length_ = 0;
+  vector_refs_->clear();
+  vector_peeling_candidate_ = nullptr;
+  vector_num_runtime_tests_ = 0;
+
+  // Phis in the loop-body prevent unrolling.
+  if (!block->GetPhis().IsEmpty()) {
+    return false;
+  }
+
+  // Scan the loop-body as for vectorization. No data dependence analysis is needed,
+  // since the unrolled body keeps all references in original program order.
+  for (HInstructionIterator it(block->GetInstructions()); !it.Done(); it.Advance()) {
+    if (!VectorizeDef(node, it.Current(), /*generate_code*/ false)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void HLoopOptimization::UnrollScalar(LoopNode* node,
+                                     HBasicBlock* block,
+                                     HBasicBlock* exit,
+                                     int64_t trip_count) {
+  HBasicBlock* header = node->loop_info->GetHeader();
+  HBasicBlock* preheader = node->loop_info->GetPreHeader();
+
+  // Adjust vector bookkeeping.
+  iset_->clear();  // prepare phi induction
+  bool is_simple_loop_header = TrySetSimpleLoopHeader(header);  // fills iset_
+  DCHECK(is_simple_loop_header);
+  vector_header_ = header;
+  vector_body_ = block;
+
+  // Generate a loop that executes all iterations at once:
+  // for (i = 0; i < stc; i += 1)
+  //    <loop-body> x trip_count
+  HInstruction* stc = induction_range_.GenerateTripCount(node->loop_info, graph_, preheader);
+  vector_index_ = graph_->GetIntConstant(0);
+  vector_mode_ = kSequential;
+  GenerateNewLoop(node,
+                  block,
+                  graph_->TransformLoopForVectorization(vector_header_, vector_body_, exit),
+                  vector_index_,
+                  stc,
+                  graph_->GetIntConstant(1),
+                  static_cast<uint32_t>(trip_count));
+  HLoopInformation* uloop = vector_header_->GetLoopInformation();
+
+  // Remove the original loop, as done after vectorization.
+  block->DisconnectAndDelete();
+  while (!header->GetFirstInstruction()->IsGoto()) {
+    header->RemoveInstruction(header->GetFirstInstruction());
+  }
+  header->SetLoopInformation(preheader->GetLoopInformation());  // outward
+  node->loop_info = uloop;
 }
 
 //
@@ -574,8 +690,7 @@ bool HLoopOptimization::ShouldVectorize(LoopNode* node, HBasicBlock* block, int6
   vector_length_ = 0;
   vector_refs_->clear();
   vector_peeling_candidate_ = nullptr;
-  vector_runtime_test_a_ =
-  vector_runtime_test_b_= nullptr;
+  vector_num_runtime_tests_ = 0;
 
   // Phis in the loop-body prevent vectorization.
   if (!block->GetPhis().IsEmpty()) {
@@ -601,6 +716,8 @@ bool HLoopOptimization::ShouldVectorize(LoopNode* node, HBasicBlock* block, int6
   // aliased, as well as the property that references either point to the same
   // array or to two completely disjoint arrays, i.e., no partial aliasing.
   // Other than a few simply heuristics, no detailed subscript analysis is done.
+  // Dependences that cannot be ruled out statically are guarded by runtime tests
+  // that select between the vector loop and the sequential cleanup loop.
   for (auto i = vector_refs_->begin(); i != vector_refs_->end(); ++i) {
     for (auto j = i; ++j != vector_refs_->end(); ) {
       if (i->type == j->type && (i->lhs || j->lhs)) {
@@ -611,24 +728,21 @@ bool HLoopOptimization::ShouldVectorize(LoopNode* node, HBasicBlock* block, int6
         HInstruction* y = j->offset;
         if (a == b) {
           // Found a[i+x] vs. a[i+y]. Accept if x == y (loop-independent data dependence).
-          // Conservatively assume a loop-carried data dependence otherwise, and reject.
-          if (x != y) {
+          // For symbolic x != y, as in copying between two parts of an array, avoid the
+          // loop-carried data dependence by generating an explicit runtime test that the
+          // accessed index ranges are disjoint. Reject two different constant offsets,
+          // since the ranges would only be disjoint for very small trip counts.
+          if (x != y &&
+              ((x->IsConstant() && y->IsConstant()) ||
+               !TrySetRuntimeTest(x, y, /*is_range*/ true))) {
             return false;
           }
         } else {
           // Found a[i+x] vs. b[i+y]. Accept if x == y (at worst loop-independent data dependence).
           // Conservatively assume a potential loop-carried data dependence otherwise, avoided by
           // generating an explicit a != b disambiguation runtime test on the two references.
-          if (x != y) {
-            // To avoid excessive overhead, we only accept one a != b test.
-            if (vector_runtime_test_a_ == nullptr) {
-              // First test found.
-              vector_runtime_test_a_ = a;
-              vector_runtime_test_b_ = b;
-            } else if ((vector_runtime_test_a_ != a || vector_runtime_test_b_ != b) &&
-                       (vector_runtime_test_a_ != b || vector_runtime_test_b_ != a)) {
-              return false;  // second test would be needed
-            }
+          if (x != y && !TrySetRuntimeTest(a, b, /*is_range*/ false)) {
+            return false;
           }
         }
       }
@@ -697,14 +811,10 @@ void HLoopOptimization::Vectorize(LoopNode* node,
   }
   vector_index_ = graph_->GetIntConstant(0);
 
-  // Generate runtime disambiguation test:
-  // vtc = a != b ? vtc : 0;
-  if (vector_runtime_test_a_ != nullptr) {
-    HInstruction* rt = Insert(
-        preheader,
-        new (global_allocator_) HNotEqual(vector_runtime_test_a_, vector_runtime_test_b_));
-    vtc = Insert(preheader,
-                 new (global_allocator_) HSelect(rt, vtc, graph_->GetIntConstant(0), kNoDexPc));
+  // Generate runtime disambiguation tests, which execute only the cleanup
+  // loop (the original scalar loop) if any of the tests fails.
+  if (vector_num_runtime_tests_ != 0) {
+    GenerateRuntimeTests(preheader, stc, &vtc);
     needs_cleanup = true;
   }
 
@@ -769,7 +879,6 @@ void HLoopOptimization::GenerateNewLoop(LoopNode* node,
                                         HInstruction* hi,
                                         HInstruction* step,
                                         uint32_t unroll) {
-  DCHECK(unroll == 1 || vector_mode_ == kVector);
   Primitive::Type induc_type = Primitive::kPrimInt;
   // Prepare new loop.
   vector_preheader_ = new_preheader,
@@ -788,7 +897,8 @@ void HLoopOptimization::GenerateNewLoop(LoopNode* node,
   vector_header_->AddInstruction(new (global_allocator_) HIf(cond));
   vector_index_ = phi;
   for (uint32_t u = 0; u < unroll; u++) {
-    // Clear map, leaving loop invariants setup during unrolling.
+    // Clear map, leaving loop invariants setup during unrolling
+    // (scalar invariants are simply mapped onto themselves again).
     if (u == 0) {
       vector_map_->clear();
     } else {
@@ -1018,6 +1128,11 @@ bool HLoopOptimization::VectorizeUse(LoopNode* node,
         return true;
       }
     }
+  } else if (instruction->IsSelect()) {
+    // Recognize vectorization idioms.
+    if (VectorizeSelectMinMaxIdiom(node, instruction, generate_code, type, restrictions)) {
+      return true;
+    }
   } else if (instruction->IsInvokeStaticOrDirect()) {
     // Accept particular intrinsics.
     HInvokeStaticOrDirect* invoke = instruction->AsInvokeStaticOrDirect();
@@ -1092,6 +1207,52 @@ bool HLoopOptimization::VectorizeUse(LoopNode* node,
   return false;
 }
 
+bool HLoopOptimization::TrySetRuntimeTest(HInstruction* a, HInstruction* b, bool is_range) {
+  for (size_t i = 0; i < vector_num_runtime_tests_; ++i) {
+    if (vector_runtime_test_range_[i] == is_range &&
+        ((vector_runtime_test_a_[i] == a && vector_runtime_test_b_[i] == b) ||
+         (vector_runtime_test_a_[i] == b && vector_runtime_test_b_[i] == a))) {
+      return true;  // already tested
+    }
+  }
+  // To avoid excessive overhead, only accept a few tests.
+  if (vector_num_runtime_tests_ == kMaxRuntimeTests) {
+    return false;
+  }
+  vector_runtime_test_a_[vector_num_runtime_tests_] = a;
+  vector_runtime_test_b_[vector_num_runtime_tests_] = b;
+  vector_runtime_test_range_[vector_num_runtime_tests_] = is_range;
+  vector_num_runtime_tests_++;
+  return true;
+}
+
+void HLoopOptimization::GenerateRuntimeTests(HBasicBlock* preheader,
+                                             HInstruction* stc,
+                                             /*inout*/ HInstruction** vtc) {
+  Primitive::Type induc_type = Primitive::kPrimInt;
+  HInstruction* zero = graph_->GetIntConstant(0);
+  for (size_t i = 0; i < vector_num_runtime_tests_; ++i) {
+    HInstruction* a = vector_runtime_test_a_[i];
+    HInstruction* b = vector_runtime_test_b_[i];
+    if (vector_runtime_test_range_[i]) {
+      // The ranges [a, a + stc) and [b, b + stc) are valid indices into the same
+      // array, so the additions cannot overflow:
+      // vtc = a + stc <= b ? vtc : (b + stc <= a ? vtc : 0);
+      HInstruction* end_a = Insert(preheader, new (global_allocator_) HAdd(induc_type, a, stc));
+      HInstruction* end_b = Insert(preheader, new (global_allocator_) HAdd(induc_type, b, stc));
+      HInstruction* rt_a = Insert(preheader, new (global_allocator_) HLessThanOrEqual(end_a, b));
+      HInstruction* rt_b = Insert(preheader, new (global_allocator_) HLessThanOrEqual(end_b, a));
+      HInstruction* sel = Insert(preheader,
+                                 new (global_allocator_) HSelect(rt_b, *vtc, zero, kNoDexPc));
+      *vtc = Insert(preheader, new (global_allocator_) HSelect(rt_a, *vtc, sel, kNoDexPc));
+    } else {
+      // vtc = a != b ? vtc : 0;
+      HInstruction* rt = Insert(preheader, new (global_allocator_) HNotEqual(a, b));
+      *vtc = Insert(preheader, new (global_allocator_) HSelect(rt, *vtc, zero, kNoDexPc));
+    }
+  }
+}
+
 bool HLoopOptimization::TrySetVectorType(Primitive::Type type, uint64_t* restrictions) {
   const InstructionSetFeatures* features = compiler_driver_->GetInstructionSetFeatures();
   switch (compiler_driver_->GetInstructionSet()) {
@@ -1550,6 +1711,97 @@ bool HLoopOptimization::VectorizeHalvingAddIdiom(LoopNode* node,
   return false;
 }
 
+// Method recognizes the following idioms:
+//   (a < b) ? a : b  and  (a > b) ? b : a   as  MIN(a, b)
+//   (a > b) ? a : b  and  (a < b) ? b : a   as  MAX(a, b)
+// for integral operands a, b and any of the (unsigned) relations <, <=, >, >=. These
+// are the if-converted forms of min/max computations written out with conditional
+// control flow, which the select generator turns into a single-block loop body.
+// TODO: general selects require a vector compare and blend, which are not available yet.
+bool HLoopOptimization::VectorizeSelectMinMaxIdiom(LoopNode* node,
+                                                   HInstruction* instruction,
+                                                   bool generate_code,
+                                                   Primitive::Type type,
+                                                   uint64_t restrictions) {
+  HSelect* select = instruction->AsSelect();
+  HInstruction* condition = select->GetCondition();
+  if (!condition->IsCondition() ||
+      node->loop_info->IsDefinedOutOfTheLoop(condition) ||
+      Primitive::IsFloatingPointType(condition->InputAt(0)->GetType())) {
+    return false;
+  }
+  // Test for a comparison between the selected values.
+  HInstruction* a = condition->InputAt(0);
+  HInstruction* b = condition->InputAt(1);
+  bool is_swapped = false;
+  if (select->GetTrueValue() == b && select->GetFalseValue() == a) {
+    is_swapped = true;
+  } else if (select->GetTrueValue() != a || select->GetFalseValue() != b) {
+    return false;
+  }
+  bool is_min = false;
+  bool is_unsigned = false;
+  switch (condition->AsCondition()->GetCondition()) {
+    case kCondLT: case kCondLE: is_min = true; break;
+    case kCondGT: case kCondGE: is_min = false; break;
+    case kCondB:  case kCondBE: is_min = true;  is_unsigned = true; break;
+    case kCondA:  case kCondAE: is_min = false; is_unsigned = true; break;
+    default:
+      return false;
+  }
+  if (is_swapped) {
+    is_min = !is_min;
+  }
+  // Deal with vector restrictions.
+  HInstruction* r = a;
+  HInstruction* s = b;
+  if (HasVectorRestrictions(restrictions, kNoMinMax)) {
+    return false;
+  } else if (HasVectorRestrictions(restrictions, kNoHiBits)) {
+    // A signed comparison of same-extension narrower operands orders them
+    // exactly as a comparison in the narrower type with that signedness.
+    if (is_unsigned || !IsNarrowerOperands(a, b, type, &r, &s, &is_unsigned)) {
+      return false;
+    }
+  }
+  // Accept recognized min/max for vectorizable operands. Vectorized code uses the
+  // shorthand idiomatic operation. Sequential code uses the original scalar expressions.
+  DCHECK(r != nullptr && s != nullptr);
+  if (generate_code && vector_mode_ != kVector) {  // de-idiom
+    r = a;
+    s = b;
+  }
+  if (VectorizeUse(node, r, generate_code, type, restrictions) &&
+      VectorizeUse(node, s, generate_code, type, restrictions)) {
+    if (generate_code) {
+      HInstruction* opa = vector_map_->Get(r);
+      HInstruction* opb = vector_map_->Get(s);
+      if (vector_mode_ == kVector) {
+        if (is_min) {
+          vector_map_->Put(instruction, new (global_allocator_) HVecMin(
+              global_allocator_, opa, opb, type, vector_length_, is_unsigned));
+        } else {
+          vector_map_->Put(instruction, new (global_allocator_) HVecMax(
+              global_allocator_, opa, opb, type, vector_length_, is_unsigned));
+        }
+      } else {
+        DCHECK(vector_mode_ == kSequential);
+        if (vector_map_->find(condition) == vector_map_->end()) {
+          vector_map_->Put(condition, CloneCondition(global_allocator_, condition, opa, opb));
+        }
+        HInstruction* new_cond = vector_map_->Get(condition);
+        vector_map_->Put(instruction, new (global_allocator_) HSelect(
+            new_cond,
+            is_swapped ? opb : opa,
+            is_swapped ? opa : opb,
+            kNoDexPc));
+      }
+    }
+    return true;
+  }
+  return false;
+}
+
 //
 // Vectorization heuristics.
 //
@@ -75,6 +75,11 @@ class HLoopOptimization : public HOptimization {
     kNoStringCharAt  = 512,  // no StringCharAt
   };
 
+  /*
+   * Maximum number of dynamic data dependence tests guarding a vector loop.
+   */
+  static constexpr size_t kMaxRuntimeTests = 4;
+
   /*
    * Vectorization mode during synthesis
    * (sequential peeling/cleanup loop or vector loop).
@@ -131,6 +136,10 @@ class HLoopOptimization : public HOptimization {
                     bool generate_code,
                     Primitive::Type type,
                     uint64_t restrictions);
+  bool TrySetRuntimeTest(HInstruction* a, HInstruction* b, bool is_range);
+  void GenerateRuntimeTests(HBasicBlock* preheader,
+                            HInstruction* stc,
+                            /*inout*/ HInstruction** vtc);
   bool TrySetVectorType(Primitive::Type type, /*out*/ uint64_t* restrictions);
   bool TrySetVectorLength(uint32_t length);
   void GenerateVecInv(HInstruction* org, Primitive::Type type);
@@ -146,12 +155,21 @@ class HLoopOptimization : public HOptimization {
                      Primitive::Type type,
                      bool is_unsigned = false);
 
+  // Scalar unrolling analysis and synthesis.
+  bool ShouldUnrollScalar(LoopNode* node, HBasicBlock* block, int64_t trip_count);
+  void UnrollScalar(LoopNode* node, HBasicBlock* block, HBasicBlock* exit, int64_t trip_count);
+
   // Vectorization idioms.
   bool VectorizeHalvingAddIdiom(LoopNode* node,
                                 HInstruction* instruction,
                                 bool generate_code,
                                 Primitive::Type type,
                                 uint64_t restrictions);
+  bool VectorizeSelectMinMaxIdiom(LoopNode* node,
+                                  HInstruction* instruction,
+                                  bool generate_code,
+                                  Primitive::Type type,
+                                  uint64_t restrictions);
 
   // Vectorization heuristics.
   bool IsVectorizationProfitable(int64_t trip_count);
@@ -218,9 +236,13 @@ class HLoopOptimization : public HOptimization {
   // Dynamic loop peeling candidate for alignment.
   const ArrayReference* vector_peeling_candidate_;
 
-  // Dynamic data dependence test of the form a != b.
-  HInstruction* vector_runtime_test_a_;
-  HInstruction* vector_runtime_test_b_;
+  // Dynamic data dependence tests. Each test is either of the form a != b on two
+  // array bases, or, for a range test, checks that the index ranges starting at
+  // offsets a and b into the same array do not overlap during the loop.
+  HInstruction* vector_runtime_test_a_[kMaxRuntimeTests];
+  HInstruction* vector_runtime_test_b_[kMaxRuntimeTests];
+  bool vector_runtime_test_range_[kMaxRuntimeTests];
+  size_t vector_num_runtime_tests_;
 
   // Mapping used during vectorization synthesis for both the scalar peeling/cleanup
   // loop (mode is kSequential) and the actual vector loop (mode is kVector). The data
@@ -45,6 +45,7 @@
 
 namespace art {
 
+class ArenaStack;
 class GraphChecker;
 class HBasicBlock;
 class HConstructorFence;
@@ -306,6 +307,7 @@ std::ostream& operator<<(std::ostream& os, const ReferenceTypeInfo& rhs);
 class HGraph : public ArenaObject<kArenaAllocGraph> {
  public:
   HGraph(ArenaAllocator* arena,
+         ArenaStack* arena_stack,
          const DexFile& dex_file,
          uint32_t method_idx,
          InstructionSet instruction_set,
@@ -314,6 +316,7 @@ class HGraph : public ArenaObject<kArenaAllocGraph> {
          bool osr = false,
          int start_instruction_id = 0)
       : arena_(arena),
+        arena_stack_(arena_stack),
         blocks_(arena->Adapter(kArenaAllocBlockList)),
         reverse_post_order_(arena->Adapter(kArenaAllocReversePostOrder)),
         linear_order_(arena->Adapter(kArenaAllocLinearOrder)),
@@ -353,6 +356,7 @@ class HGraph : public ArenaObject<kArenaAllocGraph> {
   void InitializeInexactObjectRTI(VariableSizedHandleScope* handles);
 
   ArenaAllocator* GetArena() const { return arena_; }
+  ArenaStack* GetArenaStack() const { return arena_stack_; }
   const ArenaVector<HBasicBlock*>& GetBlocks() const { return blocks_; }
 
   bool IsInSsaForm() const { return in_ssa_form_; }
@@ -630,6 +634,9 @@ class HGraph : public ArenaObject<kArenaAllocGraph> {
 
   ArenaAllocator* const arena_;
 
+  // Backs the ScopedArenaAllocators of passes that only need their data while they run.
+  ArenaStack* const arena_stack_;
+
   // List of blocks in insertion order.
   ArenaVector<HBasicBlock*> blocks_;
 
@@ -2927,9 +2934,28 @@ class HIf FINAL : public HTemplateInstruction<1> {
     return GetBlock()->GetSuccessors()[1];
   }
 
+  // Whether the branch profile shows that the given successor is (almost) never executed.
+  // Code generation places the uncommon successors after the rest of the method.
+  bool IsTrueSuccessorUncommon() const { return GetPackedFlag<kFlagTrueSuccessorIsUncommon>(); }
+  bool IsFalseSuccessorUncommon() const { return GetPackedFlag<kFlagFalseSuccessorIsUncommon>(); }
+  void SetTrueSuccessorUncommon() { SetPackedFlag<kFlagTrueSuccessorIsUncommon>(true); }
+  void SetFalseSuccessorUncommon() { SetPackedFlag<kFlagFalseSuccessorIsUncommon>(true); }
+
+  // Update the uncommon successor flags after the successors of the block were swapped.
+  void SwapUncommonSuccessors() {
+    bool is_true_successor_uncommon = IsTrueSuccessorUncommon();
+    SetPackedFlag<kFlagTrueSuccessorIsUncommon>(IsFalseSuccessorUncommon());
+    SetPackedFlag<kFlagFalseSuccessorIsUncommon>(is_true_successor_uncommon);
+  }
+
   DECLARE_INSTRUCTION(If);
 
  private:
+  static constexpr size_t kFlagTrueSuccessorIsUncommon = kNumberOfGenericPackedBits;
+  static constexpr size_t kFlagFalseSuccessorIsUncommon = kFlagTrueSuccessorIsUncommon + 1;
+  static constexpr size_t kNumberOfIfPackedBits = kFlagFalseSuccessorIsUncommon + 1;
+  static_assert(kNumberOfIfPackedBits <= kMaxNumberOfPackedBits, "Too many packed fields.");
+
   DISALLOW_COPY_AND_ASSIGN(HIf);
 };
 
@@ -4124,7 +4150,8 @@ class HInvokePolymorphic FINAL : public HInvoke {
                      uint32_t number_of_arguments,
                      Primitive::Type return_type,
                      uint32_t dex_pc,
-                     uint32_t dex_method_index)
+                     uint32_t dex_method_index,
+                     uint32_t proto_index)
       : HInvoke(arena,
                 number_of_arguments,
                 0u /* number_of_other_inputs */,
@@ -4132,11 +4159,17 @@ class HInvokePolymorphic FINAL : public HInvoke {
                 dex_pc,
                 dex_method_index,
                 nullptr,
-                kVirtual) {}
+                kVirtual),
+        proto_index_(proto_index) {}
+
+  // The proto of the call site, which gives the type the method handle is invoked with.
+  uint32_t GetProtoIndex() const { return proto_index_; }
 
   DECLARE_INSTRUCTION(InvokePolymorphic);
 
  private:
+  const uint32_t proto_index_;
+
   DISALLOW_COPY_AND_ASSIGN(HInvokePolymorphic);
 };
 
@@ -4277,7 +4310,16 @@ class HInvokeStaticOrDirect FINAL : public HInvoke {
   }
 
   bool CanBeNull() const OVERRIDE {
-    return GetPackedField<ReturnTypeField>() == Primitive::kPrimNot && !IsStringInit();
+    switch (GetIntrinsic()) {
+      case Intrinsics::kIntegerValueOf:
+      case Intrinsics::kLongValueOf:
+      case Intrinsics::kShortValueOf:
+      case Intrinsics::kCharacterValueOf:
+      case Intrinsics::kByteValueOf:
+        return false;
+      default:
+        return GetPackedField<ReturnTypeField>() == Primitive::kPrimNot && !IsStringInit();
+    }
   }
 
   // Get the index of the special input, if any.
@@ -5892,6 +5934,7 @@ class HLoadString FINAL : public HInstruction {
         string_index_(string_index),
         dex_file_(dex_file) {
     SetPackedField<LoadKindField>(LoadKind::kRuntimeCall);
+    SetPackedFlag<kFlagIsInBootImage>(false);
   }
 
   void SetLoadKind(LoadKind load_kind);
@@ -5916,6 +5959,14 @@ class HLoadString FINAL : public HInstruction {
     string_ = str;
   }
 
+  // Whether the string is known to be in the boot image. The boot image is never moved by
+  // the GC, so loading such a string from a GC root does not need a read barrier.
+  bool IsInBootImage() const { return GetPackedFlag<kFlagIsInBootImage>(); }
+
+  void MarkInBootImage() {
+    SetPackedFlag<kFlagIsInBootImage>(true);
+  }
+
   bool CanBeMoved() const OVERRIDE { return true; }
 
   bool InstructionDataEquals(const HInstruction* other) const OVERRIDE;
@@ -5963,7 +6014,8 @@ class HLoadString FINAL : public HInstruction {
   static constexpr size_t kFieldLoadKind = kNumberOfGenericPackedBits;
   static constexpr size_t kFieldLoadKindSize =
       MinimumBitsToStore(static_cast<size_t>(LoadKind::kLast));
-  static constexpr size_t kNumberOfLoadStringPackedBits = kFieldLoadKind + kFieldLoadKindSize;
+  static constexpr size_t kFlagIsInBootImage = kFieldLoadKind + kFieldLoadKindSize;
+  static constexpr size_t kNumberOfLoadStringPackedBits = kFlagIsInBootImage + 1;
   static_assert(kNumberOfLoadStringPackedBits <= kMaxNumberOfPackedBits, "Too many packed fields.");
   using LoadKindField = BitField<LoadKind, kFieldLoadKind, kFieldLoadKindSize>;
 
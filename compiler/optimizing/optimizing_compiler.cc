@@ -19,6 +19,7 @@
 #include <fstream>
 #include <memory>
 #include <sstream>
+#include <vector>
 
 #include <stdint.h>
 
@@ -46,10 +47,13 @@
 #include "base/dumpable.h"
 #include "base/macros.h"
 #include "base/mutex.h"
+#include "base/scoped_arena_allocator.h"
+#include "base/time_utils.h"
 #include "base/timing_logger.h"
 #include "bounds_check_elimination.h"
 #include "builder.h"
 #include "cha_guard_optimization.h"
+#include "clinit_check_elimination.h"
 #include "code_generator.h"
 #include "code_sinking.h"
 #include "compiled_method.h"
@@ -76,6 +80,7 @@
 #include "jit/debugger_interface.h"
 #include "jit/jit.h"
 #include "jit/jit_code_cache.h"
+#include "jit/jit_debug_info_packer.h"
 #include "jit/jit_logger.h"
 #include "jni/quick/jni_compiler.h"
 #include "licm.h"
@@ -84,6 +89,9 @@
 #include "loop_optimization.h"
 #include "nodes.h"
 #include "oat_quick_method_header.h"
+#include "partial_escape_analysis.h"
+#include "partial_redundancy_elimination.h"
+#include "pass_profile.h"
 #include "prepare_for_register_allocation.h"
 #include "reference_type_propagation.h"
 #include "register_allocator_linear_scan.h"
@@ -101,6 +109,12 @@ namespace art {
 
 static constexpr size_t kArenaAllocatorMemoryReportThreshold = 8 * MB;
 
+// Budget of the OSR compilation of a huge method, see HGraphBuilder::SkipCompilation(). The
+// compilation is abandoned when its graph takes more arena memory than this, or when building
+// and optimizing the graph takes longer than this.
+static constexpr size_t kHugeMethodOsrArenaBudget = 64 * MB;
+static constexpr uint64_t kHugeMethodOsrTimeBudgetNs = MsToNs(500);
+
 static constexpr const char* kPassNameSeparator = "$";
 
 /**
@@ -143,11 +157,14 @@ class PassObserver : public ValueObject {
                CodeGenerator* codegen,
                std::ostream* visualizer_output,
                CompilerDriver* compiler_driver,
-               Mutex& dump_mutex)
+               Mutex& dump_mutex,
+               PassProfile* pass_profile)
       : graph_(graph),
         cached_method_name_(),
         timing_logger_enabled_(compiler_driver->GetDumpPasses()),
         timing_logger_(timing_logger_enabled_ ? GetMethodName() : "", true, true),
+        pass_profile_(pass_profile),
+        pass_profile_snapshots_(),
         disasm_info_(graph->GetArena()),
         visualizer_oss_(),
         visualizer_output_(visualizer_output),
@@ -202,6 +219,10 @@ class PassObserver : public ValueObject {
     if (timing_logger_enabled_) {
       timing_logger_.StartTiming(pass_name);
     }
+    if (pass_profile_ != nullptr) {
+      pass_profile_snapshots_.emplace_back();
+      PassProfile::TakeSnapshot(graph_, &pass_profile_snapshots_.back());
+    }
   }
 
   void FlushVisualizer() REQUIRES(!visualizer_dump_mutex_) {
@@ -217,6 +238,13 @@ class PassObserver : public ValueObject {
     if (timing_logger_enabled_) {
       timing_logger_.EndTiming();
     }
+    if (pass_profile_ != nullptr) {
+      DCHECK(!pass_profile_snapshots_.empty());
+      PassProfile::Snapshot end;
+      PassProfile::TakeSnapshot(graph_, &end);
+      pass_profile_->RecordPass(pass_name, pass_profile_snapshots_.back(), end);
+      pass_profile_snapshots_.pop_back();
+    }
     if (visualizer_enabled_) {
       visualizer_.DumpGraph(pass_name, /* is_after_pass */ true, graph_in_bad_state_);
       FlushVisualizer();
@@ -258,6 +286,12 @@ class PassObserver : public ValueObject {
   bool timing_logger_enabled_;
   TimingLogger timing_logger_;
 
+  // Session-wide profile, null unless --dump-pass-profile is passed. The snapshots taken at
+  // the start of the passes in progress are kept outside of the graph's arena so that they do
+  // not show up in the profile.
+  PassProfile* const pass_profile_;
+  std::vector<PassProfile::Snapshot> pass_profile_snapshots_;
+
   DisassemblyInformation disasm_info_;
 
   std::ostringstream visualizer_oss_;
@@ -339,17 +373,29 @@ class OptimizingCompiler FINAL : public Compiler {
                   jit::JitCodeCache* code_cache,
                   ArtMethod* method,
                   bool osr,
-                  jit::JitLogger* jit_logger)
+                  bool baseline,
+                  jit::JitLogger* jit_logger,
+                  jit::JitDebugInfoPacker* debug_info_packer)
       OVERRIDE
       REQUIRES_SHARED(Locks::mutator_lock_);
 
  private:
+  // Compile the JNI stub of the native `method` and commit it to `code_cache`, where it is shared
+  // with the native methods that have the same shorty and flags.
+  bool JitCompileJniStub(Thread* self,
+                         jit::JitCodeCache* code_cache,
+                         ArtMethod* method,
+                         jit::JitLogger* jit_logger,
+                         jit::JitDebugInfoPacker* debug_info_packer)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
   void RunOptimizations(HGraph* graph,
                         CodeGenerator* codegen,
                         CompilerDriver* driver,
                         const DexCompilationUnit& dex_compilation_unit,
                         PassObserver* pass_observer,
-                        VariableSizedHandleScope* handles) const;
+                        VariableSizedHandleScope* handles,
+                        bool baseline) const;
 
   void RunOptimizations(HOptimization* optimizations[],
                         size_t length,
@@ -368,9 +414,11 @@ class OptimizingCompiler FINAL : public Compiler {
   // This method:
   // 1) Builds the graph. Returns null if it failed to build it.
   // 2) Transforms the graph to SSA. Returns null if it failed.
-  // 3) Runs optimizations on the graph, including register allocator.
+  // 3) Runs optimizations on the graph, including register allocator. A `baseline`
+  //    compilation only runs the passes the code generator depends on and a few cheap ones.
   // 4) Generates code with the `code_allocator` provided.
   CodeGenerator* TryCompile(ArenaAllocator* arena,
+                            ArenaStack* arena_stack,
                             CodeVectorAllocator* code_allocator,
                             const DexFile::CodeItem* code_item,
                             uint32_t access_flags,
@@ -382,6 +430,7 @@ class OptimizingCompiler FINAL : public Compiler {
                             Handle<mirror::DexCache> dex_cache,
                             ArtMethod* method,
                             bool osr,
+                            bool baseline,
                             VariableSizedHandleScope* handles) const;
 
   void MaybeRunInliner(HGraph* graph,
@@ -402,11 +451,31 @@ class OptimizingCompiler FINAL : public Compiler {
 
   mutable Mutex dump_mutex_;  // To synchronize visualizer writing.
 
+  std::unique_ptr<PassProfile> pass_profile_;
+  std::string pass_profile_file_name_;
+
   DISALLOW_COPY_AND_ASSIGN(OptimizingCompiler);
 };
 
 static const int kMaximumCompilationTimeBeforeWarning = 100; /* ms */
 
+// The peak memory of a method compile is what the graph's arena holds at the end plus the
+// high-water mark of the pass-local allocations on the ArenaStack.
+static void ReportArenaMemoryUsage(const DexFile& dex_file,
+                                   uint32_t method_idx,
+                                   const ArenaAllocator& arena,
+                                   ArenaStack* arena_stack) {
+  size_t peak_bytes = arena.BytesAllocated() + arena_stack->PeakBytesAllocated();
+  if (peak_bytes > kArenaAllocatorMemoryReportThreshold) {
+    MemStats mem_stats(arena.GetMemStats());
+    MemStats peak_stats(arena_stack->GetPeakStats());
+    LOG(INFO) << "Used " << peak_bytes << " bytes of arena memory at peak for compiling "
+              << dex_file.PrettyMethod(method_idx) << "\n"
+              << Dumpable<MemStats>(mem_stats) << "\n"
+              << Dumpable<MemStats>(peak_stats);
+  }
+}
+
 OptimizingCompiler::OptimizingCompiler(CompilerDriver* driver)
     : Compiler(driver, kMaximumCompilationTimeBeforeWarning),
       dump_mutex_("Visualizer dump lock") {}
@@ -424,6 +493,10 @@ void OptimizingCompiler::Init() {
   if (driver->GetDumpStats()) {
     compilation_stats_.reset(new OptimizingCompilerStats());
   }
+  pass_profile_file_name_ = driver->GetCompilerOptions().GetDumpPassProfileFileName();
+  if (!pass_profile_file_name_.empty()) {
+    pass_profile_.reset(new PassProfile());
+  }
 }
 
 void OptimizingCompiler::UnInit() const {
@@ -433,6 +506,14 @@ OptimizingCompiler::~OptimizingCompiler() {
   if (compilation_stats_.get() != nullptr) {
     compilation_stats_->Log();
   }
+  if (pass_profile_ != nullptr) {
+    std::ofstream output(pass_profile_file_name_);
+    if (output.good()) {
+      pass_profile_->Dump(output);
+    } else {
+      LOG(WARNING) << "Failed to open pass profile output " << pass_profile_file_name_;
+    }
+  }
 }
 
 bool OptimizingCompiler::CanCompileMethod(uint32_t method_idx ATTRIBUTE_UNUSED,
@@ -507,12 +588,18 @@ static HOptimization* BuildOptimization(
   } else if (opt_name == LICM::kLoopInvariantCodeMotionPassName) {
     CHECK(most_recent_side_effects != nullptr);
     return new (arena) LICM(graph, *most_recent_side_effects, stats);
+  } else if (opt_name == ClinitCheckElimination::kClinitCheckEliminationPassName) {
+    return new (arena) ClinitCheckElimination(graph, stats);
+  } else if (opt_name == PartialRedundancyElimination::kPartialRedundancyEliminationPassName) {
+    return new (arena) PartialRedundancyElimination(graph, stats);
   } else if (opt_name == LoadStoreAnalysis::kLoadStoreAnalysisPassName) {
     return new (arena) LoadStoreAnalysis(graph);
   } else if (opt_name == LoadStoreElimination::kLoadStoreEliminationPassName) {
     CHECK(most_recent_side_effects != nullptr);
     CHECK(most_recent_lsa != nullptr);
     return new (arena) LoadStoreElimination(graph, *most_recent_side_effects, *most_recent_lsa);
+  } else if (opt_name == PartialEscapeAnalysis::kPartialEscapeAnalysisPassName) {
+    return new (arena) PartialEscapeAnalysis(graph, stats);
   } else if (opt_name == SideEffectsAnalysis::kSideEffectsAnalysisPassName) {
     return new (arena) SideEffectsAnalysis(graph);
   } else if (opt_name == HLoopOptimization::kLoopOptimizationPassName) {
@@ -698,9 +785,14 @@ void OptimizingCompiler::RunArchOptimizations(InstructionSet instruction_set,
 #endif
 #ifdef ART_ENABLE_CODEGEN_x86_64
     case kX86_64: {
+      // Schedule before generating memory operands, which relies on instructions being
+      // adjacent to their only user.
+      HInstructionScheduling* scheduling =
+          new (arena) HInstructionScheduling(graph, instruction_set);
       x86::X86MemoryOperandGeneration* memory_gen =
           new (arena) x86::X86MemoryOperandGeneration(graph, codegen, stats);
       HOptimization* x86_64_optimizations[] = {
+          scheduling,
           memory_gen
       };
       RunOptimizations(x86_64_optimizations, arraysize(x86_64_optimizations), pass_observer);
@@ -738,7 +830,8 @@ void OptimizingCompiler::RunOptimizations(HGraph* graph,
                                           CompilerDriver* driver,
                                           const DexCompilationUnit& dex_compilation_unit,
                                           PassObserver* pass_observer,
-                                          VariableSizedHandleScope* handles) const {
+                                          VariableSizedHandleScope* handles,
+                                          bool baseline) const {
   OptimizingCompilerStats* stats = compilation_stats_.get();
   ArenaAllocator* arena = graph->GetArena();
   if (driver->GetCompilerOptions().GetPassesToRun() != nullptr) {
@@ -768,17 +861,21 @@ void OptimizingCompiler::RunOptimizations(HGraph* graph,
   HConstantFolding* fold2 = new (arena) HConstantFolding(
       graph, "constant_folding$after_inlining");
   HConstantFolding* fold3 = new (arena) HConstantFolding(graph, "constant_folding$after_bce");
+  ClinitCheckElimination* clinit_check_elimination =
+      new (arena) ClinitCheckElimination(graph, stats);
   SideEffectsAnalysis* side_effects1 = new (arena) SideEffectsAnalysis(
       graph, "side_effects$before_gvn");
   SideEffectsAnalysis* side_effects2 = new (arena) SideEffectsAnalysis(
       graph, "side_effects$before_lse");
   GVNOptimization* gvn = new (arena) GVNOptimization(graph, *side_effects1);
+  PartialRedundancyElimination* pre = new (arena) PartialRedundancyElimination(graph, stats);
   LICM* licm = new (arena) LICM(graph, *side_effects1, stats);
   HInductionVarAnalysis* induction = new (arena) HInductionVarAnalysis(graph);
   BoundsCheckElimination* bce = new (arena) BoundsCheckElimination(graph, *side_effects1, induction);
   HLoopOptimization* loop = new (arena) HLoopOptimization(graph, driver, induction);
   LoadStoreAnalysis* lsa = new (arena) LoadStoreAnalysis(graph);
   LoadStoreElimination* lse = new (arena) LoadStoreElimination(graph, *side_effects2, *lsa);
+  PartialEscapeAnalysis* pea = new (arena) PartialEscapeAnalysis(graph, stats);
   HSharpening* sharpening = new (arena) HSharpening(
       graph, codegen, dex_compilation_unit, driver, handles);
   InstructionSimplifier* simplify2 = new (arena) InstructionSimplifier(
@@ -800,6 +897,12 @@ void OptimizingCompiler::RunOptimizations(HGraph* graph,
   };
   RunOptimizations(optimizations1, arraysize(optimizations1), pass_observer);
 
+  if (baseline) {
+    // The simplifier already ran above, which is all the code generator needs.
+    RunArchOptimizations(driver->GetInstructionSet(), graph, codegen, pass_observer);
+    return;
+  }
+
   MaybeRunInliner(graph, codegen, driver, dex_compilation_unit, pass_observer, handles);
 
   HOptimization* optimizations2[] = {
@@ -809,8 +912,11 @@ void OptimizingCompiler::RunOptimizations(HGraph* graph,
     fold2,  // TODO: if we don't inline we can also skip fold2.
     simplify2,
     dce2,
+    // Before GVN and LICM, as each removed check no longer clobbers all memory.
+    clinit_check_elimination,
     side_effects1,
     gvn,
+    pre,
     licm,
     induction,
     bce,
@@ -820,6 +926,7 @@ void OptimizingCompiler::RunOptimizations(HGraph* graph,
     side_effects2,
     lsa,
     lse,
+    pea,  // after LSE, which removes the simpler non-escaping allocations
     cha_guard,
     dce3,
     code_sinking,
@@ -882,6 +989,7 @@ CompiledMethod* OptimizingCompiler::Emit(ArenaAllocator* arena,
 }
 
 CodeGenerator* OptimizingCompiler::TryCompile(ArenaAllocator* arena,
+                                              ArenaStack* arena_stack,
                                               CodeVectorAllocator* code_allocator,
                                               const DexFile::CodeItem* code_item,
                                               uint32_t access_flags,
@@ -893,6 +1001,7 @@ CodeGenerator* OptimizingCompiler::TryCompile(ArenaAllocator* arena,
                                               Handle<mirror::DexCache> dex_cache,
                                               ArtMethod* method,
                                               bool osr,
+                                              bool baseline,
                                               VariableSizedHandleScope* handles) const {
   MaybeRecordStat(MethodCompilationStat::kAttemptCompilation);
   CompilerDriver* compiler_driver = GetCompilerDriver();
@@ -923,6 +1032,12 @@ CodeGenerator* OptimizingCompiler::TryCompile(ArenaAllocator* arena,
     return nullptr;
   }
 
+  // Huge methods are compiled only when a hot loop requested OSR, see
+  // HGraphBuilder::SkipCompilation().
+  const bool huge_method_osr =
+      osr && compiler_options.IsHugeMethod(code_item->insns_size_in_code_units_);
+  const uint64_t start_time_ns = huge_method_osr ? NanoTime() : 0u;
+
   ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
   DexCompilationUnit dex_compilation_unit(
       class_loader,
@@ -937,6 +1052,7 @@ CodeGenerator* OptimizingCompiler::TryCompile(ArenaAllocator* arena,
 
   HGraph* graph = new (arena) HGraph(
       arena,
+      arena_stack,
       dex_file,
       method_idx,
       compiler_driver->GetInstructionSet(),
@@ -976,7 +1092,8 @@ CodeGenerator* OptimizingCompiler::TryCompile(ArenaAllocator* arena,
                              codegen.get(),
                              visualizer_output_.get(),
                              compiler_driver,
-                             dump_mutex_);
+                             dump_mutex_,
+                             pass_profile_.get());
 
   {
     VLOG(compiler) << "Building " << pass_observer.GetMethodName();
@@ -1015,15 +1132,39 @@ CodeGenerator* OptimizingCompiler::TryCompile(ArenaAllocator* arena,
     }
   }
 
+  if (huge_method_osr) {
+    // Keep the compilation time of huge methods down.
+    baseline = true;
+    if (arena->BytesUsed() > kHugeMethodOsrArenaBudget) {
+      MaybeRecordStat(MethodCompilationStat::kNotCompiledHugeMethodOverBudget);
+      return nullptr;
+    }
+  }
+
   RunOptimizations(graph,
                    codegen.get(),
                    compiler_driver,
                    dex_compilation_unit,
                    &pass_observer,
-                   handles);
+                   handles,
+                   baseline);
+
+  // Register allocation and code generation take time and memory in proportion to what the
+  // optimizations left, so stop here if they already used up the budget.
+  if (huge_method_osr &&
+      (arena->BytesUsed() > kHugeMethodOsrArenaBudget ||
+       NanoTime() - start_time_ns > kHugeMethodOsrTimeBudgetNs)) {
+    VLOG(compiler) << "Abandon OSR compilation of huge method " << pass_observer.GetMethodName()
+                   << ": " << arena->BytesUsed() << " bytes of arena memory after "
+                   << PrettyDuration(NanoTime() - start_time_ns);
+    MaybeRecordStat(MethodCompilationStat::kNotCompiledHugeMethodOverBudget);
+    return nullptr;
+  }
 
-  RegisterAllocator::Strategy regalloc_strategy =
-    compiler_options.GetRegisterAllocationStrategy();
+  // Linear scan is the cheaper allocator, which is what baseline code wants.
+  RegisterAllocator::Strategy regalloc_strategy = baseline
+      ? RegisterAllocator::kRegisterAllocatorLinearScan
+      : compiler_options.GetRegisterAllocationStrategy();
   AllocateRegisters(graph, codegen.get(), &pass_observer, regalloc_strategy);
 
   codegen->Compile(code_allocator);
@@ -1049,6 +1190,7 @@ CompiledMethod* OptimizingCompiler::Compile(const DexFile::CodeItem* code_item,
       || verifier::CanCompilerHandleVerificationFailure(
             verified_method->GetEncounteredVerificationFailures())) {
     ArenaAllocator arena(Runtime::Current()->GetArenaPool());
+    ArenaStack arena_stack(Runtime::Current()->GetArenaPool());
     CodeVectorAllocator code_allocator(&arena);
     std::unique_ptr<CodeGenerator> codegen;
     {
@@ -1058,6 +1200,7 @@ CompiledMethod* OptimizingCompiler::Compile(const DexFile::CodeItem* code_item,
       ScopedThreadSuspension sts(soa.Self(), kNative);
       codegen.reset(
           TryCompile(&arena,
+                     &arena_stack,
                      &code_allocator,
                      code_item,
                      access_flags,
@@ -1069,6 +1212,7 @@ CompiledMethod* OptimizingCompiler::Compile(const DexFile::CodeItem* code_item,
                      dex_cache,
                      nullptr,
                      /* osr */ false,
+                     /* baseline */ false,
                      &handles));
     }
     if (codegen.get() != nullptr) {
@@ -1076,10 +1220,7 @@ CompiledMethod* OptimizingCompiler::Compile(const DexFile::CodeItem* code_item,
       method = Emit(&arena, &code_allocator, codegen.get(), compiler_driver, code_item);
 
       if (kArenaAllocatorCountAllocations) {
-        if (arena.BytesAllocated() > kArenaAllocatorMemoryReportThreshold) {
-          MemStats mem_stats(arena.GetMemStats());
-          LOG(INFO) << dex_file.PrettyMethod(method_idx) << " " << Dumpable<MemStats>(mem_stats);
-        }
+        ReportArenaMemoryUsage(dex_file, method_idx, arena, &arena_stack);
       }
     }
   } else {
@@ -1138,11 +1279,104 @@ bool CanEncodeInlinedMethodInStackMap(const DexFile& caller_dex_file, ArtMethod*
   return false;
 }
 
+bool OptimizingCompiler::JitCompileJniStub(Thread* self,
+                                           jit::JitCodeCache* code_cache,
+                                           ArtMethod* method,
+                                           jit::JitLogger* jit_logger,
+                                           jit::JitDebugInfoPacker* debug_info_packer) {
+  const DexFile* dex_file = method->GetDexFile();
+  const uint32_t method_idx = method->GetDexMethodIndex();
+  const uint32_t access_flags = method->GetAccessFlags();
+  Compiler::JniOptimizationFlags optimization_flags = Compiler::kNone;
+  if (method->IsAnnotatedWithFastNative()) {
+    optimization_flags = Compiler::kFastNative;
+  } else if (method->IsAnnotatedWithCriticalNative()) {
+    optimization_flags = Compiler::kCriticalNative;
+  }
+
+  CompiledMethod* compiled_method = nullptr;
+  {
+    // Go to native so that we don't block GC during compilation.
+    ScopedThreadSuspension sts(self, kNative);
+    compiled_method = JniCompile(access_flags, method_idx, *dex_file, optimization_flags);
+  }
+  CHECK(compiled_method != nullptr);
+  const ArrayRef<const uint8_t> quick_code = compiled_method->GetQuickCode();
+
+  // JNI stubs have no stack maps, roots, nor CHA dependencies.
+  ArenaAllocator arena(Runtime::Current()->GetJitArenaPool());
+  ArenaSet<ArtMethod*> cha_single_implementation_list(arena.Adapter(kArenaAllocCHA));
+  const void* code = code_cache->CommitCode(
+      self,
+      method,
+      /* stack_map */ nullptr,
+      /* method_info */ nullptr,
+      /* roots_data */ nullptr,
+      compiled_method->GetFrameSizeInBytes(),
+      compiled_method->GetCoreSpillMask(),
+      compiled_method->GetFpSpillMask(),
+      quick_code.data(),
+      quick_code.size(),
+      /* data_size */ 0u,
+      /* osr */ false,
+      /* baseline */ false,
+      Handle<mirror::ObjectArray<mirror::Object>>(),
+      /* has_should_deoptimize_flag */ false,
+      cha_single_implementation_list);
+  if (code == nullptr) {
+    CompiledMethod::ReleaseSwapAllocatedCompiledMethod(GetCompilerDriver(), compiled_method);
+    return false;
+  }
+  MaybeRecordStat(MethodCompilationStat::kCompiled);
+
+  const CompilerOptions& compiler_options = GetCompilerDriver()->GetCompilerOptions();
+  const auto* method_header = reinterpret_cast<const OatQuickMethodHeader*>(code);
+  const uintptr_t code_address = reinterpret_cast<uintptr_t>(method_header->GetCode());
+  debug::MethodDebugInfo info = debug::MethodDebugInfo();
+  if (compiler_options.GetGenerateDebugInfo() || jit_logger != nullptr) {
+    info.trampoline_name = nullptr;
+    info.dex_file = dex_file;
+    info.class_def_index = method->GetClassDefIndex();
+    info.dex_method_index = method_idx;
+    info.access_flags = access_flags;
+    info.code_item = nullptr;
+    info.isa = compiled_method->GetInstructionSet();
+    info.deduped = false;
+    info.is_native_debuggable = compiler_options.GetNativeDebuggable();
+    info.is_optimized = false;
+    info.is_code_address_text_relative = false;
+    info.code_address = code_address;
+    info.code_size = quick_code.size();
+    info.frame_size_in_bytes = method_header->GetFrameSizeInBytes();
+    info.code_info = nullptr;
+    info.cfi = compiled_method->GetCFIInfo();
+  }
+  if (compiler_options.GetGenerateDebugInfo()) {
+    std::vector<uint8_t> elf_file = debug::WriteDebugElfFileForMethods(
+        GetCompilerDriver()->GetInstructionSet(),
+        GetCompilerDriver()->GetInstructionSetFeatures(),
+        ArrayRef<const debug::MethodDebugInfo>(&info, 1));
+    if (debug_info_packer != nullptr) {
+      debug_info_packer->AddMethod(info);
+    }
+    CreateJITCodeEntryForAddress(code_address, std::move(elf_file));
+  }
+
+  Runtime::Current()->GetJit()->AddMemoryUsage(method, arena.BytesUsed());
+  if (jit_logger != nullptr) {
+    jit_logger->WriteLog(method_header->GetCode(), quick_code.size(), method, &info);
+  }
+  CompiledMethod::ReleaseSwapAllocatedCompiledMethod(GetCompilerDriver(), compiled_method);
+  return true;
+}
+
 bool OptimizingCompiler::JitCompile(Thread* self,
                                     jit::JitCodeCache* code_cache,
                                     ArtMethod* method,
                                     bool osr,
-                                    jit::JitLogger* jit_logger) {
+                                    bool baseline,
+                                    jit::JitLogger* jit_logger,
+                                    jit::JitDebugInfoPacker* debug_info_packer) {
   StackHandleScope<3> hs(self);
   Handle<mirror::ClassLoader> class_loader(hs.NewHandle(
       method->GetDeclaringClass()->GetClassLoader()));
@@ -1156,7 +1390,13 @@ bool OptimizingCompiler::JitCompile(Thread* self,
   const uint32_t access_flags = method->GetAccessFlags();
   const InvokeType invoke_type = method->GetInvokeType();
 
+  if (UNLIKELY(method->IsNative())) {
+    DCHECK(!osr);
+    return JitCompileJniStub(self, code_cache, method, jit_logger, debug_info_packer);
+  }
+
   ArenaAllocator arena(Runtime::Current()->GetJitArenaPool());
+  ArenaStack arena_stack(Runtime::Current()->GetJitArenaPool());
   CodeVectorAllocator code_allocator(&arena);
   VariableSizedHandleScope handles(self);
 
@@ -1166,6 +1406,7 @@ bool OptimizingCompiler::JitCompile(Thread* self,
     ScopedThreadSuspension sts(self, kNative);
     codegen.reset(
         TryCompile(&arena,
+                   &arena_stack,
                    &code_allocator,
                    code_item,
                    access_flags,
@@ -1177,16 +1418,14 @@ bool OptimizingCompiler::JitCompile(Thread* self,
                    dex_cache,
                    method,
                    osr,
+                   baseline,
                    &handles));
     if (codegen.get() == nullptr) {
       return false;
     }
 
     if (kArenaAllocatorCountAllocations) {
-      if (arena.BytesAllocated() > kArenaAllocatorMemoryReportThreshold) {
-        MemStats mem_stats(arena.GetMemStats());
-        LOG(INFO) << dex_file->PrettyMethod(method_idx) << " " << Dumpable<MemStats>(mem_stats);
-      }
+      ReportArenaMemoryUsage(*dex_file, method_idx, arena, &arena_stack);
     }
   }
 
@@ -1240,6 +1479,7 @@ bool OptimizingCompiler::JitCompile(Thread* self,
       code_allocator.GetSize(),
       data_size,
       osr,
+      baseline,
       roots,
       codegen->GetGraph()->HasShouldDeoptimizeFlag(),
       codegen->GetGraph()->GetCHASingleImplementationList());
@@ -1250,10 +1490,10 @@ bool OptimizingCompiler::JitCompile(Thread* self,
   }
 
   const CompilerOptions& compiler_options = GetCompilerDriver()->GetCompilerOptions();
-  if (compiler_options.GetGenerateDebugInfo()) {
-    const auto* method_header = reinterpret_cast<const OatQuickMethodHeader*>(code);
-    const uintptr_t code_address = reinterpret_cast<uintptr_t>(method_header->GetCode());
-    debug::MethodDebugInfo info = debug::MethodDebugInfo();
+  const auto* method_header = reinterpret_cast<const OatQuickMethodHeader*>(code);
+  const uintptr_t code_address = reinterpret_cast<uintptr_t>(method_header->GetCode());
+  debug::MethodDebugInfo info = debug::MethodDebugInfo();
+  if (compiler_options.GetGenerateDebugInfo() || jit_logger != nullptr) {
     info.trampoline_name = nullptr;
     info.dex_file = dex_file;
     info.class_def_index = class_def_idx;
@@ -1270,16 +1510,21 @@ bool OptimizingCompiler::JitCompile(Thread* self,
     info.frame_size_in_bytes = method_header->GetFrameSizeInBytes();
     info.code_info = stack_map_size == 0 ? nullptr : stack_map_data;
     info.cfi = ArrayRef<const uint8_t>(*codegen->GetAssembler()->cfi().data());
+  }
+  if (compiler_options.GetGenerateDebugInfo()) {
     std::vector<uint8_t> elf_file = debug::WriteDebugElfFileForMethods(
         GetCompilerDriver()->GetInstructionSet(),
         GetCompilerDriver()->GetInstructionSetFeatures(),
         ArrayRef<const debug::MethodDebugInfo>(&info, 1));
+    if (debug_info_packer != nullptr) {
+      debug_info_packer->AddMethod(info);
+    }
     CreateJITCodeEntryForAddress(code_address, std::move(elf_file));
   }
 
   Runtime::Current()->GetJit()->AddMemoryUsage(method, arena.BytesUsed());
   if (jit_logger != nullptr) {
-    jit_logger->WriteLog(code, code_allocator.GetSize(), method);
+    jit_logger->WriteLog(method_header->GetCode(), code_allocator.GetSize(), method, &info);
   }
 
   return true;
@@ -45,6 +45,7 @@ enum MethodCompilationStat {
   kNotCompiledThrowCatchLoop,
   kNotCompiledAmbiguousArrayOp,
   kNotCompiledHugeMethod,
+  kNotCompiledHugeMethodOverBudget,
   kNotCompiledLargeMethodNoBranches,
   kNotCompiledMalformedOpcode,
   kNotCompiledNoCodegen,
@@ -56,12 +57,17 @@ enum MethodCompilationStat {
   kNotCompiledVerifyAtRuntime,
   kInlinedMonomorphicCall,
   kInlinedPolymorphicCall,
+  kInlinedMegamorphicCall,
   kMonomorphicCall,
   kPolymorphicCall,
   kMegamorphicCall,
   kBooleanSimplified,
   kIntrinsicRecognized,
   kLoopInvariantMoved,
+  kPartialRedundancyEliminated,
+  kPartialEscapeScalarReplaced,
+  kPartialEscapeMaterialized,
+  kClinitCheckEliminated,
   kSelectGenerated,
   kRemovedInstanceOf,
   kInlinedInvokeVirtualOrInterface,
@@ -86,6 +92,9 @@ enum MethodCompilationStat {
   kNotInlinedWont,
   kNotInlinedRecursiveBudget,
   kNotInlinedProxy,
+  kNotInlinedColdCallSite,
+  kInlinedHotCallSite,
+  kSpecializedMethodHandleInvoke,
   kLastStat
 };
 
@@ -161,6 +170,7 @@ class OptimizingCompilerStats {
       case kNotCompiledThrowCatchLoop : name = "NotCompiledThrowCatchLoop"; break;
       case kNotCompiledAmbiguousArrayOp : name = "NotCompiledAmbiguousArrayOp"; break;
       case kNotCompiledHugeMethod : name = "NotCompiledHugeMethod"; break;
+      case kNotCompiledHugeMethodOverBudget : name = "NotCompiledHugeMethodOverBudget"; break;
       case kNotCompiledLargeMethodNoBranches : name = "NotCompiledLargeMethodNoBranches"; break;
       case kNotCompiledMalformedOpcode : name = "NotCompiledMalformedOpcode"; break;
       case kNotCompiledNoCodegen : name = "NotCompiledNoCodegen"; break;
@@ -172,12 +182,17 @@ class OptimizingCompilerStats {
       case kNotCompiledVerifyAtRuntime : name = "NotCompiledVerifyAtRuntime"; break;
       case kInlinedMonomorphicCall: name = "InlinedMonomorphicCall"; break;
       case kInlinedPolymorphicCall: name = "InlinedPolymorphicCall"; break;
+      case kInlinedMegamorphicCall: name = "InlinedMegamorphicCall"; break;
       case kMonomorphicCall: name = "MonomorphicCall"; break;
       case kPolymorphicCall: name = "PolymorphicCall"; break;
       case kMegamorphicCall: name = "MegamorphicCall"; break;
       case kBooleanSimplified : name = "BooleanSimplified"; break;
       case kIntrinsicRecognized : name = "IntrinsicRecognized"; break;
       case kLoopInvariantMoved : name = "LoopInvariantMoved"; break;
+      case kPartialRedundancyEliminated : name = "PartialRedundancyEliminated"; break;
+      case kPartialEscapeScalarReplaced : name = "PartialEscapeScalarReplaced"; break;
+      case kPartialEscapeMaterialized : name = "PartialEscapeMaterialized"; break;
+      case kClinitCheckEliminated : name = "ClinitCheckEliminated"; break;
       case kSelectGenerated : name = "SelectGenerated"; break;
       case kRemovedInstanceOf: name = "RemovedInstanceOf"; break;
       case kInlinedInvokeVirtualOrInterface: name = "InlinedInvokeVirtualOrInterface"; break;
@@ -202,6 +217,9 @@ class OptimizingCompilerStats {
       case kNotInlinedWont: name = "NotInlinedWont"; break;
       case kNotInlinedRecursiveBudget: name = "NotInlinedRecursiveBudget"; break;
       case kNotInlinedProxy: name = "NotInlinedProxy"; break;
+      case kNotInlinedColdCallSite: name = "NotInlinedColdCallSite"; break;
+      case kInlinedHotCallSite: name = "InlinedHotCallSite"; break;
+      case kSpecializedMethodHandleInvoke: name = "SpecializedMethodHandleInvoke"; break;
 
       case kLastStat:
         LOG(FATAL) << "invalid stat "
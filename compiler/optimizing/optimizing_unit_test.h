@@ -77,9 +77,11 @@ void RemoveSuspendChecks(HGraph* graph) {
   }
 }
 
-inline HGraph* CreateGraph(ArenaAllocator* allocator) {
+// Tests that run passes allocating from the graph's ArenaStack must provide one.
+inline HGraph* CreateGraph(ArenaAllocator* allocator, ArenaStack* arena_stack = nullptr) {
   return new (allocator) HGraph(
       allocator,
+      arena_stack,
       *reinterpret_cast<DexFile*>(allocator->Alloc(sizeof(DexFile))),
       /*method_idx*/-1,
       kRuntimeISA);
@@ -0,0 +1,991 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "partial_escape_analysis.h"
+
+#include "base/arena_bit_vector.h"
+#include "base/bit_vector-inl.h"
+#include "base/scoped_arena_allocator.h"
+#include "base/scoped_arena_containers.h"
+#include "base/stl_util.h"
+
+namespace art {
+
+// Bounds on the work done for a single group of allocations. Larger groups are left to
+// LSE and code sinking.
+static constexpr size_t kMaximumNumberOfMembers = 8;
+static constexpr size_t kMaximumNumberOfLocations = 16;
+static constexpr size_t kMaximumNumberOfEscapes = 8;
+static constexpr size_t kMaximumNumberOfValuePhis = 256;
+
+// Only arrays allocated with a constant length up to this one are scalar replaced.
+static constexpr int32_t kMaximumArrayLength = 8;
+
+static constexpr int32_t kNoArrayLength = -1;
+static constexpr size_t kNoMaterialization = static_cast<size_t>(-1);
+
+static bool IsAllocationCandidate(HInstruction* instruction) {
+  if (instruction->IsNewInstance()) {
+    HNewInstance* new_instance = instruction->AsNewInstance();
+    // Finalizable objects escape to the finalizer. Allocations with checks may throw
+    // something else than an OutOfMemoryError, and strings are allocated by the
+    // StringFactory call that follows.
+    return !new_instance->IsFinalizable() &&
+        !new_instance->NeedsChecks() &&
+        !new_instance->IsStringAlloc();
+  } else if (instruction->IsNewArray()) {
+    HInstruction* length = instruction->AsNewArray()->GetLength();
+    return length->IsIntConstant() &&
+        length->AsIntConstant()->GetValue() >= 0 &&
+        length->AsIntConstant()->GetValue() <= kMaximumArrayLength;
+  }
+  return false;
+}
+
+enum class UseKind {
+  kLoad,    // Non-volatile field load, or array load at a constant index.
+  kStore,   // Non-volatile field store, or array store at a constant index.
+  kLength,  // Array length.
+  kFence,   // Constructor fence.
+  kEscape,  // Anything else.
+};
+
+static UseKind ClassifyUse(HInstruction* reference,
+                           HInstruction* user,
+                           size_t input_index,
+                           int32_t array_length) {
+  if (user->IsConstructorFence()) {
+    return UseKind::kFence;
+  }
+  if (input_index != 0u) {
+    // Stored to the heap, passed to a call, compared, ...
+    return UseKind::kEscape;
+  }
+  if (user->IsInstanceFieldGet()) {
+    return user->AsInstanceFieldGet()->IsVolatile() ? UseKind::kEscape : UseKind::kLoad;
+  } else if (user->IsInstanceFieldSet()) {
+    HInstanceFieldSet* store = user->AsInstanceFieldSet();
+    return (store->IsVolatile() || store->GetValue() == reference)
+        ? UseKind::kEscape
+        : UseKind::kStore;
+  } else if (user->IsArrayGet() || user->IsArraySet()) {
+    HInstruction* index = user->InputAt(1);
+    if (!index->IsIntConstant() ||
+        index->AsIntConstant()->GetValue() < 0 ||
+        index->AsIntConstant()->GetValue() >= array_length) {
+      return UseKind::kEscape;
+    }
+    if (user->IsArrayGet()) {
+      return UseKind::kLoad;
+    }
+    HArraySet* store = user->AsArraySet();
+    return (store->NeedsTypeCheck() || store->GetValue() == reference)
+        ? UseKind::kEscape
+        : UseKind::kStore;
+  } else if (user->IsArrayLength()) {
+    return UseKind::kLength;
+  }
+  return UseKind::kEscape;
+}
+
+static const FieldInfo& GetFieldInfo(HInstruction* access) {
+  return access->IsInstanceFieldGet()
+      ? access->AsInstanceFieldGet()->GetFieldInfo()
+      : access->AsInstanceFieldSet()->GetFieldInfo();
+}
+
+static bool IsFieldAccess(HInstruction* access) {
+  return access->IsInstanceFieldGet() || access->IsInstanceFieldSet();
+}
+
+// Returns the field offset or the array index accessed by a load or store.
+static size_t GetLocationOffset(HInstruction* access) {
+  if (IsFieldAccess(access)) {
+    return GetFieldInfo(access).GetFieldOffset().SizeValue();
+  }
+  DCHECK(access->IsArrayGet() || access->IsArraySet());
+  return access->InputAt(1)->AsIntConstant()->GetValue();
+}
+
+static Primitive::Type GetLocationType(HInstruction* access) {
+  if (access->IsInstanceFieldSet()) {
+    return access->AsInstanceFieldSet()->GetFieldType();
+  } else if (access->IsArraySet()) {
+    return access->AsArraySet()->GetComponentType();
+  }
+  return access->GetType();
+}
+
+static HInstruction* GetStoredValue(HInstruction* store) {
+  return store->IsInstanceFieldSet()
+      ? store->AsInstanceFieldSet()->GetValue()
+      : store->AsArraySet()->GetValue();
+}
+
+static HInstruction* GetDefaultValue(HGraph* graph, Primitive::Type type) {
+  switch (type) {
+    case Primitive::kPrimNot:
+      return graph->GetNullConstant();
+    case Primitive::kPrimBoolean:
+    case Primitive::kPrimByte:
+    case Primitive::kPrimChar:
+    case Primitive::kPrimShort:
+    case Primitive::kPrimInt:
+      return graph->GetIntConstant(0);
+    case Primitive::kPrimLong:
+      return graph->GetLongConstant(0);
+    case Primitive::kPrimFloat:
+      return graph->GetFloatConstant(0);
+    case Primitive::kPrimDouble:
+      return graph->GetDoubleConstant(0);
+    default:
+      UNREACHABLE();
+  }
+}
+
+// Appends `block` and all the blocks it dominates to `blocks`.
+static void CollectDominatedBlocks(HBasicBlock* block, ScopedArenaVector<HBasicBlock*>* blocks) {
+  size_t start = blocks->size();
+  blocks->push_back(block);
+  for (size_t i = start; i != blocks->size(); ++i) {
+    for (HBasicBlock* dominated : (*blocks)[i]->GetDominatedBlocks()) {
+      blocks->push_back(dominated);
+    }
+  }
+}
+
+/**
+ * A group of allocations, and of the phis merging them, whose fields are replaced
+ * by SSA values.
+ */
+class VirtualObjectGroup : public ValueObject {
+ public:
+  VirtualObjectGroup(HGraph* graph,
+                     ScopedArenaAllocator* allocator,
+                     size_t number_of_original_instructions)
+      : graph_(graph),
+        allocator_(allocator),
+        number_of_original_instructions_(number_of_original_instructions),
+        members_(allocator->Adapter(kArenaAllocPEA)),
+        locations_(allocator->Adapter(kArenaAllocPEA)),
+        array_length_(kNoArrayLength),
+        has_constructor_fence_(false),
+        escape_blocks_(allocator->Adapter(kArenaAllocPEA)),
+        blocks_with_writes_(allocator,
+                            graph->GetBlocks().size(),
+                            /* expandable */ false,
+                            kArenaAllocPEA),
+        materialization_blocks_(allocator->Adapter(kArenaAllocPEA)),
+        materializations_(allocator->Adapter(kArenaAllocPEA)),
+        loads_(allocator->Adapter(kArenaAllocPEA)),
+        load_values_(std::less<HInstruction*>(), allocator->Adapter(kArenaAllocPEA)),
+        stores_(allocator->Adapter(kArenaAllocPEA)),
+        lengths_(allocator->Adapter(kArenaAllocPEA)),
+        exit_loads_(std::less<size_t>(), allocator->Adapter(kArenaAllocPEA)),
+        value_phis_(allocator->Adapter(kArenaAllocPEA)) {}
+
+  // Collects the allocations and phis connected to `allocation` through phis, and the
+  // locations accessed on them. Returns false if the group cannot be scalar replaced.
+  bool Collect(HInstruction* allocation, ArenaBitVector* visited);
+
+  // Replaces the group by the SSA values of its locations. Returns false, without
+  // changing the graph, if that needs too many phis.
+  bool Transform();
+
+  size_t GetNumberOfAllocations() const {
+    return std::count_if(members_.begin(),
+                         members_.end(),
+                         [](HInstruction* member) { return !member->IsPhi(); });
+  }
+
+  size_t GetNumberOfMaterializations() const {
+    return materialization_blocks_.size();
+  }
+
+ private:
+  struct Location {
+    size_t offset;          // Field offset or array index.
+    Primitive::Type type;
+    HInstruction* access;   // A load or store of the location, to copy the field from.
+  };
+
+  bool AddMember(HInstruction* instruction, ArenaBitVector* visited);
+  bool AddLocation(HInstruction* access);
+  bool AddEscape(HBasicBlock* block);
+  size_t FindLocation(HInstruction* access) const;
+  size_t FindMember(HInstruction* instruction) const;
+
+  // Finds the blocks where the single allocation of the group is materialized, so that
+  // each escape is dominated by one of them.
+  bool FindMaterializationBlocks();
+  bool CanMaterializeAt(HBasicBlock* block);
+
+  HPhi* NewValuePhi(HBasicBlock* block, Primitive::Type type);
+  HInstruction* NewLoad(HInstruction* object, const Location& location, HInstruction* cursor);
+  HInstruction* NewStore(HInstruction* object, const Location& location, HInstruction* value);
+  HInstruction* Materialize(HBasicBlock* block, HInstruction** values);
+  HInstruction* GetExitLoad(size_t materialization, HBasicBlock* block, size_t location);
+
+  // Follows removed loads to the value replacing them.
+  HInstruction* Resolve(HInstruction* value) const;
+
+  void RemoveRedundantValuePhis();
+
+  HGraph* const graph_;
+  ScopedArenaAllocator* const allocator_;
+  // Instructions created by this pass, with higher ids, are never part of a group.
+  const size_t number_of_original_instructions_;
+
+  // The allocations and phis of the group. Only a group made of a single allocation
+  // can escape.
+  ScopedArenaVector<HInstruction*> members_;
+  ScopedArenaVector<Location> locations_;
+  int32_t array_length_;
+  bool has_constructor_fence_;
+
+  // The blocks with an escape, and the blocks with an escape or a store.
+  ScopedArenaVector<HBasicBlock*> escape_blocks_;
+  ArenaBitVector blocks_with_writes_;
+
+  // The blocks starting with a materialization of the allocation, and the new allocations.
+  ScopedArenaVector<HBasicBlock*> materialization_blocks_;
+  ScopedArenaVector<HInstruction*> materializations_;
+
+  // The instructions to remove, and the value of each load.
+  ScopedArenaVector<HInstruction*> loads_;
+  ScopedArenaSafeMap<HInstruction*, HInstruction*> load_values_;
+  ScopedArenaVector<HInstruction*> stores_;
+  ScopedArenaVector<HInstruction*> lengths_;
+
+  // Loads from a materialization at the end of a block leaving its branch, keyed by
+  // block id and location.
+  ScopedArenaSafeMap<size_t, HInstruction*> exit_loads_;
+
+  ScopedArenaVector<HPhi*> value_phis_;
+
+  DISALLOW_COPY_AND_ASSIGN(VirtualObjectGroup);
+};
+
+bool VirtualObjectGroup::AddMember(HInstruction* instruction, ArenaBitVector* visited) {
+  if (static_cast<size_t>(instruction->GetId()) >= number_of_original_instructions_) {
+    return false;
+  }
+  if (visited->IsBitSet(instruction->GetId())) {
+    // Either already in the group, or in a group that could not be replaced.
+    return ContainsElement(members_, instruction);
+  }
+  visited->SetBit(instruction->GetId());
+  if (!(instruction->IsPhi() || IsAllocationCandidate(instruction)) ||
+      members_.size() == kMaximumNumberOfMembers) {
+    return false;
+  }
+  members_.push_back(instruction);
+  return true;
+}
+
+bool VirtualObjectGroup::AddLocation(HInstruction* access) {
+  size_t offset = GetLocationOffset(access);
+  Primitive::Type type = GetLocationType(access);
+  for (const Location& location : locations_) {
+    if (location.offset == offset) {
+      return Primitive::PrimitiveKind(location.type) == Primitive::PrimitiveKind(type);
+    }
+  }
+  if (locations_.size() == kMaximumNumberOfLocations) {
+    return false;
+  }
+  locations_.push_back(Location{offset, type, access});
+  return true;
+}
+
+bool VirtualObjectGroup::AddEscape(HBasicBlock* block) {
+  if (members_.size() != 1u) {
+    // We cannot tell which allocation a merged reference should materialize.
+    return false;
+  }
+  blocks_with_writes_.SetBit(block->GetBlockId());
+  if (!ContainsElement(escape_blocks_, block)) {
+    if (escape_blocks_.size() == kMaximumNumberOfEscapes) {
+      return false;
+    }
+    escape_blocks_.push_back(block);
+  }
+  return true;
+}
+
+size_t VirtualObjectGroup::FindLocation(HInstruction* access) const {
+  size_t offset = GetLocationOffset(access);
+  for (size_t i = 0; i != locations_.size(); ++i) {
+    if (locations_[i].offset == offset) {
+      return i;
+    }
+  }
+  LOG(FATAL) << "Unreachable";
+  UNREACHABLE();
+}
+
+size_t VirtualObjectGroup::FindMember(HInstruction* instruction) const {
+  auto it = std::find(members_.begin(), members_.end(), instruction);
+  DCHECK(it != members_.end());
+  return std::distance(members_.begin(), it);
+}
+
+bool VirtualObjectGroup::Collect(HInstruction* allocation, ArenaBitVector* visited) {
+  if (!AddMember(allocation, visited)) {
+    return false;
+  }
+  for (size_t i = 0; i != members_.size(); ++i) {
+    HInstruction* member = members_[i];
+    if (member->IsPhi()) {
+      for (HInstruction* input : member->GetInputs()) {
+        if (!AddMember(input, visited)) {
+          return false;
+        }
+      }
+    }
+    for (const HUseListNode<HInstruction*>& use : member->GetUses()) {
+      if (use.GetUser()->IsPhi() && !AddMember(use.GetUser(), visited)) {
+        return false;
+      }
+    }
+  }
+
+  // The allocations must all be instances, or arrays of the same length.
+  bool has_instances = false;
+  for (HInstruction* member : members_) {
+    if (member->IsNewInstance()) {
+      has_instances = true;
+    } else if (member->IsNewArray()) {
+      int32_t length = member->AsNewArray()->GetLength()->AsIntConstant()->GetValue();
+      if (array_length_ != kNoArrayLength && array_length_ != length) {
+        return false;
+      }
+      array_length_ = length;
+    }
+  }
+  if (has_instances && array_length_ != kNoArrayLength) {
+    return false;
+  }
+
+  for (HInstruction* member : members_) {
+    for (const HUseListNode<HInstruction*>& use : member->GetUses()) {
+      HInstruction* user = use.GetUser();
+      if (user->IsPhi()) {
+        DCHECK(ContainsElement(members_, user));
+        continue;
+      }
+      switch (ClassifyUse(member, user, use.GetIndex(), array_length_)) {
+        case UseKind::kStore:
+          blocks_with_writes_.SetBit(user->GetBlock()->GetBlockId());
+          FALLTHROUGH_INTENDED;
+        case UseKind::kLoad:
+          if (!AddLocation(user)) {
+            return false;
+          }
+          break;
+        case UseKind::kFence:
+          has_constructor_fence_ = true;
+          break;
+        case UseKind::kLength:
+          break;
+        case UseKind::kEscape:
+          if (!AddEscape(user->GetBlock())) {
+            return false;
+          }
+          break;
+      }
+    }
+    for (const HUseListNode<HEnvironment*>& use : member->GetEnvUses()) {
+      // Deoptimization needs the object. Other environment uses only describe the
+      // interpreter frame, which is never built from compiled code without a deoptimization.
+      HInstruction* holder = use.GetUser()->GetHolder();
+      if (holder->IsDeoptimize() && !AddEscape(holder->GetBlock())) {
+        return false;
+      }
+    }
+  }
+  return escape_blocks_.empty() || FindMaterializationBlocks();
+}
+
+bool VirtualObjectGroup::CanMaterializeAt(HBasicBlock* block) {
+  HBasicBlock* allocation_block = members_[0]->GetBlock();
+  // Materialize at the start of a branch, at most once per execution of the allocation.
+  if (block->GetPredecessors().size() != 1u ||
+      !(block->GetSinglePredecessor()->GetLastInstruction()->IsIf() ||
+        block->GetSinglePredecessor()->GetLastInstruction()->IsPackedSwitch()) ||
+      block->GetLoopInformation() != allocation_block->GetLoopInformation()) {
+    return false;
+  }
+  // Outside of the branch, the paths leaving it must only read the object. Its locations
+  // are read from the materialization where these paths meet the other ones.
+  ArenaBitVector visited(allocator_, graph_->GetBlocks().size(), false, kArenaAllocPEA);
+  ScopedArenaVector<HBasicBlock*> worklist(allocator_->Adapter(kArenaAllocPEA));
+  visited.SetBit(block->GetBlockId());
+  worklist.push_back(block);
+  while (!worklist.empty()) {
+    HBasicBlock* current = worklist.back();
+    worklist.pop_back();
+    for (HBasicBlock* successor : current->GetSuccessors()) {
+      if (successor == allocation_block ||
+          visited.IsBitSet(successor->GetBlockId()) ||
+          !allocation_block->Dominates(successor)) {
+        continue;
+      }
+      if (blocks_with_writes_.IsBitSet(successor->GetBlockId()) && !block->Dominates(successor)) {
+        return false;
+      }
+      visited.SetBit(successor->GetBlockId());
+      worklist.push_back(successor);
+    }
+  }
+  return true;
+}
+
+bool VirtualObjectGroup::FindMaterializationBlocks() {
+  DCHECK_EQ(members_.size(), 1u);
+  HBasicBlock* allocation_block = members_[0]->GetBlock();
+  ScopedArenaVector<HBasicBlock*> candidates(allocator_->Adapter(kArenaAllocPEA));
+  for (HBasicBlock* escape_block : escape_blocks_) {
+    // Prefer the innermost branch, to keep the other paths free of allocations.
+    HBasicBlock* materialization_block = nullptr;
+    for (HBasicBlock* block = escape_block;
+         block != allocation_block;
+         block = block->GetDominator()) {
+      if (CanMaterializeAt(block)) {
+        materialization_block = block;
+        break;
+      }
+    }
+    if (materialization_block == nullptr) {
+      return false;
+    }
+    if (!ContainsElement(candidates, materialization_block)) {
+      candidates.push_back(materialization_block);
+    }
+  }
+  // A branch nested in another one uses the outer materialization.
+  for (HBasicBlock* candidate : candidates) {
+    bool nested = std::any_of(candidates.begin(),
+                              candidates.end(),
+                              [candidate](HBasicBlock* other) {
+                                return other != candidate && other->Dominates(candidate);
+                              });
+    if (!nested) {
+      materialization_blocks_.push_back(candidate);
+    }
+  }
+  return true;
+}
+
+HPhi* VirtualObjectGroup::NewValuePhi(HBasicBlock* block, Primitive::Type type) {
+  ArenaAllocator* arena = graph_->GetArena();
+  HPhi* phi = new (arena) HPhi(arena, kNoRegNumber, 0, HPhi::ToPhiType(type));
+  if (type == Primitive::kPrimNot) {
+    phi->SetReferenceTypeInfo(graph_->GetInexactObjectRti());
+  }
+  block->AddPhi(phi);
+  value_phis_.push_back(phi);
+  return phi;
+}
+
+HInstruction* VirtualObjectGroup::NewLoad(HInstruction* object,
+                                          const Location& location,
+                                          HInstruction* cursor) {
+  ArenaAllocator* arena = graph_->GetArena();
+  HInstruction* access = location.access;
+  HInstruction* load;
+  if (IsFieldAccess(access)) {
+    const FieldInfo& field = GetFieldInfo(access);
+    load = new (arena) HInstanceFieldGet(object,
+                                         field.GetField(),
+                                         field.GetFieldType(),
+                                         field.GetFieldOffset(),
+                                         field.IsVolatile(),
+                                         field.GetFieldIndex(),
+                                         field.GetDeclaringClassDefIndex(),
+                                         field.GetDexFile(),
+                                         access->GetDexPc());
+  } else {
+    load = new (arena) HArrayGet(object,
+                                 graph_->GetIntConstant(location.offset),
+                                 location.type,
+                                 access->GetDexPc());
+  }
+  if (location.type == Primitive::kPrimNot) {
+    load->SetReferenceTypeInfo(access->GetType() == Primitive::kPrimNot
+        ? access->GetReferenceTypeInfo()
+        : graph_->GetInexactObjectRti());
+  }
+  cursor->GetBlock()->InsertInstructionBefore(load, cursor);
+  return load;
+}
+
+HInstruction* VirtualObjectGroup::NewStore(HInstruction* object,
+                                           const Location& location,
+                                           HInstruction* value) {
+  ArenaAllocator* arena = graph_->GetArena();
+  HInstruction* access = location.access;
+  if (IsFieldAccess(access)) {
+    const FieldInfo& field = GetFieldInfo(access);
+    return new (arena) HInstanceFieldSet(object,
+                                         value,
+                                         field.GetField(),
+                                         field.GetFieldType(),
+                                         field.GetFieldOffset(),
+                                         field.IsVolatile(),
+                                         field.GetFieldIndex(),
+                                         field.GetDeclaringClassDefIndex(),
+                                         field.GetDexFile(),
+                                         access->GetDexPc());
+  }
+  HArraySet* store = new (arena) HArraySet(object,
+                                           graph_->GetIntConstant(location.offset),
+                                           value,
+                                           location.type,
+                                           access->GetDexPc());
+  // The value was stored without a type check before.
+  store->ClearNeedsTypeCheck();
+  return store;
+}
+
+HInstruction* VirtualObjectGroup::Materialize(HBasicBlock* block, HInstruction** values) {
+  ArenaAllocator* arena = graph_->GetArena();
+  HInstruction* allocation = members_[0];
+  HInstruction* object;
+  if (allocation->IsNewInstance()) {
+    HNewInstance* new_instance = allocation->AsNewInstance();
+    object = new (arena) HNewInstance(new_instance->InputAt(0),
+                                      new_instance->GetDexPc(),
+                                      new_instance->GetTypeIndex(),
+                                      new_instance->GetDexFile(),
+                                      /* finalizable */ false,
+                                      new_instance->GetEntrypoint());
+  } else {
+    HNewArray* new_array = allocation->AsNewArray();
+    object = new (arena) HNewArray(new_array->InputAt(0),
+                                   new_array->GetLength(),
+                                   new_array->GetDexPc());
+  }
+  object->SetReferenceTypeInfo(allocation->GetReferenceTypeInfo());
+  HInstruction* cursor = block->GetFirstInstruction();
+  block->InsertInstructionBefore(object, cursor);
+  // Like code sinking, keep the environment and dex pc of the original allocation.
+  object->CopyEnvironmentFrom(allocation->GetEnvironment());
+  for (size_t i = 0; i != locations_.size(); ++i) {
+    HInstruction* value = Resolve(values[i]);
+    if (value != GetDefaultValue(graph_, locations_[i].type)) {
+      block->InsertInstructionBefore(NewStore(object, locations_[i], value), cursor);
+    }
+  }
+  if (has_constructor_fence_) {
+    block->InsertInstructionBefore(
+        new (arena) HConstructorFence(object, allocation->GetDexPc(), arena), cursor);
+  }
+  return object;
+}
+
+HInstruction* VirtualObjectGroup::GetExitLoad(size_t materialization,
+                                              HBasicBlock* block,
+                                              size_t location) {
+  size_t key = block->GetBlockId() * locations_.size() + location;
+  auto it = exit_loads_.find(key);
+  if (it != exit_loads_.end()) {
+    return it->second;
+  }
+  HInstruction* load = NewLoad(materializations_[materialization],
+                               locations_[location],
+                               block->GetLastInstruction());
+  exit_loads_.Put(key, load);
+  return load;
+}
+
+HInstruction* VirtualObjectGroup::Resolve(HInstruction* value) const {
+  auto it = load_values_.find(value);
+  while (it != load_values_.end()) {
+    value = it->second;
+    it = load_values_.find(value);
+  }
+  return value;
+}
+
+bool VirtualObjectGroup::Transform() {
+  const size_t number_of_blocks = graph_->GetBlocks().size();
+  const size_t number_of_members = members_.size();
+  const size_t number_of_locations = locations_.size();
+  auto index_of = [number_of_blocks](size_t member, HBasicBlock* block) {
+    return member * number_of_blocks + block->GetBlockId();
+  };
+
+  // The locations of a member have values in the blocks it dominates.
+  ArenaBitVector in_scope(allocator_,
+                          number_of_members * number_of_blocks,
+                          /* expandable */ false,
+                          kArenaAllocPEA);
+  ScopedArenaVector<HBasicBlock*> dominated(allocator_->Adapter(kArenaAllocPEA));
+  for (size_t m = 0; m != number_of_members; ++m) {
+    dominated.clear();
+    CollectDominatedBlocks(members_[m]->GetBlock(), &dominated);
+    for (HBasicBlock* block : dominated) {
+      in_scope.SetBit(index_of(m, block));
+    }
+  }
+
+  // The materialization used in each block, if any.
+  ScopedArenaVector<size_t> materialization_of(
+      number_of_blocks, kNoMaterialization, allocator_->Adapter(kArenaAllocPEA));
+  for (size_t i = 0; i != materialization_blocks_.size(); ++i) {
+    dominated.clear();
+    CollectDominatedBlocks(materialization_blocks_[i], &dominated);
+    for (HBasicBlock* block : dominated) {
+      materialization_of[block->GetBlockId()] = i;
+    }
+  }
+  auto is_materialized = [&materialization_of](HBasicBlock* block) {
+    return materialization_of[block->GetBlockId()] != kNoMaterialization;
+  };
+
+  // The values of a member's locations are needed at the end of the blocks from which a
+  // load of the member, a phi merging it or a materialization can be reached.
+  ArenaBitVector needed(allocator_,
+                        number_of_members * number_of_blocks,
+                        /* expandable */ false,
+                        kArenaAllocPEA);
+  ScopedArenaVector<std::pair<size_t, HBasicBlock*>> worklist(
+      allocator_->Adapter(kArenaAllocPEA));
+  auto add_needed = [&](size_t member, HBasicBlock* block) {
+    DCHECK(in_scope.IsBitSet(index_of(member, block)));
+    if (!needed.IsBitSet(index_of(member, block))) {
+      needed.SetBit(index_of(member, block));
+      worklist.push_back(std::make_pair(member, block));
+    }
+  };
+  for (size_t m = 0; m != number_of_members; ++m) {
+    for (const HUseListNode<HInstruction*>& use : members_[m]->GetUses()) {
+      HInstruction* user = use.GetUser();
+      if (user->IsPhi()) {
+        add_needed(m, user->GetBlock()->GetPredecessors()[use.GetIndex()]);
+      } else if ((user->IsInstanceFieldGet() || user->IsArrayGet()) &&
+                 !is_materialized(user->GetBlock())) {
+        add_needed(m, user->GetBlock());
+      }
+    }
+  }
+  for (HBasicBlock* block : materialization_blocks_) {
+    add_needed(0u, block->GetSinglePredecessor());
+  }
+  while (!worklist.empty()) {
+    size_t member = worklist.back().first;
+    HBasicBlock* block = worklist.back().second;
+    worklist.pop_back();
+    if (block != members_[member]->GetBlock()) {
+      for (HBasicBlock* predecessor : block->GetPredecessors()) {
+        add_needed(member, predecessor);
+      }
+    }
+  }
+
+  // Values merged from several predecessors need phis: at the needed merge points, and at
+  // the start of the blocks of the member phis.
+  auto needs_phis = [&](size_t member, HBasicBlock* block) {
+    if (block == members_[member]->GetBlock()) {
+      return members_[member]->IsPhi();
+    }
+    return block->GetPredecessors().size() > 1u &&
+        !is_materialized(block) &&
+        needed.IsBitSet(index_of(member, block));
+  };
+  size_t number_of_phis = 0;
+  for (size_t m = 0; m != number_of_members; ++m) {
+    for (HBasicBlock* block : graph_->GetReversePostOrder()) {
+      if (in_scope.IsBitSet(index_of(m, block)) && needs_phis(m, block)) {
+        number_of_phis += number_of_locations;
+      }
+    }
+  }
+  if (number_of_phis > kMaximumNumberOfValuePhis) {
+    return false;
+  }
+
+  // From now on, the graph is changed.
+  ScopedArenaVector<HInstruction**> entry_values(
+      number_of_members * number_of_blocks, nullptr, allocator_->Adapter(kArenaAllocPEA));
+  ScopedArenaVector<HInstruction**> exit_values(
+      number_of_members * number_of_blocks, nullptr, allocator_->Adapter(kArenaAllocPEA));
+  for (size_t m = 0; m != number_of_members; ++m) {
+    for (HBasicBlock* block : graph_->GetReversePostOrder()) {
+      if (in_scope.IsBitSet(index_of(m, block)) && needs_phis(m, block)) {
+        HInstruction** values =
+            allocator_->AllocArray<HInstruction*>(number_of_locations, kArenaAllocPEA);
+        for (size_t i = 0; i != number_of_locations; ++i) {
+          values[i] = NewValuePhi(block, locations_[i].type);
+        }
+        entry_values[index_of(m, block)] = values;
+      }
+    }
+  }
+
+  // Follow the values of the locations through the blocks, outside of materializations.
+  for (HBasicBlock* block : graph_->GetReversePostOrder()) {
+    if (is_materialized(block)) {
+      continue;
+    }
+    for (size_t m = 0; m != number_of_members; ++m) {
+      size_t index = index_of(m, block);
+      if (!in_scope.IsBitSet(index)) {
+        continue;
+      }
+      HInstruction* member = members_[m];
+      HInstruction** values =
+          allocator_->AllocArray<HInstruction*>(number_of_locations, kArenaAllocPEA);
+      if (entry_values[index] != nullptr) {
+        std::copy_n(entry_values[index], number_of_locations, values);
+      } else if (block == member->GetBlock()) {
+        DCHECK(!member->IsPhi());
+        for (size_t i = 0; i != number_of_locations; ++i) {
+          values[i] = GetDefaultValue(graph_, locations_[i].type);
+        }
+      } else if (block->GetPredecessors().size() == 1u) {
+        std::copy_n(exit_values[index_of(m, block->GetSinglePredecessor())],
+                    number_of_locations,
+                    values);
+      } else {
+        // No load can be reached from this block.
+        std::fill_n(values, number_of_locations, nullptr);
+      }
+      for (HInstructionIterator it(block->GetInstructions()); !it.Done(); it.Advance()) {
+        HInstruction* instruction = it.Current();
+        if (instruction->InputCount() == 0u || instruction->InputAt(0) != member) {
+          continue;
+        }
+        if (instruction->IsInstanceFieldGet() || instruction->IsArrayGet()) {
+          HInstruction* value = values[FindLocation(instruction)];
+          DCHECK(value != nullptr);
+          loads_.push_back(instruction);
+          load_values_.Put(instruction, value);
+        } else if (instruction->IsInstanceFieldSet() || instruction->IsArraySet()) {
+          values[FindLocation(instruction)] = GetStoredValue(instruction);
+          stores_.push_back(instruction);
+        } else if (instruction->IsArrayLength()) {
+          lengths_.push_back(instruction);
+        } else {
+          DCHECK(instruction->IsConstructorFence()) << instruction->DebugName();
+        }
+      }
+      exit_values[index] = values;
+    }
+  }
+
+  // Materialize the allocation at the start of its escaping branches, and use it there.
+  if (!materialization_blocks_.empty()) {
+    HInstruction* allocation = members_[0];
+    for (HBasicBlock* block : materialization_blocks_) {
+      materializations_.push_back(
+          Materialize(block, exit_values[index_of(0u, block->GetSinglePredecessor())]));
+    }
+    const HUseList<HInstruction*>& uses = allocation->GetUses();
+    for (auto it = uses.begin(), end = uses.end(); it != end; /* ++it below */) {
+      HInstruction* user = it->GetUser();
+      size_t index = it->GetIndex();
+      // Increment `it` now because `*it` may disappear thanks to user->ReplaceInput().
+      ++it;
+      size_t materialization = materialization_of[user->GetBlock()->GetBlockId()];
+      if (materialization != kNoMaterialization) {
+        user->ReplaceInput(materializations_[materialization], index);
+      }
+    }
+    const HUseList<HEnvironment*>& env_uses = allocation->GetEnvUses();
+    for (auto it = env_uses.begin(), end = env_uses.end(); it != end; /* ++it below */) {
+      HEnvironment* user = it->GetUser();
+      size_t index = it->GetIndex();
+      ++it;
+      size_t materialization = materialization_of[user->GetHolder()->GetBlock()->GetBlockId()];
+      if (materialization != kNoMaterialization) {
+        user->RemoveAsUserOfInput(index);
+        user->SetRawEnvAt(index, materializations_[materialization]);
+        materializations_[materialization]->AddEnvUseAt(user, index);
+      }
+    }
+  }
+
+  // Now that all values are known, complete the phis.
+  for (size_t m = 0; m != number_of_members; ++m) {
+    for (HBasicBlock* block : graph_->GetReversePostOrder()) {
+      HInstruction** values = entry_values[index_of(m, block)];
+      if (values == nullptr) {
+        continue;
+      }
+      const ArenaVector<HBasicBlock*>& predecessors = block->GetPredecessors();
+      for (size_t p = 0; p != predecessors.size(); ++p) {
+        HBasicBlock* predecessor = predecessors[p];
+        // A member phi takes the values of its input.
+        size_t input =
+            (block == members_[m]->GetBlock()) ? FindMember(members_[m]->InputAt(p)) : m;
+        size_t materialization = materialization_of[predecessor->GetBlockId()];
+        for (size_t i = 0; i != number_of_locations; ++i) {
+          HInstruction* value = (materialization != kNoMaterialization)
+              ? GetExitLoad(materialization, predecessor, i)
+              : Resolve(exit_values[index_of(input, predecessor)][i]);
+          DCHECK(value != nullptr);
+          values[i]->AsPhi()->AddInput(value);
+        }
+      }
+    }
+  }
+
+  for (HInstruction* load : loads_) {
+    load->ReplaceWith(Resolve(load));
+    load->GetBlock()->RemoveInstruction(load);
+  }
+  for (HInstruction* store : stores_) {
+    store->GetBlock()->RemoveInstruction(store);
+  }
+  for (HInstruction* length : lengths_) {
+    length->ReplaceWith(graph_->GetIntConstant(array_length_));
+    length->GetBlock()->RemoveInstruction(length);
+  }
+  for (HInstruction* member : members_) {
+    HConstructorFence::RemoveConstructorFences(member);
+    member->RemoveEnvironmentUsers();
+    if (member->IsPhi()) {
+      member->RemoveAsUserOfAllInputs();
+    }
+  }
+  for (HInstruction* member : members_) {
+    DCHECK(!member->HasUses());
+    if (member->IsPhi()) {
+      member->GetBlock()->RemovePhi(member->AsPhi(), /* ensure_safety */ false);
+    } else {
+      member->GetBlock()->RemoveInstruction(member);
+    }
+  }
+
+  RemoveRedundantValuePhis();
+  return true;
+}
+
+void VirtualObjectGroup::RemoveRedundantValuePhis() {
+  // Replace the phis merging a single value, other than themselves.
+  ScopedArenaVector<HPhi*> worklist(value_phis_.begin(),
+                                    value_phis_.end(),
+                                    allocator_->Adapter(kArenaAllocPEA));
+  while (!worklist.empty()) {
+    HPhi* phi = worklist.back();
+    worklist.pop_back();
+    if (phi->GetBlock() == nullptr) {
+      // Already removed.
+      continue;
+    }
+    HInstruction* candidate = nullptr;
+    bool redundant = true;
+    for (HInstruction* input : phi->GetInputs()) {
+      if (input == phi || input == candidate) {
+        continue;
+      }
+      if (candidate != nullptr) {
+        redundant = false;
+        break;
+      }
+      candidate = input;
+    }
+    if (!redundant) {
+      continue;
+    }
+    DCHECK(candidate != nullptr);
+    for (const HUseListNode<HInstruction*>& use : phi->GetUses()) {
+      HInstruction* user = use.GetUser();
+      if (user->IsPhi() && ContainsElement(value_phis_, user->AsPhi())) {
+        worklist.push_back(user->AsPhi());
+      }
+    }
+    phi->ReplaceWith(candidate);
+    phi->GetBlock()->RemovePhi(phi);
+  }
+
+  // Remove the phis only used by other value phis, as SsaDeadPhiElimination does.
+  for (HPhi* phi : value_phis_) {
+    if (phi->GetBlock() == nullptr) {
+      continue;
+    }
+    bool live = phi->HasEnvironmentUses();
+    for (const HUseListNode<HInstruction*>& use : phi->GetUses()) {
+      HInstruction* user = use.GetUser();
+      live = live || !(user->IsPhi() && ContainsElement(value_phis_, user->AsPhi()));
+    }
+    if (live) {
+      worklist.push_back(phi);
+    } else {
+      phi->SetDead();
+    }
+  }
+  while (!worklist.empty()) {
+    HPhi* phi = worklist.back();
+    worklist.pop_back();
+    for (HInstruction* input : phi->GetInputs()) {
+      if (input->IsPhi() && input->AsPhi()->IsDead()) {
+        DCHECK(ContainsElement(value_phis_, input->AsPhi()));
+        input->AsPhi()->SetLive();
+        worklist.push_back(input->AsPhi());
+      }
+    }
+  }
+  for (HPhi* phi : value_phis_) {
+    if (phi->GetBlock() != nullptr && phi->IsDead()) {
+      phi->RemoveAsUserOfAllInputs();
+    }
+  }
+  for (HPhi* phi : value_phis_) {
+    if (phi->GetBlock() != nullptr && phi->IsDead()) {
+      phi->GetBlock()->RemovePhi(phi, /* ensure_safety */ false);
+    }
+  }
+}
+
+void PartialEscapeAnalysis::Run() {
+  // Debuggers can inspect the objects, catch phis would need the values at every
+  // throwing instruction, and irreducible loops need the phis we may remove.
+  if (graph_->IsDebuggable() || graph_->HasTryCatch() || graph_->HasIrreducibleLoops()) {
+    return;
+  }
+
+  ScopedArenaAllocator allocator(graph_->GetArenaStack());
+  ScopedArenaVector<HInstruction*> allocations(allocator.Adapter(kArenaAllocPEA));
+  for (HBasicBlock* block : graph_->GetReversePostOrder()) {
+    for (HInstructionIterator it(block->GetInstructions()); !it.Done(); it.Advance()) {
+      if (IsAllocationCandidate(it.Current())) {
+        allocations.push_back(it.Current());
+      }
+    }
+  }
+  const size_t number_of_instructions = graph_->GetCurrentInstructionId();
+  ArenaBitVector visited(&allocator,
+                         number_of_instructions,
+                         /* expandable */ false,
+                         kArenaAllocPEA);
+  for (HInstruction* allocation : allocations) {
+    if (visited.IsBitSet(allocation->GetId())) {
+      continue;
+    }
+    // The memory of each group is returned before the next one.
+    ScopedArenaAllocator group_allocator(graph_->GetArenaStack());
+    VirtualObjectGroup group(graph_, &group_allocator, number_of_instructions);
+    if (group.Collect(allocation, &visited) && group.Transform()) {
+      MaybeRecordStat(kPartialEscapeScalarReplaced, group.GetNumberOfAllocations());
+      MaybeRecordStat(kPartialEscapeMaterialized, group.GetNumberOfMaterializations());
+    }
+  }
+}
+
+}  // namespace art
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_PARTIAL_ESCAPE_ANALYSIS_H_
+#define ART_COMPILER_OPTIMIZING_PARTIAL_ESCAPE_ANALYSIS_H_
+
+#include "nodes.h"
+#include "optimization.h"
+
+namespace art {
+
+/**
+ * Scalar replacement of allocations that LSE could not remove, because they are merged
+ * through phis or escape only on some branches. For example:
+ *
+ *   p = new Point();                     x = a;
+ *   p.x = a;                             if (cond) {
+ *   if (cond) {                            p' = new Point();
+ *     sink(p);                 =>          p'.x = x;
+ *   }                                      sink(p');
+ *   return p.x;                              x' = p'.x;
+ *                                        }
+ *                                        return Phi(x, x');
+ *
+ * The fields of a group of allocations and of the phis merging them are tracked as SSA
+ * values, with new phis where the values of different paths meet. Loads are replaced by
+ * these values and the allocations and stores are removed.
+ *
+ * A single allocation may also escape, if every escape is in a branch at the loop depth
+ * of the allocation (the materialization block). The object is then allocated with its
+ * current field values at the start of that branch, which uses it instead. Code reached
+ * from that branch outside of it may only read the object, and reads from the object
+ * where the paths meet again.
+ *
+ * Finalizable objects, allocations that need access checks, volatile fields, and arrays
+ * that are not small with a constant length are left alone.
+ */
+class PartialEscapeAnalysis : public HOptimization {
+ public:
+  PartialEscapeAnalysis(HGraph* graph, OptimizingCompilerStats* stats)
+      : HOptimization(graph, kPartialEscapeAnalysisPassName, stats) {}
+
+  void Run() OVERRIDE;
+
+  static constexpr const char* kPartialEscapeAnalysisPassName = "partial_escape_analysis";
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(PartialEscapeAnalysis);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_PARTIAL_ESCAPE_ANALYSIS_H_
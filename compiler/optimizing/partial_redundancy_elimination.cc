@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "partial_redundancy_elimination.h"
+
+namespace art {
+
+/**
+ * Returns an instruction of `block` that computes the same value as `instruction`
+ * and is still valid at the end of `block`, or null if there is none.
+ */
+static HInstruction* FindAvailableAtEnd(HBasicBlock* block, HInstruction* instruction) {
+  SideEffects effects_after = SideEffects::None();
+  for (HBackwardInstructionIterator it(block->GetInstructions()); !it.Done(); it.Advance()) {
+    HInstruction* current = it.Current();
+    if (current->Equals(instruction)) {
+      return current;
+    }
+    effects_after = effects_after.Union(current->GetSideEffects());
+    if (instruction->GetSideEffects().MayDependOn(effects_after)) {
+      return nullptr;
+    }
+  }
+  return nullptr;
+}
+
+static bool IsCandidate(HInstruction* instruction) {
+  if (!instruction->CanBeMoved() ||
+      instruction->CanThrow() ||
+      instruction->DoesAnyWrite() ||
+      instruction->NeedsEnvironment() ||
+      instruction->GetType() == Primitive::kPrimVoid) {
+    return false;
+  }
+  // The inputs must be available on all incoming edges.
+  HBasicBlock* block = instruction->GetBlock();
+  for (const HInstruction* input : instruction->GetInputs()) {
+    if (input->GetBlock() == block) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool PartialRedundancyElimination::TryEliminate(HInstruction* instruction,
+                                                SideEffects effects_before) {
+  if (!IsCandidate(instruction) || instruction->GetSideEffects().MayDependOn(effects_before)) {
+    return false;
+  }
+  HBasicBlock* block = instruction->GetBlock();
+  const ArenaVector<HBasicBlock*>& predecessors = block->GetPredecessors();
+  ArenaVector<HInstruction*> available(predecessors.size(),
+                                       nullptr,
+                                       graph_->GetArena()->Adapter(kArenaAllocPRE));
+  HBasicBlock* missing = nullptr;
+  for (size_t i = 0, e = predecessors.size(); i != e; ++i) {
+    available[i] = FindAvailableAtEnd(predecessors[i], instruction);
+    if (available[i] == nullptr) {
+      if (missing != nullptr) {
+        // Computing the value on more than one edge would need a copy of `instruction`.
+        return false;
+      }
+      missing = predecessors[i];
+    }
+  }
+
+  if (missing != nullptr) {
+    // Compute the value on the missing edge instead of in `block`.
+    instruction->MoveBefore(missing->GetLastInstruction());
+    auto it = std::find(available.begin(), available.end(), nullptr);
+    *it = instruction;
+  }
+  HPhi* phi = new (graph_->GetArena()) HPhi(graph_->GetArena(),
+                                                kNoRegNumber,
+                                                0,
+                                                HPhi::ToPhiType(instruction->GetType()));
+  block->AddPhi(phi);
+  if (instruction->GetType() == Primitive::kPrimNot) {
+    phi->SetReferenceTypeInfo(instruction->GetReferenceTypeInfo());
+    phi->SetCanBeNull(instruction->CanBeNull());
+  }
+  instruction->ReplaceWith(phi);
+  for (HInstruction* input : available) {
+    phi->AddInput(input);
+  }
+  if (missing == nullptr) {
+    // Fully redundant.
+    block->RemoveInstruction(instruction);
+  }
+  MaybeRecordStat(MethodCompilationStat::kPartialRedundancyEliminated);
+  return true;
+}
+
+void PartialRedundancyElimination::Run() {
+  for (HBasicBlock* block : graph_->GetReversePostOrder()) {
+    // Loop headers are left to LICM. Try/catch edges carry exceptional control flow that
+    // we cannot insert code on.
+    if (block->GetPredecessors().size() < 2u ||
+        block->IsLoopHeader() ||
+        block->IsCatchBlock() ||
+        block->IsTryBlock()) {
+      continue;
+    }
+    bool has_simple_predecessors = true;
+    for (HBasicBlock* predecessor : block->GetPredecessors()) {
+      if (predecessor->GetSingleSuccessor() != block ||
+          !predecessor->GetLastInstruction()->IsGoto()) {
+        has_simple_predecessors = false;
+        break;
+      }
+    }
+    if (!has_simple_predecessors) {
+      continue;
+    }
+
+    // The side effects of the instructions of `block` preceding the current one.
+    SideEffects effects_before = SideEffects::None();
+    for (HInstructionIterator it(block->GetInstructions()); !it.Done(); it.Advance()) {
+      HInstruction* instruction = it.Current();
+      if (!TryEliminate(instruction, effects_before)) {
+        effects_before = effects_before.Union(instruction->GetSideEffects());
+      }
+    }
+  }
+}
+
+}  // namespace art
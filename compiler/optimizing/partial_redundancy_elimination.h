@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_PARTIAL_REDUNDANCY_ELIMINATION_H_
+#define ART_COMPILER_OPTIMIZING_PARTIAL_REDUNDANCY_ELIMINATION_H_
+
+#include "nodes.h"
+#include "optimization.h"
+
+namespace art {
+
+/**
+ * Removes computations at merge points that are redundant on all but at most one of the
+ * incoming edges. For example:
+ *
+ *   if (cond) {                          if (cond) {
+ *     a = obj.field;                       a = obj.field;
+ *     ...                                  ...
+ *   }                          =>        } else {
+ *   b = obj.field;                         b' = obj.field;
+ *                                        }
+ *                                        b = Phi(a, b')
+ *
+ * The computation is moved to the edge where it is not available, if any, and merged with
+ * the equivalent computations of the other edges through a phi. No path executes more
+ * instructions than before. Only movable instructions that can neither throw nor write
+ * are considered, since the instruction may then execute at a different point.
+ */
+class PartialRedundancyElimination : public HOptimization {
+ public:
+  PartialRedundancyElimination(HGraph* graph, OptimizingCompilerStats* stats)
+      : HOptimization(graph, kPartialRedundancyEliminationPassName, stats) {}
+
+  void Run() OVERRIDE;
+
+  static constexpr const char* kPartialRedundancyEliminationPassName = "pre";
+
+ private:
+  bool TryEliminate(HInstruction* instruction, SideEffects effects_before);
+
+  DISALLOW_COPY_AND_ASSIGN(PartialRedundancyElimination);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_PARTIAL_REDUNDANCY_ELIMINATION_H_
@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "base/arena_allocator.h"
+#include "builder.h"
+#include "nodes.h"
+#include "optimizing_unit_test.h"
+#include "partial_redundancy_elimination.h"
+
+namespace art {
+
+/**
+ * Fixture class for the partial redundancy elimination tests.
+ */
+class PartialRedundancyEliminationTest : public CommonCompilerTest {
+ public:
+  PartialRedundancyEliminationTest()
+      : pool_(),
+        allocator_(&pool_),
+        entry_(nullptr),
+        left_(nullptr),
+        right_(nullptr),
+        merge_(nullptr),
+        exit_(nullptr),
+        parameter_(nullptr),
+        return_(nullptr) {
+    graph_ = CreateGraph(&allocator_);
+  }
+
+  // Builds a diamond in the CFG. Tests then populate the branches and the
+  // merge block, which returns the value computed by `merge_get`.
+  void BuildDiamond(HInstruction* merge_get) {
+    entry_ = new (&allocator_) HBasicBlock(graph_);
+    left_ = new (&allocator_) HBasicBlock(graph_);
+    right_ = new (&allocator_) HBasicBlock(graph_);
+    merge_ = new (&allocator_) HBasicBlock(graph_);
+    exit_ = new (&allocator_) HBasicBlock(graph_);
+
+    graph_->AddBlock(entry_);
+    graph_->AddBlock(left_);
+    graph_->AddBlock(right_);
+    graph_->AddBlock(merge_);
+    graph_->AddBlock(exit_);
+
+    graph_->SetEntryBlock(entry_);
+    graph_->SetExitBlock(exit_);
+
+    entry_->AddSuccessor(left_);
+    entry_->AddSuccessor(right_);
+    left_->AddSuccessor(merge_);
+    right_->AddSuccessor(merge_);
+    merge_->AddSuccessor(exit_);
+
+    entry_->AddInstruction(parameter_);
+    entry_->AddInstruction(new (&allocator_) HIf(parameter_));
+    left_->AddInstruction(new (&allocator_) HGoto());
+    right_->AddInstruction(new (&allocator_) HGoto());
+    merge_->AddInstruction(merge_get);
+    return_ = new (&allocator_) HReturn(merge_get);
+    merge_->AddInstruction(return_);
+    exit_->AddInstruction(new (&allocator_) HExit());
+  }
+
+  HInstruction* CreateFieldGet() {
+    return new (&allocator_) HInstanceFieldGet(parameter_,
+                                               nullptr,
+                                               Primitive::kPrimInt,
+                                               MemberOffset(12),
+                                               false,
+                                               kUnknownFieldIndex,
+                                               kUnknownClassDefIndex,
+                                               graph_->GetDexFile(),
+                                               0);
+  }
+
+  HInstruction* CreateFieldSet() {
+    return new (&allocator_) HInstanceFieldSet(parameter_,
+                                               graph_->GetIntConstant(42),
+                                               nullptr,
+                                               Primitive::kPrimInt,
+                                               MemberOffset(16),
+                                               false,
+                                               kUnknownFieldIndex,
+                                               kUnknownClassDefIndex,
+                                               graph_->GetDexFile(),
+                                               0);
+  }
+
+  void CreateParameter() {
+    parameter_ = new (&allocator_) HParameterValue(graph_->GetDexFile(),
+                                                   dex::TypeIndex(0),
+                                                   0,
+                                                   Primitive::kPrimNot);
+  }
+
+  void PerformPRE() {
+    graph_->BuildDominatorTree();
+    PartialRedundancyElimination(graph_, nullptr).Run();
+  }
+
+  // General building fields.
+  ArenaPool pool_;
+  ArenaAllocator allocator_;
+  HGraph* graph_;
+
+  // Specific basic blocks.
+  HBasicBlock* entry_;
+  HBasicBlock* left_;
+  HBasicBlock* right_;
+  HBasicBlock* merge_;
+  HBasicBlock* exit_;
+
+  HInstruction* parameter_;
+  HInstruction* return_;
+};
+
+TEST_F(PartialRedundancyEliminationTest, PartiallyRedundantFieldGet) {
+  CreateParameter();
+  HInstruction* merge_get = CreateFieldGet();
+  BuildDiamond(merge_get);
+  HInstruction* left_get = CreateFieldGet();
+  left_->InsertInstructionBefore(left_get, left_->GetLastInstruction());
+
+  PerformPRE();
+
+  // The load is no longer executed twice on the left path.
+  EXPECT_EQ(right_, merge_get->GetBlock());
+  HInstruction* phi = return_->InputAt(0);
+  ASSERT_TRUE(phi->IsPhi());
+  EXPECT_EQ(merge_, phi->GetBlock());
+  EXPECT_EQ(left_get, phi->InputAt(0));
+  EXPECT_EQ(merge_get, phi->InputAt(1));
+}
+
+TEST_F(PartialRedundancyEliminationTest, FullyRedundantFieldGet) {
+  CreateParameter();
+  HInstruction* merge_get = CreateFieldGet();
+  BuildDiamond(merge_get);
+  HInstruction* left_get = CreateFieldGet();
+  left_->InsertInstructionBefore(left_get, left_->GetLastInstruction());
+  HInstruction* right_get = CreateFieldGet();
+  right_->InsertInstructionBefore(right_get, right_->GetLastInstruction());
+
+  PerformPRE();
+
+  EXPECT_EQ(nullptr, merge_get->GetBlock());
+  HInstruction* phi = return_->InputAt(0);
+  ASSERT_TRUE(phi->IsPhi());
+  EXPECT_EQ(left_get, phi->InputAt(0));
+  EXPECT_EQ(right_get, phi->InputAt(1));
+}
+
+TEST_F(PartialRedundancyEliminationTest, KilledInPredecessor) {
+  CreateParameter();
+  HInstruction* merge_get = CreateFieldGet();
+  BuildDiamond(merge_get);
+  HInstruction* left_get = CreateFieldGet();
+  left_->InsertInstructionBefore(left_get, left_->GetLastInstruction());
+  HInstruction* left_set = CreateFieldSet();
+  left_->InsertInstructionBefore(left_set, left_->GetLastInstruction());
+
+  PerformPRE();
+
+  // The field set may write the loaded field.
+  EXPECT_EQ(merge_, merge_get->GetBlock());
+  EXPECT_EQ(merge_get, return_->InputAt(0));
+}
+
+TEST_F(PartialRedundancyEliminationTest, KilledInMergeBlock) {
+  CreateParameter();
+  HInstruction* merge_get = CreateFieldGet();
+  BuildDiamond(merge_get);
+  HInstruction* left_get = CreateFieldGet();
+  left_->InsertInstructionBefore(left_get, left_->GetLastInstruction());
+  merge_->InsertInstructionBefore(CreateFieldSet(), merge_get);
+
+  PerformPRE();
+
+  EXPECT_EQ(merge_, merge_get->GetBlock());
+  EXPECT_EQ(merge_get, return_->InputAt(0));
+}
+
+TEST_F(PartialRedundancyEliminationTest, NotAvailable) {
+  CreateParameter();
+  HInstruction* merge_get = CreateFieldGet();
+  BuildDiamond(merge_get);
+
+  PerformPRE();
+
+  EXPECT_EQ(merge_, merge_get->GetBlock());
+  EXPECT_EQ(merge_get, return_->InputAt(0));
+}
+
+}  // namespace art
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pass_profile.h"
+
+#include "base/time_utils.h"
+#include "nodes.h"
+#include "thread-current-inl.h"
+
+namespace art {
+
+// The kind names are padded for the column layout of MemStats::Dump().
+static void DumpKindName(std::ostream& os, ArenaAllocKind kind) {
+  std::string name = GetArenaAllocKindName(kind);
+  name.erase(name.find_last_not_of(' ') + 1u);
+  os << '"' << name << '"';
+}
+
+PassProfile::PassStats::PassStats()
+    : runs(0u),
+      time_ns(0u),
+      arena_bytes(0u),
+      arena_bytes_by_kind(),
+      blocks_before(0u),
+      blocks_after(0u),
+      instructions_before(0u),
+      instructions_after(0u) {}
+
+PassProfile::PassProfile() : lock_("Pass profile lock") {}
+
+void PassProfile::TakeSnapshot(HGraph* graph, Snapshot* snapshot) {
+  ArenaAllocator* arena = graph->GetArena();
+  snapshot->arena_bytes = arena->BytesUsed();
+  if (kArenaAllocatorCountAllocations) {
+    for (size_t i = 0; i != kNumArenaAllocKinds; ++i) {
+      snapshot->arena_bytes_by_kind[i] = arena->BytesAllocated(static_cast<ArenaAllocKind>(i));
+    }
+  }
+  size_t blocks = 0u;
+  size_t instructions = 0u;
+  for (HBasicBlock* block : graph->GetBlocks()) {
+    // Removed blocks leave a null entry behind.
+    if (block != nullptr) {
+      ++blocks;
+      for (HInstructionIterator it(block->GetPhis()); !it.Done(); it.Advance()) {
+        ++instructions;
+      }
+      for (HInstructionIterator it(block->GetInstructions()); !it.Done(); it.Advance()) {
+        ++instructions;
+      }
+    }
+  }
+  snapshot->blocks = blocks;
+  snapshot->instructions = instructions;
+  // Read the time last so that the walk above is not accounted to the pass.
+  snapshot->time_ns = NanoTime();
+}
+
+void PassProfile::RecordPass(const char* pass_name, const Snapshot& start, const Snapshot& end) {
+  MutexLock mu(Thread::Current(), lock_);
+  PassStats& stats = passes_[pass_name];
+  ++stats.runs;
+  stats.time_ns += end.time_ns - start.time_ns;
+  stats.arena_bytes += end.arena_bytes - start.arena_bytes;
+  if (kArenaAllocatorCountAllocations) {
+    for (size_t i = 0; i != kNumArenaAllocKinds; ++i) {
+      stats.arena_bytes_by_kind[i] += end.arena_bytes_by_kind[i] - start.arena_bytes_by_kind[i];
+    }
+  }
+  stats.blocks_before += start.blocks;
+  stats.blocks_after += end.blocks;
+  stats.instructions_before += start.instructions;
+  stats.instructions_after += end.instructions;
+}
+
+void PassProfile::Dump(std::ostream& os) {
+  MutexLock mu(Thread::Current(), lock_);
+  os << "{\n  \"passes\": {";
+  const char* pass_separator = "\n";
+  for (const auto& entry : passes_) {
+    const PassStats& stats = entry.second;
+    os << pass_separator
+       << "    \"" << entry.first << "\": {\n"
+       << "      \"runs\": " << stats.runs << ",\n"
+       << "      \"time_ns\": " << stats.time_ns << ",\n"
+       << "      \"arena_bytes\": " << stats.arena_bytes << ",\n"
+       << "      \"blocks_before\": " << stats.blocks_before << ",\n"
+       << "      \"blocks_after\": " << stats.blocks_after << ",\n"
+       << "      \"instructions_before\": " << stats.instructions_before << ",\n"
+       << "      \"instructions_after\": " << stats.instructions_after << ",\n"
+       << "      \"arena_bytes_by_kind\": {";
+    const char* kind_separator = "";
+    for (size_t i = 0; i != kNumArenaAllocKinds; ++i) {
+      if (stats.arena_bytes_by_kind[i] != 0u) {
+        os << kind_separator;
+        DumpKindName(os, static_cast<ArenaAllocKind>(i));
+        os << ": " << stats.arena_bytes_by_kind[i];
+        kind_separator = ", ";
+      }
+    }
+    os << "}\n    }";
+    pass_separator = ",\n";
+  }
+  os << "\n  }\n}\n";
+}
+
+}  // namespace art
@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_PASS_PROFILE_H_
+#define ART_COMPILER_OPTIMIZING_PASS_PROFILE_H_
+
+#include <array>
+#include <map>
+#include <ostream>
+#include <string>
+
+#include "base/arena_allocator.h"
+#include "base/mutex.h"
+
+namespace art {
+
+class HGraph;
+
+/**
+ * Aggregates, over a compilation session, the wall time, the arena memory and the change in graph
+ * size of each optimizing compiler pass. Arena bytes per ArenaAllocKind are only available when
+ * kArenaAllocatorCountAllocations is set; the total is always recorded.
+ */
+class PassProfile {
+ public:
+  // The state of a graph and its arena at the start or the end of a pass.
+  struct Snapshot {
+    uint64_t time_ns;
+    size_t arena_bytes;
+    std::array<size_t, kNumArenaAllocKinds> arena_bytes_by_kind;
+    size_t blocks;
+    size_t instructions;
+  };
+
+  PassProfile();
+
+  static void TakeSnapshot(HGraph* graph, Snapshot* snapshot);
+
+  void RecordPass(const char* pass_name, const Snapshot& start, const Snapshot& end)
+      REQUIRES(!lock_);
+
+  void Dump(std::ostream& os) REQUIRES(!lock_);
+
+ private:
+  struct PassStats {
+    PassStats();
+
+    size_t runs;
+    uint64_t time_ns;
+    uint64_t arena_bytes;
+    std::array<uint64_t, kNumArenaAllocKinds> arena_bytes_by_kind;
+    uint64_t blocks_before;
+    uint64_t blocks_after;
+    uint64_t instructions_before;
+    uint64_t instructions_after;
+  };
+
+  Mutex lock_;
+  std::map<std::string, PassStats> passes_ GUARDED_BY(lock_);
+
+  DISALLOW_COPY_AND_ASSIGN(PassProfile);
+};
+
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_PASS_PROFILE_H_
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "pass_profile.h"
+
+#include <sstream>
+
+#include "base/arena_allocator.h"
+#include "common_runtime_test.h"
+#include "nodes.h"
+#include "optimizing_unit_test.h"
+
+namespace art {
+
+class PassProfileTest : public CommonRuntimeTest {};
+
+TEST_F(PassProfileTest, SnapshotAndDump) {
+  ArenaPool pool;
+  ArenaAllocator allocator(&pool);
+  HGraph* graph = CreateGraph(&allocator);
+
+  PassProfile::Snapshot start;
+  PassProfile::TakeSnapshot(graph, &start);
+  EXPECT_EQ(start.blocks, 0u);
+  EXPECT_EQ(start.instructions, 0u);
+
+  HBasicBlock* entry = new (&allocator) HBasicBlock(graph);
+  graph->AddBlock(entry);
+  graph->SetEntryBlock(entry);
+  entry->AddInstruction(new (&allocator) HGoto());
+  HBasicBlock* exit = new (&allocator) HBasicBlock(graph);
+  graph->AddBlock(exit);
+  graph->SetExitBlock(exit);
+  exit->AddInstruction(new (&allocator) HExit());
+
+  PassProfile::Snapshot end;
+  PassProfile::TakeSnapshot(graph, &end);
+  EXPECT_EQ(end.blocks, 2u);
+  EXPECT_EQ(end.instructions, 2u);
+  EXPECT_GT(end.arena_bytes, start.arena_bytes);
+  EXPECT_GE(end.time_ns, start.time_ns);
+
+  PassProfile profile;
+  profile.RecordPass("builder", start, end);
+  profile.RecordPass("builder", end, end);
+  profile.RecordPass("dead_code_elimination$initial", end, end);
+  std::ostringstream oss;
+  profile.Dump(oss);
+  const std::string json = oss.str();
+  EXPECT_NE(json.find("\"builder\": {\n      \"runs\": 2,"), std::string::npos) << json;
+  EXPECT_NE(json.find("\"blocks_after\": 4,"), std::string::npos) << json;
+  EXPECT_NE(json.find("\"instructions_before\": 2,"), std::string::npos) << json;
+  EXPECT_NE(json.find("\"dead_code_elimination$initial\": {"), std::string::npos) << json;
+}
+
+}  // namespace art
@@ -44,12 +44,24 @@ RegisterAllocator* RegisterAllocator::Create(ArenaAllocator* allocator,
       return new (allocator) RegisterAllocatorLinearScan(allocator, codegen, analysis);
     case kRegisterAllocatorGraphColor:
       return new (allocator) RegisterAllocatorGraphColor(allocator, codegen, analysis);
+    case kRegisterAllocatorHybrid:
+      if (ShouldUseGraphColor(*codegen->GetGraph(), analysis)) {
+        return new (allocator) RegisterAllocatorGraphColor(allocator, codegen, analysis);
+      }
+      return new (allocator) RegisterAllocatorLinearScan(allocator, codegen, analysis);
     default:
       LOG(FATAL) << "Invalid register allocation strategy: " << strategy;
       UNREACHABLE();
   }
 }
 
+bool RegisterAllocator::ShouldUseGraphColor(const HGraph& graph,
+                                            const SsaLivenessAnalysis& analysis) {
+  // Graph coloring mostly pays off by keeping loop values in registers, while the size of
+  // its interference graph grows superlinearly with the number of live intervals.
+  return graph.HasLoops() && analysis.GetNumberOfSsaValues() <= kMaxSsaValuesForGraphColor;
+}
+
 bool RegisterAllocator::CanAllocateRegistersFor(const HGraph& graph ATTRIBUTE_UNUSED,
                                                 InstructionSet instruction_set) {
   return instruction_set == kArm
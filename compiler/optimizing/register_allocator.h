@@ -41,7 +41,10 @@ class RegisterAllocator : public ArenaObject<kArenaAllocRegisterAllocator> {
  public:
   enum Strategy {
     kRegisterAllocatorLinearScan,
-    kRegisterAllocatorGraphColor
+    kRegisterAllocatorGraphColor,
+    // Graph coloring for methods with loops that are small enough for its compile time
+    // and memory use to stay reasonable, linear scan otherwise.
+    kRegisterAllocatorHybrid
   };
 
   static constexpr Strategy kRegisterAllocatorDefault = kRegisterAllocatorLinearScan;
@@ -64,6 +67,12 @@ class RegisterAllocator : public ArenaObject<kArenaAllocRegisterAllocator> {
   static bool CanAllocateRegistersFor(const HGraph& graph,
                                       InstructionSet instruction_set);
 
+  // Returns whether the hybrid strategy should use graph coloring for `graph`.
+  static bool ShouldUseGraphColor(const HGraph& graph, const SsaLivenessAnalysis& analysis);
+
+  // Above this number of SSA values, the hybrid strategy falls back to linear scan.
+  static constexpr size_t kMaxSsaValuesForGraphColor = 1024;
+
   // Verifies that live intervals do not conflict. Used by unit testing.
   static bool ValidateIntervals(const ArenaVector<LiveInterval*>& intervals,
                                 size_t number_of_spill_slots,
@@ -1170,11 +1170,15 @@ void ColoringIteration::BuildInterferenceGraph(
   //
   // For simplicity, we create a tuple for each endpoint, and then sort the tuples.
   // Tuple contents: (position, is_range_beginning, node).
+  //
+  // The endpoints and the live set are only needed while building the graph, so they live in
+  // their own arena, which goes back to the pool before pruning and coloring allocate more.
+  ArenaAllocator build_allocator(allocator_->GetArenaPool());
   ArenaVector<std::tuple<size_t, bool, InterferenceNode*>> range_endpoints(
-      allocator_->Adapter(kArenaAllocRegisterAllocator));
+      build_allocator.Adapter(kArenaAllocRegisterAllocator));
 
   // We reserve plenty of space to avoid excessive copying.
-  range_endpoints.reserve(4 * prunable_nodes_.size());
+  range_endpoints.reserve(4 * intervals.size());
 
   for (LiveInterval* parent : intervals) {
     for (LiveInterval* sibling = parent; sibling != nullptr; sibling = sibling->GetNextSibling()) {
@@ -1217,7 +1221,7 @@ void ColoringIteration::BuildInterferenceGraph(
 
   // Nodes live at the current position in the linear sweep.
   ArenaVector<InterferenceNode*> live(
-      allocator_->Adapter(kArenaAllocRegisterAllocator));
+      build_allocator.Adapter(kArenaAllocRegisterAllocator));
 
   // Linear sweep. When we encounter the beginning of a range, we add the corresponding node to the
   // live set. When we encounter the end of a range, we remove the corresponding node
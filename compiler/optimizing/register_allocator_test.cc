@@ -52,6 +52,9 @@ TEST_F(RegisterAllocatorTest, test_name##_LinearScan) {\
 }\
 TEST_F(RegisterAllocatorTest, test_name##_GraphColor) {\
   test_name(Strategy::kRegisterAllocatorGraphColor);\
+}\
+TEST_F(RegisterAllocatorTest, test_name##_Hybrid) {\
+  test_name(Strategy::kRegisterAllocatorHybrid);\
 }
 
 static bool Check(const uint16_t* data, Strategy strategy) {
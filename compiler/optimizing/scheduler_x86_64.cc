@@ -0,0 +1,286 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "scheduler_x86_64.h"
+#include "code_generator_utils.h"
+#include "mirror/array-inl.h"
+
+namespace art {
+namespace x86_64 {
+
+void SchedulingLatencyVisitorX86_64::VisitBinaryOperation(HBinaryOperation* instr) {
+  last_visited_latency_ = Primitive::IsFloatingPointType(instr->GetResultType())
+      ? kX86_64FloatingPointOpLatency
+      : kX86_64IntegerOpLatency;
+}
+
+void SchedulingLatencyVisitorX86_64::VisitArrayGet(HArrayGet* instruction) {
+  // The address computation folds into the memory operand.
+  if (instruction->IsStringCharAt() && mirror::kUseStringCompression) {
+    // Take the compression flag test into account.
+    last_visited_internal_latency_ = kX86_64MemoryLoadLatency + kX86_64BranchLatency;
+  }
+  last_visited_latency_ = kX86_64MemoryLoadLatency;
+}
+
+void SchedulingLatencyVisitorX86_64::VisitArrayLength(HArrayLength* ATTRIBUTE_UNUSED) {
+  last_visited_latency_ = kX86_64MemoryLoadLatency;
+}
+
+void SchedulingLatencyVisitorX86_64::VisitArraySet(HArraySet* ATTRIBUTE_UNUSED) {
+  last_visited_latency_ = kX86_64MemoryStoreLatency;
+}
+
+void SchedulingLatencyVisitorX86_64::VisitBoundsCheck(HBoundsCheck* ATTRIBUTE_UNUSED) {
+  last_visited_internal_latency_ = kX86_64IntegerOpLatency;
+  // Users do not use any data results.
+  last_visited_latency_ = 0;
+}
+
+// Follow the code path used by code generation for a constant divisor.
+void SchedulingLatencyVisitorX86_64::HandleDivRemConstantIntegral(HBinaryOperation* instruction,
+                                                                  uint32_t multiply_latency) {
+  int64_t imm = Int64FromConstant(instruction->GetRight()->AsConstant());
+  if (imm == 0) {
+    last_visited_internal_latency_ = 0;
+    last_visited_latency_ = 0;
+  } else if (imm == 1 || imm == -1) {
+    last_visited_internal_latency_ = 0;
+    last_visited_latency_ = kX86_64IntegerOpLatency;
+  } else if (IsPowerOfTwo(AbsOrMin(imm))) {
+    last_visited_internal_latency_ = 3 * kX86_64IntegerOpLatency;
+    last_visited_latency_ = kX86_64IntegerOpLatency;
+  } else {
+    DCHECK(imm <= -2 || imm >= 2);
+    last_visited_internal_latency_ = kX86_64MulIntegerLatency + 3 * kX86_64IntegerOpLatency;
+    last_visited_latency_ = multiply_latency;
+  }
+}
+
+void SchedulingLatencyVisitorX86_64::VisitDiv(HDiv* instr) {
+  Primitive::Type type = instr->GetResultType();
+  switch (type) {
+    case Primitive::kPrimFloat:
+      last_visited_latency_ = kX86_64DivFloatLatency;
+      break;
+    case Primitive::kPrimDouble:
+      last_visited_latency_ = kX86_64DivDoubleLatency;
+      break;
+    default:
+      if (instr->GetRight()->IsConstant()) {
+        HandleDivRemConstantIntegral(instr, kX86_64IntegerOpLatency);
+      } else {
+        last_visited_latency_ = (type == Primitive::kPrimLong)
+            ? kX86_64DivLongLatency
+            : kX86_64DivIntegerLatency;
+      }
+      break;
+  }
+}
+
+void SchedulingLatencyVisitorX86_64::VisitInstanceFieldGet(HInstanceFieldGet* ATTRIBUTE_UNUSED) {
+  last_visited_latency_ = kX86_64MemoryLoadLatency;
+}
+
+void SchedulingLatencyVisitorX86_64::VisitInstanceOf(HInstanceOf* ATTRIBUTE_UNUSED) {
+  last_visited_internal_latency_ = kX86_64CallInternalLatency;
+  last_visited_latency_ = kX86_64IntegerOpLatency;
+}
+
+void SchedulingLatencyVisitorX86_64::VisitInvoke(HInvoke* ATTRIBUTE_UNUSED) {
+  last_visited_internal_latency_ = kX86_64CallInternalLatency;
+  last_visited_latency_ = kX86_64CallLatency;
+}
+
+void SchedulingLatencyVisitorX86_64::VisitLoadString(HLoadString* ATTRIBUTE_UNUSED) {
+  last_visited_internal_latency_ = kX86_64LoadStringInternalLatency;
+  last_visited_latency_ = kX86_64MemoryLoadLatency;
+}
+
+void SchedulingLatencyVisitorX86_64::VisitMul(HMul* instr) {
+  last_visited_latency_ = Primitive::IsFloatingPointType(instr->GetResultType())
+      ? kX86_64MulFloatingPointLatency
+      : kX86_64MulIntegerLatency;
+}
+
+void SchedulingLatencyVisitorX86_64::VisitNewArray(HNewArray* ATTRIBUTE_UNUSED) {
+  last_visited_internal_latency_ = kX86_64IntegerOpLatency + kX86_64CallInternalLatency;
+  last_visited_latency_ = kX86_64CallLatency;
+}
+
+void SchedulingLatencyVisitorX86_64::VisitNewInstance(HNewInstance* instruction) {
+  if (instruction->IsStringAlloc()) {
+    last_visited_internal_latency_ = 2 + kX86_64MemoryLoadLatency + kX86_64CallInternalLatency;
+  } else {
+    last_visited_internal_latency_ = kX86_64CallInternalLatency;
+  }
+  last_visited_latency_ = kX86_64CallLatency;
+}
+
+void SchedulingLatencyVisitorX86_64::VisitRem(HRem* instruction) {
+  Primitive::Type type = instruction->GetResultType();
+  if (Primitive::IsFloatingPointType(type)) {
+    // The remainder is computed with an x87 `fprem` loop going through the stack.
+    last_visited_internal_latency_ = kX86_64RemFloatingPointInternalLatency;
+    last_visited_latency_ = kX86_64MemoryLoadLatency;
+  } else if (instruction->GetRight()->IsConstant()) {
+    HandleDivRemConstantIntegral(instruction, kX86_64MulIntegerLatency);
+  } else {
+    // The remainder is a side result of the `idiv`.
+    last_visited_latency_ = (type == Primitive::kPrimLong)
+        ? kX86_64DivLongLatency
+        : kX86_64DivIntegerLatency;
+  }
+}
+
+void SchedulingLatencyVisitorX86_64::VisitStaticFieldGet(HStaticFieldGet* ATTRIBUTE_UNUSED) {
+  last_visited_latency_ = kX86_64MemoryLoadLatency;
+}
+
+void SchedulingLatencyVisitorX86_64::VisitSuspendCheck(HSuspendCheck* instruction) {
+  HBasicBlock* block = instruction->GetBlock();
+  DCHECK((block->GetLoopInformation() != nullptr) ||
+         (block->IsEntryBlock() && instruction->GetNext()->IsGoto()));
+  // Users do not use any data results.
+  last_visited_latency_ = 0;
+}
+
+void SchedulingLatencyVisitorX86_64::VisitTypeConversion(HTypeConversion* instr) {
+  if (Primitive::IsFloatingPointType(instr->GetResultType()) ||
+      Primitive::IsFloatingPointType(instr->GetInputType())) {
+    last_visited_latency_ = kX86_64TypeConversionFloatingPointIntegerLatency;
+  } else {
+    last_visited_latency_ = kX86_64IntegerOpLatency;
+  }
+}
+
+void SchedulingLatencyVisitorX86_64::HandleSimpleArithmeticSIMD(HVecOperation* instr) {
+  if (Primitive::IsFloatingPointType(instr->GetPackedType())) {
+    last_visited_latency_ = kX86_64SIMDFloatingPointOpLatency;
+  } else {
+    last_visited_latency_ = kX86_64SIMDIntegerOpLatency;
+  }
+}
+
+void SchedulingLatencyVisitorX86_64::VisitVecReplicateScalar(
+    HVecReplicateScalar* instr ATTRIBUTE_UNUSED) {
+  last_visited_latency_ = kX86_64SIMDReplicateOpLatency;
+}
+
+void SchedulingLatencyVisitorX86_64::VisitVecCnv(HVecCnv* instr ATTRIBUTE_UNUSED) {
+  last_visited_latency_ = kX86_64SIMDTypeConversionInt2FPLatency;
+}
+
+void SchedulingLatencyVisitorX86_64::VisitVecNeg(HVecNeg* instr) {
+  // Negation subtracts from a zeroed register.
+  last_visited_internal_latency_ = kX86_64SIMDIntegerOpLatency;
+  HandleSimpleArithmeticSIMD(instr);
+}
+
+void SchedulingLatencyVisitorX86_64::VisitVecAbs(HVecAbs* instr) {
+  // Abs materializes a mask or a shifted copy first.
+  last_visited_internal_latency_ = 2 * kX86_64SIMDIntegerOpLatency;
+  HandleSimpleArithmeticSIMD(instr);
+}
+
+void SchedulingLatencyVisitorX86_64::VisitVecNot(HVecNot* instr ATTRIBUTE_UNUSED) {
+  // Not materializes an all-ones (or boolean one) constant first.
+  last_visited_internal_latency_ = kX86_64SIMDIntegerOpLatency;
+  last_visited_latency_ = kX86_64SIMDIntegerOpLatency;
+}
+
+void SchedulingLatencyVisitorX86_64::VisitVecAdd(HVecAdd* instr) {
+  HandleSimpleArithmeticSIMD(instr);
+}
+
+void SchedulingLatencyVisitorX86_64::VisitVecHalvingAdd(HVecHalvingAdd* instr) {
+  HandleSimpleArithmeticSIMD(instr);
+}
+
+void SchedulingLatencyVisitorX86_64::VisitVecSub(HVecSub* instr) {
+  HandleSimpleArithmeticSIMD(instr);
+}
+
+void SchedulingLatencyVisitorX86_64::VisitVecMul(HVecMul* instr) {
+  if (Primitive::IsFloatingPointType(instr->GetPackedType())) {
+    last_visited_latency_ = kX86_64SIMDMulFloatingPointLatency;
+  } else {
+    last_visited_latency_ = kX86_64SIMDMulIntegerLatency;
+  }
+}
+
+void SchedulingLatencyVisitorX86_64::VisitVecDiv(HVecDiv* instr) {
+  if (instr->GetPackedType() == Primitive::kPrimFloat) {
+    last_visited_latency_ = kX86_64SIMDDivFloatLatency;
+  } else {
+    DCHECK(instr->GetPackedType() == Primitive::kPrimDouble);
+    last_visited_latency_ = kX86_64SIMDDivDoubleLatency;
+  }
+}
+
+void SchedulingLatencyVisitorX86_64::VisitVecMin(HVecMin* instr) {
+  HandleSimpleArithmeticSIMD(instr);
+}
+
+void SchedulingLatencyVisitorX86_64::VisitVecMax(HVecMax* instr) {
+  HandleSimpleArithmeticSIMD(instr);
+}
+
+void SchedulingLatencyVisitorX86_64::VisitVecAnd(HVecAnd* instr ATTRIBUTE_UNUSED) {
+  last_visited_latency_ = kX86_64SIMDIntegerOpLatency;
+}
+
+void SchedulingLatencyVisitorX86_64::VisitVecAndNot(HVecAndNot* instr ATTRIBUTE_UNUSED) {
+  last_visited_latency_ = kX86_64SIMDIntegerOpLatency;
+}
+
+void SchedulingLatencyVisitorX86_64::VisitVecOr(HVecOr* instr ATTRIBUTE_UNUSED) {
+  last_visited_latency_ = kX86_64SIMDIntegerOpLatency;
+}
+
+void SchedulingLatencyVisitorX86_64::VisitVecXor(HVecXor* instr ATTRIBUTE_UNUSED) {
+  last_visited_latency_ = kX86_64SIMDIntegerOpLatency;
+}
+
+void SchedulingLatencyVisitorX86_64::VisitVecShl(HVecShl* instr) {
+  HandleSimpleArithmeticSIMD(instr);
+}
+
+void SchedulingLatencyVisitorX86_64::VisitVecShr(HVecShr* instr) {
+  HandleSimpleArithmeticSIMD(instr);
+}
+
+void SchedulingLatencyVisitorX86_64::VisitVecUShr(HVecUShr* instr) {
+  HandleSimpleArithmeticSIMD(instr);
+}
+
+void SchedulingLatencyVisitorX86_64::VisitVecLoad(HVecLoad* instr) {
+  if (instr->IsStringCharAt() && mirror::kUseStringCompression) {
+    // Set latencies for the uncompressed case.
+    last_visited_internal_latency_ = kX86_64MemoryLoadLatency + kX86_64BranchLatency;
+  } else {
+    last_visited_internal_latency_ = 0;
+  }
+  last_visited_latency_ = kX86_64SIMDMemoryLoadLatency;
+}
+
+void SchedulingLatencyVisitorX86_64::VisitVecStore(HVecStore* instr ATTRIBUTE_UNUSED) {
+  last_visited_internal_latency_ = 0;
+  last_visited_latency_ = kX86_64SIMDMemoryStoreLatency;
+}
+
+}  // namespace x86_64
+}  // namespace art
@@ -0,0 +1,146 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_COMPILER_OPTIMIZING_SCHEDULER_X86_64_H_
+#define ART_COMPILER_OPTIMIZING_SCHEDULER_X86_64_H_
+
+#include "scheduler.h"
+
+namespace art {
+namespace x86_64 {
+
+static constexpr uint32_t kX86_64MemoryLoadLatency = 4;
+static constexpr uint32_t kX86_64MemoryStoreLatency = 1;
+
+static constexpr uint32_t kX86_64CallInternalLatency = 10;
+static constexpr uint32_t kX86_64CallLatency = 5;
+
+// x86-64 instruction latency.
+// The values are loosely based on recent out-of-order cores; as for arm64 we assume that all
+// x86-64 CPUs share the same latency list.
+static constexpr uint32_t kX86_64IntegerOpLatency = 1;
+static constexpr uint32_t kX86_64FloatingPointOpLatency = 4;
+
+static constexpr uint32_t kX86_64DivDoubleLatency = 14;
+static constexpr uint32_t kX86_64DivFloatLatency = 11;
+static constexpr uint32_t kX86_64DivIntegerLatency = 26;
+static constexpr uint32_t kX86_64DivLongLatency = 42;
+static constexpr uint32_t kX86_64LoadStringInternalLatency = 4;
+static constexpr uint32_t kX86_64MulFloatingPointLatency = 4;
+static constexpr uint32_t kX86_64MulIntegerLatency = 3;
+static constexpr uint32_t kX86_64RemFloatingPointInternalLatency = 30;
+static constexpr uint32_t kX86_64TypeConversionFloatingPointIntegerLatency = 6;
+static constexpr uint32_t kX86_64BranchLatency = kX86_64IntegerOpLatency;
+
+static constexpr uint32_t kX86_64SIMDFloatingPointOpLatency = 4;
+static constexpr uint32_t kX86_64SIMDIntegerOpLatency = 1;
+static constexpr uint32_t kX86_64SIMDMemoryLoadLatency = 6;
+static constexpr uint32_t kX86_64SIMDMemoryStoreLatency = 1;
+static constexpr uint32_t kX86_64SIMDMulFloatingPointLatency = 4;
+static constexpr uint32_t kX86_64SIMDMulIntegerLatency = 10;
+static constexpr uint32_t kX86_64SIMDReplicateOpLatency = 3;
+static constexpr uint32_t kX86_64SIMDDivDoubleLatency = 14;
+static constexpr uint32_t kX86_64SIMDDivFloatLatency = 11;
+static constexpr uint32_t kX86_64SIMDTypeConversionInt2FPLatency = 4;
+
+class SchedulingLatencyVisitorX86_64 : public SchedulingLatencyVisitor {
+ public:
+  // Default visitor for instructions not handled specifically below.
+  void VisitInstruction(HInstruction* ATTRIBUTE_UNUSED) {
+    last_visited_latency_ = kX86_64IntegerOpLatency;
+  }
+
+// We add a second unused parameter to be able to use this macro like the others
+// defined in `nodes.h`.
+#define FOR_EACH_SCHEDULED_X86_64_INSTRUCTION(M)     \
+  M(ArrayGet             , unused)                   \
+  M(ArrayLength          , unused)                   \
+  M(ArraySet             , unused)                   \
+  M(BinaryOperation      , unused)                   \
+  M(BoundsCheck          , unused)                   \
+  M(Div                  , unused)                   \
+  M(InstanceFieldGet     , unused)                   \
+  M(InstanceOf           , unused)                   \
+  M(Invoke               , unused)                   \
+  M(LoadString           , unused)                   \
+  M(Mul                  , unused)                   \
+  M(NewArray             , unused)                   \
+  M(NewInstance          , unused)                   \
+  M(Rem                  , unused)                   \
+  M(StaticFieldGet       , unused)                   \
+  M(SuspendCheck         , unused)                   \
+  M(TypeConversion       , unused)                   \
+  M(VecReplicateScalar   , unused)                   \
+  M(VecCnv               , unused)                   \
+  M(VecNeg               , unused)                   \
+  M(VecAbs               , unused)                   \
+  M(VecNot               , unused)                   \
+  M(VecAdd               , unused)                   \
+  M(VecHalvingAdd        , unused)                   \
+  M(VecSub               , unused)                   \
+  M(VecMul               , unused)                   \
+  M(VecDiv               , unused)                   \
+  M(VecMin               , unused)                   \
+  M(VecMax               , unused)                   \
+  M(VecAnd               , unused)                   \
+  M(VecAndNot            , unused)                   \
+  M(VecOr                , unused)                   \
+  M(VecXor               , unused)                   \
+  M(VecShl               , unused)                   \
+  M(VecShr               , unused)                   \
+  M(VecUShr              , unused)                   \
+  M(VecLoad              , unused)                   \
+  M(VecStore             , unused)
+
+#define DECLARE_VISIT_INSTRUCTION(type, unused)  \
+  void Visit##type(H##type* instruction) OVERRIDE;
+
+  FOR_EACH_SCHEDULED_X86_64_INSTRUCTION(DECLARE_VISIT_INSTRUCTION)
+
+#undef DECLARE_VISIT_INSTRUCTION
+
+ private:
+  void HandleDivRemConstantIntegral(HBinaryOperation* instruction, uint32_t multiply_latency);
+  void HandleSimpleArithmeticSIMD(HVecOperation* instruction);
+};
+
+class HSchedulerX86_64 : public HScheduler {
+ public:
+  HSchedulerX86_64(ArenaAllocator* arena, SchedulingNodeSelector* selector)
+      : HScheduler(arena, &x86_64_latency_visitor_, selector) {}
+  ~HSchedulerX86_64() OVERRIDE {}
+
+  bool IsSchedulable(const HInstruction* instruction) const OVERRIDE {
+#define CASE_INSTRUCTION_KIND(type, unused) case \
+  HInstruction::InstructionKind::k##type:
+    switch (instruction->GetKind()) {
+      FOR_EACH_SCHEDULED_X86_64_INSTRUCTION(CASE_INSTRUCTION_KIND)
+        return true;
+      default:
+        return HScheduler::IsSchedulable(instruction);
+    }
+#undef CASE_INSTRUCTION_KIND
+  }
+
+ private:
+  SchedulingLatencyVisitorX86_64 x86_64_latency_visitor_;
+  DISALLOW_COPY_AND_ASSIGN(HSchedulerX86_64);
+};
+
+}  // namespace x86_64
+}  // namespace art
+
+#endif  // ART_COMPILER_OPTIMIZING_SCHEDULER_X86_64_H_
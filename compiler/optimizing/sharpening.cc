@@ -166,6 +166,21 @@ HLoadClass::LoadKind HSharpening::ComputeLoadClassKind(HLoadClass* load_class,
     // TODO: This may not actually be true for all architectures and
     // locations of target classes. The additional register pressure
     // for using the ArtMethod* should be considered.
+
+    // If the referrer's class is in the boot image, the load needs no read barrier.
+    bool is_in_boot_image = false;
+    if (codegen->GetCompilerOptions().IsBootImage()) {
+      is_in_boot_image = (klass != nullptr) &&
+          compiler_driver->GetSupportBootImageFixup() &&
+          compiler_driver->IsImageClass(
+              load_class->GetDexFile().StringByTypeIdx(load_class->GetTypeIndex()));
+    } else {
+      is_in_boot_image = (klass != nullptr) &&
+          Runtime::Current()->GetHeap()->ObjectIsInBootImageSpace(klass.Get());
+    }
+    if (is_in_boot_image) {
+      load_class->MarkInBootImage();
+    }
   } else {
     const DexFile& dex_file = load_class->GetDexFile();
     dex::TypeIndex type_index = load_class->GetTypeIndex();
@@ -288,6 +303,11 @@ void HSharpening::ProcessLoadString(HLoadString* load_string) {
     }
     if (string != nullptr) {
       load_string->SetString(handles_->NewHandle(string));
+      // Compiling the boot image resolves all the strings it references into the image.
+      if (codegen_->GetCompilerOptions().IsBootImage() ||
+          runtime->GetHeap()->ObjectIsInBootImageSpace(string)) {
+        load_string->MarkInBootImage();
+      }
     }
   }
   DCHECK_NE(desired_load_kind, static_cast<HLoadString::LoadKind>(-1));
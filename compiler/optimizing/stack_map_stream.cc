@@ -38,6 +38,7 @@ void StackMapStream::BeginStackMapEntry(uint32_t dex_pc,
   current_entry_.sp_mask = sp_mask;
   current_entry_.inlining_depth = inlining_depth;
   current_entry_.inline_infos_start_index = inline_infos_.size();
+  current_entry_.inline_info_index = StackMap::kNoInlineInfo;
   current_entry_.stack_mask_index = 0;
   current_entry_.dex_method_index = DexFile::kDexNoIndex;
   current_entry_.dex_register_entry.num_dex_registers = num_dex_registers;
@@ -151,7 +152,7 @@ size_t StackMapStream::PrepareForFillIn() {
   encoding.dex_register_map.num_bytes = ComputeDexRegisterMapsSize();
   encoding.location_catalog.num_entries = location_catalog_entries_.size();
   encoding.location_catalog.num_bytes = ComputeDexRegisterLocationCatalogSize();
-  encoding.inline_info.num_entries = inline_infos_.size();
+  encoding.inline_info.num_entries = PrepareInlineInfos();
   // Must be done before calling ComputeInlineInfoEncoding since ComputeInlineInfoEncoding requires
   // dex_method_index_idx to be filled in.
   PrepareMethodIndices();
@@ -372,11 +373,14 @@ void StackMapStream::FillInCodeInfo(MemoryRegion region) {
 
     // Set the inlining info.
     if (entry.inlining_depth != 0) {
-      InlineInfo inline_info = code_info.GetInlineInfo(next_inline_info_index, encoding);
-
       // Fill in the index.
-      stack_map.SetInlineInfoIndex(encoding.stack_map.encoding, next_inline_info_index);
-      DCHECK_EQ(next_inline_info_index, entry.inline_infos_start_index);
+      stack_map.SetInlineInfoIndex(encoding.stack_map.encoding, entry.inline_info_index);
+      if (entry.inline_info_index != next_inline_info_index) {
+        // Shares the inline info of an earlier stack map, which has already been written.
+        DCHECK_LT(entry.inline_info_index, next_inline_info_index);
+        continue;
+      }
+      InlineInfo inline_info = code_info.GetInlineInfo(next_inline_info_index, encoding);
       next_inline_info_index += entry.inlining_depth;
 
       inline_info.SetDepth(encoding.inline_info.encoding, entry.inlining_depth);
@@ -599,6 +603,63 @@ size_t StackMapStream::PrepareStackMasks(size_t entry_size_in_bits) {
   return dedup.size();
 }
 
+size_t StackMapStream::PrepareInlineInfos() {
+  // Stack maps at the same position of the same inlined method, for example a call and its
+  // slow path, have the same inline infos. Encode these only once.
+  ArenaSafeMap<uint32_t, ArenaVector<size_t>> dedupe(
+      std::less<uint32_t>(), allocator_->Adapter(kArenaAllocStackMapStream));
+  size_t num_entries = 0;
+  for (size_t i = 0, e = stack_maps_.size(); i < e; ++i) {
+    StackMapEntry& entry = stack_maps_[i];
+    if (entry.inlining_depth == 0) {
+      continue;
+    }
+    uint32_t hash = entry.inlining_depth;
+    for (size_t d = 0; d < entry.inlining_depth; ++d) {
+      const InlineInfoEntry& inline_entry = inline_infos_[entry.inline_infos_start_index + d];
+      hash = hash * 31 + inline_entry.dex_pc;
+      hash = hash * 31 + inline_entry.method_index;
+      hash = hash * 31 + static_cast<uint32_t>(inline_entry.dex_register_map_index);
+    }
+    auto it = dedupe.find(hash);
+    if (it == dedupe.end()) {
+      it = dedupe.Put(hash, ArenaVector<size_t>(allocator_->Adapter(kArenaAllocStackMapStream)));
+    }
+    entry.inline_info_index = StackMap::kNoInlineInfo;
+    for (size_t other : it->second) {
+      if (HaveTheSameInlineInfos(stack_maps_[other], entry)) {
+        entry.inline_info_index = stack_maps_[other].inline_info_index;
+        break;
+      }
+    }
+    if (entry.inline_info_index == StackMap::kNoInlineInfo) {
+      entry.inline_info_index = num_entries;
+      num_entries += entry.inlining_depth;
+      it->second.push_back(i);
+    }
+  }
+  return num_entries;
+}
+
+bool StackMapStream::HaveTheSameInlineInfos(const StackMapEntry& a,
+                                            const StackMapEntry& b) const {
+  if (a.inlining_depth != b.inlining_depth) {
+    return false;
+  }
+  for (size_t d = 0; d < a.inlining_depth; ++d) {
+    const InlineInfoEntry& a_entry = inline_infos_[a.inline_infos_start_index + d];
+    const InlineInfoEntry& b_entry = inline_infos_[b.inline_infos_start_index + d];
+    // The dex register maps are already deduplicated, so comparing their indices is enough.
+    if (a_entry.dex_pc != b_entry.dex_pc ||
+        a_entry.method != b_entry.method ||
+        a_entry.method_index != b_entry.method_index ||
+        a_entry.dex_register_map_index != b_entry.dex_register_map_index) {
+      return false;
+    }
+  }
+  return true;
+}
+
 // Check that all StackMapStream inputs are correctly encoded by trying to read them back.
 void StackMapStream::CheckCodeInfo(MemoryRegion region) const {
   CodeInfo code_info(region);
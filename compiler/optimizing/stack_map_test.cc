@@ -580,6 +580,57 @@ TEST(StackMapTest, TestNonLiveDexRegisters) {
   ASSERT_FALSE(stack_map.HasInlineInfo(encoding.stack_map.encoding));
 }
 
+TEST(StackMapTest, TestGetDexRegisterLocations) {
+  ArenaPool pool;
+  ArenaAllocator arena(&pool);
+  StackMapStream stream(&arena, kRuntimeISA);
+
+  ArenaBitVector sp_mask(&arena, 0, false);
+  uint32_t number_of_dex_registers = 6;
+  stream.BeginStackMapEntry(0, 64, 0x3, &sp_mask, number_of_dex_registers, 0);
+  stream.AddDexRegisterEntry(Kind::kInStack, 0);         // Short location.
+  stream.AddDexRegisterEntry(Kind::kNone, 0);            // No location.
+  stream.AddDexRegisterEntry(Kind::kConstant, -2);       // Large location.
+  stream.AddDexRegisterEntry(Kind::kInRegister, 18);     // Short location.
+  stream.AddDexRegisterEntry(Kind::kInStack, 4096);      // Large location.
+  stream.AddDexRegisterEntry(Kind::kInStack, 0);         // Shared with the first one.
+  stream.EndStackMapEntry();
+
+  size_t size = stream.PrepareForFillIn();
+  void* memory = arena.Alloc(size, kArenaAllocMisc);
+  MemoryRegion region(memory, size);
+  stream.FillInCodeInfo(region);
+
+  CodeInfo code_info(region);
+  CodeInfoEncoding encoding = code_info.ExtractEncoding();
+  uint32_t number_of_catalog_entries = code_info.GetNumberOfLocationCatalogEntries(encoding);
+  ASSERT_EQ(4u, number_of_catalog_entries);
+  std::vector<DexRegisterLocation> catalog_locations;
+  code_info.GetDexRegisterLocationCatalog(encoding).GetDexRegisterLocations(
+      number_of_catalog_entries, &catalog_locations);
+  ASSERT_EQ(number_of_catalog_entries, catalog_locations.size());
+
+  StackMap stack_map = code_info.GetStackMapAt(0, encoding);
+  DexRegisterMap dex_register_map =
+      code_info.GetDexRegisterMapOf(stack_map, encoding, number_of_dex_registers);
+  std::vector<DexRegisterLocation> locations;
+  dex_register_map.GetDexRegisterLocations(number_of_dex_registers, catalog_locations, &locations);
+  ASSERT_EQ(number_of_dex_registers, locations.size());
+  for (uint16_t i = 0; i < number_of_dex_registers; ++i) {
+    ASSERT_EQ(dex_register_map.GetDexRegisterLocation(i,
+                                                      number_of_dex_registers,
+                                                      code_info,
+                                                      encoding),
+              locations[i]);
+  }
+  ASSERT_EQ(Kind::kNone, locations[1].GetKind());
+  ASSERT_EQ(Kind::kConstant, locations[2].GetKind());
+  ASSERT_EQ(-2, locations[2].GetValue());
+  ASSERT_EQ(Kind::kInStack, locations[4].GetKind());
+  ASSERT_EQ(4096, locations[4].GetValue());
+  ASSERT_EQ(locations[0], locations[5]);
+}
+
 // Generate a stack map whose dex register offset is
 // StackMap::kNoDexRegisterMapSmallEncoding, and ensure we do
 // not treat it as kNoDexRegisterMap.
@@ -962,6 +1013,60 @@ TEST(StackMapTest, TestDeduplicateStackMask) {
             stack_map2.GetStackMaskIndex(encoding.stack_map.encoding));
 }
 
+TEST(StackMapTest, TestDeduplicateInlineInfo) {
+  ArenaPool pool;
+  ArenaAllocator arena(&pool);
+  StackMapStream stream(&arena, kRuntimeISA);
+  ArtMethod art_method;
+
+  ArenaBitVector sp_mask(&arena, 0, true);
+  // Two stack maps with the same inline info, and one with a different inlined dex pc.
+  for (uint32_t native_pc : { 4u, 8u, 12u }) {
+    stream.BeginStackMapEntry(0, native_pc, 0x3, &sp_mask, 1, 2);
+    stream.AddDexRegisterEntry(Kind::kInStack, 0);
+    stream.BeginInlineInfoEntry(&art_method, 2, 1);
+    stream.AddDexRegisterEntry(Kind::kConstant, 4);
+    stream.EndInlineInfoEntry();
+    stream.BeginInlineInfoEntry(&art_method, native_pc == 12u ? 5 : 3, 1);
+    stream.AddDexRegisterEntry(Kind::kInRegister, 1);
+    stream.EndInlineInfoEntry();
+    stream.EndStackMapEntry();
+  }
+
+  size_t size = stream.PrepareForFillIn();
+  void* memory = arena.Alloc(size, kArenaAllocMisc);
+  MemoryRegion region(memory, size);
+  stream.FillInCodeInfo(region);
+
+  CodeInfo code_info(region);
+  CodeInfoEncoding encoding = code_info.ExtractEncoding();
+  ASSERT_EQ(3u, code_info.GetNumberOfStackMaps(encoding));
+  // Two inline infos of depth 2.
+  ASSERT_EQ(4u, encoding.inline_info.num_entries);
+
+  StackMap stack_map1 = code_info.GetStackMapForNativePcOffset(4, encoding);
+  StackMap stack_map2 = code_info.GetStackMapForNativePcOffset(8, encoding);
+  StackMap stack_map3 = code_info.GetStackMapForNativePcOffset(12, encoding);
+  EXPECT_EQ(stack_map1.GetInlineInfoIndex(encoding.stack_map.encoding),
+            stack_map2.GetInlineInfoIndex(encoding.stack_map.encoding));
+  EXPECT_NE(stack_map1.GetInlineInfoIndex(encoding.stack_map.encoding),
+            stack_map3.GetInlineInfoIndex(encoding.stack_map.encoding));
+
+  InlineInfo inline_info2 = code_info.GetInlineInfoOf(stack_map2, encoding);
+  ASSERT_EQ(2u, inline_info2.GetDepth(encoding.inline_info.encoding));
+  EXPECT_EQ(2u, inline_info2.GetDexPcAtDepth(encoding.inline_info.encoding, 0));
+  EXPECT_EQ(3u, inline_info2.GetDexPcAtDepth(encoding.inline_info.encoding, 1));
+  InlineInfo inline_info3 = code_info.GetInlineInfoOf(stack_map3, encoding);
+  ASSERT_EQ(2u, inline_info3.GetDepth(encoding.inline_info.encoding));
+  EXPECT_EQ(2u, inline_info3.GetDexPcAtDepth(encoding.inline_info.encoding, 0));
+  EXPECT_EQ(5u, inline_info3.GetDexPcAtDepth(encoding.inline_info.encoding, 1));
+
+  DexRegisterMap dex_registers =
+      code_info.GetDexRegisterMapAtDepth(1, inline_info2, encoding, 1);
+  EXPECT_EQ(Kind::kInRegister, dex_registers.GetLocationKind(0, 1, code_info, encoding));
+  EXPECT_EQ(1, dex_registers.GetMachineRegister(0, 1, code_info, encoding));
+}
+
 TEST(StackMapTest, TestInvokeInfo) {
   ArenaPool pool;
   ArenaAllocator arena(&pool);
@@ -25,8 +25,10 @@
 
 #include "android-base/stringprintf.h"
 
+#include "atomic.h"
+#include "base/bit_utils.h"
+#include "base/flat_hash_set.h"
 #include "base/mutex.h"
-#include "base/hash_set.h"
 #include "base/stl_util.h"
 #include "base/time_utils.h"
 
@@ -43,6 +45,7 @@ struct DedupeSet<InKey, StoreKey, Alloc, HashType, HashFunc, kShard>::Stats {
   size_t collision_max = 0u;
   size_t total_probe_distance = 0u;
   size_t total_size = 0u;
+  size_t lock_free_size = 0u;
 };
 
 template <typename InKey,
@@ -57,17 +60,42 @@ class DedupeSet<InKey, StoreKey, Alloc, HashType, HashFunc, kShard>::Shard {
       : alloc_(alloc),
         lock_name_(lock_name),
         lock_(lock_name_.c_str()),
-        keys_() {
+        keys_(),
+        lock_free_capacity_(0u),
+        lock_free_limit_(0u),
+        lock_free_size_(0u) {
   }
 
   ~Shard() {
+    ClearLockFreeTable();
     for (const HashedKey<StoreKey>& key : keys_) {
       DCHECK(key.Key() != nullptr);
       alloc_.Destroy(key.Key());
     }
   }
 
+  void Reserve(size_t expected_keys) {
+    if (lock_free_table_ != nullptr || expected_keys == 0u) {
+      return;
+    }
+    // Keep the load factor at most 3/4 so that the probe sequences stay short.
+    size_t capacity = expected_keys * kLockFreeMaxLoadDenominator / kLockFreeMaxLoadNumerator;
+    if (capacity < kMinLockFreeCapacity) {
+      capacity = kMinLockFreeCapacity;
+    }
+    lock_free_capacity_ = RoundUpToPowerOfTwo(capacity);
+    lock_free_limit_ = lock_free_capacity_ / kLockFreeMaxLoadDenominator *
+        kLockFreeMaxLoadNumerator;
+    lock_free_table_.reset(new Atomic<const LockFreeEntry*>[lock_free_capacity_]);
+  }
+
   const StoreKey* Add(Thread* self, size_t hash, const InKey& in_key) REQUIRES(!lock_) {
+    if (lock_free_table_ != nullptr) {
+      const StoreKey* store_key = LockFreeAdd(hash, in_key);
+      if (store_key != nullptr) {
+        return store_key;
+      }
+    }
     MutexLock lock(self, lock_);
     HashedKey<InKey> hashed_in_key(hash, &in_key);
     auto it = keys_.Find(hashed_in_key);
@@ -80,8 +108,18 @@ class DedupeSet<InKey, StoreKey, Alloc, HashType, HashFunc, kShard>::Shard {
     return store_key;
   }
 
+  void Clear(Thread* self) REQUIRES(!lock_) {
+    ClearLockFreeTable();
+    MutexLock lock(self, lock_);
+    for (const HashedKey<StoreKey>& key : keys_) {
+      DCHECK(key.Key() != nullptr);
+      alloc_.Destroy(key.Key());
+    }
+    keys_.Clear();
+  }
+
   void UpdateStats(Thread* self, Stats* global_stats) REQUIRES(!lock_) {
-    // HashSet<> doesn't keep entries ordered by hash, so we actually allocate memory
+    // FlatHashSet<> doesn't keep entries ordered by hash, so we actually allocate memory
     // for bookkeeping while collecting the stats.
     std::unordered_map<HashType, size_t> stats;
     {
@@ -90,6 +128,7 @@ class DedupeSet<InKey, StoreKey, Alloc, HashType, HashFunc, kShard>::Shard {
       // It may have been higher before a re-hash.
       global_stats->total_probe_distance += keys_.TotalProbeDistance();
       global_stats->total_size += keys_.Size();
+      global_stats->lock_free_size += lock_free_size_.LoadRelaxed();
       for (const HashedKey<StoreKey>& key : keys_) {
         auto it = stats.find(key.Hash());
         if (it == stats.end()) {
@@ -109,6 +148,76 @@ class DedupeSet<InKey, StoreKey, Alloc, HashType, HashFunc, kShard>::Shard {
   }
 
  private:
+  // The lock-free table is filled to at most 3/4 of its capacity.
+  static constexpr size_t kLockFreeMaxLoadNumerator = 3u;
+  static constexpr size_t kLockFreeMaxLoadDenominator = 4u;
+  static constexpr size_t kMinLockFreeCapacity = 16u;
+
+  // The entries of the lock-free table are immutable once published, so that readers can
+  // compare the hash and the key without synchronizing with the writer beyond the acquire
+  // load of the entry pointer.
+  struct LockFreeEntry {
+    size_t hash;
+    const StoreKey* key;
+  };
+
+  static bool KeyEquals(const StoreKey* store_key, const InKey& in_key) {
+    return store_key->size() == in_key.size() &&
+        std::equal(in_key.begin(), in_key.end(), store_key->begin());
+  }
+
+  // Find or insert `in_key` in the lock-free table by linear probing, claiming empty slots
+  // with a CAS. Returns null if the key is not in the table and the table is full, then the
+  // caller falls back to `keys_`. A key racing with the table filling up can end up both in
+  // the table and in `keys_`, which only costs the memory of the duplicate.
+  const StoreKey* LockFreeAdd(size_t hash, const InKey& in_key) {
+    const size_t mask = lock_free_capacity_ - 1u;
+    LockFreeEntry* new_entry = nullptr;
+    const StoreKey* result = nullptr;
+    for (size_t i = 0u, index = hash & mask; i != lock_free_capacity_; ++i) {
+      Atomic<const LockFreeEntry*>& slot = lock_free_table_[index];
+      const LockFreeEntry* entry = slot.LoadAcquire();
+      if (entry == nullptr) {
+        if (lock_free_size_.LoadRelaxed() >= lock_free_limit_) {
+          break;
+        }
+        if (new_entry == nullptr) {
+          new_entry = new LockFreeEntry { hash, alloc_.Copy(in_key) };
+        }
+        if (slot.CompareExchangeStrongSequentiallyConsistent(nullptr, new_entry)) {
+          lock_free_size_.FetchAndAddRelaxed(1u);
+          return new_entry->key;
+        }
+        // Another thread claimed the slot, check its key before probing further.
+        entry = slot.LoadAcquire();
+        DCHECK(entry != nullptr);
+      }
+      if (entry->hash == hash && KeyEquals(entry->key, in_key)) {
+        result = entry->key;
+        break;
+      }
+      index = (index + 1u) & mask;
+    }
+    if (new_entry != nullptr) {
+      alloc_.Destroy(new_entry->key);
+      delete new_entry;
+    }
+    return result;
+  }
+
+  // Not thread-safe, there must be no concurrent Add().
+  void ClearLockFreeTable() {
+    for (size_t i = 0; i != lock_free_capacity_; ++i) {
+      const LockFreeEntry* entry = lock_free_table_[i].LoadRelaxed();
+      if (entry != nullptr) {
+        alloc_.Destroy(entry->key);
+        delete entry;
+        lock_free_table_[i].StoreRelaxed(nullptr);
+      }
+    }
+    lock_free_size_.StoreRelaxed(0u);
+  }
+
   template <typename T>
   class HashedKey {
    public:
@@ -176,7 +285,14 @@ class DedupeSet<InKey, StoreKey, Alloc, HashType, HashFunc, kShard>::Shard {
   Alloc alloc_;
   const std::string lock_name_;
   Mutex lock_;
-  HashSet<HashedKey<StoreKey>, ShardEmptyFn, ShardHashFn, ShardPred> keys_ GUARDED_BY(lock_);
+  FlatHashSet<HashedKey<StoreKey>, ShardEmptyFn, ShardHashFn, ShardPred> keys_ GUARDED_BY(lock_);
+
+  // Open addressing table searched and filled without taking `lock_`, allocated by Reserve().
+  // Keys that do not fit are stored in `keys_`.
+  std::unique_ptr<Atomic<const LockFreeEntry*>[]> lock_free_table_;
+  size_t lock_free_capacity_;
+  size_t lock_free_limit_;
+  Atomic<size_t> lock_free_size_;
 };
 
 template <typename InKey,
@@ -194,7 +310,7 @@ const StoreKey* DedupeSet<InKey, StoreKey, Alloc, HashType, HashFunc, kShard>::A
   HashType raw_hash = HashFunc()(key);
   if (kIsDebugBuild) {
     uint64_t hash_end = NanoTime();
-    hash_time_ += hash_end - hash_start;
+    hash_time_.FetchAndAddRelaxed(hash_end - hash_start);
   }
   HashType shard_hash = raw_hash / kShard;
   HashType shard_bin = raw_hash % kShard;
@@ -209,7 +325,7 @@ template <typename InKey,
           HashType kShard>
 DedupeSet<InKey, StoreKey, Alloc, HashType, HashFunc, kShard>::DedupeSet(const char* set_name,
                                                                          const Alloc& alloc)
-    : hash_time_(0) {
+    : hash_time_(0u) {
   for (HashType i = 0; i < kShard; ++i) {
     std::ostringstream oss;
     oss << set_name << " lock " << i;
@@ -227,6 +343,31 @@ DedupeSet<InKey, StoreKey, Alloc, HashType, HashFunc, kShard>::~DedupeSet() {
   // Everything done by member destructors.
 }
 
+template <typename InKey,
+          typename StoreKey,
+          typename Alloc,
+          typename HashType,
+          typename HashFunc,
+          HashType kShard>
+void DedupeSet<InKey, StoreKey, Alloc, HashType, HashFunc, kShard>::Clear(Thread* self) {
+  for (HashType shard = 0; shard < kShard; ++shard) {
+    shards_[shard]->Clear(self);
+  }
+}
+
+template <typename InKey,
+          typename StoreKey,
+          typename Alloc,
+          typename HashType,
+          typename HashFunc,
+          HashType kShard>
+void DedupeSet<InKey, StoreKey, Alloc, HashType, HashFunc, kShard>::Reserve(
+    size_t expected_keys) {
+  for (HashType shard = 0; shard < kShard; ++shard) {
+    shards_[shard]->Reserve((expected_keys + kShard - 1u) / kShard);
+  }
+}
+
 template <typename InKey,
           typename StoreKey,
           typename Alloc,
@@ -240,12 +381,14 @@ std::string DedupeSet<InKey, StoreKey, Alloc, HashType, HashFunc, kShard>::DumpS
     shards_[shard]->UpdateStats(self, &stats);
   }
   return android::base::StringPrintf("%zu collisions, %zu max hash collisions, "
-                                     "%zu/%zu probe distance, %" PRIu64 " ns hash time",
+                                     "%zu/%zu probe distance, %zu lock-free entries, "
+                                     "%" PRIu64 " ns hash time",
                                      stats.collision_sum,
                                      stats.collision_max,
                                      stats.total_probe_distance,
                                      stats.total_size,
-                                     hash_time_);
+                                     stats.lock_free_size,
+                                     hash_time_.LoadRelaxed());
 }
 
 
@@ -21,6 +21,7 @@
 #include <stdint.h>
 #include <string>
 
+#include "atomic.h"
 #include "base/macros.h"
 
 namespace art {
@@ -29,7 +30,8 @@ class Thread;
 
 // A set of Keys that support a HashFunc returning HashType. Used to find duplicates of Key in the
 // Add method. The data-structure is thread-safe through the use of internal locks, it also
-// supports the lock being sharded.
+// supports the lock being sharded. After Reserve(), the keys are first looked up and inserted
+// in lock-free open addressing tables, the locked sets only take the keys that do not fit.
 template <typename InKey,
           typename StoreKey,
           typename Alloc,
@@ -47,12 +49,19 @@ class DedupeSet {
 
   std::string DumpStats(Thread* self) const;
 
+  // Destroy all stored keys. The keys returned by Add() must no longer be in use.
+  void Clear(Thread* self);
+
+  // Allocate the lock-free tables for about `expected_keys` keys. Must not be called
+  // concurrently with Add(). Does nothing if the tables already exist.
+  void Reserve(size_t expected_keys);
+
  private:
   struct Stats;
   class Shard;
 
   std::unique_ptr<Shard> shards_[kShard];
-  uint64_t hash_time_;
+  Atomic<uint64_t> hash_time_;
 
   DISALLOW_COPY_AND_ASSIGN(DedupeSet);
 };
@@ -16,11 +16,15 @@
 
 #include "dedupe_set.h"
 
+#include <pthread.h>
+
 #include <algorithm>
 #include <cstdio>
 #include <vector>
 
 #include "base/array_ref.h"
+#include "base/logging.h"
+#include "base/time_utils.h"
 #include "dedupe_set-inl.h"
 #include "gtest/gtest.h"
 #include "thread-current-inl.h"
@@ -88,4 +92,115 @@ TEST(DedupeSetTest, Test) {
   }
 }
 
+class DedupeSetTestCountingAlloc {
+ public:
+  explicit DedupeSetTestCountingAlloc(size_t* live_keys) : live_keys_(live_keys) {}
+
+  const std::vector<uint8_t>* Copy(const ArrayRef<const uint8_t>& src) {
+    ++*live_keys_;
+    return new std::vector<uint8_t>(src.begin(), src.end());
+  }
+
+  void Destroy(const std::vector<uint8_t>* key) {
+    --*live_keys_;
+    delete key;
+  }
+
+ private:
+  size_t* const live_keys_;
+};
+
+TEST(DedupeSetTest, Clear) {
+  Thread* self = Thread::Current();
+  size_t live_keys = 0u;
+  DedupeSetTestCountingAlloc alloc(&live_keys);
+  DedupeSet<ArrayRef<const uint8_t>,
+            std::vector<uint8_t>,
+            DedupeSetTestCountingAlloc,
+            size_t,
+            DedupeSetTestHashFunc,
+            4> deduplicator("test", alloc);
+  uint8_t raw_test1[] = { 10u, 20u, 30u, 45u };
+  uint8_t raw_test2[] = { 10u, 22u, 30u, 47u };
+  deduplicator.Add(self, ArrayRef<const uint8_t>(raw_test1));
+  deduplicator.Add(self, ArrayRef<const uint8_t>(raw_test1));
+  deduplicator.Add(self, ArrayRef<const uint8_t>(raw_test2));
+  EXPECT_EQ(live_keys, 2u);
+
+  deduplicator.Clear(self);
+  EXPECT_EQ(live_keys, 0u);
+
+  // The set is usable after being cleared.
+  const std::vector<uint8_t>* array = deduplicator.Add(self, ArrayRef<const uint8_t>(raw_test1));
+  ASSERT_NE(array, nullptr);
+  EXPECT_TRUE(std::equal(array->begin(), array->end(), raw_test1));
+  EXPECT_EQ(live_keys, 1u);
+}
+
+using ConcurrentDedupeSet = DedupeSet<ArrayRef<const uint8_t>,
+                                      std::vector<uint8_t>,
+                                      DedupeSetTestAlloc,
+                                      size_t,
+                                      DedupeSetTestHashFunc,
+                                      4>;
+
+struct ConcurrentAddArgs {
+  ConcurrentDedupeSet* deduplicator;
+  const std::vector<std::vector<uint8_t>>* keys;
+  size_t first_key;
+  std::vector<const std::vector<uint8_t>*> results;
+};
+
+static void* ConcurrentAddKeys(void* arg) {
+  ConcurrentAddArgs* args = reinterpret_cast<ConcurrentAddArgs*>(arg);
+  const std::vector<std::vector<uint8_t>>& keys = *args->keys;
+  args->results.resize(keys.size());
+  // Start at a different key in each thread so that the threads race on different buckets.
+  for (size_t i = 0; i != keys.size(); ++i) {
+    size_t index = (args->first_key + i) % keys.size();
+    args->results[index] = args->deduplicator->Add(nullptr, ArrayRef<const uint8_t>(keys[index]));
+  }
+  return nullptr;
+}
+
+// Checks that concurrent Add()s agree on the stored keys and logs the time taken with and
+// without the lock-free tables.
+TEST(DedupeSetTest, ConcurrentAdd) {
+  static constexpr size_t kNumKeys = 4096u;
+  std::vector<std::vector<uint8_t>> keys;
+  for (size_t i = 0; i != kNumKeys; ++i) {
+    keys.push_back({ static_cast<uint8_t>(i), static_cast<uint8_t>(i >> 8), 1u, 2u, 3u });
+  }
+  for (bool lock_free : { false, true }) {
+    for (size_t num_threads = 1u; num_threads <= 64u; num_threads *= 2u) {
+      DedupeSetTestAlloc alloc;
+      ConcurrentDedupeSet deduplicator("test", alloc);
+      if (lock_free) {
+        deduplicator.Reserve(kNumKeys);
+      }
+      std::vector<ConcurrentAddArgs> args(num_threads);
+      std::vector<pthread_t> threads(num_threads);
+      uint64_t start_ns = NanoTime();
+      for (size_t t = 0; t != num_threads; ++t) {
+        args[t] = ConcurrentAddArgs { &deduplicator, &keys, t * kNumKeys / num_threads, {} };
+        ASSERT_EQ(0, pthread_create(&threads[t], nullptr, ConcurrentAddKeys, &args[t]));
+      }
+      for (size_t t = 0; t != num_threads; ++t) {
+        ASSERT_EQ(0, pthread_join(threads[t], nullptr));
+      }
+      uint64_t time_ns = NanoTime() - start_ns;
+      LOG(INFO) << (lock_free ? "Lock-free" : "Locked") << " DedupeSet, " << num_threads
+                << " threads: " << PrettyDuration(time_ns);
+      for (size_t i = 0; i != kNumKeys; ++i) {
+        const std::vector<uint8_t>* stored = args[0].results[i];
+        ASSERT_NE(stored, nullptr);
+        ASSERT_EQ(*stored, keys[i]);
+        for (size_t t = 1; t != num_threads; ++t) {
+          ASSERT_EQ(args[t].results[i], stored);
+        }
+      }
+    }
+  }
+}
+
 }  // namespace art
@@ -178,6 +178,7 @@ SwapSpace::SpaceChunk SwapSpace::NewFileChunk(size_t min_size) {
   }
   size_ += next_part;
   SpaceChunk new_chunk = {ptr, next_part};
+  maps_.push_back(new_chunk);
   return new_chunk;
 #else
   UNUSED(min_size, kMininumMapSize);
@@ -186,6 +187,22 @@ SwapSpace::SpaceChunk SwapSpace::NewFileChunk(size_t min_size) {
 #endif
 }
 
+void SwapSpace::WriteBack() {
+  MutexLock lock(Thread::Current(), lock_);
+  for (const SpaceChunk& chunk : maps_) {
+    if (msync(chunk.ptr, chunk.size, MS_SYNC) != 0) {
+      PLOG(WARNING) << "Failed to write back swap space chunk at "
+          << static_cast<const void*>(chunk.ptr) << " size=" << chunk.size;
+      continue;
+    }
+    // The mapping is shared, dropping the pages does not lose their contents.
+    if (madvise(chunk.ptr, chunk.size, MADV_DONTNEED) != 0) {
+      PLOG(WARNING) << "Failed to release swap space chunk at "
+          << static_cast<const void*>(chunk.ptr) << " size=" << chunk.size;
+    }
+  }
+}
+
 // TODO: Full coalescing.
 void SwapSpace::Free(void* ptr, size_t size) {
   MutexLock lock(Thread::Current(), lock_);
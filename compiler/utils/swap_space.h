@@ -42,6 +42,10 @@ class SwapSpace {
     return size_;
   }
 
+  // Write the dirty pages back to the file and drop all the pages from the resident set.
+  // The data stays valid, it is read back from the file on the next access.
+  void WriteBack() REQUIRES(!lock_);
+
  private:
   // Chunk of space.
   struct SpaceChunk {
@@ -102,6 +106,8 @@ class SwapSpace {
   FreeByStartSet free_by_start_ GUARDED_BY(lock_);
   // Free chunks ordered by size.
   FreeBySizeSet free_by_size_ GUARDED_BY(lock_);
+  // All the mapped chunks of the file.
+  std::vector<SpaceChunk> maps_ GUARDED_BY(lock_);
 
   mutable Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
   DISALLOW_COPY_AND_ASSIGN(SwapSpace);
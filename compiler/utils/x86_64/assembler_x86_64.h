@@ -555,6 +555,8 @@ class X86_64Assembler FINAL : public Assembler {
   void pcmpgtd(XmmRegister dst, XmmRegister src);
   void pcmpgtq(XmmRegister dst, XmmRegister src);  // SSE4.2
 
+  void pmovmskb(CpuRegister dst, XmmRegister src);
+
   void shufpd(XmmRegister dst, XmmRegister src, const Immediate& imm);
   void shufps(XmmRegister dst, XmmRegister src, const Immediate& imm);
   void pshufd(XmmRegister dst, XmmRegister src, const Immediate& imm);
@@ -607,6 +609,7 @@ class X86_64Assembler FINAL : public Assembler {
   void xchgl(CpuRegister dst, CpuRegister src);
   void xchgq(CpuRegister dst, CpuRegister src);
   void xchgl(CpuRegister reg, const Address& address);
+  void xchgq(CpuRegister reg, const Address& address);
 
   void cmpb(const Address& address, const Immediate& imm);
   void cmpw(const Address& address, const Immediate& imm);
@@ -736,6 +739,8 @@ class X86_64Assembler FINAL : public Assembler {
   X86_64Assembler* lock();
   void cmpxchgl(const Address& address, CpuRegister reg);
   void cmpxchgq(const Address& address, CpuRegister reg);
+  void xaddl(const Address& address, CpuRegister reg);
+  void xaddq(const Address& address, CpuRegister reg);
 
   void mfence();
 
@@ -794,6 +799,14 @@ class X86_64Assembler FINAL : public Assembler {
     lock()->cmpxchgq(address, reg);
   }
 
+  void LockXaddl(const Address& address, CpuRegister reg) {
+    lock()->xaddl(address, reg);
+  }
+
+  void LockXaddq(const Address& address, CpuRegister reg) {
+    lock()->xaddq(address, reg);
+  }
+
   //
   // Misc. functionality
   //
@@ -735,6 +735,40 @@ TEST_F(AssemblerX86_64Test, LockCmpxchgq) {
   DriverStr(expected, "lock_cmpxchg");
 }
 
+TEST_F(AssemblerX86_64Test, LockXaddl) {
+  GetAssembler()->LockXaddl(x86_64::Address(
+      x86_64::CpuRegister(x86_64::RDI), x86_64::CpuRegister(x86_64::RBX), x86_64::TIMES_4, 12),
+      x86_64::CpuRegister(x86_64::RSI));
+  GetAssembler()->LockXaddl(x86_64::Address(
+      x86_64::CpuRegister(x86_64::RDI), x86_64::CpuRegister(x86_64::R9), x86_64::TIMES_4, 12),
+      x86_64::CpuRegister(x86_64::R8));
+  GetAssembler()->LockXaddl(x86_64::Address(
+      x86_64::CpuRegister(x86_64::R13), 0), x86_64::CpuRegister(x86_64::RSI));
+  const char* expected =
+    "lock xaddl %ESI, 0xc(%RDI,%RBX,4)\n"
+    "lock xaddl %R8d, 0xc(%RDI,%R9,4)\n"
+    "lock xaddl %ESI, (%R13)\n";
+
+  DriverStr(expected, "lock_xaddl");
+}
+
+TEST_F(AssemblerX86_64Test, LockXaddq) {
+  GetAssembler()->LockXaddq(x86_64::Address(
+      x86_64::CpuRegister(x86_64::RDI), x86_64::CpuRegister(x86_64::RBX), x86_64::TIMES_4, 12),
+      x86_64::CpuRegister(x86_64::RSI));
+  GetAssembler()->LockXaddq(x86_64::Address(
+      x86_64::CpuRegister(x86_64::RDI), x86_64::CpuRegister(x86_64::R9), x86_64::TIMES_4, 12),
+      x86_64::CpuRegister(x86_64::R8));
+  GetAssembler()->LockXaddq(x86_64::Address(
+      x86_64::CpuRegister(x86_64::R13), 0), x86_64::CpuRegister(x86_64::RSI));
+  const char* expected =
+    "lock xaddq %RSI, 0xc(%RDI,%RBX,4)\n"
+    "lock xaddq %R8, 0xc(%RDI,%R9,4)\n"
+    "lock xaddq %RSI, (%R13)\n";
+
+  DriverStr(expected, "lock_xaddq");
+}
+
 TEST_F(AssemblerX86_64Test, Movl) {
   GetAssembler()->movl(x86_64::CpuRegister(x86_64::RAX), x86_64::Address(
       x86_64::CpuRegister(x86_64::RDI), x86_64::CpuRegister(x86_64::RBX), x86_64::TIMES_4, 12));
@@ -1397,6 +1431,10 @@ TEST_F(AssemblerX86_64Test, PCmpgtq) {
   DriverStr(RepeatFF(&x86_64::X86_64Assembler::pcmpgtq, "pcmpgtq %{reg2}, %{reg1}"), "pcmpgtq");
 }
 
+TEST_F(AssemblerX86_64Test, PMovmskb) {
+  DriverStr(RepeatrF(&x86_64::X86_64Assembler::pmovmskb, "pmovmskb %{reg2}, %{reg1}"), "pmovmskb");
+}
+
 TEST_F(AssemblerX86_64Test, Shufps) {
   DriverStr(RepeatFFI(&x86_64::X86_64Assembler::shufps, 1, "shufps ${imm}, %{reg2}, %{reg1}"), "shufps");
 }
@@ -1432,6 +1432,64 @@ TEST_F(VerifierDepsTest, VerifyDeps) {
   }
 }
 
+TEST_F(VerifierDepsTest, VerifyDepsPerClass) {
+  VerifyDexFile();
+
+  ASSERT_EQ(1u, NumberOfCompiledDexFiles());
+  ASSERT_FALSE(verifier_deps_->GetDexFileDeps(*primary_dex_file_)->class_dependencies_.empty());
+
+  std::vector<uint8_t> buffer;
+  verifier_deps_->Encode(dex_files_, &buffer);
+  ASSERT_FALSE(buffer.empty());
+
+  ScopedObjectAccess soa(Thread::Current());
+  StackHandleScope<1> hs(soa.Self());
+  MutableHandle<mirror::ClassLoader> new_class_loader(hs.NewHandle<mirror::ClassLoader>(nullptr));
+
+  {
+    // Valid dependencies leave no class to verify again.
+    VerifierDeps decoded_deps(dex_files_, ArrayRef<const uint8_t>(buffer));
+    ASSERT_TRUE(verifier_deps_->Equals(decoded_deps));
+    VerifierDeps::ClassesPerDexFile classes_to_reverify;
+    new_class_loader.Assign(soa.Decode<mirror::ClassLoader>(LoadDex("VerifierDeps")));
+    ASSERT_TRUE(decoded_deps.ValidateDependenciesPerClass(
+        new_class_loader, soa.Self(), &classes_to_reverify));
+    ASSERT_TRUE(classes_to_reverify[primary_dex_file_].empty());
+  }
+
+  {
+    // Mess up with classes, only the classes that depend on the entry need verifying again.
+    VerifierDeps decoded_deps(dex_files_, ArrayRef<const uint8_t>(buffer));
+    VerifierDeps::DexFileDeps* deps = decoded_deps.GetDexFileDeps(*primary_dex_file_);
+    bool found = false;
+    for (const auto& entry : deps->classes_) {
+      if (entry.IsResolved()) {
+        deps->classes_.insert(VerifierDeps::ClassResolution(
+            entry.GetDexTypeIndex(), VerifierDeps::kUnresolvedMarker));
+        found = true;
+        break;
+      }
+    }
+    ASSERT_TRUE(found);
+    size_t num_classes = deps->classes_.size();
+    size_t num_recording_classes = deps->class_dependencies_.size();
+    VerifierDeps::ClassesPerDexFile classes_to_reverify;
+    new_class_loader.Assign(soa.Decode<mirror::ClassLoader>(LoadDex("VerifierDeps")));
+    ASSERT_TRUE(decoded_deps.ValidateDependenciesPerClass(
+        new_class_loader, soa.Self(), &classes_to_reverify));
+    const std::set<dex::TypeIndex>& classes = classes_to_reverify[primary_dex_file_];
+    ASSERT_FALSE(classes.empty());
+    ASSERT_EQ(num_classes - 1u, deps->classes_.size());
+    ASSERT_EQ(num_recording_classes - classes.size(), deps->class_dependencies_.size());
+    for (dex::TypeIndex type_idx : classes) {
+      ASSERT_TRUE(deps->class_dependencies_.find(type_idx) == deps->class_dependencies_.end());
+    }
+    // The remaining dependencies hold.
+    new_class_loader.Assign(soa.Decode<mirror::ClassLoader>(LoadDex("VerifierDeps")));
+    ASSERT_TRUE(decoded_deps.ValidateDependencies(new_class_loader, soa.Self()));
+  }
+}
+
 TEST_F(VerifierDepsTest, CompilerDriver) {
   SetupCompilerDriver();
 
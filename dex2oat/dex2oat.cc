@@ -15,9 +15,12 @@
  */
 
 #include <inttypes.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/un.h>
 #include "base/memory_tool.h"
 
 #include <fstream>
@@ -58,6 +61,7 @@
 #include "dex/verification_results.h"
 #include "dex2oat_return_codes.h"
 #include "dex_file-inl.h"
+#include "driver/compiled_method_cache.h"
 #include "driver/compiler_driver.h"
 #include "driver/compiler_options.h"
 #include "elf_file.h"
@@ -106,6 +110,10 @@ static constexpr CompilerFilter::Filter kLargeAppFilter = CompilerFilter::kVerif
 static int original_argc;
 static char** original_argv;
 
+// The runtime options of the daemon, set in the daemon process and in the processes it forks to
+// serve requests. Null for an ordinary dex2oat invocation.
+static std::string* daemon_runtime_key = nullptr;
+
 static std::string CommandLine() {
   std::vector<std::string> command;
   for (int i = 0; i < original_argc; ++i) {
@@ -335,6 +343,10 @@ NO_RETURN static void Usage(const char* fmt, ...) {
   UsageError("");
   UsageError("  --dump-timing: display a breakdown of where time was spent");
   UsageError("");
+  UsageError("  --dump-timing-json=<file.json>: write the timing splits as Chrome trace events,");
+  UsageError("      followed by the cumulative compiler pass timings, to a JSON file.");
+  UsageError("      Example: --dump-timing-json=/data/local/tmp/dex2oat-timings.json");
+  UsageError("");
   UsageError("  -g");
   UsageError("  --generate-debug-info: Generate debug information for native debugging,");
   UsageError("      such as stack unwinding information, ELF symbols and DWARF sections.");
@@ -368,6 +380,22 @@ NO_RETURN static void Usage(const char* fmt, ...) {
   UsageError("  --profile-file-fd=<number>: same as --profile-file but accepts a file descriptor.");
   UsageError("      Cannot be used together with --profile-file.");
   UsageError("");
+  UsageError("  --compiled-method-cache=<file-name>: reuse the code of unchanged methods from");
+  UsageError("      the cache written by a previous compilation of the same inputs, then write");
+  UsageError("      the code of this compilation to the cache. Ignored for images.");
+  UsageError("      Example: --compiled-method-cache=/data/tmp/base.cmc");
+  UsageError("");
+  UsageError("  --release-compiled-code: release the compiled code of the dex files of each oat");
+  UsageError("      file once the oat file has been written, so that writing the remaining oat");
+  UsageError("      files and the image does not keep all the compiled code in memory.");
+  UsageError("");
+  UsageError("  --memory-budget=<megabytes>: keep the resident memory of the compilation under");
+  UsageError("      the given budget. With a swap file, swap is used regardless of the swap");
+  UsageError("      thresholds and swapped data is written back when the budget is getting tight.");
+  UsageError("      Over 75% of the budget, only half of the threads compile; over 90%, a single");
+  UsageError("      thread compiles and only the hot methods of the profile are compiled.");
+  UsageError("      Example: --memory-budget=512");
+  UsageError("");
   UsageError("  --swap-file=<file-name>: specifies a file to use for swap.");
   UsageError("      Example: --swap-file=/data/tmp/swap.001");
   UsageError("");
@@ -388,6 +416,18 @@ NO_RETURN static void Usage(const char* fmt, ...) {
   UsageError("      bytes to consider the input \"very large\" and reduce compilation done.");
   UsageError("      Example: --very-large-app-threshold=100000000");
   UsageError("");
+  UsageError("  --compact-dex-level=none|fast: write the dex files of the vdex in the standard");
+  UsageError("      format, or as compact dex files sharing their data items. Ignored for the");
+  UsageError("      boot image, debuggable code and when there is an input vdex.");
+  UsageError("      Example: --compact-dex-level=fast");
+  UsageError("      Default: none");
+  UsageError("");
+  UsageError("  --[no-]copy-dex-files: whether to copy the dex files of a zip input to the vdex.");
+  UsageError("      With --no-copy-dex-files, dex files stored uncompressed and page aligned in");
+  UsageError("      the zip are not copied, and the runtime maps them from the zip instead.");
+  UsageError("      Other inputs are copied regardless.");
+  UsageError("      Default: --copy-dex-files");
+  UsageError("");
   UsageError("  --app-image-fd=<file-descriptor>: specify output file descriptor for app image.");
   UsageError("      Example: --app-image-fd=10");
   UsageError("");
@@ -399,6 +439,16 @@ NO_RETURN static void Usage(const char* fmt, ...) {
   UsageError("");
   UsageError("  --force-determinism: force the compiler to emit a deterministic output.");
   UsageError("");
+  UsageError("  --pipelined-compilation: verify, initialize and compile each class as soon as");
+  UsageError("      its own earlier steps are done instead of running each step over all the");
+  UsageError("      classes. Improves thread utilization at a small cost in code quality.");
+  UsageError("      Ignored for images and with --force-determinism.");
+  UsageError("");
+  UsageError("  --closed-world-devirtualization: with the speed and everything filters, inline");
+  UsageError("      virtual and interface calls to the few classes of the compiled dex files that");
+  UsageError("      can receive them, behind class checks that fall back to the virtual call.");
+  UsageError("      Ignored for the boot image.");
+  UsageError("");
   UsageError("  --dump-cfg=<cfg-file>: dump control-flow graphs (CFGs) to specified file.");
   UsageError("      Example: --dump-cfg=output.cfg");
   UsageError("");
@@ -407,6 +457,11 @@ NO_RETURN static void Usage(const char* fmt, ...) {
   UsageError("      the default behavior). This option is only meaningful when used with");
   UsageError("      --dump-cfg.");
   UsageError("");
+  UsageError("  --dump-pass-profile=<file>: write the time, arena memory and graph size of each");
+  UsageError("      optimizing compiler pass, aggregated over all compiled methods, to <file>");
+  UsageError("      as JSON.");
+  UsageError("      Example: --dump-pass-profile=passes.json");
+  UsageError("");
   UsageError("  --classpath-dir=<directory-path>: directory used to resolve relative class paths.");
   UsageError("");
   UsageError("  --class-loader-context=<string spec>: a string specifying the intended");
@@ -437,6 +492,15 @@ NO_RETURN static void Usage(const char* fmt, ...) {
   UsageError("  --dirty-image-objects=<directory-path>: list of known dirty objects in the image.");
   UsageError("      The image writer will group them together.");
   UsageError("");
+  UsageError("  --daemon-socket=<socket-path>: instead of compiling, create the runtime once and");
+  UsageError("      serve compile requests on a unix domain socket. Only --boot-image,");
+  UsageError("      --android-root, --instruction-set and --runtime-arg may be combined with it,");
+  UsageError("      and requests must use the same values. A request carries the arguments of");
+  UsageError("      an app compilation and the file descriptors they refer to; an argument ending");
+  UsageError("      in '=@<n>' names the n-th descriptor, e.g. --oat-fd=@0. The reply is the");
+  UsageError("      dex2oat return code.");
+  UsageError("      Example: --daemon-socket=/data/misc/dex2oat/socket");
+  UsageError("");
   std::cerr << "See log for usage error information\n";
   exit(EXIT_FAILURE);
 }
@@ -570,6 +634,117 @@ class WatchDog {
   bool shutting_down_;
 };
 
+// Polls the resident set size during compilation and throttles the compiler driver when it
+// gets close to a memory budget.
+class MemoryBudgetWatcher {
+ public:
+  MemoryBudgetWatcher(CompilerDriver* driver, size_t budget_bytes, size_t thread_count)
+      : driver_(driver),
+        budget_bytes_(budget_bytes),
+        thread_count_(thread_count),
+        lock_("dex2oat memory budget lock"),
+        cond_("dex2oat memory budget condition", lock_),
+        shutting_down_(false),
+        level_(kLevelNormal) {
+    int rc = pthread_create(&pthread_, nullptr, &CallBack, this);
+    if (rc != 0) {
+      errno = rc;
+      PLOG(FATAL) << "pthread_create failed for dex2oat memory budget thread";
+    }
+  }
+
+  ~MemoryBudgetWatcher() {
+    {
+      MutexLock mu(Thread::Current(), lock_);
+      shutting_down_ = true;
+      cond_.Signal(Thread::Current());
+    }
+    int rc = pthread_join(pthread_, nullptr);
+    if (rc != 0) {
+      errno = rc;
+      PLOG(FATAL) << "pthread_join failed for dex2oat memory budget thread";
+    }
+    // Let the driver run at full speed for whatever comes after the compilation.
+    driver_->ThrottleCompilation(thread_count_, /* only_hot_methods */ false);
+  }
+
+ private:
+  enum Level {
+    kLevelNormal,  // Under 75% of the budget.
+    kLevelHigh,    // Under 90% of the budget.
+    kLevelCritical,
+  };
+
+  static constexpr int64_t kPollIntervalMs = 100;
+
+  static void* CallBack(void* arg) {
+    MemoryBudgetWatcher* self = reinterpret_cast<MemoryBudgetWatcher*>(arg);
+    ::art::SetThreadName("dex2oat memory budget");
+    self->Run();
+    return nullptr;
+  }
+
+  static size_t GetResidentSetSize() {
+    // The second field of statm is the number of resident pages.
+    std::string statm;
+    if (!ReadFileToString("/proc/self/statm", &statm)) {
+      return 0u;
+    }
+    std::vector<std::string> fields;
+    Split(statm, ' ', &fields);
+    if (fields.size() < 2u) {
+      return 0u;
+    }
+    return strtoull(fields[1].c_str(), nullptr, 10) * kPageSize;
+  }
+
+  Level GetLevel(size_t rss) const {
+    if (rss >= budget_bytes_ / 10u * 9u) {
+      return kLevelCritical;
+    } else if (rss >= budget_bytes_ / 4u * 3u) {
+      return kLevelHigh;
+    }
+    return kLevelNormal;
+  }
+
+  void Run() {
+    // This thread is not attached, the locks are taken with a null Thread.
+    MutexLock mu(nullptr, lock_);
+    while (!shutting_down_) {
+      Level level = GetLevel(GetResidentSetSize());
+      if (level != kLevelNormal) {
+        // Swap-allocated compiled code is not needed until the oat file is written.
+        driver_->GetCompiledMethodStorage()->WriteBackSwapSpace();
+        level = GetLevel(GetResidentSetSize());
+      }
+      if (level != level_) {
+        size_t max_threads = thread_count_;
+        if (level == kLevelCritical) {
+          max_threads = 1u;
+        } else if (level == kLevelHigh && thread_count_ > 1u) {
+          max_threads = thread_count_ / 2u;
+        }
+        LOG(INFO) << "Memory budget of " << PrettySize(budget_bytes_) << " at level " << level
+                  << ", compiling with " << max_threads << " threads"
+                  << (level == kLevelCritical ? ", hot methods only" : "");
+        driver_->ThrottleCompilation(max_threads, level == kLevelCritical);
+        level_ = level;
+      }
+      cond_.TimedWait(nullptr, kPollIntervalMs, 0);
+    }
+  }
+
+  CompilerDriver* const driver_;
+  const size_t budget_bytes_;
+  const size_t thread_count_;
+
+  pthread_t pthread_;
+  Mutex lock_;
+  ConditionVariable cond_ GUARDED_BY(lock_);
+  bool shutting_down_ GUARDED_BY(lock_);
+  Level level_;
+};
+
 class Dex2Oat FINAL {
  public:
   explicit Dex2Oat(TimingLogger* timings) :
@@ -615,6 +790,7 @@ class Dex2Oat FINAL {
       dump_timing_(false),
       dump_slow_timing_(kIsDebugBuild),
       avoid_storing_invocation_(false),
+      release_compiled_code_(false),
       swap_fd_(kInvalidFd),
       app_image_fd_(kInvalidFd),
       profile_file_fd_(kInvalidFd),
@@ -1162,6 +1338,17 @@ class Dex2Oat FINAL {
         CompilerFilter::NameOfFilter(compiler_options_->GetCompilerFilter()));
     key_value_store_->Put(OatHeader::kConcurrentCopying,
                           kUseReadBarrier ? OatHeader::kTrueValue : OatHeader::kFalseValue);
+    // Let OatFileAssistant recognize the input of an app compilation without reading its dex
+    // checksums.
+    std::string fingerprint;
+    if (zip_fd_ != -1) {
+      fingerprint = OatFileAssistant::GetFileFingerprint(zip_fd_);
+    } else if (dex_filenames_.size() == 1u && dex_locations_[0] == dex_filenames_[0]) {
+      fingerprint = OatFileAssistant::GetFileFingerprint(dex_locations_[0]);
+    }
+    if (!fingerprint.empty()) {
+      key_value_store_->Put(OatHeader::kDexLocationFingerprintKey, fingerprint);
+    }
   }
 
   // Parse the arguments from the command line. In case of an unrecognized option or impossible
@@ -1273,12 +1460,21 @@ class Dex2Oat FINAL {
         runtime_args_.push_back(argv[i]);
       } else if (option == "--dump-timing") {
         dump_timing_ = true;
+      } else if (option.starts_with("--dump-timing-json=")) {
+        dump_timing_json_ = option.substr(strlen("--dump-timing-json=")).ToString();
       } else if (option == "--dump-passes") {
         dump_passes_ = true;
       } else if (option == "--dump-stats") {
         dump_stats_ = true;
       } else if (option == "--avoid-storing-invocation") {
         avoid_storing_invocation_ = true;
+      } else if (option == "--release-compiled-code") {
+        release_compiled_code_ = true;
+      } else if (option.starts_with("--compiled-method-cache=")) {
+        compiled_method_cache_file_name_ =
+            option.substr(strlen("--compiled-method-cache=")).ToString();
+      } else if (option.starts_with("--memory-budget=")) {
+        ParseUintOption(option, "--memory-budget", &memory_budget_mb_, Usage);
       } else if (option.starts_with("--swap-file=")) {
         swap_file_name_ = option.substr(strlen("--swap-file=")).data();
       } else if (option.starts_with("--swap-fd=")) {
@@ -1298,6 +1494,19 @@ class Dex2Oat FINAL {
                         "--very-large-app-threshold",
                         &very_large_threshold_,
                         Usage);
+      } else if (option.starts_with("--compact-dex-level=")) {
+        StringPiece level = option.substr(strlen("--compact-dex-level="));
+        if (level == "none") {
+          compact_dex_level_ = CompactDexLevel::kCompactDexLevelNone;
+        } else if (level == "fast") {
+          compact_dex_level_ = CompactDexLevel::kCompactDexLevelFast;
+        } else {
+          Usage("Unknown --compact-dex-level option %s", level.data());
+        }
+      } else if (option == "--copy-dex-files") {
+        copy_dex_files_ = true;
+      } else if (option == "--no-copy-dex-files") {
+        copy_dex_files_ = false;
       } else if (option.starts_with("--app-image-file=")) {
         app_image_file_name_ = option.substr(strlen("--app-image-file=")).data();
       } else if (option.starts_with("--app-image-fd=")) {
@@ -1634,8 +1843,8 @@ class Dex2Oat FINAL {
         // No need to verify the dex file for:
         // 1) Dexlayout since it does the verification. It also may not pass the verification since
         // we don't update the dex checksum.
-        // 2) when we have a vdex file, which means it was already verified.
-        const bool verify = !DoDexLayoutOptimizations() && (input_vdex_file_ == nullptr);
+        // 2) when we have a vdex file with the dex files, which means it was already verified.
+        const bool verify = !DoDexLayoutOptimizations() && !HasInputVdexDexFiles();
         if (!oat_writers_[i]->WriteAndOpenDexFiles(
             kIsVdexEnabled ? vdex_files_[i].get() : oat_files_[i].get(),
             rodata_.back(),
@@ -1644,19 +1853,19 @@ class Dex2Oat FINAL {
             key_value_store_.get(),
             verify,
             update_input_vdex_,
+            copy_dex_files_,
             &opened_dex_files_map,
             &opened_dex_files)) {
           return dex2oat::ReturnCode::kOther;
         }
         dex_files_per_oat_file_.push_back(MakeNonOwningPointerVector(opened_dex_files));
+        // Dex files mapped from their zip rather than from the vdex own their memory.
         if (opened_dex_files_map != nullptr) {
           opened_dex_files_maps_.push_back(std::move(opened_dex_files_map));
-          for (std::unique_ptr<const DexFile>& dex_file : opened_dex_files) {
-            dex_file_oat_index_map_.emplace(dex_file.get(), i);
-            opened_dex_files_.push_back(std::move(dex_file));
-          }
-        } else {
-          DCHECK(opened_dex_files.empty());
+        }
+        for (std::unique_ptr<const DexFile>& dex_file : opened_dex_files) {
+          dex_file_oat_index_map_.emplace(dex_file.get(), i);
+          opened_dex_files_.push_back(std::move(dex_file));
         }
       }
     }
@@ -1867,6 +2076,12 @@ class Dex2Oat FINAL {
     driver_->SetDexFilesForOatFile(dex_files_);
 
     const bool compile_individually = ShouldCompileDexFilesIndividually();
+    if (!compiled_method_cache_file_name_.empty() &&
+        !IsImage() &&
+        !compile_individually &&
+        compiler_options_->IsAotCompilationEnabled()) {
+      SetUpCompiledMethodCache();
+    }
     if (compile_individually) {
       // Set the compiler driver in the callbacks so that we can avoid re-verification. This not
       // only helps performance but also prevents reverifying quickened bytecodes. Attempting
@@ -1924,10 +2139,71 @@ class Dex2Oat FINAL {
                    << soa.Self()->GetException()->Dump();
       }
     }
-    driver_->CompileAll(class_loader, dex_files, timings_);
+    {
+      std::unique_ptr<MemoryBudgetWatcher> memory_budget_watcher;
+      if (memory_budget_mb_ != 0u) {
+        memory_budget_watcher.reset(
+            new MemoryBudgetWatcher(driver_.get(), memory_budget_mb_ * MB, thread_count_));
+      }
+      driver_->CompileAll(class_loader, dex_files, timings_);
+    }
+    if (compiled_method_cache_ != nullptr) {
+      TimingLogger::ScopedTiming t("Write compiled method cache", timings_);
+      LOG(INFO) << "Reused " << compiled_method_cache_->GetNumberOfHits()
+                << " methods from " << compiled_method_cache_file_name_;
+      std::string error_msg;
+      if (!compiled_method_cache_->Write(compiled_method_cache_file_name_,
+                                         driver_.get(),
+                                         &error_msg)) {
+        LOG(WARNING) << error_msg;
+      }
+    }
     return class_loader;
   }
 
+  // Describes everything besides the dex files that the compiled code depends on, so that
+  // code is only reused by a compilation with the same configuration.
+  std::string GetCompiledMethodCacheConfig() {
+    std::ostringstream oss;
+    oss << instruction_set_ << ' ' << instruction_set_features_->GetFeatureString()
+        << " filter=" << CompilerFilter::NameOfFilter(compiler_options_->GetCompilerFilter())
+        << " debuggable=" << compiler_options_->GetDebuggable()
+        << " native-debuggable=" << compiler_options_->GetNativeDebuggable()
+        << " debug-info=" << compiler_options_->GetGenerateDebugInfo()
+        << " mini-debug-info=" << compiler_options_->GetGenerateMiniDebugInfo()
+        << " pic=" << compiler_options_->GetCompilePic()
+        << " implicit-null-checks=" << compiler_options_->GetImplicitNullChecks()
+        << " implicit-so-checks=" << compiler_options_->GetImplicitStackOverflowChecks()
+        << " implicit-suspend-checks=" << compiler_options_->GetImplicitSuspendChecks()
+        << " inline-max-code-units=" << compiler_options_->GetInlineMaxCodeUnits()
+        << " no-inline-from=" << no_inline_from_string_
+        << " read-barrier=" << kUseReadBarrier
+        << " image-checksum=" << image_file_location_oat_checksum_
+        << " image-begin=" << image_file_location_oat_data_begin_;
+    auto class_path = key_value_store_->find(OatHeader::kClassPathKey);
+    if (class_path != key_value_store_->end()) {
+      oss << " class-path=" << class_path->second;
+    }
+    if (profile_compilation_info_ != nullptr) {
+      oss << " profile=" << profile_compilation_info_->DumpInfo(&dex_files_);
+    }
+    return oss.str();
+  }
+
+  void SetUpCompiledMethodCache() {
+    TimingLogger::ScopedTiming t("Load compiled method cache", timings_);
+    compiled_method_cache_.reset(
+        new CompiledMethodCache(dex_files_, GetCompiledMethodCacheConfig()));
+    if (OS::FileExists(compiled_method_cache_file_name_.c_str())) {
+      std::string error_msg;
+      if (!compiled_method_cache_->Load(compiled_method_cache_file_name_, &error_msg)) {
+        // Not fatal, everything is compiled and the cache is rewritten.
+        LOG(WARNING) << error_msg;
+      }
+    }
+    driver_->SetCompiledMethodCache(compiled_method_cache_.get());
+  }
+
   // Notes on the interleaving of creating the images and oat files to
   // ensure the references between the two are correct.
   //
@@ -2169,6 +2445,14 @@ class Dex2Oat FINAL {
 
         oat_writer.reset();
         elf_writer.reset();
+
+        if (release_compiled_code_) {
+          // The code, maps and debug info have been written, nothing else reads the compiled
+          // methods of these dex files. Patches from the other oat files only need the code
+          // offsets kept by the relative patcher.
+          TimingLogger::ScopedTiming t3("dex2oat Release compiled code", timings_);
+          driver_->ReleaseCompiledMethods(dex_files_per_oat_file_[i]);
+        }
       }
     }
 
@@ -2272,6 +2556,33 @@ class Dex2Oat FINAL {
     if (dump_passes_) {
       LOG(INFO) << Dumpable<CumulativeLogger>(*driver_->GetTimingsLogger());
     }
+    if (!dump_timing_json_.empty()) {
+      DumpTimingJson();
+    }
+  }
+
+  void DumpTimingJson() {
+    TimingJsonWriter writer;
+    writer.AddTimingLogger(*timings_);
+    if (compiler_phases_timings_ != nullptr) {
+      writer.AddCumulativeLogger(*compiler_phases_timings_);
+    }
+    std::ostringstream oss;
+    writer.Write(oss);
+    std::unique_ptr<File> out(OS::CreateEmptyFileWriteOnly(dump_timing_json_.c_str()));
+    if (out == nullptr) {
+      PLOG(ERROR) << "Failed to create timing file: " << dump_timing_json_;
+      return;
+    }
+    std::string json = oss.str();
+    if (!out->WriteFully(json.data(), json.size())) {
+      PLOG(ERROR) << "Failed to write timing file: " << dump_timing_json_;
+      out->Erase();
+      return;
+    }
+    if (out->FlushCloseOrErase() != 0) {
+      PLOG(ERROR) << "Failed to flush and close timing file: " << dump_timing_json_;
+    }
   }
 
   bool IsImage() const {
@@ -2298,8 +2609,22 @@ class Dex2Oat FINAL {
     return UseProfile();
   }
 
+  // Compact dex files are only written for apps, and the dex files of an input vdex keep
+  // their format. Debuggers and JVMTI agents expect standard dex files.
+  CompactDexLevel GetCompactDexLevel() const {
+    if (IsBootImage() ||
+        compiler_options_->GetDebuggable() ||
+        input_vdex_fd_ != -1 ||
+        !input_vdex_.empty()) {
+      return CompactDexLevel::kCompactDexLevelNone;
+    }
+    return compact_dex_level_;
+  }
+
   bool DoDexLayoutOptimizations() const {
-    return DoProfileGuidedOptimizations();
+    // Compact dex files are written by dexlayout.
+    return DoProfileGuidedOptimizations() ||
+        GetCompactDexLevel() != CompactDexLevel::kCompactDexLevelNone;
   }
 
   bool DoEagerUnquickeningOfVdex() const {
@@ -2338,12 +2663,66 @@ class Dex2Oat FINAL {
     return true;
   }
 
+  // Parses the arguments of a daemon and creates the runtime shared by the requests it serves.
+  bool SetupDaemon(int argc, char** argv, std::string* socket_path) {
+    original_argc = argc;
+    original_argv = argv;
+    InitLogging(argv, Runtime::Abort);
+    compiler_options_.reset(new CompilerOptions());
+    for (int i = 1; i < argc; ++i) {
+      const StringPiece option(argv[i]);
+      if (option.starts_with("--daemon-socket=")) {
+        *socket_path = option.substr(strlen("--daemon-socket=")).ToString();
+      } else if (option.starts_with("--boot-image=")) {
+        boot_image_filename_ = option.substr(strlen("--boot-image=")).ToString();
+      } else if (option.starts_with("--android-root=")) {
+        android_root_ = option.substr(strlen("--android-root=")).ToString();
+      } else if (option.starts_with("--instruction-set=")) {
+        ParseInstructionSet(option);
+      } else if (option == "--runtime-arg") {
+        if (++i >= argc) {
+          Usage("Missing required argument for --runtime-arg");
+        }
+        runtime_args_.push_back(argv[i]);
+      } else {
+        Usage("Argument %s is not supported with --daemon-socket", option.data());
+      }
+    }
+    if (socket_path->empty()) {
+      Usage("--daemon-socket requires a socket path");
+    }
+    if (boot_image_filename_.empty()) {
+      // Same default as an app compilation, see ProcessOptions().
+      if (android_root_.empty()) {
+        const char* android_root_env_var = getenv("ANDROID_ROOT");
+        if (android_root_env_var == nullptr) {
+          Usage("--android-root unspecified and ANDROID_ROOT not set");
+        }
+        android_root_ += android_root_env_var;
+      }
+      boot_image_filename_ = android_root_ + "/framework/boot.art";
+    }
+
+    art::MemMap::Init();
+    callbacks_.reset(new QuickCompilerCallbacks(CompilerCallbacks::CallbackMode::kCompileApp));
+    RuntimeArgumentMap runtime_options;
+    if (!PrepareRuntimeOptions(&runtime_options) || !CreateRuntime(std::move(runtime_options))) {
+      return false;
+    }
+    daemon_runtime_key = new std::string(GetDaemonRuntimeKey());
+    return true;
+  }
+
  private:
   bool UseSwap(bool is_image, const std::vector<const DexFile*>& dex_files) {
     if (is_image) {
       // Don't use swap, we know generation should succeed, and we don't want to slow it down.
       return false;
     }
+    if (memory_budget_mb_ != 0u) {
+      // The swapped data can be written back when the budget gets tight.
+      return true;
+    }
     if (dex_files.size() < min_dex_files_for_swap_) {
       // If there are less dex files than the threshold, assume it's gonna be fine.
       return false;
@@ -2490,7 +2869,7 @@ class Dex2Oat FINAL {
 
   bool AddDexFileSources() {
     TimingLogger::ScopedTiming t2("AddDexFileSources", timings_);
-    if (input_vdex_file_ != nullptr) {
+    if (HasInputVdexDexFiles()) {
       DCHECK_EQ(oat_writers_.size(), 1u);
       const std::string& name = zip_location_.empty() ? dex_locations_[0] : zip_location_;
       DCHECK(!name.empty());
@@ -2525,6 +2904,12 @@ class Dex2Oat FINAL {
     return true;
   }
 
+  // Whether the dex files come from the input vdex. A vdex written with --no-copy-dex-files
+  // does not have them, they come from the zip as for compiling without an input vdex.
+  bool HasInputVdexDexFiles() const {
+    return input_vdex_file_ != nullptr && input_vdex_file_->HasDexSection();
+  }
+
   void CreateOatWriters() {
     TimingLogger::ScopedTiming t2("CreateOatWriters", timings_);
     elf_writers_.reserve(oat_files_.size());
@@ -2533,11 +2918,15 @@ class Dex2Oat FINAL {
       elf_writers_.emplace_back(CreateElfWriterQuick(instruction_set_,
                                                      instruction_set_features_.get(),
                                                      compiler_options_.get(),
-                                                     oat_file.get()));
+                                                     oat_file.get(),
+                                                     thread_count_));
       elf_writers_.back()->Start();
       const bool do_dexlayout = DoDexLayoutOptimizations();
       oat_writers_.emplace_back(new OatWriter(
-          IsBootImage(), timings_, do_dexlayout ? profile_compilation_info_.get() : nullptr));
+          IsBootImage(),
+          timings_,
+          do_dexlayout ? profile_compilation_info_.get() : nullptr,
+          GetCompactDexLevel()));
     }
   }
 
@@ -2633,6 +3022,9 @@ class Dex2Oat FINAL {
   // Create a runtime necessary for compilation.
   bool CreateRuntime(RuntimeArgumentMap&& runtime_options) {
     TimingLogger::ScopedTiming t_runtime("Create runtime", timings_);
+    if (daemon_runtime_key != nullptr) {
+      return AdoptDaemonRuntime();
+    }
     if (!Runtime::Create(std::move(runtime_options))) {
       LOG(ERROR) << "Failed to create runtime";
       return false;
@@ -2665,6 +3057,32 @@ class Dex2Oat FINAL {
     return true;
   }
 
+  // The options the runtime is created with. A daemon only serves requests that match its own.
+  std::string GetDaemonRuntimeKey() const {
+    std::ostringstream oss;
+    oss << boot_image_filename_ << '\n'
+        << instruction_set_ << '\n'
+        << compiler_options_->IsForceDeterminism() << '\n'
+        << android::base::Join(runtime_args_, '\n');
+    return oss.str();
+  }
+
+  // Use the runtime created by the daemon before it forked this process.
+  bool AdoptDaemonRuntime() {
+    if (IsBootImage()) {
+      LOG(ERROR) << "The dex2oat daemon does not compile boot images";
+      return false;
+    }
+    if (GetDaemonRuntimeKey() != *daemon_runtime_key) {
+      LOG(ERROR) << "The boot image, instruction set and runtime arguments of the request do not "
+                 << "match those of the dex2oat daemon";
+      return false;
+    }
+    runtime_.reset(Runtime::Current());
+    runtime_->SetCompilerCallbacks(callbacks_.get());
+    return true;
+  }
+
   // Let the ImageWriter write the image files. If we do not compile PIC, also fix up the oat files.
   bool CreateImageFile()
       REQUIRES(!Locks::mutator_lock_) {
@@ -2907,6 +3325,8 @@ class Dex2Oat FINAL {
   std::vector<std::unique_ptr<OutputStream>> vdex_out_;
   std::unique_ptr<ImageWriter> image_writer_;
   std::unique_ptr<CompilerDriver> driver_;
+  std::string compiled_method_cache_file_name_;
+  std::unique_ptr<CompiledMethodCache> compiled_method_cache_;
 
   std::vector<std::unique_ptr<MemMap>> opened_dex_files_maps_;
   std::vector<std::unique_ptr<const DexFile>> opened_dex_files_;
@@ -2917,13 +3337,16 @@ class Dex2Oat FINAL {
   bool dump_stats_;
   bool dump_passes_;
   bool dump_timing_;
+  std::string dump_timing_json_;
   bool dump_slow_timing_;
   bool avoid_storing_invocation_;
+  bool release_compiled_code_;
   std::string swap_file_name_;
   int swap_fd_;
   size_t min_dex_files_for_swap_ = kDefaultMinDexFilesForSwap;
   size_t min_dex_file_cumulative_size_for_swap_ = kDefaultMinDexFileCumulativeSizeForSwap;
   size_t very_large_threshold_ = std::numeric_limits<size_t>::max();
+  size_t memory_budget_mb_ = 0u;
   std::string app_image_file_name_;
   int app_image_fd_;
   std::string profile_file_;
@@ -2946,6 +3369,13 @@ class Dex2Oat FINAL {
   // Whether the given input vdex is also the output.
   bool update_input_vdex_ = false;
 
+  // Whether to write compact dex files, see GetCompactDexLevel().
+  CompactDexLevel compact_dex_level_ = CompactDexLevel::kCompactDexLevelNone;
+
+  // Whether to copy the dex files of the zip input to the vdex even if they can be mapped from
+  // the zip.
+  bool copy_dex_files_ = true;
+
   DISALLOW_IMPLICIT_CONSTRUCTORS(Dex2Oat);
 };
 
@@ -3133,10 +3563,166 @@ static dex2oat::ReturnCode Dex2oat(int argc, char** argv) {
 
   return result;
 }
+
+// Daemon requests. A client sends, in one message, the number of arguments and the number of
+// file descriptors as two uint32_t values, with the descriptors attached as SCM_RIGHTS. Each
+// argument follows as a uint32_t length and its characters. The daemon forks for each request,
+// and the child replies with the dex2oat::ReturnCode as a uint32_t once the compilation is done.
+static constexpr size_t kMaxDaemonRequestFds = 16u;
+static constexpr uint32_t kMaxDaemonRequestArgs = 4096u;
+static constexpr uint32_t kMaxDaemonRequestArgLength = 64 * KB;
+
+static bool ReadDaemonRequest(int connection_fd,
+                              std::vector<std::string>* args,
+                              std::vector<int>* fds) {
+  uint32_t header[2];
+  struct iovec iov = { header, sizeof(header) };
+  alignas(struct cmsghdr) char control[CMSG_SPACE(kMaxDaemonRequestFds * sizeof(int))];
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1u;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  ssize_t received = TEMP_FAILURE_RETRY(recvmsg(connection_fd, &msg, MSG_WAITALL));
+  if (received != static_cast<ssize_t>(sizeof(header)) || (msg.msg_flags & MSG_CTRUNC) != 0) {
+    LOG(ERROR) << "Failed to read dex2oat daemon request header";
+    return false;
+  }
+  for (struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+       cmsg != nullptr;
+       cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+      const int* cmsg_fds = reinterpret_cast<const int*>(CMSG_DATA(cmsg));
+      size_t num_cmsg_fds = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+      fds->insert(fds->end(), cmsg_fds, cmsg_fds + num_cmsg_fds);
+    }
+  }
+  uint32_t num_args = header[0];
+  uint32_t num_fds = header[1];
+  if (num_fds != fds->size() || num_args > kMaxDaemonRequestArgs) {
+    LOG(ERROR) << "Malformed dex2oat daemon request";
+    return false;
+  }
+  File connection(connection_fd, /* check_usage */ false);
+  connection.DisableAutoClose();
+  for (uint32_t i = 0; i != num_args; ++i) {
+    uint32_t length;
+    if (!connection.ReadFully(&length, sizeof(length)) || length > kMaxDaemonRequestArgLength) {
+      LOG(ERROR) << "Malformed dex2oat daemon request argument " << i;
+      return false;
+    }
+    std::string arg(length, '\0');
+    if (!connection.ReadFully(&arg[0], length)) {
+      LOG(ERROR) << "Truncated dex2oat daemon request argument " << i;
+      return false;
+    }
+    // Refer to the received descriptors by the numbers they have in this process.
+    size_t equals = arg.rfind('=');
+    if (equals != std::string::npos && arg.compare(equals + 1u, 1u, "@") == 0) {
+      const char* index_string = arg.c_str() + equals + 2u;
+      char* end;
+      unsigned long index = strtoul(index_string, &end, 10);  // NOLINT(runtime/int)
+      if (end == index_string || *end != '\0' || index >= fds->size()) {
+        LOG(ERROR) << "Invalid file descriptor reference in " << arg;
+        return false;
+      }
+      arg = arg.substr(0u, equals + 1u) + std::to_string((*fds)[index]);
+    }
+    args->push_back(arg);
+  }
+  return true;
+}
+
+// Runs in the child forked for a request, with the daemon's runtime already set up.
+NO_RETURN static void HandleDaemonRequest(int connection_fd) {
+  Thread::Current()->InitAfterFork();
+  dex2oat::ReturnCode result = dex2oat::ReturnCode::kOther;
+  std::vector<std::string> args;
+  std::vector<int> fds;
+  if (ReadDaemonRequest(connection_fd, &args, &fds)) {
+    std::vector<char*> argv;
+    argv.push_back(original_argv[0]);
+    for (std::string& arg : args) {
+      argv.push_back(&arg[0]);
+    }
+    argv.push_back(nullptr);
+    result = Dex2oat(static_cast<int>(args.size() + 1u), argv.data());
+  }
+  uint32_t reply = static_cast<uint32_t>(result);
+  if (TEMP_FAILURE_RETRY(write(connection_fd, &reply, sizeof(reply))) !=
+      static_cast<ssize_t>(sizeof(reply))) {
+    PLOG(WARNING) << "Failed to reply to dex2oat daemon request";
+  }
+  _exit(static_cast<int>(result));
+}
+
+// Keeps a runtime with the boot image loaded and serves compile requests in forked copies of
+// it, so that requests skip runtime creation and cannot affect each other. Only returns on error.
+static dex2oat::ReturnCode RunDaemon(int argc, char** argv) {
+  TimingLogger timings("dex2oat daemon", false, false);
+  std::unique_ptr<Dex2Oat> daemon = std::make_unique<Dex2Oat>(&timings);
+  std::string socket_path;
+  if (!daemon->SetupDaemon(argc, argv, &socket_path)) {
+    return dex2oat::ReturnCode::kCreateRuntime;
+  }
+
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (socket_path.size() >= sizeof(address.sun_path)) {
+    LOG(ERROR) << "Socket path too long: " << socket_path;
+    return dex2oat::ReturnCode::kOther;
+  }
+  strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1u);
+  int listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (listen_fd < 0) {
+    PLOG(ERROR) << "Failed to create dex2oat daemon socket";
+    return dex2oat::ReturnCode::kOther;
+  }
+  unlink(socket_path.c_str());
+  if (bind(listen_fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0 ||
+      listen(listen_fd, SOMAXCONN) != 0) {
+    PLOG(ERROR) << "Failed to listen on " << socket_path;
+    close(listen_fd);
+    return dex2oat::ReturnCode::kOther;
+  }
+  // Children reply to their clients directly, let the kernel reap them.
+  signal(SIGCHLD, SIG_IGN);
+  LOG(INFO) << "dex2oat daemon listening on " << socket_path;
+
+  while (true) {
+    int connection_fd = TEMP_FAILURE_RETRY(accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC));
+    if (connection_fd < 0) {
+      PLOG(ERROR) << "Failed to accept dex2oat daemon request";
+      continue;
+    }
+    pid_t pid = fork();
+    if (pid == 0) {
+      close(listen_fd);
+      HandleDaemonRequest(connection_fd);
+    }
+    if (pid < 0) {
+      PLOG(ERROR) << "Failed to fork for dex2oat daemon request";
+    }
+    close(connection_fd);
+  }
+}
+
+static bool IsDaemonInvocation(int argc, char** argv) {
+  for (int i = 1; i < argc; ++i) {
+    if (android::base::StartsWith(argv[i], "--daemon-socket=")) {
+      return true;
+    }
+  }
+  return false;
+}
 }  // namespace art
 
 int main(int argc, char** argv) {
-  int result = static_cast<int>(art::Dex2oat(argc, argv));
+  int result = art::IsDaemonInvocation(argc, argv)
+      ? static_cast<int>(art::RunDaemon(argc, argv))
+      : static_cast<int>(art::Dex2oat(argc, argv));
   // Everything was done, do an explicit exit here to avoid running Runtime destructors that take
   // time (bug 10645725) unless we're a debug build or running on valgrind. Note: The Dex2Oat class
   // should not destruct the runtime in this case.
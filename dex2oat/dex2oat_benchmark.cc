@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Benchmark of the compilation of the libcore dex files into a boot image with each compiler
+// filter and number of threads. Not one of the gtests run by test-art, run it with
+//
+//   art_dex2oat_benchmarks [--gtest_filter=...]
+//
+// Every compilation prints a line of space separated key=value results, starting with
+// "dex2oat-benchmark:". If ART_DEX2OAT_BENCHMARK_DIR is set, the results are also appended to
+// results.txt in that directory and the timing splits of each compilation are written there
+// as <filter>-j<threads>.json, see --dump-timing-json.
+
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "android-base/stringprintf.h"
+
+#include "common_runtime_test.h"
+
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/time_utils.h"
+#include "runtime.h"
+#include "utils.h"
+
+namespace art {
+
+struct Dex2oatRun {
+  bool success = false;
+  uint64_t wall_time_ns = 0;
+  uint64_t cpu_time_ns = 0;
+  // Peak resident set size of dex2oat, in KiB.
+  uint64_t max_rss_kb = 0;
+  size_t art_size = 0;
+  size_t oat_size = 0;
+  size_t vdex_size = 0;
+};
+
+static uint64_t TimevalToNs(const timeval& time) {
+  return static_cast<uint64_t>(time.tv_sec) * UINT64_C(1000000000) +
+      static_cast<uint64_t>(time.tv_usec) * UINT64_C(1000);
+}
+
+class Dex2oatBenchmark : public CommonRuntimeTest {
+ protected:
+  static std::string GetResultsDir() {
+    const char* dir = getenv("ART_DEX2OAT_BENCHMARK_DIR");
+    return (dir != nullptr) ? std::string(dir) : std::string();
+  }
+
+  // Run dex2oat with `args`, with its output discarded.
+  static bool RunDex2Oat(const std::vector<std::string>& args, Dex2oatRun* run) {
+    uint64_t start_time = NanoTime();
+    pid_t pid = fork();
+    if (pid == -1) {
+      return false;
+    }
+    if (pid == 0) {
+      setenv("ANDROID_LOG_TAGS", "*:e", 1);
+      std::vector<const char*> c_args;
+      for (const std::string& str : args) {
+        c_args.push_back(str.c_str());
+      }
+      c_args.push_back(nullptr);
+      execv(c_args[0], const_cast<char* const*>(c_args.data()));
+      exit(1);
+      UNREACHABLE();
+    }
+    int status = -1;
+    rusage usage;
+    if (TEMP_FAILURE_RETRY(wait4(pid, &status, 0, &usage)) == -1) {
+      return false;
+    }
+    run->wall_time_ns = NanoTime() - start_time;
+    run->cpu_time_ns = TimevalToNs(usage.ru_utime) + TimevalToNs(usage.ru_stime);
+    run->max_rss_kb = usage.ru_maxrss;
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+  }
+
+  Dex2oatRun CompileBootImage(const std::string& compiler_filter, size_t threads) {
+    Runtime* const runtime = Runtime::Current();
+    ScratchFile scratch;
+    const std::string prefix = scratch.GetFilename();
+    std::vector<std::string> argv;
+    argv.push_back(runtime->GetCompilerExecutable());
+    argv.push_back("--runtime-arg");
+    argv.push_back("-Xms64m");
+    argv.push_back("--runtime-arg");
+    argv.push_back("-Xmx512m");
+    for (const std::string& dex_file : GetLibCoreDexFileNames()) {
+      argv.push_back("--dex-file=" + dex_file);
+      argv.push_back("--dex-location=" + dex_file);
+    }
+    runtime->AddCurrentRuntimeFeaturesAsDex2OatArguments(&argv);
+    if (!kIsTargetBuild) {
+      argv.push_back("--host");
+    }
+    argv.push_back("--image=" + prefix + ".art");
+    argv.push_back("--oat-file=" + prefix + ".oat");
+    argv.push_back("--oat-location=" + prefix + ".oat");
+    argv.push_back("--base=0x60000000");
+    argv.push_back("--compiler-filter=" + compiler_filter);
+    argv.push_back("-j" + std::to_string(threads));
+    const std::string results_dir = GetResultsDir();
+    if (!results_dir.empty()) {
+      argv.push_back(android::base::StringPrintf("--dump-timing-json=%s/%s-j%zu.json",
+                                                 results_dir.c_str(),
+                                                 compiler_filter.c_str(),
+                                                 threads));
+    }
+    const char* android_root = getenv("ANDROID_ROOT");
+    CHECK(android_root != nullptr);
+    argv.push_back("--android-root=" + std::string(android_root));
+
+    Dex2oatRun run;
+    run.success = RunDex2Oat(argv, &run);
+    if (run.success) {
+      run.art_size = GetFileSizeBytes(prefix + ".art");
+      run.oat_size = GetFileSizeBytes(prefix + ".oat");
+      run.vdex_size = GetFileSizeBytes(prefix + ".vdex");
+    }
+    for (const char* extension : { ".art", ".oat", ".vdex" }) {
+      unlink((prefix + extension).c_str());
+    }
+    return run;
+  }
+
+  void Report(const std::string& compiler_filter, size_t threads, const Dex2oatRun& run) {
+    std::ostringstream os;
+    os << "filter=" << compiler_filter
+       << " threads=" << threads
+       << " success=" << run.success
+       << " wall-time-ns=" << run.wall_time_ns
+       << " cpu-time-ns=" << run.cpu_time_ns
+       << " max-rss-kb=" << run.max_rss_kb
+       << " art-size=" << run.art_size
+       << " oat-size=" << run.oat_size
+       << " vdex-size=" << run.vdex_size;
+    std::cout << "dex2oat-benchmark: " << os.str() << std::endl;
+    const std::string results_dir = GetResultsDir();
+    if (!results_dir.empty()) {
+      std::ofstream results(results_dir + "/results.txt", std::ios::app);
+      results << os.str() << std::endl;
+    }
+  }
+
+  void CompileWithThreads(const std::string& compiler_filter) {
+    std::vector<size_t> thread_counts = { 1u, 4u };
+    size_t cpus = std::thread::hardware_concurrency();
+    if (cpus > 4u) {
+      thread_counts.push_back(cpus);
+    }
+    for (size_t threads : thread_counts) {
+      Dex2oatRun run = CompileBootImage(compiler_filter, threads);
+      Report(compiler_filter, threads, run);
+      EXPECT_TRUE(run.success) << compiler_filter << " -j" << threads;
+    }
+  }
+};
+
+TEST_F(Dex2oatBenchmark, Verify) {
+  CompileWithThreads("verify");
+}
+
+TEST_F(Dex2oatBenchmark, Quicken) {
+  CompileWithThreads("quicken");
+}
+
+TEST_F(Dex2oatBenchmark, Space) {
+  CompileWithThreads("space");
+}
+
+TEST_F(Dex2oatBenchmark, Speed) {
+  CompileWithThreads("speed");
+}
+
+TEST_F(Dex2oatBenchmark, Everything) {
+  CompileWithThreads("everything");
+}
+
+}  // namespace art
@@ -37,13 +37,18 @@
 #include <inttypes.h>
 #include <stdio.h>
 
+#include <algorithm>
 #include <iostream>
 #include <memory>
 #include <sstream>
+#include <thread>
 #include <vector>
 
 #include "android-base/stringprintf.h"
 
+#include "atomic.h"
+#include "base/bit_utils.h"
+#include "base/logging.h"
 #include "dexdump_cfg.h"
 #include "dex_file-inl.h"
 #include "dex_file_types.h"
@@ -57,9 +62,10 @@ namespace art {
 struct Options gOptions;
 
 /*
- * Output file. Defaults to stdout.
+ * Output file. Defaults to stdout. Per thread, so that classes can be
+ * formatted into memory on several threads, see dumpClassesInParallel().
  */
-FILE* gOutFile = stdout;
+thread_local FILE* gOutFile = stdout;
 
 /*
  * Data types that match the definitions in the VM specification.
@@ -1803,6 +1809,60 @@ static void dumpCallSite(const DexFile* pDexFile, u4 idx) {
   }
 }
 
+/*
+ * Dumps the classes of a dex file on gOptions.numThreads threads. The classes
+ * are formatted into memory in chunks, and the chunks are written out in class
+ * order so that the output does not depend on the number of threads. Only used
+ * for the plain output, the XML output depends on the package of the previous
+ * class.
+ */
+static void dumpClassesInParallel(const DexFile* pDexFile, u4 classDefsSize) {
+  static constexpr u4 kClassesPerChunk = 16;
+  const u4 numThreads = static_cast<u4>(gOptions.numThreads);
+  const u4 numChunks = RoundUp(classDefsSize, kClassesPerChunk) / kClassesPerChunk;
+  // Bound the memory held by formatted chunks that are not written out yet.
+  const u4 windowSize = 4 * numThreads;
+  std::vector<std::string> chunks(windowSize);
+  FILE* const outFile = gOutFile;
+  for (u4 windowBegin = 0; windowBegin < numChunks; windowBegin += windowSize) {
+    const u4 windowEnd = std::min(numChunks, windowBegin + windowSize);
+    Atomic<u4> nextChunk(windowBegin);
+    auto formatChunks = [&]() {
+      for (u4 chunk = nextChunk.FetchAndAddSequentiallyConsistent(1u);
+           chunk < windowEnd;
+           chunk = nextChunk.FetchAndAddSequentiallyConsistent(1u)) {
+        char* buffer = nullptr;
+        size_t size = 0;
+        gOutFile = open_memstream(&buffer, &size);
+        CHECK(gOutFile != nullptr) << "Failed to open memory stream";
+        char* package = nullptr;
+        const u4 end = std::min(classDefsSize, (chunk + 1) * kClassesPerChunk);
+        for (u4 i = chunk * kClassesPerChunk; i < end; i++) {
+          dumpClass(pDexFile, i, &package);
+        }
+        DCHECK(package == nullptr);
+        fclose(gOutFile);
+        chunks[chunk - windowBegin].assign(buffer, size);
+        free(buffer);
+      }
+    };
+    std::vector<std::thread> threads;
+    for (u4 t = 1; t < numThreads; t++) {
+      threads.emplace_back(formatChunks);
+    }
+    formatChunks();
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+    gOutFile = outFile;
+    for (u4 chunk = windowBegin; chunk < windowEnd; chunk++) {
+      std::string& text = chunks[chunk - windowBegin];
+      fwrite(text.data(), 1, text.size(), gOutFile);
+      text.clear();
+    }
+  }
+}
+
 /*
  * Dumps the requested sections of the file.
  */
@@ -1830,9 +1890,13 @@ static void processDexFile(const char* fileName,
   // Iterate over all classes.
   char* package = nullptr;
   const u4 classDefsSize = pDexFile->GetHeader().class_defs_size_;
-  for (u4 i = 0; i < classDefsSize; i++) {
-    dumpClass(pDexFile, i, &package);
-  }  // for
+  if (gOptions.numThreads > 1 && gOptions.outputFormat == OUTPUT_PLAIN) {
+    dumpClassesInParallel(pDexFile, classDefsSize);
+  } else {
+    for (u4 i = 0; i < classDefsSize; i++) {
+      dumpClass(pDexFile, i, &package);
+    }  // for
+  }
 
   // Iterate over all method handles.
   for (u4 i = 0; i < pDexFile->NumMethodHandles(); ++i) {
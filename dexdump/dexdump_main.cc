@@ -25,6 +25,7 @@
 #include "dexdump.h"
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
@@ -36,13 +37,18 @@ namespace art {
 
 static const char* gProgName = "dexdump";
 
+/*
+ * Size of the output buffer.
+ */
+static constexpr size_t kOutputBufferSize = 256 * 1024;
+
 /*
  * Shows usage.
  */
 static void usage(void) {
   fprintf(stderr, "Copyright (C) 2007 The Android Open Source Project\n\n");
-  fprintf(stderr, "%s: [-a] [-c] [-d] [-e] [-f] [-h] [-i] [-l layout] [-o outfile]"
-                  " dexfile...\n\n", gProgName);
+  fprintf(stderr, "%s: [-a] [-c] [-d] [-e] [-f] [-h] [-i] [-j threads] [-l layout]"
+                  " [-o outfile] dexfile...\n\n", gProgName);
   fprintf(stderr, " -a : display annotations\n");
   fprintf(stderr, " -c : verify checksum and exit\n");
   fprintf(stderr, " -d : disassemble code sections\n");
@@ -51,6 +57,7 @@ static void usage(void) {
   fprintf(stderr, " -g : display CFG for dex\n");
   fprintf(stderr, " -h : display file header details\n");
   fprintf(stderr, " -i : ignore checksum failures\n");
+  fprintf(stderr, " -j : number of threads formatting the classes of plain output\n");
   fprintf(stderr, " -l : output layout, either 'plain' or 'xml'\n");
   fprintf(stderr, " -o : output file name (defaults to stdout)\n");
 }
@@ -67,10 +74,11 @@ int dexdumpDriver(int argc, char** argv) {
   bool wantUsage = false;
   memset(&gOptions, 0, sizeof(gOptions));
   gOptions.verbose = true;
+  gOptions.numThreads = 1;
 
   // Parse all arguments.
   while (1) {
-    const int ic = getopt(argc, argv, "acdefghil:o:");
+    const int ic = getopt(argc, argv, "acdefghij:l:o:");
     if (ic < 0) {
       break;  // done
     }
@@ -99,6 +107,12 @@ int dexdumpDriver(int argc, char** argv) {
       case 'i':  // continue even if checksum is bad
         gOptions.ignoreBadChecksum = true;
         break;
+      case 'j':  // number of threads
+        gOptions.numThreads = atoi(optarg);
+        if (gOptions.numThreads <= 0) {
+          wantUsage = true;
+        }
+        break;
       case 'l':  // layout
         if (strcmp(optarg, "plain") == 0) {
           gOptions.outputFormat = OUTPUT_PLAIN;
@@ -141,6 +155,12 @@ int dexdumpDriver(int argc, char** argv) {
     }
   }
 
+  // Dumps are written in many small pieces, use a large buffer unless the
+  // output goes to a terminal.
+  if (!isatty(fileno(gOutFile))) {
+    setvbuf(gOutFile, nullptr, _IOFBF, kOutputBufferSize);
+  }
+
   // Process all files supplied on command line.
   int result = 0;
   while (optind < argc) {
@@ -73,6 +73,19 @@ TEST_F(DexDumpTest, FullPlainOutput) {
     dex_file_}, &error_msg)) << error_msg;
 }
 
+TEST_F(DexDumpTest, ParallelPlainOutput) {
+  ScratchFile serial_output;
+  ScratchFile parallel_output;
+  std::string error_msg;
+  ASSERT_TRUE(Exec({"-d", "-a", "-l", "plain", "-o", serial_output.GetFilename(),
+    dex_file_}, &error_msg)) << error_msg;
+  ASSERT_TRUE(Exec({"-d", "-a", "-j", "4", "-l", "plain", "-o", parallel_output.GetFilename(),
+    dex_file_}, &error_msg)) << error_msg;
+  std::vector<std::string> diff_exec_argv =
+      { "/usr/bin/diff", serial_output.GetFilename(), parallel_output.GetFilename() };
+  ASSERT_TRUE(::art::Exec(diff_exec_argv, &error_msg)) << error_msg;
+}
+
 TEST_F(DexDumpTest, XMLOutput) {
   std::string error_msg;
   ASSERT_TRUE(Exec({"-l", "xml", "-o", "/dev/null",
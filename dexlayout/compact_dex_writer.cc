@@ -0,0 +1,199 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Writer of compact dex files.
+ */
+
+#include "compact_dex_writer.h"
+
+#include <algorithm>
+
+#include "base/bit_utils.h"
+#include "compact_dex_file.h"
+
+namespace art {
+
+// Offset 0 means that there is no item, so no item of the shared data starts there.
+static constexpr size_t kReservedSharedDataSize = 4u;
+static constexpr size_t kDexCodeItemAlignment = 4u;
+
+uint32_t CompactDexSharedData::Add(const std::vector<uint8_t>& data,
+                                   size_t alignment,
+                                   bool deduplicate) {
+  if (deduplicate) {
+    auto it = offsets_.find(std::make_pair(alignment, data));
+    if (it != offsets_.end()) {
+      return it->second;
+    }
+  }
+  if (data_.empty()) {
+    data_.resize(kReservedSharedDataSize, 0u);
+  }
+  uint32_t offset = RoundUp(data_.size(), alignment);
+  data_.resize(offset, 0u);
+  data_.insert(data_.end(), data.begin(), data.end());
+  if (deduplicate) {
+    offsets_.emplace(std::make_pair(alignment, data), offset);
+  }
+  return offset;
+}
+
+size_t CompactDexWriter::Write(const void* buffer, size_t length, size_t offset) {
+  if (buffer_ == nullptr) {
+    return DexWriter::Write(buffer, length, offset);
+  }
+  if (buffer_->size() < offset + length) {
+    buffer_->resize(offset + length, 0u);
+  }
+  memcpy(buffer_->data() + offset, buffer, length);
+  return length;
+}
+
+template <typename T, typename WriteItem>
+void CompactDexWriter::AddDataItems(std::map<uint32_t, std::unique_ptr<T>>& items,
+                                    size_t alignment,
+                                    bool deduplicate,
+                                    CompactDexSharedData* shared_data,
+                                    WriteItem write_item) {
+  // The map is keyed by the offsets in the input, keep the order of the layout instead.
+  std::vector<T*> sorted_items;
+  sorted_items.reserve(items.size());
+  for (auto& pair : items) {
+    sorted_items.push_back(pair.second.get());
+  }
+  std::stable_sort(sorted_items.begin(), sorted_items.end(), [](T* lhs, T* rhs) {
+    return lhs->GetOffset() < rhs->GetOffset();
+  });
+  std::vector<uint8_t> buffer;
+  buffer_ = &buffer;
+  for (T* item : sorted_items) {
+    buffer.clear();
+    write_item(item);
+    item->SetOffset(shared_data->Add(buffer, alignment, deduplicate));
+  }
+  buffer_ = nullptr;
+}
+
+void CompactDexWriter::LayoutDataItems(CompactDexSharedData* shared_data) {
+  dex_ir::Collections& collections = header_->GetCollections();
+  // Items are encoded after the items they refer to, so that identical encodings mean
+  // identical items. Code items are not shared since quickening rewrites them in place, and
+  // neither is class data, which refers to them.
+  AddDataItems(collections.StringDatas(), 1u, /* deduplicate */ true, shared_data,
+               [this](dex_ir::StringData* item) { WriteStringData(item, 0u); });
+  AddDataItems(collections.TypeLists(), 4u, /* deduplicate */ true, shared_data,
+               [this](dex_ir::TypeList* item) { WriteTypeList(item, 0u); });
+  AddDataItems(collections.DebugInfoItems(), 1u, /* deduplicate */ true, shared_data,
+               [this](dex_ir::DebugInfoItem* item) { WriteDebugInfoItem(item, 0u); });
+  AddDataItems(collections.EncodedArrayItems(), 1u, /* deduplicate */ true, shared_data,
+               [this](dex_ir::EncodedArrayItem* item) {
+    WriteEncodedArray(item->GetEncodedValues(), 0u);
+  });
+  AddDataItems(collections.AnnotationItems(), 1u, /* deduplicate */ true, shared_data,
+               [this](dex_ir::AnnotationItem* item) { WriteAnnotation(item, 0u); });
+  AddDataItems(collections.AnnotationSetItems(), 4u, /* deduplicate */ true, shared_data,
+               [this](dex_ir::AnnotationSetItem* item) { WriteAnnotationSet(item, 0u); });
+  AddDataItems(collections.AnnotationSetRefLists(), 4u, /* deduplicate */ true, shared_data,
+               [this](dex_ir::AnnotationSetRefList* item) { WriteAnnotationSetRef(item, 0u); });
+  AddDataItems(collections.AnnotationsDirectoryItems(), 4u, /* deduplicate */ true, shared_data,
+               [this](dex_ir::AnnotationsDirectoryItem* item) {
+    WriteAnnotationsDirectory(item, 0u);
+  });
+  AddDataItems(collections.CodeItems(), kDexCodeItemAlignment, /* deduplicate */ false,
+               shared_data,
+               [this](dex_ir::CodeItem* item) { WriteCodeItem(item, 0u); });
+  AddDataItems(collections.ClassDatas(), 1u, /* deduplicate */ false, shared_data,
+               [this](dex_ir::ClassData* item) { WriteClassData(item, 0u); });
+}
+
+// Place the items of an id section at `*offset`, returns the offset of the section.
+template <typename T>
+static uint32_t LayoutIdSection(std::vector<std::unique_ptr<T>>& items, uint32_t* offset) {
+  if (items.empty()) {
+    return 0u;
+  }
+  uint32_t section_offset = *offset;
+  for (std::unique_ptr<T>& item : items) {
+    item->SetOffset(*offset);
+    *offset += item->GetSize();
+  }
+  return section_offset;
+}
+
+void CompactDexWriter::LayoutMainSection() {
+  dex_ir::Collections& collections = header_->GetCollections();
+  uint32_t offset = dex_ir::kHeaderItemSize;
+  collections.SetStringIdsOffset(LayoutIdSection(collections.StringIds(), &offset));
+  collections.SetTypeIdsOffset(LayoutIdSection(collections.TypeIds(), &offset));
+  collections.SetProtoIdsOffset(LayoutIdSection(collections.ProtoIds(), &offset));
+  collections.SetFieldIdsOffset(LayoutIdSection(collections.FieldIds(), &offset));
+  collections.SetMethodIdsOffset(LayoutIdSection(collections.MethodIds(), &offset));
+  collections.SetClassDefsOffset(LayoutIdSection(collections.ClassDefs(), &offset));
+  collections.SetCallSiteIdsOffset(LayoutIdSection(collections.CallSiteIds(), &offset));
+  collections.SetMethodHandleItemsOffset(
+      LayoutIdSection(collections.MethodHandleItems(), &offset));
+  // The map list lists the header, the id sections and itself.
+  offset = RoundUp(offset, 4u);
+  collections.SetMapListOffset(offset);
+  size_t map_items = 2u;
+  for (uint32_t section_size : { collections.StringIdsSize(),
+                                 collections.TypeIdsSize(),
+                                 collections.ProtoIdsSize(),
+                                 collections.FieldIdsSize(),
+                                 collections.MethodIdsSize(),
+                                 collections.ClassDefsSize(),
+                                 collections.CallSiteIdsSize(),
+                                 collections.MethodHandleItemsSize() }) {
+    if (section_size != 0u) {
+      ++map_items;
+    }
+  }
+  offset += sizeof(uint32_t) + map_items * sizeof(DexFile::MapItem);
+  header_->SetFileSize(offset);
+  header_->SetDataSize(0u);
+  header_->SetDataOffset(0u);
+  header_->SetLinkSize(0u);
+  header_->SetLinkOffset(0u);
+}
+
+void CompactDexWriter::Layout(dex_ir::Header* header, CompactDexSharedData* shared_data) {
+  CompactDexWriter writer(header, /* mem_map */ nullptr);
+  writer.LayoutDataItems(shared_data);
+  writer.LayoutMainSection();
+}
+
+void CompactDexWriter::Output(dex_ir::Header* header, MemMap* mem_map, size_t thread_count) {
+  CompactDexWriter writer(header, mem_map);
+  // The data items are in the shared data section already.
+  static constexpr void (CompactDexWriter::*kSectionWriters[])() = {
+    &CompactDexWriter::WriteStringIds,
+    &CompactDexWriter::WriteTypes,
+    &CompactDexWriter::WriteProtos,
+    &CompactDexWriter::WriteFields,
+    &CompactDexWriter::WriteMethods,
+    &CompactDexWriter::WriteClassDefs,
+    &CompactDexWriter::WriteCallSites,
+    &CompactDexWriter::WriteMethodHandles,
+  };
+  dex_ir::ParallelFor(arraysize(kSectionWriters), thread_count, [&](size_t i) {
+    (writer.*kSectionWriters[i])();
+  });
+  writer.WriteMapItem(/* include_data_sections */ false);
+  writer.WriteHeader();
+  CompactDexFile::WriteMagic(mem_map->Begin());
+  CompactDexFile::WriteCurrentVersion(mem_map->Begin());
+}
+
+}  // namespace art
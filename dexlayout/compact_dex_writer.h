@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Header file of the writer of compact dex files.
+ */
+
+#ifndef ART_DEXLAYOUT_COMPACT_DEX_WRITER_H_
+#define ART_DEXLAYOUT_COMPACT_DEX_WRITER_H_
+
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "dex_writer.h"
+
+namespace art {
+
+// The data section shared by the compact dex files of a vdex.
+class CompactDexSharedData {
+ public:
+  CompactDexSharedData() = default;
+
+  // Append the encoded item `data` at an offset aligned to `alignment` and return that offset.
+  // With `deduplicate`, return the offset of an identical item added before if there is one.
+  uint32_t Add(const std::vector<uint8_t>& data, size_t alignment, bool deduplicate);
+
+  const std::vector<uint8_t>& GetData() const {
+    return data_;
+  }
+
+ private:
+  std::vector<uint8_t> data_;
+  // Offsets of the deduplicated items, by alignment and encoding.
+  std::map<std::pair<size_t, std::vector<uint8_t>>, uint32_t> offsets_;
+
+  DISALLOW_COPY_AND_ASSIGN(CompactDexSharedData);
+};
+
+class CompactDexWriter : public DexWriter {
+ public:
+  // Move the data items of `header` to `shared_data` and lay out the header, the id sections
+  // and the map list of the compact dex file. Sets the file size, so it must be called before
+  // mapping the output.
+  static void Layout(dex_ir::Header* header, CompactDexSharedData* shared_data);
+
+  // Write the compact dex file laid out by Layout().
+  static void Output(dex_ir::Header* header, MemMap* mem_map, size_t thread_count);
+
+ protected:
+  size_t Write(const void* buffer, size_t length, size_t offset) OVERRIDE;
+
+ private:
+  CompactDexWriter(dex_ir::Header* header, MemMap* mem_map)
+      : DexWriter(header, mem_map), buffer_(nullptr) { }
+
+  // Encode the items of `items` one at a time with `write_item` and move them to `shared_data`,
+  // in the order of their current offsets.
+  template <typename T, typename WriteItem>
+  void AddDataItems(std::map<uint32_t, std::unique_ptr<T>>& items,
+                    size_t alignment,
+                    bool deduplicate,
+                    CompactDexSharedData* shared_data,
+                    WriteItem write_item);
+
+  void LayoutDataItems(CompactDexSharedData* shared_data);
+  void LayoutMainSection();
+
+  // When not null, Write() encodes into this buffer rather than the output.
+  std::vector<uint8_t>* buffer_;
+};
+
+}  // namespace art
+
+#endif  // ART_DEXLAYOUT_COMPACT_DEX_WRITER_H_
@@ -20,13 +20,40 @@
  * file layout.
  */
 
+#include <algorithm>
+#include <thread>
+
 #include "dex_ir.h"
+#include "atomic.h"
 #include "dex_instruction-inl.h"
 #include "dex_ir_builder.h"
 
 namespace art {
 namespace dex_ir {
 
+// Number of strings each thread creates at a time in CreateStringIds.
+static constexpr size_t kStringBlockSize = 256;
+
+void ParallelFor(size_t count, size_t thread_count, const std::function<void(size_t)>& fn) {
+  Atomic<size_t> next_index(0u);
+  auto run = [&]() {
+    for (size_t i = next_index.FetchAndAddSequentiallyConsistent(1u);
+         i < count;
+         i = next_index.FetchAndAddSequentiallyConsistent(1u)) {
+      fn(i);
+    }
+  };
+  const size_t num_threads = std::min(thread_count, count);
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < num_threads; ++i) {
+    threads.emplace_back(run);
+  }
+  run();
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
 static uint64_t ReadVarWidth(const uint8_t** data, uint8_t length, bool sign_extend) {
   uint64_t value = 0;
   for (uint32_t i = 0; i <= length; i++) {
@@ -322,7 +349,27 @@ void Collections::ReadEncodedValue(
 
 void Collections::CreateStringId(const DexFile& dex_file, uint32_t i) {
   const DexFile::StringId& disk_string_id = dex_file.GetStringId(dex::StringIndex(i));
-  StringData* string_data = new StringData(dex_file.GetStringData(disk_string_id));
+  AddStringId(dex_file, i, new StringData(dex_file.GetStringData(disk_string_id)));
+}
+
+void Collections::CreateStringIds(const DexFile& dex_file, size_t thread_count) {
+  const size_t num_string_ids = dex_file.NumStringIds();
+  std::vector<StringData*> string_datas(num_string_ids, nullptr);
+  const size_t num_blocks = RoundUp(num_string_ids, kStringBlockSize) / kStringBlockSize;
+  ParallelFor(num_blocks, thread_count, [&](size_t block) {
+    const size_t end = std::min(num_string_ids, (block + 1) * kStringBlockSize);
+    for (size_t i = block * kStringBlockSize; i < end; ++i) {
+      const DexFile::StringId& disk_string_id = dex_file.GetStringId(dex::StringIndex(i));
+      string_datas[i] = new StringData(dex_file.GetStringData(disk_string_id));
+    }
+  });
+  for (uint32_t i = 0; i < num_string_ids; ++i) {
+    AddStringId(dex_file, i, string_datas[i]);
+  }
+}
+
+void Collections::AddStringId(const DexFile& dex_file, uint32_t i, StringData* string_data) {
+  const DexFile::StringId& disk_string_id = dex_file.GetStringId(dex::StringIndex(i));
   string_datas_.AddItem(string_data, disk_string_id.string_data_off_);
 
   StringId* string_id = new StringId(string_data);
@@ -558,13 +605,8 @@ ParameterAnnotation* Collections::GenerateParameterAnnotation(
   return new ParameterAnnotation(method_id, set_ref_list);
 }
 
-CodeItem* Collections::CreateCodeItem(const DexFile& dex_file,
-                                      const DexFile::CodeItem& disk_code_item, uint32_t offset) {
-  uint16_t registers_size = disk_code_item.registers_size_;
-  uint16_t ins_size = disk_code_item.ins_size_;
-  uint16_t outs_size = disk_code_item.outs_size_;
-  uint32_t tries_size = disk_code_item.tries_size_;
-
+DebugInfoItem* Collections::CreateDebugInfoItem(const DexFile& dex_file,
+                                                const DexFile::CodeItem& disk_code_item) {
   // TODO: Calculate the size of the debug info.
   const uint8_t* debug_info_stream = dex_file.GetDebugInfoStream(&disk_code_item);
   DebugInfoItem* debug_info = nullptr;
@@ -578,6 +620,58 @@ CodeItem* Collections::CreateCodeItem(const DexFile& dex_file,
       debug_info_items_.AddItem(debug_info, disk_code_item.debug_info_off_);
     }
   }
+  return debug_info;
+}
+
+CodeItem* Collections::CreateCodeItem(const DexFile& dex_file,
+                                      const DexFile::CodeItem& disk_code_item, uint32_t offset) {
+  DebugInfoItem* debug_info = CreateDebugInfoItem(dex_file, disk_code_item);
+  CodeItem* code_item = BuildCodeItem(dex_file, disk_code_item, debug_info);
+  code_items_.AddItem(code_item, offset);
+  return code_item;
+}
+
+void Collections::CreateCodeItems(const DexFile& dex_file, size_t thread_count) {
+  // Collect the code items of all methods, each shared code item once and in offset order.
+  std::map<uint32_t, const DexFile::CodeItem*> disk_code_item_map;
+  for (uint32_t i = 0; i < dex_file.NumClassDefs(); ++i) {
+    const uint8_t* encoded_data = dex_file.GetClassData(dex_file.GetClassDef(i));
+    if (encoded_data == nullptr) {
+      continue;
+    }
+    ClassDataItemIterator cdii(dex_file, encoded_data);
+    cdii.SkipAllFields();
+    for (; cdii.HasNextDirectMethod() || cdii.HasNextVirtualMethod(); cdii.Next()) {
+      const DexFile::CodeItem* disk_code_item = cdii.GetMethodCodeItem();
+      if (disk_code_item != nullptr &&
+          code_items_.GetExistingObject(cdii.GetMethodCodeItemOffset()) == nullptr) {
+        disk_code_item_map.emplace(cdii.GetMethodCodeItemOffset(), disk_code_item);
+      }
+    }
+  }
+  std::vector<std::pair<uint32_t, const DexFile::CodeItem*>> disk_code_items(
+      disk_code_item_map.begin(), disk_code_item_map.end());
+  std::vector<DebugInfoItem*> debug_infos;
+  debug_infos.reserve(disk_code_items.size());
+  for (const auto& disk_code_item : disk_code_items) {
+    debug_infos.push_back(CreateDebugInfoItem(dex_file, *disk_code_item.second));
+  }
+  std::vector<CodeItem*> code_items(disk_code_items.size(), nullptr);
+  ParallelFor(disk_code_items.size(), thread_count, [&](size_t i) {
+    code_items[i] = BuildCodeItem(dex_file, *disk_code_items[i].second, debug_infos[i]);
+  });
+  for (size_t i = 0; i < disk_code_items.size(); ++i) {
+    code_items_.AddItem(code_items[i], disk_code_items[i].first);
+  }
+}
+
+CodeItem* Collections::BuildCodeItem(const DexFile& dex_file,
+                                     const DexFile::CodeItem& disk_code_item,
+                                     DebugInfoItem* debug_info) {
+  uint16_t registers_size = disk_code_item.registers_size_;
+  uint16_t ins_size = disk_code_item.ins_size_;
+  uint16_t outs_size = disk_code_item.outs_size_;
+  uint32_t tries_size = disk_code_item.tries_size_;
 
   uint32_t insns_size = disk_code_item.insns_size_in_code_units_;
   uint16_t* insns = new uint16_t[insns_size];
@@ -665,7 +759,6 @@ CodeItem* Collections::CreateCodeItem(const DexFile& dex_file,
   CodeItem* code_item = new CodeItem(
       registers_size, ins_size, outs_size, debug_info, insns_size, insns, tries, handler_list);
   code_item->SetSize(size);
-  code_items_.AddItem(code_item, offset);
   // Add "fixup" references to types, strings, methods, and fields.
   // This is temporary, as we will probably want more detailed parsing of the
   // instructions here.
@@ -701,7 +794,11 @@ MethodItem* Collections::GenerateMethodItem(const DexFile& dex_file, ClassDataIt
     }
     debug_info = code_item->DebugInfo();
   }
-  if (debug_info != nullptr) {
+  // Code items, and so their debug info, may be shared between methods. Only decode the debug
+  // info for the first of them so that the positions and locals are not duplicated.
+  if (debug_info != nullptr &&
+      debug_info->GetPositionInfo().empty() &&
+      debug_info->GetLocalInfo().empty()) {
     bool is_static = (access_flags & kAccStatic) != 0;
     dex_file.DecodeDebugLocalInfo(
         disk_code_item, is_static, cdii.GetMemberIndex(), GetLocalsCb, debug_info);
@@ -778,7 +875,7 @@ void Collections::CreateCallSitesAndMethodHandles(const DexFile& dex_file) {
 
 void Collections::CreateCallSiteId(const DexFile& dex_file, uint32_t i) {
   const DexFile::CallSiteIdItem& disk_call_site_id = dex_file.GetCallSiteId(i);
-  const uint8_t* disk_call_item_ptr = dex_file.Begin() + disk_call_site_id.data_off_;
+  const uint8_t* disk_call_item_ptr = dex_file.DataBegin() + disk_call_site_id.data_off_;
   EncodedArrayItem* call_site_item =
       CreateEncodedArrayItem(disk_call_item_ptr, disk_call_site_id.data_off_);
 
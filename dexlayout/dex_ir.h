@@ -19,6 +19,7 @@
 #ifndef ART_DEXLAYOUT_DEX_IR_H_
 #define ART_DEXLAYOUT_DEX_IR_H_
 
+#include <functional>
 #include <map>
 #include <vector>
 #include <stdint.h>
@@ -71,6 +72,11 @@ static constexpr size_t kClassDefItemSize = 32;
 static constexpr size_t kCallSiteIdItemSize = 4;
 static constexpr size_t kMethodHandleItemSize = 8;
 
+// Call `fn` for every index in [0, count) on up to `thread_count` threads, the calling thread
+// included. The indexes are handed out in increasing order and `fn` must be safe to call
+// concurrently for different indexes.
+void ParallelFor(size_t count, size_t thread_count, const std::function<void(size_t)>& fn);
+
 // Visitor support
 class AbstractDispatcher {
  public:
@@ -204,6 +210,14 @@ class Collections {
 
   void CreateCallSitesAndMethodHandles(const DexFile& dex_file);
 
+  // Create the string ids and string data on up to `thread_count` threads. Only the string data
+  // is built concurrently, the items are added to the collections in index order.
+  void CreateStringIds(const DexFile& dex_file, size_t thread_count);
+  // Create the code items of all class data ahead of the class defs, on up to `thread_count`
+  // threads. The debug info items, which code items may share, are created first and the code
+  // items are added to the collection in offset order. Needs the id tables to be complete.
+  void CreateCodeItems(const DexFile& dex_file, size_t thread_count);
+
   TypeList* CreateTypeList(const DexFile::TypeList* type_list, uint32_t offset);
   EncodedArrayItem* CreateEncodedArrayItem(const uint8_t* static_data, uint32_t offset);
   AnnotationItem* CreateAnnotationItem(const DexFile::AnnotationItem* annotation, uint32_t offset);
@@ -328,6 +342,14 @@ class Collections {
   ParameterAnnotation* GenerateParameterAnnotation(const DexFile& dex_file, MethodId* method_id,
       const DexFile::AnnotationSetRefList* annotation_set_ref_list, uint32_t offset);
   MethodItem* GenerateMethodItem(const DexFile& dex_file, ClassDataItemIterator& cdii);
+  void AddStringId(const DexFile& dex_file, uint32_t i, StringData* string_data);
+  DebugInfoItem* CreateDebugInfoItem(const DexFile& dex_file,
+                                     const DexFile::CodeItem& disk_code_item);
+  // Build a code item without adding it to the collection. Only reads the id tables, so code
+  // items can be built concurrently.
+  CodeItem* BuildCodeItem(const DexFile& dex_file,
+                          const DexFile::CodeItem& disk_code_item,
+                          DebugInfoItem* debug_info);
 
   CollectionVector<StringId> string_ids_;
   CollectionVector<TypeId> type_ids_;
@@ -623,6 +645,7 @@ class MethodItem : public Item {
   uint32_t GetAccessFlags() const { return access_flags_; }
   const MethodId* GetMethodId() const { return method_id_; }
   CodeItem* GetCodeItem() { return code_; }
+  void SetCodeItem(CodeItem* code) { code_ = code; }
 
   void Accept(AbstractDispatcher* dispatch) { dispatch->Dispatch(this); }
 
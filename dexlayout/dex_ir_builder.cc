@@ -21,12 +21,20 @@
 
 #include "dex_ir_builder.h"
 
+#include "base/timing_logger.h"
+
 namespace art {
 namespace dex_ir {
 
 static void CheckAndSetRemainingOffsets(const DexFile& dex_file, Collections* collections);
 
 Header* DexIrBuilder(const DexFile& dex_file) {
+  TimingLogger timings("DexIrBuilder", /* precise */ false, /* verbose */ false);
+  return DexIrBuilder(dex_file, /* thread_count */ 1u, &timings);
+}
+
+Header* DexIrBuilder(const DexFile& dex_file, size_t thread_count, TimingLogger* timings) {
+  TimingLogger::ScopedTiming t("StringIds", timings);
   const DexFile::Header& disk_header = dex_file.GetHeader();
   Header* header = new Header(disk_header.magic_,
                               disk_header.checksum_,
@@ -42,9 +50,8 @@ Header* DexIrBuilder(const DexFile& dex_file) {
   // Walk the rest of the header fields.
   // StringId table.
   collections.SetStringIdsOffset(disk_header.string_ids_off_);
-  for (uint32_t i = 0; i < dex_file.NumStringIds(); ++i) {
-    collections.CreateStringId(dex_file, i);
-  }
+  collections.CreateStringIds(dex_file, thread_count);
+  t.NewTiming("Ids");
   // TypeId table.
   collections.SetTypeIdsOffset(disk_header.type_ids_off_);
   for (uint32_t i = 0; i < dex_file.NumTypeIds(); ++i) {
@@ -65,7 +72,11 @@ Header* DexIrBuilder(const DexFile& dex_file) {
   for (uint32_t i = 0; i < dex_file.NumMethodIds(); ++i) {
     collections.CreateMethodId(dex_file, i);
   }
+  // Code items, which the class data of the class defs refers to.
+  t.NewTiming("CodeItems");
+  collections.CreateCodeItems(dex_file, thread_count);
   // ClassDef table.
+  t.NewTiming("ClassDefs");
   collections.SetClassDefsOffset(disk_header.class_defs_off_);
   for (uint32_t i = 0; i < dex_file.NumClassDefs(); ++i) {
     collections.CreateClassDef(dex_file, i);
@@ -22,9 +22,14 @@
 #include "dex_ir.h"
 
 namespace art {
+
+class TimingLogger;
+
 namespace dex_ir {
 
 dex_ir::Header* DexIrBuilder(const DexFile& dex_file);
+// Build the IR with up to `thread_count` threads and record the time of each phase in `timings`.
+dex_ir::Header* DexIrBuilder(const DexFile& dex_file, size_t thread_count, TimingLogger* timings);
 
 }  // namespace dex_ir
 }  // namespace art
@@ -18,6 +18,7 @@
 
 #include <stdint.h>
 
+#include <algorithm>
 #include <queue>
 #include <vector>
 
@@ -242,18 +243,176 @@ size_t DexWriter::WriteEncodedMethods(dex_ir::MethodItemVector* methods, size_t
   return offset - original_offset;
 }
 
-void DexWriter::WriteStrings() {
+size_t DexWriter::WriteStringData(dex_ir::StringData* string_data, size_t offset) {
+  size_t original_offset = offset;
+  offset += WriteUleb128(CountModifiedUtf8Chars(string_data->Data()), offset);
+  // Include the null terminator.
+  offset += Write(string_data->Data(), strlen(string_data->Data()) + 1, offset);
+  return offset - original_offset;
+}
+
+size_t DexWriter::WriteTypeList(dex_ir::TypeList* type_list, size_t offset) {
+  size_t original_offset = offset;
+  uint32_t size[1] = { static_cast<uint32_t>(type_list->GetTypeList()->size()) };
+  uint16_t list[1];
+  offset += Write(size, sizeof(uint32_t), offset);
+  for (const dex_ir::TypeId* type_id : *type_list->GetTypeList()) {
+    list[0] = type_id->GetIndex();
+    offset += Write(list, sizeof(uint16_t), offset);
+  }
+  return offset - original_offset;
+}
+
+size_t DexWriter::WriteAnnotation(dex_ir::AnnotationItem* annotation, size_t offset) {
+  size_t original_offset = offset;
+  uint8_t visibility[1] = { annotation->GetVisibility() };
+  offset += Write(visibility, sizeof(uint8_t), offset);
+  offset += WriteEncodedAnnotation(annotation->GetAnnotation(), offset);
+  return offset - original_offset;
+}
+
+size_t DexWriter::WriteAnnotationSet(dex_ir::AnnotationSetItem* annotation_set, size_t offset) {
+  size_t original_offset = offset;
+  uint32_t size[1] = { static_cast<uint32_t>(annotation_set->GetItems()->size()) };
+  uint32_t annotation_off[1];
+  offset += Write(size, sizeof(uint32_t), offset);
+  for (dex_ir::AnnotationItem* annotation : *annotation_set->GetItems()) {
+    annotation_off[0] = annotation->GetOffset();
+    offset += Write(annotation_off, sizeof(uint32_t), offset);
+  }
+  return offset - original_offset;
+}
+
+size_t DexWriter::WriteAnnotationSetRef(dex_ir::AnnotationSetRefList* annotation_set_ref,
+                                        size_t offset) {
+  size_t original_offset = offset;
+  uint32_t size[1] = { static_cast<uint32_t>(annotation_set_ref->GetItems()->size()) };
+  uint32_t annotations_off[1];
+  offset += Write(size, sizeof(uint32_t), offset);
+  for (dex_ir::AnnotationSetItem* annotation_set : *annotation_set_ref->GetItems()) {
+    annotations_off[0] = annotation_set == nullptr ? 0 : annotation_set->GetOffset();
+    offset += Write(annotations_off, sizeof(uint32_t), offset);
+  }
+  return offset - original_offset;
+}
+
+size_t DexWriter::WriteAnnotationsDirectory(
+    dex_ir::AnnotationsDirectoryItem* annotations_directory, size_t offset) {
+  size_t original_offset = offset;
+  uint32_t directory_buffer[4];
+  uint32_t annotation_buffer[2];
+  directory_buffer[0] = annotations_directory->GetClassAnnotation() == nullptr ? 0 :
+      annotations_directory->GetClassAnnotation()->GetOffset();
+  directory_buffer[1] = annotations_directory->GetFieldAnnotations() == nullptr ? 0 :
+      annotations_directory->GetFieldAnnotations()->size();
+  directory_buffer[2] = annotations_directory->GetMethodAnnotations() == nullptr ? 0 :
+      annotations_directory->GetMethodAnnotations()->size();
+  directory_buffer[3] = annotations_directory->GetParameterAnnotations() == nullptr ? 0 :
+      annotations_directory->GetParameterAnnotations()->size();
+  offset += Write(directory_buffer, 4 * sizeof(uint32_t), offset);
+  if (annotations_directory->GetFieldAnnotations() != nullptr) {
+    for (std::unique_ptr<dex_ir::FieldAnnotation>& field :
+        *annotations_directory->GetFieldAnnotations()) {
+      annotation_buffer[0] = field->GetFieldId()->GetIndex();
+      annotation_buffer[1] = field->GetAnnotationSetItem()->GetOffset();
+      offset += Write(annotation_buffer, 2 * sizeof(uint32_t), offset);
+    }
+  }
+  if (annotations_directory->GetMethodAnnotations() != nullptr) {
+    for (std::unique_ptr<dex_ir::MethodAnnotation>& method :
+        *annotations_directory->GetMethodAnnotations()) {
+      annotation_buffer[0] = method->GetMethodId()->GetIndex();
+      annotation_buffer[1] = method->GetAnnotationSetItem()->GetOffset();
+      offset += Write(annotation_buffer, 2 * sizeof(uint32_t), offset);
+    }
+  }
+  if (annotations_directory->GetParameterAnnotations() != nullptr) {
+    for (std::unique_ptr<dex_ir::ParameterAnnotation>& parameter :
+        *annotations_directory->GetParameterAnnotations()) {
+      annotation_buffer[0] = parameter->GetMethodId()->GetIndex();
+      annotation_buffer[1] = parameter->GetAnnotations()->GetOffset();
+      offset += Write(annotation_buffer, 2 * sizeof(uint32_t), offset);
+    }
+  }
+  return offset - original_offset;
+}
+
+size_t DexWriter::WriteDebugInfoItem(dex_ir::DebugInfoItem* debug_info, size_t offset) {
+  return Write(debug_info->GetDebugInfo(), debug_info->GetDebugInfoSize(), offset);
+}
+
+size_t DexWriter::WriteCodeItem(dex_ir::CodeItem* code_item, size_t offset) {
+  size_t original_offset = offset;
+  uint16_t uint16_buffer[4];
+  uint32_t uint32_buffer[2];
+  uint16_buffer[0] = code_item->RegistersSize();
+  uint16_buffer[1] = code_item->InsSize();
+  uint16_buffer[2] = code_item->OutsSize();
+  uint16_buffer[3] = code_item->TriesSize();
+  uint32_buffer[0] = code_item->DebugInfo() == nullptr ? 0 : code_item->DebugInfo()->GetOffset();
+  uint32_buffer[1] = code_item->InsnsSize();
+  offset += Write(uint16_buffer, 4 * sizeof(uint16_t), offset);
+  offset += Write(uint32_buffer, 2 * sizeof(uint32_t), offset);
+  offset += Write(code_item->Insns(), code_item->InsnsSize() * sizeof(uint16_t), offset);
+  size_t end = offset;
+  if (code_item->TriesSize() != 0) {
+    if (code_item->InsnsSize() % 2 != 0) {
+      uint16_t padding[1] = { 0 };
+      offset += Write(padding, sizeof(uint16_t), offset);
+    }
+    uint32_t start_addr[1];
+    uint16_t insn_count_and_handler_off[2];
+    for (std::unique_ptr<const dex_ir::TryItem>& try_item : *code_item->Tries()) {
+      start_addr[0] = try_item->StartAddr();
+      insn_count_and_handler_off[0] = try_item->InsnCount();
+      insn_count_and_handler_off[1] = try_item->GetHandlers()->GetListOffset();
+      offset += Write(start_addr, sizeof(uint32_t), offset);
+      offset += Write(insn_count_and_handler_off, 2 * sizeof(uint16_t), offset);
+    }
+    // Leave offset pointing to the end of the try items.
+    end = offset + WriteUleb128(code_item->Handlers()->size(), offset);
+    for (std::unique_ptr<const dex_ir::CatchHandler>& handlers : *code_item->Handlers()) {
+      size_t list_offset = offset + handlers->GetListOffset();
+      uint32_t size = handlers->HasCatchAll() ? (handlers->GetHandlers()->size() - 1) * -1 :
+          handlers->GetHandlers()->size();
+      list_offset += WriteSleb128(size, list_offset);
+      for (std::unique_ptr<const dex_ir::TypeAddrPair>& handler : *handlers->GetHandlers()) {
+        if (handler->GetTypeId() != nullptr) {
+          list_offset += WriteUleb128(handler->GetTypeId()->GetIndex(), list_offset);
+        }
+        list_offset += WriteUleb128(handler->GetAddress(), list_offset);
+      }
+      end = std::max(end, list_offset);
+    }
+  }
+  return end - original_offset;
+}
+
+size_t DexWriter::WriteClassData(dex_ir::ClassData* class_data, size_t offset) {
+  size_t original_offset = offset;
+  offset += WriteUleb128(class_data->StaticFields()->size(), offset);
+  offset += WriteUleb128(class_data->InstanceFields()->size(), offset);
+  offset += WriteUleb128(class_data->DirectMethods()->size(), offset);
+  offset += WriteUleb128(class_data->VirtualMethods()->size(), offset);
+  offset += WriteEncodedFields(class_data->StaticFields(), offset);
+  offset += WriteEncodedFields(class_data->InstanceFields(), offset);
+  offset += WriteEncodedMethods(class_data->DirectMethods(), offset);
+  offset += WriteEncodedMethods(class_data->VirtualMethods(), offset);
+  return offset - original_offset;
+}
+
+void DexWriter::WriteStringIds() {
   uint32_t string_data_off[1];
   for (std::unique_ptr<dex_ir::StringId>& string_id : header_->GetCollections().StringIds()) {
     string_data_off[0] = string_id->DataItem()->GetOffset();
     Write(string_data_off, string_id->GetSize(), string_id->GetOffset());
   }
+}
 
+void DexWriter::WriteStringDatas() {
   for (auto& string_data_pair : header_->GetCollections().StringDatas()) {
     std::unique_ptr<dex_ir::StringData>& string_data = string_data_pair.second;
-    uint32_t offset = string_data->GetOffset();
-    offset += WriteUleb128(CountModifiedUtf8Chars(string_data->Data()), offset);
-    Write(string_data->Data(), strlen(string_data->Data()), offset);
+    WriteStringData(string_data.get(), string_data->GetOffset());
   }
 }
 
@@ -266,17 +425,9 @@ void DexWriter::WriteTypes() {
 }
 
 void DexWriter::WriteTypeLists() {
-  uint32_t size[1];
-  uint16_t list[1];
   for (auto& type_list_pair : header_->GetCollections().TypeLists()) {
     std::unique_ptr<dex_ir::TypeList>& type_list = type_list_pair.second;
-    size[0] = type_list->GetTypeList()->size();
-    uint32_t offset = type_list->GetOffset();
-    offset += Write(size, sizeof(uint32_t), offset);
-    for (const dex_ir::TypeId* type_id : *type_list->GetTypeList()) {
-      list[0] = type_id->GetIndex();
-      offset += Write(list, sizeof(uint16_t), offset);
-    }
+    WriteTypeList(type_list.get(), type_list->GetOffset());
   }
 }
 
@@ -320,144 +471,49 @@ void DexWriter::WriteEncodedArrays() {
 }
 
 void DexWriter::WriteAnnotations() {
-  uint8_t visibility[1];
   for (auto& annotation_pair : header_->GetCollections().AnnotationItems()) {
     std::unique_ptr<dex_ir::AnnotationItem>& annotation = annotation_pair.second;
-    visibility[0] = annotation->GetVisibility();
-    size_t offset = annotation->GetOffset();
-    offset += Write(visibility, sizeof(uint8_t), offset);
-    WriteEncodedAnnotation(annotation->GetAnnotation(), offset);
+    WriteAnnotation(annotation.get(), annotation->GetOffset());
   }
 }
 
 void DexWriter::WriteAnnotationSets() {
-  uint32_t size[1];
-  uint32_t annotation_off[1];
   for (auto& annotation_set_pair : header_->GetCollections().AnnotationSetItems()) {
     std::unique_ptr<dex_ir::AnnotationSetItem>& annotation_set = annotation_set_pair.second;
-    size[0] = annotation_set->GetItems()->size();
-    size_t offset = annotation_set->GetOffset();
-    offset += Write(size, sizeof(uint32_t), offset);
-    for (dex_ir::AnnotationItem* annotation : *annotation_set->GetItems()) {
-      annotation_off[0] = annotation->GetOffset();
-      offset += Write(annotation_off, sizeof(uint32_t), offset);
-    }
+    WriteAnnotationSet(annotation_set.get(), annotation_set->GetOffset());
   }
 }
 
 void DexWriter::WriteAnnotationSetRefs() {
-  uint32_t size[1];
-  uint32_t annotations_off[1];
   for (auto& anno_set_ref_pair : header_->GetCollections().AnnotationSetRefLists()) {
     std::unique_ptr<dex_ir::AnnotationSetRefList>& annotation_set_ref = anno_set_ref_pair.second;
-    size[0] = annotation_set_ref->GetItems()->size();
-    size_t offset = annotation_set_ref->GetOffset();
-    offset += Write(size, sizeof(uint32_t), offset);
-    for (dex_ir::AnnotationSetItem* annotation_set : *annotation_set_ref->GetItems()) {
-      annotations_off[0] = annotation_set == nullptr ? 0 : annotation_set->GetOffset();
-      offset += Write(annotations_off, sizeof(uint32_t), offset);
-    }
+    WriteAnnotationSetRef(annotation_set_ref.get(), annotation_set_ref->GetOffset());
   }
 }
 
 void DexWriter::WriteAnnotationsDirectories() {
-  uint32_t directory_buffer[4];
-  uint32_t annotation_buffer[2];
   for (auto& annotations_directory_pair : header_->GetCollections().AnnotationsDirectoryItems()) {
     std::unique_ptr<dex_ir::AnnotationsDirectoryItem>& annotations_directory =
         annotations_directory_pair.second;
-    directory_buffer[0] = annotations_directory->GetClassAnnotation() == nullptr ? 0 :
-        annotations_directory->GetClassAnnotation()->GetOffset();
-    directory_buffer[1] = annotations_directory->GetFieldAnnotations() == nullptr ? 0 :
-        annotations_directory->GetFieldAnnotations()->size();
-    directory_buffer[2] = annotations_directory->GetMethodAnnotations() == nullptr ? 0 :
-        annotations_directory->GetMethodAnnotations()->size();
-    directory_buffer[3] = annotations_directory->GetParameterAnnotations() == nullptr ? 0 :
-        annotations_directory->GetParameterAnnotations()->size();
-    uint32_t offset = annotations_directory->GetOffset();
-    offset += Write(directory_buffer, 4 * sizeof(uint32_t), offset);
-    if (annotations_directory->GetFieldAnnotations() != nullptr) {
-      for (std::unique_ptr<dex_ir::FieldAnnotation>& field :
-          *annotations_directory->GetFieldAnnotations()) {
-        annotation_buffer[0] = field->GetFieldId()->GetIndex();
-        annotation_buffer[1] = field->GetAnnotationSetItem()->GetOffset();
-        offset += Write(annotation_buffer, 2 * sizeof(uint32_t), offset);
-      }
-    }
-    if (annotations_directory->GetMethodAnnotations() != nullptr) {
-      for (std::unique_ptr<dex_ir::MethodAnnotation>& method :
-          *annotations_directory->GetMethodAnnotations()) {
-        annotation_buffer[0] = method->GetMethodId()->GetIndex();
-        annotation_buffer[1] = method->GetAnnotationSetItem()->GetOffset();
-        offset += Write(annotation_buffer, 2 * sizeof(uint32_t), offset);
-      }
-    }
-    if (annotations_directory->GetParameterAnnotations() != nullptr) {
-      for (std::unique_ptr<dex_ir::ParameterAnnotation>& parameter :
-          *annotations_directory->GetParameterAnnotations()) {
-        annotation_buffer[0] = parameter->GetMethodId()->GetIndex();
-        annotation_buffer[1] = parameter->GetAnnotations()->GetOffset();
-        offset += Write(annotation_buffer, 2 * sizeof(uint32_t), offset);
-      }
-    }
+    WriteAnnotationsDirectory(annotations_directory.get(), annotations_directory->GetOffset());
   }
 }
 
 void DexWriter::WriteDebugInfoItems() {
   for (auto& debug_info_pair : header_->GetCollections().DebugInfoItems()) {
     std::unique_ptr<dex_ir::DebugInfoItem>& debug_info = debug_info_pair.second;
-    Write(debug_info->GetDebugInfo(), debug_info->GetDebugInfoSize(), debug_info->GetOffset());
+    WriteDebugInfoItem(debug_info.get(), debug_info->GetOffset());
   }
 }
 
 void DexWriter::WriteCodeItems() {
-  uint16_t uint16_buffer[4];
-  uint32_t uint32_buffer[2];
   for (auto& code_item_pair : header_->GetCollections().CodeItems()) {
     std::unique_ptr<dex_ir::CodeItem>& code_item = code_item_pair.second;
-    uint16_buffer[0] = code_item->RegistersSize();
-    uint16_buffer[1] = code_item->InsSize();
-    uint16_buffer[2] = code_item->OutsSize();
-    uint16_buffer[3] = code_item->TriesSize();
-    uint32_buffer[0] = code_item->DebugInfo() == nullptr ? 0 : code_item->DebugInfo()->GetOffset();
-    uint32_buffer[1] = code_item->InsnsSize();
-    size_t offset = code_item->GetOffset();
-    offset += Write(uint16_buffer, 4 * sizeof(uint16_t), offset);
-    offset += Write(uint32_buffer, 2 * sizeof(uint32_t), offset);
-    offset += Write(code_item->Insns(), code_item->InsnsSize() * sizeof(uint16_t), offset);
-    if (code_item->TriesSize() != 0) {
-      if (code_item->InsnsSize() % 2 != 0) {
-        uint16_t padding[1] = { 0 };
-        offset += Write(padding, sizeof(uint16_t), offset);
-      }
-      uint32_t start_addr[1];
-      uint16_t insn_count_and_handler_off[2];
-      for (std::unique_ptr<const dex_ir::TryItem>& try_item : *code_item->Tries()) {
-        start_addr[0] = try_item->StartAddr();
-        insn_count_and_handler_off[0] = try_item->InsnCount();
-        insn_count_and_handler_off[1] = try_item->GetHandlers()->GetListOffset();
-        offset += Write(start_addr, sizeof(uint32_t), offset);
-        offset += Write(insn_count_and_handler_off, 2 * sizeof(uint16_t), offset);
-      }
-      // Leave offset pointing to the end of the try items.
-      WriteUleb128(code_item->Handlers()->size(), offset);
-      for (std::unique_ptr<const dex_ir::CatchHandler>& handlers : *code_item->Handlers()) {
-        size_t list_offset = offset + handlers->GetListOffset();
-        uint32_t size = handlers->HasCatchAll() ? (handlers->GetHandlers()->size() - 1) * -1 :
-            handlers->GetHandlers()->size();
-        list_offset += WriteSleb128(size, list_offset);
-        for (std::unique_ptr<const dex_ir::TypeAddrPair>& handler : *handlers->GetHandlers()) {
-          if (handler->GetTypeId() != nullptr) {
-            list_offset += WriteUleb128(handler->GetTypeId()->GetIndex(), list_offset);
-          }
-          list_offset += WriteUleb128(handler->GetAddress(), list_offset);
-        }
-      }
-    }
+    WriteCodeItem(code_item.get(), code_item->GetOffset());
   }
 }
 
-void DexWriter::WriteClasses() {
+void DexWriter::WriteClassDefs() {
   uint32_t class_def_buffer[8];
   for (std::unique_ptr<dex_ir::ClassDef>& class_def : header_->GetCollections().ClassDefs()) {
     class_def_buffer[0] = class_def->ClassType()->GetIndex();
@@ -476,18 +532,12 @@ void DexWriter::WriteClasses() {
     size_t offset = class_def->GetOffset();
     Write(class_def_buffer, class_def->GetSize(), offset);
   }
+}
 
+void DexWriter::WriteClassDatas() {
   for (auto& class_data_pair : header_->GetCollections().ClassDatas()) {
     std::unique_ptr<dex_ir::ClassData>& class_data = class_data_pair.second;
-    size_t offset = class_data->GetOffset();
-    offset += WriteUleb128(class_data->StaticFields()->size(), offset);
-    offset += WriteUleb128(class_data->InstanceFields()->size(), offset);
-    offset += WriteUleb128(class_data->DirectMethods()->size(), offset);
-    offset += WriteUleb128(class_data->VirtualMethods()->size(), offset);
-    offset += WriteEncodedFields(class_data->StaticFields(), offset);
-    offset += WriteEncodedFields(class_data->InstanceFields(), offset);
-    offset += WriteEncodedMethods(class_data->DirectMethods(), offset);
-    offset += WriteEncodedMethods(class_data->VirtualMethods(), offset);
+    WriteClassData(class_data.get(), class_data->GetOffset());
   }
 }
 
@@ -525,7 +575,7 @@ struct MapItemContainer {
   uint32_t offset_;
 };
 
-void DexWriter::WriteMapItem() {
+void DexWriter::WriteMapItem(bool include_data_sections) {
   dex_ir::Collections& collection = header_->GetCollections();
   std::priority_queue<MapItemContainer> queue;
 
@@ -566,45 +616,49 @@ void DexWriter::WriteMapItem() {
 
   // Data section.
   queue.push(MapItemContainer(DexFile::kDexTypeMapList, 1, collection.MapListOffset()));
-  if (collection.TypeListsSize() != 0) {
-    queue.push(MapItemContainer(DexFile::kDexTypeTypeList, collection.TypeListsSize(),
-        collection.TypeListsOffset()));
-  }
-  if (collection.AnnotationSetRefListsSize() != 0) {
-    queue.push(MapItemContainer(DexFile::kDexTypeAnnotationSetRefList,
-        collection.AnnotationSetRefListsSize(), collection.AnnotationSetRefListsOffset()));
-  }
-  if (collection.AnnotationSetItemsSize() != 0) {
-    queue.push(MapItemContainer(DexFile::kDexTypeAnnotationSetItem,
-        collection.AnnotationSetItemsSize(), collection.AnnotationSetItemsOffset()));
-  }
-  if (collection.ClassDatasSize() != 0) {
-    queue.push(MapItemContainer(DexFile::kDexTypeClassDataItem, collection.ClassDatasSize(),
-        collection.ClassDatasOffset()));
-  }
-  if (collection.CodeItemsSize() != 0) {
-    queue.push(MapItemContainer(DexFile::kDexTypeCodeItem, collection.CodeItemsSize(),
-        collection.CodeItemsOffset()));
-  }
-  if (collection.StringDatasSize() != 0) {
-    queue.push(MapItemContainer(DexFile::kDexTypeStringDataItem, collection.StringDatasSize(),
-        collection.StringDatasOffset()));
-  }
-  if (collection.DebugInfoItemsSize() != 0) {
-    queue.push(MapItemContainer(DexFile::kDexTypeDebugInfoItem, collection.DebugInfoItemsSize(),
-        collection.DebugInfoItemsOffset()));
-  }
-  if (collection.AnnotationItemsSize() != 0) {
-    queue.push(MapItemContainer(DexFile::kDexTypeAnnotationItem, collection.AnnotationItemsSize(),
-        collection.AnnotationItemsOffset()));
-  }
-  if (collection.EncodedArrayItemsSize() != 0) {
-    queue.push(MapItemContainer(DexFile::kDexTypeEncodedArrayItem,
-        collection.EncodedArrayItemsSize(), collection.EncodedArrayItemsOffset()));
-  }
-  if (collection.AnnotationsDirectoryItemsSize() != 0) {
-    queue.push(MapItemContainer(DexFile::kDexTypeAnnotationsDirectoryItem,
-        collection.AnnotationsDirectoryItemsSize(), collection.AnnotationsDirectoryItemsOffset()));
+  // The data items of compact dex files are in the shared data section.
+  if (include_data_sections) {
+    if (collection.TypeListsSize() != 0) {
+      queue.push(MapItemContainer(DexFile::kDexTypeTypeList, collection.TypeListsSize(),
+          collection.TypeListsOffset()));
+    }
+    if (collection.AnnotationSetRefListsSize() != 0) {
+      queue.push(MapItemContainer(DexFile::kDexTypeAnnotationSetRefList,
+          collection.AnnotationSetRefListsSize(), collection.AnnotationSetRefListsOffset()));
+    }
+    if (collection.AnnotationSetItemsSize() != 0) {
+      queue.push(MapItemContainer(DexFile::kDexTypeAnnotationSetItem,
+          collection.AnnotationSetItemsSize(), collection.AnnotationSetItemsOffset()));
+    }
+    if (collection.ClassDatasSize() != 0) {
+      queue.push(MapItemContainer(DexFile::kDexTypeClassDataItem, collection.ClassDatasSize(),
+          collection.ClassDatasOffset()));
+    }
+    if (collection.CodeItemsSize() != 0) {
+      queue.push(MapItemContainer(DexFile::kDexTypeCodeItem, collection.CodeItemsSize(),
+          collection.CodeItemsOffset()));
+    }
+    if (collection.StringDatasSize() != 0) {
+      queue.push(MapItemContainer(DexFile::kDexTypeStringDataItem, collection.StringDatasSize(),
+          collection.StringDatasOffset()));
+    }
+    if (collection.DebugInfoItemsSize() != 0) {
+      queue.push(MapItemContainer(DexFile::kDexTypeDebugInfoItem, collection.DebugInfoItemsSize(),
+          collection.DebugInfoItemsOffset()));
+    }
+    if (collection.AnnotationItemsSize() != 0) {
+      queue.push(MapItemContainer(DexFile::kDexTypeAnnotationItem, collection.AnnotationItemsSize(),
+          collection.AnnotationItemsOffset()));
+    }
+    if (collection.EncodedArrayItemsSize() != 0) {
+      queue.push(MapItemContainer(DexFile::kDexTypeEncodedArrayItem,
+          collection.EncodedArrayItemsSize(), collection.EncodedArrayItemsOffset()));
+    }
+    if (collection.AnnotationsDirectoryItemsSize() != 0) {
+      queue.push(MapItemContainer(DexFile::kDexTypeAnnotationsDirectoryItem,
+          collection.AnnotationsDirectoryItemsSize(),
+          collection.AnnotationsDirectoryItemsOffset()));
+    }
   }
 
   uint32_t offset = collection.MapListOffset();
@@ -658,30 +712,43 @@ void DexWriter::WriteHeader() {
   Write(buffer, 20 * sizeof(uint32_t), offset);
 }
 
-void DexWriter::WriteMemMap() {
-  WriteStrings();
-  WriteTypes();
-  WriteTypeLists();
-  WriteProtos();
-  WriteFields();
-  WriteMethods();
-  WriteEncodedArrays();
-  WriteAnnotations();
-  WriteAnnotationSets();
-  WriteAnnotationSetRefs();
-  WriteAnnotationsDirectories();
-  WriteDebugInfoItems();
-  WriteCodeItems();
-  WriteClasses();
-  WriteCallSites();
-  WriteMethodHandles();
-  WriteMapItem();
+void DexWriter::WriteMemMap(size_t thread_count) {
+  // The sections do not overlap and every writer only reads the IR, so they can be written in
+  // any order. Code items and class data are the largest sections and start first.
+  static constexpr void (DexWriter::*kSectionWriters[])() = {
+    &DexWriter::WriteCodeItems,
+    &DexWriter::WriteClassDatas,
+    &DexWriter::WriteClassDefs,
+    &DexWriter::WriteStringDatas,
+    &DexWriter::WriteStringIds,
+    &DexWriter::WriteDebugInfoItems,
+    &DexWriter::WriteTypes,
+    &DexWriter::WriteTypeLists,
+    &DexWriter::WriteProtos,
+    &DexWriter::WriteFields,
+    &DexWriter::WriteMethods,
+    &DexWriter::WriteEncodedArrays,
+    &DexWriter::WriteAnnotations,
+    &DexWriter::WriteAnnotationSets,
+    &DexWriter::WriteAnnotationSetRefs,
+    &DexWriter::WriteAnnotationsDirectories,
+    &DexWriter::WriteCallSites,
+    &DexWriter::WriteMethodHandles,
+  };
+  dex_ir::ParallelFor(arraysize(kSectionWriters), thread_count, [&](size_t i) {
+    (this->*kSectionWriters[i])();
+  });
+  WriteMapItem(/* include_data_sections */ true);
   WriteHeader();
 }
 
 void DexWriter::Output(dex_ir::Header* header, MemMap* mem_map) {
+  Output(header, mem_map, /* thread_count */ 1u);
+}
+
+void DexWriter::Output(dex_ir::Header* header, MemMap* mem_map, size_t thread_count) {
   DexWriter dex_writer(header, mem_map);
-  dex_writer.WriteMemMap();
+  dex_writer.WriteMemMap(thread_count);
 }
 
 }  // namespace art
@@ -29,13 +29,17 @@ namespace art {
 class DexWriter {
  public:
   DexWriter(dex_ir::Header* header, MemMap* mem_map) : header_(header), mem_map_(mem_map) { }
+  virtual ~DexWriter() { }
 
   static void Output(dex_ir::Header* header, MemMap* mem_map);
+  // Write the sections on up to `thread_count` threads. Every item has its offset assigned
+  // already, so the sections are written concurrently; the map list and header come last.
+  static void Output(dex_ir::Header* header, MemMap* mem_map, size_t thread_count);
 
- private:
-  void WriteMemMap();
+ protected:
+  void WriteMemMap(size_t thread_count);
 
-  size_t Write(const void* buffer, size_t length, size_t offset);
+  virtual size_t Write(const void* buffer, size_t length, size_t offset);
   size_t WriteSleb128(uint32_t value, size_t offset);
   size_t WriteUleb128(uint32_t value, size_t offset);
   size_t WriteEncodedValue(dex_ir::EncodedValue* encoded_value, size_t offset);
@@ -45,7 +49,20 @@ class DexWriter {
   size_t WriteEncodedFields(dex_ir::FieldItemVector* fields, size_t offset);
   size_t WriteEncodedMethods(dex_ir::MethodItemVector* methods, size_t offset);
 
-  void WriteStrings();
+  // Write a single data item at `offset`, returning its size.
+  size_t WriteStringData(dex_ir::StringData* string_data, size_t offset);
+  size_t WriteTypeList(dex_ir::TypeList* type_list, size_t offset);
+  size_t WriteAnnotation(dex_ir::AnnotationItem* annotation, size_t offset);
+  size_t WriteAnnotationSet(dex_ir::AnnotationSetItem* annotation_set, size_t offset);
+  size_t WriteAnnotationSetRef(dex_ir::AnnotationSetRefList* annotation_set_ref, size_t offset);
+  size_t WriteAnnotationsDirectory(dex_ir::AnnotationsDirectoryItem* annotations_directory,
+                                   size_t offset);
+  size_t WriteDebugInfoItem(dex_ir::DebugInfoItem* debug_info, size_t offset);
+  size_t WriteCodeItem(dex_ir::CodeItem* code_item, size_t offset);
+  size_t WriteClassData(dex_ir::ClassData* class_data, size_t offset);
+
+  void WriteStringIds();
+  void WriteStringDatas();
   void WriteTypes();
   void WriteTypeLists();
   void WriteProtos();
@@ -58,15 +75,17 @@ class DexWriter {
   void WriteAnnotationsDirectories();
   void WriteDebugInfoItems();
   void WriteCodeItems();
-  void WriteClasses();
+  void WriteClassDefs();
+  void WriteClassDatas();
   void WriteCallSites();
   void WriteMethodHandles();
-  void WriteMapItem();
+  void WriteMapItem(bool include_data_sections);
   void WriteHeader();
 
   dex_ir::Header* const header_;
   MemMap* const mem_map_;
 
+ private:
   DISALLOW_COPY_AND_ASSIGN(DexWriter);
 };
 
@@ -28,11 +28,16 @@
 
 #include <iostream>
 #include <memory>
+#include <set>
 #include <sstream>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "android-base/stringprintf.h"
+#include "base/timing_logger.h"
 
+#include "compact_dex_writer.h"
 #include "dex_ir_builder.h"
 #include "dex_file-inl.h"
 #include "dex_file_layout.h"
@@ -1653,9 +1658,104 @@ void DexLayout::LayoutStringData(const DexFile* dex_file) {
   }
 }
 
-// Orders code items according to specified class data ordering.
-// NOTE: If the section following the code items is byte aligned, the last code item is left in
-// place to preserve alignment. Layout needs an overhaul to handle movement of other sections.
+// Returns how much code of the given layout type is used, to pick the layout type of code items
+// shared between methods.
+static size_t GetLayoutTypeUsage(LayoutType type) {
+  switch (type) {
+    case LayoutType::kLayoutTypeHot: return 4u;
+    case LayoutType::kLayoutTypeStartupOnly: return 3u;
+    case LayoutType::kLayoutTypeSometimesUsed: return 2u;
+    case LayoutType::kLayoutTypeUsedOnce: return 1u;
+    default: return 0u;
+  }
+}
+
+// Returns whether the code item may be shared between methods. Quickening rewrites these
+// instructions in place for the method being compiled and records per-method data to undo it,
+// so code items containing them stay owned by a single method. Constructors, which may have
+// their return-void quickened, are excluded by the caller.
+static bool CanShareCodeItem(const dex_ir::CodeItem* code_item) {
+  const uint16_t* insns = code_item->Insns();
+  for (uint32_t insn_idx = 0; insn_idx < code_item->InsnsSize();) {
+    const Instruction* instruction = Instruction::At(&insns[insn_idx]);
+    switch (instruction->Opcode()) {
+      case Instruction::CHECK_CAST:
+      case Instruction::IGET:
+      case Instruction::IGET_WIDE:
+      case Instruction::IGET_OBJECT:
+      case Instruction::IGET_BOOLEAN:
+      case Instruction::IGET_BYTE:
+      case Instruction::IGET_CHAR:
+      case Instruction::IGET_SHORT:
+      case Instruction::IPUT:
+      case Instruction::IPUT_WIDE:
+      case Instruction::IPUT_OBJECT:
+      case Instruction::IPUT_BOOLEAN:
+      case Instruction::IPUT_BYTE:
+      case Instruction::IPUT_CHAR:
+      case Instruction::IPUT_SHORT:
+      case Instruction::INVOKE_VIRTUAL:
+      case Instruction::INVOKE_VIRTUAL_RANGE:
+        return false;
+      default:
+        break;
+    }
+    const uint32_t insn_width = instruction->SizeInCodeUnits();
+    if (insn_width == 0) {
+      return false;
+    }
+    insn_idx += insn_width;
+  }
+  return true;
+}
+
+// Returns the bytes identifying the contents of a code item of `dex_file`, that is the code item
+// without its debug info offset, followed by the debug info. Locals in the debug info are typed
+// by the proto and, for `this`, the class of the method, so code items with debug info are only
+// shared between methods with the same proto in the same class.
+static std::string GetCodeItemKey(const DexFile* dex_file,
+                                  dex_ir::MethodItem* method,
+                                  dex_ir::CodeItem* code_item) {
+  const size_t debug_info_off_offset = OFFSETOF_MEMBER(DexFile::CodeItem, debug_info_off_);
+  const size_t insns_size_offset = debug_info_off_offset + sizeof(uint32_t);
+  const char* begin = reinterpret_cast<const char*>(dex_file->Begin() + code_item->GetOffset());
+  std::string key(begin, debug_info_off_offset);
+  key.append(begin + insns_size_offset, code_item->GetSize() - insns_size_offset);
+  const dex_ir::DebugInfoItem* debug_info = code_item->DebugInfo();
+  if (debug_info != nullptr) {
+    key.append(reinterpret_cast<const char*>(debug_info->GetDebugInfo()),
+               debug_info->GetDebugInfoSize());
+    const uint32_t indexes[] = {
+        method->GetMethodId()->Class()->GetIndex(),
+        method->GetMethodId()->Proto()->GetIndex(),
+        (method->GetAccessFlags() & kAccStatic) != 0 ? 1u : 0u,
+    };
+    key.append(reinterpret_cast<const char*>(indexes), sizeof(indexes));
+  }
+  return key;
+}
+
+// Returns the number of pages spanned by the code items of `code_items`.
+static size_t CountCodePages(const std::unordered_set<dex_ir::CodeItem*>& code_items) {
+  std::set<uint32_t> pages;
+  for (const dex_ir::CodeItem* code_item : code_items) {
+    const uint32_t end = code_item->GetOffset() + code_item->GetSize();
+    for (uint32_t page = code_item->GetOffset() / kPageSize;
+         page * kPageSize < end;
+         ++page) {
+      pages.insert(page);
+    }
+  }
+  return pages.size();
+}
+
+// Orders code items according to specified class data ordering, after sharing identical code
+// items between methods. Within each layout type the code items follow the class data order,
+// except that the hot code items used during startup come first, right after the startup only
+// ones, so that the code run during startup is on as few pages as possible.
+// NOTE: If the section following the code items is byte aligned, the last code item is kept at
+// the end of the section to preserve alignment. Layout needs an overhaul to handle movement of
+// other sections.
 int32_t DexLayout::LayoutCodeItems(const DexFile* dex_file,
                                    std::vector<dex_ir::ClassData*> new_class_data_order) {
   // Do not move code items if class data section precedes code item section.
@@ -1667,9 +1767,8 @@ int32_t DexLayout::LayoutCodeItems(const DexFile* dex_file,
     return 0;
   }
 
-  // Find the last code item so we can leave it in place if the next section is not 4 byte aligned.
+  // Find the last code item so we can keep it last if the next section is not 4 byte aligned.
   dex_ir::CodeItem* last_code_item = nullptr;
-  std::unordered_set<dex_ir::CodeItem*> visited_code_items;
   bool is_code_item_aligned = IsNextSectionCodeItemAligned(code_item_offset);
   if (!is_code_item_aligned) {
     for (auto& code_item_pair : header_->GetCollections().CodeItems()) {
@@ -1686,8 +1785,14 @@ int32_t DexLayout::LayoutCodeItems(const DexFile* dex_file,
     kVirtual
   };
 
-  const size_t num_layout_types = static_cast<size_t>(LayoutType::kLayoutTypeCount);
-  std::unordered_set<dex_ir::CodeItem*> code_items[num_layout_types];
+  // The code item offsets encoded in the class data, to compute how their size changes.
+  std::unordered_map<const dex_ir::MethodItem*, uint32_t> original_code_offsets;
+  // Each code item gets the layout type of its most used method.
+  std::unordered_map<dex_ir::CodeItem*, LayoutType> code_item_types;
+  // Code items of methods executed during startup.
+  std::unordered_set<dex_ir::CodeItem*> startup_code_items;
+  // Code items of constructors, which are never shared.
+  std::unordered_set<dex_ir::CodeItem*> constructor_code_items;
   for (InvokeType invoke_type : invoke_types) {
     for (std::unique_ptr<dex_ir::ClassDef>& class_def : header_->GetCollections().ClassDefs()) {
       const bool is_profile_class =
@@ -1703,7 +1808,14 @@ int32_t DexLayout::LayoutCodeItems(const DexFile* dex_file,
                                 : class_data->VirtualMethods())) {
         const dex_ir::MethodId *method_id = method->GetMethodId();
         dex_ir::CodeItem *code_item = method->GetCodeItem();
-        if (code_item == last_code_item || code_item == nullptr) {
+        if (code_item == nullptr) {
+          continue;
+        }
+        original_code_offsets.emplace(method.get(), code_item->GetOffset());
+        if ((method->GetAccessFlags() & kAccConstructor) != 0) {
+          constructor_code_items.insert(code_item);
+        }
+        if (code_item == last_code_item) {
           continue;
         }
         // Separate executed methods (clinits and profiled methods) from unexecuted methods.
@@ -1725,50 +1837,153 @@ int32_t DexLayout::LayoutCodeItems(const DexFile* dex_file,
         } else if (hotness.IsInProfile()) {
           state = LayoutType::kLayoutTypeSometimesUsed;
         }
-        code_items[static_cast<size_t>(state)].insert(code_item);
+        if (is_startup_clinit || hotness.IsStartup()) {
+          startup_code_items.insert(code_item);
+        }
+        auto it = code_item_types.emplace(code_item, state).first;
+        if (GetLayoutTypeUsage(state) > GetLayoutTypeUsage(it->second)) {
+          it->second = state;
+        }
       }
     }
   }
+  const size_t startup_pages_before = CountCodePages(startup_code_items);
 
-  // Total_diff includes diffs generated by clinits, executed, and non-executed methods.
-  int32_t total_diff = 0;
-  // The relative placement has no effect on correctness; it is used to ensure
-  // the layout is deterministic
+  // Share identical code items between methods and drop the duplicates, which shrinks the code
+  // item section.
+  std::unordered_map<std::string, dex_ir::CodeItem*> unique_code_items;
+  std::unordered_set<dex_ir::CodeItem*> duplicate_code_items;
+  uint32_t duplicate_bytes = 0;
+  for (dex_ir::ClassData* data : new_class_data_order) {
+    for (InvokeType invoke_type : invoke_types) {
+      for (auto& method : *(invoke_type == InvokeType::kDirect
+                                ? data->DirectMethods()
+                                : data->VirtualMethods())) {
+        dex_ir::CodeItem* code_item = method->GetCodeItem();
+        if (code_item == nullptr ||
+            code_item == last_code_item ||
+            constructor_code_items.find(code_item) != constructor_code_items.end() ||
+            !CanShareCodeItem(code_item)) {
+          continue;
+        }
+        dex_ir::CodeItem* unique_code_item = unique_code_items.emplace(
+            GetCodeItemKey(dex_file, method.get(), code_item), code_item).first->second;
+        if (unique_code_item == code_item) {
+          continue;
+        }
+        method->SetCodeItem(unique_code_item);
+        if (GetLayoutTypeUsage(code_item_types[code_item]) >
+            GetLayoutTypeUsage(code_item_types[unique_code_item])) {
+          code_item_types[unique_code_item] = code_item_types[code_item];
+        }
+        if (startup_code_items.find(code_item) != startup_code_items.end()) {
+          startup_code_items.insert(unique_code_item);
+        }
+        if (duplicate_code_items.insert(code_item).second) {
+          duplicate_bytes += RoundUp(code_item->GetSize(), kDexCodeItemAlignment);
+        }
+      }
+    }
+  }
+  // The methods using the duplicates have all been visited, so they are unreferenced now.
+  std::map<uint32_t, std::unique_ptr<dex_ir::CodeItem>>& code_item_map =
+      header_->GetCollections().CodeItems();
+  for (auto it = code_item_map.begin(); it != code_item_map.end();) {
+    dex_ir::CodeItem* code_item = it->second.get();
+    if (duplicate_code_items.find(code_item) != duplicate_code_items.end()) {
+      code_item_types.erase(code_item);
+      startup_code_items.erase(code_item);
+      it = code_item_map.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  // Lay out the code items by layout type, placing each one once even when shared.
+  const size_t num_layout_types = static_cast<size_t>(LayoutType::kLayoutTypeCount);
+  std::unordered_set<dex_ir::CodeItem*> placed_code_items;
+  size_t counts[num_layout_types] = {};
+  DexLayoutSection& code_section = dex_sections_.sections_[static_cast<size_t>(
+      DexLayoutSections::SectionType::kSectionTypeCode)];
   for (size_t index = 0; index < num_layout_types; ++index) {
-    const std::unordered_set<dex_ir::CodeItem*>& code_items_set = code_items[index];
-    // diff is reset for each class of code items.
-    int32_t diff = 0;
     const uint32_t start_offset = code_item_offset;
-    for (dex_ir::ClassData* data : new_class_data_order) {
-      data->SetOffset(data->GetOffset() + diff);
-      for (InvokeType invoke_type : invoke_types) {
-        for (auto &method : *(invoke_type == InvokeType::kDirect
-                                  ? data->DirectMethods()
-                                  : data->VirtualMethods())) {
-          dex_ir::CodeItem* code_item = method->GetCodeItem();
-          if (code_item != nullptr &&
-              code_items_set.find(code_item) != code_items_set.end()) {
-            diff += UnsignedLeb128Size(code_item_offset)
-                - UnsignedLeb128Size(code_item->GetOffset());
+    const LayoutType layout_type = static_cast<LayoutType>(index);
+    // Hot code items are split between the ones used during startup and the others.
+    const bool split_startup = layout_type == LayoutType::kLayoutTypeHot;
+    for (bool startup : { true, false }) {
+      for (dex_ir::ClassData* data : new_class_data_order) {
+        for (InvokeType invoke_type : invoke_types) {
+          for (auto& method : *(invoke_type == InvokeType::kDirect
+                                    ? data->DirectMethods()
+                                    : data->VirtualMethods())) {
+            dex_ir::CodeItem* code_item = method->GetCodeItem();
+            if (code_item == nullptr || code_item == last_code_item) {
+              continue;
+            }
+            auto it = code_item_types.find(code_item);
+            if (it == code_item_types.end() || it->second != layout_type) {
+              continue;
+            }
+            if (split_startup &&
+                startup != (startup_code_items.find(code_item) != startup_code_items.end())) {
+              continue;
+            }
+            if (!placed_code_items.insert(code_item).second) {
+              continue;
+            }
             code_item->SetOffset(code_item_offset);
-            code_item_offset +=
-                RoundUp(code_item->GetSize(), kDexCodeItemAlignment);
+            code_item_offset += RoundUp(code_item->GetSize(), kDexCodeItemAlignment);
+            ++counts[index];
           }
         }
       }
+      if (!split_startup) {
+        break;
+      }
     }
-    DexLayoutSection& code_section = dex_sections_.sections_[static_cast<size_t>(
-        DexLayoutSections::SectionType::kSectionTypeCode)];
     code_section.parts_[index].offset_ = start_offset;
     code_section.parts_[index].size_ = code_item_offset - start_offset;
-    for (size_t i = 0; i < num_layout_types; ++i) {
-      VLOG(dex) << "Code item layout bucket " << i << " count=" << code_items[i].size()
-                << " bytes=" << code_section.parts_[i].size_;
+  }
+  for (size_t i = 0; i < num_layout_types; ++i) {
+    VLOG(dex) << "Code item layout bucket " << i << " count=" << counts[i]
+              << " bytes=" << code_section.parts_[i].size_;
+  }
+  if (last_code_item != nullptr) {
+    last_code_item->SetOffset(code_item_offset);
+  }
+
+  // Move the sections after the code items over the space of the duplicates.
+  if (duplicate_bytes != 0) {
+    FixupSections(header_->GetCollections().CodeItemsOffset(), -duplicate_bytes);
+    header_->SetFileSize(header_->FileSize() - duplicate_bytes);
+    header_->SetDataSize(header_->DataSize() - duplicate_bytes);
+  }
+
+  if (options_.show_code_item_layout_) {
+    fprintf(out_file_, "Shareable code items: %zu unique, %zu duplicates removed (%u bytes)\n",
+            unique_code_items.size(), duplicate_code_items.size(), duplicate_bytes);
+    fprintf(out_file_, "Code pages touched at startup: %zu before layout, %zu after\n",
+            startup_pages_before, CountCodePages(startup_code_items));
+  }
+
+  // The class data encodes the code item offsets as ULEB128, adjust it to their new sizes.
+  int32_t diff = 0;
+  for (dex_ir::ClassData* data : new_class_data_order) {
+    data->SetOffset(data->GetOffset() + diff);
+    for (InvokeType invoke_type : invoke_types) {
+      for (auto& method : *(invoke_type == InvokeType::kDirect
+                                ? data->DirectMethods()
+                                : data->VirtualMethods())) {
+        dex_ir::CodeItem* code_item = method->GetCodeItem();
+        if (code_item != nullptr) {
+          diff += UnsignedLeb128Size(code_item->GetOffset())
+              - UnsignedLeb128Size(original_code_offsets[method.get()]);
+        }
+      }
     }
-    total_diff += diff;
   }
   // Adjust diff to be 4-byte aligned.
-  return RoundUp(total_diff, kDexCodeItemAlignment);
+  return RoundUp(diff, kDexCodeItemAlignment);
 }
 
 bool DexLayout::IsNextSectionCodeItemAligned(uint32_t offset) {
@@ -1884,10 +2099,19 @@ void DexLayout::LayoutOutputFile(const DexFile* dex_file) {
   header_->SetFileSize(header_->FileSize() + diff);
 }
 
-void DexLayout::OutputDexFile(const DexFile* dex_file) {
+void DexLayout::OutputDexFile(const DexFile* dex_file, TimingLogger* timings) {
+  TimingLogger::ScopedTiming t("WriteDexFile", timings);
   const std::string& dex_file_location = dex_file->GetLocation();
   std::string error_msg;
   std::unique_ptr<File> new_file;
+  const bool compact_dex =
+      options_.compact_dex_level_ != CompactDexLevel::kCompactDexLevelNone;
+  if (compact_dex) {
+    CHECK(compact_dex_shared_data_ != nullptr);
+    CompactDexWriter::Layout(header_, compact_dex_shared_data_);
+    // The sections laid out by the profile are in the shared data now.
+    dex_sections_ = DexLayoutSections();
+  }
   if (!options_.output_to_memmap_) {
     std::string output_location(options_.output_dex_directory_);
     size_t last_slash = dex_file_location.rfind('/');
@@ -1922,27 +2146,39 @@ void DexLayout::OutputDexFile(const DexFile* dex_file) {
     }
     return;
   }
-  DexWriter::Output(header_, mem_map_.get());
+  if (compact_dex) {
+    CompactDexWriter::Output(header_, mem_map_.get(), options_.thread_count_);
+  } else {
+    DexWriter::Output(header_, mem_map_.get(), options_.thread_count_);
+  }
   if (new_file != nullptr) {
     UNUSED(new_file->FlushCloseOrErase());
   }
-  // Verify the output dex file's structure for debug builds.
+  t.NewTiming("VerifyOutput");
+  // Verify the output dex file's structure for debug builds. The verifier does not support
+  // compact dex files, which are only opened.
   if (kIsDebugBuild) {
     std::string location = "memory mapped file for " + dex_file_location;
-    std::unique_ptr<const DexFile> output_dex_file(DexFile::Open(mem_map_->Begin(),
-                                                                 mem_map_->Size(),
-                                                                 location,
-                                                                 header_->Checksum(),
-                                                                 /*oat_dex_file*/ nullptr,
-                                                                 /*verify*/ true,
-                                                                 /*verify_checksum*/ false,
-                                                                 &error_msg));
+    const std::vector<uint8_t>* shared_data =
+        compact_dex ? &compact_dex_shared_data_->GetData() : nullptr;
+    std::unique_ptr<const DexFile> output_dex_file(DexFile::Open(
+        mem_map_->Begin(),
+        mem_map_->Size(),
+        compact_dex ? shared_data->data() : nullptr,
+        compact_dex ? shared_data->size() : 0u,
+        location,
+        header_->Checksum(),
+        /*oat_dex_file*/ nullptr,
+        /*verify*/ !compact_dex,
+        /*verify_checksum*/ false,
+        &error_msg));
     DCHECK(output_dex_file != nullptr) << "Failed to re-open output file:" << error_msg;
   }
   // Do IR-level comparison between input and output. This check ignores potential differences
   // due to layout, so offsets are not checked. Instead, it checks the data contents of each item.
   if (kIsDebugBuild || options_.verify_output_) {
-    std::unique_ptr<dex_ir::Header> orig_header(dex_ir::DexIrBuilder(*dex_file));
+    std::unique_ptr<dex_ir::Header> orig_header(
+        dex_ir::DexIrBuilder(*dex_file, options_.thread_count_, timings));
     CHECK(VerifyOutputDexFile(orig_header.get(), header_, &error_msg)) << error_msg;
   }
 }
@@ -1953,7 +2189,9 @@ void DexLayout::OutputDexFile(const DexFile* dex_file) {
 void DexLayout::ProcessDexFile(const char* file_name,
                                const DexFile* dex_file,
                                size_t dex_file_index) {
-  std::unique_ptr<dex_ir::Header> header(dex_ir::DexIrBuilder(*dex_file));
+  TimingLogger timings("dexlayout", /* precise */ true, /* verbose */ false);
+  std::unique_ptr<dex_ir::Header> header(
+      dex_ir::DexIrBuilder(*dex_file, options_.thread_count_, &timings));
   SetHeader(header.get());
 
   if (options_.verbose_) {
@@ -1979,9 +2217,16 @@ void DexLayout::ProcessDexFile(const char* file_name,
   // Output dex file as file or memmap.
   if (options_.output_dex_directory_ != nullptr || options_.output_to_memmap_) {
     if (info_ != nullptr) {
+      TimingLogger::ScopedTiming t("LayoutOutputFile", &timings);
       LayoutOutputFile(dex_file);
     }
-    OutputDexFile(dex_file);
+    OutputDexFile(dex_file, &timings);
+  }
+
+  if (options_.show_timings_) {
+    std::ostringstream oss;
+    timings.Dump(oss);
+    fprintf(out_file_, "Timings for '%s':\n%s", file_name, oss.str().c_str());
   }
 }
 
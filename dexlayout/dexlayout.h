@@ -26,15 +26,18 @@
 #include <stdint.h>
 #include <stdio.h>
 
+#include "compact_dex_level.h"
 #include "dex_file_layout.h"
 #include "dex_ir.h"
 #include "mem_map.h"
 
 namespace art {
 
+class CompactDexSharedData;
 class DexFile;
 class Instruction;
 class ProfileCompilationInfo;
+class TimingLogger;
 
 /* Supported output formats. */
 enum OutputFormat {
@@ -55,13 +58,20 @@ class Options {
   bool ignore_bad_checksum_ = false;
   bool output_to_memmap_ = false;
   bool show_annotations_ = false;
+  bool show_code_item_layout_ = false;
   bool show_file_headers_ = false;
   bool show_section_headers_ = false;
   bool show_section_statistics_ = false;
+  bool show_timings_ = false;
   bool verbose_ = false;
   bool verify_output_ = false;
   bool visualize_pattern_ = false;
   OutputFormat output_format_ = kOutputPlain;
+  // Write compact dex files, whose data items go to the shared data set with
+  // DexLayout::SetCompactDexSharedData().
+  CompactDexLevel compact_dex_level_ = CompactDexLevel::kCompactDexLevelNone;
+  // Number of threads building the dex_ir and writing the output dex file.
+  size_t thread_count_ = 1u;
   const char* output_dex_directory_ = nullptr;
   const char* output_file_name_ = nullptr;
   const char* profile_file_name_ = nullptr;
@@ -74,7 +84,11 @@ class DexLayout {
             FILE* out_file,
             dex_ir::Header*
             header = nullptr)
-      : options_(options), info_(info), out_file_(out_file), header_(header) { }
+      : options_(options),
+        info_(info),
+        out_file_(out_file),
+        header_(header),
+        compact_dex_shared_data_(nullptr) { }
 
   int ProcessFile(const char* file_name);
   void ProcessDexFile(const char* file_name, const DexFile* dex_file, size_t dex_file_index);
@@ -82,6 +96,10 @@ class DexLayout {
   dex_ir::Header* GetHeader() const { return header_; }
   void SetHeader(dex_ir::Header* header) { header_ = header; }
 
+  void SetCompactDexSharedData(CompactDexSharedData* shared_data) {
+    compact_dex_shared_data_ = shared_data;
+  }
+
   MemMap* GetAndReleaseMemMap() { return mem_map_.release(); }
 
   const DexLayoutSections& GetSections() const {
@@ -123,7 +141,7 @@ class DexLayout {
   // Creates a new layout for the dex file based on profile info.
   // Currently reorders ClassDefs, ClassDataItems, and CodeItems.
   void LayoutOutputFile(const DexFile* dex_file);
-  void OutputDexFile(const DexFile* dex_file);
+  void OutputDexFile(const DexFile* dex_file, TimingLogger* timings);
 
   void DumpCFG(const DexFile* dex_file, int idx);
   void DumpCFG(const DexFile* dex_file, uint32_t dex_method_idx, const DexFile::CodeItem* code);
@@ -134,6 +152,7 @@ class DexLayout {
   dex_ir::Header* header_;
   std::unique_ptr<MemMap> mem_map_;
   DexLayoutSections dex_sections_;
+  CompactDexSharedData* compact_dex_shared_data_;
 
   DISALLOW_COPY_AND_ASSIGN(DexLayout);
 };
@@ -29,6 +29,7 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 
+#include "android-base/parseint.h"
 #include "base/logging.h"
 #include "jit/profile_compilation_info.h"
 #include "runtime.h"
@@ -43,8 +44,9 @@ static const char* kProgramName = "dexlayout";
  */
 static void Usage(void) {
   fprintf(stderr, "Copyright (C) 2016 The Android Open Source Project\n\n");
-  fprintf(stderr, "%s: [-a] [-c] [-d] [-e] [-f] [-h] [-i] [-l layout] [-o outfile] [-p profile]"
-                  " [-s] [-t] [-v] [-w directory] dexfile...\n\n", kProgramName);
+  fprintf(stderr, "%s: [-a] [-c] [-d] [-e] [-f] [-h] [-i] [-j threads] [-l layout] [-o outfile]"
+                  " [-p profile] [-r] [-s] [-t] [-T] [-v] [-w directory] dexfile...\n\n",
+                  kProgramName);
   fprintf(stderr, " -a : display annotations\n");
   fprintf(stderr, " -b : build dex_ir\n");
   fprintf(stderr, " -c : verify checksum and exit\n");
@@ -53,11 +55,14 @@ static void Usage(void) {
   fprintf(stderr, " -f : display summary information from file header\n");
   fprintf(stderr, " -h : display file header details\n");
   fprintf(stderr, " -i : ignore checksum failures\n");
+  fprintf(stderr, " -j : number of threads building the dex_ir and writing output (default 1)\n");
   fprintf(stderr, " -l : output layout, either 'plain' or 'xml'\n");
   fprintf(stderr, " -o : output file name (defaults to stdout)\n");
   fprintf(stderr, " -p : profile file name (defaults to no profile)\n");
+  fprintf(stderr, " -r : report shared code items and code pages touched at startup\n");
   fprintf(stderr, " -s : visualize reference pattern\n");
   fprintf(stderr, " -t : display file section sizes\n");
+  fprintf(stderr, " -T : display the time spent in each phase\n");
   fprintf(stderr, " -v : verify output file is canonical to input (IR level comparison)\n");
   fprintf(stderr, " -w : output dex directory \n");
 }
@@ -77,7 +82,7 @@ int DexlayoutDriver(int argc, char** argv) {
 
   // Parse all arguments.
   while (1) {
-    const int ic = getopt(argc, argv, "abcdefghil:mo:p:stvw:");
+    const int ic = getopt(argc, argv, "abcdefghij:l:mo:p:rstTvw:");
     if (ic < 0) {
       break;  // done
     }
@@ -106,6 +111,13 @@ int DexlayoutDriver(int argc, char** argv) {
       case 'i':  // continue even if checksum is bad
         options.ignore_bad_checksum_ = true;
         break;
+      case 'j':  // number of threads
+        if (!android::base::ParseUint(optarg, &options.thread_count_) ||
+            options.thread_count_ == 0u) {
+          fprintf(stderr, "Invalid thread count %s\n", optarg);
+          want_usage = true;
+        }
+        break;
       case 'l':  // layout
         if (strcmp(optarg, "plain") == 0) {
           options.output_format_ = kOutputPlain;
@@ -125,6 +137,9 @@ int DexlayoutDriver(int argc, char** argv) {
       case 'p':  // profile file
         options.profile_file_name_ = optarg;
         break;
+      case 'r':  // report code item layout
+        options.show_code_item_layout_ = true;
+        break;
       case 's':  // visualize access pattern
         options.visualize_pattern_ = true;
         options.verbose_ = false;
@@ -133,6 +148,9 @@ int DexlayoutDriver(int argc, char** argv) {
         options.show_section_statistics_ = true;
         options.verbose_ = false;
         break;
+      case 'T':  // display timings
+        options.show_timings_ = true;
+        break;
       case 'v':  // verify output
         options.verify_output_ = true;
         break;
@@ -277,8 +277,9 @@ class DexLayoutTest : public CommonRuntimeTest {
     return true;
   }
 
-  // Runs DexFileOutput test.
-  bool DexFileOutputExec(std::string* error_msg) {
+  // Runs DexFileOutput test, building the dex_ir and writing the output with `thread_count`
+  // threads.
+  bool DexFileOutputExec(std::string* error_msg, size_t thread_count = 1u) {
     ScratchFile tmp_file;
     const std::string& tmp_name = tmp_file.GetFilename();
     size_t tmp_last_slash = tmp_name.rfind('/');
@@ -288,7 +289,8 @@ class DexLayoutTest : public CommonRuntimeTest {
 
     for (const std::string &dex_file : GetLibCoreDexFileNames()) {
       std::vector<std::string> dexlayout_exec_argv =
-          { dexlayout, "-w", tmp_dir, "-o", tmp_name, dex_file };
+          { dexlayout, "-j", std::to_string(thread_count), "-w", tmp_dir, "-o", tmp_name,
+            dex_file };
       if (!::art::Exec(dexlayout_exec_argv, error_msg)) {
         return false;
       }
@@ -546,6 +548,13 @@ TEST_F(DexLayoutTest, DexFileOutput) {
   ASSERT_TRUE(DexFileOutputExec(&error_msg)) << error_msg;
 }
 
+TEST_F(DexLayoutTest, DexFileOutputMultiThreaded) {
+  // Disable test on target.
+  TEST_DISABLED_FOR_TARGET();
+  std::string error_msg;
+  ASSERT_TRUE(DexFileOutputExec(&error_msg, /* thread_count */ 4u)) << error_msg;
+}
+
 TEST_F(DexLayoutTest, DexFileLayout) {
   // Disable test on target.
   TEST_DISABLED_FOR_TARGET();
@@ -671,4 +680,24 @@ TEST_F(DexLayoutTest, DuplicateCodeItem) {
                             dexlayout_exec_argv));
 }
 
+TEST_F(DexLayoutTest, DuplicateCodeItemLayout) {
+  ScratchFile temp_dex;
+  ScratchFile temp_profile;
+  const std::string& dex_name = temp_dex.GetFilename();
+  std::string tmp_dir = dex_name.substr(0, dex_name.rfind('/') + 1);
+  std::string dexlayout = GetTestAndroidRoot() + "/bin/dexlayout";
+  EXPECT_TRUE(OS::FileExists(dexlayout.c_str())) << dexlayout << " should be a valid file path";
+  // Lay out the code items shared between methods and check the output with -v.
+  std::vector<std::string> dexlayout_exec_argv =
+      { dexlayout, "-v", "-r", "-w", tmp_dir, "-p", temp_profile.GetFilename(), "-o", "/dev/null",
+        dex_name };
+  ASSERT_TRUE(DexLayoutExec(&temp_dex,
+                            kDuplicateCodeItemInputDex,
+                            &temp_profile,
+                            dexlayout_exec_argv));
+  std::vector<std::string> rm_exec_argv = { "/bin/rm", dex_name + ".new" };
+  std::string error_msg;
+  ASSERT_TRUE(::art::Exec(rm_exec_argv, &error_msg)) << error_msg;
+}
+
 }  // namespace art
@@ -25,6 +25,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <unistd.h>
 
 #include "dex_file-inl.h"
 #include "mem_map.h"
@@ -34,6 +35,11 @@ namespace art {
 
 static const char* gProgName = "dexlist";
 
+/*
+ * Size of the output buffer.
+ */
+static constexpr size_t kOutputBufferSize = 256 * 1024;
+
 /* Command-line options. */
 static struct {
   char* argCopy;
@@ -272,6 +278,12 @@ int dexlistDriver(int argc, char** argv) {
     }
   }
 
+  // Listings are written one line per method, use a large buffer unless the
+  // output goes to a terminal.
+  if (!isatty(fileno(gOutFile))) {
+    setvbuf(gOutFile, nullptr, _IOFBF, kOutputBufferSize);
+  }
+
   // Process all files supplied on command line. If one of them fails we
   // continue on, only returning a failure at the end.
   int result = 0;
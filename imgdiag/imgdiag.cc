@@ -17,10 +17,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <algorithm>
 #include <fstream>
 #include <functional>
 #include <iostream>
 #include <string>
+#include <thread>
 #include <vector>
 #include <set>
 #include <map>
@@ -30,6 +32,8 @@
 
 #include "art_field-inl.h"
 #include "art_method-inl.h"
+#include "atomic.h"
+#include "base/casts.h"
 #include "base/unix_file/fd_file.h"
 #include "class_linker.h"
 #include "gc/space/image_space.h"
@@ -1096,6 +1100,7 @@ class RegionData : public RegionSpecializedBase<T> {
 
 }  // namespace
 
+static bool DumpZygoteSpaceDiff(std::ostream* os, pid_t pid, pid_t zygote_pid);
 
 class ImgDiagDumper {
  public:
@@ -1607,6 +1612,9 @@ class ImgDiagDumper {
   bool dump_dirty_objects_;  // Adds dumping of objects that are dirty.
   bool zygote_pid_only_;  // The user only specified a pid for the zygote.
 
+  friend class MultiProcessImgDiagDumper;
+  friend bool DumpZygoteSpaceDiff(std::ostream* os, pid_t pid, pid_t zygote_pid);
+
   // BacktraceMap used for finding the memory mapping of the image file.
   std::unique_ptr<BacktraceMap> proc_maps_;
   // Boot image mapping.
@@ -1629,11 +1637,439 @@ class ImgDiagDumper {
   DISALLOW_COPY_AND_ASSIGN(ImgDiagDumper);
 };
 
+// Scans the boot image of several processes and aggregates, per class, the image objects that
+// differ from the local image (or from the zygote if a zygote pid was given). The objects are
+// collected once, under the mutator lock, and the processes are then read and compared on
+// separate threads which only look at raw bytes. Each thread keeps a single process' image
+// contents at a time. The results are written as CSV.
+class MultiProcessImgDiagDumper {
+ public:
+  MultiProcessImgDiagDumper(std::ostream* os,
+                            const ImageHeader& image_header,
+                            const std::string& image_location,
+                            const std::vector<pid_t>& image_diff_pids,
+                            pid_t zygote_diff_pid,
+                            size_t thread_count)
+      : os_(os),
+        image_header_(image_header),
+        image_location_(image_location),
+        image_diff_pids_(image_diff_pids),
+        zygote_diff_pid_(zygote_diff_pid),
+        thread_count_(thread_count) {}
+
+  bool Init() REQUIRES_SHARED(Locks::mutator_lock_) {
+    std::ostream& os = *os_;
+    if (image_diff_pids_.empty()) {
+      os << "--image-diff-pids must name at least one process.\n";
+      return false;
+    }
+
+    // Collect the objects of the image with their size and class.
+    std::map<mirror::Class*, uint32_t> class_indexes;
+    auto collect_object = [&](mirror::Object* object,
+                              const uint8_t* begin_image_ptr ATTRIBUTE_UNUSED,
+                              const std::set<size_t>& dirty_pages ATTRIBUTE_UNUSED)
+        REQUIRES_SHARED(Locks::mutator_lock_) {
+      mirror::Class* klass = object->GetClass();
+      auto it = class_indexes.find(klass);
+      if (it == class_indexes.end()) {
+        it = class_indexes.emplace(klass, class_stats_.size()).first;
+        class_stats_.emplace_back();
+        class_stats_.back().descriptor = GetClassDescriptor(klass);
+      }
+      ++class_stats_[it->second].object_count;
+      objects_.push_back(ObjectEntry {
+          reinterpret_cast<uintptr_t>(object),
+          dchecked_integral_cast<uint32_t>(EntrySize(object)),
+          it->second });
+    };
+    std::set<size_t> no_dirty_pages;
+    uint8_t* image_begin = image_header_.GetImageBegin();
+    ImgObjectVisitor visitor(collect_object, image_begin, no_dirty_pages);
+    PointerSize pointer_size = InstructionSetPointerSize(Runtime::Current()->GetInstructionSet());
+    image_header_.VisitObjects(&visitor, image_begin, pointer_size);
+
+    if (zygote_diff_pid_ >= 0) {
+      std::string error_msg;
+      if (!ReadBootMap(zygote_diff_pid_, &zygote_boot_map_, &zygote_contents_, &error_msg)) {
+        os << "Zygote " << zygote_diff_pid_ << ": " << error_msg << "\n";
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool Dump() {
+    std::ostream& os = *os_;
+    const size_t num_pids = image_diff_pids_.size();
+    const size_t num_threads = std::max<size_t>(1u, std::min(thread_count_, num_pids));
+    std::vector<ProcessStats> process_stats(num_pids);
+    std::vector<std::vector<ClassStats>> thread_class_stats(
+        num_threads, std::vector<ClassStats>(class_stats_.size()));
+    Atomic<size_t> next_pid(0u);
+    auto scan_processes = [&](std::vector<ClassStats>* class_stats) {
+      while (true) {
+        const size_t index = next_pid.FetchAndAddSequentiallyConsistent(1u);
+        if (index >= num_pids) {
+          break;
+        }
+        process_stats[index].pid = image_diff_pids_[index];
+        ScanProcess(&process_stats[index], class_stats);
+      }
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < num_threads; ++i) {
+      threads.emplace_back(scan_processes, &thread_class_stats[i]);
+    }
+    scan_processes(&thread_class_stats[0]);
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+    for (const std::vector<ClassStats>& class_stats : thread_class_stats) {
+      for (size_t i = 0; i < class_stats.size(); ++i) {
+        class_stats_[i].dirty_process_count += class_stats[i].dirty_process_count;
+        class_stats_[i].dirty_object_count += class_stats[i].dirty_object_count;
+        class_stats_[i].dirty_byte_count += class_stats[i].dirty_byte_count;
+      }
+    }
+
+    bool success = true;
+    os << "# image," << image_location_ << "\n";
+    os << "pid,dirty_objects,dirty_object_bytes,dirty_pages,private_dirty_pages\n";
+    for (const ProcessStats& stats : process_stats) {
+      if (!stats.error_msg.empty()) {
+        LOG(ERROR) << "Failed to scan process " << stats.pid << ": " << stats.error_msg;
+        success = false;
+        continue;
+      }
+      os << stats.pid << ","
+         << stats.dirty_object_count << ","
+         << stats.dirty_byte_count << ","
+         << stats.dirty_pages << ","
+         << stats.private_dirty_pages << "\n";
+    }
+    os << "\n";
+
+    // Classes with the most dirty objects first, they are the candidates for the clean bins.
+    std::vector<const ClassStats*> sorted_class_stats;
+    for (const ClassStats& stats : class_stats_) {
+      if (stats.dirty_object_count != 0u) {
+        sorted_class_stats.push_back(&stats);
+      }
+    }
+    std::sort(sorted_class_stats.begin(),
+              sorted_class_stats.end(),
+              [](const ClassStats* lhs, const ClassStats* rhs) {
+                if (lhs->dirty_object_count != rhs->dirty_object_count) {
+                  return lhs->dirty_object_count > rhs->dirty_object_count;
+                }
+                return lhs->descriptor < rhs->descriptor;
+              });
+    os << "class,objects,dirty_processes,dirty_objects,dirty_bytes\n";
+    for (const ClassStats* stats : sorted_class_stats) {
+      os << stats->descriptor << ","
+         << stats->object_count << ","
+         << stats->dirty_process_count << ","
+         << stats->dirty_object_count << ","
+         << stats->dirty_byte_count << "\n";
+    }
+    os << "\n" << std::flush;
+    return success;
+  }
+
+ private:
+  struct ObjectEntry {
+    uintptr_t address;
+    uint32_t size;
+    uint32_t class_index;
+  };
+
+  struct ClassStats {
+    std::string descriptor;
+    // The count of objects of the class in the image.
+    size_t object_count = 0;
+    // The count of processes with at least one dirty object of the class.
+    size_t dirty_process_count = 0;
+    // The count of dirty objects, summed over the processes.
+    size_t dirty_object_count = 0;
+    // The count of differing bytes in dirty objects, summed over the processes.
+    size_t dirty_byte_count = 0;
+  };
+
+  struct ProcessStats {
+    pid_t pid = -1;
+    // Non-empty if the process could not be scanned.
+    std::string error_msg;
+    size_t dirty_object_count = 0;
+    size_t dirty_byte_count = 0;
+    // The count of pages that are considered dirty by the OS.
+    size_t dirty_pages = 0;
+    // The count of dirty pages with mapping count == 1.
+    size_t private_dirty_pages = 0;
+  };
+
+  // Find the writable mapping of the image in `pid` and read it. Thread-safe.
+  bool ReadBootMap(pid_t pid,
+                   backtrace_map_t* boot_map,
+                   std::vector<uint8_t>* contents,
+                   std::string* error_msg) const {
+    std::unique_ptr<BacktraceMap> proc_maps(BacktraceMap::Create(pid));
+    if (proc_maps == nullptr) {
+      *error_msg = "Could not read backtrace maps";
+      return false;
+    }
+    const std::string image_base_name = ImgDiagDumper::BaseName(image_location_);
+    bool found_boot_map = false;
+    for (const backtrace_map_t& map : *proc_maps) {
+      if (ImgDiagDumper::EndsWith(map.name, image_base_name) && (map.flags & PROT_WRITE) != 0) {
+        *boot_map = map;
+        found_boot_map = true;
+        break;
+      }
+    }
+    if (!found_boot_map) {
+      *error_msg = "Could not find map for " + image_base_name;
+      return false;
+    }
+    CHECK(boot_map->end >= boot_map->start);
+
+    // Sanity check that we aren't trying to read a completely different boot image.
+    const uintptr_t image_begin =
+        reinterpret_cast<uintptr_t>(AlignDown(image_header_.GetImageBegin(), kPageSize));
+    const uintptr_t image_end = reinterpret_cast<uintptr_t>(
+        AlignUp(image_header_.GetImageBegin() + image_header_.GetImageSize(), kPageSize));
+    if (image_begin > boot_map->start || image_end < boot_map->end) {
+      *error_msg = StringPrintf("Remote boot map [%p, %p) is out of range of local boot map",
+                                reinterpret_cast<void*>(boot_map->start),
+                                reinterpret_cast<void*>(boot_map->end));
+      return false;
+    }
+
+    std::string mem_file_name =
+        StringPrintf("/proc/%ld/mem", static_cast<long>(pid));  // NOLINT [runtime/int]
+    std::unique_ptr<File> mem_file(OS::OpenFileForReading(mem_file_name.c_str()));
+    if (mem_file == nullptr) {
+      *error_msg = "Failed to open " + mem_file_name + " for reading";
+      return false;
+    }
+    const size_t boot_map_size = boot_map->end - boot_map->start;
+    contents->resize(boot_map_size);
+    if (!mem_file->PreadFully(contents->data(), boot_map_size, boot_map->start)) {
+      *error_msg = "Could not fully read file " + mem_file_name;
+      return false;
+    }
+    return true;
+  }
+
+  // Return the contents of `address` as seen by `boot_map` and `contents`, or null if the
+  // object is not entirely in the mapping.
+  static const uint8_t* GetRemoteObject(const backtrace_map_t& boot_map,
+                                        const std::vector<uint8_t>& contents,
+                                        const ObjectEntry& entry) {
+    if (entry.address < boot_map.start || entry.address + entry.size > boot_map.end) {
+      return nullptr;
+    }
+    return contents.data() + (entry.address - boot_map.start);
+  }
+
+  // Scan the process `stats->pid`, adding its dirty objects to `class_stats`. Errors are
+  // reported through `stats->error_msg`. Does not touch any runtime state.
+  void ScanProcess(ProcessStats* stats, std::vector<ClassStats>* class_stats) const {
+    std::string* error_msg = &stats->error_msg;
+    backtrace_map_t boot_map{};  // NOLINT
+    std::vector<uint8_t> remote_contents;
+    if (!ReadBootMap(stats->pid, &boot_map, &remote_contents, error_msg)) {
+      return;
+    }
+
+    // Count the dirty pages as in ImgDiagDumper::ComputeDirtyBytes.
+    std::string pagemap_file_name =
+        StringPrintf("/proc/%ld/pagemap", static_cast<long>(stats->pid));  // NOLINT [runtime/int]
+    std::unique_ptr<File> pagemap_file(OS::OpenFileForReading(pagemap_file_name.c_str()));
+    std::unique_ptr<File> clean_pagemap_file(OS::OpenFileForReading("/proc/self/pagemap"));
+    std::unique_ptr<File> kpageflags_file(OS::OpenFileForReading("/proc/kpageflags"));
+    std::unique_ptr<File> kpagecount_file(OS::OpenFileForReading("/proc/kpagecount"));
+    if (pagemap_file == nullptr ||
+        clean_pagemap_file == nullptr ||
+        kpageflags_file == nullptr ||
+        kpagecount_file == nullptr) {
+      *error_msg = StringPrintf("Failed to open the page maps for reading: %s", strerror(errno));
+      return;
+    }
+    for (uintptr_t begin = boot_map.start; begin != boot_map.end; begin += kPageSize) {
+      uint64_t page_count = 0xC0FFEE;
+      int dirtiness = ImgDiagDumper::IsPageDirty(pagemap_file.get(),
+                                                 clean_pagemap_file.get(),
+                                                 kpageflags_file.get(),
+                                                 kpagecount_file.get(),
+                                                 begin / kPageSize,
+                                                 begin / kPageSize,
+                                                 &page_count,
+                                                 error_msg);
+      if (dirtiness < 0) {
+        return;
+      } else if (dirtiness > 0) {
+        ++stats->dirty_pages;
+        if (page_count == 1) {
+          ++stats->private_dirty_pages;
+        }
+      }
+    }
+
+    // Compare the objects against the zygote if we have it, or else against the local image.
+    std::vector<bool> class_is_dirty(class_stats->size(), false);
+    for (const ObjectEntry& entry : objects_) {
+      const uint8_t* remote = GetRemoteObject(boot_map, remote_contents, entry);
+      const uint8_t* local = (zygote_diff_pid_ >= 0)
+          ? GetRemoteObject(zygote_boot_map_, zygote_contents_, entry)
+          : reinterpret_cast<const uint8_t*>(entry.address);
+      if (remote == nullptr || local == nullptr || memcmp(local, remote, entry.size) == 0) {
+        continue;
+      }
+      size_t different_bytes = 0;
+      for (size_t i = 0; i < entry.size; ++i) {
+        if (local[i] != remote[i]) {
+          ++different_bytes;
+        }
+      }
+      ClassStats& klass_stats = (*class_stats)[entry.class_index];
+      ++klass_stats.dirty_object_count;
+      klass_stats.dirty_byte_count += different_bytes;
+      class_is_dirty[entry.class_index] = true;
+      ++stats->dirty_object_count;
+      stats->dirty_byte_count += different_bytes;
+    }
+    for (size_t i = 0; i < class_is_dirty.size(); ++i) {
+      if (class_is_dirty[i]) {
+        ++(*class_stats)[i].dirty_process_count;
+      }
+    }
+  }
+
+  std::ostream* os_;
+  const ImageHeader& image_header_;
+  const std::string image_location_;
+  const std::vector<pid_t> image_diff_pids_;
+  const pid_t zygote_diff_pid_;  // Diff against the zygote boot.art if pid is non-negative.
+  const size_t thread_count_;
+
+  // The objects of the image, in address order.
+  std::vector<ObjectEntry> objects_;
+  // The statistics of the classes of the image objects, indexed by ObjectEntry::class_index.
+  std::vector<ClassStats> class_stats_;
+  // Boot image mapping and contents of the zygote, if zygote_diff_pid_ is non-negative.
+  backtrace_map_t zygote_boot_map_{};  // NOLINT
+  std::vector<uint8_t> zygote_contents_;
+
+  DISALLOW_COPY_AND_ASSIGN(MultiProcessImgDiagDumper);
+};
+
+// Compares the zygote space of `pid` with the one of the zygote `zygote_pid`, page by page, and
+// prints the pages that the process no longer shares with the zygote, i.e. that it wrote to
+// since the fork. The zygote compaction puts the objects likely to be written first, so the
+// dirty pages should be mostly at the start of the space.
+static bool DumpZygoteSpaceDiff(std::ostream* os, pid_t pid, pid_t zygote_pid) {
+  auto find_zygote_space = [](pid_t map_pid, backtrace_map_t* zygote_map) {
+    std::unique_ptr<BacktraceMap> proc_maps(BacktraceMap::Create(map_pid));
+    if (proc_maps == nullptr) {
+      return false;
+    }
+    for (const backtrace_map_t& map : *proc_maps) {
+      if (map.name.find("dalvik-zygote space") != std::string::npos) {
+        *zygote_map = map;
+        return true;
+      }
+    }
+    return false;
+  };
+  backtrace_map_t zygote_map{};  // NOLINT
+  backtrace_map_t remote_zygote_map{};  // NOLINT
+  if (!find_zygote_space(pid, &zygote_map) || !find_zygote_space(zygote_pid, &remote_zygote_map)) {
+    *os << "Could not find the zygote space of " << pid << " and " << zygote_pid << "\n";
+    return false;
+  }
+  if (zygote_map.start != remote_zygote_map.start || zygote_map.end != remote_zygote_map.end) {
+    *os << "The zygote spaces of " << pid << " and " << zygote_pid << " differ\n";
+    return false;
+  }
+
+  std::string pagemap_file_name =
+      StringPrintf("/proc/%ld/pagemap", static_cast<long>(pid));  // NOLINT [runtime/int]
+  std::string zygote_pagemap_file_name =
+      StringPrintf("/proc/%ld/pagemap", static_cast<long>(zygote_pid));  // NOLINT [runtime/int]
+  std::unique_ptr<File> pagemap_file(OS::OpenFileForReading(pagemap_file_name.c_str()));
+  std::unique_ptr<File> zygote_pagemap_file(
+      OS::OpenFileForReading(zygote_pagemap_file_name.c_str()));
+  std::unique_ptr<File> kpagecount_file(OS::OpenFileForReading("/proc/kpagecount"));
+  if (pagemap_file == nullptr || zygote_pagemap_file == nullptr || kpagecount_file == nullptr) {
+    *os << "Failed to open the page maps for reading: " << strerror(errno) << "\n";
+    return false;
+  }
+
+  const size_t num_pages = (zygote_map.end - zygote_map.start) / kPageSize;
+  size_t dirty_pages = 0;
+  size_t private_dirty_pages = 0;
+  size_t not_present_pages = 0;
+  std::vector<std::pair<size_t, size_t>> dirty_ranges;  // In pages, [begin, end).
+  for (size_t i = 0; i != num_pages; ++i) {
+    const size_t page_index = zygote_map.start / kPageSize + i;
+    uint64_t page_frame_number = 0;
+    uint64_t zygote_page_frame_number = 0;
+    std::string error_msg;
+    if (!ImgDiagDumper::GetPageFrameNumber(
+            pagemap_file.get(), page_index, &page_frame_number, &error_msg) ||
+        !ImgDiagDumper::GetPageFrameNumber(
+            zygote_pagemap_file.get(), page_index, &zygote_page_frame_number, &error_msg)) {
+      *os << error_msg << "\n";
+      return false;
+    }
+    if (page_frame_number == 0 || zygote_page_frame_number == 0) {
+      // Swapped out or never touched, the page cannot be compared.
+      ++not_present_pages;
+      continue;
+    }
+    if (page_frame_number == zygote_page_frame_number) {
+      continue;
+    }
+    ++dirty_pages;
+    uint64_t page_count = 0;
+    if (kpagecount_file->PreadFully(
+            &page_count, sizeof(page_count), page_frame_number * sizeof(page_count)) &&
+        page_count == 1) {
+      ++private_dirty_pages;
+    }
+    if (!dirty_ranges.empty() && dirty_ranges.back().second == i) {
+      dirty_ranges.back().second = i + 1;
+    } else {
+      dirty_ranges.emplace_back(i, i + 1);
+    }
+  }
+
+  *os << "ZYGOTE SPACE DIFF PID (" << pid << ") AGAINST ZYGOTE PID (" << zygote_pid << "):\n";
+  *os << StringPrintf("  Range: [%p, %p), %zu pages\n",
+                      reinterpret_cast<void*>(zygote_map.start),
+                      reinterpret_cast<void*>(zygote_map.end),
+                      num_pages);
+  *os << StringPrintf("  Dirty pages: %zu (%.1f%%), private: %zu, not present: %zu\n",
+                      dirty_pages,
+                      num_pages != 0 ? dirty_pages * 100.0 / num_pages : 0.0,
+                      private_dirty_pages,
+                      not_present_pages);
+  *os << "  Dirty page ranges (page offsets in the space):\n";
+  for (const std::pair<size_t, size_t>& range : dirty_ranges) {
+    *os << StringPrintf("    [%zu, %zu)\n", range.first, range.second);
+  }
+  *os << "\n" << std::flush;
+  return true;
+}
+
 static int DumpImage(Runtime* runtime,
                      std::ostream* os,
                      pid_t image_diff_pid,
+                     const std::vector<pid_t>& image_diff_pids,
                      pid_t zygote_diff_pid,
-                     bool dump_dirty_objects) {
+                     bool dump_dirty_objects,
+                     size_t thread_count) {
   ScopedObjectAccess soa(Thread::Current());
   gc::Heap* heap = runtime->GetHeap();
   std::vector<gc::space::ImageSpace*> image_spaces = heap->GetBootImageSpaces();
@@ -1645,6 +2081,24 @@ static int DumpImage(Runtime* runtime,
       return EXIT_FAILURE;
     }
 
+    if (!image_diff_pids.empty()) {
+      MultiProcessImgDiagDumper multi_process_dumper(os,
+                                                     image_header,
+                                                     image_space->GetImageLocation(),
+                                                     image_diff_pids,
+                                                     zygote_diff_pid,
+                                                     thread_count);
+      if (!multi_process_dumper.Init()) {
+        return EXIT_FAILURE;
+      }
+      // The processes are scanned without the mutator lock, see MultiProcessImgDiagDumper.
+      ScopedThreadSuspension sts(soa.Self(), kNative);
+      if (!multi_process_dumper.Dump()) {
+        return EXIT_FAILURE;
+      }
+      continue;
+    }
+
     ImgDiagDumper img_diag_dumper(os,
                                   image_header,
                                   image_space->GetImageLocation(),
@@ -1688,8 +2142,28 @@ struct ImgDiagArgs : public CmdlineArgs {
         *error_msg = "Zygote diff pid out of range";
         return kParseError;
       }
+    } else if (option.starts_with("--image-diff-pids=")) {
+      std::vector<std::string> pids;
+      Split(option.substr(strlen("--image-diff-pids=")).ToString(), ',', &pids);
+      for (const std::string& pid_str : pids) {
+        pid_t pid;
+        if (!ParseInt(pid_str.c_str(), &pid) || pid < 0) {
+          *error_msg = "Image diff pids out of range: " + pid_str;
+          return kParseError;
+        }
+        image_diff_pids_.push_back(pid);
+      }
+    } else if (option.starts_with("-j")) {
+      const char* thread_count = option.substr(strlen("-j")).data();
+
+      if (!ParseUint(thread_count, &thread_count_) || thread_count_ == 0u) {
+        *error_msg = "-j requires a positive number of threads";
+        return kParseError;
+      }
     } else if (option == "--dump-dirty-objects") {
       dump_dirty_objects_ = true;
+    } else if (option == "--dump-zygote-space") {
+      dump_zygote_space_ = true;
     } else {
       return kParseUnknownArgument;
     }
@@ -1706,16 +2180,31 @@ struct ImgDiagArgs : public CmdlineArgs {
 
     // Perform our own checks.
 
-    if (kill(image_diff_pid_,
-             /*sig*/0) != 0) {  // No signal is sent, perform error-checking only.
-      // Check if the pid exists before proceeding.
-      if (errno == ESRCH) {
-        *error_msg = "Process specified does not exist";
-      } else {
-        *error_msg = StringPrintf("Failed to check process status: %s", strerror(errno));
-      }
+    if (dump_zygote_space_ && (image_diff_pid_ < 0 || zygote_diff_pid_ < 0)) {
+      *error_msg = "--dump-zygote-space requires --image-diff-pid and --zygote-diff-pid";
+      return kParseError;
+    }
+    if (!image_diff_pids_.empty() && image_diff_pid_ >= 0) {
+      *error_msg = "--image-diff-pid and --image-diff-pids are mutually exclusive";
       return kParseError;
-    } else if (instruction_set_ != kRuntimeISA) {
+    }
+    std::vector<pid_t> pids = image_diff_pids_;
+    if (pids.empty()) {
+      pids.push_back(image_diff_pid_);
+    }
+    for (pid_t pid : pids) {
+      if (kill(pid,
+               /*sig*/0) != 0) {  // No signal is sent, perform error-checking only.
+        // Check if the pid exists before proceeding.
+        if (errno == ESRCH) {
+          *error_msg = StringPrintf("Process specified does not exist: %d", pid);
+        } else {
+          *error_msg = StringPrintf("Failed to check process status: %s", strerror(errno));
+        }
+        return kParseError;
+      }
+    }
+    if (instruction_set_ != kRuntimeISA) {
       // Don't allow different ISAs since the images are ISA-specific.
       // Right now the code assumes both the runtime ISA and the remote ISA are identical.
       *error_msg = "Must use the default runtime ISA; changing ISA is not supported.";
@@ -1743,6 +2232,14 @@ struct ImgDiagArgs : public CmdlineArgs {
         "against.\n"
         "      Example: --zygote-diff-pid=$(pid zygote)\n"
         "  --dump-dirty-objects: additionally output dirty objects of interest.\n"
+        "  --image-diff-pids=<pid>,<pid>,...: scan the boot.art of several processes and\n"
+        "      print, as CSV, per process dirty counts and dirty objects by class summed over\n"
+        "      the processes. Diffs against the zygote if --zygote-diff-pid is given.\n"
+        "      Example: --image-diff-pids=$(pidof com.android.systemui),$(pidof system_server)\n"
+        "  -j<number>: number of threads scanning the processes of --image-diff-pids.\n"
+        "      Example: -j4\n"
+        "  --dump-zygote-space: additionally print the pages of the zygote space that the\n"
+        "      --image-diff-pid process dirtied since it forked from --zygote-diff-pid.\n"
         "\n";
 
     return usage;
@@ -1750,19 +2247,28 @@ struct ImgDiagArgs : public CmdlineArgs {
 
  public:
   pid_t image_diff_pid_ = -1;
+  std::vector<pid_t> image_diff_pids_;
   pid_t zygote_diff_pid_ = -1;
   bool dump_dirty_objects_ = false;
+  bool dump_zygote_space_ = false;
+  size_t thread_count_ = 1u;
 };
 
 struct ImgDiagMain : public CmdlineMain<ImgDiagArgs> {
   virtual bool ExecuteWithRuntime(Runtime* runtime) {
     CHECK(args_ != nullptr);
 
-    return DumpImage(runtime,
-                     args_->os_,
-                     args_->image_diff_pid_,
-                     args_->zygote_diff_pid_,
-                     args_->dump_dirty_objects_) == EXIT_SUCCESS;
+    if (DumpImage(runtime,
+                  args_->os_,
+                  args_->image_diff_pid_,
+                  args_->image_diff_pids_,
+                  args_->zygote_diff_pid_,
+                  args_->dump_dirty_objects_,
+                  args_->thread_count_) != EXIT_SUCCESS) {
+      return false;
+    }
+    return !args_->dump_zygote_space_ ||
+        DumpZygoteSpaceDiff(args_->os_, args_->image_diff_pid_, args_->zygote_diff_pid_);
   }
 };
 
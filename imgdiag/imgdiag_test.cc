@@ -36,6 +36,7 @@
 namespace art {
 
 static const char* kImgDiagDiffPid = "--image-diff-pid";
+static const char* kImgDiagDiffPids = "--image-diff-pids";
 static const char* kImgDiagBootImage = "--boot-image";
 static const char* kImgDiagBinaryName = "imgdiag";
 
@@ -123,6 +124,29 @@ class ImgDiagTest : public CommonRuntimeTest {
     return Exec(image_diff_pid, boot_image_location_, error_msg);
   }
 
+  // Run imgdiag --image-diff-pids=$image_diff_pids with the default boot image location.
+  bool ExecMultiProcess(const std::vector<pid_t>& image_diff_pids,
+                        size_t thread_count,
+                        std::string* error_msg) {
+    std::string file_path = GetImgDiagFilePath();
+    EXPECT_TRUE(OS::FileExists(file_path.c_str())) << file_path << " should be a valid file path";
+
+    std::stringstream diff_pids_args_ss;
+    diff_pids_args_ss << kImgDiagDiffPids << "=";
+    for (size_t i = 0; i < image_diff_pids.size(); ++i) {
+      diff_pids_args_ss << (i == 0 ? "" : ",") << image_diff_pids[i];
+    }
+
+    std::vector<std::string> exec_argv = {
+        file_path,
+        diff_pids_args_ss.str(),
+        "-j" + std::to_string(thread_count),
+        std::string(kImgDiagBootImage) + "=" + boot_image_location_
+    };
+
+    return ::art::Exec(exec_argv, error_msg);
+  }
+
  private:
   std::string runtime_args_image_;
   std::string boot_image_location_;
@@ -156,4 +180,25 @@ TEST_F(ImgDiagTest, ImageDiffBadPid) {
   UNUSED(error_msg);
 }
 
+#if defined (ART_TARGET) && !defined(__mips__)
+TEST_F(ImgDiagTest, MultiProcessSelf) {
+#else
+// Can't run this test on the host, see ImageDiffPidSelf.
+TEST_F(ImgDiagTest, DISABLED_MultiProcessSelf) {
+#endif
+  // Scan the current process twice on two threads, the results of both scans are aggregated.
+  std::string error_msg;
+  ASSERT_TRUE(ExecMultiProcess({ getpid(), getpid() }, /* thread_count */ 2u, &error_msg))
+      << "Failed to execute -- because: " << error_msg;
+}
+
+TEST_F(ImgDiagTest, MultiProcessBadPid) {
+  // Any non-existing process makes the whole scan fail.
+  std::string error_msg;
+  ASSERT_FALSE(ExecMultiProcess({ getpid(), kImgDiagGuaranteedBadPid },
+                                /* thread_count */ 2u,
+                                &error_msg)) << "Incorrectly executed";
+  UNUSED(error_msg);
+}
+
 }  // namespace art
@@ -17,11 +17,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <array>
 #include <fstream>
 #include <iostream>
 #include <map>
 #include <set>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
@@ -32,6 +35,7 @@
 #include "arch/instruction_set_features.h"
 #include "art_field-inl.h"
 #include "art_method-inl.h"
+#include "atomic.h"
 #include "base/stl_util.h"
 #include "base/unix_file/fd_file.h"
 #include "class_linker-inl.h"
@@ -50,6 +54,7 @@
 #include "imtable-inl.h"
 #include "indenter.h"
 #include "interpreter/unstarted_runtime.h"
+#include "jit/profile_compilation_info.h"
 #include "linker/buffered_output_stream.h"
 #include "linker/file_output_stream.h"
 #include "mirror/array-inl.h"
@@ -75,6 +80,7 @@
 #include "well_known_classes.h"
 
 #include <sys/stat.h>
+#include <unistd.h>
 #include "cmdline.h"
 
 namespace art {
@@ -112,6 +118,47 @@ const DexFile* OpenDexFile(const OatFile::OatDexFile* oat_dex_file, std::string*
   return ret;
 }
 
+// Calls visitor(index, worker) for each index in [0, count) on `num_threads` worker threads,
+// handing out the indexes in increasing order as the workers become idle. If there is a runtime,
+// the workers are attached to it so that they can run the verifier, and the calling thread is
+// suspended while it waits for them.
+template <typename Visitor>
+static void ParallelFor(size_t count, size_t num_threads, const Visitor& visitor)
+    NO_THREAD_SAFETY_ANALYSIS {
+  Runtime* const runtime = Runtime::Current();
+  Atomic<size_t> next_index(0u);
+  auto worker_main = [&](size_t worker) {
+    if (runtime != nullptr) {
+      CHECK(runtime->AttachCurrentThread("oatdump worker",
+                                         /* as_daemon */ true,
+                                         /* thread_group */ nullptr,
+                                         /* create_peer */ false));
+    }
+    while (true) {
+      size_t index = next_index.FetchAndAddSequentiallyConsistent(1u);
+      if (index >= count) {
+        break;
+      }
+      visitor(index, worker);
+    }
+    if (runtime != nullptr) {
+      runtime->DetachCurrentThread();
+    }
+  };
+  Thread* const self = Thread::Current();
+  std::unique_ptr<ScopedThreadSuspension> sts;
+  if (self != nullptr) {
+    sts.reset(new ScopedThreadSuspension(self, kNative));
+  }
+  std::vector<std::thread> workers;
+  for (size_t worker = 0, end = std::min(num_threads, count); worker != end; ++worker) {
+    workers.emplace_back(worker_main, worker);
+  }
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+}
+
 template <typename ElfTypes>
 class OatSymbolizer FINAL {
  public:
@@ -323,7 +370,10 @@ class OatDumperOptions {
                    const char* export_dex_location,
                    const char* app_image,
                    const char* app_oat,
-                   uint32_t addr2instr)
+                   uint32_t addr2instr,
+                   const char* code_hotness_profile,
+                   bool stats_only,
+                   size_t num_threads)
     : dump_vmap_(dump_vmap),
       dump_code_info_stack_maps_(dump_code_info_stack_maps),
       disassemble_code_(disassemble_code),
@@ -337,6 +387,9 @@ class OatDumperOptions {
       app_image_(app_image),
       app_oat_(app_oat),
       addr2instr_(addr2instr),
+      code_hotness_profile_(code_hotness_profile),
+      stats_only_(stats_only),
+      num_threads_(num_threads),
       class_loader_(nullptr) {}
 
   const bool dump_vmap_;
@@ -352,6 +405,9 @@ class OatDumperOptions {
   const char* const app_image_;
   const char* const app_oat_;
   uint32_t addr2instr_;
+  const char* const code_hotness_profile_;
+  const bool stats_only_;
+  const size_t num_threads_;
   Handle<mirror::ClassLoader>* class_loader_;
 };
 
@@ -363,15 +419,7 @@ class OatDumper {
       options_(options),
       resolved_addr2instr_(0),
       instruction_set_(oat_file_.GetOatHeader().GetInstructionSet()),
-      disassembler_(Disassembler::Create(instruction_set_,
-                                         new DisassemblerOptions(
-                                             options_.absolute_addresses_,
-                                             oat_file.Begin(),
-                                             oat_file.End(),
-                                             true /* can_read_literals_ */,
-                                             Is64BitInstructionSet(instruction_set_)
-                                                 ? &Thread::DumpThreadOffset<PointerSize::k64>
-                                                 : &Thread::DumpThreadOffset<PointerSize::k32>))) {
+      disassembler_(CreateDisassembler()) {
     CHECK(options_.class_loader_ != nullptr);
     CHECK(options_.class_filter_ != nullptr);
     CHECK(options_.method_filter_ != nullptr);
@@ -386,6 +434,19 @@ class OatDumper {
     return instruction_set_;
   }
 
+  // Disassemblers keep state between instructions, so each thread dumping code needs its own.
+  Disassembler* CreateDisassembler() const {
+    return Disassembler::Create(instruction_set_,
+                                new DisassemblerOptions(
+                                    options_.absolute_addresses_,
+                                    oat_file_.Begin(),
+                                    oat_file_.End(),
+                                    true /* can_read_literals_ */,
+                                    Is64BitInstructionSet(instruction_set_)
+                                        ? &Thread::DumpThreadOffset<PointerSize::k64>
+                                        : &Thread::DumpThreadOffset<PointerSize::k32>));
+  }
+
   bool Dump(std::ostream& os) {
     bool success = true;
     const OatHeader& oat_header = oat_file_.GetOatHeader();
@@ -438,6 +499,11 @@ class OatDumper {
                            GetQuickToInterpreterBridgeOffset);
 #undef DUMP_OAT_HEADER_OFFSET
 
+    os << "HOT CODE:\n";
+    os << StringPrintf("0x%08x (size 0x%08x)\n\n",
+                       oat_header.GetHotCodeOffset(),
+                       oat_header.GetHotCodeSize());
+
     os << "IMAGE PATCH DELTA:\n";
     os << StringPrintf("%d (0x%08x)\n\n",
                        oat_header.GetImagePatchDelta(),
@@ -511,7 +577,14 @@ class OatDumper {
     cumulative.Dump(os);
     os << "\n";
 
-    if (!options_.dump_header_only_) {
+    if (!options_.dump_header_only_ && options_.stats_only_) {
+      for (const OatFile::OatDexFile* oat_dex_file : oat_dex_files_) {
+        CHECK(oat_dex_file != nullptr);
+        if (!AddOatDexFileStats(os, *oat_dex_file)) {
+          success = false;
+        }
+      }
+    } else if (!options_.dump_header_only_) {
       VariableIndentationOutputStream vios(&os);
       VdexFile::Header vdex_header = oat_file_.GetVdexFile()->GetHeader();
       if (vdex_header.IsValid()) {
@@ -557,10 +630,202 @@ class OatDumper {
       stats_.Dump(vios);
     }
 
+    InstructionSet isa = oat_file_.GetOatHeader().GetInstructionSet();
+    if (isa == kArm || isa == kThumb2 || isa == kArm64) {
+      if (!DumpThunkStats(os)) {
+        success = false;
+      }
+    }
+
+    if (options_.code_hotness_profile_ != nullptr) {
+      if (!DumpCodeHotness(os)) {
+        success = false;
+      }
+    }
+
     os << std::flush;
     return success;
   }
 
+  // Dumps the islands of linker thunks placed between the methods of the executable section.
+  // An island is a gap between method code and the next method header that holds more than
+  // code alignment padding. Islands with the same contents hold the same thunks.
+  bool DumpThunkStats(std::ostream& os) {
+    std::map<uint32_t, uint32_t> method_regions;  // Start of method header -> end of code.
+    for (const OatFile::OatDexFile* oat_dex_file : oat_dex_files_) {
+      std::string error_msg;
+      const DexFile* const dex_file = OpenDexFile(oat_dex_file, &error_msg);
+      if (dex_file == nullptr) {
+        os << "Failed to open dex file '" << oat_dex_file->GetDexFileLocation() << "': "
+           << error_msg << "\n";
+        return false;
+      }
+      for (size_t class_def_index = 0;
+           class_def_index < dex_file->NumClassDefs();
+           class_def_index++) {
+        const DexFile::ClassDef& class_def = dex_file->GetClassDef(class_def_index);
+        const OatFile::OatClass oat_class = oat_dex_file->GetOatClass(class_def_index);
+        const uint8_t* class_data = dex_file->GetClassData(class_def);
+        if (class_data == nullptr) {
+          continue;
+        }
+        ClassDataItemIterator it(*dex_file, class_data);
+        it.SkipAllFields();
+        for (uint32_t class_method_index = 0; it.HasNext(); ++class_method_index, it.Next()) {
+          const OatFile::OatMethod oat_method = oat_class.GetOatMethod(class_method_index);
+          uint32_t code_offset = AlignCodeOffset(oat_method.GetCodeOffset());
+          uint32_t code_size = oat_method.GetQuickCodeSize();
+          if (code_offset != 0u && code_size != 0u) {
+            method_regions.emplace(code_offset - sizeof(OatQuickMethodHeader),
+                                   code_offset + code_size);
+          }
+        }
+      }
+    }
+
+    size_t num_islands = 0u;
+    size_t island_bytes = 0u;
+    size_t num_duplicate_islands = 0u;
+    size_t duplicate_island_bytes = 0u;
+    std::set<std::string> seen_islands;
+    const uint8_t* oat_begin = oat_file_.Begin();
+    const size_t instruction_alignment =
+        GetInstructionSetInstructionAlignment(oat_file_.GetOatHeader().GetInstructionSet());
+    auto visit_gap = [&](uint32_t begin, uint32_t end) {
+      while (begin != end && oat_begin[begin] == 0u) {
+        ++begin;
+      }
+      while (end != begin && oat_begin[end - 1u] == 0u) {
+        --end;
+      }
+      if (begin == end) {
+        return;  // Just padding.
+      }
+      begin = RoundDown(begin, instruction_alignment);
+      end = RoundUp(end, instruction_alignment);
+      ++num_islands;
+      island_bytes += end - begin;
+      std::string contents(reinterpret_cast<const char*>(oat_begin + begin), end - begin);
+      if (!seen_islands.insert(contents).second) {
+        ++num_duplicate_islands;
+        duplicate_island_bytes += end - begin;
+      }
+    };
+    uint32_t previous_end = 0u;
+    for (const auto& region : method_regions) {
+      if (previous_end != 0u && region.first > previous_end) {
+        visit_gap(previous_end, region.first);
+      }
+      previous_end = std::max(previous_end, region.second);
+    }
+    if (previous_end != 0u && oat_file_.Size() > previous_end) {
+      visit_gap(previous_end, oat_file_.Size());
+    }
+
+    os << "THUNK STATS:\n";
+    os << StringPrintf("  islands: %zu, %zu bytes\n", num_islands, island_bytes);
+    os << StringPrintf("  islands identical to a previous island: %zu, %zu bytes\n",
+                       num_duplicate_islands,
+                       duplicate_island_bytes);
+    os << std::flush;
+    return true;
+  }
+
+  // Dumps how many bytes of the code of the startup, hot, post-startup and other methods of
+  // the profile are on each page of the executable section. Code shared by several methods
+  // is accounted to the first of them.
+  bool DumpCodeHotness(std::ostream& os) {
+    ProfileCompilationInfo profile;
+    if (!profile.Load(options_.code_hotness_profile_, /* clear_if_invalid */ false)) {
+      os << "Failed to load profile " << options_.code_hotness_profile_ << "\n";
+      return false;
+    }
+
+    enum CodeHotness {
+      kCodeHotnessStartup,
+      kCodeHotnessHot,
+      kCodeHotnessPostStartup,
+      kCodeHotnessOther,
+      kCodeHotnessCount,
+    };
+    static const char* const kCodeHotnessNames[kCodeHotnessCount] = {
+        "startup", "hot", "post-startup", "other"
+    };
+    const uint32_t executable_offset = oat_file_.GetOatHeader().GetExecutableOffset();
+    std::vector<std::array<uint32_t, kCodeHotnessCount>> pages;
+    std::unordered_set<uint32_t> seen_code_offsets;
+    for (const OatFile::OatDexFile* oat_dex_file : oat_dex_files_) {
+      std::string error_msg;
+      const DexFile* const dex_file = OpenDexFile(oat_dex_file, &error_msg);
+      if (dex_file == nullptr) {
+        os << "Failed to open dex file '" << oat_dex_file->GetDexFileLocation() << "': "
+           << error_msg << "\n";
+        return false;
+      }
+      for (size_t class_def_index = 0;
+           class_def_index < dex_file->NumClassDefs();
+           class_def_index++) {
+        const DexFile::ClassDef& class_def = dex_file->GetClassDef(class_def_index);
+        const OatFile::OatClass oat_class = oat_dex_file->GetOatClass(class_def_index);
+        const uint8_t* class_data = dex_file->GetClassData(class_def);
+        if (class_data == nullptr) {
+          continue;
+        }
+        ClassDataItemIterator it(*dex_file, class_data);
+        it.SkipAllFields();
+        for (uint32_t class_method_index = 0; it.HasNext(); ++class_method_index, it.Next()) {
+          const OatFile::OatMethod oat_method = oat_class.GetOatMethod(class_method_index);
+          uint32_t code_offset = AlignCodeOffset(oat_method.GetCodeOffset());
+          uint32_t code_size = oat_method.GetQuickCodeSize();
+          if (code_offset == 0u || code_size == 0u ||
+              !seen_code_offsets.insert(code_offset).second) {
+            continue;
+          }
+          ProfileCompilationInfo::MethodHotness hotness =
+              profile.GetMethodHotness(MethodReference(dex_file, it.GetMemberIndex()));
+          CodeHotness code_hotness = hotness.IsStartup()
+              ? kCodeHotnessStartup
+              : hotness.IsHot()
+                  ? kCodeHotnessHot
+                  : hotness.IsPostStartup() ? kCodeHotnessPostStartup : kCodeHotnessOther;
+          uint32_t begin = code_offset - executable_offset;
+          uint32_t end = begin + code_size;
+          if (pages.size() < RoundUp(end, kPageSize) / kPageSize) {
+            pages.resize(RoundUp(end, kPageSize) / kPageSize);
+          }
+          while (begin != end) {
+            size_t page = begin / kPageSize;
+            uint32_t page_end = std::min<uint32_t>(end, (page + 1u) * kPageSize);
+            pages[page][code_hotness] += page_end - begin;
+            begin = page_end;
+          }
+        }
+      }
+    }
+
+    os << "CODE HOTNESS (bytes of code per " << kPageSize << " byte page of the executable "
+       << "section):\n";
+    size_t pages_with_code[kCodeHotnessCount] = {};
+    for (size_t page = 0; page != pages.size(); ++page) {
+      os << StringPrintf("  0x%08zx:", page * kPageSize);
+      for (size_t i = 0; i != kCodeHotnessCount; ++i) {
+        os << " " << kCodeHotnessNames[i] << "=" << pages[page][i];
+        if (pages[page][i] != 0u) {
+          ++pages_with_code[i];
+        }
+      }
+      os << "\n";
+    }
+    os << "  Pages with code of";
+    for (size_t i = 0; i != kCodeHotnessCount; ++i) {
+      os << " " << kCodeHotnessNames[i] << " methods: " << pages_with_code[i]
+         << (i + 1u != kCodeHotnessCount ? "," : "");
+    }
+    os << " (" << pages.size() << " pages in total)\n";
+    os << std::flush;
+    return true;
+  }
+
   size_t ComputeSize(const void* oat_data) {
     if (reinterpret_cast<const uint8_t*>(oat_data) < oat_file_.Begin() ||
         reinterpret_cast<const uint8_t*>(oat_data) > oat_file_.End()) {
@@ -634,18 +899,22 @@ class OatDumper {
     // Since code has deduplication, seen tracks already seen pointers to avoid double counting
     // deduplicated code and tables.
     std::unordered_set<const void*> seen;
+    // Guards bits and seen while classes are dumped in parallel.
+    Mutex lock{"oatdump stats lock"};
 
     // Returns true if it was newly added.
     bool AddBitsIfUnique(ByteKind kind, int64_t count, const void* address) {
+      MutexLock mu(Thread::Current(), lock);
       if (seen.insert(address).second == true) {
         // True means the address was not already in the set.
-        AddBits(kind, count);
+        bits[kind] += count;
         return true;
       }
       return false;
     }
 
     void AddBits(ByteKind kind, int64_t count) {
+      MutexLock mu(Thread::Current(), lock);
       bits[kind] += count;
     }
 
@@ -967,35 +1236,56 @@ class OatDumper {
                          table_offset + table_size - 1);
     }
 
-    VariableIndentationOutputStream vios(&os);
-    ScopedIndentation indent1(&vios);
-    for (size_t class_def_index = 0;
-         class_def_index < dex_file->NumClassDefs();
-         class_def_index++) {
-      const DexFile::ClassDef& class_def = dex_file->GetClassDef(class_def_index);
-      const char* descriptor = dex_file->GetClassDescriptor(class_def);
-
-      // TODO: Support regex
-      if (DescriptorToDot(descriptor).find(options_.class_filter_) == std::string::npos) {
-        continue;
-      }
-
-      uint32_t oat_class_offset = oat_dex_file.GetOatClassOffset(class_def_index);
-      const OatFile::OatClass oat_class = oat_dex_file.GetOatClass(class_def_index);
-      os << StringPrintf("%zd: %s (offset=0x%08x) (type_idx=%d)",
-                         class_def_index, descriptor, oat_class_offset, class_def.class_idx_.index_)
-         << " (" << oat_class.GetStatus() << ")"
-         << " (" << oat_class.GetType() << ")\n";
-      // TODO: include bitmap here if type is kOatClassSomeCompiled?
-      if (options_.list_classes_) {
-        continue;
+    const size_t num_class_defs = dex_file->NumClassDefs();
+    if (options_.num_threads_ <= 1u || options_.list_classes_ || resolved_addr2instr_ != 0) {
+      VariableIndentationOutputStream vios(&os);
+      ScopedIndentation indent1(&vios);
+      for (size_t class_def_index = 0; class_def_index < num_class_defs; class_def_index++) {
+        if (!DumpOatDexClass(os, &vios, oat_dex_file, *dex_file, class_def_index, disassembler_,
+                             &stop_analysis)) {
+          success = false;
+        }
+        if (stop_analysis) {
+          os << std::flush;
+          return success;
+        }
       }
-      if (!DumpOatClass(&vios, oat_class, *dex_file, class_def, &stop_analysis)) {
-        success = false;
+    } else {
+      // Dump the classes of a batch into separate buffers in parallel, then write the buffers
+      // out in class order. The batches bound the memory used for buffering.
+      const size_t batch_size = options_.num_threads_ * kClassesPerThreadPerBatch;
+      std::vector<std::unique_ptr<Disassembler>> disassemblers(options_.num_threads_);
+      for (std::unique_ptr<Disassembler>& disassembler : disassemblers) {
+        disassembler.reset(CreateDisassembler());
       }
-      if (stop_analysis) {
-        os << std::flush;
-        return success;
+      std::vector<std::string> outputs(batch_size);
+      std::unique_ptr<bool[]> failed(new bool[batch_size]);
+      for (size_t batch_begin = 0; batch_begin < num_class_defs; batch_begin += batch_size) {
+        const size_t batch_end = std::min(batch_begin + batch_size, num_class_defs);
+        std::fill_n(failed.get(), batch_size, false);
+        ParallelFor(batch_end - batch_begin,
+                    options_.num_threads_,
+                    [&](size_t i, size_t worker) {
+          std::ostringstream class_os;
+          VariableIndentationOutputStream class_vios(&class_os);
+          ScopedIndentation indent1(&class_vios);
+          bool unused_stop_analysis = false;  // Only set for --addr2instr.
+          failed[i] = !DumpOatDexClass(class_os,
+                                       &class_vios,
+                                       oat_dex_file,
+                                       *dex_file,
+                                       batch_begin + i,
+                                       disassemblers[worker].get(),
+                                       &unused_stop_analysis);
+          outputs[i] = class_os.str();
+        });
+        for (size_t i = 0; i != batch_end - batch_begin; ++i) {
+          os << outputs[i];
+          outputs[i].clear();
+          if (failed[i]) {
+            success = false;
+          }
+        }
       }
     }
     os << "\n";
@@ -1003,6 +1293,129 @@ class OatDumper {
     return success;
   }
 
+  // Dumps the class unless the class filter excludes it. Returns false if the class has bad
+  // data. The class line goes to `os` and the methods go indented to `vios`, which wraps `os`.
+  bool DumpOatDexClass(std::ostream& os,
+                       VariableIndentationOutputStream* vios,
+                       const OatFile::OatDexFile& oat_dex_file,
+                       const DexFile& dex_file,
+                       size_t class_def_index,
+                       Disassembler* disassembler,
+                       bool* stop_analysis) {
+    const DexFile::ClassDef& class_def = dex_file.GetClassDef(class_def_index);
+    const char* descriptor = dex_file.GetClassDescriptor(class_def);
+
+    // TODO: Support regex
+    if (DescriptorToDot(descriptor).find(options_.class_filter_) == std::string::npos) {
+      return true;
+    }
+
+    uint32_t oat_class_offset = oat_dex_file.GetOatClassOffset(class_def_index);
+    const OatFile::OatClass oat_class = oat_dex_file.GetOatClass(class_def_index);
+    os << StringPrintf("%zd: %s (offset=0x%08x) (type_idx=%d)",
+                       class_def_index, descriptor, oat_class_offset, class_def.class_idx_.index_)
+       << " (" << oat_class.GetStatus() << ")"
+       << " (" << oat_class.GetType() << ")\n";
+    // TODO: include bitmap here if type is kOatClassSomeCompiled?
+    if (options_.list_classes_) {
+      return true;
+    }
+    return DumpOatClass(vios, oat_class, dex_file, class_def, disassembler, stop_analysis);
+  }
+
+  // Adds the sizes of the compiled code of the dex file to the stats without dumping anything,
+  // for --stats-only.
+  bool AddOatDexFileStats(std::ostream& os, const OatFile::OatDexFile& oat_dex_file) {
+    std::string error_msg;
+    const DexFile* const dex_file = OpenDexFile(&oat_dex_file, &error_msg);
+    if (dex_file == nullptr) {
+      os << "Failed to open dex file '" << oat_dex_file.GetDexFileLocation() << "': "
+         << error_msg << "\n";
+      return false;
+    }
+    auto add_class_stats = [&](size_t class_def_index, size_t worker ATTRIBUTE_UNUSED) {
+      AddOatClassStats(oat_dex_file, *dex_file, class_def_index);
+    };
+    if (options_.num_threads_ <= 1u) {
+      for (size_t class_def_index = 0;
+           class_def_index < dex_file->NumClassDefs();
+           ++class_def_index) {
+        add_class_stats(class_def_index, 0u);
+      }
+    } else {
+      ParallelFor(dex_file->NumClassDefs(), options_.num_threads_, add_class_stats);
+    }
+    return true;
+  }
+
+  void AddOatClassStats(const OatFile::OatDexFile& oat_dex_file,
+                        const DexFile& dex_file,
+                        size_t class_def_index) {
+    const DexFile::ClassDef& class_def = dex_file.GetClassDef(class_def_index);
+    // TODO: Support regex
+    if (DescriptorToDot(dex_file.GetClassDescriptor(class_def)).find(options_.class_filter_) ==
+        std::string::npos) {
+      return;
+    }
+    const uint8_t* class_data = dex_file.GetClassData(class_def);
+    if (class_data == nullptr) {  // empty class such as a marker interface?
+      return;
+    }
+    const OatFile::OatClass oat_class = oat_dex_file.GetOatClass(class_def_index);
+    ClassDataItemIterator it(dex_file, class_data);
+    it.SkipAllFields();
+    for (uint32_t class_method_index = 0; it.HasNext(); ++class_method_index, it.Next()) {
+      std::string method_name = dex_file.GetMethodName(dex_file.GetMethodId(it.GetMemberIndex()));
+      if (method_name.find(options_.method_filter_) != std::string::npos) {
+        AddOatMethodStats(oat_class, class_method_index, it.GetMethodCodeItem());
+      }
+    }
+  }
+
+  // Adds what DumpOatMethod() would add to the stats, with the same checks.
+  void AddOatMethodStats(const OatFile::OatClass& oat_class,
+                         uint32_t class_method_index,
+                         const DexFile::CodeItem* code_item) {
+    if (oat_class.GetOatMethodOffsetsOffset(class_method_index) > oat_file_.Size()) {
+      return;
+    }
+    const OatFile::OatMethod oat_method = oat_class.GetOatMethod(class_method_index);
+    bool bad_input = AlignCodeOffset(oat_method.GetCodeOffset()) > oat_file_.Size();
+    const OatQuickMethodHeader* method_header = oat_method.GetOatQuickMethodHeader();
+    stats_.AddBitsIfUnique(Stats::kByteKindQuickMethodHeader,
+                           sizeof(*method_header) * kBitsPerByte,
+                           method_header);
+    if (method_header == nullptr ||
+        oat_method.GetOatQuickMethodHeaderOffset() > oat_file_.Size()) {
+      return;
+    }
+    size_t vmap_table_offset_limit =
+        (kIsVdexEnabled && IsMethodGeneratedByDexToDexCompiler(oat_method, code_item))
+            ? oat_file_.GetVdexFile()->Size()
+            : method_header->GetCode() - oat_file_.Begin();
+    if (method_header->GetVmapTableOffset() >= vmap_table_offset_limit) {
+      bad_input = true;
+    }
+    if (oat_method.GetQuickCodeSizeOffset() > oat_file_.Size()) {
+      return;
+    }
+    const void* code = oat_method.GetQuickCode();
+    uint32_t code_size = oat_method.GetQuickCodeSize();
+    stats_.AddBitsIfUnique(Stats::kByteKindCode, code_size * kBitsPerByte, code);
+    uint64_t aligned_code_end = AlignCodeOffset(oat_method.GetCodeOffset()) + code_size;
+    if (bad_input ||
+        code == nullptr ||
+        code_size == 0 ||
+        code_size > kMaxCodeSize ||
+        aligned_code_end > oat_file_.Size()) {
+      return;
+    }
+    if (IsMethodGeneratedByOptimizingCompiler(oat_method, code_item)) {
+      CodeInfo code_info(oat_method.GetVmapTable());
+      AddCodeInfoStats(oat_method, code_item, code_info, code_info.ExtractEncoding());
+    }
+  }
+
   bool ExportDexFile(std::ostream& os, const OatFile::OatDexFile& oat_dex_file) {
     std::string error_msg;
     std::string dex_file_location = oat_dex_file.GetDexFileLocation();
@@ -1012,6 +1425,11 @@ class OatDumper {
       os << "Failed to open dex file '" << dex_file_location << "': " << error_msg;
       return false;
     }
+    if (dex_file->IsCompactDexFile()) {
+      // The data items are in the data section shared with the other dex files of the vdex.
+      os << "Cannot export compact dex file '" << dex_file_location << "'\n";
+      return false;
+    }
     size_t fsize = oat_dex_file.FileSize();
 
     // Some quick checks just in case
@@ -1085,7 +1503,8 @@ class OatDumper {
 
   bool DumpOatClass(VariableIndentationOutputStream* vios,
                     const OatFile::OatClass& oat_class, const DexFile& dex_file,
-                    const DexFile::ClassDef& class_def, bool* stop_analysis) {
+                    const DexFile::ClassDef& class_def, Disassembler* disassembler,
+                    bool* stop_analysis) {
     bool success = true;
     bool addr_found = false;
     const uint8_t* class_data = dex_file.GetClassData(class_def);
@@ -1099,7 +1518,7 @@ class OatDumper {
     while (it.HasNextDirectMethod()) {
       if (!DumpOatMethod(vios, class_def, class_method_index, oat_class, dex_file,
                          it.GetMemberIndex(), it.GetMethodCodeItem(),
-                         it.GetRawMemberAccessFlags(), &addr_found)) {
+                         it.GetRawMemberAccessFlags(), disassembler, &addr_found)) {
         success = false;
       }
       if (addr_found) {
@@ -1112,7 +1531,7 @@ class OatDumper {
     while (it.HasNextVirtualMethod()) {
       if (!DumpOatMethod(vios, class_def, class_method_index, oat_class, dex_file,
                          it.GetMemberIndex(), it.GetMethodCodeItem(),
-                         it.GetRawMemberAccessFlags(), &addr_found)) {
+                         it.GetRawMemberAccessFlags(), disassembler, &addr_found)) {
         success = false;
       }
       if (addr_found) {
@@ -1132,12 +1551,16 @@ class OatDumper {
   // When this was picked, the largest arm method was 55,256 bytes and arm64 was 50,412 bytes.
   static constexpr uint32_t kMaxCodeSize = 100 * 1000;
 
+  // Classes dumped in parallel are buffered in memory until all classes before them are done.
+  static constexpr size_t kClassesPerThreadPerBatch = 16;
+
   bool DumpOatMethod(VariableIndentationOutputStream* vios,
                      const DexFile::ClassDef& class_def,
                      uint32_t class_method_index,
                      const OatFile::OatClass& oat_class, const DexFile& dex_file,
                      uint32_t dex_method_idx, const DexFile::CodeItem* code_item,
-                     uint32_t method_access_flags, bool* addr_found) {
+                     uint32_t method_access_flags, Disassembler* disassembler,
+                     bool* addr_found) {
     bool success = true;
 
     // TODO: Support regex
@@ -1317,7 +1740,7 @@ class OatDumper {
           success = false;
           if (options_.disassemble_code_) {
             if (code_size_offset + kPrologueBytes <= oat_file_.Size()) {
-              DumpCode(vios, oat_method, code_item, true, kPrologueBytes);
+              DumpCode(vios, disassembler, oat_method, code_item, true, kPrologueBytes);
             }
           }
         } else if (code_size > kMaxCodeSize) {
@@ -1330,11 +1753,11 @@ class OatDumper {
           success = false;
           if (options_.disassemble_code_) {
             if (code_size_offset + kPrologueBytes <= oat_file_.Size()) {
-              DumpCode(vios, oat_method, code_item, true, kPrologueBytes);
+              DumpCode(vios, disassembler, oat_method, code_item, true, kPrologueBytes);
             }
           }
         } else if (options_.disassemble_code_) {
-          DumpCode(vios, oat_method, code_item, !success, 0);
+          DumpCode(vios, disassembler, oat_method, code_item, !success, 0);
         }
       }
     }
@@ -1641,7 +2064,88 @@ class OatDumper {
     const InstructionSet instruction_set_;
   };
 
+  void AddCodeInfoStats(const OatFile::OatMethod& oat_method,
+                        const DexFile::CodeItem* code_item,
+                        const CodeInfo& code_info,
+                        const CodeInfoEncoding& encoding) {
+    StackMapEncoding stack_map_encoding(encoding.stack_map.encoding);
+    const size_t num_stack_maps = encoding.stack_map.num_entries;
+    if (stats_.AddBitsIfUnique(Stats::kByteKindCodeInfoEncoding,
+                               encoding.HeaderSize() * kBitsPerByte,
+                               oat_method.GetVmapTable())) {
+      // Stack maps
+      stats_.AddBits(
+          Stats::kByteKindStackMapNativePc,
+          stack_map_encoding.GetNativePcEncoding().BitSize() * num_stack_maps);
+      stats_.AddBits(
+          Stats::kByteKindStackMapDexPc,
+          stack_map_encoding.GetDexPcEncoding().BitSize() * num_stack_maps);
+      stats_.AddBits(
+          Stats::kByteKindStackMapDexRegisterMap,
+          stack_map_encoding.GetDexRegisterMapEncoding().BitSize() * num_stack_maps);
+      stats_.AddBits(
+          Stats::kByteKindStackMapInlineInfoIndex,
+          stack_map_encoding.GetInlineInfoEncoding().BitSize() * num_stack_maps);
+      stats_.AddBits(
+          Stats::kByteKindStackMapRegisterMaskIndex,
+          stack_map_encoding.GetRegisterMaskIndexEncoding().BitSize() * num_stack_maps);
+      stats_.AddBits(
+          Stats::kByteKindStackMapStackMaskIndex,
+          stack_map_encoding.GetStackMaskIndexEncoding().BitSize() * num_stack_maps);
+
+      // Stack masks
+      stats_.AddBits(
+          Stats::kByteKindCodeInfoStackMasks,
+          encoding.stack_mask.encoding.BitSize() * encoding.stack_mask.num_entries);
+
+      // Register masks
+      stats_.AddBits(
+          Stats::kByteKindCodeInfoRegisterMasks,
+          encoding.register_mask.encoding.BitSize() * encoding.register_mask.num_entries);
+
+      // Invoke infos
+      if (encoding.invoke_info.num_entries > 0u) {
+        stats_.AddBits(
+            Stats::kByteKindCodeInfoInvokeInfo,
+            encoding.invoke_info.encoding.BitSize() * encoding.invoke_info.num_entries);
+      }
+
+      // Location catalog
+      const size_t location_catalog_bytes =
+          code_info.GetDexRegisterLocationCatalogSize(encoding);
+      stats_.AddBits(Stats::kByteKindCodeInfoLocationCatalog,
+                     kBitsPerByte * location_catalog_bytes);
+      // Dex register bytes.
+      const size_t dex_register_bytes =
+          code_info.GetDexRegisterMapsSize(encoding, code_item->registers_size_);
+      stats_.AddBits(
+          Stats::kByteKindCodeInfoDexRegisterMap,
+          kBitsPerByte * dex_register_bytes);
+
+      // Inline infos.
+      const size_t num_inline_infos = encoding.inline_info.num_entries;
+      if (num_inline_infos > 0u) {
+        stats_.AddBits(
+            Stats::kByteKindInlineInfoMethodIndexIdx,
+            encoding.inline_info.encoding.GetMethodIndexIdxEncoding().BitSize() *
+                num_inline_infos);
+        stats_.AddBits(
+            Stats::kByteKindInlineInfoDexPc,
+            encoding.inline_info.encoding.GetDexPcEncoding().BitSize() * num_inline_infos);
+        stats_.AddBits(
+            Stats::kByteKindInlineInfoExtraData,
+            encoding.inline_info.encoding.GetExtraDataEncoding().BitSize() * num_inline_infos);
+        stats_.AddBits(
+            Stats::kByteKindInlineInfoDexRegisterMap,
+            encoding.inline_info.encoding.GetDexRegisterMapEncoding().BitSize() *
+                num_inline_infos);
+        stats_.AddBits(Stats::kByteKindInlineInfoIsLast, num_inline_infos);
+      }
+    }
+  }
+
   void DumpCode(VariableIndentationOutputStream* vios,
+                Disassembler* disassembler,
                 const OatFile::OatMethod& oat_method, const DexFile::CodeItem* code_item,
                 bool bad_input, size_t code_size) {
     const void* quick_code = oat_method.GetQuickCode();
@@ -1656,87 +2160,11 @@ class OatDumper {
       // The optimizing compiler outputs its CodeInfo data in the vmap table.
       StackMapsHelper helper(oat_method.GetVmapTable(), instruction_set_);
       MethodInfo method_info(oat_method.GetOatQuickMethodHeader()->GetOptimizedMethodInfo());
-      {
-        CodeInfoEncoding encoding(helper.GetEncoding());
-        StackMapEncoding stack_map_encoding(encoding.stack_map.encoding);
-        const size_t num_stack_maps = encoding.stack_map.num_entries;
-        if (stats_.AddBitsIfUnique(Stats::kByteKindCodeInfoEncoding,
-                                   encoding.HeaderSize() * kBitsPerByte,
-                                   oat_method.GetVmapTable())) {
-          // Stack maps
-          stats_.AddBits(
-              Stats::kByteKindStackMapNativePc,
-              stack_map_encoding.GetNativePcEncoding().BitSize() * num_stack_maps);
-          stats_.AddBits(
-              Stats::kByteKindStackMapDexPc,
-              stack_map_encoding.GetDexPcEncoding().BitSize() * num_stack_maps);
-          stats_.AddBits(
-              Stats::kByteKindStackMapDexRegisterMap,
-              stack_map_encoding.GetDexRegisterMapEncoding().BitSize() * num_stack_maps);
-          stats_.AddBits(
-              Stats::kByteKindStackMapInlineInfoIndex,
-              stack_map_encoding.GetInlineInfoEncoding().BitSize() * num_stack_maps);
-          stats_.AddBits(
-              Stats::kByteKindStackMapRegisterMaskIndex,
-              stack_map_encoding.GetRegisterMaskIndexEncoding().BitSize() * num_stack_maps);
-          stats_.AddBits(
-              Stats::kByteKindStackMapStackMaskIndex,
-              stack_map_encoding.GetStackMaskIndexEncoding().BitSize() * num_stack_maps);
-
-          // Stack masks
-          stats_.AddBits(
-              Stats::kByteKindCodeInfoStackMasks,
-              encoding.stack_mask.encoding.BitSize() * encoding.stack_mask.num_entries);
-
-          // Register masks
-          stats_.AddBits(
-              Stats::kByteKindCodeInfoRegisterMasks,
-              encoding.register_mask.encoding.BitSize() * encoding.register_mask.num_entries);
-
-          // Invoke infos
-          if (encoding.invoke_info.num_entries > 0u) {
-            stats_.AddBits(
-                Stats::kByteKindCodeInfoInvokeInfo,
-                encoding.invoke_info.encoding.BitSize() * encoding.invoke_info.num_entries);
-          }
-
-          // Location catalog
-          const size_t location_catalog_bytes =
-              helper.GetCodeInfo().GetDexRegisterLocationCatalogSize(encoding);
-          stats_.AddBits(Stats::kByteKindCodeInfoLocationCatalog,
-                         kBitsPerByte * location_catalog_bytes);
-          // Dex register bytes.
-          const size_t dex_register_bytes =
-              helper.GetCodeInfo().GetDexRegisterMapsSize(encoding, code_item->registers_size_);
-          stats_.AddBits(
-              Stats::kByteKindCodeInfoDexRegisterMap,
-              kBitsPerByte * dex_register_bytes);
-
-          // Inline infos.
-          const size_t num_inline_infos = encoding.inline_info.num_entries;
-          if (num_inline_infos > 0u) {
-            stats_.AddBits(
-                Stats::kByteKindInlineInfoMethodIndexIdx,
-                encoding.inline_info.encoding.GetMethodIndexIdxEncoding().BitSize() *
-                    num_inline_infos);
-            stats_.AddBits(
-                Stats::kByteKindInlineInfoDexPc,
-                encoding.inline_info.encoding.GetDexPcEncoding().BitSize() * num_inline_infos);
-            stats_.AddBits(
-                Stats::kByteKindInlineInfoExtraData,
-                encoding.inline_info.encoding.GetExtraDataEncoding().BitSize() * num_inline_infos);
-            stats_.AddBits(
-                Stats::kByteKindInlineInfoDexRegisterMap,
-                encoding.inline_info.encoding.GetDexRegisterMapEncoding().BitSize() *
-                    num_inline_infos);
-            stats_.AddBits(Stats::kByteKindInlineInfoIsLast, num_inline_infos);
-          }
-        }
-      }
+      AddCodeInfoStats(oat_method, code_item, helper.GetCodeInfo(), helper.GetEncoding());
       const uint8_t* quick_native_pc = reinterpret_cast<const uint8_t*>(quick_code);
       size_t offset = 0;
       while (offset < code_size) {
-        offset += disassembler_->Dump(vios->Stream(), quick_native_pc + offset);
+        offset += disassembler->Dump(vios->Stream(), quick_native_pc + offset);
         if (offset == helper.GetOffset()) {
           ScopedIndentation indent1(vios);
           StackMap stack_map = helper.GetStackMap();
@@ -1759,7 +2187,7 @@ class OatDumper {
       const uint8_t* quick_native_pc = reinterpret_cast<const uint8_t*>(quick_code);
       size_t offset = 0;
       while (offset < code_size) {
-        offset += disassembler_->Dump(vios->Stream(), quick_native_pc + offset);
+        offset += disassembler->Dump(vios->Stream(), quick_native_pc + offset);
       }
     }
   }
@@ -3414,6 +3842,15 @@ struct OatdumpArgs : public CmdlineArgs {
       list_methods_ = true;
     } else if (option.starts_with("--export-dex-to=")) {
       export_dex_location_ = option.substr(strlen("--export-dex-to=")).data();
+    } else if (option.starts_with("--code-hotness=")) {
+      code_hotness_profile_ = option.substr(strlen("--code-hotness=")).data();
+    } else if (option == "--stats-only") {
+      stats_only_ = true;
+    } else if (option.starts_with("-j")) {
+      if (!ParseUint(option.substr(strlen("-j")).data(), &num_threads_) || num_threads_ == 0u) {
+        *error_msg = "-j must be followed by a positive number of threads";
+        return kParseError;
+      }
     } else if (option.starts_with("--addr2instr=")) {
       if (!ParseUint(option.substr(strlen("--addr2instr=")).data(), &addr2instr_)) {
         *error_msg = "Address conversion failed";
@@ -3520,6 +3957,19 @@ struct OatdumpArgs : public CmdlineArgs {
         "  --export-dex-to=<directory>: may be used to export oat embedded dex files.\n"
         "      Example: --export-dex-to=/data/local/tmp\n"
         "\n"
+        "  --code-hotness=<profile-file>: may be used to dump how many bytes of the code of\n"
+        "      the startup, hot, post-startup and other methods of the profile are on each\n"
+        "      page of the executable section.\n"
+        "      Example: --code-hotness=/data/misc/profiles/cur/0/com.example.foo/primary.prof\n"
+        "\n"
+        "  --stats-only may be used to compute the oat file stats, such as the code and\n"
+        "      CodeInfo size breakdown, without dumping or disassembling the methods.\n"
+        "      Example: --stats-only\n"
+        "\n"
+        "  -j<number>: specifies the number of threads used to dump the classes of each dex\n"
+        "      file. The output does not depend on it. Defaults to the number of CPUs.\n"
+        "      Example: -j1\n"
+        "\n"
         "  --addr2instr=<address>: output matching method disassembled code from relative\n"
         "                          address (e.g. PC from crash dump)\n"
         "      Example: --addr2instr=0x00001a3b\n"
@@ -3554,10 +4004,13 @@ struct OatdumpArgs : public CmdlineArgs {
   bool list_methods_ = false;
   bool dump_header_only_ = false;
   bool imt_stat_dump_ = false;
+  bool stats_only_ = false;
+  uint32_t num_threads_ = static_cast<uint32_t>(sysconf(_SC_NPROCESSORS_CONF));
   uint32_t addr2instr_ = 0;
   const char* export_dex_location_ = nullptr;
   const char* app_image_ = nullptr;
   const char* app_oat_ = nullptr;
+  const char* code_hotness_profile_ = nullptr;
 };
 
 struct OatdumpMain : public CmdlineMain<OatdumpArgs> {
@@ -3580,7 +4033,10 @@ struct OatdumpMain : public CmdlineMain<OatdumpArgs> {
         args_->export_dex_location_,
         args_->app_image_,
         args_->app_oat_,
-        args_->addr2instr_));
+        args_->addr2instr_,
+        args_->code_hotness_profile_,
+        args_->stats_only_,
+        args_->num_threads_));
 
     return (args_->boot_image_location_ != nullptr ||
             args_->image_location_ != nullptr ||
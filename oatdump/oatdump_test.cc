@@ -41,6 +41,21 @@ TEST_F(OatDumpTest, TestNoDisassembleStatic) {
   ASSERT_TRUE(Exec(kStatic, kModeArt, {"--no-disassemble"}, kListAndCode, &error_msg)) << error_msg;
 }
 
+TEST_F(OatDumpTest, TestStatsOnly) {
+  std::string error_msg;
+  ASSERT_TRUE(Exec(kDynamic, kModeArt, {"--stats-only"}, kListOnly, &error_msg)) << error_msg;
+}
+TEST_F(OatDumpTest, TestStatsOnlyStatic) {
+  TEST_DISABLED_FOR_NON_STATIC_HOST_BUILDS();
+  std::string error_msg;
+  ASSERT_TRUE(Exec(kStatic, kModeArt, {"--stats-only"}, kListOnly, &error_msg)) << error_msg;
+}
+
+TEST_F(OatDumpTest, TestMultipleThreads) {
+  std::string error_msg;
+  ASSERT_TRUE(Exec(kDynamic, kModeArt, {"-j4"}, kListAndCode, &error_msg)) << error_msg;
+}
+
 TEST_F(OatDumpTest, TestListClasses) {
   std::string error_msg;
   ASSERT_TRUE(Exec(kDynamic, kModeArt, {"--list-classes"}, kListOnly, &error_msg)) << error_msg;
@@ -14,8 +14,8 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <memory>
-#include <set>
 
 #include "boot_image_profile.h"
 #include "dex_file-inl.h"
@@ -26,18 +26,69 @@ namespace art {
 
 using Hotness = ProfileCompilationInfo::MethodHotness;
 
-void GenerateBootImageProfile(
+BootImageProfileAggregator::BootImageProfileAggregator(
     const std::vector<std::unique_ptr<const DexFile>>& dex_files,
-    const std::vector<std::unique_ptr<const ProfileCompilationInfo>>& profiles,
-    const BootImageOptions& options,
-    bool verbose,
-    ProfileCompilationInfo* out_profile) {
-  for (const std::unique_ptr<const ProfileCompilationInfo>& profile : profiles) {
-    // Avoid merging classes since we may want to only add classes that fit a certain criteria.
-    // If we merged the classes, every single class in each profile would be in the out_profile,
-    // but we want to only included classes that are in at least a few profiles.
-    out_profile->MergeWith(*profile, /*merge_classes*/ false);
+    const BootImageOptions& options)
+    : dex_files_(dex_files),
+      options_(options),
+      counts_(dex_files.size()) {
+  for (size_t i = 0; i < dex_files_.size(); ++i) {
+    counts_[i].method_counts.resize(dex_files_[i]->NumMethodIds(), 0u);
+    counts_[i].method_flags.resize(dex_files_[i]->NumMethodIds(), 0u);
+    counts_[i].class_counts.resize(dex_files_[i]->NumTypeIds(), 0u);
   }
+}
+
+void BootImageProfileAggregator::AddProfile(const ProfileCompilationInfo& profile) {
+  // Avoid merging classes since we may want to only add classes that fit a certain criteria.
+  // If we merged the classes, every single class in each profile would be in the out_profile,
+  // but we want to only included classes that are in at least a few profiles.
+  merged_methods_.MergeWith(profile, /*merge_classes*/ false);
+
+  for (size_t i = 0; i < dex_files_.size(); ++i) {
+    const DexFile& dex_file = *dex_files_[i];
+    if (!profile.GetMethodFlagsAndClasses(dex_file, &method_flags_, &classes_)) {
+      continue;
+    }
+    DexFileCounts& counts = counts_[i];
+    for (const std::pair<uint16_t, uint8_t>& method : method_flags_) {
+      if (method.first >= dex_file.NumMethodIds()) {
+        continue;
+      }
+      ++counts.method_counts[method.first];
+      counts.method_flags[method.first] |= method.second;
+      // Classes inferred from method samples count as in the profile.
+      classes_.push_back(dex_file.GetMethodId(method.first).class_idx_);
+    }
+    // Count each class once per profile.
+    std::sort(classes_.begin(), classes_.end());
+    classes_.erase(std::unique(classes_.begin(), classes_.end()), classes_.end());
+    for (dex::TypeIndex type_index : classes_) {
+      if (type_index.index_ < counts.class_counts.size()) {
+        ++counts.class_counts[type_index.index_];
+      }
+    }
+  }
+}
+
+void BootImageProfileAggregator::MergeWith(const BootImageProfileAggregator& other) {
+  DCHECK_EQ(counts_.size(), other.counts_.size());
+  merged_methods_.MergeWith(other.merged_methods_, /*merge_classes*/ false);
+  for (size_t i = 0; i < counts_.size(); ++i) {
+    DexFileCounts& counts = counts_[i];
+    const DexFileCounts& other_counts = other.counts_[i];
+    for (size_t j = 0; j < counts.method_counts.size(); ++j) {
+      counts.method_counts[j] += other_counts.method_counts[j];
+      counts.method_flags[j] |= other_counts.method_flags[j];
+    }
+    for (size_t j = 0; j < counts.class_counts.size(); ++j) {
+      counts.class_counts[j] += other_counts.class_counts[j];
+    }
+  }
+}
+
+void BootImageProfileAggregator::Finish(bool verbose, ProfileCompilationInfo* out_profile) const {
+  out_profile->MergeWith(merged_methods_, /*merge_classes*/ false);
 
   // Image classes that were added because they are commonly used.
   size_t class_count = 0;
@@ -48,35 +99,34 @@ void GenerateBootImageProfile(
   // Total dirty classes.
   size_t dirty_count = 0;
 
-  for (const std::unique_ptr<const DexFile>& dex_file : dex_files) {
-    // Inferred classes are classes inferred from method samples.
-    std::set<std::pair<const ProfileCompilationInfo*, dex::TypeIndex>> inferred_classes;
+  for (size_t dex_file_index = 0; dex_file_index < dex_files_.size(); ++dex_file_index) {
+    const DexFile* dex_file = dex_files_[dex_file_index].get();
+    const DexFileCounts& counts = counts_[dex_file_index];
     for (size_t i = 0; i < dex_file->NumMethodIds(); ++i) {
-      MethodReference ref(dex_file.get(), i);
-      // This counter is how many profiles contain the method as sampled or hot.
-      size_t counter = 0;
-      for (const std::unique_ptr<const ProfileCompilationInfo>& profile : profiles) {
-        Hotness hotness = profile->GetMethodHotness(ref);
-        if (hotness.IsInProfile()) {
-          ++counter;
-          out_profile->AddMethodHotness(ref, hotness);
-          inferred_classes.emplace(profile.get(),
-                                   dex_file->GetMethodId(ref.dex_method_index).class_idx_);
+      if (counts.method_counts[i] == 0u && options_.compiled_method_threshold != 0u) {
+        continue;
+      }
+      MethodReference ref(dex_file, i);
+      Hotness hotness;
+      for (Hotness::Flag flag : { Hotness::kFlagHot,
+                                  Hotness::kFlagStartup,
+                                  Hotness::kFlagPostStartup }) {
+        if ((counts.method_flags[i] & flag) != 0) {
+          hotness.AddFlag(flag);
         }
       }
       // If the counter is greater or equal to the compile threshold, mark the method as hot.
       // Note that all hot methods are also marked as hot in the out profile during the merging
       // process.
-      if (counter >= options.compiled_method_threshold) {
-        Hotness hotness;
+      if (counts.method_counts[i] >= options_.compiled_method_threshold) {
         hotness.AddFlag(Hotness::kFlagHot);
-        out_profile->AddMethodHotness(ref, hotness);
       }
+      out_profile->AddMethodHotness(ref, hotness);
     }
     // Walk all of the classes and add them to the profile if they meet the requirements.
     for (size_t i = 0; i < dex_file->NumClassDefs(); ++i) {
       const DexFile::ClassDef& class_def = dex_file->GetClassDef(i);
-      TypeReference ref(dex_file.get(), class_def.class_idx_);
+      TypeReference ref(dex_file, class_def.class_idx_);
       bool is_clean = true;
       const uint8_t* class_data = dex_file->GetClassData(class_def);
       if (class_data != nullptr) {
@@ -108,21 +158,14 @@ void GenerateBootImageProfile(
       }
       ++(is_clean ? clean_count : dirty_count);
       // This counter is how many profiles contain the class.
-      size_t counter = 0;
-      for (const std::unique_ptr<const ProfileCompilationInfo>& profile : profiles) {
-        auto it = inferred_classes.find(std::make_pair(profile.get(), ref.type_index));
-        if (it != inferred_classes.end() ||
-            profile->ContainsClass(*ref.dex_file, ref.type_index)) {
-          ++counter;
-        }
-      }
+      const size_t counter = counts.class_counts[ref.type_index.index_];
       if (counter == 0) {
         continue;
       }
-      if (counter >= options.image_class_theshold) {
+      if (counter >= options_.image_class_theshold) {
         ++class_count;
         out_profile->AddClassesForDex(ref.dex_file, &ref.type_index, &ref.type_index + 1);
-      } else if (is_clean && counter >= options.image_class_clean_theshold) {
+      } else if (is_clean && counter >= options_.image_class_clean_theshold) {
         ++clean_class_count;
         out_profile->AddClassesForDex(ref.dex_file, &ref.type_index, &ref.type_index + 1);
       }
@@ -135,4 +178,17 @@ void GenerateBootImageProfile(
   }
 }
 
+void GenerateBootImageProfile(
+    const std::vector<std::unique_ptr<const DexFile>>& dex_files,
+    const std::vector<std::unique_ptr<const ProfileCompilationInfo>>& profiles,
+    const BootImageOptions& options,
+    bool verbose,
+    ProfileCompilationInfo* out_profile) {
+  BootImageProfileAggregator aggregator(dex_files, options);
+  for (const std::unique_ptr<const ProfileCompilationInfo>& profile : profiles) {
+    aggregator.AddProfile(*profile);
+  }
+  aggregator.Finish(verbose, out_profile);
+}
+
 }  // namespace art
@@ -41,6 +41,45 @@ struct BootImageOptions {
   uint32_t compiled_method_threshold = std::numeric_limits<uint32_t>::max();
 };
 
+// Aggregates profiles into a boot profile one profile at a time, so that the profiles do not
+// all need to be in memory together. The counts are kept in flat vectors indexed by method and
+// type index. Aggregators are not thread safe, but several threads can each fill an aggregator
+// for a part of the profiles and then merge them.
+class BootImageProfileAggregator {
+ public:
+  BootImageProfileAggregator(const std::vector<std::unique_ptr<const DexFile>>& dex_files,
+                             const BootImageOptions& options);
+
+  // Add the classes and methods of `profile` to the counts.
+  void AddProfile(const ProfileCompilationInfo& profile);
+
+  // Add the counts of `other`, which must be for the same dex files and options.
+  void MergeWith(const BootImageProfileAggregator& other);
+
+  // Add the classes and methods that meet the options to out_profile.
+  void Finish(bool verbose, ProfileCompilationInfo* out_profile) const;
+
+ private:
+  struct DexFileCounts {
+    // Number of profiles with the method, by method index.
+    std::vector<uint32_t> method_counts;
+    // Union of the MethodHotness flags of the method over the profiles, by method index.
+    std::vector<uint8_t> method_flags;
+    // Number of profiles with the class, or with a method of the class, by type index.
+    std::vector<uint32_t> class_counts;
+  };
+
+  const std::vector<std::unique_ptr<const DexFile>>& dex_files_;
+  const BootImageOptions& options_;
+  std::vector<DexFileCounts> counts_;
+  // The merged methods (with inline caches) of the profiles, without the classes.
+  ProfileCompilationInfo merged_methods_;
+
+  // Scratch space of AddProfile.
+  std::vector<std::pair<uint16_t, uint8_t>> method_flags_;
+  std::vector<dex::TypeIndex> classes_;
+};
+
 // Merge a bunch of profiles together to generate a boot profile. Classes and methods are added
 // to the out_profile if they meet the options.
 void GenerateBootImageProfile(
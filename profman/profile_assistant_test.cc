@@ -804,6 +804,68 @@ TEST_F(ProfileAssistantTest, TestBootImageProfile) {
       << output_file_contents;
 }
 
+TEST_F(ProfileAssistantTest, TestBootImageProfileThreads) {
+  const std::string core_dex = GetLibCoreDexFileNames()[0];
+
+  // Spread classes and methods over more profiles than threads, so that workers aggregate
+  // several profiles each and the thresholds depend on the merged counts.
+  const std::vector<std::string> kClasses = {
+    "Ljava/lang/CharSequence;",
+    "Ljava/lang/Object;",
+    "Ljava/lang/Process;",
+    "Ljava/lang/Package;",
+  };
+  const std::vector<std::string> kMethods = {
+    "Ljava/lang/Comparable;->compareTo(Ljava/lang/Object;)I",
+    "Ljava/util/HashMap;-><init>()V",
+    "Ljava/util/ArrayList;->clear()V",
+  };
+  static const size_t kNumProfiles = 7;
+  std::vector<ScratchFile> profiles;
+  for (size_t i = 0; i < kNumProfiles; ++i) {
+    std::string contents;
+    for (size_t j = 0; j < kClasses.size(); ++j) {
+      if ((i + j) % 2 == 0) {
+        contents += kClasses[j] + "\n";
+      }
+    }
+    for (size_t j = 0; j < kMethods.size(); ++j) {
+      if ((i + j) % 3 != 0) {
+        contents += ((i % 2 == 0) ? "P" : "HS") + kMethods[j] + "\n";
+      }
+    }
+    profiles.emplace_back(ScratchFile());
+    EXPECT_TRUE(CreateProfile(contents, profiles.back().GetFilename(), core_dex));
+  }
+
+  // The boot profile must not depend on how the input profiles are split between threads.
+  std::vector<std::string> outputs;
+  for (const char* threads : { "-j1", "-j3" }) {
+    ScratchFile out_profile;
+    std::vector<std::string> args;
+    args.push_back(GetProfmanCmd());
+    args.push_back("--generate-boot-image-profile");
+    args.push_back(threads);
+    args.push_back("--boot-image-class-threshold=3");
+    args.push_back("--boot-image-clean-class-threshold=2");
+    args.push_back("--boot-image-sampled-method-threshold=3");
+    args.push_back("--reference-profile-file=" + out_profile.GetFilename());
+    args.push_back("--apk=" + core_dex);
+    args.push_back("--dex-location=" + core_dex);
+    for (const ScratchFile& profile : profiles) {
+      args.push_back("--profile-file=" + profile.GetFilename());
+    }
+    std::string error;
+    EXPECT_EQ(ExecAndReturnCode(args, &error), 0) << error;
+    ASSERT_EQ(0, out_profile.GetFile()->Flush());
+    ASSERT_TRUE(out_profile.GetFile()->ResetOffset());
+    outputs.emplace_back();
+    EXPECT_TRUE(DumpClassesAndMethods(out_profile.GetFilename(), &outputs.back()));
+  }
+  EXPECT_FALSE(outputs[0].empty());
+  EXPECT_EQ(outputs[0], outputs[1]);
+}
+
 TEST_F(ProfileAssistantTest, TestProfileCreationOneNotMatched) {
   // Class names put here need to be in sorted order.
   std::vector<std::string> class_names = {
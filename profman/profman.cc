@@ -21,16 +21,19 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <set>
 #include <string>
+#include <thread>
 #include <unordered_set>
 #include <vector>
 
 #include "android-base/stringprintf.h"
 #include "android-base/strings.h"
 
+#include "atomic.h"
 #include "base/dumpable.h"
 #include "base/scoped_flock.h"
 #include "base/stringpiece.h"
@@ -145,6 +148,8 @@ NO_RETURN static void Usage(const char *fmt, ...) {
   UsageError("  --boot-image-sampled-method-threshold=<value>: minimum number of profiles a");
   UsageError("      non-hot method needs to be in order to be hot in the output profile. The");
   UsageError("      default is max int.");
+  UsageError("  -j<number>: number of threads loading and aggregating the input profiles for");
+  UsageError("      --generate-boot-image-profile. Default is the number of CPUs.");
   UsageError("");
 
   exit(EXIT_FAILURE);
@@ -178,6 +183,7 @@ class ProfMan FINAL {
       dump_classes_and_methods_(false),
       generate_boot_image_profile_(false),
       dump_output_to_fd_(kInvalidFd),
+      thread_count_(sysconf(_SC_NPROCESSORS_CONF)),
       test_profile_num_dex_(kDefaultTestProfileNumDex),
       test_profile_method_ratio_(kDefaultTestProfileMethodRatio),
       test_profile_class_ratio_(kDefaultTestProfileClassRatio),
@@ -233,6 +239,11 @@ class ProfMan FINAL {
                         "--boot-image-sampled-method-threshold",
                         &boot_image_options_.compiled_method_threshold,
                         Usage);
+      } else if (option.starts_with("-j")) {
+        ParseUintOption(option, "-j", &thread_count_, Usage, /* is_long_option */ false);
+        if (thread_count_ == 0u) {
+          Usage("-j requires a positive number of threads");
+        }
       } else if (option.starts_with("--profile-file=")) {
         profile_files_.push_back(option.substr(strlen("--profile-file=")).ToString());
       } else if (option.starts_with("--profile-file-fd=")) {
@@ -978,32 +989,54 @@ class ProfMan FINAL {
       PLOG(ERROR) << "Expected dex files for creating boot profile";
       return -2;
     }
-    // Open the input profiles.
-    std::vector<std::unique_ptr<const ProfileCompilationInfo>> profiles;
-    if (!profile_files_fd_.empty()) {
-      for (int profile_file_fd : profile_files_fd_) {
-        std::unique_ptr<const ProfileCompilationInfo> profile(LoadProfile("", profile_file_fd));
-        if (profile == nullptr) {
-          return -3;
+    // Load the input profiles on several threads, each adding its profiles to its own
+    // aggregator, so that only one profile per thread is in memory at any time.
+    const size_t num_profiles = profile_files_fd_.size() + profile_files_.size();
+    const size_t num_threads = std::max<size_t>(1u, std::min<size_t>(thread_count_, num_profiles));
+    std::vector<std::unique_ptr<BootImageProfileAggregator>> aggregators;
+    for (size_t i = 0; i < num_threads; ++i) {
+      aggregators.emplace_back(new BootImageProfileAggregator(dex_files, boot_image_options_));
+    }
+    Atomic<size_t> next_profile(0u);
+    Atomic<bool> failed_fd(false);
+    Atomic<bool> failed_file(false);
+    auto aggregate_profiles = [&](BootImageProfileAggregator* aggregator) {
+      while (!failed_fd.LoadRelaxed() && !failed_file.LoadRelaxed()) {
+        const size_t index = next_profile.FetchAndAddSequentiallyConsistent(1u);
+        if (index >= num_profiles) {
+          break;
         }
-        profiles.emplace_back(std::move(profile));
-      }
-    }
-    if (!profile_files_.empty()) {
-      for (const std::string& profile_file : profile_files_) {
-        std::unique_ptr<const ProfileCompilationInfo> profile(LoadProfile(profile_file, kInvalidFd));
+        const bool is_fd = index < profile_files_fd_.size();
+        std::unique_ptr<const ProfileCompilationInfo> profile = is_fd
+            ? LoadProfile("", profile_files_fd_[index])
+            : LoadProfile(profile_files_[index - profile_files_fd_.size()], kInvalidFd);
         if (profile == nullptr) {
-          return -4;
+          (is_fd ? failed_fd : failed_file).StoreRelaxed(true);
+          break;
         }
-        profiles.emplace_back(std::move(profile));
+        aggregator->AddProfile(*profile);
       }
+    };
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < num_threads; ++i) {
+      threads.emplace_back(aggregate_profiles, aggregators[i].get());
+    }
+    aggregate_profiles(aggregators[0].get());
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+    if (failed_fd.LoadRelaxed()) {
+      return -3;
+    }
+    if (failed_file.LoadRelaxed()) {
+      return -4;
+    }
+    for (size_t i = 1; i < num_threads; ++i) {
+      aggregators[0]->MergeWith(*aggregators[i]);
+      aggregators[i].reset();
     }
     ProfileCompilationInfo out_profile;
-    GenerateBootImageProfile(dex_files,
-                             profiles,
-                             boot_image_options_,
-                             VLOG_IS_ON(profiler),
-                             &out_profile);
+    aggregators[0]->Finish(VLOG_IS_ON(profiler), &out_profile);
     out_profile.Save(reference_fd);
     close(reference_fd);
     return 0;
@@ -1098,6 +1131,7 @@ class ProfMan FINAL {
   bool dump_classes_and_methods_;
   bool generate_boot_image_profile_;
   int dump_output_to_fd_;
+  uint32_t thread_count_;
   BootImageOptions boot_image_options_;
   std::string test_profile_;
   std::string create_profile_from_file_;
@@ -38,6 +38,12 @@ extern "C" void art_quick_implicit_suspend();
 
 namespace art {
 
+uintptr_t FaultManager::GetFaultPc(siginfo_t* siginfo ATTRIBUTE_UNUSED, void* context) {
+  struct ucontext *uc = reinterpret_cast<struct ucontext *>(context);
+  struct sigcontext *sc = reinterpret_cast<struct sigcontext*>(&uc->uc_mcontext);
+  return static_cast<uintptr_t>(sc->pc);
+}
+
 void FaultManager::GetMethodAndReturnPcAndSp(siginfo_t* siginfo ATTRIBUTE_UNUSED, void* context,
                                              ArtMethod** out_method,
                                              uintptr_t* out_return_pc, uintptr_t* out_sp) {
@@ -91,20 +97,20 @@ bool NullPointerHandler::Action(int sig ATTRIBUTE_UNUSED, siginfo_t* info, void*
 }
 
 // A suspend check is done using the following instruction sequence:
-//      0xf7223228: f9405640  ldr x0, [x18, #168]
-// .. some intervening instructions
-//      0xf7223230: f9400000  ldr x0, [x0]
+//      0xf7223228: f9405670  ldr x16, [x19, #168]  ; suspend_trigger
+//      0xf722322c: b940021f  ldr wzr, [x16]
 
-// The offset from r18 is Thread::ThreadSuspendTriggerOffset().
-// To check for a suspend check, we examine the instructions that caused
-// the fault (at PC-4 and PC).
+// The offset from x19 is Thread::ThreadSuspendTriggerOffset().
+// The compiler emits both instructions back to back, so we examine the
+// instruction that caused the fault (at PC) and the one before it (at PC-4).
 bool SuspensionHandler::Action(int sig ATTRIBUTE_UNUSED, siginfo_t* info ATTRIBUTE_UNUSED,
                                void* context) {
-  // These are the instructions to check for.  The first one is the ldr x0,[r18,#xxx]
+  // These are the instructions to check for.  The first one is the ldr x16, [x19, #xxx]
   // where xxx is the offset of the suspend trigger.
-  uint32_t checkinst1 = 0xf9400240 |
+  constexpr uint32_t kLdrX16X19 = 0xf9400000 | (TR << 5) | IP0;
+  uint32_t checkinst1 = kLdrX16X19 |
       (Thread::ThreadSuspendTriggerOffset<PointerSize::k64>().Int32Value() << 7);
-  uint32_t checkinst2 = 0xf9400000;
+  constexpr uint32_t checkinst2 = 0xb9400000 | (IP0 << 5) | 31u;  // Encoding of wzr.
 
   struct ucontext *uc = reinterpret_cast<struct ucontext *>(context);
   struct sigcontext *sc = reinterpret_cast<struct sigcontext*>(&uc->uc_mcontext);
@@ -119,35 +125,25 @@ bool SuspensionHandler::Action(int sig ATTRIBUTE_UNUSED, siginfo_t* info ATTRIBU
     return false;
   }
 
-  // The first instruction can a little bit up the stream due to load hoisting
-  // in the compiler.
-  uint8_t* limit = ptr1 - 80;   // Compiler will hoist to a max of 20 instructions.
-  bool found = false;
-  while (ptr1 > limit) {
-    uint32_t inst1 = *reinterpret_cast<uint32_t*>(ptr1);
-    VLOG(signals) << "inst1: " << std::hex << inst1 << " checkinst1: " << checkinst1;
-    if (inst1 == checkinst1) {
-      found = true;
-      break;
-    }
-    ptr1 -= 4;
-  }
-  if (found) {
-    VLOG(signals) << "suspend check match";
-    // This is a suspend check.  Arrange for the signal handler to return to
-    // art_quick_implicit_suspend.  Also set LR so that after the suspend check it
-    // will resume the instruction (current PC + 4).  PC points to the
-    // ldr x0,[x0,#0] instruction (r0 will be 0, set by the trigger).
-
-    sc->regs[30] = sc->pc + 4;
-    sc->pc = reinterpret_cast<uintptr_t>(art_quick_implicit_suspend);
-
-    // Now remove the suspend trigger that caused this fault.
-    Thread::Current()->RemoveSuspendTrigger();
-    VLOG(signals) << "removed suspend trigger invoking test suspend";
-    return true;
+  uint32_t inst1 = *reinterpret_cast<uint32_t*>(ptr1);
+  VLOG(signals) << "inst1: " << std::hex << inst1 << " checkinst1: " << checkinst1;
+  if (inst1 != checkinst1) {
+    return false;
   }
-  return false;
+
+  VLOG(signals) << "suspend check match";
+  // This is a suspend check.  Arrange for the signal handler to return to
+  // art_quick_implicit_suspend.  Also set LR so that after the suspend check it
+  // will resume at the instruction after the faulting load (current PC + 4), which
+  // is where the compiler recorded the stack map. LR is always saved in the frame
+  // of compiled code doing suspend checks.
+  sc->regs[30] = sc->pc + 4;
+  sc->pc = reinterpret_cast<uintptr_t>(art_quick_implicit_suspend);
+
+  // Now remove the suspend trigger that caused this fault.
+  Thread::Current()->RemoveSuspendTrigger();
+  VLOG(signals) << "removed suspend trigger invoking test suspend";
+  return true;
 }
 
 bool StackOverflowHandler::Action(int sig ATTRIBUTE_UNUSED, siginfo_t* info ATTRIBUTE_UNUSED,
@@ -277,6 +277,11 @@ static uint32_t GetInstructionSize(const uint8_t* pc) {
   return pc - startpc;
 }
 
+uintptr_t FaultManager::GetFaultPc(siginfo_t* siginfo ATTRIBUTE_UNUSED, void* context) {
+  struct ucontext* uc = reinterpret_cast<struct ucontext*>(context);
+  return static_cast<uintptr_t>(uc->CTX_EIP);
+}
+
 void FaultManager::GetMethodAndReturnPcAndSp(siginfo_t* siginfo, void* context,
                                              ArtMethod** out_method,
                                              uintptr_t* out_return_pc, uintptr_t* out_sp) {
@@ -358,10 +363,9 @@ bool NullPointerHandler::Action(int, siginfo_t* sig, void* context) {
 // 0xf720f1df:         648B058C000000      mov     eax, fs:[0x8c]  ; suspend_trigger
 // .. some intervening instructions.
 // 0xf720f1e6:                   8500      test    eax, [eax]
-// (x86_64)
-// 0x7f579de45d9e: 65488B0425A8000000      movq    rax, gs:[0xa8]  ; suspend_trigger
-// .. some intervening instructions.
-// 0x7f579de45da7:               8500      test    eax, [eax]
+// (x86_64, emitted back to back by the compiler)
+// 0x7f579de45d9e: 654C8B1C25A8000000      movq    r11, gs:[0xa8]  ; suspend_trigger
+// 0x7f579de45da7:             45851B      test    r11d, [r11]
 
 // The offset from fs is Thread::ThreadSuspendTriggerOffset().
 // To check for a suspend check, we examine the instructions that caused
@@ -373,20 +377,21 @@ bool SuspensionHandler::Action(int, siginfo_t*, void* context) {
 
   VLOG(signals) << "Checking for suspension point";
 #if defined(__x86_64__)
-  uint8_t checkinst1[] = {0x65, 0x48, 0x8b, 0x04, 0x25, static_cast<uint8_t>(trigger & 0xff),
+  uint8_t checkinst1[] = {0x65, 0x4c, 0x8b, 0x1c, 0x25, static_cast<uint8_t>(trigger & 0xff),
       static_cast<uint8_t>((trigger >> 8) & 0xff), 0, 0};
+  uint8_t checkinst2[] = {0x45, 0x85, 0x1b};
 #else
   uint8_t checkinst1[] = {0x64, 0x8b, 0x05, static_cast<uint8_t>(trigger & 0xff),
       static_cast<uint8_t>((trigger >> 8) & 0xff), 0, 0};
-#endif
   uint8_t checkinst2[] = {0x85, 0x00};
+#endif
 
   struct ucontext *uc = reinterpret_cast<struct ucontext*>(context);
   uint8_t* pc = reinterpret_cast<uint8_t*>(uc->CTX_EIP);
   uint8_t* sp = reinterpret_cast<uint8_t*>(uc->CTX_ESP);
 
-  if (pc[0] != checkinst2[0] || pc[1] != checkinst2[1]) {
-    // Second instruction is not correct (test eax,[eax]).
+  if (memcmp(pc, checkinst2, sizeof(checkinst2)) != 0) {
+    // Second instruction is not correct.
     VLOG(signals) << "Not a suspension point";
     return false;
   }
@@ -409,11 +414,11 @@ bool SuspensionHandler::Action(int, siginfo_t*, void* context) {
 
     // We need to arrange for the signal handler to return to the null pointer
     // exception generator.  The return address must be the address of the
-    // next instruction (this instruction + 2).  The return address
+    // next instruction (this instruction + its size).  The return address
     // is on the stack at the top address of the current frame.
 
     // Push the return address onto the stack.
-    uintptr_t retaddr = reinterpret_cast<uintptr_t>(pc + 2);
+    uintptr_t retaddr = reinterpret_cast<uintptr_t>(pc + sizeof(checkinst2));
     uintptr_t* next_sp = reinterpret_cast<uintptr_t*>(sp - sizeof(uintptr_t));
     *next_sp = retaddr;
     uc->CTX_ESP = reinterpret_cast<uintptr_t>(next_sp);
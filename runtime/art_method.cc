@@ -23,6 +23,7 @@
 #include "arch/context.h"
 #include "art_method-inl.h"
 #include "base/stringpiece.h"
+#include "catch_handler_cache.h"
 #include "class_linker-inl.h"
 #include "debugger.h"
 #include "dex_file-inl.h"
@@ -31,6 +32,7 @@
 #include "entrypoints/runtime_asm_entrypoints.h"
 #include "gc/accounting/card_table-inl.h"
 #include "interpreter/interpreter.h"
+#include "java_vm_ext.h"
 #include "jit/jit.h"
 #include "jit/jit_code_cache.h"
 #include "jit/profiling_info.h"
@@ -264,13 +266,19 @@ uint32_t ArtMethod::FindDexMethodIndexInOtherDexFile(const DexFile& other_dexfil
 uint32_t ArtMethod::FindCatchBlock(Handle<mirror::Class> exception_type,
                                    uint32_t dex_pc, bool* has_no_move_exception) {
   const DexFile::CodeItem* code_item = GetCodeItem();
-  // Set aside the exception while we resolve its type.
   Thread* self = Thread::Current();
+  CatchHandlerCache* cache = self->GetCatchHandlerCache();
+  uint32_t found_dex_pc = DexFile::kDexNoIndex;
+  if (cache->Lookup(
+          this, code_item, dex_pc, exception_type.Get(), &found_dex_pc, has_no_move_exception)) {
+    return found_dex_pc;
+  }
+  // Set aside the exception while we resolve its type.
   StackHandleScope<1> hs(self);
   Handle<mirror::Throwable> exception(hs.NewHandle(self->GetException()));
   self->ClearException();
-  // Default to handler not found.
-  uint32_t found_dex_pc = DexFile::kDexNoIndex;
+  // Do not cache the result if a handler type could not be resolved, a later lookup may succeed.
+  bool cacheable = true;
   // Iterate over the catch handlers associated with dex_pc.
   for (CatchHandlerIterator it(*code_item, dex_pc); it.HasNext(); it.Next()) {
     dex::TypeIndex iter_type_idx = it.GetHandlerTypeIndex();
@@ -286,6 +294,7 @@ uint32_t ArtMethod::FindCatchBlock(Handle<mirror::Class> exception_type,
       // removed by a pro-guard like tool.
       // Note: this is not RI behavior. RI would have failed when loading the class.
       self->ClearException();
+      cacheable = false;
       // Delete any long jump context as this routine is called during a stack walk which will
       // release its in use context at the end.
       delete self->GetLongJumpContext();
@@ -301,6 +310,14 @@ uint32_t ArtMethod::FindCatchBlock(Handle<mirror::Class> exception_type,
         Instruction::At(&code_item->insns_[found_dex_pc]);
     *has_no_move_exception = (first_catch_instr->Opcode() != Instruction::MOVE_EXCEPTION);
   }
+  if (cacheable) {
+    cache->Add(this,
+               code_item,
+               dex_pc,
+               exception_type.Get(),
+               found_dex_pc,
+               found_dex_pc != DexFile::kDexNoIndex && *has_no_move_exception);
+  }
   // Put the exception back.
   if (exception != nullptr) {
     self->SetException(exception.Get());
@@ -416,15 +433,29 @@ bool ArtMethod::IsOverridableByDefaultMethod() {
 }
 
 bool ArtMethod::IsAnnotatedWithFastNative() {
-  return IsAnnotatedWith(WellKnownClasses::dalvik_annotation_optimization_FastNative,
-                         DexFile::kDexVisibilityBuild,
-                         /* lookup_in_resolved_boot_classes */ true);
+  if (IsAnnotatedWith(WellKnownClasses::dalvik_annotation_optimization_FastNative,
+                      DexFile::kDexVisibilityBuild,
+                      /* lookup_in_resolved_boot_classes */ true)) {
+    return true;
+  }
+  // Methods that cannot be annotated, e.g. in third-party libraries, can be listed instead.
+  // An annotation takes precedence over the list.
+  return Runtime::Current()->GetJavaVM()->IsListedAsFastNative(this) &&
+      !IsAnnotatedWith(WellKnownClasses::dalvik_annotation_optimization_CriticalNative,
+                       DexFile::kDexVisibilityBuild,
+                       /* lookup_in_resolved_boot_classes */ true);
 }
 
 bool ArtMethod::IsAnnotatedWithCriticalNative() {
-  return IsAnnotatedWith(WellKnownClasses::dalvik_annotation_optimization_CriticalNative,
-                         DexFile::kDexVisibilityBuild,
-                         /* lookup_in_resolved_boot_classes */ true);
+  if (IsAnnotatedWith(WellKnownClasses::dalvik_annotation_optimization_CriticalNative,
+                      DexFile::kDexVisibilityBuild,
+                      /* lookup_in_resolved_boot_classes */ true)) {
+    return true;
+  }
+  return Runtime::Current()->GetJavaVM()->IsListedAsCriticalNative(this) &&
+      !IsAnnotatedWith(WellKnownClasses::dalvik_annotation_optimization_FastNative,
+                       DexFile::kDexVisibilityBuild,
+                       /* lookup_in_resolved_boot_classes */ true);
 }
 
 bool ArtMethod::IsAnnotatedWith(jclass klass,
@@ -614,6 +645,25 @@ const OatQuickMethodHeader* ArtMethod::GetOatQuickMethodHeader(uintptr_t pc) {
   const void* existing_entry_point = GetEntryPointFromQuickCompiledCode();
   CHECK(existing_entry_point != nullptr) << PrettyMethod() << "@" << this;
   ClassLinker* class_linker = runtime->GetClassLinker();
+  jit::Jit* jit = runtime->GetJit();
+
+  if (UNLIKELY(pc == 0u) && IsNative() && jit != nullptr) {
+    // A downcall through a compiled JNI stub: the stack walk recognizes the downcalls through the
+    // generic JNI trampoline from their tagged frame. If the entry point is not compiled code, it
+    // may have changed since the call into a JNI stub compiled by the JIT.
+    jit::JitCodeCache* code_cache = jit->GetCodeCache();
+    if (code_cache->ContainsPc(existing_entry_point)) {
+      return OatQuickMethodHeader::FromEntryPoint(existing_entry_point);
+    }
+    if (class_linker->IsQuickGenericJniStub(existing_entry_point) ||
+        class_linker->IsQuickResolutionStub(existing_entry_point) ||
+        existing_entry_point == GetQuickInstrumentationEntryPoint()) {
+      const void* code = code_cache->GetJniStubCode(this);
+      if (code != nullptr) {
+        return OatQuickMethodHeader::FromCodePointer(code);
+      }
+    }
+  }
 
   if (class_linker->IsQuickGenericJniStub(existing_entry_point)) {
     // The generic JNI does not have any method header.
@@ -638,7 +688,6 @@ const OatQuickMethodHeader* ArtMethod::GetOatQuickMethodHeader(uintptr_t pc) {
   }
 
   // Check whether the pc is in the JIT code cache.
-  jit::Jit* jit = runtime->GetJit();
   if (jit != nullptr) {
     jit::JitCodeCache* code_cache = jit->GetCodeCache();
     OatQuickMethodHeader* method_header = code_cache->LookupMethodHeader(pc, this);
@@ -675,6 +724,12 @@ const OatQuickMethodHeader* ArtMethod::GetOatQuickMethodHeader(uintptr_t pc) {
       DCHECK(IsNative());
       return nullptr;
     }
+    if (IsNative()) {
+      // We are delivering an exception from the generic jni stub, but the entry point of the
+      // method has been updated to a JNI stub compiled by the JIT since the call.
+      DCHECK(jit != nullptr && jit->GetCodeCache()->ContainsPc(existing_entry_point));
+      return nullptr;
+    }
     // Only for unit tests.
     // TODO(ngeoffray): Update these tests to pass the right pc?
     return OatQuickMethodHeader::FromEntryPoint(existing_entry_point);
@@ -744,7 +799,20 @@ void ArtMethod::CopyFrom(ArtMethod* src, PointerSize image_pointer_size) {
     SetProfilingInfoPtrSize(nullptr, image_pointer_size);
   }
   // Clear hotness to let the JIT properly decide when to compile this method.
-  hotness_count_ = 0;
+  ClearCounter();
+}
+
+uintptr_t ArtMethod::boot_image_methods_begin_ = 0u;
+size_t ArtMethod::boot_image_methods_size_ = 0u;
+uint16_t* ArtMethod::boot_image_hotness_counters_ = nullptr;
+
+void ArtMethod::SetBootImageHotnessCounters(uintptr_t methods_begin,
+                                            size_t methods_size,
+                                            uint16_t* counters) {
+  DCHECK(counters != nullptr || methods_size == 0u);
+  boot_image_methods_begin_ = methods_begin;
+  boot_image_methods_size_ = methods_size;
+  boot_image_hotness_counters_ = counters;
 }
 
 bool ArtMethod::IsImagePointerSize(PointerSize pointer_size) {
@@ -229,6 +229,21 @@ class ArtMethod FINAL {
     AddAccessFlags(kAccCompileDontBother);
   }
 
+  bool IsPreviouslyWarm() {
+    if (IsIntrinsic()) {
+      // kAccPreviouslyWarm overlaps with the intrinsic ordinal. Intrinsics are always warm.
+      return true;
+    }
+    return (GetAccessFlags() & kAccPreviouslyWarm) != 0;
+  }
+
+  void SetPreviouslyWarm() {
+    if (IsIntrinsic()) {
+      return;
+    }
+    AddAccessFlags(kAccPreviouslyWarm);
+  }
+
   // A default conflict method is a special sentinel method that stands for a conflict between
   // multiple default methods. It cannot be invoked, throwing an IncompatibleClassChangeError if one
   // attempts to do so.
@@ -296,10 +311,12 @@ class ArtMethod FINAL {
   }
 
   // Checks to see if the method was annotated with @dalvik.annotation.optimization.FastNative
+  // or listed as fast native in the -Xjnioptimizednatives file.
   // -- Independent of kAccFastNative access flags.
   bool IsAnnotatedWithFastNative();
 
   // Checks to see if the method was annotated with @dalvik.annotation.optimization.CriticalNative
+  // or listed as critical native in the -Xjnioptimizednatives file.
   // -- Unrelated to the GC notion of "critical".
   bool IsAnnotatedWithCriticalNative();
 
@@ -631,21 +648,29 @@ class ArtMethod FINAL {
   // given that the counter is only 16 bits wide we can expect wrap-around in some
   // situations.  Consumers of hotness_count_ must be able to deal with that.
   uint16_t IncrementCounter() {
-    return ++hotness_count_;
+    return ++*GetCounterAddress();
   }
 
   void ClearCounter() {
-    hotness_count_ = 0;
+    *GetCounterAddress() = 0;
   }
 
   void SetCounter(int16_t hotness_count) {
-    hotness_count_ = hotness_count;
+    *GetCounterAddress() = hotness_count;
   }
 
   uint16_t GetCounter() const {
-    return hotness_count_;
+    return *GetCounterAddress();
   }
 
+  // Keeps the hotness counters of the methods in [methods_begin, methods_begin + methods_size),
+  // the boot image methods, in `counters`, one per ArtMethod::Size() bytes, instead of in the
+  // methods. Counting then dirties the densely packed counters rather than the boot image pages
+  // shared with the zygote.
+  static void SetBootImageHotnessCounters(uintptr_t methods_begin,
+                                          size_t methods_size,
+                                          uint16_t* counters);
+
   const uint8_t* GetQuickenedInfo(PointerSize pointer_size) REQUIRES_SHARED(Locks::mutator_lock_);
 
   // Returns the method header for the compiled code containing 'pc'. Note that runtime
@@ -732,7 +757,8 @@ class ArtMethod FINAL {
   uint16_t method_index_;
 
   // The hotness we measure for this method. Managed by the interpreter. Not atomic, as we allow
-  // missing increments: if the method is hot, we will see it eventually.
+  // missing increments: if the method is hot, we will see it eventually. Unused for boot image
+  // methods, see SetBootImageHotnessCounters().
   uint16_t hotness_count_;
 
   // Fake padding field gets inserted here.
@@ -760,6 +786,14 @@ class ArtMethod FINAL {
   // resolved types; otherwise, resolve them as a side effect.
   bool IsAnnotatedWith(jclass klass, uint32_t visibility, bool lookup_in_resolved_boot_classes);
 
+  uint16_t* GetCounterAddress() const {
+    const uintptr_t offset = reinterpret_cast<uintptr_t>(this) - boot_image_methods_begin_;
+    if (offset < boot_image_methods_size_) {
+      return &boot_image_hotness_counters_[offset / Size(kRuntimePointerSize)];
+    }
+    return const_cast<uint16_t*>(&hotness_count_);
+  }
+
   static constexpr size_t PtrSizedFieldsOffset(PointerSize pointer_size) {
     // Round up to pointer size for padding field. Tested in art_method.cc.
     return RoundUp(offsetof(ArtMethod, hotness_count_) + sizeof(hotness_count_),
@@ -769,6 +803,10 @@ class ArtMethod FINAL {
   // Compare given pointer size to the image pointer size.
   static bool IsImagePointerSize(PointerSize pointer_size);
 
+  static uintptr_t boot_image_methods_begin_;
+  static size_t boot_image_methods_size_;
+  static uint16_t* boot_image_hotness_counters_;
+
   template<typename T>
   ALWAYS_INLINE T GetNativePointer(MemberOffset offset, PointerSize pointer_size) const {
     static_assert(std::is_pointer<T>::value, "T must be a pointer type");
@@ -0,0 +1,195 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_BASE_ADDRESS_RANGE_ALLOCATOR_H_
+#define ART_RUNTIME_BASE_ADDRESS_RANGE_ALLOCATOR_H_
+
+#include <stdint.h>
+
+#include <map>
+#include <set>
+#include <utility>
+
+#include "base/allocator.h"
+#include "base/bit_utils.h"
+#include "base/logging.h"
+#include "base/macros.h"
+
+namespace art {
+
+// Hands out aligned sub-ranges of the address range [begin, end). Only the bookkeeping is done
+// here, the caller maps and unmaps the memory and provides the locking.
+//
+// The free ranges are kept in two trees, one ordered by address to coalesce the neighbours of a
+// freed range and one ordered by size to find the best fit. Allocate returns the lowest of the
+// smallest free ranges that fit, which keeps the large free ranges intact.
+template <AllocatorTag kTag>
+class AddressRangeAllocator {
+ public:
+  AddressRangeAllocator(uintptr_t begin, uintptr_t end, size_t alignment)
+      : begin_(begin), end_(end), alignment_(alignment), free_bytes_(0u) {
+    CHECK(IsPowerOfTwo(alignment));
+    CHECK_ALIGNED_PARAM(begin, alignment);
+    CHECK_ALIGNED_PARAM(end, alignment);
+    CHECK_LT(begin, end);
+    InsertFreeRange(begin, end - begin);
+  }
+
+  uintptr_t Begin() const {
+    return begin_;
+  }
+
+  uintptr_t End() const {
+    return end_;
+  }
+
+  size_t FreeBytes() const {
+    return free_bytes_;
+  }
+
+  size_t LargestFreeRange() const {
+    return free_by_size_.empty() ? 0u : free_by_size_.rbegin()->first;
+  }
+
+  // Return whether [begin, begin + size) overlaps the managed range.
+  bool Overlaps(uintptr_t begin, size_t size) const {
+    return begin < end_ && begin + size > begin_;
+  }
+
+  // Return whether [begin, begin + size) lies within the managed range.
+  bool Contains(uintptr_t begin, size_t size) const {
+    return begin >= begin_ && size <= end_ - begin_ && begin - begin_ <= end_ - begin_ - size;
+  }
+
+  // Allocate `size` bytes, returns 0 if no free range is large enough.
+  uintptr_t Allocate(size_t size) {
+    DCHECK_ALIGNED_PARAM(size, alignment_);
+    DCHECK_NE(size, 0u);
+    auto it = free_by_size_.lower_bound(std::make_pair(size, static_cast<uintptr_t>(0u)));
+    if (it == free_by_size_.end()) {
+      return 0u;
+    }
+    const size_t range_size = it->first;
+    const uintptr_t range_begin = it->second;
+    RemoveFreeRange(range_begin, range_size);
+    if (range_size != size) {
+      InsertFreeRange(range_begin + size, range_size - size);
+    }
+    return range_begin;
+  }
+
+  // Allocate exactly [begin, begin + size). Returns false, without allocating anything, unless the
+  // whole range is free.
+  bool AllocateAt(uintptr_t begin, size_t size) {
+    DCHECK_ALIGNED_PARAM(begin, alignment_);
+    DCHECK_ALIGNED_PARAM(size, alignment_);
+    DCHECK_NE(size, 0u);
+    if (!Contains(begin, size)) {
+      return false;
+    }
+    auto it = free_by_address_.upper_bound(begin);
+    if (it == free_by_address_.begin()) {
+      return false;
+    }
+    --it;
+    const uintptr_t range_begin = it->first;
+    const size_t range_size = it->second;
+    if (begin + size > range_begin + range_size) {
+      return false;
+    }
+    RemoveFreeRange(range_begin, range_size);
+    if (range_begin != begin) {
+      InsertFreeRange(range_begin, begin - range_begin);
+    }
+    if (begin + size != range_begin + range_size) {
+      InsertFreeRange(begin + size, range_begin + range_size - (begin + size));
+    }
+    return true;
+  }
+
+  // Return [begin, begin + size) to the free ranges. The range may be any allocated part of a
+  // previous allocation, or span several adjacent allocations.
+  void Free(uintptr_t begin, size_t size) {
+    DCHECK_ALIGNED_PARAM(begin, alignment_);
+    DCHECK_ALIGNED_PARAM(size, alignment_);
+    DCHECK_NE(size, 0u);
+    DCHECK(Contains(begin, size));
+    uintptr_t end = begin + size;
+    auto next = free_by_address_.lower_bound(begin);
+    DCHECK(next == free_by_address_.end() || next->first >= end) << "Double free";
+    if (next != free_by_address_.end() && next->first == end) {
+      end += next->second;
+      RemoveFreeRange(next->first, next->second);
+      next = free_by_address_.lower_bound(begin);
+    }
+    if (next != free_by_address_.begin()) {
+      auto prev = next;
+      --prev;
+      DCHECK_LE(prev->first + prev->second, begin) << "Double free";
+      if (prev->first + prev->second == begin) {
+        begin = prev->first;
+        RemoveFreeRange(prev->first, prev->second);
+      }
+    }
+    InsertFreeRange(begin, end - begin);
+  }
+
+  // Call visitor(begin, size) for every free range, in address order.
+  template <typename Visitor>
+  void VisitFreeRanges(const Visitor& visitor) const {
+    for (const auto& pair : free_by_address_) {
+      visitor(pair.first, pair.second);
+    }
+  }
+
+ private:
+  void InsertFreeRange(uintptr_t begin, size_t size) {
+    free_by_address_.emplace(begin, size);
+    free_by_size_.emplace(size, begin);
+    free_bytes_ += size;
+  }
+
+  void RemoveFreeRange(uintptr_t begin, size_t size) {
+    free_by_address_.erase(begin);
+    free_by_size_.erase(std::make_pair(size, begin));
+    DCHECK_GE(free_bytes_, size);
+    free_bytes_ -= size;
+  }
+
+  using AddressMap = std::map<uintptr_t,
+                              size_t,
+                              std::less<uintptr_t>,
+                              TrackingAllocator<std::pair<const uintptr_t, size_t>, kTag>>;
+  using SizeSet = std::set<std::pair<size_t, uintptr_t>,
+                           std::less<std::pair<size_t, uintptr_t>>,
+                           TrackingAllocator<std::pair<size_t, uintptr_t>, kTag>>;
+
+  const uintptr_t begin_;
+  const uintptr_t end_;
+  const size_t alignment_;
+  size_t free_bytes_;
+
+  // Free ranges, begin to size.
+  AddressMap free_by_address_;
+  // Free ranges, (size, begin).
+  SizeSet free_by_size_;
+
+  DISALLOW_COPY_AND_ASSIGN(AddressRangeAllocator);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_BASE_ADDRESS_RANGE_ALLOCATOR_H_
@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "address_range_allocator.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace art {
+
+using TestAllocator = AddressRangeAllocator<kAllocatorTagMaps>;
+
+static constexpr size_t kAlignment = 4 * KB;
+static constexpr uintptr_t kBegin = 64 * KB;
+static constexpr uintptr_t kEnd = kBegin + 1024 * kAlignment;
+
+TEST(AddressRangeAllocator, AllocateAndFree) {
+  TestAllocator allocator(kBegin, kEnd, kAlignment);
+  EXPECT_EQ(kEnd - kBegin, allocator.FreeBytes());
+  EXPECT_EQ(kEnd - kBegin, allocator.LargestFreeRange());
+
+  uintptr_t a = allocator.Allocate(kAlignment);
+  uintptr_t b = allocator.Allocate(2 * kAlignment);
+  uintptr_t c = allocator.Allocate(kAlignment);
+  EXPECT_EQ(kBegin, a);
+  EXPECT_EQ(kBegin + kAlignment, b);
+  EXPECT_EQ(kBegin + 3 * kAlignment, c);
+  EXPECT_EQ(kEnd - kBegin - 4 * kAlignment, allocator.FreeBytes());
+
+  // Too large.
+  EXPECT_EQ(0u, allocator.Allocate(kEnd - kBegin));
+
+  // The hole left by b is the best fit for allocations of at most its size.
+  allocator.Free(b, 2 * kAlignment);
+  EXPECT_EQ(b, allocator.Allocate(kAlignment));
+  EXPECT_EQ(b + kAlignment, allocator.Allocate(kAlignment));
+  EXPECT_EQ(c + kAlignment, allocator.Allocate(2 * kAlignment));
+
+  // Freeing everything coalesces the ranges back into one.
+  allocator.Free(kBegin, 6 * kAlignment);
+  EXPECT_EQ(kEnd - kBegin, allocator.FreeBytes());
+  EXPECT_EQ(kEnd - kBegin, allocator.LargestFreeRange());
+  size_t num_free_ranges = 0u;
+  allocator.VisitFreeRanges([&](uintptr_t begin, size_t size) {
+    EXPECT_EQ(kBegin, begin);
+    EXPECT_EQ(kEnd - kBegin, size);
+    ++num_free_ranges;
+  });
+  EXPECT_EQ(1u, num_free_ranges);
+}
+
+TEST(AddressRangeAllocator, AllocateAt) {
+  TestAllocator allocator(kBegin, kEnd, kAlignment);
+  // Outside of the range.
+  EXPECT_FALSE(allocator.AllocateAt(kBegin - kAlignment, kAlignment));
+  EXPECT_FALSE(allocator.AllocateAt(kEnd, kAlignment));
+  EXPECT_FALSE(allocator.AllocateAt(kEnd - kAlignment, 2 * kAlignment));
+
+  uintptr_t middle = kBegin + 10 * kAlignment;
+  EXPECT_TRUE(allocator.AllocateAt(middle, 2 * kAlignment));
+  EXPECT_FALSE(allocator.AllocateAt(middle + kAlignment, kAlignment));
+  EXPECT_FALSE(allocator.AllocateAt(middle - kAlignment, 2 * kAlignment));
+  EXPECT_EQ(kEnd - kBegin - 2 * kAlignment, allocator.FreeBytes());
+  EXPECT_EQ(kEnd - middle - 2 * kAlignment, allocator.LargestFreeRange());
+
+  // The range below is the best fit.
+  EXPECT_EQ(kBegin, allocator.Allocate(10 * kAlignment));
+  EXPECT_EQ(middle + 2 * kAlignment, allocator.Allocate(kAlignment));
+
+  // Free part of an allocation.
+  allocator.Free(middle + kAlignment, kAlignment);
+  EXPECT_TRUE(allocator.AllocateAt(middle + kAlignment, kAlignment));
+}
+
+TEST(AddressRangeAllocator, Random) {
+  TestAllocator allocator(kBegin, kEnd, kAlignment);
+  std::vector<bool> used((kEnd - kBegin) / kAlignment, false);
+  std::vector<std::pair<uintptr_t, size_t>> allocations;
+  std::default_random_engine engine(42u);
+  for (size_t i = 0; i != 10000u; ++i) {
+    if (allocations.empty() || engine() % 3u != 0u) {
+      size_t size = (engine() % 16u + 1u) * kAlignment;
+      uintptr_t begin = allocator.Allocate(size);
+      if (begin == 0u) {
+        continue;
+      }
+      ASSERT_TRUE(allocator.Contains(begin, size));
+      size_t end_page = (begin + size - kBegin) / kAlignment;
+      for (size_t page = (begin - kBegin) / kAlignment; page != end_page; ++page) {
+        ASSERT_FALSE(used[page]);
+        used[page] = true;
+      }
+      allocations.emplace_back(begin, size);
+    } else {
+      size_t index = engine() % allocations.size();
+      uintptr_t begin = allocations[index].first;
+      size_t size = allocations[index].second;
+      allocations.erase(allocations.begin() + index);
+      allocator.Free(begin, size);
+      size_t end_page = (begin + size - kBegin) / kAlignment;
+      for (size_t page = (begin - kBegin) / kAlignment; page != end_page; ++page) {
+        used[page] = false;
+      }
+    }
+    size_t free_bytes = 0u;
+    uintptr_t last_end = 0u;
+    allocator.VisitFreeRanges([&](uintptr_t begin, size_t size) {
+      // Free ranges are coalesced.
+      EXPECT_LT(last_end, begin);
+      last_end = begin + size;
+      free_bytes += size;
+    });
+    ASSERT_EQ(free_bytes, allocator.FreeBytes());
+    ASSERT_EQ(static_cast<size_t>(std::count(used.begin(), used.end(), false)) * kAlignment,
+              free_bytes);
+  }
+}
+
+}  // namespace art
@@ -65,6 +65,7 @@ enum AllocatorTag {
   kAllocatorTagOatFile,
   kAllocatorTagDexFileVerifier,
   kAllocatorTagRosAlloc,
+  kAllocatorTagJitCode,
   kAllocatorTagCount,  // Must always be last element.
 };
 std::ostream& operator<<(std::ostream& os, const AllocatorTag& tag);
@@ -17,6 +17,12 @@
 #include "arena_allocator-inl.h"
 
 #include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#if defined(__linux__)
+#include <linux/mempolicy.h>
+#endif
 
 #include <algorithm>
 #include <cstddef>
@@ -28,6 +34,7 @@
 #include "mutex.h"
 #include "thread-current-inl.h"
 #include "systrace.h"
+#include "utils.h"
 
 namespace art {
 
@@ -74,6 +81,8 @@ const char* const ArenaAllocatorStatsImpl<kCount>::kAllocNames[] = {
   "DCE          ",
   "LSE          ",
   "LICM         ",
+  "PRE          ",
+  "PEA          ",
   "LoopOpt      ",
   "SsaLiveness  ",
   "SsaPhiElim   ",
@@ -123,6 +132,11 @@ size_t ArenaAllocatorStatsImpl<kCount>::BytesAllocated() const {
   return std::accumulate(alloc_stats_.begin(), alloc_stats_.end(), init);
 }
 
+template <bool kCount>
+size_t ArenaAllocatorStatsImpl<kCount>::BytesAllocated(ArenaAllocKind kind) const {
+  return alloc_stats_[kind];
+}
+
 template <bool kCount>
 void ArenaAllocatorStatsImpl<kCount>::Dump(std::ostream& os, const Arena* first,
                                            ssize_t lost_bytes_adjustment) const {
@@ -167,6 +181,11 @@ void ArenaAllocatorStatsImpl<kCount>::Dump(std::ostream& os, const Arena* first,
 template class ArenaAllocatorStatsImpl<kArenaAllocatorCountAllocations || kIsDebugBuild>;
 #pragma GCC diagnostic pop
 
+const char* GetArenaAllocKindName(ArenaAllocKind kind) {
+  DCHECK_LT(static_cast<size_t>(kind), static_cast<size_t>(kNumArenaAllocKinds));
+  return ArenaAllocatorStatsImpl<true>::kAllocNames[kind];
+}
+
 void ArenaAllocatorMemoryTool::DoMakeDefined(void* ptr, size_t size) {
   MEMORY_TOOL_MAKE_DEFINED(ptr, size);
 }
@@ -179,7 +198,8 @@ void ArenaAllocatorMemoryTool::DoMakeInaccessible(void* ptr, size_t size) {
   MEMORY_TOOL_MAKE_NOACCESS(ptr, size);
 }
 
-Arena::Arena() : bytes_allocated_(0), memory_(nullptr), size_(0), next_(nullptr) {
+Arena::Arena()
+    : bytes_allocated_(0), memory_(nullptr), size_(0), next_(nullptr), numa_node_(0u) {
 }
 
 class MallocArena FINAL : public Arena {
@@ -272,12 +292,63 @@ void Arena::Reset() {
   }
 }
 
-ArenaPool::ArenaPool(bool use_malloc, bool low_4gb, const char* name)
+namespace {
+
+// Return the NUMA node of the CPU the calling thread is running on.
+size_t GetCurrentNumaNode() {
+#if defined(__linux__)
+  unsigned int cpu;
+  unsigned int node;
+  if (syscall(__NR_getcpu, &cpu, &node, nullptr) == 0) {
+    return node;
+  }
+#endif
+  return 0u;
+}
+
+// Ask the kernel to allocate the pages of [begin, begin + size) on `numa_node` if it can.
+void BindToNumaNode(uint8_t* begin, size_t size, size_t numa_node) {
+#if defined(__linux__)
+  static constexpr size_t kMaskBits = kBitsPerByte * sizeof(uint64_t);
+  if (numa_node >= kMaskBits) {
+    return;
+  }
+  uint64_t mask = UINT64_C(1) << numa_node;
+  // The kernel expects the number of bits in the mask plus one.
+  if (syscall(__NR_mbind, begin, size, MPOL_PREFERRED, &mask, kMaskBits + 1u, 0u) != 0) {
+    static Atomic<bool> warned(false);
+    if (!warned.ExchangeRelaxed(true)) {
+      PLOG(WARNING) << "Failed to bind arenas to NUMA node " << numa_node;
+    }
+  }
+#else
+  UNUSED(begin, size, numa_node);
+#endif
+}
+
+}  // namespace
+
+void ArenaPool::DeleteArenaChain(Arena* first) {
+  while (first != nullptr) {
+    Arena* next = first->next_;
+    delete first;
+    first = next;
+  }
+}
+
+ArenaPool::ArenaPool(bool use_malloc,
+                     bool low_4gb,
+                     const char* name,
+                     bool use_thread_caches,
+                     bool numa_local)
     : use_malloc_(use_malloc),
       lock_("Arena pool lock", kArenaPoolLock),
-      free_arenas_(nullptr),
+      free_arenas_(),
       low_4gb_(low_4gb),
-      name_(name) {
+      name_(name),
+      numa_local_(numa_local),
+      caches_(use_thread_caches ? new ArenaCache[kNumArenaCaches] : nullptr),
+      trimming_(false) {
   if (low_4gb) {
     CHECK(!use_malloc) << "low4gb must use map implementation";
   }
@@ -287,56 +358,221 @@ ArenaPool::ArenaPool(bool use_malloc, bool low_4gb, const char* name)
 }
 
 ArenaPool::~ArenaPool() {
+  if (caches_ != nullptr) {
+    for (size_t i = 0; i != kNumArenaCaches; ++i) {
+      DeleteArenaChain(caches_[i].arenas);
+    }
+  }
   ReclaimMemory();
 }
 
 void ArenaPool::ReclaimMemory() {
-  while (free_arenas_ != nullptr) {
-    auto* arena = free_arenas_;
-    free_arenas_ = free_arenas_->next_;
-    delete arena;
+  for (Arena*& free_arenas : free_arenas_) {
+    DeleteArenaChain(free_arenas);
+    free_arenas = nullptr;
   }
 }
 
 void ArenaPool::LockReclaimMemory() {
-  MutexLock lock(Thread::Current(), lock_);
+  Thread* self = Thread::Current();
+  if (caches_ != nullptr) {
+    for (size_t i = 0; i != kNumArenaCaches; ++i) {
+      ArenaCache& cache = caches_[i];
+      Arena* arenas;
+      {
+        MutexLock lock(self, cache.lock);
+        arenas = cache.arenas;
+        cache.arenas = nullptr;
+        cache.size = 0u;
+      }
+      DeleteArenaChain(arenas);
+    }
+  }
+  MutexLock lock(self, lock_);
   ReclaimMemory();
 }
 
+Arena* ArenaPool::NewArena(size_t size) {
+  Arena* arena = use_malloc_ ? static_cast<Arena*>(new MallocArena(size)) :
+      new MemMapArena(size, low_4gb_, name_);
+  if (numa_local_) {
+    // Malloc arenas are zeroed by the creating thread, which faults their pages on its node.
+    arena->numa_node_ = GetCurrentNumaNode();
+    if (!use_malloc_) {
+      // Keep the pages on that node when they are faulted in again after TrimMaps().
+      BindToNumaNode(arena->Begin(), arena->Size(), arena->numa_node_);
+    }
+  }
+  return arena;
+}
+
+ArenaPool::ArenaCache* ArenaPool::GetCache(Thread* self) {
+  if (caches_ == nullptr) {
+    return nullptr;
+  }
+  const pid_t tid = (self != nullptr) ? self->GetTid() : GetTid();
+  return &caches_[static_cast<size_t>(tid) % kNumArenaCaches];
+}
+
+size_t ArenaPool::FreeListIndex(size_t numa_node) const {
+  return numa_local_ ? numa_node % kMaxNumaNodes : 0u;
+}
+
+Arena* ArenaPool::TakeFreeArenas(Thread* self, size_t size, size_t max_count, size_t* count) {
+  DCHECK_NE(max_count, 0u);
+  const size_t local_index = FreeListIndex(numa_local_ ? GetCurrentNumaNode() : 0u);
+  MutexLock lock(self, lock_);
+  // Look at the free list of the local node first.
+  for (size_t i = 0; i != (numa_local_ ? kMaxNumaNodes : 1u); ++i) {
+    Arena*& free_arenas = free_arenas_[(local_index + i) % kMaxNumaNodes];
+    if (free_arenas != nullptr && LIKELY(free_arenas->Size() >= size)) {
+      Arena* first = free_arenas;
+      Arena* last = first;
+      *count = 1u;
+      while (*count != max_count && last->next_ != nullptr) {
+        last = last->next_;
+        ++*count;
+      }
+      free_arenas = last->next_;
+      last->next_ = nullptr;
+      return first;
+    }
+  }
+  return nullptr;
+}
+
+void ArenaPool::AddFreeArenas(Thread* self, Arena* first) {
+  DCHECK(first != nullptr);
+  if (numa_local_) {
+    MutexLock lock(self, lock_);
+    while (first != nullptr) {
+      Arena* next = first->next_;
+      Arena*& free_arenas = free_arenas_[FreeListIndex(first->numa_node_)];
+      first->next_ = free_arenas;
+      free_arenas = first;
+      first = next;
+    }
+    return;
+  }
+  Arena* last = first;
+  while (last->next_ != nullptr) {
+    last = last->next_;
+  }
+  MutexLock lock(self, lock_);
+  last->next_ = free_arenas_[0];
+  free_arenas_[0] = first;
+}
+
 Arena* ArenaPool::AllocArena(size_t size) {
   Thread* self = Thread::Current();
   Arena* ret = nullptr;
-  {
-    MutexLock lock(self, lock_);
-    if (free_arenas_ != nullptr && LIKELY(free_arenas_->Size() >= size)) {
-      ret = free_arenas_;
-      free_arenas_ = free_arenas_->next_;
+  ArenaCache* cache = GetCache(self);
+  if (cache != nullptr) {
+    MutexLock lock(self, cache->lock);
+    cache->used = true;
+    if (cache->arenas != nullptr && LIKELY(cache->arenas->Size() >= size)) {
+      ret = cache->arenas;
+      cache->arenas = ret->next_;
+      --cache->size;
     }
   }
   if (ret == nullptr) {
-    ret = use_malloc_ ? static_cast<Arena*>(new MallocArena(size)) :
-        new MemMapArena(size, low_4gb_, name_);
+    size_t count = 0u;
+    ret = TakeFreeArenas(self, size, (cache != nullptr) ? kArenaCacheBatch : 1u, &count);
+    if (count > 1u) {
+      // Keep the rest of the batch for the next allocations of this thread.
+      Arena* rest = ret->next_;
+      Arena* last = rest;
+      while (last->next_ != nullptr) {
+        last = last->next_;
+      }
+      MutexLock lock(self, cache->lock);
+      last->next_ = cache->arenas;
+      cache->arenas = rest;
+      cache->size += count - 1u;
+    }
+  }
+  if (ret == nullptr) {
+    ret = NewArena(size);
   }
   ret->Reset();
   return ret;
 }
 
 void ArenaPool::TrimMaps() {
-  if (!use_malloc_) {
-    ScopedTrace trace(__PRETTY_FUNCTION__);
+  if (use_malloc_) {
     // Doesn't work for malloc.
-    MutexLock lock(Thread::Current(), lock_);
-    for (auto* arena = free_arenas_; arena != nullptr; arena = arena->next_) {
+    return;
+  }
+  // If another thread is trimming, let it do the work rather than wait for it.
+  if (!trimming_.CompareExchangeStrongSequentiallyConsistent(false, true)) {
+    return;
+  }
+  ScopedTrace trace(__PRETTY_FUNCTION__);
+  Thread* self = Thread::Current();
+  // Release the free arenas without holding the lock, so that the madvise calls do not stall
+  // the threads allocating arenas.
+  Arena* trimmed[kMaxNumaNodes];
+  {
+    MutexLock lock(self, lock_);
+    for (size_t i = 0; i != kMaxNumaNodes; ++i) {
+      trimmed[i] = free_arenas_[i];
+      free_arenas_[i] = nullptr;
+    }
+  }
+  for (Arena* first : trimmed) {
+    for (Arena* arena = first; arena != nullptr; arena = arena->next_) {
       arena->Release();
     }
   }
+  {
+    // Put the trimmed arenas behind the ones freed in the meantime, which are still resident.
+    MutexLock lock(self, lock_);
+    for (size_t i = 0; i != kMaxNumaNodes; ++i) {
+      if (trimmed[i] == nullptr) {
+        continue;
+      }
+      Arena** tail = &free_arenas_[i];
+      while (*tail != nullptr) {
+        tail = &(*tail)->next_;
+      }
+      *tail = trimmed[i];
+    }
+  }
+  if (caches_ != nullptr) {
+    for (size_t i = 0; i != kNumArenaCaches; ++i) {
+      ArenaCache& cache = caches_[i];
+      MutexLock lock(self, cache.lock);
+      if (!cache.used) {
+        for (Arena* arena = cache.arenas; arena != nullptr; arena = arena->next_) {
+          arena->Release();
+        }
+      }
+      cache.used = false;
+    }
+  }
+  trimming_.StoreSequentiallyConsistent(false);
 }
 
 size_t ArenaPool::GetBytesAllocated() const {
   size_t total = 0;
-  MutexLock lock(Thread::Current(), lock_);
-  for (Arena* arena = free_arenas_; arena != nullptr; arena = arena->next_) {
-    total += arena->GetBytesAllocated();
+  Thread* self = Thread::Current();
+  {
+    MutexLock lock(self, lock_);
+    for (Arena* free_arenas : free_arenas_) {
+      for (Arena* arena = free_arenas; arena != nullptr; arena = arena->next_) {
+        total += arena->GetBytesAllocated();
+      }
+    }
+  }
+  if (caches_ != nullptr) {
+    for (size_t i = 0; i != kNumArenaCaches; ++i) {
+      ArenaCache& cache = caches_[i];
+      MutexLock lock(self, cache.lock);
+      for (Arena* arena = cache.arenas; arena != nullptr; arena = arena->next_) {
+        total += arena->GetBytesAllocated();
+      }
+    }
   }
   return total;
 }
@@ -350,23 +586,47 @@ void ArenaPool::FreeArenaChain(Arena* first) {
 
   if (arena_allocator::kArenaAllocatorPreciseTracking) {
     // Do not reuse arenas when tracking.
-    while (first != nullptr) {
-      Arena* next = first->next_;
-      delete first;
-      first = next;
-    }
+    DeleteArenaChain(first);
     return;
   }
 
-  if (first != nullptr) {
-    Arena* last = first;
-    while (last->next_ != nullptr) {
-      last = last->next_;
+  if (first == nullptr) {
+    return;
+  }
+  Thread* self = Thread::Current();
+  ArenaCache* cache = GetCache(self);
+  if (cache == nullptr) {
+    AddFreeArenas(self, first);
+    return;
+  }
+  static_assert(kArenaCacheBatch < kMaxCachedArenas, "The cache must keep some arenas");
+  Arena* last = first;
+  size_t count = 1u;
+  while (last->next_ != nullptr) {
+    last = last->next_;
+    ++count;
+  }
+  Arena* overflow = nullptr;
+  {
+    MutexLock lock(self, cache->lock);
+    cache->used = true;
+    last->next_ = cache->arenas;
+    cache->arenas = first;
+    cache->size += count;
+    if (cache->size > kMaxCachedArenas) {
+      // Keep the most recently freed arenas and leave room for a batch of frees before the
+      // next flush.
+      Arena* keep_last = cache->arenas;
+      for (size_t i = 1u; i != kMaxCachedArenas - kArenaCacheBatch; ++i) {
+        keep_last = keep_last->next_;
+      }
+      overflow = keep_last->next_;
+      keep_last->next_ = nullptr;
+      cache->size = kMaxCachedArenas - kArenaCacheBatch;
     }
-    Thread* self = Thread::Current();
-    MutexLock lock(self, lock_);
-    last->next_ = free_arenas_;
-    free_arenas_ = first;
+  }
+  if (overflow != nullptr) {
+    AddFreeArenas(self, overflow);
   }
 }
 
@@ -374,6 +634,10 @@ size_t ArenaAllocator::BytesAllocated() const {
   return ArenaAllocatorStats::BytesAllocated();
 }
 
+size_t ArenaAllocator::BytesAllocated(ArenaAllocKind kind) const {
+  return ArenaAllocatorStats::BytesAllocated(kind);
+}
+
 size_t ArenaAllocator::BytesUsed() const {
   size_t total = ptr_ - begin_;
   if (arena_head_ != nullptr) {
@@ -20,6 +20,9 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#include <memory>
+
+#include "atomic.h"
 #include "base/bit_utils.h"
 #include "base/dchecked_vector.h"
 #include "base/memory_tool.h"
@@ -81,6 +84,8 @@ enum ArenaAllocKind {
   kArenaAllocDCE,
   kArenaAllocLSE,
   kArenaAllocLICM,
+  kArenaAllocPRE,
+  kArenaAllocPEA,
   kArenaAllocLoopOptimization,
   kArenaAllocSsaLiveness,
   kArenaAllocSsaPhiElimination,
@@ -102,6 +107,9 @@ enum ArenaAllocKind {
   kNumArenaAllocKinds
 };
 
+// Returns the name used for `kind` in the allocation statistics dumps, padded with spaces.
+const char* GetArenaAllocKindName(ArenaAllocKind kind);
+
 template <bool kCount>
 class ArenaAllocatorStatsImpl;
 
@@ -116,6 +124,7 @@ class ArenaAllocatorStatsImpl<false> {
   void RecordAlloc(size_t bytes ATTRIBUTE_UNUSED, ArenaAllocKind kind ATTRIBUTE_UNUSED) {}
   size_t NumAllocations() const { return 0u; }
   size_t BytesAllocated() const { return 0u; }
+  size_t BytesAllocated(ArenaAllocKind kind ATTRIBUTE_UNUSED) const { return 0u; }
   void Dump(std::ostream& os ATTRIBUTE_UNUSED,
             const Arena* first ATTRIBUTE_UNUSED,
             ssize_t lost_bytes_adjustment ATTRIBUTE_UNUSED) const {}
@@ -132,6 +141,7 @@ class ArenaAllocatorStatsImpl {
   void RecordAlloc(size_t bytes, ArenaAllocKind kind);
   size_t NumAllocations() const;
   size_t BytesAllocated() const;
+  size_t BytesAllocated(ArenaAllocKind kind) const;
   void Dump(std::ostream& os, const Arena* first, ssize_t lost_bytes_adjustment) const;
 
  private:
@@ -139,6 +149,8 @@ class ArenaAllocatorStatsImpl {
   dchecked_vector<size_t> alloc_stats_;  // Bytes used by various allocation kinds.
 
   static const char* const kAllocNames[];
+
+  friend const char* GetArenaAllocKindName(ArenaAllocKind kind);
 };
 
 typedef ArenaAllocatorStatsImpl<kArenaAllocatorCountAllocations> ArenaAllocatorStats;
@@ -232,6 +244,8 @@ class Arena {
   uint8_t* memory_;
   size_t size_;
   Arena* next_;
+  // NUMA node of the thread that created the arena, only tracked by NUMA aware pools.
+  size_t numa_node_;
   friend class ArenaPool;
   friend class ArenaAllocator;
   friend class ArenaStack;
@@ -246,9 +260,16 @@ class Arena {
 
 class ArenaPool {
  public:
+  // If `use_thread_caches` is true, freed arenas are kept in small per-thread caches that are
+  // refilled from and flushed to the shared free list in batches, so that threads allocating
+  // arenas concurrently (such as dex2oat compiler threads) rarely contend on `lock_`.
+  // If `numa_local` is true, arenas are reused on the NUMA node that created them when possible
+  // and the pages of mapped arenas are bound to that node.
   explicit ArenaPool(bool use_malloc = true,
                      bool low_4gb = false,
-                     const char* name = "LinearAlloc");
+                     const char* name = "LinearAlloc",
+                     bool use_thread_caches = false,
+                     bool numa_local = false);
   ~ArenaPool();
   Arena* AllocArena(size_t size) REQUIRES(!lock_);
   void FreeArenaChain(Arena* first) REQUIRES(!lock_);
@@ -256,15 +277,50 @@ class ArenaPool {
   void ReclaimMemory() NO_THREAD_SAFETY_ANALYSIS;
   void LockReclaimMemory() REQUIRES(!lock_);
   // Trim the maps in arenas by madvising, used by JIT to reduce memory usage. This only works
-  // use_malloc is false.
+  // use_malloc is false. The madvise calls are made without holding `lock_`, a call made while
+  // another thread is trimming returns immediately, and thread caches that were used since the
+  // previous trim are left alone as their arenas are likely to be reused soon.
   void TrimMaps() REQUIRES(!lock_);
 
+  // Maximum number of arenas kept in a thread cache.
+  static constexpr size_t kMaxCachedArenas = 8;
+  // Number of arenas moved between a thread cache and the shared free list at once.
+  static constexpr size_t kArenaCacheBatch = 4;
+  // Number of thread caches, threads are mapped to caches by thread id.
+  static constexpr size_t kNumArenaCaches = 64;
+  // Number of NUMA nodes with their own free list, higher nodes share lists.
+  static constexpr size_t kMaxNumaNodes = 8;
+
  private:
+  struct ArenaCache {
+    ArenaCache() : lock("Arena cache lock", kArenaCacheLock) {}
+
+    Mutex lock;
+    Arena* arenas GUARDED_BY(lock) = nullptr;
+    size_t size GUARDED_BY(lock) = 0u;
+    // Whether the cache was used since the last TrimMaps().
+    bool used GUARDED_BY(lock) = false;
+  };
+
+  static void DeleteArenaChain(Arena* first);
+  Arena* NewArena(size_t size);
+  ArenaCache* GetCache(Thread* self);
+  // Take up to `max_count` arenas from the free lists, the first one at least `size` bytes.
+  // Returns null if there is no such arena.
+  Arena* TakeFreeArenas(Thread* self, size_t size, size_t max_count, size_t* count)
+      REQUIRES(!lock_);
+  void AddFreeArenas(Thread* self, Arena* first) REQUIRES(!lock_);
+  size_t FreeListIndex(size_t numa_node) const;
+
   const bool use_malloc_;
   mutable Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
-  Arena* free_arenas_ GUARDED_BY(lock_);
+  // Free lists by NUMA node, only the first one is used if `numa_local_` is false.
+  Arena* free_arenas_[kMaxNumaNodes] GUARDED_BY(lock_);
   const bool low_4gb_;
   const char* name_;
+  const bool numa_local_;
+  std::unique_ptr<ArenaCache[]> caches_;
+  Atomic<bool> trimming_;
   DISALLOW_COPY_AND_ASSIGN(ArenaPool);
 };
 
@@ -367,6 +423,9 @@ class ArenaAllocator
 
   size_t BytesAllocated() const;
 
+  // Bytes allocated for `kind`. Always 0 unless kArenaAllocatorCountAllocations.
+  size_t BytesAllocated(ArenaAllocKind kind) const;
+
   MemStats GetMemStats() const;
 
   // The BytesUsed method sums up bytes allocated from arenas in arena_head_ and nodes.
@@ -14,6 +14,9 @@
  * limitations under the License.
  */
 
+#include <thread>
+#include <vector>
+
 #include "base/arena_allocator-inl.h"
 #include "base/arena_bit_vector.h"
 #include "base/memory_tool.h"
@@ -348,5 +351,95 @@ TEST_F(ArenaAllocatorTest, ReallocAlignment) {
   }
 }
 
+TEST_F(ArenaAllocatorTest, ThreadCaches) {
+  if (arena_allocator::kArenaAllocatorPreciseTracking) {
+    return;  // Arenas are not reused when tracking.
+  }
+  ArenaPool pool(/* use_malloc */ true,
+                 /* low_4gb */ false,
+                 "ThreadCaches",
+                 /* use_thread_caches */ true);
+  const void* first_allocation;
+  {
+    ArenaAllocator arena(&pool);
+    first_allocation = arena.Alloc(arena_allocator::kArenaDefaultSize * 3 / 4);
+  }
+  EXPECT_NE(0u, pool.GetBytesAllocated());
+  {
+    // The arena comes back from the cache of this thread.
+    ArenaAllocator arena(&pool);
+    EXPECT_EQ(first_allocation, arena.Alloc(arena_allocator::kArenaDefaultSize * 3 / 4));
+  }
+  {
+    // Overflow the cache into the shared free list.
+    ArenaAllocator arena(&pool);
+    for (size_t i = 0; i != 2 * ArenaPool::kMaxCachedArenas; ++i) {
+      arena.Alloc(arena_allocator::kArenaDefaultSize * 3 / 4);
+    }
+    EXPECT_EQ(2 * ArenaPool::kMaxCachedArenas, NumberOfArenas(&arena));
+  }
+  {
+    // Take the arenas back, from the cache and then from the free list.
+    ArenaAllocator arena(&pool);
+    for (size_t i = 0; i != 2 * ArenaPool::kMaxCachedArenas; ++i) {
+      arena.Alloc(arena_allocator::kArenaDefaultSize * 3 / 4);
+    }
+  }
+  EXPECT_NE(0u, pool.GetBytesAllocated());
+  pool.LockReclaimMemory();
+  EXPECT_EQ(0u, pool.GetBytesAllocated());
+}
+
+TEST_F(ArenaAllocatorTest, ThreadCachesConcurrent) {
+  for (bool numa_local : { false, true }) {
+    ArenaPool pool(/* use_malloc */ false,
+                   /* low_4gb */ false,
+                   "ThreadCachesConcurrent",
+                   /* use_thread_caches */ true,
+                   numa_local);
+    static constexpr size_t kNumThreads = 8;
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t != kNumThreads; ++t) {
+      threads.emplace_back([&pool, t]() {
+        for (size_t i = 0; i != 200; ++i) {
+          ArenaAllocator arena(&pool);
+          for (size_t j = 0; j != (i + t) % 5 + 1; ++j) {
+            uint32_t* array = arena.AllocArray<uint32_t>(arena_allocator::kArenaDefaultSize / 8);
+            // Arenas are zeroed before reuse.
+            ASSERT_EQ(0u, array[0]);
+            array[0] = 1u;
+          }
+          if (i % 50 == 0) {
+            pool.TrimMaps();
+          }
+        }
+      });
+    }
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+  }
+}
+
+TEST_F(ArenaAllocatorTest, TrimMapsKeepsActiveCaches) {
+  if (arena_allocator::kArenaAllocatorPreciseTracking) {
+    return;  // Arenas are not reused when tracking.
+  }
+  ArenaPool pool(/* use_malloc */ false,
+                 /* low_4gb */ false,
+                 "TrimMaps",
+                 /* use_thread_caches */ true);
+  {
+    ArenaAllocator arena(&pool);
+    arena.Alloc(arena_allocator::kArenaDefaultSize * 3 / 4);
+  }
+  EXPECT_NE(0u, pool.GetBytesAllocated());
+  // The cache was used since the last trim, its arena stays resident.
+  pool.TrimMaps();
+  EXPECT_NE(0u, pool.GetBytesAllocated());
+  // The cache is idle now.
+  pool.TrimMaps();
+  EXPECT_EQ(0u, pool.GetBytesAllocated());
+}
 
 }  // namespace art
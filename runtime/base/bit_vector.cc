@@ -121,97 +121,76 @@ void BitVector::Intersect(const BitVector* src) {
   // Get the minimum size between us and source.
   uint32_t min_size = (storage_size_ < src_storage_size) ? storage_size_ : src_storage_size;
 
-  uint32_t idx;
-  for (idx = 0; idx < min_size; idx++) {
-    storage_[idx] &= src->GetRawStorageWord(idx);
+  uint32_t* storage = storage_;
+  const uint32_t* src_storage = src->storage_;
+  for (uint32_t idx = 0; idx < min_size; idx++) {
+    storage[idx] &= src_storage[idx];
   }
 
   // Now, due to this being an intersection, there are two possibilities:
   //   - Either src was larger than us: we don't care, all upper bits would thus be 0.
   //   - Either we are larger than src: we don't care, all upper bits would have been 0 too.
   // So all we need to do is set all remaining bits to 0.
-  for (; idx < storage_size_; idx++) {
-    storage_[idx] = 0;
+  if (min_size < storage_size_) {
+    memset(storage + min_size, 0, (storage_size_ - min_size) * kWordBytes);
   }
 }
 
-bool BitVector::Union(const BitVector* src) {
-  // Get the highest bit to determine how much we need to expand.
-  int highest_bit = src->GetHighestBitSet();
-  bool changed = false;
-
-  // If src has no bit set, we are done: there is no need for a union with src.
-  if (highest_bit == -1) {
-    return changed;
-  }
-
-  // Update src_size to how many cells we actually care about: where the bit is + 1.
-  uint32_t src_size = BitsToWords(highest_bit + 1);
-
-  // Is the storage size smaller than src's?
-  if (storage_size_ < src_size) {
-    changed = true;
-
+uint32_t BitVector::EnsureSizeFor(const BitVector* src) {
+  uint32_t src_size = src->storage_size_;
+  if (src_size > storage_size_) {
+    int highest_bit = src->GetHighestBitSet();
+    if (highest_bit == -1) {
+      return 0u;
+    }
     EnsureSize(highest_bit);
-
     // Paranoid: storage size should be big enough to hold this bit now.
-    DCHECK_LT(static_cast<uint32_t> (highest_bit), storage_size_ * kWordBits);
+    DCHECK_LT(static_cast<uint32_t>(highest_bit), storage_size_ * kWordBits);
+    src_size = BitsToWords(highest_bit + 1);
   }
+  return src_size;
+}
 
+// The loops below record whether anything changed by accumulating the changed bits instead of
+// branching on every word, which lets the compiler vectorize them.
+
+bool BitVector::Union(const BitVector* src) {
+  uint32_t src_size = EnsureSizeFor(src);
+  uint32_t* storage = storage_;
+  const uint32_t* src_storage = src->storage_;
+  uint32_t changed_bits = 0u;
   for (uint32_t idx = 0; idx < src_size; idx++) {
-    uint32_t existing = storage_[idx];
-    uint32_t update = existing | src->GetRawStorageWord(idx);
-    if (existing != update) {
-      changed = true;
-      storage_[idx] = update;
-    }
+    uint32_t existing = storage[idx];
+    uint32_t update = existing | src_storage[idx];
+    changed_bits |= existing ^ update;
+    storage[idx] = update;
   }
-  return changed;
+  return changed_bits != 0u;
 }
 
 bool BitVector::UnionIfNotIn(const BitVector* union_with, const BitVector* not_in) {
-  // Get the highest bit to determine how much we need to expand.
-  int highest_bit = union_with->GetHighestBitSet();
-  bool changed = false;
-
-  // If src has no bit set, we are done: there is no need for a union with src.
-  if (highest_bit == -1) {
-    return changed;
-  }
-
-  // Update union_with_size to how many cells we actually care about: where the bit is + 1.
-  uint32_t union_with_size = BitsToWords(highest_bit + 1);
-
-  // Is the storage size smaller than src's?
-  if (storage_size_ < union_with_size) {
-    EnsureSize(highest_bit);
-
-    // Paranoid: storage size should be big enough to hold this bit now.
-    DCHECK_LT(static_cast<uint32_t> (highest_bit), storage_size_ * kWordBits);
-  }
-
+  uint32_t union_with_size = EnsureSizeFor(union_with);
   uint32_t not_in_size = not_in->GetStorageSize();
+  uint32_t* storage = storage_;
+  const uint32_t* union_with_storage = union_with->storage_;
+  const uint32_t* not_in_storage = not_in->storage_;
+  uint32_t changed_bits = 0u;
 
   uint32_t idx = 0;
-  for (; idx < std::min(not_in_size, union_with_size); idx++) {
-    uint32_t existing = storage_[idx];
-    uint32_t update = existing |
-        (union_with->GetRawStorageWord(idx) & ~not_in->GetRawStorageWord(idx));
-    if (existing != update) {
-      changed = true;
-      storage_[idx] = update;
-    }
+  for (uint32_t end = std::min(not_in_size, union_with_size); idx < end; idx++) {
+    uint32_t existing = storage[idx];
+    uint32_t update = existing | (union_with_storage[idx] & ~not_in_storage[idx]);
+    changed_bits |= existing ^ update;
+    storage[idx] = update;
   }
 
   for (; idx < union_with_size; idx++) {
-    uint32_t existing = storage_[idx];
-    uint32_t update = existing | union_with->GetRawStorageWord(idx);
-    if (existing != update) {
-      changed = true;
-      storage_[idx] = update;
-    }
+    uint32_t existing = storage[idx];
+    uint32_t update = existing | union_with_storage[idx];
+    changed_bits |= existing ^ update;
+    storage[idx] = update;
   }
-  return changed;
+  return changed_bits != 0u;
 }
 
 void BitVector::Subtract(const BitVector *src) {
@@ -224,8 +203,10 @@ void BitVector::Subtract(const BitVector *src) {
   //   There is no need to do more:
   //     If we are bigger than src, the upper bits are unchanged.
   //     If we are smaller than src, the non-existant upper bits are 0 and thus can't get subtracted.
+  uint32_t* storage = storage_;
+  const uint32_t* src_storage = src->storage_;
   for (uint32_t idx = 0; idx < min_size; idx++) {
-    storage_[idx] &= (~(src->GetRawStorageWord(idx)));
+    storage[idx] &= ~src_storage[idx];
   }
 }
 
@@ -282,6 +282,9 @@ class BitVector {
 
   // Ensure there is space for a bit at idx.
   void EnsureSize(uint32_t idx);
+  // Ensure there is space for the bits set in src, and return the number of words of src that
+  // may have bits set. Only looks for the highest bit set in src if src is larger than us.
+  uint32_t EnsureSizeFor(const BitVector* src);
 
   // The index of the word within storage.
   static constexpr uint32_t WordIndex(uint32_t idx) {
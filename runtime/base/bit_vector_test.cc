@@ -15,6 +15,7 @@
  */
 
 #include <memory>
+#include <vector>
 
 #include "allocator.h"
 #include "bit_vector-inl.h"
@@ -269,4 +270,74 @@ TEST(BitVector, CopyTo) {
   }
 }
 
+TEST(BitVector, SetOperations) {
+  // Compare the set operations with a reference on vectors of different sizes and densities.
+  uint32_t seed = 1234u;
+  auto next_random = [&seed]() {
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 8;
+  };
+  static constexpr uint32_t kMaxBits = 1000u;
+  for (size_t iteration = 0; iteration != 200u; ++iteration) {
+    BitVector vectors[3] = {
+        BitVector(next_random() % kMaxBits + 1u, true, Allocator::GetMallocAllocator()),
+        BitVector(next_random() % kMaxBits + 1u, true, Allocator::GetMallocAllocator()),
+        BitVector(next_random() % kMaxBits + 1u, true, Allocator::GetMallocAllocator()),
+    };
+    std::vector<bool> expected[3];
+    for (size_t v = 0; v != 3u; ++v) {
+      // The number of bits may be smaller than the storage, leaving zero words at the end.
+      uint32_t num_bits = next_random() % (vectors[v].GetStorageSize() * 32u + 1u);
+      uint32_t density = next_random() % 100u + 1u;
+      expected[v].resize(kMaxBits + 32u, false);
+      for (uint32_t i = 0; i != num_bits; ++i) {
+        if (next_random() % 100u < density) {
+          vectors[v].SetBit(i);
+          expected[v][i] = true;
+        }
+      }
+    }
+    auto check = [&](size_t v) {
+      for (uint32_t i = 0; i != kMaxBits + 32u; ++i) {
+        ASSERT_EQ(expected[v][i], vectors[v].IsBitSet(i)) << iteration << " " << i;
+      }
+    };
+    std::vector<bool> old = expected[0];
+    bool expected_changed = false;
+    switch (iteration % 4u) {
+      case 0:
+        for (uint32_t i = 0; i != kMaxBits + 32u; ++i) {
+          expected[0][i] = old[i] || expected[1][i];
+          expected_changed |= expected[0][i] != old[i];
+        }
+        EXPECT_EQ(expected_changed, vectors[0].Union(&vectors[1]));
+        break;
+      case 1:
+        for (uint32_t i = 0; i != kMaxBits + 32u; ++i) {
+          expected[0][i] = old[i] || (expected[1][i] && !expected[2][i]);
+          expected_changed |= expected[0][i] != old[i];
+        }
+        EXPECT_EQ(expected_changed, vectors[0].UnionIfNotIn(&vectors[1], &vectors[2]));
+        break;
+      case 2:
+        for (uint32_t i = 0; i != kMaxBits + 32u; ++i) {
+          expected[0][i] = old[i] && expected[1][i];
+        }
+        vectors[0].Intersect(&vectors[1]);
+        break;
+      case 3:
+        for (uint32_t i = 0; i != kMaxBits + 32u; ++i) {
+          expected[0][i] = old[i] && !expected[1][i];
+        }
+        vectors[0].Subtract(&vectors[1]);
+        break;
+    }
+    check(0);
+    check(1);
+    // A union with itself changes nothing.
+    EXPECT_FALSE(vectors[1].Union(&vectors[1]));
+    check(1);
+  }
+}
+
 }  // namespace art
@@ -0,0 +1,792 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_BASE_FLAT_HASH_SET_H_
+#define ART_RUNTIME_BASE_FLAT_HASH_SET_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+#include "bit_utils.h"
+#include "globals.h"
+#include "hash_set.h"
+#include "logging.h"
+
+namespace art {
+
+// Hash set with the same interface as HashSet, which keeps a control byte per slot next to the
+// elements. A full slot's control byte holds 7 bits of the element's hash, so that a lookup
+// compares the control bytes of a group of slots at once and only calls Pred on the slots whose
+// hash bits match, instead of calling EmptyFn and Pred on every slot of a linear probe.
+//
+// The slots are split in groups of kGroupWidth. The groups are probed quadratically, and the
+// control bytes of a group are matched with word-wide bit operations, which need no vector
+// instructions. The control bytes also make it possible to run at higher load factors than
+// HashSet. EmptyFn is only used to keep the elements of the free slots in a known state, the
+// emptiness of a slot is given by its control byte.
+//
+// The serialized format of WriteToMemory differs from HashSet's, the two can't read each other's
+// tables.
+template <class T, class EmptyFn = DefaultEmptyFn<T>, class HashFn = std::hash<T>,
+    class Pred = std::equal_to<T>, class Alloc = std::allocator<T>>
+class FlatHashSet {
+  template <class Elem, class HashSetType>
+  class BaseIterator : std::iterator<std::forward_iterator_tag, Elem> {
+   public:
+    BaseIterator(const BaseIterator&) = default;
+    BaseIterator(BaseIterator&&) = default;
+    BaseIterator(HashSetType* hash_set, size_t index) : index_(index), hash_set_(hash_set) {
+    }
+    BaseIterator& operator=(const BaseIterator&) = default;
+    BaseIterator& operator=(BaseIterator&&) = default;
+
+    bool operator==(const BaseIterator& other) const {
+      return hash_set_ == other.hash_set_ && this->index_ == other.index_;
+    }
+
+    bool operator!=(const BaseIterator& other) const {
+      return !(*this == other);
+    }
+
+    BaseIterator operator++() {  // Value after modification.
+      this->index_ = hash_set_->NextFullSlot(this->index_);
+      return *this;
+    }
+
+    BaseIterator operator++(int) {
+      BaseIterator temp = *this;
+      this->index_ = hash_set_->NextFullSlot(this->index_);
+      return temp;
+    }
+
+    Elem& operator*() const {
+      DCHECK(!hash_set_->IsFreeSlot(this->index_));
+      return hash_set_->ElementForIndex(this->index_);
+    }
+
+    Elem* operator->() const {
+      return &**this;
+    }
+
+   private:
+    size_t index_;
+    HashSetType* hash_set_;
+
+    friend class FlatHashSet;
+  };
+
+ public:
+  using value_type = T;
+  using allocator_type = Alloc;
+  using reference = T&;
+  using const_reference = const T&;
+  using pointer = T*;
+  using const_pointer = const T*;
+  using iterator = BaseIterator<T, FlatHashSet>;
+  using const_iterator = BaseIterator<const T, const FlatHashSet>;
+  using size_type = size_t;
+  using difference_type = ptrdiff_t;
+
+  static constexpr double kDefaultMinLoadFactor = 0.5;
+  static constexpr double kDefaultMaxLoadFactor = 0.875;
+  static constexpr size_t kMinBuckets = 1024;
+
+  // Number of slots whose control bytes are matched at once.
+  static constexpr size_t kGroupWidth = sizeof(uint64_t);
+
+  // If we don't own the data, this will create a new array which owns the data.
+  void Clear() {
+    DeallocateStorage();
+    num_elements_ = 0;
+    num_deleted_ = 0;
+    elements_until_expand_ = 0;
+  }
+
+  FlatHashSet() : FlatHashSet(kDefaultMinLoadFactor, kDefaultMaxLoadFactor) {}
+
+  FlatHashSet(double min_load_factor, double max_load_factor) noexcept
+      : num_elements_(0u),
+        num_deleted_(0u),
+        num_buckets_(0u),
+        elements_until_expand_(0u),
+        owns_data_(false),
+        ctrl_(nullptr),
+        data_(nullptr),
+        min_load_factor_(min_load_factor),
+        max_load_factor_(max_load_factor) {
+    DCHECK_GT(min_load_factor, 0.0);
+    DCHECK_LT(max_load_factor, 1.0);
+  }
+
+  explicit FlatHashSet(const allocator_type& alloc) noexcept
+      : allocfn_(alloc),
+        hashfn_(),
+        emptyfn_(),
+        pred_(),
+        num_elements_(0u),
+        num_deleted_(0u),
+        num_buckets_(0u),
+        elements_until_expand_(0u),
+        owns_data_(false),
+        ctrl_(nullptr),
+        data_(nullptr),
+        min_load_factor_(kDefaultMinLoadFactor),
+        max_load_factor_(kDefaultMaxLoadFactor) {
+  }
+
+  FlatHashSet(const FlatHashSet& other) noexcept
+      : allocfn_(other.allocfn_),
+        hashfn_(other.hashfn_),
+        emptyfn_(other.emptyfn_),
+        pred_(other.pred_),
+        num_elements_(other.num_elements_),
+        num_deleted_(other.num_deleted_),
+        num_buckets_(0),
+        elements_until_expand_(other.elements_until_expand_),
+        owns_data_(false),
+        ctrl_(nullptr),
+        data_(nullptr),
+        min_load_factor_(other.min_load_factor_),
+        max_load_factor_(other.max_load_factor_) {
+    AllocateStorage(other.NumBuckets());
+    for (size_t i = 0; i < num_buckets_; ++i) {
+      ctrl_[i] = other.ctrl_[i];
+      ElementForIndex(i) = other.data_[i];
+    }
+  }
+
+  // noexcept required so that the move constructor is used instead of copy constructor.
+  // b/27860101
+  FlatHashSet(FlatHashSet&& other) noexcept
+      : allocfn_(std::move(other.allocfn_)),
+        hashfn_(std::move(other.hashfn_)),
+        emptyfn_(std::move(other.emptyfn_)),
+        pred_(std::move(other.pred_)),
+        num_elements_(other.num_elements_),
+        num_deleted_(other.num_deleted_),
+        num_buckets_(other.num_buckets_),
+        elements_until_expand_(other.elements_until_expand_),
+        owns_data_(other.owns_data_),
+        ctrl_(other.ctrl_),
+        data_(other.data_),
+        min_load_factor_(other.min_load_factor_),
+        max_load_factor_(other.max_load_factor_) {
+    other.num_elements_ = 0u;
+    other.num_deleted_ = 0u;
+    other.num_buckets_ = 0u;
+    other.elements_until_expand_ = 0u;
+    other.owns_data_ = false;
+    other.ctrl_ = nullptr;
+    other.data_ = nullptr;
+  }
+
+  // Construct from existing data.
+  // Read from a block of memory, if make_copy_of_data is false, then ctrl_ and data_ point to
+  // within the passed in ptr_.
+  FlatHashSet(const uint8_t* ptr, bool make_copy_of_data, size_t* read_count) noexcept {
+    uint64_t temp;
+    size_t offset = 0;
+    offset = ReadFromBytes(ptr, offset, &temp);
+    num_elements_ = static_cast<uint64_t>(temp);
+    offset = ReadFromBytes(ptr, offset, &temp);
+    num_deleted_ = static_cast<uint64_t>(temp);
+    offset = ReadFromBytes(ptr, offset, &temp);
+    num_buckets_ = static_cast<uint64_t>(temp);
+    CHECK_LE(num_elements_ + num_deleted_, num_buckets_);
+    CHECK(num_buckets_ == 0u || IsPowerOfTwo(num_buckets_ / kGroupWidth)) << num_buckets_;
+    offset = ReadFromBytes(ptr, offset, &temp);
+    elements_until_expand_ = static_cast<uint64_t>(temp);
+    offset = ReadFromBytes(ptr, offset, &min_load_factor_);
+    offset = ReadFromBytes(ptr, offset, &max_load_factor_);
+    if (!make_copy_of_data) {
+      owns_data_ = false;
+      ctrl_ = const_cast<uint8_t*>(ptr + offset);
+      offset = RoundUp(offset + num_buckets_, sizeof(uint64_t));
+      data_ = const_cast<T*>(reinterpret_cast<const T*>(ptr + offset));
+      offset += sizeof(*data_) * num_buckets_;
+    } else {
+      AllocateStorage(num_buckets_);
+      memcpy(ctrl_, ptr + offset, num_buckets_);
+      offset = RoundUp(offset + num_buckets_, sizeof(uint64_t));
+      // Write elements, not that this may not be safe for cross compilation if the elements are
+      // pointer sized.
+      for (size_t i = 0; i < num_buckets_; ++i) {
+        offset = ReadFromBytes(ptr, offset, &data_[i]);
+      }
+    }
+    // Caller responsible for aligning.
+    *read_count = offset;
+  }
+
+  // Returns how large the table is after being written. If target is null, then no writing happens
+  // but the size is still returned. Target must be 8 byte aligned.
+  size_t WriteToMemory(uint8_t* ptr) const {
+    size_t offset = 0;
+    offset = WriteToBytes(ptr, offset, static_cast<uint64_t>(num_elements_));
+    offset = WriteToBytes(ptr, offset, static_cast<uint64_t>(num_deleted_));
+    offset = WriteToBytes(ptr, offset, static_cast<uint64_t>(num_buckets_));
+    offset = WriteToBytes(ptr, offset, static_cast<uint64_t>(elements_until_expand_));
+    offset = WriteToBytes(ptr, offset, min_load_factor_);
+    offset = WriteToBytes(ptr, offset, max_load_factor_);
+    if (ptr != nullptr) {
+      memcpy(ptr + offset, ctrl_, num_buckets_);
+      // Keep the padding deterministic.
+      memset(ptr + offset + num_buckets_,
+             0,
+             RoundUp(offset + num_buckets_, sizeof(uint64_t)) - (offset + num_buckets_));
+    }
+    offset = RoundUp(offset + num_buckets_, sizeof(uint64_t));
+    // Write elements, not that this may not be safe for cross compilation if the elements are
+    // pointer sized.
+    for (size_t i = 0; i < num_buckets_; ++i) {
+      offset = WriteToBytes(ptr, offset, data_[i]);
+    }
+    // Caller responsible for aligning.
+    return offset;
+  }
+
+  ~FlatHashSet() {
+    DeallocateStorage();
+  }
+
+  FlatHashSet& operator=(FlatHashSet&& other) noexcept {
+    FlatHashSet(std::move(other)).swap(*this);
+    return *this;
+  }
+
+  FlatHashSet& operator=(const FlatHashSet& other) noexcept {
+    FlatHashSet(other).swap(*this);  // NOLINT(runtime/explicit) - a case of lint gone mad.
+    return *this;
+  }
+
+  // Lower case for c++11 for each.
+  iterator begin() {
+    return iterator(this, FirstFullSlot());
+  }
+
+  // Lower case for c++11 for each. const version.
+  const_iterator begin() const {
+    return const_iterator(this, FirstFullSlot());
+  }
+
+  // Lower case for c++11 for each.
+  iterator end() {
+    return iterator(this, NumBuckets());
+  }
+
+  // Lower case for c++11 for each. const version.
+  const_iterator end() const {
+    return const_iterator(this, NumBuckets());
+  }
+
+  bool Empty() const {
+    return Size() == 0;
+  }
+
+  // Return true if the hash set has ownership of the underlying data.
+  bool OwnsData() const {
+    return owns_data_;
+  }
+
+  // Erase algorithm:
+  // A slot can be made empty again only if no probe went past its group, which is the case if
+  // the group has an empty slot: a group never gets an empty slot back once it was full, since
+  // erasing from a full group leaves a deleted marker. Otherwise the slot is marked deleted, so
+  // that probes keep going. Deleted slots are reused by inserts and dropped on resize.
+  iterator Erase(iterator it) {
+    const size_t index = it.index_;
+    DCHECK(!IsFreeSlot(index));
+    const size_t group_begin = RoundDown(index, kGroupWidth);
+    if (MatchEmpty(LoadGroup(group_begin)) != 0u) {
+      ctrl_[index] = kEmpty;
+    } else {
+      ctrl_[index] = kDeleted;
+      ++num_deleted_;
+    }
+    emptyfn_.MakeEmpty(ElementForIndex(index));
+    --num_elements_;
+    ++it;
+    return it;
+  }
+
+  // Find an element, returns end() if not found.
+  // Allows custom key (K) types, example of when this is useful:
+  // Set of Class* sorted by name, want to find a class with a name but can't allocate a dummy
+  // object in the heap for performance solution.
+  template <typename K>
+  iterator Find(const K& key) {
+    return FindWithHash(key, hashfn_(key));
+  }
+
+  template <typename K>
+  const_iterator Find(const K& key) const {
+    return FindWithHash(key, hashfn_(key));
+  }
+
+  template <typename K>
+  iterator FindWithHash(const K& key, size_t hash) {
+    return iterator(this, FindIndex(key, hash));
+  }
+
+  template <typename K>
+  const_iterator FindWithHash(const K& key, size_t hash) const {
+    return const_iterator(this, FindIndex(key, hash));
+  }
+
+  // Insert an element, allows duplicates.
+  void Insert(const T& element) {
+    InsertWithHash(element, hashfn_(element));
+  }
+
+  void InsertWithHash(const T& element, size_t hash) {
+    DCHECK_EQ(hash, hashfn_(element));
+    if (num_elements_ + num_deleted_ >= elements_until_expand_) {
+      Expand();
+      DCHECK_LT(num_elements_ + num_deleted_, elements_until_expand_);
+    }
+    const size_t mixed_hash = MixHash(hash);
+    const size_t index = FirstAvailableSlot(mixed_hash);
+    if (ctrl_[index] == kDeleted) {
+      --num_deleted_;
+    }
+    ctrl_[index] = HashBits(mixed_hash);
+    data_[index] = element;
+    ++num_elements_;
+  }
+
+  size_t Size() const {
+    return num_elements_;
+  }
+
+  void swap(FlatHashSet& other) {
+    // Use argument-dependent lookup with fall-back to std::swap() for function objects.
+    using std::swap;
+    swap(allocfn_, other.allocfn_);
+    swap(hashfn_, other.hashfn_);
+    swap(emptyfn_, other.emptyfn_);
+    swap(pred_, other.pred_);
+    std::swap(ctrl_, other.ctrl_);
+    std::swap(data_, other.data_);
+    std::swap(num_buckets_, other.num_buckets_);
+    std::swap(num_elements_, other.num_elements_);
+    std::swap(num_deleted_, other.num_deleted_);
+    std::swap(elements_until_expand_, other.elements_until_expand_);
+    std::swap(min_load_factor_, other.min_load_factor_);
+    std::swap(max_load_factor_, other.max_load_factor_);
+    std::swap(owns_data_, other.owns_data_);
+  }
+
+  allocator_type get_allocator() const {
+    return allocfn_;
+  }
+
+  void ShrinkToMaximumLoad() {
+    Resize(Size() / max_load_factor_);
+  }
+
+  // Reserve enough room to insert until Size() == num_elements without requiring to grow the hash
+  // set. No-op if the hash set is already large enough to do this.
+  void Reserve(size_t num_elements) {
+    size_t num_buckets = num_elements / max_load_factor_;
+    // Deal with rounding errors. Add one for rounding.
+    while (static_cast<size_t>(num_buckets * max_load_factor_) <= num_elements + 1u) {
+      ++num_buckets;
+    }
+    if (RoundUpNumBuckets(num_buckets) > NumBuckets()) {
+      Resize(num_buckets);
+    }
+  }
+
+  // The number of groups that inserted elements were probed past. Used for measuring how good
+  // hash functions are.
+  size_t TotalProbeDistance() const {
+    size_t total = 0;
+    for (size_t i = 0; i < NumBuckets(); ++i) {
+      if (!IsFreeSlot(i)) {
+        const size_t target_group = i / kGroupWidth;
+        ProbeSequence seq(MixHash(hashfn_(ElementForIndex(i))), NumGroups());
+        while (seq.Group() != target_group) {
+          ++total;
+          seq.Next();
+        }
+      }
+    }
+    return total;
+  }
+
+  // Calculate the current load factor and return it.
+  double CalculateLoadFactor() const {
+    return static_cast<double>(Size()) / static_cast<double>(NumBuckets());
+  }
+
+  // Make sure that every element has the right control byte and is reachable from the start of
+  // its probe sequence. Returns the number of errors.
+  size_t Verify() NO_THREAD_SAFETY_ANALYSIS {
+    size_t errors = 0;
+    size_t num_full = 0;
+    for (size_t i = 0; i < num_buckets_; ++i) {
+      if (IsFreeSlot(i)) {
+        continue;
+      }
+      ++num_full;
+      const size_t mixed_hash = MixHash(hashfn_(data_[i]));
+      if (ctrl_[i] != HashBits(mixed_hash)) {
+        LOG(ERROR) << "Element " << i << " has control byte " << static_cast<int>(ctrl_[i])
+                   << " instead of " << static_cast<int>(HashBits(mixed_hash));
+        ++errors;
+      }
+      const size_t target_group = i / kGroupWidth;
+      for (ProbeSequence seq(mixed_hash, NumGroups()); seq.Group() != target_group; seq.Next()) {
+        if (MatchEmpty(LoadGroup(seq.Group() * kGroupWidth)) != 0u) {
+          LOG(ERROR) << "Element " << i << " is past an empty slot of group " << seq.Group();
+          ++errors;
+          break;
+        }
+      }
+    }
+    if (num_full != num_elements_) {
+      LOG(ERROR) << "Found " << num_full << " elements instead of " << num_elements_;
+      ++errors;
+    }
+    return errors;
+  }
+
+  double GetMinLoadFactor() const {
+    return min_load_factor_;
+  }
+
+  double GetMaxLoadFactor() const {
+    return max_load_factor_;
+  }
+
+  // Change the load factor of the hash set. If the current load factor is greater than the max
+  // specified, then we resize the hash table storage.
+  void SetLoadFactor(double min_load_factor, double max_load_factor) {
+    DCHECK_LT(min_load_factor, max_load_factor);
+    DCHECK_GT(min_load_factor, 0.0);
+    DCHECK_LT(max_load_factor, 1.0);
+    min_load_factor_ = min_load_factor;
+    max_load_factor_ = max_load_factor;
+    elements_until_expand_ = NumBuckets() * max_load_factor_;
+    // If the current load factor isn't in the range, then resize to the mean of the minimum and
+    // maximum load factor.
+    const double load_factor = CalculateLoadFactor();
+    if (load_factor > max_load_factor_) {
+      Resize(Size() / ((min_load_factor_ + max_load_factor_) * 0.5));
+    }
+  }
+
+  // The hash set expands when Size() plus the number of deleted slots reaches
+  // ElementsUntilExpand().
+  size_t ElementsUntilExpand() const {
+    return elements_until_expand_;
+  }
+
+  size_t NumBuckets() const {
+    return num_buckets_;
+  }
+
+  // The storage of the hash set, NumBuckets() elements. The free slots hold elements made empty
+  // by EmptyFn. It is valid until the hash set is resized or destroyed; inserting may resize, see
+  // ElementsUntilExpand().
+  const T* GetData() const {
+    return data_;
+  }
+
+ private:
+  // Control bytes. A full slot has the 7 hash bits of its element, values 0 to 0x7f.
+  static constexpr uint8_t kEmpty = 0x80;
+  static constexpr uint8_t kDeleted = 0xfe;
+
+  static constexpr uint64_t kLsbs = UINT64_C(0x0101010101010101);
+  static constexpr uint64_t kMsbs = UINT64_C(0x8080808080808080);
+
+  // Quadratic probing over the groups, visits every group once when the number of groups is a
+  // power of two.
+  class ProbeSequence {
+   public:
+    ProbeSequence(size_t mixed_hash, size_t num_groups)
+        : mask_(num_groups - 1u), group_((mixed_hash >> 7) & mask_), stride_(0u) {
+      DCHECK(IsPowerOfTwo(num_groups));
+    }
+
+    size_t Group() const {
+      return group_;
+    }
+
+    void Next() {
+      ++stride_;
+      group_ = (group_ + stride_) & mask_;
+      DCHECK_LE(stride_, mask_);  // Don't loop forever.
+    }
+
+   private:
+    const size_t mask_;
+    size_t group_;
+    size_t stride_;
+  };
+
+  // Spread the entropy of hashes that only vary in their high or low bits, e.g. pointers, over
+  // the hash bits and the group index.
+  static size_t MixHash(size_t hash) {
+    static constexpr size_t kMultiplier =
+        (sizeof(size_t) == 8u) ? static_cast<size_t>(UINT64_C(0x9e3779b97f4a7c15)) : 0x9e3779b9u;
+    const size_t mixed = hash * kMultiplier;
+    return mixed ^ (mixed >> (kBitsPerByte * sizeof(size_t) / 2u));
+  }
+
+  static uint8_t HashBits(size_t mixed_hash) {
+    return static_cast<uint8_t>(mixed_hash & 0x7fu);
+  }
+
+  // The control bytes of the kGroupWidth slots starting at group_begin, the control byte of
+  // group_begin in the low byte.
+  uint64_t LoadGroup(size_t group_begin) const {
+    DCHECK_ALIGNED(group_begin, kGroupWidth);
+    DCHECK_LT(group_begin, NumBuckets());
+    // All the ISAs ART runs on are little endian.
+    uint64_t group;
+    memcpy(&group, ctrl_ + group_begin, sizeof(group));
+    return group;
+  }
+
+  // Returns a mask with the high bit set in the bytes of the group that may hold hash_bits. There
+  // may be false positives next to a real match, which the caller filters out with Pred.
+  static uint64_t Match(uint64_t group, uint8_t hash_bits) {
+    const uint64_t x = group ^ (kLsbs * hash_bits);
+    return (x - kLsbs) & ~x & kMsbs;
+  }
+
+  // Returns a mask with the high bit set in the bytes of the group that are kEmpty.
+  static uint64_t MatchEmpty(uint64_t group) {
+    return (group & (~group << 6)) & kMsbs;
+  }
+
+  // Returns a mask with the high bit set in the bytes of the group that are kEmpty or kDeleted.
+  static uint64_t MatchFree(uint64_t group) {
+    return group & kMsbs;
+  }
+
+  // The slot within its group of the lowest match of a mask.
+  static size_t LowestMatch(uint64_t mask) {
+    DCHECK_NE(mask, 0u);
+    return CTZ(mask) / kBitsPerByte;
+  }
+
+  size_t NumGroups() const {
+    return num_buckets_ / kGroupWidth;
+  }
+
+  T& ElementForIndex(size_t index) {
+    DCHECK_LT(index, NumBuckets());
+    DCHECK(data_ != nullptr);
+    return data_[index];
+  }
+
+  const T& ElementForIndex(size_t index) const {
+    DCHECK_LT(index, NumBuckets());
+    DCHECK(data_ != nullptr);
+    return data_[index];
+  }
+
+  // Find the hash table slot for an element, or return NumBuckets() if not found.
+  // This value for not found is important so that iterator(this, FindIndex(...)) == end().
+  template <typename K>
+  size_t FindIndex(const K& element, size_t hash) const {
+    // Guard against failing to get an element for a non-existing index.
+    if (UNLIKELY(NumBuckets() == 0)) {
+      return 0;
+    }
+    DCHECK_EQ(hashfn_(element), hash);
+    const size_t mixed_hash = MixHash(hash);
+    const uint8_t hash_bits = HashBits(mixed_hash);
+    for (ProbeSequence seq(mixed_hash, NumGroups()); ; seq.Next()) {
+      const size_t group_begin = seq.Group() * kGroupWidth;
+      const uint64_t group = LoadGroup(group_begin);
+      for (uint64_t match = Match(group, hash_bits); match != 0u; match &= match - 1u) {
+        const size_t index = group_begin + LowestMatch(match);
+        if (pred_(ElementForIndex(index), element)) {
+          return index;
+        }
+      }
+      if (MatchEmpty(group) != 0u) {
+        return NumBuckets();
+      }
+    }
+  }
+
+  bool IsFreeSlot(size_t index) const {
+    DCHECK_LT(index, NumBuckets());
+    return (ctrl_[index] & kEmpty) != 0u;
+  }
+
+  size_t FirstFullSlot() const {
+    size_t index = 0;
+    while (index < num_buckets_ && IsFreeSlot(index)) {
+      ++index;
+    }
+    return index;
+  }
+
+  size_t NextFullSlot(size_t index) const {
+    DCHECK_LT(index, num_buckets_);
+    do {
+      ++index;
+    } while (index < num_buckets_ && IsFreeSlot(index));
+    return index;
+  }
+
+  // The slots are a power of two number of groups.
+  static size_t RoundUpNumBuckets(size_t num_buckets) {
+    return RoundUpToPowerOfTwo(std::max(num_buckets, static_cast<size_t>(kGroupWidth)));
+  }
+
+  // Allocate a number of buckets, all free.
+  void AllocateStorage(size_t num_buckets) {
+    DCHECK(num_buckets == 0u || IsPowerOfTwo(num_buckets / kGroupWidth));
+    num_buckets_ = num_buckets;
+    data_ = allocfn_.allocate(num_buckets_);
+    ctrl_ = CtrlAllocator(allocfn_).allocate(num_buckets_);
+    owns_data_ = true;
+    memset(ctrl_, kEmpty, num_buckets_);
+    for (size_t i = 0; i < num_buckets_; ++i) {
+      allocfn_.construct(allocfn_.address(data_[i]));
+      emptyfn_.MakeEmpty(data_[i]);
+    }
+  }
+
+  void DeallocateStorage() {
+    if (owns_data_) {
+      for (size_t i = 0; i < NumBuckets(); ++i) {
+        allocfn_.destroy(allocfn_.address(data_[i]));
+      }
+      if (data_ != nullptr) {
+        allocfn_.deallocate(data_, NumBuckets());
+        CtrlAllocator(allocfn_).deallocate(ctrl_, NumBuckets());
+      }
+      owns_data_ = false;
+    }
+    ctrl_ = nullptr;
+    data_ = nullptr;
+    num_buckets_ = 0;
+    num_deleted_ = 0;
+  }
+
+  // Expand the set based on the load factors.
+  void Expand() {
+    size_t min_index = static_cast<size_t>(Size() / min_load_factor_);
+    // Resize based on the minimum load factor. This also drops the deleted slots, which may be
+    // all that is needed if many elements were erased.
+    Resize(min_index);
+  }
+
+  // Expand / shrink the table to the new specified size, rounded up to a power of two number of
+  // groups.
+  void Resize(size_t new_size) {
+    if (new_size < kMinBuckets) {
+      new_size = kMinBuckets;
+    }
+    new_size = RoundUpNumBuckets(new_size);
+    DCHECK_GE(new_size, Size());
+    uint8_t* const old_ctrl = ctrl_;
+    T* const old_data = data_;
+    size_t old_num_buckets = num_buckets_;
+    // Reinsert all of the old elements.
+    const bool owned_data = owns_data_;
+    AllocateStorage(new_size);
+    num_deleted_ = 0;
+    for (size_t i = 0; i < old_num_buckets; ++i) {
+      T& element = old_data[i];
+      if ((old_ctrl[i] & kEmpty) == 0u) {
+        const size_t mixed_hash = MixHash(hashfn_(element));
+        const size_t index = FirstAvailableSlot(mixed_hash);
+        ctrl_[index] = HashBits(mixed_hash);
+        data_[index] = std::move(element);
+      }
+      if (owned_data) {
+        allocfn_.destroy(allocfn_.address(element));
+      }
+    }
+    if (owned_data) {
+      allocfn_.deallocate(old_data, old_num_buckets);
+      CtrlAllocator(allocfn_).deallocate(old_ctrl, old_num_buckets);
+    }
+
+    // When we hit elements_until_expand_, we are at the max load factor and must expand again.
+    elements_until_expand_ = NumBuckets() * max_load_factor_;
+  }
+
+  ALWAYS_INLINE size_t FirstAvailableSlot(size_t mixed_hash) const {
+    DCHECK_NE(NumBuckets(), 0u);
+    for (ProbeSequence seq(mixed_hash, NumGroups()); ; seq.Next()) {
+      const size_t group_begin = seq.Group() * kGroupWidth;
+      const uint64_t free = MatchFree(LoadGroup(group_begin));
+      if (free != 0u) {
+        return group_begin + LowestMatch(free);
+      }
+    }
+  }
+
+  // Return new offset.
+  template <typename Elem>
+  static size_t WriteToBytes(uint8_t* ptr, size_t offset, Elem n) {
+    DCHECK_ALIGNED(ptr + offset, sizeof(n));
+    if (ptr != nullptr) {
+      *reinterpret_cast<Elem*>(ptr + offset) = n;
+    }
+    return offset + sizeof(n);
+  }
+
+  template <typename Elem>
+  static size_t ReadFromBytes(const uint8_t* ptr, size_t offset, Elem* out) {
+    DCHECK(ptr != nullptr);
+    DCHECK_ALIGNED(ptr + offset, sizeof(*out));
+    *out = *reinterpret_cast<const Elem*>(ptr + offset);
+    return offset + sizeof(*out);
+  }
+
+  using CtrlAllocator = typename Alloc::template rebind<uint8_t>::other;
+
+  Alloc allocfn_;  // Allocator function.
+  HashFn hashfn_;  // Hashing function.
+  EmptyFn emptyfn_;  // SetEmpty function for the free slots.
+  Pred pred_;  // Equals function.
+  size_t num_elements_;  // Number of inserted elements.
+  size_t num_deleted_;  // Number of slots marked kDeleted.
+  size_t num_buckets_;  // Number of hash table buckets.
+  size_t elements_until_expand_;  // Maximum number of used slots until we expand the table.
+  bool owns_data_;  // If we own ctrl_ and data_ and are responsible for freeing them.
+  uint8_t* ctrl_;  // Control bytes, one per bucket.
+  T* data_;  // Backing storage.
+  double min_load_factor_;
+  double max_load_factor_;
+};
+
+template <class T, class EmptyFn, class HashFn, class Pred, class Alloc>
+void swap(FlatHashSet<T, EmptyFn, HashFn, Pred, Alloc>& lhs,
+          FlatHashSet<T, EmptyFn, HashFn, Pred, Alloc>& rhs) {
+  lhs.swap(rhs);
+}
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_BASE_FLAT_HASH_SET_H_
@@ -0,0 +1,371 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "flat_hash_set.h"
+
+#include <forward_list>
+#include <map>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace art {
+
+struct IsEmptyFnString {
+  void MakeEmpty(std::string& item) const {
+    item.clear();
+  }
+  bool IsEmpty(const std::string& item) const {
+    return item.empty();
+  }
+};
+
+class FlatHashSetTest : public testing::Test {
+ public:
+  FlatHashSetTest() : seed_(97421), unique_number_(0) {
+  }
+  std::string RandomString(size_t len) {
+    std::ostringstream oss;
+    for (size_t i = 0; i < len; ++i) {
+      oss << static_cast<char>('A' + PRand() % 64);
+    }
+    static_assert(' ' < 'A', "space must be less than a");
+    oss << " " << unique_number_++;  // Relies on ' ' < 'A'
+    return oss.str();
+  }
+  void SetSeed(size_t seed) {
+    seed_ = seed;
+  }
+  size_t PRand() {  // Pseudo random.
+    seed_ = seed_ * 1103515245 + 12345;
+    return seed_;
+  }
+
+ private:
+  size_t seed_;
+  size_t unique_number_;
+};
+
+TEST_F(FlatHashSetTest, TestSmoke) {
+  FlatHashSet<std::string, IsEmptyFnString> hash_set;
+  const std::string test_string = "hello world 1234";
+  ASSERT_TRUE(hash_set.Empty());
+  ASSERT_EQ(hash_set.Size(), 0U);
+  ASSERT_TRUE(hash_set.Find(test_string) == hash_set.end());
+  hash_set.Insert(test_string);
+  auto it = hash_set.Find(test_string);
+  ASSERT_EQ(*it, test_string);
+  auto after_it = hash_set.Erase(it);
+  ASSERT_TRUE(after_it == hash_set.end());
+  ASSERT_TRUE(hash_set.Empty());
+  ASSERT_EQ(hash_set.Size(), 0U);
+  it = hash_set.Find(test_string);
+  ASSERT_TRUE(it == hash_set.end());
+}
+
+TEST_F(FlatHashSetTest, TestInsertAndErase) {
+  FlatHashSet<std::string, IsEmptyFnString> hash_set;
+  static constexpr size_t count = 10000;
+  std::vector<std::string> strings;
+  for (size_t i = 0; i < count; ++i) {
+    // Insert a bunch of elements and make sure we can find them.
+    strings.push_back(RandomString(10));
+    hash_set.Insert(strings[i]);
+    auto it = hash_set.Find(strings[i]);
+    ASSERT_TRUE(it != hash_set.end());
+    ASSERT_EQ(*it, strings[i]);
+  }
+  ASSERT_EQ(strings.size(), hash_set.Size());
+  ASSERT_EQ(hash_set.Verify(), 0U);
+  // Try to erase the odd strings.
+  for (size_t i = 1; i < count; i += 2) {
+    auto it = hash_set.Find(strings[i]);
+    ASSERT_TRUE(it != hash_set.end());
+    ASSERT_EQ(*it, strings[i]);
+    hash_set.Erase(it);
+  }
+  ASSERT_EQ(hash_set.Verify(), 0U);
+  // Test removed.
+  for (size_t i = 1; i < count; i += 2) {
+    auto it = hash_set.Find(strings[i]);
+    ASSERT_TRUE(it == hash_set.end());
+  }
+  for (size_t i = 0; i < count; i += 2) {
+    auto it = hash_set.Find(strings[i]);
+    ASSERT_TRUE(it != hash_set.end());
+    ASSERT_EQ(*it, strings[i]);
+  }
+}
+
+TEST_F(FlatHashSetTest, TestIterator) {
+  FlatHashSet<std::string, IsEmptyFnString> hash_set;
+  ASSERT_TRUE(hash_set.begin() == hash_set.end());
+  static constexpr size_t count = 1000;
+  std::vector<std::string> strings;
+  for (size_t i = 0; i < count; ++i) {
+    // Insert a bunch of elements and make sure we can find them.
+    strings.push_back(RandomString(10));
+    hash_set.Insert(strings[i]);
+  }
+  // Make sure we visit each string exactly once.
+  std::map<std::string, size_t> found_count;
+  for (const std::string& s : hash_set) {
+    ++found_count[s];
+  }
+  for (size_t i = 0; i < count; ++i) {
+    ASSERT_EQ(found_count[strings[i]], 1U);
+  }
+  found_count.clear();
+  // Remove all the elements with iterator erase.
+  for (auto it = hash_set.begin(); it != hash_set.end();) {
+    ++found_count[*it];
+    it = hash_set.Erase(it);
+    ASSERT_EQ(hash_set.Verify(), 0U);
+  }
+  for (size_t i = 0; i < count; ++i) {
+    ASSERT_EQ(found_count[strings[i]], 1U);
+  }
+}
+
+TEST_F(FlatHashSetTest, TestSwapAndCopy) {
+  FlatHashSet<std::string, IsEmptyFnString> hash_seta, hash_setb;
+  std::vector<std::string> strings;
+  static constexpr size_t count = 1000;
+  for (size_t i = 0; i < count; ++i) {
+    strings.push_back(RandomString(10));
+    hash_seta.Insert(strings[i]);
+  }
+  std::swap(hash_seta, hash_setb);
+  ASSERT_TRUE(hash_seta.Empty());
+  ASSERT_EQ(hash_setb.Size(), count);
+  FlatHashSet<std::string, IsEmptyFnString> hash_setc(hash_setb);
+  hash_setb.Clear();
+  for (size_t i = 0; i < count; ++i) {
+    ASSERT_TRUE(hash_setc.Find(strings[i]) != hash_setc.end());
+  }
+  ASSERT_EQ(hash_setc.Verify(), 0U);
+}
+
+TEST_F(FlatHashSetTest, TestEraseReusesSlots) {
+  FlatHashSet<std::string, IsEmptyFnString> hash_set;
+  static constexpr size_t count = 500;
+  for (size_t round = 0; round < 100; ++round) {
+    std::vector<std::string> strings;
+    for (size_t i = 0; i < count; ++i) {
+      strings.push_back(RandomString(10));
+      hash_set.Insert(strings[i]);
+    }
+    for (const std::string& s : strings) {
+      hash_set.Erase(hash_set.Find(s));
+    }
+    ASSERT_TRUE(hash_set.Empty());
+    ASSERT_EQ(hash_set.Verify(), 0U);
+  }
+  // Rounds of inserting and erasing the same number of elements must not grow the table.
+  EXPECT_EQ(hash_set.NumBuckets(), static_cast<size_t>(FlatHashSet<std::string>::kMinBuckets));
+}
+
+TEST_F(FlatHashSetTest, TestLoadFactor) {
+  FlatHashSet<std::string, IsEmptyFnString> hash_set;
+  static constexpr size_t kStringCount = 10000;
+  for (size_t i = 0; i < kStringCount; ++i) {
+    hash_set.Insert(RandomString(i % 10 + 1));
+  }
+  // The number of buckets is rounded up to a power of two, which may halve the load factor.
+  EXPECT_GE(hash_set.CalculateLoadFactor(), hash_set.GetMinLoadFactor() * 0.5);
+  EXPECT_LE(hash_set.CalculateLoadFactor(), hash_set.GetMaxLoadFactor());
+  hash_set.SetLoadFactor(0.1, 0.3);
+  EXPECT_DOUBLE_EQ(0.1, hash_set.GetMinLoadFactor());
+  EXPECT_DOUBLE_EQ(0.3, hash_set.GetMaxLoadFactor());
+  EXPECT_LE(hash_set.CalculateLoadFactor(), hash_set.GetMaxLoadFactor());
+  EXPECT_EQ(hash_set.Verify(), 0U);
+}
+
+TEST_F(FlatHashSetTest, TestStress) {
+  FlatHashSet<std::string, IsEmptyFnString> hash_set;
+  std::unordered_multiset<std::string> std_set;
+  std::vector<std::string> strings;
+  static constexpr size_t string_count = 2000;
+  static constexpr size_t operations = 100000;
+  static constexpr size_t target_size = 5000;
+  for (size_t i = 0; i < string_count; ++i) {
+    strings.push_back(RandomString(i % 10 + 1));
+  }
+  const size_t seed = time(nullptr);
+  SetSeed(seed);
+  LOG(INFO) << "Starting stress test with seed " << seed;
+  for (size_t i = 0; i < operations; ++i) {
+    ASSERT_EQ(hash_set.Size(), std_set.size());
+    size_t delta = std::abs(static_cast<ssize_t>(target_size) -
+                            static_cast<ssize_t>(hash_set.Size()));
+    size_t n = PRand();
+    if (n % target_size == 0) {
+      hash_set.Clear();
+      std_set.clear();
+      ASSERT_TRUE(hash_set.Empty());
+      ASSERT_TRUE(std_set.empty());
+    } else  if (n % target_size < delta) {
+      // Skew towards adding elements until we are at the desired size.
+      const std::string& s = strings[PRand() % string_count];
+      hash_set.Insert(s);
+      std_set.insert(s);
+      ASSERT_EQ(*hash_set.Find(s), *std_set.find(s));
+    } else {
+      const std::string& s = strings[PRand() % string_count];
+      auto it1 = hash_set.Find(s);
+      auto it2 = std_set.find(s);
+      ASSERT_EQ(it1 == hash_set.end(), it2 == std_set.end());
+      if (it1 != hash_set.end()) {
+        ASSERT_EQ(*it1, *it2);
+        hash_set.Erase(it1);
+        std_set.erase(it2);
+      }
+    }
+  }
+  ASSERT_EQ(hash_set.Verify(), 0U);
+}
+
+TEST_F(FlatHashSetTest, TestPointerKeys) {
+  // Pointers have their low bits clear, the hash is mixed before it is split into the control
+  // byte and the group.
+  FlatHashSet<const uint64_t*> hash_set;
+  std::vector<uint64_t> storage(10000);
+  for (const uint64_t& value : storage) {
+    hash_set.Insert(&value);
+  }
+  ASSERT_EQ(hash_set.Verify(), 0U);
+  for (const uint64_t& value : storage) {
+    ASSERT_TRUE(hash_set.Find(&value) != hash_set.end());
+  }
+  uint64_t other;
+  ASSERT_TRUE(hash_set.Find(&other) == hash_set.end());
+}
+
+TEST_F(FlatHashSetTest, TestWriteToMemory) {
+  FlatHashSet<uint32_t> hash_set;
+  static constexpr uint32_t count = 5000;
+  for (uint32_t i = 1; i <= count; ++i) {
+    hash_set.Insert(i * 7u);
+  }
+  // Leave some deleted slots behind.
+  for (uint32_t i = 1; i <= count; i += 3) {
+    hash_set.Erase(hash_set.Find(i * 7u));
+  }
+  const size_t size = hash_set.WriteToMemory(nullptr);
+  std::unique_ptr<uint64_t[]> buffer(new uint64_t[RoundUp(size, 8u) / 8u]);
+  uint8_t* const ptr = reinterpret_cast<uint8_t*>(buffer.get());
+  ASSERT_EQ(hash_set.WriteToMemory(ptr), size);
+  for (bool make_copy : { true, false }) {
+    size_t read_count = 0;
+    FlatHashSet<uint32_t> read_set(ptr, make_copy, &read_count);
+    EXPECT_EQ(read_count, size);
+    EXPECT_EQ(read_set.OwnsData(), make_copy);
+    EXPECT_EQ(read_set.Size(), hash_set.Size());
+    EXPECT_EQ(read_set.Verify(), 0U);
+    for (uint32_t i = 1; i <= count; ++i) {
+      EXPECT_EQ(read_set.Find(i * 7u) != read_set.end(), (i - 1u) % 3u != 0u) << i;
+    }
+    if (make_copy) {
+      // The copy does not write through to the serialized set.
+      read_set.Insert(1u);
+      read_set.Reserve(2 * count);
+      EXPECT_TRUE(read_set.Find(1u) != read_set.end());
+      EXPECT_EQ(read_set.Verify(), 0U);
+    }
+  }
+}
+
+struct IsEmptyFnVectorInt {
+  void MakeEmpty(std::vector<int>& item) const {
+    item.clear();
+  }
+  bool IsEmpty(const std::vector<int>& item) const {
+    return item.empty();
+  }
+};
+
+template <typename T>
+size_t HashIntSequence(T begin, T end) {
+  size_t hash = 0;
+  for (auto iter = begin; iter != end; ++iter) {
+    hash = hash * 2 + *iter;
+  }
+  return hash;
+};
+
+struct VectorIntHashEquals {
+  std::size_t operator()(const std::vector<int>& item) const {
+    return HashIntSequence(item.begin(), item.end());
+  }
+
+  std::size_t operator()(const std::forward_list<int>& item) const {
+    return HashIntSequence(item.begin(), item.end());
+  }
+
+  bool operator()(const std::vector<int>& a, const std::vector<int>& b) const {
+    return a == b;
+  }
+
+  bool operator()(const std::vector<int>& a, const std::forward_list<int>& b) const {
+    auto aiter = a.begin();
+    auto biter = b.begin();
+    while (aiter != a.end() && biter != b.end()) {
+      if (*aiter != *biter) {
+        return false;
+      }
+      aiter++;
+      biter++;
+    }
+    return (aiter == a.end() && biter == b.end());
+  }
+};
+
+TEST_F(FlatHashSetTest, TestLookupByAlternateKeyType) {
+  FlatHashSet<std::vector<int>, IsEmptyFnVectorInt, VectorIntHashEquals, VectorIntHashEquals>
+      hash_set;
+  hash_set.Insert(std::vector<int>({1, 2, 3, 4}));
+  hash_set.Insert(std::vector<int>({4, 2}));
+  ASSERT_EQ(hash_set.end(), hash_set.Find(std::vector<int>({1, 1, 1, 1})));
+  ASSERT_NE(hash_set.end(), hash_set.Find(std::vector<int>({1, 2, 3, 4})));
+  ASSERT_EQ(hash_set.end(), hash_set.Find(std::forward_list<int>({1, 1, 1, 1})));
+  ASSERT_NE(hash_set.end(), hash_set.Find(std::forward_list<int>({1, 2, 3, 4})));
+}
+
+TEST_F(FlatHashSetTest, TestReserve) {
+  FlatHashSet<std::string, IsEmptyFnString> hash_set;
+  std::vector<size_t> sizes = {1, 10, 25, 55, 128, 1024, 4096};
+  for (size_t size : sizes) {
+    hash_set.Reserve(size);
+    const size_t buckets_before = hash_set.NumBuckets();
+    // Check that we expanded enough.
+    CHECK_GE(hash_set.ElementsUntilExpand(), size);
+    // Try inserting elements until we are at our reserve size and ensure the hash set did not
+    // expand.
+    while (hash_set.Size() < size) {
+      hash_set.Insert(std::to_string(hash_set.Size()));
+    }
+    CHECK_EQ(hash_set.NumBuckets(), buckets_before);
+  }
+  // Check the behaviour for shrinking, it does not necessarily resize down.
+  constexpr size_t size = 100;
+  hash_set.Reserve(size);
+  CHECK_GE(hash_set.ElementsUntilExpand(), size);
+}
+
+}  // namespace art
@@ -517,6 +517,12 @@ class HashSet {
     return num_buckets_;
   }
 
+  // The storage of the hash set, NumBuckets() elements. It is valid until the hash set is
+  // resized or destroyed; inserting may resize, see ElementsUntilExpand().
+  const T* GetData() const {
+    return data_;
+  }
+
  private:
   T& ElementForIndex(size_t index) {
     DCHECK_LT(index, NumBuckets());
@@ -17,8 +17,13 @@
 #include "mutex.h"
 
 #include <errno.h>
+#include <string.h>
 #include <sys/time.h>
 
+#include <algorithm>
+#include <limits>
+#include <vector>
+
 #include "android-base/stringprintf.h"
 
 #include "atomic.h"
@@ -139,14 +144,81 @@ class Locks::ScopedExpectedMutexesOnWeakRefAccessLock FINAL {
   const BaseMutex* const mutex_;
 };
 
+// The contention statistics of BaseMutex::SetContentionStatsEnabled(). A mutex claims a slot the
+// first time it is contended and keeps it. Slots are never reused, so the statistics of destroyed
+// mutexes are still dumped. Slot 0 is shared by the locks of all monitors.
+static constexpr size_t kMutexContentionStatsSize = 512;
+static constexpr size_t kMutexContentionStatsOwners = 4;
+static constexpr size_t kMutexContentionStatsNameSize = 48;
+struct MutexContentionStats {
+  // Set once `name` and `level` are written.
+  Atomic<bool> ready;
+  Atomic<bool> destroyed;
+  char name[kMutexContentionStatsNameSize];
+  LockLevel level;
+  Atomic<uint64_t> count;
+  Atomic<uint64_t> wait_time;
+  Atomic<uint64_t> max_wait_time;
+  // The threads that held the mutex, replacing the least frequent one when a new one shows up.
+  struct {
+    Atomic<uint64_t> tid;
+    Atomic<uint32_t> count;
+  } owners[kMutexContentionStatsOwners];
+};
+static Atomic<bool> gMutexContentionStatsEnabled(false);
+// Allocated when the statistics are first enabled and never freed, a recorder may still be using
+// it after they are turned off.
+static Atomic<MutexContentionStats*> gMutexContentionStats(nullptr);
+// Number of slots claimed after the shared slot 0, may exceed the size of the table.
+static Atomic<size_t> gMutexContentionStatsClaimed(0);
+
+static void InitContentionStats(MutexContentionStats* stats, const char* name, LockLevel level) {
+  strncpy(stats->name, name, kMutexContentionStatsNameSize - 1u);
+  stats->level = level;
+  stats->ready.StoreRelease(true);
+}
+
+static void RecordContentionStats(MutexContentionStats* stats,
+                                  uint64_t owner_tid,
+                                  uint64_t wait_time) {
+  // This code is intentionally racy as it is only used for diagnostics.
+  stats->count.FetchAndAddRelaxed(1u);
+  stats->wait_time.FetchAndAddRelaxed(wait_time);
+  uint64_t max_wait_time = stats->max_wait_time.LoadRelaxed();
+  while (wait_time > max_wait_time &&
+         !stats->max_wait_time.CompareExchangeWeakRelaxed(max_wait_time, wait_time)) {
+    max_wait_time = stats->max_wait_time.LoadRelaxed();
+  }
+  if (owner_tid == 0u || owner_tid == static_cast<uint64_t>(-1)) {
+    // The owner is not known, or the mutex is held shared.
+    return;
+  }
+  size_t min_index = 0u;
+  uint32_t min_count = std::numeric_limits<uint32_t>::max();
+  for (size_t i = 0; i != kMutexContentionStatsOwners; ++i) {
+    if (stats->owners[i].tid.LoadRelaxed() == owner_tid) {
+      stats->owners[i].count.FetchAndAddRelaxed(1u);
+      return;
+    }
+    uint32_t count = stats->owners[i].count.LoadRelaxed();
+    if (count < min_count) {
+      min_index = i;
+      min_count = count;
+    }
+  }
+  stats->owners[min_index].tid.StoreRelaxed(owner_tid);
+  stats->owners[min_index].count.StoreRelaxed(min_count + 1u);
+}
+
 // Scoped class that generates events at the beginning and end of lock contention.
 class ScopedContentionRecorder FINAL : public ValueObject {
  public:
   ScopedContentionRecorder(BaseMutex* mutex, uint64_t blocked_tid, uint64_t owner_tid)
-      : mutex_(kLogLockContentions ? mutex : nullptr),
+      : mutex_(mutex),
         blocked_tid_(kLogLockContentions ? blocked_tid : 0),
-        owner_tid_(kLogLockContentions ? owner_tid : 0),
-        start_nano_time_(kLogLockContentions ? NanoTime() : 0) {
+        owner_tid_(owner_tid),
+        stats_(BaseMutex::IsContentionStatsEnabled() ? mutex->GetContentionStats() : nullptr),
+        start_nano_time_((kLogLockContentions || stats_ != nullptr) ? NanoTime() : 0) {
     if (ATRACE_ENABLED()) {
       std::string msg = StringPrintf("Lock contention on %s (owner tid: %" PRIu64 ")",
                                      mutex->GetName(), owner_tid);
@@ -160,19 +232,24 @@ class ScopedContentionRecorder FINAL : public ValueObject {
       uint64_t end_nano_time = NanoTime();
       mutex_->RecordContention(blocked_tid_, owner_tid_, end_nano_time - start_nano_time_);
     }
+    if (stats_ != nullptr) {
+      RecordContentionStats(stats_, owner_tid_, NanoTime() - start_nano_time_);
+    }
   }
 
  private:
   BaseMutex* const mutex_;
   const uint64_t blocked_tid_;
   const uint64_t owner_tid_;
+  MutexContentionStats* const stats_;
   const uint64_t start_nano_time_;
 };
 
 BaseMutex::BaseMutex(const char* name, LockLevel level)
     : level_(level),
       name_(name),
-      should_respond_to_empty_checkpoint_request_(false) {
+      should_respond_to_empty_checkpoint_request_(false),
+      contention_stats_(nullptr) {
   if (kLogLockContentions) {
     ScopedAllMutexesLock mu(this);
     std::set<BaseMutex*>** all_mutexes_ptr = &gAllMutexData->all_mutexes;
@@ -186,6 +263,10 @@ BaseMutex::BaseMutex(const char* name, LockLevel level)
 }
 
 BaseMutex::~BaseMutex() {
+  MutexContentionStats* stats = contention_stats_.LoadRelaxed();
+  if (stats != nullptr && level_ != kMonitorLock) {
+    stats->destroyed.StoreRelaxed(true);
+  }
   if (kLogLockContentions) {
     ScopedAllMutexesLock mu(this);
     gAllMutexData->all_mutexes->erase(this);
@@ -221,6 +302,88 @@ void BaseMutex::DumpAll(std::ostream& os) {
   }
 }
 
+void BaseMutex::SetContentionStatsEnabled(bool enabled) {
+  if (enabled && gMutexContentionStats.LoadAcquire() == nullptr) {
+    MutexContentionStats* table = new MutexContentionStats[kMutexContentionStatsSize]();
+    InitContentionStats(&table[0], "monitor locks", kMonitorLock);
+    // Both the runtime option and the lock contention profiler may enable the statistics.
+    if (!gMutexContentionStats.CompareExchangeStrongRelease(nullptr, table)) {
+      delete[] table;
+    }
+  }
+  // Publishes the table to the contenders that see the statistics enabled.
+  gMutexContentionStatsEnabled.StoreRelease(enabled);
+}
+
+bool BaseMutex::IsContentionStatsEnabled() {
+  return gMutexContentionStatsEnabled.LoadAcquire();
+}
+
+MutexContentionStats* BaseMutex::GetContentionStats() {
+  MutexContentionStats* stats = contention_stats_.LoadRelaxed();
+  if (stats != nullptr) {
+    return stats;
+  }
+  MutexContentionStats* table = gMutexContentionStats.LoadRelaxed();
+  if (level_ == kMonitorLock) {
+    stats = &table[0];
+  } else {
+    const size_t index = gMutexContentionStatsClaimed.FetchAndAddRelaxed(1u) + 1u;
+    if (index >= kMutexContentionStatsSize) {
+      return nullptr;
+    }
+    stats = &table[index];
+    InitContentionStats(stats, name_, level_);
+  }
+  // If another contender claimed a slot first, ours stays empty and is not dumped.
+  if (!contention_stats_.CompareExchangeStrongRelaxed(nullptr, stats)) {
+    stats = contention_stats_.LoadRelaxed();
+  }
+  return stats;
+}
+
+void BaseMutex::DumpContentionStats(std::ostream& os) {
+  const MutexContentionStats* table = gMutexContentionStats.LoadAcquire();
+  if (table == nullptr) {
+    return;
+  }
+  std::vector<const MutexContentionStats*> entries;
+  for (size_t i = 0; i != kMutexContentionStatsSize; ++i) {
+    if (table[i].ready.LoadAcquire() && table[i].count.LoadRelaxed() != 0u) {
+      entries.push_back(&table[i]);
+    }
+  }
+  std::sort(entries.begin(),
+            entries.end(),
+            [](const MutexContentionStats* lhs, const MutexContentionStats* rhs) {
+              return lhs->wait_time.LoadRelaxed() > rhs->wait_time.LoadRelaxed();
+            });
+  os << "Mutex contention statistics (" << entries.size() << " mutexes";
+  if (gMutexContentionStatsClaimed.LoadRelaxed() >= kMutexContentionStatsSize - 1u) {
+    os << ", table full";
+  }
+  os << "):\n";
+  for (const MutexContentionStats* entry : entries) {
+    uint64_t count = entry->count.LoadRelaxed();
+    uint64_t wait_time = entry->wait_time.LoadRelaxed();
+    os << "  \"" << entry->name << "\" (" << entry->level << ")"
+       << (entry->destroyed.LoadRelaxed() ? " destroyed" : "")
+       << " contended " << count << " times, total wait " << PrettyDuration(wait_time)
+       << ", average " << PrettyDuration(wait_time / count)
+       << ", max " << PrettyDuration(entry->max_wait_time.LoadRelaxed());
+    bool first = true;
+    for (const auto& owner : entry->owners) {
+      uint32_t owner_count = owner.count.LoadRelaxed();
+      if (owner_count != 0u) {
+        os << (first ? ", held by tid " : ", ") << owner.tid.LoadRelaxed() << " (" << owner_count
+           << ")";
+        first = false;
+      }
+    }
+    os << "\n";
+  }
+}
+
 void BaseMutex::CheckSafeToWait(Thread* self) {
   if (self == nullptr) {
     CheckUnattachedThread(level_);
@@ -741,7 +904,7 @@ bool ReaderWriterMutex::ExclusiveLockWithTimeout(Thread* self, int64_t ms, int32
 #if ART_USE_FUTEXES
 void ReaderWriterMutex::HandleSharedLockContention(Thread* self, int32_t cur_state) {
   // Owner holds it exclusively, hang up.
-  ScopedContentionRecorder scr(this, GetExclusiveOwnerTid(), SafeGetTid(self));
+  ScopedContentionRecorder scr(this, SafeGetTid(self), GetExclusiveOwnerTid());
   ++num_pending_readers_;
   if (UNLIKELY(should_respond_to_empty_checkpoint_request_)) {
     self->CheckEmptyCheckpointFromMutex();
@@ -60,11 +60,13 @@ enum LockLevel {
   kThreadSuspendCountLock,
   kAbortLock,
   kJdwpAdbStateLock,
+  kJdwpPendingEventsLock,
   kJdwpSocketLock,
   kRegionSpaceRegionLock,
   kMarkSweepMarkStackLock,
   kRosAllocGlobalLock,
   kRosAllocBracketLock,
+  kRosAllocPerCpuLock,
   kRosAllocBulkFreeLock,
   kTaggingLockLevel,
   kTransactionLogLock,
@@ -77,10 +79,14 @@ enum LockLevel {
   kReferenceQueueWeakReferencesLock,
   kReferenceQueueClearedReferencesLock,
   kReferenceProcessorLock,
+  kJitDebugInfoPackerLock,
   kJitDebugInterfaceLock,
   kAllocSpaceLock,
   kBumpPointerSpaceBlockLock,
+  kArenaCacheLock,
   kArenaPoolLock,
+  kIrtChunkPoolLock,
+  kInternTableStripeLock,
   kInternTableLock,
   kOatFileSecondaryLookupLock,
   kHostDlOpenHandlesLock,
@@ -139,6 +145,8 @@ const size_t kContentionLogSize = 4;
 const size_t kContentionLogDataSize = kLogLockContentions ? 1 : 0;
 const size_t kAllMutexDataSize = kLogLockContentions ? 1 : 0;
 
+struct MutexContentionStats;
+
 // Base class for all Mutex implementations
 class BaseMutex {
  public:
@@ -154,6 +162,16 @@ class BaseMutex {
 
   static void DumpAll(std::ostream& os);
 
+  // Per mutex contention statistics: number of contended waits, total and max wait time, and
+  // the threads that most often held the mutex. They are only gathered on the contended path,
+  // the uncontended fast path is unchanged, and can be turned on at runtime, unlike
+  // kLogLockContentions. A mutex gets a slot of a fixed-size table the first time it is
+  // contended, mutexes of monitors share one slot. -XX:LockContentionStats and the lock
+  // contention profiler turn them on, they are dumped on SIGQUIT.
+  static void SetContentionStatsEnabled(bool enabled);
+  static bool IsContentionStatsEnabled();
+  static void DumpContentionStats(std::ostream& os);
+
   bool ShouldRespondToEmptyCheckpointRequest() const {
     return should_respond_to_empty_checkpoint_request_;
   }
@@ -178,9 +196,15 @@ class BaseMutex {
   void RecordContention(uint64_t blocked_tid, uint64_t owner_tid, uint64_t nano_time_blocked);
   void DumpContention(std::ostream& os) const;
 
+  // Return the contention statistics slot of this mutex, assigning one if needed. Returns null
+  // if the table is full.
+  MutexContentionStats* GetContentionStats();
+
   const LockLevel level_;  // Support for lock hierarchy.
   const char* const name_;
   bool should_respond_to_empty_checkpoint_request_;
+  // Slot of SetContentionStatsEnabled(), null until the mutex is first contended.
+  Atomic<MutexContentionStats*> contention_stats_;
 
   // A log entry that records contention but makes no guarantee that either tid will be held live.
   struct ContentionLogEntry {
@@ -16,8 +16,14 @@
 
 #include "mutex-inl.h"
 
+#include <sched.h>
+#include <unistd.h>
+
+#include <sstream>
+
 #include "common_runtime_test.h"
 #include "thread-current-inl.h"
+#include "utils.h"
 
 namespace art {
 
@@ -171,4 +177,57 @@ TEST_F(MutexTest, SharedTryLockUnlock) {
   SharedTryLockUnlockTest();
 }
 
+struct ContentionStatsState {
+  ContentionStatsState() : mu("contention stats test mutex"), started(false) {
+  }
+
+  Mutex mu;
+  Atomic<bool> started;
+};
+
+static void* ContentionStatsCallback(void* arg) {
+  ContentionStatsState* state = reinterpret_cast<ContentionStatsState*>(arg);
+  state->started.StoreSequentiallyConsistent(true);
+  state->mu.Lock(Thread::Current());
+  state->mu.Unlock(Thread::Current());
+  return nullptr;
+}
+
+// GCC has trouble with our mutex tests, so we have to turn off thread safety analysis.
+static void ContentionStatsTest() NO_THREAD_SAFETY_ANALYSIS {
+  BaseMutex::SetContentionStatsEnabled(true);
+  ContentionStatsState state;
+  state.mu.Lock(Thread::Current());
+
+  pthread_t pthread;
+  int pthread_create_result = pthread_create(&pthread, nullptr, ContentionStatsCallback, &state);
+  ASSERT_EQ(0, pthread_create_result);
+  while (!state.started.LoadSequentiallyConsistent()) {
+    sched_yield();
+  }
+  // Give the other thread time to block on the mutex.
+  usleep(100 * 1000);
+
+  state.mu.Unlock(Thread::Current());
+  EXPECT_EQ(pthread_join(pthread, nullptr), 0);
+  BaseMutex::SetContentionStatsEnabled(false);
+
+  std::ostringstream oss;
+  BaseMutex::DumpContentionStats(oss);
+  const std::string dump = oss.str();
+  if (!ART_USE_FUTEXES) {
+    return;  // Contention is only recorded with futexes.
+  }
+  size_t begin = dump.find("\"contention stats test mutex\"");
+  ASSERT_NE(begin, std::string::npos) << dump;
+  const std::string line = dump.substr(begin, dump.find('\n', begin) - begin);
+  EXPECT_NE(line.find(" contended 1 times"), std::string::npos) << line;
+  EXPECT_NE(line.find("held by tid " + std::to_string(GetTid()) + " (1)"), std::string::npos)
+      << line;
+}
+
+TEST_F(MutexTest, ContentionStats) {
+  ContentionStatsTest();
+}
+
 }  // namespace art
@@ -22,6 +22,18 @@
 #include <string>
 #include <utils/Trace.h>
 
+#include "base/macros.h"
+
+// Sets the counter track `name` to `value`. ATRACE_ENABLED() only reads the enabled tags that
+// atrace caches and refreshes when tracing starts, and `value` is not evaluated unless tracing,
+// so counters are cheap enough for hot paths and may compute their value under a lock.
+#define ART_TRACE_COUNTER(name, value)                      \
+  do {                                                      \
+    if (UNLIKELY(ATRACE_ENABLED())) {                       \
+      ATRACE_INT64(name, static_cast<int64_t>(value));      \
+    }                                                       \
+  } while (false)
+
 namespace art {
 
 class ScopedTrace {
@@ -16,6 +16,8 @@
 
 
 #include <stdio.h>
+#include <string.h>
+#include <unistd.h>
 
 #include "timing_logger.h"
 
@@ -27,9 +29,11 @@
 #include "gc/heap.h"
 #include "runtime.h"
 #include "thread-current-inl.h"
+#include "utils.h"
 
 #include <cmath>
 #include <iomanip>
+#include <sstream>
 
 namespace art {
 
@@ -37,6 +41,32 @@ constexpr size_t CumulativeLogger::kLowMemoryBucketCount;
 constexpr size_t CumulativeLogger::kDefaultBucketCount;
 constexpr size_t TimingLogger::kIndexNotFound;
 
+// Writes `str` as a quoted JSON string.
+static void WriteJsonString(std::ostream& os, const std::string& str) {
+  os << '"';
+  for (char c : str) {
+    switch (c) {
+      case '"': os << "\\\""; break;
+      case '\\': os << "\\\\"; break;
+      case '\n': os << "\\n"; break;
+      case '\t': os << "\\t"; break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          os << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+             << static_cast<int>(c) << std::dec << std::setfill(' ');
+        } else {
+          os << c;
+        }
+    }
+  }
+  os << '"';
+}
+
+// Writes nanoseconds as the fractional microseconds used by the trace-event format.
+static void WriteMicros(std::ostream& os, uint64_t ns) {
+  os << ns / 1000 << '.' << std::setw(3) << std::setfill('0') << ns % 1000 << std::setfill(' ');
+}
+
 CumulativeLogger::CumulativeLogger(const std::string& name)
     : name_(name),
       lock_name_("CumulativeLoggerLock" + name),
@@ -85,11 +115,44 @@ size_t CumulativeLogger::GetIterations() const {
   return iterations_;
 }
 
+void CumulativeLogger::GetTotalTimes(
+    std::vector<std::pair<std::string, uint64_t>>* totals) const {
+  MutexLock mu(Thread::Current(), lock_);
+  for (Histogram<uint64_t>* histogram : histograms_) {
+    totals->emplace_back(histogram->Name(), histogram->AdjustedSum());
+  }
+}
+
 void CumulativeLogger::Dump(std::ostream &os) const {
   MutexLock mu(Thread::Current(), lock_);
   DumpHistogram(os);
 }
 
+void CumulativeLogger::DumpJson(std::ostream& os) const {
+  MutexLock mu(Thread::Current(), lock_);
+  os << "{\"name\":";
+  WriteJsonString(os, name_);
+  os << ",\"iterations\":" << iterations_
+     << ",\"totalNs\":" << total_time_ * kAdjust
+     << ",\"timings\":[";
+  bool first = true;
+  for (Histogram<uint64_t>* histogram : histograms_) {
+    if (!first) {
+      os << ',';
+    }
+    first = false;
+    os << "{\"name\":";
+    WriteJsonString(os, histogram->Name());
+    os << ",\"count\":" << histogram->SampleSize()
+       << ",\"sumNs\":" << histogram->AdjustedSum()
+       << ",\"minNs\":" << histogram->Min() * kAdjust
+       << ",\"maxNs\":" << histogram->Max() * kAdjust
+       << ",\"meanNs\":" << static_cast<uint64_t>(histogram->Mean() * kAdjust)
+       << '}';
+  }
+  os << "]}";
+}
+
 void CumulativeLogger::AddPair(const std::string& label, uint64_t delta_time) {
   // Convert delta time to microseconds so that we don't overflow our counters.
   delta_time /= kAdjust;
@@ -130,11 +193,13 @@ void CumulativeLogger::DumpHistogram(std::ostream &os) const {
 }
 
 TimingLogger::TimingLogger(const char* name, bool precise, bool verbose)
-    : name_(name), precise_(precise), verbose_(verbose) {
+    : name_(name), tid_(art::GetTid()), precise_(precise), verbose_(verbose) {
 }
 
 void TimingLogger::Reset() {
+  tid_ = art::GetTid();
   timings_.clear();
+  utilizations_.clear();
 }
 
 void TimingLogger::StartTiming(const char* label) {
@@ -165,6 +230,26 @@ size_t TimingLogger::FindTimingIndex(const char* name, size_t start_idx) const {
   return kIndexNotFound;
 }
 
+void TimingLogger::AddUtilization(const char* label,
+                                  uint64_t busy_ns,
+                                  uint64_t wall_ns,
+                                  size_t num_threads) {
+  DCHECK(label != nullptr);
+  for (Utilization& utilization : utilizations_) {
+    if (strcmp(utilization.label, label) == 0) {
+      utilization.busy_ns += busy_ns;
+      // Weigh the thread counts of the records by their wall time.
+      uint64_t thread_ns = utilization.wall_ns * utilization.num_threads + wall_ns * num_threads;
+      utilization.wall_ns += wall_ns;
+      utilization.num_threads = (utilization.wall_ns != 0u)
+          ? static_cast<size_t>(thread_ns / utilization.wall_ns)
+          : std::max(utilization.num_threads, num_threads);
+      return;
+    }
+  }
+  utilizations_.push_back(Utilization { label, busy_ns, wall_ns, num_threads });
+}
+
 TimingLogger::TimingData TimingLogger::CalculateTimingData() const {
   TimingLogger::TimingData ret;
   ret.data_.resize(timings_.size());
@@ -194,6 +279,31 @@ TimingLogger::TimingData TimingLogger::CalculateTimingData() const {
   return ret;  // No need to fear, C++11 move semantics are here.
 }
 
+void TimingLogger::DumpTraceEvents(std::ostream& os) const {
+  TimingLogger::TimingData timing_data(CalculateTimingData());
+  const pid_t pid = getpid();
+  bool first = true;
+  for (size_t i = 0; i < timings_.size(); ++i) {
+    if (!timings_[i].IsStartTiming()) {
+      continue;
+    }
+    if (!first) {
+      os << ',';
+    }
+    first = false;
+    // Nesting is implied by the spans of the events, which is how the trace viewers expect it.
+    os << "{\"name\":";
+    WriteJsonString(os, timings_[i].GetName());
+    os << ",\"cat\":";
+    WriteJsonString(os, name_);
+    os << ",\"ph\":\"X\",\"ts\":";
+    WriteMicros(os, timings_[i].GetTime());
+    os << ",\"dur\":";
+    WriteMicros(os, timing_data.GetTotalTime(i));
+    os << ",\"pid\":" << pid << ",\"tid\":" << tid_ << '}';
+  }
+}
+
 void TimingLogger::Dump(std::ostream &os, const char* indent_string) const {
   static constexpr size_t kFractionalDigits = 3;
   TimingLogger::TimingData timing_data(CalculateTimingData());
@@ -231,6 +341,14 @@ void TimingLogger::Dump(std::ostream &os, const char* indent_string) const {
       --tab_count;
     }
   }
+  for (const Utilization& utilization : utilizations_) {
+    uint64_t thread_ns = utilization.wall_ns * utilization.num_threads;
+    os << indent_string << utilization.label << ": "
+       << ((thread_ns != 0u) ? utilization.busy_ns * 100u / thread_ns : 0u) << "% of "
+       << utilization.num_threads << " threads busy ("
+       << PrettyDuration(utilization.busy_ns) << " CPU in "
+       << PrettyDuration(utilization.wall_ns) << ")\n";
+  }
   os << name_ << ": end, " << PrettyDuration(GetTotalNs()) << "\n";
 }
 
@@ -251,4 +369,30 @@ TimingLogger::~TimingLogger() {
   }
 }
 
+void TimingJsonWriter::AddTimingLogger(const TimingLogger& logger) {
+  std::ostringstream oss;
+  logger.DumpTraceEvents(oss);
+  if (!oss.str().empty()) {
+    trace_events_.push_back(oss.str());
+  }
+}
+
+void TimingJsonWriter::AddCumulativeLogger(const CumulativeLogger& logger) {
+  std::ostringstream oss;
+  logger.DumpJson(oss);
+  cumulative_timings_.push_back(oss.str());
+}
+
+void TimingJsonWriter::Write(std::ostream& os) const {
+  os << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  for (size_t i = 0; i < trace_events_.size(); ++i) {
+    os << (i != 0 ? "," : "") << trace_events_[i];
+  }
+  os << "],\"cumulativeTimings\":[";
+  for (size_t i = 0; i < cumulative_timings_.size(); ++i) {
+    os << (i != 0 ? "," : "") << cumulative_timings_[i];
+  }
+  os << "]}\n";
+}
+
 }  // namespace art
@@ -21,6 +21,8 @@
 #include "base/macros.h"
 #include "base/mutex.h"
 
+#include <sys/types.h>
+
 #include <set>
 #include <string>
 #include <vector>
@@ -44,6 +46,10 @@ class CumulativeLogger {
   void SetName(const std::string& name) REQUIRES(!lock_);
   void AddLogger(const TimingLogger& logger) REQUIRES(!lock_);
   size_t GetIterations() const REQUIRES(!lock_);
+  // Appends the total time in nanoseconds spent in each timing label.
+  void GetTotalTimes(std::vector<std::pair<std::string, uint64_t>>* totals) const REQUIRES(!lock_);
+  // Writes the name, iteration count and per-label statistics as a JSON object.
+  void DumpJson(std::ostream& os) const REQUIRES(!lock_);
 
  private:
   class HistogramComparator {
@@ -150,7 +156,13 @@ class TimingLogger {
   uint64_t GetTotalNs() const;
   // Find the index of a timing by name.
   size_t FindTimingIndex(const char* name, size_t start_idx) const;
+  // Records that `num_threads` threads spent `busy_ns` of CPU time on `label` during `wall_ns`.
+  // Records with the same label accumulate. Dumped after the timings.
+  void AddUtilization(const char* label, uint64_t busy_ns, uint64_t wall_ns, size_t num_threads);
   void Dump(std::ostream& os, const char* indent_string = "  ") const;
+  // Writes each split as a Chrome trace-event "complete" event, separated by commas and tagged
+  // with the logger name and the thread that recorded the timings.
+  void DumpTraceEvents(std::ostream& os) const;
 
   // Scoped timing splits that can be nested and composed with the explicit split
   // starts and ends.
@@ -179,9 +191,19 @@ class TimingLogger {
 
   TimingData CalculateTimingData() const;
 
+  const char* GetName() const {
+    return name_;
+  }
+
+  pid_t GetTid() const {
+    return tid_;
+  }
+
  protected:
   // The name of the timing logger.
   const char* const name_;
+  // The thread that created or last reset the logger, used to attribute exported splits.
+  pid_t tid_;
   // Do we want to print the exactly recorded split (true) or round down to the time unit being
   // used (false).
   const bool precise_;
@@ -191,10 +213,36 @@ class TimingLogger {
   // of end split associated with i. If it is and end split ret[i] = i.
   std::vector<Timing> timings_;
 
+  struct Utilization {
+    const char* label;
+    uint64_t busy_ns;
+    uint64_t wall_ns;
+    size_t num_threads;
+  };
+  std::vector<Utilization> utilizations_;
+
  private:
   DISALLOW_COPY_AND_ASSIGN(TimingLogger);
 };
 
+// Collects timing loggers into a single JSON document that can be aggregated by tools or loaded
+// into chrome://tracing. Splits of TimingLoggers become "traceEvents" and CumulativeLoggers are
+// listed with their per-label statistics under "cumulativeTimings".
+class TimingJsonWriter {
+ public:
+  TimingJsonWriter() {}
+
+  void AddTimingLogger(const TimingLogger& logger);
+  void AddCumulativeLogger(const CumulativeLogger& logger);
+  void Write(std::ostream& os) const;
+
+ private:
+  std::vector<std::string> trace_events_;
+  std::vector<std::string> cumulative_timings_;
+
+  DISALLOW_COPY_AND_ASSIGN(TimingJsonWriter);
+};
+
 }  // namespace art
 
 #endif  // ART_RUNTIME_BASE_TIMING_LOGGER_H_
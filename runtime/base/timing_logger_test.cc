@@ -16,6 +16,8 @@
 
 #include "timing_logger.h"
 
+#include <sstream>
+
 #include "common_runtime_test.h"
 
 namespace art {
@@ -158,4 +160,70 @@ TEST_F(TimingLoggerTest, ScopedAndExplicit) {
   EXPECT_LE(timings[idx_innerinnersplit1].GetTime(), timings[idx_innerinnersplit2].GetTime());
 }
 
+TEST_F(TimingLoggerTest, CumulativeTotalTimes) {
+  const char* split1 = "Split 1";
+  const char* split2 = "Split 2";
+  CumulativeLogger cumulative("Cumulative");
+  for (size_t i = 0; i < 2; ++i) {
+    TimingLogger logger("Timings", true, false);
+    logger.StartTiming(split1);
+    logger.NewTiming(split2);
+    logger.EndTiming();
+    cumulative.AddLogger(logger);
+  }
+  EXPECT_EQ(2U, cumulative.GetIterations());
+  std::vector<std::pair<std::string, uint64_t>> totals;
+  cumulative.GetTotalTimes(&totals);
+  ASSERT_EQ(2U, totals.size());
+  uint64_t total_ns = 0;
+  for (const auto& total : totals) {
+    EXPECT_TRUE(total.first == split1 || total.first == split2) << total.first;
+    total_ns += total.second;
+  }
+  EXPECT_EQ(cumulative.GetTotalNs(), total_ns);
+}
+
+TEST_F(TimingLoggerTest, Utilization) {
+  TimingLogger logger("Utilization", true, false);
+  logger.AddUtilization("Compile", 300, 100, 4);
+  logger.AddUtilization("Verify", 0, 0, 4);
+  logger.AddUtilization("Compile", 100, 100, 4);
+  std::ostringstream oss;
+  logger.Dump(oss);
+  const std::string dump = oss.str();
+  EXPECT_NE(dump.find("Compile: 50% of 4 threads busy"), std::string::npos) << dump;
+  EXPECT_NE(dump.find("Verify: 0% of 4 threads busy"), std::string::npos) << dump;
+  logger.Reset();
+  std::ostringstream reset_oss;
+  logger.Dump(reset_oss);
+  EXPECT_EQ(reset_oss.str().find("Compile:"), std::string::npos) << reset_oss.str();
+}
+
+TEST_F(TimingLoggerTest, JsonExport) {
+  TimingLogger logger("Json \"Timings\"", true, false);
+  logger.StartTiming("Outer");
+  logger.StartTiming("Inner");
+  logger.EndTiming();
+  logger.EndTiming();
+  CumulativeLogger cumulative("Cumulative");
+  cumulative.AddLogger(logger);
+  TimingJsonWriter writer;
+  writer.AddTimingLogger(logger);
+  writer.AddCumulativeLogger(cumulative);
+  std::ostringstream oss;
+  writer.Write(oss);
+  const std::string json = oss.str();
+  // Each split becomes a complete event tagged with the escaped logger name and the thread.
+  const std::string tid = "\"tid\":" + std::to_string(GetTid());
+  size_t outer = json.find("{\"name\":\"Outer\",\"cat\":\"Json \\\"Timings\\\"\",\"ph\":\"X\"");
+  size_t inner = json.find("{\"name\":\"Inner\"");
+  ASSERT_NE(outer, std::string::npos) << json;
+  ASSERT_NE(inner, std::string::npos) << json;
+  EXPECT_LT(outer, inner);
+  EXPECT_NE(json.find(tid, outer), std::string::npos) << json;
+  EXPECT_NE(json.find("\"cumulativeTimings\":[{\"name\":\"Cumulative\",\"iterations\":1"),
+            std::string::npos) << json;
+  EXPECT_NE(json.find("{\"name\":\"Inner\",\"count\":1,"), std::string::npos) << json;
+}
+
 }  // namespace art
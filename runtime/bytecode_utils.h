@@ -106,8 +106,42 @@ class DexSwitchTable : public ValueObject {
 
   bool IsSparse() const { return sparse_; }
 
+  // Whether to build a chain of comparisons against the keys, one after the other.
   bool ShouldBuildDecisionTree() {
-    return IsSparse() || GetNumEntries() <= kSmallSwitchThreshold;
+    return (IsSparse() && !ShouldBuildBinarySearchTree()) ||
+        (!IsSparse() && GetNumEntries() <= kSmallSwitchThreshold);
+  }
+
+  // Whether to build a binary search on the keys of a large sparse switch, whose inner nodes
+  // compare against the middle key and whose leaves are short chains of comparisons.
+  bool ShouldBuildBinarySearchTree() const {
+    return IsSparse() && GetNumEntries() > kBinarySearchSwitchThreshold;
+  }
+
+  // Whether the binary search node over the keys [lo, hi) is a leaf.
+  static bool IsBinarySearchLeaf(size_t lo, size_t hi) {
+    DCHECK_LT(lo, hi);
+    return hi - lo <= kBinarySearchLeafSize;
+  }
+
+  // The key at which the inner binary search node over [lo, hi) splits.
+  static size_t GetBinarySearchSplit(size_t lo, size_t hi) {
+    DCHECK(!IsBinarySearchLeaf(lo, hi));
+    return lo + (hi - lo) / 2;
+  }
+
+  // The dex_pc under which the block of the binary search node over [lo, hi) is stored. For
+  // uniqueness, leaves use the key entries and inner nodes the target entries of the table.
+  uint32_t GetDexPcForBinarySearchNode(size_t lo, size_t hi) const {
+    DCHECK(ShouldBuildBinarySearchTree());
+    return IsBinarySearchLeaf(lo, hi)
+        ? GetDexPcForCaseBlock(lo)
+        : GetDexPcForIndex(GetFirstValueIndex() + GetBinarySearchSplit(lo, hi));
+  }
+
+  // The dex_pc under which the block comparing against key `index` in a leaf is stored.
+  uint32_t GetDexPcForCaseBlock(size_t index) const {
+    return GetDexPcForIndex(index);
   }
 
  private:
@@ -127,6 +161,11 @@ class DexSwitchTable : public ValueObject {
   // compare/jump series.
   static constexpr uint16_t kSmallSwitchThreshold = 3;
 
+  // The number of entries in a sparse switch above which we use a binary search, and the
+  // number of keys compared one after the other in each of its leaves.
+  static constexpr uint16_t kBinarySearchSwitchThreshold = 8;
+  static constexpr size_t kBinarySearchLeafSize = 3;
+
   DISALLOW_COPY_AND_ASSIGN(DexSwitchTable);
 };
 
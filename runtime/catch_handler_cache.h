@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_CATCH_HANDLER_CACHE_H_
+#define ART_RUNTIME_CATCH_HANDLER_CACHE_H_
+
+#include <stdint.h>
+
+#include "base/bit_utils.h"
+#include "base/macros.h"
+#include "dex_file.h"
+
+namespace art {
+
+class ArtMethod;
+
+namespace mirror {
+class Class;
+}  // namespace mirror
+
+// Per-thread cache of the catch handlers ArtMethod::FindCatchBlock looked up, keyed by method,
+// dex pc and exception class. Misses are cached too, so that unwinding through frames without
+// a matching handler does not decode the try items and resolve the handler types again.
+//
+// The cache holds no GC roots. The owning thread clears it whenever its roots are visited,
+// which every collection does before it moves or frees the classes and methods of the entries.
+// The code item is part of the key so that class redefinition does not need to clear caches.
+class CatchHandlerCache {
+ public:
+  CatchHandlerCache() {
+    Clear();
+  }
+
+  // Returns whether the cache has an entry for the key, and the handler dex pc (kDexNoIndex if
+  // the method has no handler for the exception) and whether it starts without move-exception.
+  bool Lookup(ArtMethod* method,
+              const DexFile::CodeItem* code_item,
+              uint32_t dex_pc,
+              mirror::Class* exception_class,
+              uint32_t* handler_dex_pc,
+              bool* has_no_move_exception) const {
+    const Entry& entry = entries_[IndexOf(method, dex_pc, exception_class)];
+    if (entry.method != method ||
+        entry.code_item != code_item ||
+        entry.dex_pc != dex_pc ||
+        entry.exception_class != exception_class) {
+      return false;
+    }
+    *handler_dex_pc = entry.handler_dex_pc;
+    *has_no_move_exception = entry.has_no_move_exception;
+    return true;
+  }
+
+  void Add(ArtMethod* method,
+           const DexFile::CodeItem* code_item,
+           uint32_t dex_pc,
+           mirror::Class* exception_class,
+           uint32_t handler_dex_pc,
+           bool has_no_move_exception) {
+    Entry& entry = entries_[IndexOf(method, dex_pc, exception_class)];
+    entry.method = method;
+    entry.code_item = code_item;
+    entry.dex_pc = dex_pc;
+    entry.exception_class = exception_class;
+    entry.handler_dex_pc = handler_dex_pc;
+    entry.has_no_move_exception = has_no_move_exception;
+  }
+
+  void Clear() {
+    for (Entry& entry : entries_) {
+      entry.method = nullptr;
+    }
+  }
+
+ private:
+  static constexpr size_t kSize = 32;
+  static_assert(IsPowerOfTwo(kSize), "kSize must be a power of two");
+
+  struct Entry {
+    ArtMethod* method;
+    const DexFile::CodeItem* code_item;
+    mirror::Class* exception_class;
+    uint32_t dex_pc;
+    uint32_t handler_dex_pc;
+    bool has_no_move_exception;
+  };
+
+  static size_t IndexOf(ArtMethod* method, uint32_t dex_pc, mirror::Class* exception_class) {
+    uintptr_t hash = (reinterpret_cast<uintptr_t>(method) >> 4) ^
+                     (reinterpret_cast<uintptr_t>(exception_class) >> 3) ^
+                     dex_pc;
+    return (hash ^ (hash >> 7)) & (kSize - 1);
+  }
+
+  Entry entries_[kSize];
+
+  DISALLOW_COPY_AND_ASSIGN(CatchHandlerCache);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_CATCH_HANDLER_CACHE_H_
@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "catch_handler_cache.h"
+
+#include "gtest/gtest.h"
+
+namespace art {
+
+// Mocks some methods, code items and classes.
+#define METHOD1 (reinterpret_cast<ArtMethod*>(8u))
+#define METHOD2 (reinterpret_cast<ArtMethod*>(16u))
+#define CODE_ITEM1 (reinterpret_cast<const DexFile::CodeItem*>(64u))
+#define CODE_ITEM2 (reinterpret_cast<const DexFile::CodeItem*>(128u))
+#define CLASS1 (reinterpret_cast<mirror::Class*>(256u))
+#define CLASS2 (reinterpret_cast<mirror::Class*>(512u))
+
+TEST(CatchHandlerCacheTest, LookupAndClear) {
+  CatchHandlerCache cache;
+  uint32_t handler_dex_pc = 0u;
+  bool has_no_move_exception = false;
+  EXPECT_FALSE(
+      cache.Lookup(METHOD1, CODE_ITEM1, 4u, CLASS1, &handler_dex_pc, &has_no_move_exception));
+
+  cache.Add(METHOD1, CODE_ITEM1, 4u, CLASS1, 12u, true);
+  ASSERT_TRUE(
+      cache.Lookup(METHOD1, CODE_ITEM1, 4u, CLASS1, &handler_dex_pc, &has_no_move_exception));
+  EXPECT_EQ(12u, handler_dex_pc);
+  EXPECT_TRUE(has_no_move_exception);
+
+  // Every part of the key has to match.
+  EXPECT_FALSE(
+      cache.Lookup(METHOD2, CODE_ITEM1, 4u, CLASS1, &handler_dex_pc, &has_no_move_exception));
+  EXPECT_FALSE(
+      cache.Lookup(METHOD1, CODE_ITEM2, 4u, CLASS1, &handler_dex_pc, &has_no_move_exception));
+  EXPECT_FALSE(
+      cache.Lookup(METHOD1, CODE_ITEM1, 6u, CLASS1, &handler_dex_pc, &has_no_move_exception));
+  EXPECT_FALSE(
+      cache.Lookup(METHOD1, CODE_ITEM1, 4u, CLASS2, &handler_dex_pc, &has_no_move_exception));
+
+  // Methods without a handler for the exception are cached too.
+  cache.Add(METHOD2, CODE_ITEM2, 4u, CLASS2, DexFile::kDexNoIndex, false);
+  ASSERT_TRUE(
+      cache.Lookup(METHOD2, CODE_ITEM2, 4u, CLASS2, &handler_dex_pc, &has_no_move_exception));
+  EXPECT_EQ(DexFile::kDexNoIndex, handler_dex_pc);
+
+  cache.Clear();
+  EXPECT_FALSE(
+      cache.Lookup(METHOD1, CODE_ITEM1, 4u, CLASS1, &handler_dex_pc, &has_no_move_exception));
+  EXPECT_FALSE(
+      cache.Lookup(METHOD2, CODE_ITEM2, 4u, CLASS2, &handler_dex_pc, &has_no_move_exception));
+}
+
+}  // namespace art
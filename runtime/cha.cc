@@ -29,6 +29,13 @@
 
 namespace art {
 
+ClassHierarchyAnalysis::ClassHierarchyAnalysis()
+    : pending_generation_(0u),
+      flushed_generation_(0u),
+      flush_in_progress_(false),
+      flush_cond_("CHA flush condition variable", *Locks::cha_lock_) {
+}
+
 void ClassHierarchyAnalysis::AddDependency(ArtMethod* method,
                                            ArtMethod* dependent_method,
                                            OatQuickMethodHeader* dependent_header) {
@@ -74,6 +81,30 @@ void ClassHierarchyAnalysis::RemoveDependentsWithMethodHeaders(
       map_it++;
     }
   }
+  // The freed code must not be invalidated by the next flush either.
+  pending_invalidations_.erase(
+      std::remove_if(
+          pending_invalidations_.begin(),
+          pending_invalidations_.end(),
+          [&method_headers](MethodAndMethodHeaderPair& dependent) {
+            return method_headers.find(dependent.second) != method_headers.end();
+          }),
+      pending_invalidations_.end());
+}
+
+void ClassHierarchyAnalysis::MoveDependentMethodHeaders(
+    const std::unordered_map<OatQuickMethodHeader*, OatQuickMethodHeader*>&
+        moved_method_headers) {
+  auto move = [&moved_method_headers](MethodAndMethodHeaderPair& dependent) {
+    auto it = moved_method_headers.find(dependent.second);
+    if (it != moved_method_headers.end()) {
+      dependent.second = it->second;
+    }
+  };
+  for (auto& entry : cha_dependency_map_) {
+    std::for_each(entry.second.begin(), entry.second.end(), move);
+  }
+  std::for_each(pending_invalidations_.begin(), pending_invalidations_.end(), move);
 }
 
 // This stack visitor walks the stack and for compiled code with certain method
@@ -513,60 +544,99 @@ void ClassHierarchyAnalysis::InvalidateSingleImplementationMethods(
   if (!invalidated_single_impl_methods.empty()) {
     Runtime* const runtime = Runtime::Current();
     Thread *self = Thread::Current();
-    // Method headers for compiled code to be invalidated.
-    std::unordered_set<OatQuickMethodHeader*> dependent_method_headers;
     PointerSize image_pointer_size =
         Runtime::Current()->GetClassLinker()->GetImagePointerSize();
 
-    {
-      // We do this under cha_lock_. Committing code also grabs this lock to
-      // make sure the code is only committed when all single-implementation
-      // assumptions are still true.
-      MutexLock cha_mu(self, *Locks::cha_lock_);
-      // Invalidate compiled methods that assume some virtual calls have only
-      // single implementations.
-      for (ArtMethod* invalidated : invalidated_single_impl_methods) {
-        if (!invalidated->HasSingleImplementation()) {
-          // It might have been invalidated already when other class linking is
-          // going on.
-          continue;
-        }
-        invalidated->SetHasSingleImplementation(false);
-        if (invalidated->IsAbstract()) {
-          // Clear the single implementation method.
-          invalidated->SetSingleImplementation(nullptr, image_pointer_size);
-        }
+    // We do this under cha_lock_. Committing code also grabs this lock to
+    // make sure the code is only committed when all single-implementation
+    // assumptions are still true.
+    MutexLock cha_mu(self, *Locks::cha_lock_);
+    for (ArtMethod* invalidated : invalidated_single_impl_methods) {
+      if (!invalidated->HasSingleImplementation()) {
+        // It might have been invalidated already when other class linking is
+        // going on.
+        continue;
+      }
+      invalidated->SetHasSingleImplementation(false);
+      if (invalidated->IsAbstract()) {
+        // Clear the single implementation method.
+        invalidated->SetSingleImplementation(nullptr, image_pointer_size);
+      }
 
-        if (runtime->IsAotCompiler()) {
-          // No need to invalidate any compiled code as the AotCompiler doesn't
-          // run any code.
-          continue;
-        }
+      if (runtime->IsAotCompiler()) {
+        // No need to invalidate any compiled code as the AotCompiler doesn't
+        // run any code.
+        continue;
+      }
+
+      // Record the dependents, they get invalidated before the class that was
+      // just linked can be instantiated.
+      const ListOfDependentPairs& dependents = GetDependents(invalidated);
+      if (!dependents.empty()) {
+        DCHECK(runtime->UseJitCompilation());
+        pending_invalidations_.insert(
+            pending_invalidations_.end(), dependents.begin(), dependents.end());
+        ++pending_generation_;
+      }
+      RemoveAllDependenciesFor(invalidated);
+    }
+  }
+}
 
-        // Invalidate all dependents.
-        for (const auto& dependent : GetDependents(invalidated)) {
-          ArtMethod* method = dependent.first;;
+void ClassHierarchyAnalysis::FlushPendingInvalidations(Thread* self) {
+  Runtime* const runtime = Runtime::Current();
+  // Method headers for compiled code to be invalidated.
+  std::unordered_set<OatQuickMethodHeader*> dependent_method_headers;
+  uint64_t generation = 0u;
+  while (true) {
+    {
+      MutexLock cha_mu(self, *Locks::cha_lock_);
+      if (flushed_generation_ == pending_generation_) {
+        return;
+      }
+      if (!flush_in_progress_) {
+        generation = pending_generation_;
+        for (const MethodAndMethodHeaderPair& dependent : pending_invalidations_) {
+          ArtMethod* method = dependent.first;
           OatQuickMethodHeader* method_header = dependent.second;
+          if (!dependent_method_headers.insert(method_header).second) {
+            // Several invalidated methods may share the same dependent code.
+            continue;
+          }
           VLOG(class_linker) << "CHA invalidated compiled code for " << method->PrettyMethod();
-          DCHECK(runtime->UseJitCompilation());
-          runtime->GetJit()->GetCodeCache()->InvalidateCompiledCodeFor(
-              method, method_header);
-          dependent_method_headers.insert(method_header);
+          runtime->GetJit()->GetCodeCache()->InvalidateCompiledCodeFor(method, method_header);
         }
-        RemoveAllDependenciesFor(invalidated);
+        pending_invalidations_.clear();
+        if (dependent_method_headers.empty()) {
+          flushed_generation_ = generation;
+          return;
+        }
+        flush_in_progress_ = true;
+        break;
       }
     }
-
-    if (dependent_method_headers.empty()) {
-      return;
-    }
-    // Deoptimze compiled code on stack that should have been invalidated.
-    CHACheckpoint checkpoint(dependent_method_headers);
-    size_t threads_running_checkpoint = runtime->GetThreadList()->RunCheckpoint(&checkpoint);
-    if (threads_running_checkpoint != 0) {
-      checkpoint.WaitForThreadsToRunThroughCheckpoint(threads_running_checkpoint);
+    // The invalidations being flushed by another thread may include the ones
+    // of the class we are about to initialize, wait for them. Wait suspended
+    // as the other thread runs a checkpoint, and do not hold cha_lock_ when
+    // becoming runnable again.
+    ScopedThreadSuspension sts(self, kWaitingForCheckPointsToRun);
+    MutexLock cha_mu(self, *Locks::cha_lock_);
+    while (flush_in_progress_) {
+      flush_cond_.Wait(self);
     }
   }
+
+  // Deoptimze compiled code on stack that should have been invalidated.
+  CHACheckpoint checkpoint(dependent_method_headers);
+  size_t threads_running_checkpoint = runtime->GetThreadList()->RunCheckpoint(&checkpoint);
+  if (threads_running_checkpoint != 0) {
+    checkpoint.WaitForThreadsToRunThroughCheckpoint(threads_running_checkpoint);
+  }
+
+  MutexLock cha_mu(self, *Locks::cha_lock_);
+  flushed_generation_ = generation;
+  flush_in_progress_ = false;
+  flush_cond_.Broadcast(self);
 }
 
 void ClassHierarchyAnalysis::RemoveDependenciesForLinearAlloc(const LinearAlloc* linear_alloc) {
@@ -580,6 +650,14 @@ void ClassHierarchyAnalysis::RemoveDependenciesForLinearAlloc(const LinearAlloc*
       ++it;
     }
   }
+  pending_invalidations_.erase(
+      std::remove_if(
+          pending_invalidations_.begin(),
+          pending_invalidations_.end(),
+          [linear_alloc](MethodAndMethodHeaderPair& dependent) {
+            return linear_alloc->ContainsUnsafe(dependent.first);
+          }),
+      pending_invalidations_.end());
 }
 
 }  // namespace art
@@ -55,6 +55,14 @@ class LinearAlloc;
  * will be updated as a result. Method A can later be recompiled with less
  * aggressive assumptions.
  *
+ * The invalidation of the dependent compiled code is deferred until a class
+ * is about to be initialized, see FlushPendingInvalidations(). Code that
+ * assumes single-implementation of a method can only go wrong once there is
+ * an instance of the class that overrides it, and a class cannot have
+ * instances before it is initialized. This lets a burst of class loading,
+ * such as loading several subclasses in a row, invalidate all the code it
+ * affects with a single checkpoint.
+ *
  * For live compiled code that's on stack, deoptmization will be initiated
  * to force the invalidated compiled code into interpreter mode to guarantee
  * correctness. The deoptimization mechanism used is a hybrid of
@@ -87,7 +95,7 @@ class ClassHierarchyAnalysis {
   typedef std::pair<ArtMethod*, OatQuickMethodHeader*> MethodAndMethodHeaderPair;
   typedef std::vector<MethodAndMethodHeaderPair> ListOfDependentPairs;
 
-  ClassHierarchyAnalysis() {}
+  ClassHierarchyAnalysis();
 
   // Add a dependency that compiled code with `dependent_header` for `dependent_method`
   // assumes that virtual `method` has single-implementation.
@@ -109,9 +117,22 @@ class ClassHierarchyAnalysis {
       const std::unordered_set<OatQuickMethodHeader*>& method_headers)
       REQUIRES(Locks::cha_lock_);
 
+  // Replace in cha_dependency_map_ and the pending invalidations the method headers of compiled
+  // code that was moved, according to the old to new header pairs of `moved_method_headers`.
+  void MoveDependentMethodHeaders(
+      const std::unordered_map<OatQuickMethodHeader*, OatQuickMethodHeader*>&
+          moved_method_headers)
+      REQUIRES(Locks::cha_lock_);
+
   // Update CHA info for methods that `klass` overrides, after loading `klass`.
   void UpdateAfterLoadingOf(Handle<mirror::Class> klass) REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Invalidate the compiled code recorded by UpdateAfterLoadingOf() and deoptimize its frames
+  // on the stacks of all threads. This must be called before any class loaded since the last
+  // flush can get instances. If another thread is already flushing, wait for it to finish.
+  void FlushPendingInvalidations(Thread* self)
+      REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(!Locks::cha_lock_);
+
   // Remove all of the dependencies for a linear allocator. This is called when dex cache unloading
   // occurs.
   void RemoveDependenciesForLinearAlloc(const LinearAlloc* linear_alloc)
@@ -167,6 +188,15 @@ class ClassHierarchyAnalysis {
   std::unordered_map<ArtMethod*, ListOfDependentPairs> cha_dependency_map_
     GUARDED_BY(Locks::cha_lock_);
 
+  // Compiled code whose single-implementation assumptions have been invalidated but that has
+  // not been invalidated yet.
+  ListOfDependentPairs pending_invalidations_ GUARDED_BY(Locks::cha_lock_);
+  // Number of additions to pending_invalidations_, and how many of them have been flushed.
+  uint64_t pending_generation_ GUARDED_BY(Locks::cha_lock_);
+  uint64_t flushed_generation_ GUARDED_BY(Locks::cha_lock_);
+  bool flush_in_progress_ GUARDED_BY(Locks::cha_lock_);
+  ConditionVariable flush_cond_ GUARDED_BY(Locks::cha_lock_);
+
   DISALLOW_COPY_AND_ASSIGN(ClassHierarchyAnalysis);
 };
 
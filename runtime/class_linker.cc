@@ -105,11 +105,14 @@
 #include "oat_file_manager.h"
 #include "object_lock.h"
 #include "os.h"
+#include "quick_frame_cache.h"
 #include "runtime.h"
 #include "runtime_callbacks.h"
 #include "scoped_thread_state_change-inl.h"
+#include "startup_phases.h"
 #include "thread-inl.h"
 #include "thread_list.h"
+#include "thread_pool.h"
 #include "trace.h"
 #include "utf.h"
 #include "utils.h"
@@ -124,6 +127,9 @@ using android::base::StringPrintf;
 static constexpr bool kSanityCheckObjects = kIsDebugBuild;
 static constexpr bool kVerifyArtMethodDeclaringClasses = kIsDebugBuild;
 
+// Background verification should not compete with the threads the app is waiting on.
+static constexpr int kVerificationThreadPthreadPriority = 9;
+
 static void ThrowNoClassDefFoundError(const char* fmt, ...)
     __attribute__((__format__(__printf__, 1, 2)))
     REQUIRES_SHARED(Locks::mutator_lock_);
@@ -400,6 +406,7 @@ void ClassLinker::CheckSystemClass(Thread* self, Handle<mirror::Class> c1, const
 bool ClassLinker::InitWithoutImage(std::vector<std::unique_ptr<const DexFile>> boot_class_path,
                                    std::string* error_msg) {
   VLOG(startup) << "ClassLinker::Init";
+  ScopedStartupPhase startup_phase(__FUNCTION__);
 
   Thread* const self = Thread::Current();
   Runtime* const runtime = Runtime::Current();
@@ -870,6 +877,7 @@ struct TrampolineCheckData {
 
 bool ClassLinker::InitFromBootImage(std::string* error_msg) {
   VLOG(startup) << __FUNCTION__ << " entering";
+  ScopedStartupPhase startup_phase(__FUNCTION__);
   CHECK(!init_done_);
 
   Runtime* const runtime = Runtime::Current();
@@ -1023,6 +1031,9 @@ bool ClassLinker::InitFromBootImage(std::string* error_msg) {
   for (const std::unique_ptr<const DexFile>& dex_file : boot_dex_files_) {
     OatDexFile::MadviseDexFile(*dex_file, MadviseState::kMadviseStateAtLoad);
   }
+  for (const OatFile* oat_file : oat_files) {
+    oat_file->MadviseCode(MadviseState::kMadviseStateAtLoad);
+  }
   FinishInit(self);
 
   VLOG(startup) << __FUNCTION__ << " exiting";
@@ -1381,26 +1392,11 @@ bool AppImageClassLoadersAndDexCachesHelper::Update(
         // If the oat file expects the dex cache arrays to be in the BSS, then allocate there and
         // copy over the arrays.
         DCHECK(dex_file != nullptr);
-        size_t num_strings = mirror::DexCache::kDexCacheStringCacheSize;
-        if (dex_file->NumStringIds() < num_strings) {
-          num_strings = dex_file->NumStringIds();
-        }
-        size_t num_types = mirror::DexCache::kDexCacheTypeCacheSize;
-        if (dex_file->NumTypeIds() < num_types) {
-          num_types = dex_file->NumTypeIds();
-        }
-        size_t num_methods = mirror::DexCache::kDexCacheMethodCacheSize;
-        if (dex_file->NumMethodIds() < num_methods) {
-          num_methods = dex_file->NumMethodIds();
-        }
-        size_t num_fields = mirror::DexCache::kDexCacheFieldCacheSize;
-        if (dex_file->NumFieldIds() < num_fields) {
-          num_fields = dex_file->NumFieldIds();
-        }
-        size_t num_method_types = mirror::DexCache::kDexCacheMethodTypeCacheSize;
-        if (dex_file->NumProtoIds() < num_method_types) {
-          num_method_types = dex_file->NumProtoIds();
-        }
+        size_t num_strings = mirror::DexCache::StringCacheSize(dex_file->NumStringIds());
+        size_t num_types = mirror::DexCache::TypeCacheSize(dex_file->NumTypeIds());
+        size_t num_methods = mirror::DexCache::MethodCacheSize(dex_file->NumMethodIds());
+        size_t num_fields = mirror::DexCache::FieldCacheSize(dex_file->NumFieldIds());
+        size_t num_method_types = mirror::DexCache::MethodTypeCacheSize(dex_file->NumProtoIds());
         const size_t num_call_sites = dex_file->NumCallSiteIds();
         CHECK_EQ(num_strings, dex_cache->NumStrings());
         CHECK_EQ(num_types, dex_cache->NumResolvedTypes());
@@ -2330,6 +2326,10 @@ void ClassLinker::DeleteClassLoader(Thread* self, const ClassLoaderData& data) {
     // If we don't have a JIT, we need to manually remove the CHA dependencies manually.
     cha_->RemoveDependenciesForLinearAlloc(data.allocator);
   }
+  // The debugger keys its method event filter by method, so it must not outlive the methods.
+  Dbg::ClearMethodEventFilter();
+  // Likewise for the frame caches.
+  QuickFrameCache::InvalidateAll();
   delete data.allocator;
   delete data.class_table;
 }
@@ -2825,6 +2825,90 @@ mirror::Class* ClassLinker::FindClass(Thread* self,
   return result_ptr.Ptr();
 }
 
+class PreloadClassesTask : public Task {
+ public:
+  PreloadClassesTask(jobject class_loader,
+                     const std::vector<std::string>& descriptors,
+                     Atomic<size_t>* next_index,
+                     Atomic<size_t>* num_loaded)
+      : class_loader_(class_loader),
+        descriptors_(descriptors),
+        next_index_(next_index),
+        num_loaded_(num_loaded) {}
+
+  void Run(Thread* self) OVERRIDE {
+    ScopedObjectAccess soa(self);
+    ClassLinker* const class_linker = Runtime::Current()->GetClassLinker();
+    StackHandleScope<2> hs(self);
+    Handle<mirror::ClassLoader> class_loader(
+        hs.NewHandle(soa.Decode<mirror::ClassLoader>(class_loader_)));
+    MutableHandle<mirror::Class> klass(hs.NewHandle<mirror::Class>(nullptr));
+    // Take the classes one at a time, their loading times vary a lot.
+    for (size_t i = next_index_->FetchAndAddRelaxed(1u);
+         i < descriptors_.size();
+         i = next_index_->FetchAndAddRelaxed(1u)) {
+      klass.Assign(class_linker->FindClass(self, descriptors_[i].c_str(), class_loader));
+      if (klass == nullptr) {
+        self->ClearException();
+        continue;
+      }
+      class_linker->VerifyClass(self, klass);
+      if (self->IsExceptionPending()) {
+        self->ClearException();
+      }
+      num_loaded_->FetchAndAddRelaxed(1u);
+    }
+  }
+
+  void Finalize() OVERRIDE {
+    delete this;
+  }
+
+ private:
+  const jobject class_loader_;
+  const std::vector<std::string>& descriptors_;
+  Atomic<size_t>* const next_index_;
+  Atomic<size_t>* const num_loaded_;
+};
+
+size_t ClassLinker::PreloadClasses(Thread* self,
+                                   jobject class_loader,
+                                   const std::vector<std::string>& descriptors,
+                                   size_t num_threads) {
+  if (descriptors.empty() || num_threads == 0u) {
+    return 0u;
+  }
+  // Peers let the workers call into class loaders written in Java. They can only be created
+  // once the runtime is started.
+  const bool create_peers = Runtime::Current()->IsStarted();
+  ThreadPool thread_pool("Class preloading thread pool", num_threads, create_peers);
+  Atomic<size_t> next_index(0u);
+  Atomic<size_t> num_loaded(0u);
+  for (size_t i = 0; i != num_threads; ++i) {
+    thread_pool.AddTask(
+        self, new PreloadClassesTask(class_loader, descriptors, &next_index, &num_loaded));
+  }
+  uint64_t start_time = NanoTime();
+  thread_pool.StartWorkers(self);
+  thread_pool.Wait(self, /* do_work */ false, /* may_hold_locks */ false);
+  VLOG(class_linker) << "Preloaded " << num_loaded.LoadRelaxed() << " of " << descriptors.size()
+                     << " classes with " << num_threads << " threads in "
+                     << PrettyDuration(NanoTime() - start_time);
+  return num_loaded.LoadRelaxed();
+}
+
+size_t ClassLinker::PreloadProfileClasses(Thread* self,
+                                          jobject class_loader,
+                                          ProfileCompilationInfo* profile,
+                                          const std::vector<const DexFile*>& dex_files,
+                                          size_t num_threads) {
+  std::unordered_set<std::string> descriptors = profile->GetClassDescriptors(dex_files);
+  return PreloadClasses(self,
+                        class_loader,
+                        std::vector<std::string>(descriptors.begin(), descriptors.end()),
+                        num_threads);
+}
+
 mirror::Class* ClassLinker::DefineClass(Thread* self,
                                         const char* descriptor,
                                         size_t hash,
@@ -2980,6 +3064,8 @@ mirror::Class* ClassLinker::DefineClass(Thread* self,
    */
   Runtime::Current()->GetRuntimeCallbacks()->ClassPrepare(klass, h_new_class);
 
+  MaybeVerifyClassInBackground(self, h_new_class);
+
   // Notify native debugger of the new class and its layout.
   jit::Jit::NewTypeLoadedIfUsingJit(h_new_class.Get());
 
@@ -3978,9 +4064,30 @@ mirror::Class* ClassLinker::InsertClass(const char* descriptor, ObjPtr<mirror::C
     }
     LOG(INFO) << "Loaded class " << descriptor << source;
   }
+  Thread* const self = Thread::Current();
+  ObjPtr<mirror::ClassLoader> const class_loader = klass->GetClassLoader();
   {
-    WriterMutexLock mu(Thread::Current(), *Locks::classlinker_classes_lock_);
-    ObjPtr<mirror::ClassLoader> const class_loader = klass->GetClassLoader();
+    // Once the class loader has a class table, inserting only needs the lock of that table, so
+    // that threads loading classes do not serialize on classlinker_classes_lock_. The root log
+    // is only written under the exclusive lock.
+    ReaderMutexLock mu(self, *Locks::classlinker_classes_lock_);
+    ClassTable* const class_table = ClassTableForClassLoader(class_loader);
+    if (class_table != nullptr && !log_new_roots_) {
+      VerifyObject(klass);
+      ObjPtr<mirror::Class> existing = class_table->TryInsertWithHash(klass, hash);
+      if (existing != klass) {
+        return existing.Ptr();
+      }
+      if (class_loader != nullptr) {
+        // This is necessary because we need to have the card dirtied for remembered sets.
+        Runtime::Current()->GetHeap()->WriteBarrierEveryFieldOf(class_loader);
+      }
+      CheckCopiedMethodsHolder(klass);
+      return nullptr;
+    }
+  }
+  {
+    WriterMutexLock mu(self, *Locks::classlinker_classes_lock_);
     ClassTable* const class_table = InsertClassTableForClassLoader(class_loader);
     ObjPtr<mirror::Class> existing = class_table->Lookup(descriptor, hash);
     if (existing != nullptr) {
@@ -3996,13 +4103,17 @@ mirror::Class* ClassLinker::InsertClass(const char* descriptor, ObjPtr<mirror::C
       new_class_roots_.push_back(GcRoot<mirror::Class>(klass));
     }
   }
+  CheckCopiedMethodsHolder(klass);
+  return nullptr;
+}
+
+void ClassLinker::CheckCopiedMethodsHolder(ObjPtr<mirror::Class> klass) {
   if (kIsDebugBuild) {
     // Test that copied methods correctly can find their holder.
     for (ArtMethod& method : klass->GetCopiedMethods(image_pointer_size_)) {
       CHECK_EQ(GetHoldingClassOfCopiedMethod(&method), klass);
     }
   }
-  return nullptr;
 }
 
 void ClassLinker::WriteBarrierForBootOatFileBssRoots(const OatFile* oat_file) {
@@ -4033,7 +4144,8 @@ mirror::Class* ClassLinker::LookupClass(Thread* self,
                                         const char* descriptor,
                                         size_t hash,
                                         ObjPtr<mirror::ClassLoader> class_loader) {
-  ReaderMutexLock mu(self, *Locks::classlinker_classes_lock_);
+  // No need for the classlinker_classes_lock_: the class table of a live class loader is never
+  // replaced or deleted and ClassTable::Lookup() synchronizes with the writers on its own.
   ClassTable* const class_table = ClassTableForClassLoader(class_loader);
   if (class_table != nullptr) {
     ObjPtr<mirror::Class> result = class_table->Lookup(descriptor, hash);
@@ -4371,6 +4483,75 @@ verifier::FailureKind ClassLinker::PerformClassVerification(Thread* self,
                                                error_msg);
 }
 
+// Verifies a class defined by an app class loader on a verification thread. The class is held
+// through a weak global so that queueing it does not keep its class loader alive.
+class VerifyClassTask FINAL : public Task {
+ public:
+  explicit VerifyClassTask(jweak klass) : klass_(klass) {}
+
+  void Run(Thread* self) OVERRIDE {
+    ScopedObjectAccess soa(self);
+    StackHandleScope<1> hs(self);
+    Handle<mirror::Class> klass(hs.NewHandle(soa.Decode<mirror::Class>(klass_)));
+    if (klass != nullptr && !klass->IsVerified() && !klass->IsErroneous()) {
+      Runtime::Current()->GetClassLinker()->VerifyClass(self, klass);
+      // A hard failure is recorded in the class and rethrown on the thread that uses it.
+      self->ClearException();
+    }
+  }
+
+  void Finalize() OVERRIDE {
+    Thread* self = Thread::Current();
+    self->GetJniEnv()->vm->DeleteWeakGlobalRef(self, klass_);
+    delete this;
+  }
+
+ private:
+  const jweak klass_;
+
+  DISALLOW_COPY_AND_ASSIGN(VerifyClassTask);
+};
+
+void ClassLinker::CreateVerificationThreadPool(size_t num_threads) {
+  DCHECK(verification_thread_pool_ == nullptr);
+  // Verification may load classes through the app class loaders, which runs managed code.
+  constexpr bool kVerificationPoolNeedsPeers = true;
+  verification_thread_pool_.reset(
+      new ThreadPool("Verification thread pool", num_threads, kVerificationPoolNeedsPeers));
+  verification_thread_pool_->SetPthreadPriority(kVerificationThreadPthreadPriority);
+  verification_thread_pool_->StartWorkers(Thread::Current());
+}
+
+void ClassLinker::DeleteVerificationThreadPool() {
+  if (verification_thread_pool_ == nullptr) {
+    return;
+  }
+  Thread* self = Thread::Current();
+  std::unique_ptr<ThreadPool> pool;
+  {
+    ScopedSuspendAll ssa(__FUNCTION__);
+    // Clear the field while the threads are suspended, DefineClass checks against it.
+    pool = std::move(verification_thread_pool_);
+  }
+  // Classes left in the queue stay lazily verified.
+  pool->StopWorkers(self);
+  pool->RemoveAllTasks(self);
+  pool->Wait(self, false, false);
+}
+
+void ClassLinker::MaybeVerifyClassInBackground(Thread* self, Handle<mirror::Class> klass) {
+  // Boot classpath classes are verified when the boot image is compiled.
+  if (verification_thread_pool_ == nullptr || klass->GetClassLoader() == nullptr) {
+    return;
+  }
+  mirror::Class::Status oat_file_class_status(mirror::Class::kStatusNotReady);
+  if (VerifyClassUsingOatFile(klass->GetDexFile(), klass.Get(), oat_file_class_status)) {
+    return;
+  }
+  jweak weak_klass = self->GetJniEnv()->vm->AddWeakGlobalRef(self, klass.Get());
+  verification_thread_pool_->AddTask(self, new VerifyClassTask(weak_klass));
+}
+
 bool ClassLinker::VerifyClassUsingOatFile(const DexFile& dex_file,
                                           ObjPtr<mirror::Class> klass,
                                           mirror::Class::Status& oat_file_class_status) {
@@ -4611,6 +4792,9 @@ mirror::Class* ClassLinker::CreateProxyClass(ScopedObjectAccessAlreadyRunnable&
   {
     // Lock on klass is released. Lock new class object.
     ObjectLock<mirror::Class> initialization_lock(self, klass);
+    if (cha_ != nullptr) {
+      cha_->FlushPendingInvalidations(self);
+    }
     mirror::Class::SetStatus(klass, mirror::Class::kStatusInitialized, self);
   }
 
@@ -4892,6 +5076,12 @@ bool ClassLinker::InitializeClass(Thread* self, Handle<mirror::Class> klass,
     CHECK_EQ(klass->GetStatus(), mirror::Class::kStatusVerified) << klass->PrettyClass()
         << " self.tid=" << self->GetTid() << " clinit.tid=" << klass->GetClinitThreadId();
 
+    // The class can get instances once it is initializing, the compiled code that relies on
+    // single-implementation assumptions it broke must be invalidated by then.
+    if (cha_ != nullptr) {
+      cha_->FlushPendingInvalidations(self);
+    }
+
     // From here out other threads may observe that we're initializing and so changes of state
     // require the a notification.
     klass->SetClinitThreadId(self->GetTid());
@@ -5398,8 +5588,10 @@ void ClassLinker::RegisterClassLoader(ObjPtr<mirror::ClassLoader> class_loader)
   Thread* const self = Thread::Current();
   ClassLoaderData data;
   data.weak_root = self->GetJniEnv()->vm->AddWeakGlobalRef(self, class_loader);
-  // Create and set the class table.
+  // Create and set the class table. LookupClass() reads the class table without locks, publish
+  // it only once it is constructed.
   data.class_table = new ClassTable;
+  QuasiAtomic::ThreadFenceRelease();
   class_loader->SetClassTable(data.class_table);
   // Create and set the linear allocator.
   data.allocator = Runtime::Current()->CreateLinearAlloc();
@@ -8629,6 +8821,7 @@ void ClassLinker::DumpForSigQuit(std::ostream& os) {
   ReaderMutexLock mu(soa.Self(), *Locks::classlinker_classes_lock_);
   os << "Zygote loaded classes=" << NumZygoteClasses() << " post zygote classes="
      << NumNonZygoteClasses() << "\n";
+  mirror::DexCache::DumpLookupStats(os);
 }
 
 class CountClassesVisitor : public ClassLoaderVisitor {
@@ -70,8 +70,10 @@ class InternTable;
 class LinearAlloc;
 class OatFile;
 template<class T> class ObjectLock;
+class ProfileCompilationInfo;
 class Runtime;
 class ScopedObjectAccessAlreadyRunnable;
+class ThreadPool;
 template<size_t kNumReferences> class PACKED(4) StackHandleScope;
 
 enum VisitRootFlags : uint8_t;
@@ -190,6 +192,24 @@ class ClassLinker {
     return FindClass(self, descriptor, ScopedNullHandle<mirror::ClassLoader>());
   }
 
+  // Loads, links and verifies the classes with the given descriptors in `class_loader` on a pool
+  // of `num_threads` threads, and waits for them. Classes that cannot be loaded are skipped. The
+  // classes are not initialized, this is left to the caller's thread. Returns the number of
+  // classes loaded.
+  size_t PreloadClasses(Thread* self,
+                        jobject class_loader,
+                        const std::vector<std::string>& descriptors,
+                        size_t num_threads)
+      REQUIRES(!Locks::mutator_lock_);
+
+  // Preloads the classes of `profile` defined in `dex_files`, see PreloadClasses().
+  size_t PreloadProfileClasses(Thread* self,
+                               jobject class_loader,
+                               ProfileCompilationInfo* profile,
+                               const std::vector<const DexFile*>& dex_files,
+                               size_t num_threads)
+      REQUIRES(!Locks::mutator_lock_);
+
   // Finds the array class given for the element class.
   mirror::Class* FindArrayClass(Thread* self, ObjPtr<mirror::Class>* element_class)
       REQUIRES_SHARED(Locks::mutator_lock_)
@@ -466,6 +486,12 @@ class ClassLinker {
                                mirror::Class::Status& oat_file_class_status)
       REQUIRES_SHARED(Locks::mutator_lock_)
       REQUIRES(!Locks::dex_lock_);
+
+  // Verify the classes that app class loaders define on `num_threads` background threads, in the
+  // order they are defined, instead of on the first thread to initialize each of them.
+  void CreateVerificationThreadPool(size_t num_threads);
+  void DeleteVerificationThreadPool();
+
   void ResolveClassExceptionHandlerTypes(Handle<mirror::Class> klass)
       REQUIRES_SHARED(Locks::mutator_lock_)
       REQUIRES(!Locks::dex_lock_);
@@ -731,6 +757,11 @@ class ClassLinker {
     LinearAlloc* allocator;
   };
 
+  // In debug builds, checks that the copied methods of a newly inserted class find their holder.
+  void CheckCopiedMethodsHolder(ObjPtr<mirror::Class> klass)
+      REQUIRES(!Locks::classlinker_classes_lock_)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
   // Ensures that the supertype of 'klass' ('supertype') is verified. Returns false and throws
   // appropriate exceptions if verification failed hard. Returns true for successful verification or
   // soft-failures.
@@ -740,6 +771,12 @@ class ClassLinker {
       REQUIRES(!Locks::dex_lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Queues the newly defined 'klass' on the verification thread pool, unless background
+  // verification is disabled or the oat file already has the class verified.
+  void MaybeVerifyClassInBackground(Thread* self, Handle<mirror::Class> klass)
+      REQUIRES(!Locks::dex_lock_)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
   void DeleteClassLoader(Thread* self, const ClassLoaderData& data)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
@@ -1286,6 +1323,9 @@ class ClassLinker {
 
   std::unique_ptr<ClassHierarchyAnalysis> cha_;
 
+  // Verifies newly defined app classes, if background verification is enabled.
+  std::unique_ptr<ThreadPool> verification_thread_pool_;
+
   class FindVirtualMethodHolderVisitor;
 
   friend class AppImageClassLoadersAndDexCachesHelper;
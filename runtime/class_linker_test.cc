@@ -1178,6 +1178,55 @@ TEST_F(ClassLinkerTest, StaticFields) {
   EXPECT_TRUE(s8->GetObject(statics.Get())->AsString()->Equals("robot"));
 }
 
+TEST_F(ClassLinkerTest, BootImageHotnessCounters) {
+  ScopedObjectAccess soa(Thread::Current());
+  if (!Runtime::Current()->GetHeap()->HasBootImageSpace()) {
+    return;
+  }
+  ObjPtr<mirror::Class> object_class = class_linker_->FindSystemClass(soa.Self(),
+                                                                      "Ljava/lang/Object;");
+  ASSERT_TRUE(object_class != nullptr);
+  ASSERT_TRUE(Runtime::Current()->GetHeap()->ObjectIsInBootImageSpace(object_class));
+  ArtMethod* method = object_class->FindClassMethod("hashCode", "()I", kRuntimePointerSize);
+  ASSERT_TRUE(method != nullptr);
+  const size_t method_size = ArtMethod::Size(kRuntimePointerSize);
+  std::unique_ptr<uint8_t[]> method_copy(new uint8_t[method_size]);
+  memcpy(method_copy.get(), method, method_size);
+  // Counting must not write to the boot image method.
+  const uint16_t counter = method->GetCounter();
+  EXPECT_EQ(static_cast<uint16_t>(counter + 1u), method->IncrementCounter());
+  EXPECT_EQ(static_cast<uint16_t>(counter + 1u), method->GetCounter());
+  EXPECT_EQ(0, memcmp(method_copy.get(), method, method_size));
+  method->SetCounter(counter);
+  EXPECT_EQ(counter, method->GetCounter());
+}
+
+TEST_F(ClassLinkerTest, PreloadClasses) {
+  Thread* self = Thread::Current();
+  jobject jclass_loader;
+  {
+    ScopedObjectAccess soa(self);
+    jclass_loader = LoadDex("Interfaces");
+  }
+  std::vector<std::string> descriptors =
+      { "LInterfaces$A;", "LInterfaces$B;", "LInterfaces$K;", "LInterfaces;", "LDoesNotExist;" };
+  EXPECT_EQ(4u, class_linker_->PreloadClasses(self, jclass_loader, descriptors, 2u));
+
+  ScopedObjectAccess soa(self);
+  ObjPtr<mirror::ClassLoader> class_loader = soa.Decode<mirror::ClassLoader>(jclass_loader);
+  for (size_t i = 0; i != 4u; ++i) {
+    mirror::Class* klass =
+        class_linker_->LookupClass(soa.Self(), descriptors[i].c_str(), class_loader);
+    ASSERT_TRUE(klass != nullptr) << descriptors[i];
+    EXPECT_TRUE(klass->IsResolved()) << descriptors[i];
+    // Initialization is left to the caller.
+    EXPECT_FALSE(klass->IsInitialized()) << descriptors[i];
+  }
+  // Linking K loaded its super interface.
+  EXPECT_TRUE(class_linker_->LookupClass(soa.Self(), "LInterfaces$J;", class_loader) != nullptr);
+  EXPECT_TRUE(class_linker_->LookupClass(soa.Self(), "LDoesNotExist;", class_loader) == nullptr);
+}
+
 TEST_F(ClassLinkerTest, Interfaces) {
   ScopedObjectAccess soa(Thread::Current());
   StackHandleScope<6> hs(soa.Self());
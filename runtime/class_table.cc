@@ -22,15 +22,60 @@
 
 namespace art {
 
-ClassTable::ClassTable() : lock_("Class loader classes", kClassLoaderClassesLock) {
+ClassTable::ClassTable()
+    : lock_("Class loader classes", kClassLoaderClassesLock),
+      sequence_(0u),
+      snapshot_(nullptr) {
   Runtime* const runtime = Runtime::Current();
   classes_.push_back(ClassSet(runtime->GetHashTableMinLoadFactor(),
                               runtime->GetHashTableMaxLoadFactor()));
+  PublishSnapshotLocked();
 }
 
 void ClassTable::FreezeSnapshot() {
   WriterMutexLock mu(Thread::Current(), lock_);
+  BeginWriteLocked();
   classes_.push_back(ClassSet());
+  PublishSnapshotLocked();
+  EndWriteLocked();
+}
+
+void ClassTable::PublishSnapshotLocked() {
+  std::unique_ptr<Snapshot> snapshot(new Snapshot());
+  snapshot->reserve(classes_.size());
+  for (const ClassSet& class_set : classes_) {
+    snapshot->push_back(ClassSetView { class_set.GetData(), class_set.NumBuckets() });
+  }
+  snapshot_.StoreRelease(snapshot.get());
+  snapshots_.push_back(std::move(snapshot));
+}
+
+void ClassTable::BeginWriteLocked() {
+  DCHECK_EQ(sequence_.LoadRelaxed() & 1u, 0u);
+  sequence_.StoreRelaxed(sequence_.LoadRelaxed() + 1u);
+  // Make the odd sequence visible before any of the modifications.
+  QuasiAtomic::ThreadFenceRelease();
+}
+
+void ClassTable::EndWriteLocked() {
+  DCHECK_EQ(sequence_.LoadRelaxed() & 1u, 1u);
+  sequence_.StoreRelease(sequence_.LoadRelaxed() + 1u);
+}
+
+void ClassTable::InsertLocked(const TableSlot& slot, uint32_t hash) {
+  ClassSet& class_set = classes_.back();
+  BeginWriteLocked();
+  if (class_set.Size() >= class_set.ElementsUntilExpand()) {
+    // Growing would free the storage under the lock-free lookups. Grow a copy instead.
+    ClassSet grown(class_set);
+    grown.InsertWithHash(slot, hash);
+    class_set.swap(grown);
+    retired_class_sets_.push_back(std::move(grown));
+    PublishSnapshotLocked();
+  } else {
+    class_set.InsertWithHash(slot, hash);
+  }
+  EndWriteLocked();
 }
 
 bool ClassTable::Contains(ObjPtr<mirror::Class> klass) {
@@ -84,7 +129,9 @@ mirror::Class* ClassTable::UpdateClass(const char* descriptor, mirror::Class* kl
   VerifyObject(klass);
   // Update the element in the hash set with the new class. This is safe to do since the descriptor
   // doesn't change.
+  BeginWriteLocked();
   *existing_it = TableSlot(klass, hash);
+  EndWriteLocked();
   return existing;
 }
 
@@ -129,8 +176,40 @@ size_t ClassTable::NumReferencedNonZygoteClasses() const {
   return classes_.back().Size();
 }
 
+mirror::Class* ClassTable::LookupLockFree(const DescriptorHashPair& pair, size_t hash) const {
+  // Linear probing as in HashSet::FindIndex().
+  ClassDescriptorHashEquals pred;
+  for (const ClassSetView& view : *snapshot_.LoadAcquire()) {
+    if (view.num_buckets == 0u) {
+      continue;
+    }
+    size_t index = hash % view.num_buckets;
+    while (true) {
+      const TableSlot& slot = view.data[index];
+      if (slot.IsNull()) {
+        break;
+      }
+      if (pred(slot, pair)) {
+        return slot.Read();
+      }
+      index = (index + 1u != view.num_buckets) ? index + 1u : 0u;
+    }
+  }
+  return nullptr;
+}
+
 mirror::Class* ClassTable::Lookup(const char* descriptor, size_t hash) {
   DescriptorHashPair pair(descriptor, hash);
+  // Seqlock read: trust the lock-free probe only if no writer was active before or during it.
+  // The storage it reads is never freed while the table is alive, see InsertLocked().
+  const uint32_t sequence = sequence_.LoadAcquire();
+  if (LIKELY((sequence & 1u) == 0u)) {
+    mirror::Class* result = LookupLockFree(pair, hash);
+    QuasiAtomic::ThreadFenceAcquire();
+    if (LIKELY(sequence_.LoadRelaxed() == sequence)) {
+      return result;
+    }
+  }
   ReaderMutexLock mu(Thread::Current(), lock_);
   for (ClassSet& class_set : classes_) {
     auto it = class_set.FindWithHash(pair, hash);
@@ -142,7 +221,11 @@ mirror::Class* ClassTable::Lookup(const char* descriptor, size_t hash) {
 }
 
 ObjPtr<mirror::Class> ClassTable::TryInsert(ObjPtr<mirror::Class> klass) {
-  TableSlot slot(klass);
+  return TryInsertWithHash(klass, TableSlot::HashDescriptor(klass));
+}
+
+ObjPtr<mirror::Class> ClassTable::TryInsertWithHash(ObjPtr<mirror::Class> klass, size_t hash) {
+  TableSlot slot(klass, hash);
   WriterMutexLock mu(Thread::Current(), lock_);
   for (ClassSet& class_set : classes_) {
     auto it = class_set.Find(slot);
@@ -150,14 +233,14 @@ ObjPtr<mirror::Class> ClassTable::TryInsert(ObjPtr<mirror::Class> klass) {
       return it->Read();
     }
   }
-  classes_.back().Insert(slot);
+  InsertLocked(slot, hash);
   return klass;
 }
 
 void ClassTable::Insert(ObjPtr<mirror::Class> klass) {
   const uint32_t hash = TableSlot::HashDescriptor(klass);
   WriterMutexLock mu(Thread::Current(), lock_);
-  classes_.back().InsertWithHash(TableSlot(klass, hash), hash);
+  InsertLocked(TableSlot(klass, hash), hash);
 }
 
 void ClassTable::CopyWithoutLocks(const ClassTable& source_table) {
@@ -168,19 +251,19 @@ void ClassTable::CopyWithoutLocks(const ClassTable& source_table) {
   }
   for (const ClassSet& class_set : source_table.classes_) {
     for (const TableSlot& slot : class_set) {
-      classes_.back().Insert(slot);
+      InsertLocked(slot, ClassDescriptorHashEquals()(slot));
     }
   }
 }
 
 void ClassTable::InsertWithoutLocks(ObjPtr<mirror::Class> klass) {
   const uint32_t hash = TableSlot::HashDescriptor(klass);
-  classes_.back().InsertWithHash(TableSlot(klass, hash), hash);
+  InsertLocked(TableSlot(klass, hash), hash);
 }
 
 void ClassTable::InsertWithHash(ObjPtr<mirror::Class> klass, size_t hash) {
   WriterMutexLock mu(Thread::Current(), lock_);
-  classes_.back().InsertWithHash(TableSlot(klass, hash), hash);
+  InsertLocked(TableSlot(klass, hash), hash);
 }
 
 bool ClassTable::Remove(const char* descriptor) {
@@ -189,7 +272,9 @@ bool ClassTable::Remove(const char* descriptor) {
   for (ClassSet& class_set : classes_) {
     auto it = class_set.Find(pair);
     if (it != class_set.end()) {
+      BeginWriteLocked();
       class_set.Erase(it);
+      EndWriteLocked();
       return true;
     }
   }
@@ -289,7 +374,10 @@ size_t ClassTable::ReadFromMemory(uint8_t* ptr) {
 
 void ClassTable::AddClassSet(ClassSet&& set) {
   WriterMutexLock mu(Thread::Current(), lock_);
+  BeginWriteLocked();
   classes_.insert(classes_.begin(), std::move(set));
+  PublishSnapshotLocked();
+  EndWriteLocked();
 }
 
 void ClassTable::ClearStrongRoots() {
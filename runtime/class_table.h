@@ -17,6 +17,7 @@
 #ifndef ART_RUNTIME_CLASS_TABLE_H_
 #define ART_RUNTIME_CLASS_TABLE_H_
 
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
@@ -192,6 +193,7 @@ class ClassTable {
       REQUIRES_SHARED(Locks::mutator_lock_);
 
   // Return the first class that matches the descriptor. Returns null if there are none.
+  // Does not take the lock unless a writer modifies the table concurrently.
   mirror::Class* Lookup(const char* descriptor, size_t hash)
       REQUIRES(!lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
@@ -207,6 +209,11 @@ class ClassTable {
       REQUIRES(!lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // TryInsert() with a precomputed hash of the descriptor.
+  ObjPtr<mirror::Class> TryInsertWithHash(ObjPtr<mirror::Class> klass, size_t hash)
+      REQUIRES(!lock_)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
   void Insert(ObjPtr<mirror::Class> klass)
       REQUIRES(!lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
@@ -261,10 +268,35 @@ class ClassTable {
   }
 
  private:
+  // The storage of a class set as seen by the lock-free lookups.
+  struct ClassSetView {
+    const TableSlot* data;
+    size_t num_buckets;
+  };
+  using Snapshot = std::vector<ClassSetView>;
+
   // Only copies classes.
   void CopyWithoutLocks(const ClassTable& source_table) NO_THREAD_SAFETY_ANALYSIS;
   void InsertWithoutLocks(ObjPtr<mirror::Class> klass) NO_THREAD_SAFETY_ANALYSIS;
 
+  // Probe the published snapshot without the lock. The result is only valid if `sequence_`
+  // did not change during the probe.
+  mirror::Class* LookupLockFree(const DescriptorHashPair& pair, size_t hash) const
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
+  // Insert into the latest class set. Never frees storage that lock-free lookups may read,
+  // growing the set moves the old storage to `retired_class_sets_`.
+  void InsertLocked(const TableSlot& slot, uint32_t hash)
+      REQUIRES(lock_)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
+  // Publish the storage of `classes_` for the lock-free lookups.
+  void PublishSnapshotLocked() REQUIRES(lock_);
+
+  // Bracket the modifications of the class sets for the lock-free lookups.
+  void BeginWriteLocked() REQUIRES(lock_);
+  void EndWriteLocked() REQUIRES(lock_);
+
   size_t CountDefiningLoaderClasses(ObjPtr<mirror::ClassLoader> defining_loader,
                                     const ClassSet& set) const
       REQUIRES(lock_)
@@ -279,6 +311,14 @@ class ClassTable {
   mutable ReaderWriterMutex lock_;
   // We have a vector to help prevent dirty pages after the zygote forks by calling FreezeSnapshot.
   std::vector<ClassSet> classes_ GUARDED_BY(lock_);
+  // Seqlock for the lock-free lookups, odd while the class sets are being modified.
+  Atomic<uint32_t> sequence_;
+  // The storage of `classes_` for the lock-free lookups. Lookups may still use older snapshots
+  // and storage, so these are kept until the table is destroyed. The storage grows
+  // geometrically, so the retired storage takes at most as much memory as the live storage.
+  Atomic<const Snapshot*> snapshot_;
+  std::vector<std::unique_ptr<Snapshot>> snapshots_ GUARDED_BY(lock_);
+  std::vector<ClassSet> retired_class_sets_ GUARDED_BY(lock_);
   // Extra strong roots that can be either dex files or dex caches. Dex files used by the class
   // loader which may not be owned by the class loader must be held strongly live. Also dex caches
   // are held live to prevent them being unloading once they have classes in them.
@@ -18,6 +18,7 @@
 
 #include "art_field-inl.h"
 #include "art_method-inl.h"
+#include "base/time_utils.h"
 #include "class_linker-inl.h"
 #include "common_runtime_test.h"
 #include "dex_file.h"
@@ -27,6 +28,7 @@
 #include "mirror/class-inl.h"
 #include "obj_ptr.h"
 #include "scoped_thread_state_change-inl.h"
+#include "thread_pool.h"
 
 namespace art {
 namespace mirror {
@@ -159,5 +161,74 @@ TEST_F(ClassTableTest, ClassTable) {
   // TODO: Add tests for UpdateClass, InsertOatFile.
 }
 
+class LookupClassTask : public Task {
+ public:
+  LookupClassTask(jobject class_loader,
+                  const char* descriptor,
+                  Class* expected,
+                  size_t iterations,
+                  AtomicInteger* mismatches)
+      : class_loader_(class_loader),
+        descriptor_(descriptor),
+        expected_(expected),
+        iterations_(iterations),
+        mismatches_(mismatches) {}
+
+  void Run(Thread* self) OVERRIDE {
+    ScopedObjectAccess soa(self);
+    ClassLinker* const class_linker = Runtime::Current()->GetClassLinker();
+    ObjPtr<ClassLoader> class_loader = soa.Decode<ClassLoader>(class_loader_);
+    const size_t hash = ComputeModifiedUtf8Hash(descriptor_);
+    for (size_t i = 0; i != iterations_; ++i) {
+      if (class_linker->LookupClass(self, descriptor_, hash, class_loader) != expected_) {
+        ++*mismatches_;
+      }
+    }
+  }
+
+  void Finalize() OVERRIDE {
+    delete this;
+  }
+
+ private:
+  const jobject class_loader_;
+  const char* const descriptor_;
+  Class* const expected_;  // The test does not run a moving GC.
+  const size_t iterations_;
+  AtomicInteger* const mismatches_;
+};
+
+TEST_F(ClassTableTest, ConcurrentLookup) {
+  Thread* self = Thread::Current();
+  jobject jclass_loader;
+  Class* klass;
+  {
+    ScopedObjectAccess soa(self);
+    jclass_loader = LoadDex("XandY");
+    StackHandleScope<1> hs(soa.Self());
+    Handle<ClassLoader> class_loader(hs.NewHandle(soa.Decode<ClassLoader>(jclass_loader)));
+    klass = class_linker_->FindClass(soa.Self(), "LX;", class_loader);
+    ASSERT_TRUE(klass != nullptr);
+  }
+  // Benchmark with `num_threads` threads looking up the same class, the worst case for
+  // cache line sharing.
+  static constexpr size_t kIterations = 1000000;
+  for (size_t num_threads : {1u, 2u, 4u, 8u}) {
+    AtomicInteger mismatches(0);
+    ThreadPool thread_pool("Class table test thread pool", num_threads);
+    for (size_t i = 0; i != num_threads; ++i) {
+      thread_pool.AddTask(
+          self, new LookupClassTask(jclass_loader, "LX;", klass, kIterations, &mismatches));
+    }
+    uint64_t start_time = NanoTime();
+    thread_pool.StartWorkers(self);
+    thread_pool.Wait(self, /* do_work */ false, /* may_hold_locks */ false);
+    uint64_t duration = NanoTime() - start_time;
+    EXPECT_EQ(mismatches.LoadRelaxed(), 0);
+    LOG(INFO) << num_threads << " threads, " << kIterations << " lookups each: "
+              << PrettyDuration(duration);
+  }
+}
+
 }  // namespace mirror
 }  // namespace art
@@ -487,6 +487,8 @@ static bool IsValidImplicitCheck(uintptr_t addr, ArtMethod* method, const Instru
     }
 
     case Instruction::IGET_OBJECT_QUICK:
+    case Instruction::IGET_OBJECT_QUICK_IF_EQZ:
+    case Instruction::IGET_OBJECT_QUICK_IF_NEZ:
       if (kEmitCompilerReadBarrier && IsValidReadBarrierImplicitCheck(addr)) {
         return true;
       }
@@ -616,7 +618,9 @@ void ThrowNullPointerExceptionFromDexPC(bool check_address, uintptr_t addr) {
     case Instruction::IGET_CHAR_QUICK:
     case Instruction::IGET_SHORT_QUICK:
     case Instruction::IGET_WIDE_QUICK:
-    case Instruction::IGET_OBJECT_QUICK: {
+    case Instruction::IGET_OBJECT_QUICK:
+    case Instruction::IGET_OBJECT_QUICK_IF_EQZ:
+    case Instruction::IGET_OBJECT_QUICK_IF_NEZ: {
       // Since we replaced the field index, we ask the verifier to tell us which
       // field is accessed at this location.
       ArtField* field =
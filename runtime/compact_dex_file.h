@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_COMPACT_DEX_FILE_H_
+#define ART_RUNTIME_COMPACT_DEX_FILE_H_
+
+#include "dex_file.h"
+
+namespace art {
+
+// Compact dex is an ART internal dex format written by dex2oat to the vdex. The header and the
+// id sections have the standard layout, but all the data items live in a data section shared by
+// the compact dex files of one vdex, and the offsets to data items are relative to it. Items with
+// the same encoding, e.g. the strings and type lists common to the dex files of a multidex APK,
+// are stored once.
+class CompactDexFile : public DexFile {
+ public:
+  static constexpr size_t kDexMagicSize = 4;
+  static constexpr uint8_t kDexMagic[kDexMagicSize] = { 'c', 'd', 'e', 'x' };
+  static constexpr uint8_t kDexMagicVersion[] = { '0', '0', '1', '\0' };
+
+  // Write the compact dex specific magic.
+  static void WriteMagic(uint8_t* magic);
+
+  // Write the current version, note that the input is the address of the magic.
+  static void WriteCurrentVersion(uint8_t* magic);
+
+  // Returns true if the byte string points to the magic value.
+  static bool IsMagicValid(const uint8_t* magic);
+
+  // Returns true if the byte string after the magic is the correct value.
+  static bool IsVersionValid(const uint8_t* magic);
+
+ private:
+  CompactDexFile(const uint8_t* base,
+                 size_t size,
+                 const uint8_t* data_base,
+                 size_t data_size,
+                 const std::string& location,
+                 uint32_t location_checksum,
+                 const OatDexFile* oat_dex_file)
+      : DexFile(base,
+                size,
+                data_base,
+                data_size,
+                location,
+                location_checksum,
+                oat_dex_file,
+                /* is_compact_dex */ true) {}
+
+  friend class DexFile;
+
+  DISALLOW_COPY_AND_ASSIGN(CompactDexFile);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_COMPACT_DEX_FILE_H_
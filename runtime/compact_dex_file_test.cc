@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "compact_dex_file.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "common_runtime_test.h"
+#include "dex_file-inl.h"
+
+namespace art {
+
+class CompactDexFileTest : public CommonRuntimeTest {};
+
+TEST_F(CompactDexFileTest, MagicAndVersion) {
+  // Test permutations of valid/invalid headers.
+  for (size_t i = 0; i < 2; ++i) {
+    for (size_t j = 0; j < 2; ++j) {
+      static constexpr size_t kLength =
+          CompactDexFile::kDexMagicSize + sizeof(CompactDexFile::kDexMagicVersion);
+      uint8_t header[kLength];
+      std::fill_n(header, kLength, 0x99);
+      const bool valid_magic = (i & 1) == 0;
+      const bool valid_version = (j & 1) == 0;
+      if (valid_magic) {
+        CompactDexFile::WriteMagic(header);
+      }
+      if (valid_version) {
+        CompactDexFile::WriteCurrentVersion(header);
+      }
+      EXPECT_EQ(valid_magic, CompactDexFile::IsMagicValid(header));
+      EXPECT_EQ(valid_version, CompactDexFile::IsVersionValid(header));
+      EXPECT_FALSE(DexFile::IsMagicValid(header));
+    }
+  }
+}
+
+TEST_F(CompactDexFileTest, OpenWithDataSection) {
+  std::unique_ptr<const DexFile> dex(OpenTestDexFile("Nested"));
+  ASSERT_TRUE(dex != nullptr);
+
+  // A compact dex file whose data section is a copy of the standard one, so that the data
+  // offsets are unchanged but the data is only reachable through the data section.
+  std::vector<uint8_t> main_section(dex->Begin(), dex->Begin() + dex->Size());
+  std::vector<uint8_t> data_section(main_section);
+  CompactDexFile::WriteMagic(main_section.data());
+  CompactDexFile::WriteCurrentVersion(main_section.data());
+
+  std::string error_msg;
+  std::unique_ptr<const DexFile> compact_dex(DexFile::Open(main_section.data(),
+                                                           main_section.size(),
+                                                           data_section.data(),
+                                                           data_section.size(),
+                                                           "compact",
+                                                           dex->GetLocationChecksum(),
+                                                           /* oat_dex_file */ nullptr,
+                                                           /* verify */ false,
+                                                           /* verify_checksum */ false,
+                                                           &error_msg));
+  ASSERT_TRUE(compact_dex != nullptr) << error_msg;
+  EXPECT_TRUE(compact_dex->IsCompactDexFile());
+  EXPECT_FALSE(dex->IsCompactDexFile());
+  EXPECT_EQ(DexFile::kMaxDexVersion, compact_dex->GetVersion());
+  EXPECT_EQ(data_section.data(), compact_dex->DataBegin());
+  ASSERT_EQ(dex->NumStringIds(), compact_dex->NumStringIds());
+  for (size_t i = 0; i < dex->NumStringIds(); ++i) {
+    dex::StringIndex string_idx(i);
+    const char* data = compact_dex->StringDataByIdx(string_idx);
+    EXPECT_GE(reinterpret_cast<const uint8_t*>(data), data_section.data());
+    EXPECT_LT(reinterpret_cast<const uint8_t*>(data), data_section.data() + data_section.size());
+    EXPECT_STREQ(dex->StringDataByIdx(string_idx), data);
+  }
+  ASSERT_EQ(dex->NumClassDefs(), compact_dex->NumClassDefs());
+  for (size_t i = 0; i < dex->NumClassDefs(); ++i) {
+    const uint8_t* class_data = dex->GetClassData(dex->GetClassDef(i));
+    const uint8_t* compact_class_data = compact_dex->GetClassData(compact_dex->GetClassDef(i));
+    if (class_data == nullptr) {
+      EXPECT_TRUE(compact_class_data == nullptr);
+    } else {
+      EXPECT_EQ(data_section.data() + (class_data - dex->Begin()), compact_class_data);
+    }
+  }
+
+  // The data section is required, and the verifier only supports standard dex files.
+  EXPECT_TRUE(DexFile::Open(main_section.data(),
+                            main_section.size(),
+                            "compact",
+                            dex->GetLocationChecksum(),
+                            /* oat_dex_file */ nullptr,
+                            /* verify */ false,
+                            /* verify_checksum */ false,
+                            &error_msg) == nullptr);
+  EXPECT_TRUE(DexFile::Open(main_section.data(),
+                            main_section.size(),
+                            data_section.data(),
+                            data_section.size(),
+                            "compact",
+                            dex->GetLocationChecksum(),
+                            /* oat_dex_file */ nullptr,
+                            /* verify */ true,
+                            /* verify_checksum */ false,
+                            &error_msg) == nullptr);
+}
+
+}  // namespace art
@@ -2916,6 +2916,12 @@ void Dbg::PostLocationEvent(ArtMethod* m, int dex_pc, mirror::Object* this_objec
   }
 }
 
+void Dbg::ClearMethodEventFilter() {
+  if (gJdwpState != nullptr) {
+    gJdwpState->ClearMethodEventFilter();
+  }
+}
+
 void Dbg::PostFieldAccessEvent(ArtMethod* m, int dex_pc,
                                mirror::Object* this_object, ArtField* f) {
   // TODO We should send events for native methods.
@@ -3126,6 +3132,10 @@ void Dbg::UpdateDebugger(Thread* thread, mirror::Object* this_object,
     }
   }
 
+  // Drop the method events that the modifiers of the registered events rule out for this method
+  // before paying for building the event location.
+  event_flags = gJdwpState->FilterMethodEventFlags(m, event_flags);
+
   // If there's something interesting going on, see if it matches one
   // of the debugger filters.
   if (event_flags != 0) {
@@ -515,6 +515,10 @@ class Dbg {
                              int event_flags, const JValue* return_value)
       REQUIRES(!Locks::breakpoint_lock_) REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Forgets which methods the registered method entry and exit events can match, because the
+  // class loader of some of the methods is being freed.
+  static void ClearMethodEventFilter();
+
   // Indicates whether we need deoptimization for debugging.
   static bool RequiresDeoptimization();
 
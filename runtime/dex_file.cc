@@ -38,6 +38,7 @@
 #include "base/stl_util.h"
 #include "base/systrace.h"
 #include "base/unix_file/fd_file.h"
+#include "compact_dex_file.h"
 #include "dex_file-inl.h"
 #include "dex_file_verifier.h"
 #include "jvalue.h"
@@ -172,6 +173,31 @@ std::unique_ptr<const DexFile> DexFile::Open(const uint8_t* base,
   ScopedTrace trace(std::string("Open dex file from RAM ") + location);
   return OpenCommon(base,
                     size,
+                    /* data_base */ nullptr,
+                    /* data_size */ 0u,
+                    location,
+                    location_checksum,
+                    oat_dex_file,
+                    verify,
+                    verify_checksum,
+                    error_msg);
+}
+
+std::unique_ptr<const DexFile> DexFile::Open(const uint8_t* base,
+                                             size_t size,
+                                             const uint8_t* data_base,
+                                             size_t data_size,
+                                             const std::string& location,
+                                             uint32_t location_checksum,
+                                             const OatDexFile* oat_dex_file,
+                                             bool verify,
+                                             bool verify_checksum,
+                                             std::string* error_msg) {
+  ScopedTrace trace(std::string("Open dex file from RAM ") + location);
+  return OpenCommon(base,
+                    size,
+                    data_base,
+                    data_size,
                     location,
                     location_checksum,
                     oat_dex_file,
@@ -198,6 +224,8 @@ std::unique_ptr<const DexFile> DexFile::Open(const std::string& location,
 
   std::unique_ptr<DexFile> dex_file = OpenCommon(map->Begin(),
                                                  map->Size(),
+                                                 /* data_base */ nullptr,
+                                                 /* data_size */ 0u,
                                                  location,
                                                  location_checksum,
                                                  kNoOatDexFile,
@@ -317,6 +345,8 @@ std::unique_ptr<const DexFile> DexFile::OpenFile(int fd,
 
   std::unique_ptr<DexFile> dex_file = OpenCommon(map->Begin(),
                                                  map->Size(),
+                                                 /* data_base */ nullptr,
+                                                 /* data_size */ 0u,
                                                  location,
                                                  dex_header->checksum_,
                                                  kNoOatDexFile,
@@ -383,6 +413,8 @@ std::unique_ptr<const DexFile> DexFile::OpenOneDexFileFromZip(const ZipArchive&
   VerifyResult verify_result;
   std::unique_ptr<DexFile> dex_file = OpenCommon(map->Begin(),
                                                  map->Size(),
+                                                 /* data_base */ nullptr,
+                                                 /* data_size */ 0u,
                                                  location,
                                                  zip_entry->GetCrc32(),
                                                  kNoOatDexFile,
@@ -480,6 +512,8 @@ bool DexFile::OpenAllDexFilesFromZip(const ZipArchive& zip_archive,
 
 std::unique_ptr<DexFile> DexFile::OpenCommon(const uint8_t* base,
                                              size_t size,
+                                             const uint8_t* data_base,
+                                             size_t data_size,
                                              const std::string& location,
                                              uint32_t location_checksum,
                                              const OatDexFile* oat_dex_file,
@@ -490,11 +524,29 @@ std::unique_ptr<DexFile> DexFile::OpenCommon(const uint8_t* base,
   if (verify_result != nullptr) {
     *verify_result = VerifyResult::kVerifyNotAttempted;
   }
-  std::unique_ptr<DexFile> dex_file(new DexFile(base,
-                                                size,
-                                                location,
-                                                location_checksum,
-                                                oat_dex_file));
+  std::unique_ptr<DexFile> dex_file;
+  if (CompactDexFile::IsMagicValid(base)) {
+    if (data_base == nullptr) {
+      *error_msg = StringPrintf("Compact dex file '%s' opened without its data section",
+                                location.c_str());
+      return nullptr;
+    }
+    if (verify) {
+      // Compact dex files are created by dex2oat from verified dex files, the verifier only
+      // handles the standard format.
+      *error_msg = StringPrintf("Cannot verify compact dex file '%s'", location.c_str());
+      return nullptr;
+    }
+    dex_file.reset(new CompactDexFile(base,
+                                      size,
+                                      data_base,
+                                      data_size,
+                                      location,
+                                      location_checksum,
+                                      oat_dex_file));
+  } else {
+    dex_file.reset(new DexFile(base, size, location, location_checksum, oat_dex_file));
+  }
   if (dex_file == nullptr) {
     *error_msg = StringPrintf("Failed to open dex file '%s' from memory: %s", location.c_str(),
                               error_msg->c_str());
@@ -526,8 +578,27 @@ DexFile::DexFile(const uint8_t* base,
                  const std::string& location,
                  uint32_t location_checksum,
                  const OatDexFile* oat_dex_file)
+    : DexFile(base,
+              size,
+              base,
+              size,
+              location,
+              location_checksum,
+              oat_dex_file,
+              /* is_compact_dex */ false) {}
+
+DexFile::DexFile(const uint8_t* base,
+                 size_t size,
+                 const uint8_t* data_base,
+                 size_t data_size,
+                 const std::string& location,
+                 uint32_t location_checksum,
+                 const OatDexFile* oat_dex_file,
+                 bool is_compact_dex)
     : begin_(base),
       size_(size),
+      data_begin_(data_base),
+      data_size_(data_size),
       location_(location),
       location_checksum_(location_checksum),
       header_(reinterpret_cast<const Header*>(base)),
@@ -541,7 +612,8 @@ DexFile::DexFile(const uint8_t* base,
       num_method_handles_(0),
       call_site_ids_(nullptr),
       num_call_site_ids_(0),
-      oat_dex_file_(oat_dex_file) {
+      oat_dex_file_(oat_dex_file),
+      is_compact_dex_(is_compact_dex) {
   CHECK(begin_ != nullptr) << GetLocation();
   CHECK_GT(size_, 0U) << GetLocation();
   // Check base (=header) alignment.
@@ -567,7 +639,10 @@ bool DexFile::Init(std::string* error_msg) {
 }
 
 bool DexFile::CheckMagicAndVersion(std::string* error_msg) const {
-  if (!IsMagicValid(header_->magic_)) {
+  bool magic_valid = is_compact_dex_
+      ? CompactDexFile::IsMagicValid(header_->magic_)
+      : IsMagicValid(header_->magic_);
+  if (!magic_valid) {
     std::ostringstream oss;
     oss << "Unrecognized magic number in "  << GetLocation() << ":"
             << " " << header_->magic_[0]
@@ -577,7 +652,10 @@ bool DexFile::CheckMagicAndVersion(std::string* error_msg) const {
     *error_msg = oss.str();
     return false;
   }
-  if (!IsVersionValid(header_->magic_)) {
+  bool version_valid = is_compact_dex_
+      ? CompactDexFile::IsVersionValid(header_->magic_)
+      : IsVersionValid(header_->magic_);
+  if (!version_valid) {
     std::ostringstream oss;
     oss << "Unrecognized version number in "  << GetLocation() << ":"
             << " " << header_->magic_[4]
@@ -1414,15 +1492,19 @@ std::ostream& operator<<(std::ostream& os, const Signature& sig) {
 // Decodes the header section from the class data bytes.
 void ClassDataItemIterator::ReadClassDataHeader() {
   CHECK(ptr_pos_ != nullptr);
-  header_.static_fields_size_ = DecodeUnsignedLeb128(&ptr_pos_);
-  header_.instance_fields_size_ = DecodeUnsignedLeb128(&ptr_pos_);
-  header_.direct_methods_size_ = DecodeUnsignedLeb128(&ptr_pos_);
-  header_.virtual_methods_size_ = DecodeUnsignedLeb128(&ptr_pos_);
+  uint32_t values[4];
+  DecodeUnsignedLeb128s(&ptr_pos_, DataEnd(), values, arraysize(values));
+  header_.static_fields_size_ = values[0];
+  header_.instance_fields_size_ = values[1];
+  header_.direct_methods_size_ = values[2];
+  header_.virtual_methods_size_ = values[3];
 }
 
 void ClassDataItemIterator::ReadClassDataField() {
-  field_.field_idx_delta_ = DecodeUnsignedLeb128(&ptr_pos_);
-  field_.access_flags_ = DecodeUnsignedLeb128(&ptr_pos_);
+  uint32_t values[2];
+  DecodeUnsignedLeb128s(&ptr_pos_, DataEnd(), values, arraysize(values));
+  field_.field_idx_delta_ = values[0];
+  field_.access_flags_ = values[1];
   // The user of the iterator is responsible for checking if there
   // are unordered or duplicate indexes.
 }
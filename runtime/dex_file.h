@@ -44,6 +44,9 @@ class DexFile {
   // First Dex format version enforcing class definition ordering rules.
   static const uint32_t kClassDefinitionOrderEnforcedVersion = 37;
 
+  // Latest supported Dex format version.
+  static const uint32_t kMaxDexVersion = 38;
+
   static const uint8_t kDexMagic[];
   static constexpr size_t kNumDexVersions = 3;
   static constexpr size_t kDexVersionLen = 4;
@@ -448,6 +451,20 @@ class DexFile {
                                              bool verify_checksum,
                                              std::string* error_msg);
 
+  // Opens .dex or compact dex file, backed by existing memory. The data items of a compact dex
+  // file are in the data section it shares with the other compact dex files of its container,
+  // at [data_base, data_base + data_size).
+  static std::unique_ptr<const DexFile> Open(const uint8_t* base,
+                                             size_t size,
+                                             const uint8_t* data_base,
+                                             size_t data_size,
+                                             const std::string& location,
+                                             uint32_t location_checksum,
+                                             const OatDexFile* oat_dex_file,
+                                             bool verify,
+                                             bool verify_checksum,
+                                             std::string* error_msg);
+
   // Opens .dex file that has been memory-mapped by the caller.
   static std::unique_ptr<const DexFile> Open(const std::string& location,
                                              uint32_t location_checkum,
@@ -526,9 +543,15 @@ class DexFile {
     return *header_;
   }
 
-  // Decode the dex magic version
+  // Decode the dex magic version. Compact dex files are only created from verified dex files
+  // and support the features of all the dex versions.
   uint32_t GetVersion() const {
-    return GetHeader().GetVersion();
+    return IsCompactDexFile() ? kMaxDexVersion : GetHeader().GetVersion();
+  }
+
+  // Returns true if this is a compact dex file, see CompactDexFile.
+  bool IsCompactDexFile() const {
+    return is_compact_dex_;
   }
 
   // Returns true if the byte string points to the magic value.
@@ -727,7 +750,7 @@ class DexFile {
     if (class_def.interfaces_off_ == 0) {
         return nullptr;
     } else {
-      const uint8_t* addr = begin_ + class_def.interfaces_off_;
+      const uint8_t* addr = data_begin_ + class_def.interfaces_off_;
       return reinterpret_cast<const TypeList*>(addr);
     }
   }
@@ -755,17 +778,17 @@ class DexFile {
     if (class_def.class_data_off_ == 0) {
       return nullptr;
     } else {
-      return begin_ + class_def.class_data_off_;
+      return data_begin_ + class_def.class_data_off_;
     }
   }
 
   //
   const CodeItem* GetCodeItem(const uint32_t code_off) const {
-    DCHECK_LT(code_off, size_) << "Code item offset larger then maximum allowed offset";
+    DCHECK_LT(code_off, data_size_) << "Code item offset larger then maximum allowed offset";
     if (code_off == 0) {
       return nullptr;  // native or abstract method
     } else {
-      const uint8_t* addr = begin_ + code_off;
+      const uint8_t* addr = data_begin_ + code_off;
       return reinterpret_cast<const CodeItem*>(addr);
     }
   }
@@ -815,7 +838,7 @@ class DexFile {
     if (proto_id.parameters_off_ == 0) {
       return nullptr;
     } else {
-      const uint8_t* addr = begin_ + proto_id.parameters_off_;
+      const uint8_t* addr = data_begin_ + proto_id.parameters_off_;
       return reinterpret_cast<const TypeList*>(addr);
     }
   }
@@ -824,12 +847,12 @@ class DexFile {
     if (class_def.static_values_off_ == 0) {
       return 0;
     } else {
-      return begin_ + class_def.static_values_off_;
+      return data_begin_ + class_def.static_values_off_;
     }
   }
 
   const uint8_t* GetCallSiteEncodedValuesArray(const CallSiteIdItem& call_site_id) const {
-    return begin_ + call_site_id.data_off_;
+    return data_begin_ + call_site_id.data_off_;
   }
 
   static const TryItem* GetTryItems(const CodeItem& code_item, uint32_t offset);
@@ -852,10 +875,10 @@ class DexFile {
     // Check that the offset is in bounds.
     // Note that although the specification says that 0 should be used if there
     // is no debug information, some applications incorrectly use 0xFFFFFFFF.
-    if (code_item->debug_info_off_ == 0 || code_item->debug_info_off_ >= size_) {
+    if (code_item->debug_info_off_ == 0 || code_item->debug_info_off_ >= data_size_) {
       return nullptr;
     } else {
-      return begin_ + code_item->debug_info_off_;
+      return data_begin_ + code_item->debug_info_off_;
     }
   }
 
@@ -908,7 +931,8 @@ class DexFile {
     if (class_def.annotations_off_ == 0) {
       return nullptr;
     } else {
-      return reinterpret_cast<const AnnotationsDirectoryItem*>(begin_ + class_def.annotations_off_);
+      return reinterpret_cast<const AnnotationsDirectoryItem*>(
+          data_begin_ + class_def.annotations_off_);
     }
   }
 
@@ -916,7 +940,8 @@ class DexFile {
     if (anno_dir->class_annotations_off_ == 0) {
       return nullptr;
     } else {
-      return reinterpret_cast<const AnnotationSetItem*>(begin_ + anno_dir->class_annotations_off_);
+      return reinterpret_cast<const AnnotationSetItem*>(
+          data_begin_ + anno_dir->class_annotations_off_);
     }
   }
 
@@ -958,7 +983,7 @@ class DexFile {
     if (offset == 0) {
       return nullptr;
     } else {
-      return reinterpret_cast<const AnnotationSetItem*>(begin_ + offset);
+      return reinterpret_cast<const AnnotationSetItem*>(data_begin_ + offset);
     }
   }
 
@@ -968,7 +993,7 @@ class DexFile {
     if (offset == 0) {
       return nullptr;
     } else {
-      return reinterpret_cast<const AnnotationSetItem*>(begin_ + offset);
+      return reinterpret_cast<const AnnotationSetItem*>(data_begin_ + offset);
     }
   }
 
@@ -978,7 +1003,7 @@ class DexFile {
     if (offset == 0) {
       return nullptr;
     }
-    return reinterpret_cast<const AnnotationSetRefList*>(begin_ + offset);
+    return reinterpret_cast<const AnnotationSetRefList*>(data_begin_ + offset);
   }
 
   const AnnotationItem* GetAnnotationItem(const AnnotationSetItem* set_item, uint32_t index) const {
@@ -987,7 +1012,7 @@ class DexFile {
     if (offset == 0) {
       return nullptr;
     } else {
-      return reinterpret_cast<const AnnotationItem*>(begin_ + offset);
+      return reinterpret_cast<const AnnotationItem*>(data_begin_ + offset);
     }
   }
 
@@ -996,7 +1021,7 @@ class DexFile {
     if (offset == 0) {
       return nullptr;
     }
-    return reinterpret_cast<const AnnotationSetItem*>(begin_ + offset);
+    return reinterpret_cast<const AnnotationSetItem*>(data_begin_ + offset);
   }
 
   // Debug info opcodes and constants
@@ -1057,6 +1082,16 @@ class DexFile {
     return size_;
   }
 
+  // Returns the base of the data items, i.e. what the offsets of the data items are relative to.
+  // This is the dex file itself unless it is a compact dex file.
+  const uint8_t* DataBegin() const {
+    return data_begin_;
+  }
+
+  size_t DataSize() const {
+    return data_size_;
+  }
+
   // Return the name of the index-th classes.dex in a multidex zip file. This is classes.dex for
   // index == 0, and classes{index + 1}.dex else.
   static std::string GetMultiDexClassesDexName(size_t index);
@@ -1143,8 +1178,11 @@ class DexFile {
     kVerifyFailed
   };
 
+  // A null `data_base` means that the data items are in the dex file.
   static std::unique_ptr<DexFile> OpenCommon(const uint8_t* base,
                                              size_t size,
+                                             const uint8_t* data_base,
+                                             size_t data_size,
                                              const std::string& location,
                                              uint32_t location_checksum,
                                              const OatDexFile* oat_dex_file,
@@ -1169,6 +1207,18 @@ class DexFile {
           uint32_t location_checksum,
           const OatDexFile* oat_dex_file);
 
+ protected:
+  DexFile(const uint8_t* base,
+          size_t size,
+          const uint8_t* data_base,
+          size_t data_size,
+          const std::string& location,
+          uint32_t location_checksum,
+          const OatDexFile* oat_dex_file,
+          bool is_compact_dex);
+
+ private:
+
   // Top-level initializer that calls other Init methods.
   bool Init(std::string* error_msg);
 
@@ -1184,6 +1234,10 @@ class DexFile {
   // The size of the underlying memory allocation in bytes.
   const size_t size_;
 
+  // The base address and size of the data items, see DataBegin().
+  const uint8_t* const data_begin_;
+  const size_t data_size_;
+
   // Typically the dex file name when available, alternatively some identifying string.
   //
   // The ClassLinker will use this to match DexFiles the boot class
@@ -1233,6 +1287,8 @@ class DexFile {
   // null.
   mutable const OatDexFile* oat_dex_file_;
 
+  const bool is_compact_dex_;
+
   friend class DexFileVerifierTest;
   friend class OatWriter;
   ART_FRIEND_TEST(ClassLinkerTest, RegisterDexFileName);  // for constructor
@@ -1472,6 +1528,11 @@ class ClassDataItemIterator {
   // Read and decode header from a class_data_item stream into header
   void ReadClassDataHeader();
 
+  // The class_data_item is in the dex file, the data up to its end can be read ahead.
+  const uint8_t* DataEnd() const {
+    return dex_file_.Begin() + dex_file_.Size();
+  }
+
   uint32_t EndOfStaticFieldsPos() const {
     return header_.static_fields_size_;
   }
@@ -239,7 +239,7 @@ void DexFileTrackingRegistrar::SetCodeItemRegistration(const char* class_name, b
 void DexFileTrackingRegistrar::SetAllStringDataStartRegistration(bool should_poison) {
   for (size_t stringid_ctr = 0; stringid_ctr < dex_file_->NumStringIds(); ++stringid_ctr) {
     const DexFile::StringId & string_id = dex_file_->GetStringId(StringIndex(stringid_ctr));
-    const void* string_data_begin = reinterpret_cast<const void*>(dex_file_->Begin() + string_id.string_data_off_);
+    const void* string_data_begin = reinterpret_cast<const void*>(dex_file_->DataBegin() + string_id.string_data_off_);
     // Data Section of String Data Item
     const void* string_data_data_begin = reinterpret_cast<const void*>(dex_file_->GetStringData(string_id));
     range_values_.push_back(std::make_tuple(string_data_begin, 1, should_poison));
@@ -254,7 +254,7 @@ void DexFileTrackingRegistrar::SetAllStringDataRegistration(bool should_poison)
     const DexFile::MapItem& map_item = map_list->list_[map_ctr];
     if (map_item.type_ == DexFile::kDexTypeStringDataItem) {
       const DexFile::MapItem& next_map_item = map_list->list_[map_ctr + 1];
-      const void* string_data_begin = reinterpret_cast<const void*>(dex_file_->Begin() + map_item.offset_);
+      const void* string_data_begin = reinterpret_cast<const void*>(dex_file_->DataBegin() + map_item.offset_);
       size_t string_data_size = next_map_item.offset_ - map_item.offset_;
       range_values_.push_back(std::make_tuple(string_data_begin, string_data_size, should_poison));
     }
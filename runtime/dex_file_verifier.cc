@@ -20,6 +20,7 @@
 
 #include <limits>
 #include <memory>
+#include <mutex>
 
 #include "android-base/stringprintf.h"
 
@@ -223,18 +224,46 @@ const DexFile::ProtoId* DexFileVerifier::CheckLoadProtoId(uint32_t idx, const ch
     error_stmt;                                               \
   }
 
+std::mutex DexFileVerifier::verified_dex_files_lock_;
+std::set<DexFileVerifier::VerifiedDexFileKey> DexFileVerifier::verified_dex_files_;
+
 bool DexFileVerifier::Verify(const DexFile* dex_file,
                              const uint8_t* begin,
                              size_t size,
                              const char* location,
                              bool verify_checksum,
                              std::string* error_msg) {
+  // The same dex file is often verified several times in a process, e.g. when it is loaded by
+  // more than one class loader. The checksum is recomputed and compared with the one recorded,
+  // so modified contents get verified again.
+  bool use_cache = (begin == dex_file->Begin()) && (size == dex_file->Size());
+  VerifiedDexFileKey key;
+  if (use_cache) {
+    const DexFile::Header& header = dex_file->GetHeader();
+    uint32_t checksum = dex_file->CalculateChecksum();
+    // The checksum does not cover the magic, which holds the version.
+    std::string magic_and_signature(reinterpret_cast<const char*>(header.magic_),
+                                    sizeof(header.magic_));
+    magic_and_signature.append(reinterpret_cast<const char*>(header.signature_),
+                               DexFile::kSha1DigestSize);
+    key = std::make_tuple(size, checksum, std::move(magic_and_signature));
+    if (!verify_checksum || checksum == header.checksum_) {
+      std::lock_guard<std::mutex> mu(verified_dex_files_lock_);
+      if (verified_dex_files_.find(key) != verified_dex_files_.end()) {
+        return true;
+      }
+    }
+  }
   std::unique_ptr<DexFileVerifier> verifier(
       new DexFileVerifier(dex_file, begin, size, location, verify_checksum));
   if (!verifier->Verify()) {
     *error_msg = verifier->FailureReason();
     return false;
   }
+  if (use_cache) {
+    std::lock_guard<std::mutex> mu(verified_dex_files_lock_);
+    verified_dex_files_.insert(key);
+  }
   return true;
 }
 
@@ -17,6 +17,10 @@
 #ifndef ART_RUNTIME_DEX_FILE_VERIFIER_H_
 #define ART_RUNTIME_DEX_FILE_VERIFIER_H_
 
+#include <mutex>
+#include <set>
+#include <string>
+#include <tuple>
 #include <unordered_set>
 
 #include "base/allocator.h"
@@ -58,6 +62,9 @@ class DexFileVerifier {
 
   bool Verify();
 
+  // A dex file that passed verification: size, checksum of the contents, magic and signature.
+  using VerifiedDexFileKey = std::tuple<size_t, uint32_t, std::string>;
+
   bool CheckShortyDescriptorMatch(char shorty_char, const char* descriptor, bool is_return_type);
   bool CheckListSize(const void* start, size_t count, size_t element_size, const char* label);
   // Check a list. The head is assumed to be at *ptr, and elements to be of size element_size. If
@@ -250,6 +257,11 @@ class DexFileVerifier {
 
   // Set of type ids for which there are ClassDef elements in the dex file.
   std::unordered_set<decltype(DexFile::ClassDef::class_idx_)> defined_classes_;
+
+  // The dex files verified successfully in this process. A std::mutex rather than a Mutex since
+  // dex files are also verified by tools that do not create a runtime.
+  static std::mutex verified_dex_files_lock_;
+  static std::set<VerifiedDexFileKey> verified_dex_files_;
 };
 
 }  // namespace art
@@ -1670,6 +1670,35 @@ TEST_F(DexFileVerifierTest, Checksum) {
   EXPECT_NE(error_msg.find("Bad checksum"), std::string::npos) << error_msg;
 }
 
+TEST_F(DexFileVerifierTest, VerifiedDexFilesCache) {
+  size_t length;
+  std::unique_ptr<uint8_t[]> dex_bytes(DecodeBase64(kGoodTestDex, &length));
+  CHECK(dex_bytes != nullptr);
+  // Note: `dex_file` will be destroyed before `dex_bytes`.
+  std::unique_ptr<DexFile> dex_file(GetDexFile(dex_bytes.get(), length));
+  std::string error_msg;
+  for (size_t i = 0; i != 2u; ++i) {
+    EXPECT_TRUE(DexFileVerifier::Verify(dex_file.get(),
+                                        dex_file->Begin(),
+                                        dex_file->Size(),
+                                        "good",
+                                        /*verify_checksum*/ true,
+                                        &error_msg)) << error_msg;
+  }
+
+  // Modified contents are verified again, even with a matching checksum.
+  DexFile::Header* header = reinterpret_cast<DexFile::Header*>(
+      const_cast<uint8_t*>(dex_file->Begin()));
+  header->string_ids_size_ = 0u;
+  FixUpChecksum(const_cast<uint8_t*>(dex_file->Begin()));
+  EXPECT_FALSE(DexFileVerifier::Verify(dex_file.get(),
+                                       dex_file->Begin(),
+                                       dex_file->Size(),
+                                       "modified",
+                                       /*verify_checksum*/ true,
+                                       &error_msg));
+}
+
 TEST_F(DexFileVerifierTest, BadStaticMethodName) {
   // Generated DEX file version (037) from:
   //
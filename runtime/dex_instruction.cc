@@ -263,6 +263,8 @@ std::string Instruction::DumpString(const DexFile* file) const {
           FALLTHROUGH_INTENDED;
         case IGET_QUICK:
         case IGET_OBJECT_QUICK:
+        case IGET_OBJECT_QUICK_IF_EQZ:
+        case IGET_OBJECT_QUICK_IF_NEZ:
           if (file != nullptr) {
             uint32_t field_idx = VRegC_22c();
             os << opcode << " v" << static_cast<int>(VRegA_22c()) << ", v" << static_cast<int>(VRegB_22c()) << ", "
@@ -117,6 +117,8 @@ bool DexDecompiler::Decompile() {
         break;
 
       case Instruction::IGET_OBJECT_QUICK:
+      case Instruction::IGET_OBJECT_QUICK_IF_EQZ:
+      case Instruction::IGET_OBJECT_QUICK_IF_NEZ:
         DecompileInstanceFieldAccess(inst, Instruction::IGET_OBJECT);
         break;
 
@@ -122,6 +122,7 @@ extern "C" mirror::String* artAllocStringFromStringFromCode##suffix##suffix2( /*
 
 GENERATE_ENTRYPOINTS_FOR_ALLOCATOR(DlMalloc, gc::kAllocatorTypeDlMalloc)
 GENERATE_ENTRYPOINTS_FOR_ALLOCATOR(RosAlloc, gc::kAllocatorTypeRosAlloc)
+GENERATE_ENTRYPOINTS_FOR_ALLOCATOR(RosAllocPerCpu, gc::kAllocatorTypeRosAllocPerCpu)
 GENERATE_ENTRYPOINTS_FOR_ALLOCATOR(BumpPointer, gc::kAllocatorTypeBumpPointer)
 GENERATE_ENTRYPOINTS_FOR_ALLOCATOR(TLAB, gc::kAllocatorTypeTLAB)
 GENERATE_ENTRYPOINTS_FOR_ALLOCATOR(Region, gc::kAllocatorTypeRegion)
@@ -182,6 +183,7 @@ void SetQuickAllocEntryPoints##suffix(QuickEntryPoints* qpoints, bool instrument
 #if !defined(__APPLE__) || !defined(__LP64__)
 GENERATE_ENTRYPOINTS(_dlmalloc)
 GENERATE_ENTRYPOINTS(_rosalloc)
+GENERATE_ENTRYPOINTS(_rosalloc_per_cpu)
 GENERATE_ENTRYPOINTS(_bump_pointer)
 GENERATE_ENTRYPOINTS(_tlab)
 GENERATE_ENTRYPOINTS(_region)
@@ -210,6 +212,10 @@ void ResetQuickAllocEntryPoints(QuickEntryPoints* qpoints, bool is_marking) {
       SetQuickAllocEntryPoints_rosalloc(qpoints, entry_points_instrumented);
       return;
     }
+    case gc::kAllocatorTypeRosAllocPerCpu: {
+      SetQuickAllocEntryPoints_rosalloc_per_cpu(qpoints, entry_points_instrumented);
+      return;
+    }
     case gc::kAllocatorTypeBumpPointer: {
       CHECK(kMovingCollector);
       SetQuickAllocEntryPoints_bump_pointer(qpoints, entry_points_instrumented);
@@ -29,6 +29,7 @@
 #include "imtable-inl.h"
 #include "interpreter/interpreter.h"
 #include "instrumentation.h"
+#include "jit/jit.h"
 #include "linear_alloc.h"
 #include "method_bss_mapping.h"
 #include "method_handles.h"
@@ -2194,11 +2195,18 @@ extern "C" TwoWordReturn artQuickGenericJniTrampoline(Thread* self, ArtMethod**
     visitor.FinalizeHandleScope(self);
   }
 
-  // Fix up managed-stack things in Thread.
-  self->SetTopOfStack(sp);
+  // Fix up managed-stack things in Thread. The frame is tagged so that stack walks do not
+  // mistake it for the frame of a compiled JNI stub, see ManagedStack::SetTopQuickFrameTagged().
+  self->SetTopOfStackTagged(sp);
 
   self->VerifyStack();
 
+  // Count the call towards compiling a JNI stub for the method.
+  jit::Jit* jit = Runtime::Current()->GetJit();
+  if (jit != nullptr) {
+    jit->AddSamples(self, called, 1u, /* with_backedges */ false);
+  }
+
   uint32_t cookie;
   uint32_t* sp32;
   // Skip calling JniMethodStart for @CriticalNative.
@@ -44,6 +44,11 @@ static bool art_fault_handler(int sig, siginfo_t* info, void* context) {
   return fault_manager.HandleFault(sig, info, context);
 }
 
+// Signal handler called on SIGSEGV before art_fault_handler, with all signals blocked.
+static bool art_fault_fast_handler(int sig, siginfo_t* info, void* context) {
+  return fault_manager.HandleFaultFast(sig, info, context);
+}
+
 #if defined(__linux__)
 
 // Change to verify the safe implementations against the original ones.
@@ -122,6 +127,10 @@ static bool SafeVerifyClassClass(mirror::Class* cls) REQUIRES_SHARED(Locks::muta
 
 FaultManager::FaultManager() : initialized_(false) {
   sigaction(SIGSEGV, nullptr, &oldaction_);
+  for (GeneratedCodeRange& range : generated_code_ranges_) {
+    range.begin.store(0u, std::memory_order_relaxed);
+    range.end.store(0u, std::memory_order_relaxed);
+  }
 }
 
 FaultManager::~FaultManager() {
@@ -143,6 +152,13 @@ void FaultManager::Init() {
     .sc_flags = 0UL,
   };
 
+  SigchainAction fast_sa = {
+    .sc_sigaction = art_fault_fast_handler,
+    .sc_mask = mask,
+    .sc_flags = SIGCHAIN_FAST_PATH,
+  };
+
+  AddSpecialSignalHandlerFn(SIGSEGV, &fast_sa);
   AddSpecialSignalHandlerFn(SIGSEGV, &sa);
   initialized_ = true;
 }
@@ -150,6 +166,7 @@ void FaultManager::Init() {
 void FaultManager::Release() {
   if (initialized_) {
     RemoveSpecialSignalHandlerFn(SIGSEGV, art_fault_handler);
+    RemoveSpecialSignalHandlerFn(SIGSEGV, art_fault_fast_handler);
     initialized_ = false;
   }
 }
@@ -214,6 +231,58 @@ bool FaultManager::HandleFault(int sig, siginfo_t* info, void* context) {
   return false;
 }
 
+bool FaultManager::HandleFaultFast(int sig, siginfo_t* info, void* context) {
+  // Compiled code only runs in Runnable threads holding the mutator lock, so a PC in one of the
+  // registered ranges makes the checks of IsInGeneratedCode() unnecessary. Each handler still
+  // checks that the faulting instruction or address is one it generated.
+  if (!IsInGeneratedCodeRange(GetFaultPc(info, context))) {
+    return false;
+  }
+  for (const auto& handler : generated_code_handlers_) {
+    if (handler->Action(sig, info, context)) {
+      return true;
+    }
+  }
+  // Let HandleFault() give the other handlers a chance, with the signal mask set up for them.
+  return false;
+}
+
+bool FaultManager::IsInGeneratedCodeRange(uintptr_t pc) const {
+  for (const GeneratedCodeRange& range : generated_code_ranges_) {
+    uintptr_t begin = range.begin.load(std::memory_order_acquire);
+    if (begin > kClaimedRange && begin <= pc && pc < range.end.load(std::memory_order_relaxed)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void FaultManager::AddGeneratedCodeRange(const void* begin, size_t size) {
+  uintptr_t range_begin = reinterpret_cast<uintptr_t>(begin);
+  DCHECK_GT(range_begin, kClaimedRange);
+  for (GeneratedCodeRange& range : generated_code_ranges_) {
+    uintptr_t expected = 0u;
+    if (range.begin.compare_exchange_strong(expected, kClaimedRange, std::memory_order_relaxed)) {
+      range.end.store(range_begin + size, std::memory_order_relaxed);
+      range.begin.store(range_begin, std::memory_order_release);
+      return;
+    }
+  }
+  VLOG(signals) << "Too many generated code ranges, faults in " << begin
+                << " will take the slow path";
+}
+
+void FaultManager::RemoveGeneratedCodeRange(const void* begin, size_t size) {
+  uintptr_t range_begin = reinterpret_cast<uintptr_t>(begin);
+  for (GeneratedCodeRange& range : generated_code_ranges_) {
+    if (range.begin.load(std::memory_order_relaxed) == range_begin &&
+        range.end.load(std::memory_order_relaxed) == range_begin + size) {
+      range.begin.store(0u, std::memory_order_release);
+      return;
+    }
+  }
+}
+
 void FaultManager::AddHandler(FaultHandler* handler, bool generated_code) {
   DCHECK(initialized_);
   if (generated_code) {
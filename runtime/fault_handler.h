@@ -18,6 +18,7 @@
 #ifndef ART_RUNTIME_FAULT_HANDLER_H_
 #define ART_RUNTIME_FAULT_HANDLER_H_
 
+#include <atomic>
 #include <signal.h>
 #include <vector>
 #include <setjmp.h>
@@ -46,6 +47,16 @@ class FaultManager {
   // Try to handle a fault, returns true if successful.
   bool HandleFault(int sig, siginfo_t* info, void* context);
 
+  // Try to handle a fault whose PC lies in a registered generated code range, without the
+  // thread state and method checks of HandleFault(). Called before sigchain adjusts the
+  // signal mask, so it must not fault itself. Returns true if successful.
+  bool HandleFaultFast(int sig, siginfo_t* info, void* context);
+
+  // Record the bounds of memory holding compiled code (JIT code cache, oat file) for
+  // HandleFaultFast(). Ranges that do not fit in the table are left to HandleFault().
+  void AddGeneratedCodeRange(const void* begin, size_t size);
+  void RemoveGeneratedCodeRange(const void* begin, size_t size);
+
   // Added handlers are owned by the fault handler and will be freed on Shutdown().
   void AddHandler(FaultHandler* handler, bool generated_code);
   void RemoveHandler(FaultHandler* handler);
@@ -60,11 +71,27 @@ class FaultManager {
   bool IsInGeneratedCode(siginfo_t* siginfo, void *context, bool check_dex_pc)
                          NO_THREAD_SAFETY_ANALYSIS;
 
+  // Return the PC of the faulting instruction. Architecture specific, like the function above.
+  static uintptr_t GetFaultPc(siginfo_t* siginfo, void* context);
+
  private:
   // The HandleFaultByOtherHandlers function is only called by HandleFault function for generated code.
   bool HandleFaultByOtherHandlers(int sig, siginfo_t* info, void* context)
                                   NO_THREAD_SAFETY_ANALYSIS;
 
+  bool IsInGeneratedCodeRange(uintptr_t pc) const;
+
+  // Entries are claimed and released with atomic operations on `begin`, so that the signal
+  // handler can read the table without taking a lock.
+  struct GeneratedCodeRange {
+    std::atomic<uintptr_t> begin;
+    std::atomic<uintptr_t> end;
+  };
+  static constexpr size_t kMaxGeneratedCodeRanges = 64;
+  // Marks an entry being filled in by AddGeneratedCodeRange().
+  static constexpr uintptr_t kClaimedRange = 1u;
+
+  GeneratedCodeRange generated_code_ranges_[kMaxGeneratedCodeRanges];
   std::vector<FaultHandler*> generated_code_handlers_;
   std::vector<FaultHandler*> other_handlers_;
   struct sigaction oldaction_;
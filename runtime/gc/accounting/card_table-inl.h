@@ -17,6 +17,12 @@
 #ifndef ART_RUNTIME_GC_ACCOUNTING_CARD_TABLE_INL_H_
 #define ART_RUNTIME_GC_ACCOUNTING_CARD_TABLE_INL_H_
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 #include "atomic.h"
 #include "base/bit_utils.h"
 #include "base/logging.h"
@@ -49,6 +55,53 @@ static inline bool byte_cas(uint8_t old_value, uint8_t new_value, uint8_t* addre
 #endif
 }
 
+// The size of the card vectors compared at once by SkipCleanCardWords().
+static constexpr size_t kCardVectorSize = 16;
+
+// Returns true if the kCardVectorSize aligned cards are all clean.
+static inline bool IsCleanCardVector(const uintptr_t* cards) {
+  static_assert(CardTable::kCardClean == 0, "kCardClean must be 0");
+#if defined(__SSE2__)
+  const __m128i v = _mm_load_si128(reinterpret_cast<const __m128i*>(cards));
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) == 0xFFFF;
+#elif defined(__aarch64__)
+  return vmaxvq_u8(vld1q_u8(reinterpret_cast<const uint8_t*>(cards))) == 0;
+#elif defined(__ARM_NEON__)
+  const uint64x2_t v = vreinterpretq_u64_u8(vld1q_u8(reinterpret_cast<const uint8_t*>(cards)));
+  return (vgetq_lane_u64(v, 0) | vgetq_lane_u64(v, 1)) == 0;
+#else
+  for (size_t i = 0; i < kCardVectorSize / sizeof(uintptr_t); ++i) {
+    if (cards[i] != 0) {
+      return false;
+    }
+  }
+  return true;
+#endif
+}
+
+template <bool kVectorized>
+inline uintptr_t* CardTable::SkipCleanCardWords(uintptr_t* word_cur, uintptr_t* word_end) {
+  if (kVectorized) {
+    static constexpr size_t kWordsPerVector = kCardVectorSize / sizeof(uintptr_t);
+    // Go word by word up to the vector alignment.
+    while (!IsAligned<kCardVectorSize>(word_cur) && word_cur < word_end) {
+      if (*word_cur != 0) {
+        return word_cur;
+      }
+      ++word_cur;
+    }
+    while (static_cast<size_t>(word_end - word_cur) >= kWordsPerVector &&
+           IsCleanCardVector(word_cur)) {
+      word_cur += kWordsPerVector;
+    }
+    // The remaining words, or the vector with the first card which is not clean.
+  }
+  while (word_cur < word_end && LIKELY(*word_cur == 0)) {
+    ++word_cur;
+  }
+  return word_cur;
+}
+
 template <bool kClearCard, typename Visitor>
 inline size_t CardTable::Scan(ContinuousSpaceBitmap* bitmap,
                               uint8_t* const scan_begin,
@@ -81,11 +134,9 @@ inline size_t CardTable::Scan(ContinuousSpaceBitmap* bitmap,
   uintptr_t* word_end = reinterpret_cast<uintptr_t*>(aligned_end);
   for (uintptr_t* word_cur = reinterpret_cast<uintptr_t*>(card_cur); word_cur < word_end;
       ++word_cur) {
-    while (LIKELY(*word_cur == 0)) {
-      ++word_cur;
-      if (UNLIKELY(word_cur >= word_end)) {
-        goto exit_for;
-      }
+    word_cur = SkipCleanCardWords(word_cur, word_end);
+    if (UNLIKELY(word_cur >= word_end)) {
+      break;
     }
 
     // Find the first dirty card.
@@ -105,7 +156,6 @@ inline size_t CardTable::Scan(ContinuousSpaceBitmap* bitmap,
       start += kCardSize;
     }
   }
-  exit_for:
 
   // Handle any unaligned cards at the end.
   card_cur = reinterpret_cast<uint8_t*>(word_end);
@@ -184,6 +234,10 @@ inline void CardTable::ModifyCardsAtomic(uint8_t* scan_begin,
 
   // TODO: Parallelize.
   while (word_cur < word_end) {
+    word_cur = SkipCleanCardWords(word_cur, word_end);
+    if (word_cur >= word_end) {
+      break;
+    }
     while (true) {
       expected_word = *word_cur;
       if (LIKELY(expected_word == 0)) {
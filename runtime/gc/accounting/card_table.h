@@ -52,6 +52,13 @@ class CardTable {
   static constexpr uint8_t kCardClean = 0x0;
   static constexpr uint8_t kCardDirty = 0x70;
   static constexpr uint8_t kCardAged = kCardDirty - 1;
+  // Whether the clean cards are skipped 16 at a time with vector compares. SSE2 and NEON are part
+  // of the baseline of the targets that have them, so no runtime feature check is needed.
+#if defined(__SSE2__) || defined(__ARM_NEON__) || defined(__aarch64__)
+  static constexpr bool kVectorizedCardScan = true;
+#else
+  static constexpr bool kVectorizedCardScan = false;
+#endif
 
   static CardTable* Create(const uint8_t* heap_begin, size_t heap_capacity);
   ~CardTable();
@@ -115,6 +122,11 @@ class CardTable {
       REQUIRES(Locks::heap_bitmap_lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Returns the first word in [word_cur, word_end) which holds a card that is not clean, or
+  // word_end if all the cards are clean. The cards may be dirtied concurrently.
+  template <bool kVectorized = kVectorizedCardScan>
+  static uintptr_t* SkipCleanCardWords(uintptr_t* word_cur, uintptr_t* word_end) ALWAYS_INLINE;
+
   // Assertion used to check the given address is covered by the card table
   void CheckAddrIsInCardTable(const uint8_t* addr) const;
 
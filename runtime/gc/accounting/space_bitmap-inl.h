@@ -47,10 +47,56 @@ inline bool SpaceBitmap<kAlignment>::AtomicTestAndSet(const mirror::Object* obj)
       return true;
     }
   } while (!atomic_entry->CompareExchangeWeakRelaxed(old_word, old_word | mask));
+  MarkSummary(index);
   DCHECK(Test(obj));
   return false;
 }
 
+template<size_t kAlignment>
+inline void SpaceBitmap<kAlignment>::MarkSummary(size_t index) {
+  if (summary_begin_ != nullptr) {
+    const size_t summary_bit = index / kSummaryWords;
+    Atomic<uintptr_t>* const summary_entry = &summary_begin_[summary_bit / kBitsPerIntPtrT];
+    const uintptr_t mask = static_cast<uintptr_t>(1) << (summary_bit % kBitsPerIntPtrT);
+    if ((summary_entry->LoadRelaxed() & mask) == 0) {
+      summary_entry->FetchAndOrSequentiallyConsistent(mask);
+    }
+  }
+}
+
+template<size_t kAlignment>
+inline size_t SpaceBitmap<kAlignment>::FindNonZeroWord(size_t begin, size_t end) const {
+  // The words are read as plain words so that the OR of a block is vectorized. Like the relaxed
+  // loads of the walks, the reads may or may not see the concurrent updates of the bitmap.
+  const uintptr_t* const words = reinterpret_cast<const uintptr_t*>(bitmap_begin_);
+  size_t i = begin;
+  while (i < end) {
+    if (summary_begin_ != nullptr && IsAligned<kSummaryWords>(i)) {
+      const size_t summary_bit = i / kSummaryWords;
+      const uintptr_t summary_word = summary_begin_[summary_bit / kBitsPerIntPtrT].LoadRelaxed();
+      if ((summary_word & (static_cast<uintptr_t>(1) << (summary_bit % kBitsPerIntPtrT))) == 0) {
+        i += kSummaryWords;
+        continue;
+      }
+    }
+    if (IsAligned<kScanBlockWords>(i) && end - i >= kScanBlockWords) {
+      uintptr_t block = 0;
+      for (size_t j = 0; j < kScanBlockWords; ++j) {
+        block |= words[i + j];
+      }
+      if (block == 0) {
+        i += kScanBlockWords;
+        continue;
+      }
+    }
+    if (words[i] != 0) {
+      return i;
+    }
+    ++i;
+  }
+  return end;
+}
+
 template<size_t kAlignment>
 inline bool SpaceBitmap<kAlignment>::Test(const mirror::Object* obj) const {
   uintptr_t addr = reinterpret_cast<uintptr_t>(obj);
@@ -116,7 +162,9 @@ inline void SpaceBitmap<kAlignment>::VisitMarkedRange(uintptr_t visit_begin,
     }
 
     // Traverse the middle, full part.
-    for (size_t i = index_start + 1; i < index_end; ++i) {
+    for (size_t i = FindNonZeroWord(index_start + 1, index_end);
+         i < index_end;
+         i = FindNonZeroWord(i + 1, index_end)) {
       uintptr_t w = bitmap_begin_[i].LoadRelaxed();
       if (w != 0) {
         const uintptr_t ptr_base = IndexToOffset(i) + heap_begin_;
@@ -162,7 +210,7 @@ void SpaceBitmap<kAlignment>::Walk(Visitor&& visitor) {
 
   uintptr_t end = OffsetToIndex(HeapLimit() - heap_begin_ - 1);
   Atomic<uintptr_t>* bitmap_begin = bitmap_begin_;
-  for (uintptr_t i = 0; i <= end; ++i) {
+  for (uintptr_t i = FindNonZeroWord(0, end + 1); i <= end; i = FindNonZeroWord(i + 1, end + 1)) {
     uintptr_t w = bitmap_begin[i].LoadRelaxed();
     if (w != 0) {
       uintptr_t ptr_base = IndexToOffset(i) + heap_begin_;
@@ -195,6 +243,7 @@ inline bool SpaceBitmap<kAlignment>::Modify(const mirror::Object* obj) {
     // occur if the bitmap was read write and we did not check the bit.
     if ((old_word & mask) == 0) {
       atomic_entry->StoreRelaxed(old_word | mask);
+      MarkSummary(index);
     }
   } else {
     atomic_entry->StoreRelaxed(old_word & ~mask);
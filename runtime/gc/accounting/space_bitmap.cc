@@ -63,7 +63,8 @@ SpaceBitmap<kAlignment>::SpaceBitmap(const std::string& name,
       bitmap_size_(bitmap_size),
       heap_begin_(reinterpret_cast<uintptr_t>(heap_begin)),
       heap_limit_(reinterpret_cast<uintptr_t>(heap_begin) + heap_capacity),
-      name_(name) {
+      name_(name),
+      summary_begin_(nullptr) {
   CHECK(bitmap_begin_ != nullptr);
   CHECK_NE(bitmap_size, 0U);
 }
@@ -110,6 +111,43 @@ void SpaceBitmap<kAlignment>::Clear() {
   if (bitmap_begin_ != nullptr) {
     mem_map_->MadviseDontNeedAndZero();
   }
+  if (summary_begin_ != nullptr) {
+    summary_mem_map_->MadviseDontNeedAndZero();
+  }
+}
+
+template<size_t kAlignment>
+bool SpaceBitmap<kAlignment>::EnableSummary() {
+  if (summary_begin_ != nullptr) {
+    return true;
+  }
+  // Cover the whole mem map, the heap size of the bitmap may change.
+  const size_t summary_bits = RoundUp(mem_map_->Size() / sizeof(uintptr_t), kSummaryWords) /
+      kSummaryWords;
+  const size_t summary_size = RoundUp(summary_bits, kBitsPerIntPtrT) / kBitsPerByte;
+  std::string error_msg;
+  summary_mem_map_.reset(MemMap::MapAnonymous((name_ + " summary").c_str(), nullptr,
+                                              summary_size, PROT_READ | PROT_WRITE, false, false,
+                                              &error_msg));
+  if (UNLIKELY(summary_mem_map_ == nullptr)) {
+    LOG(ERROR) << "Failed to allocate summary of bitmap " << name_ << ": " << error_msg;
+    return false;
+  }
+  summary_begin_ = reinterpret_cast<Atomic<uintptr_t>*>(summary_mem_map_->Begin());
+  RebuildSummary();
+  return true;
+}
+
+template<size_t kAlignment>
+void SpaceBitmap<kAlignment>::RebuildSummary() {
+  DCHECK(summary_begin_ != nullptr);
+  summary_mem_map_->MadviseDontNeedAndZero();
+  const size_t count = bitmap_size_ / sizeof(intptr_t);
+  for (size_t i = 0; i < count; ++i) {
+    if (bitmap_begin_[i].LoadRelaxed() != 0) {
+      MarkSummary(i);
+    }
+  }
 }
 
 template<size_t kAlignment>
@@ -140,6 +178,9 @@ void SpaceBitmap<kAlignment>::CopyFrom(SpaceBitmap* source_bitmap) {
   for (size_t i = 0; i < count; ++i) {
     dest[i].StoreRelaxed(src[i].LoadRelaxed());
   }
+  if (summary_begin_ != nullptr) {
+    RebuildSummary();
+  }
 }
 
 template<size_t kAlignment>
@@ -176,7 +217,10 @@ void SpaceBitmap<kAlignment>::SweepWalk(const SpaceBitmap<kAlignment>& live_bitm
   CHECK_LT(end, live_bitmap.Size() / sizeof(intptr_t));
   Atomic<uintptr_t>* live = live_bitmap.bitmap_begin_;
   Atomic<uintptr_t>* mark = mark_bitmap.bitmap_begin_;
-  for (size_t i = start; i <= end; i++) {
+  // Garbage needs a live bit, skip the empty parts of the live bitmap.
+  for (size_t i = live_bitmap.FindNonZeroWord(start, end + 1);
+       i <= end;
+       i = live_bitmap.FindNonZeroWord(i + 1, end + 1)) {
     uintptr_t garbage = live[i].LoadRelaxed() & ~mark[i].LoadRelaxed();
     if (UNLIKELY(garbage != 0)) {
       uintptr_t ptr_base = IndexToOffset(i) + live_bitmap.heap_begin_;
@@ -146,6 +146,17 @@ class SpaceBitmap {
 
   void CopyFrom(SpaceBitmap* source_bitmap);
 
+  // Keep a summary of the bitmap, with one bit per kSummaryWords words set if any of these words
+  // may be non zero, so that the walks skip the empty parts of sparse bitmaps. The summary is
+  // computed from the bitmap, then updated by Set, AtomicTestAndSet, Clear() and CopyFrom, and
+  // stays conservative when bits are cleared: the words must not be written through Begin()
+  // afterwards. Returns false if the summary could not be allocated.
+  bool EnableSummary();
+
+  bool HasSummary() const {
+    return summary_begin_ != nullptr;
+  }
+
   // Starting address of our internal storage.
   Atomic<uintptr_t>* Begin() {
     return bitmap_begin_;
@@ -204,9 +215,25 @@ class SpaceBitmap {
               const void* heap_begin,
               size_t heap_capacity);
 
+  // Number of bitmap words of a summary bit.
+  static constexpr size_t kSummaryWords = 64;
+  // The walks test blocks of this many bytes of the bitmap at once, the size of the widest
+  // vector registers.
+  static constexpr size_t kScanBlockBytes = 64;
+  static constexpr size_t kScanBlockWords = kScanBlockBytes / sizeof(uintptr_t);
+
   template<bool kSetBit>
   bool Modify(const mirror::Object* obj);
 
+  // Returns the index of the first non zero word in [begin, end), or `end` if there is none.
+  size_t FindNonZeroWord(size_t begin, size_t end) const;
+
+  // Record in the summary, if any, that the word at `index` may be non zero.
+  void MarkSummary(size_t index);
+
+  // Compute the summary from the bitmap words.
+  void RebuildSummary();
+
   // Backing storage for bitmap.
   std::unique_ptr<MemMap> mem_map_;
 
@@ -225,6 +252,10 @@ class SpaceBitmap {
 
   // Name of this bitmap.
   std::string name_;
+
+  // Backing storage and words of the summary, null unless EnableSummary() was called.
+  std::unique_ptr<MemMap> summary_mem_map_;
+  Atomic<uintptr_t>* summary_begin_;
 };
 
 typedef SpaceBitmap<kObjectAlignment> ContinuousSpaceBitmap;
@@ -19,6 +19,7 @@
 #include <stdint.h>
 #include <memory>
 
+#include "base/time_utils.h"
 #include "common_runtime_test.h"
 #include "globals.h"
 #include "space_bitmap-inl.h"
@@ -153,7 +154,7 @@ class RandGen {
 };
 
 template <size_t kAlignment>
-void RunTest() NO_THREAD_SAFETY_ANALYSIS {
+void RunTest(bool summary) NO_THREAD_SAFETY_ANALYSIS {
   uint8_t* heap_begin = reinterpret_cast<uint8_t*>(0x10000000);
   size_t heap_capacity = 16 * MB;
 
@@ -164,6 +165,9 @@ void RunTest() NO_THREAD_SAFETY_ANALYSIS {
   for (int i = 0; i < 5 ; ++i) {
     std::unique_ptr<ContinuousSpaceBitmap> space_bitmap(
         ContinuousSpaceBitmap::Create("test bitmap", heap_begin, heap_capacity));
+    if (summary) {
+      ASSERT_TRUE(space_bitmap->EnableSummary());
+    }
 
     for (int j = 0; j < 10000; ++j) {
       size_t offset = RoundDown(r.next() % heap_capacity, kAlignment);
@@ -200,11 +204,130 @@ void RunTest() NO_THREAD_SAFETY_ANALYSIS {
 }
 
 TEST_F(SpaceBitmapTest, VisitorObjectAlignment) {
-  RunTest<kObjectAlignment>();
+  RunTest<kObjectAlignment>(/* summary */ false);
 }
 
 TEST_F(SpaceBitmapTest, VisitorPageAlignment) {
-  RunTest<kPageSize>();
+  RunTest<kPageSize>(/* summary */ false);
+}
+
+TEST_F(SpaceBitmapTest, VisitorObjectAlignmentSummary) {
+  RunTest<kObjectAlignment>(/* summary */ true);
+}
+
+TEST_F(SpaceBitmapTest, VisitorPageAlignmentSummary) {
+  RunTest<kPageSize>(/* summary */ true);
+}
+
+static void CountSweptObjects(size_t ptr_count, mirror::Object** ptrs ATTRIBUTE_UNUSED, void* arg) {
+  *reinterpret_cast<size_t*>(arg) += ptr_count;
+}
+
+// The summary computed from a populated bitmap and the one maintained by Set must give the same
+// walks as the bitmap alone.
+static void RunSummaryTest() NO_THREAD_SAFETY_ANALYSIS {
+  uint8_t* heap_begin = reinterpret_cast<uint8_t*>(0x10000000);
+  size_t heap_capacity = 64 * MB;
+  std::unique_ptr<ContinuousSpaceBitmap> live_bitmap(
+      ContinuousSpaceBitmap::Create("live bitmap", heap_begin, heap_capacity));
+  std::unique_ptr<ContinuousSpaceBitmap> mark_bitmap(
+      ContinuousSpaceBitmap::Create("mark bitmap", heap_begin, heap_capacity));
+  RandGen r(0x1234);
+  size_t live = 0;
+  size_t marked = 0;
+  for (int i = 0; i < 1000; ++i) {
+    const mirror::Object* obj = reinterpret_cast<mirror::Object*>(
+        heap_begin + RoundDown(r.next() % heap_capacity, kObjectAlignment));
+    if (!live_bitmap->Set(obj)) {
+      ++live;
+      if (r.next() % 2 == 0) {
+        mark_bitmap->Set(obj);
+        ++marked;
+      }
+    }
+  }
+  ASSERT_TRUE(live_bitmap->EnableSummary());
+  size_t walked = 0;
+  live_bitmap->Walk(SimpleCounter(&walked));
+  EXPECT_EQ(live, walked);
+  size_t swept = 0;
+  ContinuousSpaceBitmap::SweepWalk(*live_bitmap,
+                                   *mark_bitmap,
+                                   reinterpret_cast<uintptr_t>(heap_begin),
+                                   reinterpret_cast<uintptr_t>(heap_begin) + heap_capacity,
+                                   CountSweptObjects,
+                                   &swept);
+  EXPECT_EQ(live - marked, swept);
+
+  // Set more bits after enabling the summary, in words whose summary bits are still clear.
+  const mirror::Object* last = reinterpret_cast<mirror::Object*>(
+      heap_begin + heap_capacity - kObjectAlignment);
+  if (!live_bitmap->Set(last)) {
+    ++live;
+  }
+  walked = 0;
+  live_bitmap->Walk(SimpleCounter(&walked));
+  EXPECT_EQ(live, walked);
+
+  live_bitmap->Clear();
+  walked = 0;
+  live_bitmap->Walk(SimpleCounter(&walked));
+  EXPECT_EQ(0u, walked);
+}
+
+// Compares the walks of a sparse bitmap word by word, by blocks of words, and with the summary.
+static void RunSparseWalkBenchmark() NO_THREAD_SAFETY_ANALYSIS {
+  uint8_t* heap_begin = reinterpret_cast<uint8_t*>(0x10000000);
+  size_t heap_capacity = 256 * MB;
+  std::unique_ptr<ContinuousSpaceBitmap> bitmap(
+      ContinuousSpaceBitmap::Create("test bitmap", heap_begin, heap_capacity));
+  // An object every 256 KiB.
+  size_t objects = 0;
+  for (size_t offset = 0; offset < heap_capacity; offset += 256 * KB) {
+    bitmap->Set(reinterpret_cast<mirror::Object*>(heap_begin + offset));
+    ++objects;
+  }
+  constexpr size_t kIterations = 10;
+
+  uint64_t start = NanoTime();
+  size_t count = 0;
+  const size_t words = bitmap->Size() / sizeof(intptr_t);
+  for (size_t i = 0; i < kIterations; ++i) {
+    for (size_t j = 0; j < words; ++j) {
+      count += POPCOUNT(bitmap->Begin()[j].LoadRelaxed());
+    }
+  }
+  const uint64_t word_time = NanoTime() - start;
+  EXPECT_EQ(objects * kIterations, count);
+
+  start = NanoTime();
+  count = 0;
+  for (size_t i = 0; i < kIterations; ++i) {
+    bitmap->Walk(SimpleCounter(&count));
+  }
+  const uint64_t block_time = NanoTime() - start;
+  EXPECT_EQ(objects * kIterations, count);
+
+  ASSERT_TRUE(bitmap->EnableSummary());
+  start = NanoTime();
+  count = 0;
+  for (size_t i = 0; i < kIterations; ++i) {
+    bitmap->Walk(SimpleCounter(&count));
+  }
+  const uint64_t summary_time = NanoTime() - start;
+  EXPECT_EQ(objects * kIterations, count);
+
+  LOG(INFO) << "Sparse bitmap walk: word by word " << PrettyDuration(word_time / kIterations)
+            << ", by blocks " << PrettyDuration(block_time / kIterations)
+            << ", with summary " << PrettyDuration(summary_time / kIterations);
+}
+
+TEST_F(SpaceBitmapTest, Summary) {
+  RunSummaryTest();
+}
+
+TEST_F(SpaceBitmapTest, SparseWalkBenchmark) {
+  RunSparseWalkBenchmark();
 }
 
 }  // namespace accounting
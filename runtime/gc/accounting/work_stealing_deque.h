@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_GC_ACCOUNTING_WORK_STEALING_DEQUE_H_
+#define ART_RUNTIME_GC_ACCOUNTING_WORK_STEALING_DEQUE_H_
+
+#include <memory>
+#include <vector>
+
+#include "atomic.h"
+#include "base/bit_utils.h"
+#include "base/logging.h"
+#include "base/macros.h"
+
+// This implements the Chase-Lev work-stealing deque, with the memory orderings of "Correct and
+// Efficient Work-Stealing for Weak Memory Models" (Le et al., PPoPP 2013). The owner thread pushes
+// and pops at the bottom, any other thread may steal from the top concurrently. The circular
+// buffer grows when full; the buffers it replaces are kept until the deque is destroyed or Reset()
+// since a thief may still be reading from them.
+
+namespace art {
+namespace gc {
+namespace accounting {
+
+template <typename T>
+class WorkStealingDeque {
+ public:
+  explicit WorkStealingDeque(size_t initial_capacity)
+      : top_(0), bottom_(0), buffer_(nullptr) {
+    CHECK(IsPowerOfTwo(initial_capacity)) << initial_capacity;
+    buffers_.emplace_back(new Buffer(initial_capacity));
+    buffer_.StoreRelaxed(buffers_.back().get());
+  }
+
+  // Owner only.
+  void Push(T* value) {
+    const int64_t bottom = bottom_.LoadRelaxed();
+    const int64_t top = top_.LoadAcquire();
+    Buffer* buffer = buffer_.LoadRelaxed();
+    if (UNLIKELY(bottom - top > static_cast<int64_t>(buffer->Capacity()) - 1)) {
+      buffer = Grow(buffer, top, bottom);
+    }
+    buffer->Set(bottom, value);
+    QuasiAtomic::ThreadFenceRelease();
+    bottom_.StoreRelaxed(bottom + 1);
+  }
+
+  // Owner only. Returns null if the deque is empty.
+  T* Pop() {
+    const int64_t bottom = bottom_.LoadRelaxed() - 1;
+    Buffer* const buffer = buffer_.LoadRelaxed();
+    bottom_.StoreRelaxed(bottom);
+    QuasiAtomic::ThreadFenceSequentiallyConsistent();
+    int64_t top = top_.LoadRelaxed();
+    T* value = nullptr;
+    if (top <= bottom) {
+      value = buffer->Get(bottom);
+      if (top == bottom) {
+        // Last element, race against the thieves for it.
+        if (!top_.CompareExchangeStrongSequentiallyConsistent(top, top + 1)) {
+          value = nullptr;
+        }
+        bottom_.StoreRelaxed(bottom + 1);
+      }
+    } else {
+      bottom_.StoreRelaxed(bottom + 1);
+    }
+    return value;
+  }
+
+  // Any thread. Returns null if the deque is empty or the steal lost a race, in which case the
+  // caller may retry.
+  T* Steal() {
+    int64_t top = top_.LoadAcquire();
+    QuasiAtomic::ThreadFenceSequentiallyConsistent();
+    const int64_t bottom = bottom_.LoadAcquire();
+    if (top < bottom) {
+      Buffer* const buffer = buffer_.LoadAcquire();
+      T* const value = buffer->Get(top);
+      if (top_.CompareExchangeStrongSequentiallyConsistent(top, top + 1)) {
+        return value;
+      }
+    }
+    return nullptr;
+  }
+
+  // Any thread, only an estimate while the owner or thieves are active.
+  bool IsEmpty() const {
+    return bottom_.LoadAcquire() <= top_.LoadAcquire();
+  }
+
+  size_t Size() const {
+    const int64_t size = bottom_.LoadAcquire() - top_.LoadAcquire();
+    return size > 0 ? static_cast<size_t>(size) : 0u;
+  }
+
+  // Frees the replaced buffers. No other thread may be accessing the deque.
+  void Reset() {
+    DCHECK(IsEmpty());
+    top_.StoreRelaxed(0);
+    bottom_.StoreRelaxed(0);
+    buffers_.erase(buffers_.begin(), buffers_.end() - 1);
+  }
+
+ private:
+  class Buffer {
+   public:
+    explicit Buffer(size_t capacity)
+        : mask_(capacity - 1), elements_(new Atomic<T*>[capacity]) {}
+
+    size_t Capacity() const {
+      return mask_ + 1;
+    }
+
+    T* Get(int64_t index) const {
+      return elements_[static_cast<size_t>(index) & mask_].LoadRelaxed();
+    }
+
+    void Set(int64_t index, T* value) {
+      elements_[static_cast<size_t>(index) & mask_].StoreRelaxed(value);
+    }
+
+   private:
+    const size_t mask_;
+    std::unique_ptr<Atomic<T*>[]> elements_;
+  };
+
+  Buffer* Grow(Buffer* old_buffer, int64_t top, int64_t bottom) {
+    Buffer* const new_buffer = new Buffer(old_buffer->Capacity() * 2);
+    for (int64_t i = top; i < bottom; ++i) {
+      new_buffer->Set(i, old_buffer->Get(i));
+    }
+    buffers_.emplace_back(new_buffer);
+    buffer_.StoreRelease(new_buffer);
+    return new_buffer;
+  }
+
+  Atomic<int64_t> top_;
+  Atomic<int64_t> bottom_;
+  Atomic<Buffer*> buffer_;
+  // The current buffer last, and the ones it replaced. Only modified by the owner.
+  std::vector<std::unique_ptr<Buffer>> buffers_;
+
+  DISALLOW_COPY_AND_ASSIGN(WorkStealingDeque);
+};
+
+}  // namespace accounting
+}  // namespace gc
+}  // namespace art
+
+#endif  // ART_RUNTIME_GC_ACCOUNTING_WORK_STEALING_DEQUE_H_
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "work_stealing_deque.h"
+
+#include <vector>
+
+#include "common_runtime_test.h"
+#include "thread-current-inl.h"
+#include "thread_pool.h"
+
+namespace art {
+namespace gc {
+namespace accounting {
+
+class WorkStealingDequeTest : public CommonRuntimeTest {};
+
+// The deque does not dereference its elements, so any distinct non-null values work.
+static int* Element(size_t i) {
+  return reinterpret_cast<int*>(static_cast<uintptr_t>(i + 1) * sizeof(int));
+}
+
+TEST_F(WorkStealingDequeTest, PushPopSteal) {
+  WorkStealingDeque<int> deque(4);
+  EXPECT_TRUE(deque.IsEmpty());
+  EXPECT_EQ(deque.Pop(), nullptr);
+  EXPECT_EQ(deque.Steal(), nullptr);
+  // Grow past the initial capacity.
+  static constexpr size_t kCount = 100;
+  for (size_t i = 0; i < kCount; ++i) {
+    deque.Push(Element(i));
+  }
+  EXPECT_EQ(deque.Size(), kCount);
+  // Steal takes the oldest, Pop the newest.
+  EXPECT_EQ(deque.Steal(), Element(0));
+  EXPECT_EQ(deque.Pop(), Element(kCount - 1));
+  for (size_t i = kCount - 2; i > 0; --i) {
+    EXPECT_EQ(deque.Pop(), Element(i));
+  }
+  EXPECT_TRUE(deque.IsEmpty());
+  EXPECT_EQ(deque.Pop(), nullptr);
+  deque.Reset();
+  deque.Push(Element(7));
+  EXPECT_EQ(deque.Steal(), Element(7));
+  EXPECT_EQ(deque.Pop(), nullptr);
+}
+
+class StealTask : public Task {
+ public:
+  StealTask(WorkStealingDeque<int>* deque, Atomic<bool>* done, std::vector<int*>* stolen)
+      : deque_(deque), done_(done), stolen_(stolen) {}
+
+  void Run(Thread* self ATTRIBUTE_UNUSED) OVERRIDE {
+    while (!done_->LoadSequentiallyConsistent() || !deque_->IsEmpty()) {
+      int* value = deque_->Steal();
+      if (value != nullptr) {
+        stolen_->push_back(value);
+      }
+    }
+  }
+
+  void Finalize() OVERRIDE {
+    delete this;
+  }
+
+ private:
+  WorkStealingDeque<int>* const deque_;
+  Atomic<bool>* const done_;
+  std::vector<int*>* const stolen_;
+};
+
+// Every pushed element must be popped or stolen exactly once.
+TEST_F(WorkStealingDequeTest, ConcurrentSteal) {
+  static constexpr size_t kThieves = 3;
+  static constexpr size_t kCount = 100000;
+  Thread* self = Thread::Current();
+  ThreadPool thread_pool("Work stealing deque test thread pool", kThieves);
+  WorkStealingDeque<int> deque(16);
+  Atomic<bool> done(false);
+  std::vector<std::vector<int*>> stolen(kThieves);
+  for (size_t i = 0; i < kThieves; ++i) {
+    thread_pool.AddTask(self, new StealTask(&deque, &done, &stolen[i]));
+  }
+  thread_pool.StartWorkers(self);
+  std::vector<int*> popped;
+  for (size_t i = 0; i < kCount; ++i) {
+    deque.Push(Element(i));
+    if (i % 3 == 0) {
+      int* value = deque.Pop();
+      if (value != nullptr) {
+        popped.push_back(value);
+      }
+    }
+  }
+  for (int* value = deque.Pop(); value != nullptr; value = deque.Pop()) {
+    popped.push_back(value);
+  }
+  done.StoreSequentiallyConsistent(true);
+  thread_pool.Wait(self, /* do_work */ false, /* may_hold_locks */ false);
+  thread_pool.StopWorkers(self);
+  std::vector<size_t> seen(kCount, 0u);
+  for (int* value : popped) {
+    ++seen[reinterpret_cast<uintptr_t>(value) / sizeof(int) - 1];
+  }
+  for (const std::vector<int*>& values : stolen) {
+    for (int* value : values) {
+      ++seen[reinterpret_cast<uintptr_t>(value) / sizeof(int) - 1];
+    }
+  }
+  for (size_t i = 0; i < kCount; ++i) {
+    EXPECT_EQ(seen[i], 1u) << i;
+  }
+}
+
+}  // namespace accounting
+}  // namespace gc
+}  // namespace art
@@ -16,12 +16,16 @@
 
 #include "allocation_record.h"
 
+#include <cmath>
+
 #include "art_method-inl.h"
 #include "base/enums.h"
 #include "base/stl_util.h"
+#include "base/time_utils.h"
 #include "obj_ptr-inl.h"
 #include "object_callbacks.h"
 #include "stack.h"
+#include "thread_list.h"
 
 #ifdef ART_TARGET_ANDROID
 #include "cutils/properties.h"
@@ -91,9 +95,32 @@ void AllocRecordObjectMap::SetProperties() {
       max_stack_depth_ = value;
     }
   }
+  // Check whether there's a system property enabling sampling.
+  propertyName = "dalvik.vm.allocTrackerSampleBytes";
+  char sampleBytesString[PROPERTY_VALUE_MAX];
+  if (property_get(propertyName, sampleBytesString, "") > 0) {
+    char* end;
+    size_t value = strtoul(sampleBytesString, &end, 10);
+    if (*end != '\0') {
+      LOG(ERROR) << "Ignoring  " << propertyName << " '" << sampleBytesString
+                 << "' --- invalid";
+    } else {
+      sample_interval_.StoreRelaxed(value);
+    }
+  }
 #endif  // ART_TARGET_ANDROID
 }
 
+AllocRecordThreadLocalBuffer::AllocRecordThreadLocalBuffer(pid_t tid)
+    : bytes_until_sample_(0u),
+      random_state_((static_cast<uint64_t>(tid) << 32) ^ NanoTime() ^ 0x9e3779b97f4a7c15ULL),
+      epoch_(0u) {
+  if (random_state_ == 0u) {
+    random_state_ = 1u;
+  }
+  entries_.reserve(AllocRecordObjectMap::kThreadLocalRecordCount);
+}
+
 AllocRecordObjectMap::~AllocRecordObjectMap() {
   Clear();
 }
@@ -139,6 +166,9 @@ static inline void SweepClassObject(AllocRecord* record, IsMarkedVisitor* visito
 
 void AllocRecordObjectMap::SweepAllocationRecords(IsMarkedVisitor* visitor) {
   VLOG(heap) << "Start SweepAllocationRecords()";
+  // New records are not allowed while the GC sweeps system weaks, so the thread local buffers are
+  // not being added to and can be merged here to get their objects swept.
+  MergeAllThreadLocalBuffers(Thread::Current());
   size_t count_deleted = 0, count_moved = 0, count = 0;
   // Only the first (size - recent_record_max_) number of records can be deleted.
   const size_t delete_bound = std::max(entries_.size(), recent_record_max_) - recent_record_max_;
@@ -172,13 +202,13 @@ void AllocRecordObjectMap::SweepAllocationRecords(IsMarkedVisitor* visitor) {
 
 void AllocRecordObjectMap::AllowNewAllocationRecords() {
   CHECK(!kUseReadBarrier);
-  allow_new_record_ = true;
+  allow_new_record_.StoreRelaxed(true);
   new_record_condition_.Broadcast(Thread::Current());
 }
 
 void AllocRecordObjectMap::DisallowNewAllocationRecords() {
   CHECK(!kUseReadBarrier);
-  allow_new_record_ = false;
+  allow_new_record_.StoreRelaxed(false);
 }
 
 void AllocRecordObjectMap::BroadcastForNewAllocationRecords() {
@@ -239,6 +269,9 @@ void AllocRecordObjectMap::SetAllocTrackingEnabled(bool enable) {
       LOG(INFO) << "Enabling alloc tracker (" << records->alloc_record_max_ << " entries of "
                 << records->max_stack_depth_ << " frames, taking up to "
                 << PrettySize(sz * records->alloc_record_max_) << ")";
+      if (records->GetSampleInterval() != 0u) {
+        LOG(INFO) << "Sampling one allocation per " << PrettySize(records->GetSampleInterval());
+      }
     }
     Runtime::Current()->GetInstrumentation()->InstrumentQuickAllocEntryPoints();
     {
@@ -263,9 +296,56 @@ void AllocRecordObjectMap::SetAllocTrackingEnabled(bool enable) {
   }
 }
 
+bool AllocRecordObjectMap::WaitForNewRecordsAllowed(Thread* self) {
+  // Wait for GC's sweeping to complete and allow new records
+  while (UNLIKELY((!kUseReadBarrier && !allow_new_record_.LoadRelaxed()) ||
+                  (kUseReadBarrier && !self->GetWeakRefAccessEnabled()))) {
+    // Check and run the empty checkpoint before blocking so the empty checkpoint will work in the
+    // presence of threads blocking for weak ref access.
+    self->CheckEmptyCheckpointFromWeakRefAccess(Locks::alloc_tracker_lock_);
+    new_record_condition_.WaitHoldingLocks(self);
+  }
+  // Return false if the allocation tracking has been disabled while waiting for system weak access
+  // above.
+  return Runtime::Current()->GetHeap()->IsAllocTrackingEnabled();
+}
+
+bool AllocRecordObjectMap::SampleAllocation(AllocRecordThreadLocalBuffer* buffer,
+                                            size_t byte_count) {
+  if (LIKELY(byte_count < buffer->bytes_until_sample_)) {
+    buffer->bytes_until_sample_ -= byte_count;
+    return false;
+  }
+  // The countdown is only 0 before the first allocation of the thread, which starts it.
+  const bool first = buffer->bytes_until_sample_ == 0u;
+  // Draw the next interval from an exponential distribution with the sample interval as the mean,
+  // using xorshift64* for the uniform variate.
+  uint64_t x = buffer->random_state_;
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  buffer->random_state_ = x;
+  const double u = static_cast<double>((x * 0x2545f4914f6cdd1dULL) >> 11) * (1.0 / (1ULL << 53));
+  const double interval = -std::log(1.0 - u) * static_cast<double>(GetSampleInterval());
+  buffer->bytes_until_sample_ = std::max<size_t>(static_cast<size_t>(interval), 1u);
+  return !first;
+}
+
 void AllocRecordObjectMap::RecordAllocation(Thread* self,
                                             ObjPtr<mirror::Object>* obj,
                                             size_t byte_count) {
+  AllocRecordThreadLocalBuffer* buffer = nullptr;
+  if (GetSampleInterval() != 0u) {
+    buffer = self->GetAllocRecordBuffer();
+    if (UNLIKELY(buffer == nullptr)) {
+      buffer = new AllocRecordThreadLocalBuffer(self->GetTid());
+      self->SetAllocRecordBuffer(buffer);
+    }
+    if (!SampleAllocation(buffer, byte_count)) {
+      return;
+    }
+  }
+
   // Get stack trace outside of lock in case there are allocations during the stack walk.
   // b/27858645.
   AllocRecordStackTrace trace;
@@ -275,6 +355,27 @@ void AllocRecordObjectMap::RecordAllocation(Thread* self,
     auto obj_wrapper = hs.NewHandleWrapper(obj);
     visitor.WalkStack();
   }
+  trace.SetTid(self->GetTid());
+
+  if (buffer != nullptr) {
+    const uint32_t epoch = epoch_.LoadRelaxed();
+    if (buffer->epoch_ != epoch) {
+      // The records were cleared since this buffer was last used, drop its stale records.
+      buffer->entries_.clear();
+      buffer->epoch_ = epoch;
+    }
+    // There is no suspend point between this check and adding the record, so the GC can't start
+    // sweeping the thread local buffers before the record is added.
+    if (buffer->entries_.size() < kThreadLocalRecordCount &&
+        ((!kUseReadBarrier && allow_new_record_.LoadRelaxed()) ||
+         (kUseReadBarrier && self->GetWeakRefAccessEnabled()))) {
+      buffer->entries_.push_back(EntryPair(GcRoot<mirror::Object>(obj->Ptr()),
+                                           AllocRecord(byte_count,
+                                                       (*obj)->GetClass(),
+                                                       std::move(trace))));
+      return;
+    }
+  }
 
   MutexLock mu(self, *Locks::alloc_tracker_lock_);
   Heap* const heap = Runtime::Current()->GetHeap();
@@ -288,33 +389,65 @@ void AllocRecordObjectMap::RecordAllocation(Thread* self,
     return;
   }
 
-  // Wait for GC's sweeping to complete and allow new records
-  while (UNLIKELY((!kUseReadBarrier && !allow_new_record_) ||
-                  (kUseReadBarrier && !self->GetWeakRefAccessEnabled()))) {
-    // Check and run the empty checkpoint before blocking so the empty checkpoint will work in the
-    // presence of threads blocking for weak ref access.
-    self->CheckEmptyCheckpointFromWeakRefAccess(Locks::alloc_tracker_lock_);
-    new_record_condition_.WaitHoldingLocks(self);
-  }
-
-  if (!heap->IsAllocTrackingEnabled()) {
-    // Return if the allocation tracking has been disabled while waiting for system weak access
-    // above.
+  if (!WaitForNewRecordsAllowed(self)) {
     return;
   }
 
   DCHECK_LE(Size(), alloc_record_max_);
 
-  // Erase extra unfilled elements.
-  trace.SetTid(self->GetTid());
+  if (buffer != nullptr) {
+    MergeThreadLocalBuffer(buffer);
+  }
 
   // Add the record.
   Put(obj->Ptr(), AllocRecord(byte_count, (*obj)->GetClass(), std::move(trace)));
   DCHECK_LE(Size(), alloc_record_max_);
 }
 
+void AllocRecordObjectMap::MergeThreadLocalBuffer(AllocRecordThreadLocalBuffer* buffer) {
+  if (buffer->epoch_ == epoch_.LoadRelaxed()) {
+    for (EntryPair& entry : buffer->entries_) {
+      // Do not record for DDM thread.
+      if (entry.second.GetTid() != alloc_ddm_thread_id_) {
+        PutEntry(std::move(entry));
+      }
+    }
+  }
+  buffer->entries_.clear();
+  buffer->epoch_ = epoch_.LoadRelaxed();
+}
+
+void AllocRecordObjectMap::MergeAllThreadLocalBuffers(Thread* self) {
+  if (GetSampleInterval() == 0u) {
+    return;
+  }
+  MutexLock mu(self, *Locks::thread_list_lock_);
+  for (Thread* thread : Runtime::Current()->GetThreadList()->GetList()) {
+    AllocRecordThreadLocalBuffer* buffer = thread->GetAllocRecordBuffer();
+    if (buffer != nullptr) {
+      MergeThreadLocalBuffer(buffer);
+    }
+  }
+}
+
+void AllocRecordObjectMap::FlushThreadLocalRecords(Thread* self) {
+  AllocRecordThreadLocalBuffer* buffer = self->GetAllocRecordBuffer();
+  if (buffer == nullptr || buffer->entries_.empty()) {
+    return;
+  }
+  MutexLock mu(self, *Locks::alloc_tracker_lock_);
+  Heap* const heap = Runtime::Current()->GetHeap();
+  AllocRecordObjectMap* records = heap->GetAllocationRecords();
+  if (heap->IsAllocTrackingEnabled() && records->WaitForNewRecordsAllowed(self)) {
+    records->MergeThreadLocalBuffer(buffer);
+  } else {
+    buffer->entries_.clear();
+  }
+}
+
 void AllocRecordObjectMap::Clear() {
   entries_.clear();
+  epoch_.FetchAndAddRelaxed(1u);
 }
 
 AllocRecordObjectMap::AllocRecordObjectMap()
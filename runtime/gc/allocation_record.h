@@ -19,7 +19,9 @@
 
 #include <list>
 #include <memory>
+#include <vector>
 
+#include "atomic.h"
 #include "base/mutex.h"
 #include "obj_ptr.h"
 #include "gc_root.h"
@@ -37,6 +39,8 @@ namespace mirror {
 
 namespace gc {
 
+class AllocRecordThreadLocalBuffer;
+
 class AllocRecordStackTraceElement {
  public:
   int32_t ComputeLineNumber() const REQUIRES_SHARED(Locks::mutator_lock_);
@@ -218,16 +222,30 @@ class AllocRecordObjectMap {
 
   static void SetAllocTrackingEnabled(bool enabled) REQUIRES(!Locks::alloc_tracker_lock_);
 
+  // Merges the sampled records self has not merged yet, called when self is exiting.
+  static void FlushThreadLocalRecords(Thread* self)
+      REQUIRES(!Locks::alloc_tracker_lock_)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
+  // If sample_interval is non-zero, only record on average one allocation per sample_interval
+  // allocated bytes of each thread, with geometrically distributed intervals so that allocations
+  // of all sizes get sampled proportionally to their bytes. The sampled records are added to the
+  // thread's buffer without locking and merged into the map in batches or when the GC sweeps.
+  void SetSampleInterval(size_t sample_interval) REQUIRES(Locks::alloc_tracker_lock_) {
+    sample_interval_.StoreRelaxed(sample_interval);
+  }
+
+  size_t GetSampleInterval() const {
+    return sample_interval_.LoadRelaxed();
+  }
+
   AllocRecordObjectMap() REQUIRES(Locks::alloc_tracker_lock_);
   ~AllocRecordObjectMap();
 
   void Put(mirror::Object* obj, AllocRecord&& record)
       REQUIRES_SHARED(Locks::mutator_lock_)
       REQUIRES(Locks::alloc_tracker_lock_) {
-    if (entries_.size() == alloc_record_max_) {
-      entries_.pop_front();
-    }
-    entries_.push_back(EntryPair(GcRoot<mirror::Object>(obj), std::move(record)));
+    PutEntry(EntryPair(GcRoot<mirror::Object>(obj), std::move(record)));
   }
 
   size_t Size() const REQUIRES_SHARED(Locks::alloc_tracker_lock_) {
@@ -295,16 +313,59 @@ class AllocRecordObjectMap {
   static constexpr size_t kDefaultNumRecentRecords = 64 * 1024 - 1;
   static constexpr size_t kDefaultAllocStackDepth = 16;
   static constexpr size_t kMaxSupportedStackDepth = 128;
+  // Number of sampled records a thread buffers before merging them.
+  static constexpr size_t kThreadLocalRecordCount = 32;
   size_t alloc_record_max_ GUARDED_BY(Locks::alloc_tracker_lock_) = kDefaultNumAllocRecords;
   size_t recent_record_max_ GUARDED_BY(Locks::alloc_tracker_lock_) = kDefaultNumRecentRecords;
   size_t max_stack_depth_ = kDefaultAllocStackDepth;
   pid_t alloc_ddm_thread_id_  GUARDED_BY(Locks::alloc_tracker_lock_) = 0;
-  bool allow_new_record_ GUARDED_BY(Locks::alloc_tracker_lock_) = true;
+  // Written with the lock held, but also read by sampling threads without it.
+  Atomic<bool> allow_new_record_{true};
+  Atomic<size_t> sample_interval_{0};
+  // Incremented by Clear() so that records still buffered by threads get dropped.
+  Atomic<uint32_t> epoch_{0};
   ConditionVariable new_record_condition_ GUARDED_BY(Locks::alloc_tracker_lock_);
   // see the comment in typedef of EntryList
   EntryList entries_ GUARDED_BY(Locks::alloc_tracker_lock_);
 
   void SetProperties() REQUIRES(Locks::alloc_tracker_lock_);
+
+  void PutEntry(EntryPair&& entry) REQUIRES(Locks::alloc_tracker_lock_) {
+    if (entries_.size() == alloc_record_max_) {
+      entries_.pop_front();
+    }
+    entries_.push_back(std::move(entry));
+  }
+
+  // Waits until new records are allowed. Returns false if tracking got disabled meanwhile.
+  bool WaitForNewRecordsAllowed(Thread* self)
+      REQUIRES_SHARED(Locks::mutator_lock_)
+      REQUIRES(Locks::alloc_tracker_lock_);
+
+  // Counts an allocation against the sampling countdown of buffer. Returns true if it is sampled.
+  bool SampleAllocation(AllocRecordThreadLocalBuffer* buffer, size_t byte_count);
+
+  // Moves the records of buffer into entries_. The owner of buffer must not be adding records.
+  void MergeThreadLocalBuffer(AllocRecordThreadLocalBuffer* buffer)
+      REQUIRES(Locks::alloc_tracker_lock_);
+  void MergeAllThreadLocalBuffers(Thread* self) REQUIRES(Locks::alloc_tracker_lock_);
+
+  friend class AllocRecordThreadLocalBuffer;
+};
+
+// The sampling state and not yet merged sampled records of a thread.
+class AllocRecordThreadLocalBuffer {
+ public:
+  explicit AllocRecordThreadLocalBuffer(pid_t tid);
+
+ private:
+  size_t bytes_until_sample_;
+  uint64_t random_state_;
+  uint32_t epoch_;
+  std::vector<AllocRecordObjectMap::EntryPair> entries_;
+
+  friend class AllocRecordObjectMap;
+  DISALLOW_COPY_AND_ASSIGN(AllocRecordThreadLocalBuffer);
 };
 
 }  // namespace gc
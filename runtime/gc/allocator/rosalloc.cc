@@ -16,9 +16,13 @@
 
 #include "rosalloc.h"
 
+#include <algorithm>
 #include <map>
+#include <limits>
 #include <list>
+#include <sched.h>
 #include <sstream>
+#include <unistd.h>
 #include <vector>
 
 #include "android-base/stringprintf.h"
@@ -61,7 +65,8 @@ RosAlloc::RosAlloc(void* base, size_t capacity, size_t max_capacity,
       bulk_free_lock_("rosalloc bulk free lock", kRosAllocBulkFreeLock),
       page_release_mode_(page_release_mode),
       page_release_size_threshold_(page_release_size_threshold),
-      is_running_on_memory_tool_(running_on_memory_tool) {
+      is_running_on_memory_tool_(running_on_memory_tool),
+      num_per_cpu_runs_(0) {
   DCHECK_ALIGNED(base, kPageSize);
   DCHECK_EQ(RoundUp(capacity, kPageSize), capacity);
   DCHECK_EQ(RoundUp(max_capacity, kPageSize), max_capacity);
@@ -119,6 +124,9 @@ RosAlloc::~RosAlloc() {
   for (size_t i = 0; i < kNumOfSizeBrackets; i++) {
     delete size_bracket_locks_[i];
   }
+  for (size_t cpu = 0; cpu < num_per_cpu_runs_; ++cpu) {
+    delete per_cpu_runs_[cpu].lock;
+  }
   if (is_running_on_memory_tool_) {
     MEMORY_TOOL_MAKE_DEFINED(base_, capacity_);
   }
@@ -657,7 +665,14 @@ void* RosAlloc::AllocFromRun(Thread* self, size_t size, size_t* bytes_allocated,
   size_t bracket_size;
   size_t idx = SizeToIndexAndBracketSize(size, &bracket_size);
   void* slot_addr;
-  if (LIKELY(idx < kNumThreadLocalSizeBrackets)) {
+  if (LIKELY(idx < kNumThreadLocalSizeBrackets) && UNLIKELY(UsesPerCpuRuns())) {
+    // Use the run of the current CPU.
+    slot_addr = AllocFromPerCpuRun(self, idx, bytes_tl_bulk_allocated);
+    if (LIKELY(slot_addr != nullptr)) {
+      *bytes_allocated = bracket_size;
+      *usable_size = bracket_size;
+    }
+  } else if (LIKELY(idx < kNumThreadLocalSizeBrackets)) {
     // Use a thread-local run.
     Run* thread_local_run = reinterpret_cast<Run*>(self->GetRosAllocRun(idx));
     // Allow invalid since this will always fail the allocation.
@@ -674,44 +689,13 @@ void* RosAlloc::AllocFromRun(Thread* self, size_t size, size_t* bytes_allocated,
     DCHECK(thread_local_run != dedicated_full_run_ || slot_addr == nullptr)
         << "allocated from an invalid run";
     if (UNLIKELY(slot_addr == nullptr)) {
-      // The run got full. Try to free slots.
-      DCHECK(thread_local_run->IsFull());
-      MutexLock mu(self, *size_bracket_locks_[idx]);
-      bool is_all_free_after_merge;
-      // This is safe to do for the dedicated_full_run_ since the bitmaps are empty.
-      if (thread_local_run->MergeThreadLocalFreeListToFreeList(&is_all_free_after_merge)) {
-        DCHECK_NE(thread_local_run, dedicated_full_run_);
-        // Some slot got freed. Keep it.
-        DCHECK(!thread_local_run->IsFull());
-        DCHECK_EQ(is_all_free_after_merge, thread_local_run->IsAllFree());
-      } else {
-        // No slots got freed. Try to refill the thread-local run.
-        DCHECK(thread_local_run->IsFull());
-        if (thread_local_run != dedicated_full_run_) {
-          thread_local_run->SetIsThreadLocal(false);
-          if (kIsDebugBuild) {
-            full_runs_[idx].insert(thread_local_run);
-            if (kTraceRosAlloc) {
-              LOG(INFO) << "RosAlloc::AllocFromRun() : Inserted run 0x" << std::hex
-                        << reinterpret_cast<intptr_t>(thread_local_run)
-                        << " into full_runs_[" << std::dec << idx << "]";
-            }
-          }
-          DCHECK(non_full_runs_[idx].find(thread_local_run) == non_full_runs_[idx].end());
-          DCHECK(full_runs_[idx].find(thread_local_run) != full_runs_[idx].end());
-        }
-
-        thread_local_run = RefillRun(self, idx);
-        if (UNLIKELY(thread_local_run == nullptr)) {
-          self->SetRosAllocRun(idx, dedicated_full_run_);
-          return nullptr;
-        }
-        DCHECK(non_full_runs_[idx].find(thread_local_run) == non_full_runs_[idx].end());
-        DCHECK(full_runs_[idx].find(thread_local_run) == full_runs_[idx].end());
-        thread_local_run->SetIsThreadLocal(true);
-        self->SetRosAllocRun(idx, thread_local_run);
-        DCHECK(!thread_local_run->IsFull());
+      // The run got full. Try to free slots or refill the thread-local run.
+      thread_local_run = RefreshThreadLocalRun(self, idx, thread_local_run);
+      if (UNLIKELY(thread_local_run == nullptr)) {
+        self->SetRosAllocRun(idx, dedicated_full_run_);
+        return nullptr;
       }
+      self->SetRosAllocRun(idx, thread_local_run);
       DCHECK(thread_local_run != nullptr);
       DCHECK(!thread_local_run->IsFull());
       DCHECK(thread_local_run->IsThreadLocal());
@@ -753,6 +737,125 @@ void* RosAlloc::AllocFromRun(Thread* self, size_t size, size_t* bytes_allocated,
   return slot_addr;
 }
 
+RosAlloc::Run* RosAlloc::RefreshThreadLocalRun(Thread* self, size_t idx, Run* run) {
+  DCHECK(run->IsFull());
+  MutexLock mu(self, *size_bracket_locks_[idx]);
+  bool is_all_free_after_merge;
+  // This is safe to do for the dedicated_full_run_ since the bitmaps are empty.
+  if (run->MergeThreadLocalFreeListToFreeList(&is_all_free_after_merge)) {
+    DCHECK_NE(run, dedicated_full_run_);
+    // Some slot got freed. Keep it.
+    DCHECK(!run->IsFull());
+    DCHECK_EQ(is_all_free_after_merge, run->IsAllFree());
+    return run;
+  }
+  // No slots got freed. Try to refill the thread-local run.
+  DCHECK(run->IsFull());
+  if (run != dedicated_full_run_) {
+    run->SetIsThreadLocal(false);
+    if (kIsDebugBuild) {
+      full_runs_[idx].insert(run);
+      if (kTraceRosAlloc) {
+        LOG(INFO) << "RosAlloc::AllocFromRun() : Inserted run 0x" << std::hex
+                  << reinterpret_cast<intptr_t>(run)
+                  << " into full_runs_[" << std::dec << idx << "]";
+      }
+    }
+    DCHECK(non_full_runs_[idx].find(run) == non_full_runs_[idx].end());
+    DCHECK(full_runs_[idx].find(run) != full_runs_[idx].end());
+  }
+  run = RefillRun(self, idx);
+  if (UNLIKELY(run == nullptr)) {
+    return nullptr;
+  }
+  DCHECK(non_full_runs_[idx].find(run) == non_full_runs_[idx].end());
+  DCHECK(full_runs_[idx].find(run) == full_runs_[idx].end());
+  run->SetIsThreadLocal(true);
+  DCHECK(!run->IsFull());
+  return run;
+}
+
+void RosAlloc::EnablePerCpuRuns() {
+  if (UsesPerCpuRuns()) {
+    return;
+  }
+  long num_cpus = sysconf(_SC_NPROCESSORS_CONF);  // NOLINT
+  num_per_cpu_runs_ = num_cpus > 0 ? static_cast<size_t>(num_cpus) : 1U;
+  per_cpu_runs_.reset(new PerCpuRuns[num_per_cpu_runs_]);
+  for (size_t cpu = 0; cpu < num_per_cpu_runs_; ++cpu) {
+    per_cpu_runs_[cpu].lock = new Mutex("rosalloc per-cpu run lock", kRosAllocPerCpuLock);
+    std::fill_n(per_cpu_runs_[cpu].runs, kNumThreadLocalSizeBrackets, dedicated_full_run_);
+  }
+}
+
+RosAlloc::PerCpuRuns* RosAlloc::GetCurrentCpuRuns() const {
+  // The thread may migrate right after this. That only costs some contention on the lock of the
+  // previous CPU.
+  int cpu = sched_getcpu();
+  return &per_cpu_runs_[cpu >= 0 ? static_cast<size_t>(cpu) % num_per_cpu_runs_ : 0U];
+}
+
+void* RosAlloc::AllocFromPerCpuRun(Thread* self, size_t idx, size_t* bytes_tl_bulk_allocated) {
+  DCHECK_LT(idx, kNumThreadLocalSizeBrackets);
+  PerCpuRuns* cpu_runs = GetCurrentCpuRuns();
+  MutexLock mu(self, *cpu_runs->lock);
+  // A per-CPU run is marked as thread-local so that the frees and BulkFree() treat it as such.
+  Run* run = cpu_runs->runs[idx];
+  DCHECK(run->IsThreadLocal() || run == dedicated_full_run_);
+  void* slot_addr = run->AllocSlot();
+  if (LIKELY(slot_addr != nullptr)) {
+    // The slot is already counted.
+    *bytes_tl_bulk_allocated = 0;
+    return slot_addr;
+  }
+  run = RefreshThreadLocalRun(self, idx, run);
+  if (UNLIKELY(run == nullptr)) {
+    cpu_runs->runs[idx] = dedicated_full_run_;
+    return nullptr;
+  }
+  cpu_runs->runs[idx] = run;
+  // Account for all the free slots in the new or refreshed per-CPU run.
+  *bytes_tl_bulk_allocated = run->NumberOfFreeSlots() * bracketSizes[idx];
+  slot_addr = run->AllocSlot();
+  // Must succeed now with a new run.
+  DCHECK(slot_addr != nullptr);
+  return slot_addr;
+}
+
+size_t RosAlloc::RevokePerCpuRuns() {
+  Thread* self = Thread::Current();
+  size_t free_bytes = 0U;
+  for (size_t cpu = 0; cpu < num_per_cpu_runs_; ++cpu) {
+    MutexLock cpu_mu(self, *per_cpu_runs_[cpu].lock);
+    for (size_t idx = 0; idx < kNumThreadLocalSizeBrackets; ++idx) {
+      Run* run = per_cpu_runs_[cpu].runs[idx];
+      if (run == dedicated_full_run_) {
+        continue;
+      }
+      MutexLock mu(self, *size_bracket_locks_[idx]);
+      DCHECK(run->IsThreadLocal());
+      per_cpu_runs_[cpu].runs[idx] = dedicated_full_run_;
+      free_bytes += run->NumberOfFreeSlots() * bracketSizes[idx];
+      // See RevokeThreadLocalRuns() for why the bulk free list needs no merge here.
+      bool dont_care;
+      run->MergeThreadLocalFreeListToFreeList(&dont_care);
+      run->SetIsThreadLocal(false);
+      RevokeRun(self, idx, run);
+    }
+  }
+  return free_bytes;
+}
+
+bool RosAlloc::IsPerCpuRun(Run* run) const {
+  // Only used by Verify() with the mutators suspended, so no need to lock the per-CPU runs.
+  for (size_t cpu = 0; cpu < num_per_cpu_runs_; ++cpu) {
+    if (per_cpu_runs_[cpu].runs[run->size_bracket_idx_] == run) {
+      return true;
+    }
+  }
+  return false;
+}
+
 size_t RosAlloc::FreeFromRun(Thread* self, void* ptr, Run* run) {
   DCHECK_EQ(run->magic_num_, kMagicNum);
   DCHECK_LT(run, ptr);
@@ -1588,6 +1691,7 @@ size_t RosAlloc::RevokeAllThreadLocalRuns() {
   for (Thread* thread : thread_list) {
     free_bytes += RevokeThreadLocalRuns(thread);
   }
+  free_bytes += RevokePerCpuRuns();
   RevokeThreadUnsafeCurrentRuns();
   return free_bytes;
 }
@@ -1618,6 +1722,12 @@ void RosAlloc::AssertAllThreadLocalRunsAreRevoked() {
       MutexLock brackets_mu(self, *size_bracket_locks_[idx]);
       CHECK_EQ(current_runs_[idx], dedicated_full_run_);
     }
+    for (size_t cpu = 0; cpu < num_per_cpu_runs_; ++cpu) {
+      MutexLock cpu_mu(self, *per_cpu_runs_[cpu].lock);
+      for (size_t idx = 0; idx < kNumThreadLocalSizeBrackets; ++idx) {
+        CHECK_EQ(per_cpu_runs_[cpu].runs[idx], dedicated_full_run_);
+      }
+    }
   }
 }
 
@@ -1896,6 +2006,10 @@ void RosAlloc::Run::Verify(Thread* self, RosAlloc* rosalloc, bool running_on_mem
         }
       }
     }
+    if (!owner_found && rosalloc->UsesPerCpuRuns()) {
+      // Or by a CPU.
+      owner_found = rosalloc->IsPerCpuRun(this);
+    }
     CHECK(owner_found) << "A thread local run has no owner thread " << Dump();
   } else {
     // If it's not thread local, check that the thread local free list is empty.
@@ -1979,12 +2093,20 @@ void RosAlloc::Run::Verify(Thread* self, RosAlloc* rosalloc, bool running_on_mem
 
 size_t RosAlloc::ReleasePages() {
   VLOG(heap) << "RosAlloc::ReleasePages()";
+  size_t cursor = 0;
+  return ReleasePages(&cursor, std::numeric_limits<size_t>::max());
+}
+
+size_t RosAlloc::ReleasePages(size_t* cursor, size_t max_pages) {
   DCHECK(!DoesReleaseAllPages());
   Thread* self = Thread::Current();
   size_t reclaimed_bytes = 0;
-  size_t i = 0;
+  size_t i = *cursor;
+  const size_t slice_end = (max_pages > std::numeric_limits<size_t>::max() - i)
+      ? std::numeric_limits<size_t>::max()
+      : i + max_pages;
   // Check the page map size which might have changed due to grow/shrink.
-  while (i < page_map_size_) {
+  while (i < page_map_size_ && i < slice_end) {
     // Reading the page map without a lock is racy but the race is benign since it should only
     // result in occasionally not releasing pages which we could release.
     uint8_t pm = page_map_[i];
@@ -2030,6 +2152,7 @@ size_t RosAlloc::ReleasePages() {
         break;
     }
   }
+  *cursor = (i < page_map_size_) ? i : 0U;
   return reclaimed_bytes;
 }
 
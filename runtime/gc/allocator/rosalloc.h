@@ -732,6 +732,14 @@ class RosAlloc {
   Mutex* size_bracket_locks_[kNumOfSizeBrackets];
   // Bracket lock names (since locks only have char* names).
   std::string size_bracket_lock_names_[kNumOfSizeBrackets];
+  // The runs of the thread-local size brackets shared by the threads running on the same CPU,
+  // which replace the thread-local runs after EnablePerCpuRuns(). runs[i] is guarded by lock.
+  struct PerCpuRuns {
+    Mutex* lock;
+    Run* runs[kNumThreadLocalSizeBrackets];
+  };
+  std::unique_ptr<PerCpuRuns[]> per_cpu_runs_;
+  size_t num_per_cpu_runs_;
   // The types of page map entries.
   enum PageMapKind {
     kPageMapReleased = 0,     // Zero and released back to the OS.
@@ -823,6 +831,18 @@ class RosAlloc {
   // Dumps the page map for debugging.
   std::string DumpPageMap() REQUIRES(lock_);
 
+  // Called when the thread-local or per-CPU run `run` of the size bracket idx is full. Merges the
+  // thread-local free list into the free list or replaces the run with a new one, and returns the
+  // run to allocate from. Returns null if out of memory.
+  Run* RefreshThreadLocalRun(Thread* self, size_t idx, Run* run) REQUIRES(!lock_);
+  // Allocates a slot of the thread-local size bracket idx from the run of the current CPU.
+  void* AllocFromPerCpuRun(Thread* self, size_t idx, size_t* bytes_tl_bulk_allocated)
+      REQUIRES(!lock_);
+  // Returns the per-CPU runs of the CPU the calling thread runs on.
+  PerCpuRuns* GetCurrentCpuRuns() const;
+  // Returns true if run is one of the per-CPU runs. For Verify().
+  bool IsPerCpuRun(Run* run) const;
+
  public:
   RosAlloc(void* base, size_t capacity, size_t max_capacity,
            PageReleaseMode page_release_mode,
@@ -886,6 +906,10 @@ class RosAlloc {
 
   // Release empty pages.
   size_t ReleasePages() REQUIRES(!lock_);
+  // Release the empty pages among the next max_pages pages of the page map starting at page
+  // *cursor. Updates *cursor to the page to continue from, or to 0 once the end of the page map is
+  // reached. Returns the number of bytes released.
+  size_t ReleasePages(size_t* cursor, size_t max_pages) REQUIRES(!lock_);
   // Returns the current footprint.
   size_t Footprint() REQUIRES(!lock_);
   // Returns the current capacity, maximum footprint.
@@ -906,6 +930,17 @@ class RosAlloc {
   // Assert all the thread local runs are revoked.
   void AssertAllThreadLocalRunsAreRevoked() REQUIRES(!Locks::thread_list_lock_, !bulk_free_lock_);
 
+  // Use per-CPU runs instead of thread-local runs for the thread-local size brackets so that the
+  // memory pinned by partially used runs scales with the number of CPUs instead of the number of
+  // threads. Must be called before the first allocation. Used by kAllocatorTypeRosAllocPerCpu.
+  void EnablePerCpuRuns();
+  bool UsesPerCpuRuns() const {
+    return per_cpu_runs_ != nullptr;
+  }
+  // Releases the per-CPU runs back to the common set of runs. Returns the total bytes of free
+  // slots in them, like RevokeThreadLocalRuns().
+  size_t RevokePerCpuRuns() REQUIRES(!lock_, !bulk_free_lock_);
+
   static Run* GetDedicatedFullRun() {
     return dedicated_full_run_;
   }
@@ -32,6 +32,7 @@ enum AllocatorType {
   kAllocatorTypeLOS,  // Large object space, also doesn't have entrypoints.
   kAllocatorTypeRegion,
   kAllocatorTypeRegionTLAB,
+  kAllocatorTypeRosAllocPerCpu,  // Use RosAlloc allocator with per-CPU runs, has entrypoints.
 };
 std::ostream& operator<<(std::ostream& os, const AllocatorType& rhs);
 
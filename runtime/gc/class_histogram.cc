@@ -0,0 +1,141 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "class_histogram.h"
+
+#include <algorithm>
+
+#include "base/bit_utils.h"
+#include "gc/accounting/space_bitmap-inl.h"
+#include "mirror/class-inl.h"
+#include "mirror/object-inl.h"
+#include "thread-current-inl.h"
+#include "utils.h"
+
+namespace art {
+namespace gc {
+
+static size_t SizeBucket(size_t size) {
+  // Sizes are at least the object alignment, 8 bytes.
+  const size_t bucket =
+      (size <= kObjectAlignment) ? 0u : static_cast<size_t>(MostSignificantBit(size)) - 3;
+  return std::min(bucket, ClassHistogram::kNumSizeBuckets - 1);
+}
+
+ClassHistogram::ClassHistogram(size_t sampling_rate)
+    : sampling_rate_(sampling_rate),
+      lock_("Class histogram lock") {
+  CHECK_GT(sampling_rate, 0u);
+}
+
+void ClassHistogram::BeginSample() {
+  pending_classes_.clear();
+  std::fill(std::begin(pending_sizes_), std::end(pending_sizes_), Counts());
+}
+
+void ClassHistogram::AddObject(mirror::Object* obj, uint64_t weight) {
+  mirror::Class* const klass = obj->GetClass<kVerifyNone, kWithoutReadBarrier>();
+  const size_t size = obj->SizeOf<kVerifyNone>();
+  Counts& counts = pending_classes_[klass];
+  counts.count += weight;
+  counts.bytes += size * weight;
+  Counts& size_counts = pending_sizes_[SizeBucket(size)];
+  size_counts.count += weight;
+  size_counts.bytes += size * weight;
+}
+
+template <size_t kAlignment>
+void ClassHistogram::SampleMarkedRange(const accounting::SpaceBitmap<kAlignment>* bitmap,
+                                       uint8_t* begin,
+                                       uint8_t* end) {
+  const uintptr_t range_begin = reinterpret_cast<uintptr_t>(begin);
+  const uintptr_t range_end = reinterpret_cast<uintptr_t>(end);
+  const size_t stride = kSampleChunkSize * sampling_rate_;
+  // Start at a random chunk so that the same objects are not always the ones sampled.
+  uintptr_t chunk = range_begin + GetRandomNumber<size_t>(0, sampling_rate_ - 1) * kSampleChunkSize;
+  for (; chunk < range_end; chunk += stride) {
+    bitmap->VisitMarkedRange(chunk,
+                             std::min(chunk + kSampleChunkSize, range_end),
+                             [this](mirror::Object* obj) REQUIRES_SHARED(Locks::mutator_lock_) {
+      AddObject(obj, sampling_rate_);
+    });
+  }
+}
+
+template <size_t kAlignment>
+void ClassHistogram::AddMarkedRange(const accounting::SpaceBitmap<kAlignment>* bitmap,
+                                    uint8_t* begin,
+                                    uint8_t* end) {
+  bitmap->VisitMarkedRange(reinterpret_cast<uintptr_t>(begin),
+                           reinterpret_cast<uintptr_t>(end),
+                           [this](mirror::Object* obj) REQUIRES_SHARED(Locks::mutator_lock_) {
+    AddObject(obj, 1u);
+  });
+}
+
+template void ClassHistogram::SampleMarkedRange<kObjectAlignment>(
+    const accounting::SpaceBitmap<kObjectAlignment>* bitmap, uint8_t* begin, uint8_t* end);
+template void ClassHistogram::AddMarkedRange<kLargeObjectAlignment>(
+    const accounting::SpaceBitmap<kLargeObjectAlignment>* bitmap, uint8_t* begin, uint8_t* end);
+
+void ClassHistogram::EndSample(const std::string& collector_name) {
+  std::vector<Entry> classes;
+  classes.reserve(pending_classes_.size());
+  for (const auto& pair : pending_classes_) {
+    classes.push_back(
+        Entry { pair.first->PrettyDescriptor(), pair.second.count, pair.second.bytes });
+  }
+  pending_classes_.clear();
+  std::sort(classes.begin(), classes.end(), [](const Entry& a, const Entry& b) {
+    return a.bytes > b.bytes;
+  });
+  MutexLock mu(Thread::Current(), lock_);
+  collector_name_ = collector_name;
+  classes_.swap(classes);
+  std::copy(std::begin(pending_sizes_), std::end(pending_sizes_), std::begin(sizes_));
+}
+
+std::vector<ClassHistogram::Entry> ClassHistogram::GetEntries() const {
+  MutexLock mu(Thread::Current(), lock_);
+  return classes_;
+}
+
+void ClassHistogram::Dump(std::ostream& os, size_t max_classes) const {
+  MutexLock mu(Thread::Current(), lock_);
+  uint64_t total_count = 0u;
+  uint64_t total_bytes = 0u;
+  for (const Counts& counts : sizes_) {
+    total_count += counts.count;
+    total_bytes += counts.bytes;
+  }
+  os << "Sampled live objects of " << collector_name_ << " (1 in " << sampling_rate_ << "): count="
+     << total_count << " bytes=" << total_bytes << "\n";
+  os << "MinSize\tCount\tBytes\n";
+  for (size_t i = 0; i < kNumSizeBuckets; ++i) {
+    if (sizes_[i].count == 0) {
+      continue;
+    }
+    os << (kObjectAlignment << i) << (i + 1 < kNumSizeBuckets ? "\t" : "+\t") << sizes_[i].count
+       << "\t" << sizes_[i].bytes << "\n";
+  }
+  os << "Class\tCount\tBytes\n";
+  for (size_t i = 0; i < std::min(max_classes, classes_.size()); ++i) {
+    os << classes_[i].descriptor << "\t" << classes_[i].count << "\t" << classes_[i].bytes << "\n";
+  }
+}
+
+}  // namespace gc
+}  // namespace art
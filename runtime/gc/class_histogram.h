@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_GC_CLASS_HISTOGRAM_H_
+#define ART_RUNTIME_GC_CLASS_HISTOGRAM_H_
+
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "base/mutex.h"
+#include "gc/accounting/space_bitmap.h"
+
+namespace art {
+
+namespace mirror {
+class Class;
+class Object;
+}  // namespace mirror
+
+namespace gc {
+
+// Estimates the live bytes and objects per class, and an object size histogram, from a sample of
+// the objects a collector found live. Collectors call BeginSample() after marking, feed the
+// sample from their mark bitmaps and evacuated regions, and publish it with EndSample(). The
+// result of the last collection can be read at any time.
+class ClassHistogram {
+ public:
+  // The bitmaps are sampled in chunks of this many bytes.
+  static constexpr size_t kSampleChunkSize = kPageSize;
+  // Objects of [8 << i, 8 << (i + 1)) bytes go in size bucket i, the last bucket is unbounded.
+  static constexpr size_t kNumSizeBuckets = 20;
+
+  struct Entry {
+    std::string descriptor;
+    uint64_t count;
+    uint64_t bytes;
+  };
+
+  explicit ClassHistogram(size_t sampling_rate);
+
+  size_t GetSamplingRate() const {
+    return sampling_rate_;
+  }
+
+  // Collector side, only called by the thread running the GC.
+  void BeginSample();
+  // Record a sampled object, standing for weight objects like it.
+  void AddObject(mirror::Object* obj, uint64_t weight) REQUIRES_SHARED(Locks::mutator_lock_);
+  // Sample the objects marked in [begin, end) of the bitmap, walking one out of sampling_rate
+  // chunks of kSampleChunkSize bytes.
+  template <size_t kAlignment>
+  void SampleMarkedRange(const accounting::SpaceBitmap<kAlignment>* bitmap,
+                         uint8_t* begin,
+                         uint8_t* end) REQUIRES_SHARED(Locks::mutator_lock_);
+  // Record every object marked in [begin, end) of the bitmap. Used for the large objects, which
+  // are too few to sample.
+  template <size_t kAlignment>
+  void AddMarkedRange(const accounting::SpaceBitmap<kAlignment>* bitmap,
+                      uint8_t* begin,
+                      uint8_t* end) REQUIRES_SHARED(Locks::mutator_lock_);
+  // Resolve the class names and publish the sample of the collection.
+  void EndSample(const std::string& collector_name)
+      REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(!lock_);
+
+  // The last published sample, sorted by decreasing bytes.
+  std::vector<Entry> GetEntries() const REQUIRES(!lock_);
+  // Write the last published sample as tab separated tables of the size buckets and the classes.
+  void Dump(std::ostream& os, size_t max_classes = 100) const REQUIRES(!lock_);
+
+ private:
+  struct Counts {
+    uint64_t count = 0u;
+    uint64_t bytes = 0u;
+  };
+
+  const size_t sampling_rate_;
+
+  // The sample being taken, keyed by class since the names are only looked up at the end.
+  std::unordered_map<mirror::Class*, Counts> pending_classes_;
+  Counts pending_sizes_[kNumSizeBuckets];
+
+  mutable Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  std::string collector_name_ GUARDED_BY(lock_);
+  std::vector<Entry> classes_ GUARDED_BY(lock_);
+  Counts sizes_[kNumSizeBuckets] GUARDED_BY(lock_);
+
+  DISALLOW_COPY_AND_ASSIGN(ClassHistogram);
+};
+
+}  // namespace gc
+}  // namespace art
+
+#endif  // ART_RUNTIME_GC_CLASS_HISTOGRAM_H_
@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "class_histogram.h"
+
+#include <sstream>
+
+#include "common_runtime_test.h"
+#include "gc/accounting/space_bitmap-inl.h"
+#include "handle_scope-inl.h"
+#include "mirror/object-inl.h"
+#include "mirror/string.h"
+#include "scoped_thread_state_change-inl.h"
+
+namespace art {
+namespace gc {
+
+class ClassHistogramTest : public CommonRuntimeTest {};
+
+TEST_F(ClassHistogramTest, AddObjects) {
+  ScopedObjectAccess soa(Thread::Current());
+  VariableSizedHandleScope hs(soa.Self());
+  Handle<mirror::String> string(
+      hs.NewHandle(mirror::String::AllocFromModifiedUtf8(soa.Self(), "a string")));
+  Handle<mirror::Class> klass(hs.NewHandle(string->GetClass()));
+  ClassHistogram histogram(4u);
+  histogram.BeginSample();
+  histogram.AddObject(string.Get(), 4u);
+  histogram.AddObject(string.Get(), 4u);
+  histogram.AddObject(klass.Get(), 1u);
+  // Nothing is published before the sample ends.
+  EXPECT_TRUE(histogram.GetEntries().empty());
+  histogram.EndSample("test");
+  std::vector<ClassHistogram::Entry> entries = histogram.GetEntries();
+  ASSERT_EQ(entries.size(), 2u);
+  // Sorted by decreasing bytes.
+  const bool string_first = 8 * string->SizeOf() >= klass->SizeOf();
+  const ClassHistogram::Entry& strings = entries[string_first ? 0 : 1];
+  EXPECT_EQ(strings.descriptor, "java.lang.String");
+  EXPECT_EQ(strings.count, 8u);
+  EXPECT_EQ(strings.bytes, 8 * string->SizeOf());
+  const ClassHistogram::Entry& classes = entries[string_first ? 1 : 0];
+  EXPECT_EQ(classes.descriptor, "java.lang.Class");
+  EXPECT_EQ(classes.count, 1u);
+  EXPECT_EQ(classes.bytes, klass->SizeOf());
+  std::ostringstream oss;
+  histogram.Dump(oss);
+  EXPECT_NE(oss.str().find("java.lang.String\t8\t"), std::string::npos) << oss.str();
+  // A new sample replaces the previous one.
+  histogram.BeginSample();
+  histogram.EndSample("test");
+  EXPECT_TRUE(histogram.GetEntries().empty());
+}
+
+TEST_F(ClassHistogramTest, SampleMarkedRange) {
+  ScopedObjectAccess soa(Thread::Current());
+  VariableSizedHandleScope hs(soa.Self());
+  Handle<mirror::String> string(
+      hs.NewHandle(mirror::String::AllocFromModifiedUtf8(soa.Self(), "a string")));
+  uint8_t* const begin = AlignDown(reinterpret_cast<uint8_t*>(string.Get()), kPageSize);
+  std::unique_ptr<accounting::ContinuousSpaceBitmap> bitmap(
+      accounting::ContinuousSpaceBitmap::Create("class histogram test bitmap", begin, kPageSize));
+  bitmap->Set(string.Get());
+  // With a sampling rate of 1 every chunk is walked.
+  ClassHistogram histogram(1u);
+  histogram.BeginSample();
+  histogram.SampleMarkedRange(bitmap.get(), begin, begin + kPageSize);
+  histogram.EndSample("test");
+  std::vector<ClassHistogram::Entry> entries = histogram.GetEntries();
+  ASSERT_EQ(entries.size(), 1u);
+  EXPECT_EQ(entries[0].descriptor, "java.lang.String");
+  EXPECT_EQ(entries[0].count, 1u);
+  EXPECT_EQ(entries[0].bytes, string->SizeOf());
+}
+
+}  // namespace gc
+}  // namespace art
@@ -27,9 +27,11 @@
 #include "gc/accounting/mod_union_table-inl.h"
 #include "gc/accounting/read_barrier_table.h"
 #include "gc/accounting/space_bitmap-inl.h"
+#include "gc/class_histogram.h"
 #include "gc/gc_pause_listener.h"
 #include "gc/reference_processor.h"
 #include "gc/space/image_space.h"
+#include "gc/space/region_space-inl.h"
 #include "gc/space/space-inl.h"
 #include "gc/verification.h"
 #include "image-inl.h"
@@ -40,6 +42,7 @@
 #include "scoped_thread_state_change-inl.h"
 #include "thread-inl.h"
 #include "thread_list.h"
+#include "thread_pool.h"
 #include "well_known_classes.h"
 
 namespace art {
@@ -61,6 +64,7 @@ static constexpr size_t kReadBarrierMarkStackSize = 512 * KB;
 static constexpr bool kVerifyNoMissingCardMarks = kIsDebugBuild;
 
 ConcurrentCopying::ConcurrentCopying(Heap* heap,
+                                     bool young_gen,
                                      const std::string& name_prefix,
                                      bool measure_read_barrier_slow_path)
     : GarbageCollector(heap,
@@ -76,6 +80,11 @@ ConcurrentCopying::ConcurrentCopying(Heap* heap,
       rb_mark_bit_stack_full_(false),
       mark_stack_lock_("concurrent copying mark stack lock", kMarkSweepMarkStackLock),
       thread_running_gc_(nullptr),
+      parallel_marking_active_(false),
+      parallel_marking_busy_workers_(0u),
+      parallel_marking_count_(0u),
+      cumulative_parallel_marking_rounds_(0u),
+      cumulative_bytes_copied_by_gc_thread_(0u),
       is_marking_(false),
       is_using_read_barrier_entrypoints_(false),
       is_active_(false),
@@ -99,11 +108,18 @@ ConcurrentCopying::ConcurrentCopying(Heap* heap,
       rb_slow_path_count_gc_total_(0),
       rb_table_(heap_->GetReadBarrierTable()),
       force_evacuate_all_(false),
+      young_gen_(young_gen),
+      use_generational_cc_(heap->UseGenerationalConcurrentCopying()),
       gc_grays_immune_objects_(false),
       immune_gray_stack_lock_("concurrent copying immune gray stack lock",
                               kMarkSweepMarkStackLock) {
   static_assert(space::RegionSpace::kRegionSize == accounting::ReadBarrierTable::kRegionSize,
                 "The region space size and the read barrier table region size must match");
+  if (young_gen_) {
+    // The young collection grays the old objects on dirty cards like the dirty immune objects.
+    CHECK(use_generational_cc_);
+    CHECK(kUseBakerReadBarrier && kGrayDirtyImmuneObjects);
+  }
   Thread* self = Thread::Current();
   {
     ReaderMutexLock mu(self, *Locks::heap_bitmap_lock_);
@@ -172,6 +188,10 @@ void ConcurrentCopying::RunPhases() {
     // the pause.
     ReaderMutexLock mu(self, *Locks::mutator_lock_);
     GrayAllDirtyImmuneObjects();
+    if (young_gen_) {
+      // Likewise for the old objects that may reference objects in the newly allocated regions.
+      GrayAllDirtyOldObjects();
+    }
   }
   FlipThreadRoots();
   {
@@ -268,7 +288,21 @@ void ConcurrentCopying::BindBitmaps() {
       // It is OK to clear the bitmap with mutators running since the only place it is read is
       // VisitObjects which has exclusion with CC.
       region_space_bitmap_ = region_space_->GetMarkBitmap();
-      region_space_bitmap_->Clear();
+      if (!young_gen_) {
+        region_space_bitmap_->Clear();
+      }
+      // Otherwise the bitmap still holds the objects that survived the previous collections,
+      // which a young collection considers live.
+    } else if (young_gen_ && space->IsContinuousMemMapAllocSpace()) {
+      // Like StickyMarkSweep, treat the objects that were live after the last GC as marked so
+      // that only the objects allocated since then get swept.
+      space->GetMarkBitmap()->CopyFrom(space->GetLiveBitmap());
+    }
+  }
+  if (young_gen_) {
+    for (space::DiscontinuousSpace* space : heap_->GetDiscontinuousSpaces()) {
+      CHECK(space->IsLargeObjectSpace());
+      space->AsLargeObjectSpace()->CopyLiveToMarked();
     }
   }
 }
@@ -298,7 +332,10 @@ void ConcurrentCopying::InitializePhase() {
   bytes_moved_.StoreRelaxed(0);
   objects_moved_.StoreRelaxed(0);
   GcCause gc_cause = GetCurrentIteration()->GetGcCause();
-  if (gc_cause == kGcCauseExplicit ||
+  if (young_gen_) {
+    // A young collection never evacuates the old regions.
+    force_evacuate_all_ = false;
+  } else if (gc_cause == kGcCauseExplicit ||
       gc_cause == kGcCauseForNativeAllocBlocking ||
       gc_cause == kGcCauseCollectorTransition ||
       GetCurrentIteration()->GetClearSoftReferences()) {
@@ -419,7 +456,17 @@ class ConcurrentCopying::FlipCallback : public Closure {
     Locks::mutator_lock_->AssertExclusiveHeld(self);
     {
       TimingLogger::ScopedTiming split2("(Paused)SetFromSpace", cc->GetTimings());
-      cc->region_space_->SetFromSpace(cc->rb_table_, cc->force_evacuate_all_);
+      space::RegionSpace::EvacMode evac_mode =
+          space::RegionSpace::EvacMode::kEvacModeLivePercentNewlyAllocated;
+      if (cc->young_gen_) {
+        evac_mode = space::RegionSpace::EvacMode::kEvacModeNewlyAllocated;
+      } else if (cc->force_evacuate_all_) {
+        evac_mode = space::RegionSpace::EvacMode::kEvacModeForceAll;
+      }
+      // A young collection does not trace the old regions, so it keeps their live bytes.
+      cc->region_space_->SetFromSpace(cc->rb_table_, evac_mode, /*clear_live_bytes*/ !cc->young_gen_);
+      // The GC-running thread copies into its own evacuation regions.
+      cc->region_space_->StartEvacTlab(self);
     }
     cc->SwapStacks();
     if (ConcurrentCopying::kEnableFromSpaceAccountingCheck) {
@@ -429,7 +476,7 @@ class ConcurrentCopying::FlipCallback : public Closure {
     }
     cc->is_marking_ = true;
     cc->mark_stack_mode_.StoreRelaxed(ConcurrentCopying::kMarkStackModeThreadLocal);
-    if (kIsDebugBuild) {
+    if (kIsDebugBuild && !cc->young_gen_) {
       cc->region_space_->AssertAllRegionLiveBytesZeroOrCleared();
     }
     if (UNLIKELY(Runtime::Current()->IsActiveTransaction())) {
@@ -444,6 +491,9 @@ class ConcurrentCopying::FlipCallback : public Closure {
         cc->VerifyGrayImmuneObjects();
       }
     }
+    if (cc->young_gen_) {
+      cc->GrayAllNewlyDirtyOldObjects();
+    }
     // May be null during runtime creation, in this case leave java_lang_Object null.
     // This is safe since single threaded behavior should mean FillDummyObject does not
     // happen when java_lang_Object_ is null.
@@ -615,8 +665,11 @@ void ConcurrentCopying::FlipThreadRoots() {
   ThreadFlipVisitor thread_flip_visitor(this, heap_->use_tlab_);
   FlipCallback flip_callback(this);
 
+  // The heap thread pool is idle until marking starts, so use it to visit the roots of the
+  // threads that are still suspended after the pause.
+  ThreadPool* thread_pool = GetParallelMarkingThreadCount() != 0 ? heap_->GetThreadPool() : nullptr;
   size_t barrier_count = Runtime::Current()->GetThreadList()->FlipThreadRoots(
-      &thread_flip_visitor, &flip_callback, this, GetHeap()->GetGcPauseListener());
+      &thread_flip_visitor, &flip_callback, this, GetHeap()->GetGcPauseListener(), thread_pool);
 
   {
     ScopedThreadStateChange tsc(self, kWaitingForCheckPointsToRun);
@@ -676,7 +729,20 @@ void ConcurrentCopying::GrayAllDirtyImmuneObjects() {
       table->ProcessCards();
       table->VisitObjects(&VisitorType::Callback, &visitor);
       // Don't clear cards here since we need to rescan in the pause. If we cleared the cards here,
-      // there would be races with the mutator marking new cards.
+      // there would be races with the mutator marking new cards. The cards aged above are already
+      // recorded in the mod-union table though, so retire them with a CAS that fails for the cards
+      // the mutators dirty in the meantime. This leaves only the newly dirty cards to the pause,
+      // instead of every dirty card of the space.
+      TimingLogger::ScopedTiming split2("ClearAgedImmuneCards", GetTimings());
+      card_table->ModifyCardsAtomic(
+          space->Begin(),
+          space->End(),
+          [](uint8_t card) {
+            return (card == gc::accounting::CardTable::kCardAged)
+                ? gc::accounting::CardTable::kCardClean
+                : card;
+          },
+          /* card modified visitor */ VoidFunctor());
     } else {
       // Keep cards aged if we don't have a mod-union table since we may need to scan them in future
       // GCs. This case is for app images.
@@ -717,7 +783,8 @@ void ConcurrentCopying::GrayAllNewlyDirtyImmuneObjects() {
                                              visitor,
                                              gc::accounting::CardTable::kCardDirty);
     if (table != nullptr) {
-      // Add the cards to the mod-union table so that we can clear cards to save RAM.
+      // Add the cards to the mod-union table so that we can clear cards to save RAM. The cards
+      // processed concurrently are clean by now, this only records the newly dirty ones.
       table->ProcessCards();
       TimingLogger::ScopedTiming split2("(Paused)ClearCards", GetTimings());
       card_table->ClearCardRange(space->Begin(),
@@ -729,6 +796,131 @@ void ConcurrentCopying::GrayAllNewlyDirtyImmuneObjects() {
   updated_all_immune_objects_.StoreRelaxed(true);
 }
 
+// Grays the white old objects and records them in a list so that the marking phase only scans
+// the objects it grayed, and not the ones marked in the meantime.
+template <bool kConcurrent>
+class ConcurrentCopying::GrayOldObjectVisitor {
+ public:
+  GrayOldObjectVisitor(Thread* self, std::vector<mirror::Object*>* gray_objects)
+      : self_(self), gray_objects_(gray_objects) {}
+
+  ALWAYS_INLINE void operator()(mirror::Object* obj) const REQUIRES_SHARED(Locks::mutator_lock_) {
+    if (obj->GetReadBarrierState() != ReadBarrier::WhiteState()) {
+      return;
+    }
+    if (kConcurrent) {
+      Locks::mutator_lock_->AssertSharedHeld(self_);
+      if (!obj->AtomicSetReadBarrierState(ReadBarrier::WhiteState(), ReadBarrier::GrayState())) {
+        return;
+      }
+    } else {
+      Locks::mutator_lock_->AssertExclusiveHeld(self_);
+      obj->SetReadBarrierState(ReadBarrier::GrayState());
+    }
+    gray_objects_->push_back(obj);
+  }
+
+ private:
+  Thread* const self_;
+  std::vector<mirror::Object*>* const gray_objects_;
+};
+
+template <typename Visitor>
+void ConcurrentCopying::VisitOldObjectsOnCards(const Visitor& visitor,
+                                               uint8_t minimum_age,
+                                               bool age_cards) {
+  accounting::CardTable* const card_table = heap_->GetCardTable();
+  // Aging turns the dirty cards into aged ones and clears the cards aged by the previous young
+  // collection, whose objects were scanned then. The cards dirtied after the aging are handled in
+  // the pause.
+  auto maybe_age_cards = [&](uint8_t* begin, uint8_t* end) {
+    if (age_cards) {
+      card_table->ModifyCardsAtomic(begin, end, AgeCardVisitor(), VoidFunctor());
+    }
+  };
+  // The old objects of the region space are the ones in its mark bitmap, see BindBitmaps().
+  maybe_age_cards(region_space_->Begin(), region_space_->Limit());
+  card_table->Scan</* kClearCard */ false>(region_space_bitmap_,
+                                           region_space_->Begin(),
+                                           region_space_->Limit(),
+                                           visitor,
+                                           minimum_age);
+  for (space::ContinuousSpace* space : heap_->GetContinuousSpaces()) {
+    if (space == region_space_ ||
+        immune_spaces_.ContainsSpace(space) ||
+        !space->IsContinuousMemMapAllocSpace()) {
+      continue;
+    }
+    maybe_age_cards(space->Begin(), space->End());
+    card_table->Scan</* kClearCard */ false>(space->GetMarkBitmap(),
+                                             space->Begin(),
+                                             space->End(),
+                                             visitor,
+                                             minimum_age);
+  }
+  space::LargeObjectSpace* const los = heap_->GetLargeObjectsSpace();
+  if (los != nullptr) {
+    // Large objects are page aligned so each has its own card, the one of its header.
+    std::pair<uint8_t*, uint8_t*> range = los->GetBeginEndAtomic();
+    los->GetMarkBitmap()->VisitMarkedRange(
+        reinterpret_cast<uintptr_t>(range.first),
+        reinterpret_cast<uintptr_t>(range.second),
+        [&](mirror::Object* obj) REQUIRES_SHARED(Locks::mutator_lock_) {
+          uint8_t* const addr = reinterpret_cast<uint8_t*>(obj);
+          maybe_age_cards(addr, addr + accounting::CardTable::kCardSize);
+          if (card_table->GetCard(obj) >= minimum_age) {
+            visitor(obj);
+          }
+        });
+  }
+}
+
+void ConcurrentCopying::GrayAllDirtyOldObjects() {
+  TimingLogger::ScopedTiming split("GrayAllDirtyOldObjects", GetTimings());
+  DCHECK(young_gen_);
+  DCHECK(dirty_old_objects_.empty());
+  Thread* const self = Thread::Current();
+  GrayOldObjectVisitor</* kConcurrent */ true> visitor(self, &dirty_old_objects_);
+  WriterMutexLock mu(self, *Locks::heap_bitmap_lock_);
+  VisitOldObjectsOnCards(visitor, accounting::CardTable::kCardAged, /* age_cards */ true);
+}
+
+void ConcurrentCopying::GrayAllNewlyDirtyOldObjects() {
+  TimingLogger::ScopedTiming split("(Paused)GrayAllNewlyDirtyOldObjects", GetTimings());
+  DCHECK(young_gen_);
+  Thread* const self = Thread::Current();
+  GrayOldObjectVisitor</* kConcurrent */ false> visitor(self, &dirty_old_objects_);
+  WriterMutexLock mu(self, *Locks::heap_bitmap_lock_);
+  // Don't need to scan aged cards since we did these before the pause.
+  VisitOldObjectsOnCards(visitor, accounting::CardTable::kCardDirty, /* age_cards */ false);
+}
+
+void ConcurrentCopying::ScanDirtyOldObjects() {
+  TimingLogger::ScopedTiming split("ScanDirtyOldObjects", GetTimings());
+  DCHECK(young_gen_);
+  if (kVerboseMode) {
+    LOG(INFO) << "dirty old objects=" << dirty_old_objects_.size();
+  }
+  for (mirror::Object* obj : dirty_old_objects_) {
+    DCHECK(obj->GetReadBarrierState() == ReadBarrier::GrayState());
+    // Update the fields without pushing the object onto the mark stack, it is already marked.
+    Scan(obj);
+    // As in ProcessMarkStackRef(), leave a reference gray if its referent is not marked yet so
+    // that GetReferent() goes through the read barrier. It is whitened when dequeued.
+    mirror::Object* referent = nullptr;
+    mirror::Class* klass = obj->GetClass<kVerifyNone, kWithoutReadBarrier>();
+    if (UNLIKELY(klass->IsTypeOfReferenceClass() &&
+                 (referent = obj->AsReference()->GetReferent<kWithoutReadBarrier>()) != nullptr &&
+                 !IsInToSpace(referent))) {
+      continue;
+    }
+    bool success = obj->AtomicSetReadBarrierState</*kCasRelease*/true>(ReadBarrier::GrayState(),
+                                                                         ReadBarrier::WhiteState());
+    DCHECK(success);
+  }
+  dirty_old_objects_.clear();
+}
+
 void ConcurrentCopying::SwapStacks() {
   heap_->SwapStacks();
 }
@@ -833,6 +1025,9 @@ void ConcurrentCopying::MarkingPhase() {
     }
     immune_gray_stack_.clear();
   }
+  if (young_gen_) {
+    ScanDirtyOldObjects();
+  }
 
   {
     TimingLogger::ScopedTiming split2("VisitConcurrentRoots", GetTimings());
@@ -1411,14 +1606,20 @@ bool ConcurrentCopying::ProcessMarkStackOnce() {
   size_t count = 0;
   MarkStackMode mark_stack_mode = mark_stack_mode_.LoadRelaxed();
   if (mark_stack_mode == kMarkStackModeThreadLocal) {
-    // Process the thread-local mark stacks and the GC mark stack.
-    count += ProcessThreadLocalMarkStacks(false, nullptr);
-    while (!gc_mark_stack_->IsEmpty()) {
-      mirror::Object* to_ref = gc_mark_stack_->PopBack();
-      ProcessMarkStackRef(to_ref);
-      ++count;
+    const size_t thread_count = GetParallelMarkingThreadCount();
+    if (thread_count > 0) {
+      // Hand the thread-local mark stacks and the GC mark stack to the parallel marking workers.
+      count += ProcessMarkStackParallel(thread_count);
+    } else {
+      // Process the thread-local mark stacks and the GC mark stack.
+      count += ProcessThreadLocalMarkStacks(false, nullptr);
+      while (!gc_mark_stack_->IsEmpty()) {
+        mirror::Object* to_ref = gc_mark_stack_->PopBack();
+        ProcessMarkStackRef(to_ref);
+        ++count;
+      }
+      gc_mark_stack_->Reset();
     }
-    gc_mark_stack_->Reset();
   } else if (mark_stack_mode == kMarkStackModeShared) {
     // Do an empty checkpoint to avoid a race with a mutator preempted in the middle of a read
     // barrier but before pushing onto the mark stack. b/32508093. Note the weak ref access is
@@ -1501,6 +1702,285 @@ size_t ConcurrentCopying::ProcessThreadLocalMarkStacks(bool disable_weak_ref_acc
   return count;
 }
 
+class ConcurrentCopying::ParallelMarkTask : public Task {
+ public:
+  ParallelMarkTask(ConcurrentCopying* concurrent_copying, size_t thread_count)
+      : concurrent_copying_(concurrent_copying), thread_count_(thread_count) {
+  }
+
+  void Run(Thread* self) OVERRIDE NO_THREAD_SAFETY_ANALYSIS {
+    // The GC-running thread holds the mutator lock shared for the whole marking phase. Take it
+    // here too so that the annotations and lock assertions hold for this worker.
+    ReaderMutexLock mu(self, *Locks::mutator_lock_);
+    concurrent_copying_->ParallelMarkWorker(self, thread_count_);
+  }
+
+  void Finalize() OVERRIDE {
+    delete this;
+  }
+
+ private:
+  ConcurrentCopying* const concurrent_copying_;
+  const size_t thread_count_;
+};
+
+size_t ConcurrentCopying::GetParallelMarkingThreadCount() const {
+  // Like MarkSweep, leave the CPUs to the foreground apps in a background state.
+  if (heap_->GetThreadPool() == nullptr || !Runtime::Current()->InJankPerceptibleProcessState()) {
+    return 0;
+  }
+  return std::min(heap_->GetConcGCThreadCount(), heap_->GetThreadPool()->GetThreadCount());
+}
+
+bool ConcurrentCopying::IsMarkingThread(Thread* self) const {
+  if (self == thread_running_gc_) {
+    return true;
+  }
+  if (parallel_marking_active_.LoadRelaxed()) {
+    for (ThreadPoolWorker* worker : heap_->GetThreadPool()->GetWorkers()) {
+      if (worker->GetThread() == self) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+size_t ConcurrentCopying::ProcessMarkStackParallel(size_t thread_count) {
+  Thread* self = Thread::Current();
+  ThreadPool* thread_pool = heap_->GetThreadPool();
+  DCHECK(thread_pool != nullptr);
+  // Run a checkpoint to collect all thread local mark stacks into revoked_mark_stacks_.
+  RevokeThreadLocalMarkStacks(false, nullptr);
+  size_t count = 0;
+  {
+    MutexLock mu(self, mark_stack_lock_);
+    // Split the GC mark stack into pooled mark stacks so that the workers can steal them.
+    while (!gc_mark_stack_->IsEmpty()) {
+      accounting::AtomicStack<mirror::Object>* mark_stack;
+      if (!pooled_mark_stacks_.empty()) {
+        mark_stack = pooled_mark_stacks_.back();
+        pooled_mark_stacks_.pop_back();
+      } else {
+        mark_stack = accounting::AtomicStack<mirror::Object>::Create(
+            "thread local mark stack", kMarkStackSize, kMarkStackSize);
+      }
+      DCHECK(mark_stack->IsEmpty());
+      while (!gc_mark_stack_->IsEmpty() && !mark_stack->IsFull()) {
+        mark_stack->PushBack(gc_mark_stack_->PopBack());
+      }
+      revoked_mark_stacks_.push_back(mark_stack);
+    }
+    if (revoked_mark_stacks_.empty()) {
+      gc_mark_stack_->Reset();
+      return 0;
+    }
+    parallel_marking_busy_workers_.StoreRelaxed(thread_count);
+  }
+  gc_mark_stack_->Reset();
+  parallel_marking_count_.StoreRelaxed(0u);
+  parallel_marking_active_.StoreRelaxed(true);
+  for (size_t i = 0; i < thread_count; ++i) {
+    thread_pool->AddTask(self, new ParallelMarkTask(this, thread_count));
+  }
+  thread_pool->SetMaxActiveWorkers(thread_count);
+  thread_pool->StartWorkers(self);
+  // Marking pushes onto the thread-local mark stacks of the workers, so the GC-running thread
+  // doesn't join in.
+  thread_pool->Wait(self, /* do_work */ false, /* may_hold_locks */ true);
+  thread_pool->StopWorkers(self);
+  parallel_marking_active_.StoreRelaxed(false);
+  cumulative_parallel_marking_rounds_.FetchAndAddRelaxed(1u);
+  count += parallel_marking_count_.LoadRelaxed();
+  if (kIsDebugBuild) {
+    MutexLock mu(self, mark_stack_lock_);
+    CHECK_EQ(parallel_marking_busy_workers_.LoadRelaxed(), 0u);
+  }
+  // Mutators may have revoked full thread-local mark stacks after the workers finished. The
+  // caller processes the mark stacks again until they are seen empty twice.
+  return count;
+}
+
+void ConcurrentCopying::ParallelMarkWorker(Thread* self, size_t thread_count) {
+  DCHECK_NE(self, thread_running_gc_);
+  // The minimum size of the own mark stack to share it with an idle worker.
+  static constexpr size_t kMinSharedMarkStackSize = 256;
+  if (!region_space_->HasEvacTlab(self)) {
+    // Keep the evacuation TLAB until ReclaimPhase() since there may be more parallel rounds.
+    region_space_->StartEvacTlab(self);
+  }
+  size_t count = 0;
+  bool busy = true;
+  while (true) {
+    // PushOntoMarkStack() pushes the refs marked by this worker onto its thread-local mark stack.
+    accounting::AtomicStack<mirror::Object>* tl_mark_stack = self->GetThreadLocalMarkStack();
+    if (tl_mark_stack != nullptr && !tl_mark_stack->IsEmpty()) {
+      if (tl_mark_stack->Size() >= kMinSharedMarkStackSize &&
+          parallel_marking_busy_workers_.LoadRelaxed() < thread_count) {
+        // Another worker is out of work. Publish the own mark stack for it to steal.
+        MutexLock mu(self, mark_stack_lock_);
+        revoked_mark_stacks_.push_back(tl_mark_stack);
+        self->SetThreadLocalMarkStack(nullptr);
+        continue;
+      }
+      ProcessMarkStackRef</*kParallel*/ true>(tl_mark_stack->PopBack());
+      ++count;
+      continue;
+    }
+    accounting::AtomicStack<mirror::Object>* stolen_mark_stack = nullptr;
+    {
+      MutexLock mu(self, mark_stack_lock_);
+      if (!revoked_mark_stacks_.empty()) {
+        // Steal a mark stack revoked by a mutator or published by another worker.
+        stolen_mark_stack = revoked_mark_stacks_.back();
+        revoked_mark_stacks_.pop_back();
+        if (!busy) {
+          busy = true;
+          parallel_marking_busy_workers_.FetchAndAddRelaxed(1u);
+        }
+      } else {
+        if (busy) {
+          busy = false;
+          parallel_marking_busy_workers_.FetchAndSubRelaxed(1u);
+        }
+        if (parallel_marking_busy_workers_.LoadRelaxed() == 0u) {
+          // No mark stack left and no other worker can produce one.
+          break;
+        }
+      }
+    }
+    if (stolen_mark_stack == nullptr) {
+      // Wait for a busy worker to publish its mark stack.
+      sched_yield();
+      continue;
+    }
+    while (!stolen_mark_stack->IsEmpty()) {
+      ProcessMarkStackRef</*kParallel*/ true>(stolen_mark_stack->PopBack());
+      ++count;
+    }
+    MutexLock mu(self, mark_stack_lock_);
+    if (pooled_mark_stacks_.size() >= kMarkStackPoolSize) {
+      // The pool has enough. Delete it.
+      delete stolen_mark_stack;
+    } else {
+      // Otherwise, put it into the pool for later reuse.
+      stolen_mark_stack->Reset();
+      pooled_mark_stacks_.push_back(stolen_mark_stack);
+    }
+  }
+  // Return the empty thread-local mark stack to the pool.
+  accounting::AtomicStack<mirror::Object>* tl_mark_stack = self->GetThreadLocalMarkStack();
+  if (tl_mark_stack != nullptr) {
+    DCHECK(tl_mark_stack->IsEmpty());
+    MutexLock mu(self, mark_stack_lock_);
+    self->SetThreadLocalMarkStack(nullptr);
+    if (pooled_mark_stacks_.size() >= kMarkStackPoolSize) {
+      delete tl_mark_stack;
+    } else {
+      tl_mark_stack->Reset();
+      pooled_mark_stacks_.push_back(tl_mark_stack);
+    }
+  }
+  parallel_marking_count_.FetchAndAddRelaxed(count);
+}
+
+void ConcurrentCopying::VerifySampledRegions() {
+  const size_t count = heap_->GetSampledVerificationRegions();
+  if (count == 0) {
+    return;
+  }
+  TimingLogger::ScopedTiming split(__FUNCTION__, GetTimings());
+  std::vector<std::pair<uint8_t*, uint8_t*>> ranges;
+  region_space_->SampleEvacuatedRegions(count, &ranges);
+  const Verification* const verification = heap_->GetVerification();
+  size_t objects = 0;
+  size_t failures = 0;
+  for (const std::pair<uint8_t*, uint8_t*>& range : ranges) {
+    region_space_->WalkEvacuatedRange(
+        range.first,
+        range.second,
+        [&](mirror::Object* obj) REQUIRES_SHARED(Locks::mutator_lock_) {
+          ++objects;
+          // Without a valid class the size of the object is unknown, stop walking the region.
+          const bool valid_class =
+              verification->IsValidClass(obj->GetClass<kVerifyNone, kWithoutReadBarrier>());
+          failures += verification->VerifyObjectReferences(obj, /* fatal */ false);
+          return valid_class;
+        });
+  }
+  VLOG(gc) << "Sampled heap verification checked " << objects << " objects in " << ranges.size()
+           << " regions";
+  CHECK_EQ(failures, 0u) << "Sampled heap verification found invalid references";
+}
+
+void ConcurrentCopying::SampleClassHistogram() {
+  ClassHistogram* const histogram = heap_->GetClassHistogram();
+  // A young collection does not trace the old regions, so it does not know which of their
+  // objects are live.
+  if (histogram == nullptr || young_gen_) {
+    return;
+  }
+  TimingLogger::ScopedTiming split(__FUNCTION__, GetTimings());
+  const size_t sampling_rate = histogram->GetSamplingRate();
+  histogram->BeginSample();
+  // All the objects copied to the to-space are live. Walk one out of sampling_rate of the
+  // evacuated regions and weigh their objects by how many regions each sampled one stands for.
+  std::vector<std::pair<uint8_t*, uint8_t*>> ranges;
+  const size_t num_regions = region_space_->SampleEvacuatedRegions(0u, &ranges);
+  region_space_->SampleEvacuatedRegions((num_regions + sampling_rate - 1) / sampling_rate, &ranges);
+  if (!ranges.empty()) {
+    const uint64_t weight = (num_regions + ranges.size() / 2) / ranges.size();
+    for (const std::pair<uint8_t*, uint8_t*>& range : ranges) {
+      region_space_->WalkEvacuatedRange(
+          range.first,
+          range.second,
+          [&](mirror::Object* obj) REQUIRES_SHARED(Locks::mutator_lock_) {
+            histogram->AddObject(obj, weight);
+            return true;
+          });
+    }
+  }
+  // The unevacuated regions and the non-moving space track their live objects in the mark
+  // bitmaps.
+  histogram->SampleMarkedRange(region_space_bitmap_,
+                               region_space_->Begin(),
+                               region_space_->Limit());
+  space::ContinuousSpace* const non_moving_space = heap_->GetNonMovingSpace();
+  histogram->SampleMarkedRange(non_moving_space->GetMarkBitmap(),
+                               non_moving_space->Begin(),
+                               non_moving_space->End());
+  space::LargeObjectSpace* const los = heap_->GetLargeObjectsSpace();
+  if (los != nullptr) {
+    const std::pair<uint8_t*, uint8_t*> range = los->GetBeginEndAtomic();
+    histogram->AddMarkedRange(los->GetMarkBitmap(), range.first, range.second);
+  }
+  histogram->EndSample(GetName());
+}
+
+void ConcurrentCopying::RevokeEvacTlabs() {
+  TimingLogger::ScopedTiming split(__FUNCTION__, GetTimings());
+  Thread* self = Thread::Current();
+  size_t gc_thread_bytes = region_space_->RevokeEvacTlab(self);
+  MutexLock mu(self, mark_stack_lock_);
+  cumulative_bytes_copied_by_gc_thread_ += gc_thread_bytes;
+  ThreadPool* thread_pool = heap_->GetThreadPool();
+  if (thread_pool == nullptr) {
+    return;
+  }
+  // The parallel marking workers are idle at this point.
+  const std::vector<ThreadPoolWorker*>& workers = thread_pool->GetWorkers();
+  if (cumulative_bytes_copied_by_workers_.size() < workers.size()) {
+    cumulative_bytes_copied_by_workers_.resize(workers.size(), 0u);
+  }
+  for (size_t i = 0; i < workers.size(); ++i) {
+    Thread* worker_thread = workers[i]->GetThread();
+    if (worker_thread != nullptr && region_space_->HasEvacTlab(worker_thread)) {
+      cumulative_bytes_copied_by_workers_[i] += region_space_->RevokeEvacTlab(worker_thread);
+    }
+  }
+}
+
+template <bool kParallel>
 inline void ConcurrentCopying::ProcessMarkStackRef(mirror::Object* to_ref) {
   DCHECK(!region_space_->IsInFromSpace(to_ref));
   if (kUseBakerReadBarrier) {
@@ -1510,8 +1990,11 @@ inline void ConcurrentCopying::ProcessMarkStackRef(mirror::Object* to_ref) {
   }
   bool add_to_live_bytes = false;
   if (region_space_->IsInUnevacFromSpace(to_ref)) {
-    // Mark the bitmap only in the GC thread here so that we don't need a CAS.
-    if (!kUseBakerReadBarrier || !region_space_bitmap_->Set(to_ref)) {
+    // Mark the bitmap only in the GC thread here so that we don't need a CAS, unless the
+    // parallel marking workers share the bitmap.
+    if (!kUseBakerReadBarrier ||
+        !(kParallel ? region_space_bitmap_->AtomicTestAndSet(to_ref)
+                    : region_space_bitmap_->Set(to_ref))) {
       // It may be already marked if we accidentally pushed the same object twice due to the racy
       // bitmap read in MarkUnevacFromSpaceRegion.
       Scan(to_ref);
@@ -1551,12 +2034,16 @@ inline void ConcurrentCopying::ProcessMarkStackRef(mirror::Object* to_ref) {
 #endif
 
   if (add_to_live_bytes) {
-    // Add to the live bytes per unevacuated from space. Note this code is always run by the
-    // GC-running thread (no synchronization required).
+    // Add to the live bytes per unevacuated from space. Note this code is run by the GC-running
+    // thread (no synchronization required) or by the parallel marking workers.
     DCHECK(region_space_bitmap_->Test(to_ref));
     size_t obj_size = to_ref->SizeOf<kDefaultVerifyFlags>();
     size_t alloc_size = RoundUp(obj_size, space::RegionSpace::kAlignment);
-    region_space_->AddLiveBytes(to_ref, alloc_size);
+    if (kParallel) {
+      region_space_->AddLiveBytesAtomic(to_ref, alloc_size);
+    } else {
+      region_space_->AddLiveBytes(to_ref, alloc_size);
+    }
   }
   if (ReadBarrier::kEnableToSpaceInvariantChecks) {
     CHECK(to_ref != nullptr);
@@ -1740,6 +2227,13 @@ void ConcurrentCopying::ReclaimPhase() {
     CheckEmptyMarkStack();
   }
 
+  // No more copying. Release the evacuation TLABs before the from-space is cleared.
+  RevokeEvacTlabs();
+
+  // The evacuated regions are complete now and the from-space is not cleared yet.
+  VerifySampledRegions();
+  SampleClassHistogram();
+
   {
     // Record freed objects.
     TimingLogger::ScopedTiming split2("RecordFree", GetTimings());
@@ -1764,7 +2258,11 @@ void ConcurrentCopying::ReclaimPhase() {
     uint64_t cleared_objects;
     {
       TimingLogger::ScopedTiming split4("ClearFromSpace", GetTimings());
-      region_space_->ClearFromSpace(&cleared_bytes, &cleared_objects);
+      // The generational mode keeps the bitmap of the surviving objects for the next young
+      // collection.
+      region_space_->ClearFromSpace(&cleared_bytes,
+                                    &cleared_objects,
+                                    /*clear_bitmap*/ !use_generational_cc_);
       CHECK_GE(cleared_bytes, from_bytes);
       CHECK_GE(cleared_objects, from_objects);
     }
@@ -1947,7 +2445,7 @@ void ConcurrentCopying::AssertToSpaceInvariantInNonMovingSpace(mirror::Object* o
   if (immune_spaces_.ContainsObject(ref)) {
     if (kUseBakerReadBarrier) {
       // Immune object may not be gray if called from the GC.
-      if (Thread::Current() == thread_running_gc_ && !gc_grays_immune_objects_) {
+      if (IsMarkingThread(Thread::Current()) && !gc_grays_immune_objects_) {
         return;
       }
       bool updated_all_immune_objects = updated_all_immune_objects_.LoadSequentiallyConsistent();
@@ -2021,7 +2519,7 @@ inline void ConcurrentCopying::Scan(mirror::Object* to_ref) {
     Thread::Current()->ModifyDebugDisallowReadBarrier(1);
   }
   DCHECK(!region_space_->IsInFromSpace(to_ref));
-  DCHECK_EQ(Thread::Current(), thread_running_gc_);
+  DCHECK(IsMarkingThread(Thread::Current()));
   RefFieldsVisitor visitor(this);
   // Disable the read barrier for a performance reason.
   to_ref->VisitReferences</*kVisitNativeRoots*/true, kDefaultVerifyFlags, kWithoutReadBarrier>(
@@ -2033,7 +2531,7 @@ inline void ConcurrentCopying::Scan(mirror::Object* to_ref) {
 
 // Process a field.
 inline void ConcurrentCopying::Process(mirror::Object* obj, MemberOffset offset) {
-  DCHECK_EQ(Thread::Current(), thread_running_gc_);
+  DCHECK(IsMarkingThread(Thread::Current()));
   mirror::Object* ref = obj->GetFieldObject<
       mirror::Object, kVerifyNone, kWithoutReadBarrier, false>(offset);
   mirror::Object* to_ref = Mark</*kGrayImmuneObject*/false, /*kFromGCThread*/true>(
@@ -2260,8 +2758,13 @@ mirror::Object* ConcurrentCopying::Copy(mirror::Object* from_ref,
   size_t non_moving_space_bytes_allocated = 0U;
   size_t bytes_allocated = 0U;
   size_t dummy;
-  mirror::Object* to_ref = region_space_->AllocNonvirtual<true>(
-      region_space_alloc_size, &region_space_bytes_allocated, nullptr, &dummy);
+  Thread* const self = Thread::Current();
+  // The GC threads copy into their own evacuation TLABs; mutators share the evacuation region.
+  mirror::Object* to_ref = region_space_->HasEvacTlab(self)
+      ? region_space_->AllocEvacTlab(
+            self, region_space_alloc_size, &region_space_bytes_allocated, nullptr, &dummy)
+      : region_space_->AllocNonvirtual<true>(
+            region_space_alloc_size, &region_space_bytes_allocated, nullptr, &dummy);
   bytes_allocated = region_space_bytes_allocated;
   if (to_ref != nullptr) {
     DCHECK_EQ(region_space_alloc_size, region_space_bytes_allocated);
@@ -2385,6 +2888,10 @@ mirror::Object* ConcurrentCopying::Copy(mirror::Object* from_ref,
       bytes_moved_.FetchAndAddRelaxed(region_space_alloc_size);
       if (LIKELY(!fall_back_to_non_moving)) {
         DCHECK(region_space_->IsInToSpace(to_ref));
+        if (use_generational_cc_) {
+          // Record the survivor so that the next young collection considers it old.
+          region_space_bitmap_->AtomicTestAndSet(to_ref);
+        }
       } else {
         DCHECK(heap_->non_moving_space_->HasAddress(to_ref));
         DCHECK_EQ(bytes_allocated, non_moving_space_bytes_allocated);
@@ -2559,10 +3066,11 @@ void ConcurrentCopying::FinishPhase() {
     CHECK_EQ(pooled_mark_stacks_.size(), kMarkStackPoolSize);
   }
   // kVerifyNoMissingCardMarks relies on the region space cards not being cleared to avoid false
-  // positives.
-  if (!kVerifyNoMissingCardMarks) {
+  // positives. The generational mode uses the cards to find the old objects to scan.
+  if (!kVerifyNoMissingCardMarks && !use_generational_cc_) {
     TimingLogger::ScopedTiming split("ClearRegionSpaceCards", GetTimings());
-    // We do not currently use the region space cards at all, madvise them away to save ram.
+    // We do not use the region space cards outside of the generational mode, madvise them away to
+    // save ram.
     heap_->GetCardTable()->ClearCardRange(region_space_->Begin(), region_space_->Limit());
   }
   {
@@ -2685,6 +3193,16 @@ void ConcurrentCopying::DumpPerformanceInfo(std::ostream& os) {
   }
   os << "Cumulative bytes moved " << cumulative_bytes_moved_.LoadRelaxed() << "\n";
   os << "Cumulative objects moved " << cumulative_objects_moved_.LoadRelaxed() << "\n";
+  if (cumulative_parallel_marking_rounds_.LoadRelaxed() > 0) {
+    os << "Parallel marking rounds " << cumulative_parallel_marking_rounds_.LoadRelaxed() << "\n";
+  }
+  MutexLock mu2(Thread::Current(), mark_stack_lock_);
+  os << "Cumulative bytes copied by the GC thread " << cumulative_bytes_copied_by_gc_thread_
+     << "\n";
+  for (size_t i = 0; i < cumulative_bytes_copied_by_workers_.size(); ++i) {
+    os << "Cumulative bytes copied by GC worker " << i << " "
+       << cumulative_bytes_copied_by_workers_[i] << "\n";
+  }
 }
 
 }  // namespace collector
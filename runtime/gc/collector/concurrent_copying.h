@@ -65,9 +65,12 @@ class ConcurrentCopying : public GarbageCollector {
   // pages.
   static constexpr bool kGrayDirtyImmuneObjects = true;
 
-  explicit ConcurrentCopying(Heap* heap,
-                             const std::string& name_prefix = "",
-                             bool measure_read_barrier_slow_path = false);
+  // If young_gen is true, the collector only evacuates the regions allocated since the last GC and
+  // treats the objects that survived earlier collections as live (generational mode).
+  ConcurrentCopying(Heap* heap,
+                    bool young_gen,
+                    const std::string& name_prefix = "",
+                    bool measure_read_barrier_slow_path = false);
   ~ConcurrentCopying();
 
   virtual void RunPhases() OVERRIDE
@@ -87,7 +90,7 @@ class ConcurrentCopying : public GarbageCollector {
   void BindBitmaps() REQUIRES_SHARED(Locks::mutator_lock_)
       REQUIRES(!Locks::heap_bitmap_lock_);
   virtual GcType GetGcType() const OVERRIDE {
-    return kGcTypePartial;
+    return young_gen_ ? kGcTypeSticky : kGcTypePartial;
   }
   virtual CollectorType GetCollectorType() const OVERRIDE {
     return kCollectorTypeCC;
@@ -170,14 +173,47 @@ class ConcurrentCopying : public GarbageCollector {
   virtual void ProcessMarkStack() OVERRIDE REQUIRES_SHARED(Locks::mutator_lock_)
       REQUIRES(!mark_stack_lock_);
   bool ProcessMarkStackOnce() REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(!mark_stack_lock_);
+  // kParallel is true if called by a parallel marking worker, in which case the region space
+  // bitmap and the live bytes are updated atomically.
+  template <bool kParallel = false>
   void ProcessMarkStackRef(mirror::Object* to_ref) REQUIRES_SHARED(Locks::mutator_lock_)
       REQUIRES(!mark_stack_lock_);
+  // Returns the number of worker threads for the parallel marking, or 0 if the GC-running thread
+  // should process the mark stacks alone.
+  size_t GetParallelMarkingThreadCount() const;
+  // Process the thread-local and GC mark stacks with `thread_count` workers from the heap thread
+  // pool. Returns the number of refs processed.
+  size_t ProcessMarkStackParallel(size_t thread_count) REQUIRES_SHARED(Locks::mutator_lock_)
+      REQUIRES(!mark_stack_lock_);
+  // Run by each of the `thread_count` parallel marking workers. Drain the own thread-local mark
+  // stack and steal the revoked mark stacks until there is no work left for any worker.
+  void ParallelMarkWorker(Thread* self, size_t thread_count) REQUIRES_SHARED(Locks::mutator_lock_)
+      REQUIRES(!mark_stack_lock_);
+  // True if self is the GC-running thread or a parallel marking worker. For debug checks.
+  bool IsMarkingThread(Thread* self) const;
   void GrayAllDirtyImmuneObjects()
       REQUIRES(Locks::mutator_lock_)
       REQUIRES(!mark_stack_lock_);
   void GrayAllNewlyDirtyImmuneObjects()
       REQUIRES(Locks::mutator_lock_)
       REQUIRES(!mark_stack_lock_);
+  // Young collection only: age the cards outside the immune spaces and gray the old objects on
+  // aged cards, since they may reference objects in the newly allocated regions.
+  void GrayAllDirtyOldObjects()
+      REQUIRES_SHARED(Locks::mutator_lock_)
+      REQUIRES(!mark_stack_lock_);
+  // Young collection only: gray the old objects on cards dirtied since GrayAllDirtyOldObjects().
+  void GrayAllNewlyDirtyOldObjects()
+      REQUIRES(Locks::mutator_lock_)
+      REQUIRES(!mark_stack_lock_);
+  template <typename Visitor>
+  void VisitOldObjectsOnCards(const Visitor& visitor, uint8_t minimum_age, bool age_cards)
+      REQUIRES_SHARED(Locks::mutator_lock_)
+      REQUIRES(Locks::heap_bitmap_lock_);
+  // Young collection only: scan the old objects grayed by the two functions above and whiten them.
+  void ScanDirtyOldObjects()
+      REQUIRES_SHARED(Locks::mutator_lock_)
+      REQUIRES(!mark_stack_lock_);
   void VerifyGrayImmuneObjects()
       REQUIRES(Locks::mutator_lock_)
       REQUIRES(!mark_stack_lock_);
@@ -259,7 +295,16 @@ class ConcurrentCopying : public GarbageCollector {
   mirror::Object* MarkFromReadBarrierWithMeasurements(mirror::Object* from_ref)
       REQUIRES_SHARED(Locks::mutator_lock_)
       REQUIRES(!mark_stack_lock_, !skipped_blocks_lock_, !immune_gray_stack_lock_);
-  void DumpPerformanceInfo(std::ostream& os) OVERRIDE REQUIRES(!rb_slow_path_histogram_lock_);
+  void DumpPerformanceInfo(std::ostream& os) OVERRIDE
+      REQUIRES(!rb_slow_path_histogram_lock_, !mark_stack_lock_);
+  // Revoke the evacuation TLABs of the GC-running thread and the parallel marking workers and
+  // add up the bytes they copied.
+  void RevokeEvacTlabs() REQUIRES(!mark_stack_lock_);
+  // Check the references of the objects in a few randomly chosen evacuated regions, see
+  // Heap::GetSampledVerificationRegions(). Runs concurrently with the mutators.
+  void VerifySampledRegions() REQUIRES_SHARED(Locks::mutator_lock_);
+  // Record the live objects of a sample of the heap in the heap's class histogram, if any.
+  void SampleClassHistogram() REQUIRES_SHARED(Locks::mutator_lock_);
   // Set the read barrier mark entrypoints to non-null.
   void ActivateReadBarrierEntrypoints();
 
@@ -277,6 +322,19 @@ class ConcurrentCopying : public GarbageCollector {
   std::vector<accounting::ObjectStack*> pooled_mark_stacks_
       GUARDED_BY(mark_stack_lock_);
   Thread* thread_running_gc_;
+  // True while the parallel marking workers are running.
+  Atomic<bool> parallel_marking_active_;
+  // The number of parallel marking workers that may still produce work. Only modified with
+  // mark_stack_lock_ held.
+  Atomic<size_t> parallel_marking_busy_workers_;
+  // The number of refs processed by the parallel marking workers in the current round.
+  Atomic<size_t> parallel_marking_count_;
+  // The number of parallel marking rounds over all GCs. Used for DumpPerformanceInfo.
+  Atomic<uint64_t> cumulative_parallel_marking_rounds_;
+  // The bytes copied into the evacuation TLABs by the GC-running thread and by each heap thread
+  // pool worker over all GCs. Used for DumpPerformanceInfo.
+  uint64_t cumulative_bytes_copied_by_gc_thread_ GUARDED_BY(mark_stack_lock_);
+  std::vector<uint64_t> cumulative_bytes_copied_by_workers_ GUARDED_BY(mark_stack_lock_);
   bool is_marking_;                       // True while marking is ongoing.
   // True while we might dispatch on the read barrier entrypoints.
   bool is_using_read_barrier_entrypoints_;
@@ -332,6 +390,14 @@ class ConcurrentCopying : public GarbageCollector {
 
   accounting::ReadBarrierTable* rb_table_;
   bool force_evacuate_all_;  // True if all regions are evacuated.
+  // True for the young collection of the generational mode.
+  const bool young_gen_;
+  // True if the heap alternates young and full collections. The full collection then keeps the
+  // region space cards and mark bitmap for the next young collection.
+  const bool use_generational_cc_;
+  // Old objects grayed by a young collection before and during the pause. Only accessed by the
+  // GC-running thread.
+  std::vector<mirror::Object*> dirty_old_objects_;
   Atomic<bool> updated_all_immune_objects_;
   bool gc_grays_immune_objects_;
   Mutex immune_gray_stack_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
@@ -353,8 +419,10 @@ class ConcurrentCopying : public GarbageCollector {
   class DisableWeakRefAccessCallback;
   class FlipCallback;
   template <bool kConcurrent> class GrayImmuneObjectVisitor;
+  template <bool kConcurrent> class GrayOldObjectVisitor;
   class ImmuneSpaceScanObjVisitor;
   class LostCopyVisitor;
+  class ParallelMarkTask;
   class RefFieldsVisitor;
   class RevokeThreadLocalMarkStackCheckpoint;
   class ScopedGcGraysImmuneObjects;
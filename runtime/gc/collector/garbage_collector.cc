@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <stdio.h>
 
 #include "garbage_collector.h"
@@ -78,6 +79,7 @@ void GarbageCollector::RegisterPause(uint64_t nano_length) {
 void GarbageCollector::ResetCumulativeStatistics() {
   cumulative_timings_.Reset();
   total_time_ns_ = 0;
+  total_thread_cpu_time_ns_ = 0;
   total_freed_objects_ = 0;
   total_freed_bytes_ = 0;
   MutexLock mu(Thread::Current(), pause_histogram_lock_);
@@ -86,8 +88,10 @@ void GarbageCollector::ResetCumulativeStatistics() {
 
 void GarbageCollector::Run(GcCause gc_cause, bool clear_soft_references) {
   ScopedTrace trace(android::base::StringPrintf("%s %s GC", PrettyCause(gc_cause), GetName()));
+  ART_TRACE_COUNTER("GC in progress", 1);
   Thread* self = Thread::Current();
   uint64_t start_time = NanoTime();
+  uint64_t start_thread_cpu_time = ThreadCpuNanoTime();
   Iteration* current_iteration = GetCurrentIteration();
   current_iteration->Reset(gc_cause, clear_soft_references);
   // Note transaction mode is single-threaded and there's no asynchronous GC and this flag doesn't
@@ -110,11 +114,13 @@ void GarbageCollector::Run(GcCause gc_cause, bool clear_soft_references) {
     RegisterPause(current_iteration->GetDurationNs());
   }
   total_time_ns_ += current_iteration->GetDurationNs();
+  total_thread_cpu_time_ns_ += ThreadCpuNanoTime() - start_thread_cpu_time;
   for (uint64_t pause_time : current_iteration->GetPauseTimes()) {
     MutexLock mu(self, pause_histogram_lock_);
     pause_histogram_.AdjustAndAddValue(pause_time);
   }
   is_transaction_active_ = false;
+  ART_TRACE_COUNTER("GC in progress", 0);
 }
 
 void GarbageCollector::SwapBitmaps() {
@@ -160,6 +166,7 @@ void GarbageCollector::ResetMeasurements() {
   }
   cumulative_timings_.Reset();
   total_time_ns_ = 0;
+  total_thread_cpu_time_ns_ = 0;
   total_freed_objects_ = 0;
   total_freed_bytes_ = 0;
 }
@@ -237,6 +244,44 @@ void GarbageCollector::DumpPerformanceInfo(std::ostream& os) {
      << PrettySize(freed_bytes / seconds) << "/s\n";
 }
 
+static std::string MetricsKey(const std::string& name) {
+  std::string key(name);
+  std::replace(key.begin(), key.end(), ' ', '-');
+  return key;
+}
+
+void GarbageCollector::DumpMetrics(std::ostream& os) {
+  const CumulativeLogger& logger = GetCumulativeTimings();
+  const size_t iterations = logger.GetIterations();
+  if (iterations == 0) {
+    return;
+  }
+  const std::string prefix = MetricsKey(GetName()) + ".";
+  os << prefix << "iterations=" << iterations << "\n"
+     << prefix << "total-time=" << logger.GetTotalNs() << "\n"
+     << prefix << "thread-cpu-time=" << total_thread_cpu_time_ns_ << "\n"
+     << prefix << "freed-objects=" << GetTotalFreedObjects() << "\n"
+     << prefix << "freed-bytes=" << GetTotalFreedBytes() << "\n";
+  {
+    MutexLock mu(Thread::Current(), pause_histogram_lock_);
+    os << prefix << "pause-count=" << pause_histogram_.SampleSize() << "\n"
+       << prefix << "pause-time=" << pause_histogram_.AdjustedSum() << "\n";
+    if (pause_histogram_.SampleSize() > 0) {
+      Histogram<uint64_t>::CumulativeData cumulative_data;
+      pause_histogram_.CreateHistogram(&cumulative_data);
+      os << prefix << "pause-p50-us=" << pause_histogram_.Percentile(0.50, cumulative_data) << "\n"
+         << prefix << "pause-p95-us=" << pause_histogram_.Percentile(0.95, cumulative_data) << "\n"
+         << prefix << "pause-p99-us=" << pause_histogram_.Percentile(0.99, cumulative_data) << "\n"
+         << prefix << "pause-max-us=" << pause_histogram_.Max() << "\n";
+    }
+  }
+  std::vector<std::pair<std::string, uint64_t>> phase_times;
+  logger.GetTotalTimes(&phase_times);
+  for (const auto& phase_time : phase_times) {
+    os << prefix << "phase." << MetricsKey(phase_time.first) << "=" << phase_time.second << "\n";
+  }
+}
+
 }  // namespace collector
 }  // namespace gc
 }  // namespace art
@@ -107,6 +107,10 @@ class GarbageCollector : public RootVisitor, public IsMarkedVisitor, public Mark
   // Record a free of large objects.
   void RecordFreeLOS(const ObjectBytePair& freed);
   virtual void DumpPerformanceInfo(std::ostream& os) REQUIRES(!pause_histogram_lock_);
+  // Dump the cumulative statistics as one "key=value" line each, keys are prefixed with the
+  // collector name. Times are in nanoseconds except for the pause percentiles which are in
+  // microseconds like the pause histogram.
+  void DumpMetrics(std::ostream& os) REQUIRES(!pause_histogram_lock_);
 
   // Helper functions for querying if objects are marked. These are used for processing references,
   // and will be used for reading system weaks while the GC is running.
@@ -147,6 +151,8 @@ class GarbageCollector : public RootVisitor, public IsMarkedVisitor, public Mark
   // Cumulative statistics.
   Histogram<uint64_t> pause_histogram_ GUARDED_BY(pause_histogram_lock_);
   uint64_t total_time_ns_;
+  // CPU time of the threads running the collections, not counting the GC worker threads.
+  uint64_t total_thread_cpu_time_ns_;
   uint64_t total_freed_objects_;
   int64_t total_freed_bytes_;
   CumulativeLogger cumulative_timings_;
@@ -16,6 +16,8 @@
 
 #include "mark_sweep.h"
 
+#include <sched.h>
+
 #include <atomic>
 #include <functional>
 #include <numeric>
@@ -34,6 +36,8 @@
 #include "gc/accounting/heap_bitmap-inl.h"
 #include "gc/accounting/mod_union_table.h"
 #include "gc/accounting/space_bitmap-inl.h"
+#include "gc/accounting/work_stealing_deque.h"
+#include "gc/class_histogram.h"
 #include "gc/heap.h"
 #include "gc/reference_processor.h"
 #include "gc/space/large_object_space.h"
@@ -53,6 +57,8 @@ namespace collector {
 static constexpr bool kUseRecursiveMark = false;
 static constexpr bool kUseMarkStackPrefetch = true;
 static constexpr size_t kSweepArrayChunkFreeSize = 1024;
+// Minimum number of allocation stack entries swept by each thread in a parallel SweepArray.
+static constexpr size_t kMinSweepArrayChunkSize = 16 * KB;
 static constexpr bool kPreCleanCards = true;
 
 // Parallelism options.
@@ -64,6 +70,8 @@ static constexpr bool kParallelRecursiveMark = true;
 // ProcessMarkStack with very small mark stacks.
 static constexpr size_t kMinimumParallelMarkStackSize = 128;
 static constexpr bool kParallelProcessMarkStack = true;
+// Initial capacity of the work stealing deque of each parallel mark stack processing task.
+static constexpr size_t kWorkStealingDequeCapacity = 1 * KB;
 
 // Profiling and information flags.
 static constexpr bool kProfileLargeObjects = false;
@@ -99,6 +107,8 @@ MarkSweep::MarkSweep(Heap* heap, bool is_concurrent, const std::string& name_pre
       mark_stack_(nullptr),
       gc_barrier_(new Barrier(0)),
       mark_stack_lock_("mark sweep mark stack lock", kMarkSweepMarkStackLock),
+      cumulative_parallel_mark_stack_rounds_(0u),
+      cumulative_steals_(0u),
       is_concurrent_(is_concurrent),
       live_stack_freeze_size_(0) {
   std::string error_msg;
@@ -323,6 +333,11 @@ void MarkSweep::ReclaimPhase() {
   // Clean up class loaders after system weaks are swept since that is how we know if class
   // unloading occurred.
   runtime->GetClassLinker()->CleanupClassLoaders();
+  {
+    // The mark bitmaps are final now and not swept yet.
+    ReaderMutexLock mu(self, *Locks::heap_bitmap_lock_);
+    SampleClassHistogram();
+  }
   {
     WriterMutexLock mu(self, *Locks::heap_bitmap_lock_);
     GetHeap()->RecordFreeRevoke();
@@ -337,6 +352,27 @@ void MarkSweep::ReclaimPhase() {
   }
 }
 
+void MarkSweep::SampleClassHistogram() {
+  ClassHistogram* const histogram = GetHeap()->GetClassHistogram();
+  if (histogram == nullptr) {
+    return;
+  }
+  TimingLogger::ScopedTiming t(__FUNCTION__, GetTimings());
+  histogram->BeginSample();
+  for (const auto& space : GetHeap()->GetContinuousSpaces()) {
+    // The objects of the immune spaces are not marked.
+    if (space->IsContinuousMemMapAllocSpace() && !immune_spaces_.ContainsSpace(space)) {
+      histogram->SampleMarkedRange(space->GetMarkBitmap(), space->Begin(), space->End());
+    }
+  }
+  space::LargeObjectSpace* const los = GetHeap()->GetLargeObjectsSpace();
+  if (los != nullptr) {
+    const std::pair<uint8_t*, uint8_t*> range = los->GetBeginEndAtomic();
+    histogram->AddMarkedRange(los->GetMarkBitmap(), range.first, range.second);
+  }
+  histogram->EndSample(GetName());
+}
+
 void MarkSweep::FindDefaultSpaceBitmap() {
   TimingLogger::ScopedTiming t(__FUNCTION__, GetTimings());
   for (const auto& space : GetHeap()->GetContinuousSpaces()) {
@@ -1162,8 +1198,10 @@ void MarkSweep::MarkRootsCheckpoint(Thread* self,
   CheckpointMarkThreadRoots check_point(this, revoke_ros_alloc_thread_local_buffers_at_checkpoint);
   ThreadList* thread_list = Runtime::Current()->GetThreadList();
   // Request the check point is run on all threads returning a count of the threads that must
-  // run through the barrier including self.
-  size_t barrier_count = thread_list->RunCheckpoint(&check_point);
+  // run through the barrier including self. The heap thread pool marks the roots of the suspended
+  // threads in parallel.
+  ThreadPool* thread_pool = GetThreadCount(false) > 1 ? heap_->GetThreadPool() : nullptr;
+  size_t barrier_count = thread_list->RunCheckpoint(&check_point, nullptr, thread_pool);
   // Release locks then wait for all mutator threads to pass the barrier.
   // If there are no threads to wait which implys that all the checkpoint functions are finished,
   // then no need to release locks.
@@ -1180,6 +1218,114 @@ void MarkSweep::MarkRootsCheckpoint(Thread* self,
   Locks::heap_bitmap_lock_->ExclusiveLock(self);
 }
 
+// Sweeps a slice of the allocation stack for a single space, compacting the objects of other
+// spaces to the start of the slice.
+class MarkSweep::SweepArrayTask : public Task {
+ public:
+  SweepArrayTask(space::AllocSpace* alloc_space,
+                 space::ContinuousSpace* space,
+                 accounting::ContinuousSpaceBitmap* mark_bitmap,
+                 StackReference<mirror::Object>* objects,
+                 size_t count,
+                 size_t* out_count,
+                 ObjectBytePair* freed)
+      : alloc_space_(alloc_space),
+        space_(space),
+        mark_bitmap_(mark_bitmap),
+        objects_(objects),
+        count_(count),
+        out_count_(out_count),
+        freed_(freed) {}
+
+  // The GC thread holds the heap bitmap lock and waits for the slices to be swept.
+  void Run(Thread* self) OVERRIDE NO_THREAD_SAFETY_ANALYSIS {
+    std::vector<mirror::Object*> free_buffer;
+    free_buffer.reserve(kSweepArrayChunkFreeSize);
+    StackReference<mirror::Object>* out = objects_;
+    for (size_t i = 0; i < count_; ++i) {
+      mirror::Object* const obj = objects_[i].AsMirrorPtr();
+      if (kUseThreadLocalAllocationStack && obj == nullptr) {
+        continue;
+      }
+      if (space_->HasAddress(obj)) {
+        if (!mark_bitmap_->Test(obj)) {
+          if (free_buffer.size() >= kSweepArrayChunkFreeSize) {
+            FreeList(self, &free_buffer);
+          }
+          free_buffer.push_back(obj);
+        }
+      } else {
+        (out++)->Assign(obj);
+      }
+    }
+    FreeList(self, &free_buffer);
+    *out_count_ = out - objects_;
+  }
+
+  void Finalize() OVERRIDE {
+    delete this;
+  }
+
+ private:
+  void FreeList(Thread* self, std::vector<mirror::Object*>* free_buffer)
+      NO_THREAD_SAFETY_ANALYSIS {
+    if (!free_buffer->empty()) {
+      freed_->objects += free_buffer->size();
+      freed_->bytes += alloc_space_->FreeList(self, free_buffer->size(), free_buffer->data());
+      free_buffer->clear();
+    }
+  }
+
+  space::AllocSpace* const alloc_space_;
+  space::ContinuousSpace* const space_;
+  accounting::ContinuousSpaceBitmap* const mark_bitmap_;
+  StackReference<mirror::Object>* const objects_;
+  const size_t count_;
+  size_t* const out_count_;
+  ObjectBytePair* const freed_;
+};
+
+size_t MarkSweep::SweepArrayParallel(space::AllocSpace* alloc_space,
+                                     space::ContinuousSpace* space,
+                                     accounting::ContinuousSpaceBitmap* mark_bitmap,
+                                     StackReference<mirror::Object>* objects,
+                                     size_t count,
+                                     ThreadPool* thread_pool,
+                                     size_t thread_count,
+                                     ObjectBytePair* freed) {
+  Thread* self = Thread::Current();
+  const size_t chunk_size =
+      std::max((count + thread_count - 1) / thread_count, kMinSweepArrayChunkSize);
+  const size_t chunk_count = (count + chunk_size - 1) / chunk_size;
+  std::vector<size_t> out_counts(chunk_count, 0u);
+  std::vector<ObjectBytePair> chunk_freed(chunk_count);
+  for (size_t i = 0; i < chunk_count; ++i) {
+    const size_t begin = i * chunk_size;
+    thread_pool->AddTask(self, new SweepArrayTask(alloc_space,
+                                                  space,
+                                                  mark_bitmap,
+                                                  objects + begin,
+                                                  std::min(chunk_size, count - begin),
+                                                  &out_counts[i],
+                                                  &chunk_freed[i]));
+  }
+  thread_pool->SetMaxActiveWorkers(std::min(chunk_count - 1, thread_pool->GetThreadCount()));
+  thread_pool->StartWorkers(self);
+  thread_pool->Wait(self, /* do_work */ true, /* may_hold_locks */ true);
+  thread_pool->StopWorkers(self);
+  // Each slice left the objects of the other spaces at its start, move them next to each other.
+  StackReference<mirror::Object>* out = objects;
+  for (size_t i = 0; i < chunk_count; ++i) {
+    StackReference<mirror::Object>* const chunk_begin = objects + i * chunk_size;
+    if (out != chunk_begin) {
+      memmove(out, chunk_begin, out_counts[i] * sizeof(*out));
+    }
+    out += out_counts[i];
+    freed->Add(chunk_freed[i]);
+  }
+  return out - objects;
+}
+
 void MarkSweep::SweepArray(accounting::ObjectStack* allocations, bool swap_bitmaps) {
   TimingLogger::ScopedTiming t(__FUNCTION__, GetTimings());
   Thread* self = Thread::Current();
@@ -1210,6 +1356,8 @@ void MarkSweep::SweepArray(accounting::ObjectStack* allocations, bool swap_bitma
   if (non_moving_space != nullptr) {
     sweep_spaces.push_back(non_moving_space);
   }
+  ThreadPool* thread_pool = GetHeap()->GetThreadPool();
+  const size_t thread_count = GetThreadCount(!IsConcurrent());
   // Start by sweeping the continuous spaces.
   for (space::ContinuousSpace* space : sweep_spaces) {
     space::AllocSpace* alloc_space = space->AsAllocSpace();
@@ -1218,6 +1366,11 @@ void MarkSweep::SweepArray(accounting::ObjectStack* allocations, bool swap_bitma
     if (swap_bitmaps) {
       std::swap(live_bitmap, mark_bitmap);
     }
+    if (space->IsMallocSpace() && thread_count > 1 && count >= 2 * kMinSweepArrayChunkSize) {
+      count = SweepArrayParallel(alloc_space, space, mark_bitmap, objects, count, thread_pool,
+                                 thread_count, &freed);
+      continue;
+    }
     StackReference<mirror::Object>* out = objects;
     for (size_t i = 0; i < count; ++i) {
       mirror::Object* const obj = objects[i].AsMirrorPtr();
@@ -1293,13 +1446,19 @@ void MarkSweep::Sweep(bool swap_bitmaps) {
     live_stack->Reset();
     DCHECK(mark_stack_->IsEmpty());
   }
+  const size_t thread_count = GetThreadCount(!IsConcurrent());
   for (const auto& space : GetHeap()->GetContinuousSpaces()) {
     if (space->IsContinuousMemMapAllocSpace()) {
       space::ContinuousMemMapAllocSpace* alloc_space = space->AsContinuousMemMapAllocSpace();
       TimingLogger::ScopedTiming split(
           alloc_space->IsZygoteSpace() ? "SweepZygoteSpace" : "SweepMallocSpace",
           GetTimings());
-      RecordFree(alloc_space->Sweep(swap_bitmaps));
+      if (alloc_space->IsMallocSpace() && thread_count > 1) {
+        RecordFree(alloc_space->AsMallocSpace()->SweepParallel(
+            swap_bitmaps, GetHeap()->GetThreadPool(), thread_count));
+      } else {
+        RecordFree(alloc_space->Sweep(swap_bitmaps));
+      }
     }
   }
   SweepLargeObjects(swap_bitmaps);
@@ -1365,26 +1524,185 @@ void MarkSweep::ScanObject(mirror::Object* obj) {
   ScanObjectVisit(obj, mark_visitor, ref_visitor);
 }
 
+// The state shared by the tasks of one ProcessMarkStackParallel() call.
+class MarkSweep::WorkStealingMarkState {
+ public:
+  explicit WorkStealingMarkState(size_t task_count)
+      : objects_scanned(task_count, 0u), steals(task_count, 0u) {
+    for (size_t i = 0; i < task_count; ++i) {
+      deques.emplace_back(new ObjectDeque(kWorkStealingDequeCapacity));
+    }
+  }
+
+  bool AllDequesEmpty() const {
+    for (const std::unique_ptr<ObjectDeque>& deque : deques) {
+      if (!deque->IsEmpty()) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  using ObjectDeque = accounting::WorkStealingDeque<mirror::Object>;
+  std::vector<std::unique_ptr<ObjectDeque>> deques;
+  // Tasks which started running, and the ones of them that ran out of work. Marking is done once
+  // all the started tasks are idle and no deque has work, including the ones of unstarted tasks.
+  Atomic<size_t> started_tasks;
+  Atomic<size_t> idle_tasks;
+  // Written by each task for itself.
+  std::vector<size_t> objects_scanned;
+  std::vector<size_t> steals;
+};
+
+// Marks from its own deque, steals from the deques of the other tasks when it runs out.
+class MarkSweep::WorkStealingMarkTask : public Task {
+ public:
+  WorkStealingMarkTask(MarkSweep* mark_sweep, WorkStealingMarkState* state, size_t index)
+      : mark_sweep_(mark_sweep), state_(state), index_(index) {}
+
+  // The GC thread holds the heap bitmap lock and the mutator lock for the tasks.
+  void Run(Thread* self ATTRIBUTE_UNUSED) OVERRIDE NO_THREAD_SAFETY_ANALYSIS {
+    state_->started_tasks.FetchAndAddSequentiallyConsistent(1u);
+    WorkStealingMarkState::ObjectDeque* const deque = state_->deques[index_].get();
+    MarkObjectVisitor mark_visitor(mark_sweep_, deque);
+    DelayReferenceReferentVisitor ref_visitor(mark_sweep_);
+    size_t objects_scanned = 0;
+    size_t steals = 0;
+    for (;;) {
+      for (mirror::Object* obj = deque->Pop(); obj != nullptr; obj = deque->Pop()) {
+        mark_sweep_->ScanObjectVisit(obj, mark_visitor, ref_visitor);
+        ++objects_scanned;
+      }
+      mirror::Object* const stolen = Steal();
+      if (stolen != nullptr) {
+        ++steals;
+        deque->Push(stolen);
+      } else if (WaitForWorkOrTermination()) {
+        break;
+      }
+    }
+    state_->objects_scanned[index_] = objects_scanned;
+    state_->steals[index_] = steals;
+  }
+
+  void Finalize() OVERRIDE {
+    delete this;
+  }
+
+ private:
+  class MarkObjectVisitor {
+   public:
+    MarkObjectVisitor(MarkSweep* mark_sweep, WorkStealingMarkState::ObjectDeque* deque)
+        : mark_sweep_(mark_sweep), deque_(deque) {}
+
+    ALWAYS_INLINE void operator()(mirror::Object* obj,
+                                  MemberOffset offset,
+                                  bool is_static ATTRIBUTE_UNUSED) const
+        REQUIRES_SHARED(Locks::mutator_lock_) {
+      Mark(obj->GetFieldObject<mirror::Object>(offset));
+    }
+
+    void VisitRootIfNonNull(mirror::CompressedReference<mirror::Object>* root) const
+        REQUIRES_SHARED(Locks::mutator_lock_) {
+      if (!root->IsNull()) {
+        VisitRoot(root);
+      }
+    }
+
+    void VisitRoot(mirror::CompressedReference<mirror::Object>* root) const
+        REQUIRES_SHARED(Locks::mutator_lock_) {
+      Mark(root->AsMirrorPtr());
+    }
+
+   private:
+    ALWAYS_INLINE void Mark(mirror::Object* ref) const REQUIRES_SHARED(Locks::mutator_lock_) {
+      if (ref != nullptr && mark_sweep_->MarkObjectParallel(ref)) {
+        deque_->Push(ref);
+      }
+    }
+
+    MarkSweep* const mark_sweep_;
+    WorkStealingMarkState::ObjectDeque* const deque_;
+  };
+
+  // Tries to steal an object from each of the other deques once.
+  mirror::Object* Steal() {
+    const size_t task_count = state_->deques.size();
+    for (size_t i = 1; i < task_count; ++i) {
+      mirror::Object* obj = state_->deques[(index_ + i) % task_count]->Steal();
+      if (obj != nullptr) {
+        return obj;
+      }
+    }
+    return nullptr;
+  }
+
+  // Spins until some deque has work or marking is done. Returns true if marking is done.
+  bool WaitForWorkOrTermination() {
+    state_->idle_tasks.FetchAndAddSequentiallyConsistent(1u);
+    for (;;) {
+      if (!state_->AllDequesEmpty()) {
+        state_->idle_tasks.FetchAndSubSequentiallyConsistent(1u);
+        return false;
+      }
+      // An idle task has an empty deque and only leaves idle to steal, so no task can produce
+      // work once all the started ones are idle.
+      if (state_->idle_tasks.LoadSequentiallyConsistent() ==
+              state_->started_tasks.LoadSequentiallyConsistent() &&
+          state_->AllDequesEmpty()) {
+        return true;
+      }
+      sched_yield();
+    }
+  }
+
+  MarkSweep* const mark_sweep_;
+  WorkStealingMarkState* const state_;
+  const size_t index_;
+};
+
 void MarkSweep::ProcessMarkStackParallel(size_t thread_count) {
   Thread* self = Thread::Current();
   ThreadPool* thread_pool = GetHeap()->GetThreadPool();
-  const size_t chunk_size = std::min(mark_stack_->Size() / thread_count + 1,
-                                     static_cast<size_t>(MarkStackTask<false>::kMaxSize));
-  CHECK_GT(chunk_size, 0U);
-  // Split the current mark stack up into work tasks.
-  for (auto* it = mark_stack_->Begin(), *end = mark_stack_->End(); it < end; ) {
-    const size_t delta = std::min(static_cast<size_t>(end - it), chunk_size);
-    thread_pool->AddTask(self, new MarkStackTask<false>(thread_pool, this, delta, it));
-    it += delta;
+  WorkStealingMarkState state(thread_count);
+  // Deal the current mark stack out to the deques before any task runs.
+  size_t index = 0;
+  for (auto* it = mark_stack_->Begin(), *end = mark_stack_->End(); it < end; ++it) {
+    state.deques[index]->Push(it->AsMirrorPtr());
+    index = (index + 1) % thread_count;
+  }
+  mark_stack_->Reset();
+  for (size_t i = 0; i < thread_count; ++i) {
+    thread_pool->AddTask(self, new WorkStealingMarkTask(this, &state, i));
   }
   thread_pool->SetMaxActiveWorkers(thread_count - 1);
   thread_pool->StartWorkers(self);
   thread_pool->Wait(self, true, true);
   thread_pool->StopWorkers(self);
-  mark_stack_->Reset();
-  CHECK_EQ(work_chunks_created_.LoadSequentiallyConsistent(),
-           work_chunks_deleted_.LoadSequentiallyConsistent())
-      << " some of the work chunks were leaked";
+  DCHECK(state.AllDequesEmpty());
+  MutexLock mu(self, mark_stack_lock_);
+  ++cumulative_parallel_mark_stack_rounds_;
+  if (cumulative_objects_scanned_by_task_.size() < thread_count) {
+    cumulative_objects_scanned_by_task_.resize(thread_count, 0u);
+  }
+  for (size_t i = 0; i < thread_count; ++i) {
+    cumulative_objects_scanned_by_task_[i] += state.objects_scanned[i];
+    cumulative_steals_ += state.steals[i];
+  }
+}
+
+void MarkSweep::DumpPerformanceInfo(std::ostream& os) {
+  GarbageCollector::DumpPerformanceInfo(os);
+  MutexLock mu(Thread::Current(), mark_stack_lock_);
+  if (cumulative_parallel_mark_stack_rounds_ == 0) {
+    return;
+  }
+  os << "Parallel mark stack processing rounds " << cumulative_parallel_mark_stack_rounds_
+     << " with " << cumulative_steals_ << " steals\n";
+  for (size_t i = 0; i < cumulative_objects_scanned_by_task_.size(); ++i) {
+    os << "Cumulative objects scanned by parallel mark task " << i << " "
+       << cumulative_objects_scanned_by_task_[i] << "\n";
+  }
 }
 
 // Scan anything that's on the mark stack.
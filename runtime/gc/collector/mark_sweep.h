@@ -18,6 +18,7 @@
 #define ART_RUNTIME_GC_COLLECTOR_MARK_SWEEP_H_
 
 #include <memory>
+#include <vector>
 
 #include "atomic.h"
 #include "barrier.h"
@@ -37,7 +38,9 @@ class Object;
 class Reference;
 }  // namespace mirror
 
+template <typename T> class StackReference;
 class Thread;
+class ThreadPool;
 enum VisitRootFlags : uint8_t;
 
 namespace gc {
@@ -49,6 +52,11 @@ template<typename T> class AtomicStack;
 typedef AtomicStack<mirror::Object> ObjectStack;
 }  // namespace accounting
 
+namespace space {
+class AllocSpace;
+class ContinuousSpace;
+}  // namespace space
+
 namespace collector {
 
 class MarkSweep : public GarbageCollector {
@@ -58,6 +66,7 @@ class MarkSweep : public GarbageCollector {
   ~MarkSweep() {}
 
   virtual void RunPhases() OVERRIDE REQUIRES(!mark_stack_lock_);
+  void DumpPerformanceInfo(std::ostream& os) OVERRIDE REQUIRES(!mark_stack_lock_);
   void InitializePhase();
   void MarkingPhase() REQUIRES(!mark_stack_lock_) REQUIRES_SHARED(Locks::mutator_lock_);
   void PausePhase() REQUIRES(Locks::mutator_lock_) REQUIRES(!mark_stack_lock_);
@@ -153,11 +162,29 @@ class MarkSweep : public GarbageCollector {
   // Sweeps unmarked objects to complete the garbage collection.
   void SweepLargeObjects(bool swap_bitmaps) REQUIRES(Locks::heap_bitmap_lock_);
 
+  // Record the marked objects of a sample of the heap in the heap's class histogram, if any.
+  void SampleClassHistogram()
+      REQUIRES_SHARED(Locks::heap_bitmap_lock_)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
   // Sweep only pointers within an array. WARNING: Trashes objects.
   void SweepArray(accounting::ObjectStack* allocation_stack_, bool swap_bitmaps)
       REQUIRES(Locks::heap_bitmap_lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Sweeps the entries of objects[0, count) which are in space on up to thread_count threads and
+  // returns how many entries of other spaces remain, moved to the start of objects.
+  size_t SweepArrayParallel(space::AllocSpace* alloc_space,
+                            space::ContinuousSpace* space,
+                            accounting::ContinuousSpaceBitmap* mark_bitmap,
+                            StackReference<mirror::Object>* objects,
+                            size_t count,
+                            ThreadPool* thread_pool,
+                            size_t thread_count,
+                            ObjectBytePair* freed)
+      REQUIRES(Locks::heap_bitmap_lock_)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
   // Blackens an object.
   void ScanObject(mirror::Object* obj)
       REQUIRES(Locks::heap_bitmap_lock_)
@@ -292,6 +319,7 @@ class MarkSweep : public GarbageCollector {
       REQUIRES(!mark_stack_lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Processes the mark stack with thread_count tasks which steal work from each other.
   void ProcessMarkStackParallel(size_t thread_count)
       REQUIRES(Locks::heap_bitmap_lock_)
       REQUIRES(!mark_stack_lock_)
@@ -346,6 +374,12 @@ class MarkSweep : public GarbageCollector {
   std::unique_ptr<Barrier> gc_barrier_;
   Mutex mark_stack_lock_ ACQUIRED_AFTER(Locks::classlinker_classes_lock_);
 
+  // Load balance of the parallel mark stack processing over all GCs, used for
+  // DumpPerformanceInfo.
+  uint64_t cumulative_parallel_mark_stack_rounds_ GUARDED_BY(mark_stack_lock_);
+  uint64_t cumulative_steals_ GUARDED_BY(mark_stack_lock_);
+  std::vector<uint64_t> cumulative_objects_scanned_by_task_ GUARDED_BY(mark_stack_lock_);
+
   const bool is_concurrent_;
 
   // Verification.
@@ -358,6 +392,7 @@ class MarkSweep : public GarbageCollector {
   class CheckpointMarkThreadRoots;
   class DelayReferenceReferentVisitor;
   template<bool kUseFinger> class MarkStackTask;
+  class SweepArrayTask;
   class MarkObjectSlowPath;
   class RecursiveMarkTask;
   class ScanObjectParallelVisitor;
@@ -365,6 +400,8 @@ class MarkSweep : public GarbageCollector {
   class VerifyRootMarkedVisitor;
   class VerifyRootVisitor;
   class VerifySystemWeakVisitor;
+  class WorkStealingMarkState;
+  class WorkStealingMarkTask;
 
   DISALLOW_IMPLICIT_CONSTRUCTORS(MarkSweep);
 };
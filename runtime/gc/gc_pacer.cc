@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gc_pacer.h"
+
+#include <algorithm>
+
+#include "base/logging.h"
+#include "base/time_utils.h"
+
+namespace art {
+namespace gc {
+
+GcPacer::GcPacer(uint64_t start_time_ns)
+    : last_end_time_ns_(start_time_ns),
+      last_bytes_allocated_after_gc_(0u),
+      last_allocation_rate_(0.0),
+      smoothed_allocation_rate_(0.0),
+      last_duration_ns_(0u),
+      smoothed_duration_ns_(0.0),
+      num_collections_(0u) {}
+
+void GcPacer::RecordCollection(uint64_t end_time_ns,
+                               uint64_t duration_ns,
+                               uint64_t bytes_allocated_before_gc,
+                               uint64_t bytes_allocated_during_gc,
+                               uint64_t bytes_allocated_after_gc) {
+  DCHECK_GE(end_time_ns, last_end_time_ns_);
+  // The bytes allocated since the previous collection finished. Bytes freed outside of a
+  // collection, e.g. by trimming, may make the heap shrink in between.
+  const uint64_t bytes_allocated_before_gc_since_last =
+      bytes_allocated_before_gc > last_bytes_allocated_after_gc_
+          ? bytes_allocated_before_gc - last_bytes_allocated_after_gc_
+          : 0u;
+  const uint64_t bytes_allocated = bytes_allocated_before_gc_since_last + bytes_allocated_during_gc;
+  // Avoid dividing by zero for back to back collections.
+  const uint64_t interval_ns = std::max<uint64_t>(end_time_ns - last_end_time_ns_, 1u);
+  last_allocation_rate_ = static_cast<double>(bytes_allocated) * MsToNs(1000) / interval_ns;
+  last_duration_ns_ = duration_ns;
+  if (num_collections_ == 0) {
+    smoothed_allocation_rate_ = last_allocation_rate_;
+    smoothed_duration_ns_ = static_cast<double>(duration_ns);
+  } else {
+    smoothed_allocation_rate_ = kSmoothingFactor * last_allocation_rate_ +
+        (1.0 - kSmoothingFactor) * smoothed_allocation_rate_;
+    smoothed_duration_ns_ = kSmoothingFactor * duration_ns +
+        (1.0 - kSmoothingFactor) * smoothed_duration_ns_;
+  }
+  last_end_time_ns_ = end_time_ns;
+  last_bytes_allocated_after_gc_ = bytes_allocated_after_gc;
+  ++num_collections_;
+}
+
+uint64_t GcPacer::GetAllocationRate() const {
+  return static_cast<uint64_t>(std::max(last_allocation_rate_, smoothed_allocation_rate_));
+}
+
+uint64_t GcPacer::GetPredictedDurationNs() const {
+  return std::max(last_duration_ns_, static_cast<uint64_t>(smoothed_duration_ns_));
+}
+
+uint64_t GcPacer::GetRemainingBytes() const {
+  const double duration_seconds = static_cast<double>(GetPredictedDurationNs()) / MsToNs(1000);
+  return static_cast<uint64_t>(GetAllocationRate() * duration_seconds * (1.0 + kSafetyMargin));
+}
+
+}  // namespace gc
+}  // namespace art
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_GC_GC_PACER_H_
+#define ART_RUNTIME_GC_GC_PACER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "base/macros.h"
+
+namespace art {
+namespace gc {
+
+// Predicts how early the next concurrent collection has to start so that it finishes before the
+// heap reaches its footprint limit. The prediction uses the mutator allocation rate and the
+// collection duration, both smoothed over the recent collections. To react to bursts the larger
+// of the smoothed and the latest sample is used, then a safety margin is added on top.
+class GcPacer {
+ public:
+  // Weight of the latest sample in the smoothed allocation rate and collection duration.
+  static constexpr double kSmoothingFactor = 0.5;
+  // Fraction of the predicted remaining bytes added to cover misprediction.
+  static constexpr double kSafetyMargin = 0.5;
+
+  explicit GcPacer(uint64_t start_time_ns);
+
+  // Record a finished collection. The byte counts are the heap's allocated bytes when the
+  // collection started and when it finished, and how many bytes were allocated while it ran.
+  void RecordCollection(uint64_t end_time_ns,
+                        uint64_t duration_ns,
+                        uint64_t bytes_allocated_before_gc,
+                        uint64_t bytes_allocated_during_gc,
+                        uint64_t bytes_allocated_after_gc);
+
+  // The predicted allocation rate in bytes per second.
+  uint64_t GetAllocationRate() const;
+
+  // The predicted duration of the next collection.
+  uint64_t GetPredictedDurationNs() const;
+
+  // How many bytes may still be allocated when the next concurrent collection starts: the bytes
+  // the mutators are predicted to allocate while it runs, plus the safety margin. 0 until a
+  // collection was recorded.
+  uint64_t GetRemainingBytes() const;
+
+  size_t GetNumCollections() const {
+    return num_collections_;
+  }
+
+ private:
+  uint64_t last_end_time_ns_;
+  uint64_t last_bytes_allocated_after_gc_;
+  // Bytes per second.
+  double last_allocation_rate_;
+  double smoothed_allocation_rate_;
+  uint64_t last_duration_ns_;
+  double smoothed_duration_ns_;
+  size_t num_collections_;
+
+  DISALLOW_COPY_AND_ASSIGN(GcPacer);
+};
+
+}  // namespace gc
+}  // namespace art
+
+#endif  // ART_RUNTIME_GC_GC_PACER_H_
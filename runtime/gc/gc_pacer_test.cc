@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gc_pacer.h"
+
+#include "base/time_utils.h"
+#include "globals.h"
+#include "gtest/gtest.h"
+
+namespace art {
+namespace gc {
+
+TEST(GcPacerTest, SteadyAllocationRate) {
+  GcPacer pacer(0u);
+  EXPECT_EQ(pacer.GetRemainingBytes(), 0u);
+  // 10MB allocated per second, 8MB of them before each GC and 2MB during the 200ms it runs.
+  // The heap holds 16MB after each GC, the first GC counts the bytes allocated since creation.
+  uint64_t time_ns = 0u;
+  for (size_t i = 0; i < 4; ++i) {
+    time_ns += MsToNs(1000);
+    const uint64_t bytes_allocated_before_gc = (i == 0) ? 8 * MB : 16 * MB + 8 * MB;
+    pacer.RecordCollection(time_ns, MsToNs(200), bytes_allocated_before_gc, 2 * MB, 16 * MB);
+  }
+  EXPECT_EQ(pacer.GetNumCollections(), 4u);
+  EXPECT_EQ(pacer.GetPredictedDurationNs(), MsToNs(200));
+  EXPECT_EQ(pacer.GetAllocationRate(), 10 * MB);
+  // 2MB to be allocated while the next GC runs, plus the safety margin.
+  EXPECT_EQ(pacer.GetRemainingBytes(), 3 * MB);
+}
+
+TEST(GcPacerTest, Burst) {
+  GcPacer pacer(0u);
+  pacer.RecordCollection(MsToNs(1000), MsToNs(100), 10 * MB, 1 * MB, 10 * MB);
+  const uint64_t steady_remaining = pacer.GetRemainingBytes();
+  // A burst of 40MB in 100ms must raise the prediction right away, not after smoothing.
+  pacer.RecordCollection(MsToNs(1100), MsToNs(100), 50 * MB, 0u, 10 * MB);
+  EXPECT_EQ(pacer.GetAllocationRate(), 400 * MB);
+  EXPECT_GT(pacer.GetRemainingBytes(), 10 * steady_remaining);
+  // Once the burst is over, the smoothed rate makes the prediction decay instead of dropping.
+  pacer.RecordCollection(MsToNs(2100), MsToNs(100), 20 * MB, 1 * MB, 10 * MB);
+  EXPECT_LT(pacer.GetAllocationRate(), 400 * MB);
+  EXPECT_GT(pacer.GetAllocationRate(), 11 * MB);
+}
+
+TEST(GcPacerTest, HeapShrankBetweenCollections) {
+  GcPacer pacer(0u);
+  pacer.RecordCollection(MsToNs(1000), MsToNs(100), 10 * MB, 0u, 10 * MB);
+  // The heap shrank below what the last GC left, only the bytes allocated during the GC count.
+  pacer.RecordCollection(MsToNs(2000), MsToNs(100), 5 * MB, 10 * MB, 5 * MB);
+  EXPECT_EQ(pacer.GetAllocationRate(), 10 * MB);
+}
+
+}  // namespace gc
+}  // namespace art
@@ -78,6 +78,8 @@ inline mirror::Object* Heap::AllocObjectWithAllocator(Thread* self,
   size_t bytes_allocated;
   size_t usable_size;
   size_t new_num_bytes_allocated = 0;
+  // Only the slow path may have an allocation to sample, see SetAllocationSampler().
+  bool slow_path_allocation = false;
   if (IsTLABAllocator(allocator)) {
     byte_count = RoundUp(byte_count, space::BumpPointerSpace::kAlignment);
   }
@@ -106,6 +108,7 @@ inline mirror::Object* Heap::AllocObjectWithAllocator(Thread* self,
     pre_fence_visitor(obj, usable_size);
     QuasiAtomic::ThreadFenceForConstructor();
   } else {
+    slow_path_allocation = true;
     // bytes allocated that takes bulk thread-local buffer allocations into account.
     size_t bytes_tl_bulk_allocated = 0;
     obj = TryToAllocate<kInstrumented, false>(self, allocator, byte_count, &bytes_allocated,
@@ -194,6 +197,9 @@ inline mirror::Object* Heap::AllocObjectWithAllocator(Thread* self,
   } else {
     DCHECK(!IsAllocTrackingEnabled());
   }
+  if (slow_path_allocation && UNLIKELY(alloc_sampler_.LoadRelaxed() != nullptr)) {
+    SampleAllocation(self, allocator, bytes_allocated, &obj);
+  }
   if (AllocatorHasAllocationStack(allocator)) {
     PushOnAllocationStack(self, &obj);
   }
@@ -252,6 +258,7 @@ inline mirror::Object* Heap::TryToAllocate(Thread* self,
   if (allocator_type != kAllocatorTypeTLAB &&
       allocator_type != kAllocatorTypeRegionTLAB &&
       allocator_type != kAllocatorTypeRosAlloc &&
+      allocator_type != kAllocatorTypeRosAllocPerCpu &&
       UNLIKELY(IsOutOfMemoryOnAllocation(allocator_type, alloc_size, kGrow))) {
     return nullptr;
   }
@@ -268,7 +275,8 @@ inline mirror::Object* Heap::TryToAllocate(Thread* self,
       }
       break;
     }
-    case kAllocatorTypeRosAlloc: {
+    case kAllocatorTypeRosAlloc:
+    case kAllocatorTypeRosAllocPerCpu: {
       if (kInstrumented && UNLIKELY(is_running_on_memory_tool_)) {
         // If running on valgrind or asan, we should be using the instrumented path.
         size_t max_bytes_tl_bulk_allocated = rosalloc_space_->MaxBytesBulkAllocatedFor(alloc_size);
@@ -16,11 +16,14 @@
 
 #include "heap.h"
 
+#include <cmath>
 #include <limits>
+#include <sched.h>
 #include <memory>
 #include <vector>
 
 #include "android-base/stringprintf.h"
+#include "android-base/strings.h"
 
 #include "allocation_listener.h"
 #include "art_field-inl.h"
@@ -44,12 +47,14 @@
 #include "gc/accounting/read_barrier_table.h"
 #include "gc/accounting/remembered_set.h"
 #include "gc/accounting/space_bitmap-inl.h"
+#include "gc/class_histogram.h"
 #include "gc/collector/concurrent_copying.h"
 #include "gc/collector/mark_compact.h"
 #include "gc/collector/mark_sweep.h"
 #include "gc/collector/partial_mark_sweep.h"
 #include "gc/collector/semi_space.h"
 #include "gc/collector/sticky_mark_sweep.h"
+#include "gc/gc_pacer.h"
 #include "gc/reference_processor.h"
 #include "gc/scoped_gc_critical_section.h"
 #include "gc/space/bump_pointer_space.h"
@@ -83,6 +88,7 @@
 #include "reflection.h"
 #include "runtime.h"
 #include "scoped_thread_state_change-inl.h"
+#include "startup_phases.h"
 #include "thread_list.h"
 #include "verify_object-inl.h"
 #include "well_known_classes.h"
@@ -141,6 +147,15 @@ static constexpr bool kLogAllGCs = false;
 static constexpr size_t kPartialTlabSize = 16 * KB;
 static constexpr bool kUsePartialTlabs = true;
 
+// Adaptive TLAB sizing. A thread refilling its TLAB faster than every kTlabFastRefillInterval gets
+// the TLAB size doubled, faster than every kTlabBurstRefillInterval quadrupled. A thread refilling
+// slower than every kTlabSlowRefillInterval or wasting more than half of a TLAB gets it halved.
+static constexpr bool kUseAdaptiveTlabSize = true;
+static constexpr uint64_t kTlabBurstRefillInterval = MsToNs(1);
+static constexpr uint64_t kTlabFastRefillInterval = MsToNs(10);
+static constexpr uint64_t kTlabSlowRefillInterval = MsToNs(100);
+static constexpr size_t kMinTlabSize = 4 * KB;
+
 #if defined(__LP64__) || !defined(ADDRESS_SANITIZER)
 // 300 MB (0x12c00000) - (default non-moving space capacity).
 static uint8_t* const kPreferredAllocSpaceBegin =
@@ -180,6 +195,7 @@ Heap::Heap(size_t initial_size,
            size_t long_gc_log_threshold,
            bool ignore_max_footprint,
            bool use_tlab,
+           bool use_rosalloc_per_cpu_runs,
            bool verify_pre_gc_heap,
            bool verify_pre_sweeping_heap,
            bool verify_post_gc_heap,
@@ -189,7 +205,12 @@ Heap::Heap(size_t initial_size,
            bool gc_stress_mode,
            bool measure_gc_performance,
            bool use_homogeneous_space_compaction_for_oom,
-           uint64_t min_interval_homogeneous_space_compaction_by_oom)
+           uint64_t min_interval_homogeneous_space_compaction_by_oom,
+           bool use_generational_cc,
+           size_t sampled_verification_regions,
+           bool use_huge_pages,
+           bool use_gc_pacer,
+           size_t class_histogram_sampling_rate)
     : non_moving_space_(nullptr),
       rosalloc_space_(nullptr),
       dlmalloc_space_(nullptr),
@@ -224,6 +245,7 @@ Heap::Heap(size_t initial_size,
       num_bytes_allocated_(0),
       new_native_bytes_allocated_(0),
       old_native_bytes_allocated_(0),
+      native_gcs_deferred_for_enqueue_backlog_(0u),
       num_bytes_freed_revoke_(0),
       verify_missing_card_marks_(false),
       verify_system_weaks_(false),
@@ -258,8 +280,11 @@ Heap::Heap(size_t initial_size,
       semi_space_collector_(nullptr),
       mark_compact_collector_(nullptr),
       concurrent_copying_collector_(nullptr),
+      young_concurrent_copying_collector_(nullptr),
+      active_concurrent_copying_collector_(nullptr),
       is_running_on_memory_tool_(Runtime::Current()->IsRunningOnMemoryTool()),
       use_tlab_(use_tlab),
+      use_rosalloc_per_cpu_runs_(use_rosalloc_per_cpu_runs),
       main_space_backup_(nullptr),
       min_interval_homogeneous_space_compaction_by_oom_(
           min_interval_homogeneous_space_compaction_by_oom),
@@ -267,9 +292,19 @@ Heap::Heap(size_t initial_size,
       pending_collector_transition_(nullptr),
       pending_heap_trim_(nullptr),
       use_homogeneous_space_compaction_for_oom_(use_homogeneous_space_compaction_for_oom),
+      // The young collection relies on graying objects on dirty cards, which needs the Baker read
+      // barrier.
+      use_generational_cc_(kUseBakerReadBarrier && use_generational_cc),
+      sampled_verification_regions_(sampled_verification_regions),
+      gc_pacer_(use_gc_pacer ? new GcPacer(NanoTime()) : nullptr),
+      class_histogram_(class_histogram_sampling_rate != 0
+                           ? new ClassHistogram(class_histogram_sampling_rate)
+                           : nullptr),
       running_collection_is_blocking_(false),
       blocking_gc_count_(0U),
       blocking_gc_time_(0U),
+      allocation_stall_count_(0U),
+      allocation_stall_time_(0U),
       last_update_time_gc_count_rate_histograms_(  // Round down by the window duration.
           (NanoTime() / kGcCountRateHistogramWindowDuration) * kGcCountRateHistogramWindowDuration),
       gc_count_last_window_(0U),
@@ -281,7 +316,13 @@ Heap::Heap(size_t initial_size,
       backtrace_lock_(nullptr),
       seen_backtrace_count_(0u),
       unique_backtrace_count_(0u),
-      gc_disabled_for_shutdown_(false) {
+      gc_disabled_for_shutdown_(false),
+      total_trim_released_bytes_(0u),
+      total_trim_slices_(0u),
+      total_trim_time_ns_(0u),
+      alloc_sampler_(nullptr),
+      alloc_sample_interval_(1u),
+      alloc_sampler_instrumented_(false) {
   if (VLOG_IS_ON(heap) || VLOG_IS_ON(startup)) {
     LOG(INFO) << "Heap() entering";
   }
@@ -292,6 +333,7 @@ Heap::Heap(size_t initial_size,
   verification_.reset(new Verification(this));
   CHECK_GE(large_object_threshold, kMinLargeObjectThreshold);
   ScopedTrace trace(__FUNCTION__);
+  ScopedStartupPhase startup_phase("Heap");
   Runtime* const runtime = Runtime::Current();
   // If we aren't the zygote, switch to the default non zygote allocator. This may update the
   // entrypoints.
@@ -434,9 +476,12 @@ Heap::Heap(size_t initial_size,
     CHECK(separate_non_moving_space);
     MemMap* region_space_mem_map = space::RegionSpace::CreateMemMap(kRegionSpaceName,
                                                                     capacity_ * 2,
-                                                                    request_begin);
+                                                                    request_begin,
+                                                                    use_huge_pages);
     CHECK(region_space_mem_map != nullptr) << "No region space mem map";
-    region_space_ = space::RegionSpace::Create(kRegionSpaceName, region_space_mem_map);
+    region_space_ = space::RegionSpace::Create(kRegionSpaceName,
+                                               region_space_mem_map,
+                                               use_huge_pages);
     AddSpace(region_space_);
   } else if (IsMovingGc(foreground_collector_type_) &&
       foreground_collector_type_ != kCollectorTypeGSS) {
@@ -488,6 +533,10 @@ Heap::Heap(size_t initial_size,
     large_object_space_ = space::FreeListSpace::Create("free list large object space", nullptr,
                                                        capacity_);
     CHECK(large_object_space_ != nullptr) << "Failed to create large object space";
+  } else if (large_object_space_type == space::LargeObjectSpaceType::kSegregatedFit) {
+    large_object_space_ = space::SegregatedFitSpace::Create(
+        "segregated fit large object space", nullptr, capacity_);
+    CHECK(large_object_space_ != nullptr) << "Failed to create large object space";
   } else if (large_object_space_type == space::LargeObjectSpaceType::kMap) {
     large_object_space_ = space::LargeObjectMapSpace::Create("mem map large object space");
     CHECK(large_object_space_ != nullptr) << "Failed to create large object space";
@@ -596,11 +645,24 @@ Heap::Heap(size_t initial_size,
     }
     if (MayUseCollector(kCollectorTypeCC)) {
       concurrent_copying_collector_ = new collector::ConcurrentCopying(this,
+                                                                       /*young_gen*/ false,
                                                                        "",
                                                                        measure_gc_performance);
+      if (use_generational_cc_) {
+        young_concurrent_copying_collector_ = new collector::ConcurrentCopying(
+            this,
+            /*young_gen*/ true,
+            "young",
+            measure_gc_performance);
+      }
+      active_concurrent_copying_collector_ = concurrent_copying_collector_;
       DCHECK(region_space_ != nullptr);
       concurrent_copying_collector_->SetRegionSpace(region_space_);
       garbage_collectors_.push_back(concurrent_copying_collector_);
+      if (young_concurrent_copying_collector_ != nullptr) {
+        young_concurrent_copying_collector_->SetRegionSpace(region_space_);
+        garbage_collectors_.push_back(young_concurrent_copying_collector_);
+      }
     }
     if (MayUseCollector(kCollectorTypeMC)) {
       mark_compact_collector_ = new collector::MarkCompact(this);
@@ -832,6 +894,32 @@ void Heap::DecrementDisableThreadFlip(Thread* self) {
   }
 }
 
+void Heap::PinObjectForCriticalAccess(Thread* self, ObjPtr<mirror::Object> obj) {
+  DCHECK(IsMovableObject(obj));
+  if (kUseReadBarrier && region_space_ != nullptr && region_space_->HasAddress(obj.Ptr())) {
+    // The object cannot move before its region is pinned: the regions to evacuate are selected
+    // during the thread flip, which waits for this runnable thread.
+    region_space_->PinRegion(obj.Ptr());
+  } else if (!kUseReadBarrier) {
+    IncrementDisableMovingGC(self);
+  } else {
+    // For the CC collector, we only need to wait for the thread flip rather than the whole GC
+    // to occur thanks to the to-space invariant.
+    IncrementDisableThreadFlip(self);
+  }
+}
+
+void Heap::UnpinObjectForCriticalAccess(Thread* self, ObjPtr<mirror::Object> obj) {
+  DCHECK(IsMovableObject(obj));
+  if (kUseReadBarrier && region_space_ != nullptr && region_space_->HasAddress(obj.Ptr())) {
+    region_space_->UnpinRegion(obj.Ptr());
+  } else if (!kUseReadBarrier) {
+    DecrementDisableMovingGC(self);
+  } else {
+    DecrementDisableThreadFlip(self);
+  }
+}
+
 void Heap::ThreadFlipBegin(Thread* self) {
   // Supposed to be called by GC. Set thread_flip_running_ to be true. If disable_thread_flip_count_
   // > 0, block. Otherwise, go ahead.
@@ -956,6 +1044,9 @@ void Heap::SetSpaceAsDefault(space::ContinuousSpace* continuous_space) {
     dlmalloc_space_ = continuous_space->AsDlMallocSpace();
   } else if (continuous_space->IsRosAllocSpace()) {
     rosalloc_space_ = continuous_space->AsRosAllocSpace();
+    if (use_rosalloc_per_cpu_runs_) {
+      rosalloc_space_->GetRosAlloc()->EnablePerCpuRuns();
+    }
   }
 }
 
@@ -993,6 +1084,21 @@ void Heap::RemoveSpace(space::Space* space) {
   }
 }
 
+void Heap::AddGcTimings(TimingJsonWriter* writer) {
+  Thread* self = Thread::Current();
+  ScopedThreadStateChange tsc(self, kWaitingForGcToComplete);
+  MutexLock mu(self, *gc_complete_lock_);
+  // Holding the lock keeps a new collection from resetting the iteration timings under us.
+  WaitForGcToCompleteLocked(kGcCauseNone, self);
+  for (auto& collector : garbage_collectors_) {
+    if (collector->GetCumulativeTimings().GetIterations() == 0) {
+      continue;
+    }
+    writer->AddCumulativeLogger(collector->GetCumulativeTimings());
+    writer->AddTimingLogger(*collector->GetTimings());
+  }
+}
+
 void Heap::DumpGcPerformanceInfo(std::ostream& os) {
   // Dump cumulative timings.
   os << "Dumping cumulative Gc timings\n";
@@ -1026,10 +1132,18 @@ void Heap::DumpGcPerformanceInfo(std::ostream& os) {
   }
   os << "Total mutator paused time: " << PrettyDuration(total_paused_time) << "\n";
   os << "Total time waiting for GC to complete: " << PrettyDuration(total_wait_time_) << "\n";
+  os << "Total time blocked in Reference.get(): "
+     << PrettyDuration(reference_processor_->GetReferentBlockedTime()) << " ("
+     << reference_processor_->GetReferentBlockedCount() << " times)\n";
+  reference_processor_->DumpEnqueueStatistics(os);
+  os << "Native allocation GCs deferred for the reference queue backlog: "
+     << native_gcs_deferred_for_enqueue_backlog_.LoadRelaxed() << "\n";
   os << "Total GC count: " << GetGcCount() << "\n";
   os << "Total GC time: " << PrettyDuration(GetGcTime()) << "\n";
   os << "Total blocking GC count: " << GetBlockingGcCount() << "\n";
   os << "Total blocking GC time: " << PrettyDuration(GetBlockingGcTime()) << "\n";
+  os << "Total allocation stall time: " << PrettyDuration(GetAllocationStallTime()) << " ("
+     << GetAllocationStallCount() << " times)\n";
 
   {
     MutexLock mu(Thread::Current(), *gc_complete_lock_);
@@ -1074,6 +1188,8 @@ void Heap::ResetGcPerformanceInfo() {
     MutexLock mu(Thread::Current(), *gc_complete_lock_);
     gc_count_rate_histogram_.Reset();
     blocking_gc_count_rate_histogram_.Reset();
+    allocation_stall_count_ = 0;
+    allocation_stall_time_ = 0;
   }
 }
 
@@ -1101,6 +1217,28 @@ uint64_t Heap::GetBlockingGcTime() const {
   return blocking_gc_time_;
 }
 
+uint64_t Heap::GetAllocationStallCount() const {
+  MutexLock mu(Thread::Current(), *gc_complete_lock_);
+  return allocation_stall_count_;
+}
+
+uint64_t Heap::GetAllocationStallTime() const {
+  MutexLock mu(Thread::Current(), *gc_complete_lock_);
+  return allocation_stall_time_;
+}
+
+void Heap::DumpGcMetrics(std::ostream& os) {
+  for (auto& collector : garbage_collectors_) {
+    collector->DumpMetrics(os);
+  }
+}
+
+void Heap::DumpClassHistogram(std::ostream& os) {
+  if (class_histogram_ != nullptr) {
+    class_histogram_->Dump(os);
+  }
+}
+
 void Heap::DumpGcCountRateHistogram(std::ostream& os) const {
   MutexLock mu(Thread::Current(), *gc_complete_lock_);
   if (gc_count_rate_histogram_.SampleSize() > 0U) {
@@ -1228,6 +1366,7 @@ void Heap::ThrowOutOfMemoryError(Thread* self, size_t byte_count, AllocatorType
     if (allocator_type == kAllocatorTypeNonMoving) {
       space = non_moving_space_;
     } else if (allocator_type == kAllocatorTypeRosAlloc ||
+               allocator_type == kAllocatorTypeRosAllocPerCpu ||
                allocator_type == kAllocatorTypeDlMalloc) {
       space = main_space_;
     } else if (allocator_type == kAllocatorTypeBumpPointer ||
@@ -1317,6 +1456,8 @@ void Heap::TrimIndirectReferenceTables(Thread* self) {
   if (barrier_count != 0) {
     barrier.Increment(self, barrier_count);
   }
+  // Release the chunk maps kept for the reference tables of new threads.
+  Runtime::Current()->GetIrtChunkPool()->Trim();
 }
 
 void Heap::StartGC(Thread* self, GcCause cause, CollectorType collector_type) {
@@ -1341,12 +1482,17 @@ void Heap::TrimSpaces(Thread* self) {
   uint64_t total_alloc_space_allocated = 0;
   uint64_t total_alloc_space_size = 0;
   uint64_t managed_reclaimed = 0;
+  // The RosAlloc spaces whose empty pages get released by TrimRosAllocSpacePages().
+  std::vector<space::RosAllocSpace*> rosalloc_spaces;
   {
     ScopedObjectAccess soa(self);
     for (const auto& space : continuous_spaces_) {
       if (space->IsMallocSpace()) {
         gc::space::MallocSpace* malloc_space = space->AsMallocSpace();
-        if (malloc_space->IsRosAllocSpace() || !CareAboutPauseTimes()) {
+        if (malloc_space->IsRosAllocSpace()) {
+          malloc_space->AsRosAllocSpace()->TrimFootprint();
+          rosalloc_spaces.push_back(malloc_space->AsRosAllocSpace());
+        } else if (!CareAboutPauseTimes()) {
           // Don't trim dlmalloc spaces if we care about pauses since this can hold the space lock
           // for a long period of time.
           managed_reclaimed += malloc_space->Trim();
@@ -1367,15 +1513,52 @@ void Heap::TrimSpaces(Thread* self) {
   }
   const float managed_utilization = static_cast<float>(total_alloc_space_allocated) /
       static_cast<float>(total_alloc_space_size);
-  uint64_t gc_heap_end_ns = NanoTime();
   // We never move things in the native heap, so we can finish the GC at this point.
   FinishGC(self, collector::kGcTypeNone);
+  for (space::RosAllocSpace* rosalloc_space : rosalloc_spaces) {
+    managed_reclaimed += TrimRosAllocSpacePages(self, rosalloc_space);
+  }
+  uint64_t gc_heap_end_ns = NanoTime();
+  total_trim_time_ns_.FetchAndAddRelaxed(gc_heap_end_ns - start_ns);
+  total_trim_released_bytes_.FetchAndAddRelaxed(managed_reclaimed);
 
   VLOG(heap) << "Heap trim of managed (duration=" << PrettyDuration(gc_heap_end_ns - start_ns)
       << ", advised=" << PrettySize(managed_reclaimed) << ") heap. Managed heap utilization of "
       << static_cast<int>(100 * managed_utilization) << "%.";
 }
 
+size_t Heap::TrimRosAllocSpacePages(Thread* self, space::RosAllocSpace* rosalloc_space) {
+  const uint64_t start_ns = NanoTime();
+  size_t released_bytes = 0;
+  size_t cursor = 0;
+  do {
+    // Only block the other GCs for one slice at a time.
+    StartGC(self, kGcCauseTrim, kCollectorTypeHeapTrim);
+    {
+      ScopedObjectAccess soa(self);
+      // The space may have been removed by a background compaction since the last slice.
+      if (std::find(continuous_spaces_.begin(), continuous_spaces_.end(), rosalloc_space) ==
+          continuous_spaces_.end()) {
+        FinishGC(self, collector::kGcTypeNone);
+        break;
+      }
+      released_bytes += rosalloc_space->ReleasePages(&cursor, kHeapTrimSlicePages);
+    }
+    FinishGC(self, collector::kGcTypeNone);
+    total_trim_slices_.FetchAndAddRelaxed(1);
+    // Stay within the page release budget, and let the allocating threads run between slices.
+    const uint64_t budget_ns =
+        MsToNs(static_cast<uint64_t>(released_bytes) * 1000 / kHeapTrimReleaseBytesPerSecond);
+    const uint64_t elapsed_ns = NanoTime() - start_ns;
+    if (cursor != 0 && budget_ns > elapsed_ns) {
+      NanoSleep(budget_ns - elapsed_ns);
+    } else {
+      sched_yield();
+    }
+  } while (cursor != 0);
+  return released_bytes;
+}
+
 bool Heap::IsValidObjectAddress(const void* addr) const {
   if (addr == nullptr) {
     return true;
@@ -1667,6 +1850,8 @@ mirror::Object* Heap::AllocateInternalWithGc(Thread* self,
     switch (allocator) {
       case kAllocatorTypeRosAlloc:
         // Fall-through.
+      case kAllocatorTypeRosAllocPerCpu:
+        // Fall-through.
       case kAllocatorTypeDlMalloc: {
         if (use_homogeneous_space_compaction_for_oom_ &&
             current_time - last_time_homogeneous_space_compaction_by_oom_ >
@@ -2119,6 +2304,9 @@ void Heap::ChangeCollector(CollectorType collector_type) {
     gc_plan_.clear();
     switch (collector_type_) {
       case kCollectorTypeCC: {
+        if (use_generational_cc_) {
+          gc_plan_.push_back(collector::kGcTypeSticky);
+        }
         gc_plan_.push_back(collector::kGcTypeFull);
         if (use_tlab_) {
           ChangeAllocator(kAllocatorTypeRegionTLAB);
@@ -2142,14 +2330,14 @@ void Heap::ChangeCollector(CollectorType collector_type) {
         gc_plan_.push_back(collector::kGcTypeSticky);
         gc_plan_.push_back(collector::kGcTypePartial);
         gc_plan_.push_back(collector::kGcTypeFull);
-        ChangeAllocator(kUseRosAlloc ? kAllocatorTypeRosAlloc : kAllocatorTypeDlMalloc);
+        ChangeAllocator(kUseRosAlloc ? GetRosAllocAllocatorType() : kAllocatorTypeDlMalloc);
         break;
       }
       case kCollectorTypeCMS: {
         gc_plan_.push_back(collector::kGcTypeSticky);
         gc_plan_.push_back(collector::kGcTypePartial);
         gc_plan_.push_back(collector::kGcTypeFull);
-        ChangeAllocator(kUseRosAlloc ? kAllocatorTypeRosAlloc : kAllocatorTypeDlMalloc);
+        ChangeAllocator(kUseRosAlloc ? GetRosAllocAllocatorType() : kAllocatorTypeDlMalloc);
         break;
       }
       default: {
@@ -2167,13 +2355,21 @@ void Heap::ChangeCollector(CollectorType collector_type) {
 }
 
 // Special compacting collector which uses sub-optimal bin packing to reduce zygote space size.
+// Compacts the moving space into the zygote space before the zygote forks. The objects that are
+// likely to be written after the fork are grouped at the start of the copied objects, so that
+// the children keep more of the other zygote space pages clean and shared.
 class ZygoteCompactingCollector FINAL : public collector::SemiSpace {
  public:
-  ZygoteCompactingCollector(gc::Heap* heap, bool is_running_on_memory_tool)
+  ZygoteCompactingCollector(gc::Heap* heap,
+                            bool is_running_on_memory_tool,
+                            std::unordered_set<mirror::Class*>&& known_dirty_classes)
       : SemiSpace(heap, false, "zygote collector"),
         bin_live_bitmap_(nullptr),
         bin_mark_bitmap_(nullptr),
-        is_running_on_memory_tool_(is_running_on_memory_tool) {}
+        is_running_on_memory_tool_(is_running_on_memory_tool),
+        known_dirty_classes_(std::move(known_dirty_classes)),
+        dirty_pos_(0u),
+        dirty_end_(0u) {}
 
   void BuildBins(space::ContinuousSpace* space) REQUIRES_SHARED(Locks::mutator_lock_) {
     bin_live_bitmap_ = space->GetLiveBitmap();
@@ -2193,6 +2389,39 @@ class ZygoteCompactingCollector FINAL : public collector::SemiSpace {
     AddBin(reinterpret_cast<uintptr_t>(space->End()) - prev, prev);
   }
 
+  virtual void MarkingPhase() OVERRIDE
+      REQUIRES(Locks::mutator_lock_, !Locks::heap_bitmap_lock_) {
+    // Reserve the pages at the start of the target space for the objects likely to be written
+    // after the fork. The full GC before the compaction left few dead objects, so the size of
+    // all of them in the from space is a tight bound. The clean objects start on the next page.
+    size_t dirty_bytes = 0u;
+    auto count_dirty = [&](mirror::Object* obj) REQUIRES_SHARED(Locks::mutator_lock_) {
+      if (IsLikelyDirtyAfterFork(obj)) {
+        dirty_bytes += RoundUp(obj->SizeOf<kDefaultVerifyFlags>(), kObjectAlignment);
+      }
+    };
+    if (from_space_->IsBumpPointerSpace()) {
+      from_space_->AsBumpPointerSpace()->Walk(count_dirty);
+    } else if (from_space_->IsRegionSpace()) {
+      from_space_->AsRegionSpace()->Walk(count_dirty);
+    } else {
+      from_space_->GetLiveBitmap()->Walk(count_dirty);
+    }
+    if (dirty_bytes != 0u) {
+      uintptr_t begin = reinterpret_cast<uintptr_t>(to_space_->End());
+      size_t reserved_bytes = RoundUp(begin + dirty_bytes, kPageSize) - begin;
+      size_t bytes_allocated, dummy;
+      mirror::Object* dirty_begin =
+          to_space_->Alloc(self_, reserved_bytes, &bytes_allocated, nullptr, &dummy);
+      if (dirty_begin != nullptr) {
+        dirty_pos_ = reinterpret_cast<uintptr_t>(dirty_begin);
+        dirty_end_ = dirty_pos_ + reserved_bytes;
+      }
+      VLOG(heap) << "Zygote objects likely dirty after fork: " << PrettySize(dirty_bytes);
+    }
+    SemiSpace::MarkingPhase();
+  }
+
  private:
   // Maps from bin sizes to locations.
   std::multimap<size_t, uintptr_t> bins_;
@@ -2201,6 +2430,11 @@ class ZygoteCompactingCollector FINAL : public collector::SemiSpace {
   // Mark bitmap of the space which contains the bins.
   accounting::ContinuousSpaceBitmap* bin_mark_bitmap_;
   const bool is_running_on_memory_tool_;
+  // Classes whose instances are known to be written after the fork, from an offline profile.
+  const std::unordered_set<mirror::Class*> known_dirty_classes_;
+  // The range reserved for the objects likely to be written after the fork.
+  uintptr_t dirty_pos_;
+  uintptr_t dirty_end_;
 
   void AddBin(size_t size, uintptr_t position) {
     if (is_running_on_memory_tool_) {
@@ -2211,6 +2445,30 @@ class ZygoteCompactingCollector FINAL : public collector::SemiSpace {
     }
   }
 
+  // As for the image bins of the ImageWriter, this is only a memory use tuning.
+  bool IsLikelyDirtyAfterFork(mirror::Object* obj) REQUIRES_SHARED(Locks::mutator_lock_) {
+    mirror::Class* klass = obj->GetClass<kVerifyNone>();
+    if (known_dirty_classes_.find(klass) != known_dirty_classes_.end()) {
+      return true;
+    }
+    if (obj->IsClass()) {
+      // Non-final static fields get written, and so do the classes still to be initialized.
+      mirror::Class* as_class = obj->AsClass();
+      if (!as_class->IsInitialized()) {
+        return true;
+      }
+      for (uint32_t i = 0, num = as_class->NumStaticFields(); i != num; ++i) {
+        if (!as_class->GetStaticField(i)->IsFinal()) {
+          return true;
+        }
+      }
+      return false;
+    }
+    // Instances of java.lang.Object are usually locks, references get enqueued, and dex caches
+    // are filled as the children resolve their entries.
+    return klass->IsObjectClass() || klass->IsTypeOfReferenceClass() || klass->IsDexCacheClass();
+  }
+
   virtual bool ShouldSweepSpace(space::ContinuousSpace* space ATTRIBUTE_UNUSED) const {
     // Don't sweep any spaces since we probably blasted the internal accounting of the free list
     // allocator.
@@ -2219,12 +2477,22 @@ class ZygoteCompactingCollector FINAL : public collector::SemiSpace {
 
   virtual mirror::Object* MarkNonForwardedObject(mirror::Object* obj)
       REQUIRES(Locks::heap_bitmap_lock_, Locks::mutator_lock_) {
+    if (obj->GetClass<kVerifyNone>()->IsStringClass()) {
+      // Cache the hash code now rather than have each child write it to its copy of the page.
+      obj->AsString()->GetHashCode();
+    }
     size_t obj_size = obj->SizeOf<kDefaultVerifyFlags>();
     size_t alloc_size = RoundUp(obj_size, kObjectAlignment);
     mirror::Object* forward_address;
     // Find the smallest bin which we can move obj in.
     auto it = bins_.lower_bound(alloc_size);
-    if (it == bins_.end()) {
+    if (dirty_pos_ + alloc_size <= dirty_end_ && IsLikelyDirtyAfterFork(obj)) {
+      // Keep the objects likely to be written together, away from the bins.
+      forward_address = reinterpret_cast<mirror::Object*>(dirty_pos_);
+      dirty_pos_ += alloc_size;
+      bin_live_bitmap_->Set(forward_address);
+      bin_mark_bitmap_->Set(forward_address);
+    } else if (it == bins_.end()) {
       // No available space in the bins, place it in the target space instead (grows the zygote
       // space).
       size_t bytes_allocated, dummy;
@@ -2269,6 +2537,39 @@ void Heap::UnBindBitmaps() {
   }
 }
 
+std::unordered_set<mirror::Class*> Heap::LoadZygoteDirtyClasses(Thread* self) {
+  std::unordered_set<mirror::Class*> classes;
+  const std::string& file_name = Runtime::Current()->GetZygoteDirtyClassesFile();
+  if (file_name.empty()) {
+    return classes;
+  }
+  std::string contents;
+  if (!ReadFileToString(file_name, &contents)) {
+    PLOG(WARNING) << "Failed to read the zygote dirty classes from " << file_name;
+    return classes;
+  }
+  ScopedObjectAccess soa(self);
+  ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
+  std::vector<std::string> lines;
+  Split(contents, '\n', &lines);
+  for (const std::string& line : lines) {
+    // One class per line, in the format of --dirty-image-objects of dex2oat.
+    std::string name = android::base::Trim(line);
+    if (name.empty() || name[0] == '#') {
+      continue;
+    }
+    std::string descriptor = DotToDescriptor(name.c_str());
+    // Classes do not move, and only the boot class path is loaded before the fork.
+    ObjPtr<mirror::Class> klass =
+        class_linker->LookupClass(self, descriptor.c_str(), /* class_loader */ nullptr);
+    if (klass != nullptr) {
+      classes.insert(klass.Ptr());
+    }
+  }
+  VLOG(heap) << "Loaded " << classes.size() << " zygote dirty classes from " << file_name;
+  return classes;
+}
+
 void Heap::PreZygoteFork() {
   if (!HasZygoteSpace()) {
     // We still want to GC in case there is some unreachable non moving objects that could cause a
@@ -2295,7 +2596,9 @@ void Heap::PreZygoteFork() {
     // Temporarily disable rosalloc verification because the zygote
     // compaction will mess up the rosalloc internal metadata.
     ScopedDisableRosAllocVerification disable_rosalloc_verif(this);
-    ZygoteCompactingCollector zygote_collector(this, is_running_on_memory_tool_);
+    ZygoteCompactingCollector zygote_collector(this,
+                                               is_running_on_memory_tool_,
+                                               LoadZygoteDirtyClasses(self));
     zygote_collector.BuildBins(non_moving_space_);
     // Create a new bump pointer space which we will compact into.
     space::BumpPointerSpace target_space("zygote bump space", non_moving_space_->End(),
@@ -2486,7 +2789,7 @@ collector::GarbageCollector* Heap::Compact(space::ContinuousMemMapAllocSpace* ta
 }
 
 void Heap::TraceHeapSize(size_t heap_size) {
-  ATRACE_INT("Heap size (KB)", heap_size / KB);
+  ART_TRACE_COUNTER("Heap size (KB)", heap_size / KB);
 }
 
 collector::GcType Heap::CollectGarbageInternal(collector::GcType gc_type,
@@ -2569,7 +2872,13 @@ collector::GcType Heap::CollectGarbageInternal(collector::GcType gc_type,
         collector = semi_space_collector_;
         break;
       case kCollectorTypeCC:
-        collector = concurrent_copying_collector_;
+        if (use_generational_cc_) {
+          // Sticky requests run a young collection, everything else a full one.
+          active_concurrent_copying_collector_ = (gc_type == collector::kGcTypeSticky)
+              ? young_concurrent_copying_collector_
+              : concurrent_copying_collector_;
+        }
+        collector = active_concurrent_copying_collector_;
         break;
       case kCollectorTypeMC:
         mark_compact_collector_->SetSpace(bump_pointer_space_);
@@ -2578,7 +2887,9 @@ collector::GcType Heap::CollectGarbageInternal(collector::GcType gc_type,
       default:
         LOG(FATAL) << "Invalid collector type " << static_cast<size_t>(collector_type_);
     }
-    if (collector != mark_compact_collector_ && collector != concurrent_copying_collector_) {
+    if (collector != mark_compact_collector_ &&
+        collector != concurrent_copying_collector_ &&
+        collector != young_concurrent_copying_collector_) {
       temp_space_->GetMemMap()->Protect(PROT_READ | PROT_WRITE);
       if (kIsDebugBuild) {
         // Try to read each page of the memory map in case mprotect didn't work properly b/19894268.
@@ -2586,8 +2897,11 @@ collector::GcType Heap::CollectGarbageInternal(collector::GcType gc_type,
       }
       CHECK(temp_space_->IsEmpty());
     }
-    gc_type = collector::kGcTypeFull;  // TODO: Not hard code this in.
+    if (collector != young_concurrent_copying_collector_) {
+      gc_type = collector::kGcTypeFull;  // TODO: Not hard code this in.
+    }
   } else if (current_allocator_ == kAllocatorTypeRosAlloc ||
+      current_allocator_ == kAllocatorTypeRosAllocPerCpu ||
       current_allocator_ == kAllocatorTypeDlMalloc) {
     collector = FindCollectorByGcType(gc_type);
   } else {
@@ -3343,7 +3657,9 @@ collector::GcType Heap::WaitForGcToCompleteLocked(GcCause cause, Thread* self) {
   collector::GcType last_gc_type = collector::kGcTypeNone;
   GcCause last_gc_cause = kGcCauseNone;
   uint64_t wait_start = NanoTime();
+  bool waited = false;
   while (collector_type_running_ != kCollectorTypeNone) {
+    waited = true;
     if (self != task_processor_->GetRunningThread()) {
       // The current thread is about to wait for a currently running
       // collection to finish. If the waiting thread is not the heap
@@ -3360,6 +3676,10 @@ collector::GcType Heap::WaitForGcToCompleteLocked(GcCause cause, Thread* self) {
   }
   uint64_t wait_time = NanoTime() - wait_start;
   total_wait_time_ += wait_time;
+  if (waited && (cause == kGcCauseForAlloc || cause == kGcCauseForNativeAllocBlocking)) {
+    ++allocation_stall_count_;
+    allocation_stall_time_ += wait_time;
+  }
   if (wait_time > long_pause_log_threshold_) {
     LOG(INFO) << "WaitForGcToComplete blocked " << cause << " on " << last_gc_cause << " for "
               << PrettyDuration(wait_time);
@@ -3384,6 +3704,10 @@ collector::GcType Heap::WaitForGcToCompleteLocked(GcCause cause, Thread* self) {
 void Heap::DumpForSigQuit(std::ostream& os) {
   os << "Heap: " << GetPercentFree() << "% free, " << PrettySize(GetBytesAllocated()) << "/"
      << PrettySize(GetTotalMemory()) << "; " << GetObjectsAllocated() << " objects\n";
+  os << "Heap trim: " << PrettySize(total_trim_released_bytes_.LoadRelaxed()) << " released ("
+     << total_trim_released_bytes_.LoadRelaxed() / kPageSize << " pages) in "
+     << total_trim_slices_.LoadRelaxed() << " slices, total time "
+     << PrettyDuration(total_trim_time_ns_.LoadRelaxed()) << "\n";
   DumpGcPerformanceInfo(os);
 }
 
@@ -3454,6 +3778,11 @@ void Heap::GrowForUtilization(collector::GarbageCollector* collector_ran,
     collector::GcType non_sticky_gc_type = NonStickyGcType();
     // Find what the next non sticky collector will be.
     collector::GarbageCollector* non_sticky_collector = FindCollectorByGcType(non_sticky_gc_type);
+    if (use_generational_cc_ && non_sticky_collector == nullptr) {
+      // The full concurrent copying collector reports itself as partial.
+      non_sticky_collector = FindCollectorByGcType(collector::kGcTypePartial);
+    }
+    CHECK(non_sticky_collector != nullptr);
     // If the throughput of the current sticky GC >= throughput of the non sticky collector, then
     // do another sticky collection next.
     // We also check that the bytes allocated aren't over the footprint limit in order to prevent a
@@ -3476,6 +3805,7 @@ void Heap::GrowForUtilization(collector::GarbageCollector* collector_ran,
   }
   if (!ignore_max_footprint_) {
     SetIdealFootprint(target_size);
+    ART_TRACE_COUNTER("Heap footprint (KB)", max_allowed_footprint_ / KB);
     if (IsGcConcurrent()) {
       const uint64_t freed_bytes = current_gc_iteration_.GetFreedBytes() +
           current_gc_iteration_.GetFreedLargeObjectBytes() +
@@ -3486,12 +3816,30 @@ void Heap::GrowForUtilization(collector::GarbageCollector* collector_ran,
       const uint64_t bytes_allocated_during_gc = bytes_allocated + freed_bytes -
           bytes_allocated_before_gc;
       // Calculate when to perform the next ConcurrentGC.
-      // Calculate the estimated GC duration.
-      const double gc_duration_seconds = NsToMs(current_gc_iteration_.GetDurationNs()) / 1000.0;
-      // Estimate how many remaining bytes we will have when we need to start the next GC.
-      size_t remaining_bytes = bytes_allocated_during_gc * gc_duration_seconds;
-      remaining_bytes = std::min(remaining_bytes, kMaxConcurrentRemainingBytes);
-      remaining_bytes = std::max(remaining_bytes, kMinConcurrentRemainingBytes);
+      size_t remaining_bytes;
+      if (gc_pacer_ != nullptr) {
+        gc_pacer_->RecordCollection(NanoTime(),
+                                    current_gc_iteration_.GetDurationNs(),
+                                    bytes_allocated_before_gc,
+                                    bytes_allocated_during_gc,
+                                    bytes_allocated);
+        // Start early enough for the GC to finish at the predicted allocation rate. If that is
+        // more than we have left, the max below starts the next GC right away.
+        remaining_bytes = static_cast<size_t>(
+            std::min<uint64_t>(gc_pacer_->GetRemainingBytes(), max_allowed_footprint_));
+        remaining_bytes = std::max(remaining_bytes, kMinConcurrentRemainingBytes);
+        ART_TRACE_COUNTER("GC pacer allocation rate (KB/s)", gc_pacer_->GetAllocationRate() / KB);
+        ART_TRACE_COUNTER("GC pacer predicted duration (ms)",
+                          NsToMs(gc_pacer_->GetPredictedDurationNs()));
+        ART_TRACE_COUNTER("GC pacer remaining bytes (KB)", remaining_bytes / KB);
+      } else {
+        // Calculate the estimated GC duration.
+        const double gc_duration_seconds = NsToMs(current_gc_iteration_.GetDurationNs()) / 1000.0;
+        // Estimate how many remaining bytes we will have when we need to start the next GC.
+        remaining_bytes = bytes_allocated_during_gc * gc_duration_seconds;
+        remaining_bytes = std::min(remaining_bytes, kMaxConcurrentRemainingBytes);
+        remaining_bytes = std::max(remaining_bytes, kMinConcurrentRemainingBytes);
+      }
       if (UNLIKELY(remaining_bytes > max_allowed_footprint_)) {
         // A never going to happen situation that from the estimated allocation rate we will exceed
         // the applications entire footprint with the given estimated allocation rate. Schedule
@@ -3505,6 +3853,9 @@ void Heap::GrowForUtilization(collector::GarbageCollector* collector_ran,
       // right away.
       concurrent_start_bytes_ = std::max(max_allowed_footprint_ - remaining_bytes,
                                          static_cast<size_t>(bytes_allocated));
+      if (gc_pacer_ != nullptr) {
+        ART_TRACE_COUNTER("GC pacer concurrent start (KB)", concurrent_start_bytes_ / KB);
+      }
     }
   }
 }
@@ -3813,6 +4164,13 @@ void Heap::RegisterNativeAllocation(JNIEnv* env, size_t bytes) {
     }
   } else if (new_value > NativeAllocationGcWatermark() * HeapGrowthMultiplier() &&
              !IsGCRequestPending()) {
+    // The references the last GC cleared may free native memory once they are
+    // enqueued, through their Cleaners. Another GC would not free it sooner,
+    // so wait for them, up to the blocking watermark.
+    if (reference_processor_->GetEnqueueBacklog() != 0u) {
+      native_gcs_deferred_for_enqueue_backlog_.FetchAndAddRelaxed(1u);
+      return;
+    }
     // Trigger another GC because there have been enough native bytes
     // allocated since the last GC.
     if (IsGcConcurrent()) {
@@ -4043,6 +4401,114 @@ void Heap::RemoveAllocationListener() {
   }
 }
 
+void Heap::SetAllocationSampler(AllocationListener* sampler, size_t interval) {
+  SetAllocationSampleInterval(interval);
+  AllocationListener* old = GetAndOverwriteAllocationListener(&alloc_sampler_, sampler);
+
+  // The TLAB allocators sample in AllocWithNewTLAB(), which the uninstrumented entrypoints reach
+  // as well. The others need every allocation to go through AllocObjectWithAllocator().
+  if (old == nullptr && !IsTLABAllocator(GetCurrentAllocator())) {
+    alloc_sampler_instrumented_ = true;
+    Runtime::Current()->GetInstrumentation()->InstrumentQuickAllocEntryPoints();
+  }
+}
+
+void Heap::RemoveAllocationSampler() {
+  AllocationListener* old = GetAndOverwriteAllocationListener(&alloc_sampler_, nullptr);
+
+  if (old != nullptr && alloc_sampler_instrumented_) {
+    alloc_sampler_instrumented_ = false;
+    Runtime::Current()->GetInstrumentation()->UninstrumentQuickAllocEntryPoints();
+  }
+}
+
+size_t Heap::NextAllocSampleInterval(Thread* self) {
+  Thread::AllocSampleState* state = self->GetAllocSampleState();
+  uint64_t x = state->random_state;
+  if (UNLIKELY(x == 0u)) {
+    x = (static_cast<uint64_t>(self->GetTid()) << 32) ^ NanoTime() ^ 0x9e3779b97f4a7c15ULL;
+    x = (x == 0u) ? 1u : x;
+  }
+  // Draw from an exponential distribution with the sample interval as the mean, using xorshift64*
+  // for the uniform variate, as AllocRecordObjectMap::SampleAllocation() does.
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  state->random_state = x;
+  const double u = static_cast<double>((x * 0x2545f4914f6cdd1dULL) >> 11) * (1.0 / (1ULL << 53));
+  const double interval =
+      -std::log(1.0 - u) * static_cast<double>(alloc_sample_interval_.LoadRelaxed());
+  return std::max<size_t>(static_cast<size_t>(interval), 1u);
+}
+
+size_t Heap::HandOutTlabBytes(Thread* self, size_t bytes, size_t needed, bool can_clamp) {
+  if (LIKELY(alloc_sampler_.LoadRelaxed() == nullptr)) {
+    return bytes;
+  }
+  Thread::AllocSampleState* state = self->GetAllocSampleState();
+  if (state->tlab_end_at_sample) {
+    // The TLAB ended at the sample point and the allocation that did not fit crosses it.
+    state->tlab_end_at_sample = false;
+    state->sample_pending = true;
+    state->bytes_until_sample = NextAllocSampleInterval(self);
+  } else if (UNLIKELY(state->bytes_until_sample == 0u)) {
+    state->bytes_until_sample = NextAllocSampleInterval(self);
+  }
+  if (bytes < state->bytes_until_sample) {
+    state->bytes_until_sample -= bytes;
+    return bytes;
+  }
+  // Bytes of the TLAB before the start of the countdown to the sample point it is ended at.
+  size_t counted = 0u;
+  if (!can_clamp || needed >= state->bytes_until_sample) {
+    // The sample point lies within the allocation, or the TLAB cannot be ended at it.
+    state->sample_pending = true;
+    state->bytes_until_sample = NextAllocSampleInterval(self);
+    if (!can_clamp) {
+      return bytes;
+    }
+    // The rest of the TLAB counts towards the next sample point.
+    counted = needed;
+    if (bytes - counted < state->bytes_until_sample) {
+      state->bytes_until_sample -= bytes - counted;
+      return bytes;
+    }
+  }
+  bytes = counted + state->bytes_until_sample;
+  state->bytes_until_sample = 0u;
+  state->tlab_end_at_sample = true;
+  return bytes;
+}
+
+void Heap::SampleAllocation(Thread* self,
+                            AllocatorType allocator,
+                            size_t byte_count,
+                            ObjPtr<mirror::Object>* obj) {
+  AllocationListener* sampler = alloc_sampler_.LoadSequentiallyConsistent();
+  if (sampler == nullptr) {
+    return;
+  }
+  Thread::AllocSampleState* state = self->GetAllocSampleState();
+  if (IsTLABAllocator(allocator)) {
+    // Counted when the TLAB was handed out.
+    if (!state->sample_pending) {
+      return;
+    }
+  } else {
+    if (UNLIKELY(state->bytes_until_sample == 0u)) {
+      state->bytes_until_sample = NextAllocSampleInterval(self);
+    }
+    if (LIKELY(byte_count < state->bytes_until_sample)) {
+      state->bytes_until_sample -= byte_count;
+      return;
+    }
+    state->bytes_until_sample = NextAllocSampleInterval(self);
+  }
+  state->sample_pending = false;
+  // We assume that a sampler that was once stored will never be deleted.
+  sampler->ObjectAllocated(self, obj, byte_count);
+}
+
 void Heap::SetGcPauseListener(GcPauseListener* l) {
   gc_pause_listener_.StoreRelaxed(l);
 }
@@ -4051,6 +4517,29 @@ void Heap::RemoveGcPauseListener() {
   gc_pause_listener_.StoreRelaxed(nullptr);
 }
 
+size_t Heap::NextTlabSize(Thread* self, size_t default_size, size_t max_size) {
+  if (!kUseAdaptiveTlabSize) {
+    return default_size;
+  }
+  const uint64_t now = NanoTime();
+  size_t size = self->GetTlabTargetSize();
+  if (size == 0u) {
+    size = default_size;
+  } else {
+    const uint64_t refill_interval = now - self->GetTlabLastRefillTime();
+    if (self->GetTlabRecentWaste() > size / 2 || refill_interval > kTlabSlowRefillInterval) {
+      size /= 2;
+    } else if (refill_interval < kTlabBurstRefillInterval) {
+      size *= 4;
+    } else if (refill_interval < kTlabFastRefillInterval) {
+      size *= 2;
+    }
+  }
+  size = std::min(std::max(size, std::min(kMinTlabSize, max_size)), max_size);
+  self->RecordTlabRefill(now, size);
+  return size;
+}
+
 mirror::Object* Heap::AllocWithNewTLAB(Thread* self,
                                        size_t alloc_size,
                                        bool grow,
@@ -4063,9 +4552,13 @@ mirror::Object* Heap::AllocWithNewTLAB(Thread* self,
     // There is enough space if we grow the TLAB. Lets do that. This increases the
     // TLAB bytes.
     const size_t min_expand_size = alloc_size - self->TlabSize();
-    const size_t expand_bytes = std::max(
+    const size_t expand_bytes = HandOutTlabBytes(
+        self,
+        std::max(min_expand_size,
+                 std::min(self->TlabRemainingCapacity() - self->TlabSize(),
+                          std::max(kPartialTlabSize, self->GetTlabTargetSize()))),
         min_expand_size,
-        std::min(self->TlabRemainingCapacity() - self->TlabSize(), kPartialTlabSize));
+        /*can_clamp*/ true);
     if (UNLIKELY(IsOutOfMemoryOnAllocation(allocator_type, expand_bytes, grow))) {
       return nullptr;
     }
@@ -4074,7 +4567,12 @@ mirror::Object* Heap::AllocWithNewTLAB(Thread* self,
     DCHECK_LE(alloc_size, self->TlabSize());
   } else if (allocator_type == kAllocatorTypeTLAB) {
     DCHECK(bump_pointer_space_ != nullptr);
-    const size_t new_tlab_size = alloc_size + kDefaultTLABSize;
+    // The bump pointer TLABs cannot be expanded, so they are not ended at the sample points.
+    const size_t new_tlab_size = HandOutTlabBytes(
+        self,
+        alloc_size + NextTlabSize(self, kDefaultTLABSize, space::RegionSpace::kRegionSize),
+        alloc_size,
+        /*can_clamp*/ false);
     if (UNLIKELY(IsOutOfMemoryOnAllocation(allocator_type, new_tlab_size, grow))) {
       return nullptr;
     }
@@ -4092,9 +4590,14 @@ mirror::Object* Heap::AllocWithNewTLAB(Thread* self,
       if (LIKELY(!IsOutOfMemoryOnAllocation(allocator_type,
                                             space::RegionSpace::kRegionSize,
                                             grow))) {
-        const size_t new_tlab_size = kUsePartialTlabs
-            ? std::max(alloc_size, kPartialTlabSize)
-            : gc::space::RegionSpace::kRegionSize;
+        const size_t new_tlab_size = HandOutTlabBytes(
+            self,
+            kUsePartialTlabs
+                ? std::max(alloc_size,
+                           NextTlabSize(self, kPartialTlabSize, space::RegionSpace::kRegionSize))
+                : gc::space::RegionSpace::kRegionSize,
+            alloc_size,
+            /*can_clamp*/ kUsePartialTlabs);
         // Try to allocate a tlab.
         if (!region_space_->AllocNewTlab(self, new_tlab_size)) {
           // Failed to allocate a tlab. Try non-tlab.
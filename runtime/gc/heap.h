@@ -49,6 +49,7 @@ class RootVisitor;
 class StackVisitor;
 class Thread;
 class ThreadPool;
+class TimingJsonWriter;
 class TimingLogger;
 class VariableSizedHandleScope;
 
@@ -61,6 +62,8 @@ namespace gc {
 
 class AllocationListener;
 class AllocRecordObjectMap;
+class ClassHistogram;
+class GcPacer;
 class GcPauseListener;
 class ReferenceProcessor;
 class TaskProcessor;
@@ -152,6 +155,10 @@ class Heap {
 
   // How often we allow heap trimming to happen (nanoseconds).
   static constexpr uint64_t kHeapTrimWait = MsToNs(5000);
+  // How many pages of a RosAlloc space one heap trim slice goes through.
+  static constexpr size_t kHeapTrimSlicePages = 256;
+  // How many bytes the heap trim releases per second at most.
+  static constexpr size_t kHeapTrimReleaseBytesPerSecond = 64 * MB;
   // How long we wait after a transition request to perform a collector transition (nanoseconds).
   static constexpr uint64_t kCollectorTransitionWait = MsToNs(5000);
 
@@ -179,6 +186,7 @@ class Heap {
        size_t long_gc_threshold,
        bool ignore_max_footprint,
        bool use_tlab,
+       bool use_rosalloc_per_cpu_runs,
        bool verify_pre_gc_heap,
        bool verify_pre_sweeping_heap,
        bool verify_post_gc_heap,
@@ -188,7 +196,12 @@ class Heap {
        bool gc_stress_mode,
        bool measure_gc_performance,
        bool use_homogeneous_space_compaction,
-       uint64_t min_interval_homogeneous_space_compaction_by_oom);
+       uint64_t min_interval_homogeneous_space_compaction_by_oom,
+       bool use_generational_cc,
+       size_t sampled_verification_regions,
+       bool use_huge_pages,
+       bool use_gc_pacer,
+       size_t class_histogram_sampling_rate);
 
   ~Heap();
 
@@ -267,6 +280,11 @@ class Heap {
   void ChangeAllocator(AllocatorType allocator)
       REQUIRES(Locks::mutator_lock_, !Locks::runtime_shutdown_lock_);
 
+  // The allocator type to use for the RosAlloc main space.
+  AllocatorType GetRosAllocAllocatorType() const {
+    return use_rosalloc_per_cpu_runs_ ? kAllocatorTypeRosAllocPerCpu : kAllocatorTypeRosAlloc;
+  }
+
   // Transition the garbage collector during runtime, may copy objects from one space to another.
   void TransitionCollector(CollectorType collector_type) REQUIRES(!*gc_complete_lock_);
 
@@ -315,6 +333,13 @@ class Heap {
   // Temporarily disable thread flip for JNI critical calls.
   void IncrementDisableThreadFlip(Thread* self) REQUIRES(!*thread_flip_lock_);
   void DecrementDisableThreadFlip(Thread* self) REQUIRES(!*thread_flip_lock_);
+  // Keep a movable object in place for a JNI critical section. With the region space, only the
+  // region of the object is kept from being evacuated. Otherwise this disables moving GC or the
+  // thread flip, which may wait for a GC to complete and the object may move before returning.
+  void PinObjectForCriticalAccess(Thread* self, ObjPtr<mirror::Object> obj)
+      REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(!*gc_complete_lock_, !*thread_flip_lock_);
+  void UnpinObjectForCriticalAccess(Thread* self, ObjPtr<mirror::Object> obj)
+      REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(!*gc_complete_lock_, !*thread_flip_lock_);
   void ThreadFlipBegin(Thread* self) REQUIRES(!*thread_flip_lock_);
   void ThreadFlipEnd(Thread* self) REQUIRES(!*thread_flip_lock_);
 
@@ -679,6 +704,9 @@ class Heap {
   // GC performance measuring
   void DumpGcPerformanceInfo(std::ostream& os)
       REQUIRES(!*gc_complete_lock_);
+  // Adds the cumulative timings of each collector that ran, and the splits of its last
+  // iteration, to `writer`. Waits for a running collection to complete first.
+  void AddGcTimings(TimingJsonWriter* writer) REQUIRES(!*gc_complete_lock_);
   void ResetGcPerformanceInfo() REQUIRES(!*gc_complete_lock_);
 
   // Thread pool.
@@ -717,8 +745,14 @@ class Heap {
     return zygote_space_ != nullptr;
   }
 
+  // Returns the concurrent copying collector that is running or ran last. With generational CC
+  // this is either the young or the full collector.
   collector::ConcurrentCopying* ConcurrentCopyingCollector() {
-    return concurrent_copying_collector_;
+    return active_concurrent_copying_collector_;
+  }
+
+  bool UseGenerationalConcurrentCopying() const {
+    return use_generational_cc_;
   }
 
   CollectorType CurrentCollectorType() {
@@ -761,6 +795,13 @@ class Heap {
   uint64_t GetBlockingGcTime() const;
   void DumpGcCountRateHistogram(std::ostream& os) const REQUIRES(!*gc_complete_lock_);
   void DumpBlockingGcCountRateHistogram(std::ostream& os) const REQUIRES(!*gc_complete_lock_);
+  // How often and for how long allocating threads waited for a running GC to complete.
+  uint64_t GetAllocationStallCount() const REQUIRES(!*gc_complete_lock_);
+  uint64_t GetAllocationStallTime() const REQUIRES(!*gc_complete_lock_);
+  // Dump the cumulative statistics of each collector, see GarbageCollector::DumpMetrics.
+  void DumpGcMetrics(std::ostream& os);
+  // Dump the class histogram of the last collection that sampled one, nothing if disabled.
+  void DumpClassHistogram(std::ostream& os);
 
   // Allocation tracking support
   // Callers to this function use double-checked locking to ensure safety on allocation_records_
@@ -811,6 +852,18 @@ class Heap {
   // reasons, we assume it stays valid when we read it (so that we don't require a lock).
   void RemoveAllocationListener();
 
+  // Install an allocation sampler, which is called for the allocation that crosses each sample
+  // point of a thread. The distance between the sample points is drawn from an exponential
+  // distribution with a mean of `interval` bytes. The TLAB allocators sample by ending the TLABs
+  // at the sample points, so that the entrypoints only need to be instrumented for the others.
+  // Note: as with the allocation listener, the sampler must not be deleted once installed.
+  void SetAllocationSampler(AllocationListener* sampler, size_t interval);
+  // Change the mean sample interval of the installed sampler, if any.
+  void SetAllocationSampleInterval(size_t interval) {
+    alloc_sample_interval_.StoreRelaxed(std::max<size_t>(interval, 1u));
+  }
+  void RemoveAllocationSampler();
+
   // Install a gc pause listener.
   void SetGcPauseListener(GcPauseListener* l);
   // Get the currently installed gc pause listener, or null.
@@ -823,6 +876,16 @@ class Heap {
 
   const Verification* GetVerification() const;
 
+  // How many regions the concurrent copying collector verifies per collection, 0 if disabled.
+  size_t GetSampledVerificationRegions() const {
+    return sampled_verification_regions_;
+  }
+
+  // Null unless the collectors sample the live objects per class after marking.
+  ClassHistogram* GetClassHistogram() const {
+    return class_histogram_.get();
+  }
+
  private:
   class ConcurrentGCTask;
   class CollectorTransitionTask;
@@ -929,6 +992,10 @@ class Heap {
                                               size_t* bytes_tl_bulk_allocated)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Returns the TLAB size for the next refill of self, adapted to its recent refill rate and
+  // waste, and records the refill.
+  size_t NextTlabSize(Thread* self, size_t default_size, size_t max_size);
+
   mirror::Object* AllocWithNewTLAB(Thread* self,
                                    size_t alloc_size,
                                    bool grow,
@@ -937,6 +1004,23 @@ class Heap {
                                    size_t* bytes_tl_bulk_allocated)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Counts the `bytes` of TLAB about to be handed out to self against its allocation sample
+  // countdown and returns the bytes to hand out. If `can_clamp` and the next sample point lies
+  // past the `needed` bytes, the TLAB is ended at the sample point so that the allocation that
+  // crosses it takes the slow path. Otherwise the current allocation is sampled.
+  size_t HandOutTlabBytes(Thread* self, size_t bytes, size_t needed, bool can_clamp);
+
+  // Draws the distance to the next allocation sample point of self.
+  size_t NextAllocSampleInterval(Thread* self);
+
+  // Called by the slow path of the allocation with the allocated object, calls the allocation
+  // sampler if the allocation is sampled.
+  void SampleAllocation(Thread* self,
+                        AllocatorType allocator,
+                        size_t byte_count,
+                        ObjPtr<mirror::Object>* obj)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
   void ThrowOutOfMemoryError(Thread* self, size_t byte_count, AllocatorType allocator_type)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
@@ -984,6 +1068,11 @@ class Heap {
   // Find a collector based on GC type.
   collector::GarbageCollector* FindCollectorByGcType(collector::GcType gc_type);
 
+  // Look up the classes listed in the file of -Xzygote-dirty-classes, whose instances the zygote
+  // compaction groups with the other objects likely to be written after the fork.
+  std::unordered_set<mirror::Class*> LoadZygoteDirtyClasses(Thread* self)
+      REQUIRES(!Locks::mutator_lock_);
+
   // Create the main free list malloc space, either a RosAlloc space or DlMalloc space.
   void CreateMainMallocSpace(MemMap* mem_map,
                              size_t initial_size,
@@ -1044,6 +1133,11 @@ class Heap {
 
   // Trim the managed and native spaces by releasing unused memory back to the OS.
   void TrimSpaces(Thread* self) REQUIRES(!*gc_complete_lock_);
+  // Release the empty pages of a RosAlloc space kHeapTrimSlicePages at a time, yielding or
+  // sleeping between the slices to stay within kHeapTrimReleaseBytesPerSecond. Returns the number
+  // of bytes released.
+  size_t TrimRosAllocSpacePages(Thread* self, space::RosAllocSpace* rosalloc_space)
+      REQUIRES(!*gc_complete_lock_);
 
   // Trim 0 pages at the end of reference tables.
   void TrimIndirectReferenceTables(Thread* self);
@@ -1240,6 +1334,10 @@ class Heap {
   // old_native_bytes_allocated_ and new_native_bytes_allocated_.
   Atomic<size_t> old_native_bytes_allocated_;
 
+  // Number of times RegisterNativeAllocation did not request a GC since the reference queue
+  // threads had not enqueued the references cleared by the last GC yet.
+  Atomic<uint64_t> native_gcs_deferred_for_enqueue_backlog_;
+
   // Used for synchronization when multiple threads call into
   // RegisterNativeAllocation and require blocking GC.
   // * If a previous blocking GC is in progress, all threads will wait for
@@ -1367,9 +1465,14 @@ class Heap {
   collector::SemiSpace* semi_space_collector_;
   collector::MarkCompact* mark_compact_collector_;
   collector::ConcurrentCopying* concurrent_copying_collector_;
+  // Only non-null with generational CC; collects the regions allocated since the last GC.
+  collector::ConcurrentCopying* young_concurrent_copying_collector_;
+  collector::ConcurrentCopying* active_concurrent_copying_collector_;
 
   const bool is_running_on_memory_tool_;
   const bool use_tlab_;
+  // Whether the RosAlloc space uses per-CPU runs instead of thread-local runs.
+  const bool use_rosalloc_per_cpu_runs_;
 
   // Pointer to the space which becomes the new main space when we do homogeneous space compaction.
   // Use unique_ptr since the space is only added during the homogeneous compaction phase.
@@ -1403,12 +1506,29 @@ class Heap {
   // Whether or not we use homogeneous space compaction to avoid OOM errors.
   bool use_homogeneous_space_compaction_for_oom_;
 
+  // If true, the concurrent copying collector alternates young and full collections.
+  const bool use_generational_cc_;
+
+  // The number of randomly chosen regions whose references the concurrent copying collector
+  // verifies in each collection.
+  const size_t sampled_verification_regions_;
+
+  // Decides when to start the concurrent GC from the recent allocation rate and GC duration. Null
+  // if the start is only derived from the bytes allocated during the last GC.
+  std::unique_ptr<GcPacer> gc_pacer_;
+
+  // The live objects per class sampled by the last full collection.
+  std::unique_ptr<ClassHistogram> class_histogram_;
+
   // True if the currently running collection has made some thread wait.
   bool running_collection_is_blocking_ GUARDED_BY(gc_complete_lock_);
   // The number of blocking GC runs.
   uint64_t blocking_gc_count_;
   // The total duration of blocking GC runs.
   uint64_t blocking_gc_time_;
+  // The number of times and total duration an allocation waited for a running GC.
+  uint64_t allocation_stall_count_ GUARDED_BY(gc_complete_lock_);
+  uint64_t allocation_stall_time_ GUARDED_BY(gc_complete_lock_);
   // The duration of the window for the GC count rate histograms.
   static constexpr uint64_t kGcCountRateHistogramWindowDuration = MsToNs(10 * 1000);  // 10s.
   // The last time when the GC count rate histograms were updated.
@@ -1441,6 +1561,11 @@ class Heap {
   // allocating.
   bool gc_disabled_for_shutdown_ GUARDED_BY(gc_complete_lock_);
 
+  // Heap trim statistics, shown in DumpForSigQuit().
+  Atomic<uint64_t> total_trim_released_bytes_;
+  Atomic<uint64_t> total_trim_slices_;
+  Atomic<uint64_t> total_trim_time_ns_;
+
   // Boot image spaces.
   std::vector<space::ImageSpace*> boot_image_spaces_;
 
@@ -1448,6 +1573,12 @@ class Heap {
   Atomic<AllocationListener*> alloc_listener_;
   // An installed GC Pause listener.
   Atomic<GcPauseListener*> gc_pause_listener_;
+  // An installed allocation sampler and its mean sample interval in bytes.
+  Atomic<AllocationListener*> alloc_sampler_;
+  Atomic<size_t> alloc_sample_interval_;
+  // Whether the allocation sampler instrumented the entrypoints, as the current allocator was not
+  // a TLAB allocator when it was installed.
+  bool alloc_sampler_instrumented_;
 
   std::unique_ptr<Verification> verification_;
 
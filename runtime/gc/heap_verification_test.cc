@@ -146,6 +146,28 @@ TEST_F(VerificationTest, LogHeapCorruption) {
   v->LogHeapCorruption(nullptr, MemberOffset(0), arr.Get(), false);
 }
 
+TEST_F(VerificationTest, VerifyObjectReferences) {
+  TEST_DISABLED_FOR_MEMORY_TOOL();
+  ScopedLogSeverity sls(LogSeverity::INFO);
+  ScopedObjectAccess soa(Thread::Current());
+  Runtime* const runtime = Runtime::Current();
+  VariableSizedHandleScope hs(soa.Self());
+  Handle<mirror::String> string(
+      hs.NewHandle(mirror::String::AllocFromModifiedUtf8(soa.Self(), "obj")));
+  using ObjArray = mirror::ObjectArray<mirror::Object>;
+  Handle<ObjArray> arr(
+      hs.NewHandle(AllocObjectArray<mirror::Object>(soa.Self(), 256)));
+  const Verification* const v = runtime->GetHeap()->GetVerification();
+  arr->Set(0, string.Get());
+  EXPECT_EQ(v->VerifyObjectReferences(arr.Get(), /* fatal */ false), 0u);
+  EXPECT_EQ(v->VerifyObjectReferences(string.Get(), /* fatal */ false), 0u);
+  // An unaligned reference is never valid.
+  arr->GetFieldObjectReferenceAddr<kVerifyNone>(ObjArray::OffsetOfElement(1))->Assign(
+      reinterpret_cast<mirror::Object*>(reinterpret_cast<uintptr_t>(string.Get()) + 1));
+  EXPECT_EQ(v->VerifyObjectReferences(arr.Get(), /* fatal */ false), 1u);
+  arr->SetWithoutChecks<false>(1, nullptr);
+}
+
 TEST_F(VerificationTest, FindPathFromRootSet) {
   TEST_DISABLED_FOR_MEMORY_TOOL();
   ScopedLogSeverity sls(LogSeverity::INFO);
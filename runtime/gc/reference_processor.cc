@@ -18,6 +18,7 @@
 
 #include "base/time_utils.h"
 #include "collector/garbage_collector.h"
+#include "heap.h"
 #include "java_vm_ext.h"
 #include "mirror/class-inl.h"
 #include "mirror/object-inl.h"
@@ -28,6 +29,8 @@
 #include "reflection.h"
 #include "scoped_thread_state_change-inl.h"
 #include "task_processor.h"
+#include "thread_list.h"
+#include "thread_pool.h"
 #include "utils.h"
 #include "well_known_classes.h"
 
@@ -36,6 +39,10 @@ namespace gc {
 
 static constexpr bool kAsyncReferenceQueueAdd = false;
 
+// The fewest cleared references handed to an enqueue thread at once, so that a few cleared
+// references do not wake up all the threads.
+static constexpr size_t kMinReferencesPerEnqueueTask = 64;
+
 ReferenceProcessor::ReferenceProcessor()
     : collector_(nullptr),
       preserving_references_(false),
@@ -44,9 +51,44 @@ ReferenceProcessor::ReferenceProcessor()
       weak_reference_queue_(Locks::reference_queue_weak_references_lock_),
       finalizer_reference_queue_(Locks::reference_queue_finalizer_references_lock_),
       phantom_reference_queue_(Locks::reference_queue_phantom_references_lock_),
-      cleared_references_(Locks::reference_queue_cleared_references_lock_) {
+      cleared_references_(Locks::reference_queue_cleared_references_lock_),
+      get_referent_blocked_ns_(0u),
+      get_referent_blocked_count_(0u),
+      enqueue_backlog_(0u),
+      max_enqueue_backlog_(0u),
+      enqueued_references_(0u),
+      enqueue_time_ns_(0u) {
+}
+
+ReferenceProcessor::~ReferenceProcessor() {
 }
 
+// Records the time from construction until destruction as time blocked in GetReferent(), if
+// Start() was called.
+class ReferenceProcessor::ScopedGetReferentBlockedTime {
+ public:
+  explicit ScopedGetReferentBlockedTime(ReferenceProcessor* processor)
+      : processor_(processor), start_time_(0u) {
+  }
+
+  ~ScopedGetReferentBlockedTime() {
+    if (start_time_ != 0u) {
+      processor_->get_referent_blocked_ns_.FetchAndAddRelaxed(NanoTime() - start_time_);
+      processor_->get_referent_blocked_count_.FetchAndAddRelaxed(1u);
+    }
+  }
+
+  void Start() {
+    if (start_time_ == 0u) {
+      start_time_ = NanoTime();
+    }
+  }
+
+ private:
+  ReferenceProcessor* const processor_;
+  uint64_t start_time_;
+};
+
 void ReferenceProcessor::EnableSlowPath() {
   mirror::Reference::GetJavaLangRefReference()->SetSlowPath(true);
 }
@@ -74,6 +116,7 @@ ObjPtr<mirror::Object> ReferenceProcessor::GetReferent(Thread* self,
       return referent;
     }
   }
+  ScopedGetReferentBlockedTime blocked_time(this);
   MutexLock mu(self, *Locks::reference_processor_lock_);
   while ((!kUseReadBarrier && SlowPathEnabled()) ||
          (kUseReadBarrier && !self->GetWeakRefAccessEnabled())) {
@@ -107,6 +150,7 @@ ObjPtr<mirror::Object> ReferenceProcessor::GetReferent(Thread* self,
     // Check and run the empty checkpoint before blocking so the empty checkpoint will work in the
     // presence of threads blocking for weak ref access.
     self->CheckEmptyCheckpointFromWeakRefAccess(Locks::reference_processor_lock_);
+    blocked_time.Start();
     condition_.WaitHoldingLocks(self);
   }
   return reference->GetReferent();
@@ -124,6 +168,25 @@ void ReferenceProcessor::StopPreservingReferences(Thread* self) {
   condition_.Broadcast(self);
 }
 
+void ReferenceProcessor::ClearWhiteReferences(Thread* self,
+                                              ReferenceQueue* queue,
+                                              bool concurrent,
+                                              collector::GarbageCollector* collector) {
+  Heap* const heap = Runtime::Current()->GetHeap();
+  ThreadPool* const thread_pool = heap->GetThreadPool();
+  // The workers need the mutator lock shared, which they can't get if the mutators are suspended.
+  if (thread_pool == nullptr ||
+      Runtime::Current()->IsActiveTransaction() ||
+      Locks::mutator_lock_->IsExclusiveHeld(self)) {
+    queue->ClearWhiteReferences(&cleared_references_, collector);
+    return;
+  }
+  const size_t thread_count = std::min(
+      concurrent ? heap->GetConcGCThreadCount() : heap->GetParallelGCThreadCount(),
+      thread_pool->GetThreadCount());
+  queue->ClearWhiteReferencesParallel(&cleared_references_, collector, thread_pool, thread_count);
+}
+
 // Process reference class instances and schedule finalizations.
 void ReferenceProcessor::ProcessReferences(bool concurrent,
                                            TimingLogger* timings,
@@ -165,8 +228,8 @@ void ReferenceProcessor::ProcessReferences(bool concurrent,
     }
   }
   // Clear all remaining soft and weak references with white referents.
-  soft_reference_queue_.ClearWhiteReferences(&cleared_references_, collector);
-  weak_reference_queue_.ClearWhiteReferences(&cleared_references_, collector);
+  ClearWhiteReferences(self, &soft_reference_queue_, concurrent, collector);
+  ClearWhiteReferences(self, &weak_reference_queue_, concurrent, collector);
   {
     TimingLogger::ScopedTiming t2(concurrent ? "EnqueueFinalizerReferences" :
         "(Paused)EnqueueFinalizerReferences", timings);
@@ -181,10 +244,10 @@ void ReferenceProcessor::ProcessReferences(bool concurrent,
     }
   }
   // Clear all finalizer referent reachable soft and weak references with white referents.
-  soft_reference_queue_.ClearWhiteReferences(&cleared_references_, collector);
-  weak_reference_queue_.ClearWhiteReferences(&cleared_references_, collector);
+  ClearWhiteReferences(self, &soft_reference_queue_, concurrent, collector);
+  ClearWhiteReferences(self, &weak_reference_queue_, concurrent, collector);
   // Clear all phantom references with white referents.
-  phantom_reference_queue_.ClearWhiteReferences(&cleared_references_, collector);
+  ClearWhiteReferences(self, &phantom_reference_queue_, concurrent, collector);
   // At this point all reference queues other than the cleared references should be empty.
   DCHECK(soft_reference_queue_.IsEmpty());
   DCHECK(weak_reference_queue_.IsEmpty());
@@ -265,18 +328,124 @@ class ClearedReferenceTask : public HeapTask {
   const jobject cleared_references_;
 };
 
+// Enqueues a circular list of cleared references on an enqueue thread.
+class ReferenceProcessor::EnqueuePendingTask : public Task {
+ public:
+  EnqueuePendingTask(ReferenceProcessor* processor, jobject references, size_t count)
+      : processor_(processor), references_(references), count_(count) {
+  }
+
+  void Run(Thread* self) OVERRIDE {
+    const uint64_t start_time = NanoTime();
+    {
+      ScopedObjectAccess soa(self);
+      jvalue args[1];
+      args[0].l = references_;
+      InvokeWithJValues(
+          soa, nullptr, WellKnownClasses::java_lang_ref_ReferenceQueue_enqueuePending, args);
+      if (self->IsExceptionPending()) {
+        LOG(WARNING) << "Exception enqueueing cleared references: "
+                     << self->GetException()->Dump();
+        self->ClearException();
+      }
+      soa.Env()->DeleteGlobalRef(references_);
+    }
+    processor_->enqueued_references_.FetchAndAddRelaxed(count_);
+    processor_->enqueue_time_ns_.FetchAndAddRelaxed(NanoTime() - start_time);
+    processor_->enqueue_backlog_.FetchAndSubRelaxed(count_);
+  }
+
+  void Finalize() OVERRIDE {
+    delete this;
+  }
+
+ private:
+  ReferenceProcessor* const processor_;
+  const jobject references_;
+  const size_t count_;
+};
+
+void ReferenceProcessor::AddEnqueuePendingTask(Thread* self,
+                                               ObjPtr<mirror::Reference> head,
+                                               ObjPtr<mirror::Reference> tail,
+                                               size_t count) {
+  tail->SetPendingNext(head);
+  jobject references = self->GetJniEnv()->vm->AddGlobalRef(self, head);
+  const size_t backlog = enqueue_backlog_.FetchAndAddRelaxed(count) + count;
+  size_t max_backlog = max_enqueue_backlog_.LoadRelaxed();
+  while (backlog > max_backlog &&
+         !max_enqueue_backlog_.CompareExchangeWeakRelaxed(max_backlog, backlog)) {
+  }
+  enqueue_thread_pool_->AddTask(self, new EnqueuePendingTask(this, references, count));
+}
+
+void ReferenceProcessor::HandClearedReferencesToEnqueueThreads(Thread* self) {
+  ObjPtr<mirror::Reference> const list = cleared_references_.GetList();
+  size_t count = 0u;
+  ObjPtr<mirror::Reference> ref = list;
+  do {
+    if (!ref->IsFinalizerReferenceInstance()) {
+      ++count;
+    }
+    ref = ref->GetPendingNext();
+  } while (ref != list);
+  if (count == 0u) {
+    return;
+  }
+  const size_t thread_count = enqueue_thread_pool_->GetThreadCount();
+  const size_t task_size =
+      std::max(kMinReferencesPerEnqueueTask, (count + thread_count - 1u) / thread_count);
+  // Relink the list. The finalizer references stay in cleared_references_, the others are split
+  // into circular lists of task_size references. Only the references already visited are relinked.
+  cleared_references_.Clear();
+  ObjPtr<mirror::Reference> task_head = nullptr;
+  ObjPtr<mirror::Reference> task_tail = nullptr;
+  size_t task_count = 0u;
+  ref = list;
+  do {
+    ObjPtr<mirror::Reference> next = ref->GetPendingNext();
+    if (ref->IsFinalizerReferenceInstance()) {
+      ref->SetPendingNext(nullptr);
+      cleared_references_.EnqueueReference(ref);
+    } else {
+      if (task_head == nullptr) {
+        task_head = ref;
+      } else {
+        task_tail->SetPendingNext(ref);
+      }
+      task_tail = ref;
+      if (++task_count == task_size) {
+        AddEnqueuePendingTask(self, task_head, task_tail, task_count);
+        task_head = nullptr;
+        task_count = 0u;
+      }
+    }
+    ref = next;
+  } while (ref != list);
+  if (task_head != nullptr) {
+    AddEnqueuePendingTask(self, task_head, task_tail, task_count);
+  }
+}
+
 void ReferenceProcessor::EnqueueClearedReferences(Thread* self) {
   Locks::mutator_lock_->AssertNotHeld(self);
   // When a runtime isn't started there are no reference queues to care about so ignore.
   if (!cleared_references_.IsEmpty()) {
     if (LIKELY(Runtime::Current()->IsStarted())) {
-      jobject cleared_references;
+      jobject cleared_references = nullptr;
       {
         ReaderMutexLock mu(self, *Locks::mutator_lock_);
-        cleared_references = self->GetJniEnv()->vm->AddGlobalRef(
-            self, cleared_references_.GetList());
+        if (enqueue_thread_pool_ != nullptr) {
+          HandClearedReferencesToEnqueueThreads(self);
+        }
+        if (!cleared_references_.IsEmpty()) {
+          cleared_references = self->GetJniEnv()->vm->AddGlobalRef(
+              self, cleared_references_.GetList());
+        }
       }
-      if (kAsyncReferenceQueueAdd) {
+      if (cleared_references == nullptr) {
+        // The enqueue threads got all the cleared references.
+      } else if (kAsyncReferenceQueueAdd) {
         // TODO: This can cause RunFinalization to terminate before newly freed objects are
         // finalized since they may not be enqueued by the time RunFinalization starts.
         Runtime::Current()->GetHeap()->GetTaskProcessor()->AddTask(
@@ -290,6 +459,44 @@ void ReferenceProcessor::EnqueueClearedReferences(Thread* self) {
   }
 }
 
+void ReferenceProcessor::CreateEnqueueThreadPool(size_t num_threads) {
+  DCHECK(enqueue_thread_pool_ == nullptr);
+  // The threads run managed code, the Cleaners among others.
+  constexpr bool kEnqueuePoolNeedsPeers = true;
+  enqueue_thread_pool_.reset(
+      new ThreadPool("Reference queue thread pool", num_threads, kEnqueuePoolNeedsPeers));
+  enqueue_thread_pool_->StartWorkers(Thread::Current());
+}
+
+void ReferenceProcessor::DeleteEnqueueThreadPool() {
+  if (enqueue_thread_pool_ == nullptr) {
+    return;
+  }
+  Thread* self = Thread::Current();
+  std::unique_ptr<ThreadPool> pool;
+  {
+    ScopedSuspendAll ssa(__FUNCTION__);
+    // Clear the field while the threads are suspended, EnqueueClearedReferences checks against it.
+    pool = std::move(enqueue_thread_pool_);
+  }
+  // The references left in the queue are not enqueued anymore at shutdown.
+  pool->StopWorkers(self);
+  pool->RemoveAllTasks(self);
+  pool->Wait(self, false, false);
+}
+
+void ReferenceProcessor::DumpEnqueueStatistics(std::ostream& os) const {
+  const uint64_t enqueued = enqueued_references_.LoadRelaxed();
+  const uint64_t time_ns = enqueue_time_ns_.LoadRelaxed();
+  os << "Cleared references enqueued by the reference queue threads: " << enqueued;
+  if (time_ns != 0u) {
+    os << " in " << PrettyDuration(time_ns) << " ("
+       << static_cast<uint64_t>(static_cast<double>(enqueued) * 1e9 / time_ns) << "/s)";
+  }
+  os << ", backlog " << GetEnqueueBacklog() << " (max " << max_enqueue_backlog_.LoadRelaxed()
+     << ")\n";
+}
+
 void ReferenceProcessor::ClearReferent(ObjPtr<mirror::Reference> ref) {
   Thread* self = Thread::Current();
   MutexLock mu(self, *Locks::reference_processor_lock_);
@@ -17,6 +17,8 @@
 #ifndef ART_RUNTIME_GC_REFERENCE_PROCESSOR_H_
 #define ART_RUNTIME_GC_REFERENCE_PROCESSOR_H_
 
+#include <memory>
+
 #include "base/mutex.h"
 #include "globals.h"
 #include "jni.h"
@@ -25,6 +27,7 @@
 namespace art {
 
 class IsMarkedVisitor;
+class ThreadPool;
 class TimingLogger;
 
 namespace mirror {
@@ -46,6 +49,7 @@ class Heap;
 class ReferenceProcessor {
  public:
   explicit ReferenceProcessor();
+  ~ReferenceProcessor();
   void ProcessReferences(bool concurrent,
                          TimingLogger* timings,
                          bool clear_soft_references,
@@ -61,7 +65,13 @@ class ReferenceProcessor {
   // Decode the referent, may block if references are being processed.
   ObjPtr<mirror::Object> GetReferent(Thread* self, ObjPtr<mirror::Reference> reference)
       REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(!Locks::reference_processor_lock_);
+  // Hands the cleared references to the managed reference queues. The finalizer references go to
+  // the ReferenceQueueDaemon. With an enqueue thread pool, the other references are split among
+  // its threads, which enqueue them directly, running the Cleaners, without waiting for them.
   void EnqueueClearedReferences(Thread* self) REQUIRES(!Locks::mutator_lock_);
+  // Create the pool of threads that enqueue the cleared references, see -Xreferencequeuethreads.
+  void CreateEnqueueThreadPool(size_t num_threads);
+  void DeleteEnqueueThreadPool();
   void DelayReferenceReferent(ObjPtr<mirror::Class> klass,
                               ObjPtr<mirror::Reference> ref,
                               collector::GarbageCollector* collector)
@@ -76,8 +86,24 @@ class ReferenceProcessor {
   void ClearReferent(ObjPtr<mirror::Reference> ref)
       REQUIRES_SHARED(Locks::mutator_lock_)
       REQUIRES(!Locks::reference_processor_lock_);
+  // Total time mutators spent blocked in GetReferent() and how many times they blocked.
+  uint64_t GetReferentBlockedTime() const {
+    return get_referent_blocked_ns_.LoadRelaxed();
+  }
+  uint64_t GetReferentBlockedCount() const {
+    return get_referent_blocked_count_.LoadRelaxed();
+  }
+  // Number of cleared references handed to the enqueue threads that are not enqueued yet.
+  size_t GetEnqueueBacklog() const {
+    return enqueue_backlog_.LoadRelaxed();
+  }
+  // Dump the backlog and throughput of the enqueue threads, if any.
+  void DumpEnqueueStatistics(std::ostream& os) const;
 
  private:
+  class ScopedGetReferentBlockedTime;
+  class EnqueuePendingTask;
+
   bool SlowPathEnabled() REQUIRES_SHARED(Locks::mutator_lock_);
   // Called by ProcessReferences.
   void DisableSlowPath(Thread* self) REQUIRES(Locks::reference_processor_lock_)
@@ -91,6 +117,22 @@ class ReferenceProcessor {
   void WaitUntilDoneProcessingReferences(Thread* self)
       REQUIRES_SHARED(Locks::mutator_lock_)
       REQUIRES(Locks::reference_processor_lock_);
+  // Split the cleared references other than the finalizer references among the enqueue threads.
+  void HandClearedReferencesToEnqueueThreads(Thread* self)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+  // Hand the circular list from head to tail to an enqueue thread.
+  void AddEnqueuePendingTask(Thread* self,
+                             ObjPtr<mirror::Reference> head,
+                             ObjPtr<mirror::Reference> tail,
+                             size_t count)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+  // Clear the white referents of queue, using the heap thread pool when the mutators are running
+  // and there is no transaction, since the blocked GetReferent() callers wait for this.
+  void ClearWhiteReferences(Thread* self,
+                            ReferenceQueue* queue,
+                            bool concurrent,
+                            collector::GarbageCollector* collector)
+      REQUIRES_SHARED(Locks::mutator_lock_);
   // Collector which is clearing references, used by the GetReferent to return referents which are
   // already marked.
   collector::GarbageCollector* collector_ GUARDED_BY(Locks::reference_processor_lock_);
@@ -106,6 +148,18 @@ class ReferenceProcessor {
   ReferenceQueue finalizer_reference_queue_;
   ReferenceQueue phantom_reference_queue_;
   ReferenceQueue cleared_references_;
+  // Time and number of times mutators blocked in GetReferent().
+  Atomic<uint64_t> get_referent_blocked_ns_;
+  Atomic<uint64_t> get_referent_blocked_count_;
+  // Threads enqueueing the cleared references other than the finalizer references, or null.
+  // Only replaced with the mutators suspended, EnqueueClearedReferences() uses it shared.
+  std::unique_ptr<ThreadPool> enqueue_thread_pool_;
+  // References handed to the enqueue threads, not yet enqueued, and the most there were.
+  Atomic<size_t> enqueue_backlog_;
+  Atomic<size_t> max_enqueue_backlog_;
+  // References the enqueue threads enqueued and the time they took, Cleaners included.
+  Atomic<uint64_t> enqueued_references_;
+  Atomic<uint64_t> enqueue_time_ns_;
 
   DISALLOW_COPY_AND_ASSIGN(ReferenceProcessor);
 };
@@ -129,20 +129,28 @@ size_t ReferenceQueue::GetLength() const {
   return count;
 }
 
+bool ReferenceQueue::ClearWhiteReferent(ObjPtr<mirror::Reference> ref,
+                                        collector::GarbageCollector* collector) {
+  mirror::HeapReference<mirror::Object>* referent_addr = ref->GetReferentReferenceAddr();
+  // do_atomic_update is false because this happens during the reference processing phase where
+  // Reference.clear() would block.
+  if (!collector->IsNullOrMarkedHeapReference(referent_addr, /*do_atomic_update*/false)) {
+    // Referent is white, clear it.
+    if (Runtime::Current()->IsActiveTransaction()) {
+      ref->ClearReferent<true>();
+    } else {
+      ref->ClearReferent<false>();
+    }
+    return true;
+  }
+  return false;
+}
+
 void ReferenceQueue::ClearWhiteReferences(ReferenceQueue* cleared_references,
                                           collector::GarbageCollector* collector) {
   while (!IsEmpty()) {
     ObjPtr<mirror::Reference> ref = DequeuePendingReference();
-    mirror::HeapReference<mirror::Object>* referent_addr = ref->GetReferentReferenceAddr();
-    // do_atomic_update is false because this happens during the reference processing phase where
-    // Reference.clear() would block.
-    if (!collector->IsNullOrMarkedHeapReference(referent_addr, /*do_atomic_update*/false)) {
-      // Referent is white, clear it.
-      if (Runtime::Current()->IsActiveTransaction()) {
-        ref->ClearReferent<true>();
-      } else {
-        ref->ClearReferent<false>();
-      }
+    if (ClearWhiteReferent(ref, collector)) {
       cleared_references->EnqueueReference(ref);
     }
     // Delay disabling the read barrier until here so that the ClearReferent call above in
@@ -151,6 +159,85 @@ void ReferenceQueue::ClearWhiteReferences(ReferenceQueue* cleared_references,
   }
 }
 
+void ReferenceQueue::ClearWhiteReferentRange(mirror::Reference* const* begin,
+                                             mirror::Reference* const* end,
+                                             collector::GarbageCollector* collector,
+                                             std::vector<mirror::Reference*>* cleared) {
+  for (mirror::Reference* const* it = begin; it != end; ++it) {
+    ObjPtr<mirror::Reference> ref = *it;
+    if (ClearWhiteReferent(ref, collector)) {
+      cleared->push_back(ref.Ptr());
+    }
+    DisableReadBarrierForReference(ref);
+  }
+}
+
+class ReferenceQueue::ClearWhiteReferencesTask : public Task {
+ public:
+  ClearWhiteReferencesTask(mirror::Reference* const* begin,
+                           mirror::Reference* const* end,
+                           collector::GarbageCollector* collector,
+                           std::vector<mirror::Reference*>* cleared)
+      : begin_(begin), end_(end), collector_(collector), cleared_(cleared) {
+  }
+
+  void Run(Thread* self) OVERRIDE NO_THREAD_SAFETY_ANALYSIS {
+    // The GC thread holds the mutator lock shared while it waits for the workers.
+    ReaderMutexLock mu(self, *Locks::mutator_lock_);
+    ReferenceQueue::ClearWhiteReferentRange(begin_, end_, collector_, cleared_);
+  }
+
+  void Finalize() OVERRIDE {
+    delete this;
+  }
+
+ private:
+  mirror::Reference* const* const begin_;
+  mirror::Reference* const* const end_;
+  collector::GarbageCollector* const collector_;
+  std::vector<mirror::Reference*>* const cleared_;
+};
+
+void ReferenceQueue::ClearWhiteReferencesParallel(ReferenceQueue* cleared_references,
+                                                  collector::GarbageCollector* collector,
+                                                  ThreadPool* thread_pool,
+                                                  size_t thread_count) {
+  DCHECK(!Runtime::Current()->IsActiveTransaction());
+  // Unlink the whole list first so that it can be split. Raw pointers since the workers can't use
+  // the ObjPtr of another thread.
+  std::vector<mirror::Reference*> refs;
+  while (!IsEmpty()) {
+    refs.push_back(DequeuePendingReference().Ptr());
+  }
+  thread_count = std::min(thread_count, refs.size() / kMinParallelReferencesPerThread);
+  std::vector<std::vector<mirror::Reference*>> cleared(std::max<size_t>(thread_count, 1U));
+  mirror::Reference* const* const refs_begin = refs.data();
+  mirror::Reference* const* const refs_end = refs_begin + refs.size();
+  if (thread_count <= 1) {
+    ClearWhiteReferentRange(refs_begin, refs_end, collector, &cleared[0]);
+  } else {
+    Thread* self = Thread::Current();
+    const size_t chunk_size = (refs.size() + thread_count - 1) / thread_count;
+    for (size_t i = 1; i < thread_count; ++i) {
+      mirror::Reference* const* begin = std::min(refs_begin + i * chunk_size, refs_end);
+      mirror::Reference* const* end = std::min(begin + chunk_size, refs_end);
+      thread_pool->AddTask(self, new ClearWhiteReferencesTask(begin, end, collector, &cleared[i]));
+    }
+    thread_pool->SetMaxActiveWorkers(thread_count - 1);
+    thread_pool->StartWorkers(self);
+    // The calling thread takes the first chunk.
+    ClearWhiteReferentRange(refs_begin, std::min(refs_begin + chunk_size, refs_end), collector,
+                            &cleared[0]);
+    thread_pool->Wait(self, /* do_work */ false, /* may_hold_locks */ true);
+    thread_pool->StopWorkers(self);
+  }
+  for (const std::vector<mirror::Reference*>& cleared_refs : cleared) {
+    for (mirror::Reference* ref : cleared_refs) {
+      cleared_references->EnqueueReference(ref);
+    }
+  }
+}
+
 void ReferenceQueue::EnqueueFinalizerReferences(ReferenceQueue* cleared_references,
                                                 collector::GarbageCollector* collector) {
   while (!IsEmpty()) {
@@ -71,7 +71,7 @@ class ReferenceQueue {
   // If applicable, disable the read barrier for the reference after its referent is handled (see
   // ConcurrentCopying::ProcessMarkStackRef.) This must be called for a reference that's dequeued
   // from pending queue (DequeuePendingReference).
-  void DisableReadBarrierForReference(ObjPtr<mirror::Reference> ref)
+  static void DisableReadBarrierForReference(ObjPtr<mirror::Reference> ref)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
   // Enqueues finalizer references with white referents.  White referents are blackened, moved to
@@ -92,6 +92,15 @@ class ReferenceQueue {
                             collector::GarbageCollector* collector)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Like ClearWhiteReferences() but splits the references among the calling thread and
+  // thread_count - 1 workers of thread_pool if there are enough of them. The collector must
+  // support concurrent IsNullOrMarkedHeapReference() calls and no transaction may be active.
+  void ClearWhiteReferencesParallel(ReferenceQueue* cleared_references,
+                                    collector::GarbageCollector* collector,
+                                    ThreadPool* thread_pool,
+                                    size_t thread_count)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
   void Dump(std::ostream& os) const REQUIRES_SHARED(Locks::mutator_lock_);
   size_t GetLength() const REQUIRES_SHARED(Locks::mutator_lock_);
 
@@ -110,6 +119,23 @@ class ReferenceQueue {
       REQUIRES_SHARED(Locks::mutator_lock_);
 
  private:
+  class ClearWhiteReferencesTask;
+
+  // The minimum number of references for each thread of ClearWhiteReferencesParallel().
+  static constexpr size_t kMinParallelReferencesPerThread = 1024;
+
+  // Clears the referent of a dequeued reference if it is white. Returns true if it was cleared.
+  static bool ClearWhiteReferent(ObjPtr<mirror::Reference> ref,
+                                 collector::GarbageCollector* collector)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+  // Calls ClearWhiteReferent() and DisableReadBarrierForReference() for refs [begin, end) and
+  // appends the cleared ones to cleared.
+  static void ClearWhiteReferentRange(mirror::Reference* const* begin,
+                                      mirror::Reference* const* end,
+                                      collector::GarbageCollector* collector,
+                                      std::vector<mirror::Reference*>* cleared)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
   // Lock, used for parallel GC reference enqueuing. It allows for multiple threads simultaneously
   // calling AtomicEnqueueIfNotEnqueued.
   Mutex* const lock_;
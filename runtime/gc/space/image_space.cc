@@ -34,17 +34,21 @@
 #include "base/scoped_flock.h"
 #include "base/systrace.h"
 #include "base/time_utils.h"
+#include "class_linker.h"
 #include "exec_utils.h"
 #include "gc/accounting/space_bitmap-inl.h"
 #include "image-inl.h"
 #include "image_space_fs.h"
+#include "intern_table.h"
 #include "mirror/class-inl.h"
+#include "mirror/executable.h"
 #include "mirror/object-inl.h"
 #include "mirror/object-refvisitor-inl.h"
 #include "oat_file.h"
 #include "os.h"
 #include "runtime.h"
 #include "space-inl.h"
+#include "thread_pool.h"
 #include "utils.h"
 
 namespace art {
@@ -56,6 +60,10 @@ using android::base::StringPrintf;
 
 Atomic<uint32_t> ImageSpace::bitmap_index_(0);
 
+// App images with fewer bytes of ArtMethods than this fix up their native structures on the
+// loading thread only, starting workers would take longer than the fixup.
+static constexpr size_t kMinMethodBytesForParallelFixup = 256 * KB;
+
 ImageSpace::ImageSpace(const std::string& image_filename,
                        const char* image_location,
                        MemMap* mem_map,
@@ -314,6 +322,15 @@ ImageHeader* ImageSpace::ReadImageHeader(const char* image_location,
         }
         return cache_hdr.release();
       } else if (!has_cache) {
+        gc::Heap* const heap = Runtime::Current()->GetHeap();
+        if (Runtime::Current()->ShouldRelocateInPlace() &&
+            image_isa == kRuntimeISA &&
+            heap != nullptr &&
+            !heap->GetBootImageSpaces().empty()) {
+          // The boot image was relocated in memory, the header of the loaded primary image has
+          // the addresses and patch delta in use.
+          return new ImageHeader(heap->GetBootImageSpaces()[0]->GetImageHeader());
+        }
         *error_msg = StringPrintf("Unable to find a relocated version of image file %s",
                                   image_location);
         return nullptr;
@@ -480,6 +497,7 @@ class ImageSpaceLoader {
                                           bool is_zygote,
                                           bool is_global_cache,
                                           bool validate_oat_file,
+                                          int32_t relocation_delta,
                                           std::string* error_msg)
       REQUIRES_SHARED(Locks::mutator_lock_) {
     // Should this be a RDWR lock? This is only a defensive measure, as at
@@ -510,13 +528,18 @@ class ImageSpaceLoader {
                 image_location,
                 validate_oat_file,
                 /* oat_file */nullptr,
+                relocation_delta,
                 error_msg);
   }
 
+  // A non-zero relocation_delta maps a PIC boot image that many bytes away from the address it
+  // was compiled for. Only the image header is relocated, RelocateBootImagesInPlace must fix up
+  // the contents once all the boot image spaces are loaded.
   static std::unique_ptr<ImageSpace> Init(const char* image_filename,
                                           const char* image_location,
                                           bool validate_oat_file,
                                           const OatFile* oat_file,
+                                          int32_t relocation_delta,
                                           std::string* error_msg)
       REQUIRES_SHARED(Locks::mutator_lock_) {
     CHECK(image_filename != nullptr);
@@ -553,6 +576,11 @@ class ImageSpaceLoader {
       return nullptr;
     }
 
+    if (relocation_delta != 0 && (oat_file != nullptr || !image_header->CompilePic())) {
+      *error_msg = StringPrintf("Cannot relocate non-pic boot image %s in place", image_filename);
+      return nullptr;
+    }
+
     if (oat_file != nullptr) {
       // If we have an oat file, check the oat file checksum. The oat file is only non-null for the
       // app image case. Otherwise, we open the oat file after the image and check the checksum there.
@@ -600,7 +628,7 @@ class ImageSpaceLoader {
     map.reset(LoadImageFile(image_filename,
                             image_location,
                             *image_header,
-                            image_header->GetImageBegin(),
+                            image_header->GetImageBegin() + relocation_delta,
                             file->Fd(),
                             logger,
                             image_header->IsPic() ? nullptr : error_msg));
@@ -638,6 +666,10 @@ class ImageSpaceLoader {
     // Loaded the map, use the image header from the file now in case we patch it with
     // RelocateInPlace.
     image_header = reinterpret_cast<ImageHeader*>(map->Begin());
+    if (relocation_delta != 0) {
+      // Relocate the header now so that the oat file is opened at its new address.
+      image_header->RelocateImage(relocation_delta);
+    }
     const uint32_t bitmap_index = ImageSpace::bitmap_index_.FetchAndAddSequentiallyConsistent(1);
     std::string bitmap_name(StringPrintf("imagespace %s live-bitmap %u",
                                          image_filename,
@@ -661,7 +693,7 @@ class ImageSpaceLoader {
         return nullptr;
       }
     }
-    {
+    if (relocation_delta == 0) {
       TimingLogger::ScopedTiming timing("RelocateImage", &logger);
       if (!RelocateInPlace(*image_header,
                            map->Begin(),
@@ -921,6 +953,33 @@ class ImageSpaceLoader {
     }
   };
 
+  // Adapt for InternTable::VisitRoots.
+  class FixupInternRootVisitor : public FixupVisitor, public RootVisitor {
+   public:
+    template<typename... Args>
+    explicit FixupInternRootVisitor(Args... args) : FixupVisitor(args...) {}
+
+    void VisitRoots(mirror::Object*** roots, size_t count, const RootInfo& info ATTRIBUTE_UNUSED)
+        OVERRIDE REQUIRES_SHARED(Locks::mutator_lock_) {
+      for (size_t i = 0; i < count; ++i) {
+        *roots[i] = ForwardObject(*roots[i]);
+      }
+    }
+
+    void VisitRoots(mirror::CompressedReference<mirror::Object>** roots,
+                    size_t count,
+                    const RootInfo& info ATTRIBUTE_UNUSED)
+        OVERRIDE REQUIRES_SHARED(Locks::mutator_lock_) {
+      for (size_t i = 0; i < count; ++i) {
+        mirror::Object* ref = roots[i]->AsMirrorPtr();
+        mirror::Object* new_ref = ForwardObject(ref);
+        if (ref != new_ref) {
+          roots[i]->Assign(new_ref);
+        }
+      }
+    }
+  };
+
   class FixupObjectVisitor : public FixupVisitor {
    public:
     template<typename... Args>
@@ -929,7 +988,16 @@ class ImageSpaceLoader {
                                 Args... args)
         : FixupVisitor(args...),
           pointer_size_(pointer_size),
-          visited_(visited) {}
+          visited_(visited),
+          method_class_(nullptr),
+          constructor_class_(nullptr) {}
+
+    // Also forward the ArtMethod pointers of java.lang.reflect.Method and Constructor objects,
+    // which are held in a long field that VisitReferences does not see.
+    void SetExecutableClasses(mirror::Class* method_class, mirror::Class* constructor_class) {
+      method_class_ = method_class;
+      constructor_class_ = constructor_class;
+    }
 
     // Fix up separately since we also need to fix up method entrypoints.
     ALWAYS_INLINE void VisitRootIfNonNull(
@@ -948,9 +1016,14 @@ class ImageSpaceLoader {
         // Space is not yet added to the heap, don't do a read barrier.
         mirror::Object* ref = obj->GetFieldObject<mirror::Object, kVerifyNone, kWithoutReadBarrier>(
             offset);
-        // Use SetFieldObjectWithoutWriteBarrier to avoid card marking since we are writing to the
-        // image.
-        obj->SetFieldObjectWithoutWriteBarrier<false, true, kVerifyNone>(offset, ForwardObject(ref));
+        mirror::Object* new_ref = ForwardObject(ref);
+        // Only write changed references so that pages which don't need relocation, e.g. ones only
+        // referring to a boot image mapped at its requested address, stay clean and shared.
+        if (ref != new_ref) {
+          // Use SetFieldObjectWithoutWriteBarrier to avoid card marking since we are writing to the
+          // image.
+          obj->SetFieldObjectWithoutWriteBarrier<false, true, kVerifyNone>(offset, new_ref);
+        }
       }
     }
 
@@ -979,9 +1052,12 @@ class ImageSpaceLoader {
                     ObjPtr<mirror::Reference> ref) const
         REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(Locks::heap_bitmap_lock_) {
       mirror::Object* obj = ref->GetReferent<kWithoutReadBarrier>();
-      ref->SetFieldObjectWithoutWriteBarrier<false, true, kVerifyNone>(
-          mirror::Reference::ReferentOffset(),
-          ForwardObject(obj));
+      mirror::Object* new_obj = ForwardObject(obj);
+      if (obj != new_obj) {
+        ref->SetFieldObjectWithoutWriteBarrier<false, true, kVerifyNone>(
+            mirror::Reference::ReferentOffset(),
+            new_obj);
+      }
     }
 
     void operator()(mirror::Object* obj) const
@@ -1025,6 +1101,16 @@ class ImageSpaceLoader {
       obj->VisitReferences</*visit native roots*/false, kVerifyNone, kWithoutReadBarrier>(
           *this,
           *this);
+      mirror::Class* const klass = obj->GetClass<kVerifyNone, kWithoutReadBarrier>();
+      if (UNLIKELY(klass != nullptr &&
+                   (klass == method_class_ || klass == constructor_class_))) {
+        mirror::Executable* executable = down_cast<mirror::Executable*>(obj);
+        ArtMethod* method = executable->GetArtMethod();
+        ArtMethod* new_method = ForwardObject(method);
+        if (method != new_method) {
+          executable->SetArtMethod(new_method);
+        }
+      }
       // Note that this code relies on no circular dependencies.
       // We want to use our own class loader and not the one in the image.
       if (obj->IsClass<kVerifyNone, kWithoutReadBarrier>()) {
@@ -1063,6 +1149,8 @@ class ImageSpaceLoader {
    private:
     const PointerSize pointer_size_;
     gc::accounting::ContinuousSpaceBitmap* const visited_;
+    mirror::Class* method_class_;
+    mirror::Class* constructor_class_;
   };
 
   class ForwardObjectAdapter {
@@ -1095,9 +1183,13 @@ class ImageSpaceLoader {
   class FixupArtMethodVisitor : public FixupVisitor, public ArtMethodVisitor {
    public:
     template<typename... Args>
-    explicit FixupArtMethodVisitor(bool fixup_heap_objects, PointerSize pointer_size, Args... args)
+    explicit FixupArtMethodVisitor(bool fixup_heap_objects,
+                                   bool fixup_code,
+                                   PointerSize pointer_size,
+                                   Args... args)
         : FixupVisitor(args...),
           fixup_heap_objects_(fixup_heap_objects),
+          fixup_code_(fixup_code),
           pointer_size_(pointer_size) {}
 
     virtual void Visit(ArtMethod* method) NO_THREAD_SAFETY_ANALYSIS {
@@ -1119,12 +1211,16 @@ class ImageSpaceLoader {
         if (fixup_heap_objects_) {
           method->UpdateObjectsForImageRelocation(ForwardObjectAdapter(this), pointer_size_);
         }
-        method->UpdateEntrypoints<kWithoutReadBarrier>(ForwardCodeAdapter(this), pointer_size_);
+        if (fixup_code_) {
+          method->UpdateEntrypoints<kWithoutReadBarrier>(ForwardCodeAdapter(this), pointer_size_);
+        }
       }
     }
 
    private:
     const bool fixup_heap_objects_;
+    // False if the oat files are at the addresses the image was compiled for.
+    const bool fixup_code_;
     const PointerSize pointer_size_;
   };
 
@@ -1138,6 +1234,83 @@ class ImageSpaceLoader {
     }
   };
 
+  // Visits the elements of packed arrays, taking a few arrays at a time from a shared index so
+  // that the workers of a thread pool and the calling thread split the arrays between them. The
+  // visitors only write to the visited elements, so the elements can be visited in any order.
+  template <typename T, typename Visitor>
+  class VisitPackedArraysTask FINAL : public Task {
+   public:
+    VisitPackedArraysTask(const std::vector<LengthPrefixedArray<T>*>& arrays,
+                          size_t element_size,
+                          size_t element_alignment,
+                          Atomic<size_t>* next_index,
+                          Visitor* visitor)
+        : arrays_(arrays),
+          element_size_(element_size),
+          element_alignment_(element_alignment),
+          next_index_(next_index),
+          visitor_(visitor) {}
+
+    void Run(Thread* self ATTRIBUTE_UNUSED) OVERRIDE {
+      const size_t num_arrays = arrays_.size();
+      while (true) {
+        size_t begin = next_index_->FetchAndAddSequentiallyConsistent(kArraysPerChunk);
+        if (begin >= num_arrays) {
+          break;
+        }
+        size_t end = std::min(begin + kArraysPerChunk, num_arrays);
+        for (size_t i = begin; i != end; ++i) {
+          LengthPrefixedArray<T>* array = arrays_[i];
+          for (size_t j = 0, size = array->size(); j != size; ++j) {
+            visitor_->Visit(&array->At(j, element_size_, element_alignment_));
+          }
+        }
+      }
+    }
+
+    void Finalize() OVERRIDE {
+      delete this;
+    }
+
+   private:
+    static constexpr size_t kArraysPerChunk = 64u;
+
+    const std::vector<LengthPrefixedArray<T>*>& arrays_;
+    const size_t element_size_;
+    const size_t element_alignment_;
+    Atomic<size_t>* const next_index_;
+    Visitor* const visitor_;
+  };
+
+  // Visit the elements of the packed arrays in `section` of the image mapped at `base`, on
+  // `thread_pool` and the calling thread if `thread_pool` is not null.
+  template <typename T, typename Visitor>
+  static void VisitPackedArrays(const ImageSection& section,
+                                uint8_t* base,
+                                size_t element_size,
+                                size_t element_alignment,
+                                Visitor* visitor,
+                                ThreadPool* thread_pool) {
+    std::vector<LengthPrefixedArray<T>*> arrays;
+    for (size_t pos = 0; pos < section.Size(); ) {
+      auto* array = reinterpret_cast<LengthPrefixedArray<T>*>(base + section.Offset() + pos);
+      arrays.push_back(array);
+      pos += array->ComputeSize(array->size(), element_size, element_alignment);
+    }
+    Atomic<size_t> next_index(0u);
+    if (thread_pool == nullptr) {
+      VisitPackedArraysTask<T, Visitor>(
+          arrays, element_size, element_alignment, &next_index, visitor).Run(nullptr);
+      return;
+    }
+    Thread* self = Thread::Current();
+    for (size_t i = 0, count = thread_pool->GetThreadCount() + 1u; i != count; ++i) {
+      thread_pool->AddTask(self, new VisitPackedArraysTask<T, Visitor>(
+          arrays, element_size, element_alignment, &next_index, visitor));
+    }
+    thread_pool->Wait(self, /* do_work */ true, /* may_hold_locks */ false);
+  }
+
   // Relocate an image space mapped at target_base which possibly used to be at a different base
   // address. Only needs a single image space, not one for both source and destination.
   // In place means modifying a single ImageSpace in place rather than relocating from one ImageSpace
@@ -1246,124 +1419,289 @@ class ImageSpaceLoader {
           image_header.GetImageRoots<kWithoutReadBarrier>())));
       image_header.RelocateImageObjects(app_image.Delta());
       CHECK_EQ(image_header.GetImageBegin(), target_base);
-      // Fix up dex cache DexFile pointers.
-      auto* dex_caches = image_header.GetImageRoot<kWithoutReadBarrier>(ImageHeader::kDexCaches)->
-          AsObjectArray<mirror::DexCache, kVerifyNone, kWithoutReadBarrier>();
-      for (int32_t i = 0, count = dex_caches->GetLength(); i < count; ++i) {
-        mirror::DexCache* dex_cache = dex_caches->Get<kVerifyNone, kWithoutReadBarrier>(i);
-        // Fix up dex cache pointers.
-        mirror::StringDexCacheType* strings = dex_cache->GetStrings();
-        if (strings != nullptr) {
-          mirror::StringDexCacheType* new_strings = fixup_adapter.ForwardObject(strings);
-          if (strings != new_strings) {
-            dex_cache->SetStrings(new_strings);
-          }
-          dex_cache->FixupStrings<kWithoutReadBarrier>(new_strings, fixup_adapter);
+      FixupDexCaches(image_header, fixup_adapter, pointer_size);
+    }
+    // The fixup of the native structures does not need the mutator lock, it can use workers.
+    // Start them only when there are enough methods for the thread creation to pay off.
+    const size_t num_threads =
+        (image_header.GetMethodsSection().Size() >= kMinMethodBytesForParallelFixup)
+            ? Runtime::Current()->GetImageFixupThreads()
+            : 0u;
+    FixupNativeStructures(image_header,
+                          target_base,
+                          fixup_image,
+                          fixup_code,
+                          pointer_size,
+                          fixup_adapter,
+                          num_threads,
+                          &logger);
+    if (fixup_image) {
+      // In the app image case, the image methods are actually in the boot image.
+      image_header.RelocateImageMethods(boot_image.Delta());
+      ScopedObjectAccess soa(Thread::Current());
+      FixupClassTable(image_header, target_base, fixup_adapter);
+    }
+    if (VLOG_IS_ON(image)) {
+      logger.Dump(LOG_STREAM(INFO));
+    }
+    return true;
+  }
+
+ public:
+  // Relocate the boot image spaces, which Init mapped `delta` bytes away from the addresses they
+  // were compiled for. Init has already relocated the image headers and the oat files are loaded
+  // at their new addresses, only the contents of the images remain to be fixed up. The images
+  // reference each other in both directions, so they are fixed up as if they were a single app
+  // image spanning all of them. This runs before any thread is attached, nothing may look at the
+  // objects of the spaces before it returns.
+  static bool RelocateBootImagesInPlace(const std::vector<ImageSpace*>& spaces,
+                                        int32_t delta,
+                                        std::string* error_msg)
+      REQUIRES_SHARED(Locks::mutator_lock_) {
+    DCHECK(!spaces.empty());
+    DCHECK_NE(delta, 0);
+    TimingLogger logger(__FUNCTION__, true, false);
+    const ImageHeader& first_header = spaces.front()->GetImageHeader();
+    const ImageHeader& last_header = spaces.back()->GetImageHeader();
+    const uintptr_t images_begin = reinterpret_cast<uintptr_t>(first_header.GetImageBegin());
+    const uintptr_t images_end =
+        reinterpret_cast<uintptr_t>(last_header.GetImageBegin() + last_header.GetImageSize());
+    const uintptr_t oats_begin = reinterpret_cast<uintptr_t>(first_header.GetOatFileBegin());
+    const uintptr_t oats_end = reinterpret_cast<uintptr_t>(last_header.GetOatFileEnd());
+    if (images_begin >= images_end || oats_begin >= oats_end) {
+      *error_msg = "Boot image spaces are not in ascending address order";
+      return false;
+    }
+    const PointerSize pointer_size = first_header.GetPointerSize();
+    const RelocationRange no_range(0u, 0u, 0u);
+    RelocationRange images(images_begin - delta, images_begin, images_end - images_begin);
+    RelocationRange oats(oats_begin - delta, oats_begin, oats_end - oats_begin);
+    VLOG(image) << "Boot images " << images;
+    VLOG(image) << "Boot oats " << oats;
+    FixupObjectAdapter fixup_adapter(no_range, no_range, images, oats);
+
+    // The image roots of the primary image are still unrelocated, look up the classes of the
+    // reflective methods through them before the object fixup rewrites them.
+    mirror::ObjectArray<mirror::Object>* image_roots =
+        first_header.GetImageRoots<kWithoutReadBarrier>();
+    CHECK(images.InDest(reinterpret_cast<uintptr_t>(image_roots)));
+    // No AsObjectArray since the class of the array is not fixed up yet.
+    auto* class_roots = down_cast<mirror::ObjectArray<mirror::Class>*>(fixup_adapter.ForwardObject(
+        image_roots->Get<kVerifyNone, kWithoutReadBarrier>(ImageHeader::kClassRoots)));
+    mirror::Class* method_class = fixup_adapter.ForwardObject(
+        class_roots->Get<kVerifyNone, kWithoutReadBarrier>(ClassLinker::kJavaLangReflectMethod));
+    mirror::Class* constructor_class = fixup_adapter.ForwardObject(
+        class_roots->Get<kVerifyNone, kWithoutReadBarrier>(
+            ClassLinker::kJavaLangReflectConstructor));
+    {
+      // One visited bitmap for all the spaces since the fixup of an object may first fix up its
+      // class, super class and method arrays in another space.
+      TimingLogger::ScopedTiming timing("Fixup objects", &logger);
+      std::unique_ptr<gc::accounting::ContinuousSpaceBitmap> visited_bitmap(
+          gc::accounting::ContinuousSpaceBitmap::Create("Relocate bitmap",
+                                                        reinterpret_cast<uint8_t*>(images_begin),
+                                                        images_end - images_begin));
+      FixupObjectVisitor fixup_object_visitor(visited_bitmap.get(),
+                                              pointer_size,
+                                              no_range,
+                                              no_range,
+                                              images,
+                                              oats);
+      fixup_object_visitor.SetExecutableClasses(method_class, constructor_class);
+      for (ImageSpace* space : spaces) {
+        const ImageSection& objects_section =
+            space->GetImageHeader().GetImageSection(ImageHeader::kSectionObjects);
+        space->GetLiveBitmap()->VisitMarkedRange(
+            reinterpret_cast<uintptr_t>(space->Begin() + objects_section.Offset()),
+            reinterpret_cast<uintptr_t>(space->Begin() + objects_section.End()),
+            fixup_object_visitor);
+      }
+    }
+    for (ImageSpace* space : spaces) {
+      const ImageHeader& image_header = space->GetImageHeader();
+      FixupDexCaches(image_header, fixup_adapter, pointer_size);
+      // No thread is attached yet, the boot images are fixed up on this thread only.
+      FixupNativeStructures(image_header,
+                            space->Begin(),
+                            /* fixup_image */ true,
+                            /* fixup_code */ true,
+                            pointer_size,
+                            fixup_adapter,
+                            /* num_threads */ 0u,
+                            &logger);
+      FixupClassTable(image_header, space->Begin(), fixup_adapter);
+      FixupInternTable(image_header, space->Begin(), fixup_adapter);
+    }
+    if (VLOG_IS_ON(image)) {
+      logger.Dump(LOG_STREAM(INFO));
+    }
+    return true;
+  }
+
+ private:
+  // Fix up the native arrays of the dex caches of an image whose objects are already relocated.
+  static void FixupDexCaches(const ImageHeader& image_header,
+                             const FixupObjectAdapter& fixup_adapter,
+                             PointerSize pointer_size)
+      REQUIRES_SHARED(Locks::mutator_lock_) {
+    auto* dex_caches = image_header.GetImageRoot<kWithoutReadBarrier>(ImageHeader::kDexCaches)->
+        AsObjectArray<mirror::DexCache, kVerifyNone, kWithoutReadBarrier>();
+    for (int32_t i = 0, count = dex_caches->GetLength(); i < count; ++i) {
+      mirror::DexCache* dex_cache = dex_caches->Get<kVerifyNone, kWithoutReadBarrier>(i);
+      // Fix up dex cache pointers.
+      mirror::StringDexCacheType* strings = dex_cache->GetStrings();
+      if (strings != nullptr) {
+        mirror::StringDexCacheType* new_strings = fixup_adapter.ForwardObject(strings);
+        if (strings != new_strings) {
+          dex_cache->SetStrings(new_strings);
         }
-        mirror::TypeDexCacheType* types = dex_cache->GetResolvedTypes();
-        if (types != nullptr) {
-          mirror::TypeDexCacheType* new_types = fixup_adapter.ForwardObject(types);
-          if (types != new_types) {
-            dex_cache->SetResolvedTypes(new_types);
-          }
-          dex_cache->FixupResolvedTypes<kWithoutReadBarrier>(new_types, fixup_adapter);
+        dex_cache->FixupStrings<kWithoutReadBarrier>(new_strings, fixup_adapter);
+      }
+      mirror::TypeDexCacheType* types = dex_cache->GetResolvedTypes();
+      if (types != nullptr) {
+        mirror::TypeDexCacheType* new_types = fixup_adapter.ForwardObject(types);
+        if (types != new_types) {
+          dex_cache->SetResolvedTypes(new_types);
         }
-        mirror::MethodDexCacheType* methods = dex_cache->GetResolvedMethods();
-        if (methods != nullptr) {
-          mirror::MethodDexCacheType* new_methods = fixup_adapter.ForwardObject(methods);
-          if (methods != new_methods) {
-            dex_cache->SetResolvedMethods(new_methods);
-          }
-          for (size_t j = 0, num = dex_cache->NumResolvedMethods(); j != num; ++j) {
-            auto pair = mirror::DexCache::GetNativePairPtrSize(new_methods, j, pointer_size);
-            ArtMethod* orig = pair.object;
-            ArtMethod* copy = fixup_adapter.ForwardObject(orig);
-            if (orig != copy) {
-              pair.object = copy;
-              mirror::DexCache::SetNativePairPtrSize(new_methods, j, pair, pointer_size);
-            }
-          }
+        dex_cache->FixupResolvedTypes<kWithoutReadBarrier>(new_types, fixup_adapter);
+      }
+      mirror::MethodDexCacheType* methods = dex_cache->GetResolvedMethods();
+      if (methods != nullptr) {
+        mirror::MethodDexCacheType* new_methods = fixup_adapter.ForwardObject(methods);
+        if (methods != new_methods) {
+          dex_cache->SetResolvedMethods(new_methods);
         }
-        mirror::FieldDexCacheType* fields = dex_cache->GetResolvedFields();
-        if (fields != nullptr) {
-          mirror::FieldDexCacheType* new_fields = fixup_adapter.ForwardObject(fields);
-          if (fields != new_fields) {
-            dex_cache->SetResolvedFields(new_fields);
+        for (size_t j = 0, num = dex_cache->NumResolvedMethods(); j != num; ++j) {
+          auto pair = mirror::DexCache::GetNativePairPtrSize(new_methods, j, pointer_size);
+          ArtMethod* orig = pair.object;
+          ArtMethod* copy = fixup_adapter.ForwardObject(orig);
+          if (orig != copy) {
+            pair.object = copy;
+            mirror::DexCache::SetNativePairPtrSize(new_methods, j, pair, pointer_size);
           }
-          for (size_t j = 0, num = dex_cache->NumResolvedFields(); j != num; ++j) {
-            mirror::FieldDexCachePair orig =
-                mirror::DexCache::GetNativePairPtrSize(new_fields, j, pointer_size);
-            mirror::FieldDexCachePair copy(fixup_adapter.ForwardObject(orig.object), orig.index);
-            if (orig.object != copy.object) {
-              mirror::DexCache::SetNativePairPtrSize(new_fields, j, copy, pointer_size);
-            }
+        }
+      }
+      mirror::FieldDexCacheType* fields = dex_cache->GetResolvedFields();
+      if (fields != nullptr) {
+        mirror::FieldDexCacheType* new_fields = fixup_adapter.ForwardObject(fields);
+        if (fields != new_fields) {
+          dex_cache->SetResolvedFields(new_fields);
+        }
+        for (size_t j = 0, num = dex_cache->NumResolvedFields(); j != num; ++j) {
+          mirror::FieldDexCachePair orig =
+              mirror::DexCache::GetNativePairPtrSize(new_fields, j, pointer_size);
+          mirror::FieldDexCachePair copy(fixup_adapter.ForwardObject(orig.object), orig.index);
+          if (orig.object != copy.object) {
+            mirror::DexCache::SetNativePairPtrSize(new_fields, j, copy, pointer_size);
           }
         }
+      }
 
-        mirror::MethodTypeDexCacheType* method_types = dex_cache->GetResolvedMethodTypes();
-        if (method_types != nullptr) {
-          mirror::MethodTypeDexCacheType* new_method_types =
-              fixup_adapter.ForwardObject(method_types);
-          if (method_types != new_method_types) {
-            dex_cache->SetResolvedMethodTypes(new_method_types);
-          }
-          dex_cache->FixupResolvedMethodTypes<kWithoutReadBarrier>(new_method_types, fixup_adapter);
+      mirror::MethodTypeDexCacheType* method_types = dex_cache->GetResolvedMethodTypes();
+      if (method_types != nullptr) {
+        mirror::MethodTypeDexCacheType* new_method_types =
+            fixup_adapter.ForwardObject(method_types);
+        if (method_types != new_method_types) {
+          dex_cache->SetResolvedMethodTypes(new_method_types);
         }
-        GcRoot<mirror::CallSite>* call_sites = dex_cache->GetResolvedCallSites();
-        if (call_sites != nullptr) {
-          GcRoot<mirror::CallSite>* new_call_sites = fixup_adapter.ForwardObject(call_sites);
-          if (call_sites != new_call_sites) {
-            dex_cache->SetResolvedCallSites(new_call_sites);
-          }
-          dex_cache->FixupResolvedCallSites<kWithoutReadBarrier>(new_call_sites, fixup_adapter);
+        dex_cache->FixupResolvedMethodTypes<kWithoutReadBarrier>(new_method_types, fixup_adapter);
+      }
+      GcRoot<mirror::CallSite>* call_sites = dex_cache->GetResolvedCallSites();
+      if (call_sites != nullptr) {
+        GcRoot<mirror::CallSite>* new_call_sites = fixup_adapter.ForwardObject(call_sites);
+        if (call_sites != new_call_sites) {
+          dex_cache->SetResolvedCallSites(new_call_sites);
         }
+        dex_cache->FixupResolvedCallSites<kWithoutReadBarrier>(new_call_sites, fixup_adapter);
       }
     }
-    {
+  }
+
+  // Fix up the ArtMethods of an image mapped at target_base and, if fixup_image, the ArtFields,
+  // IMTs and IMT conflict tables. The entrypoints of the methods are only fixed up if fixup_code.
+  // The methods and fields are independent of each other, they are split between the calling
+  // thread and `num_threads` workers if `num_threads` is not zero.
+  static void FixupNativeStructures(const ImageHeader& image_header,
+                                    uint8_t* target_base,
+                                    bool fixup_image,
+                                    bool fixup_code,
+                                    PointerSize pointer_size,
+                                    const FixupVisitor& ranges,
+                                    size_t num_threads,
+                                    TimingLogger* logger) {
+    std::unique_ptr<ThreadPool> thread_pool;
+    if (num_threads != 0u) {
+      TimingLogger::ScopedTiming timing("Create fixup thread pool", logger);
+      thread_pool.reset(new ThreadPool("Image fixup thread pool", num_threads));
+      thread_pool->StartWorkers(Thread::Current());
+    }
+    if (fixup_image || fixup_code) {
       // Only touches objects in the app image, no need for mutator lock.
-      TimingLogger::ScopedTiming timing("Fixup methods", &logger);
-      FixupArtMethodVisitor method_visitor(fixup_image,
-                                           pointer_size,
-                                           boot_image,
-                                           boot_oat,
-                                           app_image,
-                                           app_oat);
-      image_header.VisitPackedArtMethods(&method_visitor, target_base, pointer_size);
+      TimingLogger::ScopedTiming timing("Fixup methods", logger);
+      FixupArtMethodVisitor method_visitor(fixup_image, fixup_code, pointer_size, ranges);
+      VisitPackedArrays<ArtMethod>(image_header.GetMethodsSection(),
+                                   target_base,
+                                   ArtMethod::Size(pointer_size),
+                                   ArtMethod::Alignment(pointer_size),
+                                   &method_visitor,
+                                   thread_pool.get());
+      const ImageSection& runtime_methods = image_header.GetRuntimeMethodsSection();
+      for (size_t pos = 0; pos < runtime_methods.Size(); pos += ArtMethod::Size(pointer_size)) {
+        method_visitor.Visit(
+            reinterpret_cast<ArtMethod*>(target_base + runtime_methods.Offset() + pos));
+      }
     }
     if (fixup_image) {
       {
         // Only touches objects in the app image, no need for mutator lock.
-        TimingLogger::ScopedTiming timing("Fixup fields", &logger);
-        FixupArtFieldVisitor field_visitor(boot_image, boot_oat, app_image, app_oat);
-        image_header.VisitPackedArtFields(&field_visitor, target_base);
+        TimingLogger::ScopedTiming timing("Fixup fields", logger);
+        FixupArtFieldVisitor field_visitor(ranges);
+        VisitPackedArrays<ArtField>(image_header.GetFieldsSection(),
+                                    target_base,
+                                    sizeof(ArtField),
+                                    alignof(ArtField),
+                                    &field_visitor,
+                                    thread_pool.get());
       }
+      FixupObjectAdapter fixup_adapter(ranges);
       {
-        TimingLogger::ScopedTiming timing("Fixup imt", &logger);
+        TimingLogger::ScopedTiming timing("Fixup imt", logger);
         image_header.VisitPackedImTables(fixup_adapter, target_base, pointer_size);
       }
       {
-        TimingLogger::ScopedTiming timing("Fixup conflict tables", &logger);
+        TimingLogger::ScopedTiming timing("Fixup conflict tables", logger);
         image_header.VisitPackedImtConflictTables(fixup_adapter, target_base, pointer_size);
       }
-      // In the app image case, the image methods are actually in the boot image.
-      image_header.RelocateImageMethods(boot_image.Delta());
-      const auto& class_table_section = image_header.GetImageSection(ImageHeader::kSectionClassTable);
-      if (class_table_section.Size() > 0u) {
-        // Note that we require that ReadFromMemory does not make an internal copy of the elements.
-        // This also relies on visit roots not doing any verification which could fail after we update
-        // the roots to be the image addresses.
-        ScopedObjectAccess soa(Thread::Current());
-        WriterMutexLock mu(Thread::Current(), *Locks::classlinker_classes_lock_);
-        ClassTable temp_table;
-        temp_table.ReadFromMemory(target_base + class_table_section.Offset());
-        FixupRootVisitor root_visitor(boot_image, boot_oat, app_image, app_oat);
-        temp_table.VisitRoots(root_visitor);
-      }
     }
-    if (VLOG_IS_ON(image)) {
-      logger.Dump(LOG_STREAM(INFO));
+  }
+
+  static void FixupClassTable(const ImageHeader& image_header,
+                              uint8_t* target_base,
+                              const FixupVisitor& ranges)
+      REQUIRES_SHARED(Locks::mutator_lock_) {
+    const auto& class_table_section = image_header.GetImageSection(ImageHeader::kSectionClassTable);
+    if (class_table_section.Size() > 0u) {
+      // Note that we require that ReadFromMemory does not make an internal copy of the elements.
+      // This also relies on visit roots not doing any verification which could fail after we update
+      // the roots to be the image addresses.
+      WriterMutexLock mu(Thread::Current(), *Locks::classlinker_classes_lock_);
+      ClassTable temp_table;
+      temp_table.ReadFromMemory(target_base + class_table_section.Offset());
+      FixupRootVisitor root_visitor(ranges);
+      temp_table.VisitRoots(root_visitor);
+    }
+  }
+
+  // Only boot images have an intern table that refers to the image.
+  static void FixupInternTable(const ImageHeader& image_header,
+                               uint8_t* target_base,
+                               const FixupVisitor& ranges)
+      REQUIRES_SHARED(Locks::mutator_lock_) {
+    const auto& section = image_header.GetImageSection(ImageHeader::kSectionInternedStrings);
+    if (section.Size() > 0u) {
+      FixupInternRootVisitor root_visitor(ranges);
+      InternTable::VisitRootsInMemory(target_base + section.Offset(), &root_visitor);
     }
-    return true;
   }
 
   static std::unique_ptr<OatFile> OpenOatFile(const ImageSpace& image,
@@ -1453,6 +1791,7 @@ static bool CheckSpace(const std::string& cache_filename, std::string* error_msg
 std::unique_ptr<ImageSpace> ImageSpace::CreateBootImage(const char* image_location,
                                                         const InstructionSet image_isa,
                                                         bool secondary_image,
+                                                        int32_t* relocation_delta,
                                                         std::string* error_msg) {
   ScopedTrace trace(__FUNCTION__);
 
@@ -1507,6 +1846,24 @@ std::unique_ptr<ImageSpace> ImageSpace::CreateBootImage(const char* image_locati
     }
   }
 
+  // Step 0.c: If the primary image was relocated in place, load the secondary image from
+  //           /system at the same delta. The cache cannot have a matching image.
+  if (*relocation_delta != 0) {
+    DCHECK(secondary_image);
+    if (!found_image || !has_system) {
+      *error_msg = StringPrintf("Cannot relocate image %s in place: no image in /system",
+                                image_location);
+      return nullptr;
+    }
+    return ImageSpaceLoader::Load(image_location,
+                                  system_filename,
+                                  is_zygote,
+                                  is_global_cache,
+                                  /* validate_oat_file */ false,
+                                  *relocation_delta,
+                                  error_msg);
+  }
+
   // Collect all the errors.
   std::vector<std::string> error_msgs;
 
@@ -1523,6 +1880,7 @@ std::unique_ptr<ImageSpace> ImageSpace::CreateBootImage(const char* image_locati
                                  is_zygote,
                                  is_global_cache,
                                  /* validate_oat_file */ false,
+                                 /* relocation_delta */ 0,
                                  &local_error_msg);
       if (relocated_space != nullptr) {
         return relocated_space;
@@ -1540,6 +1898,7 @@ std::unique_ptr<ImageSpace> ImageSpace::CreateBootImage(const char* image_locati
                                is_zygote,
                                is_global_cache,
                                /* validate_oat_file */ true,
+                               /* relocation_delta */ 0,
                                &local_error_msg);
     if (cache_space != nullptr) {
       return cache_space;
@@ -1560,6 +1919,7 @@ std::unique_ptr<ImageSpace> ImageSpace::CreateBootImage(const char* image_locati
                                is_zygote,
                                is_global_cache,
                                /* validate_oat_file */ false,
+                               /* relocation_delta */ 0,
                                &local_error_msg);
     if (system_space != nullptr) {
       return system_space;
@@ -1567,7 +1927,42 @@ std::unique_ptr<ImageSpace> ImageSpace::CreateBootImage(const char* image_locati
     error_msgs.push_back(local_error_msg);
   }
 
-  // Step 2.b: We require a relocated image. Then we must patch it. This step fails if this is a
+  // Step 2.b: We require a relocated image. If the image was compiled as PIC and relocation in
+  //           place is enabled, map it at a random delta and fix it up in memory. The secondary
+  //           images follow at the same delta, see Step 0.c, and LoadBootImage fixes up the
+  //           contents once they are all mapped.
+  if (found_image && has_system && relocate && !secondary_image &&
+      Runtime::Current()->ShouldRelocateInPlace()) {
+    std::string local_error_msg;
+    std::unique_ptr<ImageHeader> system_header(
+        ReadSpecificImageHeader(system_filename.c_str(), &local_error_msg));
+    if (system_header != nullptr && !system_header->CompilePic()) {
+      local_error_msg = "Image is not compiled as PIC.";
+    } else if (system_header != nullptr) {
+      // A zero delta would mean the image is not relocated in place.
+      int32_t delta;
+      do {
+        delta = ChooseRelocationOffsetDelta();
+      } while (delta == 0);
+      std::unique_ptr<ImageSpace> relocated_space =
+          ImageSpaceLoader::Load(image_location,
+                                 system_filename,
+                                 is_zygote,
+                                 is_global_cache,
+                                 /* validate_oat_file */ false,
+                                 delta,
+                                 &local_error_msg);
+      if (relocated_space != nullptr) {
+        *relocation_delta = delta;
+        return relocated_space;
+      }
+    }
+    error_msgs.push_back(StringPrintf("Cannot relocate image %s in place: %s",
+                                      image_location,
+                                      local_error_msg.c_str()));
+  }
+
+  // Step 2.c: We require a relocated image. Then we must patch it. This step fails if this is a
   //           secondary image.
   if (found_image && has_system && relocate) {
     std::string local_error_msg;
@@ -1585,6 +1980,7 @@ std::unique_ptr<ImageSpace> ImageSpace::CreateBootImage(const char* image_locati
                                    is_zygote,
                                    is_global_cache,
                                    /* validate_oat_file */ false,
+                                   /* relocation_delta */ 0,
                                    &local_error_msg);
         if (patched_space != nullptr) {
           return patched_space;
@@ -1614,6 +2010,7 @@ std::unique_ptr<ImageSpace> ImageSpace::CreateBootImage(const char* image_locati
                                    is_zygote,
                                    is_global_cache,
                                    /* validate_oat_file */ false,
+                                   /* relocation_delta */ 0,
                                    &local_error_msg);
         if (compiled_space != nullptr) {
           return compiled_space;
@@ -1661,6 +2058,8 @@ bool ImageSpace::LoadBootImage(const std::string& image_file_name,
 
   bool error = false;
   uint8_t* oat_file_end_tmp = *oat_file_end;
+  // Non-zero if the images are relocated in place, see CreateBootImage.
+  int32_t relocation_delta = 0;
 
   for (size_t index = 0; index < image_file_names.size(); ++index) {
     std::string& image_name = image_file_names[index];
@@ -1669,6 +2068,7 @@ bool ImageSpace::LoadBootImage(const std::string& image_file_name,
         image_name.c_str(),
         image_instruction_set,
         index > 0,
+        &relocation_delta,
         &error_msg);
     if (boot_image_space_uptr != nullptr) {
       space::ImageSpace* boot_image_space = boot_image_space_uptr.release();
@@ -1704,6 +2104,17 @@ bool ImageSpace::LoadBootImage(const std::string& image_file_name,
     }
   }
 
+  if (!error && relocation_delta != 0) {
+    std::string error_msg;
+    if (!ImageSpaceLoader::RelocateBootImagesInPlace(*boot_image_spaces,
+                                                     relocation_delta,
+                                                     &error_msg)) {
+      error = true;
+      LOG(ERROR) << "Could not relocate boot image '" << image_file_name << "' in place. "
+          << "Attempting to fall back to imageless running. Error was: " << error_msg;
+    }
+  }
+
   if (error) {
     // Remove already loaded spaces.
     for (space::Space* loaded_space : *boot_image_spaces) {
@@ -1747,6 +2158,7 @@ std::unique_ptr<ImageSpace> ImageSpace::CreateFromAppImage(const char* image,
                                 image,
                                 /*validate_oat_file*/false,
                                 oat_file,
+                                /*relocation_delta*/0,
                                 /*out*/error_msg);
 }
 
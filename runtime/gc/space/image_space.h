@@ -209,9 +209,14 @@ class ImageSpace : public MemMapSpace {
   // creation of the alloc space. The ReleaseOatFile will later be
   // used to transfer ownership of the OatFile to the ClassLinker when
   // it is initialized.
+  //
+  // relocation_delta is shared by the images of a boot image. It is set by
+  // the primary image if it gets relocated in place, and secondary images
+  // are then mapped at the same delta.
   static std::unique_ptr<ImageSpace> CreateBootImage(const char* image,
                                      InstructionSet image_isa,
                                      bool secondary_image,
+                                     int32_t* relocation_delta,
                                      std::string* error_msg)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
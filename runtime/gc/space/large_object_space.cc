@@ -32,6 +32,7 @@
 #include "scoped_thread_state_change-inl.h"
 #include "space-inl.h"
 #include "thread-current-inl.h"
+#include "utils.h"
 
 namespace art {
 namespace gc {
@@ -571,6 +572,320 @@ void FreeListSpace::SetAllLargeObjectsAsZygoteObjects(Thread* self) {
   }
 }
 
+SegregatedFitSpace* SegregatedFitSpace::Create(const std::string& name,
+                                               uint8_t* requested_begin,
+                                               size_t capacity) {
+  CHECK_EQ(capacity % kAlignment, 0U);
+  CHECK_LT(capacity / kAlignment, static_cast<size_t>(kNoPage));
+  std::string error_msg;
+  MemMap* mem_map = MemMap::MapAnonymous(name.c_str(), requested_begin, capacity,
+                                         PROT_READ | PROT_WRITE, true, false, &error_msg);
+  CHECK(mem_map != nullptr) << "Failed to allocate large object space mem map: " << error_msg;
+  return new SegregatedFitSpace(name, mem_map, mem_map->Begin(), mem_map->End());
+}
+
+SegregatedFitSpace::SegregatedFitSpace(const std::string& name,
+                                       MemMap* mem_map,
+                                       uint8_t* begin,
+                                       uint8_t* end)
+    : LargeObjectSpace(name, begin, end),
+      mem_map_(mem_map),
+      page_runs_(nullptr),
+      pending_pages_(nullptr),
+      num_pages_((end - begin) / kAlignment),
+      lock_("segregated fit space lock", kAllocSpaceLock),
+      non_empty_size_classes_(0),
+      pending_release_bytes_(0),
+      total_released_bytes_(0) {
+  CHECK_ALIGNED(end - begin, kAlignment);
+  CHECK_GT(num_pages_, 0U);
+  std::string error_msg;
+  page_run_map_.reset(MemMap::MapAnonymous("large object segregated fit space page run map",
+                                           nullptr, sizeof(PageRun) * num_pages_,
+                                           PROT_READ | PROT_WRITE, false, false, &error_msg));
+  CHECK(page_run_map_.get() != nullptr) << "Failed to allocate page run map" << error_msg;
+  page_runs_ = reinterpret_cast<PageRun*>(page_run_map_->Begin());
+  const size_t num_pending_words = RoundUp(num_pages_, kPagesPerPendingWord) /
+      kPagesPerPendingWord;
+  pending_pages_map_.reset(MemMap::MapAnonymous("large object segregated fit space pending pages",
+                                                nullptr, sizeof(uint64_t) * num_pending_words,
+                                                PROT_READ | PROT_WRITE, false, false,
+                                                &error_msg));
+  CHECK(pending_pages_map_.get() != nullptr) << "Failed to allocate pending page bitmap"
+      << error_msg;
+  pending_pages_ = reinterpret_cast<uint64_t*>(pending_pages_map_->Begin());
+  std::fill_n(free_list_heads_, kNumSizeClasses, kNoPage);
+  // The whole space starts as one free run.
+  MutexLock mu(Thread::Current(), lock_);
+  InsertFreeRun(0, num_pages_);
+}
+
+SegregatedFitSpace::~SegregatedFitSpace() {}
+
+void SegregatedFitSpace::SetRun(size_t page, size_t num_pages, uint32_t flags) {
+  DCHECK_NE(num_pages, 0U);
+  DCHECK_LE(page + num_pages, num_pages_);
+  page_runs_[page] = PageRun { static_cast<uint32_t>(num_pages), flags, kNoPage, kNoPage };
+  PageRun* last = &page_runs_[page + num_pages - 1];
+  last->num_pages = static_cast<uint32_t>(num_pages);
+  last->flags = flags;
+}
+
+void SegregatedFitSpace::InsertFreeRun(size_t page, size_t num_pages) {
+  SetRun(page, num_pages, kFlagFree);
+  const size_t size_class = SizeClassOf(num_pages);
+  PageRun* run = &page_runs_[page];
+  run->next_free = free_list_heads_[size_class];
+  if (run->next_free != kNoPage) {
+    page_runs_[run->next_free].prev_free = static_cast<uint32_t>(page);
+  }
+  free_list_heads_[size_class] = static_cast<uint32_t>(page);
+  non_empty_size_classes_ |= 1U << size_class;
+}
+
+void SegregatedFitSpace::RemoveFreeRun(size_t page) {
+  const PageRun& run = page_runs_[page];
+  DCHECK_NE(run.flags & kFlagFree, 0U);
+  const size_t size_class = SizeClassOf(run.num_pages);
+  if (run.prev_free != kNoPage) {
+    page_runs_[run.prev_free].next_free = run.next_free;
+  } else {
+    DCHECK_EQ(free_list_heads_[size_class], page);
+    free_list_heads_[size_class] = run.next_free;
+    if (run.next_free == kNoPage) {
+      non_empty_size_classes_ &= ~(1U << size_class);
+    }
+  }
+  if (run.next_free != kNoPage) {
+    page_runs_[run.next_free].prev_free = run.prev_free;
+  }
+}
+
+size_t SegregatedFitSpace::FindFreeRun(size_t num_pages) {
+  // Every run in a size class above the one of num_pages fits.
+  const size_t size_class = SizeClassOf(num_pages);
+  const size_t min_fit_class = IsPowerOfTwo(num_pages) ? size_class : size_class + 1;
+  if (min_fit_class < kNumSizeClasses) {
+    const uint32_t fit_classes = non_empty_size_classes_ & ~((1U << min_fit_class) - 1);
+    if (fit_classes != 0) {
+      return free_list_heads_[CTZ(fit_classes)];
+    }
+  }
+  // Otherwise fall back to a first fit in the size class of num_pages, which also holds smaller
+  // runs.
+  for (size_t page = free_list_heads_[size_class]; page != kNoPage;
+       page = page_runs_[page].next_free) {
+    if (page_runs_[page].num_pages >= num_pages) {
+      return page;
+    }
+  }
+  return kNoPage;
+}
+
+void SegregatedFitSpace::SetPendingPages(size_t begin, size_t end, bool pending) {
+  while (begin < end) {
+    const size_t bit = begin % kPagesPerPendingWord;
+    const size_t count = std::min(kPagesPerPendingWord - bit, end - begin);
+    const uint64_t mask = (count == kPagesPerPendingWord)
+        ? ~UINT64_C(0)
+        : ((UINT64_C(1) << count) - 1) << bit;
+    if (pending) {
+      pending_pages_[begin / kPagesPerPendingWord] |= mask;
+    } else {
+      pending_pages_[begin / kPagesPerPendingWord] &= ~mask;
+    }
+    begin += count;
+  }
+}
+
+template <typename Visitor>
+void SegregatedFitSpace::VisitPendingPages(size_t begin, size_t end, const Visitor& visitor) {
+  auto is_pending = [this](size_t page) {
+    return (pending_pages_[page / kPagesPerPendingWord] &
+            (UINT64_C(1) << (page % kPagesPerPendingWord))) != 0;
+  };
+  size_t page = begin;
+  while (page < end) {
+    const uint64_t word = pending_pages_[page / kPagesPerPendingWord] >>
+        (page % kPagesPerPendingWord);
+    if (word == 0) {
+      // Skip the rest of the word.
+      page = RoundUp(page + 1, kPagesPerPendingWord);
+      continue;
+    }
+    page += CTZ(word);
+    if (page >= end) {
+      break;
+    }
+    size_t run_end = page + 1;
+    while (run_end < end && is_pending(run_end)) {
+      ++run_end;
+    }
+    visitor(page, run_end);
+    page = run_end;
+  }
+}
+
+void SegregatedFitSpace::ZeroPendingPages(size_t page, size_t num_pages) {
+  // The pages were not released so they may still hold the contents of a freed object.
+  VisitPendingPages(page, page + num_pages, [this](size_t run_begin, size_t run_end)
+      REQUIRES(lock_) {
+    const size_t bytes = (run_end - run_begin) * kAlignment;
+    memset(PageAddress(run_begin), 0, bytes);
+    DCHECK_GE(pending_release_bytes_, bytes);
+    pending_release_bytes_ -= bytes;
+  });
+  SetPendingPages(page, page + num_pages, false);
+}
+
+size_t SegregatedFitSpace::ReleasePendingPagesLocked() {
+  size_t released_bytes = 0;
+  VisitPendingPages(0, num_pages_, [this, &released_bytes](size_t run_begin, size_t run_end) {
+    const size_t bytes = (run_end - run_begin) * kAlignment;
+    madvise(PageAddress(run_begin), bytes, MADV_DONTNEED);
+    released_bytes += bytes;
+  });
+  DCHECK_EQ(released_bytes, pending_release_bytes_);
+  SetPendingPages(0, num_pages_, false);
+  pending_release_bytes_ = 0;
+  total_released_bytes_ += released_bytes;
+  return released_bytes;
+}
+
+size_t SegregatedFitSpace::ReleasePendingPages(Thread* self) {
+  MutexLock mu(self, lock_);
+  return ReleasePendingPagesLocked();
+}
+
+mirror::Object* SegregatedFitSpace::Alloc(Thread* self, size_t num_bytes, size_t* bytes_allocated,
+                                          size_t* usable_size, size_t* bytes_tl_bulk_allocated) {
+  const size_t allocation_size = RoundUp(std::max<size_t>(num_bytes, 1U), kAlignment);
+  const size_t num_pages = allocation_size / kAlignment;
+  MutexLock mu(self, lock_);
+  const size_t page = FindFreeRun(num_pages);
+  if (UNLIKELY(page == kNoPage)) {
+    return nullptr;
+  }
+  const size_t free_pages = page_runs_[page].num_pages;
+  DCHECK_GE(free_pages, num_pages);
+  RemoveFreeRun(page);
+  if (free_pages > num_pages) {
+    // Put the remainder back into the free lists.
+    InsertFreeRun(page + num_pages, free_pages - num_pages);
+  }
+  SetRun(page, num_pages, 0U);
+  ZeroPendingPages(page, num_pages);
+  DCHECK(bytes_allocated != nullptr);
+  *bytes_allocated = allocation_size;
+  if (usable_size != nullptr) {
+    *usable_size = allocation_size;
+  }
+  DCHECK(bytes_tl_bulk_allocated != nullptr);
+  *bytes_tl_bulk_allocated = allocation_size;
+  ++num_objects_allocated_;
+  ++total_objects_allocated_;
+  num_bytes_allocated_ += allocation_size;
+  total_bytes_allocated_ += allocation_size;
+  return reinterpret_cast<mirror::Object*>(PageAddress(page));
+}
+
+size_t SegregatedFitSpace::Free(Thread* self, mirror::Object* obj) {
+  MutexLock mu(self, lock_);
+  DCHECK(Contains(obj)) << reinterpret_cast<void*>(Begin()) << " " << obj << " "
+                        << reinterpret_cast<void*>(End());
+  DCHECK_ALIGNED(obj, kAlignment);
+  const size_t page = PageIndexOf(obj);
+  DCHECK_EQ(page_runs_[page].flags & kFlagFree, 0U);
+  const size_t num_pages = page_runs_[page].num_pages;
+  const size_t allocation_size = num_pages * kAlignment;
+  SetPendingPages(page, page + num_pages, true);
+  pending_release_bytes_ += allocation_size;
+  // Coalesce with the neighboring free runs, found through their boundary tags.
+  size_t free_begin = page;
+  size_t free_pages = num_pages;
+  if (page > 0 && (page_runs_[page - 1].flags & kFlagFree) != 0) {
+    const size_t prev_pages = page_runs_[page - 1].num_pages;
+    free_begin -= prev_pages;
+    free_pages += prev_pages;
+    RemoveFreeRun(free_begin);
+  }
+  const size_t next = page + num_pages;
+  if (next < num_pages_ && (page_runs_[next].flags & kFlagFree) != 0) {
+    free_pages += page_runs_[next].num_pages;
+    RemoveFreeRun(next);
+  }
+  InsertFreeRun(free_begin, free_pages);
+  --num_objects_allocated_;
+  DCHECK_LE(allocation_size, num_bytes_allocated_);
+  num_bytes_allocated_ -= allocation_size;
+  if (pending_release_bytes_ >= kReleaseBatchBytes) {
+    ReleasePendingPagesLocked();
+  }
+  return allocation_size;
+}
+
+size_t SegregatedFitSpace::AllocationSize(mirror::Object* obj, size_t* usable_size) {
+  MutexLock mu(Thread::Current(), lock_);
+  const PageRun& run = page_runs_[PageIndexOf(obj)];
+  DCHECK_EQ(run.flags & kFlagFree, 0U);
+  size_t alloc_size = run.num_pages * kAlignment;
+  if (usable_size != nullptr) {
+    *usable_size = alloc_size;
+  }
+  return alloc_size;
+}
+
+void SegregatedFitSpace::Walk(DlMallocSpace::WalkCallback callback, void* arg) {
+  MutexLock mu(Thread::Current(), lock_);
+  for (size_t page = 0; page < num_pages_; page += page_runs_[page].num_pages) {
+    if ((page_runs_[page].flags & kFlagFree) == 0) {
+      size_t alloc_size = page_runs_[page].num_pages * kAlignment;
+      uint8_t* byte_start = PageAddress(page);
+      callback(byte_start, byte_start + alloc_size, alloc_size, arg);
+      callback(nullptr, nullptr, 0, arg);
+    }
+  }
+}
+
+void SegregatedFitSpace::Dump(std::ostream& os) const {
+  MutexLock mu(Thread::Current(), lock_);
+  os << GetName() << " -"
+     << " begin: " << reinterpret_cast<void*>(Begin())
+     << " end: " << reinterpret_cast<void*>(End())
+     << " pending release: " << PrettySize(pending_release_bytes_)
+     << " total released: " << PrettySize(total_released_bytes_) << "\n";
+  for (size_t page = 0; page < num_pages_; page += page_runs_[page].num_pages) {
+    size_t size = page_runs_[page].num_pages * kAlignment;
+    const void* address = PageAddress(page);
+    if ((page_runs_[page].flags & kFlagFree) != 0) {
+      os << "Free block at address: " << address << " of length " << size << " bytes\n";
+    } else {
+      os << "Large object at address: " << address << " of length " << size << " bytes\n";
+    }
+  }
+}
+
+bool SegregatedFitSpace::IsZygoteLargeObject(Thread* self, mirror::Object* obj) const {
+  MutexLock mu(self, lock_);
+  const PageRun& run = page_runs_[PageIndexOf(obj)];
+  DCHECK_EQ(run.flags & kFlagFree, 0U);
+  return (run.flags & kFlagZygote) != 0;
+}
+
+void SegregatedFitSpace::SetAllLargeObjectsAsZygoteObjects(Thread* self) {
+  MutexLock mu(self, lock_);
+  for (size_t page = 0; page < num_pages_; page += page_runs_[page].num_pages) {
+    if ((page_runs_[page].flags & kFlagFree) == 0) {
+      page_runs_[page].flags |= kFlagZygote;
+    }
+  }
+}
+
+std::pair<uint8_t*, uint8_t*> SegregatedFitSpace::GetBeginEndAtomic() const {
+  MutexLock mu(Thread::Current(), lock_);
+  return std::make_pair(Begin(), End());
+}
+
 void LargeObjectSpace::SweepCallback(size_t num_ptrs, mirror::Object** ptrs, void* arg) {
   SweepCallbackContext* context = static_cast<SweepCallbackContext*>(arg);
   space::LargeObjectSpace* space = context->space->AsLargeObjectSpace();
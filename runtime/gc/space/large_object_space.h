@@ -18,6 +18,7 @@
 #define ART_RUNTIME_GC_SPACE_LARGE_OBJECT_SPACE_H_
 
 #include "base/allocator.h"
+#include "base/bit_utils.h"
 #include "dlmalloc_space.h"
 #include "safe_map.h"
 #include "space.h"
@@ -35,6 +36,7 @@ enum class LargeObjectSpaceType {
   kDisabled,
   kMap,
   kFreeList,
+  kSegregatedFit,
 };
 
 // Abstraction implemented by all large object spaces.
@@ -220,6 +222,97 @@ class FreeListSpace FINAL : public LargeObjectSpace {
   FreeBlocks free_blocks_ GUARDED_BY(lock_);
 };
 
+// A continuous large object space which keeps its free page runs in power-of-two size classes.
+// Allocation takes the first run of the smallest non-empty class that is guaranteed to fit and
+// freeing coalesces with the neighboring runs through boundary tags, so both are constant time
+// except for the rare fallback search. The pages of freed objects are released to the kernel in
+// batches instead of with one madvise per free.
+class SegregatedFitSpace FINAL : public LargeObjectSpace {
+ public:
+  static constexpr size_t kAlignment = kPageSize;
+  // Release the pages of freed objects once this many bytes of them are pending.
+  static constexpr size_t kReleaseBatchBytes = 4 * MB;
+
+  virtual ~SegregatedFitSpace();
+  static SegregatedFitSpace* Create(const std::string& name,
+                                    uint8_t* requested_begin,
+                                    size_t capacity);
+  size_t AllocationSize(mirror::Object* obj, size_t* usable_size) OVERRIDE REQUIRES(!lock_);
+  mirror::Object* Alloc(Thread* self, size_t num_bytes, size_t* bytes_allocated,
+                        size_t* usable_size, size_t* bytes_tl_bulk_allocated)
+      OVERRIDE REQUIRES(!lock_);
+  size_t Free(Thread* self, mirror::Object* obj) OVERRIDE REQUIRES(!lock_);
+  void Walk(DlMallocSpace::WalkCallback callback, void* arg) OVERRIDE REQUIRES(!lock_);
+  void Dump(std::ostream& os) const REQUIRES(!lock_);
+  // Release the pages of all the freed objects now. Returns the number of bytes released.
+  size_t ReleasePendingPages(Thread* self) REQUIRES(!lock_);
+
+  std::pair<uint8_t*, uint8_t*> GetBeginEndAtomic() const OVERRIDE REQUIRES(!lock_);
+
+ protected:
+  SegregatedFitSpace(const std::string& name, MemMap* mem_map, uint8_t* begin, uint8_t* end);
+  bool IsZygoteLargeObject(Thread* self, mirror::Object* obj) const OVERRIDE REQUIRES(!lock_);
+  void SetAllLargeObjectsAsZygoteObjects(Thread* self) OVERRIDE REQUIRES(!lock_);
+
+ private:
+  // One per page. Only the entries of the first and the last page of a run are valid. The free
+  // list links are only valid in the first page of a free run.
+  struct PageRun {
+    uint32_t num_pages;
+    uint32_t flags;
+    uint32_t prev_free;
+    uint32_t next_free;
+  };
+  static constexpr uint32_t kFlagFree = 0x1;
+  static constexpr uint32_t kFlagZygote = 0x2;
+  static constexpr uint32_t kNoPage = 0xFFFFFFFF;
+  // Free run of [2^k, 2^(k+1)) pages are in size class k.
+  static constexpr size_t kNumSizeClasses = 32;
+  static constexpr size_t kPagesPerPendingWord = BitSizeOf<uint64_t>();
+
+  static size_t SizeClassOf(size_t num_pages) {
+    DCHECK_NE(num_pages, 0U);
+    return static_cast<size_t>(MostSignificantBit(num_pages));
+  }
+  size_t PageIndexOf(const mirror::Object* obj) const {
+    DCHECK(Contains(obj));
+    return (reinterpret_cast<const uint8_t*>(obj) - Begin()) / kAlignment;
+  }
+  uint8_t* PageAddress(size_t page) const {
+    return Begin() + page * kAlignment;
+  }
+  // Writes the boundary tags of the run [page, page + num_pages).
+  void SetRun(size_t page, size_t num_pages, uint32_t flags) REQUIRES(lock_);
+  void InsertFreeRun(size_t page, size_t num_pages) REQUIRES(lock_);
+  void RemoveFreeRun(size_t page) REQUIRES(lock_);
+  // Returns the first page of a free run of at least num_pages pages, or kNoPage.
+  size_t FindFreeRun(size_t num_pages) REQUIRES(lock_);
+  void SetPendingPages(size_t begin, size_t end, bool pending) REQUIRES(lock_);
+  // Calls visitor(run_begin, run_end) for each run of pending pages in [begin, end).
+  template <typename Visitor>
+  void VisitPendingPages(size_t begin, size_t end, const Visitor& visitor) REQUIRES(lock_);
+  // Zeroes the pending pages in [page, page + num_pages) and takes them out of the pending set.
+  void ZeroPendingPages(size_t page, size_t num_pages) REQUIRES(lock_);
+  size_t ReleasePendingPagesLocked() REQUIRES(lock_);
+
+  std::unique_ptr<MemMap> mem_map_;
+  // Side table of PageRun, one per page.
+  std::unique_ptr<MemMap> page_run_map_;
+  PageRun* page_runs_;
+  // Bitmap of the free pages not returned to the kernel yet, one bit per page.
+  std::unique_ptr<MemMap> pending_pages_map_;
+  uint64_t* pending_pages_;
+  const size_t num_pages_;
+
+  mutable Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  // The first free run of each size class.
+  uint32_t free_list_heads_[kNumSizeClasses] GUARDED_BY(lock_);
+  // Bit k is set when size class k has a free run.
+  uint32_t non_empty_size_classes_ GUARDED_BY(lock_);
+  size_t pending_release_bytes_ GUARDED_BY(lock_);
+  uint64_t total_released_bytes_ GUARDED_BY(lock_);
+};
+
 }  // namespace space
 }  // namespace gc
 }  // namespace art
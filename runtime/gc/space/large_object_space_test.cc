@@ -29,19 +29,23 @@ class LargeObjectSpaceTest : public SpaceTest<CommonRuntimeTest> {
   static constexpr size_t kNumThreads = 10;
   static constexpr size_t kNumIterations = 1000;
   void RaceTest();
+
+  void SpeedTest();
 };
 
 
 void LargeObjectSpaceTest::LargeObjectTest() {
   size_t rand_seed = 0;
   Thread* const self = Thread::Current();
-  for (size_t i = 0; i < 2; ++i) {
+  for (size_t i = 0; i < 3; ++i) {
     LargeObjectSpace* los = nullptr;
     const size_t capacity = 128 * MB;
     if (i == 0) {
       los = space::LargeObjectMapSpace::Create("large object space");
-    } else {
+    } else if (i == 1) {
       los = space::FreeListSpace::Create("large object space", nullptr, capacity);
+    } else {
+      los = space::SegregatedFitSpace::Create("large object space", nullptr, capacity);
     }
 
     // Make sure the bitmap is not empty and actually covers at least how much we expect.
@@ -151,12 +155,14 @@ class AllocRaceTask : public Task {
 };
 
 void LargeObjectSpaceTest::RaceTest() {
-  for (size_t los_type = 0; los_type < 2; ++los_type) {
+  for (size_t los_type = 0; los_type < 3; ++los_type) {
     LargeObjectSpace* los = nullptr;
     if (los_type == 0) {
       los = space::LargeObjectMapSpace::Create("large object space");
-    } else {
+    } else if (los_type == 1) {
       los = space::FreeListSpace::Create("large object space", nullptr, 128 * MB);
+    } else {
+      los = space::SegregatedFitSpace::Create("large object space", nullptr, 128 * MB);
     }
 
     Thread* self = Thread::Current();
@@ -173,6 +179,59 @@ void LargeObjectSpaceTest::RaceTest() {
   }
 }
 
+// Allocates and frees byte array sized objects between 12KB and 1MB in a sliding window and logs
+// the average time per allocation and free of each space.
+void LargeObjectSpaceTest::SpeedTest() {
+  static constexpr size_t kNumLiveObjects = 64;
+  static constexpr size_t kNumAllocations = 20000;
+  static constexpr size_t kMinAllocationSize = 12 * KB;
+  static constexpr size_t kMaxAllocationSize = 1 * MB;
+  Thread* const self = Thread::Current();
+  for (size_t los_type = 0; los_type < 3; ++los_type) {
+    LargeObjectSpace* los = nullptr;
+    if (los_type == 0) {
+      los = space::LargeObjectMapSpace::Create("large object space");
+    } else if (los_type == 1) {
+      los = space::FreeListSpace::Create("large object space", nullptr, 256 * MB);
+    } else {
+      los = space::SegregatedFitSpace::Create("large object space", nullptr, 256 * MB);
+    }
+    size_t rand_seed = 0;
+    std::vector<mirror::Object*> live(kNumLiveObjects, nullptr);
+    uint64_t alloc_ns = 0;
+    uint64_t free_ns = 0;
+    size_t num_frees = 0;
+    for (size_t i = 0; i < kNumAllocations; ++i) {
+      mirror::Object*& slot = live[test_rand(&rand_seed) % kNumLiveObjects];
+      if (slot != nullptr) {
+        const uint64_t start = NanoTime();
+        los->Free(self, slot);
+        free_ns += NanoTime() - start;
+        ++num_frees;
+      }
+      const size_t request_size = kMinAllocationSize +
+          test_rand(&rand_seed) % (kMaxAllocationSize - kMinAllocationSize);
+      size_t bytes_allocated, bytes_tl_bulk_allocated;
+      const uint64_t start = NanoTime();
+      slot = los->Alloc(self, request_size, &bytes_allocated, nullptr, &bytes_tl_bulk_allocated);
+      alloc_ns += NanoTime() - start;
+      ASSERT_TRUE(slot != nullptr);
+      // Touch the object like a mutator initializing an array would.
+      reinterpret_cast<uint8_t*>(slot)[request_size - 1] = 1;
+    }
+    for (mirror::Object* obj : live) {
+      if (obj != nullptr) {
+        los->Free(self, obj);
+      }
+    }
+    EXPECT_EQ(0U, los->GetObjectsAllocated());
+    LOG(INFO) << los->GetName() << " type " << los_type
+              << ": alloc " << PrettyDuration(alloc_ns / kNumAllocations)
+              << " free " << PrettyDuration(free_ns / std::max<size_t>(num_frees, 1U));
+    delete los;
+  }
+}
+
 TEST_F(LargeObjectSpaceTest, LargeObjectTest) {
   LargeObjectTest();
 }
@@ -181,6 +240,10 @@ TEST_F(LargeObjectSpaceTest, RaceTest) {
   RaceTest();
 }
 
+TEST_F(LargeObjectSpaceTest, SpeedTest) {
+  SpeedTest();
+}
+
 }  // namespace space
 }  // namespace gc
 }  // namespace art
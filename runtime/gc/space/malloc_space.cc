@@ -29,6 +29,7 @@
 #include "handle_scope-inl.h"
 #include "thread.h"
 #include "thread_list.h"
+#include "thread_pool.h"
 #include "utils.h"
 
 namespace art {
@@ -252,6 +253,118 @@ void MallocSpace::SweepCallback(size_t num_ptrs, mirror::Object** ptrs, void* ar
   context->freed.bytes += space->FreeList(self, num_ptrs, ptrs);
 }
 
+// Objects freed per FreeList() call by the chunks of a parallel sweep. SweepWalk() hands out at
+// most a bitmap word worth of objects at a time, batching them up means fewer round trips through
+// the locks of the allocator.
+static constexpr size_t kParallelSweepFreeBatchSize = 4 * KB;
+// Smaller chunks are not worth handing to another thread.
+static constexpr size_t kMinParallelSweepChunkSize = 1 * MB;
+
+class MallocSpace::SweepChunkTask : public Task {
+ public:
+  SweepChunkTask(MallocSpace* space,
+                 bool swap_bitmaps,
+                 uintptr_t begin,
+                 uintptr_t end,
+                 collector::ObjectBytePair* freed)
+      : space_(space), swap_bitmaps_(swap_bitmaps), begin_(begin), end_(end), freed_(freed) {}
+
+  // The thread which requested the sweep holds the heap bitmap lock exclusively and waits for us,
+  // the chunks cover disjoint bitmap words.
+  void Run(Thread* self) OVERRIDE NO_THREAD_SAFETY_ANALYSIS {
+    accounting::ContinuousSpaceBitmap* live_bitmap = space_->GetLiveBitmap();
+    accounting::ContinuousSpaceBitmap* mark_bitmap = space_->GetMarkBitmap();
+    if (swap_bitmaps_) {
+      std::swap(live_bitmap, mark_bitmap);
+    }
+    batch_.reserve(kParallelSweepFreeBatchSize);
+    self_ = self;
+    accounting::ContinuousSpaceBitmap::SweepWalk(
+        *live_bitmap, *mark_bitmap, begin_, end_, &Callback, reinterpret_cast<void*>(this));
+    FreeBatch();
+  }
+
+  void Finalize() OVERRIDE {
+    delete this;
+  }
+
+ private:
+  static void Callback(size_t num_ptrs, mirror::Object** ptrs, void* arg)
+      NO_THREAD_SAFETY_ANALYSIS {
+    SweepChunkTask* task = reinterpret_cast<SweepChunkTask*>(arg);
+    // Same as MallocSpace::SweepCallback, the bits only need clearing if the bitmaps don't get
+    // swapped afterwards.
+    if (!task->swap_bitmaps_) {
+      accounting::ContinuousSpaceBitmap* bitmap = task->space_->GetLiveBitmap();
+      for (size_t i = 0; i < num_ptrs; ++i) {
+        bitmap->Clear(ptrs[i]);
+      }
+    }
+    task->batch_.insert(task->batch_.end(), ptrs, ptrs + num_ptrs);
+    if (task->batch_.size() >= kParallelSweepFreeBatchSize) {
+      task->FreeBatch();
+    }
+  }
+
+  void FreeBatch() NO_THREAD_SAFETY_ANALYSIS {
+    if (!batch_.empty()) {
+      freed_->objects += batch_.size();
+      freed_->bytes += space_->FreeList(self_, batch_.size(), batch_.data());
+      batch_.clear();
+    }
+  }
+
+  MallocSpace* const space_;
+  const bool swap_bitmaps_;
+  const uintptr_t begin_;
+  const uintptr_t end_;
+  collector::ObjectBytePair* const freed_;
+  Thread* self_ = nullptr;
+  std::vector<mirror::Object*> batch_;
+};
+
+collector::ObjectBytePair MallocSpace::SweepParallel(bool swap_bitmaps,
+                                                     ThreadPool* thread_pool,
+                                                     size_t thread_count) {
+  // If the bitmaps are bound then sweeping this space clearly won't do anything.
+  if (GetLiveBitmap() == GetMarkBitmap()) {
+    return collector::ObjectBytePair(0, 0);
+  }
+  const uintptr_t begin = reinterpret_cast<uintptr_t>(Begin());
+  const uintptr_t end = reinterpret_cast<uintptr_t>(End());
+  // Page aligned chunk boundaries never share a bitmap word, so the live bits can be cleared
+  // without atomics.
+  const size_t chunk_size =
+      RoundUp(std::max((end - begin + thread_count - 1) / thread_count, kMinParallelSweepChunkSize),
+              kPageSize);
+  const size_t chunk_count = (end - begin + chunk_size - 1) / chunk_size;
+  if (thread_pool == nullptr || chunk_count <= 1) {
+    return Sweep(swap_bitmaps);
+  }
+  Thread* self = Thread::Current();
+  std::vector<collector::ObjectBytePair> freed(chunk_count);
+  // The first chunk is swept by this thread while it waits.
+  for (size_t i = 1; i < chunk_count; ++i) {
+    const uintptr_t chunk_begin = begin + i * chunk_size;
+    thread_pool->AddTask(self, new SweepChunkTask(this,
+                                                  swap_bitmaps,
+                                                  chunk_begin,
+                                                  std::min(chunk_begin + chunk_size, end),
+                                                  &freed[i]));
+  }
+  thread_pool->SetMaxActiveWorkers(std::min(chunk_count - 1, thread_pool->GetThreadCount()));
+  thread_pool->StartWorkers(self);
+  SweepChunkTask first(this, swap_bitmaps, begin, begin + chunk_size, &freed[0]);
+  first.Run(self);
+  thread_pool->Wait(self, /* do_work */ true, /* may_hold_locks */ true);
+  thread_pool->StopWorkers(self);
+  collector::ObjectBytePair total;
+  for (const collector::ObjectBytePair& chunk_freed : freed) {
+    total.Add(chunk_freed);
+  }
+  return total;
+}
+
 void MallocSpace::ClampGrowthLimit() {
   size_t new_capacity = Capacity();
   CHECK_LE(new_capacity, NonGrowthLimitCapacity());
@@ -23,6 +23,9 @@
 #include "base/memory_tool.h"
 
 namespace art {
+
+class ThreadPool;
+
 namespace gc {
 
 namespace collector {
@@ -135,6 +138,14 @@ class MallocSpace : public ContinuousMemMapAllocSpace {
   virtual uint64_t GetBytesAllocated() = 0;
   virtual uint64_t GetObjectsAllocated() = 0;
 
+  // Same as Sweep() but the bitmap range is split into up to thread_count chunks which are swept
+  // on thread_pool, each freeing its garbage in batches. Falls back to Sweep() when the space is
+  // too small to split.
+  collector::ObjectBytePair SweepParallel(bool swap_bitmaps,
+                                          ThreadPool* thread_pool,
+                                          size_t thread_count)
+      REQUIRES(Locks::heap_bitmap_lock_) REQUIRES_SHARED(Locks::mutator_lock_);
+
   // Returns the class of a recently freed object.
   mirror::Class* FindRecentFreedObject(const mirror::Object* obj);
 
@@ -195,6 +206,8 @@ class MallocSpace : public ContinuousMemMapAllocSpace {
   const size_t initial_size_;
 
  private:
+  class SweepChunkTask;
+
   static void SweepCallback(size_t num_ptrs, mirror::Object** ptrs, void* arg)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
@@ -88,6 +88,40 @@ inline mirror::Object* RegionSpace::AllocNonvirtual(size_t num_bytes, size_t* by
   return nullptr;
 }
 
+inline mirror::Object* RegionSpace::AllocEvacTlab(Thread* self,
+                                                  size_t num_bytes,
+                                                  size_t* bytes_allocated,
+                                                  size_t* usable_size,
+                                                  size_t* bytes_tl_bulk_allocated) {
+  DCHECK_ALIGNED(num_bytes, kAlignment);
+  DCHECK(HasEvacTlab(self));
+  mirror::Object* obj;
+  if (LIKELY(num_bytes <= kRegionSize)) {
+    // No other thread allocates in this region, so the allocation only fails when it is full.
+    Region* r = static_cast<Region*>(self->GetThreadLocalEvacRegion());
+    obj = r->Alloc(num_bytes, bytes_allocated, usable_size, bytes_tl_bulk_allocated);
+    if (UNLIKELY(obj == nullptr)) {
+      MutexLock mu(self, region_lock_);
+      r = AllocateRegion(/*for_evac*/ true);
+      if (UNLIKELY(r == nullptr)) {
+        return nullptr;
+      }
+      obj = r->Alloc(num_bytes, bytes_allocated, usable_size, bytes_tl_bulk_allocated);
+      CHECK(obj != nullptr);
+    }
+    self->SetThreadLocalEvacRegion(r, self->GetThreadLocalEvacBytes() + num_bytes);
+  } else {
+    // Large object.
+    obj = AllocLarge</*kForEvac*/ true>(num_bytes, bytes_allocated, usable_size,
+                                        bytes_tl_bulk_allocated);
+    if (LIKELY(obj != nullptr)) {
+      self->SetThreadLocalEvacRegion(self->GetThreadLocalEvacRegion(),
+                                     self->GetThreadLocalEvacBytes() + *bytes_allocated);
+    }
+  }
+  return obj;
+}
+
 inline mirror::Object* RegionSpace::Region::Alloc(size_t num_bytes, size_t* bytes_allocated,
                                                   size_t* usable_size,
                                                   size_t* bytes_tl_bulk_allocated) {
@@ -231,6 +265,18 @@ void RegionSpace::WalkInternal(Visitor&& visitor) {
   }
 }
 
+template <typename Visitor>
+inline void RegionSpace::WalkEvacuatedRange(uint8_t* begin, uint8_t* top, Visitor&& visitor) {
+  uint8_t* pos = begin;
+  while (pos < top) {
+    mirror::Object* obj = reinterpret_cast<mirror::Object*>(pos);
+    if (obj->GetClass<kVerifyNone, kWithoutReadBarrier>() == nullptr || !visitor(obj)) {
+      break;
+    }
+    pos = reinterpret_cast<uint8_t*>(GetNextObject(obj));
+  }
+}
+
 inline mirror::Object* RegionSpace::GetNextObject(mirror::Object* obj) {
   const uintptr_t position = reinterpret_cast<uintptr_t>(obj) + obj->SizeOf();
   return reinterpret_cast<mirror::Object*>(RoundUp(position, kAlignment));
@@ -274,6 +320,10 @@ mirror::Object* RegionSpace::AllocLarge(size_t num_bytes, size_t* bytes_allocate
       Region* first_reg = &regions_[left];
       DCHECK(first_reg->IsFree());
       first_reg->UnfreeLarge(this, time_);
+      if (!kForEvac) {
+        // Evac doesn't count as newly allocated.
+        first_reg->SetNewlyAllocated();
+      }
       ++num_non_free_regions_;
       size_t allocated = num_regs * kRegionSize;
       // We make 'top' all usable bytes, as the caller of this
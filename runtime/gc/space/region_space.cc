@@ -20,6 +20,7 @@
 #include "mirror/object-inl.h"
 #include "mirror/class-inl.h"
 #include "thread_list.h"
+#include "utils.h"
 
 namespace art {
 namespace gc {
@@ -29,25 +30,37 @@ namespace space {
 // value of the region size, evaculate the region.
 static constexpr uint kEvaculateLivePercentThreshold = 75U;
 
+// The live bytes that may be copied out of the regions selected by their live percent in one
+// collection. The regions left over age and rank higher in the next collection.
+static constexpr size_t kEvacuationCopyBudget = 32 * MB;
+
 // If we protect the cleared regions.
 // Only protect for target builds to prevent flaky test failures (b/63131961).
 static constexpr bool kProtectClearedRegions = kIsTargetBuild;
 
-MemMap* RegionSpace::CreateMemMap(const std::string& name, size_t capacity,
-                                  uint8_t* requested_begin) {
+MemMap* RegionSpace::CreateMemMap(const std::string& name,
+                                  size_t capacity,
+                                  uint8_t* requested_begin,
+                                  bool use_huge_pages) {
   CHECK_ALIGNED(capacity, kRegionSize);
   std::string error_msg;
-  // Ask for the capacity of an additional kRegionSize so that we can align the map by kRegionSize
+  // Huge pages have to be aligned to kHugePageSize to be used for the whole space.
+  const size_t alignment =
+      (use_huge_pages && kHugePageSize > kRegionSize) ? kHugePageSize : kRegionSize;
+  const size_t map_capacity = RoundUp(capacity, alignment);
+  // Ask for the capacity of an additional alignment so that we can align the map by the alignment
   // even if we get unaligned base address. This is necessary for the ReadBarrierTable to work.
   std::unique_ptr<MemMap> mem_map;
   while (true) {
+    // Transparent huge pages only apply to private anonymous memory, not ashmem.
     mem_map.reset(MemMap::MapAnonymous(name.c_str(),
                                        requested_begin,
-                                       capacity + kRegionSize,
+                                       map_capacity + alignment,
                                        PROT_READ | PROT_WRITE,
                                        true,
                                        false,
-                                       &error_msg));
+                                       &error_msg,
+                                       /* use_ashmem */ !use_huge_pages));
     if (mem_map.get() != nullptr || requested_begin == nullptr) {
       break;
     }
@@ -60,31 +73,35 @@ MemMap* RegionSpace::CreateMemMap(const std::string& name, size_t capacity,
     MemMap::DumpMaps(LOG_STREAM(ERROR));
     return nullptr;
   }
-  CHECK_EQ(mem_map->Size(), capacity + kRegionSize);
+  CHECK_EQ(mem_map->Size(), map_capacity + alignment);
   CHECK_EQ(mem_map->Begin(), mem_map->BaseBegin());
   CHECK_EQ(mem_map->Size(), mem_map->BaseSize());
-  if (IsAlignedParam(mem_map->Begin(), kRegionSize)) {
-    // Got an aligned map. Since we requested a map that's kRegionSize larger. Shrink by
-    // kRegionSize at the end.
-    mem_map->SetSize(capacity);
-  } else {
+  if (!IsAlignedParam(mem_map->Begin(), alignment)) {
     // Got an unaligned map. Align the both ends.
-    mem_map->AlignBy(kRegionSize);
+    mem_map->AlignBy(alignment);
   }
-  CHECK_ALIGNED(mem_map->Begin(), kRegionSize);
+  // Shrink the extra alignment at the end.
+  mem_map->SetSize(capacity);
+  CHECK_ALIGNED_PARAM(mem_map->Begin(), alignment);
   CHECK_ALIGNED(mem_map->End(), kRegionSize);
   CHECK_EQ(mem_map->Size(), capacity);
+  if (use_huge_pages && !mem_map->AdviseHugePages()) {
+    LOG(WARNING) << "Huge pages are not available for " << name;
+  }
   return mem_map.release();
 }
 
-RegionSpace* RegionSpace::Create(const std::string& name, MemMap* mem_map) {
-  return new RegionSpace(name, mem_map);
+RegionSpace* RegionSpace::Create(const std::string& name, MemMap* mem_map, bool use_huge_pages) {
+  return new RegionSpace(name, mem_map, use_huge_pages);
 }
 
-RegionSpace::RegionSpace(const std::string& name, MemMap* mem_map)
+RegionSpace::RegionSpace(const std::string& name, MemMap* mem_map, bool use_huge_pages)
     : ContinuousMemMapAllocSpace(name, mem_map, mem_map->Begin(), mem_map->End(), mem_map->End(),
                                  kGcRetentionPolicyAlwaysCollect),
-      region_lock_("Region lock", kRegionSpaceRegionLock), time_(1U) {
+      region_lock_("Region lock", kRegionSpaceRegionLock), time_(1U),
+      release_granularity_(use_huge_pages ? kHugePageSize : kPageSize),
+      live_percent_histogram_(), num_selected_regions_(0U), num_deferred_regions_(0U),
+      selected_live_bytes_(0U) {
   size_t mem_map_size = mem_map->Size();
   CHECK_ALIGNED(mem_map_size, kRegionSize);
   CHECK_ALIGNED(mem_map->Begin(), kRegionSize);
@@ -154,14 +171,22 @@ size_t RegionSpace::ToSpaceSize() {
   return num_regions * kRegionSize;
 }
 
-inline bool RegionSpace::Region::ShouldBeEvacuated() {
+inline bool RegionSpace::Region::ShouldBeEvacuated(EvacMode evac_mode) {
   DCHECK((IsAllocated() || IsLarge()) && IsInToSpace());
   // if the region was allocated after the start of the
   // previous GC or the live ratio is below threshold, evacuate
-  // it.
+  // it. Newly allocated large regions are not copied, they are
+  // traced in place.
   bool result;
-  if (is_newly_allocated_) {
+  if (UNLIKELY(IsPinned())) {
+    // An object of the region is in use by native code, e.g. in a JNI critical section.
+    result = false;
+  } else if (evac_mode == EvacMode::kEvacModeForceAll) {
+    result = true;
+  } else if (is_newly_allocated_ && IsAllocated()) {
     result = true;
+  } else if (evac_mode == EvacMode::kEvacModeNewlyAllocated) {
+    result = false;
   } else {
     bool is_live_percent_valid = live_bytes_ != static_cast<size_t>(-1);
     if (is_live_percent_valid) {
@@ -172,10 +197,8 @@ inline bool RegionSpace::Region::ShouldBeEvacuated() {
       const size_t bytes_allocated = RoundUp(BytesAllocated(), kRegionSize);
       DCHECK_LE(live_bytes_, bytes_allocated);
       if (IsAllocated()) {
-        // Side node: live_percent == 0 does not necessarily mean
-        // there's no live objects due to rounding (there may be a
-        // few).
-        result = live_bytes_ * 100U < kEvaculateLivePercentThreshold * bytes_allocated;
+        // Selected by live percent, age and copy cost in SelectRegionsByLiveBytes().
+        result = is_selected_for_evac_;
       } else {
         DCHECK(IsLarge());
         result = live_bytes_ == 0U;
@@ -189,7 +212,9 @@ inline bool RegionSpace::Region::ShouldBeEvacuated() {
 
 // Determine which regions to evacuate and mark them as
 // from-space. Mark the rest as unevacuated from-space.
-void RegionSpace::SetFromSpace(accounting::ReadBarrierTable* rb_table, bool force_evacuate_all) {
+void RegionSpace::SetFromSpace(accounting::ReadBarrierTable* rb_table,
+                               EvacMode evac_mode,
+                               bool clear_live_bytes) {
   ++time_;
   if (kUseTableLookupReadBarrier) {
     DCHECK(rb_table->IsAllCleared());
@@ -202,6 +227,9 @@ void RegionSpace::SetFromSpace(accounting::ReadBarrierTable* rb_table, bool forc
   const size_t iter_limit = kUseTableLookupReadBarrier
       ? num_regions_
       : std::min(num_regions_, non_free_region_index_limit_);
+  if (evac_mode == EvacMode::kEvacModeLivePercentNewlyAllocated) {
+    SelectRegionsByLiveBytes(iter_limit);
+  }
   for (size_t i = 0; i < iter_limit; ++i) {
     Region* r = &regions_[i];
     RegionState state = r->State();
@@ -212,12 +240,14 @@ void RegionSpace::SetFromSpace(accounting::ReadBarrierTable* rb_table, bool forc
         DCHECK((state == RegionState::kRegionStateAllocated ||
                 state == RegionState::kRegionStateLarge) &&
                type == RegionType::kRegionTypeToSpace);
-        bool should_evacuate = force_evacuate_all || r->ShouldBeEvacuated();
+        bool should_evacuate = r->ShouldBeEvacuated(evac_mode);
+        r->is_selected_for_evac_ = false;
         if (should_evacuate) {
           r->SetAsFromSpace();
           DCHECK(r->IsInFromSpace());
         } else {
-          r->SetAsUnevacFromSpace();
+          // Regions allocated since the last GC have no live bytes to keep.
+          r->SetAsUnevacFromSpace(clear_live_bytes || r->IsNewlyAllocated());
           DCHECK(r->IsInUnevacFromSpace());
         }
         if (UNLIKELY(state == RegionState::kRegionStateLarge &&
@@ -233,7 +263,7 @@ void RegionSpace::SetFromSpace(accounting::ReadBarrierTable* rb_table, bool forc
           r->SetAsFromSpace();
           DCHECK(r->IsInFromSpace());
         } else {
-          r->SetAsUnevacFromSpace();
+          r->SetAsUnevacFromSpace(/*clear_live_bytes*/ true);
           DCHECK(r->IsInUnevacFromSpace());
         }
         --num_expected_large_tails;
@@ -251,14 +281,68 @@ void RegionSpace::SetFromSpace(accounting::ReadBarrierTable* rb_table, bool forc
   evac_region_ = &full_region_;
 }
 
-static void ZeroAndProtectRegion(uint8_t* begin, uint8_t* end) {
-  ZeroAndReleasePages(begin, end - begin);
+void RegionSpace::SelectRegionsByLiveBytes(size_t iter_limit) {
+  std::fill_n(live_percent_histogram_, kLivePercentHistogramBuckets, 0U);
+  num_selected_regions_ = 0;
+  num_deferred_regions_ = 0;
+  selected_live_bytes_ = 0;
+  // Pairs of the cost/benefit score and the region.
+  std::vector<std::pair<double, Region*>> candidates;
+  for (size_t i = 0; i < iter_limit; ++i) {
+    Region* r = &regions_[i];
+    // Newly allocated regions are always evacuated, large regions are never copied and pinned
+    // regions are kept in place.
+    if (!r->IsAllocated() || r->IsNewlyAllocated() || r->IsPinned() ||
+        r->live_bytes_ == static_cast<size_t>(-1)) {
+      continue;
+    }
+    DCHECK(r->IsInToSpace());
+    DCHECK_LE(r->live_bytes_, kRegionSize);
+    const size_t live_percent = r->live_bytes_ * 100U / kRegionSize;
+    ++live_percent_histogram_[std::min(live_percent / (100U / kLivePercentHistogramBuckets),
+                                       kLivePercentHistogramBuckets - 1)];
+    // Side node: live_percent == 0 does not necessarily mean
+    // there's no live objects due to rounding (there may be a
+    // few).
+    if (r->live_bytes_ * 100U >= kEvaculateLivePercentThreshold * kRegionSize) {
+      continue;
+    }
+    // The benefit is the reclaimed bytes weighted by the age, since the objects in an old region
+    // are less likely to die soon. The cost is reading the live bytes and writing their copies.
+    const double live_ratio = static_cast<double>(r->live_bytes_) / kRegionSize;
+    const uint32_t age = time_ - r->alloc_time_;
+    candidates.emplace_back((1.0 - live_ratio) * age / (1.0 + live_ratio), r);
+  }
+  std::sort(candidates.begin(),
+            candidates.end(),
+            [](const std::pair<double, Region*>& a, const std::pair<double, Region*>& b) {
+              return a.first > b.first;
+            });
+  for (const std::pair<double, Region*>& candidate : candidates) {
+    Region* r = candidate.second;
+    if (selected_live_bytes_ + r->live_bytes_ > kEvacuationCopyBudget) {
+      // Over budget. A region with fewer live bytes may still fit.
+      ++num_deferred_regions_;
+      continue;
+    }
+    r->is_selected_for_evac_ = true;
+    selected_live_bytes_ += r->live_bytes_;
+    ++num_selected_regions_;
+  }
+}
+
+static void ZeroAndProtectRegion(uint8_t* begin,
+                                 uint8_t* end,
+                                 size_t release_granularity = kPageSize) {
+  ZeroAndReleasePages(begin, end - begin, release_granularity);
   if (kProtectClearedRegions) {
     mprotect(begin, end - begin, PROT_NONE);
   }
 }
 
-void RegionSpace::ClearFromSpace(uint64_t* cleared_bytes, uint64_t* cleared_objects) {
+void RegionSpace::ClearFromSpace(uint64_t* cleared_bytes,
+                                 uint64_t* cleared_objects,
+                                 bool clear_bitmap) {
   DCHECK(cleared_bytes != nullptr);
   DCHECK(cleared_objects != nullptr);
   *cleared_bytes = 0;
@@ -273,10 +357,10 @@ void RegionSpace::ClearFromSpace(uint64_t* cleared_bytes, uint64_t* cleared_obje
   // clear block is zeroed, released, and a new block begins.
   uint8_t* clear_block_begin = nullptr;
   uint8_t* clear_block_end = nullptr;
-  auto clear_region = [&clear_block_begin, &clear_block_end](Region* r) {
+  auto clear_region = [this, &clear_block_begin, &clear_block_end](Region* r) {
     r->Clear(/*zero_and_release_pages*/false);
     if (clear_block_end != r->Begin()) {
-      ZeroAndProtectRegion(clear_block_begin, clear_block_end);
+      ZeroAndProtectRegion(clear_block_begin, clear_block_end, release_granularity_);
       clear_block_begin = r->Begin();
     }
     clear_block_end = r->End();
@@ -329,13 +413,24 @@ void RegionSpace::ClearFromSpace(uint64_t* cleared_bytes, uint64_t* cleared_obje
           ++regions_to_clear_bitmap;
         }
 
-        GetLiveBitmap()->ClearRange(
-            reinterpret_cast<mirror::Object*>(r->Begin()),
-            reinterpret_cast<mirror::Object*>(r->Begin() + regions_to_clear_bitmap * kRegionSize));
+        if (clear_bitmap) {
+          GetLiveBitmap()->ClearRange(
+              reinterpret_cast<mirror::Object*>(r->Begin()),
+              reinterpret_cast<mirror::Object*>(r->Begin() + regions_to_clear_bitmap * kRegionSize));
+        }
         // Skip over extra regions we cleared the bitmaps: we don't need to clear them, as they
         // are unevac region sthat are live.
         // Subtract one for the for loop.
         i += regions_to_clear_bitmap - 1;
+      } else if (r->IsLarge()) {
+        // A large region that kept its live bytes from a previous GC (young collection) may not
+        // have them all accounted; its tails must stay with it.
+        size_t num_tails = 0;
+        while (i + num_tails + 1 < num_regions_ && regions_[i + num_tails + 1].IsLargeTail()) {
+          regions_[i + num_tails + 1].SetUnevacFromSpaceAsToSpace();
+          ++num_tails;
+        }
+        i += num_tails;
       }
     }
     // Note r != last_checked_region if r->IsInUnevacFromSpace() was true above.
@@ -346,7 +441,7 @@ void RegionSpace::ClearFromSpace(uint64_t* cleared_bytes, uint64_t* cleared_obje
     }
   }
   // Clear pages for the last block since clearing happens when a new block opens.
-  ZeroAndReleasePages(clear_block_begin, clear_block_end - clear_block_begin);
+  ZeroAndReleasePages(clear_block_begin, clear_block_end - clear_block_begin, release_granularity_);
   // Update non_free_region_index_limit_.
   SetNonFreeRegionLimit(new_non_free_region_index_limit);
   evac_region_ = nullptr;
@@ -437,6 +532,17 @@ void RegionSpace::FreeLarge(mirror::Object* large_obj, size_t bytes_allocated) {
 
 void RegionSpace::DumpRegions(std::ostream& os) {
   MutexLock mu(Thread::Current(), region_lock_);
+  os << "Evacuation live percent threshold=" << kEvaculateLivePercentThreshold
+     << "% copy budget=" << kEvacuationCopyBudget << " bytes\n";
+  os << "Last selection: selected_regions=" << num_selected_regions_
+     << " deferred_regions=" << num_deferred_regions_
+     << " selected_live_bytes=" << selected_live_bytes_ << " live percent histogram:";
+  for (size_t i = 0; i < kLivePercentHistogramBuckets; ++i) {
+    const size_t bucket_size = 100U / kLivePercentHistogramBuckets;
+    os << " [" << i * bucket_size << "-" << (i + 1) * bucket_size << "%)="
+       << live_percent_histogram_[i];
+  }
+  os << "\n";
   for (size_t i = 0; i < num_regions_; ++i) {
     regions_[i].Dump(os);
   }
@@ -458,6 +564,47 @@ void RegionSpace::RecordAlloc(mirror::Object* ref) {
   r->objects_allocated_.FetchAndAddSequentiallyConsistent(1);
 }
 
+void RegionSpace::StartEvacTlab(Thread* thread) {
+  DCHECK(!HasEvacTlab(thread));
+  // The full region makes the first allocation get a new evacuation region.
+  thread->SetThreadLocalEvacRegion(&full_region_, 0U);
+}
+
+size_t RegionSpace::SampleEvacuatedRegions(size_t count,
+                                           std::vector<std::pair<uint8_t*, uint8_t*>>* ranges) {
+  MutexLock mu(Thread::Current(), region_lock_);
+  // Reservoir sampling over the candidate regions.
+  std::vector<Region*> sample;
+  size_t candidates = 0;
+  for (size_t i = 0; i < std::min(num_regions_, non_free_region_index_limit_); ++i) {
+    Region* r = &regions_[i];
+    if (r->IsFree() || !r->IsInToSpace() || r->IsNewlyAllocated() || r->IsLarge() ||
+        r->IsLargeTail() || r->is_a_tlab_) {
+      continue;
+    }
+    ++candidates;
+    if (sample.size() < count) {
+      sample.push_back(r);
+    } else {
+      const size_t j = GetRandomNumber<size_t>(0, candidates - 1);
+      if (j < count) {
+        sample[j] = r;
+      }
+    }
+  }
+  for (Region* r : sample) {
+    ranges->emplace_back(r->Begin(), r->Top());
+  }
+  return candidates;
+}
+
+size_t RegionSpace::RevokeEvacTlab(Thread* thread) {
+  // The unused end of the last evacuation region is left as is, like the one of evac_region_.
+  size_t bytes = thread->GetThreadLocalEvacBytes();
+  thread->SetThreadLocalEvacRegion(nullptr, 0U);
+  return bytes;
+}
+
 bool RegionSpace::AllocNewTlab(Thread* self, size_t min_bytes) {
   MutexLock mu(self, region_lock_);
   RevokeThreadLocalBuffersLocked(self);
@@ -42,9 +42,13 @@ class RegionSpace FINAL : public ContinuousMemMapAllocSpace {
 
   // Create a region space mem map with the requested sizes. The requested base address is not
   // guaranteed to be granted, if it is required, the caller should call Begin on the returned
-  // space to confirm the request was granted.
-  static MemMap* CreateMemMap(const std::string& name, size_t capacity, uint8_t* requested_begin);
-  static RegionSpace* Create(const std::string& name, MemMap* mem_map);
+  // space to confirm the request was granted. With use_huge_pages, the map is aligned to
+  // kHugePageSize and advised to be backed by transparent huge pages.
+  static MemMap* CreateMemMap(const std::string& name,
+                              size_t capacity,
+                              uint8_t* requested_begin,
+                              bool use_huge_pages = false);
+  static RegionSpace* Create(const std::string& name, MemMap* mem_map, bool use_huge_pages = false);
 
   // Allocate num_bytes, returns null if the space is full.
   mirror::Object* Alloc(Thread* self, size_t num_bytes, size_t* bytes_allocated,
@@ -66,6 +70,23 @@ class RegionSpace FINAL : public ContinuousMemMapAllocSpace {
                              size_t* bytes_tl_bulk_allocated) REQUIRES(!region_lock_);
   void FreeLarge(mirror::Object* large_obj, size_t bytes_allocated) REQUIRES(!region_lock_);
 
+  // Per-GC-thread evacuation TLABs. A GC thread that has an evacuation TLAB allocates to-space
+  // copies from its own evacuation region so that several GC threads can copy at once without
+  // contending on evac_region_ and region_lock_. Only valid between SetFromSpace() and
+  // ClearFromSpace().
+  void StartEvacTlab(Thread* thread);
+  bool HasEvacTlab(Thread* thread) const {
+    return thread->GetThreadLocalEvacRegion() != nullptr;
+  }
+  ALWAYS_INLINE mirror::Object* AllocEvacTlab(Thread* self,
+                                              size_t num_bytes,
+                                              size_t* bytes_allocated,
+                                              size_t* usable_size,
+                                              size_t* bytes_tl_bulk_allocated)
+      REQUIRES(!region_lock_);
+  // Returns the bytes the thread evacuated into its TLABs.
+  size_t RevokeEvacTlab(Thread* thread);
+
   // Return the storage space required by obj.
   size_t AllocationSize(mirror::Object* obj, size_t* usable_size) OVERRIDE
       REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(!region_lock_) {
@@ -163,6 +184,17 @@ class RegionSpace FINAL : public ContinuousMemMapAllocSpace {
     WalkInternal<true>(visitor);
   }
 
+  // Append the [begin, top) ranges of up to count randomly chosen regions that the GC copied
+  // objects to in the current collection. Regions mutators allocate in are left out since their
+  // objects may not be initialized yet. Only valid after copying is done and before
+  // ClearFromSpace(). Returns how many regions the sample was chosen from.
+  size_t SampleEvacuatedRegions(size_t count, std::vector<std::pair<uint8_t*, uint8_t*>>* ranges)
+      REQUIRES(!region_lock_);
+  // Visit the objects of a range returned by SampleEvacuatedRegions().
+  template <typename Visitor>
+  ALWAYS_INLINE void WalkEvacuatedRange(uint8_t* begin, uint8_t* top, Visitor&& visitor)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
   accounting::ContinuousSpaceBitmap::SweepCallback* GetSweepCallback() OVERRIDE {
     return nullptr;
   }
@@ -214,19 +246,60 @@ class RegionSpace FINAL : public ContinuousMemMapAllocSpace {
     return RegionType::kRegionTypeNone;
   }
 
-  void SetFromSpace(accounting::ReadBarrierTable* rb_table, bool force_evacuate_all)
+  // Keeps the region of `ref` from being evacuated until the matching UnpinRegion(), so that
+  // `ref` stays in place without holding up the collector. Pinning is ordered with
+  // SetFromSpace() by the thread flip, as callers are runnable.
+  void PinRegion(mirror::Object* ref) {
+    DCHECK(HasAddress(ref));
+    RefToRegionUnlocked(ref)->Pin();
+  }
+
+  void UnpinRegion(mirror::Object* ref) {
+    DCHECK(HasAddress(ref));
+    RefToRegionUnlocked(ref)->Unpin();
+  }
+
+  bool IsInPinnedRegion(mirror::Object* ref) {
+    return HasAddress(ref) && RefToRegionUnlocked(ref)->IsPinned();
+  }
+
+  // Which regions SetFromSpace() selects for evacuation.
+  enum class EvacMode {
+    // Only the regions allocated since the last GC (young collection).
+    kEvacModeNewlyAllocated,
+    // The regions allocated since the last GC and the ones with a low live ratio.
+    kEvacModeLivePercentNewlyAllocated,
+    // All regions.
+    kEvacModeForceAll,
+  };
+
+  // If clear_live_bytes is false, the regions that are not evacuated keep the live bytes computed
+  // by the previous GC. This is used by young collections, which do not trace the objects that
+  // survived earlier collections.
+  void SetFromSpace(accounting::ReadBarrierTable* rb_table,
+                    EvacMode evac_mode,
+                    bool clear_live_bytes)
       REQUIRES(!region_lock_);
 
   size_t FromSpaceSize() REQUIRES(!region_lock_);
   size_t UnevacFromSpaceSize() REQUIRES(!region_lock_);
   size_t ToSpaceSize() REQUIRES(!region_lock_);
-  void ClearFromSpace(uint64_t* cleared_bytes, uint64_t* cleared_objects) REQUIRES(!region_lock_);
+  // If clear_bitmap is false, the mark bitmap of the kept regions is preserved so that it still
+  // records the surviving objects, as needed by the generational concurrent copying collector.
+  void ClearFromSpace(uint64_t* cleared_bytes, uint64_t* cleared_objects, bool clear_bitmap)
+      REQUIRES(!region_lock_);
 
   void AddLiveBytes(mirror::Object* ref, size_t alloc_size) {
     Region* reg = RefToRegionUnlocked(ref);
     reg->AddLiveBytes(alloc_size);
   }
 
+  // Same as AddLiveBytes() but may be called by several threads at once.
+  void AddLiveBytesAtomic(mirror::Object* ref, size_t alloc_size) {
+    Region* reg = RefToRegionUnlocked(ref);
+    reg->AddLiveBytesAtomic(alloc_size);
+  }
+
   void AssertAllRegionLiveBytesZeroOrCleared() REQUIRES(!region_lock_) {
     if (kIsDebugBuild) {
       MutexLock mu(Thread::Current(), region_lock_);
@@ -246,7 +319,7 @@ class RegionSpace FINAL : public ContinuousMemMapAllocSpace {
   }
 
  private:
-  RegionSpace(const std::string& name, MemMap* mem_map);
+  RegionSpace(const std::string& name, MemMap* mem_map, bool use_huge_pages);
 
   template<bool kToSpaceOnly, typename Visitor>
   ALWAYS_INLINE void WalkInternal(Visitor&& visitor) NO_THREAD_SAFETY_ANALYSIS;
@@ -258,7 +331,8 @@ class RegionSpace FINAL : public ContinuousMemMapAllocSpace {
           begin_(nullptr), top_(nullptr), end_(nullptr),
           state_(RegionState::kRegionStateAllocated), type_(RegionType::kRegionTypeToSpace),
           objects_allocated_(0), alloc_time_(0), live_bytes_(static_cast<size_t>(-1)),
-          is_newly_allocated_(false), is_a_tlab_(false), thread_(nullptr) {}
+          is_newly_allocated_(false), is_selected_for_evac_(false), is_a_tlab_(false),
+          thread_(nullptr), pin_count_(0) {}
 
     void Init(size_t idx, uint8_t* begin, uint8_t* end) {
       idx_ = idx;
@@ -271,8 +345,10 @@ class RegionSpace FINAL : public ContinuousMemMapAllocSpace {
       alloc_time_ = 0;
       live_bytes_ = static_cast<size_t>(-1);
       is_newly_allocated_ = false;
+      is_selected_for_evac_ = false;
       is_a_tlab_ = false;
       thread_ = nullptr;
+      pin_count_.StoreRelaxed(0);
       DCHECK_LT(begin, end);
       DCHECK_EQ(static_cast<size_t>(end - begin), kRegionSize);
     }
@@ -371,18 +447,35 @@ class RegionSpace FINAL : public ContinuousMemMapAllocSpace {
       live_bytes_ = static_cast<size_t>(-1);
     }
 
-    void SetAsUnevacFromSpace() {
+    void SetAsUnevacFromSpace(bool clear_live_bytes) {
       DCHECK(!IsFree() && IsInToSpace());
       type_ = RegionType::kRegionTypeUnevacFromSpace;
-      live_bytes_ = 0U;
+      if (clear_live_bytes) {
+        live_bytes_ = 0U;
+      }
     }
 
     void SetUnevacFromSpaceAsToSpace() {
       DCHECK(!IsFree() && IsInUnevacFromSpace());
       type_ = RegionType::kRegionTypeToSpace;
+      // The region survived a GC, it is no longer newly allocated.
+      is_newly_allocated_ = false;
+    }
+
+    ALWAYS_INLINE bool ShouldBeEvacuated(EvacMode evac_mode);
+
+    void Pin() {
+      pin_count_.FetchAndAddSequentiallyConsistent(1u);
+    }
+
+    void Unpin() {
+      size_t old_pin_count = pin_count_.FetchAndSubSequentiallyConsistent(1u);
+      DCHECK_NE(old_pin_count, 0u);
     }
 
-    ALWAYS_INLINE bool ShouldBeEvacuated();
+    bool IsPinned() const {
+      return pin_count_.LoadSequentiallyConsistent() != 0u;
+    }
 
     void AddLiveBytes(size_t live_bytes) {
       DCHECK(IsInUnevacFromSpace());
@@ -394,6 +487,17 @@ class RegionSpace FINAL : public ContinuousMemMapAllocSpace {
       DCHECK_LE(live_bytes_, BytesAllocated());
     }
 
+    void AddLiveBytesAtomic(size_t live_bytes) {
+      DCHECK(IsInUnevacFromSpace());
+      DCHECK(!IsLargeTail());
+      static_assert(sizeof(Atomic<size_t>) == sizeof(live_bytes_),
+                    "Atomic<size_t> must have the size of size_t");
+      // For large allocations, we always consider all bytes in the
+      // regions live.
+      reinterpret_cast<Atomic<size_t>*>(&live_bytes_)->FetchAndAddRelaxed(
+          IsLarge() ? Top() - begin_ : live_bytes);
+    }
+
     bool AllAllocatedBytesAreLive() const {
       return LiveBytes() == static_cast<size_t>(Top() - Begin());
     }
@@ -461,8 +565,10 @@ class RegionSpace FINAL : public ContinuousMemMapAllocSpace {
     uint32_t alloc_time_;               // The allocation time of the region.
     size_t live_bytes_;                 // The live bytes. Used to compute the live percent.
     bool is_newly_allocated_;           // True if it's allocated after the last collection.
+    bool is_selected_for_evac_;         // True if picked by SelectRegionsByLiveBytes().
     bool is_a_tlab_;                    // True if it's a tlab.
     Thread* thread_;                    // The owning thread if it's a tlab.
+    Atomic<size_t> pin_count_;          // The number of pins, see RegionSpace::PinRegion().
 
     friend class RegionSpace;
   };
@@ -520,9 +626,17 @@ class RegionSpace FINAL : public ContinuousMemMapAllocSpace {
 
   Region* AllocateRegion(bool for_evac) REQUIRES(region_lock_);
 
+  // For kEvacModeLivePercentNewlyAllocated, rank the old non-large regions whose live percent is
+  // below the threshold by cost/benefit and select them for evacuation until the live bytes to
+  // copy reach the per-collection copy budget. Also fills in the live percent histogram.
+  void SelectRegionsByLiveBytes(size_t iter_limit) REQUIRES(region_lock_);
+
   Mutex region_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
 
   uint32_t time_;                  // The time as the number of collections since the startup.
+  // kHugePageSize if the space is backed by huge pages, kPageSize otherwise. Cleared regions are
+  // only released to the kernel in whole units of this size.
+  const size_t release_granularity_;
   size_t num_regions_;             // The number of regions in this space.
   size_t num_non_free_regions_;    // The number of non-free regions in this space.
   std::unique_ptr<Region[]> regions_ GUARDED_BY(region_lock_);
@@ -535,6 +649,14 @@ class RegionSpace FINAL : public ContinuousMemMapAllocSpace {
   Region* evac_region_;            // The region that's being evacuated to currently.
   Region full_region_;             // The dummy/sentinel region that looks full.
 
+  // The region selection of the last SetFromSpace() with kEvacModeLivePercentNewlyAllocated.
+  // Used for DumpRegions().
+  static constexpr size_t kLivePercentHistogramBuckets = 10;
+  size_t live_percent_histogram_[kLivePercentHistogramBuckets] GUARDED_BY(region_lock_);
+  size_t num_selected_regions_ GUARDED_BY(region_lock_);
+  size_t num_deferred_regions_ GUARDED_BY(region_lock_);
+  size_t selected_live_bytes_ GUARDED_BY(region_lock_);
+
   // Mark bitmap used by the GC.
   std::unique_ptr<accounting::ContinuousSpaceBitmap> mark_bitmap_;
 
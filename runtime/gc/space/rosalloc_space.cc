@@ -244,14 +244,7 @@ size_t RosAllocSpace::FreeList(Thread* self, size_t num_ptrs, mirror::Object** p
 
 size_t RosAllocSpace::Trim() {
   VLOG(heap) << "RosAllocSpace::Trim() ";
-  {
-    Thread* const self = Thread::Current();
-    // SOA required for Rosalloc::Trim() -> ArtRosAllocMoreCore() -> Heap::GetRosAllocSpace.
-    ScopedObjectAccess soa(self);
-    MutexLock mu(self, lock_);
-    // Trim to release memory at the end of the space.
-    rosalloc_->Trim();
-  }
+  TrimFootprint();
   // Attempt to release pages if it does not release all empty pages.
   if (!rosalloc_->DoesReleaseAllPages()) {
     return rosalloc_->ReleasePages();
@@ -259,6 +252,24 @@ size_t RosAllocSpace::Trim() {
   return 0;
 }
 
+void RosAllocSpace::TrimFootprint() {
+  Thread* const self = Thread::Current();
+  // SOA required for Rosalloc::Trim() -> ArtRosAllocMoreCore() -> Heap::GetRosAllocSpace.
+  ScopedObjectAccess soa(self);
+  MutexLock mu(self, lock_);
+  // Trim to release memory at the end of the space.
+  rosalloc_->Trim();
+}
+
+size_t RosAllocSpace::ReleasePages(size_t* cursor, size_t max_pages) {
+  if (rosalloc_->DoesReleaseAllPages()) {
+    // The empty pages are released as soon as they are freed.
+    *cursor = 0;
+    return 0;
+  }
+  return rosalloc_->ReleasePages(cursor, max_pages);
+}
+
 void RosAllocSpace::Walk(void(*callback)(void *start, void *end, size_t num_bytes, void* callback_arg),
                          void* arg) {
   InspectAllRosAlloc(callback, arg, true);
@@ -104,6 +104,11 @@ class RosAllocSpace : public MallocSpace {
   }
 
   size_t Trim() OVERRIDE;
+  // The two parts of Trim(), for the incremental heap trim. TrimFootprint() releases the free
+  // pages at the end of the space, ReleasePages() the free pages of the next max_pages pages from
+  // *cursor, see RosAlloc::ReleasePages().
+  void TrimFootprint();
+  size_t ReleasePages(size_t* cursor, size_t max_pages);
   void Walk(WalkCallback callback, void* arg) OVERRIDE REQUIRES(!lock_);
   size_t GetFootprint() OVERRIDE;
   size_t GetFootprintLimit() OVERRIDE;
@@ -22,6 +22,7 @@
 #include "art_field-inl.h"
 #include "mirror/class-inl.h"
 #include "mirror/object-refvisitor-inl.h"
+#include "mirror/reference-inl.h"
 
 namespace art {
 namespace gc {
@@ -149,6 +150,62 @@ bool Verification::IsValidClass(const void* addr) const {
   return k1 == k2;
 }
 
+class Verification::VerifyReferenceVisitor {
+ public:
+  VerifyReferenceVisitor(const Verification* verification, bool fatal)
+      : verification_(verification), fatal_(fatal), failures_(0u) {}
+
+  void operator()(ObjPtr<mirror::Object> obj, MemberOffset offset, bool is_static ATTRIBUTE_UNUSED)
+      const REQUIRES_SHARED(Locks::mutator_lock_) {
+    Check(obj,
+          offset,
+          obj->GetFieldObject<mirror::Object, kVerifyNone, kWithoutReadBarrier>(offset));
+  }
+
+  void operator()(ObjPtr<mirror::Class> klass ATTRIBUTE_UNUSED, ObjPtr<mirror::Reference> ref) const
+      REQUIRES_SHARED(Locks::mutator_lock_) {
+    Check(ref, mirror::Reference::ReferentOffset(), ref->GetReferent<kWithoutReadBarrier>());
+  }
+
+  // Native roots are not visited.
+  void VisitRootIfNonNull(mirror::CompressedReference<mirror::Object>* root ATTRIBUTE_UNUSED)
+      const {}
+  void VisitRoot(mirror::CompressedReference<mirror::Object>* root ATTRIBUTE_UNUSED) const {}
+
+  size_t Failures() const {
+    return failures_;
+  }
+
+ private:
+  void Check(ObjPtr<mirror::Object> holder, MemberOffset offset, mirror::Object* ref) const
+      REQUIRES_SHARED(Locks::mutator_lock_) {
+    if (ref != nullptr &&
+        (!verification_->IsValidHeapObjectAddress(ref) ||
+         !verification_->IsValidClass(ref->GetClass<kVerifyNone, kWithoutReadBarrier>()))) {
+      verification_->LogHeapCorruption(holder, offset, ref, fatal_);
+      ++failures_;
+    }
+  }
+
+  const Verification* const verification_;
+  const bool fatal_;
+  mutable size_t failures_;
+};
+
+size_t Verification::VerifyObjectReferences(mirror::Object* obj, bool fatal) const {
+  VerifyReferenceVisitor visitor(this, fatal);
+  if (!IsValidClass(obj->GetClass<kVerifyNone, kWithoutReadBarrier>())) {
+    LogHeapCorruption(obj,
+                      mirror::Object::ClassOffset(),
+                      obj->GetClass<kVerifyNone, kWithoutReadBarrier>(),
+                      fatal);
+    return 1u;
+  }
+  obj->VisitReferences</*kVisitNativeRoots*/ false, kVerifyNone, kWithoutReadBarrier>(visitor,
+                                                                                     visitor);
+  return visitor.Failures();
+}
+
 using ObjectSet = std::set<mirror::Object*>;
 using WorkQueue = std::deque<std::pair<mirror::Object*, std::string>>;
 
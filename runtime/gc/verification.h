@@ -56,6 +56,12 @@ class Verification {
   bool IsValidHeapObjectAddress(const void* addr, space::Space** out_space = nullptr) const
       REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Check that the class and the non-null references of obj point to valid objects, logging each
+  // invalid reference with LogHeapCorruption. Returns how many were found. Only reads obj, so it
+  // may run concurrently with mutators.
+  size_t VerifyObjectReferences(mirror::Object* obj, bool fatal) const
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
   // Find the first path to the target from the root set. Should be called while paused since
   // visiting roots is not safe otherwise.
   std::string FirstPathFromRootSet(ObjPtr<mirror::Object> target) const
@@ -74,6 +80,7 @@ class Verification {
 
   class BFSFindReachable;
   class CollectRootVisitor;
+  class VerifyReferenceVisitor;
 };
 
 }  // namespace gc
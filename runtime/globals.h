@@ -40,6 +40,9 @@ static constexpr size_t kStackAlignment = 16;
 // compile-time constant so the compiler can generate better code.
 static constexpr int kPageSize = 4096;
 
+// Size of a transparent huge page with 4KB base pages (a PMD entry).
+static constexpr size_t kHugePageSize = 2 * MB;
+
 // Returns whether the given memory offset can be used for generating
 // an implicit null check.
 static inline bool CanDoImplicitNullCheckOn(uintptr_t offset) {
@@ -30,6 +30,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <sys/time.h>
+#include <sys/wait.h>
 #include <sys/uio.h>
 #include <time.h>
 #include <time.h>
@@ -452,28 +453,28 @@ class Hprof : public SingleRootVisitor {
       }
     }
 
-    // First pass to measure the size of the dump.
-    size_t overall_size;
-    size_t max_length;
-    {
-      EndianOutput count_output;
-      output_ = &count_output;
-      ProcessHeap(false);
-      overall_size = count_output.SumLength();
-      max_length = count_output.MaxLength();
-      output_ = nullptr;
-    }
-
+    size_t overall_size = 0u;
     bool okay;
-    visited_objects_.clear();
     if (direct_to_ddms_) {
+      // First pass to measure the size of the dump, which the chunk header holds.
+      size_t max_length;
+      {
+        EndianOutput count_output;
+        output_ = &count_output;
+        ProcessHeap(false);
+        overall_size = count_output.SumLength();
+        max_length = count_output.MaxLength();
+        output_ = nullptr;
+      }
+      visited_objects_.clear();
       if (kDirectStream) {
         okay = DumpToDdmsDirect(overall_size, max_length, CHUNK_TYPE("HPDS"));
       } else {
         okay = DumpToDdmsBuffered(overall_size, max_length);
       }
     } else {
-      okay = DumpToFile(overall_size, max_length);
+      // Files do not need the size up front, the records are written as they are generated.
+      okay = DumpToFile(&overall_size);
     }
 
     if (okay) {
@@ -757,7 +758,7 @@ class Hprof : public SingleRootVisitor {
     //        Dbg::DdmSendChunkV(CHUNK_TYPE("HPDS"), iov, 2);
   }
 
-  bool DumpToFile(size_t overall_size, size_t max_length)
+  bool DumpToFile(size_t* overall_size)
       REQUIRES(Locks::mutator_lock_) {
     // Where exactly are we writing to?
     int out_fd;
@@ -779,16 +780,11 @@ class Hprof : public SingleRootVisitor {
     std::unique_ptr<File> file(new File(out_fd, filename_, true));
     bool okay;
     {
-      FileEndianOutput file_output(file.get(), max_length);
+      FileEndianOutput file_output(file.get(), kMaxBytesPerSegment);
       output_ = &file_output;
       ProcessHeap(true);
       okay = !file_output.Errors();
-
-      if (okay) {
-        // Check for expected size. Output is expected to be less-or-equal than first phase, see
-        // b/23521263.
-        DCHECK_LE(file_output.SumLength(), overall_size);
-      }
+      *overall_size = file_output.SumLength();
       output_ = nullptr;
     }
 
@@ -1603,12 +1599,57 @@ void Hprof::VisitRoot(mirror::Object* obj, const RootInfo& info) {
   MarkRootObject(obj, 0, xlate[info.GetType()], info.GetThreadId());
 }
 
+// Dump the heap from a forked child. The child gets a copy-on-write snapshot of the heap with all
+// threads suspended, so the threads of this process only stay suspended for the fork and keep
+// running while the child writes the dump.
+static void DumpHeapInChild(const char* filename, int fd) {
+  Thread* self = Thread::Current();
+  pid_t pid;
+  {
+    gc::ScopedGCCriticalSection gcs(self,
+                                    gc::kGcCauseHprof,
+                                    gc::kCollectorTypeHprof);
+    ScopedSuspendAll ssa(__FUNCTION__);
+    pid = fork();
+    if (pid == 0) {
+      // Only this thread exists in the child. The other threads are suspended in the snapshot
+      // and never resume, so the child exits without releasing the mutator lock.
+      Hprof hprof(filename, fd, false);
+      hprof.Dump();
+      _exit(self->IsExceptionPending() ? 1 : 0);
+    }
+  }
+  if (pid < 0) {
+    ScopedObjectAccess soa(self);
+    ThrowRuntimeException("Couldn't dump heap; fork failed: %s", strerror(errno));
+    return;
+  }
+  int status;
+  if (TEMP_FAILURE_RETRY(waitpid(pid, &status, 0)) != pid) {
+    ScopedObjectAccess soa(self);
+    ThrowRuntimeException("Couldn't dump heap; waitpid(%d) failed: %s", pid, strerror(errno));
+    return;
+  }
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+    ScopedObjectAccess soa(self);
+    ThrowRuntimeException("Couldn't dump heap; writing \"%s\" failed in child %d: status %d",
+                          filename,
+                          pid,
+                          status);
+  }
+}
+
 // If "direct_to_ddms" is true, the other arguments are ignored, and data is
 // sent directly to DDMS.
 // If "fd" is >= 0, the output will be written to that file descriptor.
 // Otherwise, "filename" is used to create an output file.
+// With -XX:ForkHeapDump=true, dumps to a file are written by a forked child.
 void DumpHeap(const char* filename, int fd, bool direct_to_ddms) {
   CHECK(filename != nullptr);
+  if (!direct_to_ddms && Runtime::Current()->GetForkHeapDump()) {
+    DumpHeapInChild(filename, fd);
+    return;
+  }
   Thread* self = Thread::Current();
   // Need to take a heap dump while GC isn't running. See the comment in Heap::VisitObjects().
   // Also we need the critical section to avoid visiting the same object twice. See b/34967844
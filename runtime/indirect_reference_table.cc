@@ -20,6 +20,7 @@
 #include "base/systrace.h"
 #include "java_vm_ext.h"
 #include "jni_internal.h"
+#include "mem_map.h"
 #include "nth_caller_visitor.h"
 #include "reference_table.h"
 #include "runtime.h"
@@ -62,11 +63,92 @@ void IndirectReferenceTable::AbortIfNoCheckJNI(const std::string& msg) {
   }
 }
 
+static std::unique_ptr<MemMap> MapChunk(size_t byte_count, std::string* error_msg) {
+  return std::unique_ptr<MemMap>(MemMap::MapAnonymous("indirect ref table",
+                                                      nullptr,
+                                                      byte_count,
+                                                      PROT_READ | PROT_WRITE,
+                                                      false,
+                                                      false,
+                                                      error_msg));
+}
+
+IrtChunkPool::IrtChunkPool()
+    : lock_("Indirect reference table chunk pool lock", kIrtChunkPoolLock), pooled_bytes_(0u) {
+}
+
+IrtChunkPool::~IrtChunkPool() {
+}
+
+std::unique_ptr<MemMap> IrtChunkPool::Allocate(size_t byte_count, std::string* error_msg) {
+  {
+    MutexLock mu(Thread::Current(), lock_);
+    for (auto it = maps_.begin(); it != maps_.end(); ++it) {
+      if ((*it)->Size() == byte_count) {
+        std::unique_ptr<MemMap> map = std::move(*it);
+        maps_.erase(it);
+        DCHECK_GE(pooled_bytes_, byte_count);
+        pooled_bytes_ -= byte_count;
+        return map;
+      }
+    }
+  }
+  return MapChunk(byte_count, error_msg);
+}
+
+void IrtChunkPool::Free(std::unique_ptr<MemMap> map) {
+  if (map == nullptr || map->Size() > kMaxPooledBytes) {
+    return;
+  }
+  if (map->Size() <= kMaxMemsetBytes) {
+    memset(map->Begin(), 0, map->Size());
+  } else {
+    map->MadviseDontNeedAndZero();
+  }
+  MutexLock mu(Thread::Current(), lock_);
+  if (maps_.size() < kMaxPooledMaps && pooled_bytes_ + map->Size() <= kMaxPooledBytes) {
+    pooled_bytes_ += map->Size();
+    maps_.push_back(std::move(map));
+  }
+  // Otherwise the pool is full and the map is unmapped.
+}
+
+void IrtChunkPool::Trim() {
+  std::vector<std::unique_ptr<MemMap>> maps;
+  {
+    MutexLock mu(Thread::Current(), lock_);
+    maps.swap(maps_);
+    pooled_bytes_ = 0u;
+  }
+  // The maps are unmapped here, without holding the lock.
+}
+
+size_t IrtChunkPool::GetPooledBytes() {
+  MutexLock mu(Thread::Current(), lock_);
+  return pooled_bytes_;
+}
+
+static IrtChunkPool* GetChunkPool() {
+  Runtime* runtime = Runtime::Current();
+  return runtime != nullptr ? runtime->GetIrtChunkPool() : nullptr;
+}
+
+static std::unique_ptr<MemMap> AllocateChunkMap(size_t byte_count, std::string* error_msg) {
+  IrtChunkPool* pool = GetChunkPool();
+  if (pool != nullptr) {
+    return pool->Allocate(byte_count, error_msg);
+  }
+  return MapChunk(byte_count, error_msg);
+}
+
 IndirectReferenceTable::IndirectReferenceTable(size_t max_count,
                                                IndirectRefKind desired_kind,
                                                ResizableCapacity resizable,
                                                std::string* error_msg)
     : segment_state_(kIRTFirstSegment),
+      chunks_(),
+      num_chunks_(0u),
+      first_chunk_entries_(max_count),
       kind_(desired_kind),
       max_entries_(max_count),
       current_num_holes_(0),
@@ -78,22 +160,26 @@ IndirectReferenceTable::IndirectReferenceTable(size_t max_count,
   CHECK_LE(max_count, kMaxTableSizeInBytes / sizeof(IrtEntry));
 
   const size_t table_bytes = max_count * sizeof(IrtEntry);
-  table_mem_map_.reset(MemMap::MapAnonymous("indirect ref table", nullptr, table_bytes,
-                                            PROT_READ | PROT_WRITE, false, false, error_msg));
-  if (table_mem_map_.get() == nullptr && error_msg->empty()) {
+  chunk_maps_[0] = AllocateChunkMap(table_bytes, error_msg);
+  if (chunk_maps_[0].get() == nullptr && error_msg->empty()) {
     *error_msg = "Unable to map memory for indirect ref table";
   }
 
-  if (table_mem_map_.get() != nullptr) {
-    table_ = reinterpret_cast<IrtEntry*>(table_mem_map_->Begin());
-  } else {
-    table_ = nullptr;
+  if (chunk_maps_[0].get() != nullptr) {
+    chunks_[0] = reinterpret_cast<IrtEntry*>(chunk_maps_[0]->Begin());
+    num_chunks_ = 1u;
   }
   segment_state_ = kIRTFirstSegment;
   last_known_previous_state_ = kIRTFirstSegment;
 }
 
 IndirectReferenceTable::~IndirectReferenceTable() {
+  IrtChunkPool* pool = GetChunkPool();
+  if (pool != nullptr) {
+    for (size_t chunk = 0; chunk != num_chunks_; ++chunk) {
+      pool->Free(std::move(chunk_maps_[chunk]));
+    }
+  }
 }
 
 void IndirectReferenceTable::ConstexprChecks() {
@@ -125,7 +211,7 @@ void IndirectReferenceTable::ConstexprChecks() {
 }
 
 bool IndirectReferenceTable::IsValid() const {
-  return table_mem_map_.get() != nullptr;
+  return chunk_maps_[0].get() != nullptr;
 }
 
 // Holes:
@@ -163,10 +249,10 @@ bool IndirectReferenceTable::IsValid() const {
 // equal to the current previous state, and smaller than the current state (top index). The
 // condition is conservative as it adds O(1) overhead to operations on an empty segment.
 
-static size_t CountNullEntries(const IrtEntry* table, size_t from, size_t to) {
+size_t IndirectReferenceTable::CountNullEntries(size_t from, size_t to) const {
   size_t count = 0;
   for (size_t index = from; index != to; ++index) {
-    if (table[index].GetReference()->IsNull()) {
+    if (GetEntry(index)->GetReference()->IsNull()) {
       count++;
     }
   }
@@ -177,7 +263,7 @@ void IndirectReferenceTable::RecoverHoles(IRTSegmentState prev_state) {
   if (last_known_previous_state_.top_index >= segment_state_.top_index ||
       last_known_previous_state_.top_index < prev_state.top_index) {
     const size_t top_index = segment_state_.top_index;
-    size_t count = CountNullEntries(table_, prev_state.top_index, top_index);
+    size_t count = CountNullEntries(prev_state.top_index, top_index);
 
     if (kDebugIRT) {
       LOG(INFO) << "+++ Recovered holes: "
@@ -195,12 +281,11 @@ void IndirectReferenceTable::RecoverHoles(IRTSegmentState prev_state) {
 }
 
 ALWAYS_INLINE
-static inline void CheckHoleCount(IrtEntry* table,
-                                  size_t exp_num_holes,
-                                  IRTSegmentState prev_state,
-                                  IRTSegmentState cur_state) {
+inline void IndirectReferenceTable::CheckHoleCount(size_t exp_num_holes,
+                                                   IRTSegmentState prev_state,
+                                                   IRTSegmentState cur_state) const {
   if (kIsDebugBuild) {
-    size_t count = CountNullEntries(table, prev_state.top_index, cur_state.top_index);
+    size_t count = CountNullEntries(prev_state.top_index, cur_state.top_index);
     CHECK_EQ(exp_num_holes, count) << "prevState=" << prev_state.top_index
                                    << " topIndex=" << cur_state.top_index;
   }
@@ -216,23 +301,27 @@ bool IndirectReferenceTable::Resize(size_t new_size, std::string* error_msg) {
   }
   // Note: the above check also ensures that there is no overflow below.
 
-  const size_t table_bytes = new_size * sizeof(IrtEntry);
-  std::unique_ptr<MemMap> new_map(MemMap::MapAnonymous("indirect ref table",
-                                                       nullptr,
-                                                       table_bytes,
-                                                       PROT_READ | PROT_WRITE,
-                                                       false,
-                                                       false,
-                                                       error_msg));
-  if (new_map == nullptr) {
-    return false;
+  // Each new chunk doubles the capacity. The entries already in the table stay where they are,
+  // so there is nothing to copy and concurrent readers of the table are not affected.
+  CHECK_NE(first_chunk_entries_, 0u);
+  CHECK_EQ(max_entries_, first_chunk_entries_ << (num_chunks_ - 1u));
+  while (max_entries_ < new_size) {
+    if (max_entries_ > kMaxEntries / 2 || num_chunks_ == kMaxTableChunks) {
+      *error_msg = android::base::StringPrintf("Requested size exceeds maximum: %zu", new_size);
+      return false;
+    }
+    // The new chunk holds as many entries as all the previous ones.
+    const size_t chunk_bytes = max_entries_ * sizeof(IrtEntry);
+    std::unique_ptr<MemMap> new_map = AllocateChunkMap(chunk_bytes, error_msg);
+    if (new_map == nullptr) {
+      return false;
+    }
+    chunks_[num_chunks_] = reinterpret_cast<IrtEntry*>(new_map->Begin());
+    chunk_maps_[num_chunks_] = std::move(new_map);
+    ++num_chunks_;
+    max_entries_ *= 2;
   }
 
-  memcpy(new_map->Begin(), table_mem_map_->Begin(), table_mem_map_->Size());
-  table_mem_map_ = std::move(new_map);
-  table_ = reinterpret_cast<IrtEntry*>(table_mem_map_->Begin());
-  max_entries_ = new_size;
-
   return true;
 }
 
@@ -249,7 +338,7 @@ IndirectRef IndirectReferenceTable::Add(IRTSegmentState previous_state,
 
   CHECK(obj != nullptr);
   VerifyObject(obj);
-  DCHECK(table_ != nullptr);
+  DCHECK_NE(num_chunks_, 0u);
 
   if (top_index == max_entries_) {
     if (resizable_ == ResizableCapacity::kNo) {
@@ -279,7 +368,7 @@ IndirectRef IndirectReferenceTable::Add(IRTSegmentState previous_state,
   }
 
   RecoverHoles(previous_state);
-  CheckHoleCount(table_, current_num_holes_, previous_state, segment_state_);
+  CheckHoleCount(current_num_holes_, previous_state, segment_state_);
 
   // We know there's enough room in the table.  Now we just need to find
   // the right spot.  If there's a hole, find it and fill it; otherwise,
@@ -289,21 +378,20 @@ IndirectRef IndirectReferenceTable::Add(IRTSegmentState previous_state,
   if (current_num_holes_ > 0) {
     DCHECK_GT(top_index, 1U);
     // Find the first hole; likely to be near the end of the list.
-    IrtEntry* p_scan = &table_[top_index - 1];
-    DCHECK(!p_scan->GetReference()->IsNull());
-    --p_scan;
-    while (!p_scan->GetReference()->IsNull()) {
-      DCHECK_GE(p_scan, table_ + previous_state.top_index);
-      --p_scan;
+    index = top_index - 1;
+    DCHECK(!GetEntry(index)->GetReference()->IsNull());
+    --index;
+    while (!GetEntry(index)->GetReference()->IsNull()) {
+      DCHECK_GE(index, previous_state.top_index);
+      --index;
     }
-    index = p_scan - table_;
     current_num_holes_--;
   } else {
     // Add to the end.
     index = top_index++;
     segment_state_.top_index = top_index;
   }
-  table_[index].Add(obj);
+  GetEntry(index)->Add(obj);
   result = ToIndirectRef(index);
   if (kDebugIRT) {
     LOG(INFO) << "+++ added at " << ExtractIndex(result) << " top=" << segment_state_.top_index
@@ -316,7 +404,7 @@ IndirectRef IndirectReferenceTable::Add(IRTSegmentState previous_state,
 
 void IndirectReferenceTable::AssertEmpty() {
   for (size_t i = 0; i < Capacity(); ++i) {
-    if (!table_[i].GetReference()->IsNull()) {
+    if (!GetEntry(i)->GetReference()->IsNull()) {
       LOG(FATAL) << "Internal Error: non-empty local reference table\n"
                  << MutatorLockedDumpable<IndirectReferenceTable>(*this);
       UNREACHABLE();
@@ -343,7 +431,7 @@ bool IndirectReferenceTable::Remove(IRTSegmentState previous_state, IndirectRef
   const uint32_t top_index = segment_state_.top_index;
   const uint32_t bottom_index = previous_state.top_index;
 
-  DCHECK(table_ != nullptr);
+  DCHECK_NE(num_chunks_, 0u);
 
   if (GetIndirectRefKind(iref) == kHandleScopeOrInvalid) {
     auto* self = Thread::Current();
@@ -375,7 +463,7 @@ bool IndirectReferenceTable::Remove(IRTSegmentState previous_state, IndirectRef
   }
 
   RecoverHoles(previous_state);
-  CheckHoleCount(table_, current_num_holes_, previous_state, segment_state_);
+  CheckHoleCount(current_num_holes_, previous_state, segment_state_);
 
   if (idx == top_index - 1) {
     // Top-most entry.  Scan up and consume holes.
@@ -384,7 +472,7 @@ bool IndirectReferenceTable::Remove(IRTSegmentState previous_state, IndirectRef
       return false;
     }
 
-    *table_[idx].GetReference() = GcRoot<mirror::Object>(nullptr);
+    *GetEntry(idx)->GetReference() = GcRoot<mirror::Object>(nullptr);
     if (current_num_holes_ != 0) {
       uint32_t collapse_top_index = top_index;
       while (--collapse_top_index > bottom_index && current_num_holes_ != 0) {
@@ -392,9 +480,10 @@ bool IndirectReferenceTable::Remove(IRTSegmentState previous_state, IndirectRef
           ScopedObjectAccess soa(Thread::Current());
           LOG(INFO) << "+++ checking for hole at " << collapse_top_index - 1
                     << " (previous_state=" << bottom_index << ") val="
-                    << table_[collapse_top_index - 1].GetReference()->Read<kWithoutReadBarrier>();
+                    << GetEntry(collapse_top_index - 1)->GetReference()
+                           ->Read<kWithoutReadBarrier>();
         }
-        if (!table_[collapse_top_index - 1].GetReference()->IsNull()) {
+        if (!GetEntry(collapse_top_index - 1)->GetReference()->IsNull()) {
           break;
         }
         if (kDebugIRT) {
@@ -404,7 +493,7 @@ bool IndirectReferenceTable::Remove(IRTSegmentState previous_state, IndirectRef
       }
       segment_state_.top_index = collapse_top_index;
 
-      CheckHoleCount(table_, current_num_holes_, previous_state, segment_state_);
+      CheckHoleCount(current_num_holes_, previous_state, segment_state_);
     } else {
       segment_state_.top_index = top_index - 1;
       if (kDebugIRT) {
@@ -414,7 +503,7 @@ bool IndirectReferenceTable::Remove(IRTSegmentState previous_state, IndirectRef
   } else {
     // Not the top-most entry.  This creates a hole.  We null out the entry to prevent somebody
     // from deleting it twice and screwing up the hole count.
-    if (table_[idx].GetReference()->IsNull()) {
+    if (GetEntry(idx)->GetReference()->IsNull()) {
       LOG(INFO) << "--- WEIRD: removing null entry " << idx;
       return false;
     }
@@ -422,9 +511,9 @@ bool IndirectReferenceTable::Remove(IRTSegmentState previous_state, IndirectRef
       return false;
     }
 
-    *table_[idx].GetReference() = GcRoot<mirror::Object>(nullptr);
+    *GetEntry(idx)->GetReference() = GcRoot<mirror::Object>(nullptr);
     current_num_holes_++;
-    CheckHoleCount(table_, current_num_holes_, previous_state, segment_state_);
+    CheckHoleCount(current_num_holes_, previous_state, segment_state_);
     if (kDebugIRT) {
       LOG(INFO) << "+++ left hole at " << idx << ", holes=" << current_num_holes_;
     }
@@ -436,9 +525,20 @@ bool IndirectReferenceTable::Remove(IRTSegmentState previous_state, IndirectRef
 void IndirectReferenceTable::Trim() {
   ScopedTrace trace(__PRETTY_FUNCTION__);
   const size_t top_index = Capacity();
-  auto* release_start = AlignUp(reinterpret_cast<uint8_t*>(&table_[top_index]), kPageSize);
-  uint8_t* release_end = table_mem_map_->End();
-  madvise(release_start, release_end - release_start, MADV_DONTNEED);
+  size_t chunk_begin = 0u;
+  for (size_t chunk = 0; chunk != num_chunks_; ++chunk) {
+    const size_t chunk_end = first_chunk_entries_ << chunk;
+    if (top_index < chunk_end) {
+      const size_t first_unused = std::max(top_index, chunk_begin) - chunk_begin;
+      auto* release_start =
+          AlignUp(reinterpret_cast<uint8_t*>(&chunks_[chunk][first_unused]), kPageSize);
+      uint8_t* release_end = chunk_maps_[chunk]->End();
+      if (release_start < release_end) {
+        madvise(release_start, release_end - release_start, MADV_DONTNEED);
+      }
+    }
+    chunk_begin = chunk_end;
+  }
 }
 
 void IndirectReferenceTable::VisitRoots(RootVisitor* visitor, const RootInfo& root_info) {
@@ -455,9 +555,9 @@ void IndirectReferenceTable::Dump(std::ostream& os) const {
   os << kind_ << " table dump:\n";
   ReferenceTable::Table entries;
   for (size_t i = 0; i < Capacity(); ++i) {
-    ObjPtr<mirror::Object> obj = table_[i].GetReference()->Read<kWithoutReadBarrier>();
+    ObjPtr<mirror::Object> obj = GetEntry(i)->GetReference()->Read<kWithoutReadBarrier>();
     if (obj != nullptr) {
-      obj = table_[i].GetReference()->Read();
+      obj = GetEntry(i)->GetReference()->Read();
       entries.push_back(GcRoot<mirror::Object>(obj));
     }
   }
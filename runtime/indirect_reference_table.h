@@ -21,7 +21,9 @@
 
 #include <iosfwd>
 #include <limits>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "base/bit_utils.h"
 #include "base/logging.h"
@@ -181,9 +183,12 @@ static_assert(sizeof(IrtEntry) == (1 + kIRTPrevCount) * sizeof(uint32_t),
               "Unexpected sizeof(IrtEntry)");
 static_assert(IsPowerOfTwo(sizeof(IrtEntry)), "Unexpected sizeof(IrtEntry)");
 
+class IndirectReferenceTable;
+
 class IrtIterator {
  public:
-  IrtIterator(IrtEntry* table, size_t i, size_t capacity) REQUIRES_SHARED(Locks::mutator_lock_)
+  IrtIterator(IndirectReferenceTable* table, size_t i, size_t capacity)
+      REQUIRES_SHARED(Locks::mutator_lock_)
       : table_(table), i_(i), capacity_(capacity) {
   }
 
@@ -192,17 +197,14 @@ class IrtIterator {
     return *this;
   }
 
-  GcRoot<mirror::Object>* operator*() REQUIRES_SHARED(Locks::mutator_lock_) {
-    // This does not have a read barrier as this is used to visit roots.
-    return table_[i_].GetReference();
-  }
+  GcRoot<mirror::Object>* operator*() REQUIRES_SHARED(Locks::mutator_lock_);
 
   bool equals(const IrtIterator& rhs) const {
     return (i_ == rhs.i_ && table_ == rhs.table_);
   }
 
  private:
-  IrtEntry* const table_;
+  IndirectReferenceTable* const table_;
   size_t i_;
   const size_t capacity_;
 };
@@ -215,6 +217,45 @@ bool inline operator!=(const IrtIterator& lhs, const IrtIterator& rhs) {
   return !lhs.equals(rhs);
 }
 
+// Pool of released indirect reference table chunk maps. Every thread creates a local reference
+// table in JNIEnvExt::Create and destroys it when it exits, so keeping a few of the released maps
+// around lets short-lived threads skip the mmap, naming and munmap of their table.
+//
+// The maps are zeroed when they are returned to the pool, so a table built from a pooled map
+// looks exactly like one built from a fresh anonymous mapping. The pool keeps at most
+// kMaxPooledMaps maps and kMaxPooledBytes bytes, and Trim() unmaps all of them, which the heap
+// does when it trims after the app becomes idle.
+class IrtChunkPool {
+ public:
+  IrtChunkPool();
+  ~IrtChunkPool();
+
+  // Return a zeroed read-write map of `byte_count` bytes, reusing a pooled one if possible.
+  std::unique_ptr<MemMap> Allocate(size_t byte_count, std::string* error_msg)
+      REQUIRES(!lock_);
+
+  // Hand a map back to the pool. The map is unmapped if the pool is full.
+  void Free(std::unique_ptr<MemMap> map) REQUIRES(!lock_);
+
+  // Unmap all the pooled maps.
+  void Trim() REQUIRES(!lock_);
+
+  size_t GetPooledBytes() REQUIRES(!lock_);
+
+ private:
+  static constexpr size_t kMaxPooledMaps = 64u;
+  static constexpr size_t kMaxPooledBytes = 1 * MB;
+  // Maps up to this size are zeroed with memset, which keeps their pages for the next table.
+  // Larger ones are released with madvise.
+  static constexpr size_t kMaxMemsetBytes = 16 * KB;
+
+  Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  std::vector<std::unique_ptr<MemMap>> maps_ GUARDED_BY(lock_);
+  size_t pooled_bytes_ GUARDED_BY(lock_);
+
+  DISALLOW_COPY_AND_ASSIGN(IrtChunkPool);
+};
+
 class IndirectReferenceTable {
  public:
   enum class ResizableCapacity {
@@ -293,11 +334,11 @@ class IndirectReferenceTable {
 
   // Note IrtIterator does not have a read barrier as it's used to visit roots.
   IrtIterator begin() {
-    return IrtIterator(table_, 0, Capacity());
+    return IrtIterator(this, 0, Capacity());
   }
 
   IrtIterator end() {
-    return IrtIterator(table_, Capacity(), Capacity());
+    return IrtIterator(this, Capacity(), Capacity());
   }
 
   void VisitRoots(RootVisitor* visitor, const RootInfo& root_info)
@@ -324,7 +365,22 @@ class IndirectReferenceTable {
     return DecodeIndirectRefKind(reinterpret_cast<uintptr_t>(iref));
   }
 
+  // Return the entry at `index`. The entries live in chunks that never move, so this is safe
+  // to call while another thread grows the table.
+  ALWAYS_INLINE IrtEntry* GetEntry(size_t index) const {
+    if (LIKELY(index < first_chunk_entries_)) {
+      return &chunks_[0][index];
+    }
+    // Chunk `c` > 0 holds the entries [first_chunk_entries_ << (c - 1), first_chunk_entries_ << c).
+    size_t chunk = MostSignificantBit(index / first_chunk_entries_) + 1u;
+    DCHECK_LT(chunk, num_chunks_);
+    return &chunks_[chunk][index - (first_chunk_entries_ << (chunk - 1u))];
+  }
+
  private:
+  // Enough chunks to double the first chunk up to the maximum table size.
+  static constexpr size_t kMaxTableChunks = 32u;
+
   static constexpr size_t kSerialBits = MinimumBitsToStore(kIRTPrevCount);
   static constexpr uint32_t kShiftedSerialMask = (1u << kSerialBits) - 1;
 
@@ -370,15 +426,21 @@ class IndirectReferenceTable {
 
   IndirectRef ToIndirectRef(uint32_t table_index) const {
     DCHECK_LT(table_index, max_entries_);
-    uint32_t serial = table_[table_index].GetSerial();
+    uint32_t serial = GetEntry(table_index)->GetSerial();
     return reinterpret_cast<IndirectRef>(EncodeIndirectRef(table_index, serial));
   }
 
-  // Resize the backing table. Currently must be larger than the current size.
+  // Grow the table to at least `new_size` entries by adding chunks. Existing entries are not
+  // copied. Currently must be larger than the current size.
   bool Resize(size_t new_size, std::string* error_msg);
 
   void RecoverHoles(IRTSegmentState from);
 
+  size_t CountNullEntries(size_t from, size_t to) const;
+  void CheckHoleCount(size_t exp_num_holes,
+                      IRTSegmentState prev_state,
+                      IRTSegmentState cur_state) const;
+
   // Abort if check_jni is not enabled. Otherwise, just log as an error.
   static void AbortIfNoCheckJNI(const std::string& msg);
 
@@ -389,11 +451,15 @@ class IndirectReferenceTable {
   /// semi-public - read/write by jni down calls.
   IRTSegmentState segment_state_;
 
-  // Mem map where we store the indirect refs.
-  std::unique_ptr<MemMap> table_mem_map_;
-  // bottom of the stack. Do not directly access the object references
-  // in this as they are roots. Use Get() that has a read barrier.
-  IrtEntry* table_;
+  // Mem maps where we store the indirect refs. The first chunk holds the initial capacity and
+  // each resize appends chunks that double the capacity, so that entries stay in place and
+  // Get() needs no lock while the table grows. Do not directly access the object references
+  // in these as they are roots. Use Get() that has a read barrier.
+  std::unique_ptr<MemMap> chunk_maps_[kMaxTableChunks];
+  IrtEntry* chunks_[kMaxTableChunks];
+  size_t num_chunks_;
+  // The number of entries in the first chunk.
+  const size_t first_chunk_entries_;
   // bit mask, ORed into all irefs.
   const IndirectRefKind kind_;
 
@@ -411,6 +477,11 @@ class IndirectReferenceTable {
   ResizableCapacity resizable_;
 };
 
+inline GcRoot<mirror::Object>* IrtIterator::operator*() {
+  // This does not have a read barrier as this is used to visit roots.
+  return table_->GetEntry(i_)->GetReference();
+}
+
 }  // namespace art
 
 #endif  // ART_RUNTIME_INDIRECT_REFERENCE_TABLE_H_
@@ -20,6 +20,7 @@
 
 #include "class_linker-inl.h"
 #include "common_runtime_test.h"
+#include "mem_map.h"
 #include "mirror/object-inl.h"
 #include "scoped_thread_state_change-inl.h"
 
@@ -510,4 +511,114 @@ TEST_F(IndirectReferenceTableTest, Resize) {
   EXPECT_EQ(irt.Capacity(), kTableMax + 1);
 }
 
+TEST_F(IndirectReferenceTableTest, ResizeKeepsEntriesInPlace) {
+  ScopedObjectAccess soa(Thread::Current());
+  static const size_t kTableMax = 16;
+  static const size_t kNumRefs = 5 * kTableMax + 3;
+
+  mirror::Class* c = class_linker_->FindSystemClass(soa.Self(), "Ljava/lang/Object;");
+  StackHandleScope<2> hs(soa.Self());
+  ASSERT_TRUE(c != nullptr);
+  Handle<mirror::Object> obj0 = hs.NewHandle(c->AllocObject(soa.Self()));
+  ASSERT_TRUE(obj0 != nullptr);
+  Handle<mirror::Object> obj1 = hs.NewHandle(c->AllocObject(soa.Self()));
+  ASSERT_TRUE(obj1 != nullptr);
+
+  std::string error_msg;
+  IndirectReferenceTable irt(kTableMax,
+                             kLocal,
+                             IndirectReferenceTable::ResizableCapacity::kYes,
+                             &error_msg);
+  ASSERT_TRUE(irt.IsValid()) << error_msg;
+  const IRTSegmentState cookie = kIRTFirstSegment;
+
+  // Fill the first chunk and a few more, alternating the objects.
+  std::vector<IndirectRef> refs;
+  std::vector<const IrtEntry*> entries;
+  for (size_t i = 0; i != kNumRefs; ++i) {
+    refs.push_back(irt.Add(cookie, (i % 2 == 0) ? obj0.Get() : obj1.Get()));
+    entries.push_back(irt.GetEntry(i));
+  }
+  EXPECT_EQ(irt.Capacity(), kNumRefs);
+  for (size_t i = 0; i != kNumRefs; ++i) {
+    EXPECT_OBJ_PTR_EQ((i % 2 == 0) ? obj0.Get() : obj1.Get(), irt.Get(refs[i])) << i;
+    // Growing the table did not move the entry.
+    EXPECT_EQ(entries[i], irt.GetEntry(i)) << i;
+  }
+
+  // A hole in the first chunk is found from the last chunk.
+  ASSERT_TRUE(irt.Remove(cookie, refs[1]));
+  IndirectRef hole_ref = irt.Add(cookie, obj0.Get());
+  EXPECT_EQ(irt.Capacity(), kNumRefs);
+  EXPECT_OBJ_PTR_EQ(obj0.Get(), irt.Get(hole_ref));
+
+  // Visiting the table sees all the chunks.
+  size_t visited = 0u;
+  for (GcRoot<mirror::Object>* root : irt) {
+    EXPECT_FALSE(root->IsNull());
+    ++visited;
+  }
+  EXPECT_EQ(visited, kNumRefs);
+
+  irt.Trim();
+  for (size_t i = 0; i != kNumRefs; ++i) {
+    if (i != 1u) {
+      EXPECT_OBJ_PTR_EQ((i % 2 == 0) ? obj0.Get() : obj1.Get(), irt.Get(refs[i])) << i;
+    }
+  }
+}
+
+TEST_F(IndirectReferenceTableTest, ChunkPool) {
+  ScopedObjectAccess soa(Thread::Current());
+  static const size_t kTableMax = 1024;
+
+  IrtChunkPool pool;
+  std::string error_msg;
+  const size_t byte_count = kTableMax * sizeof(IrtEntry);
+  std::unique_ptr<MemMap> map = pool.Allocate(byte_count, &error_msg);
+  ASSERT_TRUE(map != nullptr) << error_msg;
+  uint8_t* begin = map->Begin();
+  memset(begin, 0xff, byte_count);
+
+  // A freed map is handed out again for the same size, zeroed.
+  pool.Free(std::move(map));
+  EXPECT_EQ(byte_count, pool.GetPooledBytes());
+  std::unique_ptr<MemMap> other = pool.Allocate(2 * byte_count, &error_msg);
+  ASSERT_TRUE(other != nullptr) << error_msg;
+  EXPECT_NE(begin, other->Begin());
+  map = pool.Allocate(byte_count, &error_msg);
+  ASSERT_TRUE(map != nullptr) << error_msg;
+  EXPECT_EQ(begin, map->Begin());
+  EXPECT_EQ(0u, pool.GetPooledBytes());
+  for (size_t i = 0; i != byte_count; ++i) {
+    ASSERT_EQ(0u, begin[i]) << i;
+  }
+
+  // Trimming unmaps the pooled maps.
+  pool.Free(std::move(map));
+  pool.Free(std::move(other));
+  EXPECT_EQ(3 * byte_count, pool.GetPooledBytes());
+  pool.Trim();
+  EXPECT_EQ(0u, pool.GetPooledBytes());
+
+  // A table returns its chunks to the runtime pool and the next table reuses them.
+  const IrtEntry* first_entry;
+  {
+    IndirectReferenceTable irt(kTableMax,
+                               kLocal,
+                               IndirectReferenceTable::ResizableCapacity::kNo,
+                               &error_msg);
+    ASSERT_TRUE(irt.IsValid()) << error_msg;
+    first_entry = irt.GetEntry(0u);
+  }
+  {
+    IndirectReferenceTable irt(kTableMax,
+                               kLocal,
+                               IndirectReferenceTable::ResizableCapacity::kNo,
+                               &error_msg);
+    ASSERT_TRUE(irt.IsValid()) << error_msg;
+    EXPECT_EQ(first_entry, irt.GetEntry(0u));
+  }
+}
+
 }  // namespace art
@@ -40,6 +40,7 @@
 #include "mirror/object-inl.h"
 #include "nth_caller_visitor.h"
 #include "oat_quick_method_header.h"
+#include "quick_frame_cache.h"
 #include "thread.h"
 #include "thread_list.h"
 
@@ -804,6 +805,7 @@ void Instrumentation::Deoptimize(ArtMethod* method) {
   CHECK(method->IsInvokable());
 
   Thread* self = Thread::Current();
+  QuickFrameCache::InvalidateAll();
   {
     WriterMutexLock mu(self, deoptimized_methods_lock_);
     bool has_not_been_deoptimized = AddDeoptimizedMethod(method);
@@ -905,6 +907,7 @@ bool Instrumentation::ShouldNotifyMethodEnterExitEvents() const {
 
 void Instrumentation::DeoptimizeEverything(const char* key) {
   CHECK(deoptimization_enabled_);
+  QuickFrameCache::InvalidateAll();
   ConfigureStubs(key, InstrumentationLevel::kInstrumentWithInterpreter);
 }
 
@@ -194,6 +194,9 @@ class Instrumentation {
   bool AreAllMethodsDeoptimized() const {
     return interpreter_stubs_installed_;
   }
+  bool IsDeoptimizationEnabled() const {
+    return deoptimization_enabled_;
+  }
   bool ShouldNotifyMethodEnterExitEvents() const REQUIRES_SHARED(Locks::mutator_lock_);
 
   // Executes everything with interpreter.
@@ -35,24 +35,44 @@
 namespace art {
 
 InternTable::InternTable()
-    : log_new_roots_(false),
-      weak_intern_condition_("New intern condition", *Locks::intern_table_lock_),
+    : weak_intern_condition_("New intern condition", *Locks::intern_table_lock_),
+      image_tables_(nullptr),
       weak_root_state_(gc::kWeakRootStateNormal) {
 }
 
+InternTable::Stripe::Stripe()
+    : lock("InternTable stripe lock", kInternTableStripeLock),
+      log_new_roots(false) {
+}
+
 size_t InternTable::Size() const {
-  MutexLock mu(Thread::Current(), *Locks::intern_table_lock_);
-  return strong_interns_.Size() + weak_interns_.Size();
+  return StrongSize() + WeakSize();
 }
 
 size_t InternTable::StrongSize() const {
-  MutexLock mu(Thread::Current(), *Locks::intern_table_lock_);
-  return strong_interns_.Size();
+  Thread* const self = Thread::Current();
+  size_t size = 0u;
+  {
+    MutexLock mu(self, *Locks::intern_table_lock_);
+    for (const UnorderedSet& set : image_sets_) {
+      size += set.Size();
+    }
+  }
+  for (const Stripe& stripe : stripes_) {
+    MutexLock mu(self, stripe.lock);
+    size += stripe.strong_interns.Size();
+  }
+  return size;
 }
 
 size_t InternTable::WeakSize() const {
-  MutexLock mu(Thread::Current(), *Locks::intern_table_lock_);
-  return weak_interns_.Size();
+  Thread* const self = Thread::Current();
+  size_t size = 0u;
+  for (const Stripe& stripe : stripes_) {
+    MutexLock mu(self, stripe.lock);
+    size += stripe.weak_interns.Size();
+  }
+  return size;
 }
 
 void InternTable::DumpForSigQuit(std::ostream& os) const {
@@ -60,42 +80,79 @@ void InternTable::DumpForSigQuit(std::ostream& os) const {
 }
 
 void InternTable::VisitRoots(RootVisitor* visitor, VisitRootFlags flags) {
-  MutexLock mu(Thread::Current(), *Locks::intern_table_lock_);
+  Thread* const self = Thread::Current();
   if ((flags & kVisitRootFlagAllRoots) != 0) {
-    strong_interns_.VisitRoots(visitor);
-  } else if ((flags & kVisitRootFlagNewRoots) != 0) {
-    for (auto& root : new_strong_intern_roots_) {
-      ObjPtr<mirror::String> old_ref = root.Read<kWithoutReadBarrier>();
-      root.VisitRoot(visitor, RootInfo(kRootInternedString));
-      ObjPtr<mirror::String> new_ref = root.Read<kWithoutReadBarrier>();
-      if (new_ref != old_ref) {
-        // The GC moved a root in the log. Need to search the strong interns and update the
-        // corresponding object. This is slow, but luckily for us, this may only happen with a
-        // concurrent moving GC.
-        strong_interns_.Remove(old_ref);
-        strong_interns_.Insert(new_ref);
+    MutexLock mu(self, *Locks::intern_table_lock_);
+    BufferedRootVisitor<kDefaultBufferedRootCount> buffered_visitor(
+        visitor, RootInfo(kRootInternedString));
+    for (UnorderedSet& set : image_sets_) {
+      for (auto& intern : set) {
+        buffered_visitor.VisitRoot(intern);
       }
     }
   }
-  if ((flags & kVisitRootFlagClearRootLog) != 0) {
-    new_strong_intern_roots_.clear();
+  for (Stripe& stripe : stripes_) {
+    MutexLock mu(self, stripe.lock);
+    if ((flags & kVisitRootFlagAllRoots) != 0) {
+      stripe.strong_interns.VisitRoots(visitor);
+    } else if ((flags & kVisitRootFlagNewRoots) != 0) {
+      for (auto& root : stripe.new_strong_intern_roots) {
+        ObjPtr<mirror::String> old_ref = root.Read<kWithoutReadBarrier>();
+        root.VisitRoot(visitor, RootInfo(kRootInternedString));
+        ObjPtr<mirror::String> new_ref = root.Read<kWithoutReadBarrier>();
+        if (new_ref != old_ref) {
+          // The GC moved a root in the log. Need to search the strong interns and update the
+          // corresponding object. This is slow, but luckily for us, this may only happen with a
+          // concurrent moving GC.
+          stripe.strong_interns.Remove(old_ref);
+          stripe.strong_interns.Insert(new_ref);
+        }
+      }
+    }
+    if ((flags & kVisitRootFlagClearRootLog) != 0) {
+      stripe.new_strong_intern_roots.clear();
+    }
+    if ((flags & kVisitRootFlagStartLoggingNewRoots) != 0) {
+      stripe.log_new_roots = true;
+    } else if ((flags & kVisitRootFlagStopLoggingNewRoots) != 0) {
+      stripe.log_new_roots = false;
+    }
   }
-  if ((flags & kVisitRootFlagStartLoggingNewRoots) != 0) {
-    log_new_roots_ = true;
-  } else if ((flags & kVisitRootFlagStopLoggingNewRoots) != 0) {
-    log_new_roots_ = false;
+  // Note: we deliberately don't visit the weak tables and the immutable image roots.
+}
+
+InternTable::Stripe& InternTable::GetStripe(ObjPtr<mirror::String> s) {
+  return stripes_[StripeIndex(s->GetHashCode())];
+}
+
+template <typename Key>
+ObjPtr<mirror::String> InternTable::LookupImageStrong(const Key& key) {
+  const ImageTables* image_tables = image_tables_.LoadAcquire();
+  if (image_tables != nullptr) {
+    for (const UnorderedSet* set : *image_tables) {
+      auto it = set->Find(key);
+      if (it != set->end()) {
+        return it->Read();
+      }
+    }
   }
-  // Note: we deliberately don't visit the weak_interns_ table and the immutable image roots.
+  return nullptr;
 }
 
 ObjPtr<mirror::String> InternTable::LookupWeak(Thread* self, ObjPtr<mirror::String> s) {
-  MutexLock mu(self, *Locks::intern_table_lock_);
-  return LookupWeakLocked(s);
+  Stripe& stripe = GetStripe(s);
+  MutexLock mu(self, stripe.lock);
+  return stripe.weak_interns.Find(s);
 }
 
 ObjPtr<mirror::String> InternTable::LookupStrong(Thread* self, ObjPtr<mirror::String> s) {
-  MutexLock mu(self, *Locks::intern_table_lock_);
-  return LookupStrongLocked(s);
+  ObjPtr<mirror::String> image_string = LookupImageStrong(GcRoot<mirror::String>(s));
+  if (image_string != nullptr) {
+    return image_string;
+  }
+  Stripe& stripe = GetStripe(s);
+  MutexLock mu(self, stripe.lock);
+  return stripe.strong_interns.Find(s);
 }
 
 ObjPtr<mirror::String> InternTable::LookupStrong(Thread* self,
@@ -105,76 +162,84 @@ ObjPtr<mirror::String> InternTable::LookupStrong(Thread* self,
   Utf8String string(utf16_length,
                     utf8_data,
                     ComputeUtf16HashFromModifiedUtf8(utf8_data, utf16_length));
-  MutexLock mu(self, *Locks::intern_table_lock_);
-  return strong_interns_.Find(string);
-}
-
-ObjPtr<mirror::String> InternTable::LookupWeakLocked(ObjPtr<mirror::String> s) {
-  return weak_interns_.Find(s);
-}
-
-ObjPtr<mirror::String> InternTable::LookupStrongLocked(ObjPtr<mirror::String> s) {
-  return strong_interns_.Find(s);
+  ObjPtr<mirror::String> image_string = LookupImageStrong(string);
+  if (image_string != nullptr) {
+    return image_string;
+  }
+  Stripe& stripe = GetStripe(string);
+  MutexLock mu(self, stripe.lock);
+  return stripe.strong_interns.Find(string);
 }
 
 void InternTable::AddNewTable() {
-  MutexLock mu(Thread::Current(), *Locks::intern_table_lock_);
-  weak_interns_.AddNewTable();
-  strong_interns_.AddNewTable();
+  Thread* const self = Thread::Current();
+  for (Stripe& stripe : stripes_) {
+    MutexLock mu(self, stripe.lock);
+    stripe.weak_interns.AddNewTable();
+    stripe.strong_interns.AddNewTable();
+  }
 }
 
-ObjPtr<mirror::String> InternTable::InsertStrong(ObjPtr<mirror::String> s) {
+ObjPtr<mirror::String> InternTable::InsertStrong(Stripe* stripe, ObjPtr<mirror::String> s) {
   Runtime* runtime = Runtime::Current();
   if (runtime->IsActiveTransaction()) {
     runtime->RecordStrongStringInsertion(s);
   }
-  if (log_new_roots_) {
-    new_strong_intern_roots_.push_back(GcRoot<mirror::String>(s));
+  if (stripe->log_new_roots) {
+    stripe->new_strong_intern_roots.push_back(GcRoot<mirror::String>(s));
   }
-  strong_interns_.Insert(s);
+  stripe->strong_interns.Insert(s);
   return s;
 }
 
-ObjPtr<mirror::String> InternTable::InsertWeak(ObjPtr<mirror::String> s) {
+ObjPtr<mirror::String> InternTable::InsertWeak(Stripe* stripe, ObjPtr<mirror::String> s) {
   Runtime* runtime = Runtime::Current();
   if (runtime->IsActiveTransaction()) {
     runtime->RecordWeakStringInsertion(s);
   }
-  weak_interns_.Insert(s);
+  stripe->weak_interns.Insert(s);
   return s;
 }
 
-void InternTable::RemoveStrong(ObjPtr<mirror::String> s) {
-  strong_interns_.Remove(s);
+void InternTable::RemoveStrong(Stripe* stripe, ObjPtr<mirror::String> s) {
+  stripe->strong_interns.Remove(s);
 }
 
-void InternTable::RemoveWeak(ObjPtr<mirror::String> s) {
+void InternTable::RemoveWeak(Stripe* stripe, ObjPtr<mirror::String> s) {
   Runtime* runtime = Runtime::Current();
   if (runtime->IsActiveTransaction()) {
     runtime->RecordWeakStringRemoval(s);
   }
-  weak_interns_.Remove(s);
+  stripe->weak_interns.Remove(s);
 }
 
 // Insert/remove methods used to undo changes made during an aborted transaction.
 ObjPtr<mirror::String> InternTable::InsertStrongFromTransaction(ObjPtr<mirror::String> s) {
   DCHECK(!Runtime::Current()->IsActiveTransaction());
-  return InsertStrong(s);
+  Stripe& stripe = GetStripe(s);
+  MutexLock mu(Thread::Current(), stripe.lock);
+  return InsertStrong(&stripe, s);
 }
 
 ObjPtr<mirror::String> InternTable::InsertWeakFromTransaction(ObjPtr<mirror::String> s) {
   DCHECK(!Runtime::Current()->IsActiveTransaction());
-  return InsertWeak(s);
+  Stripe& stripe = GetStripe(s);
+  MutexLock mu(Thread::Current(), stripe.lock);
+  return InsertWeak(&stripe, s);
 }
 
 void InternTable::RemoveStrongFromTransaction(ObjPtr<mirror::String> s) {
   DCHECK(!Runtime::Current()->IsActiveTransaction());
-  RemoveStrong(s);
+  Stripe& stripe = GetStripe(s);
+  MutexLock mu(Thread::Current(), stripe.lock);
+  RemoveStrong(&stripe, s);
 }
 
 void InternTable::RemoveWeakFromTransaction(ObjPtr<mirror::String> s) {
   DCHECK(!Runtime::Current()->IsActiveTransaction());
-  RemoveWeak(s);
+  Stripe& stripe = GetStripe(s);
+  MutexLock mu(Thread::Current(), stripe.lock);
+  RemoveWeak(&stripe, s);
 }
 
 void InternTable::AddImagesStringsToTable(const std::vector<gc::space::ImageSpace*>& image_spaces) {
@@ -195,17 +260,22 @@ void InternTable::BroadcastForNewInterns() {
   weak_intern_condition_.Broadcast(self);
 }
 
-void InternTable::WaitUntilAccessible(Thread* self) {
-  Locks::intern_table_lock_->ExclusiveUnlock(self);
+bool InternTable::IsWeakAccessible(Thread* self) const {
+  return kUseReadBarrier
+      ? self->GetWeakRefAccessEnabled()
+      : weak_root_state_.LoadSequentiallyConsistent() != gc::kWeakRootStateNoReadsOrWrites;
+}
+
+void InternTable::WaitUntilAccessible(Thread* self, Stripe* stripe) {
+  stripe->lock.ExclusiveUnlock(self);
   {
     ScopedThreadSuspension sts(self, kWaitingWeakGcRootRead);
     MutexLock mu(self, *Locks::intern_table_lock_);
-    while ((!kUseReadBarrier && weak_root_state_ == gc::kWeakRootStateNoReadsOrWrites) ||
-           (kUseReadBarrier && !self->GetWeakRefAccessEnabled())) {
+    while (!IsWeakAccessible(self)) {
       weak_intern_condition_.Wait(self);
     }
   }
-  Locks::intern_table_lock_->ExclusiveLock(self);
+  stripe->lock.ExclusiveLock(self);
 }
 
 ObjPtr<mirror::String> InternTable::Insert(ObjPtr<mirror::String> s,
@@ -215,26 +285,27 @@ ObjPtr<mirror::String> InternTable::Insert(ObjPtr<mirror::String> s,
     return nullptr;
   }
   Thread* const self = Thread::Current();
-  MutexLock mu(self, *Locks::intern_table_lock_);
+  // Image strings are strong and never removed, no need to lock or to check the weak root state.
+  ObjPtr<mirror::String> image_string = LookupImageStrong(GcRoot<mirror::String>(s));
+  if (image_string != nullptr) {
+    return image_string;
+  }
+  Stripe* const stripe = &GetStripe(s);
+  MutexLock mu(self, stripe->lock);
   if (kDebugLocking && !holding_locks) {
     Locks::mutator_lock_->AssertSharedHeld(self);
     CHECK_EQ(2u, self->NumberOfHeldMutexes()) << "may only safely hold the mutator lock";
   }
   while (true) {
     if (holding_locks) {
-      if (!kUseReadBarrier) {
-        CHECK_EQ(weak_root_state_, gc::kWeakRootStateNormal);
-      } else {
-        CHECK(self->GetWeakRefAccessEnabled());
-      }
+      CHECK(IsWeakAccessible(self));
     }
     // Check the strong table for a match.
-    ObjPtr<mirror::String> strong = LookupStrongLocked(s);
+    ObjPtr<mirror::String> strong = stripe->strong_interns.Find(s);
     if (strong != nullptr) {
       return strong;
     }
-    if ((!kUseReadBarrier && weak_root_state_ != gc::kWeakRootStateNoReadsOrWrites) ||
-        (kUseReadBarrier && self->GetWeakRefAccessEnabled())) {
+    if (IsWeakAccessible(self)) {
       break;
     }
     // weak_root_state_ is set to gc::kWeakRootStateNoReadsOrWrites in the GC pause but is only
@@ -243,25 +314,21 @@ ObjPtr<mirror::String> InternTable::Insert(ObjPtr<mirror::String> s,
     CHECK(!holding_locks);
     StackHandleScope<1> hs(self);
     auto h = hs.NewHandleWrapper(&s);
-    WaitUntilAccessible(self);
-  }
-  if (!kUseReadBarrier) {
-    CHECK_EQ(weak_root_state_, gc::kWeakRootStateNormal);
-  } else {
-    CHECK(self->GetWeakRefAccessEnabled());
+    WaitUntilAccessible(self, stripe);
   }
+  CHECK(IsWeakAccessible(self));
   // There is no match in the strong table, check the weak table.
-  ObjPtr<mirror::String> weak = LookupWeakLocked(s);
+  ObjPtr<mirror::String> weak = stripe->weak_interns.Find(s);
   if (weak != nullptr) {
     if (is_strong) {
       // A match was found in the weak table. Promote to the strong table.
-      RemoveWeak(weak);
-      return InsertStrong(weak);
+      RemoveWeak(stripe, weak);
+      return InsertStrong(stripe, weak);
     }
     return weak;
   }
   // No match in the strong table or the weak table. Insert into the strong / weak table.
-  return is_strong ? InsertStrong(s) : InsertWeak(s);
+  return is_strong ? InsertStrong(stripe, s) : InsertWeak(stripe, s);
 }
 
 ObjPtr<mirror::String> InternTable::InternStrong(int32_t utf16_length, const char* utf8_data) {
@@ -299,8 +366,12 @@ bool InternTable::ContainsWeak(ObjPtr<mirror::String> s) {
 }
 
 void InternTable::SweepInternTableWeaks(IsMarkedVisitor* visitor) {
-  MutexLock mu(Thread::Current(), *Locks::intern_table_lock_);
-  weak_interns_.SweepWeaks(visitor);
+  // The stripes are independent, each one is swept under its own lock.
+  Thread* const self = Thread::Current();
+  for (Stripe& stripe : stripes_) {
+    MutexLock mu(self, stripe.lock);
+    stripe.weak_interns.SweepWeaks(visitor);
+  }
 }
 
 size_t InternTable::AddTableFromMemory(const uint8_t* ptr) {
@@ -308,13 +379,71 @@ size_t InternTable::AddTableFromMemory(const uint8_t* ptr) {
   return AddTableFromMemoryLocked(ptr);
 }
 
+size_t InternTable::VisitRootsInMemory(uint8_t* ptr, RootVisitor* visitor) {
+  size_t read_count = 0;
+  UnorderedSet set(ptr, /*make copy*/false, &read_count);
+  BufferedRootVisitor<kDefaultBufferedRootCount> buffered_visitor(
+      visitor, RootInfo(kRootInternedString));
+  for (GcRoot<mirror::String>& intern : set) {
+    buffered_visitor.VisitRoot(intern);
+  }
+  return read_count;
+}
+
 size_t InternTable::AddTableFromMemoryLocked(const uint8_t* ptr) {
-  return strong_interns_.AddTableFromMemory(ptr);
+  size_t read_count = 0;
+  UnorderedSet set(ptr, /*make copy*/false, &read_count);
+  if (set.Empty()) {
+    // Avoid inserting empty sets.
+    return read_count;
+  }
+  // TODO: Disable this for app images if app images have intern tables.
+  static constexpr bool kCheckDuplicates = true;
+  if (kCheckDuplicates) {
+    Thread* const self = Thread::Current();
+    for (GcRoot<mirror::String>& string : set) {
+      Stripe& stripe = GetStripe(string.Read());
+      MutexLock mu(self, stripe.lock);
+      CHECK(LookupImageStrong(string) == nullptr &&
+            stripe.strong_interns.Find(string.Read()) == nullptr)
+          << "Already found " << string.Read()->ToModifiedUtf8();
+    }
+  }
+  // Publish a new array of image tables for the lock-free lookups. The old array may still be
+  // in use by readers, keep it alive.
+  image_sets_.push_back(std::move(set));
+  std::unique_ptr<ImageTables> image_tables(new ImageTables());
+  for (const UnorderedSet& image_set : image_sets_) {
+    image_tables->push_back(&image_set);
+  }
+  image_tables_.StoreRelease(image_tables.get());
+  image_tables_history_.push_back(std::move(image_tables));
+  return read_count;
 }
 
 size_t InternTable::WriteToMemory(uint8_t* ptr) {
-  MutexLock mu(Thread::Current(), *Locks::intern_table_lock_);
-  return strong_interns_.WriteToMemory(ptr);
+  // Combine the image tables and the strong tables of all the stripes into a single one.
+  Thread* const self = Thread::Current();
+  Runtime* const runtime = Runtime::Current();
+  UnorderedSet combined;
+  combined.SetLoadFactor(runtime->GetHashTableMinLoadFactor(),
+                         runtime->GetHashTableMaxLoadFactor());
+  {
+    MutexLock mu(self, *Locks::intern_table_lock_);
+    for (const UnorderedSet& set : image_sets_) {
+      for (const GcRoot<mirror::String>& string : set) {
+        combined.Insert(string);
+      }
+    }
+  }
+  for (Stripe& stripe : stripes_) {
+    MutexLock mu(self, stripe.lock);
+    stripe.strong_interns.CopyTo(&combined);
+  }
+  if (combined.Empty()) {
+    return 0;
+  }
+  return combined.WriteToMemory(ptr);
 }
 
 std::size_t InternTable::StringHashEquals::operator()(const GcRoot<mirror::String>& root) const {
@@ -363,44 +492,6 @@ bool InternTable::StringHashEquals::operator()(const GcRoot<mirror::String>& a,
   }
 }
 
-size_t InternTable::Table::AddTableFromMemory(const uint8_t* ptr) {
-  size_t read_count = 0;
-  UnorderedSet set(ptr, /*make copy*/false, &read_count);
-  if (set.Empty()) {
-    // Avoid inserting empty sets.
-    return read_count;
-  }
-  // TODO: Disable this for app images if app images have intern tables.
-  static constexpr bool kCheckDuplicates = true;
-  if (kCheckDuplicates) {
-    for (GcRoot<mirror::String>& string : set) {
-      CHECK(Find(string.Read()) == nullptr) << "Already found " << string.Read()->ToModifiedUtf8();
-    }
-  }
-  // Insert at the front since we add new interns into the back.
-  tables_.insert(tables_.begin(), std::move(set));
-  return read_count;
-}
-
-size_t InternTable::Table::WriteToMemory(uint8_t* ptr) {
-  if (tables_.empty()) {
-    return 0;
-  }
-  UnorderedSet* table_to_write;
-  UnorderedSet combined;
-  if (tables_.size() > 1) {
-    table_to_write = &combined;
-    for (UnorderedSet& table : tables_) {
-      for (GcRoot<mirror::String>& string : table) {
-        combined.Insert(string);
-      }
-    }
-  } else {
-    table_to_write = &tables_.back();
-  }
-  return table_to_write->WriteToMemory(ptr);
-}
-
 void InternTable::Table::Remove(ObjPtr<mirror::String> s) {
   for (UnorderedSet& table : tables_) {
     auto it = table.Find(GcRoot<mirror::String>(s));
@@ -413,7 +504,6 @@ void InternTable::Table::Remove(ObjPtr<mirror::String> s) {
 }
 
 ObjPtr<mirror::String> InternTable::Table::Find(ObjPtr<mirror::String> s) {
-  Locks::intern_table_lock_->AssertHeld(Thread::Current());
   for (UnorderedSet& table : tables_) {
     auto it = table.Find(GcRoot<mirror::String>(s));
     if (it != table.end()) {
@@ -424,7 +514,6 @@ ObjPtr<mirror::String> InternTable::Table::Find(ObjPtr<mirror::String> s) {
 }
 
 ObjPtr<mirror::String> InternTable::Table::Find(const Utf8String& string) {
-  Locks::intern_table_lock_->AssertHeld(Thread::Current());
   for (UnorderedSet& table : tables_) {
     auto it = table.Find(string);
     if (it != table.end()) {
@@ -434,12 +523,20 @@ ObjPtr<mirror::String> InternTable::Table::Find(const Utf8String& string) {
   return nullptr;
 }
 
+void InternTable::Table::CopyTo(UnorderedSet* set) const {
+  for (const UnorderedSet& table : tables_) {
+    for (const GcRoot<mirror::String>& string : table) {
+      set->Insert(string);
+    }
+  }
+}
+
 void InternTable::Table::AddNewTable() {
   tables_.push_back(UnorderedSet());
 }
 
 void InternTable::Table::Insert(ObjPtr<mirror::String> s) {
-  // Always insert the last table, the image tables are before and we avoid inserting into these
+  // Always insert the last table, the zygote tables are before and we avoid inserting into these
   // to prevent dirty pages.
   DCHECK(!tables_.empty());
   tables_.back().Insert(GcRoot<mirror::String>(s));
@@ -491,7 +588,7 @@ void InternTable::ChangeWeakRootState(gc::WeakRootState new_state) {
 
 void InternTable::ChangeWeakRootStateLocked(gc::WeakRootState new_state) {
   CHECK(!kUseReadBarrier);
-  weak_root_state_ = new_state;
+  weak_root_state_.StoreSequentiallyConsistent(new_state);
   if (new_state != gc::kWeakRootStateNoReadsOrWrites) {
     weak_intern_condition_.Broadcast(Thread::Current());
   }
@@ -17,10 +17,14 @@
 #ifndef ART_RUNTIME_INTERN_TABLE_H_
 #define ART_RUNTIME_INTERN_TABLE_H_
 
+#include <list>
+#include <memory>
 #include <unordered_set>
+#include <vector>
 
 #include "atomic.h"
 #include "base/allocator.h"
+#include "base/bit_utils.h"
 #include "base/hash_set.h"
 #include "base/mutex.h"
 #include "gc_root.h"
@@ -52,6 +56,10 @@ class Transaction;
  * String.intern. Some code (XML parsers being a prime example) relies on being able to intern
  * arbitrarily many strings for the duration of a parse without permanently increasing the memory
  * footprint.
+ *
+ * The strings interned at runtime are striped by hash, each stripe with its own lock, so that
+ * threads interning different strings rarely contend. The tables read from images are never
+ * modified and are looked up without a lock.
  */
 class InternTable {
  public:
@@ -131,6 +139,12 @@ class InternTable {
   size_t AddTableFromMemory(const uint8_t* ptr) REQUIRES(!Locks::intern_table_lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Visit the roots of an intern table in memory, as written by WriteToMemory, without adding
+  // it to an intern table. Unlike AddTableFromMemory, the strings are not read, so the roots may
+  // be updated to addresses that are not mapped yet, e.g. to relocate an image.
+  static size_t VisitRootsInMemory(uint8_t* ptr, RootVisitor* visitor)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
   // Write the post zygote intern table to a pointer. Only writes the strong interns since it is
   // expected that there is no weak interns since this is called from the image writer.
   size_t WriteToMemory(uint8_t* ptr) REQUIRES_SHARED(Locks::mutator_lock_)
@@ -182,42 +196,29 @@ class InternTable {
     }
   };
 
+  typedef HashSet<GcRoot<mirror::String>, GcRootEmptyFn, StringHashEquals, StringHashEquals,
+      TrackingAllocator<GcRoot<mirror::String>, kAllocatorTagInternTable>> UnorderedSet;
+
   // Table which holds pre zygote and post zygote interned strings. There is one instance for
-  // weak interns and strong interns.
+  // weak interns and strong interns of each stripe. Callers hold the lock of the stripe.
   class Table {
    public:
     Table();
-    ObjPtr<mirror::String> Find(ObjPtr<mirror::String> s) REQUIRES_SHARED(Locks::mutator_lock_)
-        REQUIRES(Locks::intern_table_lock_);
-    ObjPtr<mirror::String> Find(const Utf8String& string) REQUIRES_SHARED(Locks::mutator_lock_)
-        REQUIRES(Locks::intern_table_lock_);
-    void Insert(ObjPtr<mirror::String> s) REQUIRES_SHARED(Locks::mutator_lock_)
-        REQUIRES(Locks::intern_table_lock_);
-    void Remove(ObjPtr<mirror::String> s)
-        REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(Locks::intern_table_lock_);
-    void VisitRoots(RootVisitor* visitor)
-        REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(Locks::intern_table_lock_);
-    void SweepWeaks(IsMarkedVisitor* visitor)
-        REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(Locks::intern_table_lock_);
+    ObjPtr<mirror::String> Find(ObjPtr<mirror::String> s) REQUIRES_SHARED(Locks::mutator_lock_);
+    ObjPtr<mirror::String> Find(const Utf8String& string) REQUIRES_SHARED(Locks::mutator_lock_);
+    void Insert(ObjPtr<mirror::String> s) REQUIRES_SHARED(Locks::mutator_lock_);
+    void Remove(ObjPtr<mirror::String> s) REQUIRES_SHARED(Locks::mutator_lock_);
+    void VisitRoots(RootVisitor* visitor) REQUIRES_SHARED(Locks::mutator_lock_);
+    void SweepWeaks(IsMarkedVisitor* visitor) REQUIRES_SHARED(Locks::mutator_lock_);
     // Add a new intern table that will only be inserted into from now on.
-    void AddNewTable() REQUIRES(Locks::intern_table_lock_);
-    size_t Size() const REQUIRES(Locks::intern_table_lock_);
-    // Read and add an intern table from ptr.
-    // Tables read are inserted at the front of the table array. Only checks for conflicts in
-    // debug builds. Returns how many bytes were read.
-    size_t AddTableFromMemory(const uint8_t* ptr)
-        REQUIRES(Locks::intern_table_lock_) REQUIRES_SHARED(Locks::mutator_lock_);
-    // Write the intern tables to ptr, if there are multiple tables they are combined into a single
-    // one. Returns how many bytes were written.
-    size_t WriteToMemory(uint8_t* ptr)
-        REQUIRES(Locks::intern_table_lock_) REQUIRES_SHARED(Locks::mutator_lock_);
+    void AddNewTable();
+    size_t Size() const;
+    // Insert all the strings of the table into `set`.
+    void CopyTo(UnorderedSet* set) const;
 
    private:
-    typedef HashSet<GcRoot<mirror::String>, GcRootEmptyFn, StringHashEquals, StringHashEquals,
-        TrackingAllocator<GcRoot<mirror::String>, kAllocatorTagInternTable>> UnorderedSet;
-
     void SweepWeaks(UnorderedSet* set, IsMarkedVisitor* visitor)
-        REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(Locks::intern_table_lock_);
+        REQUIRES_SHARED(Locks::mutator_lock_);
 
     // We call AddNewTable when we create the zygote to reduce private dirty pages caused by
     // modifying the zygote intern table. The back of table is modified when strings are interned.
@@ -226,34 +227,70 @@ class InternTable {
     ART_FRIEND_TEST(InternTableTest, CrossHash);
   };
 
+  // The strong and weak interns whose hashes map to the same stripe. A string is in the stripe
+  // of its hash in both tables, so one lock covers the promotion of a weak intern to strong.
+  struct Stripe {
+    Stripe();
+
+    mutable Mutex lock;
+    bool log_new_roots GUARDED_BY(lock);
+    // Since this contains (strong) roots, they need a read barrier to
+    // enable concurrent intern table (strong) root scan. Do not
+    // directly access the strings in it. Use functions that contain
+    // read barriers.
+    Table strong_interns GUARDED_BY(lock);
+    std::vector<GcRoot<mirror::String>> new_strong_intern_roots GUARDED_BY(lock);
+    // Since this contains (weak) roots, they need a read barrier. Do
+    // not directly access the strings in it. Use functions that contain
+    // read barriers.
+    Table weak_interns GUARDED_BY(lock);
+  };
+
+  // The image tables are never modified once added, they are looked up through an immutable
+  // array of pointers that is replaced when a table is added.
+  using ImageTables = std::vector<const UnorderedSet*>;
+
+  static constexpr size_t kNumStripes = 16u;
+
+  static size_t StripeIndex(int32_t hash) {
+    // Java string hashes of short strings only use the low bits, mix them into the top bits.
+    static_assert(IsPowerOfTwo(kNumStripes), "kNumStripes must be a power of two");
+    return (static_cast<uint32_t>(hash) * 0x9e3779b9u) >> (32u - WhichPowerOf2(kNumStripes));
+  }
+
+  Stripe& GetStripe(ObjPtr<mirror::String> s) REQUIRES_SHARED(Locks::mutator_lock_);
+  Stripe& GetStripe(const Utf8String& string) {
+    return stripes_[StripeIndex(string.GetHash())];
+  }
+
+  // Look up a string in the image tables, without a lock.
+  template <typename Key>
+  ObjPtr<mirror::String> LookupImageStrong(const Key& key) REQUIRES_SHARED(Locks::mutator_lock_);
+
   // Insert if non null, otherwise return null. Must be called holding the mutator lock.
   // If holding_locks is true, then we may also hold other locks. If holding_locks is true, then we
   // require GC is not running since it is not safe to wait while holding locks.
   ObjPtr<mirror::String> Insert(ObjPtr<mirror::String> s, bool is_strong, bool holding_locks)
       REQUIRES(!Locks::intern_table_lock_) REQUIRES_SHARED(Locks::mutator_lock_);
 
-  ObjPtr<mirror::String> LookupStrongLocked(ObjPtr<mirror::String> s)
-      REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(Locks::intern_table_lock_);
-  ObjPtr<mirror::String> LookupWeakLocked(ObjPtr<mirror::String> s)
-      REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(Locks::intern_table_lock_);
-  ObjPtr<mirror::String> InsertStrong(ObjPtr<mirror::String> s)
-      REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(Locks::intern_table_lock_);
-  ObjPtr<mirror::String> InsertWeak(ObjPtr<mirror::String> s)
-      REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(Locks::intern_table_lock_);
-  void RemoveStrong(ObjPtr<mirror::String> s)
-      REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(Locks::intern_table_lock_);
-  void RemoveWeak(ObjPtr<mirror::String> s)
-      REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(Locks::intern_table_lock_);
+  ObjPtr<mirror::String> InsertStrong(Stripe* stripe, ObjPtr<mirror::String> s)
+      REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(stripe->lock);
+  ObjPtr<mirror::String> InsertWeak(Stripe* stripe, ObjPtr<mirror::String> s)
+      REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(stripe->lock);
+  void RemoveStrong(Stripe* stripe, ObjPtr<mirror::String> s)
+      REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(stripe->lock);
+  void RemoveWeak(Stripe* stripe, ObjPtr<mirror::String> s)
+      REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(stripe->lock);
 
   // Transaction rollback access.
   ObjPtr<mirror::String> InsertStrongFromTransaction(ObjPtr<mirror::String> s)
-      REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(Locks::intern_table_lock_);
+      REQUIRES_SHARED(Locks::mutator_lock_);
   ObjPtr<mirror::String> InsertWeakFromTransaction(ObjPtr<mirror::String> s)
-      REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(Locks::intern_table_lock_);
+      REQUIRES_SHARED(Locks::mutator_lock_);
   void RemoveStrongFromTransaction(ObjPtr<mirror::String> s)
-      REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(Locks::intern_table_lock_);
+      REQUIRES_SHARED(Locks::mutator_lock_);
   void RemoveWeakFromTransaction(ObjPtr<mirror::String> s)
-      REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(Locks::intern_table_lock_);
+      REQUIRES_SHARED(Locks::mutator_lock_);
 
   size_t AddTableFromMemoryLocked(const uint8_t* ptr)
       REQUIRES(Locks::intern_table_lock_) REQUIRES_SHARED(Locks::mutator_lock_);
@@ -262,25 +299,24 @@ class InternTable {
   void ChangeWeakRootStateLocked(gc::WeakRootState new_state)
       REQUIRES(Locks::intern_table_lock_);
 
-  // Wait until we can read weak roots.
-  void WaitUntilAccessible(Thread* self)
-      REQUIRES(Locks::intern_table_lock_) REQUIRES_SHARED(Locks::mutator_lock_);
+  bool IsWeakAccessible(Thread* self) const;
+
+  // Release the lock of the stripe and wait until we can read weak roots.
+  void WaitUntilAccessible(Thread* self, Stripe* stripe)
+      REQUIRES(stripe->lock) REQUIRES(!Locks::intern_table_lock_)
+      REQUIRES_SHARED(Locks::mutator_lock_);
 
-  bool log_new_roots_ GUARDED_BY(Locks::intern_table_lock_);
   ConditionVariable weak_intern_condition_ GUARDED_BY(Locks::intern_table_lock_);
-  // Since this contains (strong) roots, they need a read barrier to
-  // enable concurrent intern table (strong) root scan. Do not
-  // directly access the strings in it. Use functions that contain
-  // read barriers.
-  Table strong_interns_ GUARDED_BY(Locks::intern_table_lock_);
-  std::vector<GcRoot<mirror::String>> new_strong_intern_roots_
+  // Strong interns read from images, the front of the intern table. The sets and the arrays
+  // published in image_tables_ are kept until the intern table is deleted.
+  std::list<UnorderedSet> image_sets_ GUARDED_BY(Locks::intern_table_lock_);
+  std::vector<std::unique_ptr<ImageTables>> image_tables_history_
       GUARDED_BY(Locks::intern_table_lock_);
-  // Since this contains (weak) roots, they need a read barrier. Do
-  // not directly access the strings in it. Use functions that contain
-  // read barriers.
-  Table weak_interns_ GUARDED_BY(Locks::intern_table_lock_);
-  // Weak root state, used for concurrent system weak processing and more.
-  gc::WeakRootState weak_root_state_ GUARDED_BY(Locks::intern_table_lock_);
+  Atomic<const ImageTables*> image_tables_;
+  Stripe stripes_[kNumStripes];
+  // Weak root state, used for concurrent system weak processing and more. Only written in a
+  // GC pause or while holding intern_table_lock_, which waiters hold to check it.
+  Atomic<gc::WeakRootState> weak_root_state_;
 
   friend class Transaction;
   ART_FRIEND_TEST(InternTableTest, CrossHash);
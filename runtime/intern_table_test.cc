@@ -16,6 +16,8 @@
 
 #include "intern_table.h"
 
+#include "android-base/stringprintf.h"
+
 #include "base/hash_set.h"
 #include "common_runtime_test.h"
 #include "gc_root-inl.h"
@@ -23,10 +25,13 @@
 #include "handle_scope-inl.h"
 #include "mirror/string.h"
 #include "scoped_thread_state_change-inl.h"
+#include "thread_pool.h"
 #include "utf.h"
 
 namespace art {
 
+using android::base::StringPrintf;
+
 class InternTableTest : public CommonRuntimeTest {};
 
 TEST_F(InternTableTest, Intern) {
@@ -77,10 +82,12 @@ TEST_F(InternTableTest, CrossHash) {
   // A string that has a negative hash value.
   GcRoot<mirror::String> str(mirror::String::AllocFromModifiedUtf8(soa.Self(), "00000000"));
 
-  MutexLock mu(Thread::Current(), *Locks::intern_table_lock_);
-  for (InternTable::Table::UnorderedSet& table : t.strong_interns_.tables_) {
-    // The negative hash value shall be 32-bit wide on every host.
-    ASSERT_TRUE(IsUint<32>(table.hashfn_(str)));
+  for (InternTable::Stripe& stripe : t.stripes_) {
+    MutexLock mu(Thread::Current(), stripe.lock);
+    for (InternTable::UnorderedSet& table : stripe.strong_interns.tables_) {
+      // The negative hash value shall be 32-bit wide on every host.
+      ASSERT_TRUE(IsUint<32>(table.hashfn_(str)));
+    }
   }
 }
 
@@ -234,4 +241,55 @@ TEST_F(InternTableTest, LookupStrong) {
   EXPECT_TRUE(lookup_foobbS == nullptr);
 }
 
+class InternStringsTask : public Task {
+ public:
+  InternStringsTask(InternTable* intern_table, size_t count)
+      : intern_table_(intern_table), count_(count) {}
+
+  void Run(Thread* self) OVERRIDE {
+    ScopedObjectAccess soa(self);
+    for (size_t i = 0; i != count_; ++i) {
+      std::string name = StringPrintf("intern %zu", i);
+      // Intern weakly first so that threads race promoting the same string to the strong table.
+      intern_table_->InternWeak(mirror::String::AllocFromModifiedUtf8(self, name.c_str()));
+      intern_table_->InternStrong(name.c_str());
+    }
+  }
+
+  void Finalize() OVERRIDE {
+    delete this;
+  }
+
+ private:
+  InternTable* const intern_table_;
+  const size_t count_;
+};
+
+TEST_F(InternTableTest, ConcurrentIntern) {
+  Thread* self = Thread::Current();
+  // Use the runtime intern table, its strong interns are GC roots.
+  InternTable* intern_table = Runtime::Current()->GetInternTable();
+  const size_t strong_size = intern_table->StrongSize();
+  const size_t weak_size = intern_table->WeakSize();
+  static constexpr size_t kNumThreads = 4;
+  static constexpr size_t kCount = 1000;
+  ThreadPool thread_pool("Intern table test thread pool", kNumThreads);
+  for (size_t i = 0; i != kNumThreads; ++i) {
+    thread_pool.AddTask(self, new InternStringsTask(intern_table, kCount));
+  }
+  thread_pool.StartWorkers(self);
+  thread_pool.Wait(self, /* do_work */ false, /* may_hold_locks */ false);
+  // Each string is interned once whatever the interleaving, and all are strong.
+  EXPECT_EQ(strong_size + kCount, intern_table->StrongSize());
+  EXPECT_LE(intern_table->WeakSize(), weak_size);
+  ScopedObjectAccess soa(self);
+  for (size_t i = 0; i != kCount; ++i) {
+    std::string name = StringPrintf("intern %zu", i);
+    ObjPtr<mirror::String> strong =
+        intern_table->LookupStrong(soa.Self(), CountModifiedUtf8Chars(name.c_str()), name.c_str());
+    ASSERT_TRUE(strong != nullptr) << name;
+    EXPECT_TRUE(strong->Equals(name.c_str()));
+  }
+}
+
 }  // namespace art
@@ -236,6 +236,15 @@ enum InterpreterImplKind {
 
 static constexpr InterpreterImplKind kInterpreterImplKind = kMterpImplKind;
 
+// Only the switch interpreter records branch profiles, so it runs the methods that have a
+// ProfilingInfo when the JIT profiles branches.
+static bool IsProfilingBranches(ArtMethod* method) REQUIRES_SHARED(Locks::mutator_lock_) {
+  jit::Jit* jit = Runtime::Current()->GetJit();
+  return jit != nullptr &&
+      jit->ProfileBranches() &&
+      method->GetProfilingInfo(kRuntimePointerSize) != nullptr;
+}
+
 static inline JValue Execute(
     Thread* self,
     const DexFile::CodeItem* code_item,
@@ -306,8 +315,8 @@ static inline JValue Execute(
                                                false);
       } else {
         while (true) {
-          // Mterp does not support all instrumentation/debugging.
-          if (MterpShouldSwitchInterpreters() != 0) {
+          // Mterp does not support all instrumentation/debugging, nor branch profiling.
+          if (MterpShouldSwitchInterpreters() != 0 || UNLIKELY(IsProfilingBranches(method))) {
             return ExecuteSwitchImpl<false, false>(self, code_item, shadow_frame, result_register,
                                                    false);
           }
@@ -925,6 +925,41 @@ inline void CopyRegisters(ShadowFrame& caller_frame,
   }
 }
 
+// Calls the compiled code of `called_method` with the invoke arguments read straight from the
+// caller's registers, without a shadow frame for the callee. Range invokes pass the registers in
+// place. The callee must not need class initialization, which requires a callee shadow frame.
+template <bool is_range>
+static inline void InvokeCompiledCodeFromRegisters(
+    Thread* self,
+    ArtMethod* called_method,
+    ShadowFrame& shadow_frame,
+    const uint32_t (&arg)[Instruction::kMaxVarArgRegs],
+    uint32_t vregC,
+    uint16_t number_of_inputs,
+    JValue* result)
+    REQUIRES_SHARED(Locks::mutator_lock_) {
+  jit::Jit* jit = Runtime::Current()->GetJit();
+  if (jit != nullptr) {
+    jit->NotifyInterpreterToCompiledCodeTransition(self, shadow_frame.GetMethod());
+  }
+  uint32_t args[Instruction::kMaxVarArgRegs];
+  uint32_t* args_ptr;
+  if (is_range) {
+    args_ptr = shadow_frame.GetVRegArgs(vregC);
+  } else {
+    DCHECK_LE(number_of_inputs, arraysize(arg));
+    for (size_t i = 0; i < number_of_inputs; ++i) {
+      args[i] = static_cast<uint32_t>(shadow_frame.GetVReg(arg[i]));
+    }
+    args_ptr = args;
+  }
+  called_method->Invoke(self,
+                        args_ptr,
+                        number_of_inputs * sizeof(uint32_t),
+                        result,
+                        called_method->GetInterfaceMethodIfProxy(kRuntimePointerSize)->GetShorty());
+}
+
 template <bool is_range,
           bool do_assignability_check>
 static inline bool DoCallCommon(ArtMethod* called_method,
@@ -957,6 +992,14 @@ static inline bool DoCallCommon(ArtMethod* called_method,
       ClassLinker::ShouldUseInterpreterEntrypoint(
           called_method,
           called_method->GetEntryPointFromQuickCompiledCode());
+  if (!use_interpreter_entrypoint &&
+      !do_assignability_check &&
+      !string_init &&
+      (!called_method->IsStatic() || called_method->GetDeclaringClass()->IsInitialized())) {
+    InvokeCompiledCodeFromRegisters<is_range>(
+        self, called_method, shadow_frame, arg, vregC, number_of_inputs, result);
+    return !self->IsExceptionPending();
+  }
   if (LIKELY(code_item != nullptr)) {
     // When transitioning to compiled code, space only needs to be reserved for the input registers.
     // The rest of the frame gets discarded. This also prevents accessing the called method's code
@@ -1209,6 +1252,9 @@ bool DoFilledNewArray(const Instruction* inst,
     self->AssertPendingOOMException();
     return false;
   }
+  if (transaction_active) {
+    Runtime::Current()->RecordNewObject(new_array);
+  }
   uint32_t arg[Instruction::kMaxVarArgRegs];  // only used in filled-new-array.
   uint32_t vregC = 0;   // only used in filled-new-array-range.
   if (is_range) {
@@ -112,6 +112,32 @@ template<bool is_range, bool do_assignability_check>
 bool DoCall(ArtMethod* called_method, Thread* self, ShadowFrame& shadow_frame,
             const Instruction* inst, uint16_t inst_data, JValue* result);
 
+// Finds the method called by an invoke, first looking in the inline cache of the caller's
+// ProfilingInfo for invoke-virtual and invoke-interface. Sets `*is_cached` if the method was
+// found there, in which case the call has already been recorded in the inline cache.
+template<InvokeType type, bool do_access_check>
+static inline ArtMethod* FindMethodToCall(uint32_t method_idx,
+                                          ObjPtr<mirror::Object>* receiver,
+                                          const ShadowFrame& shadow_frame,
+                                          Thread* self,
+                                          bool* is_cached)
+    REQUIRES_SHARED(Locks::mutator_lock_) {
+  ArtMethod* sf_method = shadow_frame.GetMethod();
+  if ((type == kVirtual || type == kInterface) && !do_access_check && *receiver != nullptr) {
+    jit::Jit* jit = Runtime::Current()->GetJit();
+    if (jit != nullptr) {
+      ArtMethod* called_method =
+          jit->GetCachedInvokeTarget(*receiver, sf_method, shadow_frame.GetDexPC());
+      if (called_method != nullptr) {
+        *is_cached = true;
+        return called_method;
+      }
+    }
+  }
+  *is_cached = false;
+  return FindMethodFromCode<type, do_access_check>(method_idx, receiver, sf_method, self);
+}
+
 // Handles streamlined non-range invoke static, direct and virtual instructions originating in
 // mterp. Access checks and instrumentation other than jit profiling are not supported, but does
 // support interpreter intrinsics if applicable.
@@ -128,8 +154,9 @@ static inline bool DoFastInvoke(Thread* self,
       ? nullptr
       : shadow_frame.GetVRegReference(vregC);
   ArtMethod* sf_method = shadow_frame.GetMethod();
-  ArtMethod* const called_method = FindMethodFromCode<type, false>(
-      method_idx, &receiver, sf_method, self);
+  bool is_cached;
+  ArtMethod* const called_method = FindMethodToCall<type, false>(
+      method_idx, &receiver, shadow_frame, self, &is_cached);
   // The shadow frame should already be pushed, so we don't need to update it.
   if (UNLIKELY(called_method == nullptr)) {
     CHECK(self->IsExceptionPending());
@@ -142,7 +169,7 @@ static inline bool DoFastInvoke(Thread* self,
   } else {
     jit::Jit* jit = Runtime::Current()->GetJit();
     if (jit != nullptr) {
-      if (type == kVirtual) {
+      if (type == kVirtual && !is_cached) {
         jit->InvokeVirtualOrInterface(receiver, sf_method, shadow_frame.GetDexPC(), called_method);
       }
       jit->AddSamples(self, sf_method, 1, /*with_backedges*/false);
@@ -169,8 +196,9 @@ static inline bool DoInvoke(Thread* self,
   const uint32_t vregC = (is_range) ? inst->VRegC_3rc() : inst->VRegC_35c();
   ObjPtr<mirror::Object> receiver = (type == kStatic) ? nullptr : shadow_frame.GetVRegReference(vregC);
   ArtMethod* sf_method = shadow_frame.GetMethod();
-  ArtMethod* const called_method = FindMethodFromCode<type, do_access_check>(
-      method_idx, &receiver, sf_method, self);
+  bool is_cached;
+  ArtMethod* const called_method = FindMethodToCall<type, do_access_check>(
+      method_idx, &receiver, shadow_frame, self, &is_cached);
   // The shadow frame should already be pushed, so we don't need to update it.
   if (UNLIKELY(called_method == nullptr)) {
     CHECK(self->IsExceptionPending());
@@ -183,7 +211,7 @@ static inline bool DoInvoke(Thread* self,
   } else {
     jit::Jit* jit = Runtime::Current()->GetJit();
     if (jit != nullptr) {
-      if (type == kVirtual || type == kInterface) {
+      if ((type == kVirtual || type == kInterface) && !is_cached) {
         jit->InvokeVirtualOrInterface(receiver, sf_method, shadow_frame.GetDexPC(), called_method);
       }
       jit->AddSamples(self, sf_method, 1, /*with_backedges*/false);
@@ -196,6 +224,16 @@ static inline bool DoInvoke(Thread* self,
             self, receiver.Ptr(), sf_method, shadow_frame.GetDexPC(), called_method);
       }
     }
+    // Like mterp, the switch interpreter (and the unstarted runtime it calls into) handles
+    // intrinsics inline. The intrinsics do not record their writes in transactions, and would
+    // skip the method entry and exit events.
+    if (!is_range && called_method->IsIntrinsic() &&
+        !Runtime::Current()->IsActiveTransaction() &&
+        !Runtime::Current()->GetInstrumentation()->IsActive()) {
+      if (MterpHandleIntrinsic(&shadow_frame, called_method, inst, inst_data, result)) {
+        return !self->IsExceptionPending();
+      }
+    }
     return DoCall<is_range, do_access_check>(called_method, self, shadow_frame, inst, inst_data,
                                              result);
   }
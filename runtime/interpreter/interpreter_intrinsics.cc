@@ -16,6 +16,10 @@
 
 #include "interpreter/interpreter_intrinsics.h"
 
+#include <cmath>
+#include <limits>
+
+#include "atomic.h"
 #include "compiler/intrinsics_enum.h"
 #include "dex_instruction.h"
 #include "interpreter/interpreter_common.h"
@@ -45,6 +49,31 @@ static ALWAYS_INLINE bool name(ShadowFrame* shadow_frame,           \
 #define BINARY_JI_INTRINSIC(name, op, set) \
     BINARY_INTRINSIC(name, op, GetVRegLong(arg[0]), GetVReg(arg[2]), set)
 
+#define BINARY_FF_INTRINSIC(name, op, set) \
+    BINARY_INTRINSIC(name, op, GetVRegFloat(arg[0]), GetVRegFloat(arg[1]), set)
+
+#define BINARY_DD_INTRINSIC(name, op, set) \
+    BINARY_INTRINSIC(name, op, GetVRegDouble(arg[0]), GetVRegDouble(arg[2]), set)
+
+// The Math.*Exact methods. Punt on overflow, and let the non-intrinsic version throw.
+#define EXACT_INTRINSIC(name, op, type, get1, get2, set)            \
+static ALWAYS_INLINE bool name(ShadowFrame* shadow_frame,           \
+                               const Instruction* inst,             \
+                               uint16_t inst_data,                  \
+                               JValue* result_register)             \
+    REQUIRES_SHARED(Locks::mutator_lock_) {                         \
+  uint32_t arg[Instruction::kMaxVarArgRegs] = {};                   \
+  inst->GetVarArgs(arg, inst_data);                                 \
+  type res;                                                         \
+  if (op(static_cast<type>(shadow_frame->get1),                     \
+         static_cast<type>(shadow_frame->get2),                     \
+         &res)) {                                                   \
+    return false;                                                   \
+  }                                                                 \
+  result_register->set(res);                                        \
+  return true;                                                      \
+}
+
 #define UNARY_INTRINSIC(name, op, get, set)                  \
 static ALWAYS_INLINE bool name(ShadowFrame* shadow_frame,    \
                                const Instruction* inst,      \
@@ -58,6 +87,68 @@ static ALWAYS_INLINE bool name(ShadowFrame* shadow_frame,    \
 }
 
 
+// Math.min and Math.max for floating point values: NaN wins, and -0.0 is less than 0.0.
+template <typename T>
+static ALWAYS_INLINE T FpMin(T a, T b) {
+  if (std::isnan(a)) {
+    return a;
+  }
+  if (a == 0 && b == 0 && std::signbit(b)) {
+    return b;
+  }
+  return (a <= b) ? a : b;
+}
+
+template <typename T>
+static ALWAYS_INLINE T FpMax(T a, T b) {
+  if (std::isnan(a)) {
+    return a;
+  }
+  if (a == 0 && b == 0 && std::signbit(a)) {
+    return b;
+  }
+  return (a >= b) ? a : b;
+}
+
+// Float.floatToIntBits and Double.doubleToLongBits collapse all NaNs to the canonical one.
+static ALWAYS_INLINE int32_t FloatToIntBits(float value) {
+  return std::isnan(value) ? INT32_C(0x7fc00000) : bit_cast<int32_t, float>(value);
+}
+
+static ALWAYS_INLINE int64_t DoubleToLongBits(double value) {
+  return std::isnan(value) ? INT64_C(0x7ff8000000000000) : bit_cast<int64_t, double>(value);
+}
+
+// java.lang.Double.doubleToRawLongBits(D)J
+UNARY_INTRINSIC(MterpDoubleDoubleToRawLongBits, , GetVRegLong, SetJ);
+
+// java.lang.Double.doubleToLongBits(D)J
+UNARY_INTRINSIC(MterpDoubleDoubleToLongBits, DoubleToLongBits, GetVRegDouble, SetJ);
+
+// java.lang.Double.isInfinite(D)Z
+UNARY_INTRINSIC(MterpDoubleIsInfinite, std::isinf, GetVRegDouble, SetZ);
+
+// java.lang.Double.isNaN(D)Z
+UNARY_INTRINSIC(MterpDoubleIsNaN, std::isnan, GetVRegDouble, SetZ);
+
+// java.lang.Double.longBitsToDouble(J)D
+UNARY_INTRINSIC(MterpDoubleLongBitsToDouble, , GetVRegLong, SetJ);
+
+// java.lang.Float.floatToRawIntBits(F)I
+UNARY_INTRINSIC(MterpFloatFloatToRawIntBits, , GetVReg, SetI);
+
+// java.lang.Float.floatToIntBits(F)I
+UNARY_INTRINSIC(MterpFloatFloatToIntBits, FloatToIntBits, GetVRegFloat, SetI);
+
+// java.lang.Float.isInfinite(F)Z
+UNARY_INTRINSIC(MterpFloatIsInfinite, std::isinf, GetVRegFloat, SetZ);
+
+// java.lang.Float.isNaN(F)Z
+UNARY_INTRINSIC(MterpFloatIsNaN, std::isnan, GetVRegFloat, SetZ);
+
+// java.lang.Float.intBitsToFloat(I)F
+UNARY_INTRINSIC(MterpFloatIntBitsToFloat, , GetVReg, SetI);
+
 // java.lang.Integer.reverse(I)I
 UNARY_INTRINSIC(MterpIntegerReverse, ReverseBits32, GetVReg, SetI);
 
@@ -139,6 +230,18 @@ BINARY_II_INTRINSIC(MterpMathMaxIntInt, std::max, SetI);
 // java.lang.Math.max(JJ)J
 BINARY_JJ_INTRINSIC(MterpMathMaxLongLong, std::max, SetJ);
 
+// java.lang.Math.min(FF)F
+BINARY_FF_INTRINSIC(MterpMathMinFloatFloat, FpMin, SetF);
+
+// java.lang.Math.min(DD)D
+BINARY_DD_INTRINSIC(MterpMathMinDoubleDouble, FpMin, SetD);
+
+// java.lang.Math.max(FF)F
+BINARY_FF_INTRINSIC(MterpMathMaxFloatFloat, FpMax, SetF);
+
+// java.lang.Math.max(DD)D
+BINARY_DD_INTRINSIC(MterpMathMaxDoubleDouble, FpMax, SetD);
+
 // java.lang.Math.abs(I)I
 UNARY_INTRINSIC(MterpMathAbsInt, std::abs, GetVReg, SetI);
 
@@ -178,6 +281,88 @@ UNARY_INTRINSIC(MterpMathAcos, std::acos, GetVRegDouble, SetD);
 // java.lang.Math.atan(D)D
 UNARY_INTRINSIC(MterpMathAtan, std::atan, GetVRegDouble, SetD);
 
+// java.lang.Math.atan2(DD)D
+BINARY_DD_INTRINSIC(MterpMathAtan2, std::atan2, SetD);
+
+// java.lang.Math.cbrt(D)D
+UNARY_INTRINSIC(MterpMathCbrt, std::cbrt, GetVRegDouble, SetD);
+
+// java.lang.Math.cosh(D)D
+UNARY_INTRINSIC(MterpMathCosh, std::cosh, GetVRegDouble, SetD);
+
+// java.lang.Math.exp(D)D
+UNARY_INTRINSIC(MterpMathExp, std::exp, GetVRegDouble, SetD);
+
+// java.lang.Math.expm1(D)D
+UNARY_INTRINSIC(MterpMathExpm1, std::expm1, GetVRegDouble, SetD);
+
+// java.lang.Math.hypot(DD)D
+BINARY_DD_INTRINSIC(MterpMathHypot, std::hypot, SetD);
+
+// java.lang.Math.log(D)D
+UNARY_INTRINSIC(MterpMathLog, std::log, GetVRegDouble, SetD);
+
+// java.lang.Math.log10(D)D
+UNARY_INTRINSIC(MterpMathLog10, std::log10, GetVRegDouble, SetD);
+
+// java.lang.Math.nextAfter(DD)D
+BINARY_DD_INTRINSIC(MterpMathNextAfter, std::nextafter, SetD);
+
+// java.lang.Math.sinh(D)D
+UNARY_INTRINSIC(MterpMathSinh, std::sinh, GetVRegDouble, SetD);
+
+// java.lang.Math.tanh(D)D
+UNARY_INTRINSIC(MterpMathTanh, std::tanh, GetVRegDouble, SetD);
+
+// java.lang.Math.rint(D)D
+UNARY_INTRINSIC(MterpMathRint, std::rint, GetVRegDouble, SetD);
+
+// java.lang.Math.addExact(II)I
+EXACT_INTRINSIC(MterpMathAddExactInt, __builtin_add_overflow, int32_t,
+                GetVReg(arg[0]), GetVReg(arg[1]), SetI);
+
+// java.lang.Math.addExact(JJ)J
+EXACT_INTRINSIC(MterpMathAddExactLong, __builtin_add_overflow, int64_t,
+                GetVRegLong(arg[0]), GetVRegLong(arg[2]), SetJ);
+
+// java.lang.Math.subtractExact(II)I
+EXACT_INTRINSIC(MterpMathSubtractExactInt, __builtin_sub_overflow, int32_t,
+                GetVReg(arg[0]), GetVReg(arg[1]), SetI);
+
+// java.lang.Math.subtractExact(JJ)J
+EXACT_INTRINSIC(MterpMathSubtractExactLong, __builtin_sub_overflow, int64_t,
+                GetVRegLong(arg[0]), GetVRegLong(arg[2]), SetJ);
+
+// java.lang.Math.multiplyExact(II)I
+EXACT_INTRINSIC(MterpMathMultiplyExactInt, __builtin_mul_overflow, int32_t,
+                GetVReg(arg[0]), GetVReg(arg[1]), SetI);
+
+// java.lang.Math.multiplyExact(JJ)J
+EXACT_INTRINSIC(MterpMathMultiplyExactLong, __builtin_mul_overflow, int64_t,
+                GetVRegLong(arg[0]), GetVRegLong(arg[2]), SetJ);
+
+#define NEGATE_EXACT_INTRINSIC(name, type, get, set)                \
+static ALWAYS_INLINE bool name(ShadowFrame* shadow_frame,           \
+                               const Instruction* inst,             \
+                               uint16_t inst_data,                  \
+                               JValue* result_register)             \
+    REQUIRES_SHARED(Locks::mutator_lock_) {                         \
+  uint32_t arg[Instruction::kMaxVarArgRegs] = {};                   \
+  inst->GetVarArgs(arg, inst_data);                                 \
+  type value = shadow_frame->get(arg[0]);                           \
+  if (value == std::numeric_limits<type>::min()) {                  \
+    return false;                                                   \
+  }                                                                 \
+  result_register->set(-value);                                     \
+  return true;                                                      \
+}
+
+// java.lang.Math.negateExact(I)I
+NEGATE_EXACT_INTRINSIC(MterpMathNegateExactInt, int32_t, GetVReg, SetI);
+
+// java.lang.Math.negateExact(J)J
+NEGATE_EXACT_INTRINSIC(MterpMathNegateExactLong, int64_t, GetVRegLong, SetJ);
+
 // java.lang.String.charAt(I)C
 static ALWAYS_INLINE bool MterpStringCharAt(ShadowFrame* shadow_frame,
                                             const Instruction* inst,
@@ -262,6 +447,9 @@ SIMPLE_STRING_INTRINSIC(StringIsEmpty, SetZ(str->GetLength() == 0))
 // java.lang.String.length()I
 SIMPLE_STRING_INTRINSIC(StringLength, SetI(str->GetLength()))
 
+// java.lang.String.hashCode()I
+SIMPLE_STRING_INTRINSIC(StringHashCode, SetI(str->GetHashCode()))
+
 // java.lang.String.getCharsNoCheck(II[CI)V
 static ALWAYS_INLINE bool MterpStringGetCharsNoCheck(ShadowFrame* shadow_frame,
                                                      const Instruction* inst,
@@ -323,6 +511,136 @@ static ALWAYS_INLINE bool MterpStringEquals(ShadowFrame* shadow_frame,
   return true;
 }
 
+// The box caches that the valueOf intrinsics use, in the order of
+// Thread::GetInterpreterBoxCacheFields().
+enum class BoxCache : size_t {
+  kInteger,
+  kLong,
+  kShort,
+  kCharacter,
+  kByte,
+};
+static_assert(static_cast<size_t>(BoxCache::kByte) + 1u == Thread::kNumInterpreterBoxCaches,
+              "Unexpected number of box caches");
+
+static ALWAYS_INLINE void SetBoxValue(ArtField* field, ObjPtr<mirror::Object> box, int32_t value)
+    REQUIRES_SHARED(Locks::mutator_lock_) {
+  field->SetInt</* kTransactionActive */ false>(box, value);
+}
+
+static ALWAYS_INLINE void SetBoxValue(ArtField* field, ObjPtr<mirror::Object> box, int64_t value)
+    REQUIRES_SHARED(Locks::mutator_lock_) {
+  field->SetLong</* kTransactionActive */ false>(box, value);
+}
+
+static ALWAYS_INLINE void SetBoxValue(ArtField* field, ObjPtr<mirror::Object> box, int16_t value)
+    REQUIRES_SHARED(Locks::mutator_lock_) {
+  field->SetShort</* kTransactionActive */ false>(box, value);
+}
+
+static ALWAYS_INLINE void SetBoxValue(ArtField* field, ObjPtr<mirror::Object> box, uint16_t value)
+    REQUIRES_SHARED(Locks::mutator_lock_) {
+  field->SetChar</* kTransactionActive */ false>(box, value);
+}
+
+static ALWAYS_INLINE void SetBoxValue(ArtField* field, ObjPtr<mirror::Object> box, int8_t value)
+    REQUIRES_SHARED(Locks::mutator_lock_) {
+  field->SetByte</* kTransactionActive */ false>(box, value);
+}
+
+// Boxes `value` like the valueOf methods do: values in the range of the box cache get the cached
+// box, and the others a new box, allocated here rather than by running the constructors. Punt
+// while the box cache or box class is not initialized.
+template <typename T>
+static ALWAYS_INLINE bool BoxValueOf(ArtMethod* called_method,
+                                     BoxCache box_cache,
+                                     const char* cache_descriptor,
+                                     const char* cache_array_descriptor,
+                                     const char* value_descriptor,
+                                     int32_t low,
+                                     T value,
+                                     JValue* result_register)
+    REQUIRES_SHARED(Locks::mutator_lock_) {
+  Thread* self = Thread::Current();
+  ArtField** cache_field = &self->GetInterpreterBoxCacheFields()[static_cast<size_t>(box_cache)];
+  if (UNLIKELY(*cache_field == nullptr)) {
+    ObjPtr<mirror::Class> cache_class = Runtime::Current()->GetClassLinker()->LookupClass(
+        self, cache_descriptor, /* class_loader */ nullptr);
+    if (cache_class == nullptr || !cache_class->IsInitialized()) {
+      return false;
+    }
+    *cache_field = cache_class->FindDeclaredStaticField("cache", cache_array_descriptor);
+    if (*cache_field == nullptr) {
+      return false;
+    }
+  }
+  ObjPtr<mirror::ObjectArray<mirror::Object>> cache =
+      ObjPtr<mirror::ObjectArray<mirror::Object>>::DownCast(
+          (*cache_field)->GetObject((*cache_field)->GetDeclaringClass()));
+  if (UNLIKELY(cache == nullptr)) {
+    return false;
+  }
+  int64_t index = static_cast<int64_t>(value) - low;
+  if (index >= 0 && index < cache->GetLength()) {
+    result_register->SetL(cache->GetWithoutChecks(static_cast<int32_t>(index)));
+    return true;
+  }
+
+  ObjPtr<mirror::Class> boxed_class = called_method->GetDeclaringClass();
+  if (UNLIKELY(!boxed_class->IsInitialized())) {
+    return false;
+  }
+  ArtField* value_field = boxed_class->FindDeclaredInstanceField("value", value_descriptor);
+  if (UNLIKELY(value_field == nullptr)) {
+    return false;
+  }
+  ObjPtr<mirror::Object> box = boxed_class->AllocObject(self);
+  if (UNLIKELY(box == nullptr)) {
+    // Leave the OutOfMemoryError pending.
+    DCHECK(self->IsExceptionPending());
+    return true;
+  }
+  SetBoxValue(value_field, box, value);
+  // The value field is final.
+  QuasiAtomic::ThreadFenceForConstructor();
+  result_register->SetL(box);
+  return true;
+}
+
+#define VALUE_OF_INTRINSIC(name, box_cache, boxed, type, shorty, get, low) \
+static ALWAYS_INLINE bool Mterp##name(ShadowFrame* shadow_frame,           \
+                                      ArtMethod* called_method,            \
+                                      const Instruction* inst,             \
+                                      uint16_t inst_data,                  \
+                                      JValue* result_register)             \
+    REQUIRES_SHARED(Locks::mutator_lock_) {                                \
+  uint32_t arg[Instruction::kMaxVarArgRegs] = {};                          \
+  inst->GetVarArgs(arg, inst_data);                                        \
+  return BoxValueOf(called_method,                                         \
+                    BoxCache::box_cache,                                   \
+                    "Ljava/lang/" boxed "$" boxed "Cache;",                \
+                    "[Ljava/lang/" boxed ";",                              \
+                    shorty,                                                \
+                    low,                                                   \
+                    static_cast<type>(shadow_frame->get(arg[0])),          \
+                    result_register);                                      \
+}
+
+// java.lang.Integer.valueOf(I)Ljava/lang/Integer;
+VALUE_OF_INTRINSIC(IntegerValueOf, kInteger, "Integer", int32_t, "I", GetVReg, -128)
+
+// java.lang.Long.valueOf(J)Ljava/lang/Long;
+VALUE_OF_INTRINSIC(LongValueOf, kLong, "Long", int64_t, "J", GetVRegLong, -128)
+
+// java.lang.Short.valueOf(S)Ljava/lang/Short;
+VALUE_OF_INTRINSIC(ShortValueOf, kShort, "Short", int16_t, "S", GetVReg, -128)
+
+// java.lang.Character.valueOf(C)Ljava/lang/Character;
+VALUE_OF_INTRINSIC(CharacterValueOf, kCharacter, "Character", uint16_t, "C", GetVReg, 0)
+
+// java.lang.Byte.valueOf(B)Ljava/lang/Byte;
+VALUE_OF_INTRINSIC(ByteValueOf, kByte, "Byte", int8_t, "B", GetVReg, -128)
+
 // Macro to help keep track of what's left to implement.
 #define UNIMPLEMENTED_CASE(name)    \
     case Intrinsics::k##name:       \
@@ -334,6 +652,11 @@ static ALWAYS_INLINE bool MterpStringEquals(ShadowFrame* shadow_frame,
       res = Mterp##name(shadow_frame, inst, inst_data, result_register); \
       break;
 
+#define VALUE_OF_INTRINSIC_CASE(name)                                                 \
+    case Intrinsics::k##name:                                                         \
+      res = Mterp##name(shadow_frame, called_method, inst, inst_data, result_register); \
+      break;
+
 bool MterpHandleIntrinsic(ShadowFrame* shadow_frame,
                           ArtMethod* const called_method,
                           const Instruction* inst,
@@ -343,16 +666,16 @@ bool MterpHandleIntrinsic(ShadowFrame* shadow_frame,
   Intrinsics intrinsic = static_cast<Intrinsics>(called_method->GetIntrinsic());
   bool res = false;  // Assume failure
   switch (intrinsic) {
-    UNIMPLEMENTED_CASE(DoubleDoubleToRawLongBits /* (D)J */)
-    UNIMPLEMENTED_CASE(DoubleDoubleToLongBits /* (D)J */)
-    UNIMPLEMENTED_CASE(DoubleIsInfinite /* (D)Z */)
-    UNIMPLEMENTED_CASE(DoubleIsNaN /* (D)Z */)
-    UNIMPLEMENTED_CASE(DoubleLongBitsToDouble /* (J)D */)
-    UNIMPLEMENTED_CASE(FloatFloatToRawIntBits /* (F)I */)
-    UNIMPLEMENTED_CASE(FloatFloatToIntBits /* (F)I */)
-    UNIMPLEMENTED_CASE(FloatIsInfinite /* (F)Z */)
-    UNIMPLEMENTED_CASE(FloatIsNaN /* (F)Z */)
-    UNIMPLEMENTED_CASE(FloatIntBitsToFloat /* (I)F */)
+    INTRINSIC_CASE(DoubleDoubleToRawLongBits)
+    INTRINSIC_CASE(DoubleDoubleToLongBits)
+    INTRINSIC_CASE(DoubleIsInfinite)
+    INTRINSIC_CASE(DoubleIsNaN)
+    INTRINSIC_CASE(DoubleLongBitsToDouble)
+    INTRINSIC_CASE(FloatFloatToRawIntBits)
+    INTRINSIC_CASE(FloatFloatToIntBits)
+    INTRINSIC_CASE(FloatIsInfinite)
+    INTRINSIC_CASE(FloatIsNaN)
+    INTRINSIC_CASE(FloatIntBitsToFloat)
     INTRINSIC_CASE(IntegerReverse)
     INTRINSIC_CASE(IntegerReverseBytes)
     INTRINSIC_CASE(IntegerBitCount)
@@ -380,12 +703,12 @@ bool MterpHandleIntrinsic(ShadowFrame* shadow_frame,
     INTRINSIC_CASE(MathAbsFloat)
     INTRINSIC_CASE(MathAbsLong)
     INTRINSIC_CASE(MathAbsInt)
-    UNIMPLEMENTED_CASE(MathMinDoubleDouble /* (DD)D */)
-    UNIMPLEMENTED_CASE(MathMinFloatFloat /* (FF)F */)
+    INTRINSIC_CASE(MathMinDoubleDouble)
+    INTRINSIC_CASE(MathMinFloatFloat)
     INTRINSIC_CASE(MathMinLongLong)
     INTRINSIC_CASE(MathMinIntInt)
-    UNIMPLEMENTED_CASE(MathMaxDoubleDouble /* (DD)D */)
-    UNIMPLEMENTED_CASE(MathMaxFloatFloat /* (FF)F */)
+    INTRINSIC_CASE(MathMaxDoubleDouble)
+    INTRINSIC_CASE(MathMaxFloatFloat)
     INTRINSIC_CASE(MathMaxLongLong)
     INTRINSIC_CASE(MathMaxIntInt)
     INTRINSIC_CASE(MathCos)
@@ -393,26 +716,40 @@ bool MterpHandleIntrinsic(ShadowFrame* shadow_frame,
     INTRINSIC_CASE(MathAcos)
     INTRINSIC_CASE(MathAsin)
     INTRINSIC_CASE(MathAtan)
-    UNIMPLEMENTED_CASE(MathAtan2 /* (DD)D */)
-    UNIMPLEMENTED_CASE(MathCbrt /* (D)D */)
-    UNIMPLEMENTED_CASE(MathCosh /* (D)D */)
-    UNIMPLEMENTED_CASE(MathExp /* (D)D */)
-    UNIMPLEMENTED_CASE(MathExpm1 /* (D)D */)
-    UNIMPLEMENTED_CASE(MathHypot /* (DD)D */)
-    UNIMPLEMENTED_CASE(MathLog /* (D)D */)
-    UNIMPLEMENTED_CASE(MathLog10 /* (D)D */)
-    UNIMPLEMENTED_CASE(MathNextAfter /* (DD)D */)
-    UNIMPLEMENTED_CASE(MathSinh /* (D)D */)
+    INTRINSIC_CASE(MathAtan2)
+    INTRINSIC_CASE(MathCbrt)
+    INTRINSIC_CASE(MathCosh)
+    INTRINSIC_CASE(MathExp)
+    INTRINSIC_CASE(MathExpm1)
+    INTRINSIC_CASE(MathHypot)
+    INTRINSIC_CASE(MathLog)
+    INTRINSIC_CASE(MathLog10)
+    INTRINSIC_CASE(MathNextAfter)
+    INTRINSIC_CASE(MathSinh)
     INTRINSIC_CASE(MathTan)
-    UNIMPLEMENTED_CASE(MathTanh /* (D)D */)
+    INTRINSIC_CASE(MathTanh)
     INTRINSIC_CASE(MathSqrt)
     INTRINSIC_CASE(MathCeil)
     INTRINSIC_CASE(MathFloor)
-    UNIMPLEMENTED_CASE(MathRint /* (D)D */)
+    INTRINSIC_CASE(MathRint)
     UNIMPLEMENTED_CASE(MathRoundDouble /* (D)J */)
     UNIMPLEMENTED_CASE(MathRoundFloat /* (F)I */)
+    INTRINSIC_CASE(MathAddExactInt)
+    INTRINSIC_CASE(MathAddExactLong)
+    INTRINSIC_CASE(MathSubtractExactInt)
+    INTRINSIC_CASE(MathSubtractExactLong)
+    INTRINSIC_CASE(MathMultiplyExactInt)
+    INTRINSIC_CASE(MathMultiplyExactLong)
+    INTRINSIC_CASE(MathNegateExactInt)
+    INTRINSIC_CASE(MathNegateExactLong)
     UNIMPLEMENTED_CASE(SystemArrayCopyChar /* ([CI[CII)V */)
     UNIMPLEMENTED_CASE(SystemArrayCopy /* (Ljava/lang/Object;ILjava/lang/Object;II)V */)
+    UNIMPLEMENTED_CASE(ArraysEqualsByte /* ([B[B)Z */)
+    UNIMPLEMENTED_CASE(ArraysEqualsChar /* ([C[C)Z */)
+    UNIMPLEMENTED_CASE(ArraysEqualsInt /* ([I[I)Z */)
+    UNIMPLEMENTED_CASE(ArraysEqualsLong /* ([J[J)Z */)
+    UNIMPLEMENTED_CASE(CRC32Update /* (II)I */)
+    UNIMPLEMENTED_CASE(CRC32UpdateBytes /* (I[BII)I */)
     UNIMPLEMENTED_CASE(ThreadCurrentThread /* ()Ljava/lang/Thread; */)
     UNIMPLEMENTED_CASE(MemoryPeekByte /* (J)B */)
     UNIMPLEMENTED_CASE(MemoryPeekIntNative /* (J)I */)
@@ -426,6 +763,7 @@ bool MterpHandleIntrinsic(ShadowFrame* shadow_frame,
     INTRINSIC_CASE(StringCompareTo)
     INTRINSIC_CASE(StringEquals)
     INTRINSIC_CASE(StringGetCharsNoCheck)
+    INTRINSIC_CASE(StringHashCode)
     INTRINSIC_CASE(StringIndexOf)
     INTRINSIC_CASE(StringIndexOfAfter)
     UNIMPLEMENTED_CASE(StringStringIndexOf /* (Ljava/lang/String;)I */)
@@ -468,7 +806,11 @@ bool MterpHandleIntrinsic(ShadowFrame* shadow_frame,
     UNIMPLEMENTED_CASE(UnsafeStoreFence /* ()V */)
     UNIMPLEMENTED_CASE(UnsafeFullFence /* ()V */)
     UNIMPLEMENTED_CASE(ReferenceGetReferent /* ()Ljava/lang/Object; */)
-    UNIMPLEMENTED_CASE(IntegerValueOf /* (I)Ljava/lang/Integer; */)
+    VALUE_OF_INTRINSIC_CASE(IntegerValueOf)
+    VALUE_OF_INTRINSIC_CASE(LongValueOf)
+    VALUE_OF_INTRINSIC_CASE(ShortValueOf)
+    VALUE_OF_INTRINSIC_CASE(CharacterValueOf)
+    VALUE_OF_INTRINSIC_CASE(ByteValueOf)
     UNIMPLEMENTED_CASE(ThreadInterrupted /* ()Z */)
     case Intrinsics::kNone:
       res = false;
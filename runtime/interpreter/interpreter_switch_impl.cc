@@ -96,6 +96,13 @@ namespace interpreter {
     }                                                                                          \
   } while (false)
 
+#define PROFILE_BRANCH(taken)                                                                  \
+  do {                                                                                         \
+    if (UNLIKELY(profile_branches)) {                                                          \
+      jit->AddBranchInfo(method, dex_pc, taken);                                               \
+    }                                                                                          \
+  } while (false)
+
 #define HOTNESS_UPDATE()                                                                       \
   do {                                                                                         \
     if (jit != nullptr) {                                                                      \
@@ -168,6 +175,7 @@ JValue ExecuteSwitchImpl(Thread* self, const DexFile::CodeItem* code_item,
   uint16_t inst_data;
   ArtMethod* method = shadow_frame.GetMethod();
   jit::Jit* jit = Runtime::Current()->GetJit();
+  const bool profile_branches = jit != nullptr && jit->ProfileBranches();
 
   do {
     dex_pc = inst->GetDexPc(insns);
@@ -525,6 +533,9 @@ JValue ExecuteSwitchImpl(Thread* self, const DexFile::CodeItem* code_item,
           HANDLE_PENDING_EXCEPTION();
         } else {
           ObjPtr<mirror::Object> obj = shadow_frame.GetVRegReference(inst->VRegA_21c(inst_data));
+          if (UNLIKELY(profile_branches) && obj != nullptr) {
+            jit->AddTypeInfo(obj, method, dex_pc);
+          }
           if (UNLIKELY(obj != nullptr && !obj->InstanceOf(c))) {
             ThrowClassCastException(c, obj->GetClass());
             HANDLE_PENDING_EXCEPTION();
@@ -545,6 +556,9 @@ JValue ExecuteSwitchImpl(Thread* self, const DexFile::CodeItem* code_item,
           HANDLE_PENDING_EXCEPTION();
         } else {
           ObjPtr<mirror::Object> obj = shadow_frame.GetVRegReference(inst->VRegB_22c(inst_data));
+          if (UNLIKELY(profile_branches) && obj != nullptr) {
+            jit->AddTypeInfo(obj, method, dex_pc);
+          }
           shadow_frame.SetVReg(inst->VRegA_22c(inst_data),
                                (obj != nullptr && obj->InstanceOf(c)) ? 1 : 0);
           inst = inst->Next_2xx();
@@ -594,6 +608,9 @@ JValue ExecuteSwitchImpl(Thread* self, const DexFile::CodeItem* code_item,
             HANDLE_PENDING_EXCEPTION();
             break;
           }
+          if (transaction_active) {
+            Runtime::Current()->RecordNewObject(obj);
+          }
           shadow_frame.SetVRegReference(inst->VRegA_21c(inst_data), obj.Ptr());
           inst = inst->Next_2xx();
         }
@@ -611,6 +628,9 @@ JValue ExecuteSwitchImpl(Thread* self, const DexFile::CodeItem* code_item,
         if (UNLIKELY(obj == nullptr)) {
           HANDLE_PENDING_EXCEPTION();
         } else {
+          if (transaction_active) {
+            Runtime::Current()->RecordNewObject(obj);
+          }
           shadow_frame.SetVRegReference(inst->VRegA_22c(inst_data), obj.Ptr());
           inst = inst->Next_2xx();
         }
@@ -800,10 +820,12 @@ JValue ExecuteSwitchImpl(Thread* self, const DexFile::CodeItem* code_item,
         if (shadow_frame.GetVReg(inst->VRegA_22t(inst_data)) ==
             shadow_frame.GetVReg(inst->VRegB_22t(inst_data))) {
           int16_t offset = inst->VRegC_22t();
+          PROFILE_BRANCH(true);
           BRANCH_INSTRUMENTATION(offset);
           inst = inst->RelativeAt(offset);
           HANDLE_BACKWARD_BRANCH(offset);
         } else {
+          PROFILE_BRANCH(false);
           BRANCH_INSTRUMENTATION(2);
           inst = inst->Next_2xx();
         }
@@ -814,10 +836,12 @@ JValue ExecuteSwitchImpl(Thread* self, const DexFile::CodeItem* code_item,
         if (shadow_frame.GetVReg(inst->VRegA_22t(inst_data)) !=
             shadow_frame.GetVReg(inst->VRegB_22t(inst_data))) {
           int16_t offset = inst->VRegC_22t();
+          PROFILE_BRANCH(true);
           BRANCH_INSTRUMENTATION(offset);
           inst = inst->RelativeAt(offset);
           HANDLE_BACKWARD_BRANCH(offset);
         } else {
+          PROFILE_BRANCH(false);
           BRANCH_INSTRUMENTATION(2);
           inst = inst->Next_2xx();
         }
@@ -828,10 +852,12 @@ JValue ExecuteSwitchImpl(Thread* self, const DexFile::CodeItem* code_item,
         if (shadow_frame.GetVReg(inst->VRegA_22t(inst_data)) <
             shadow_frame.GetVReg(inst->VRegB_22t(inst_data))) {
           int16_t offset = inst->VRegC_22t();
+          PROFILE_BRANCH(true);
           BRANCH_INSTRUMENTATION(offset);
           inst = inst->RelativeAt(offset);
           HANDLE_BACKWARD_BRANCH(offset);
         } else {
+          PROFILE_BRANCH(false);
           BRANCH_INSTRUMENTATION(2);
           inst = inst->Next_2xx();
         }
@@ -842,10 +868,12 @@ JValue ExecuteSwitchImpl(Thread* self, const DexFile::CodeItem* code_item,
         if (shadow_frame.GetVReg(inst->VRegA_22t(inst_data)) >=
             shadow_frame.GetVReg(inst->VRegB_22t(inst_data))) {
           int16_t offset = inst->VRegC_22t();
+          PROFILE_BRANCH(true);
           BRANCH_INSTRUMENTATION(offset);
           inst = inst->RelativeAt(offset);
           HANDLE_BACKWARD_BRANCH(offset);
         } else {
+          PROFILE_BRANCH(false);
           BRANCH_INSTRUMENTATION(2);
           inst = inst->Next_2xx();
         }
@@ -856,10 +884,12 @@ JValue ExecuteSwitchImpl(Thread* self, const DexFile::CodeItem* code_item,
         if (shadow_frame.GetVReg(inst->VRegA_22t(inst_data)) >
         shadow_frame.GetVReg(inst->VRegB_22t(inst_data))) {
           int16_t offset = inst->VRegC_22t();
+          PROFILE_BRANCH(true);
           BRANCH_INSTRUMENTATION(offset);
           inst = inst->RelativeAt(offset);
           HANDLE_BACKWARD_BRANCH(offset);
         } else {
+          PROFILE_BRANCH(false);
           BRANCH_INSTRUMENTATION(2);
           inst = inst->Next_2xx();
         }
@@ -870,10 +900,12 @@ JValue ExecuteSwitchImpl(Thread* self, const DexFile::CodeItem* code_item,
         if (shadow_frame.GetVReg(inst->VRegA_22t(inst_data)) <=
             shadow_frame.GetVReg(inst->VRegB_22t(inst_data))) {
           int16_t offset = inst->VRegC_22t();
+          PROFILE_BRANCH(true);
           BRANCH_INSTRUMENTATION(offset);
           inst = inst->RelativeAt(offset);
           HANDLE_BACKWARD_BRANCH(offset);
         } else {
+          PROFILE_BRANCH(false);
           BRANCH_INSTRUMENTATION(2);
           inst = inst->Next_2xx();
         }
@@ -883,10 +915,12 @@ JValue ExecuteSwitchImpl(Thread* self, const DexFile::CodeItem* code_item,
         PREAMBLE();
         if (shadow_frame.GetVReg(inst->VRegA_21t(inst_data)) == 0) {
           int16_t offset = inst->VRegB_21t();
+          PROFILE_BRANCH(true);
           BRANCH_INSTRUMENTATION(offset);
           inst = inst->RelativeAt(offset);
           HANDLE_BACKWARD_BRANCH(offset);
         } else {
+          PROFILE_BRANCH(false);
           BRANCH_INSTRUMENTATION(2);
           inst = inst->Next_2xx();
         }
@@ -896,10 +930,12 @@ JValue ExecuteSwitchImpl(Thread* self, const DexFile::CodeItem* code_item,
         PREAMBLE();
         if (shadow_frame.GetVReg(inst->VRegA_21t(inst_data)) != 0) {
           int16_t offset = inst->VRegB_21t();
+          PROFILE_BRANCH(true);
           BRANCH_INSTRUMENTATION(offset);
           inst = inst->RelativeAt(offset);
           HANDLE_BACKWARD_BRANCH(offset);
         } else {
+          PROFILE_BRANCH(false);
           BRANCH_INSTRUMENTATION(2);
           inst = inst->Next_2xx();
         }
@@ -909,10 +945,12 @@ JValue ExecuteSwitchImpl(Thread* self, const DexFile::CodeItem* code_item,
         PREAMBLE();
         if (shadow_frame.GetVReg(inst->VRegA_21t(inst_data)) < 0) {
           int16_t offset = inst->VRegB_21t();
+          PROFILE_BRANCH(true);
           BRANCH_INSTRUMENTATION(offset);
           inst = inst->RelativeAt(offset);
           HANDLE_BACKWARD_BRANCH(offset);
         } else {
+          PROFILE_BRANCH(false);
           BRANCH_INSTRUMENTATION(2);
           inst = inst->Next_2xx();
         }
@@ -922,10 +960,12 @@ JValue ExecuteSwitchImpl(Thread* self, const DexFile::CodeItem* code_item,
         PREAMBLE();
         if (shadow_frame.GetVReg(inst->VRegA_21t(inst_data)) >= 0) {
           int16_t offset = inst->VRegB_21t();
+          PROFILE_BRANCH(true);
           BRANCH_INSTRUMENTATION(offset);
           inst = inst->RelativeAt(offset);
           HANDLE_BACKWARD_BRANCH(offset);
         } else {
+          PROFILE_BRANCH(false);
           BRANCH_INSTRUMENTATION(2);
           inst = inst->Next_2xx();
         }
@@ -935,10 +975,12 @@ JValue ExecuteSwitchImpl(Thread* self, const DexFile::CodeItem* code_item,
         PREAMBLE();
         if (shadow_frame.GetVReg(inst->VRegA_21t(inst_data)) > 0) {
           int16_t offset = inst->VRegB_21t();
+          PROFILE_BRANCH(true);
           BRANCH_INSTRUMENTATION(offset);
           inst = inst->RelativeAt(offset);
           HANDLE_BACKWARD_BRANCH(offset);
         } else {
+          PROFILE_BRANCH(false);
           BRANCH_INSTRUMENTATION(2);
           inst = inst->Next_2xx();
         }
@@ -948,10 +990,12 @@ JValue ExecuteSwitchImpl(Thread* self, const DexFile::CodeItem* code_item,
         PREAMBLE();
         if (shadow_frame.GetVReg(inst->VRegA_21t(inst_data)) <= 0) {
           int16_t offset = inst->VRegB_21t();
+          PROFILE_BRANCH(true);
           BRANCH_INSTRUMENTATION(offset);
           inst = inst->RelativeAt(offset);
           HANDLE_BACKWARD_BRANCH(offset);
         } else {
+          PROFILE_BRANCH(false);
           BRANCH_INSTRUMENTATION(2);
           inst = inst->Next_2xx();
         }
@@ -1281,7 +1325,10 @@ JValue ExecuteSwitchImpl(Thread* self, const DexFile::CodeItem* code_item,
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
         break;
       }
-      case Instruction::IGET_OBJECT_QUICK: {
+      case Instruction::IGET_OBJECT_QUICK:
+      case Instruction::IGET_OBJECT_QUICK_IF_EQZ:
+      case Instruction::IGET_OBJECT_QUICK_IF_NEZ: {
+        // The branch of the fused instructions is left to the if-eqz or if-nez that follows.
         PREAMBLE();
         bool success = DoIGetQuick<Primitive::kPrimNot>(shadow_frame, inst, inst_data);
         POSSIBLY_HANDLE_PENDING_EXCEPTION(!success, Next_2xx);
@@ -2400,7 +2447,7 @@ JValue ExecuteSwitchImpl(Thread* self, const DexFile::CodeItem* code_item,
         inst = inst->Next_2xx();
         break;
       case Instruction::UNUSED_3E ... Instruction::UNUSED_43:
-      case Instruction::UNUSED_F3 ... Instruction::UNUSED_F9:
+      case Instruction::UNUSED_F5 ... Instruction::UNUSED_F9:
       case Instruction::UNUSED_FE ... Instruction::UNUSED_FF:
       case Instruction::UNUSED_79:
       case Instruction::UNUSED_7A:
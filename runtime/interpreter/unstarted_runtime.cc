@@ -1682,6 +1682,40 @@ void UnstartedRuntime::UnstartedJNIMathExp(
   result->SetD(exp(value.GetD()));
 }
 
+void UnstartedRuntime::UnstartedJNIMathLog10(
+    Thread* self ATTRIBUTE_UNUSED, ArtMethod* method ATTRIBUTE_UNUSED,
+    mirror::Object* receiver ATTRIBUTE_UNUSED, uint32_t* args, JValue* result) {
+  JValue value;
+  value.SetJ((static_cast<uint64_t>(args[1]) << 32) | args[0]);
+  result->SetD(log10(value.GetD()));
+}
+
+void UnstartedRuntime::UnstartedJNIMathSqrt(
+    Thread* self ATTRIBUTE_UNUSED, ArtMethod* method ATTRIBUTE_UNUSED,
+    mirror::Object* receiver ATTRIBUTE_UNUSED, uint32_t* args, JValue* result) {
+  JValue value;
+  value.SetJ((static_cast<uint64_t>(args[1]) << 32) | args[0]);
+  result->SetD(sqrt(value.GetD()));
+}
+
+void UnstartedRuntime::UnstartedJNIMathTan(
+    Thread* self ATTRIBUTE_UNUSED, ArtMethod* method ATTRIBUTE_UNUSED,
+    mirror::Object* receiver ATTRIBUTE_UNUSED, uint32_t* args, JValue* result) {
+  JValue value;
+  value.SetJ((static_cast<uint64_t>(args[1]) << 32) | args[0]);
+  result->SetD(tan(value.GetD()));
+}
+
+void UnstartedRuntime::UnstartedJNIMathAtan2(
+    Thread* self ATTRIBUTE_UNUSED, ArtMethod* method ATTRIBUTE_UNUSED,
+    mirror::Object* receiver ATTRIBUTE_UNUSED, uint32_t* args, JValue* result) {
+  JValue y;
+  y.SetJ((static_cast<uint64_t>(args[1]) << 32) | args[0]);
+  JValue x;
+  x.SetJ((static_cast<uint64_t>(args[3]) << 32) | args[2]);
+  result->SetD(atan2(y.GetD(), x.GetD()));
+}
+
 void UnstartedRuntime::UnstartedJNIAtomicLongVMSupportsCS8(
     Thread* self ATTRIBUTE_UNUSED,
     ArtMethod* method ATTRIBUTE_UNUSED,
@@ -1741,6 +1775,26 @@ void UnstartedRuntime::UnstartedJNIStringCompareTo(
   result->SetI(receiver->AsString()->CompareTo(rhs));
 }
 
+void UnstartedRuntime::UnstartedJNIStringConcat(
+    Thread* self, ArtMethod* method ATTRIBUTE_UNUSED, mirror::Object* receiver, uint32_t* args,
+    JValue* result) {
+  mirror::Object* arg = reinterpret_cast<mirror::Object*>(args[0]);
+  if (arg == nullptr) {
+    AbortTransactionOrFail(self, "String.concat with null object");
+    return;
+  }
+  StackHandleScope<2> hs(self);
+  Handle<mirror::String> h_this(hs.NewHandle(receiver->AsString()));
+  Handle<mirror::String> h_arg(hs.NewHandle(arg->AsString()));
+  if (h_this->GetLength() == 0) {
+    result->SetL(h_arg.Get());
+  } else if (h_arg->GetLength() == 0) {
+    result->SetL(h_this.Get());
+  } else {
+    result->SetL(mirror::String::AllocFromStrings(self, h_this, h_arg));
+  }
+}
+
 void UnstartedRuntime::UnstartedJNIStringIntern(
     Thread* self ATTRIBUTE_UNUSED, ArtMethod* method ATTRIBUTE_UNUSED, mirror::Object* receiver,
     uint32_t* args ATTRIBUTE_UNUSED, JValue* result) {
@@ -85,6 +85,10 @@
   V(VMStackGetStackClass2, "java.lang.Class dalvik.system.VMStack.getStackClass2()") \
   V(MathLog, "double java.lang.Math.log(double)") \
   V(MathExp, "double java.lang.Math.exp(double)") \
+  V(MathLog10, "double java.lang.Math.log10(double)") \
+  V(MathSqrt, "double java.lang.Math.sqrt(double)") \
+  V(MathTan, "double java.lang.Math.tan(double)") \
+  V(MathAtan2, "double java.lang.Math.atan2(double, double)") \
   V(AtomicLongVMSupportsCS8, "boolean java.util.concurrent.atomic.AtomicLong.VMSupportsCS8()") \
   V(ClassGetNameNative, "java.lang.String java.lang.Class.getNameNative()") \
   V(DoubleLongBitsToDouble, "double java.lang.Double.longBitsToDouble(long)") \
@@ -93,6 +97,7 @@
   V(ObjectInternalClone, "java.lang.Object java.lang.Object.internalClone()") \
   V(ObjectNotifyAll, "void java.lang.Object.notifyAll()") \
   V(StringCompareTo, "int java.lang.String.compareTo(java.lang.String)") \
+  V(StringConcat, "java.lang.String java.lang.String.concat(java.lang.String)") \
   V(StringIntern, "java.lang.String java.lang.String.intern()") \
   V(StringFastIndexOf, "int java.lang.String.fastIndexOf(int, int)") \
   V(ArrayCreateMultiArray, "java.lang.Object java.lang.reflect.Array.createMultiArray(java.lang.Class, int[])") \
@@ -45,6 +45,7 @@
 #include "thread-inl.h"
 #include "thread_list.h"
 #include "ti/agent.h"
+#include "utils.h"
 
 namespace art {
 
@@ -470,6 +471,78 @@ JavaVMExt::JavaVMExt(Runtime* runtime,
       env_hooks_() {
   functions = unchecked_functions_;
   SetCheckJniEnabled(runtime_options.Exists(RuntimeArgumentMap::CheckJni));
+  if (runtime_options.Exists(RuntimeArgumentMap::JniOptimizedNatives)) {
+    LoadOptimizedNativesList(runtime_options.GetOrDefault(RuntimeArgumentMap::JniOptimizedNatives));
+  }
+}
+
+// Each line of the file is "fast" or "critical" followed by a method in the format used by
+// profiles, e.g. "critical Lcom/example/Math;->dot([FI)F". Empty lines and lines starting
+// with '#' are ignored. Problems with the file are only warned about, as the methods then
+// simply use the normal JNI transitions.
+void JavaVMExt::LoadOptimizedNativesList(const std::string& file_name) {
+  std::string contents;
+  if (!ReadFileToString(file_name, &contents)) {
+    LOG(WARNING) << "Failed to read the JNI optimized natives list " << file_name;
+    return;
+  }
+  std::vector<std::string> lines;
+  Split(contents, '\n', &lines);
+  for (const std::string& line : lines) {
+    if (line[0] == '#') {
+      continue;
+    }
+    size_t space = line.find(' ');
+    std::string kind = line.substr(0, space);
+    std::string method = (space != std::string::npos) ? line.substr(space + 1u) : "";
+    if (method.empty() || method.find("->") == std::string::npos) {
+      LOG(WARNING) << "Ignoring malformed line in " << file_name << ": " << line;
+    } else if (kind == "fast") {
+      listed_fast_natives_.insert(method);
+    } else if (kind == "critical") {
+      listed_critical_natives_.insert(method);
+    } else {
+      LOG(WARNING) << "Ignoring unknown kind in " << file_name << ": " << line;
+    }
+  }
+  // @FastNative and @CriticalNative are mutually exclusive.
+  for (auto it = listed_fast_natives_.begin(); it != listed_fast_natives_.end(); ) {
+    if (listed_critical_natives_.erase(*it) != 0u) {
+      LOG(WARNING) << "Ignoring " << *it << " listed as both fast and critical native";
+      it = listed_fast_natives_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+static std::string GetOptimizedNativesListKey(ArtMethod* method)
+    REQUIRES_SHARED(Locks::mutator_lock_) {
+  return std::string(method->GetDeclaringClassDescriptor()) + "->" + method->GetName() +
+      method->GetSignature().ToString();
+}
+
+bool JavaVMExt::IsListedAsFastNative(ArtMethod* method) {
+  // Fast where no list is given.
+  if (listed_fast_natives_.empty() || !method->IsNative()) {
+    return false;
+  }
+  return listed_fast_natives_.count(GetOptimizedNativesListKey(method)) != 0u;
+}
+
+bool JavaVMExt::IsListedAsCriticalNative(ArtMethod* method) {
+  // Fast where no list is given.
+  if (listed_critical_natives_.empty() ||
+      !method->IsNative() ||
+      !method->IsStatic() ||
+      method->IsSynchronized()) {
+    return false;
+  }
+  // The native code gets neither a JNIEnv* nor a jclass, and cannot take or return references.
+  if (strchr(method->GetShorty(), 'L') != nullptr) {
+    return false;
+  }
+  return listed_critical_natives_.count(GetOptimizedNativesListKey(method)) != 0u;
 }
 
 JavaVMExt::~JavaVMExt() {
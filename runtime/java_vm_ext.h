@@ -19,6 +19,9 @@
 
 #include "jni.h"
 
+#include <set>
+#include <string>
+
 #include "base/macros.h"
 #include "base/mutex.h"
 #include "indirect_reference_table.h"
@@ -92,6 +95,13 @@ class JavaVMExt : public JavaVM {
   // made by a third-party native method.
   bool ShouldTrace(ArtMethod* method) REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Native methods can be listed in the "-Xjnioptimizednatives:" file to get the transitions of
+  // @FastNative or @CriticalNative without annotating them. The list must be the same for the
+  // compiler and the runtime that executes its code. A method listed as critical native is only
+  // reported if it is static, not synchronized and takes and returns only primitives.
+  bool IsListedAsFastNative(ArtMethod* method) REQUIRES_SHARED(Locks::mutator_lock_);
+  bool IsListedAsCriticalNative(ArtMethod* method) REQUIRES_SHARED(Locks::mutator_lock_);
+
   /**
    * Loads the given shared library. 'path' is an absolute pathname.
    *
@@ -203,6 +213,8 @@ class JavaVMExt : public JavaVM {
   // an erroneous state, and the result needs to be checked.
   JavaVMExt(Runtime* runtime, const RuntimeArgumentMap& runtime_options, std::string* error_msg);
 
+  void LoadOptimizedNativesList(const std::string& file_name);
+
   // Return true if self can currently access weak globals.
   bool MayAccessWeakGlobalsUnlocked(Thread* self) const REQUIRES_SHARED(Locks::mutator_lock_);
   bool MayAccessWeakGlobals(Thread* self) const
@@ -223,6 +235,11 @@ class JavaVMExt : public JavaVM {
   // Extra diagnostics.
   const std::string trace_;
 
+  // Methods from the "-Xjnioptimizednatives:" file, as "Lpkg/Class;->name(signature)".
+  // Only written by the constructor.
+  std::set<std::string> listed_fast_natives_;
+  std::set<std::string> listed_critical_natives_;
+
   // Not guarded by globals_lock since we sometimes use SynchronizedGet in Thread::DecodeJObject.
   IndirectReferenceTable globals_;
 
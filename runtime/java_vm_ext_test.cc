@@ -18,9 +18,12 @@
 
 #include <pthread.h>
 
+#include "class_linker.h"
 #include "common_runtime_test.h"
 #include "java_vm_ext.h"
+#include "mirror/class-inl.h"
 #include "runtime.h"
+#include "scoped_thread_state_change-inl.h"
 
 namespace art {
 
@@ -134,4 +137,65 @@ TEST_F(JavaVmExtTest, DetachCurrentThread) {
   EXPECT_EQ(JNI_ERR, err);
 }
 
+class JavaVmExtOptimizedNativesTest : public CommonRuntimeTest {
+ protected:
+  void SetUpRuntimeOptions(RuntimeOptions* options) OVERRIDE {
+    list_.reset(new ScratchFile());
+    std::string contents =
+        "# Comments and unknown kinds are ignored.\n"
+        "fast LMyClassNatives;->foo()V\n"
+        "critical LMyClassNatives;->sbar(I)I\n"
+        // Not static.
+        "critical LMyClassNatives;->bar(I)I\n"
+        // Listed as both.
+        "fast LMyClassNatives;->fooI(I)I\n"
+        "critical LMyClassNatives;->fooI(I)I\n"
+        "slow LMyClassNatives;->fooII(II)I\n";
+    ASSERT_TRUE(list_->GetFile()->WriteFully(contents.data(), contents.size()));
+    options->push_back(
+        std::make_pair("-Xjnioptimizednatives:" + list_->GetFilename(), nullptr));
+  }
+
+  void TearDown() OVERRIDE {
+    list_.reset();
+    CommonRuntimeTest::TearDown();
+  }
+
+  std::unique_ptr<ScratchFile> list_;
+};
+
+TEST_F(JavaVmExtOptimizedNativesTest, ListedNatives) {
+  ScopedObjectAccess soa(Thread::Current());
+  jobject jclass_loader = LoadDex("MyClassNatives");
+  StackHandleScope<1> hs(soa.Self());
+  Handle<mirror::ClassLoader> loader(
+      hs.NewHandle(soa.Decode<mirror::ClassLoader>(jclass_loader)));
+  mirror::Class* c = class_linker_->FindClass(soa.Self(), "LMyClassNatives;", loader);
+  ASSERT_TRUE(c != nullptr);
+  const PointerSize pointer_size = class_linker_->GetImagePointerSize();
+  auto find_method = [&](const char* name, const char* signature)
+      REQUIRES_SHARED(Locks::mutator_lock_) {
+    ArtMethod* method = c->FindClassMethod(name, signature, pointer_size);
+    CHECK(method != nullptr) << name << signature;
+    return method;
+  };
+
+  JavaVMExt* vm = Runtime::Current()->GetJavaVM();
+  ArtMethod* foo = find_method("foo", "()V");
+  EXPECT_TRUE(vm->IsListedAsFastNative(foo));
+  EXPECT_FALSE(vm->IsListedAsCriticalNative(foo));
+  EXPECT_TRUE(foo->IsAnnotatedWithFastNative());
+
+  ArtMethod* sbar = find_method("sbar", "(I)I");
+  EXPECT_FALSE(vm->IsListedAsFastNative(sbar));
+  EXPECT_TRUE(vm->IsListedAsCriticalNative(sbar));
+  EXPECT_TRUE(sbar->IsAnnotatedWithCriticalNative());
+
+  EXPECT_FALSE(vm->IsListedAsCriticalNative(find_method("bar", "(I)I")));
+  EXPECT_FALSE(vm->IsListedAsFastNative(find_method("fooI", "(I)I")));
+  EXPECT_FALSE(vm->IsListedAsCriticalNative(find_method("fooI", "(I)I")));
+  EXPECT_FALSE(vm->IsListedAsFastNative(find_method("fooII", "(II)I")));
+  EXPECT_FALSE(vm->IsListedAsCriticalNative(find_method("fooII", "(II)I")));
+}
+
 }  // namespace art
@@ -28,6 +28,7 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <string.h>
+#include <unordered_map>
 #include <vector>
 
 struct iovec;
@@ -205,6 +206,19 @@ struct JdwpState {
                          const JValue* returnValue)
      REQUIRES(!event_list_lock_, !jdwp_token_lock_) REQUIRES_SHARED(Locks::mutator_lock_);
 
+  /*
+   * Clears the method entry and exit bits of "eventFlags" for which the class modifiers of every
+   * registered event of that kind rule out "method", so that PostLocationEvent is only called
+   * for events that can match. The result is computed once per method and event list.
+   */
+  int FilterMethodEventFlags(ArtMethod* method, int eventFlags)
+      REQUIRES(!event_list_lock_) REQUIRES_SHARED(Locks::mutator_lock_);
+
+  /*
+   * Forgets the per-method results of FilterMethodEventFlags.
+   */
+  void ClearMethodEventFilter() REQUIRES(!event_list_lock_);
+
   /*
    * A field of interest has been accessed or modified. This is used for field access and field
    * modification events.
@@ -320,6 +334,8 @@ struct JdwpState {
       REQUIRES(event_list_lock_) REQUIRES_SHARED(Locks::mutator_lock_);
   void UnregisterEvent(JdwpEvent* pEvent)
       REQUIRES(event_list_lock_) REQUIRES_SHARED(Locks::mutator_lock_);
+  int ComputeMethodEventFlags(ArtMethod* method)
+      REQUIRES(event_list_lock_) REQUIRES_SHARED(Locks::mutator_lock_);
   void SendBufferedRequest(uint32_t type, const std::vector<iovec>& iov);
 
   /*
@@ -390,6 +406,9 @@ struct JdwpState {
   Mutex event_list_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER ACQUIRED_BEFORE(Locks::breakpoint_lock_);
   JdwpEvent* event_list_ GUARDED_BY(event_list_lock_);
   size_t event_list_size_ GUARDED_BY(event_list_lock_);  // Number of elements in event_list_.
+  // The method entry and exit flags that events in event_list_ may match, by canonical method.
+  // Cleared whenever the event list changes.
+  std::unordered_map<ArtMethod*, int> method_event_flags_ GUARDED_BY(event_list_lock_);
 
   // Used to synchronize JDWP command handler thread and event threads so only one
   // thread does JDWP stuff at a time. This prevent from interleaving command handling
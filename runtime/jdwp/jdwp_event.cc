@@ -244,6 +244,7 @@ JdwpError JdwpState::RegisterEvent(JdwpEvent* pEvent) {
     }
     event_list_ = pEvent;
     ++event_list_size_;
+    method_event_flags_.clear();
   }
 
   Dbg::ManageDeoptimization();
@@ -347,6 +348,7 @@ void JdwpState::UnregisterEvent(JdwpEvent* pEvent) {
 
   --event_list_size_;
   CHECK(event_list_size_ != 0 || event_list_ == nullptr);
+  method_event_flags_.clear();
 }
 
 /*
@@ -560,6 +562,85 @@ static bool ModsMatch(JdwpEvent* pEvent, const ModBasket& basket)
   return true;
 }
 
+/*
+ * Return true if a mod of "pEvent" rejects every location in "method", looking at the
+ * mods that only depend on the declaring class. We stop at the first Count mod: ModsMatch
+ * decrements it for every event that reaches it, so an event that gets that far must be posted
+ * even if a later mod rejects it.
+ */
+static bool ModsRejectMethod(const JdwpEvent* pEvent, ArtMethod* method, std::string* className)
+    REQUIRES_SHARED(Locks::mutator_lock_) {
+  for (int i = 0; i < pEvent->modCount; ++i) {
+    const JdwpEventMod& mod = pEvent->mods[i];
+    switch (mod.modKind) {
+    case MK_COUNT:
+      return false;
+    case MK_CLASS_ONLY:
+      if (!Dbg::MatchType(method->GetDeclaringClass(), mod.classOnly.refTypeId)) {
+        return true;
+      }
+      break;
+    case MK_CLASS_MATCH:
+    case MK_CLASS_EXCLUDE:
+      if (className->empty()) {
+        *className = Dbg::GetClassName(method->GetDeclaringClass());
+      }
+      if (PatternMatch(mod.classMatch.classPattern, *className) ==
+          (mod.modKind == MK_CLASS_EXCLUDE)) {
+        return true;
+      }
+      break;
+    default:
+      // The other mods depend on the thread, the instance or the dex pc of the event.
+      break;
+    }
+  }
+  return false;
+}
+
+int JdwpState::ComputeMethodEventFlags(ArtMethod* method) {
+  int flags = 0;
+  std::string className;
+  for (JdwpEvent* pEvent = event_list_; pEvent != nullptr; pEvent = pEvent->next) {
+    int flag;
+    switch (pEvent->eventKind) {
+    case EK_METHOD_ENTRY:
+      flag = Dbg::kMethodEntry;
+      break;
+    case EK_METHOD_EXIT:
+    case EK_METHOD_EXIT_WITH_RETURN_VALUE:
+      flag = Dbg::kMethodExit;
+      break;
+    default:
+      continue;
+    }
+    if ((flags & flag) == 0 && !ModsRejectMethod(pEvent, method, &className)) {
+      flags |= flag;
+    }
+  }
+  return flags;
+}
+
+int JdwpState::FilterMethodEventFlags(ArtMethod* method, int eventFlags) {
+  static constexpr int kMethodEventFlags = Dbg::kMethodEntry | Dbg::kMethodExit;
+  if ((eventFlags & kMethodEventFlags) == 0) {
+    return eventFlags;
+  }
+  // Locations are reported, and matched, against the canonical method.
+  method = method->GetCanonicalMethod(kRuntimePointerSize);
+  MutexLock mu(Thread::Current(), event_list_lock_);
+  auto it = method_event_flags_.find(method);
+  if (it == method_event_flags_.end()) {
+    it = method_event_flags_.emplace(method, ComputeMethodEventFlags(method)).first;
+  }
+  return eventFlags & (it->second | ~kMethodEventFlags);
+}
+
+void JdwpState::ClearMethodEventFilter() {
+  MutexLock mu(Thread::Current(), event_list_lock_);
+  method_event_flags_.clear();
+}
+
 /*
  * Find all events of type "event_kind" with mods that match up with the
  * rest of the arguments while holding the event list lock. This method
@@ -41,7 +41,10 @@ static void* StartJdwpThread(void* arg);
  * JdwpNetStateBase class implementation
  */
 JdwpNetStateBase::JdwpNetStateBase(JdwpState* state)
-    : state_(state), socket_lock_("JdwpNetStateBase lock", kJdwpSocketLock) {
+    : state_(state),
+      socket_lock_("JdwpNetStateBase lock", kJdwpSocketLock),
+      pending_events_lock_("JdwpNetStateBase pending events lock", kJdwpPendingEventsLock),
+      writing_events_(false) {
   clientSock = -1;
   wake_pipe_[0] = -1;
   wake_pipe_[1] = -1;
@@ -153,6 +156,46 @@ ssize_t JdwpNetStateBase::WriteBufferedPacketLocked(const std::vector<iovec>& io
   return TEMP_FAILURE_RETRY(writev(clientSock, &iov[0], iov.size()));
 }
 
+ssize_t JdwpNetStateBase::WriteEventPacket(ExpandBuf* pReq, size_t length) {
+  DCHECK_LE(length, expandBufGetLength(pReq));
+  if (!IsConnected()) {
+    LOG(WARNING) << "Connection with debugger is closed";
+    return -1;
+  }
+  Thread* const self = Thread::Current();
+  const uint8_t* packet = expandBufGetBuffer(pReq);
+  {
+    MutexLock mu(self, pending_events_lock_);
+    pending_events_.insert(pending_events_.end(), packet, packet + length);
+    if (writing_events_) {
+      // The thread writing events sends ours before it releases the socket.
+      return length;
+    }
+    writing_events_ = true;
+  }
+  ssize_t result = length;
+  std::vector<uint8_t> batch;
+  MutexLock mu(self, socket_lock_);
+  while (true) {
+    {
+      MutexLock mu2(self, pending_events_lock_);
+      if (pending_events_.empty()) {
+        writing_events_ = false;
+        break;
+      }
+      batch.swap(pending_events_);
+    }
+    ssize_t actual = TEMP_FAILURE_RETRY(write(clientSock, batch.data(), batch.size()));
+    if (static_cast<size_t>(actual) != batch.size()) {
+      PLOG(ERROR) << StringPrintf("Failed to send JDWP event packets to debugger (%zd of %zu)",
+                                  actual, batch.size());
+      result = -1;
+    }
+    batch.clear();
+  }
+  return result;
+}
+
 bool JdwpState::IsConnected() {
   return netState != nullptr && netState->IsConnected();
 }
@@ -189,7 +232,7 @@ void JdwpState::SendRequest(ExpandBuf* pReq) {
   }
 
   errno = 0;
-  ssize_t actual = netState->WritePacket(pReq, expandBufGetLength(pReq));
+  ssize_t actual = netState->WriteEventPacket(pReq, expandBufGetLength(pReq));
   if (static_cast<size_t>(actual) != expandBufGetLength(pReq)) {
     PLOG(ERROR) << StringPrintf("Failed to send JDWP packet to debugger (%zd of %zu)",
                                 actual, expandBufGetLength(pReq));
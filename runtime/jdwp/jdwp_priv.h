@@ -94,6 +94,11 @@ class JdwpNetStateBase {
     return &socket_lock_;
   }
   ssize_t WriteBufferedPacketLocked(const std::vector<iovec>& iov);
+  // Write an event packet. Events that threads post while another thread writes events are
+  // appended to pending_events_, and the writing thread sends them with a single write before
+  // it releases the socket. Failures are reported by the thread that does the write.
+  ssize_t WriteEventPacket(ExpandBuf* pReq, size_t length)
+      REQUIRES(!socket_lock_, !pending_events_lock_);
 
   int clientSock;  // Active connection to debugger.
 
@@ -116,6 +121,11 @@ class JdwpNetStateBase {
   // Used to serialize writes to the socket.
   Mutex socket_lock_;
 
+  // Event packets waiting for the thread that is writing events, see WriteEventPacket.
+  Mutex pending_events_lock_ ACQUIRED_AFTER(socket_lock_);
+  std::vector<uint8_t> pending_events_ GUARDED_BY(pending_events_lock_);
+  bool writing_events_ GUARDED_BY(pending_events_lock_);
+
   // Are we waiting for the JDWP handshake?
   bool awaiting_handshake_;
 };
@@ -21,7 +21,8 @@
 #include "thread-current-inl.h"
 #include "thread.h"
 
-#include <unordered_map>
+#include <algorithm>
+#include <map>
 
 namespace art {
 
@@ -41,6 +42,9 @@ extern "C" {
     JITCodeEntry* prev_;
     const uint8_t *symfile_addr_;
     uint64_t symfile_size_;
+    // The fields below are not part of the GDB interface, debuggers do not read them.
+    uint32_t num_methods_;       // Methods described by the ELF file, 0 if not for methods.
+    uint32_t num_live_methods_;  // Methods described by the ELF file whose code is not freed.
   };
 
   struct JITDescriptor {
@@ -70,6 +74,13 @@ extern "C" {
 
 static Mutex g_jit_debug_mutex("JIT debug interface lock", kJitDebugInterfaceLock);
 
+// Pack the entries of single methods once there are this many of them.
+static constexpr size_t kJitPackThreshold = 64;
+
+// Maximum number of methods in a packed entry, which keeps repacking the live methods of an
+// entry with freed code cheap.
+static constexpr size_t kJitMaxMethodsPerPackedEntry = 256;
+
 static JITCodeEntry* CreateJITCodeEntryInternal(std::vector<uint8_t> symfile)
     REQUIRES(g_jit_debug_mutex) {
   DCHECK_NE(symfile.size(), 0u);
@@ -83,6 +94,8 @@ static JITCodeEntry* CreateJITCodeEntryInternal(std::vector<uint8_t> symfile)
   CHECK(entry != nullptr);
   entry->symfile_addr_ = symfile_copy;
   entry->symfile_size_ = symfile.size();
+  entry->num_methods_ = 0u;
+  entry->num_live_methods_ = 0u;
   entry->prev_ = nullptr;
 
   entry->next_ = __jit_debug_descriptor.first_entry_;
@@ -127,9 +140,89 @@ void DeleteJITCodeEntry(JITCodeEntry* entry) {
   DeleteJITCodeEntryInternal(entry);
 }
 
-// Mapping from address to entry.  It takes ownership of the entries
-// so that the user of the JIT interface does not have to store them.
-static std::unordered_map<uintptr_t, JITCodeEntry*> g_jit_code_entries;
+// Mapping from code address to entry, in address order. It takes ownership of the entries
+// so that the user of the JIT interface does not have to store them. A packed entry is shared
+// by all the methods it describes.
+static std::map<uintptr_t, JITCodeEntry*> g_jit_code_entries GUARDED_BY(g_jit_debug_mutex);
+
+static JITCodeEntryPacker* g_jit_code_entry_packer GUARDED_BY(g_jit_debug_mutex) = nullptr;
+
+// Number of entries describing a single method.
+static size_t g_jit_num_unpacked_entries GUARDED_BY(g_jit_debug_mutex) = 0u;
+
+// Number of packed entries that still describe some freed code.
+static size_t g_jit_num_stale_entries GUARDED_BY(g_jit_debug_mutex) = 0u;
+
+static void AddMethodsToEntry(JITCodeEntry* entry, size_t num_methods)
+    REQUIRES(g_jit_debug_mutex) {
+  DCHECK_EQ(entry->num_methods_, 0u);
+  DCHECK_NE(num_methods, 0u);
+  entry->num_methods_ = num_methods;
+  entry->num_live_methods_ = num_methods;
+  if (num_methods == 1u) {
+    ++g_jit_num_unpacked_entries;
+  }
+}
+
+// Drop one of the methods described by the entry, and the entry itself with its last method.
+static void RemoveMethodFromEntry(JITCodeEntry* entry) REQUIRES(g_jit_debug_mutex) {
+  DCHECK_NE(entry->num_live_methods_, 0u);
+  if (entry->num_methods_ == 1u) {
+    DCHECK_NE(g_jit_num_unpacked_entries, 0u);
+    --g_jit_num_unpacked_entries;
+  } else if (entry->num_live_methods_ == entry->num_methods_) {
+    ++g_jit_num_stale_entries;
+  }
+  --entry->num_live_methods_;
+  if (entry->num_live_methods_ == 0u) {
+    if (entry->num_methods_ != 1u) {
+      DCHECK_NE(g_jit_num_stale_entries, 0u);
+      --g_jit_num_stale_entries;
+    }
+    DeleteJITCodeEntryInternal(entry);
+  }
+}
+
+// Pack the single method entries once there are enough of them, and repack the live methods of
+// the packed entries that describe freed code so that the debugger does not see it. The methods
+// are grouped in address order, so that an entry describes neighbouring code.
+static void MaybePackJITCodeEntries() REQUIRES(g_jit_debug_mutex) {
+  if (g_jit_code_entry_packer == nullptr ||
+      (g_jit_num_unpacked_entries < kJitPackThreshold && g_jit_num_stale_entries == 0u)) {
+    return;
+  }
+  std::vector<uintptr_t> addresses;
+  for (const auto& pair : g_jit_code_entries) {
+    const JITCodeEntry* entry = pair.second;
+    if (entry->num_methods_ == 1u || entry->num_live_methods_ != entry->num_methods_) {
+      addresses.push_back(pair.first);
+    }
+  }
+  for (size_t begin = 0; begin < addresses.size(); begin += kJitMaxMethodsPerPackedEntry) {
+    size_t count = std::min(addresses.size() - begin, kJitMaxMethodsPerPackedEntry);
+    ArrayRef<const uintptr_t> group = ArrayRef<const uintptr_t>(addresses).SubArray(begin, count);
+    std::vector<uint8_t> symfile = g_jit_code_entry_packer->Pack(group);
+    if (symfile.empty()) {
+      continue;
+    }
+    // Register the packed entry before removing the old ones so that the methods always have
+    // debug info.
+    JITCodeEntry* packed_entry = CreateJITCodeEntryInternal(std::move(symfile));
+    AddMethodsToEntry(packed_entry, group.size());
+    for (uintptr_t address : group) {
+      auto it = g_jit_code_entries.find(address);
+      DCHECK(it != g_jit_code_entries.end());
+      RemoveMethodFromEntry(it->second);
+      it->second = packed_entry;
+    }
+  }
+}
+
+void SetJITCodeEntryPacker(JITCodeEntryPacker* packer) {
+  Thread* self = Thread::Current();
+  MutexLock mu(self, g_jit_debug_mutex);
+  g_jit_code_entry_packer = packer;
+}
 
 void CreateJITCodeEntryForAddress(uintptr_t address, std::vector<uint8_t> symfile) {
   Thread* self = Thread::Current();
@@ -137,7 +230,9 @@ void CreateJITCodeEntryForAddress(uintptr_t address, std::vector<uint8_t> symfil
   DCHECK_NE(address, 0u);
   DCHECK(g_jit_code_entries.find(address) == g_jit_code_entries.end());
   JITCodeEntry* entry = CreateJITCodeEntryInternal(std::move(symfile));
+  AddMethodsToEntry(entry, 1u);
   g_jit_code_entries.emplace(address, entry);
+  MaybePackJITCodeEntries();
 }
 
 bool DeleteJITCodeEntryForAddress(uintptr_t address) {
@@ -147,7 +242,10 @@ bool DeleteJITCodeEntryForAddress(uintptr_t address) {
   if (it == g_jit_code_entries.end()) {
     return false;
   }
-  DeleteJITCodeEntryInternal(it->second);
+  if (g_jit_code_entry_packer != nullptr) {
+    g_jit_code_entry_packer->Remove(address);
+  }
+  RemoveMethodFromEntry(it->second);
   g_jit_code_entries.erase(it);
   return true;
 }
@@ -21,12 +21,33 @@
 #include <memory>
 #include <vector>
 
+#include "base/array_ref.h"
+
 namespace art {
 
 extern "C" {
   struct JITCodeEntry;
 }
 
+// Interface through which the JIT compiler packs the debug info of several methods into one
+// in-memory ELF file, so that the native debugger has fewer entries to scan. It is called with
+// the JIT debug interface lock held, which keeps the code of the registered methods alive.
+class JITCodeEntryPacker {
+ public:
+  virtual ~JITCodeEntryPacker() {}
+
+  // Returns one in-memory ELF file describing the methods at the given code addresses, which
+  // are in increasing order. Returns an empty vector if the methods cannot be packed.
+  virtual std::vector<uint8_t> Pack(ArrayRef<const uintptr_t> addresses) = 0;
+
+  // The code at `address` is being freed, its debug info is no longer needed.
+  virtual void Remove(uintptr_t address) = 0;
+};
+
+// Set the packer for the entries created by CreateJITCodeEntryForAddress, null to stop packing.
+// The entries stay registered one method per entry until enough of them accumulated.
+void SetJITCodeEntryPacker(JITCodeEntryPacker* packer);
+
 // Notify native debugger about new JITed code by passing in-memory ELF.
 // It takes ownership of the in-memory ELF file.
 JITCodeEntry* CreateJITCodeEntry(std::vector<uint8_t> symfile);
@@ -37,7 +58,8 @@ void DeleteJITCodeEntry(JITCodeEntry* entry);
 
 // Notify native debugger about new JITed code by passing in-memory ELF.
 // The address is used only to uniquely identify the entry.
-// It takes ownership of the in-memory ELF file.
+// It takes ownership of the in-memory ELF file. The entry may later be replaced by one packed
+// with the entries of the neighbouring methods.
 void CreateJITCodeEntryForAddress(uintptr_t address, std::vector<uint8_t> symfile);
 
 // Notify native debugger that JITed code has been removed.
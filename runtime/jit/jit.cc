@@ -18,10 +18,17 @@
 
 #include <dlfcn.h>
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 #include "art_method-inl.h"
+#include "base/arena_allocator.h"
 #include "base/enums.h"
 #include "base/logging.h"
 #include "base/memory_tool.h"
+#include "base/systrace.h"
+#include "base/time_utils.h"
 #include "debugger.h"
 #include "entrypoints/runtime_asm_entrypoints.h"
 #include "interpreter/interpreter.h"
@@ -29,12 +36,14 @@
 #include "jit_code_cache.h"
 #include "oat_file_manager.h"
 #include "oat_quick_method_header.h"
+#include "os.h"
 #include "profile_compilation_info.h"
 #include "profile_saver.h"
 #include "runtime.h"
 #include "runtime_options.h"
 #include "stack.h"
 #include "stack_map.h"
+#include "startup_phases.h"
 #include "thread-inl.h"
 #include "thread_list.h"
 #include "utils.h"
@@ -51,12 +60,29 @@ static constexpr size_t kJitDefaultCompileThreshold           = 10000;  // Non-d
 static constexpr size_t kJitStressDefaultCompileThreshold     = 100;    // Fast-debug build.
 static constexpr size_t kJitSlowStressDefaultCompileThreshold = 2;      // Slow-debug build.
 
+// Compile requests are ranked by hotness, in samples per second since the method became warm,
+// which halves for every kJitHotnessHalfLifeNs a request waits. A compilation whose hotness decays
+// under kJitStaleHotness is dropped.
+static constexpr double kJitHotnessHalfLifeNs = 1e9;
+static constexpr double kJitStaleHotness = 1.0;
+static constexpr double kJitMinHotness = kJitStaleHotness / 2;
+
+// Maximum number of compile requests a compiler thread serves in a row. The arenas freed by one
+// compilation are reused by the next one of the batch, the pool is only trimmed at its end.
+static constexpr size_t kJitCompileBatchSize = 8;
+
+// With a CPU budget, the hotness thresholds are rescaled at most once per period, by a factor
+// of two: up when the compile queue is deeper than a batch per compiler thread or the compiler
+// threads used more than the budget, down when the queue is empty and they used under half.
+static constexpr uint64_t kJitThresholdControllerPeriodNs = MsToNs(1000);
+static constexpr uint32_t kJitMaxThresholdScale = 8 * Jit::kThresholdScaleOne;
+
 // JIT compiler
 void* Jit::jit_library_handle_= nullptr;
 void* Jit::jit_compiler_handle_ = nullptr;
 void* (*Jit::jit_load_)(bool*) = nullptr;
 void (*Jit::jit_unload_)(void*) = nullptr;
-bool (*Jit::jit_compile_method_)(void*, ArtMethod*, Thread*, bool) = nullptr;
+bool (*Jit::jit_compile_method_)(void*, ArtMethod*, Thread*, bool, bool) = nullptr;
 void (*Jit::jit_types_loaded_)(void*, mirror::Class**, size_t count) = nullptr;
 bool Jit::generate_debug_info_ = false;
 
@@ -73,6 +99,19 @@ JitOptions* JitOptions::CreateFromRuntimeArguments(const RuntimeArgumentMap& opt
       options.GetOrDefault(RuntimeArgumentMap::JITCodeCacheInitialCapacity);
   jit_options->code_cache_max_capacity_ =
       options.GetOrDefault(RuntimeArgumentMap::JITCodeCacheMaxCapacity);
+  jit_options->code_cache_huge_pages_ =
+      options.Exists(RuntimeArgumentMap::JITCodeCacheHugePages);
+  jit_options->code_cache_compaction_ =
+      options.Exists(RuntimeArgumentMap::JITCodeCacheCompaction);
+  jit_options->thread_pool_size_ = options.GetOrDefault(RuntimeArgumentMap::JITPoolThreads);
+  jit_options->warm_start_ = options.Exists(RuntimeArgumentMap::JITWarmStart);
+  jit_options->baseline_ = options.Exists(RuntimeArgumentMap::JITBaseline);
+  jit_options->profile_branches_ = options.Exists(RuntimeArgumentMap::JITProfileBranches);
+  jit_options->cpu_budget_percent_ = options.GetOrDefault(RuntimeArgumentMap::JITCpuBudget);
+  jit_options->zygote_profile_ = options.GetOrDefault(RuntimeArgumentMap::JITZygoteProfile);
+  if (jit_options->thread_pool_size_ == 0) {
+    LOG(FATAL) << "The JIT needs at least one compiler thread.";
+  }
   jit_options->dump_info_on_shutdown_ =
       options.Exists(RuntimeArgumentMap::DumpJITInfoOnShutdown);
   jit_options->profile_saver_options_ =
@@ -154,6 +193,25 @@ void Jit::DumpInfo(std::ostream& os) {
   cumulative_timings_.Dump(os);
   MutexLock mu(Thread::Current(), lock_);
   memory_use_.PrintMemoryUse(os);
+  if (number_of_compile_batches_ != 0) {
+    os << "Compile batches=" << number_of_compile_batches_
+       << " average size="
+       << static_cast<double>(number_of_batched_compilations_) / number_of_compile_batches_
+       << " throughput="
+       << static_cast<double>(number_of_batched_compilations_) * MsToNs(1000) /
+              std::max<uint64_t>(batch_compile_time_ns_, 1u)
+       << " methods/s\n";
+  }
+  if (cpu_budget_percent_ != 0) {
+    os << "Threshold updates=" << number_of_threshold_updates_
+       << " warm=" << WarmMethodThreshold()
+       << " hot=" << HotMethodThreshold()
+       << " osr=" << OSRMethodThreshold() << "\n";
+  }
+}
+
+void Jit::AddTimings(TimingJsonWriter* writer) const {
+  writer->AddCumulativeLogger(cumulative_timings_);
 }
 
 void Jit::DumpForSigQuit(std::ostream& os) {
@@ -165,29 +223,362 @@ void Jit::AddTimingLogger(const TimingLogger& logger) {
   cumulative_timings_.AddLogger(logger);
 }
 
+bool Jit::IsValidThresholdScale(uint32_t scale) const {
+  const uint32_t warm = ScaleThreshold(warm_method_threshold_, scale);
+  const uint32_t hot = ScaleThreshold(hot_method_threshold_, scale);
+  const uint32_t osr = ScaleThreshold(osr_method_threshold_, scale);
+  return warm > 0 &&
+      hot > warm &&
+      osr > hot &&
+      osr <= std::numeric_limits<uint16_t>::max() &&
+      priority_thread_weight_ <= hot;
+}
+
+void Jit::UpdateThresholdScale(size_t backlog, uint64_t cpu_ns) {
+  const uint64_t now = NanoTime();
+  controller_window_cpu_ns_ += cpu_ns;
+  const uint64_t window_ns = now - controller_window_start_ns_;
+  if (window_ns < kJitThresholdControllerPeriodNs) {
+    return;
+  }
+  const uint64_t cpu_percent = controller_window_cpu_ns_ * 100 / window_ns;
+  controller_window_start_ns_ = now;
+  controller_window_cpu_ns_ = 0;
+
+  const uint32_t scale = threshold_scale_.LoadRelaxed();
+  uint32_t new_scale = scale;
+  if (backlog > kJitCompileBatchSize * thread_pool_size_ || cpu_percent > cpu_budget_percent_) {
+    if (scale < kJitMaxThresholdScale && IsValidThresholdScale(scale * 2)) {
+      new_scale = scale * 2;
+    }
+  } else if (backlog == 0 && cpu_percent < cpu_budget_percent_ / 2) {
+    // Going under the configured thresholds compiles earlier while there is CPU to spare.
+    if (scale > kThresholdScaleOne / 2 && IsValidThresholdScale(scale / 2)) {
+      new_scale = scale / 2;
+    }
+  }
+  if (new_scale == scale) {
+    return;
+  }
+  threshold_scale_.StoreRelaxed(new_scale);
+  number_of_threshold_updates_++;
+  VLOG(jit) << "JIT thresholds scaled by "
+            << static_cast<double>(new_scale) / kThresholdScaleOne
+            << " (warm=" << WarmMethodThreshold()
+            << ", hot=" << HotMethodThreshold()
+            << ", osr=" << OSRMethodThreshold()
+            << ") with " << backlog << " queued requests and "
+            << cpu_percent << "% compiler CPU";
+}
+
+class JitCompileTask FINAL : public Task {
+ public:
+  enum TaskKind {
+    kAllocateProfile,
+    kCompile,
+    kCompileBaseline,
+    kCompileOsr,
+    kOptimize
+  };
+
+  JitCompileTask(ArtMethod* method, TaskKind kind)
+      : method_(method), kind_(kind), enqueue_time_ns_(0u), hotness_(0.0), priority_(0.0) {
+    ScopedObjectAccess soa(Thread::Current());
+    // Add a global ref to the class to prevent class unloading until compilation is done.
+    klass_ = soa.Vm()->AddGlobalRef(soa.Self(), method_->GetDeclaringClass());
+    CHECK(klass_ != nullptr);
+  }
+
+  ~JitCompileTask() {
+    ScopedObjectAccess soa(Thread::Current());
+    soa.Vm()->DeleteGlobalRef(soa.Self(), klass_);
+  }
+
+  void Run(Thread* self) OVERRIDE {
+    ScopedObjectAccess soa(self);
+    if (kind_ == kCompile || kind_ == kOptimize) {
+      Runtime::Current()->GetJit()->CompileMethod(method_, self, /* osr */ false);
+    } else if (kind_ == kCompileBaseline) {
+      Runtime::Current()->GetJit()->CompileMethod(
+          method_, self, /* osr */ false, /* baseline */ true);
+    } else if (kind_ == kCompileOsr) {
+      Runtime::Current()->GetJit()->CompileMethod(method_, self, /* osr */ true);
+    } else {
+      DCHECK(kind_ == kAllocateProfile);
+      if (ProfilingInfo::Create(self, method_, /* retry_allocation */ true)) {
+        VLOG(jit) << "Start profiling " << ArtMethod::PrettyMethod(method_);
+      }
+    }
+    ProfileSaver::NotifyJitActivity();
+  }
+
+  void Finalize() OVERRIDE {
+    delete this;
+  }
+
+  ArtMethod* GetMethod() const {
+    return method_;
+  }
+
+  TaskKind GetKind() const {
+    return kind_;
+  }
+
+  // Record when the request is enqueued and how hot its method is, that is the number of samples
+  // per second since the method became warm.
+  void SetEnqueueTime(uint64_t enqueue_time_ns, double hotness) {
+    enqueue_time_ns_ = enqueue_time_ns;
+    hotness_ = hotness;
+    // Decayed hotness compares the same way as log2(hotness) - (now - enqueue_time) / half_life,
+    // and `now` is the same for all requests.
+    priority_ = std::log2(hotness > kJitMinHotness ? hotness : kJitMinHotness) +
+        static_cast<double>(enqueue_time_ns) / kJitHotnessHalfLifeNs;
+  }
+
+  // Higher is more urgent: OSR requests block a thread in the interpreter, profile allocations
+  // are cheap, then compilations go by decayed hotness. Optimizing methods that already have
+  // baseline code waits for all of those.
+  bool IsMoreUrgentThan(const JitCompileTask& other) const {
+    if (kind_ != other.kind_) {
+      return KindRank(kind_) > KindRank(other.kind_);
+    }
+    return priority_ > other.priority_;
+  }
+
+  // Whether a compilation waited behind hotter ones until its hotness decayed to nothing. OSR
+  // requests, profile allocations and optimizations of baseline code never go stale.
+  bool IsStale(uint64_t now_ns) const {
+    if (kind_ != kCompile && kind_ != kCompileBaseline) {
+      return false;
+    }
+    const double waited = static_cast<double>(now_ns - enqueue_time_ns_) / kJitHotnessHalfLifeNs;
+    return hotness_ * std::exp2(-waited) < kJitStaleHotness;
+  }
+
+  // Drop a stale request: restart the method's counter from the warm threshold so that it gets
+  // requested again, with a fresh hotness, if it is still being executed.
+  void Drop(Thread* self, uint16_t warm_method_threshold) {
+    ScopedObjectAccess soa(self);
+    VLOG(jit) << "Dropping stale compile request for " << ArtMethod::PrettyMethod(method_);
+    if (!method_->IsNative()) {
+      ProfilingInfo* info = method_->GetProfilingInfo(kRuntimePointerSize);
+      if (info != nullptr) {
+        info->SetWarmTimeNs(NanoTime());
+      }
+    }
+    method_->SetCounter(warm_method_threshold);
+  }
+
+ private:
+  static int KindRank(TaskKind kind) {
+    switch (kind) {
+      case kOptimize: return 0;
+      case kCompile: return 1;
+      case kCompileBaseline: return 1;
+      case kAllocateProfile: return 2;
+      case kCompileOsr: return 3;
+    }
+    LOG(FATAL) << "Unreachable";
+    UNREACHABLE();
+  }
+
+  ArtMethod* const method_;
+  const TaskKind kind_;
+  jobject klass_;
+  uint64_t enqueue_time_ns_;
+  double hotness_;
+  double priority_;
+
+  DISALLOW_IMPLICIT_CONSTRUCTORS(JitCompileTask);
+};
+
+// Compile requests waiting for the JIT thread, kept in order of urgency instead of in the thread
+// pool's FIFO, so that a burst of barely warm methods does not delay a hot loop. The hotness of a
+// request halves for every half life it waits; as all requests decay at the same rate their order
+// does not change, but a request that starves behind hotter ones eventually goes stale.
+class JitCompileQueue {
+ public:
+  JitCompileQueue()
+      : lock_("JIT compile queue lock"),
+        compiler_slot_cond_("JIT compiler slot condition", lock_),
+        max_compilers_(1u),
+        active_compilers_(0u) {}
+
+  void Add(Thread* self, JitCompileTask* task) REQUIRES(!lock_) {
+    MutexLock mu(self, lock_);
+    tasks_.push_back(task);
+    std::push_heap(tasks_.begin(), tasks_.end(), LessUrgent);
+    ART_TRACE_COUNTER("JIT queue depth", tasks_.size());
+  }
+
+  size_t Size(Thread* self) REQUIRES(!lock_) {
+    MutexLock mu(self, lock_);
+    return tasks_.size();
+  }
+
+  // Return the most urgent request, or null if there is none.
+  JitCompileTask* Take(Thread* self) REQUIRES(!lock_) {
+    MutexLock mu(self, lock_);
+    if (tasks_.empty()) {
+      return nullptr;
+    }
+    std::pop_heap(tasks_.begin(), tasks_.end(), LessUrgent);
+    JitCompileTask* task = tasks_.back();
+    tasks_.pop_back();
+    ART_TRACE_COUNTER("JIT queue depth", tasks_.size());
+    return task;
+  }
+
+  // Block until fewer than the allowed number of compiler threads are working on requests.
+  void AcquireCompilerSlot(Thread* self) REQUIRES(!lock_) {
+    MutexLock mu(self, lock_);
+    while (active_compilers_ >= max_compilers_) {
+      compiler_slot_cond_.Wait(self);
+    }
+    ++active_compilers_;
+  }
+
+  void ReleaseCompilerSlot(Thread* self) REQUIRES(!lock_) {
+    MutexLock mu(self, lock_);
+    DCHECK_GT(active_compilers_, 0u);
+    --active_compilers_;
+    compiler_slot_cond_.Signal(self);
+  }
+
+  // Threads over a lowered limit finish their current compilation before blocking.
+  void SetMaxCompilers(Thread* self, size_t max_compilers) REQUIRES(!lock_) {
+    DCHECK_GT(max_compilers, 0u);
+    MutexLock mu(self, lock_);
+    max_compilers_ = max_compilers;
+    compiler_slot_cond_.Broadcast(self);
+  }
+
+  // Like ThreadPool::RemoveAllTasks, forget the requests without running or deleting them.
+  void Clear(Thread* self) REQUIRES(!lock_) {
+    MutexLock mu(self, lock_);
+    tasks_.clear();
+    ART_TRACE_COUNTER("JIT queue depth", 0);
+  }
+
+ private:
+  static bool LessUrgent(const JitCompileTask* a, const JitCompileTask* b) {
+    return b->IsMoreUrgentThan(*a);
+  }
+
+  Mutex lock_;
+  ConditionVariable compiler_slot_cond_ GUARDED_BY(lock_);
+  std::vector<JitCompileTask*> tasks_ GUARDED_BY(lock_);
+  size_t max_compilers_ GUARDED_BY(lock_);
+  size_t active_compilers_ GUARDED_BY(lock_);
+
+  DISALLOW_COPY_AND_ASSIGN(JitCompileQueue);
+};
+
+void Jit::DoneCompileBatch(size_t batch_size, uint64_t duration_ns, uint64_t cpu_ns) {
+  // Give back the memory of the batch.
+  Runtime::Current()->GetJitArenaPool()->TrimMaps();
+  Thread* self = Thread::Current();
+  const size_t backlog = compile_queue_->Size(self);
+  MutexLock mu(self, lock_);
+  number_of_compile_batches_++;
+  number_of_batched_compilations_ += batch_size;
+  batch_compile_time_ns_ += duration_ns;
+  if (cpu_budget_percent_ != 0) {
+    UpdateThresholdScale(backlog, cpu_ns);
+  }
+}
+
+// The thread pool gets one of these per request added to the compile queue. It runs whichever
+// request is the most urgent once a worker gets to it, dropping the stale ones on the way.
+class JitCompileQueueTask FINAL : public Task {
+ public:
+  JitCompileQueueTask(Jit* jit, JitCompileQueue* queue, uint16_t warm_method_threshold)
+      : jit_(jit), queue_(queue), warm_method_threshold_(warm_method_threshold) {}
+
+  void Run(Thread* self) OVERRIDE {
+    queue_->AcquireCompilerSlot(self);
+    // Requests served here leave the queue tasks added for them with nothing to do.
+    const uint64_t start_ns = NanoTime();
+    const uint64_t start_cpu_ns = ThreadCpuNanoTime();
+    size_t batch_size = 0;
+    for (JitCompileTask* task = queue_->Take(self); task != nullptr; task = queue_->Take(self)) {
+      const bool stale = task->IsStale(NanoTime());
+      if (stale) {
+        task->Drop(self, warm_method_threshold_);
+      } else {
+        task->Run(self);
+        if (task->GetKind() != JitCompileTask::kAllocateProfile) {
+          ++batch_size;
+        }
+      }
+      task->Finalize();
+      if (batch_size == kJitCompileBatchSize) {
+        break;
+      }
+    }
+    if (batch_size != 0) {
+      jit_->DoneCompileBatch(
+          batch_size, NanoTime() - start_ns, ThreadCpuNanoTime() - start_cpu_ns);
+    }
+    queue_->ReleaseCompilerSlot(self);
+  }
+
+  void Finalize() OVERRIDE {
+    delete this;
+  }
+
+ private:
+  Jit* const jit_;
+  JitCompileQueue* const queue_;
+  const uint16_t warm_method_threshold_;
+
+  DISALLOW_IMPLICIT_CONSTRUCTORS(JitCompileQueueTask);
+};
+
 Jit::Jit() : dump_info_on_shutdown_(false),
              cumulative_timings_("JIT timings"),
              memory_use_("Memory used for compilation", 16),
              lock_("JIT memory use lock"),
+             number_of_compile_batches_(0),
+             number_of_batched_compilations_(0),
+             batch_compile_time_ns_(0),
+             controller_window_start_ns_(0),
+             controller_window_cpu_ns_(0),
+             number_of_threshold_updates_(0),
              use_jit_compilation_(true),
              hot_method_threshold_(0),
              warm_method_threshold_(0),
              osr_method_threshold_(0),
              priority_thread_weight_(0),
-             invoke_transition_weight_(0) {}
+             invoke_transition_weight_(0),
+             thread_pool_size_(0),
+             cpu_budget_percent_(0),
+             threshold_scale_(kThresholdScaleOne),
+             warm_start_(false),
+             baseline_(false),
+             profile_branches_(false),
+             warm_start_lock_("JIT warm start lock"),
+             compile_queue_(new JitCompileQueue()) {}
+
+JitCodeCache* Jit::CreateCodeCache(JitOptions* options, bool for_zygote, std::string* error_msg) {
+  return JitCodeCache::Create(options->GetCodeCacheInitialCapacity(),
+                              options->GetCodeCacheMaxCapacity(),
+                              generate_debug_info_,
+                              options->UseCodeCacheHugePages(),
+                              options->UseCodeCacheCompaction(),
+                              for_zygote,
+                              error_msg);
+}
 
-Jit* Jit::Create(JitOptions* options, std::string* error_msg) {
+Jit* Jit::Create(JitOptions* options, bool for_zygote, std::string* error_msg) {
   DCHECK(options->UseJitCompilation() || options->GetProfileSaverOptions().IsEnabled());
+  DCHECK(!for_zygote || options->UseJitCompilation());
   std::unique_ptr<Jit> jit(new Jit);
   jit->dump_info_on_shutdown_ = options->DumpJitInfoOnShutdown();
   if (jit_compiler_handle_ == nullptr && !LoadCompiler(error_msg)) {
     return nullptr;
   }
-  jit->code_cache_.reset(JitCodeCache::Create(
-      options->GetCodeCacheInitialCapacity(),
-      options->GetCodeCacheMaxCapacity(),
-      jit->generate_debug_info_,
-      error_msg));
+  jit->code_cache_.reset(CreateCodeCache(options, for_zygote, error_msg));
   if (jit->GetCodeCache() == nullptr) {
     return nullptr;
   }
@@ -205,14 +596,48 @@ Jit* Jit::Create(JitOptions* options, std::string* error_msg) {
   jit->osr_method_threshold_ = options->GetOsrThreshold();
   jit->priority_thread_weight_ = options->GetPriorityThreadWeight();
   jit->invoke_transition_weight_ = options->GetInvokeTransitionWeight();
+  jit->thread_pool_size_ = options->GetThreadPoolSize();
+  // The thresholds are fixed when compiling at first use.
+  if (options->GetCompileThreshold() != 0) {
+    jit->cpu_budget_percent_ = options->GetCpuBudgetPercent();
+  }
+  {
+    MutexLock mu(Thread::Current(), jit->lock_);
+    jit->controller_window_start_ns_ = NanoTime();
+  }
+  jit->warm_start_ = options->UseWarmStart() && options->UseJitCompilation();
+  // Compiling at first use is synchronous, it may as well produce optimized code.
+  jit->baseline_ = options->UseBaseline() && options->GetCompileThreshold() != 0;
+  jit->profile_branches_ = options->ProfileBranches();
 
-  jit->CreateThreadPool();
+  // The zygote must not start threads before forking.
+  if (!for_zygote) {
+    jit->CreateThreadPool();
 
-  // Notify native debugger about the classes already loaded before the creation of the jit.
-  jit->DumpTypeInfoForLoadedTypes(Runtime::Current()->GetClassLinker());
+    // Notify native debugger about the classes already loaded before the creation of the jit.
+    jit->DumpTypeInfoForLoadedTypes(Runtime::Current()->GetClassLinker());
+  }
   return jit.release();
 }
 
+bool Jit::PostZygoteFork(JitOptions* options, std::string* error_msg) {
+  DCHECK(code_cache_->IsZygoteCache());
+  DCHECK(thread_pool_ == nullptr);
+  std::unique_ptr<JitCodeCache> code_cache(
+      CreateCodeCache(options, /* for_zygote */ false, error_msg));
+  if (code_cache == nullptr) {
+    return false;
+  }
+  code_cache->AttachZygoteCodeCache(code_cache_.release());
+  code_cache_ = std::move(code_cache);
+  // The options of the child may differ from the zygote's.
+  profile_saver_options_ = options->GetProfileSaverOptions();
+
+  CreateThreadPool();
+  DumpTypeInfoForLoadedTypes(Runtime::Current()->GetClassLinker());
+  return true;
+}
+
 bool Jit::LoadCompilerLibrary(std::string* error_msg) {
   jit_library_handle_ = dlopen(
       kIsDebugBuild ? "libartd-compiler.so" : "libart-compiler.so", RTLD_NOW);
@@ -235,7 +660,7 @@ bool Jit::LoadCompilerLibrary(std::string* error_msg) {
     *error_msg = "JIT couldn't find jit_unload entry point";
     return false;
   }
-  jit_compile_method_ = reinterpret_cast<bool (*)(void*, ArtMethod*, Thread*, bool)>(
+  jit_compile_method_ = reinterpret_cast<bool (*)(void*, ArtMethod*, Thread*, bool, bool)>(
       dlsym(jit_library_handle_, "jit_compile_method"));
   if (jit_compile_method_ == nullptr) {
     dlclose(jit_library_handle_);
@@ -269,9 +694,10 @@ bool Jit::LoadCompiler(std::string* error_msg) {
   return true;
 }
 
-bool Jit::CompileMethod(ArtMethod* method, Thread* self, bool osr) {
+bool Jit::CompileMethod(ArtMethod* method, Thread* self, bool osr, bool baseline) {
   DCHECK(Runtime::Current()->UseJitCompilation());
   DCHECK(!method->IsRuntimeMethod());
+  ScopedStartupPhase startup_phase("FirstJitCompilation", /* once */ true);
 
   // Don't compile the method if it has breakpoints.
   if (Dbg::IsDebuggerActive() && Dbg::MethodHasAnyBreakpoints(method)) {
@@ -289,19 +715,27 @@ bool Jit::CompileMethod(ArtMethod* method, Thread* self, bool osr) {
   // If we get a request to compile a proxy method, we pass the actual Java method
   // of that proxy method, as the compiler does not expect a proxy method.
   ArtMethod* method_to_compile = method->GetInterfaceMethodIfProxy(kRuntimePointerSize);
-  if (!code_cache_->NotifyCompilationOf(method_to_compile, self, osr)) {
+  if (!code_cache_->NotifyCompilationOf(method_to_compile, self, osr, baseline)) {
     return false;
   }
 
   VLOG(jit) << "Compiling method "
             << ArtMethod::PrettyMethod(method_to_compile)
-            << " osr=" << std::boolalpha << osr;
-  bool success = jit_compile_method_(jit_compiler_handle_, method_to_compile, self, osr);
+            << " osr=" << std::boolalpha << osr
+            << " baseline=" << baseline;
+  bool success =
+      jit_compile_method_(jit_compiler_handle_, method_to_compile, self, osr, baseline);
   code_cache_->DoneCompiling(method_to_compile, self, osr);
   if (!success) {
     VLOG(jit) << "Failed to compile method "
               << ArtMethod::PrettyMethod(method_to_compile)
-              << " osr=" << std::boolalpha << osr;
+              << " osr=" << std::boolalpha << osr
+              << " baseline=" << baseline;
+  } else if (baseline && thread_pool_ != nullptr) {
+    // The thread pool is gone when shutting down, the baseline code then stays.
+    AddCompileTask(self,
+                   new JitCompileTask(method, JitCompileTask::kOptimize),
+                   method->GetCounter());
   }
   if (kIsDebugBuild) {
     if (self->IsExceptionPending()) {
@@ -321,9 +755,10 @@ void Jit::CreateThreadPool() {
 
   // We need peers as we may report the JIT thread, e.g., in the debugger.
   constexpr bool kJitPoolNeedsPeers = true;
-  thread_pool_.reset(new ThreadPool("Jit thread pool", 1, kJitPoolNeedsPeers));
+  thread_pool_.reset(new ThreadPool("Jit thread pool", thread_pool_size_, kJitPoolNeedsPeers));
 
   thread_pool_->SetPthreadPriority(kJitPoolThreadPthreadPriority);
+  UpdateProcessState(Runtime::Current()->InJankPerceptibleProcessState());
   Start();
 }
 
@@ -348,11 +783,34 @@ void Jit::DeleteThreadPool() {
     // will finish in a short period, so it's not worth adding a suspend logic
     // here. Besides, this is only done for shutdown.
     pool->Wait(self, false, false);
+    compile_queue_->Clear(self);
   }
 }
 
+// Reads the warm start profile on a JIT thread rather than on the thread registering the app.
+class JitWarmStartTask FINAL : public Task {
+ public:
+  explicit JitWarmStartTask(const std::string& filename) : filename_(filename) {}
+
+  void Run(Thread* self) OVERRIDE {
+    Runtime::Current()->GetJit()->LoadWarmStartProfile(self, filename_);
+  }
+
+  void Finalize() OVERRIDE {
+    delete this;
+  }
+
+ private:
+  const std::string filename_;
+
+  DISALLOW_IMPLICIT_CONSTRUCTORS(JitWarmStartTask);
+};
+
 void Jit::StartProfileSaver(const std::string& filename,
                             const std::vector<std::string>& code_paths) {
+  if (warm_start_ && thread_pool_ != nullptr) {
+    thread_pool_->AddTask(Thread::Current(), new JitWarmStartTask(filename));
+  }
   if (profile_saver_options_.IsEnabled()) {
     ProfileSaver::Start(profile_saver_options_,
                         filename,
@@ -361,6 +819,153 @@ void Jit::StartProfileSaver(const std::string& filename,
   }
 }
 
+// Read the profile in `filename`, or return null. The profile only matches dex files with the
+// same location and checksum.
+static std::unique_ptr<MappedProfile> LoadMappedProfile(const std::string& filename) {
+  std::string error_msg;
+  std::unique_ptr<MappedProfile> profile;
+  if (!OS::FileExists(ProfileCompilationInfo::GetDeltaLogFilename(filename).c_str())) {
+    // Query a profile in the current format in place. The profile saver rewrites the file, so
+    // read it rather than mapping it.
+    profile = MappedProfile::Read(filename, &error_msg);
+  }
+  if (profile == nullptr) {
+    // Merge the delta log, or convert a profile in the previous format.
+    ProfileCompilationInfo info;
+    std::vector<uint8_t> data;
+    if (!info.Load(filename, /* clear_if_invalid */ false) || !info.Serialize(&data)) {
+      LOG(WARNING) << "JIT could not load profile " << filename;
+      return nullptr;
+    }
+    profile = MappedProfile::Create(std::move(data), &error_msg);
+    CHECK(profile != nullptr) << error_msg;
+  }
+  return profile;
+}
+
+class CollectClassesVisitor : public ClassVisitor {
+ public:
+  bool operator()(ObjPtr<mirror::Class> klass) OVERRIDE REQUIRES_SHARED(Locks::mutator_lock_) {
+    classes_.push_back(klass.Ptr());
+    return true;
+  }
+
+  const std::vector<mirror::Class*>& GetClasses() const {
+    return classes_;
+  }
+
+ private:
+  std::vector<mirror::Class*> classes_;
+};
+
+void Jit::LoadWarmStartProfile(Thread* self, const std::string& filename) {
+  // Methods of updated apks are not primed.
+  std::unique_ptr<MappedProfile> profile = LoadMappedProfile(filename);
+  if (profile == nullptr) {
+    return;
+  }
+  VLOG(jit) << "JIT warm start with " << profile->GetNumberOfMethods() << " methods from "
+            << filename;
+  {
+    MutexLock mu(self, warm_start_lock_);
+    warm_start_profile_ = std::move(profile);
+  }
+
+  // Prime the classes loaded before the app registered its profile.
+  ScopedObjectAccess soa(self);
+  CollectClassesVisitor visitor;
+  Runtime::Current()->GetClassLinker()->VisitClasses(&visitor);
+  for (mirror::Class* klass : visitor.GetClasses()) {
+    PrimeHotMethods(self, klass);
+  }
+}
+
+void Jit::CompileZygoteMethods(Thread* self, const std::string& filename) {
+  DCHECK(code_cache_->IsZygoteCache());
+  ScopedTrace trace(__FUNCTION__);
+  std::unique_ptr<MappedProfile> profile = LoadMappedProfile(filename);
+  if (profile == nullptr) {
+    return;
+  }
+  ScopedObjectAccess soa(self);
+  std::vector<ArtMethod*> hot_methods;
+  {
+    // Classes may move while compiling, collect the methods first.
+    CollectClassesVisitor visitor;
+    Runtime::Current()->GetClassLinker()->VisitClasses(&visitor);
+    for (mirror::Class* klass : visitor.GetClasses()) {
+      // Only the boot classes are shared by all the children, and never unloaded.
+      if (klass->GetClassLoader() != nullptr ||
+          !klass->IsResolved() ||
+          klass->IsProxyClass() ||
+          klass->IsArrayClass()) {
+        continue;
+      }
+      for (ArtMethod& method : klass->GetDeclaredMethods(kRuntimePointerSize)) {
+        if (method.IsNative() || method.IsAbstract() || method.IsClassInitializer() ||
+            !method.IsCompilable() ||
+            method.GetOatMethodQuickCode(kRuntimePointerSize) != nullptr) {
+          continue;
+        }
+        MethodReference ref(method.GetDexFile(), method.GetDexMethodIndex());
+        if (profile->GetMethodHotness(ref).IsHot()) {
+          hot_methods.push_back(&method);
+        }
+      }
+    }
+  }
+  size_t compiled = 0;
+  for (ArtMethod* method : hot_methods) {
+    // The compiler needs a ProfilingInfo. The zygote's ones are not used after the fork: the
+    // children profile the methods they interpret again.
+    if (method->GetProfilingInfo(kRuntimePointerSize) == nullptr &&
+        !ProfilingInfo::Create(self, method, /* retry_allocation */ false)) {
+      continue;
+    }
+    if (CompileMethod(method, self, /* osr */ false)) {
+      ++compiled;
+    }
+    method->SetProfilingInfo(nullptr);
+  }
+  VLOG(jit) << "JIT compiled " << compiled << " of the " << hot_methods.size()
+            << " hot methods of " << filename << " for the zygote";
+}
+
+void Jit::PrimeHotMethods(Thread* self, mirror::Class* klass) {
+  if (!klass->IsResolved() || klass->IsProxyClass() || klass->IsArrayClass()) {
+    return;
+  }
+  std::vector<ArtMethod*> hot_methods;
+  {
+    MutexLock mu(self, warm_start_lock_);
+    if (warm_start_profile_ == nullptr) {
+      return;
+    }
+    for (ArtMethod& method : klass->GetDeclaredMethods(kRuntimePointerSize)) {
+      if (method.IsNative() || method.IsAbstract() || method.IsClassInitializer() ||
+          !method.IsCompilable()) {
+        continue;
+      }
+      MethodReference ref(method.GetDexFile(), method.GetDexMethodIndex());
+      if (warm_start_profile_->GetMethodHotness(ref).IsHot()) {
+        hot_methods.push_back(&method);
+      }
+    }
+  }
+  for (ArtMethod* method : hot_methods) {
+    // The compiler needs a ProfilingInfo, which AddSamples would only create at the warm
+    // threshold. Don't retry the allocation, a failure only leaves the method cold.
+    if (method->GetProfilingInfo(kRuntimePointerSize) == nullptr &&
+        !ProfilingInfo::Create(self, method, /* retry_allocation */ false)) {
+      continue;
+    }
+    const size_t hot_method_threshold = HotMethodThreshold();
+    if (method->GetCounter() < hot_method_threshold - 1) {
+      method->SetCounter(hot_method_threshold - 1);
+    }
+  }
+}
+
 void Jit::StopProfileSaver() {
   if (profile_saver_options_.IsEnabled() && ProfileSaver::IsStarted()) {
     ProfileSaver::Stop(dump_info_on_shutdown_);
@@ -402,6 +1007,9 @@ void Jit::NewTypeLoadedIfUsingJit(mirror::Class* type) {
     DCHECK(jit->jit_types_loaded_ != nullptr);
     jit->jit_types_loaded_(jit->jit_compiler_handle_, &type, 1);
   }
+  if (jit->warm_start_) {
+    jit->PrimeHotMethods(Thread::Current(), type);
+  }
 }
 
 void Jit::DumpTypeInfoForLoadedTypes(ClassLinker* linker) {
@@ -480,14 +1088,25 @@ bool Jit::MaybeDoOnStackReplacement(Thread* thread,
       return false;
     }
 
+    // Every loop header of the method is an OSR entry, unless the compiler removed the loop.
+    // Remember the ones without an entry to avoid searching the stack maps at each back edge.
+    const uint32_t target_dex_pc = dex_pc + dex_pc_offset;
+    ProfilingInfo* info = method->GetProfilingInfo(kRuntimePointerSize);
+    if (info != nullptr && info->IsOsrEntryMissing(target_dex_pc)) {
+      return false;
+    }
+
     CodeInfo code_info = osr_method->GetOptimizedCodeInfo();
     CodeInfoEncoding encoding = code_info.ExtractEncoding();
 
     // Find stack map starting at the target dex_pc.
-    StackMap stack_map = code_info.GetOsrStackMapForDexPc(dex_pc + dex_pc_offset, encoding);
+    StackMap stack_map = code_info.GetOsrStackMapForDexPc(target_dex_pc, encoding);
     if (!stack_map.IsValid()) {
       // There is no OSR stack map for this dex pc offset. Just return to the interpreter in the
       // hope that the next branch has one.
+      if (info != nullptr) {
+        info->SetOsrEntryMissing(target_dex_pc);
+      }
       return false;
     }
 
@@ -498,6 +1117,10 @@ bool Jit::MaybeDoOnStackReplacement(Thread* thread,
       return false;
     }
 
+    if (info != nullptr) {
+      info->AddOsrTransition(target_dex_pc);
+    }
+
     // We found a stack map, now fill the frame with dex register values from the interpreter's
     // shadow frame.
     DexRegisterMap vreg_map =
@@ -587,52 +1210,28 @@ void Jit::AddMemoryUsage(ArtMethod* method, size_t bytes) {
   memory_use_.AddValue(bytes);
 }
 
-class JitCompileTask FINAL : public Task {
- public:
-  enum TaskKind {
-    kAllocateProfile,
-    kCompile,
-    kCompileOsr
-  };
-
-  JitCompileTask(ArtMethod* method, TaskKind kind) : method_(method), kind_(kind) {
-    ScopedObjectAccess soa(Thread::Current());
-    // Add a global ref to the class to prevent class unloading until compilation is done.
-    klass_ = soa.Vm()->AddGlobalRef(soa.Self(), method_->GetDeclaringClass());
-    CHECK(klass_ != nullptr);
+void Jit::AddCompileTask(Thread* self, JitCompileTask* task, int32_t count) {
+  const uint64_t now = NanoTime();
+  double hotness = 0.0;
+  const bool is_jni_stub = task->GetMethod()->IsNative();
+  ProfilingInfo* info = (task->GetKind() == JitCompileTask::kAllocateProfile || is_jni_stub)
+      ? nullptr
+      : task->GetMethod()->GetProfilingInfo(kRuntimePointerSize);
+  if (is_jni_stub) {
+    // Native methods have no warm time to measure their hotness from, and their JNI stubs are
+    // cheap to compile: serve them first and never let them go stale.
+    hotness = std::numeric_limits<double>::infinity();
+  } else if (info != nullptr && now > info->GetWarmTimeNs()) {
+    hotness = static_cast<double>(count - static_cast<int32_t>(WarmMethodThreshold())) *
+        MsToNs(1000) /
+        (now - info->GetWarmTimeNs());
   }
-
-  ~JitCompileTask() {
-    ScopedObjectAccess soa(Thread::Current());
-    soa.Vm()->DeleteGlobalRef(soa.Self(), klass_);
-  }
-
-  void Run(Thread* self) OVERRIDE {
-    ScopedObjectAccess soa(self);
-    if (kind_ == kCompile) {
-      Runtime::Current()->GetJit()->CompileMethod(method_, self, /* osr */ false);
-    } else if (kind_ == kCompileOsr) {
-      Runtime::Current()->GetJit()->CompileMethod(method_, self, /* osr */ true);
-    } else {
-      DCHECK(kind_ == kAllocateProfile);
-      if (ProfilingInfo::Create(self, method_, /* retry_allocation */ true)) {
-        VLOG(jit) << "Start profiling " << ArtMethod::PrettyMethod(method_);
-      }
-    }
-    ProfileSaver::NotifyJitActivity();
-  }
-
-  void Finalize() OVERRIDE {
-    delete this;
-  }
-
- private:
-  ArtMethod* const method_;
-  const TaskKind kind_;
-  jobject klass_;
-
-  DISALLOW_IMPLICIT_CONSTRUCTORS(JitCompileTask);
-};
+  task->SetEnqueueTime(now, hotness);
+  compile_queue_->Add(self, task);
+  thread_pool_->AddTask(self, new JitCompileQueueTask(this,
+                                                      compile_queue_.get(),
+                                                      warm_method_threshold_));
+}
 
 void Jit::AddSamples(Thread* self, ArtMethod* method, uint16_t count, bool with_backedges) {
   if (thread_pool_ == nullptr) {
@@ -641,24 +1240,42 @@ void Jit::AddSamples(Thread* self, ArtMethod* method, uint16_t count, bool with_
     return;
   }
 
-  if (method->IsClassInitializer() || method->IsNative() || !method->IsCompilable()) {
+  if (method->IsClassInitializer() || !method->IsCompilable()) {
     // We do not want to compile such methods.
     return;
   }
   DCHECK(thread_pool_ != nullptr);
-  DCHECK_GT(warm_method_threshold_, 0);
-  DCHECK_GT(hot_method_threshold_, warm_method_threshold_);
-  DCHECK_GT(osr_method_threshold_, hot_method_threshold_);
+  // Read the scale once so that the thresholds are consistent with each other.
+  const uint32_t scale = threshold_scale_.LoadRelaxed();
+  const int32_t warm_method_threshold = ScaleThreshold(warm_method_threshold_, scale);
+  const int32_t hot_method_threshold = ScaleThreshold(hot_method_threshold_, scale);
+  const int32_t osr_method_threshold = ScaleThreshold(osr_method_threshold_, scale);
+  DCHECK_GT(warm_method_threshold, 0);
+  DCHECK_GT(hot_method_threshold, warm_method_threshold);
+  DCHECK_GT(osr_method_threshold, hot_method_threshold);
   DCHECK_GE(priority_thread_weight_, 1);
-  DCHECK_LE(priority_thread_weight_, hot_method_threshold_);
+  DCHECK_LE(priority_thread_weight_, hot_method_threshold);
 
   int32_t starting_count = method->GetCounter();
   if (Jit::ShouldUsePriorityThreadWeight()) {
     count *= priority_thread_weight_;
   }
   int32_t new_count = starting_count + count;   // int32 here to avoid wrap-around;
-  if (starting_count < warm_method_threshold_) {
-    if ((new_count >= warm_method_threshold_) &&
+  if (UNLIKELY(method->IsNative())) {
+    // Native methods cannot have a ProfilingInfo, which would replace their JNI entry point, and
+    // their JNI stub has nothing to optimize: compile it as soon as the method is hot.
+    if (starting_count < hot_method_threshold) {
+      if (use_jit_compilation_ &&
+          (new_count >= hot_method_threshold) &&
+          !code_cache_->ContainsPc(method->GetEntryPointFromQuickCompiledCode())) {
+        AddCompileTask(self, new JitCompileTask(method, JitCompileTask::kCompile), new_count);
+      }
+      method->SetCounter(std::min(new_count, hot_method_threshold));
+    }
+    return;
+  }
+  if (starting_count < warm_method_threshold) {
+    if ((new_count >= warm_method_threshold) &&
         (method->GetProfilingInfo(kRuntimePointerSize) == nullptr)) {
       bool success = ProfilingInfo::Create(self, method, /* retry_allocation */ false);
       if (success) {
@@ -675,28 +1292,32 @@ void Jit::AddSamples(Thread* self, ArtMethod* method, uint16_t count, bool with_
       if (!success) {
         // We failed allocating. Instead of doing the collection on the Java thread, we push
         // an allocation to a compiler thread, that will do the collection.
-        thread_pool_->AddTask(self, new JitCompileTask(method, JitCompileTask::kAllocateProfile));
+        AddCompileTask(self,
+                       new JitCompileTask(method, JitCompileTask::kAllocateProfile),
+                       new_count);
       }
     }
     // Avoid jumping more than one state at a time.
-    new_count = std::min(new_count, hot_method_threshold_ - 1);
+    new_count = std::min(new_count, hot_method_threshold - 1);
   } else if (use_jit_compilation_) {
-    if (starting_count < hot_method_threshold_) {
-      if ((new_count >= hot_method_threshold_) &&
+    if (starting_count < hot_method_threshold) {
+      if ((new_count >= hot_method_threshold) &&
           !code_cache_->ContainsPc(method->GetEntryPointFromQuickCompiledCode())) {
         DCHECK(thread_pool_ != nullptr);
-        thread_pool_->AddTask(self, new JitCompileTask(method, JitCompileTask::kCompile));
+        JitCompileTask::TaskKind kind =
+            baseline_ ? JitCompileTask::kCompileBaseline : JitCompileTask::kCompile;
+        AddCompileTask(self, new JitCompileTask(method, kind), new_count);
       }
       // Avoid jumping more than one state at a time.
-      new_count = std::min(new_count, osr_method_threshold_ - 1);
-    } else if (starting_count < osr_method_threshold_) {
+      new_count = std::min(new_count, osr_method_threshold - 1);
+    } else if (starting_count < osr_method_threshold) {
       if (!with_backedges) {
         // If the samples don't contain any back edge, we don't increment the hotness.
         return;
       }
-      if ((new_count >= osr_method_threshold_) &&  !code_cache_->IsOsrCompiled(method)) {
+      if ((new_count >= osr_method_threshold) &&  !code_cache_->IsOsrCompiled(method)) {
         DCHECK(thread_pool_ != nullptr);
-        thread_pool_->AddTask(self, new JitCompileTask(method, JitCompileTask::kCompileOsr));
+        AddCompileTask(self, new JitCompileTask(method, JitCompileTask::kCompileOsr), new_count);
       }
     }
   }
@@ -728,15 +1349,41 @@ void Jit::MethodEntered(Thread* thread, ArtMethod* method) {
 void Jit::InvokeVirtualOrInterface(ObjPtr<mirror::Object> this_object,
                                    ArtMethod* caller,
                                    uint32_t dex_pc,
-                                   ArtMethod* callee ATTRIBUTE_UNUSED) {
+                                   ArtMethod* callee) {
   ScopedAssertNoThreadSuspension ants(__FUNCTION__);
   DCHECK(this_object != nullptr);
   ProfilingInfo* info = caller->GetProfilingInfo(kRuntimePointerSize);
   if (info != nullptr) {
-    info->AddInvokeInfo(dex_pc, this_object->GetClass());
+    info->AddInvokeInfo(dex_pc, this_object->GetClass(), callee);
   }
 }
 
+void Jit::AddBranchInfo(ArtMethod* method, uint32_t dex_pc, bool taken) {
+  ScopedAssertNoThreadSuspension ants(__FUNCTION__);
+  ProfilingInfo* info = method->GetProfilingInfo(kRuntimePointerSize);
+  if (info != nullptr) {
+    info->AddBranchInfo(dex_pc, taken);
+  }
+}
+
+void Jit::AddTypeInfo(ObjPtr<mirror::Object> object, ArtMethod* method, uint32_t dex_pc) {
+  ScopedAssertNoThreadSuspension ants(__FUNCTION__);
+  DCHECK(object != nullptr);
+  ProfilingInfo* info = method->GetProfilingInfo(kRuntimePointerSize);
+  if (info != nullptr) {
+    info->AddTypeInfo(dex_pc, object->GetClass());
+  }
+}
+
+ArtMethod* Jit::GetCachedInvokeTarget(ObjPtr<mirror::Object> this_object,
+                                      ArtMethod* caller,
+                                      uint32_t dex_pc) {
+  ScopedAssertNoThreadSuspension ants(__FUNCTION__);
+  DCHECK(this_object != nullptr);
+  ProfilingInfo* info = caller->GetProfilingInfo(kRuntimePointerSize);
+  return (info != nullptr) ? info->GetInvokeTarget(dex_pc, this_object->GetClass()) : nullptr;
+}
+
 void Jit::WaitForCompilationToFinish(Thread* self) {
   if (thread_pool_ != nullptr) {
     thread_pool_->Wait(self, false, false);
@@ -755,6 +1402,10 @@ void Jit::Start() {
   GetThreadPool()->StartWorkers(Thread::Current());
 }
 
+void Jit::UpdateProcessState(bool jank_perceptible) {
+  compile_queue_->SetMaxCompilers(Thread::Current(), jank_perceptible ? thread_pool_size_ : 1u);
+}
+
 ScopedJitSuspend::ScopedJitSuspend() {
   jit::Jit* jit = Runtime::Current()->GetJit();
   was_on_ = (jit != nullptr) && (jit->GetThreadPool() != nullptr);
@@ -17,11 +17,13 @@
 #ifndef ART_RUNTIME_JIT_JIT_H_
 #define ART_RUNTIME_JIT_JIT_H_
 
+#include "atomic.h"
 #include "base/histogram-inl.h"
 #include "base/macros.h"
 #include "base/mutex.h"
 #include "base/timing_logger.h"
 #include "jit/profile_saver_options.h"
+#include "mapped_profile.h"
 #include "obj_ptr.h"
 #include "profile_compilation_info.h"
 #include "thread_pool.h"
@@ -41,6 +43,8 @@ class Class;
 namespace jit {
 
 class JitCodeCache;
+class JitCompileQueue;
+class JitCompileTask;
 class JitOptions;
 
 static constexpr int16_t kJitCheckForOSR = -1;
@@ -54,8 +58,22 @@ class Jit {
   static constexpr int16_t kJitRecheckOSRThreshold = 100;
 
   virtual ~Jit();
-  static Jit* Create(JitOptions* options, std::string* error_msg);
-  bool CompileMethod(ArtMethod* method, Thread* self, bool osr)
+  // The Jit of a zygote, created `for_zygote`, only compiles into a code cache the children
+  // share, see CompileZygoteMethods. It has no compiler threads until PostZygoteFork.
+  static Jit* Create(JitOptions* options, bool for_zygote, std::string* error_msg);
+
+  // In a child of the zygote, move the zygote's code cache into a new code cache and start the
+  // compiler threads.
+  bool PostZygoteFork(JitOptions* options, std::string* error_msg);
+
+  // Before the zygote first forks, compile the hot methods of the boot classes that the profile
+  // in `filename` has and that have no AOT code.
+  void CompileZygoteMethods(Thread* self, const std::string& filename)
+      REQUIRES(!Locks::mutator_lock_);
+
+  // A baseline compilation skips the inliner and the loop and memory optimizations, and queues
+  // the optimized compilation that replaces its code once the JIT has nothing more urgent to do.
+  bool CompileMethod(ArtMethod* method, Thread* self, bool osr, bool baseline = false)
       REQUIRES_SHARED(Locks::mutator_lock_);
   void CreateThreadPool();
 
@@ -73,21 +91,31 @@ class Jit {
   void DumpInfo(std::ostream& os) REQUIRES(!lock_);
   // Add a timing logger to cumulative_timings_.
   void AddTimingLogger(const TimingLogger& logger);
+  // Add cumulative_timings_ to `writer`.
+  void AddTimings(TimingJsonWriter* writer) const;
+
+  // Called by a compiler thread after serving batch_size compile requests in a row, which took
+  // cpu_ns of its CPU time.
+  void DoneCompileBatch(size_t batch_size, uint64_t duration_ns, uint64_t cpu_ns)
+      REQUIRES(!lock_);
 
   void AddMemoryUsage(ArtMethod* method, size_t bytes)
       REQUIRES(!lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Unit of the scale applied to the configured hotness thresholds.
+  static constexpr uint32_t kThresholdScaleOne = 64;
+
   size_t OSRMethodThreshold() const {
-    return osr_method_threshold_;
+    return ScaleThreshold(osr_method_threshold_, threshold_scale_.LoadRelaxed());
   }
 
   size_t HotMethodThreshold() const {
-    return hot_method_threshold_;
+    return ScaleThreshold(hot_method_threshold_, threshold_scale_.LoadRelaxed());
   }
 
   size_t WarmMethodThreshold() const {
-    return warm_method_threshold_;
+    return ScaleThreshold(warm_method_threshold_, threshold_scale_.LoadRelaxed());
   }
 
   uint16_t PriorityThreadWeight() const {
@@ -119,6 +147,25 @@ class Jit {
                                 ArtMethod* callee)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Returns the method that an earlier call at `dex_pc` in `caller` found for a receiver of the
+  // same class as `this_object`, or null. A found call is recorded in the inline cache.
+  ArtMethod* GetCachedInvokeTarget(ObjPtr<mirror::Object> this_object,
+                                   ArtMethod* caller,
+                                   uint32_t dex_pc)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
+  bool ProfileBranches() const {
+    return profile_branches_;
+  }
+
+  // Record the outcome of the conditional branch at `dex_pc` in the ProfilingInfo of `method`.
+  void AddBranchInfo(ArtMethod* method, uint32_t dex_pc, bool taken)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
+  // Record the class of `object`, tested by the CHECK_CAST or INSTANCE_OF at `dex_pc`.
+  void AddTypeInfo(ObjPtr<mirror::Object> object, ArtMethod* method, uint32_t dex_pc)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
   void NotifyInterpreterToCompiledCodeTransition(Thread* self, ArtMethod* caller)
       REQUIRES_SHARED(Locks::mutator_lock_) {
     AddSamples(self, caller, invoke_transition_weight_, false);
@@ -136,11 +183,23 @@ class Jit {
                          const std::vector<std::string>& code_paths);
   void StopProfileSaver();
 
+  // With -Xjitwarmstart, read the hot methods a previous run saved in `filename` and prime the
+  // loaded ones so that they get compiled when next invoked. Methods of classes loaded later are
+  // primed by NewTypeLoadedIfUsingJit.
+  void LoadWarmStartProfile(Thread* self, const std::string& filename)
+      REQUIRES(!warm_start_lock_);
+
   void DumpForSigQuit(std::ostream& os) REQUIRES(!lock_);
 
   static void NewTypeLoadedIfUsingJit(mirror::Class* type)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Give the methods of `klass` that the warm start profile has as hot a ProfilingInfo and a
+  // hotness counter just under the compile threshold.
+  void PrimeHotMethods(Thread* self, mirror::Class* klass)
+      REQUIRES_SHARED(Locks::mutator_lock_)
+      REQUIRES(!warm_start_lock_);
+
   // If debug info generation is turned on then write the type information for types already loaded
   // into the specified class linker to the jit debug interface,
   void DumpTypeInfoForLoadedTypes(ClassLinker* linker);
@@ -177,17 +236,40 @@ class Jit {
   // Start JIT threads.
   void Start();
 
+  // Only use one compiler thread while the app is not jank perceptible.
+  void UpdateProcessState(bool jank_perceptible);
+
  private:
   Jit();
 
   static bool LoadCompiler(std::string* error_msg);
 
+  static JitCodeCache* CreateCodeCache(JitOptions* options,
+                                       bool for_zygote,
+                                       std::string* error_msg);
+
+  // Add `task` to the compile queue, ranked by the hotness `count` samples since the method became
+  // warm imply.
+  void AddCompileTask(Thread* self, JitCompileTask* task, int32_t count)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
+  static uint32_t ScaleThreshold(uint16_t threshold, uint32_t scale) {
+    return static_cast<uint32_t>(threshold) * scale / kThresholdScaleOne;
+  }
+
+  // Whether the thresholds scaled by `scale` keep warm < hot < osr and fit the hotness counter.
+  bool IsValidThresholdScale(uint32_t scale) const;
+
+  // Threshold controller: rescale the thresholds given the compile queue `backlog` and the
+  // `cpu_ns` used by the compile batch that just finished.
+  void UpdateThresholdScale(size_t backlog, uint64_t cpu_ns) REQUIRES(lock_);
+
   // JIT compiler
   static void* jit_library_handle_;
   static void* jit_compiler_handle_;
   static void* (*jit_load_)(bool*);
   static void (*jit_unload_)(void*);
-  static bool (*jit_compile_method_)(void*, ArtMethod*, Thread*, bool);
+  static bool (*jit_compile_method_)(void*, ArtMethod*, Thread*, bool, bool);
   static void (*jit_types_loaded_)(void*, mirror::Class**, size_t count);
 
   // Performance monitoring.
@@ -195,6 +277,13 @@ class Jit {
   CumulativeLogger cumulative_timings_;
   Histogram<uint64_t> memory_use_ GUARDED_BY(lock_);
   Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  uint64_t number_of_compile_batches_ GUARDED_BY(lock_);
+  uint64_t number_of_batched_compilations_ GUARDED_BY(lock_);
+  uint64_t batch_compile_time_ns_ GUARDED_BY(lock_);
+  // CPU time used by the compiler threads since the threshold controller last ran.
+  uint64_t controller_window_start_ns_ GUARDED_BY(lock_);
+  uint64_t controller_window_cpu_ns_ GUARDED_BY(lock_);
+  uint64_t number_of_threshold_updates_ GUARDED_BY(lock_);
 
   std::unique_ptr<jit::JitCodeCache> code_cache_;
 
@@ -206,7 +295,24 @@ class Jit {
   uint16_t osr_method_threshold_;
   uint16_t priority_thread_weight_;
   uint16_t invoke_transition_weight_;
+  size_t thread_pool_size_;
+  // Percent of a CPU the compiler threads may use before the hotness thresholds are raised.
+  // Zero disables the threshold controller.
+  uint32_t cpu_budget_percent_;
+  // Scale of the thresholds above, in units of kThresholdScaleOne. Only the controller writes
+  // it; mutators read it once per sample so they see consistent thresholds.
+  Atomic<uint32_t> threshold_scale_;
+  bool warm_start_;
+  // Whether methods reaching the compile threshold get baseline code first.
+  bool baseline_;
+  // Whether warm methods are interpreted by the switch interpreter, which records the outcomes of
+  // their conditional branches and the types their CHECK_CAST and INSTANCE_OF see.
+  bool profile_branches_;
+  Mutex warm_start_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  std::unique_ptr<MappedProfile> warm_start_profile_ GUARDED_BY(warm_start_lock_);
   std::unique_ptr<ThreadPool> thread_pool_;
+  // Compile requests of the thread pool's tasks, in order of urgency.
+  std::unique_ptr<JitCompileQueue> compile_queue_;
 
   DISALLOW_COPY_AND_ASSIGN(Jit);
 };
@@ -235,6 +341,31 @@ class JitOptions {
   size_t GetCodeCacheMaxCapacity() const {
     return code_cache_max_capacity_;
   }
+  bool UseCodeCacheHugePages() const {
+    return code_cache_huge_pages_;
+  }
+  bool UseCodeCacheCompaction() const {
+    return code_cache_compaction_;
+  }
+  size_t GetThreadPoolSize() const {
+    return thread_pool_size_;
+  }
+  uint32_t GetCpuBudgetPercent() const {
+    return cpu_budget_percent_;
+  }
+  bool UseWarmStart() const {
+    return warm_start_;
+  }
+  bool UseBaseline() const {
+    return baseline_;
+  }
+  bool ProfileBranches() const {
+    return profile_branches_;
+  }
+  // The profile whose hot methods the zygote compiles before forking, empty if none.
+  const std::string& GetZygoteProfile() const {
+    return zygote_profile_;
+  }
   bool DumpJitInfoOnShutdown() const {
     return dump_info_on_shutdown_;
   }
@@ -262,6 +393,14 @@ class JitOptions {
   bool use_jit_compilation_;
   size_t code_cache_initial_capacity_;
   size_t code_cache_max_capacity_;
+  bool code_cache_huge_pages_;
+  bool code_cache_compaction_;
+  size_t thread_pool_size_;
+  uint32_t cpu_budget_percent_;
+  bool warm_start_;
+  bool baseline_;
+  bool profile_branches_;
+  std::string zygote_profile_;
   size_t compile_threshold_;
   size_t warmup_threshold_;
   size_t osr_threshold_;
@@ -274,6 +413,13 @@ class JitOptions {
       : use_jit_compilation_(false),
         code_cache_initial_capacity_(0),
         code_cache_max_capacity_(0),
+        code_cache_huge_pages_(false),
+        code_cache_compaction_(false),
+        thread_pool_size_(0),
+        cpu_budget_percent_(0),
+        warm_start_(false),
+        baseline_(false),
+        profile_branches_(false),
         compile_threshold_(0),
         warmup_threshold_(0),
         osr_threshold_(0),
@@ -0,0 +1,238 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jit_code_allocator.h"
+
+#include <algorithm>
+#include <functional>
+#include <tuple>
+#include <utility>
+
+#include "base/bit_utils.h"
+#include "base/casts.h"
+#include "base/logging.h"
+
+namespace art {
+namespace jit {
+
+// The size classes are at most 25% apart, and multiples of 32 bytes so that any instruction set
+// alignment divides them.
+static constexpr size_t kSizeClasses[] = {
+    64, 96, 128, 160, 192, 224, 256, 320, 384, 448, 512
+};
+static constexpr size_t kNumSizeClasses = arraysize(kSizeClasses);
+static_assert(kSizeClasses[kNumSizeClasses - 1] == JitCodeAllocator::kMaxSmallSize,
+              "The largest size class must be the largest small allocation");
+static_assert(JitCodeAllocator::kSlabSize / kSizeClasses[0] <= 0xffff, "Too many slots");
+
+JitCodeAllocator::Slab::Slab(size_t size_class_in, size_t num_slots_in)
+    : size_class(dchecked_integral_cast<uint16_t>(size_class_in)),
+      num_slots(dchecked_integral_cast<uint16_t>(num_slots_in)) {
+  free_slots.reserve(num_slots);
+  for (size_t i = num_slots; i != 0u; --i) {
+    free_slots.push_back(dchecked_integral_cast<uint16_t>(i - 1u));
+  }
+}
+
+JitCodeAllocator::JitCodeAllocator(uint8_t* begin,
+                                   size_t max_size,
+                                   size_t capacity,
+                                   size_t alignment)
+    : begin_(reinterpret_cast<uintptr_t>(begin)),
+      alignment_(alignment),
+      capacity_(capacity),
+      bytes_allocated_(0u),
+      ranges_(begin_, begin_ + max_size, alignment),
+      partial_slabs_(kNumSizeClasses) {
+  CHECK_LE(capacity, max_size);
+  CHECK_ALIGNED_PARAM(kSlabSize, alignment);
+  for (size_t size_class : kSizeClasses) {
+    CHECK_ALIGNED_PARAM(size_class, alignment);
+  }
+}
+
+size_t JitCodeAllocator::SizeClassIndex(size_t size) {
+  DCHECK_LE(size, kMaxSmallSize);
+  return std::lower_bound(kSizeClasses, kSizeClasses + kNumSizeClasses, size) - kSizeClasses;
+}
+
+uintptr_t JitCodeAllocator::AllocateRange(size_t size) {
+  uintptr_t result = ranges_.Allocate(size);
+  // The best fit only goes above the capacity when it is the unused tail, in which case no other
+  // free range is large enough.
+  if (result != 0u && result - begin_ + size > capacity_) {
+    ranges_.Free(result, size);
+    return 0u;
+  }
+  return result;
+}
+
+uint8_t* JitCodeAllocator::AllocateLarge(size_t size) {
+  uintptr_t result = AllocateRange(size);
+  if (result == 0u) {
+    return nullptr;
+  }
+  large_allocations_.emplace(result, size);
+  bytes_allocated_ += size;
+  return reinterpret_cast<uint8_t*>(result);
+}
+
+JitCodeAllocator::SlabMap::iterator JitCodeAllocator::NewSlab(size_t size_class, uintptr_t begin) {
+  size_t slot_size = kSizeClasses[size_class];
+  auto it = slabs_.emplace(std::piecewise_construct,
+                           std::forward_as_tuple(begin),
+                           std::forward_as_tuple(size_class, kSlabSize / slot_size)).first;
+  partial_slabs_[size_class].insert(begin);
+  return it;
+}
+
+uint8_t* JitCodeAllocator::AllocateSlot(SlabMap::iterator it) {
+  Slab& slab = it->second;
+  DCHECK(!slab.IsFull());
+  size_t slot = slab.free_slots.back();
+  slab.free_slots.pop_back();
+  if (slab.IsFull()) {
+    partial_slabs_[slab.size_class].erase(it->first);
+  }
+  size_t slot_size = kSizeClasses[slab.size_class];
+  bytes_allocated_ += slot_size;
+  return reinterpret_cast<uint8_t*>(it->first + slot * slot_size);
+}
+
+uint8_t* JitCodeAllocator::Allocate(size_t size) {
+  DCHECK_NE(size, 0u);
+  size = RoundUp(size, alignment_);
+  if (size > kMaxSmallSize) {
+    return AllocateLarge(size);
+  }
+  size_t size_class = SizeClassIndex(size);
+  const std::set<uintptr_t>& partial_slabs = partial_slabs_[size_class];
+  if (!partial_slabs.empty()) {
+    return AllocateSlot(slabs_.find(*partial_slabs.begin()));
+  }
+  uintptr_t slab_begin = AllocateRange(kSlabSize);
+  if (slab_begin == 0u) {
+    return nullptr;
+  }
+  return AllocateSlot(NewSlab(size_class, slab_begin));
+}
+
+JitCodeAllocator::SlabMap::const_iterator JitCodeAllocator::FindSlab(uintptr_t address) const {
+  auto it = slabs_.upper_bound(address);
+  if (it == slabs_.begin()) {
+    return slabs_.end();
+  }
+  --it;
+  return (address - it->first < kSlabSize) ? it : slabs_.end();
+}
+
+void JitCodeAllocator::Free(uint8_t* ptr) {
+  uintptr_t address = reinterpret_cast<uintptr_t>(ptr);
+  auto large = large_allocations_.find(address);
+  if (large != large_allocations_.end()) {
+    ranges_.Free(address, large->second);
+    DCHECK_GE(bytes_allocated_, large->second);
+    bytes_allocated_ -= large->second;
+    large_allocations_.erase(large);
+    return;
+  }
+  auto const_it = FindSlab(address);
+  CHECK(const_it != slabs_.end()) << "Freeing unallocated code " << static_cast<void*>(ptr);
+  auto it = slabs_.find(const_it->first);
+  Slab& slab = it->second;
+  size_t slot_size = kSizeClasses[slab.size_class];
+  DCHECK_ALIGNED_PARAM(address - it->first, slot_size);
+  uint16_t slot = dchecked_integral_cast<uint16_t>((address - it->first) / slot_size);
+  // Keep the free slots sorted so that the lowest ones get reused first.
+  auto pos = std::upper_bound(
+      slab.free_slots.begin(), slab.free_slots.end(), slot, std::greater<uint16_t>());
+  DCHECK(pos == slab.free_slots.begin() || *(pos - 1) != slot) << "Double free";
+  if (slab.IsFull()) {
+    partial_slabs_[slab.size_class].insert(it->first);
+  }
+  slab.free_slots.insert(pos, slot);
+  DCHECK_GE(bytes_allocated_, slot_size);
+  bytes_allocated_ -= slot_size;
+  if (slab.IsEmpty()) {
+    partial_slabs_[slab.size_class].erase(it->first);
+    ranges_.Free(it->first, kSlabSize);
+    slabs_.erase(it);
+  }
+}
+
+size_t JitCodeAllocator::UsableSize(const uint8_t* ptr) const {
+  uintptr_t address = reinterpret_cast<uintptr_t>(ptr);
+  auto large = large_allocations_.find(address);
+  if (large != large_allocations_.end()) {
+    return large->second;
+  }
+  auto it = FindSlab(address);
+  CHECK(it != slabs_.end()) << "Unallocated code " << static_cast<const void*>(ptr);
+  return kSizeClasses[it->second.size_class];
+}
+
+uint8_t* JitCodeAllocator::AllocateBelow(const uint8_t* ptr) {
+  uintptr_t address = reinterpret_cast<uintptr_t>(ptr);
+  auto large = large_allocations_.find(address);
+  if (large != large_allocations_.end()) {
+    size_t size = large->second;
+    uintptr_t result = AllocateRange(size);
+    if (result == 0u) {
+      return nullptr;
+    } else if (result > address) {
+      ranges_.Free(result, size);
+      return nullptr;
+    }
+    large_allocations_.emplace(result, size);
+    bytes_allocated_ += size;
+    return reinterpret_cast<uint8_t*>(result);
+  }
+  auto it = FindSlab(address);
+  CHECK(it != slabs_.end()) << "Unallocated code " << static_cast<const void*>(ptr);
+  size_t size_class = it->second.size_class;
+  const std::set<uintptr_t>& partial_slabs = partial_slabs_[size_class];
+  // Moving within the same slab would not release anything.
+  if (!partial_slabs.empty() && *partial_slabs.begin() < it->first) {
+    return AllocateSlot(slabs_.find(*partial_slabs.begin()));
+  }
+  uintptr_t slab_begin = AllocateRange(kSlabSize);
+  if (slab_begin == 0u) {
+    return nullptr;
+  } else if (slab_begin > it->first) {
+    ranges_.Free(slab_begin, kSlabSize);
+    return nullptr;
+  }
+  return AllocateSlot(NewSlab(size_class, slab_begin));
+}
+
+void JitCodeAllocator::SetCapacity(size_t capacity) {
+  DCHECK_GE(capacity, capacity_);
+  DCHECK(ranges_.Contains(begin_, capacity));
+  capacity_ = capacity;
+}
+
+size_t JitCodeAllocator::Footprint() const {
+  size_t footprint = ranges_.End() - begin_;
+  ranges_.VisitFreeRanges([&](uintptr_t begin, size_t size) {
+    if (begin + size == ranges_.End()) {
+      footprint = begin - begin_;
+    }
+  });
+  return footprint;
+}
+
+}  // namespace jit
+}  // namespace art
@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_JIT_JIT_CODE_ALLOCATOR_H_
+#define ART_RUNTIME_JIT_JIT_CODE_ALLOCATOR_H_
+
+#include <stdint.h>
+
+#include <map>
+#include <set>
+#include <vector>
+
+#include "base/address_range_allocator.h"
+#include "base/allocator.h"
+#include "base/macros.h"
+#include "globals.h"
+
+namespace art {
+namespace jit {
+
+// Allocator for the code of the JIT code cache. Only the bookkeeping is done here, out of line,
+// so that allocating and freeing never write to the code pages. The caller provides the locking.
+//
+// Small allocations, which are most of the compiled methods and all the JNI stubs, are rounded
+// up to a size class and get a slot in a slab of slots of that size, lowest slab first. Larger
+// allocations take the best fit among the free ranges, which is the start of the unused tail
+// until code gets freed, i.e. a bump pointer.
+class JitCodeAllocator {
+ public:
+  // Size of the slabs holding small allocations.
+  static constexpr size_t kSlabSize = 4 * KB;
+  // Largest allocation served from a slab.
+  static constexpr size_t kMaxSmallSize = 512;
+
+  // Manage [begin, begin + max_size), of which the first `capacity` bytes can be allocated.
+  // Allocations are aligned to `alignment`, which must divide all the size classes.
+  JitCodeAllocator(uint8_t* begin, size_t max_size, size_t capacity, size_t alignment);
+
+  // Allocate `size` bytes, returns null if there is no room below the capacity.
+  uint8_t* Allocate(size_t size);
+
+  // Free an allocation returned by Allocate() or AllocateBelow().
+  void Free(uint8_t* ptr);
+
+  // Return the size of the allocation at `ptr`, at least the size that was requested.
+  size_t UsableSize(const uint8_t* ptr) const;
+
+  // Allocate a block of the same size as the allocation at `ptr`, at a lower address that makes
+  // it possible to release the range or slab of `ptr` once it is freed. Returns null if there is
+  // no such block. Used for compacting the code.
+  uint8_t* AllocateBelow(const uint8_t* ptr);
+
+  // Grow the number of bytes that can be allocated.
+  void SetCapacity(size_t capacity);
+
+  size_t GetCapacity() const {
+    return capacity_;
+  }
+
+  // Bytes allocated, including the rounding up to the size classes.
+  size_t BytesAllocated() const {
+    return bytes_allocated_;
+  }
+
+  // Bytes from the beginning of the managed range to the end of the highest allocation.
+  size_t Footprint() const;
+
+ private:
+  struct Slab {
+    Slab(size_t size_class, size_t num_slots);
+
+    bool IsFull() const {
+      return free_slots.empty();
+    }
+
+    bool IsEmpty() const {
+      return free_slots.size() == num_slots;
+    }
+
+    const uint16_t size_class;
+    const uint16_t num_slots;
+    // Indexes of the free slots, the lowest is at the back.
+    std::vector<uint16_t> free_slots;
+  };
+
+  using SlabMap = std::map<uintptr_t, Slab>;
+
+  static size_t SizeClassIndex(size_t size);
+
+  // Allocate from the free ranges, returns 0 if there is no room below the capacity.
+  uintptr_t AllocateRange(size_t size);
+
+  uint8_t* AllocateLarge(size_t size);
+  SlabMap::iterator NewSlab(size_t size_class, uintptr_t begin);
+  uint8_t* AllocateSlot(SlabMap::iterator slab);
+  SlabMap::const_iterator FindSlab(uintptr_t address) const;
+
+  const uintptr_t begin_;
+  const size_t alignment_;
+  size_t capacity_;
+  size_t bytes_allocated_;
+
+  // The ranges of the slabs and large allocations.
+  AddressRangeAllocator<kAllocatorTagJitCode> ranges_;
+  // Large allocations, begin to size.
+  std::map<uintptr_t, size_t> large_allocations_;
+  // Slabs, by begin.
+  SlabMap slabs_;
+  // For each size class, the begin of the slabs with free slots.
+  std::vector<std::set<uintptr_t>> partial_slabs_;
+
+  DISALLOW_COPY_AND_ASSIGN(JitCodeAllocator);
+};
+
+}  // namespace jit
+}  // namespace art
+
+#endif  // ART_RUNTIME_JIT_JIT_CODE_ALLOCATOR_H_
@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jit_code_allocator.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace art {
+namespace jit {
+
+static constexpr size_t kAlignment = 16;
+static constexpr size_t kSlabSize = JitCodeAllocator::kSlabSize;
+// The allocator never touches the memory it manages.
+static uint8_t* const kBegin = reinterpret_cast<uint8_t*>(1 * MB);
+static constexpr size_t kMaxSize = 64 * kSlabSize;
+
+TEST(JitCodeAllocator, SmallAllocationsShareSlabs) {
+  JitCodeAllocator allocator(kBegin, kMaxSize, kMaxSize, kAlignment);
+  uint8_t* a = allocator.Allocate(100);
+  uint8_t* b = allocator.Allocate(120);
+  uint8_t* c = allocator.Allocate(40);
+  // 100 and 120 bytes are in the 128 bytes class, 40 bytes in the 64 bytes one.
+  EXPECT_EQ(kBegin, a);
+  EXPECT_EQ(kBegin + 128, b);
+  EXPECT_EQ(kBegin + kSlabSize, c);
+  EXPECT_EQ(128u, allocator.UsableSize(a));
+  EXPECT_EQ(64u, allocator.UsableSize(c));
+  EXPECT_EQ(2 * 128u + 64u, allocator.BytesAllocated());
+  EXPECT_EQ(2 * kSlabSize, allocator.Footprint());
+
+  // Freed slots are reused lowest first.
+  allocator.Free(a);
+  EXPECT_EQ(a, allocator.Allocate(128));
+  allocator.Free(b);
+  allocator.Free(a);
+  // The empty slab is released, and its range reused by the next slab.
+  EXPECT_EQ(64u, allocator.BytesAllocated());
+  EXPECT_EQ(kBegin, allocator.Allocate(512));
+  allocator.Free(kBegin);
+  allocator.Free(c);
+  EXPECT_EQ(0u, allocator.BytesAllocated());
+  EXPECT_EQ(0u, allocator.Footprint());
+}
+
+TEST(JitCodeAllocator, FullSlab) {
+  JitCodeAllocator allocator(kBegin, kMaxSize, kMaxSize, kAlignment);
+  std::vector<uint8_t*> slots;
+  for (size_t i = 0; i != kSlabSize / 512; ++i) {
+    slots.push_back(allocator.Allocate(512));
+    EXPECT_EQ(kBegin + i * 512, slots.back());
+  }
+  // The slab is full: the next allocation of the class gets a new slab.
+  EXPECT_EQ(kBegin + kSlabSize, allocator.Allocate(500));
+  allocator.Free(slots[3]);
+  EXPECT_EQ(slots[3], allocator.Allocate(512));
+}
+
+TEST(JitCodeAllocator, LargeAllocations) {
+  JitCodeAllocator allocator(kBegin, kMaxSize, kMaxSize, kAlignment);
+  uint8_t* a = allocator.Allocate(1000);
+  uint8_t* b = allocator.Allocate(2 * KB);
+  uint8_t* c = allocator.Allocate(1000);
+  // Allocations are bumped while nothing is freed.
+  EXPECT_EQ(kBegin, a);
+  EXPECT_EQ(kBegin + 1008, b);
+  EXPECT_EQ(kBegin + 1008 + 2 * KB, c);
+  EXPECT_EQ(1008u, allocator.UsableSize(a));
+  EXPECT_EQ(2 * KB, allocator.UsableSize(b));
+
+  // The hole left by b is the best fit for allocations of at most its size.
+  allocator.Free(b);
+  EXPECT_EQ(b, allocator.Allocate(1 * KB));
+  EXPECT_EQ(c + 1008, allocator.Allocate(2 * KB));
+}
+
+TEST(JitCodeAllocator, Capacity) {
+  JitCodeAllocator allocator(kBegin, kMaxSize, 2 * kSlabSize, kAlignment);
+  EXPECT_EQ(kBegin, allocator.Allocate(kSlabSize));
+  EXPECT_EQ(kBegin + kSlabSize, allocator.Allocate(100));
+  // Neither a new slab nor a large allocation fit below the capacity.
+  EXPECT_EQ(nullptr, allocator.Allocate(40));
+  EXPECT_EQ(nullptr, allocator.Allocate(1 * KB));
+  allocator.SetCapacity(4 * kSlabSize);
+  EXPECT_EQ(4 * kSlabSize, allocator.GetCapacity());
+  EXPECT_EQ(kBegin + 2 * kSlabSize, allocator.Allocate(40));
+  EXPECT_EQ(kBegin + 3 * kSlabSize, allocator.Allocate(kSlabSize));
+  EXPECT_EQ(nullptr, allocator.Allocate(1 * KB));
+}
+
+TEST(JitCodeAllocator, AllocateBelow) {
+  JitCodeAllocator allocator(kBegin, kMaxSize, kMaxSize, kAlignment);
+  uint8_t* a = allocator.Allocate(2 * KB);
+  uint8_t* b = allocator.Allocate(2 * KB);
+  // Fill a slab of the 512 bytes class and start another one.
+  std::vector<uint8_t*> slots;
+  for (size_t i = 0; i != kSlabSize / 512 + 1; ++i) {
+    slots.push_back(allocator.Allocate(512));
+  }
+  uint8_t* c = allocator.Allocate(2 * KB);
+  EXPECT_EQ(kBegin + 4 * KB + 2 * kSlabSize, c);
+
+  // There is no hole below.
+  EXPECT_EQ(nullptr, allocator.AllocateBelow(c));
+  EXPECT_EQ(nullptr, allocator.AllocateBelow(slots.back()));
+
+  // Large allocations move to the holes below them.
+  allocator.Free(a);
+  uint8_t* moved_c = allocator.AllocateBelow(c);
+  EXPECT_EQ(a, moved_c);
+  allocator.Free(c);
+
+  // Small allocations move to the slots of lower slabs only.
+  allocator.Free(slots[1]);
+  EXPECT_EQ(nullptr, allocator.AllocateBelow(slots[2]));
+  uint8_t* moved_slot = allocator.AllocateBelow(slots.back());
+  EXPECT_EQ(slots[1], moved_slot);
+  allocator.Free(slots.back());
+  EXPECT_EQ(4 * KB + kSlabSize, allocator.Footprint());
+  EXPECT_EQ(4 * KB + kSlabSize, allocator.BytesAllocated());
+}
+
+}  // namespace jit
+}  // namespace art
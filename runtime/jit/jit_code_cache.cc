@@ -27,6 +27,7 @@
 #include "cha.h"
 #include "debugger_interface.h"
 #include "entrypoints/runtime_asm_entrypoints.h"
+#include "fault_handler.h"
 #include "gc/accounting/bitmap-inl.h"
 #include "gc/scoped_gc_critical_section.h"
 #include "intern_table.h"
@@ -37,6 +38,7 @@
 #include "oat_file-inl.h"
 #include "oat_quick_method_header.h"
 #include "object_callbacks.h"
+#include "quick_frame_cache.h"
 #include "scoped_thread_state_change-inl.h"
 #include "stack.h"
 #include "thread_list.h"
@@ -51,6 +53,21 @@ static constexpr int kProtCode = PROT_READ | PROT_EXEC;
 static constexpr size_t kCodeSizeLogThreshold = 50 * KB;
 static constexpr size_t kStackMapSizeLogThreshold = 50 * KB;
 
+// Memory held by the replaced code index snapshots above which committing code deletes them.
+static constexpr size_t kMaxRetiredCodeIndexBytes = 256 * KB;
+
+// Compiled code that survived kSurvivorAge full collections is tenured, and only polled for
+// liveness before one full collection out of kTenuredPollingInterval. A hot method then needs
+// to be idle through a rare polling period to lose its code.
+static constexpr uint16_t kSurvivorAge = 2;
+static constexpr size_t kTenuredPollingInterval = 4;
+
+// Full collections compact the code when the holes below the highest code take at least
+// kCompactionHolesPercent of the code footprint, and kCompactionMinHoles bytes. Smaller holes
+// are not worth suspending all threads.
+static constexpr size_t kCompactionHolesPercent = 25;
+static constexpr size_t kCompactionMinHoles = 32 * KB;
+
 #define CHECKED_MPROTECT(memory, size, prot)                \
   do {                                                      \
     int rc = mprotect(memory, size, prot);                  \
@@ -60,9 +77,103 @@ static constexpr size_t kStackMapSizeLogThreshold = 50 * KB;
     }                                                       \
   } while (false)                                           \
 
+// Native methods can share a JNI stub when the code the JNI compiler generates for them is the
+// same, which only depends on their shorty and on these flags.
+class JitCodeCache::JniStubKey {
+ public:
+  explicit JniStubKey(ArtMethod* method) REQUIRES_SHARED(Locks::mutator_lock_)
+      : shorty_(method->GetShorty()),
+        is_static_(method->IsStatic()),
+        is_fast_native_(method->IsAnnotatedWithFastNative()),
+        is_critical_native_(method->IsAnnotatedWithCriticalNative()),
+        is_synchronized_(method->IsSynchronized()) {
+    DCHECK(!(is_fast_native_ && is_critical_native_));
+  }
+
+  bool operator<(const JniStubKey& rhs) const {
+    if (is_static_ != rhs.is_static_) {
+      return rhs.is_static_;
+    }
+    if (is_synchronized_ != rhs.is_synchronized_) {
+      return rhs.is_synchronized_;
+    }
+    if (is_fast_native_ != rhs.is_fast_native_) {
+      return rhs.is_fast_native_;
+    }
+    if (is_critical_native_ != rhs.is_critical_native_) {
+      return rhs.is_critical_native_;
+    }
+    return shorty_ < rhs.shorty_;
+  }
+
+ private:
+  std::string shorty_;
+  bool is_static_;
+  bool is_fast_native_;
+  bool is_critical_native_;
+  bool is_synchronized_;
+};
+
+// The code of a JNI stub, null while it is being compiled, and the native methods that use it.
+class JitCodeCache::JniStubData {
+ public:
+  JniStubData() : code_(nullptr), methods_() {}
+
+  void SetCode(const void* code) {
+    DCHECK(code != nullptr);
+    code_ = code;
+  }
+
+  const void* GetCode() const {
+    return code_;
+  }
+
+  bool IsCompiled() const {
+    return GetCode() != nullptr;
+  }
+
+  void AddMethod(ArtMethod* method) {
+    if (!ContainsElement(methods_, method)) {
+      methods_.push_back(method);
+    }
+  }
+
+  bool RemoveMethod(ArtMethod* method) {
+    auto it = std::find(methods_.begin(), methods_.end(), method);
+    if (it == methods_.end()) {
+      return false;
+    }
+    methods_.erase(it);
+    return true;
+  }
+
+  void RemoveMethodsIn(const LinearAlloc& alloc) {
+    auto kept_end = std::remove_if(
+        methods_.begin(),
+        methods_.end(),
+        [&alloc](ArtMethod* method) { return alloc.ContainsUnsafe(method); });
+    methods_.erase(kept_end, methods_.end());
+  }
+
+  void MoveObsoleteMethod(ArtMethod* old_method, ArtMethod* new_method) {
+    std::replace(methods_.begin(), methods_.end(), old_method, new_method);
+  }
+
+  const std::vector<ArtMethod*>& GetMethods() const {
+    return methods_;
+  }
+
+ private:
+  const void* code_;
+  std::vector<ArtMethod*> methods_;
+};
+
 JitCodeCache* JitCodeCache::Create(size_t initial_capacity,
                                    size_t max_capacity,
                                    bool generate_debug_info,
+                                   bool use_huge_pages,
+                                   bool compact_code,
+                                   bool for_zygote,
                                    std::string* error_msg) {
   ScopedTrace trace(__PRETTY_FUNCTION__);
   CHECK_GE(max_capacity, initial_capacity);
@@ -70,10 +181,12 @@ JitCodeCache* JitCodeCache::Create(size_t initial_capacity,
   // Generating debug information is for using the Linux perf tool on
   // host which does not work with ashmem.
   // Also, target linux does not support ashmem.
-  bool use_ashmem = !generate_debug_info && !kIsTargetLinux;
+  // Transparent huge pages only apply to private anonymous memory, not ashmem.
+  bool use_ashmem = !generate_debug_info && !kIsTargetLinux && !use_huge_pages;
 
-  // With 'perf', we want a 1-1 mapping between an address and a method.
-  bool garbage_collect_code = !generate_debug_info;
+  // With 'perf', we want a 1-1 mapping between an address and a method. The code of the zygote
+  // is shared with the children, which do not know what is live in other processes.
+  bool garbage_collect_code = !generate_debug_info && !for_zygote;
 
   // We need to have 32 bit offsets from method headers in code cache which point to things
   // in the data cache. If the maps are more than 4G apart, having multiple maps wouldn't work.
@@ -118,8 +231,13 @@ JitCodeCache* JitCodeCache::Create(size_t initial_capacity,
   DCHECK_EQ(code_size + data_size, max_capacity);
   uint8_t* divider = data_map->Begin() + data_size;
 
-  MemMap* code_map =
-      data_map->RemapAtEnd(divider, "jit-code-cache", kProtAll, &error_str, use_ashmem);
+  // SELinux does not let the zygote map executable memory: its code is only made executable in
+  // the children, see AttachZygoteCodeCache.
+  MemMap* code_map = data_map->RemapAtEnd(divider,
+                                          "jit-code-cache",
+                                          for_zygote ? kProtData : kProtAll,
+                                          &error_str,
+                                          use_ashmem);
   if (code_map == nullptr) {
     std::ostringstream oss;
     oss << "Failed to create read write execute cache: " << error_str << " size=" << max_capacity;
@@ -127,11 +245,21 @@ JitCodeCache* JitCodeCache::Create(size_t initial_capacity,
     return nullptr;
   }
   DCHECK_EQ(code_map->Begin(), divider);
+  // Only the code benefits from huge pages: it is what the instruction TLB misses on.
+  if (use_huge_pages && !code_map->AdviseHugePages()) {
+    LOG(WARNING) << "Huge pages are not available for the JIT code cache";
+  }
   data_size = initial_capacity / 2;
   code_size = initial_capacity - data_size;
   DCHECK_EQ(code_size + data_size, initial_capacity);
-  return new JitCodeCache(
-      code_map, data_map.release(), code_size, data_size, max_capacity, garbage_collect_code);
+  return new JitCodeCache(code_map,
+                          data_map.release(),
+                          code_size,
+                          data_size,
+                          max_capacity,
+                          garbage_collect_code,
+                          compact_code,
+                          for_zygote);
 }
 
 JitCodeCache::JitCodeCache(MemMap* code_map,
@@ -139,24 +267,35 @@ JitCodeCache::JitCodeCache(MemMap* code_map,
                            size_t initial_code_capacity,
                            size_t initial_data_capacity,
                            size_t max_capacity,
-                           bool garbage_collect_code)
+                           bool garbage_collect_code,
+                           bool compact_code,
+                           bool for_zygote)
     : lock_("Jit code cache", kJitCodeCacheLock),
       lock_cond_("Jit code cache condition variable", lock_),
       collection_in_progress_(false),
       code_map_(code_map),
       data_map_(data_map),
+      code_allocator_(new JitCodeAllocator(code_map->Begin(),
+                                           code_map->Size(),
+                                           initial_code_capacity,
+                                           GetInstructionSetAlignment(kRuntimeISA))),
       max_capacity_(max_capacity),
       current_capacity_(initial_code_capacity + initial_data_capacity),
-      code_end_(initial_code_capacity),
       data_end_(initial_data_capacity),
       last_collection_increased_code_cache_(false),
       last_update_time_ns_(0),
       garbage_collect_code_(garbage_collect_code),
+      compact_code_(compact_code),
+      is_zygote_cache_(for_zygote),
       used_memory_for_data_(0),
       used_memory_for_code_(0),
       number_of_compilations_(0),
+      number_of_jni_stub_compilations_(0),
       number_of_osr_compilations_(0),
       number_of_collections_(0),
+      number_of_full_collections_(0),
+      number_of_compactions_(0),
+      number_of_recompilations_(0),
       histogram_stack_map_memory_use_("Memory used for stack maps", 16),
       histogram_code_memory_use_("Memory used for compiled code", 16),
       histogram_profiling_info_memory_use_("Memory used for profiling info", 16),
@@ -164,17 +303,17 @@ JitCodeCache::JitCodeCache(MemMap* code_map,
       inline_cache_cond_("Jit inline cache condition variable", lock_) {
 
   DCHECK_GE(max_capacity, initial_code_capacity + initial_data_capacity);
-  code_mspace_ = create_mspace_with_base(code_map_->Begin(), code_end_, false /*locked*/);
   data_mspace_ = create_mspace_with_base(data_map_->Begin(), data_end_, false /*locked*/);
 
-  if (code_mspace_ == nullptr || data_mspace_ == nullptr) {
+  if (data_mspace_ == nullptr) {
     PLOG(FATAL) << "create_mspace_with_base failed";
   }
 
   SetFootprintLimit(current_capacity_);
 
-  CHECKED_MPROTECT(code_map_->Begin(), code_map_->Size(), kProtCode);
+  CHECKED_MPROTECT(code_map_->Begin(), code_map_->Size(), for_zygote ? kProtData : kProtCode);
   CHECKED_MPROTECT(data_map_->Begin(), data_map_->Size(), kProtData);
+  fault_manager.AddGeneratedCodeRange(code_map_->Begin(), code_map_->Size());
 
   VLOG(jit) << "Created jit code cache: initial data size="
             << PrettySize(initial_data_capacity)
@@ -182,12 +321,69 @@ JitCodeCache::JitCodeCache(MemMap* code_map,
             << PrettySize(initial_code_capacity);
 }
 
+JitCodeCache::~JitCodeCache() {
+  fault_manager.RemoveGeneratedCodeRange(code_map_->Begin(), code_map_->Size());
+}
+
 bool JitCodeCache::ContainsPc(const void* ptr) const {
+  return IsInCodeMap(ptr) || (zygote_cache_ != nullptr && zygote_cache_->IsInCodeMap(ptr));
+}
+
+bool JitCodeCache::IsInCodeMap(const void* ptr) const {
   return code_map_->Begin() <= ptr && ptr < code_map_->End();
 }
 
+void JitCodeCache::AttachZygoteCodeCache(JitCodeCache* zygote_cache) {
+  DCHECK(zygote_cache->IsZygoteCache());
+  DCHECK(!IsZygoteCache());
+  DCHECK(zygote_cache_ == nullptr);
+  // Nothing writes the code and data of the zygote after the fork, only the pages this process
+  // writes stop being shared.
+  CHECKED_MPROTECT(zygote_cache->code_map_->Begin(), zygote_cache->code_map_->Size(), kProtCode);
+  CHECKED_MPROTECT(zygote_cache->data_map_->Begin(), zygote_cache->data_map_->Size(), PROT_READ);
+  Thread* self = Thread::Current();
+  std::vector<std::pair<const void*, ArtMethod*>> zygote_code;
+  {
+    MutexLock mu(self, zygote_cache->lock_);
+    DCHECK(zygote_cache->jni_stubs_map_.empty());
+    zygote_code.assign(zygote_cache->method_code_map_.begin(),
+                       zygote_cache->method_code_map_.end());
+  }
+  MutexLock mu(self, lock_);
+  for (const auto& entry : zygote_code) {
+    zygote_methods_.Overwrite(entry.second, entry.first);
+  }
+  zygote_cache_.reset(zygote_cache);
+}
+
+void JitCodeCache::InstallZygoteCode(Thread* self) {
+  ClassLinker* class_linker = Runtime::Current()->GetClassLinker();
+  instrumentation::Instrumentation* instrumentation = Runtime::Current()->GetInstrumentation();
+  MutexLock mu(self, lock_);
+  for (auto it = zygote_methods_.begin(); it != zygote_methods_.end();) {
+    ArtMethod* method = it->first;
+    if (!class_linker->IsQuickToInterpreterBridge(method->GetEntryPointFromQuickCompiledCode())) {
+      // The resolution stub of a static method initializes its class, and is replaced by the
+      // AOT code or the interpreter bridge. The method gets JIT compiled again when it is hot.
+      it = zygote_methods_.erase(it);
+      continue;
+    }
+    instrumentation->UpdateMethodsCode(
+        method, OatQuickMethodHeader::FromCodePointer(it->second)->GetEntryPoint());
+    ++it;
+  }
+  VLOG(jit) << "JIT installed the zygote code of " << zygote_methods_.size() << " methods";
+}
+
 bool JitCodeCache::ContainsMethod(ArtMethod* method) {
   MutexLock mu(Thread::Current(), lock_);
+  if (UNLIKELY(method->IsNative())) {
+    auto it = FindJniStub(method);
+    return it != jni_stubs_map_.end() && it->second.IsCompiled();
+  }
+  if (zygote_methods_.find(method) != zygote_methods_.end()) {
+    return true;
+  }
   for (auto& it : method_code_map_) {
     if (it.second == method) {
       return true;
@@ -201,19 +397,28 @@ class ScopedCodeCacheWrite : ScopedTrace {
   explicit ScopedCodeCacheWrite(MemMap* code_map, bool only_for_tlb_shootdown = false)
       : ScopedTrace("ScopedCodeCacheWrite"),
         code_map_(code_map),
+        // The code map of a zygote cache is created without PROT_EXEC, and stays writable in the
+        // zygote.
+        executable_((code_map->GetProtect() & PROT_EXEC) != 0),
         only_for_tlb_shootdown_(only_for_tlb_shootdown) {
-    ScopedTrace trace("mprotect all");
-    CHECKED_MPROTECT(
-        code_map_->Begin(), only_for_tlb_shootdown_ ? kPageSize : code_map_->Size(), kProtAll);
+    if (executable_) {
+      ScopedTrace trace("mprotect all");
+      CHECKED_MPROTECT(
+          code_map_->Begin(), only_for_tlb_shootdown_ ? kPageSize : code_map_->Size(), kProtAll);
+    }
   }
   ~ScopedCodeCacheWrite() {
-    ScopedTrace trace("mprotect code");
-    CHECKED_MPROTECT(
-        code_map_->Begin(), only_for_tlb_shootdown_ ? kPageSize : code_map_->Size(), kProtCode);
+    if (executable_) {
+      ScopedTrace trace("mprotect code");
+      CHECKED_MPROTECT(
+          code_map_->Begin(), only_for_tlb_shootdown_ ? kPageSize : code_map_->Size(), kProtCode);
+    }
   }
  private:
   MemMap* const code_map_;
 
+  const bool executable_;
+
   // If we're using ScopedCacheWrite only for TLB shootdown, we limit the scope of mprotect to
   // one page.
   const bool only_for_tlb_shootdown_;
@@ -233,9 +438,16 @@ uint8_t* JitCodeCache::CommitCode(Thread* self,
                                   size_t code_size,
                                   size_t data_size,
                                   bool osr,
+                                  bool baseline,
                                   Handle<mirror::ObjectArray<mirror::Object>> roots,
                                   bool has_should_deoptimize_flag,
                                   const ArenaSet<ArtMethod*>& cha_single_implementation_list) {
+  if (is_zygote_cache_ && !cha_single_implementation_list.empty()) {
+    // The class hierarchy analysis invalidates code through the code cache of the current JIT,
+    // which does not know about the zygote's code until the fork.
+    VLOG(jit) << "JIT discarded zygote code with single-implementation assumptions.";
+    return nullptr;
+  }
   uint8_t* result = CommitCodeInternal(self,
                                        method,
                                        stack_map,
@@ -248,6 +460,7 @@ uint8_t* JitCodeCache::CommitCode(Thread* self,
                                        code_size,
                                        data_size,
                                        osr,
+                                       baseline,
                                        roots,
                                        has_should_deoptimize_flag,
                                        cha_single_implementation_list);
@@ -266,10 +479,14 @@ uint8_t* JitCodeCache::CommitCode(Thread* self,
                                 code_size,
                                 data_size,
                                 osr,
+                                baseline,
                                 roots,
                                 has_should_deoptimize_flag,
                                 cha_single_implementation_list);
   }
+  if (result != nullptr) {
+    MaybeDeleteRetiredCodeIndexSnapshots(self);
+  }
   return result;
 }
 
@@ -405,6 +622,10 @@ void JitCodeCache::SweepRootTables(IsMarkedVisitor* visitor) {
       for (size_t j = 0; j < InlineCache::kIndividualCacheSize; ++j) {
         ProcessWeakClass(&cache->classes_[j], visitor, nullptr);
       }
+      if (cache->classes_[0].IsNull()) {
+        // The target was a method of the unloaded class or of one of its superclasses.
+        cache->target_ = nullptr;
+      }
     }
   }
 }
@@ -414,7 +635,10 @@ void JitCodeCache::FreeCode(const void* code_ptr) {
   // Notify native debugger that we are about to remove the code.
   // It does nothing if we are not using native debugger.
   DeleteJITCodeEntryForAddress(reinterpret_cast<uintptr_t>(code_ptr));
-  FreeData(GetRootTable(code_ptr));
+  // JNI stubs have no stack maps nor roots in the data cache.
+  if (OatQuickMethodHeader::FromCodePointer(code_ptr)->IsOptimized()) {
+    FreeData(GetRootTable(code_ptr));
+  }
   FreeCode(reinterpret_cast<uint8_t*>(allocation));
 }
 
@@ -430,8 +654,8 @@ void JitCodeCache::FreeAllMethodHeaders(
   // first since once we do FreeCode() below, the memory can be reused
   // so it's possible for the same method_header to start representing
   // different compile code.
+  // Freeing the code does not write to it, the code allocator keeps its bookkeeping aside.
   MutexLock mu(Thread::Current(), lock_);
-  ScopedCodeCacheWrite scc(code_map_.get());
   for (const OatQuickMethodHeader* method_header : method_headers) {
     FreeCode(method_header->GetCode());
   }
@@ -460,6 +684,27 @@ void JitCodeCache::RemoveMethodsIn(Thread* self, const LinearAlloc& alloc) {
         }
       }
     }
+    for (auto it = jni_stubs_map_.begin(); it != jni_stubs_map_.end();) {
+      JniStubData* data = &it->second;
+      for (ArtMethod* method : data->GetMethods()) {
+        if (alloc.ContainsUnsafe(method)) {
+          jni_stub_methods_.erase(method);
+        }
+      }
+      data->RemoveMethodsIn(alloc);
+      if (data->GetMethods().empty()) {
+        // A stub being compiled keeps the method it is compiled for, whose class the compile
+        // task keeps alive, so an empty stub is always compiled.
+        DCHECK(data->IsCompiled());
+        method_headers.insert(OatQuickMethodHeader::FromCodePointer(data->GetCode()));
+        it = jni_stubs_map_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    if (!method_headers.empty()) {
+      RebuildCodeIndex();
+    }
     for (auto it = osr_code_map_.begin(); it != osr_code_map_.end();) {
       if (alloc.ContainsUnsafe(it->first)) {
         // Note that the code has already been pushed to method_headers in the loop
@@ -469,6 +714,20 @@ void JitCodeCache::RemoveMethodsIn(Thread* self, const LinearAlloc& alloc) {
         ++it;
       }
     }
+    for (auto it = baseline_code_map_.begin(); it != baseline_code_map_.end();) {
+      if (alloc.ContainsUnsafe(it->first)) {
+        it = baseline_code_map_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    for (auto it = evicted_methods_.begin(); it != evicted_methods_.end();) {
+      if (alloc.ContainsUnsafe(*it)) {
+        it = evicted_methods_.erase(it);
+      } else {
+        ++it;
+      }
+    }
     for (auto it = profiling_infos_.begin(); it != profiling_infos_.end();) {
       ProfilingInfo* info = *it;
       if (alloc.ContainsUnsafe(info->GetMethod())) {
@@ -518,23 +777,28 @@ void JitCodeCache::DisallowInlineCacheAccess() {
 }
 
 void JitCodeCache::CopyInlineCacheInto(const InlineCache& ic,
-                                       Handle<mirror::ObjectArray<mirror::Class>> array) {
+                                       Handle<mirror::ObjectArray<mirror::Class>> array,
+                                       /*out*/uint16_t* counts,
+                                       /*out*/uint16_t* megamorphic_count) {
   WaitUntilInlineCacheAccessible(Thread::Current());
   // Note that we don't need to lock `lock_` here, the compiler calling
   // this method has already ensured the inline cache will not be deleted.
+  std::fill_n(counts, InlineCache::kIndividualCacheSize, 0u);
   for (size_t in_cache = 0, in_array = 0;
        in_cache < InlineCache::kIndividualCacheSize;
        ++in_cache) {
     mirror::Class* object = ic.classes_[in_cache].Read();
     if (object != nullptr) {
+      counts[in_array] = ic.counts_[in_cache];
       array->Set(in_array++, object);
     }
   }
+  *megamorphic_count = ic.megamorphic_count_;
 }
 
 static void ClearMethodCounter(ArtMethod* method, bool was_warm) {
   if (was_warm) {
-    method->AddAccessFlags(kAccPreviouslyWarm);
+    method->SetPreviouslyWarm();
   }
   // We reset the counter to 1 so that the profile knows that the method was executed at least once.
   // This is required for layout purposes.
@@ -556,11 +820,16 @@ uint8_t* JitCodeCache::CommitCodeInternal(Thread* self,
                                           size_t code_size,
                                           size_t data_size,
                                           bool osr,
+                                          bool baseline,
                                           Handle<mirror::ObjectArray<mirror::Object>> roots,
                                           bool has_should_deoptimize_flag,
                                           const ArenaSet<ArtMethod*>&
                                               cha_single_implementation_list) {
-  DCHECK(stack_map != nullptr);
+  // JNI stubs are committed without stack maps and roots.
+  DCHECK_EQ(stack_map == nullptr, method->IsNative());
+  DCHECK(!method->IsNative() || (!osr && !baseline));
+  // Build the key of a JNI stub before taking the locks, it looks up the method's annotations.
+  std::unique_ptr<JniStubKey> jni_stub_key(method->IsNative() ? new JniStubKey(method) : nullptr);
   size_t alignment = GetInstructionSetAlignment(kRuntimeISA);
   // Ensure the header ends up at expected instruction alignment.
   size_t header_size = RoundUp(sizeof(OatQuickMethodHeader), alignment);
@@ -584,8 +853,8 @@ uint8_t* JitCodeCache::CommitCodeInternal(Thread* self,
       std::copy(code, code + code_size, code_ptr);
       method_header = OatQuickMethodHeader::FromCodePointer(code_ptr);
       new (method_header) OatQuickMethodHeader(
-          code_ptr - stack_map,
-          code_ptr - method_info,
+          (stack_map != nullptr) ? code_ptr - stack_map : 0u,
+          (method_info != nullptr) ? code_ptr - method_info : 0u,
           frame_size_in_bytes,
           core_spill_mask,
           fp_spill_mask,
@@ -640,24 +909,68 @@ uint8_t* JitCodeCache::CommitCodeInternal(Thread* self,
     // possible that the compiled code is considered invalidated by some class linking,
     // but below we still make the compiled code valid for the method.
     MutexLock mu(self, lock_);
-    // Fill the root table before updating the entry point.
-    DCHECK_EQ(FromStackMapToRoots(stack_map), roots_data);
-    DCHECK_LE(roots_data, stack_map);
-    FillRootTable(roots_data, roots);
-    {
-      // Flush data cache, as compiled code references literals in it.
-      // We also need a TLB shootdown to act as memory barrier across cores.
-      ScopedCodeCacheWrite ccw(code_map_.get(), /* only_for_tlb_shootdown */ true);
-      FlushDataCache(reinterpret_cast<char*>(roots_data),
-                     reinterpret_cast<char*>(roots_data + data_size));
-    }
-    method_code_map_.Put(code_ptr, method);
-    if (osr) {
+    if (UNLIKELY(method->IsNative())) {
+      auto it = jni_stubs_map_.find(*jni_stub_key);
+      DCHECK(it != jni_stubs_map_.end())
+          << "Entry inserted in NotifyCompilationOf() should be alive.";
+      JniStubData* data = &it->second;
+      DCHECK(!data->IsCompiled());
+      DCHECK(ContainsElement(data->GetMethods(), method));
+      {
+        // We need a TLB shootdown to act as memory barrier across cores.
+        ScopedCodeCacheWrite ccw(code_map_.get(), /* only_for_tlb_shootdown */ true);
+      }
+      data->SetCode(code_ptr);
+      AddToCodeIndex(code_ptr, /* method */ nullptr);
+      number_of_jni_stub_compilations_++;
+      instrumentation::Instrumentation* instrumentation = Runtime::Current()->GetInstrumentation();
+      for (ArtMethod* m : data->GetMethods()) {
+        instrumentation->UpdateMethodsCode(m, method_header->GetEntryPoint());
+      }
+    } else {
+      // Fill the root table before updating the entry point.
+      DCHECK_EQ(FromStackMapToRoots(stack_map), roots_data);
+      DCHECK_LE(roots_data, stack_map);
+      FillRootTable(roots_data, roots);
+      {
+        // Flush data cache, as compiled code references literals in it.
+        // We also need a TLB shootdown to act as memory barrier across cores.
+        ScopedCodeCacheWrite ccw(code_map_.get(), /* only_for_tlb_shootdown */ true);
+        FlushDataCache(reinterpret_cast<char*>(roots_data),
+                       reinterpret_cast<char*>(roots_data + data_size));
+      }
+      method_code_map_.Put(code_ptr, method);
+      AddToCodeIndex(code_ptr, method);
+    }
+    if (!osr && evicted_methods_.erase(method) != 0) {
+      // The method was needed again after its code got evicted: don't poll it until the next
+      // tenured polling period.
+      number_of_recompilations_++;
+      ProfilingInfo* info = method->GetProfilingInfo(kRuntimePointerSize);
+      if (info != nullptr) {
+        info->SetSurvivedCollections(kSurvivorAge);
+      }
+    }
+    if (method->IsNative()) {
+      // The entry points were updated above.
+    } else if (osr) {
       number_of_osr_compilations_++;
       osr_code_map_.Put(method, code_ptr);
+      ProfilingInfo* info = method->GetProfilingInfo(kRuntimePointerSize);
+      if (info != nullptr) {
+        info->ResetOsrEntries();
+      }
     } else {
-      Runtime::Current()->GetInstrumentation()->UpdateMethodsCode(
-          method, method_header->GetEntryPoint());
+      if (baseline) {
+        baseline_code_map_.Overwrite(method, code_ptr);
+      } else {
+        baseline_code_map_.erase(method);
+      }
+      // The code of the zygote is not executable before the fork, see InstallZygoteCode.
+      if (!is_zygote_cache_) {
+        Runtime::Current()->GetInstrumentation()->UpdateMethodsCode(
+            method, method_header->GetEntryPoint());
+      }
     }
     if (collection_in_progress_) {
       // We need to update the live bitmap if there is a GC to ensure it sees this new
@@ -690,10 +1003,38 @@ size_t JitCodeCache::CodeCacheSize() {
   return CodeCacheSizeLocked();
 }
 
+size_t JitCodeCache::NumberOfCompilations() {
+  MutexLock mu(Thread::Current(), lock_);
+  return number_of_compilations_;
+}
+
+size_t JitCodeCache::NumberOfOsrCompilations() {
+  MutexLock mu(Thread::Current(), lock_);
+  return number_of_osr_compilations_;
+}
+
 bool JitCodeCache::RemoveMethod(ArtMethod* method, bool release_memory) {
   MutexLock mu(Thread::Current(), lock_);
   if (method->IsNative()) {
-    return false;
+    auto it = FindJniStub(method);
+    if (it == jni_stubs_map_.end() || !it->second.IsCompiled()) {
+      return false;
+    }
+    JniStubData* data = &it->second;
+    data->RemoveMethod(method);
+    jni_stub_methods_.erase(method);
+    if (data->GetMethods().empty()) {
+      if (release_memory) {
+        ScopedCodeCacheWrite ccw(code_map_.get());
+        FreeCode(data->GetCode());
+      }
+      jni_stubs_map_.erase(it);
+      RebuildCodeIndex();
+    }
+    method->ClearCounter();
+    Runtime::Current()->GetInstrumentation()->UpdateMethodsCode(method, GetQuickGenericJniStub());
+    VLOG(jit) << "JIT removed JNI stub of " << ArtMethod::PrettyMethod(method);
+    return true;
   }
 
   bool in_cache = false;
@@ -718,10 +1059,16 @@ bool JitCodeCache::RemoveMethod(ArtMethod* method, bool release_memory) {
     osr_code_map_.erase(code_map);
     osr = true;
   }
+  baseline_code_map_.erase(method);
+  if (zygote_methods_.erase(method) != 0) {
+    // The zygote's code stays in the shared pages, whatever `release_memory`.
+    in_cache = true;
+  }
 
   if (!in_cache) {
     return false;
   }
+  RebuildCodeIndex();
 
   ProfilingInfo* info = method->GetProfilingInfo(kRuntimePointerSize);
   if (info != nullptr) {
@@ -747,6 +1094,18 @@ bool JitCodeCache::RemoveMethod(ArtMethod* method, bool release_memory) {
 void JitCodeCache::NotifyMethodRedefined(ArtMethod* method) {
   MutexLock mu(Thread::Current(), lock_);
   if (method->IsNative()) {
+    auto it = FindJniStub(method);
+    if (it != jni_stubs_map_.end()) {
+      JniStubData* data = &it->second;
+      data->RemoveMethod(method);
+      jni_stub_methods_.erase(method);
+      if (data->GetMethods().empty() && data->IsCompiled()) {
+        ScopedCodeCacheWrite ccw(code_map_.get());
+        FreeCode(data->GetCode());
+        jni_stubs_map_.erase(it);
+        RebuildCodeIndex();
+      }
+    }
     return;
   }
   ProfilingInfo* info = method->GetProfilingInfo(kRuntimePointerSize);
@@ -757,18 +1116,26 @@ void JitCodeCache::NotifyMethodRedefined(ArtMethod* method) {
   }
   method->SetProfilingInfo(nullptr);
   ScopedCodeCacheWrite ccw(code_map_.get());
+  bool in_cache = false;
   for (auto code_iter = method_code_map_.begin(); code_iter != method_code_map_.end();) {
     if (code_iter->second == method) {
       FreeCode(code_iter->first);
       code_iter = method_code_map_.erase(code_iter);
+      in_cache = true;
       continue;
     }
     ++code_iter;
   }
+  if (in_cache) {
+    RebuildCodeIndex();
+  }
   auto code_map = osr_code_map_.find(method);
   if (code_map != osr_code_map_.end()) {
     osr_code_map_.erase(code_map);
   }
+  baseline_code_map_.erase(method);
+  // The entry point of `method` no longer is the zygote's code, which stays in the shared pages.
+  zygote_methods_.erase(method);
 }
 
 // This invalidates old_method. Once this function returns one can no longer use old_method to
@@ -778,11 +1145,17 @@ void JitCodeCache::NotifyMethodRedefined(ArtMethod* method) {
 // shouldn't be used since it is no longer logically in the jit code cache.
 // TODO We should add DCHECKS that validate that the JIT is paused when this method is entered.
 void JitCodeCache::MoveObsoleteMethod(ArtMethod* old_method, ArtMethod* new_method) {
-  // Native methods have no profiling info and need no special handling from the JIT code cache.
+  MutexLock mu(Thread::Current(), lock_);
+  // Native methods have no profiling info, only the JNI stubs need to know about the move.
   if (old_method->IsNative()) {
+    auto it = FindJniStub(old_method);
+    if (it != jni_stubs_map_.end()) {
+      it->second.MoveObsoleteMethod(old_method, new_method);
+      jni_stub_methods_.erase(old_method);
+      jni_stub_methods_.Overwrite(new_method, it);
+    }
     return;
   }
-  MutexLock mu(Thread::Current(), lock_);
   // Update ProfilingInfo to the new one and remove it from the old_method.
   if (old_method->GetProfilingInfo(kRuntimePointerSize) != nullptr) {
     DCHECK_EQ(old_method->GetProfilingInfo(kRuntimePointerSize)->GetMethod(), old_method);
@@ -795,17 +1168,34 @@ void JitCodeCache::MoveObsoleteMethod(ArtMethod* old_method, ArtMethod* new_meth
     info->method_ = new_method;
   }
   // Update method_code_map_ to point to the new method.
+  bool in_cache = false;
   for (auto& it : method_code_map_) {
     if (it.second == old_method) {
       it.second = new_method;
+      in_cache = true;
     }
   }
+  if (in_cache) {
+    RebuildCodeIndex();
+  }
   // Update osr_code_map_ to point to the new method.
   auto code_map = osr_code_map_.find(old_method);
   if (code_map != osr_code_map_.end()) {
     osr_code_map_.Put(new_method, code_map->second);
     osr_code_map_.erase(old_method);
   }
+  auto baseline_code = baseline_code_map_.find(old_method);
+  if (baseline_code != baseline_code_map_.end()) {
+    baseline_code_map_.Put(new_method, baseline_code->second);
+    baseline_code_map_.erase(old_method);
+  }
+  // Frames of `old_method` running the zygote's code are looked up in the zygote's code index,
+  // which only checks the non-obsolete method.
+  auto zygote_code = zygote_methods_.find(old_method);
+  if (zygote_code != zygote_methods_.end()) {
+    zygote_methods_.Put(new_method, zygote_code->second);
+    zygote_methods_.erase(zygote_code);
+  }
 }
 
 size_t JitCodeCache::CodeCacheSizeLocked() {
@@ -837,6 +1227,14 @@ size_t JitCodeCache::ReserveData(Thread* self,
                                  uint8_t** stack_map_data,
                                  uint8_t** method_info_data,
                                  uint8_t** roots_data) {
+  if (is_zygote_cache_ && number_of_roots != 0) {
+    // The zygote compacts its heap before forking, which would leave stale roots in the shared
+    // root tables.
+    *roots_data = nullptr;
+    *stack_map_data = nullptr;
+    *method_info_data = nullptr;
+    return 0;
+  }
   size_t table_size = ComputeRootTableSize(number_of_roots);
   size_t size = RoundUp(stack_map_size + method_info_size + table_size, sizeof(void*));
   uint8_t* result = nullptr;
@@ -892,7 +1290,7 @@ class MarkCodeVisitor FINAL : public StackVisitor {
       return true;
     }
     const void* code = method_header->GetCode();
-    if (code_cache_->ContainsPc(code)) {
+    if (code_cache_->IsInCodeMap(code)) {
       // Use the atomic set version, as multiple threads are executing this code.
       bitmap_->AtomicTestAndSet(FromCodeToAllocation(code));
     }
@@ -949,10 +1347,7 @@ void JitCodeCache::SetFootprintLimit(size_t new_footprint) {
   DCHECK(IsAlignedParam(per_space_footprint, kPageSize));
   DCHECK_EQ(per_space_footprint * 2, new_footprint);
   mspace_set_footprint_limit(data_mspace_, per_space_footprint);
-  {
-    ScopedCodeCacheWrite scc(code_map_.get());
-    mspace_set_footprint_limit(code_mspace_, per_space_footprint);
-  }
+  code_allocator_->SetCapacity(per_space_footprint);
 }
 
 bool JitCodeCache::IncreaseCodeCacheCapacity() {
@@ -993,6 +1388,57 @@ void JitCodeCache::MarkCompiledCodeOnThreadStacks(Thread* self) {
   }
 }
 
+void JitCodeCache::AddToCodeIndex(const void* code_ptr, ArtMethod* method) {
+  code_index_.Add(code_ptr, method);
+}
+
+void JitCodeCache::RebuildCodeIndex() {
+  std::vector<JitCodeIndex::Entry> entries;
+  entries.reserve(method_code_map_.size() + jni_stubs_map_.size());
+  for (const auto& entry : method_code_map_) {
+    entries.push_back(JitCodeIndex::Entry { entry.first, entry.second });
+  }
+  for (const auto& entry : jni_stubs_map_) {
+    if (entry.second.IsCompiled()) {
+      entries.push_back(JitCodeIndex::Entry { entry.second.GetCode(), nullptr });
+    }
+  }
+  code_index_.Reset(std::move(entries));
+}
+
+class PassBarrierClosure FINAL : public Closure {
+ public:
+  explicit PassBarrierClosure(Barrier* barrier) : barrier_(barrier) {}
+
+  void Run(Thread* thread ATTRIBUTE_UNUSED) OVERRIDE {
+    barrier_->Pass(Thread::Current());
+  }
+
+ private:
+  Barrier* const barrier_;
+};
+
+void JitCodeCache::MaybeDeleteRetiredCodeIndexSnapshots(Thread* self) {
+  JitCodeIndex::RetiredSnapshots retired_snapshots;
+  {
+    MutexLock mu(self, lock_);
+    if (code_index_.RetiredBytes() <= kMaxRetiredCodeIndexBytes) {
+      return;
+    }
+    retired_snapshots = code_index_.TakeRetired();
+  }
+  // Lookups do not go through suspend points: once all the threads have run a checkpoint, none
+  // of them is using the snapshots.
+  ScopedTrace trace(__FUNCTION__);
+  Barrier barrier(0);
+  PassBarrierClosure closure(&barrier);
+  size_t threads_running_checkpoint = Runtime::Current()->GetThreadList()->RunCheckpoint(&closure);
+  ScopedThreadSuspension sts(self, kSuspended);
+  if (threads_running_checkpoint != 0) {
+    barrier.Increment(self, threads_running_checkpoint);
+  }
+}
+
 bool JitCodeCache::ShouldDoFullCollection() {
   if (current_capacity_ == max_capacity_) {
     // Always do a full collection when the code cache is full.
@@ -1066,6 +1512,7 @@ void JitCodeCache::GarbageCollectCache(Thread* self) {
       // Increase the code cache only when we do partial collections.
       // TODO: base this strategy on how full the code cache is?
       if (do_full_collection) {
+        number_of_full_collections_++;
         last_collection_increased_code_cache_ = false;
       } else {
         last_collection_increased_code_cache_ = true;
@@ -1079,9 +1526,14 @@ void JitCodeCache::GarbageCollectCache(Thread* self) {
         // Save the entry point of methods we have compiled, and update the entry
         // point of those methods to the interpreter. If the method is invoked, the
         // interpreter will update its entry point to the compiled code and call it.
+        // Code that survived enough full collections is only polled once in a while, so
+        // that the cold code gets evicted first.
+        const bool poll_tenured =
+            (number_of_full_collections_ + 1) % kTenuredPollingInterval == 0;
         for (ProfilingInfo* info : profiling_infos_) {
           const void* entry_point = info->GetMethod()->GetEntryPointFromQuickCompiledCode();
-          if (ContainsPc(entry_point)) {
+          if (IsInCodeMap(entry_point) &&
+              (poll_tenured || info->GetSurvivedCollections() < kSurvivorAge)) {
             info->SetSavedEntryPoint(entry_point);
             // Don't call Instrumentation::UpdateMethods, as it can check the declaring
             // class of the method. We may be concurrently running a GC which makes accessing
@@ -1090,6 +1542,25 @@ void JitCodeCache::GarbageCollectCache(Thread* self) {
             info->GetMethod()->SetEntryPointFromQuickCompiledCode(GetQuickToInterpreterBridge());
           }
         }
+        // JNI stubs are small and shared, only poll them with the tenured code. Their methods go
+        // back to the generic JNI trampoline, which counts calls towards getting the stub again.
+        if (poll_tenured) {
+          for (const auto& entry : jni_stubs_map_) {
+            const JniStubData& data = entry.second;
+            if (!data.IsCompiled()) {
+              continue;
+            }
+            const void* entry_point =
+                OatQuickMethodHeader::FromCodePointer(data.GetCode())->GetEntryPoint();
+            for (ArtMethod* method : data.GetMethods()) {
+              if (method->GetEntryPointFromQuickCompiledCode() == entry_point) {
+                // Bypass the instrumentation for the same reason as above.
+                method->SetEntryPointFromQuickCompiledCode(GetQuickGenericJniStub());
+                ClearMethodCounter(method, /*was_warm*/ false);
+              }
+            }
+          }
+        }
 
         DCHECK(CheckLiveCompiledCodeHasProfilingInfo());
       }
@@ -1105,7 +1576,6 @@ void JitCodeCache::RemoveUnmarkedCode(Thread* self) {
   std::unordered_set<OatQuickMethodHeader*> method_headers;
   {
     MutexLock mu(self, lock_);
-    ScopedCodeCacheWrite scc(code_map_.get());
     // Iterate over all compiled code and remove entries that are not marked.
     for (auto it = method_code_map_.begin(); it != method_code_map_.end();) {
       const void* code_ptr = it->first;
@@ -1117,6 +1587,18 @@ void JitCodeCache::RemoveUnmarkedCode(Thread* self) {
         it = method_code_map_.erase(it);
       }
     }
+    for (auto it = jni_stubs_map_.begin(); it != jni_stubs_map_.end();) {
+      const JniStubData& data = it->second;
+      if (!data.IsCompiled() || GetLiveBitmap()->Test(FromCodeToAllocation(data.GetCode()))) {
+        ++it;
+      } else {
+        method_headers.insert(OatQuickMethodHeader::FromCodePointer(data.GetCode()));
+        it = EraseJniStub(it);
+      }
+    }
+    if (!method_headers.empty()) {
+      RebuildCodeIndex();
+    }
   }
   FreeAllMethodHeaders(method_headers);
 }
@@ -1130,7 +1612,14 @@ void JitCodeCache::DoCollection(Thread* self, bool collect_profiling_info) {
       // Also remove the saved entry point from the ProfilingInfo objects.
       for (ProfilingInfo* info : profiling_infos_) {
         const void* ptr = info->GetMethod()->GetEntryPointFromQuickCompiledCode();
-        if (!ContainsPc(ptr) && !info->IsInUseByCompiler()) {
+        if (IsInCodeMap(ptr)) {
+          // Either not polled, or invoked since polling started.
+          info->IncrementSurvivedCollections();
+        } else if (info->GetSavedEntryPoint() != nullptr) {
+          // Polled and not invoked, the code is going away.
+          evicted_methods_.insert(info->GetMethod());
+        }
+        if (!IsInCodeMap(ptr) && !info->IsInUseByCompiler()) {
           info->GetMethod()->SetProfilingInfo(nullptr);
         }
 
@@ -1160,20 +1649,64 @@ void JitCodeCache::DoCollection(Thread* self, bool collect_profiling_info) {
         GetLiveBitmap()->AtomicTestAndSet(FromCodeToAllocation(code_ptr));
       }
     }
+    // Likewise mark the JNI stubs that are the entrypoint of any of their methods.
+    for (const auto& entry : jni_stubs_map_) {
+      const JniStubData& data = entry.second;
+      if (!data.IsCompiled()) {
+        continue;
+      }
+      const void* entry_point =
+          OatQuickMethodHeader::FromCodePointer(data.GetCode())->GetEntryPoint();
+      for (ArtMethod* method : data.GetMethods()) {
+        if (method->GetEntryPointFromQuickCompiledCode() == entry_point) {
+          GetLiveBitmap()->AtomicTestAndSet(FromCodeToAllocation(data.GetCode()));
+          break;
+        }
+      }
+    }
 
     // Empty osr method map, as osr compiled code will be deleted (except the ones
     // on thread stacks).
     osr_code_map_.clear();
+    // Likewise forget the baseline code that is no longer an entrypoint.
+    for (auto it = baseline_code_map_.begin(); it != baseline_code_map_.end();) {
+      const OatQuickMethodHeader* method_header = OatQuickMethodHeader::FromCodePointer(it->second);
+      if (method_header->GetEntryPoint() == it->first->GetEntryPointFromQuickCompiledCode()) {
+        ++it;
+      } else {
+        it = baseline_code_map_.erase(it);
+      }
+    }
+  }
+
+  // Lookups do not go through suspend points, so once all the threads have run the checkpoint,
+  // none of them is using the code index snapshots replaced before it.
+  JitCodeIndex::RetiredSnapshots retired_snapshots;
+  {
+    MutexLock mu(self, lock_);
+    retired_snapshots = code_index_.TakeRetired();
   }
 
   // Run a checkpoint on all threads to mark the JIT compiled code they are running.
   MarkCompiledCodeOnThreadStacks(self);
+  retired_snapshots.clear();
 
   // At this point, mutator threads are still running, and entrypoints of methods can
   // change. We do know they cannot change to a code cache entry that is not marked,
   // therefore we can safely remove those entries.
   RemoveUnmarkedCode(self);
 
+  if (collect_profiling_info && compact_code_) {
+    bool should_compact_code = false;
+    {
+      MutexLock mu(self, lock_);
+      should_compact_code = ShouldCompactCode();
+    }
+    if (should_compact_code) {
+      CompactCode(self);
+    }
+  }
+
   if (collect_profiling_info) {
     ScopedThreadSuspension sts(self, kSuspended);
     MutexLock mu(self, lock_);
@@ -1187,7 +1720,7 @@ void JitCodeCache::DoCollection(Thread* self, bool collect_profiling_info) {
         // a method has compiled code but no ProfilingInfo.
         // We make sure compiled methods have a ProfilingInfo object. It is needed for
         // code cache collection.
-        if (ContainsPc(ptr) &&
+        if (IsInCodeMap(ptr) &&
             info->GetMethod()->GetProfilingInfo(kRuntimePointerSize) == nullptr) {
           info->GetMethod()->SetProfilingInfo(info);
         } else if (info->GetMethod()->GetProfilingInfo(kRuntimePointerSize) != info) {
@@ -1202,6 +1735,133 @@ void JitCodeCache::DoCollection(Thread* self, bool collect_profiling_info) {
   }
 }
 
+bool JitCodeCache::ShouldCompactCode() {
+  size_t footprint = code_allocator_->Footprint();
+  size_t holes = footprint - code_allocator_->BytesAllocated();
+  return holes >= kCompactionMinHoles && holes * 100u >= footprint * kCompactionHolesPercent;
+}
+
+class CollectActiveCodeVisitor FINAL : public StackVisitor {
+ public:
+  CollectActiveCodeVisitor(Thread* thread_in, std::unordered_set<const void*>* active_code)
+      : StackVisitor(thread_in, nullptr, StackVisitor::StackWalkKind::kSkipInlinedFrames),
+        active_code_(active_code) {}
+
+  bool VisitFrame() OVERRIDE REQUIRES_SHARED(Locks::mutator_lock_) {
+    const OatQuickMethodHeader* method_header = GetCurrentOatQuickMethodHeader();
+    if (method_header != nullptr) {
+      active_code_->insert(method_header->GetCode());
+    }
+    return true;
+  }
+
+ private:
+  std::unordered_set<const void*>* const active_code_;
+};
+
+static void CollectActiveCode(Thread* thread, void* arg) REQUIRES_SHARED(Locks::mutator_lock_) {
+  CollectActiveCodeVisitor visitor(thread, reinterpret_cast<std::unordered_set<const void*>*>(arg));
+  visitor.WalkStack();
+}
+
+void JitCodeCache::CompactCode(Thread* self) {
+  ScopedTrace trace(__FUNCTION__);
+  // Debug info and perf maps record the code addresses. They are only generated when the code
+  // is never collected, and therefore never moved.
+  DCHECK(garbage_collect_code_);
+  Runtime* const runtime = Runtime::Current();
+  ScopedThreadSuspension sts(self, kSuspended);
+  ScopedSuspendAll ssa(__FUNCTION__);
+  // Instrumentation exit stubs keep return addresses in compiled code aside from the stacks.
+  if (runtime->GetInstrumentation()->AreExitStubsInstalled()) {
+    return;
+  }
+  // With all threads suspended, code is only entered again by returning to a frame on a stack,
+  // or through the entry point of its method. Code with frames stays where it is, and the entry
+  // points of the code that moves are updated below.
+  std::unordered_set<const void*> active_code;
+  {
+    MutexLock mu(self, *Locks::thread_list_lock_);
+    runtime->GetThreadList()->ForEach(CollectActiveCode, &active_code);
+  }
+
+  // Need cha_lock_ for updating the method headers of the CHA dependencies.
+  MutexLock cha_mu(self, *Locks::cha_lock_);
+  MutexLock mu(self, lock_);
+  // OSR code and the shared JNI stubs are not moved, only the code that is the entry point of
+  // its method, which is then its only reference.
+  std::vector<std::pair<const void*, ArtMethod*>> movable_code;
+  for (const auto& entry : method_code_map_) {
+    const OatQuickMethodHeader* method_header = OatQuickMethodHeader::FromCodePointer(entry.first);
+    if (method_header->GetEntryPoint() == entry.second->GetEntryPointFromQuickCompiledCode() &&
+        !ContainsElement(active_code, entry.first)) {
+      movable_code.push_back(entry);
+    }
+  }
+
+  size_t header_size =
+      RoundUp(sizeof(OatQuickMethodHeader), GetInstructionSetAlignment(kRuntimeISA));
+  std::unordered_map<OatQuickMethodHeader*, OatQuickMethodHeader*> moved_method_headers;
+  size_t moved_bytes = 0u;
+  {
+    ScopedCodeCacheWrite scc(code_map_.get());
+    // Start with the highest code, so that it fills the lowest holes.
+    for (auto it = movable_code.rbegin(); it != movable_code.rend(); ++it) {
+      const void* code_ptr = it->first;
+      ArtMethod* method = it->second;
+      uint8_t* allocation = reinterpret_cast<uint8_t*>(FromCodeToAllocation(code_ptr));
+      uint8_t* new_allocation = code_allocator_->AllocateBelow(allocation);
+      if (new_allocation == nullptr) {
+        continue;
+      }
+      OatQuickMethodHeader* method_header = OatQuickMethodHeader::FromCodePointer(code_ptr);
+      size_t code_size = method_header->GetCodeSize();
+      std::copy(allocation, allocation + header_size + code_size, new_allocation);
+      uint8_t* new_code_ptr = new_allocation + header_size;
+      OatQuickMethodHeader* new_method_header = OatQuickMethodHeader::FromCodePointer(new_code_ptr);
+      // The compiled code is position independent, but the header locates the stack maps and
+      // the method info relative to the code.
+      DCHECK(method_header->IsOptimized());
+      new_method_header->SetVmapTableOffset(dchecked_integral_cast<uint32_t>(
+          new_code_ptr - method_header->GetOptimizedCodeInfoPtr()));
+      if (method_header->GetMethodInfoOffset() != 0u) {
+        new_method_header->SetMethodInfoOffset(dchecked_integral_cast<uint32_t>(
+            new_code_ptr - method_header->GetOptimizedMethodInfoPtr()));
+      }
+      FlushInstructionCache(reinterpret_cast<char*>(new_code_ptr),
+                            reinterpret_cast<char*>(new_code_ptr + code_size));
+
+      method_code_map_.erase(code_ptr);
+      method_code_map_.Put(new_code_ptr, method);
+      auto baseline_code = baseline_code_map_.find(method);
+      if (baseline_code != baseline_code_map_.end() && baseline_code->second == code_ptr) {
+        baseline_code->second = new_code_ptr;
+      }
+      ProfilingInfo* info = method->GetProfilingInfo(kRuntimePointerSize);
+      if (info != nullptr && info->GetSavedEntryPoint() == method_header->GetEntryPoint()) {
+        info->SetSavedEntryPoint(new_method_header->GetEntryPoint());
+      }
+      // Bypass the instrumentation, we have checked above that the entry point is this code.
+      method->SetEntryPointFromQuickCompiledCode(new_method_header->GetEntryPoint());
+      moved_method_headers.emplace(method_header, new_method_header);
+      moved_bytes += code_allocator_->UsableSize(new_allocation);
+      code_allocator_->Free(allocation);
+    }
+  }
+  if (!moved_method_headers.empty()) {
+    RebuildCodeIndex();
+    QuickFrameCache::InvalidateAll();
+  }
+  // No thread is looking up code while all of them are suspended.
+  code_index_.TakeRetired();
+  runtime->GetClassLinker()->GetClassHierarchyAnalysis()->MoveDependentMethodHeaders(
+      moved_method_headers);
+  number_of_compactions_++;
+  VLOG(jit) << "JIT code cache compaction moved " << moved_method_headers.size()
+            << " methods, " << PrettySize(moved_bytes) << ", code footprint is now "
+            << PrettySize(code_allocator_->Footprint());
+}
+
 bool JitCodeCache::CheckLiveCompiledCodeHasProfilingInfo() {
   ScopedTrace trace(__FUNCTION__);
   // Check that methods we have compiled do have a ProfilingInfo object. We would
@@ -1228,39 +1888,67 @@ OatQuickMethodHeader* JitCodeCache::LookupMethodHeader(uintptr_t pc, ArtMethod*
     // On Thumb-2, the pc is offset by one.
     --pc;
   }
-  if (!ContainsPc(reinterpret_cast<const void*>(pc))) {
-    return nullptr;
+  if (IsInCodeMap(reinterpret_cast<const void*>(pc))) {
+    return LookupCodeIndex(pc, method);
   }
+  if (zygote_cache_ != nullptr && zygote_cache_->IsInCodeMap(reinterpret_cast<const void*>(pc))) {
+    // The code index of the zygote is not modified after the fork.
+    return zygote_cache_->LookupCodeIndex(pc, method);
+  }
+  return nullptr;
+}
 
-  MutexLock mu(Thread::Current(), lock_);
-  if (method_code_map_.empty()) {
+OatQuickMethodHeader* JitCodeCache::LookupCodeIndex(uintptr_t pc, ArtMethod* method) {
+  // The code index also has the JNI stubs, which are looked up by pc like the other code.
+  const JitCodeIndex::Entry* entry = code_index_.Lookup(pc);
+  if (entry == nullptr) {
     return nullptr;
   }
-  auto it = method_code_map_.lower_bound(reinterpret_cast<const void*>(pc));
-  --it;
-
-  const void* code_ptr = it->first;
-  OatQuickMethodHeader* method_header = OatQuickMethodHeader::FromCodePointer(code_ptr);
+  OatQuickMethodHeader* method_header = OatQuickMethodHeader::FromCodePointer(entry->code);
   if (!method_header->Contains(pc)) {
     return nullptr;
   }
-  if (kIsDebugBuild && method != nullptr) {
+  if (kIsDebugBuild && method != nullptr && entry->method != nullptr) {
     // When we are walking the stack to redefine classes and creating obsolete methods it is
     // possible that we might have updated the method_code_map by making this method obsolete in a
     // previous frame. Therefore we should just check that the non-obsolete version of this method
     // is the one we expect. We change to the non-obsolete versions in the error message since the
     // obsolete version of the method might not be fully initialized yet. This situation can only
     // occur when we are in the process of allocating and setting up obsolete methods. Otherwise
-    // method and it->second should be identical. (See runtime/openjdkjvmti/ti_redefine.cc for more
-    // information.)
-    DCHECK_EQ(it->second->GetNonObsoleteMethod(), method->GetNonObsoleteMethod())
+    // method and entry->method should be identical. (See runtime/openjdkjvmti/ti_redefine.cc for
+    // more information.)
+    DCHECK_EQ(entry->method->GetNonObsoleteMethod(), method->GetNonObsoleteMethod())
         << ArtMethod::PrettyMethod(method->GetNonObsoleteMethod()) << " "
-        << ArtMethod::PrettyMethod(it->second->GetNonObsoleteMethod()) << " "
+        << ArtMethod::PrettyMethod(entry->method->GetNonObsoleteMethod()) << " "
         << std::hex << pc;
   }
   return method_header;
 }
 
+const void* JitCodeCache::GetJniStubCode(ArtMethod* method) {
+  DCHECK(method->IsNative());
+  MutexLock mu(Thread::Current(), lock_);
+  auto it = FindJniStub(method);
+  return (it != jni_stubs_map_.end()) ? it->second.GetCode() : nullptr;
+}
+
+void JitCodeCache::AddJniStubMethod(JniStubMap::iterator it, ArtMethod* method) {
+  it->second.AddMethod(method);
+  jni_stub_methods_.Overwrite(method, it);
+}
+
+JitCodeCache::JniStubMap::iterator JitCodeCache::FindJniStub(ArtMethod* method) {
+  auto it = jni_stub_methods_.find(method);
+  return (it != jni_stub_methods_.end()) ? it->second : jni_stubs_map_.end();
+}
+
+JitCodeCache::JniStubMap::iterator JitCodeCache::EraseJniStub(JniStubMap::iterator it) {
+  for (ArtMethod* method : it->second.GetMethods()) {
+    jni_stub_methods_.erase(method);
+  }
+  return jni_stubs_map_.erase(it);
+}
+
 OatQuickMethodHeader* JitCodeCache::LookupOsrMethodHeader(ArtMethod* method) {
   MutexLock mu(Thread::Current(), lock_);
   auto it = osr_code_map_.find(method);
@@ -1273,6 +1961,7 @@ OatQuickMethodHeader* JitCodeCache::LookupOsrMethodHeader(ArtMethod* method) {
 ProfilingInfo* JitCodeCache::AddProfilingInfo(Thread* self,
                                               ArtMethod* method,
                                               const std::vector<uint32_t>& entries,
+                                              const std::vector<uint32_t>& branch_entries,
                                               bool retry_allocation)
     // No thread safety analysis as we are using TryLock/Unlock explicitly.
     NO_THREAD_SAFETY_ANALYSIS {
@@ -1281,19 +1970,19 @@ ProfilingInfo* JitCodeCache::AddProfilingInfo(Thread* self,
     // If we are allocating for the interpreter, just try to lock, to avoid
     // lock contention with the JIT.
     if (lock_.ExclusiveTryLock(self)) {
-      info = AddProfilingInfoInternal(self, method, entries);
+      info = AddProfilingInfoInternal(self, method, entries, branch_entries);
       lock_.ExclusiveUnlock(self);
     }
   } else {
     {
       MutexLock mu(self, lock_);
-      info = AddProfilingInfoInternal(self, method, entries);
+      info = AddProfilingInfoInternal(self, method, entries, branch_entries);
     }
 
     if (info == nullptr) {
       GarbageCollectCache(self);
       MutexLock mu(self, lock_);
-      info = AddProfilingInfoInternal(self, method, entries);
+      info = AddProfilingInfoInternal(self, method, entries, branch_entries);
     }
   }
   return info;
@@ -1301,9 +1990,12 @@ ProfilingInfo* JitCodeCache::AddProfilingInfo(Thread* self,
 
 ProfilingInfo* JitCodeCache::AddProfilingInfoInternal(Thread* self ATTRIBUTE_UNUSED,
                                                       ArtMethod* method,
-                                                      const std::vector<uint32_t>& entries) {
+                                                      const std::vector<uint32_t>& entries,
+                                                      const std::vector<uint32_t>& branch_entries) {
   size_t profile_info_size = RoundUp(
-      sizeof(ProfilingInfo) + sizeof(InlineCache) * entries.size(),
+      sizeof(ProfilingInfo) +
+          sizeof(InlineCache) * entries.size() +
+          sizeof(BranchCache) * branch_entries.size(),
       sizeof(void*));
 
   // Check whether some other thread has concurrently created it.
@@ -1316,7 +2008,7 @@ ProfilingInfo* JitCodeCache::AddProfilingInfoInternal(Thread* self ATTRIBUTE_UNU
   if (data == nullptr) {
     return nullptr;
   }
-  info = new (data) ProfilingInfo(method, entries);
+  info = new (data) ProfilingInfo(method, entries, branch_entries);
 
   // Make sure other threads see the data in the profiling info object before the
   // store in the ArtMethod's ProfilingInfo pointer.
@@ -1331,16 +2023,10 @@ ProfilingInfo* JitCodeCache::AddProfilingInfoInternal(Thread* self ATTRIBUTE_UNU
 // NO_THREAD_SAFETY_ANALYSIS as this is called from mspace code, at which point the lock
 // is already held.
 void* JitCodeCache::MoreCore(const void* mspace, intptr_t increment) NO_THREAD_SAFETY_ANALYSIS {
-  if (code_mspace_ == mspace) {
-    size_t result = code_end_;
-    code_end_ += increment;
-    return reinterpret_cast<void*>(result + code_map_->Begin());
-  } else {
-    DCHECK_EQ(data_mspace_, mspace);
-    size_t result = data_end_;
-    data_end_ += increment;
-    return reinterpret_cast<void*>(result + data_map_->Begin());
-  }
+  DCHECK_EQ(data_mspace_, mspace);
+  size_t result = data_end_;
+  data_end_ += increment;
+  return reinterpret_cast<void*>(result + data_map_->Begin());
 }
 
 void JitCodeCache::GetProfiledMethods(const std::set<std::string>& dex_base_locations,
@@ -1420,6 +2106,15 @@ void JitCodeCache::GetProfiledMethods(const std::set<std::string>& dex_base_loca
     }
     methods.emplace_back(/*ProfileMethodInfo*/
         MethodReference(dex_file, method->GetDexMethodIndex()), inline_caches);
+
+    const BranchCache* branch_caches = info->GetBranchCaches();
+    for (size_t i = 0; i < info->GetNumberOfBranchCaches(); ++i) {
+      const BranchCache& branch = branch_caches[i];
+      if (branch.GetTakenCount() != 0 || branch.GetNotTakenCount() != 0) {
+        methods.back().branches.emplace_back(/*ProfileMethodInfo::ProfileBranch*/
+            branch.GetDexPc(), branch.GetTakenCount(), branch.GetNotTakenCount());
+      }
+    }
   }
 }
 
@@ -1432,8 +2127,47 @@ bool JitCodeCache::IsOsrCompiled(ArtMethod* method) {
   return osr_code_map_.find(method) != osr_code_map_.end();
 }
 
-bool JitCodeCache::NotifyCompilationOf(ArtMethod* method, Thread* self, bool osr) {
-  if (!osr && ContainsPc(method->GetEntryPointFromQuickCompiledCode())) {
+bool JitCodeCache::IsBaselineCompiled(ArtMethod* method) {
+  MutexLock mu(Thread::Current(), lock_);
+  auto it = baseline_code_map_.find(method);
+  return it != baseline_code_map_.end() &&
+      OatQuickMethodHeader::FromCodePointer(it->second)->GetEntryPoint() ==
+          method->GetEntryPointFromQuickCompiledCode();
+}
+
+bool JitCodeCache::NotifyCompilationOf(ArtMethod* method,
+                                       Thread* self,
+                                       bool osr,
+                                       bool baseline) {
+  if (!osr &&
+      ContainsPc(method->GetEntryPointFromQuickCompiledCode()) &&
+      (baseline || !IsBaselineCompiled(method))) {
+    return false;
+  }
+
+  if (UNLIKELY(method->IsNative())) {
+    JniStubKey key(method);
+    MutexLock mu(self, lock_);
+    auto it = jni_stubs_map_.find(key);
+    if (it == jni_stubs_map_.end()) {
+      // Compile a new stub.
+      it = jni_stubs_map_.Put(key, JniStubData());
+      AddJniStubMethod(it, method);
+      return true;
+    }
+    AddJniStubMethod(it, method);
+    JniStubData* data = &it->second;
+    if (!data->IsCompiled()) {
+      // The stub is being compiled, CommitCode() updates the entry points of all its methods.
+      return false;
+    }
+    // Share the existing stub.
+    const void* entry_point =
+        OatQuickMethodHeader::FromCodePointer(data->GetCode())->GetEntryPoint();
+    if (collection_in_progress_) {
+      GetLiveBitmap()->AtomicTestAndSet(FromCodeToAllocation(data->GetCode()));
+    }
+    Runtime::Current()->GetInstrumentation()->UpdateMethodsCode(method, entry_point);
     return false;
   }
 
@@ -1478,7 +2212,23 @@ void JitCodeCache::DoneCompilerUse(ArtMethod* method, Thread* self) {
   info->DecrementInlineUse();
 }
 
-void JitCodeCache::DoneCompiling(ArtMethod* method, Thread* self ATTRIBUTE_UNUSED, bool osr) {
+void JitCodeCache::DoneCompiling(ArtMethod* method, Thread* self, bool osr) {
+  if (UNLIKELY(method->IsNative())) {
+    JniStubKey key(method);
+    MutexLock mu(self, lock_);
+    auto it = jni_stubs_map_.find(key);
+    DCHECK(it != jni_stubs_map_.end());
+    if (!it->second.IsCompiled()) {
+      // The compilation failed, forget the stub and let its methods request it again.
+      for (ArtMethod* m : it->second.GetMethods()) {
+        ClearMethodCounter(m, /*was_warm*/ false);
+      }
+      EraseJniStub(it);
+    }
+    return;
+  }
+  // Other compiler threads may be reading or setting the flags in NotifyCompilationOf.
+  MutexLock mu(self, lock_);
   ProfilingInfo* info = method->GetProfilingInfo(kRuntimePointerSize);
   DCHECK(info->IsMethodBeingCompiled(osr));
   info->SetIsMethodBeingCompiled(false, osr);
@@ -1486,7 +2236,7 @@ void JitCodeCache::DoneCompiling(ArtMethod* method, Thread* self ATTRIBUTE_UNUSE
 
 size_t JitCodeCache::GetMemorySizeOfCodePointer(const void* ptr) {
   MutexLock mu(Thread::Current(), lock_);
-  return mspace_usable_size(reinterpret_cast<const void*>(FromCodeToAllocation(ptr)));
+  return code_allocator_->UsableSize(reinterpret_cast<const uint8_t*>(FromCodeToAllocation(ptr)));
 }
 
 void JitCodeCache::InvalidateCompiledCodeFor(ArtMethod* method,
@@ -1504,6 +2254,10 @@ void JitCodeCache::InvalidateCompiledCodeFor(ArtMethod* method,
     Runtime::Current()->GetInstrumentation()->UpdateMethodsCode(
         method, GetQuickToInterpreterBridge());
     ClearMethodCounter(method, /*was_warm*/ profiling_info != nullptr);
+    if (zygote_cache_ != nullptr && zygote_cache_->IsInCodeMap(header->GetCode())) {
+      MutexLock mu(Thread::Current(), lock_);
+      zygote_methods_.erase(method);
+    }
   } else {
     MutexLock mu(Thread::Current(), lock_);
     auto it = osr_code_map_.find(method);
@@ -1516,18 +2270,24 @@ void JitCodeCache::InvalidateCompiledCodeFor(ArtMethod* method,
 
 uint8_t* JitCodeCache::AllocateCode(size_t code_size) {
   size_t alignment = GetInstructionSetAlignment(kRuntimeISA);
-  uint8_t* result = reinterpret_cast<uint8_t*>(
-      mspace_memalign(code_mspace_, alignment, code_size));
+  uint8_t* result = code_allocator_->Allocate(code_size);
+  if (result == nullptr) {
+    return nullptr;
+  }
   size_t header_size = RoundUp(sizeof(OatQuickMethodHeader), alignment);
   // Ensure the header ends up at expected instruction alignment.
   DCHECK_ALIGNED_PARAM(reinterpret_cast<uintptr_t>(result + header_size), alignment);
-  used_memory_for_code_ += mspace_usable_size(result);
+  used_memory_for_code_ += code_allocator_->UsableSize(result);
+  ART_TRACE_COUNTER("JIT code cache size (KB)", used_memory_for_code_ / KB);
   return result;
 }
 
 void JitCodeCache::FreeCode(uint8_t* code) {
-  used_memory_for_code_ -= mspace_usable_size(code);
-  mspace_free(code_mspace_, code);
+  // The freed range may get new code, for which the frame caches must not return this code.
+  QuickFrameCache::InvalidateAll();
+  used_memory_for_code_ -= code_allocator_->UsableSize(code);
+  ART_TRACE_COUNTER("JIT code cache size (KB)", used_memory_for_code_ / KB);
+  code_allocator_->Free(code);
 }
 
 uint8_t* JitCodeCache::AllocateData(size_t data_size) {
@@ -1547,10 +2307,21 @@ void JitCodeCache::Dump(std::ostream& os) {
      << "Current JIT data cache size: " << PrettySize(used_memory_for_data_) << "\n"
      << "Current JIT capacity: " << PrettySize(current_capacity_) << "\n"
      << "Current number of JIT code cache entries: " << method_code_map_.size() << "\n"
+     << "Current number of JIT JNI stub entries: " << jni_stubs_map_.size() << "\n"
      << "Total number of JIT compilations: " << number_of_compilations_ << "\n"
+     << "Total number of JIT compilations of JNI stubs: "
+        << number_of_jni_stub_compilations_ << "\n"
      << "Total number of JIT compilations for on stack replacement: "
         << number_of_osr_compilations_ << "\n"
-     << "Total number of JIT code cache collections: " << number_of_collections_ << std::endl;
+     << "Total number of JIT code cache collections: " << number_of_collections_ << "\n"
+     << "Total number of full JIT code cache collections: " << number_of_full_collections_ << "\n"
+     << "Total number of JIT code cache compactions: " << number_of_compactions_ << "\n"
+     << "Total number of recompilations of evicted JIT code: " << number_of_recompilations_
+        << std::endl;
+  if (zygote_cache_ != nullptr) {
+    os << "Current number of methods using zygote JIT code: " << zygote_methods_.size()
+       << std::endl;
+  }
   histogram_stack_map_memory_use_.PrintMemoryUse(os);
   histogram_code_memory_use_.PrintMemoryUse(os);
   histogram_profiling_info_memory_use_.PrintMemoryUse(os);
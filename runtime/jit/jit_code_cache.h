@@ -26,6 +26,8 @@
 #include "base/mutex.h"
 #include "gc/accounting/bitmap.h"
 #include "gc_root.h"
+#include "jit_code_allocator.h"
+#include "jit_code_index.h"
 #include "jni.h"
 #include "method_reference.h"
 #include "oat_file.h"
@@ -61,19 +63,34 @@ class JitCodeCache {
   static constexpr size_t kReservedCapacity = kInitialCapacity * 4;
 
   // Create the code cache with a code + data capacity equal to "capacity", error message is passed
-  // in the out arg error_msg.
+  // in the out arg error_msg. With `compact_code`, full collections move the code that is not
+  // running into the holes left by the freed code. A cache created `for_zygote` is filled by the
+  // zygote before forking: its code is not executable in the zygote and never collected.
   static JitCodeCache* Create(size_t initial_capacity,
                               size_t max_capacity,
                               bool generate_debug_info,
+                              bool use_huge_pages,
+                              bool compact_code,
+                              bool for_zygote,
                               std::string* error_msg);
 
+  ~JitCodeCache();
+
   // Number of bytes allocated in the code cache.
   size_t CodeCacheSize() REQUIRES(!lock_);
 
   // Number of bytes allocated in the data cache.
   size_t DataCacheSize() REQUIRES(!lock_);
 
-  bool NotifyCompilationOf(ArtMethod* method, Thread* self, bool osr)
+  // Number of compilations committed so far, and how many of them were for on stack replacement.
+  size_t NumberOfCompilations() REQUIRES(!lock_);
+  size_t NumberOfOsrCompilations() REQUIRES(!lock_);
+
+  // Returns whether the compilation of `method` may proceed. Only an optimized compilation may
+  // replace the code of a method that already has some, and only if that code is baseline code.
+  // For a native method, returns false if a compiled JNI stub for it already exists: its entry
+  // point is then updated to that stub.
+  bool NotifyCompilationOf(ArtMethod* method, Thread* self, bool osr, bool baseline)
       REQUIRES_SHARED(Locks::mutator_lock_)
       REQUIRES(!lock_);
 
@@ -115,15 +132,35 @@ class JitCodeCache {
                       size_t code_size,
                       size_t data_size,
                       bool osr,
+                      bool baseline,
                       Handle<mirror::ObjectArray<mirror::Object>> roots,
                       bool has_should_deoptimize_flag,
                       const ArenaSet<ArtMethod*>& cha_single_implementation_list)
       REQUIRES_SHARED(Locks::mutator_lock_)
       REQUIRES(!lock_);
 
-  // Return true if the code cache contains this pc.
+  // Return true if the code cache contains this pc, including the code of the zygote cache.
   bool ContainsPc(const void* pc) const;
 
+  // Return true if the code this cache allocated contains this pc.
+  bool IsInCodeMap(const void* pc) const;
+
+  bool IsZygoteCache() const {
+    return is_zygote_cache_;
+  }
+
+  // Take ownership of `zygote_cache`, which the zygote filled before forking this process. Its
+  // code and data are made read only, so that their pages stay shared with the zygote, and its
+  // code is looked up along with the code of this cache.
+  void AttachZygoteCodeCache(JitCodeCache* zygote_cache) REQUIRES(!lock_);
+
+  // Update the entry points of the methods the zygote compiled to their code. Methods that do not
+  // use the interpreter bridge, such as the static methods of classes not initialized yet, keep
+  // their entry point and forget the code of the zygote.
+  void InstallZygoteCode(Thread* self)
+      REQUIRES(!lock_)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
   // Return true if the code cache contains this method.
   bool ContainsMethod(ArtMethod* method) REQUIRES(!lock_);
 
@@ -171,6 +208,13 @@ class JitCodeCache {
       REQUIRES(!lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Return the code of the compiled JNI stub used by the native `method`, or null if there is
+  // none. The entry point of `method` may not be that code, for instance while the code cache
+  // is polling for the liveness of JNI stubs.
+  const void* GetJniStubCode(ArtMethod* method)
+      REQUIRES(!lock_)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
   // Removes method from the cache for testing purposes. The caller
   // must ensure that all threads are suspended and the method should
   // not be in any thread's stack.
@@ -183,7 +227,12 @@ class JitCodeCache {
       REQUIRES(!lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
-  void CopyInlineCacheInto(const InlineCache& ic, Handle<mirror::ObjectArray<mirror::Class>> array)
+  // Copy the classes of `ic` into `array`, and their call counts into the
+  // `InlineCache::kIndividualCacheSize` entries of `counts`, in the same order.
+  void CopyInlineCacheInto(const InlineCache& ic,
+                           Handle<mirror::ObjectArray<mirror::Class>> array,
+                           /*out*/uint16_t* counts,
+                           /*out*/uint16_t* megamorphic_count)
       REQUIRES(!lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
@@ -192,12 +241,13 @@ class JitCodeCache {
   ProfilingInfo* AddProfilingInfo(Thread* self,
                                   ArtMethod* method,
                                   const std::vector<uint32_t>& entries,
+                                  const std::vector<uint32_t>& branch_entries,
                                   bool retry_allocation)
       REQUIRES(!lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
   bool OwnsSpace(const void* mspace) const NO_THREAD_SAFETY_ANALYSIS {
-    return mspace == code_mspace_ || mspace == data_mspace_;
+    return mspace == data_mspace_;
   }
 
   void* MoreCore(const void* mspace, intptr_t increment);
@@ -225,6 +275,10 @@ class JitCodeCache {
 
   bool IsOsrCompiled(ArtMethod* method) REQUIRES(!lock_);
 
+  // Return whether the entry point of `method` is baseline code, which an optimized compilation
+  // is expected to replace.
+  bool IsBaselineCompiled(ArtMethod* method) REQUIRES(!lock_);
+
   void SweepRootTables(IsMarkedVisitor* visitor)
       REQUIRES(!lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
@@ -253,7 +307,9 @@ class JitCodeCache {
                size_t initial_code_capacity,
                size_t initial_data_capacity,
                size_t max_capacity,
-               bool garbage_collect_code);
+               bool garbage_collect_code,
+               bool compact_code,
+               bool for_zygote);
 
   // Internal version of 'CommitCode' that will not retry if the
   // allocation fails. Return null if the allocation fails.
@@ -269,6 +325,7 @@ class JitCodeCache {
                               size_t code_size,
                               size_t data_size,
                               bool osr,
+                              bool baseline,
                               Handle<mirror::ObjectArray<mirror::Object>> roots,
                               bool has_should_deoptimize_flag,
                               const ArenaSet<ArtMethod*>& cha_single_implementation_list)
@@ -277,7 +334,8 @@ class JitCodeCache {
 
   ProfilingInfo* AddProfilingInfoInternal(Thread* self,
                                           ArtMethod* method,
-                                          const std::vector<uint32_t>& entries)
+                                          const std::vector<uint32_t>& entries,
+                                          const std::vector<uint32_t>& branch_entries)
       REQUIRES(lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
@@ -291,7 +349,7 @@ class JitCodeCache {
       REQUIRES(!lock_)
       REQUIRES(!Locks::cha_lock_);
 
-  // Free in the mspace allocations for `code_ptr`.
+  // Free the code and data allocations for `code_ptr`.
   void FreeCode(const void* code_ptr) REQUIRES(lock_);
 
   // Number of bytes allocated in the code cache.
@@ -322,20 +380,63 @@ class JitCodeCache {
       REQUIRES(!lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Look up `pc`, which IsInCodeMap, in code_index_.
+  OatQuickMethodHeader* LookupCodeIndex(uintptr_t pc, ArtMethod* method)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
+  // Add compiled code, or a compiled JNI stub with a null `method`, to the code index.
+  void AddToCodeIndex(const void* code_ptr, ArtMethod* method) REQUIRES(lock_);
+
+  // Rebuild the code index from method_code_map_ and jni_stubs_map_, after removing or moving
+  // code.
+  void RebuildCodeIndex() REQUIRES(lock_);
+
+  // Delete the replaced code index snapshots if they hold more than kMaxRetiredCodeIndexBytes.
+  void MaybeDeleteRetiredCodeIndexSnapshots(Thread* self)
+      REQUIRES(!lock_)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
   bool CheckLiveCompiledCodeHasProfilingInfo()
       REQUIRES(lock_);
 
+  // Return whether the holes between the code are worth a compaction.
+  bool ShouldCompactCode() REQUIRES(lock_);
+
+  // Move the code that is the entry point of its method, and not on any thread stack, to lower
+  // addresses. Suspends all threads.
+  void CompactCode(Thread* self)
+      REQUIRES(!lock_)
+      REQUIRES(!Locks::cha_lock_)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
   void FreeCode(uint8_t* code) REQUIRES(lock_);
   uint8_t* AllocateCode(size_t code_size) REQUIRES(lock_);
   void FreeData(uint8_t* data) REQUIRES(lock_);
   uint8_t* AllocateData(size_t data_size) REQUIRES(lock_);
 
+  // Native methods share their JNI stub with all native methods that have the same shorty and
+  // the same flags, see JniStubKey.
+  class JniStubKey;
+  class JniStubData;
+  typedef SafeMap<JniStubKey, JniStubData> JniStubMap;
+
+  // Add `method` to the JNI stub at `it` and to jni_stub_methods_.
+  void AddJniStubMethod(JniStubMap::iterator it, ArtMethod* method) REQUIRES(lock_);
+
+  // Return the JNI stub of `method`, or the end of jni_stubs_map_ if it has none. Unlike finding
+  // the stub by its key, this does not look up the annotations of `method`.
+  JniStubMap::iterator FindJniStub(ArtMethod* method) REQUIRES(lock_);
+
+  // Remove the JNI stub at `it` from jni_stubs_map_ and its methods from jni_stub_methods_.
+  JniStubMap::iterator EraseJniStub(JniStubMap::iterator it) REQUIRES(lock_);
+
   bool IsWeakAccessEnabled(Thread* self) const;
   void WaitUntilInlineCacheAccessible(Thread* self)
       REQUIRES(!lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
-  // Lock for guarding allocations, collections, and the method_code_map_.
+  // Lock for guarding allocations, collections, and the method_code_map_. Pc lookups go through
+  // code_index_ instead.
   Mutex lock_;
   // Condition to wait on during collection.
   ConditionVariable lock_cond_ GUARDED_BY(lock_);
@@ -345,16 +446,26 @@ class JitCodeCache {
   std::unique_ptr<MemMap> code_map_;
   // Mem map which holds data (stack maps and profiling info).
   std::unique_ptr<MemMap> data_map_;
-  // The opaque mspace for allocating code.
-  void* code_mspace_ GUARDED_BY(lock_);
+  // The allocator for code.
+  std::unique_ptr<JitCodeAllocator> code_allocator_ GUARDED_BY(lock_);
   // The opaque mspace for allocating data.
   void* data_mspace_ GUARDED_BY(lock_);
   // Bitmap for collecting code and data.
   std::unique_ptr<CodeCacheBitmap> live_bitmap_;
   // Holds compiled code associated to the ArtMethod.
   SafeMap<const void*, ArtMethod*> method_code_map_ GUARDED_BY(lock_);
+  // Holds compiled JNI stubs and the native methods using them.
+  JniStubMap jni_stubs_map_ GUARDED_BY(lock_);
+  // The JNI stub of each native method in jni_stubs_map_, so that stack walks and entry point
+  // queries do not scan the methods of every stub.
+  SafeMap<ArtMethod*, JniStubMap::iterator> jni_stub_methods_ GUARDED_BY(lock_);
+  // The code of method_code_map_ and of the compiled JNI stubs by address, for looking up pcs
+  // without lock_. Only modified with lock_ held.
+  JitCodeIndex code_index_;
   // Holds osr compiled code associated to the ArtMethod.
   SafeMap<ArtMethod*, const void*> osr_code_map_ GUARDED_BY(lock_);
+  // Holds the baseline compiled code of ArtMethods that have not been optimized yet.
+  SafeMap<ArtMethod*, const void*> baseline_code_map_ GUARDED_BY(lock_);
   // ProfilingInfo objects we have allocated.
   std::vector<ProfilingInfo*> profiling_infos_ GUARDED_BY(lock_);
 
@@ -364,9 +475,6 @@ class JitCodeCache {
   // The current capacity in bytes of the code cache.
   size_t current_capacity_ GUARDED_BY(lock_);
 
-  // The current footprint in bytes of the code portion of the code cache.
-  size_t code_end_ GUARDED_BY(lock_);
-
   // The current footprint in bytes of the data portion of the code cache.
   size_t data_end_ GUARDED_BY(lock_);
 
@@ -380,6 +488,20 @@ class JitCodeCache {
   // Whether we can do garbage collection. Not 'const' as tests may override this.
   bool garbage_collect_code_;
 
+  // Whether full collections compact the code.
+  const bool compact_code_;
+
+  // Whether this cache is filled by the zygote before forking.
+  const bool is_zygote_cache_;
+
+  // The cache the zygote filled before forking this process, read only. Set before this cache is
+  // used, see AttachZygoteCodeCache.
+  std::unique_ptr<JitCodeCache> zygote_cache_;
+
+  // The methods that have code in zygote_cache_. Redefined methods are removed, their code stays
+  // unused in the pages shared with the zygote.
+  SafeMap<ArtMethod*, const void*> zygote_methods_ GUARDED_BY(lock_);
+
   // The size in bytes of used memory for the data portion of the code cache.
   size_t used_memory_for_data_ GUARDED_BY(lock_);
 
@@ -389,12 +511,28 @@ class JitCodeCache {
   // Number of compilations done throughout the lifetime of the JIT.
   size_t number_of_compilations_ GUARDED_BY(lock_);
 
+  // Number of JNI stubs compiled throughout the lifetime of the JIT.
+  size_t number_of_jni_stub_compilations_ GUARDED_BY(lock_);
+
   // Number of compilations for on-stack-replacement done throughout the lifetime of the JIT.
   size_t number_of_osr_compilations_ GUARDED_BY(lock_);
 
   // Number of code cache collections done throughout the lifetime of the JIT.
   size_t number_of_collections_ GUARDED_BY(lock_);
 
+  // Number of full code cache collections done throughout the lifetime of the JIT.
+  size_t number_of_full_collections_ GUARDED_BY(lock_);
+
+  // Number of code compactions done throughout the lifetime of the JIT.
+  size_t number_of_compactions_ GUARDED_BY(lock_);
+
+  // Methods whose code a full collection found cold and evicted, and that have not been
+  // compiled again since.
+  std::unordered_set<ArtMethod*> evicted_methods_ GUARDED_BY(lock_);
+
+  // Number of compilations of methods in `evicted_methods_`.
+  size_t number_of_recompilations_ GUARDED_BY(lock_);
+
   // Histograms for keeping track of stack map size statistics.
   Histogram<uint64_t> histogram_stack_map_memory_use_ GUARDED_BY(lock_);
 
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jit_code_index.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "base/logging.h"
+#include "globals.h"
+
+namespace art {
+namespace jit {
+
+static bool CompareEntries(const JitCodeIndex::Entry& lhs, const JitCodeIndex::Entry& rhs) {
+  return lhs.code < rhs.code;
+}
+
+// Return the entry of `entries` with the highest address below `pc`, or nullptr.
+static const JitCodeIndex::Entry* LookupIn(const std::vector<JitCodeIndex::Entry>& entries,
+                                           uintptr_t pc) {
+  auto it = std::lower_bound(entries.begin(),
+                             entries.end(),
+                             pc,
+                             [](const JitCodeIndex::Entry& entry, uintptr_t value) {
+    return reinterpret_cast<uintptr_t>(entry.code) < value;
+  });
+  return (it == entries.begin()) ? nullptr : &*(it - 1);
+}
+
+const JitCodeIndex::Entry* JitCodeIndex::Snapshot::Lookup(uintptr_t pc) const {
+  const Entry* entry = LookupIn(*entries_, pc);
+  const Entry* added = LookupIn(added_, pc);
+  if (added != nullptr && (entry == nullptr || entry->code < added->code)) {
+    return added;
+  }
+  return entry;
+}
+
+JitCodeIndex::JitCodeIndex() : snapshot_(nullptr), retired_bytes_(0u) {
+  snapshot_.StoreRelaxed(new Snapshot(std::make_shared<const std::vector<Entry>>(),
+                                      std::vector<Entry>()));
+}
+
+JitCodeIndex::~JitCodeIndex() {
+  delete snapshot_.LoadRelaxed();
+}
+
+const JitCodeIndex::Entry* JitCodeIndex::Lookup(uintptr_t pc) const {
+  return snapshot_.LoadAcquire()->Lookup(pc);
+}
+
+void JitCodeIndex::Publish(Snapshot* snapshot) {
+  const Snapshot* old_snapshot = snapshot_.LoadRelaxed();
+  snapshot_.StoreRelease(snapshot);
+  retired_bytes_ += sizeof(Snapshot) + old_snapshot->added_.size() * sizeof(Entry);
+  if (old_snapshot->entries_ != snapshot->entries_) {
+    retired_bytes_ += old_snapshot->entries_->size() * sizeof(Entry);
+  }
+  retired_.emplace_back(old_snapshot);
+}
+
+void JitCodeIndex::Add(const void* code, ArtMethod* method) {
+  const Snapshot* old_snapshot = snapshot_.LoadRelaxed();
+  if (kIsDebugBuild) {
+    const Entry* previous = old_snapshot->Lookup(reinterpret_cast<uintptr_t>(code) + 1u);
+    DCHECK(previous == nullptr || previous->code != code) << code;
+  }
+  Entry entry = { code, method };
+  if (old_snapshot->added_.size() == kMaxAddedEntries) {
+    // Merge all the entries in a new shared array.
+    std::vector<Entry> entries;
+    entries.reserve(old_snapshot->entries_->size() + kMaxAddedEntries + 1u);
+    entries.insert(entries.end(), old_snapshot->entries_->begin(), old_snapshot->entries_->end());
+    entries.insert(entries.end(), old_snapshot->added_.begin(), old_snapshot->added_.end());
+    entries.push_back(entry);
+    Reset(std::move(entries));
+    return;
+  }
+  std::vector<Entry> added(old_snapshot->added_);
+  added.insert(std::upper_bound(added.begin(), added.end(), entry, CompareEntries), entry);
+  Publish(new Snapshot(old_snapshot->entries_, std::move(added)));
+}
+
+void JitCodeIndex::Reset(std::vector<Entry>&& entries) {
+  std::sort(entries.begin(), entries.end(), CompareEntries);
+  Publish(new Snapshot(std::make_shared<const std::vector<Entry>>(std::move(entries)),
+                       std::vector<Entry>()));
+}
+
+JitCodeIndex::RetiredSnapshots JitCodeIndex::TakeRetired() {
+  RetiredSnapshots retired;
+  retired.swap(retired_);
+  retired_bytes_ = 0u;
+  return retired;
+}
+
+size_t JitCodeIndex::Size() const {
+  const Snapshot* snapshot = snapshot_.LoadRelaxed();
+  return snapshot->entries_->size() + snapshot->added_.size();
+}
+
+}  // namespace jit
+}  // namespace art
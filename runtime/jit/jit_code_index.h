@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_JIT_JIT_CODE_INDEX_H_
+#define ART_RUNTIME_JIT_JIT_CODE_INDEX_H_
+
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+#include "atomic.h"
+#include "base/macros.h"
+
+namespace art {
+
+class ArtMethod;
+
+namespace jit {
+
+// Index of the code of the JIT code cache by address, for looking up the code of a pc without
+// taking the code cache lock. The index is a snapshot that is never modified once published:
+// the writers, which the caller serializes, publish a new snapshot for every change.
+//
+// A snapshot is a large sorted array shared with the following snapshots, plus a small sorted
+// array of the code added since, so that adding code copies only the small array. Removing code
+// rebuilds the index, which the code cache only does for batches of code.
+//
+// Replaced snapshots are retired rather than deleted, since readers may still be using them.
+// The caller takes them with TakeRetired() and deletes them once no reader can be using them.
+class JitCodeIndex {
+ public:
+  struct Entry {
+    const void* code;
+    ArtMethod* method;
+  };
+
+  class Snapshot;
+  using RetiredSnapshots = std::vector<std::unique_ptr<const Snapshot>>;
+
+  // Number of entries added since the last rebuild above which they are merged with the others.
+  static constexpr size_t kMaxAddedEntries = 64;
+
+  JitCodeIndex();
+  ~JitCodeIndex();
+
+  // Return the entry of the code with the highest address below `pc`, or nullptr if there is
+  // none. The entry is valid until the snapshot is deleted. Can be called concurrently with the
+  // writers.
+  const Entry* Lookup(uintptr_t pc) const;
+
+  // Add the code at `code`, which must not be in the index.
+  void Add(const void* code, ArtMethod* method);
+
+  // Replace the content of the index with `entries`, which need not be sorted.
+  void Reset(std::vector<Entry>&& entries);
+
+  // Take the snapshots replaced so far.
+  RetiredSnapshots TakeRetired();
+
+  // Bytes held by the snapshots that have not been taken yet, an estimation.
+  size_t RetiredBytes() const {
+    return retired_bytes_;
+  }
+
+  size_t Size() const;
+
+ private:
+  void Publish(Snapshot* snapshot);
+
+  Atomic<const Snapshot*> snapshot_;
+  RetiredSnapshots retired_;
+  size_t retired_bytes_;
+
+  DISALLOW_COPY_AND_ASSIGN(JitCodeIndex);
+};
+
+class JitCodeIndex::Snapshot {
+ public:
+  Snapshot(std::shared_ptr<const std::vector<Entry>> entries, std::vector<Entry>&& added)
+      : entries_(std::move(entries)), added_(std::move(added)) {}
+
+  const Entry* Lookup(uintptr_t pc) const;
+
+ private:
+  // The entries at the last rebuild, and the ones added since, both sorted by address.
+  const std::shared_ptr<const std::vector<Entry>> entries_;
+  const std::vector<Entry> added_;
+
+  friend class JitCodeIndex;
+  DISALLOW_COPY_AND_ASSIGN(Snapshot);
+};
+
+}  // namespace jit
+}  // namespace art
+
+#endif  // ART_RUNTIME_JIT_JIT_CODE_INDEX_H_
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "jit_code_index.h"
+
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace art {
+namespace jit {
+
+// The index never dereferences the code or the methods.
+static const void* Code(uintptr_t address) {
+  return reinterpret_cast<const void*>(address);
+}
+
+static ArtMethod* Method(uintptr_t id) {
+  return reinterpret_cast<ArtMethod*>(id);
+}
+
+TEST(JitCodeIndex, Lookup) {
+  JitCodeIndex index;
+  EXPECT_EQ(nullptr, index.Lookup(0x1000));
+  index.Add(Code(0x2000), Method(2));
+  index.Add(Code(0x1000), Method(1));
+  index.Add(Code(0x3000), nullptr);
+  EXPECT_EQ(3u, index.Size());
+
+  // A pc belongs to the highest code strictly below it.
+  EXPECT_EQ(nullptr, index.Lookup(0x1000));
+  EXPECT_EQ(Method(1), index.Lookup(0x1001)->method);
+  EXPECT_EQ(Method(1), index.Lookup(0x2000)->method);
+  EXPECT_EQ(Code(0x2000), index.Lookup(0x2004)->code);
+  EXPECT_EQ(nullptr, index.Lookup(0x3004)->method);
+  EXPECT_EQ(Code(0x3000), index.Lookup(0x9000)->code);
+}
+
+TEST(JitCodeIndex, MergeAddedEntries) {
+  JitCodeIndex index;
+  // Interleave the added entries with the merged ones.
+  for (uintptr_t i = 0; i != 2 * JitCodeIndex::kMaxAddedEntries + 3; ++i) {
+    uintptr_t address = 0x1000 + ((i % 2 == 0) ? i : 0x1000 - i) * 0x10;
+    index.Add(Code(address), Method(i));
+  }
+  EXPECT_EQ(2 * JitCodeIndex::kMaxAddedEntries + 3, index.Size());
+  for (uintptr_t i = 0; i != 2 * JitCodeIndex::kMaxAddedEntries + 3; ++i) {
+    uintptr_t address = 0x1000 + ((i % 2 == 0) ? i : 0x1000 - i) * 0x10;
+    EXPECT_EQ(Method(i), index.Lookup(address + 4)->method);
+  }
+}
+
+TEST(JitCodeIndex, Reset) {
+  JitCodeIndex index;
+  index.Add(Code(0x1000), Method(1));
+  index.Add(Code(0x2000), Method(2));
+  std::vector<JitCodeIndex::Entry> entries = {
+      { Code(0x3000), Method(3) },
+      { Code(0x1000), Method(4) },
+  };
+  index.Reset(std::move(entries));
+  EXPECT_EQ(2u, index.Size());
+  EXPECT_EQ(Method(4), index.Lookup(0x2004)->method);
+  EXPECT_EQ(Method(3), index.Lookup(0x3004)->method);
+}
+
+TEST(JitCodeIndex, RetiredSnapshots) {
+  JitCodeIndex index;
+  const JitCodeIndex::Entry* entry = nullptr;
+  index.Add(Code(0x1000), Method(1));
+  entry = index.Lookup(0x1004);
+  index.Add(Code(0x2000), Method(2));
+  index.Reset(std::vector<JitCodeIndex::Entry>());
+  EXPECT_EQ(nullptr, index.Lookup(0x1004));
+  // The replaced snapshots stay alive until taken.
+  EXPECT_EQ(Method(1), entry->method);
+  EXPECT_NE(0u, index.RetiredBytes());
+  JitCodeIndex::RetiredSnapshots retired = index.TakeRetired();
+  EXPECT_EQ(3u, retired.size());
+  EXPECT_EQ(0u, index.RetiredBytes());
+  EXPECT_TRUE(index.TakeRetired().empty());
+}
+
+}  // namespace jit
+}  // namespace art
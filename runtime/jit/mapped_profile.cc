@@ -0,0 +1,309 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mapped_profile.h"
+
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+#include "android-base/file.h"
+#include "base/scoped_flock.h"
+#include "base/systrace.h"
+#include "base/unix_file/fd_file.h"
+#include "dex_file.h"
+
+namespace art {
+
+static_assert(sizeof(MappedProfile::Header) == 16, "Unexpected MappedProfile::Header size");
+static_assert(sizeof(MappedProfile::DexFileEntry) == 36,
+              "Unexpected MappedProfile::DexFileEntry size");
+static_assert(sizeof(MappedProfile::MethodEntry) == 12,
+              "Unexpected MappedProfile::MethodEntry size");
+static_assert(sizeof(MappedProfile::BranchEntry) == 8,
+              "Unexpected MappedProfile::BranchEntry size");
+static_assert(sizeof(MappedProfile::InlineCacheEntry) == 8,
+              "Unexpected MappedProfile::InlineCacheEntry size");
+static_assert(sizeof(MappedProfile::ClassEntry) == 4,
+              "Unexpected MappedProfile::ClassEntry size");
+
+MappedProfile::MappedProfile(std::unique_ptr<MemMap>&& map, std::vector<uint8_t>&& data)
+    : map_(std::move(map)),
+      data_(std::move(data)),
+      begin_(map_ != nullptr ? map_->Begin() : data_.data()),
+      size_(map_ != nullptr ? map_->Size() : data_.size()) {}
+
+// Lock the profile file like ProfileCompilationInfo::Load, so that a concurrent save does not
+// hand out a partially written profile.
+static ScopedFlock LockProfile(const std::string& filename, std::string* error_msg) {
+  ScopedFlock profile_file = LockedFile::Open(filename.c_str(),
+                                              O_RDONLY | O_NOFOLLOW | O_CLOEXEC,
+                                              /*block*/false,
+                                              error_msg);
+  if (profile_file.get() == nullptr) {
+    *error_msg = "Couldn't lock the profile file " + filename + ": " + *error_msg;
+  }
+  return profile_file;
+}
+
+std::unique_ptr<MappedProfile> MappedProfile::Open(const std::string& filename,
+                                                   std::string* error_msg) {
+  ScopedTrace trace(__PRETTY_FUNCTION__);
+  ScopedFlock profile_file = LockProfile(filename, error_msg);
+  if (profile_file.get() == nullptr) {
+    return nullptr;
+  }
+  int64_t length = profile_file->GetLength();
+  if (length < static_cast<int64_t>(sizeof(Header))) {
+    *error_msg = "Profile " + filename + " is too small";
+    return nullptr;
+  }
+  std::unique_ptr<MemMap> map(MemMap::MapFile(length,
+                                              PROT_READ,
+                                              MAP_PRIVATE,
+                                              profile_file->Fd(),
+                                              /*start*/ 0,
+                                              /*low_4gb*/ false,
+                                              filename.c_str(),
+                                              error_msg));
+  if (map == nullptr) {
+    *error_msg = "Failed to mmap profile " + filename + ": " + *error_msg;
+    return nullptr;
+  }
+  std::unique_ptr<MappedProfile> profile(
+      new MappedProfile(std::move(map), std::vector<uint8_t>()));
+  if (!profile->Verify(error_msg)) {
+    *error_msg = "Invalid profile " + filename + ": " + *error_msg;
+    return nullptr;
+  }
+  return profile;
+}
+
+std::unique_ptr<MappedProfile> MappedProfile::Read(const std::string& filename,
+                                                   std::string* error_msg) {
+  ScopedTrace trace(__PRETTY_FUNCTION__);
+  ScopedFlock profile_file = LockProfile(filename, error_msg);
+  if (profile_file.get() == nullptr) {
+    return nullptr;
+  }
+  int64_t length = profile_file->GetLength();
+  if (length < static_cast<int64_t>(sizeof(Header))) {
+    *error_msg = "Profile " + filename + " is too small";
+    return nullptr;
+  }
+  std::vector<uint8_t> data(length);
+  if (!android::base::ReadFully(profile_file->Fd(), data.data(), data.size())) {
+    *error_msg = "Could not read profile " + filename;
+    return nullptr;
+  }
+  std::unique_ptr<MappedProfile> profile = Create(std::move(data), error_msg);
+  if (profile == nullptr) {
+    *error_msg = "Invalid profile " + filename + ": " + *error_msg;
+  }
+  return profile;
+}
+
+std::unique_ptr<MappedProfile> MappedProfile::Create(std::vector<uint8_t>&& data,
+                                                     std::string* error_msg) {
+  if (data.size() < sizeof(Header)) {
+    *error_msg = "Profile is too small";
+    return nullptr;
+  }
+  std::unique_ptr<MappedProfile> profile(new MappedProfile(nullptr, std::move(data)));
+  if (!profile->Verify(error_msg)) {
+    return nullptr;
+  }
+  return profile;
+}
+
+bool MappedProfile::IsMappableVersion(const uint8_t* version) {
+  return memcmp(version,
+                ProfileCompilationInfo::kProfileVersion,
+                sizeof(Header::version)) == 0;
+}
+
+template <typename T>
+bool MappedProfile::IsArrayInBounds(uint32_t offset, uint64_t count) const {
+  return IsAlignedParam(offset, alignof(T)) &&
+      offset <= size_ &&
+      count * sizeof(T) <= size_ - offset;
+}
+
+bool MappedProfile::Verify(std::string* error_msg) const {
+  if (!IsAlignedParam(begin_, alignof(Header))) {
+    *error_msg = "Misaligned profile";
+    return false;
+  }
+  const Header& header = GetHeader();
+  if (memcmp(header.magic, ProfileCompilationInfo::kProfileMagic, sizeof(header.magic)) != 0) {
+    *error_msg = "Profile missing magic";
+    return false;
+  }
+  if (!IsMappableVersion(header.version)) {
+    *error_msg = "Profile version mismatch";
+    return false;
+  }
+  if (header.size != size_) {
+    *error_msg = "Profile size mismatch: " + std::to_string(header.size) + " vs " +
+        std::to_string(size_);
+    return false;
+  }
+  if (header.number_of_dex_files > std::numeric_limits<uint8_t>::max() ||
+      !IsArrayInBounds<DexFileEntry>(sizeof(Header), header.number_of_dex_files)) {
+    *error_msg = "Invalid number of dex files " + std::to_string(header.number_of_dex_files);
+    return false;
+  }
+  for (const DexFileEntry& dex_file : GetDexFiles()) {
+    if (dex_file.profile_key_size == 0 ||
+        dex_file.profile_key_size >= PATH_MAX ||
+        !IsArrayInBounds<char>(dex_file.profile_key_offset, dex_file.profile_key_size)) {
+      *error_msg = "Invalid profile key";
+      return false;
+    }
+    if (!IsArrayInBounds<uint8_t>(dex_file.bitmap_offset,
+                                  GetBitmapSize(dex_file.num_method_ids))) {
+      *error_msg = "Invalid method bitmap";
+      return false;
+    }
+    if (!IsArrayInBounds<uint16_t>(dex_file.classes_offset, dex_file.number_of_classes)) {
+      *error_msg = "Invalid classes";
+      return false;
+    }
+    ArrayRef<const uint16_t> classes = GetClasses(dex_file);
+    if (std::adjacent_find(classes.begin(), classes.end(), std::greater_equal<uint16_t>()) !=
+        classes.end()) {
+      *error_msg = "Unsorted classes";
+      return false;
+    }
+    if (!IsArrayInBounds<MethodEntry>(dex_file.methods_offset, dex_file.number_of_methods)) {
+      *error_msg = "Invalid methods";
+      return false;
+    }
+    ArrayRef<const MethodEntry> methods = GetMethods(dex_file);
+    for (size_t i = 0; i < methods.size(); ++i) {
+      const MethodEntry& method = methods[i];
+      if (method.method_index >= dex_file.num_method_ids ||
+          (i != 0 && method.method_index <= methods[i - 1].method_index)) {
+        *error_msg = "Invalid or unsorted method index " + std::to_string(method.method_index);
+        return false;
+      }
+      if (method.number_of_branches == 0 && method.number_of_inline_caches == 0) {
+        continue;
+      }
+      if (!IsArrayInBounds<BranchEntry>(method.data_offset, method.number_of_branches) ||
+          !IsArrayInBounds<InlineCacheEntry>(
+              method.data_offset + method.number_of_branches * sizeof(BranchEntry),
+              method.number_of_inline_caches)) {
+        *error_msg = "Invalid method data";
+        return false;
+      }
+      for (const InlineCacheEntry& inline_cache : GetInlineCaches(method)) {
+        if (inline_cache.kind > kInlineCacheMegamorphic ||
+            (inline_cache.kind != kInlineCacheClasses && inline_cache.number_of_classes != 0) ||
+            !IsArrayInBounds<ClassEntry>(inline_cache.classes_offset,
+                                         inline_cache.number_of_classes)) {
+          *error_msg = "Invalid inline cache at dex pc " + std::to_string(inline_cache.dex_pc);
+          return false;
+        }
+        for (const ClassEntry& class_entry : GetClasses(inline_cache)) {
+          if (class_entry.dex_profile_index >= header.number_of_dex_files) {
+            *error_msg = "dex_profile_index out of bounds " +
+                std::to_string(class_entry.dex_profile_index);
+            return false;
+          }
+        }
+      }
+    }
+  }
+  return true;
+}
+
+const MappedProfile::DexFileEntry* MappedProfile::FindDexFile(const std::string& profile_key,
+                                                              uint32_t checksum) const {
+  for (const DexFileEntry& dex_file : GetDexFiles()) {
+    if (dex_file.checksum == checksum &&
+        dex_file.profile_key_size == profile_key.size() &&
+        memcmp(begin_ + dex_file.profile_key_offset, profile_key.data(), profile_key.size()) == 0) {
+      return &dex_file;
+    }
+  }
+  return nullptr;
+}
+
+const MappedProfile::MethodEntry* MappedProfile::FindMethod(const DexFileEntry& dex_file,
+                                                            uint16_t method_index) const {
+  ArrayRef<const MethodEntry> methods = GetMethods(dex_file);
+  auto it = std::lower_bound(methods.begin(),
+                             methods.end(),
+                             method_index,
+                             [](const MethodEntry& method, uint16_t index) {
+                               return method.method_index < index;
+                             });
+  return (it != methods.end() && it->method_index == method_index) ? &*it : nullptr;
+}
+
+ProfileCompilationInfo::MethodHotness MappedProfile::GetMethodHotness(
+    const DexFileEntry& dex_file, uint16_t method_index) const {
+  using Hotness = ProfileCompilationInfo::MethodHotness;
+  Hotness hotness;
+  if (method_index >= dex_file.num_method_ids) {
+    return hotness;
+  }
+  ArrayRef<const uint8_t> bitmap = GetBitmap(dex_file);
+  auto load_bit = [&](size_t bit_index) {
+    return (bitmap[bit_index / kBitsPerByte] & (1u << (bit_index % kBitsPerByte))) != 0;
+  };
+  if (load_bit(method_index)) {
+    hotness.AddFlag(Hotness::kFlagStartup);
+  }
+  if (load_bit(dex_file.num_method_ids + method_index)) {
+    hotness.AddFlag(Hotness::kFlagPostStartup);
+  }
+  if (FindMethod(dex_file, method_index) != nullptr) {
+    hotness.AddFlag(Hotness::kFlagHot);
+  }
+  return hotness;
+}
+
+ProfileCompilationInfo::MethodHotness MappedProfile::GetMethodHotness(
+    const MethodReference& method_ref) const {
+  const DexFileEntry* dex_file = FindDexFile(
+      ProfileCompilationInfo::GetProfileDexFileKey(method_ref.dex_file->GetLocation()),
+      method_ref.dex_file->GetLocationChecksum());
+  if (dex_file == nullptr) {
+    return ProfileCompilationInfo::MethodHotness();
+  }
+  return GetMethodHotness(*dex_file, method_ref.dex_method_index);
+}
+
+bool MappedProfile::ContainsClass(const DexFileEntry& dex_file, dex::TypeIndex type_index) const {
+  ArrayRef<const uint16_t> classes = GetClasses(dex_file);
+  return std::binary_search(classes.begin(), classes.end(), type_index.index_);
+}
+
+uint32_t MappedProfile::GetNumberOfMethods() const {
+  uint32_t total = 0;
+  for (const DexFileEntry& dex_file : GetDexFiles()) {
+    total += dex_file.number_of_methods;
+  }
+  return total;
+}
+
+}  // namespace art
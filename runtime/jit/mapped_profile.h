@@ -0,0 +1,235 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_JIT_MAPPED_PROFILE_H_
+#define ART_RUNTIME_JIT_MAPPED_PROFILE_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/array_ref.h"
+#include "base/bit_utils.h"
+#include "base/macros.h"
+#include "dex_file_types.h"
+#include "globals.h"
+#include "mem_map.h"
+#include "method_reference.h"
+#include "profile_compilation_info.h"
+
+namespace art {
+
+/**
+ * Read-only view of a profile in the mappable format (ProfileCompilationInfo::kProfileVersion),
+ * which is queried in place instead of being parsed into ProfileCompilationInfo maps.
+ *
+ * The profile is a sequence of sections addressed by offsets from its start. All fields use
+ * the native (little-endian) byte order and are naturally aligned, and every array is sorted by
+ * its first field so that lookups are binary searches:
+ *
+ *    Header
+ *    DexFileEntry[number_of_dex_files]       in profile index order
+ *    per dex file:
+ *        profile key                         not null terminated
+ *        startup/post startup bitmap         as DexFileData::bitmap_storage
+ *        uint16_t type_index[number_of_classes]
+ *        MethodEntry[number_of_methods]      the hot methods
+ *        per method with branches or inline caches:
+ *            BranchEntry[number_of_branches]
+ *            InlineCacheEntry[number_of_inline_caches]
+ *            ClassEntry[number_of_classes]   per inline cache
+ *
+ * Sections start at 4-byte aligned offsets.
+ */
+class MappedProfile {
+ public:
+  struct Header {
+    uint8_t magic[4];
+    uint8_t version[4];
+    uint32_t number_of_dex_files;
+    // Size of the profile in bytes, header included.
+    uint32_t size;
+  };
+
+  struct DexFileEntry {
+    uint32_t checksum;
+    uint32_t num_method_ids;
+    uint32_t profile_key_offset;
+    uint32_t profile_key_size;
+    uint32_t bitmap_offset;
+    uint32_t methods_offset;
+    uint32_t number_of_methods;
+    uint32_t classes_offset;
+    uint32_t number_of_classes;
+  };
+
+  struct MethodEntry {
+    uint16_t method_index;
+    uint16_t number_of_branches;
+    uint16_t number_of_inline_caches;
+    uint16_t padding;
+    // Offset of the branches, followed by the inline caches. Zero if there are neither.
+    uint32_t data_offset;
+  };
+
+  struct BranchEntry {
+    uint16_t dex_pc;
+    uint16_t taken;
+    uint16_t not_taken;
+    uint16_t padding;
+  };
+
+  enum InlineCacheKind : uint8_t {
+    kInlineCacheClasses = 0,
+    kInlineCacheMissingTypes = 1,
+    kInlineCacheMegamorphic = 2,
+  };
+
+  struct InlineCacheEntry {
+    uint16_t dex_pc;
+    uint8_t kind;
+    uint8_t number_of_classes;
+    // Offset of the classes, only set for kInlineCacheClasses.
+    uint32_t classes_offset;
+  };
+
+  struct ClassEntry {
+    // Index of the owning dex file in the DexFileEntry table.
+    uint8_t dex_profile_index;
+    uint8_t padding;
+    uint16_t type_index;
+  };
+
+  // Map the profile `filename`. The file must not be truncated or rewritten while the
+  // profile is in use, use Read for profiles that may be saved again.
+  static std::unique_ptr<MappedProfile> Open(const std::string& filename,
+                                             std::string* error_msg);
+
+  // Read the profile `filename` into memory, without parsing it. The delta log of the
+  // profile, if any, is ignored.
+  static std::unique_ptr<MappedProfile> Read(const std::string& filename,
+                                             std::string* error_msg);
+
+  // Take ownership of a profile in the mappable format, for instance as written by
+  // ProfileCompilationInfo::Serialize.
+  static std::unique_ptr<MappedProfile> Create(std::vector<uint8_t>&& data,
+                                               std::string* error_msg);
+
+  // Return whether `version` is the version of the mappable format.
+  static bool IsMappableVersion(const uint8_t* version);
+
+  const uint8_t* Begin() const {
+    return begin_;
+  }
+
+  size_t Size() const {
+    return size_;
+  }
+
+  ArrayRef<const DexFileEntry> GetDexFiles() const {
+    return ArrayRef<const DexFileEntry>(
+        reinterpret_cast<const DexFileEntry*>(begin_ + sizeof(Header)),
+        GetHeader().number_of_dex_files);
+  }
+
+  // Return the entry of the dex file with the given profile key and checksum, or null.
+  const DexFileEntry* FindDexFile(const std::string& profile_key, uint32_t checksum) const;
+
+  std::string GetProfileKey(const DexFileEntry& dex_file) const {
+    return std::string(reinterpret_cast<const char*>(begin_ + dex_file.profile_key_offset),
+                       dex_file.profile_key_size);
+  }
+
+  ArrayRef<const uint8_t> GetBitmap(const DexFileEntry& dex_file) const {
+    return ArrayRef<const uint8_t>(begin_ + dex_file.bitmap_offset,
+                                   GetBitmapSize(dex_file.num_method_ids));
+  }
+
+  ArrayRef<const uint16_t> GetClasses(const DexFileEntry& dex_file) const {
+    return GetArray<uint16_t>(dex_file.classes_offset, dex_file.number_of_classes);
+  }
+
+  ArrayRef<const MethodEntry> GetMethods(const DexFileEntry& dex_file) const {
+    return GetArray<MethodEntry>(dex_file.methods_offset, dex_file.number_of_methods);
+  }
+
+  ArrayRef<const BranchEntry> GetBranches(const MethodEntry& method) const {
+    return GetArray<BranchEntry>(method.data_offset, method.number_of_branches);
+  }
+
+  ArrayRef<const InlineCacheEntry> GetInlineCaches(const MethodEntry& method) const {
+    return GetArray<InlineCacheEntry>(
+        method.data_offset + method.number_of_branches * sizeof(BranchEntry),
+        method.number_of_inline_caches);
+  }
+
+  ArrayRef<const ClassEntry> GetClasses(const InlineCacheEntry& inline_cache) const {
+    return GetArray<ClassEntry>(inline_cache.classes_offset, inline_cache.number_of_classes);
+  }
+
+  // Return the entry of the hot method `method_index`, or null.
+  const MethodEntry* FindMethod(const DexFileEntry& dex_file, uint16_t method_index) const;
+
+  // Return the hotness flags of the method. The inline caches are not part of the result, they
+  // are available through FindMethod.
+  ProfileCompilationInfo::MethodHotness GetMethodHotness(const DexFileEntry& dex_file,
+                                                         uint16_t method_index) const;
+  ProfileCompilationInfo::MethodHotness GetMethodHotness(const MethodReference& method_ref) const;
+
+  bool ContainsClass(const DexFileEntry& dex_file, dex::TypeIndex type_index) const;
+
+  // Return the number of hot methods over all dex files.
+  uint32_t GetNumberOfMethods() const;
+
+  // Size in bytes of the startup/post startup bitmap of a dex file.
+  static size_t GetBitmapSize(uint32_t num_method_ids) {
+    return RoundUp(num_method_ids * kNumberOfBitmaps, kBitsPerByte) / kBitsPerByte;
+  }
+
+  // Number of bitmaps of a dex file, startup then post startup.
+  static constexpr size_t kNumberOfBitmaps = 2;
+
+ private:
+  MappedProfile(std::unique_ptr<MemMap>&& map, std::vector<uint8_t>&& data);
+
+  // Check that all offsets, sizes and indexes are in bounds and that the arrays are sorted.
+  bool Verify(std::string* error_msg) const;
+
+  // Return whether an array of `count` elements of T at `offset` is aligned and in bounds.
+  template <typename T>
+  bool IsArrayInBounds(uint32_t offset, uint64_t count) const;
+
+  template <typename T>
+  ArrayRef<const T> GetArray(uint32_t offset, size_t count) const {
+    return ArrayRef<const T>(reinterpret_cast<const T*>(begin_ + offset), count);
+  }
+
+  const Header& GetHeader() const {
+    return *reinterpret_cast<const Header*>(begin_);
+  }
+
+  // Exactly one of map_ and data_ holds the profile.
+  std::unique_ptr<MemMap> map_;
+  std::vector<uint8_t> data_;
+  const uint8_t* begin_;
+  size_t size_;
+
+  DISALLOW_COPY_AND_ASSIGN(MappedProfile);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_JIT_MAPPED_PROFILE_H_
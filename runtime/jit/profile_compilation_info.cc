@@ -38,6 +38,7 @@
 #include "base/stl_util.h"
 #include "base/systrace.h"
 #include "base/unix_file/fd_file.h"
+#include "jit/mapped_profile.h"
 #include "jit/profiling_info.h"
 #include "os.h"
 #include "safe_map.h"
@@ -47,11 +48,19 @@
 namespace art {
 
 const uint8_t ProfileCompilationInfo::kProfileMagic[] = { 'p', 'r', 'o', '\0' };
-// Last profile version: update the multidex separator.
-const uint8_t ProfileCompilationInfo::kProfileVersion[] = { '0', '0', '9', '\0' };
+// Last profile version: uncompressed sections that MappedProfile can query in place.
+const uint8_t ProfileCompilationInfo::kProfileVersion[] = { '0', '1', '1', '\0' };
+// Previous profile version, still loaded: zipped and delta encoded, with the branch profiles.
+const uint8_t ProfileCompilationInfo::kProfileVersionCompressed[] = { '0', '1', '0', '\0' };
 
 static constexpr uint16_t kMaxDexFileKeyLength = PATH_MAX;
 
+// Alignment of the sections of the mappable profile format.
+static constexpr size_t kMappedSectionAlignment = 4;
+
+// Suffix of the append-only log that holds the profile data saved since the last full write.
+static constexpr const char* kDeltaLogSuffix = ".delta";
+
 // Debug flag to ignore checksums when testing if a method or a class is present in the profile.
 // Used to facilitate testing profile guided compilation across a large number of apps
 // using the same test profile.
@@ -124,6 +133,18 @@ void ProfileCompilationInfo::DexPcData::AddClass(uint16_t dex_profile_idx,
 // Note: this is OK because we don't store profiles of different apps into the same file.
 // Apps with split apks don't cause trouble because each split has a different name and will not
 // collide with other entries.
+void ProfileCompilationInfo::BranchData::Add(uint16_t taken_count, uint16_t not_taken_count) {
+  uint32_t new_taken = static_cast<uint32_t>(taken) + taken_count;
+  uint32_t new_not_taken = static_cast<uint32_t>(not_taken) + not_taken_count;
+  while (new_taken > std::numeric_limits<uint16_t>::max() ||
+         new_not_taken > std::numeric_limits<uint16_t>::max()) {
+    new_taken >>= 1;
+    new_not_taken >>= 1;
+  }
+  taken = static_cast<uint16_t>(new_taken);
+  not_taken = static_cast<uint16_t>(new_not_taken);
+}
+
 std::string ProfileCompilationInfo::GetProfileDexFileKey(const std::string& dex_location) {
   DCHECK(!dex_location.empty());
   size_t last_sep_index = dex_location.find_last_of('/');
@@ -194,7 +215,7 @@ bool ProfileCompilationInfo::Load(const std::string& filename, bool clear_if_inv
 
   ProfileLoadSatus status = LoadInternal(fd, &error);
   if (status == kProfileLoadSuccess) {
-    return true;
+    return MergeDeltaLog(filename);
   }
 
   if (clear_if_invalid &&
@@ -202,7 +223,8 @@ bool ProfileCompilationInfo::Load(const std::string& filename, bool clear_if_inv
     LOG(WARNING) << "Clearing bad or obsolete profile data from file "
                  << filename << ": " << error;
     if (profile_file->ClearContent()) {
-      return true;
+      // The records of the delta log are self-contained, they are still worth keeping.
+      return MergeDeltaLog(filename);
     } else {
       PLOG(WARNING) << "Could not clear profile file: " << filename;
       return false;
@@ -213,6 +235,101 @@ bool ProfileCompilationInfo::Load(const std::string& filename, bool clear_if_inv
   return false;
 }
 
+std::string ProfileCompilationInfo::GetDeltaLogFilename(const std::string& filename) {
+  return filename + kDeltaLogSuffix;
+}
+
+bool ProfileCompilationInfo::MergeDeltaLog(const std::string& filename) {
+  std::string log_filename = GetDeltaLogFilename(filename);
+  if (!OS::FileExists(log_filename.c_str())) {
+    return true;
+  }
+  std::string error;
+  ScopedFlock log_file = LockedFile::Open(log_filename.c_str(),
+                                          O_RDONLY | O_NOFOLLOW | O_CLOEXEC,
+                                          /*block*/false,
+                                          &error);
+  if (log_file.get() == nullptr) {
+    // Do not return partial data: a save of it would clear the log.
+    LOG(WARNING) << "Couldn't lock the profile delta log " << log_filename << ": " << error;
+    return false;
+  }
+  int fd = log_file->Fd();
+  int64_t log_size = log_file->GetLength();
+  uint32_t number_of_records = 0;
+  while (lseek(fd, 0, SEEK_CUR) < log_size) {
+    // Each record is a complete profile, as written by Save(int fd).
+    ProfileCompilationInfo record(arena_.GetArenaPool());
+    ProfileLoadSatus status = record.LoadInternal(fd, &error, /*allow_trailing_data*/ true);
+    if (status != kProfileLoadSuccess || !MergeWith(record)) {
+      // A save interrupted mid-way leaves a torn record at the end of the log. Keep what was
+      // merged so far; the next full save drops the rest.
+      LOG(WARNING) << "Ignoring the profile delta log " << log_filename << " after "
+                   << number_of_records << " records: " << error;
+      break;
+    }
+    number_of_records++;
+  }
+  VLOG(profiler) << "Merged " << number_of_records << " records from " << log_filename;
+  return true;
+}
+
+bool ProfileCompilationInfo::ClearDeltaLog(const std::string& filename) {
+  std::string log_filename = GetDeltaLogFilename(filename);
+  if (!OS::FileExists(log_filename.c_str())) {
+    return true;
+  }
+  std::string error;
+  ScopedFlock log_file = LockedFile::Open(log_filename.c_str(),
+                                          O_WRONLY | O_NOFOLLOW | O_CLOEXEC,
+                                          /*block*/false,
+                                          &error);
+  if (log_file.get() == nullptr) {
+    LOG(WARNING) << "Couldn't lock the profile delta log " << log_filename << ": " << error;
+    return false;
+  }
+  if (!log_file->ClearContent()) {
+    PLOG(WARNING) << "Could not clear the profile delta log: " << log_filename;
+    return false;
+  }
+  return true;
+}
+
+bool ProfileCompilationInfo::AppendToDeltaLog(const std::string& filename,
+                                              uint64_t* bytes_written) {
+  ScopedTrace trace(__PRETTY_FUNCTION__);
+  std::string error;
+  std::string log_filename = GetDeltaLogFilename(filename);
+  int flags = O_WRONLY | O_CREAT | O_APPEND | O_NOFOLLOW | O_CLOEXEC;
+  ScopedFlock log_file = LockedFile::Open(log_filename.c_str(), flags, /*block*/false, &error);
+  if (log_file.get() == nullptr) {
+    LOG(WARNING) << "Couldn't lock the profile delta log " << log_filename << ": " << error;
+    return false;
+  }
+
+  int fd = log_file->Fd();
+  off_t start = lseek(fd, 0, SEEK_END);
+  if (start == -1) {
+    PLOG(WARNING) << "Could not seek the profile delta log: " << log_filename;
+    return false;
+  }
+  if (!Save(fd)) {
+    // Cut the torn record so that later appends stay readable.
+    if (TEMP_FAILURE_RETRY(ftruncate(fd, start)) != 0) {
+      PLOG(WARNING) << "Could not truncate the profile delta log: " << log_filename;
+    }
+    VLOG(profiler) << "Failed to append profile info to " << log_filename;
+    return false;
+  }
+  off_t end = lseek(fd, 0, SEEK_CUR);
+  if (bytes_written != nullptr && end != -1) {
+    *bytes_written = static_cast<uint64_t>(end - start);
+  }
+  VLOG(profiler) << "Successfully appended profile info to " << log_filename
+                 << " Size: " << end;
+  return true;
+}
+
 bool ProfileCompilationInfo::Save(const std::string& filename, uint64_t* bytes_written) {
   ScopedTrace trace(__PRETTY_FUNCTION__);
   std::string error;
@@ -239,6 +356,8 @@ bool ProfileCompilationInfo::Save(const std::string& filename, uint64_t* bytes_w
   // access and fail immediately if we can't.
   bool result = Save(fd);
   if (result) {
+    // The base file now holds everything loaded from the log.
+    ClearDeltaLog(filename);
     int64_t size = GetFileSizeBytes(filename);
     if (size != -1) {
       VLOG(profiler)
@@ -296,7 +415,8 @@ static constexpr size_t kLineHeaderSize =
  *        startup/post startup bitmap,
  *    .....]
  * The method_encoding is:
- *    method_id,number_of_inline_caches,inline_cache1,inline_cache2...
+ *    method_id,number_of_inline_caches,inline_cache1,inline_cache2...,
+ *    number_of_branches,branch1,branch2...
  * The inline_cache is:
  *    dex_pc,[M|dex_map_size], dex_profile_index,class_id1,class_id2...,dex_profile_index2,...
  *    dex_map_size is the number of dex_indeces that follows.
@@ -306,8 +426,13 @@ static constexpr size_t kLineHeaderSize =
  *    M stands for megamorphic or missing types and it's encoded as either
  *    the byte kIsMegamorphicEncoding or kIsMissingTypesEncoding.
  *    When present, there will be no class ids following.
+ * The branch is:
+ *    dex_pc,taken_count,not_taken_count
+ *
+ * This is the format of kProfileVersionCompressed. Save writes kProfileVersion, described in
+ * mapped_profile.h.
  **/
-bool ProfileCompilationInfo::Save(int fd) {
+bool ProfileCompilationInfo::SaveCompressed(int fd) {
   uint64_t start = NanoTime();
   ScopedTrace trace(__PRETTY_FUNCTION__);
   DCHECK_GE(fd, 0);
@@ -389,6 +514,7 @@ bool ProfileCompilationInfo::Save(int fd) {
       last_method_index = method_it.first;
       AddUintToBuffer(&buffer, diff_with_last_method_index);
       AddInlineCacheToBuffer(&buffer, method_it.second);
+      AddBranchesToBuffer(&buffer, dex_data.FindBranches(method_it.first));
     }
 
     uint16_t last_class_index = 0;
@@ -429,6 +555,165 @@ bool ProfileCompilationInfo::Save(int fd) {
   return true;
 }
 
+bool ProfileCompilationInfo::Save(int fd) {
+  uint64_t start = NanoTime();
+  ScopedTrace trace(__PRETTY_FUNCTION__);
+  DCHECK_GE(fd, 0);
+
+  std::vector<uint8_t> buffer;
+  if (!Serialize(&buffer)) {
+    return false;
+  }
+  if (!WriteBuffer(fd, buffer.data(), buffer.size())) {
+    return false;
+  }
+  uint64_t total_time = NanoTime() - start;
+  VLOG(profiler) << "Time to save profile of " << std::to_string(buffer.size()) << " bytes: "
+                 << std::to_string(total_time);
+  return true;
+}
+
+// Append a zeroed section of `size` bytes to the buffer and return its aligned offset.
+static uint32_t AppendSection(std::vector<uint8_t>* buffer, size_t size) {
+  size_t offset = RoundUp(buffer->size(), kMappedSectionAlignment);
+  DCHECK_LE(offset + size, std::numeric_limits<uint32_t>::max());
+  buffer->resize(offset + size, 0u);
+  return static_cast<uint32_t>(offset);
+}
+
+template <typename T>
+static void StoreAt(std::vector<uint8_t>* buffer, size_t offset, const T& value) {
+  DCHECK_LE(offset + sizeof(T), buffer->size());
+  memcpy(buffer->data() + offset, &value, sizeof(T));
+}
+
+bool ProfileCompilationInfo::Serialize(std::vector<uint8_t>* buffer) const {
+  ScopedTrace trace(__PRETTY_FUNCTION__);
+  buffer->clear();
+  AppendSection(buffer,
+                sizeof(MappedProfile::Header) + info_.size() * sizeof(MappedProfile::DexFileEntry));
+
+  for (size_t i = 0; i < info_.size(); ++i) {
+    const DexFileData& dex_data = *info_[i];
+    DCHECK_EQ(dex_data.profile_index, i);
+
+    // Note that we allow dex files without any methods or classes, so that
+    // inline caches can refer valid dex files.
+
+    if (dex_data.profile_key.size() >= kMaxDexFileKeyLength) {
+      LOG(WARNING) << "DexFileKey exceeds allocated limit";
+      return false;
+    }
+    MappedProfile::DexFileEntry entry = {};
+    entry.checksum = dex_data.checksum;
+    entry.num_method_ids = dex_data.num_method_ids;
+
+    entry.profile_key_size = dex_data.profile_key.size();
+    entry.profile_key_offset = AppendSection(buffer, dex_data.profile_key.size());
+    std::copy(dex_data.profile_key.begin(),
+              dex_data.profile_key.end(),
+              buffer->begin() + entry.profile_key_offset);
+
+    DCHECK_EQ(dex_data.bitmap_storage.size(),
+              MappedProfile::GetBitmapSize(dex_data.num_method_ids));
+    entry.bitmap_offset = AppendSection(buffer, dex_data.bitmap_storage.size());
+    std::copy(dex_data.bitmap_storage.begin(),
+              dex_data.bitmap_storage.end(),
+              buffer->begin() + entry.bitmap_offset);
+
+    // The sets and maps are ordered, so the arrays come out sorted.
+    entry.number_of_classes = dex_data.class_set.size();
+    entry.classes_offset = AppendSection(buffer, sizeof(uint16_t) * dex_data.class_set.size());
+    size_t class_offset = entry.classes_offset;
+    for (dex::TypeIndex type_index : dex_data.class_set) {
+      StoreAt(buffer, class_offset, type_index.index_);
+      class_offset += sizeof(uint16_t);
+    }
+
+    entry.number_of_methods = dex_data.method_map.size();
+    entry.methods_offset =
+        AppendSection(buffer, sizeof(MappedProfile::MethodEntry) * dex_data.method_map.size());
+    size_t method_offset = entry.methods_offset;
+    for (const auto& method_it : dex_data.method_map) {
+      const InlineCacheMap& inline_caches = method_it.second;
+      const BranchMap* branches = dex_data.FindBranches(method_it.first);
+      MappedProfile::MethodEntry method = {};
+      method.method_index = method_it.first;
+      method.number_of_branches = (branches != nullptr) ? branches->size() : 0u;
+      method.number_of_inline_caches = inline_caches.size();
+      if (method.number_of_branches != 0 || method.number_of_inline_caches != 0) {
+        method.data_offset = AppendSection(
+            buffer,
+            sizeof(MappedProfile::BranchEntry) * method.number_of_branches +
+                sizeof(MappedProfile::InlineCacheEntry) * method.number_of_inline_caches);
+        size_t data_offset = method.data_offset;
+        if (branches != nullptr) {
+          for (const auto& branch_it : *branches) {
+            MappedProfile::BranchEntry branch = {};
+            branch.dex_pc = branch_it.first;
+            branch.taken = branch_it.second.taken;
+            branch.not_taken = branch_it.second.not_taken;
+            StoreAt(buffer, data_offset, branch);
+            data_offset += sizeof(branch);
+          }
+        }
+        for (const auto& inline_cache_it : inline_caches) {
+          const DexPcData& dex_pc_data = inline_cache_it.second;
+          MappedProfile::InlineCacheEntry inline_cache = {};
+          inline_cache.dex_pc = inline_cache_it.first;
+          if (dex_pc_data.is_missing_types) {
+            inline_cache.kind = MappedProfile::kInlineCacheMissingTypes;
+          } else if (dex_pc_data.is_megamorphic) {
+            inline_cache.kind = MappedProfile::kInlineCacheMegamorphic;
+          } else {
+            DCHECK_LT(dex_pc_data.classes.size(), InlineCache::kIndividualCacheSize);
+            inline_cache.kind = MappedProfile::kInlineCacheClasses;
+            inline_cache.number_of_classes = dex_pc_data.classes.size();
+            inline_cache.classes_offset = AppendSection(
+                buffer, sizeof(MappedProfile::ClassEntry) * dex_pc_data.classes.size());
+            size_t class_entry_offset = inline_cache.classes_offset;
+            for (const ClassReference& class_ref : dex_pc_data.classes) {
+              MappedProfile::ClassEntry class_entry = {};
+              class_entry.dex_profile_index = class_ref.dex_profile_index;
+              class_entry.type_index = class_ref.type_index.index_;
+              StoreAt(buffer, class_entry_offset, class_entry);
+              class_entry_offset += sizeof(class_entry);
+            }
+          }
+          StoreAt(buffer, data_offset, inline_cache);
+          data_offset += sizeof(inline_cache);
+        }
+      }
+      StoreAt(buffer, method_offset, method);
+      method_offset += sizeof(method);
+    }
+    StoreAt(buffer,
+            sizeof(MappedProfile::Header) + i * sizeof(MappedProfile::DexFileEntry),
+            entry);
+  }
+
+  // Allow large profiles for non target builds for the case where we are merging many profiles
+  // to generate a boot image profile.
+  if (kIsTargetBuild && buffer->size() > kProfileSizeErrorThresholdInBytes) {
+    LOG(ERROR) << "Profile data size exceeds "
+               << std::to_string(kProfileSizeErrorThresholdInBytes)
+               << " bytes. Profile will not be written to disk.";
+    return false;
+  }
+  if (buffer->size() > kProfileSizeWarningThresholdInBytes) {
+    LOG(WARNING) << "Profile data size exceeds "
+                 << std::to_string(kProfileSizeWarningThresholdInBytes);
+  }
+
+  MappedProfile::Header header;
+  std::copy_n(kProfileMagic, sizeof(header.magic), header.magic);
+  std::copy_n(kProfileVersion, sizeof(header.version), header.version);
+  header.number_of_dex_files = info_.size();
+  header.size = buffer->size();
+  StoreAt(buffer, 0u, header);
+  return true;
+}
+
 void ProfileCompilationInfo::AddInlineCacheToBuffer(std::vector<uint8_t>* buffer,
                                                     const InlineCacheMap& inline_cache_map) {
   // Add inline cache map size.
@@ -485,10 +770,31 @@ void ProfileCompilationInfo::AddInlineCacheToBuffer(std::vector<uint8_t>* buffer
   }
 }
 
+void ProfileCompilationInfo::AddBranchesToBuffer(std::vector<uint8_t>* buffer,
+                                                 const BranchMap* branches) {
+  if (branches == nullptr) {
+    AddUintToBuffer(buffer, static_cast<uint16_t>(0));
+    return;
+  }
+  DCHECK_LE(branches->size(), std::numeric_limits<uint16_t>::max());
+  AddUintToBuffer(buffer, static_cast<uint16_t>(branches->size()));
+  for (const auto& branch_it : *branches) {
+    AddUintToBuffer(buffer, branch_it.first);  // dex_pc
+    AddUintToBuffer(buffer, branch_it.second.taken);
+    AddUintToBuffer(buffer, branch_it.second.not_taken);
+  }
+}
+
 uint32_t ProfileCompilationInfo::GetMethodsRegionSize(const DexFileData& dex_data) {
-  // ((uint16_t)method index + (uint16_t)inline cache size) * number of methods
-  uint32_t size = 2 * sizeof(uint16_t) * dex_data.method_map.size();
+  // ((uint16_t)method index + (uint16_t)inline cache size + (uint16_t)branch count)
+  //     * number of methods
+  uint32_t size = 3 * sizeof(uint16_t) * dex_data.method_map.size();
   for (const auto& method_it : dex_data.method_map) {
+    const BranchMap* branches = dex_data.FindBranches(method_it.first);
+    if (branches != nullptr) {
+      // (uint16_t)dex_pc + (uint16_t)taken + (uint16_t)not taken
+      size += 3 * sizeof(uint16_t) * branches->size();
+    }
     const InlineCacheMap& inline_cache = method_it.second;
     size += sizeof(uint16_t) * inline_cache.size();  // dex_pc
     for (const auto& inline_cache_it : inline_cache) {
@@ -611,6 +917,14 @@ bool ProfileCompilationInfo::AddMethod(const std::string& dex_location,
   // Add the method.
   InlineCacheMap* inline_cache = data->FindOrAddMethod(method_index);
 
+  if (pmi.branches != nullptr && !pmi.branches->empty()) {
+    BranchMap* branches = data->FindOrAddBranches(method_index);
+    for (const auto& branch_it : *pmi.branches) {
+      branches->FindOrAdd(branch_it.first)->second.Add(branch_it.second.taken,
+                                                       branch_it.second.not_taken);
+    }
+  }
+
   if (pmi.inline_caches == nullptr) {
     // If we don't have inline caches return success right away.
     return true;
@@ -673,6 +987,13 @@ bool ProfileCompilationInfo::AddMethod(const ProfileMethodInfo& pmi) {
       dex_pc_data->AddClass(class_dex_data->profile_index, class_ref.type_index);
     }
   }
+
+  if (!pmi.branches.empty()) {
+    BranchMap* branches = data->FindOrAddBranches(pmi.ref.dex_method_index);
+    for (const ProfileMethodInfo::ProfileBranch& branch : pmi.branches) {
+      branches->FindOrAdd(branch.dex_pc)->second.Add(branch.taken, branch.not_taken);
+    }
+  }
   return true;
 }
 
@@ -737,6 +1058,28 @@ bool ProfileCompilationInfo::ReadInlineCache(SafeBuffer& buffer,
   return true;
 }
 
+bool ProfileCompilationInfo::ReadBranches(SafeBuffer& buffer,
+                                          DexFileData* data,
+                                          uint16_t method_index,
+                                          /*out*/ std::string* error) {
+  uint16_t number_of_branches;
+  READ_UINT(uint16_t, buffer, number_of_branches, error);
+  if (number_of_branches == 0) {
+    return true;
+  }
+  BranchMap* branches = data->FindOrAddBranches(method_index);
+  for (; number_of_branches > 0; number_of_branches--) {
+    uint16_t dex_pc;
+    uint16_t taken;
+    uint16_t not_taken;
+    READ_UINT(uint16_t, buffer, dex_pc, error);
+    READ_UINT(uint16_t, buffer, taken, error);
+    READ_UINT(uint16_t, buffer, not_taken, error);
+    branches->FindOrAdd(dex_pc)->second.Add(taken, not_taken);
+  }
+  return true;
+}
+
 bool ProfileCompilationInfo::ReadMethods(SafeBuffer& buffer,
                                          uint8_t number_of_dex_files,
                                          const ProfileLineHeader& line_header,
@@ -761,6 +1104,9 @@ bool ProfileCompilationInfo::ReadMethods(SafeBuffer& buffer,
     if (!ReadInlineCache(buffer, number_of_dex_files, inline_cache, error)) {
       return false;
     }
+    if (!ReadBranches(buffer, data, method_index, error)) {
+      return false;
+    }
   }
   uint32_t total_bytes_read = unread_bytes_before_operation - buffer.CountUnreadBytes();
   if (total_bytes_read != line_header.method_region_size_bytes) {
@@ -870,35 +1216,52 @@ void ProfileCompilationInfo::SafeBuffer::Advance(size_t data_size) {
   ptr_current_ += data_size;
 }
 
+ProfileCompilationInfo::ProfileLoadSatus ProfileCompilationInfo::ReadProfileVersion(
+      int fd,
+      /*out*/bool* is_mappable,
+      /*out*/std::string* error) {
+  SafeBuffer safe_buffer(sizeof(kProfileMagic) + sizeof(kProfileVersion));
+
+  ProfileLoadSatus status = safe_buffer.FillFromFd(fd, "ReadProfileVersion", error);
+  if (status != kProfileLoadSuccess) {
+    return status;
+  }
+
+  if (!safe_buffer.CompareAndAdvance(kProfileMagic, sizeof(kProfileMagic))) {
+    *error = "Profile missing magic";
+    return kProfileLoadVersionMismatch;
+  }
+  if (safe_buffer.CompareAndAdvance(kProfileVersion, sizeof(kProfileVersion))) {
+    *is_mappable = true;
+  } else if (safe_buffer.CompareAndAdvance(kProfileVersionCompressed,
+                                           sizeof(kProfileVersionCompressed))) {
+    *is_mappable = false;
+  } else {
+    *error = "Profile version mismatch";
+    return kProfileLoadVersionMismatch;
+  }
+  return kProfileLoadSuccess;
+}
+
 ProfileCompilationInfo::ProfileLoadSatus ProfileCompilationInfo::ReadProfileHeader(
       int fd,
       /*out*/uint8_t* number_of_dex_files,
       /*out*/uint32_t* uncompressed_data_size,
       /*out*/uint32_t* compressed_data_size,
       /*out*/std::string* error) {
-  // Read magic and version
-  const size_t kMagicVersionSize =
-    sizeof(kProfileMagic) +
-    sizeof(kProfileVersion) +
+  // Read the header following the magic and version.
+  const size_t kHeaderSize =
     sizeof(uint8_t) +  // number of dex files
     sizeof(uint32_t) +  // size of uncompressed profile data
     sizeof(uint32_t);  // size of compressed profile data
 
-  SafeBuffer safe_buffer(kMagicVersionSize);
+  SafeBuffer safe_buffer(kHeaderSize);
 
   ProfileLoadSatus status = safe_buffer.FillFromFd(fd, "ReadProfileHeader", error);
   if (status != kProfileLoadSuccess) {
     return status;
   }
 
-  if (!safe_buffer.CompareAndAdvance(kProfileMagic, sizeof(kProfileMagic))) {
-    *error = "Profile missing magic";
-    return kProfileLoadVersionMismatch;
-  }
-  if (!safe_buffer.CompareAndAdvance(kProfileVersion, sizeof(kProfileVersion))) {
-    *error = "Profile version mismatch";
-    return kProfileLoadVersionMismatch;
-  }
   if (!safe_buffer.ReadUintAndAdvance<uint8_t>(number_of_dex_files)) {
     *error = "Cannot read the number of dex files";
     return kProfileLoadBadData;
@@ -1007,7 +1370,7 @@ bool ProfileCompilationInfo::Load(int fd) {
 
 // TODO(calin): fail fast if the dex checksums don't match.
 ProfileCompilationInfo::ProfileLoadSatus ProfileCompilationInfo::LoadInternal(
-      int fd, std::string* error) {
+      int fd, std::string* error, bool allow_trailing_data) {
   ScopedTrace trace(__PRETTY_FUNCTION__);
   DCHECK_GE(fd, 0);
 
@@ -1025,11 +1388,20 @@ ProfileCompilationInfo::ProfileLoadSatus ProfileCompilationInfo::LoadInternal(
   if (stat_buffer.st_size == 0) {
     return kProfileLoadSuccess;
   }
-  // Read profile header: magic + version + number_of_dex_files.
+  bool is_mappable;
+  ProfileLoadSatus status = ReadProfileVersion(fd, &is_mappable, error);
+  if (status != kProfileLoadSuccess) {
+    return status;
+  }
+  if (is_mappable) {
+    return LoadMappable(fd, error, allow_trailing_data);
+  }
+
+  // Read profile header: number_of_dex_files + data sizes.
   uint8_t number_of_dex_files;
   uint32_t uncompressed_data_size;
   uint32_t compressed_data_size;
-  ProfileLoadSatus status = ReadProfileHeader(fd,
+  status = ReadProfileHeader(fd,
                                               &number_of_dex_files,
                                               &uncompressed_data_size,
                                               &compressed_data_size,
@@ -1056,7 +1428,7 @@ ProfileCompilationInfo::ProfileLoadSatus ProfileCompilationInfo::LoadInternal(
   bool bytes_read_success =
       android::base::ReadFully(fd, compressed_data.get(), compressed_data_size);
 
-  if (testEOF(fd) != 0) {
+  if (!allow_trailing_data && testEOF(fd) != 0) {
     *error += "Unexpected data in the profile file.";
     return kProfileLoadBadData;
   }
@@ -1103,6 +1475,109 @@ ProfileCompilationInfo::ProfileLoadSatus ProfileCompilationInfo::LoadInternal(
   }
 }
 
+ProfileCompilationInfo::ProfileLoadSatus ProfileCompilationInfo::LoadMappable(
+      int fd, std::string* error, bool allow_trailing_data) {
+  // The magic and version are already read, the rest of the header gives the profile size.
+  std::vector<uint8_t> data(sizeof(MappedProfile::Header));
+  std::copy_n(kProfileMagic, sizeof(kProfileMagic), data.begin());
+  std::copy_n(kProfileVersion, sizeof(kProfileVersion), data.begin() + sizeof(kProfileMagic));
+  const size_t kVersionEnd = sizeof(kProfileMagic) + sizeof(kProfileVersion);
+  if (!android::base::ReadFully(fd, data.data() + kVersionEnd, data.size() - kVersionEnd)) {
+    *error += "Profile EOF reached prematurely for ReadProfileHeader";
+    return kProfileLoadBadData;
+  }
+  MappedProfile::Header header;
+  memcpy(&header, data.data(), sizeof(header));
+  if (header.size < sizeof(header)) {
+    *error += "Invalid profile size " + std::to_string(header.size);
+    return kProfileLoadBadData;
+  }
+  // Allow large profiles for non target builds for the case where we are merging many profiles
+  // to generate a boot image profile.
+  if (kIsTargetBuild && header.size > kProfileSizeErrorThresholdInBytes) {
+    LOG(ERROR) << "Profile data size exceeds "
+               << std::to_string(kProfileSizeErrorThresholdInBytes)
+               << " bytes";
+    return kProfileLoadBadData;
+  }
+  if (header.size > kProfileSizeWarningThresholdInBytes) {
+    LOG(WARNING) << "Profile data size exceeds "
+                 << std::to_string(kProfileSizeWarningThresholdInBytes)
+                 << " bytes";
+  }
+
+  data.resize(header.size);
+  if (!android::base::ReadFully(fd, data.data() + sizeof(header), data.size() - sizeof(header))) {
+    *error += "Unable to read profile data";
+    return kProfileLoadBadData;
+  }
+  if (!allow_trailing_data && testEOF(fd) != 0) {
+    *error += "Unexpected data in the profile file.";
+    return kProfileLoadBadData;
+  }
+
+  std::string verify_error;
+  std::unique_ptr<MappedProfile> profile = MappedProfile::Create(std::move(data), &verify_error);
+  if (profile == nullptr) {
+    *error += verify_error;
+    return kProfileLoadBadData;
+  }
+  return LoadMappedProfile(*profile, error);
+}
+
+ProfileCompilationInfo::ProfileLoadSatus ProfileCompilationInfo::LoadMappedProfile(
+      const MappedProfile& profile, /*out*/std::string* error) {
+  ArrayRef<const MappedProfile::DexFileEntry> dex_files = profile.GetDexFiles();
+  // Add all the dex files first, the inline caches may refer to any of them.
+  for (size_t i = 0; i < dex_files.size(); ++i) {
+    std::string profile_key = profile.GetProfileKey(dex_files[i]);
+    DexFileData* data =
+        GetOrAddDexFileData(profile_key, dex_files[i].checksum, dex_files[i].num_method_ids);
+    if (data == nullptr || data->profile_index != i) {
+      *error = "Invalid or duplicate dex file in profile: " + profile_key;
+      return kProfileLoadBadData;
+    }
+  }
+  for (size_t i = 0; i < dex_files.size(); ++i) {
+    const MappedProfile::DexFileEntry& dex_file = dex_files[i];
+    DexFileData* data = info_[i];
+
+    ArrayRef<const uint8_t> bitmap = profile.GetBitmap(dex_file);
+    DCHECK_EQ(bitmap.size(), data->bitmap_storage.size());
+    std::copy(bitmap.begin(), bitmap.end(), data->bitmap_storage.begin());
+
+    for (uint16_t type_index : profile.GetClasses(dex_file)) {
+      // The classes are sorted, hint that each one goes last.
+      data->class_set.insert(data->class_set.end(), dex::TypeIndex(type_index));
+    }
+
+    for (const MappedProfile::MethodEntry& method : profile.GetMethods(dex_file)) {
+      InlineCacheMap* inline_cache = data->FindOrAddMethod(method.method_index);
+      ArrayRef<const MappedProfile::BranchEntry> branches = profile.GetBranches(method);
+      if (!branches.empty()) {
+        BranchMap* branch_map = data->FindOrAddBranches(method.method_index);
+        for (const MappedProfile::BranchEntry& branch : branches) {
+          branch_map->FindOrAdd(branch.dex_pc)->second.Add(branch.taken, branch.not_taken);
+        }
+      }
+      for (const MappedProfile::InlineCacheEntry& entry : profile.GetInlineCaches(method)) {
+        DexPcData* dex_pc_data = FindOrAddDexPc(inline_cache, entry.dex_pc);
+        if (entry.kind == MappedProfile::kInlineCacheMissingTypes) {
+          dex_pc_data->SetIsMissingTypes();
+        } else if (entry.kind == MappedProfile::kInlineCacheMegamorphic) {
+          dex_pc_data->SetIsMegamorphic();
+        } else {
+          for (const MappedProfile::ClassEntry& class_entry : profile.GetClasses(entry)) {
+            dex_pc_data->AddClass(class_entry.dex_profile_index,
+                                  dex::TypeIndex(class_entry.type_index));
+          }
+        }
+      }
+    }
+  }
+  return kProfileLoadSuccess;
+}
+
 std::unique_ptr<uint8_t[]> ProfileCompilationInfo::DeflateBuffer(const uint8_t* in_buffer,
                                                                  uint32_t in_size,
                                                                  uint32_t* compressed_data_size) {
@@ -1231,6 +1706,16 @@ bool ProfileCompilationInfo::MergeWith(const ProfileCompilationInfo& other,
       }
     }
 
+    // Merge the branch profiles.
+    for (const auto& other_branches_it : other_dex_data->branch_map) {
+      BranchMap* branches = dex_data->FindOrAddBranches(other_branches_it.first);
+      for (const auto& other_branch_it : other_branches_it.second) {
+        const BranchData& other_branch = other_branch_it.second;
+        branches->FindOrAdd(other_branch_it.first)->second.Add(other_branch.taken,
+                                                               other_branch.not_taken);
+      }
+    }
+
     // Merge the method bitmaps.
     dex_data->MergeBitmap(*other_dex_data);
   }
@@ -1283,6 +1768,10 @@ std::unique_ptr<ProfileCompilationInfo::OfflineProfileMethodInfo> ProfileCompila
   const InlineCacheMap* inline_caches = hotness.GetInlineCacheMap();
   DCHECK(inline_caches != nullptr);
   std::unique_ptr<OfflineProfileMethodInfo> pmi(new OfflineProfileMethodInfo(inline_caches));
+  const DexFileData* method_dex_data = FindDexData(GetProfileDexFileKey(dex_location),
+                                                   dex_checksum);
+  DCHECK(method_dex_data != nullptr);
+  pmi->branches = method_dex_data->FindBranches(dex_method_index);
 
   pmi->dex_references.resize(info_.size());
   for (const DexFileData* dex_data : info_) {
@@ -1304,6 +1793,10 @@ bool ProfileCompilationInfo::ContainsClass(const DexFile& dex_file, dex::TypeInd
   return false;
 }
 
+bool ProfileCompilationInfo::ContainsDexFile(const DexFile& dex_file) const {
+  return FindDexData(&dex_file) != nullptr;
+}
+
 uint32_t ProfileCompilationInfo::GetNumberOfMethods() const {
   uint32_t total = 0;
   for (const DexFileData* dex_data : info_) {
@@ -1390,7 +1883,17 @@ std::string ProfileCompilationInfo::DumpInfo(const std::vector<const DexFile*>*
         }
         os << "}";
       }
-      os << "], ";
+      os << "]";
+      const BranchMap* branches = dex_data->FindBranches(method_it.first);
+      if (branches != nullptr) {
+        os << "<";
+        for (const auto& branch_it : *branches) {
+          os << "{" << std::hex << branch_it.first << std::dec << ":"
+             << branch_it.second.taken << "/" << branch_it.second.not_taken << "}";
+        }
+        os << ">";
+      }
+      os << ", ";
     }
     bool startup = true;
     while (true) {
@@ -1447,6 +1950,27 @@ bool ProfileCompilationInfo::GetClassesAndMethods(
   return true;
 }
 
+bool ProfileCompilationInfo::GetMethodFlagsAndClasses(
+    const DexFile& dex_file,
+    /*out*/std::vector<std::pair<uint16_t, uint8_t>>* method_flags,
+    /*out*/std::vector<dex::TypeIndex>* classes) const {
+  method_flags->clear();
+  classes->clear();
+  const DexFileData* dex_data = FindDexData(&dex_file);
+  if (dex_data == nullptr) {
+    return false;
+  }
+  for (uint32_t method_idx = 0; method_idx < dex_data->num_method_ids; ++method_idx) {
+    MethodHotness hotness = dex_data->GetHotnessInfo(method_idx);
+    if (hotness.IsInProfile()) {
+      method_flags->emplace_back(static_cast<uint16_t>(method_idx),
+                                 hotness.GetFlags());
+    }
+  }
+  classes->assign(dex_data->class_set.begin(), dex_data->class_set.end());
+  return true;
+}
+
 bool ProfileCompilationInfo::Equals(const ProfileCompilationInfo& other) {
   // No need to compare profile_key_map_. That's only a cache for fast search.
   // All the information is already in the info_ vector.
@@ -1574,6 +2098,13 @@ bool ProfileCompilationInfo::OfflineProfileMethodInfo::operator==(
   if (inline_caches->size() != other.inline_caches->size()) {
     return false;
   }
+  // A missing branch profile is the same as an empty one.
+  bool has_branches = branches != nullptr && !branches->empty();
+  bool other_has_branches = other.branches != nullptr && !other.branches->empty();
+  if (has_branches != other_has_branches ||
+      (has_branches && *branches != *other.branches)) {
+    return false;
+  }
 
   // We can't use a simple equality test because we need to match the dex files
   // of the inline caches which might have different profile indexes.
@@ -1622,6 +2153,19 @@ ProfileCompilationInfo::DexFileData::FindOrAddMethod(uint16_t method_index) {
       InlineCacheMap(std::less<uint16_t>(), arena_->Adapter(kArenaAllocProfile)))->second);
 }
 
+ProfileCompilationInfo::BranchMap*
+ProfileCompilationInfo::DexFileData::FindOrAddBranches(uint16_t method_index) {
+  return &(branch_map.FindOrAdd(
+      method_index,
+      BranchMap(std::less<uint16_t>(), arena_->Adapter(kArenaAllocProfile)))->second);
+}
+
+const ProfileCompilationInfo::BranchMap*
+ProfileCompilationInfo::DexFileData::FindBranches(uint16_t method_index) const {
+  auto it = branch_map.find(method_index);
+  return it != branch_map.end() ? &it->second : nullptr;
+}
+
 // Mark a method as executed at least once.
 bool ProfileCompilationInfo::DexFileData::AddMethod(MethodHotness::Flag flags, size_t index) {
   if (index >= num_method_ids) {
@@ -33,6 +33,8 @@
 
 namespace art {
 
+class MappedProfile;
+
 /**
  *  Convenient class to pass around profile information (including inline caches)
  *  without the need to hold GC-able objects.
@@ -49,6 +51,15 @@ struct ProfileMethodInfo {
     const std::vector<TypeReference> classes;
   };
 
+  struct ProfileBranch {
+    ProfileBranch(uint32_t pc, uint16_t taken_count, uint16_t not_taken_count)
+        : dex_pc(pc), taken(taken_count), not_taken(not_taken_count) {}
+
+    const uint32_t dex_pc;
+    const uint16_t taken;
+    const uint16_t not_taken;
+  };
+
   explicit ProfileMethodInfo(MethodReference reference) : ref(reference) {}
 
   ProfileMethodInfo(MethodReference reference, const std::vector<ProfileInlineCache>& caches)
@@ -57,6 +68,7 @@ struct ProfileMethodInfo {
 
   MethodReference ref;
   std::vector<ProfileInlineCache> inline_caches;
+  std::vector<ProfileBranch> branches;
 };
 
 /**
@@ -69,7 +81,10 @@ struct ProfileMethodInfo {
 class ProfileCompilationInfo {
  public:
   static const uint8_t kProfileMagic[];
+  // The version written by Save, in the format read by MappedProfile.
   static const uint8_t kProfileVersion[];
+  // The previous, compressed version. It is still loaded, and saving it again converts it.
+  static const uint8_t kProfileVersionCompressed[];
 
   // Data structures for encoding the offline representation of inline caches.
   // This is exposed as public in order to make it available to dex2oat compilations
@@ -168,6 +183,25 @@ class ProfileCompilationInfo {
   // Maps a method dex index to its inline cache.
   using MethodMap = ArenaSafeMap<uint16_t, InlineCacheMap>;
 
+  // How many times a conditional branch was taken and not taken. The counts saturate by
+  // halving both of them, which keeps their ratio.
+  struct BranchData {
+    BranchData() : taken(0), not_taken(0) {}
+    void Add(uint16_t taken_count, uint16_t not_taken_count);
+    bool operator==(const BranchData& other) const {
+      return taken == other.taken && not_taken == other.not_taken;
+    }
+
+    uint16_t taken;
+    uint16_t not_taken;
+  };
+
+  // The branch map: DexPc -> BranchData.
+  using BranchMap = ArenaSafeMap<uint16_t, BranchData>;
+
+  // Maps a method dex index to its branch profile.
+  using MethodBranchMap = ArenaSafeMap<uint16_t, BranchMap>;
+
   // Profile method hotness information for a single method. Also includes a pointer to the inline
   // cache map.
   class MethodHotness {
@@ -223,11 +257,13 @@ class ProfileCompilationInfo {
   // dex_references[ClassReference::dex_profile_index].
   struct OfflineProfileMethodInfo {
     explicit OfflineProfileMethodInfo(const InlineCacheMap* inline_cache_map)
-        : inline_caches(inline_cache_map) {}
+        : inline_caches(inline_cache_map), branches(nullptr) {}
 
     bool operator==(const OfflineProfileMethodInfo& other) const;
 
     const InlineCacheMap* const inline_caches;
+    // The branch profile of the method, if any.
+    const BranchMap* branches;
     std::vector<DexReference> dex_references;
   };
 
@@ -294,7 +330,7 @@ class ProfileCompilationInfo {
   // If the current profile is non-empty the load will fail.
   bool Load(int fd);
 
-  // Load profile information from the given file
+  // Load profile information from the given file and its delta log, if any.
   // If the current profile is non-empty the load will fail.
   // If clear_if_invalid is true and the file is invalid the method clears the
   // the file and returns true.
@@ -308,9 +344,20 @@ class ProfileCompilationInfo {
   // Save the profile data to the given file descriptor.
   bool Save(int fd);
 
-  // Save the current profile into the given file. The file will be cleared before saving.
+  // Encode the profile data in the format of kProfileVersion, as written by Save.
+  bool Serialize(/*out*/std::vector<uint8_t>* buffer) const;
+
+  // Save the current profile into the given file. The file will be cleared before saving,
+  // and so will its delta log since the saved data supersedes it.
   bool Save(const std::string& filename, uint64_t* bytes_written);
 
+  // Append the current profile as one record to the delta log of the given file, leaving the
+  // file itself untouched. Load(filename, ...) merges the records back in.
+  bool AppendToDeltaLog(const std::string& filename, uint64_t* bytes_written);
+
+  // Return the name of the delta log of the given profile file.
+  static std::string GetDeltaLogFilename(const std::string& filename);
+
   // Return the number of methods that were profiled.
   uint32_t GetNumberOfMethods() const;
 
@@ -326,6 +373,9 @@ class ProfileCompilationInfo {
   // Return true if the class's type is present in the profiling info.
   bool ContainsClass(const DexFile& dex_file, dex::TypeIndex type_idx) const;
 
+  // Return true if the profiling info has data for the dex file.
+  bool ContainsDexFile(const DexFile& dex_file) const;
+
   // Return the method data for the given location and index from the profiling info.
   // If the method index is not found or the checksum doesn't match, null is returned.
   // Note: the inline cache map is a pointer to the map stored in the profile and
@@ -352,6 +402,14 @@ class ProfileCompilationInfo {
                             /*out*/std::set<uint16_t>* startup_method_set,
                             /*out*/std::set<uint16_t>* post_startup_method_method_set) const;
 
+  // Return the profiled methods of a given dex file as (method index, MethodHotness flags)
+  // pairs sorted by method index, and the profiled classes sorted by type index. Unlike
+  // GetClassesAndMethods, this looks up the dex file only once and fills flat vectors, which
+  // suits aggregating many profiles. Returns false if the dex file is not in the profile.
+  bool GetMethodFlagsAndClasses(const DexFile& dex_file,
+                                /*out*/std::vector<std::pair<uint16_t, uint8_t>>* method_flags,
+                                /*out*/std::vector<dex::TypeIndex>* classes) const;
+
   // Perform an equality test with the `other` profile information.
   bool Equals(const ProfileCompilationInfo& other);
 
@@ -414,6 +472,7 @@ class ProfileCompilationInfo {
           profile_index(index),
           checksum(location_checksum),
           method_map(std::less<uint16_t>(), arena->Adapter(kArenaAllocProfile)),
+          branch_map(std::less<uint16_t>(), arena->Adapter(kArenaAllocProfile)),
           class_set(std::less<dex::TypeIndex>(), arena->Adapter(kArenaAllocProfile)),
           num_method_ids(num_methods),
           bitmap_storage(arena->Adapter(kArenaAllocProfile)) {
@@ -426,7 +485,9 @@ class ProfileCompilationInfo {
     }
 
     bool operator==(const DexFileData& other) const {
-      return checksum == other.checksum && method_map == other.method_map;
+      return checksum == other.checksum &&
+          method_map == other.method_map &&
+          branch_map == other.branch_map;
     }
 
     // Mark a method as executed at least once.
@@ -451,12 +512,19 @@ class ProfileCompilationInfo {
     uint32_t checksum;
     // The methonds' profile information.
     MethodMap method_map;
+    // The branch profiles of the hot methods that have one.
+    MethodBranchMap branch_map;
     // The classes which have been profiled. Note that these don't necessarily include
     // all the classes that can be found in the inline caches reference.
     ArenaSet<dex::TypeIndex> class_set;
     // Find the inline caches of the the given method index. Add an empty entry if
     // no previous data is found.
     InlineCacheMap* FindOrAddMethod(uint16_t method_index);
+    // Find the branch profile of the given method index. Add an empty entry if
+    // no previous data is found.
+    BranchMap* FindOrAddBranches(uint16_t method_index);
+    // Return the branch profile of the given method index, or null if it has none.
+    const BranchMap* FindBranches(uint16_t method_index) const;
     // Num method ids.
     uint32_t num_method_ids;
     ArenaVector<uint8_t> bitmap_storage;
@@ -595,11 +663,35 @@ class ProfileCompilationInfo {
     uint8_t* ptr_current_;
   };
 
-  // Entry point for profile loding functionality.
-  ProfileLoadSatus LoadInternal(int fd, std::string* error);
+  // Entry point for profile loding functionality. If allow_trailing_data is true the read
+  // stops after the first profile record instead of expecting the end of the file.
+  ProfileLoadSatus LoadInternal(int fd, std::string* error, bool allow_trailing_data = false);
+
+  // Load the rest of a kProfileVersion profile whose magic and version were read from fd.
+  ProfileLoadSatus LoadMappable(int fd, std::string* error, bool allow_trailing_data);
+
+  // Add the data of the mapped profile to the (empty) profile.
+  ProfileLoadSatus LoadMappedProfile(const MappedProfile& profile, /*out*/std::string* error);
 
-  // Read the profile header from the given fd and store the number of profile
-  // lines into number_of_dex_files.
+  // Save the profile data in the format of kProfileVersionCompressed. Only used to test the
+  // conversion of profiles in that format.
+  bool SaveCompressed(int fd);
+
+  // Merge the records of the delta log of the given file. A torn record at the end of the
+  // log is ignored. Returns false if the log exists but could not be locked.
+  bool MergeDeltaLog(const std::string& filename);
+
+  // Clear the delta log of the given file, if any.
+  static bool ClearDeltaLog(const std::string& filename);
+
+  // Read the magic and the version from the given fd and tell whether the profile is in the
+  // format of kProfileVersion or of kProfileVersionCompressed.
+  ProfileLoadSatus ReadProfileVersion(int fd,
+                                      /*out*/bool* is_mappable,
+                                      /*out*/std::string* error);
+
+  // Read the header that follows the version of a kProfileVersionCompressed profile from the
+  // given fd and store the number of profile lines into number_of_dex_files.
   ProfileLoadSatus ReadProfileHeader(int fd,
                                      /*out*/uint8_t* number_of_dex_files,
                                      /*out*/uint32_t* size_uncompressed_data,
@@ -644,6 +736,16 @@ class ProfileCompilationInfo {
   void AddInlineCacheToBuffer(std::vector<uint8_t>* buffer,
                               const InlineCacheMap& inline_cache);
 
+  // Read the branch profile encoding from line_bufer. The branches are only stored
+  // if there are any.
+  bool ReadBranches(SafeBuffer& buffer,
+                    DexFileData* data,
+                    uint16_t method_index,
+                    /*out*/std::string* error);
+
+  // Encode the branch profile (null if the method has none) into the given buffer.
+  void AddBranchesToBuffer(std::vector<uint8_t>* buffer, const BranchMap* branches);
+
   // Return the number of bytes needed to encode the profile information
   // for the methods in dex_data.
   uint32_t GetMethodsRegionSize(const DexFileData& dex_data);
@@ -24,7 +24,9 @@
 #include "method_reference.h"
 #include "mirror/class-inl.h"
 #include "mirror/class_loader.h"
+#include "os.h"
 #include "handle_scope-inl.h"
+#include "jit/mapped_profile.h"
 #include "jit/profile_compilation_info.h"
 #include "linear_alloc.h"
 #include "scoped_thread_state_change-inl.h"
@@ -93,6 +95,11 @@ class ProfileCompilationInfoTest : public CommonRuntimeTest {
     return static_cast<uint32_t>(file.GetFd());
   }
 
+  // Save the profile in the format of kProfileVersionCompressed.
+  bool SaveCompressed(ProfileCompilationInfo* info, const ScratchFile& file) {
+    return info->SaveCompressed(GetFd(file));
+  }
+
   bool SaveProfilingInfo(
       const std::string& filename,
       const std::vector<ArtMethod*>& methods,
@@ -465,7 +472,7 @@ TEST_F(ProfileCompilationInfoTest, Incomplete) {
   ASSERT_TRUE(profile.GetFile()->WriteFully(
       ProfileCompilationInfo::kProfileMagic, kProfileMagicSize));
   ASSERT_TRUE(profile.GetFile()->WriteFully(
-      ProfileCompilationInfo::kProfileVersion, kProfileVersionSize));
+      ProfileCompilationInfo::kProfileVersionCompressed, kProfileVersionSize));
   // Write that we have at least one line.
   uint8_t line_number[] = { 0, 1 };
   ASSERT_TRUE(profile.GetFile()->WriteFully(line_number, sizeof(line_number)));
@@ -481,7 +488,7 @@ TEST_F(ProfileCompilationInfoTest, TooLongDexLocation) {
   ASSERT_TRUE(profile.GetFile()->WriteFully(
       ProfileCompilationInfo::kProfileMagic, kProfileMagicSize));
   ASSERT_TRUE(profile.GetFile()->WriteFully(
-      ProfileCompilationInfo::kProfileVersion, kProfileVersionSize));
+      ProfileCompilationInfo::kProfileVersionCompressed, kProfileVersionSize));
   // Write that we have at least one line.
   uint8_t line_number[] = { 0, 1 };
   ASSERT_TRUE(profile.GetFile()->WriteFully(line_number, sizeof(line_number)));
@@ -518,6 +525,53 @@ TEST_F(ProfileCompilationInfoTest, UnexpectedContent) {
   ASSERT_FALSE(loaded_info.Load(GetFd(profile)));
 }
 
+TEST_F(ProfileCompilationInfoTest, DeltaLog) {
+  ScratchFile profile;
+  std::string log_filename = ProfileCompilationInfo::GetDeltaLogFilename(profile.GetFilename());
+
+  ProfileCompilationInfo base_info;
+  ProfileCompilationInfo all_info;
+  for (uint16_t i = 0; i < 10; i++) {
+    ASSERT_TRUE(AddMethod("dex_location1", /* checksum */ 1, /* method_idx */ i, &base_info));
+    ASSERT_TRUE(AddMethod("dex_location1", /* checksum */ 1, /* method_idx */ i, &all_info));
+  }
+  ASSERT_TRUE(base_info.Save(profile.GetFilename(), /* bytes_written */ nullptr));
+
+  // Append two records, the second one with a new dex file.
+  ProfileCompilationInfo delta_info1;
+  ProfileCompilationInfo delta_info2;
+  for (uint16_t i = 5; i < 20; i++) {
+    ASSERT_TRUE(AddMethod("dex_location1", /* checksum */ 1, /* method_idx */ i, &delta_info1));
+    ASSERT_TRUE(AddMethod("dex_location1", /* checksum */ 1, /* method_idx */ i, &all_info));
+    ASSERT_TRUE(AddMethod("dex_location2", /* checksum */ 2, /* method_idx */ i, &delta_info2));
+    ASSERT_TRUE(AddMethod("dex_location2", /* checksum */ 2, /* method_idx */ i, &all_info));
+  }
+  uint64_t bytes_written = 0;
+  ASSERT_TRUE(delta_info1.AppendToDeltaLog(profile.GetFilename(), &bytes_written));
+  ASSERT_GT(bytes_written, 0u);
+  ASSERT_TRUE(delta_info2.AppendToDeltaLog(profile.GetFilename(), &bytes_written));
+
+  // A torn record at the end of the log is ignored.
+  std::unique_ptr<File> log_file(OS::OpenFileWithFlags(log_filename.c_str(), O_WRONLY | O_APPEND));
+  ASSERT_TRUE(log_file != nullptr);
+  uint8_t torn_data[] = { 'p', 'r', 'o' };
+  ASSERT_TRUE(log_file->WriteFully(torn_data, sizeof(torn_data)));
+  ASSERT_EQ(0, log_file->FlushClose());
+
+  // The file and the log load as one profile.
+  ProfileCompilationInfo loaded_info;
+  ASSERT_TRUE(loaded_info.Load(profile.GetFilename(), /* clear_if_invalid */ false));
+  ASSERT_TRUE(loaded_info.Equals(all_info));
+
+  // A full save folds the log into the file.
+  ASSERT_TRUE(loaded_info.Save(profile.GetFilename(), /* bytes_written */ nullptr));
+  ASSERT_EQ(0, GetFileSizeBytes(log_filename));
+  ProfileCompilationInfo reloaded_info;
+  ASSERT_TRUE(reloaded_info.Load(profile.GetFilename(), /* clear_if_invalid */ false));
+  ASSERT_TRUE(reloaded_info.Equals(all_info));
+  ASSERT_EQ(0, unlink(log_filename.c_str()));
+}
+
 TEST_F(ProfileCompilationInfoTest, SaveInlineCaches) {
   ScratchFile profile;
 
@@ -833,6 +887,51 @@ TEST_F(ProfileCompilationInfoTest, MissingTypesInlineCachesMerge) {
   ASSERT_TRUE(info_no_inline_cache.Save(GetFd(profile)));
 }
 
+TEST_F(ProfileCompilationInfoTest, SaveAndMergeBranches) {
+  ProfileCompilationInfo::InlineCacheMap* ic_map = CreateInlineCacheMap();
+  ProfileCompilationInfo::BranchMap branches(std::less<uint16_t>(),
+                                             arena_->Adapter(kArenaAllocProfile));
+  branches.FindOrAdd(2)->second.Add(/* taken */ 10, /* not_taken */ 1);
+  branches.FindOrAdd(7)->second.Add(/* taken */ 0, /* not_taken */ 0xffff);
+  ProfileCompilationInfo::OfflineProfileMethodInfo pmi(ic_map);
+  pmi.branches = &branches;
+  pmi.dex_references.emplace_back("dex_location1", /* checksum */ 1, kMaxMethodIds);
+
+  ProfileCompilationInfo saved_info;
+  ASSERT_TRUE(AddMethod("dex_location1", /* checksum */ 1, /* method_idx */ 3, pmi, &saved_info));
+  ASSERT_TRUE(AddMethod("dex_location1", /* checksum */ 1, /* method_idx */ 4, &saved_info));
+
+  ScratchFile profile;
+  ASSERT_TRUE(saved_info.Save(GetFd(profile)));
+  ASSERT_EQ(0, profile.GetFile()->Flush());
+
+  // Check that we get back what we saved.
+  ProfileCompilationInfo loaded_info;
+  ASSERT_TRUE(profile.GetFile()->ResetOffset());
+  ASSERT_TRUE(loaded_info.Load(GetFd(profile)));
+  ASSERT_TRUE(loaded_info.Equals(saved_info));
+  std::unique_ptr<ProfileCompilationInfo::OfflineProfileMethodInfo> loaded_pmi =
+      loaded_info.GetMethod("dex_location1", /* checksum */ 1, /* method_idx */ 3);
+  ASSERT_TRUE(loaded_pmi != nullptr);
+  ASSERT_TRUE(*loaded_pmi == pmi);
+  std::unique_ptr<ProfileCompilationInfo::OfflineProfileMethodInfo> loaded_pmi_no_branches =
+      loaded_info.GetMethod("dex_location1", /* checksum */ 1, /* method_idx */ 4);
+  ASSERT_TRUE(loaded_pmi_no_branches != nullptr);
+  ASSERT_TRUE(loaded_pmi_no_branches->branches == nullptr);
+
+  // Merging adds up the counts, and halves both of them when one saturates.
+  ASSERT_TRUE(loaded_info.MergeWith(saved_info));
+  std::unique_ptr<ProfileCompilationInfo::OfflineProfileMethodInfo> merged_pmi =
+      loaded_info.GetMethod("dex_location1", /* checksum */ 1, /* method_idx */ 3);
+  ASSERT_TRUE(merged_pmi != nullptr);
+  ASSERT_TRUE(merged_pmi->branches != nullptr);
+  ASSERT_EQ(2u, merged_pmi->branches->size());
+  ASSERT_EQ(20u, merged_pmi->branches->Get(2).taken);
+  ASSERT_EQ(2u, merged_pmi->branches->Get(2).not_taken);
+  ASSERT_EQ(0u, merged_pmi->branches->Get(7).taken);
+  ASSERT_EQ(0xffffu, merged_pmi->branches->Get(7).not_taken);
+}
+
 TEST_F(ProfileCompilationInfoTest, LoadShouldClearExistingDataFromProfiles) {
   ScratchFile profile;
 
@@ -940,4 +1039,162 @@ TEST_F(ProfileCompilationInfoTest, SampledMethodsTest) {
   }
 }
 
+TEST_F(ProfileCompilationInfoTest, IncompleteMappable) {
+  ScratchFile profile;
+  ASSERT_TRUE(profile.GetFile()->WriteFully(
+      ProfileCompilationInfo::kProfileMagic, kProfileMagicSize));
+  ASSERT_TRUE(profile.GetFile()->WriteFully(
+      ProfileCompilationInfo::kProfileVersion, kProfileVersionSize));
+  // One dex file and a profile size larger than the file.
+  uint8_t header[] = { 1, 0, 0, 0, 0, 1, 0, 0 };
+  ASSERT_TRUE(profile.GetFile()->WriteFully(header, sizeof(header)));
+  ASSERT_EQ(0, profile.GetFile()->Flush());
+
+  ProfileCompilationInfo loaded_info;
+  ASSERT_TRUE(profile.GetFile()->ResetOffset());
+  ASSERT_FALSE(loaded_info.Load(GetFd(profile)));
+}
+
+TEST_F(ProfileCompilationInfoTest, ConvertCompressedProfile) {
+  ProfileCompilationInfo saved_info;
+  ProfileCompilationInfo::OfflineProfileMethodInfo pmi = GetOfflineProfileMethodInfo();
+  for (uint16_t method_idx = 0; method_idx < 10; method_idx++) {
+    ASSERT_TRUE(AddMethod("dex_location1", /* checksum */ 1, method_idx, pmi, &saved_info));
+    ASSERT_TRUE(AddMethod("dex_location4", /* checksum */ 4, method_idx, pmi, &saved_info));
+  }
+  ASSERT_TRUE(saved_info.AddMethodIndex(
+      Hotness::kFlagStartup, "dex_location4", /* checksum */ 4, 20, kMaxMethodIds));
+  ASSERT_TRUE(AddClass("dex_location1", /* checksum */ 1, dex::TypeIndex(7), &saved_info));
+
+  // Load a profile in the previous format.
+  ScratchFile compressed_profile;
+  ASSERT_TRUE(SaveCompressed(&saved_info, compressed_profile));
+  ASSERT_EQ(0, compressed_profile.GetFile()->Flush());
+  ProfileCompilationInfo loaded_info;
+  ASSERT_TRUE(compressed_profile.GetFile()->ResetOffset());
+  ASSERT_TRUE(loaded_info.Load(GetFd(compressed_profile)));
+  ASSERT_TRUE(loaded_info.Equals(saved_info));
+
+  // Saving it again writes the current format.
+  ScratchFile profile;
+  ASSERT_TRUE(loaded_info.Save(GetFd(profile)));
+  ASSERT_EQ(0, profile.GetFile()->Flush());
+  uint8_t magic_version[kProfileMagicSize + kProfileVersionSize];
+  ASSERT_TRUE(profile.GetFile()->ResetOffset());
+  ASSERT_TRUE(profile.GetFile()->ReadFully(magic_version, sizeof(magic_version)));
+  ASSERT_EQ(0, memcmp(magic_version + kProfileMagicSize,
+                      ProfileCompilationInfo::kProfileVersion,
+                      kProfileVersionSize));
+
+  ProfileCompilationInfo converted_info;
+  ASSERT_TRUE(profile.GetFile()->ResetOffset());
+  ASSERT_TRUE(converted_info.Load(GetFd(profile)));
+  ASSERT_TRUE(converted_info.Equals(saved_info));
+  std::unique_ptr<ProfileCompilationInfo::OfflineProfileMethodInfo> converted_pmi =
+      converted_info.GetMethod("dex_location4", /* checksum */ 4, /* method_idx */ 3);
+  ASSERT_TRUE(converted_pmi != nullptr);
+  ASSERT_TRUE(*converted_pmi == pmi);
+}
+
+TEST_F(ProfileCompilationInfoTest, MappedProfile) {
+  ProfileCompilationInfo::OfflineProfileMethodInfo pmi = GetOfflineProfileMethodInfo();
+  ProfileCompilationInfo::BranchMap branches(std::less<uint16_t>(),
+                                             arena_->Adapter(kArenaAllocProfile));
+  branches.FindOrAdd(5)->second.Add(/* taken */ 3, /* not_taken */ 4);
+  pmi.branches = &branches;
+
+  ProfileCompilationInfo saved_info;
+  ASSERT_TRUE(AddMethod("dex_location1", /* checksum */ 1, /* method_idx */ 3, pmi, &saved_info));
+  ASSERT_TRUE(AddMethod("dex_location1", /* checksum */ 1, /* method_idx */ 8, &saved_info));
+  ASSERT_TRUE(saved_info.AddMethodIndex(
+      Hotness::kFlagPostStartup, "dex_location2", /* checksum */ 2, 6, kMaxMethodIds));
+  ASSERT_TRUE(AddClass("dex_location2", /* checksum */ 2, dex::TypeIndex(9), &saved_info));
+  ASSERT_TRUE(AddClass("dex_location2", /* checksum */ 2, dex::TypeIndex(4), &saved_info));
+
+  ScratchFile profile;
+  ASSERT_TRUE(saved_info.Save(GetFd(profile)));
+  ASSERT_EQ(0, profile.GetFile()->Flush());
+
+  std::string error_msg;
+  std::unique_ptr<MappedProfile> mapped = MappedProfile::Open(profile.GetFilename(), &error_msg);
+  ASSERT_TRUE(mapped != nullptr) << error_msg;
+  ASSERT_EQ(3u, mapped->GetDexFiles().size());
+  EXPECT_EQ(2u, mapped->GetNumberOfMethods());
+  ASSERT_TRUE(mapped->FindDexFile("dex_location1", /* checksum */ 2) == nullptr);
+
+  const MappedProfile::DexFileEntry* dex1 = mapped->FindDexFile("dex_location1", 1);
+  ASSERT_TRUE(dex1 != nullptr);
+  EXPECT_TRUE(mapped->GetMethodHotness(*dex1, 3).IsHot());
+  EXPECT_TRUE(mapped->GetMethodHotness(*dex1, 8).IsHot());
+  EXPECT_FALSE(mapped->GetMethodHotness(*dex1, 4).IsInProfile());
+
+  const MappedProfile::MethodEntry* method = mapped->FindMethod(*dex1, 3);
+  ASSERT_TRUE(method != nullptr);
+  ASSERT_EQ(1u, mapped->GetBranches(*method).size());
+  EXPECT_EQ(5u, mapped->GetBranches(*method)[0].dex_pc);
+  EXPECT_EQ(3u, mapped->GetBranches(*method)[0].taken);
+  EXPECT_EQ(4u, mapped->GetBranches(*method)[0].not_taken);
+  ASSERT_EQ(pmi.inline_caches->size(), mapped->GetInlineCaches(*method).size());
+  for (const MappedProfile::InlineCacheEntry& inline_cache : mapped->GetInlineCaches(*method)) {
+    const ProfileCompilationInfo::DexPcData& dex_pc_data =
+        pmi.inline_caches->Get(inline_cache.dex_pc);
+    EXPECT_EQ(dex_pc_data.is_missing_types,
+              inline_cache.kind == MappedProfile::kInlineCacheMissingTypes);
+    EXPECT_EQ(dex_pc_data.is_megamorphic,
+              inline_cache.kind == MappedProfile::kInlineCacheMegamorphic);
+    // The dex references of pmi were added to the profile in order, so the profile indexes
+    // of the classes are the same.
+    ArrayRef<const MappedProfile::ClassEntry> classes = mapped->GetClasses(inline_cache);
+    ASSERT_EQ(dex_pc_data.classes.size(), classes.size());
+    size_t i = 0;
+    for (const ProfileCompilationInfo::ClassReference& class_ref : dex_pc_data.classes) {
+      EXPECT_EQ(class_ref.dex_profile_index, classes[i].dex_profile_index);
+      EXPECT_EQ(class_ref.type_index.index_, classes[i].type_index);
+      ++i;
+    }
+  }
+  EXPECT_TRUE(mapped->FindMethod(*dex1, 4) == nullptr);
+
+  const MappedProfile::DexFileEntry* dex2 = mapped->FindDexFile("dex_location2", 2);
+  ASSERT_TRUE(dex2 != nullptr);
+  EXPECT_TRUE(mapped->GetMethodHotness(*dex2, 6).IsPostStartup());
+  EXPECT_FALSE(mapped->GetMethodHotness(*dex2, 6).IsHot());
+  EXPECT_FALSE(mapped->GetMethodHotness(*dex2, 6).IsStartup());
+  EXPECT_TRUE(mapped->ContainsClass(*dex2, dex::TypeIndex(4)));
+  EXPECT_TRUE(mapped->ContainsClass(*dex2, dex::TypeIndex(9)));
+  EXPECT_FALSE(mapped->ContainsClass(*dex2, dex::TypeIndex(5)));
+  EXPECT_FALSE(mapped->ContainsClass(*dex1, dex::TypeIndex(4)));
+}
+
+TEST_F(ProfileCompilationInfoTest, MappedProfileRejectsBadData) {
+  ProfileCompilationInfo saved_info;
+  ProfileCompilationInfo::OfflineProfileMethodInfo pmi = GetOfflineProfileMethodInfo();
+  ASSERT_TRUE(AddMethod("dex_location1", /* checksum */ 1, /* method_idx */ 3, pmi, &saved_info));
+  std::vector<uint8_t> data;
+  ASSERT_TRUE(saved_info.Serialize(&data));
+
+  std::string error_msg;
+  std::vector<uint8_t> good_data(data);
+  ASSERT_TRUE(MappedProfile::Create(std::move(good_data), &error_msg) != nullptr) << error_msg;
+
+  std::vector<uint8_t> truncated_data(data.begin(), data.end() - 1);
+  EXPECT_TRUE(MappedProfile::Create(std::move(truncated_data), &error_msg) == nullptr);
+
+  // Point the methods of the first dex file past the end of the profile.
+  std::vector<uint8_t> bad_offset_data(data);
+  MappedProfile::DexFileEntry entry;
+  memcpy(&entry, bad_offset_data.data() + sizeof(MappedProfile::Header), sizeof(entry));
+  entry.methods_offset = bad_offset_data.size();
+  memcpy(bad_offset_data.data() + sizeof(MappedProfile::Header), &entry, sizeof(entry));
+  EXPECT_TRUE(MappedProfile::Create(std::move(bad_offset_data), &error_msg) == nullptr);
+
+  // The loader checks the data the same way.
+  ScratchFile profile;
+  ASSERT_TRUE(profile.GetFile()->WriteFully(data.data(), data.size() - 1));
+  ASSERT_EQ(0, profile.GetFile()->Flush());
+  ProfileCompilationInfo loaded_info;
+  ASSERT_TRUE(profile.GetFile()->ResetOffset());
+  ASSERT_FALSE(loaded_info.Load(GetFd(profile)));
+}
+
 }  // namespace art
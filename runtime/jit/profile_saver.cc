@@ -21,6 +21,9 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 
+#include <limits>
+#include <memory>
+
 #include "android-base/strings.h"
 
 #include "art_method-inl.h"
@@ -86,6 +89,7 @@ ProfileSaver::ProfileSaver(const ProfileSaverOptions& options,
       total_number_of_code_cache_queries_(0),
       total_number_of_skipped_writes_(0),
       total_number_of_failed_writes_(0),
+      total_number_of_delta_writes_(0),
       total_ms_of_sleep_(0),
       total_ns_of_work_(0),
       max_number_of_profile_entries_cached_(0),
@@ -100,6 +104,9 @@ ProfileSaver::~ProfileSaver() {
   for (auto& it : profile_cache_) {
     delete it.second;
   }
+  for (auto& it : saved_profiles_) {
+    delete it.second;
+  }
 }
 
 void ProfileSaver::Run() {
@@ -349,7 +356,7 @@ static void SampleClassesAndExecutedMethods(pthread_t profiler_pthread,
           // Mark startup methods as hot if they have more than hot_method_sample_threshold
           // samples. This means they will get compiled by the compiler driver.
           if (method.GetProfilingInfo(kRuntimePointerSize) != nullptr ||
-              (method.GetAccessFlags() & kAccPreviouslyWarm) != 0 ||
+              method.IsPreviouslyWarm() ||
               counter >= hot_method_sample_threshold) {
             hot_methods->AddReference(method.GetDexFile(), method.GetDexMethodIndex());
           } else if (counter != 0) {
@@ -497,6 +504,30 @@ bool ProfileSaver::ProcessProfilingInfo(bool force_save, /*out*/uint16_t* number
       jit_code_cache_->GetProfiledMethods(locations, profile_methods);
       total_number_of_code_cache_queries_++;
     }
+    auto saved_it = saved_profiles_.find(filename);
+    if (saved_it != saved_profiles_.end()) {
+      SavedProfile* saved = saved_it->second;
+      if (saved->log_bytes <= saved->file_bytes) {
+        ProfileCompilationInfo info(Runtime::Current()->GetArenaPool());
+        info.AddMethods(profile_methods);
+        auto profile_cache_it = profile_cache_.find(filename);
+        if (profile_cache_it != profile_cache_.end()) {
+          info.MergeWith(*(profile_cache_it->second));
+        }
+        if (AppendProfileDelta(filename, &info, saved, force_save, number_of_new_methods)) {
+          if (profile_cache_it != profile_cache_.end()) {
+            ProfileCompilationInfo *cached_info = profile_cache_it->second;
+            profile_cache_.erase(profile_cache_it);
+            delete cached_info;
+          }
+          profile_file_saved = true;
+        }
+        continue;
+      }
+      // The log outgrew the file, compact it with a full save.
+      saved_profiles_.erase(saved_it);
+      delete saved;
+    }
     {
       ProfileCompilationInfo info(Runtime::Current()->GetArenaPool());
       if (!info.Load(filename, /*clear_if_invalid*/ true)) {
@@ -542,6 +573,15 @@ bool ProfileSaver::ProcessProfilingInfo(bool force_save, /*out*/uint16_t* number
           profile_cache_.erase(profile_cache_it);
           delete cached_info;
         }
+        if (options_.GetDeltaWrites()) {
+          // Remember what is on disk so that the next saves only append what is new.
+          SavedProfile* saved = new SavedProfile();
+          saved->info.reset(new ProfileCompilationInfo(Runtime::Current()->GetArenaPool()));
+          saved->info->MergeWith(info);
+          saved->file_bytes = bytes_written;
+          saved->log_bytes = 0;
+          saved_profiles_.Put(filename, saved);
+        }
         if (bytes_written > 0) {
           total_number_of_writes_++;
           total_bytes_written_ += bytes_written;
@@ -567,6 +607,53 @@ bool ProfileSaver::ProcessProfilingInfo(bool force_save, /*out*/uint16_t* number
   return profile_file_saved;
 }
 
+bool ProfileSaver::AppendProfileDelta(const std::string& filename,
+                                      ProfileCompilationInfo* info,
+                                      SavedProfile* saved,
+                                      bool force_save,
+                                      /*out*/uint16_t* number_of_new_methods) {
+  std::unique_ptr<ProfileCompilationInfo> merged(
+      new ProfileCompilationInfo(Runtime::Current()->GetArenaPool()));
+  if (!merged->MergeWith(*saved->info) || !merged->MergeWith(*info)) {
+    // The dex files changed under the profile; let a full save sort it out.
+    saved->log_bytes = std::numeric_limits<uint64_t>::max();
+    return false;
+  }
+  int64_t delta_number_of_methods =
+      merged->GetNumberOfMethods() - saved->info->GetNumberOfMethods();
+  int64_t delta_number_of_classes =
+      merged->GetNumberOfResolvedClasses() - saved->info->GetNumberOfResolvedClasses();
+
+  if ((delta_number_of_methods == 0 && delta_number_of_classes == 0) ||
+      (!force_save &&
+       delta_number_of_methods < options_.GetMinMethodsToSave() &&
+       delta_number_of_classes < options_.GetMinClassesToSave())) {
+    VLOG(profiler) << "Not enough information to append to: " << filename
+                   << " Number of methods: " << delta_number_of_methods
+                   << " Number of classes: " << delta_number_of_classes;
+    total_number_of_skipped_writes_++;
+    return false;
+  }
+
+  if (number_of_new_methods != nullptr) {
+    *number_of_new_methods =
+        std::max(static_cast<uint16_t>(delta_number_of_methods), *number_of_new_methods);
+  }
+  // The record holds this process' data only, not the whole profile on disk.
+  uint64_t bytes_written = 0;
+  if (!info->AppendToDeltaLog(filename, &bytes_written)) {
+    LOG(WARNING) << "Could not append profiling info to " << filename;
+    total_number_of_failed_writes_++;
+    return false;
+  }
+  saved->info = std::move(merged);
+  saved->log_bytes += bytes_written;
+  total_number_of_writes_++;
+  total_number_of_delta_writes_++;
+  total_bytes_written_ += bytes_written;
+  return true;
+}
+
 void* ProfileSaver::RunProfileSaverThread(void* arg) {
   Runtime* runtime = Runtime::Current();
 
@@ -777,6 +864,7 @@ void ProfileSaver::DumpInfo(std::ostream& os) {
      << total_number_of_code_cache_queries_ << '\n'
      << "ProfileSaver total_number_of_skipped_writes=" << total_number_of_skipped_writes_ << '\n'
      << "ProfileSaver total_number_of_failed_writes=" << total_number_of_failed_writes_ << '\n'
+     << "ProfileSaver total_number_of_delta_writes=" << total_number_of_delta_writes_ << '\n'
      << "ProfileSaver total_ms_of_sleep=" << total_ms_of_sleep_ << '\n'
      << "ProfileSaver total_ms_of_work=" << NsToMs(total_ns_of_work_) << '\n'
      << "ProfileSaver max_number_profile_entries_cached="
@@ -84,6 +84,22 @@ class ProfileSaver {
     REQUIRES(!Locks::profiler_lock_)
     REQUIRES(!Locks::mutator_lock_);
 
+  // With delta writes, the profile data known to be on disk for a tracked file, i.e. in the
+  // file and in its delta log, and the bytes last written to each of them.
+  struct SavedProfile {
+    std::unique_ptr<ProfileCompilationInfo> info;
+    uint64_t file_bytes;
+    uint64_t log_bytes;
+  };
+
+  // Appends the data of info that is new relative to saved to the delta log of filename,
+  // subject to the same thresholds as a full save. Returns true if the log was written.
+  bool AppendProfileDelta(const std::string& filename,
+                          ProfileCompilationInfo* info,
+                          SavedProfile* saved,
+                          bool force_save,
+                          /*out*/uint16_t* number_of_new_methods);
+
   void NotifyJitActivityInternal() REQUIRES(!wait_lock_);
   void WakeUpSaver() REQUIRES(wait_lock_);
 
@@ -133,6 +149,10 @@ class ProfileSaver {
   // to just a few hundreds entries in the ProfileCompilationInfo objects.
   SafeMap<std::string, ProfileCompilationInfo*> profile_cache_;
 
+  // The data last saved to each tracked file, only used with delta writes. A file without an
+  // entry gets a full save, which also folds its delta log back in.
+  SafeMap<std::string, SavedProfile*> saved_profiles_;
+
   // Save period condition support.
   Mutex wait_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
   ConditionVariable period_condition_ GUARDED_BY(wait_lock_);
@@ -142,6 +162,7 @@ class ProfileSaver {
   uint64_t total_number_of_code_cache_queries_;
   uint64_t total_number_of_skipped_writes_;
   uint64_t total_number_of_failed_writes_;
+  uint64_t total_number_of_delta_writes_;
   uint64_t total_ms_of_sleep_;
   uint64_t total_ns_of_work_;
   // TODO(calin): replace with an actual size.
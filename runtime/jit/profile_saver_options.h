@@ -41,7 +41,8 @@ struct ProfileSaverOptions {
     min_notification_before_wake_(kMinNotificationBeforeWake),
     max_notification_before_wake_(kMaxNotificationBeforeWake),
     profile_path_(""),
-    profile_boot_class_path_(false) {}
+    profile_boot_class_path_(false),
+    delta_writes_(false) {}
 
   ProfileSaverOptions(
       bool enabled,
@@ -53,7 +54,8 @@ struct ProfileSaverOptions {
       uint32_t min_notification_before_wake,
       uint32_t max_notification_before_wake,
       const std::string& profile_path,
-      bool profile_boot_class_path)
+      bool profile_boot_class_path,
+      bool delta_writes = false)
   : enabled_(enabled),
     min_save_period_ms_(min_save_period_ms),
     save_resolved_classes_delay_ms_(save_resolved_classes_delay_ms),
@@ -63,7 +65,8 @@ struct ProfileSaverOptions {
     min_notification_before_wake_(min_notification_before_wake),
     max_notification_before_wake_(max_notification_before_wake),
     profile_path_(profile_path),
-    profile_boot_class_path_(profile_boot_class_path) {}
+    profile_boot_class_path_(profile_boot_class_path),
+    delta_writes_(delta_writes) {}
 
   bool IsEnabled() const {
     return enabled_;
@@ -103,6 +106,11 @@ struct ProfileSaverOptions {
   bool GetProfileBootClassPath() const {
     return profile_boot_class_path_;
   }
+  // Whether saves after the first one append the new data to a delta log instead of
+  // rewriting the whole profile file.
+  bool GetDeltaWrites() const {
+    return delta_writes_;
+  }
 
   friend std::ostream & operator<<(std::ostream &os, const ProfileSaverOptions& pso) {
     os << "enabled_" << pso.enabled_
@@ -113,7 +121,8 @@ struct ProfileSaverOptions {
         << ", min_classes_to_save_" << pso.min_classes_to_save_
         << ", min_notification_before_wake_" << pso.min_notification_before_wake_
         << ", max_notification_before_wake_" << pso.max_notification_before_wake_
-        << ", profile_boot_class_path_" << pso.profile_boot_class_path_;
+        << ", profile_boot_class_path_" << pso.profile_boot_class_path_
+        << ", delta_writes_" << pso.delta_writes_;
     return os;
   }
 
@@ -129,6 +138,7 @@ struct ProfileSaverOptions {
   uint32_t max_notification_before_wake_;
   std::string profile_path_;
   bool profile_boot_class_path_;
+  bool delta_writes_;
 };
 
 }  // namespace art
@@ -17,6 +17,7 @@
 #include "profiling_info.h"
 
 #include "art_method-inl.h"
+#include "base/time_utils.h"
 #include "dex_instruction.h"
 #include "jit/jit.h"
 #include "jit/jit_code_cache.h"
@@ -25,17 +26,30 @@
 
 namespace art {
 
-ProfilingInfo::ProfilingInfo(ArtMethod* method, const std::vector<uint32_t>& entries)
+ProfilingInfo::ProfilingInfo(ArtMethod* method,
+                             const std::vector<uint32_t>& entries,
+                             const std::vector<uint32_t>& branch_entries)
       : number_of_inline_caches_(entries.size()),
+        number_of_branch_caches_(branch_entries.size()),
         method_(method),
         is_method_being_compiled_(false),
         is_osr_method_being_compiled_(false),
         current_inline_uses_(0),
-        saved_entry_point_(nullptr) {
+        saved_entry_point_(nullptr),
+        survived_collections_(0),
+        warm_time_ns_(NanoTime()),
+        osr_transitions_(0),
+        number_of_osr_entries_(0) {
+  memset(&osr_entries_, 0, sizeof(osr_entries_));
   memset(&cache_, 0, number_of_inline_caches_ * sizeof(InlineCache));
   for (size_t i = 0; i < number_of_inline_caches_; ++i) {
     cache_[i].dex_pc_ = entries[i];
   }
+  BranchCache* branches = GetBranchCaches();
+  memset(branches, 0, number_of_branch_caches_ * sizeof(BranchCache));
+  for (size_t i = 0; i < number_of_branch_caches_; ++i) {
+    branches[i].dex_pc_ = branch_entries[i];
+  }
 }
 
 bool ProfilingInfo::Create(Thread* self, ArtMethod* method, bool retry_allocation) {
@@ -47,8 +61,12 @@ bool ProfilingInfo::Create(Thread* self, ArtMethod* method, bool retry_allocatio
   const uint16_t* code_ptr = code_item.insns_;
   const uint16_t* code_end = code_item.insns_ + code_item.insns_size_in_code_units_;
 
+  // With branch profiling, also keep track of the types tested by CHECK_CAST and INSTANCE_OF
+  // and of the outcomes of conditional branches.
+  const bool profile_branches = Runtime::Current()->GetJit()->ProfileBranches();
   uint32_t dex_pc = 0;
   std::vector<uint32_t> entries;
+  std::vector<uint32_t> branch_entries;
   while (code_ptr < code_end) {
     const Instruction& instruction = *Instruction::At(code_ptr);
     switch (instruction.Opcode()) {
@@ -61,6 +79,30 @@ bool ProfilingInfo::Create(Thread* self, ArtMethod* method, bool retry_allocatio
         entries.push_back(dex_pc);
         break;
 
+      case Instruction::CHECK_CAST:
+      case Instruction::INSTANCE_OF:
+        if (profile_branches) {
+          entries.push_back(dex_pc);
+        }
+        break;
+
+      case Instruction::IF_EQ:
+      case Instruction::IF_NE:
+      case Instruction::IF_LT:
+      case Instruction::IF_GE:
+      case Instruction::IF_GT:
+      case Instruction::IF_LE:
+      case Instruction::IF_EQZ:
+      case Instruction::IF_NEZ:
+      case Instruction::IF_LTZ:
+      case Instruction::IF_GEZ:
+      case Instruction::IF_GTZ:
+      case Instruction::IF_LEZ:
+        if (profile_branches) {
+          branch_entries.push_back(dex_pc);
+        }
+        break;
+
       default:
         break;
     }
@@ -73,27 +115,71 @@ bool ProfilingInfo::Create(Thread* self, ArtMethod* method, bool retry_allocatio
 
   // Allocate the `ProfilingInfo` object int the JIT's data space.
   jit::JitCodeCache* code_cache = Runtime::Current()->GetJit()->GetCodeCache();
-  return code_cache->AddProfilingInfo(self, method, entries, retry_allocation) != nullptr;
+  return code_cache->AddProfilingInfo(
+      self, method, entries, branch_entries, retry_allocation) != nullptr;
+}
+
+void ProfilingInfo::AddBranchInfo(uint32_t dex_pc, bool taken) {
+  // The caches are sorted by dex pc, see Create().
+  BranchCache* branches = GetBranchCaches();
+  size_t lo = 0;
+  size_t hi = number_of_branch_caches_;
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2;
+    if (branches[mid].dex_pc_ < dex_pc) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  if (lo < number_of_branch_caches_ && branches[lo].dex_pc_ == dex_pc) {
+    branches[lo].Increment(taken);
+  }
 }
 
 InlineCache* ProfilingInfo::GetInlineCache(uint32_t dex_pc) {
-  // TODO: binary search if array is too long.
-  for (size_t i = 0; i < number_of_inline_caches_; ++i) {
-    if (cache_[i].dex_pc_ == dex_pc) {
-      return &cache_[i];
+  // The caches are sorted by dex pc, see Create().
+  size_t lo = 0;
+  size_t hi = number_of_inline_caches_;
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2;
+    if (cache_[mid].dex_pc_ < dex_pc) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
     }
   }
+  if (lo < number_of_inline_caches_ && cache_[lo].dex_pc_ == dex_pc) {
+    return &cache_[lo];
+  }
   LOG(FATAL) << "No inline cache found for "  << ArtMethod::PrettyMethod(method_) << "@" << dex_pc;
   UNREACHABLE();
 }
 
-void ProfilingInfo::AddInvokeInfo(uint32_t dex_pc, mirror::Class* cls) {
+ArtMethod* ProfilingInfo::GetInvokeTarget(uint32_t dex_pc, mirror::Class* cls) {
+  InlineCache* cache = GetInlineCache(dex_pc);
+  // classes_[0] only changes once its class is unloaded, which clears target_ too. So a non-null
+  // target_ is the method called for receivers of classes_[0].
+  ArtMethod* target = cache->target_;
+  if (target == nullptr ||
+      ReadBarrier::IsMarked(cache->classes_[0].Read<kWithoutReadBarrier>()) != cls) {
+    return nullptr;
+  }
+  cache->IncrementCount(&cache->counts_[0]);
+  return target;
+}
+
+void ProfilingInfo::AddInvokeInfo(uint32_t dex_pc, mirror::Class* cls, ArtMethod* target) {
   InlineCache* cache = GetInlineCache(dex_pc);
   for (size_t i = 0; i < InlineCache::kIndividualCacheSize; ++i) {
     mirror::Class* existing = cache->classes_[i].Read<kWithoutReadBarrier>();
     mirror::Class* marked = ReadBarrier::IsMarked(existing);
     if (marked == cls) {
-      // Receiver type is already in the cache, nothing else to do.
+      // Receiver type is already in the cache, just count the call.
+      cache->IncrementCount(&cache->counts_[i]);
+      if (i == 0u) {
+        cache->target_ = target;
+      }
       return;
     } else if (marked == nullptr) {
       // Cache entry is empty, try to put `cls` in it.
@@ -108,13 +194,19 @@ void ProfilingInfo::AddInvokeInfo(uint32_t dex_pc, mirror::Class* cls) {
         // entry in case the entry contains `cls`.
         --i;
       } else {
-        // We successfully set `cls`, just return.
+        // We successfully set `cls`. The entry may have held a class that got unloaded,
+        // so restart its count.
+        cache->counts_[i] = 1u;
+        if (i == 0u) {
+          cache->target_ = target;
+        }
         return;
       }
     }
   }
   // Unsuccessfull - cache is full, making it megamorphic. We do not DCHECK it though,
   // as the garbage collector might clear the entries concurrently.
+  cache->IncrementCount(&cache->megamorphic_count_);
 }
 
 }  // namespace art
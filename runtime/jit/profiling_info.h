@@ -17,6 +17,7 @@
 #ifndef ART_RUNTIME_JIT_PROFILING_INFO_H_
 #define ART_RUNTIME_JIT_PROFILING_INFO_H_
 
+#include <limits>
 #include <vector>
 
 #include "base/macros.h"
@@ -37,13 +38,35 @@ class Class;
 
 // Structure to store the classes seen at runtime for a specific instruction.
 // Once the classes_ array is full, we consider the INVOKE to be megamorphic.
+// The counts let the compiler still inline the dominant receivers of a
+// megamorphic INVOKE.
 class InlineCache {
  public:
   static constexpr uint8_t kIndividualCacheSize = 5;
 
  private:
+  // Counts are approximate, as the interpreter updates them without synchronization.
+  // When one saturates, all are halved, which keeps their ratios.
+  void IncrementCount(uint16_t* count) {
+    if (*count == std::numeric_limits<uint16_t>::max()) {
+      for (size_t i = 0; i < kIndividualCacheSize; ++i) {
+        counts_[i] /= 2;
+      }
+      megamorphic_count_ /= 2;
+    }
+    ++*count;
+  }
+
   uint32_t dex_pc_;
   GcRoot<mirror::Class> classes_[kIndividualCacheSize];
+  // Number of calls seen with each of `classes_` as the receiver.
+  uint16_t counts_[kIndividualCacheSize];
+  // Number of calls whose receiver did not fit in the full cache.
+  uint16_t megamorphic_count_;
+  // The method called for receivers of classes_[0], which lets the interpreter skip the method
+  // lookup of monomorphic calls. Null until recorded, and cleared with classes_[0] when its
+  // class gets unloaded.
+  ArtMethod* target_;
 
   friend class jit::JitCodeCache;
   friend class ProfilingInfo;
@@ -51,6 +74,41 @@ class InlineCache {
   DISALLOW_COPY_AND_ASSIGN(InlineCache);
 };
 
+// Structure to store how often the conditional branch of a specific instruction was taken.
+class BranchCache {
+ public:
+  uint32_t GetDexPc() const {
+    return dex_pc_;
+  }
+
+  uint16_t GetTakenCount() const {
+    return taken_;
+  }
+
+  uint16_t GetNotTakenCount() const {
+    return not_taken_;
+  }
+
+ private:
+  // Like the counts of the inline caches, both counts are halved when one saturates.
+  void Increment(bool taken) {
+    uint16_t* count = taken ? &taken_ : &not_taken_;
+    if (*count == std::numeric_limits<uint16_t>::max()) {
+      taken_ /= 2;
+      not_taken_ /= 2;
+    }
+    ++*count;
+  }
+
+  uint32_t dex_pc_;
+  uint16_t taken_;
+  uint16_t not_taken_;
+
+  friend class ProfilingInfo;
+
+  DISALLOW_COPY_AND_ASSIGN(BranchCache);
+};
+
 /**
  * Profiling info for a method, created and filled by the interpreter once the
  * method is warm, and used by the compiler to drive optimizations.
@@ -63,12 +121,42 @@ class ProfilingInfo {
       REQUIRES_SHARED(Locks::mutator_lock_);
 
   // Add information from an executed INVOKE instruction to the profile.
-  void AddInvokeInfo(uint32_t dex_pc, mirror::Class* cls)
+  void AddInvokeInfo(uint32_t dex_pc, mirror::Class* cls, ArtMethod* target)
       // Method should not be interruptible, as it manipulates the ProfilingInfo
       // which can be concurrently collected.
       REQUIRES(Roles::uninterruptible_)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Add the class of the object tested by an executed CHECK_CAST or INSTANCE_OF instruction,
+  // which have an inline cache when branch profiling is enabled.
+  void AddTypeInfo(uint32_t dex_pc, mirror::Class* cls)
+      REQUIRES(Roles::uninterruptible_)
+      REQUIRES_SHARED(Locks::mutator_lock_) {
+    AddInvokeInfo(dex_pc, cls, /* target */ nullptr);
+  }
+
+  // Add the outcome of an executed conditional branch. Does nothing if the method was not
+  // profiled with branch caches.
+  void AddBranchInfo(uint32_t dex_pc, bool taken);
+
+  uint32_t GetNumberOfBranchCaches() const {
+    return number_of_branch_caches_;
+  }
+
+  const BranchCache* GetBranchCaches() const {
+    return reinterpret_cast<const BranchCache*>(&cache_[number_of_inline_caches_]);
+  }
+
+  BranchCache* GetBranchCaches() {
+    return reinterpret_cast<BranchCache*>(&cache_[number_of_inline_caches_]);
+  }
+
+  // Return the method that the INVOKE at dex_pc called for a previous receiver of class `cls`
+  // and count the call, or return null if the inline cache does not know the target.
+  ArtMethod* GetInvokeTarget(uint32_t dex_pc, mirror::Class* cls)
+      REQUIRES(Roles::uninterruptible_)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
   ArtMethod* GetMethod() const {
     return method_;
   }
@@ -99,6 +187,79 @@ class ProfilingInfo {
     return saved_entry_point_;
   }
 
+  uint16_t GetSurvivedCollections() const {
+    return survived_collections_;
+  }
+
+  void SetSurvivedCollections(uint16_t value) {
+    survived_collections_ = value;
+  }
+
+  void IncrementSurvivedCollections() {
+    if (survived_collections_ != std::numeric_limits<uint16_t>::max()) {
+      survived_collections_++;
+    }
+  }
+
+  uint64_t GetWarmTimeNs() const {
+    return warm_time_ns_;
+  }
+
+  // Called when a compile request for the method is dropped and its hotness counter reset.
+  void SetWarmTimeNs(uint64_t warm_time_ns) {
+    warm_time_ns_ = warm_time_ns;
+  }
+
+  // Records that the interpreter jumped into the OSR compiled code at the loop header at dex_pc.
+  void AddOsrTransition(uint32_t dex_pc) {
+    if (osr_transitions_ != std::numeric_limits<uint32_t>::max()) {
+      osr_transitions_++;
+    }
+    OsrEntry* entry = FindOrAddOsrEntry(dex_pc);
+    if (entry != nullptr && entry->transitions != std::numeric_limits<uint16_t>::max()) {
+      entry->transitions++;
+    }
+  }
+
+  // Records that the OSR compiled code has no entry for the loop header at dex_pc, so that the
+  // interpreter does not look for it again at every back edge.
+  void SetOsrEntryMissing(uint32_t dex_pc) {
+    OsrEntry* entry = FindOrAddOsrEntry(dex_pc);
+    if (entry != nullptr) {
+      entry->is_missing = true;
+    }
+  }
+
+  bool IsOsrEntryMissing(uint32_t dex_pc) const {
+    for (size_t i = 0; i < number_of_osr_entries_; ++i) {
+      if (osr_entries_[i].dex_pc == dex_pc) {
+        return osr_entries_[i].is_missing;
+      }
+    }
+    return false;
+  }
+
+  uint32_t GetOsrTransitions() const {
+    return osr_transitions_;
+  }
+
+  // Returns the number of OSR transitions at the loop header at dex_pc, if it is tracked.
+  uint16_t GetOsrTransitions(uint32_t dex_pc) const {
+    for (size_t i = 0; i < number_of_osr_entries_; ++i) {
+      if (osr_entries_[i].dex_pc == dex_pc) {
+        return osr_entries_[i].transitions;
+      }
+    }
+    return 0u;
+  }
+
+  // Called when new OSR code is installed for the method, which may have other entries.
+  void ResetOsrEntries() {
+    for (size_t i = 0; i < number_of_osr_entries_; ++i) {
+      osr_entries_[i].is_missing = false;
+    }
+  }
+
   void ClearGcRootsInInlineCaches() {
     for (size_t i = 0; i < number_of_inline_caches_; ++i) {
       InlineCache* cache = &cache_[i];
@@ -130,18 +291,50 @@ class ProfilingInfo {
   }
 
  private:
-  ProfilingInfo(ArtMethod* method, const std::vector<uint32_t>& entries);
+  // Number of loop headers of a method for which OSR statistics are kept.
+  static constexpr size_t kMaxOsrEntries = 4;
+
+  struct OsrEntry {
+    uint32_t dex_pc;
+    uint16_t transitions;
+    bool is_missing;
+  };
+
+  ProfilingInfo(ArtMethod* method,
+                const std::vector<uint32_t>& entries,
+                const std::vector<uint32_t>& branch_entries);
+
+  // Returns null if all the OSR entry slots are taken by other loop headers.
+  OsrEntry* FindOrAddOsrEntry(uint32_t dex_pc) {
+    for (size_t i = 0; i < number_of_osr_entries_; ++i) {
+      if (osr_entries_[i].dex_pc == dex_pc) {
+        return &osr_entries_[i];
+      }
+    }
+    if (number_of_osr_entries_ == kMaxOsrEntries) {
+      return nullptr;
+    }
+    OsrEntry* entry = &osr_entries_[number_of_osr_entries_++];
+    entry->dex_pc = dex_pc;
+    entry->transitions = 0u;
+    entry->is_missing = false;
+    return entry;
+  }
 
   // Number of instructions we are profiling in the ArtMethod.
   const uint32_t number_of_inline_caches_;
 
+  // Number of conditional branches we are profiling in the ArtMethod.
+  const uint32_t number_of_branch_caches_;
+
   // Method this profiling info is for.
   // Not 'const' as JVMTI introduces obsolete methods that we implement by creating new ArtMethods.
   // See JitCodeCache::MoveObsoleteMethod.
   ArtMethod* method_;
 
-  // Whether the ArtMethod is currently being compiled. This flag
-  // is implicitly guarded by the JIT code cache lock.
+  // Whether the ArtMethod is currently being compiled. These flags
+  // are guarded by the JIT code cache lock, as several compiler threads
+  // may be working at the same time.
   // TODO: Make the JIT code cache lock global.
   bool is_method_being_compiled_;
   bool is_osr_method_being_compiled_;
@@ -154,7 +347,22 @@ class ProfilingInfo {
   // is poking for the liveness of compiled code.
   const void* saved_entry_point_;
 
-  // Dynamically allocated array of size `number_of_inline_caches_`.
+  // Number of full code cache collections the compiled code of the method survived. Guarded by
+  // the JIT code cache lock.
+  uint16_t survived_collections_;
+
+  // When the method last became warm. The JIT ranks compile requests by the rate at which the
+  // method was sampled since then.
+  uint64_t warm_time_ns_;
+
+  // Loop headers at which the interpreter entered, or failed to enter, the OSR compiled code of
+  // the method. Updated racily by the interpreter like the inline caches.
+  uint32_t osr_transitions_;
+  uint8_t number_of_osr_entries_;
+  OsrEntry osr_entries_[kMaxOsrEntries];
+
+  // Dynamically allocated array of size `number_of_inline_caches_`, followed by
+  // `number_of_branch_caches_` BranchCache objects.
   InlineCache cache_[0];
 
   friend class jit::JitCodeCache;
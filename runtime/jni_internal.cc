@@ -1856,13 +1856,7 @@ class JNI {
     if (heap->IsMovableObject(s)) {
       StackHandleScope<1> hs(soa.Self());
       HandleWrapperObjPtr<mirror::String> h(hs.NewHandleWrapper(&s));
-      if (!kUseReadBarrier) {
-        heap->IncrementDisableMovingGC(soa.Self());
-      } else {
-        // For the CC collector, we only need to wait for the thread flip rather than the whole GC
-        // to occur thanks to the to-space invariant.
-        heap->IncrementDisableThreadFlip(soa.Self());
-      }
+      heap->PinObjectForCriticalAccess(soa.Self(), s);
     }
     if (s->IsCompressed()) {
       if (is_copy != nullptr) {
@@ -1890,11 +1884,7 @@ class JNI {
     gc::Heap* heap = Runtime::Current()->GetHeap();
     ObjPtr<mirror::String> s = soa.Decode<mirror::String>(java_string);
     if (heap->IsMovableObject(s)) {
-      if (!kUseReadBarrier) {
-        heap->DecrementDisableMovingGC(soa.Self());
-      } else {
-        heap->DecrementDisableThreadFlip(soa.Self());
-      }
+      heap->UnpinObjectForCriticalAccess(soa.Self(), s);
     }
     if (s->IsCompressed() || (s->IsCompressed() == false && s->GetValue() != chars)) {
       delete[] chars;
@@ -2051,14 +2041,8 @@ class JNI {
     }
     gc::Heap* heap = Runtime::Current()->GetHeap();
     if (heap->IsMovableObject(array)) {
-      if (!kUseReadBarrier) {
-        heap->IncrementDisableMovingGC(soa.Self());
-      } else {
-        // For the CC collector, we only need to wait for the thread flip rather than the whole GC
-        // to occur thanks to the to-space invariant.
-        heap->IncrementDisableThreadFlip(soa.Self());
-      }
-      // Re-decode in case the object moved since IncrementDisableGC waits for GC to complete.
+      heap->PinObjectForCriticalAccess(soa.Self(), array);
+      // Re-decode in case the object moved since pinning may wait for GC to complete.
       array = soa.Decode<mirror::Array>(java_array);
     }
     if (is_copy != nullptr) {
@@ -2359,7 +2343,8 @@ class JNI {
         //    and switching is super easy, remove ! in C code, add annotation in .java code.
         // 3) Good chance of hitting DCHECK failures in ScopedFastNativeObjectAccess
         //    since that checks for presence of @FastNative and not for ! in the descriptor.
-        LOG(WARNING) << "!bang JNI is deprecated. Switch to @FastNative for " << m->PrettyMethod();
+        LOG(WARNING) << "!bang JNI is deprecated. Switch to @FastNative, or list the method in "
+                     << "-Xjnioptimizednatives, for " << m->PrettyMethod();
         is_fast = false;
         // TODO: make this a hard register error in the future.
       }
@@ -2606,12 +2591,8 @@ class JNI {
       if (is_copy) {
         delete[] reinterpret_cast<uint64_t*>(elements);
       } else if (heap->IsMovableObject(array)) {
-        // Non copy to a movable object must means that we had disabled the moving GC.
-        if (!kUseReadBarrier) {
-          heap->DecrementDisableMovingGC(soa.Self());
-        } else {
-          heap->DecrementDisableThreadFlip(soa.Self());
-        }
+        // Non copy to a movable object must means that we had pinned it.
+        heap->UnpinObjectForCriticalAccess(soa.Self(), array);
       }
     }
   }
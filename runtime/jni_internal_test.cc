@@ -20,9 +20,11 @@
 
 #include "art_method-inl.h"
 #include "common_compiler_test.h"
+#include "gc/heap.h"
 #include "indirect_reference_table.h"
 #include "java_vm_ext.h"
 #include "jni_env_ext.h"
+#include "mirror/array-inl.h"
 #include "mirror/string-inl.h"
 #include "nativehelper/ScopedLocalRef.h"
 #include "scoped_thread_state_change-inl.h"
@@ -1424,6 +1426,27 @@ TEST_F(JniInternalTest, StaleWeakGlobal) {
   EXPECT_EQ(new_local_ref, nullptr);
 }
 
+TEST_F(JniInternalTest, GetPrimitiveArrayCriticalDoesNotBlockGc) {
+  gc::Heap* heap = Runtime::Current()->GetHeap();
+  if (heap->CurrentCollectorType() != gc::kCollectorTypeCC) {
+    // The other collectors disable moving GC during the critical section.
+    return;
+  }
+  jintArray array = env_->NewIntArray(16);
+  ASSERT_NE(array, nullptr);
+  jboolean is_copy;
+  void* elements = env_->GetPrimitiveArrayCritical(array, &is_copy);
+  ASSERT_NE(elements, nullptr);
+  EXPECT_EQ(is_copy, JNI_FALSE);
+  // Only the region of the array is pinned, so the collector can run without moving the array.
+  heap->CollectGarbage(false);
+  {
+    ScopedObjectAccess soa(env_);
+    EXPECT_EQ(soa.Decode<mirror::Array>(array)->GetRawData(sizeof(jint), 0), elements);
+  }
+  env_->ReleasePrimitiveArrayCritical(array, elements, 0);
+}
+
 TEST_F(JniInternalTest, NewStringUTF) {
   EXPECT_EQ(env_->NewStringUTF(nullptr), nullptr);
   jstring s;
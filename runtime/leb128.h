@@ -17,6 +17,8 @@
 #ifndef ART_RUNTIME_LEB128_H_
 #define ART_RUNTIME_LEB128_H_
 
+#include <string.h>
+
 #include <vector>
 
 #include "base/bit_utils.h"
@@ -96,6 +98,36 @@ static inline bool DecodeUnsignedLeb128Checked(const uint8_t** data,
   return true;
 }
 
+// Reads `count` unsigned LEB128 values to `out`, updating the given pointer to point just past
+// the end of the last value, with the same results as `count` calls of DecodeUnsignedLeb128().
+// The data up to `end` must be readable. When the next eight bytes are readable and the values
+// are all single bytes, which is the common case for small counts and indexes, they are taken
+// from a single load.
+static inline void DecodeUnsignedLeb128s(const uint8_t** data,
+                                         const void* end,
+                                         uint32_t* out,
+                                         size_t count) {
+  DCHECK_GE(count, 1u);
+  DCHECK_LE(count, sizeof(uint64_t));
+  const uint8_t* ptr = *data;
+  if (reinterpret_cast<const uint8_t*>(end) - ptr >= static_cast<ptrdiff_t>(sizeof(uint64_t))) {
+    uint64_t bytes;
+    memcpy(&bytes, ptr, sizeof(bytes));
+    const uint64_t high_bits = UINT64_C(0x8080808080808080) >> ((8u - count) * kBitsPerByte);
+    if ((bytes & high_bits) == 0u) {
+      for (size_t i = 0; i != count; ++i) {
+        out[i] = static_cast<uint8_t>(bytes >> (i * kBitsPerByte));
+      }
+      *data = ptr + count;
+      return;
+    }
+  }
+  for (size_t i = 0; i != count; ++i) {
+    out[i] = DecodeUnsignedLeb128(&ptr);
+  }
+  *data = ptr;
+}
+
 // Reads an unsigned LEB128 + 1 value. updating the given pointer to point
 // just past the end of the read value. This function tolerates
 // non-zero high-order bits in the fifth encoded byte.
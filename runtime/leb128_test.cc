@@ -172,6 +172,42 @@ TEST(Leb128Test, UnsignedStream) {
   EXPECT_EQ(data_size, static_cast<size_t>(encoded_data_ptr - encoded_data));
 }
 
+TEST(Leb128Test, UnsignedStreamBatches) {
+  // Encode a number of entries, also with garbage in the high bits of five byte encodings.
+  std::vector<uint8_t> encoded_data;
+  std::vector<uint32_t> decoded;
+  for (size_t i = 0; i < arraysize(uleb128_tests); ++i) {
+    uint8_t buffer[5];
+    uint8_t* end = EncodeUnsignedLeb128(buffer, uleb128_tests[i].decoded);
+    encoded_data.insert(encoded_data.end(), buffer, end);
+    decoded.push_back(uleb128_tests[i].decoded);
+  }
+  static const uint8_t kGarbage[] = { 0xff, 0xff, 0xff, 0xff, 0xff };
+  const uint8_t* garbage_ptr = kGarbage;
+  encoded_data.insert(encoded_data.end(), kGarbage, kGarbage + arraysize(kGarbage));
+  decoded.push_back(DecodeUnsignedLeb128(&garbage_ptr));
+  for (size_t count = 1; count <= 6; ++count) {
+    for (size_t start = 0; start < decoded.size(); ++start) {
+      // Decode `count` values from the stream of values starting with the entry `start`.
+      const uint8_t* expected_ptr = &encoded_data[0];
+      for (size_t i = 0; i != start; ++i) {
+        DecodeUnsignedLeb128(&expected_ptr);
+      }
+      const uint8_t* data_ptr = expected_ptr;
+      size_t num_values = std::min(count, decoded.size() - start);
+      for (size_t i = 0; i != num_values; ++i) {
+        DecodeUnsignedLeb128(&expected_ptr);
+      }
+      uint32_t values[6];
+      DecodeUnsignedLeb128s(&data_ptr, &encoded_data[0] + encoded_data.size(), values, num_values);
+      EXPECT_EQ(expected_ptr, data_ptr) << " count = " << count << " start = " << start;
+      for (size_t i = 0; i != num_values; ++i) {
+        EXPECT_EQ(decoded[start + i], values[i]) << " count = " << count << " start = " << start;
+      }
+    }
+  }
+}
+
 TEST(Leb128Test, SignedSinglesVector) {
   // Test individual encodings.
   for (size_t i = 0; i < arraysize(sleb128_tests); ++i) {
@@ -298,6 +334,25 @@ TEST(Leb128Test, Speed) {
     last_time = cur_time;
   }
 
+  // Verify batch decoding and measure its speed.
+  std::unique_ptr<Histogram<uint64_t>> batch_dec_hist(
+      new Histogram<uint64_t>("Leb128BatchDecodeSpeedTest", 5));
+  const uint8_t* const encoded_data_end = &builder.GetData()[0] + builder.GetData().size();
+  encoded_data_ptr = &builder.GetData()[0];
+  last_time = NanoTime();
+  for (size_t i = 0; i < 1024; i++) {
+    for (size_t j = 0; j < 1024; j += 4) {
+      uint32_t values[4];
+      DecodeUnsignedLeb128s(&encoded_data_ptr, encoded_data_end, values, arraysize(values));
+      for (size_t k = 0; k != arraysize(values); ++k) {
+        EXPECT_EQ(values[k], (i * 1024) + j + k);
+      }
+    }
+    uint64_t cur_time = NanoTime();
+    batch_dec_hist->AddValue(cur_time - last_time);
+    last_time = cur_time;
+  }
+
   Histogram<uint64_t>::CumulativeData enc_data;
   enc_hist->CreateHistogram(&enc_data);
   enc_hist->PrintConfidenceIntervals(std::cout, 0.99, enc_data);
@@ -305,6 +360,10 @@ TEST(Leb128Test, Speed) {
   Histogram<uint64_t>::CumulativeData dec_data;
   dec_hist->CreateHistogram(&dec_data);
   dec_hist->PrintConfidenceIntervals(std::cout, 0.99, dec_data);
+
+  Histogram<uint64_t>::CumulativeData batch_dec_data;
+  batch_dec_hist->CreateHistogram(&batch_dec_data);
+  batch_dec_hist->PrintConfidenceIntervals(std::cout, 0.99, batch_dec_data);
 }
 
 }  // namespace art
@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "lock_contention_profiler.h"
+
+#include <algorithm>
+#include <ostream>
+#include <sstream>
+#include <vector>
+
+#include "art_method-inl.h"
+#include "base/mutex-inl.h"
+#include "base/time_utils.h"
+#include "monitor.h"
+#include "stack.h"
+#include "thread.h"
+
+namespace art {
+
+static void PrintLocation(std::ostream& os, ArtMethod* method, uint32_t dex_pc)
+    REQUIRES_SHARED(Locks::mutator_lock_) {
+  const char* source_file;
+  int32_t line_number;
+  Monitor::TranslateLocation(method, dex_pc, &source_file, &line_number);
+  os << method->PrettyMethod() << "(" << source_file << ":" << line_number << ")";
+}
+
+// Appends the innermost non-runtime frames of a thread to a call site key.
+class ContentionSiteVisitor FINAL : public StackVisitor {
+ public:
+  ContentionSiteVisitor(Thread* thread, std::ostream& os)
+      REQUIRES_SHARED(Locks::mutator_lock_)
+      : StackVisitor(thread, nullptr, StackVisitor::StackWalkKind::kIncludeInlinedFrames),
+        os_(os),
+        depth_(0u) {}
+
+  bool VisitFrame() OVERRIDE REQUIRES_SHARED(Locks::mutator_lock_) {
+    ArtMethod* m = GetMethod();
+    if (m == nullptr || m->IsRuntimeMethod()) {
+      return true;
+    }
+    os_ << "\n      at ";
+    PrintLocation(os_, m, GetDexPc(/* abort_on_failure */ false));
+    return ++depth_ != LockContentionProfiler::kWaiterStackDepth;
+  }
+
+ private:
+  std::ostream& os_;
+  size_t depth_;
+};
+
+LockContentionProfiler::LockContentionProfiler()
+    : lock_("Lock contention profiler lock"),
+      dropped_samples_(0u),
+      contention_stats_were_enabled_(BaseMutex::IsContentionStatsEnabled()) {
+  BaseMutex::SetContentionStatsEnabled(true);
+}
+
+LockContentionProfiler::~LockContentionProfiler() {
+  if (!contention_stats_were_enabled_) {
+    BaseMutex::SetContentionStatsEnabled(false);
+  }
+}
+
+void LockContentionProfiler::RecordMonitorContention(Thread* self,
+                                                     ArtMethod* owner_method,
+                                                     uint32_t owner_dex_pc,
+                                                     uint64_t wait_ms) {
+  std::ostringstream oss;
+  oss << "owner locked at ";
+  if (owner_method != nullptr) {
+    PrintLocation(oss, owner_method, owner_dex_pc);
+  } else {
+    oss << "<unknown>";
+  }
+  oss << "\n    waiter";
+  ContentionSiteVisitor visitor(self, oss);
+  visitor.WalkStack();
+  std::string key = oss.str();
+
+  MutexLock mu(self, lock_);
+  auto it = call_sites_.find(key);
+  if (it == call_sites_.end()) {
+    if (call_sites_.size() == kMaxCallSites) {
+      ++dropped_samples_;
+      return;
+    }
+    it = call_sites_.emplace(std::move(key), CallSiteStats()).first;
+  }
+  CallSiteStats& stats = it->second;
+  ++stats.samples;
+  stats.total_wait_ms += wait_ms;
+  stats.max_wait_ms = std::max(stats.max_wait_ms, wait_ms);
+}
+
+size_t LockContentionProfiler::GetNumberOfSamples() {
+  MutexLock mu(Thread::Current(), lock_);
+  size_t samples = dropped_samples_;
+  for (const auto& entry : call_sites_) {
+    samples += entry.second.samples;
+  }
+  return samples;
+}
+
+void LockContentionProfiler::Dump(std::ostream& os) {
+  std::vector<std::pair<uint64_t, std::string>> sorted;
+  uint64_t dropped_samples;
+  {
+    MutexLock mu(Thread::Current(), lock_);
+    sorted.reserve(call_sites_.size());
+    for (const auto& entry : call_sites_) {
+      const CallSiteStats& stats = entry.second;
+      std::ostringstream oss;
+      oss << "  " << stats.samples << " samples, total wait " << PrettyDuration(MsToNs(
+          stats.total_wait_ms)) << ", max wait " << PrettyDuration(MsToNs(stats.max_wait_ms))
+          << "\n    " << entry.first << "\n";
+      sorted.emplace_back(stats.total_wait_ms, oss.str());
+    }
+    dropped_samples = dropped_samples_;
+  }
+  // The call sites that waited the longest first.
+  std::sort(sorted.begin(), sorted.end(), [](const auto& lhs, const auto& rhs) {
+    return lhs.first > rhs.first;
+  });
+  os << "Monitor contention profile (" << sorted.size() << " call sites, "
+     << dropped_samples << " samples dropped):\n";
+  for (const auto& entry : sorted) {
+    os << entry.second;
+  }
+}
+
+}  // namespace art
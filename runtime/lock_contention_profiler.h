@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_LOCK_CONTENTION_PROFILER_H_
+#define ART_RUNTIME_LOCK_CONTENTION_PROFILER_H_
+
+#include <iosfwd>
+#include <map>
+#include <string>
+
+#include "base/macros.h"
+#include "base/mutex.h"
+
+namespace art {
+
+class ArtMethod;
+class Thread;
+
+// Aggregates the sampled contended monitor enters by call site. Monitor::Lock() samples blocked
+// enters like the -Xlockprofthreshold logging does, so that a wait of w ms is sampled with
+// probability min(1, w / threshold). A call site is the locking method and dex pc of the owner
+// together with the innermost frames of the waiter's stack. The number of call sites is bounded,
+// samples for new call sites are counted separately once the table is full.
+//
+// The profiler exists when -Xlockprofthreshold is set, it also turns on the contention
+// statistics of runtime mutexes (see BaseMutex::SetContentionStatsEnabled()). Both are dumped on
+// SIGQUIT.
+class LockContentionProfiler {
+ public:
+  static constexpr size_t kMaxCallSites = 512;
+  static constexpr size_t kWaiterStackDepth = 4;
+
+  LockContentionProfiler();
+  ~LockContentionProfiler();
+
+  // Records a sampled monitor enter of `self` that was blocked for `wait_ms` on a monitor that
+  // its owner locked in `owner_method` at `owner_dex_pc`.
+  void RecordMonitorContention(Thread* self,
+                               ArtMethod* owner_method,
+                               uint32_t owner_dex_pc,
+                               uint64_t wait_ms)
+      REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(!lock_);
+
+  void Dump(std::ostream& os) REQUIRES(!lock_);
+
+  size_t GetNumberOfSamples() REQUIRES(!lock_);
+
+ private:
+  struct CallSiteStats {
+    CallSiteStats() : samples(0u), total_wait_ms(0u), max_wait_ms(0u) {}
+
+    uint64_t samples;
+    uint64_t total_wait_ms;
+    uint64_t max_wait_ms;
+  };
+
+  Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  // Keyed by the pretty printed owner location and waiter frames, which stay valid when classes
+  // are unloaded.
+  std::map<std::string, CallSiteStats> call_sites_ GUARDED_BY(lock_);
+  uint64_t dropped_samples_ GUARDED_BY(lock_);
+  // Whether the mutex contention statistics were on before the profiler turned them on.
+  const bool contention_stats_were_enabled_;
+
+  DISALLOW_COPY_AND_ASSIGN(LockContentionProfiler);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_LOCK_CONTENTION_PROFILER_H_
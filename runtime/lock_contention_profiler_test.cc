@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "lock_contention_profiler.h"
+
+#include <sstream>
+
+#include "base/mutex-inl.h"
+#include "common_runtime_test.h"
+#include "scoped_thread_state_change-inl.h"
+#include "thread-current-inl.h"
+#include "thread_pool.h"
+
+namespace art {
+
+class LockContentionProfilerTest : public CommonRuntimeTest {};
+
+TEST_F(LockContentionProfilerTest, MonitorCallSites) {
+  Thread* self = Thread::Current();
+  LockContentionProfiler profiler;
+  {
+    ScopedObjectAccess soa(self);
+    profiler.RecordMonitorContention(self, nullptr, 0u, 3u);
+    profiler.RecordMonitorContention(self, nullptr, 0u, 5u);
+  }
+  EXPECT_EQ(profiler.GetNumberOfSamples(), 2u);
+
+  std::ostringstream oss;
+  profiler.Dump(oss);
+  const std::string dump = oss.str();
+  // Both samples come from the same call site.
+  EXPECT_NE(dump.find("(1 call sites, 0 samples dropped)"), std::string::npos) << dump;
+  EXPECT_NE(dump.find("2 samples, total wait 8ms, max wait 5ms"), std::string::npos) << dump;
+  EXPECT_NE(dump.find("owner locked at <unknown>"), std::string::npos) << dump;
+}
+
+#if ART_USE_FUTEXES
+class LockMutexTask : public Task {
+ public:
+  explicit LockMutexTask(Mutex* mutex) : mutex_(mutex) {}
+
+  void Run(Thread* self) OVERRIDE {
+    MutexLock mu(self, *mutex_);
+  }
+
+  void Finalize() OVERRIDE {
+    delete this;
+  }
+
+ private:
+  Mutex* const mutex_;
+};
+
+TEST_F(LockContentionProfilerTest, MutexContention) {
+  Thread* self = Thread::Current();
+  LockContentionProfiler profiler;
+  Mutex mutex("Contention profiler test lock");
+  ThreadPool thread_pool("Contention profiler test thread pool", 1u);
+  {
+    MutexLock mu(self, mutex);
+    thread_pool.AddTask(self, new LockMutexTask(&mutex));
+    thread_pool.StartWorkers(self);
+    // Give the worker time to block on the mutex.
+    usleep(100 * 1000);
+  }
+  thread_pool.Wait(self, /* do_work */ false, /* may_hold_locks */ false);
+
+  // The profiler turns on the contention statistics of runtime mutexes.
+  std::ostringstream oss;
+  BaseMutex::DumpContentionStats(oss);
+  const std::string dump = oss.str();
+  size_t begin = dump.find("\"Contention profiler test lock\"");
+  ASSERT_NE(begin, std::string::npos) << dump;
+  const std::string line = dump.substr(begin, dump.find('\n', begin) - begin);
+  EXPECT_NE(line.find(" contended 1 times"), std::string::npos) << line;
+}
+#endif  // ART_USE_FUTEXES
+
+}  // namespace art
@@ -64,7 +64,13 @@ class PACKED(4) ManagedStack {
   }
 
   ArtMethod** GetTopQuickFrame() const {
-    return top_quick_frame_;
+    return reinterpret_cast<ArtMethod**>(
+        reinterpret_cast<uintptr_t>(top_quick_frame_) & ~kTopQuickFrameTagMask);
+  }
+
+  // Whether the top quick frame was tagged, i.e. it is a frame of the generic JNI trampoline.
+  bool GetTopQuickFrameTag() const {
+    return (reinterpret_cast<uintptr_t>(top_quick_frame_) & kTopQuickFrameTagMask) != 0u;
   }
 
   void SetTopQuickFrame(ArtMethod** top) {
@@ -72,6 +78,15 @@ class PACKED(4) ManagedStack {
     top_quick_frame_ = top;
   }
 
+  // Set a top quick frame of the generic JNI trampoline. The frame of a native method does not
+  // otherwise tell whether it was built by the generic JNI trampoline or by a compiled JNI stub,
+  // and the entry point of the method may change while the native code runs.
+  void SetTopQuickFrameTagged(ArtMethod** top) {
+    DCHECK(top_shadow_frame_ == nullptr);
+    top_quick_frame_ = reinterpret_cast<ArtMethod**>(
+        reinterpret_cast<uintptr_t>(top) | kTopQuickFrameTagMask);
+  }
+
   static size_t TopQuickFrameOffset() {
     return OFFSETOF_MEMBER(ManagedStack, top_quick_frame_);
   }
@@ -97,6 +112,10 @@ class PACKED(4) ManagedStack {
   bool ShadowFramesContain(StackReference<mirror::Object>* shadow_frame_entry) const;
 
  private:
+  // The tag is kept in the low bit of `top_quick_frame_`; the assembly that reloads the stack
+  // pointer from a generic JNI frame removes it.
+  static constexpr uintptr_t kTopQuickFrameTagMask = 1u;
+
   ArtMethod** top_quick_frame_;
   ManagedStack* link_;
   ShadowFrame* top_shadow_frame_;
@@ -32,6 +32,7 @@
 #include "backtrace/BacktraceMap.h"
 #include "cutils/ashmem.h"
 
+#include "base/address_range_allocator.h"
 #include "base/allocator.h"
 #include "base/bit_utils.h"
 #include "base/memory_tool.h"
@@ -140,6 +141,21 @@ static uintptr_t GenerateNextMemPos() {
 
 // Initialize linear scan to random position.
 uintptr_t MemMap::next_mem_pos_ = GenerateNextMemPos();
+
+// Size of the address range reserved in the low 4GB for low_4gb mappings. The reservation is
+// PROT_NONE and MAP_NORESERVE so it only costs address space, and the mappings are placed into it
+// with MAP_FIXED, which spares the linear scan and its probing syscalls for most requests.
+static constexpr size_t kLow4GBReservationSize = 256 * MB;
+
+// Flags of the PROT_NONE mappings backing the free ranges of the reservation.
+static constexpr int kLow4GBReservationFlags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE;
+
+using Low4GBReservation = AddressRangeAllocator<kAllocatorTagMaps>;
+
+// The free ranges of the low 4GB reservation, created on the first low_4gb request.
+static Low4GBReservation* gLow4GBReservation GUARDED_BY(MemMap::GetMemMapsLock()) = nullptr;
+// Whether the reservation could not be created, in which case we always do the linear scan.
+static bool gLow4GBReservationFailed GUARDED_BY(MemMap::GetMemMapsLock()) = false;
 #endif
 
 // Return true if the address range is contained in a single memory map by either reading
@@ -495,7 +511,7 @@ MemMap::~MemMap() {
 
   if (!reuse_) {
     MEMORY_TOOL_MAKE_UNDEFINED(base_begin_, base_size_);
-    int result = munmap(base_begin_, base_size_);
+    int result = UnmapPages(base_begin_, base_size_);
     if (result == -1) {
       PLOG(FATAL) << "munmap failed";
     }
@@ -579,13 +595,19 @@ MemMap* MemMap::RemapAtEnd(uint8_t* new_end, const char* tail_name, int tail_pro
   }
 
   MEMORY_TOOL_MAKE_UNDEFINED(tail_base_begin, tail_base_size);
-  // Unmap/map the tail region.
-  int result = munmap(tail_base_begin, tail_base_size);
-  if (result == -1) {
-    PrintFileToLog("/proc/self/maps", LogSeverity::WARNING);
-    *error_msg = StringPrintf("munmap(%p, %zd) failed for '%s'. See process maps in the log.",
-                              tail_base_begin, tail_base_size, name_.c_str());
-    return nullptr;
+  if (IsInLow4GBReservation(tail_base_begin, tail_base_size)) {
+    // Replace the tail in place, unmapping it would hand the range to other users of mmap while
+    // the reservation still considers it allocated.
+    flags |= MAP_FIXED;
+  } else {
+    // Unmap/map the tail region.
+    int result = munmap(tail_base_begin, tail_base_size);
+    if (result == -1) {
+      PrintFileToLog("/proc/self/maps", LogSeverity::WARNING);
+      *error_msg = StringPrintf("munmap(%p, %zd) failed for '%s'. See process maps in the log.",
+                                tail_base_begin, tail_base_size, name_.c_str());
+      return nullptr;
+    }
   }
   // Don't cause memory allocation between the munmap and the mmap
   // calls. Otherwise, libc (or something else) might take this memory
@@ -675,10 +697,25 @@ void MemMap::DumpMaps(std::ostream& os, bool terse) {
   DumpMapsLocked(os, terse);
 }
 
+static void DumpLow4GBReservation(std::ostream& os) REQUIRES(MemMap::GetMemMapsLock()) {
+#if USE_ART_LOW_4G_ALLOCATOR
+  if (gLow4GBReservation != nullptr) {
+    os << "Low 4GB reservation: " << reinterpret_cast<void*>(gLow4GBReservation->Begin()) << "-"
+       << reinterpret_cast<void*>(gLow4GBReservation->End())
+       << " free=" << PrettySize(gLow4GBReservation->FreeBytes())
+       << " largest free range=" << PrettySize(gLow4GBReservation->LargestFreeRange())
+       << std::endl;
+  }
+#else
+  UNUSED(os);
+#endif
+}
+
 void MemMap::DumpMapsLocked(std::ostream& os, bool terse) {
   const auto& mem_maps = *gMaps;
   if (!terse) {
     os << mem_maps;
+    DumpLow4GBReservation(os);
     return;
   }
 
@@ -732,6 +769,7 @@ void MemMap::DumpMapsLocked(std::ostream& os, bool terse) {
     }
     os << " prot=0x" << std::hex << map->GetProtect() << " " << map->GetName() << "]" << std::endl;
   }
+  DumpLow4GBReservation(os);
 }
 
 bool MemMap::HasMemMap(MemMap* map) {
@@ -784,6 +822,17 @@ void MemMap::Shutdown() {
     DCHECK(gMaps != nullptr);
     delete gMaps;
     gMaps = nullptr;
+#if USE_ART_LOW_4G_ALLOCATOR
+    if (gLow4GBReservation != nullptr) {
+      // Release the free ranges, the allocated ones belong to maps that were not deleted.
+      gLow4GBReservation->VisitFreeRanges([](uintptr_t begin, size_t size) {
+        munmap(reinterpret_cast<void*>(begin), size);
+      });
+      delete gLow4GBReservation;
+      gLow4GBReservation = nullptr;
+    }
+    gLow4GBReservationFailed = false;
+#endif
   }
   delete mem_maps_lock_;
   mem_maps_lock_ = nullptr;
@@ -800,8 +849,8 @@ void MemMap::SetSize(size_t new_size) {
       reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(BaseBegin()) +
                               new_size),
       base_size_ - new_size);
-  CHECK_EQ(munmap(reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(BaseBegin()) + new_size),
-                  base_size_ - new_size), 0) << new_size << " " << base_size_;
+  CHECK_EQ(UnmapPages(reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(BaseBegin()) + new_size),
+                       base_size_ - new_size), 0) << new_size << " " << base_size_;
   base_size_ = new_size;
   size_ = new_size;
 }
@@ -811,12 +860,26 @@ void* MemMap::MapInternalArtLow4GBAllocator(size_t length,
                                             int flags,
                                             int fd,
                                             off_t offset) {
+#if USE_ART_LOW_4G_ALLOCATOR
+  std::lock_guard<std::mutex> mu(*mem_maps_lock_);
+  void* actual = MapFromLow4GBReservation(nullptr, length, prot, flags, fd, offset);
+  if (actual != MAP_FAILED) {
+    return actual;
+  }
+  return ScanLow4GB(length, prot, flags, fd, offset);
+#else
+  UNUSED(length, prot, flags, fd, offset);
+  LOG(FATAL) << "Unreachable";
+  UNREACHABLE();
+#endif
+}
+
+void* MemMap::ScanLow4GB(size_t length, int prot, int flags, int fd, off_t offset) {
 #if USE_ART_LOW_4G_ALLOCATOR
   void* actual = MAP_FAILED;
 
   bool first_run = true;
 
-  std::lock_guard<std::mutex> mu(*mem_maps_lock_);
   for (uintptr_t ptr = next_mem_pos_; ptr < 4 * GB; ptr += kPageSize) {
     // Use gMaps as an optimization to skip over large maps.
     // Find the first map which is address > ptr.
@@ -841,6 +904,12 @@ void* MemMap::MapInternalArtLow4GBAllocator(size_t length,
       ++it;
     }
 
+    // The reservation is not in gMaps, skip over it.
+    if (gLow4GBReservation != nullptr && gLow4GBReservation->Overlaps(ptr, length)) {
+      ptr = gLow4GBReservation->End() - kPageSize;
+      continue;
+    }
+
     // Try to see if we get lucky with this address since none of the ART maps overlap.
     actual = TryMemMapLow4GB(reinterpret_cast<void*>(ptr), length, prot, flags, fd, offset);
     if (actual != MAP_FAILED) {
@@ -899,6 +968,97 @@ void* MemMap::MapInternalArtLow4GBAllocator(size_t length,
 #endif
 }
 
+void* MemMap::MapFromLow4GBReservation(void* addr,
+                                       size_t length,
+                                       int prot,
+                                       int flags,
+                                       int fd,
+                                       off_t offset) {
+#if USE_ART_LOW_4G_ALLOCATOR
+  DCHECK_EQ(flags & MAP_FIXED, 0);
+  uintptr_t begin;
+  if (addr == nullptr) {
+    if (gLow4GBReservation == nullptr) {
+      if (gLow4GBReservationFailed) {
+        return MAP_FAILED;
+      }
+      void* reservation = ScanLow4GB(kLow4GBReservationSize,
+                                     PROT_NONE,
+                                     kLow4GBReservationFlags,
+                                     /* fd */ -1,
+                                     /* offset */ 0);
+      if (reservation == MAP_FAILED) {
+        LOG(WARNING) << "Could not reserve " << PrettySize(kLow4GBReservationSize)
+                     << " in the low 4GB, using the linear scan for all low_4gb maps";
+        gLow4GBReservationFailed = true;
+        return MAP_FAILED;
+      }
+      uintptr_t reservation_begin = reinterpret_cast<uintptr_t>(reservation);
+      gLow4GBReservation = new Low4GBReservation(reservation_begin,
+                                                 reservation_begin + kLow4GBReservationSize,
+                                                 kPageSize);
+    }
+    begin = gLow4GBReservation->Allocate(length);
+    if (begin == 0u) {
+      return MAP_FAILED;
+    }
+  } else {
+    begin = reinterpret_cast<uintptr_t>(addr);
+    if (gLow4GBReservation == nullptr || !gLow4GBReservation->AllocateAt(begin, length)) {
+      return MAP_FAILED;
+    }
+  }
+  void* actual = mmap(reinterpret_cast<void*>(begin), length, prot, flags | MAP_FIXED, fd, offset);
+  if (actual == MAP_FAILED) {
+    int saved_errno = errno;
+    // A failed MAP_FIXED mmap may already have unmapped the range, reserve it again.
+    if (mmap(reinterpret_cast<void*>(begin),
+             length,
+             PROT_NONE,
+             kLow4GBReservationFlags | MAP_FIXED,
+             -1,
+             0) == MAP_FAILED) {
+      PLOG(WARNING) << "Could not restore the low 4GB reservation at "
+                    << reinterpret_cast<void*>(begin);
+    } else {
+      gLow4GBReservation->Free(begin, length);
+    }
+    errno = saved_errno;
+  }
+  return actual;
+#else
+  UNUSED(addr, length, prot, flags, fd, offset);
+  return MAP_FAILED;
+#endif
+}
+
+bool MemMap::IsInLow4GBReservation(void* addr, size_t length) {
+#if USE_ART_LOW_4G_ALLOCATOR
+  std::lock_guard<std::mutex> mu(*mem_maps_lock_);
+  return gLow4GBReservation != nullptr &&
+      gLow4GBReservation->Contains(reinterpret_cast<uintptr_t>(addr), length);
+#else
+  UNUSED(addr, length);
+  return false;
+#endif
+}
+
+int MemMap::UnmapPages(void* addr, size_t length) {
+#if USE_ART_LOW_4G_ALLOCATOR
+  std::lock_guard<std::mutex> mu(*mem_maps_lock_);
+  uintptr_t begin = reinterpret_cast<uintptr_t>(addr);
+  if (gLow4GBReservation != nullptr && gLow4GBReservation->Contains(begin, length)) {
+    // Keep the range reserved so that nobody else maps it while it is free.
+    if (mmap(addr, length, PROT_NONE, kLow4GBReservationFlags | MAP_FIXED, -1, 0) == MAP_FAILED) {
+      return -1;
+    }
+    gLow4GBReservation->Free(begin, length);
+    return 0;
+  }
+#endif
+  return munmap(addr, length);
+}
+
 void* MemMap::MapInternal(void* addr,
                           size_t length,
                           int prot,
@@ -950,7 +1110,7 @@ void* MemMap::MapInternal(void* addr,
     if (orig_prot != prot_non_exec) {
       if (mprotect(actual, length, orig_prot) != 0) {
         PLOG(ERROR) << "Could not protect to requested prot: " << orig_prot;
-        munmap(actual, length);
+        UnmapPages(actual, length);
         errno = ENOMEM;
         return MAP_FAILED;
       }
@@ -958,6 +1118,14 @@ void* MemMap::MapInternal(void* addr,
     return actual;
   }
 
+  if (addr != nullptr && (flags & MAP_FIXED) == 0) {
+    // The kernel does not honor a hint inside the reservation, map free reserved ranges ourselves.
+    std::lock_guard<std::mutex> mu(*mem_maps_lock_);
+    actual = MapFromLow4GBReservation(addr, length, prot, flags, fd, offset);
+    if (actual != MAP_FAILED) {
+      return actual;
+    }
+  }
   actual = mmap(addr, length, prot, flags, fd, offset);
 #else
 #if defined(__LP64__)
@@ -995,14 +1163,16 @@ void MemMap::TryReadable() {
   }
 }
 
-void ZeroAndReleasePages(void* address, size_t length) {
+void ZeroAndReleasePages(void* address, size_t length, size_t release_granularity) {
+  DCHECK(IsPowerOfTwo(release_granularity));
+  DCHECK_GE(release_granularity, kPageSize);
   if (length == 0) {
     return;
   }
   uint8_t* const mem_begin = reinterpret_cast<uint8_t*>(address);
   uint8_t* const mem_end = mem_begin + length;
-  uint8_t* const page_begin = AlignUp(mem_begin, kPageSize);
-  uint8_t* const page_end = AlignDown(mem_end, kPageSize);
+  uint8_t* const page_begin = AlignUp(mem_begin, release_granularity);
+  uint8_t* const page_end = AlignDown(mem_end, release_granularity);
   if (!kMadviseZeroes || page_begin >= page_end) {
     // No possible area to madvise.
     std::fill(mem_begin, mem_end, 0);
@@ -1017,6 +1187,19 @@ void ZeroAndReleasePages(void* address, size_t length) {
   }
 }
 
+bool MemMap::AdviseHugePages() {
+#ifdef MADV_HUGEPAGE
+  if (base_size_ == 0) {
+    return true;
+  }
+  if (madvise(base_begin_, base_size_, MADV_HUGEPAGE) == 0) {
+    return true;
+  }
+  PLOG(WARNING) << "madvise(MADV_HUGEPAGE) failed for " << name_;
+#endif
+  return false;
+}
+
 void MemMap::AlignBy(size_t size) {
   CHECK_EQ(begin_, base_begin_) << "Unsupported";
   CHECK_EQ(size_, base_size_) << "Unsupported";
@@ -1041,13 +1224,13 @@ void MemMap::AlignBy(size_t size) {
   // Unmap the unaligned parts.
   if (base_begin < aligned_base_begin) {
     MEMORY_TOOL_MAKE_UNDEFINED(base_begin, aligned_base_begin - base_begin);
-    CHECK_EQ(munmap(base_begin, aligned_base_begin - base_begin), 0)
+    CHECK_EQ(UnmapPages(base_begin, aligned_base_begin - base_begin), 0)
         << "base_begin=" << reinterpret_cast<void*>(base_begin)
         << " aligned_base_begin=" << reinterpret_cast<void*>(aligned_base_begin);
   }
   if (aligned_base_end < base_end) {
     MEMORY_TOOL_MAKE_UNDEFINED(aligned_base_end, base_end - aligned_base_end);
-    CHECK_EQ(munmap(aligned_base_end, base_end - aligned_base_end), 0)
+    CHECK_EQ(UnmapPages(aligned_base_end, base_end - aligned_base_end), 0)
         << "base_end=" << reinterpret_cast<void*>(base_end)
         << " aligned_base_end=" << reinterpret_cast<void*>(aligned_base_end);
   }
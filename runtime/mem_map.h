@@ -25,6 +25,7 @@
 #include <string>
 
 #include "android-base/thread_annotations.h"
+#include "globals.h"
 
 namespace art {
 
@@ -45,9 +46,10 @@ static constexpr bool kMadviseZeroes = false;
 
 // Used to keep track of mmap segments.
 //
-// On 64b systems not supporting MAP_32BIT, the implementation of MemMap will do a linear scan
-// for free pages. For security, the start of this scan should be randomized. This requires a
-// dynamic initializer.
+// On 64b systems not supporting MAP_32BIT, the implementation of MemMap reserves an address range
+// in the low 4GB on the first low_4gb request and sub-allocates from it. Requests that do not fit
+// into the reservation fall back to a linear scan for free pages. For security, the start of this
+// scan should be randomized. This requires a dynamic initializer.
 // For this to work, it is paramount that there are no other static initializers that access MemMap.
 // Otherwise, calls might see uninitialized values.
 class MemMap {
@@ -70,6 +72,11 @@ class MemMap {
                               std::string* error_msg,
                               bool use_ashmem = true);
 
+  // Ask the kernel to back the map with transparent huge pages. Only effective for private
+  // anonymous maps, i.e. ones created with use_ashmem false. Returns false if huge pages are not
+  // supported.
+  bool AdviseHugePages();
+
   // Create placeholder for a region allocated by direct call to mmap.
   // This is useful when we do not have control over the code calling mmap,
   // but when we still want to keep track of it in the list.
@@ -232,6 +239,22 @@ class MemMap {
                                              int fd,
                                              off_t offset)
       REQUIRES(!MemMap::mem_maps_lock_);
+  static void* ScanLow4GB(size_t length, int prot, int flags, int fd, off_t offset)
+      REQUIRES(MemMap::mem_maps_lock_);
+  // Map [addr, addr + length) from the low 4GB reservation, or any free range of the reservation
+  // if addr is null. Returns MAP_FAILED if the reservation cannot satisfy the request.
+  static void* MapFromLow4GBReservation(void* addr,
+                                        size_t length,
+                                        int prot,
+                                        int flags,
+                                        int fd,
+                                        off_t offset)
+      REQUIRES(MemMap::mem_maps_lock_);
+  static bool IsInLow4GBReservation(void* addr, size_t length)
+      REQUIRES(!MemMap::mem_maps_lock_);
+  // Unmap pages, or return them to the low 4GB reservation if they were allocated from it.
+  static int UnmapPages(void* addr, size_t length)
+      REQUIRES(!MemMap::mem_maps_lock_);
 
   const std::string name_;
   uint8_t* begin_;  // Start of data. May be changed by AlignBy.
@@ -259,8 +282,10 @@ class MemMap {
 
 std::ostream& operator<<(std::ostream& os, const MemMap& mem_map);
 
-// Zero and release pages if possible, no requirements on alignments.
-void ZeroAndReleasePages(void* address, size_t length);
+// Zero and release pages if possible, no requirements on alignments. Only whole units of
+// release_granularity are released, the rest is zeroed in place. Mappings backed by huge pages
+// pass kHugePageSize so that releasing memory does not split the huge pages.
+void ZeroAndReleasePages(void* address, size_t length, size_t release_granularity = kPageSize);
 
 }  // namespace art
 
@@ -18,7 +18,9 @@
 
 #include <sys/mman.h>
 
+#include <algorithm>
 #include <memory>
+#include <vector>
 
 #include "common_runtime_test.h"
 #include "base/memory_tool.h"
@@ -141,6 +143,49 @@ TEST_F(MemMapTest, Start) {
 #endif
   // End of test.
 }
+
+TEST_F(MemMapTest, MapAnonymousLow4GBReuseFreedRange) {
+  CommonInit();
+  std::string error_msg;
+  std::vector<std::unique_ptr<MemMap>> maps;
+  for (size_t i = 0; i != 16u; ++i) {
+    maps.emplace_back(MemMap::MapAnonymous("MapAnonymousLow4GBReuseFreedRange",
+                                           nullptr,
+                                           (i % 4u + 1u) * kPageSize,
+                                           PROT_READ | PROT_WRITE,
+                                           /*low_4gb*/true,
+                                           /*reuse*/false,
+                                           &error_msg));
+    ASSERT_TRUE(maps.back() != nullptr) << error_msg;
+    ASSERT_LT(reinterpret_cast<uintptr_t>(maps.back()->End()), 4 * GB);
+    memset(maps.back()->Begin(), 42, maps.back()->Size());
+  }
+  // The range of an unmapped low 4GB map is handed out again, both when asked for explicitly and
+  // as the best fit, and its contents are cleared.
+  uint8_t* freed_begin = maps[5]->Begin();
+  size_t freed_size = maps[5]->Size();
+  maps[5].reset();
+  std::unique_ptr<MemMap> map(MemMap::MapAnonymous("MapAnonymousLow4GBReuseFreedRange",
+                                                   freed_begin,
+                                                   freed_size,
+                                                   PROT_READ | PROT_WRITE,
+                                                   /*low_4gb*/true,
+                                                   /*reuse*/false,
+                                                   &error_msg));
+  ASSERT_TRUE(map != nullptr) << error_msg;
+  EXPECT_EQ(freed_begin, map->Begin());
+  EXPECT_EQ(0, map->Begin()[0]);
+  map.reset();
+  map.reset(MemMap::MapAnonymous("MapAnonymousLow4GBReuseFreedRange",
+                                 nullptr,
+                                 freed_size,
+                                 PROT_READ,
+                                 /*low_4gb*/true,
+                                 /*reuse*/false,
+                                 &error_msg));
+  ASSERT_TRUE(map != nullptr) << error_msg;
+  EXPECT_EQ(freed_begin, map->Begin());
+}
 #endif
 
 TEST_F(MemMapTest, MapAnonymousEmpty) {
@@ -537,4 +582,30 @@ TEST_F(MemMapTest, AlignBy) {
   }
 }
 
+TEST_F(MemMapTest, ZeroAndReleaseHugePages) {
+  CommonInit();
+  std::string error_msg;
+  const size_t size = 3 * kHugePageSize;
+  std::unique_ptr<MemMap> map(MemMap::MapAnonymous("MemMapTest_ZeroAndReleaseHugePages",
+                                                   nullptr,
+                                                   size,
+                                                   PROT_READ | PROT_WRITE,
+                                                   false,
+                                                   false,
+                                                   &error_msg,
+                                                   /* use_ashmem */ false));
+  ASSERT_TRUE(map != nullptr) << error_msg;
+  // Huge pages may not be available, the advice must not change the contents either way.
+  map->AdviseHugePages();
+  std::fill(map->Begin(), map->End(), 0xAB);
+  // Start and end off huge page boundaries so that both partial and whole units are cleared.
+  uint8_t* const begin = map->Begin() + kPageSize + 1;
+  uint8_t* const end = map->End() - kPageSize - 1;
+  ZeroAndReleasePages(begin, end - begin, kHugePageSize);
+  for (uint8_t* ptr = map->Begin(); ptr < map->End(); ++ptr) {
+    const uint8_t expected = (ptr >= begin && ptr < end) ? 0 : 0xAB;
+    ASSERT_EQ(*ptr, expected) << ptr - map->Begin();
+  }
+}
+
 }  // namespace art
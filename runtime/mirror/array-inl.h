@@ -21,6 +21,7 @@
 
 #include "android-base/stringprintf.h"
 
+#include "array_copy.h"
 #include "base/bit_utils.h"
 #include "base/casts.h"
 #include "base/logging.h"
@@ -270,30 +271,6 @@ inline void PrimitiveArray<T>::SetWithoutChecks(int32_t i, T value) {
   DCHECK(CheckIsValidIndex<kVerifyFlags>(i));
   GetData()[i] = value;
 }
-// Backward copy where elements are of aligned appropriately for T. Count is in T sized units.
-// Copies are guaranteed not to tear when the sizeof T is less-than 64bit.
-template<typename T>
-static inline void ArrayBackwardCopy(T* d, const T* s, int32_t count) {
-  d += count;
-  s += count;
-  for (int32_t i = 0; i < count; ++i) {
-    d--;
-    s--;
-    *d = *s;
-  }
-}
-
-// Forward copy where elements are of aligned appropriately for T. Count is in T sized units.
-// Copies are guaranteed not to tear when the sizeof T is less-than 64bit.
-template<typename T>
-static inline void ArrayForwardCopy(T* d, const T* s, int32_t count) {
-  for (int32_t i = 0; i < count; ++i) {
-    *d = *s;
-    d++;
-    s++;
-  }
-}
-
 template<class T>
 inline void PrimitiveArray<T>::Memmove(int32_t dst_pos,
                                        ObjPtr<PrimitiveArray<T>> src,
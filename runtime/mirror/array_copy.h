@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_MIRROR_ARRAY_COPY_H_
+#define ART_RUNTIME_MIRROR_ARRAY_COPY_H_
+
+#include <stdint.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "base/logging.h"
+#include "base/macros.h"
+
+namespace art {
+namespace mirror {
+
+// Whether the array copies below move 16 bytes at a time with vector loads and stores. SSE2 and
+// NEON are part of the baseline of the targets that have them.
+#if defined(__SSE2__) || defined(__ARM_NEON__) || defined(__aarch64__)
+static constexpr bool kVectorizedArrayCopy = true;
+#else
+static constexpr bool kVectorizedArrayCopy = false;
+#endif
+static constexpr size_t kArrayCopyVectorSize = 16;
+
+// Copy one vector of T elements. This does not tear elements of less than 64 bits: NEON accesses
+// are single-copy atomic for each element and x86 does not split aligned 32-bit accesses.
+template<typename T>
+inline void ArrayCopyVector(T* d, const T* s) {
+#if defined(__SSE2__)
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(d),
+                   _mm_loadu_si128(reinterpret_cast<const __m128i*>(s)));
+#elif defined(__ARM_NEON__) || defined(__aarch64__)
+  if (sizeof(T) == sizeof(uint16_t)) {
+    vst1q_u16(reinterpret_cast<uint16_t*>(d), vld1q_u16(reinterpret_cast<const uint16_t*>(s)));
+  } else if (sizeof(T) == sizeof(uint32_t)) {
+    vst1q_u32(reinterpret_cast<uint32_t*>(d), vld1q_u32(reinterpret_cast<const uint32_t*>(s)));
+  } else {
+    static_assert(sizeof(T) <= sizeof(uint64_t), "Unexpected element size");
+    vst1q_u64(reinterpret_cast<uint64_t*>(d), vld1q_u64(reinterpret_cast<const uint64_t*>(s)));
+  }
+#else
+  UNUSED(d, s);
+  LOG(FATAL) << "Unreachable";
+#endif
+}
+
+// Backward copy where elements are of aligned appropriately for T. Count is in T sized units.
+// Copies are guaranteed not to tear when the sizeof T is less-than 64bit.
+template<typename T>
+inline void ArrayBackwardCopy(T* d, const T* s, int32_t count) {
+  d += count;
+  s += count;
+  if (kVectorizedArrayCopy) {
+    // Each vector is loaded before the overlapping part of the source is overwritten.
+    static constexpr int32_t kElementsPerVector = kArrayCopyVectorSize / sizeof(T);
+    for (; count >= kElementsPerVector; count -= kElementsPerVector) {
+      d -= kElementsPerVector;
+      s -= kElementsPerVector;
+      ArrayCopyVector(d, s);
+    }
+  }
+  for (int32_t i = 0; i < count; ++i) {
+    d--;
+    s--;
+    *d = *s;
+  }
+}
+
+// Forward copy where elements are of aligned appropriately for T. Count is in T sized units.
+// Copies are guaranteed not to tear when the sizeof T is less-than 64bit.
+template<typename T>
+inline void ArrayForwardCopy(T* d, const T* s, int32_t count) {
+  if (kVectorizedArrayCopy) {
+    static constexpr int32_t kElementsPerVector = kArrayCopyVectorSize / sizeof(T);
+    for (; count >= kElementsPerVector; count -= kElementsPerVector) {
+      ArrayCopyVector(d, s);
+      d += kElementsPerVector;
+      s += kElementsPerVector;
+    }
+  }
+  for (int32_t i = 0; i < count; ++i) {
+    *d = *s;
+    d++;
+    s++;
+  }
+}
+
+}  // namespace mirror
+}  // namespace art
+
+#endif  // ART_RUNTIME_MIRROR_ARRAY_COPY_H_
@@ -55,14 +55,22 @@ inline uint32_t DexCache::ClassSize(PointerSize pointer_size) {
 
 inline uint32_t DexCache::StringSlotIndex(dex::StringIndex string_idx) {
   DCHECK_LT(string_idx.index_, GetDexFile()->NumStringIds());
-  const uint32_t slot_idx = string_idx.index_ % kDexCacheStringCacheSize;
+  const uint32_t slot_idx = SlotIndex(string_idx.index_, NumStrings());
   DCHECK_LT(slot_idx, NumStrings());
   return slot_idx;
 }
 
+inline void DexCache::RecordLookup(LookupKind kind, bool hit) {
+  if (kCountLookups) {
+    (hit ? lookup_hits_ : lookup_misses_)[kind].FetchAndAddRelaxed(1u);
+  }
+}
+
 inline String* DexCache::GetResolvedString(dex::StringIndex string_idx) {
-  return GetStrings()[StringSlotIndex(string_idx)].load(
+  String* string = GetStrings()[StringSlotIndex(string_idx)].load(
       std::memory_order_relaxed).GetObjectForIndex(string_idx.index_);
+  RecordLookup(kLookupString, string != nullptr);
+  return string;
 }
 
 inline void DexCache::SetResolvedString(dex::StringIndex string_idx, ObjPtr<String> resolved) {
@@ -91,7 +99,7 @@ inline void DexCache::ClearString(dex::StringIndex string_idx) {
 
 inline uint32_t DexCache::TypeSlotIndex(dex::TypeIndex type_idx) {
   DCHECK_LT(type_idx.index_, GetDexFile()->NumTypeIds());
-  const uint32_t slot_idx = type_idx.index_ % kDexCacheTypeCacheSize;
+  const uint32_t slot_idx = SlotIndex(type_idx.index_, NumResolvedTypes());
   DCHECK_LT(slot_idx, NumResolvedTypes());
   return slot_idx;
 }
@@ -99,8 +107,10 @@ inline uint32_t DexCache::TypeSlotIndex(dex::TypeIndex type_idx) {
 inline Class* DexCache::GetResolvedType(dex::TypeIndex type_idx) {
   // It is theorized that a load acquire is not required since obtaining the resolved class will
   // always have an address dependency or a lock.
-  return GetResolvedTypes()[TypeSlotIndex(type_idx)].load(
+  Class* type = GetResolvedTypes()[TypeSlotIndex(type_idx)].load(
       std::memory_order_relaxed).GetObjectForIndex(type_idx.index_);
+  RecordLookup(kLookupType, type != nullptr);
+  return type;
 }
 
 inline void DexCache::SetResolvedType(dex::TypeIndex type_idx, ObjPtr<Class> resolved) {
@@ -178,7 +188,7 @@ inline CallSite* DexCache::SetResolvedCallSite(uint32_t call_site_idx, CallSite*
 
 inline uint32_t DexCache::FieldSlotIndex(uint32_t field_idx) {
   DCHECK_LT(field_idx, GetDexFile()->NumFieldIds());
-  const uint32_t slot_idx = field_idx % kDexCacheFieldCacheSize;
+  const uint32_t slot_idx = SlotIndex(field_idx, NumResolvedFields());
   DCHECK_LT(slot_idx, NumResolvedFields());
   return slot_idx;
 }
@@ -186,7 +196,9 @@ inline uint32_t DexCache::FieldSlotIndex(uint32_t field_idx) {
 inline ArtField* DexCache::GetResolvedField(uint32_t field_idx, PointerSize ptr_size) {
   DCHECK_EQ(Runtime::Current()->GetClassLinker()->GetImagePointerSize(), ptr_size);
   auto pair = GetNativePairPtrSize(GetResolvedFields(), FieldSlotIndex(field_idx), ptr_size);
-  return pair.GetObjectForIndex(field_idx);
+  ArtField* field = pair.GetObjectForIndex(field_idx);
+  RecordLookup(kLookupField, field != nullptr);
+  return field;
 }
 
 inline void DexCache::SetResolvedField(uint32_t field_idx, ArtField* field, PointerSize ptr_size) {
@@ -218,7 +230,9 @@ inline uint32_t DexCache::MethodSlotIndex(uint32_t method_idx) {
 inline ArtMethod* DexCache::GetResolvedMethod(uint32_t method_idx, PointerSize ptr_size) {
   DCHECK_EQ(Runtime::Current()->GetClassLinker()->GetImagePointerSize(), ptr_size);
   auto pair = GetNativePairPtrSize(GetResolvedMethods(), MethodSlotIndex(method_idx), ptr_size);
-  return pair.GetObjectForIndex(method_idx);
+  ArtMethod* method = pair.GetObjectForIndex(method_idx);
+  RecordLookup(kLookupMethod, method != nullptr);
+  return method;
 }
 
 inline void DexCache::SetResolvedMethod(uint32_t method_idx,
@@ -355,8 +369,10 @@ inline void DexCache::FixupStrings(StringDexCacheType* dest, const Visitor& visi
     StringDexCachePair source = src[i].load(std::memory_order_relaxed);
     String* ptr = source.object.Read<kReadBarrierOption>();
     String* new_source = visitor(ptr);
-    source.object = GcRoot<String>(new_source);
-    dest[i].store(source, std::memory_order_relaxed);
+    if (dest != src || ptr != new_source) {
+      source.object = GcRoot<String>(new_source);
+      dest[i].store(source, std::memory_order_relaxed);
+    }
   }
 }
 
@@ -367,8 +383,10 @@ inline void DexCache::FixupResolvedTypes(TypeDexCacheType* dest, const Visitor&
     TypeDexCachePair source = src[i].load(std::memory_order_relaxed);
     Class* ptr = source.object.Read<kReadBarrierOption>();
     Class* new_source = visitor(ptr);
-    source.object = GcRoot<Class>(new_source);
-    dest[i].store(source, std::memory_order_relaxed);
+    if (dest != src || ptr != new_source) {
+      source.object = GcRoot<Class>(new_source);
+      dest[i].store(source, std::memory_order_relaxed);
+    }
   }
 }
 
@@ -380,8 +398,10 @@ inline void DexCache::FixupResolvedMethodTypes(MethodTypeDexCacheType* dest,
     MethodTypeDexCachePair source = src[i].load(std::memory_order_relaxed);
     MethodType* ptr = source.object.Read<kReadBarrierOption>();
     MethodType* new_source = visitor(ptr);
-    source.object = GcRoot<MethodType>(new_source);
-    dest[i].store(source, std::memory_order_relaxed);
+    if (dest != src || ptr != new_source) {
+      source.object = GcRoot<MethodType>(new_source);
+      dest[i].store(source, std::memory_order_relaxed);
+    }
   }
 }
 
@@ -392,7 +412,9 @@ inline void DexCache::FixupResolvedCallSites(GcRoot<mirror::CallSite>* dest,
   for (size_t i = 0, count = NumResolvedCallSites(); i < count; ++i) {
     mirror::CallSite* source = src[i].Read<kReadBarrierOption>();
     mirror::CallSite* new_source = visitor(source);
-    dest[i] = GcRoot<mirror::CallSite>(new_source);
+    if (dest != src || source != new_source) {
+      dest[i] = GcRoot<mirror::CallSite>(new_source);
+    }
   }
 }
 
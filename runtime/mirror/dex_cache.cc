@@ -70,22 +70,10 @@ void DexCache::InitializeDexCache(Thread* self,
   FieldDexCacheType* fields = (dex_file->NumFieldIds() == 0u) ? nullptr :
       reinterpret_cast<FieldDexCacheType*>(raw_arrays + layout.FieldsOffset());
 
-  size_t num_strings = kDexCacheStringCacheSize;
-  if (dex_file->NumStringIds() < num_strings) {
-    num_strings = dex_file->NumStringIds();
-  }
-  size_t num_types = kDexCacheTypeCacheSize;
-  if (dex_file->NumTypeIds() < num_types) {
-    num_types = dex_file->NumTypeIds();
-  }
-  size_t num_fields = kDexCacheFieldCacheSize;
-  if (dex_file->NumFieldIds() < num_fields) {
-    num_fields = dex_file->NumFieldIds();
-  }
-  size_t num_methods = kDexCacheMethodCacheSize;
-  if (dex_file->NumMethodIds() < num_methods) {
-    num_methods = dex_file->NumMethodIds();
-  }
+  size_t num_strings = StringCacheSize(dex_file->NumStringIds());
+  size_t num_types = TypeCacheSize(dex_file->NumTypeIds());
+  size_t num_fields = FieldCacheSize(dex_file->NumFieldIds());
+  size_t num_methods = MethodCacheSize(dex_file->NumMethodIds());
 
   // Note that we allocate the method type dex caches regardless of this flag,
   // and we make sure here that they're not used by the runtime. This is in the
@@ -94,13 +82,7 @@ void DexCache::InitializeDexCache(Thread* self,
   // If this needs to be mitigated in a production system running this code,
   // DexCache::kDexCacheMethodTypeCacheSize can be set to zero.
   MethodTypeDexCacheType* method_types = nullptr;
-  size_t num_method_types = 0;
-
-  if (dex_file->NumProtoIds() < kDexCacheMethodTypeCacheSize) {
-    num_method_types = dex_file->NumProtoIds();
-  } else {
-    num_method_types = kDexCacheMethodTypeCacheSize;
-  }
+  size_t num_method_types = MethodTypeCacheSize(dex_file->NumProtoIds());
 
   if (num_method_types > 0) {
     method_types = reinterpret_cast<MethodTypeDexCacheType*>(
@@ -219,6 +201,28 @@ void DexCache::SetLocation(ObjPtr<mirror::String> location) {
   SetFieldObject<false>(OFFSET_OF_OBJECT_MEMBER(DexCache, location_), location);
 }
 
+Atomic<uint64_t> DexCache::lookup_hits_[kLookupKindCount];
+Atomic<uint64_t> DexCache::lookup_misses_[kLookupKindCount];
+
+void DexCache::DumpLookupStats(std::ostream& os) {
+  if (!kCountLookups) {
+    return;
+  }
+  static const char* const kLookupKindNames[] = { "strings", "types", "fields", "methods" };
+  static_assert(arraysize(kLookupKindNames) == kLookupKindCount, "Missing lookup kind name");
+  os << "Dex cache lookups:";
+  for (size_t i = 0; i != kLookupKindCount; ++i) {
+    uint64_t hits = lookup_hits_[i].LoadRelaxed();
+    uint64_t misses = lookup_misses_[i].LoadRelaxed();
+    uint64_t lookups = hits + misses;
+    os << " " << kLookupKindNames[i] << " hits=" << hits << " misses=" << misses;
+    if (lookups != 0u) {
+      os << " (" << (hits * 100u / lookups) << "% hit rate)";
+    }
+  }
+  os << "\n";
+}
+
 #if !defined(__aarch64__) && !defined(__x86_64__)
 static pthread_mutex_t dex_cache_slow_atomic_mutex = PTHREAD_MUTEX_INITIALIZER;
 
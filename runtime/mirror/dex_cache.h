@@ -187,6 +187,69 @@ class MANAGED DexCache FINAL : public Object {
     return kDexCacheMethodTypeCacheSize;
   }
 
+  // Maximum sizes of the type, string and field dex caches of big dex files. This bounds the
+  // type, string, field and method dex caches of a dex file to 272KiB on 64-bit targets.
+  static constexpr size_t kMaxDexCacheTypeCacheSize = 8 * kDexCacheTypeCacheSize;
+  static constexpr size_t kMaxDexCacheStringCacheSize = 8 * kDexCacheStringCacheSize;
+  static constexpr size_t kMaxDexCacheFieldCacheSize = 8 * kDexCacheFieldCacheSize;
+
+  // Number of ids of a big dex file per slot of its type, string and field dex caches.
+  static constexpr size_t kIdsPerCacheSlot = 4;
+
+  // Size of a dex cache for `num_ids` ids. Dex files with up to `default_size` ids get one
+  // slot per id. Bigger dex files get a power of two between `default_size` and `max_size`.
+  static size_t CacheSize(size_t num_ids, size_t default_size, size_t max_size) {
+    if (num_ids <= default_size) {
+      return num_ids;
+    }
+    size_t size = RoundUpToPowerOfTwo(num_ids / kIdsPerCacheSlot);
+    return std::min(max_size, std::max(default_size, size));
+  }
+
+  static size_t TypeCacheSize(size_t num_type_ids) {
+    return CacheSize(num_type_ids, kDexCacheTypeCacheSize, kMaxDexCacheTypeCacheSize);
+  }
+
+  static size_t StringCacheSize(size_t num_string_ids) {
+    return CacheSize(num_string_ids, kDexCacheStringCacheSize, kMaxDexCacheStringCacheSize);
+  }
+
+  static size_t FieldCacheSize(size_t num_field_ids) {
+    return CacheSize(num_field_ids, kDexCacheFieldCacheSize, kMaxDexCacheFieldCacheSize);
+  }
+
+  // The method dex cache keeps its size, the IMT conflict trampolines hash method indexes with
+  // kDexCacheMethodCacheSize.
+  static size_t MethodCacheSize(size_t num_method_ids) {
+    return CacheSize(num_method_ids, kDexCacheMethodCacheSize, kDexCacheMethodCacheSize);
+  }
+
+  static size_t MethodTypeCacheSize(size_t num_proto_ids) {
+    return CacheSize(num_proto_ids, kDexCacheMethodTypeCacheSize, kDexCacheMethodTypeCacheSize);
+  }
+
+  // Slot of the id `idx` in a dex cache of `cache_size` slots. Caches with fewer slots than ids
+  // have a power of two size, see CacheSize().
+  static uint32_t SlotIndex(uint32_t idx, size_t cache_size) {
+    DCHECK(idx < cache_size || IsPowerOfTwo(cache_size));
+    return LIKELY(idx < cache_size) ? idx : idx & (cache_size - 1u);
+  }
+
+  // Whether to count the hits and misses of the lookups in the dex caches of all dex files.
+  // They are printed by DumpLookupStats(), on SIGQUIT. The counters are shared by all threads,
+  // so this is off by default.
+  static constexpr bool kCountLookups = false;
+
+  enum LookupKind {
+    kLookupString,
+    kLookupType,
+    kLookupField,
+    kLookupMethod,
+    kLookupKindCount
+  };
+
+  static void DumpLookupStats(std::ostream& os);
+
   // Size of an instance of java.lang.DexCache not including referenced values.
   static constexpr uint32_t InstanceSize() {
     return sizeof(DexCache);
@@ -444,6 +507,8 @@ class MANAGED DexCache FINAL : public Object {
   uint32_t MethodTypeSlotIndex(uint32_t proto_idx) REQUIRES_SHARED(Locks::mutator_lock_);
 
  private:
+  static void RecordLookup(LookupKind kind, bool hit);
+
   void Init(const DexFile* dex_file,
             ObjPtr<String> location,
             StringDexCacheType* strings,
@@ -546,6 +611,9 @@ class MANAGED DexCache FINAL : public Object {
   uint32_t num_resolved_types_;         // Number of elements in the resolved_types_ array.
   uint32_t num_strings_;                // Number of elements in the strings_ array.
 
+  static Atomic<uint64_t> lookup_hits_[kLookupKindCount];
+  static Atomic<uint64_t> lookup_misses_[kLookupKindCount];
+
   friend struct art::DexCacheOffsets;  // for verifying offset information
   friend class Object;  // For VisitReferences
   DISALLOW_IMPLICIT_CONSTRUCTORS(DexCache);
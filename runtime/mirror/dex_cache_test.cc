@@ -50,18 +50,41 @@ TEST_F(DexCacheTest, Open) {
           Runtime::Current()->GetLinearAlloc())));
   ASSERT_TRUE(dex_cache != nullptr);
 
-  EXPECT_TRUE(dex_cache->StaticStringSize() == dex_cache->NumStrings()
-      || java_lang_dex_file_->NumStringIds() == dex_cache->NumStrings());
-  EXPECT_TRUE(dex_cache->StaticTypeSize() == dex_cache->NumResolvedTypes()
-      || java_lang_dex_file_->NumTypeIds() == dex_cache->NumResolvedTypes());
+  EXPECT_EQ(DexCache::StringCacheSize(java_lang_dex_file_->NumStringIds()),
+            dex_cache->NumStrings());
+  EXPECT_EQ(DexCache::TypeCacheSize(java_lang_dex_file_->NumTypeIds()),
+            dex_cache->NumResolvedTypes());
   EXPECT_TRUE(dex_cache->StaticMethodSize() == dex_cache->NumResolvedMethods()
       || java_lang_dex_file_->NumMethodIds() == dex_cache->NumResolvedMethods());
-  EXPECT_TRUE(dex_cache->StaticArtFieldSize() == dex_cache->NumResolvedFields()
-      || java_lang_dex_file_->NumFieldIds() ==  dex_cache->NumResolvedFields());
+  EXPECT_EQ(DexCache::FieldCacheSize(java_lang_dex_file_->NumFieldIds()),
+            dex_cache->NumResolvedFields());
   EXPECT_TRUE(dex_cache->StaticMethodTypeSize() == dex_cache->NumResolvedMethodTypes()
       || java_lang_dex_file_->NumProtoIds() == dex_cache->NumResolvedMethodTypes());
 }
 
+TEST_F(DexCacheTest, CacheSize) {
+  // Copies, EXPECT_EQ() takes its arguments by reference.
+  const size_t default_size = DexCache::kDexCacheTypeCacheSize;
+  const size_t ids_per_slot = DexCache::kIdsPerCacheSlot;
+  const size_t max_field_size = DexCache::kMaxDexCacheFieldCacheSize;
+  const size_t method_size = DexCache::kDexCacheMethodCacheSize;
+  // Small dex files get one slot per id.
+  EXPECT_EQ(0u, DexCache::TypeCacheSize(0u));
+  EXPECT_EQ(300u, DexCache::TypeCacheSize(300u));
+  EXPECT_EQ(default_size, DexCache::TypeCacheSize(default_size));
+  // Bigger ones a power of two, one slot per kIdsPerCacheSlot ids, within the bounds.
+  EXPECT_EQ(default_size, DexCache::TypeCacheSize(default_size + 1u));
+  EXPECT_EQ(4096u, DexCache::StringCacheSize(ids_per_slot * 3000u));
+  EXPECT_EQ(max_field_size, DexCache::FieldCacheSize(65535u));
+  EXPECT_EQ(method_size, DexCache::MethodCacheSize(65535u));
+
+  // Ids below the size map to their own slot, the others are hashed.
+  EXPECT_EQ(299u, DexCache::SlotIndex(299u, 300u));
+  EXPECT_EQ(20u, DexCache::SlotIndex(20u, 300u));
+  EXPECT_EQ(3u, DexCache::SlotIndex(4096u + 3u, 4096u));
+  EXPECT_EQ(4095u, DexCache::SlotIndex(4095u, 4096u));
+}
+
 TEST_F(DexCacheMethodHandlesTest, Open) {
   ScopedObjectAccess soa(Thread::Current());
   StackHandleScope<1> hs(soa.Self());
@@ -14,13 +14,16 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <ctime>
+#include <limits>
 
 #include "object.h"
 
 #include "art_field.h"
 #include "art_field-inl.h"
 #include "array-inl.h"
+#include "array_copy.h"
 #include "class.h"
 #include "class-inl.h"
 #include "class_linker-inl.h"
@@ -76,6 +79,17 @@ class CopyReferenceFieldsWithReadBarrierVisitor {
 Object* Object::CopyObject(ObjPtr<mirror::Object> dest,
                            ObjPtr<mirror::Object> src,
                            size_t num_bytes) {
+  // Check the GC state once, before copying. The references of an object array that is not gray
+  // for the Baker read barrier are up to date, so they need no second copy with read barriers.
+  bool copy_references_with_read_barrier = kUseReadBarrier;
+  if (kUseReadBarrier && src->IsObjectArray()) {
+    ObjPtr<ObjectArray<Object>> src_array = src->AsObjectArray<Object>();
+    if (ObjectArray<Object>::CanCopyWithoutReadBarrier(&src_array)) {
+      // Carries the fake address dependency to the loads below.
+      src = src_array;
+      copy_references_with_read_barrier = false;
+    }
+  }
   // Copy instance data.  Don't assume memcpy copies by words (b/32012820).
   {
     const size_t offset = sizeof(Object);
@@ -84,21 +98,16 @@ Object* Object::CopyObject(ObjPtr<mirror::Object> dest,
     num_bytes -= offset;
     DCHECK_ALIGNED(src_bytes, sizeof(uintptr_t));
     DCHECK_ALIGNED(dst_bytes, sizeof(uintptr_t));
-    // Use word sized copies to begin.
-    while (num_bytes >= sizeof(uintptr_t)) {
-      reinterpret_cast<Atomic<uintptr_t>*>(dst_bytes)->StoreRelaxed(
-          reinterpret_cast<Atomic<uintptr_t>*>(src_bytes)->LoadRelaxed());
-      src_bytes += sizeof(uintptr_t);
-      dst_bytes += sizeof(uintptr_t);
-      num_bytes -= sizeof(uintptr_t);
-    }
-    // Copy possible 32 bit word.
-    if (sizeof(uintptr_t) != sizeof(uint32_t) && num_bytes >= sizeof(uint32_t)) {
-      reinterpret_cast<Atomic<uint32_t>*>(dst_bytes)->StoreRelaxed(
-          reinterpret_cast<Atomic<uint32_t>*>(src_bytes)->LoadRelaxed());
-      src_bytes += sizeof(uint32_t);
-      dst_bytes += sizeof(uint32_t);
-      num_bytes -= sizeof(uint32_t);
+    // Use 32 bit word copies, vectorized where possible, to begin.
+    while (num_bytes >= sizeof(uint32_t)) {
+      const size_t num_words = std::min<size_t>(num_bytes / sizeof(uint32_t),
+                                                std::numeric_limits<int32_t>::max());
+      ArrayForwardCopy<uint32_t>(reinterpret_cast<uint32_t*>(dst_bytes),
+                                 reinterpret_cast<const uint32_t*>(src_bytes),
+                                 static_cast<int32_t>(num_words));
+      src_bytes += num_words * sizeof(uint32_t);
+      dst_bytes += num_words * sizeof(uint32_t);
+      num_bytes -= num_words * sizeof(uint32_t);
     }
     // Copy remaining bytes, avoid going past the end of num_bytes since there may be a redzone
     // there.
@@ -111,9 +120,9 @@ Object* Object::CopyObject(ObjPtr<mirror::Object> dest,
     }
   }
 
-  if (kUseReadBarrier) {
+  if (copy_references_with_read_barrier) {
     // We need a RB here. After copying the whole object above, copy references fields one by one
-    // again with a RB to make sure there are no from space refs. TODO: Optimize this later?
+    // again with a RB to make sure there are no from space refs.
     CopyReferenceFieldsWithReadBarrierVisitor visitor(dest);
     src->VisitReferences(visitor, visitor);
   }
@@ -24,6 +24,7 @@
 #include "android-base/stringprintf.h"
 
 #include "array-inl.h"
+#include "array_copy.h"
 #include "class.h"
 #include "gc/heap.h"
 #include "object-inl.h"
@@ -127,6 +128,23 @@ inline T* ObjectArray<T>::GetWithoutChecks(int32_t i) {
   return GetFieldObject<T, kVerifyFlags, kReadBarrierOption>(OffsetOfElement(i));
 }
 
+template<class T>
+inline bool ObjectArray<T>::CanCopyWithoutReadBarrier(ObjPtr<ObjectArray<T>>* src) {
+  if (!kUseReadBarrier) {
+    return true;
+  }
+  if (kUseBakerReadBarrier) {
+    uintptr_t fake_address_dependency;
+    if (!ReadBarrier::IsGray(src->Ptr(), &fake_address_dependency)) {
+      DCHECK_EQ(fake_address_dependency, 0U);
+      src->Assign(reinterpret_cast<ObjectArray<T>*>(
+          reinterpret_cast<uintptr_t>(src->Ptr()) | fake_address_dependency));
+      return true;
+    }
+  }
+  return false;
+}
+
 template<class T>
 inline void ObjectArray<T>::AssignableMemmove(int32_t dst_pos,
                                               ObjPtr<ObjectArray<T>> src,
@@ -141,61 +159,33 @@ inline void ObjectArray<T>::AssignableMemmove(int32_t dst_pos,
   // Perform the memmove using int memmove then perform the write barrier.
   static_assert(sizeof(HeapReference<T>) == sizeof(uint32_t),
                 "art::mirror::HeapReference<T> and uint32_t have different sizes.");
-  // TODO: Optimize this later?
   // We can't use memmove since it does not handle read barriers and may do by per byte copying.
   // See b/32012820.
   const bool copy_forward = (src != this) || (dst_pos < src_pos) || (dst_pos - src_pos >= count);
-  if (copy_forward) {
-    // Forward copy.
-    bool baker_non_gray_case = false;
-    if (kUseReadBarrier && kUseBakerReadBarrier) {
-      uintptr_t fake_address_dependency;
-      if (!ReadBarrier::IsGray(src.Ptr(), &fake_address_dependency)) {
-        baker_non_gray_case = true;
-        DCHECK_EQ(fake_address_dependency, 0U);
-        src.Assign(reinterpret_cast<ObjectArray<T>*>(
-            reinterpret_cast<uintptr_t>(src.Ptr()) | fake_address_dependency));
-        for (int i = 0; i < count; ++i) {
-          // We can skip the RB here because 'src' isn't gray.
-          T* obj = src->template GetWithoutChecks<kDefaultVerifyFlags, kWithoutReadBarrier>(
-              src_pos + i);
-          SetWithoutChecksAndWriteBarrier<false>(dst_pos + i, obj);
-        }
-      }
+  if (CanCopyWithoutReadBarrier(&src)) {
+    // The GC state is checked once for the whole copy, the references are copied as raw words.
+    uint32_t* d = reinterpret_cast<uint32_t*>(GetRawData(sizeof(HeapReference<T>), dst_pos));
+    const uint32_t* s =
+        reinterpret_cast<const uint32_t*>(src->GetRawData(sizeof(HeapReference<T>), src_pos));
+    if (copy_forward) {
+      ArrayForwardCopy<uint32_t>(d, s, count);
+    } else {
+      ArrayBackwardCopy<uint32_t>(d, s, count);
     }
-    if (!baker_non_gray_case) {
-      for (int i = 0; i < count; ++i) {
-        // We need a RB here. ObjectArray::GetWithoutChecks() contains a RB.
-        T* obj = src->GetWithoutChecks(src_pos + i);
-        SetWithoutChecksAndWriteBarrier<false>(dst_pos + i, obj);
-      }
+  } else if (copy_forward) {
+    for (int i = 0; i < count; ++i) {
+      // We need a RB here. ObjectArray::GetWithoutChecks() contains a RB.
+      T* obj = src->GetWithoutChecks(src_pos + i);
+      SetWithoutChecksAndWriteBarrier<false>(dst_pos + i, obj);
     }
   } else {
-    // Backward copy.
-    bool baker_non_gray_case = false;
-    if (kUseReadBarrier && kUseBakerReadBarrier) {
-      uintptr_t fake_address_dependency;
-      if (!ReadBarrier::IsGray(src.Ptr(), &fake_address_dependency)) {
-        baker_non_gray_case = true;
-        DCHECK_EQ(fake_address_dependency, 0U);
-        src.Assign(reinterpret_cast<ObjectArray<T>*>(
-            reinterpret_cast<uintptr_t>(src.Ptr()) | fake_address_dependency));
-        for (int i = count - 1; i >= 0; --i) {
-          // We can skip the RB here because 'src' isn't gray.
-          T* obj = src->template GetWithoutChecks<kDefaultVerifyFlags, kWithoutReadBarrier>(
-              src_pos + i);
-          SetWithoutChecksAndWriteBarrier<false>(dst_pos + i, obj);
-        }
-      }
-    }
-    if (!baker_non_gray_case) {
-      for (int i = count - 1; i >= 0; --i) {
-        // We need a RB here. ObjectArray::GetWithoutChecks() contains a RB.
-        T* obj = src->GetWithoutChecks(src_pos + i);
-        SetWithoutChecksAndWriteBarrier<false>(dst_pos + i, obj);
-      }
+    for (int i = count - 1; i >= 0; --i) {
+      // We need a RB here. ObjectArray::GetWithoutChecks() contains a RB.
+      T* obj = src->GetWithoutChecks(src_pos + i);
+      SetWithoutChecksAndWriteBarrier<false>(dst_pos + i, obj);
     }
   }
+  // The card of the array covers all of its elements.
   Runtime::Current()->GetHeap()->WriteBarrierArray(this, dst_pos, count);
   if (kIsDebugBuild) {
     for (int i = 0; i < count; ++i) {
@@ -219,32 +209,22 @@ inline void ObjectArray<T>::AssignableMemcpy(int32_t dst_pos,
   // Perform the memmove using int memcpy then perform the write barrier.
   static_assert(sizeof(HeapReference<T>) == sizeof(uint32_t),
                 "art::mirror::HeapReference<T> and uint32_t have different sizes.");
-  // TODO: Optimize this later?
   // We can't use memmove since it does not handle read barriers and may do by per byte copying.
   // See b/32012820.
-  bool baker_non_gray_case = false;
-  if (kUseReadBarrier && kUseBakerReadBarrier) {
-    uintptr_t fake_address_dependency;
-    if (!ReadBarrier::IsGray(src.Ptr(), &fake_address_dependency)) {
-      baker_non_gray_case = true;
-      DCHECK_EQ(fake_address_dependency, 0U);
-      src.Assign(reinterpret_cast<ObjectArray<T>*>(
-          reinterpret_cast<uintptr_t>(src.Ptr()) | fake_address_dependency));
-      for (int i = 0; i < count; ++i) {
-        // We can skip the RB here because 'src' isn't gray.
-        Object* obj = src->template GetWithoutChecks<kDefaultVerifyFlags, kWithoutReadBarrier>(
-            src_pos + i);
-        SetWithoutChecksAndWriteBarrier<false>(dst_pos + i, obj);
-      }
-    }
-  }
-  if (!baker_non_gray_case) {
+  if (CanCopyWithoutReadBarrier(&src)) {
+    // The GC state is checked once for the whole copy, the references are copied as raw words.
+    uint32_t* d = reinterpret_cast<uint32_t*>(GetRawData(sizeof(HeapReference<T>), dst_pos));
+    const uint32_t* s =
+        reinterpret_cast<const uint32_t*>(src->GetRawData(sizeof(HeapReference<T>), src_pos));
+    ArrayForwardCopy<uint32_t>(d, s, count);
+  } else {
     for (int i = 0; i < count; ++i) {
       // We need a RB here. ObjectArray::GetWithoutChecks() contains a RB.
       T* obj = src->GetWithoutChecks(src_pos + i);
       SetWithoutChecksAndWriteBarrier<false>(dst_pos + i, obj);
     }
   }
+  // The card of the array covers all of its elements.
   Runtime::Current()->GetHeap()->WriteBarrierArray(this, dst_pos, count);
   if (kIsDebugBuild) {
     for (int i = 0; i < count; ++i) {
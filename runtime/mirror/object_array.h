@@ -106,6 +106,12 @@ class MANAGED ObjectArray: public Array {
   static MemberOffset OffsetOfElement(int32_t i);
 
  private:
+  // Whether the references of `src` can be copied as raw words, without read barriers. With the
+  // Baker read barrier this is the case if `src` is not gray, and `src` is then updated with the
+  // fake address dependency that orders the loads of its elements after its read barrier state.
+  static bool CanCopyWithoutReadBarrier(ObjPtr<ObjectArray<T>>* src)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
   // TODO fix thread safety analysis broken by the use of template. This should be
   // REQUIRES_SHARED(Locks::mutator_lock_).
   template<typename Visitor>
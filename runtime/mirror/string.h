@@ -52,6 +52,10 @@ class MANAGED String FINAL : public Object {
     return OFFSET_OF_OBJECT_MEMBER(String, count_);
   }
 
+  static MemberOffset HashCodeOffset() {
+    return OFFSET_OF_OBJECT_MEMBER(String, hash_code_);
+  }
+
   static MemberOffset ValueOffset() {
     return OFFSET_OF_OBJECT_MEMBER(String, value_);
   }
@@ -16,6 +16,7 @@
 
 #include "monitor.h"
 
+#include <algorithm>
 #include <vector>
 
 #include "android-base/stringprintf.h"
@@ -28,6 +29,7 @@
 #include "class_linker.h"
 #include "dex_file-inl.h"
 #include "dex_instruction-inl.h"
+#include "lock_contention_profiler.h"
 #include "lock_word-inl.h"
 #include "mirror/class-inl.h"
 #include "mirror/object-inl.h"
@@ -45,6 +47,18 @@ using android::base::StringPrintf;
 
 static constexpr uint64_t kLongWaitMs = 100;
 
+// Tells the CPU that we are in a spin-wait loop. This saves power and, on SMT cores, lets the
+// other hardware thread, which may be the lock owner, run faster.
+static inline void SpinPause() {
+#if defined(__i386__) || defined(__x86_64__)
+  __builtin_ia32_pause();
+#elif defined(__arm__) || defined(__aarch64__)
+  __asm__ __volatile__("yield" : : : "memory");
+#else
+  __asm__ __volatile__("" : : : "memory");
+#endif
+}
+
 /*
  * Every Object has a monitor associated with it, but not every Object is actually locked.  Even
  * the ones that are locked do not need a full-fledged monitor until a) there is actual contention
@@ -87,6 +101,7 @@ Monitor::Monitor(Thread* self, Thread* owner, mirror::Object* obj, int32_t hash_
       num_waiters_(0),
       owner_(owner),
       lock_count_(0),
+      spin_limit_(kInitialMonitorSpins),
       obj_(GcRoot<mirror::Object>(obj)),
       wait_set_(nullptr),
       hash_code_(hash_code),
@@ -110,6 +125,7 @@ Monitor::Monitor(Thread* self, Thread* owner, mirror::Object* obj, int32_t hash_
       num_waiters_(0),
       owner_(owner),
       lock_count_(0),
+      spin_limit_(kInitialMonitorSpins),
       obj_(GcRoot<mirror::Object>(obj)),
       wait_set_(nullptr),
       hash_code_(hash_code),
@@ -346,13 +362,43 @@ bool Monitor::TryLock(Thread* self) {
   return TryLockLocked(self);
 }
 
+bool Monitor::SpinWhileOwned(Thread* self) {
+  const uint32_t spin_limit = spin_limit_;
+  monitor_lock_.Unlock(self);
+  // GetOwner() is a racy read of the volatile owner_, which is fine since we retry the
+  // acquisition under monitor_lock_ anyway.
+  bool released = false;
+  for (uint32_t i = 0; i != spin_limit; ++i) {
+    if (GetOwner() == nullptr) {
+      released = true;
+      break;
+    }
+    SpinPause();
+  }
+  monitor_lock_.Lock(self);
+  if (released) {
+    spin_limit_ = (spin_limit < kMaxMonitorSpins / 2) ? spin_limit * 2 : kMaxMonitorSpins;
+  } else {
+    spin_limit_ = (spin_limit > kMinMonitorSpins * 2) ? spin_limit / 2 : kMinMonitorSpins;
+  }
+  return released;
+}
+
 void Monitor::Lock(Thread* self) {
   MutexLock mu(self, monitor_lock_);
+  bool spun = false;
   while (true) {
     if (TryLockLocked(self)) {
       return;
     }
-    // Contended.
+    // Contended. Short critical sections are common, so first spin for about as long as the
+    // owners of this monitor have recently held it, which is cheaper than blocking.
+    if (!spun) {
+      spun = true;
+      if (SpinWhileOwned(self)) {
+        continue;
+      }
+    }
     const bool log_contention = (lock_profiling_threshold_ != 0);
     uint64_t wait_start_ms = log_contention ? MilliTime() : 0;
     ArtMethod* owners_method = locking_method_;
@@ -403,6 +449,7 @@ void Monitor::Lock(Thread* self) {
       }
       if (original_owner_thread_id != 0u) {
         // Woken from contention.
+        Runtime::Current()->GetMonitorList()->RecordContention();
         if (log_contention) {
           uint64_t wait_ms = MilliTime() - wait_start_ms;
           uint32_t sample_percent;
@@ -415,6 +462,11 @@ void Monitor::Lock(Thread* self) {
             // Reacquire mutator_lock_ for logging.
             ScopedObjectAccess soa(self);
 
+            LockContentionProfiler* profiler = Runtime::Current()->GetLockContentionProfiler();
+            if (profiler != nullptr) {
+              profiler->RecordMonitorContention(self, owners_method, owners_dex_pc, wait_ms);
+            }
+
             bool owner_alive = false;
             pid_t original_owner_tid = 0;
             std::string original_owner_name;
@@ -989,15 +1041,21 @@ mirror::Object* Monitor::MonitorEnter(Thread* self, mirror::Object* obj, bool tr
           contention_count++;
           Runtime* runtime = Runtime::Current();
           if (contention_count <= runtime->GetMaxSpinsBeforeThinLockInflation()) {
-            // TODO: Consider switching the thread state to kBlocked when we are yielding.
-            // Use sched_yield instead of NanoSleep since NanoSleep can wait much longer than the
-            // parameter you pass in. This can cause thread suspension to take excessively long
-            // and make long pauses. See b/16307460.
-            // TODO: We should literally spin first, without sched_yield. Sched_yield either does
-            // nothing (at significant expense), or guarantees that we wait at least microseconds.
-            // If the owner is running, I would expect the median lock hold time to be hundreds
-            // of nanoseconds or less.
-            sched_yield();
+            // Spin first, without sched_yield. Sched_yield either does nothing (at significant
+            // expense), or guarantees that we wait at least microseconds. If the owner is
+            // running, the median lock hold time should be hundreds of nanoseconds or less.
+            bool changed = false;
+            for (uint32_t i = 0; i != kThinLockSpins && !changed; ++i) {
+              SpinPause();
+              changed = !LockWord::Equal<false>(h_obj->GetLockWord(false), lock_word);
+            }
+            if (!changed) {
+              // TODO: Consider switching the thread state to kBlocked when we are yielding.
+              // Use sched_yield instead of NanoSleep since NanoSleep can wait much longer than
+              // the parameter you pass in. This can cause thread suspension to take excessively
+              // long and make long pauses. See b/16307460.
+              sched_yield();
+            }
           } else {
             contention_count = 0;
             // No ordering required for initial lockword read. Install rereads it anyway.
@@ -1386,7 +1444,12 @@ uint32_t Monitor::GetOwnerThreadId() {
 
 MonitorList::MonitorList()
     : allow_new_monitors_(true), monitor_list_lock_("MonitorList lock", kMonitorListLock),
-      monitor_add_condition_("MonitorList disallow condition", monitor_list_lock_) {
+      monitor_add_condition_("MonitorList disallow condition", monitor_list_lock_),
+      creation_time_ns_(NanoTime()),
+      num_inflations_(0u),
+      num_deflations_(0u),
+      num_freed_(0u),
+      num_contentions_(0u) {
 }
 
 MonitorList::~MonitorList() {
@@ -1431,6 +1494,8 @@ void MonitorList::Add(Monitor* m) {
     monitor_add_condition_.WaitHoldingLocks(self);
   }
   list_.push_front(m);
+  ++num_inflations_;
+  ART_TRACE_COUNTER("Inflated monitors", list_.size());
 }
 
 void MonitorList::SweepMonitorList(IsMarkedVisitor* visitor) {
@@ -1447,11 +1512,13 @@ void MonitorList::SweepMonitorList(IsMarkedVisitor* visitor) {
                     << obj;
       MonitorPool::ReleaseMonitor(self, m);
       it = list_.erase(it);
+      ++num_freed_;
     } else {
       m->SetObject(new_obj);
       ++it;
     }
   }
+  ART_TRACE_COUNTER("Inflated monitors", list_.size());
 }
 
 size_t MonitorList::Size() {
@@ -1460,6 +1527,17 @@ size_t MonitorList::Size() {
   return list_.size();
 }
 
+void MonitorList::DumpForSigQuit(std::ostream& os) {
+  Thread* self = Thread::Current();
+  MutexLock mu(self, monitor_list_lock_);
+  const uint64_t uptime_ms = std::max<uint64_t>(NsToMs(NanoTime() - creation_time_ns_), 1u);
+  os << "Monitors: " << list_.size() << " live, "
+     << num_inflations_ << " inflated (" << (num_inflations_ * 1000u / uptime_ms) << "/s), "
+     << num_deflations_ << " deflated, "
+     << num_freed_ << " freed, "
+     << num_contentions_.LoadRelaxed() << " contended acquisitions\n";
+}
+
 class MonitorDeflateVisitor : public IsMarkedVisitor {
  public:
   MonitorDeflateVisitor() : self_(Thread::Current()), deflate_count_(0) {}
@@ -1483,6 +1561,10 @@ size_t MonitorList::DeflateMonitors() {
   MonitorDeflateVisitor visitor;
   Locks::mutator_lock_->AssertExclusiveHeld(visitor.self_);
   SweepMonitorList(&visitor);
+  {
+    MutexLock mu(visitor.self_, monitor_list_lock_);
+    num_deflations_ += visitor.deflate_count_;
+  }
   return visitor.deflate_count_;
 }
 
@@ -53,6 +53,18 @@ class Monitor {
   // a lock word. See Runtime::max_spins_before_thin_lock_inflation_.
   constexpr static size_t kDefaultMaxSpinsBeforeThinLockInflation = 50;
 
+  // Bounds and initial value of the per-monitor number of CPU pauses a contending thread spins
+  // for, waiting for the owner to release an inflated lock, before it blocks. The limit doubles
+  // when spinning acquired the monitor and halves when it did not, so that it tracks how long
+  // the owners of this monitor usually hold it.
+  constexpr static uint32_t kMinMonitorSpins = 8;
+  constexpr static uint32_t kInitialMonitorSpins = 128;
+  constexpr static uint32_t kMaxMonitorSpins = 2048;
+
+  // The number of CPU pauses a thread spins for, waiting for a thin lock owner to release the
+  // lock, before each sched_yield.
+  constexpr static uint32_t kThinLockSpins = 64;
+
   ~Monitor();
 
   static void Init(uint32_t lock_profiling_threshold, uint32_t stack_dump_lock_profiling_threshold);
@@ -153,6 +165,12 @@ class Monitor {
   }
 #endif
 
+  // Translates the provided method and pc into its declaring class' source file and line number.
+  static void TranslateLocation(ArtMethod* method, uint32_t pc,
+                                const char** source_file,
+                                int32_t* line_number)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
  private:
   Monitor(Thread* self, Thread* owner, mirror::Object* obj, int32_t hash_code)
       REQUIRES_SHARED(Locks::mutator_lock_);
@@ -208,6 +226,11 @@ class Monitor {
   void Lock(Thread* self)
       REQUIRES(!monitor_lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
+  // Releases monitor_lock_ and spins for up to spin_limit_ pauses while the monitor is owned,
+  // then reacquires monitor_lock_ and adapts spin_limit_. Returns whether the owner released
+  // the monitor.
+  bool SpinWhileOwned(Thread* self)
+      REQUIRES(monitor_lock_);
   bool Unlock(Thread* thread)
       REQUIRES(!monitor_lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
@@ -253,12 +276,6 @@ class Monitor {
       REQUIRES(!monitor_lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
-  // Translates the provided method and pc into its declaring class' source file and line number.
-  static void TranslateLocation(ArtMethod* method, uint32_t pc,
-                                const char** source_file,
-                                int32_t* line_number)
-      REQUIRES_SHARED(Locks::mutator_lock_);
-
   uint32_t GetOwnerThreadId() REQUIRES(!monitor_lock_);
 
   // Support for systrace output of monitor operations.
@@ -288,6 +305,9 @@ class Monitor {
   // Owner's recursive lock depth.
   int lock_count_ GUARDED_BY(monitor_lock_);
 
+  // How many pauses a contending thread spins for before blocking, see kInitialMonitorSpins.
+  uint32_t spin_limit_ GUARDED_BY(monitor_lock_);
+
   // What object are we part of. This is a weak root. Do not access
   // this directly, use GetObject() to read it so it will be guarded
   // by a read barrier.
@@ -336,6 +356,13 @@ class MonitorList {
   size_t DeflateMonitors() REQUIRES(!monitor_list_lock_) REQUIRES(Locks::mutator_lock_);
   size_t Size() REQUIRES(!monitor_list_lock_);
 
+  // Counts a lock acquisition that blocked because another thread owned the monitor.
+  void RecordContention() {
+    num_contentions_.FetchAndAddRelaxed(1u);
+  }
+
+  void DumpForSigQuit(std::ostream& os) REQUIRES(!monitor_list_lock_);
+
   typedef std::list<Monitor*, TrackingAllocator<Monitor*, kAllocatorTagMonitorList>> Monitors;
 
  private:
@@ -348,6 +375,14 @@ class MonitorList {
   ConditionVariable monitor_add_condition_ GUARDED_BY(monitor_list_lock_);
   Monitors list_ GUARDED_BY(monitor_list_lock_);
 
+  // Statistics since the runtime started, for DumpForSigQuit(). Monitors deflated are also freed
+  // by the next sweep, freed monitors include the ones of unreachable objects.
+  const uint64_t creation_time_ns_;
+  uint64_t num_inflations_ GUARDED_BY(monitor_list_lock_);
+  uint64_t num_deflations_ GUARDED_BY(monitor_list_lock_);
+  uint64_t num_freed_ GUARDED_BY(monitor_list_lock_);
+  Atomic<uint64_t> num_contentions_;
+
   friend class Monitor;
   DISALLOW_COPY_AND_ASSIGN(MonitorList);
 };
@@ -108,17 +108,13 @@ void MonitorPool::FreeInternal() {
 Monitor* MonitorPool::CreateMonitorInPool(Thread* self, Thread* owner, mirror::Object* obj,
                                           int32_t hash_code)
     REQUIRES_SHARED(Locks::mutator_lock_) {
-  // We are gonna allocate, so acquire the writer lock.
-  MutexLock mu(self, *Locks::allocated_monitor_ids_lock_);
-
-  // Enough space, or need to resize?
-  if (first_free_ == nullptr) {
-    VLOG(monitor) << "Allocating a new chunk.";
-    AllocateChunk();
+  // The cached monitors belong to this thread, no other thread reads their next_free_ links.
+  if (self->GetCachedMonitors() == nullptr) {
+    RefillThreadCache(self);
   }
 
-  Monitor* mon_uninitialized = first_free_;
-  first_free_ = first_free_->next_free_;
+  Monitor* mon_uninitialized = self->GetCachedMonitors();
+  self->SetCachedMonitors(mon_uninitialized->next_free_, self->GetNumberOfCachedMonitors() - 1u);
 
   // Pull out the id which was preinitialized.
   MonitorId id = mon_uninitialized->monitor_id_;
@@ -130,9 +126,6 @@ Monitor* MonitorPool::CreateMonitorInPool(Thread* self, Thread* owner, mirror::O
 }
 
 void MonitorPool::ReleaseMonitorToPool(Thread* self, Monitor* monitor) {
-  // Might be racy with allocation, so acquire lock.
-  MutexLock mu(self, *Locks::allocated_monitor_ids_lock_);
-
   // Keep the monitor id. Don't trust it's not cleared.
   MonitorId id = monitor->monitor_id_;
 
@@ -140,12 +133,23 @@ void MonitorPool::ReleaseMonitorToPool(Thread* self, Monitor* monitor) {
   // TODO: Exception safety?
   monitor->~Monitor();
 
-  // Add to the head of the free list.
-  monitor->next_free_ = first_free_;
-  first_free_ = monitor;
-
   // Rewrite monitor id.
   monitor->monitor_id_ = id;
+
+  if (self == nullptr) {
+    // Releasing on shutdown, after the threads are gone.
+    MutexLock mu(self, *Locks::allocated_monitor_ids_lock_);
+    monitor->next_free_ = first_free_;
+    first_free_ = monitor;
+    return;
+  }
+
+  // Add to the head of the thread's cache.
+  monitor->next_free_ = self->GetCachedMonitors();
+  self->SetCachedMonitors(monitor, self->GetNumberOfCachedMonitors() + 1u);
+  if (self->GetNumberOfCachedMonitors() > kMaxThreadCacheSize) {
+    FlushThreadCache(self, kThreadCacheBatchSize);
+  }
 }
 
 void MonitorPool::ReleaseMonitorsToPool(Thread* self, MonitorList::Monitors* monitors) {
@@ -154,4 +158,54 @@ void MonitorPool::ReleaseMonitorsToPool(Thread* self, MonitorList::Monitors* mon
   }
 }
 
+void MonitorPool::RefillThreadCache(Thread* self) {
+  DCHECK(self->GetCachedMonitors() == nullptr);
+  MutexLock mu(self, *Locks::allocated_monitor_ids_lock_);
+
+  // Enough space, or need to resize?
+  if (first_free_ == nullptr) {
+    VLOG(monitor) << "Allocating a new chunk.";
+    AllocateChunk();
+  }
+
+  Monitor* first = first_free_;
+  Monitor* last = first;
+  size_t count = 1u;
+  while (count != kThreadCacheBatchSize && last->next_free_ != nullptr) {
+    last = last->next_free_;
+    ++count;
+  }
+  first_free_ = last->next_free_;
+  last->next_free_ = nullptr;
+  self->SetCachedMonitors(first, count);
+}
+
+void MonitorPool::FlushThreadCache(Thread* self, size_t num_to_keep) {
+  size_t count = self->GetNumberOfCachedMonitors();
+  if (count <= num_to_keep) {
+    return;
+  }
+  // Find the monitors to flush, they follow the ones to keep.
+  Monitor* last_kept = nullptr;
+  Monitor* first = self->GetCachedMonitors();
+  for (size_t i = 0; i != num_to_keep; ++i) {
+    last_kept = first;
+    first = first->next_free_;
+  }
+  Monitor* last = first;
+  while (last->next_free_ != nullptr) {
+    last = last->next_free_;
+  }
+  if (last_kept != nullptr) {
+    last_kept->next_free_ = nullptr;
+    self->SetCachedMonitors(self->GetCachedMonitors(), num_to_keep);
+  } else {
+    self->SetCachedMonitors(nullptr, 0u);
+  }
+
+  MutexLock mu(self, *Locks::allocated_monitor_ids_lock_);
+  last->next_free_ = first_free_;
+  first_free_ = first;
+}
+
 }  // namespace art
@@ -79,6 +79,15 @@ class MonitorPool {
 #endif
   }
 
+  // Returns the free monitors cached by `self` to the shared free list, for exiting threads.
+  static void ReleaseThreadCache(Thread* self) {
+#ifndef __LP64__
+    UNUSED(self);
+#else
+    GetMonitorPool()->FlushThreadCache(self, 0u);
+#endif
+  }
+
   static MonitorId MonitorIdFromMonitor(Monitor* mon) {
 #ifndef __LP64__
     return reinterpret_cast<MonitorId>(mon) >> LockWord::kMonitorIdAlignmentShift;
@@ -122,12 +131,21 @@ class MonitorPool {
   // so ignore thead-safety analysis.
   void FreeInternal() NO_THREAD_SAFETY_ANALYSIS;
 
+  // The monitors cached by a thread are only accessed by that thread, so the functions using the
+  // cache do not hold the allocated_monitor_ids_lock_ for their next_free_ links.
   Monitor* CreateMonitorInPool(Thread* self, Thread* owner, mirror::Object* obj, int32_t hash_code)
-      REQUIRES_SHARED(Locks::mutator_lock_);
+      REQUIRES_SHARED(Locks::mutator_lock_) NO_THREAD_SAFETY_ANALYSIS;
 
-  void ReleaseMonitorToPool(Thread* self, Monitor* monitor);
+  void ReleaseMonitorToPool(Thread* self, Monitor* monitor) NO_THREAD_SAFETY_ANALYSIS;
   void ReleaseMonitorsToPool(Thread* self, MonitorList::Monitors* monitors);
 
+  // Each thread keeps a small cache of free monitors so that inflating a lock rarely takes the
+  // allocated_monitor_ids_lock_, which all inflating and deflating threads contend on otherwise.
+  // The cache is refilled and flushed kThreadCacheBatchSize monitors at a time.
+  void RefillThreadCache(Thread* self) NO_THREAD_SAFETY_ANALYSIS;
+  // Keeps the first `num_to_keep` cached monitors and moves the rest to the shared free list.
+  void FlushThreadCache(Thread* self, size_t num_to_keep) NO_THREAD_SAFETY_ANALYSIS;
+
   // Note: This is safe as we do not ever move chunks.  All needed entries in the monitor_chunks_
   // data structure are read-only once we get here.  Updates happen-before this call because
   // the lock word was stored with release semantics and we read it with acquire semantics to
@@ -178,6 +196,9 @@ class MonitorPool {
     return kInitialChunkStorage << index;
   }
 
+  static constexpr size_t kThreadCacheBatchSize = 16;
+  static constexpr size_t kMaxThreadCacheSize = 2 * kThreadCacheBatchSize;
+
   // TODO: There are assumptions in the code that monitor addresses are 8B aligned (>>3).
   static constexpr size_t kMonitorAlignment = 8;
   // Size of a monitor, rounded up to a multiple of alignment.
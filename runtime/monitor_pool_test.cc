@@ -124,4 +124,38 @@ TEST_F(MonitorPoolTest, MonitorPoolTest) {
   }
 }
 
+TEST_F(MonitorPoolTest, ThreadCache) {
+#ifndef __LP64__
+  // There is no pool on 32-bit targets, monitors are allocated on the native heap.
+  return;
+#endif
+  Thread* self = Thread::Current();
+  ScopedObjectAccess soa(self);
+  MonitorPool::ReleaseThreadCache(self);
+  EXPECT_EQ(self->GetNumberOfCachedMonitors(), 0u);
+
+  std::vector<Monitor*> monitors;
+  for (size_t i = 0; i != 100u; ++i) {
+    monitors.push_back(MonitorPool::CreateMonitor(self, self, nullptr, static_cast<int32_t>(i)));
+    VerifyMonitor(monitors.back(), self);
+  }
+  for (Monitor* mon : monitors) {
+    MonitorPool::ReleaseMonitor(self, mon);
+    // Releasing many monitors keeps only a bounded number of them in the cache, so that threads
+    // that release more than they allocate return the rest.
+    EXPECT_LE(self->GetNumberOfCachedMonitors(), 32u);
+  }
+  EXPECT_NE(self->GetNumberOfCachedMonitors(), 0u);
+
+  // The cache hands out the monitor released last first.
+  Monitor* mon = MonitorPool::CreateMonitor(self, self, nullptr, 0);
+  EXPECT_EQ(mon, monitors.back());
+  VerifyMonitor(mon, self);
+  MonitorPool::ReleaseMonitor(self, mon);
+
+  MonitorPool::ReleaseThreadCache(self);
+  EXPECT_EQ(self->GetNumberOfCachedMonitors(), 0u);
+  EXPECT_TRUE(self->GetCachedMonitors() == nullptr);
+}
+
 }  // namespace art
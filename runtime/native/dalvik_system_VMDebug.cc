@@ -24,6 +24,7 @@
 #include "nativehelper/jni_macros.h"
 
 #include "base/histogram-inl.h"
+#include "base/mutex.h"
 #include "base/time_utils.h"
 #include "class_linker.h"
 #include "common_throws.h"
@@ -399,6 +400,11 @@ enum class VMDebugRuntimeStatId {
   kArtGcBlockingGcTime,
   kArtGcGcCountRateHistogram,
   kArtGcBlockingGcCountRateHistogram,
+  kArtGcAllocationStallCount,
+  kArtGcAllocationStallTime,
+  kArtGcCollectorMetrics,
+  kArtGcClassHistogram,
+  kArtLockContentionStats,
   kNumRuntimeStats,
 };
 
@@ -439,6 +445,29 @@ static jobject VMDebug_getRuntimeStatInternal(JNIEnv* env, jclass, jint statId)
       heap->DumpBlockingGcCountRateHistogram(output);
       return env->NewStringUTF(output.str().c_str());
     }
+    case VMDebugRuntimeStatId::kArtGcAllocationStallCount: {
+      std::string output = std::to_string(heap->GetAllocationStallCount());
+      return env->NewStringUTF(output.c_str());
+    }
+    case VMDebugRuntimeStatId::kArtGcAllocationStallTime: {
+      std::string output = std::to_string(NsToMs(heap->GetAllocationStallTime()));
+      return env->NewStringUTF(output.c_str());
+    }
+    case VMDebugRuntimeStatId::kArtGcCollectorMetrics: {
+      std::ostringstream output;
+      heap->DumpGcMetrics(output);
+      return env->NewStringUTF(output.str().c_str());
+    }
+    case VMDebugRuntimeStatId::kArtGcClassHistogram: {
+      std::ostringstream output;
+      heap->DumpClassHistogram(output);
+      return env->NewStringUTF(output.str().c_str());
+    }
+    case VMDebugRuntimeStatId::kArtLockContentionStats: {
+      std::ostringstream output;
+      BaseMutex::DumpContentionStats(output);
+      return env->NewStringUTF(output.str().c_str());
+    }
     default:
       return nullptr;
   }
@@ -505,6 +534,38 @@ static jobjectArray VMDebug_getRuntimeStatsInternal(JNIEnv* env, jclass) {
       return nullptr;
     }
   }
+  if (!SetRuntimeStatValue(env, result, VMDebugRuntimeStatId::kArtGcAllocationStallCount,
+                           std::to_string(heap->GetAllocationStallCount()))) {
+    return nullptr;
+  }
+  if (!SetRuntimeStatValue(env, result, VMDebugRuntimeStatId::kArtGcAllocationStallTime,
+                           std::to_string(NsToMs(heap->GetAllocationStallTime())))) {
+    return nullptr;
+  }
+  {
+    std::ostringstream output;
+    heap->DumpGcMetrics(output);
+    if (!SetRuntimeStatValue(env, result, VMDebugRuntimeStatId::kArtGcCollectorMetrics,
+                             output.str())) {
+      return nullptr;
+    }
+  }
+  {
+    std::ostringstream output;
+    heap->DumpClassHistogram(output);
+    if (!SetRuntimeStatValue(env, result, VMDebugRuntimeStatId::kArtGcClassHistogram,
+                             output.str())) {
+      return nullptr;
+    }
+  }
+  {
+    std::ostringstream output;
+    BaseMutex::DumpContentionStats(output);
+    if (!SetRuntimeStatValue(env, result, VMDebugRuntimeStatId::kArtLockContentionStats,
+                             output.str())) {
+      return nullptr;
+    }
+  }
   return result;
 }
 
@@ -18,6 +18,14 @@
 
 #include <string.h>
 
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 #include "jni_internal.h"
 #include "mirror/string-inl.h"
 #include "mirror/string.h"
@@ -30,6 +38,122 @@
 
 namespace art {
 
+// The conversions below handle 16 bytes at a time with SSE2 or NEON, which are part of the
+// baseline of the targets that have them, and the remaining bytes or chars one by one.
+
+// Widen `count` bytes to chars. If `kAsciiOnly`, the bytes above 0x7f become `replacement`.
+template <bool kAsciiOnly>
+static void BytesToChars(const uint8_t* src, uint16_t* dst, size_t count, uint16_t replacement) {
+#if defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i replacements = _mm_set1_epi16(replacement);
+  for (; count >= 16u; count -= 16u, src += 16u, dst += 16u) {
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    __m128i lo = _mm_unpacklo_epi8(bytes, zero);
+    __m128i hi = _mm_unpackhi_epi8(bytes, zero);
+    if (kAsciiOnly) {
+      const __m128i non_ascii = _mm_cmplt_epi8(bytes, zero);
+      const __m128i non_ascii_lo = _mm_unpacklo_epi8(non_ascii, non_ascii);
+      const __m128i non_ascii_hi = _mm_unpackhi_epi8(non_ascii, non_ascii);
+      lo = _mm_or_si128(_mm_andnot_si128(non_ascii_lo, lo),
+                        _mm_and_si128(non_ascii_lo, replacements));
+      hi = _mm_or_si128(_mm_andnot_si128(non_ascii_hi, hi),
+                        _mm_and_si128(non_ascii_hi, replacements));
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), lo);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 8u), hi);
+  }
+#elif defined(__ARM_NEON__) || defined(__aarch64__)
+  const uint16x8_t max_ascii = vdupq_n_u16(0x7f);
+  const uint16x8_t replacements = vdupq_n_u16(replacement);
+  for (; count >= 16u; count -= 16u, src += 16u, dst += 16u) {
+    const uint8x16_t bytes = vld1q_u8(src);
+    uint16x8_t lo = vmovl_u8(vget_low_u8(bytes));
+    uint16x8_t hi = vmovl_u8(vget_high_u8(bytes));
+    if (kAsciiOnly) {
+      lo = vbslq_u16(vcgtq_u16(lo, max_ascii), replacements, lo);
+      hi = vbslq_u16(vcgtq_u16(hi, max_ascii), replacements, hi);
+    }
+    vst1q_u16(dst, lo);
+    vst1q_u16(dst + 8u, hi);
+  }
+#endif
+  for (; count != 0u; --count) {
+    uint16_t ch = *src++;
+    *dst++ = (!kAsciiOnly || ch <= 0x7f) ? ch : replacement;
+  }
+}
+
+// Narrow `count` chars to bytes, the chars above `max_valid_char` (at most 0xff) become '?'.
+static void CharsToBytes(const uint16_t* src, uint8_t* dst, size_t count, uint16_t max_valid_char) {
+  DCHECK_LE(max_valid_char, 0xffu);
+#if defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i max_valid = _mm_set1_epi16(max_valid_char);
+  const __m128i question_marks = _mm_set1_epi16('?');
+  for (; count >= 16u; count -= 16u, src += 16u, dst += 16u) {
+    __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 8u));
+    // The saturated difference is zero for the valid chars.
+    const __m128i valid_lo = _mm_cmpeq_epi16(_mm_subs_epu16(lo, max_valid), zero);
+    const __m128i valid_hi = _mm_cmpeq_epi16(_mm_subs_epu16(hi, max_valid), zero);
+    lo = _mm_or_si128(_mm_and_si128(valid_lo, lo), _mm_andnot_si128(valid_lo, question_marks));
+    hi = _mm_or_si128(_mm_and_si128(valid_hi, hi), _mm_andnot_si128(valid_hi, question_marks));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_packus_epi16(lo, hi));
+  }
+#elif defined(__ARM_NEON__) || defined(__aarch64__)
+  const uint16x8_t max_valid = vdupq_n_u16(max_valid_char);
+  const uint16x8_t question_marks = vdupq_n_u16('?');
+  for (; count >= 16u; count -= 16u, src += 16u, dst += 16u) {
+    uint16x8_t lo = vld1q_u16(src);
+    uint16x8_t hi = vld1q_u16(src + 8u);
+    lo = vbslq_u16(vcgtq_u16(lo, max_valid), question_marks, lo);
+    hi = vbslq_u16(vcgtq_u16(hi, max_valid), question_marks, hi);
+    vst1q_u8(dst, vcombine_u8(vmovn_u16(lo), vmovn_u16(hi)));
+  }
+#endif
+  for (; count != 0u; --count) {
+    uint16_t ch = *src++;
+    *dst++ = static_cast<uint8_t>((ch <= max_valid_char) ? ch : '?');
+  }
+}
+
+// Returns the number of ASCII chars at the start of the `count` chars.
+static size_t CountAsciiPrefix(const uint16_t* src, size_t count) {
+  size_t i = 0u;
+#if defined(__SSE2__)
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i non_ascii_bits = _mm_set1_epi16(static_cast<int16_t>(0xff80));
+  for (; count - i >= 8u; i += 8u) {
+    const __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    const __m128i ascii = _mm_cmpeq_epi16(_mm_and_si128(chars, non_ascii_bits), zero);
+    if (_mm_movemask_epi8(ascii) != 0xffff) {
+      break;
+    }
+  }
+#elif defined(__aarch64__)
+  for (; count - i >= 8u; i += 8u) {
+    if (vmaxvq_u16(vld1q_u16(src + i)) > 0x7f) {
+      break;
+    }
+  }
+#elif defined(__ARM_NEON__)
+  for (; count - i >= 8u; i += 8u) {
+    const uint16x8_t chars = vld1q_u16(src + i);
+    uint16x4_t max = vpmax_u16(vget_low_u16(chars), vget_high_u16(chars));
+    max = vpmax_u16(max, max);
+    max = vpmax_u16(max, max);
+    if (vget_lane_u16(max, 0) > 0x7f) {
+      break;
+    }
+  }
+#endif
+  while (i != count && src[i] <= 0x7f) {
+    ++i;
+  }
+  return i;
+}
+
 /**
  * Approximates java.lang.UnsafeByteSequence so we don't have to pay the cost of calling back into
  * Java when converting a char[] to a UTF-8 byte[]. This lets us have UTF-8 conversions slightly
@@ -63,6 +187,16 @@ class NativeUnsafeByteSequence {
     return true;
   }
 
+  // Appends `count` bytes for the caller to fill in. Returns null if the allocation failed.
+  jbyte* appendUninitialized(jint count) {
+    if (count > mSize - mOffset && !resize(std::max(mSize * 2, mOffset + count))) {
+      return nullptr;
+    }
+    jbyte* bytes = &mRawArray[mOffset];
+    mOffset += count;
+    return bytes;
+  }
+
   bool resize(int newSize) {
     if (newSize == mSize) {
       return true;
@@ -125,10 +259,8 @@ static void CharsetUtils_asciiBytesToChars(JNIEnv* env, jclass, jbyteArray javaB
   const jbyte* src = &bytes[offset];
   jchar* dst = &chars[0];
   static const jchar REPLACEMENT_CHAR = 0xfffd;
-  for (int i = length - 1; i >= 0; --i) {
-    jchar ch = static_cast<jchar>(*src++ & 0xff);
-    *dst++ = (ch <= 0x7f) ? ch : REPLACEMENT_CHAR;
-  }
+  BytesToChars</* kAsciiOnly */ true>(
+      reinterpret_cast<const uint8_t*>(src), dst, length, REPLACEMENT_CHAR);
 }
 
 static void CharsetUtils_isoLatin1BytesToChars(JNIEnv* env, jclass, jbyteArray javaBytes,
@@ -144,9 +276,7 @@ static void CharsetUtils_isoLatin1BytesToChars(JNIEnv* env, jclass, jbyteArray j
 
   const jbyte* src = &bytes[offset];
   jchar* dst = &chars[0];
-  for (int i = length - 1; i >= 0; --i) {
-    *dst++ = static_cast<jchar>(*src++ & 0xff);
-  }
+  BytesToChars</* kAsciiOnly */ false>(reinterpret_cast<const uint8_t*>(src), dst, length, 0u);
 }
 
 /**
@@ -169,13 +299,12 @@ static jbyteArray charsToBytes(JNIEnv* env, jstring java_string, jint offset, ji
     return nullptr;
   }
 
-  jbyte* dst = &bytes[0];
-  for (int i = 0; i < length; ++i) {
-    jchar ch = string->CharAt(offset + i);
-    if (ch > maxValidChar) {
-      ch = '?';
-    }
-    *dst++ = static_cast<jbyte>(ch);
+  // Compressed strings hold only ASCII chars, which are valid for both charsets.
+  uint8_t* dst = reinterpret_cast<uint8_t*>(&bytes[0]);
+  if (string->IsCompressed()) {
+    memcpy(dst, string->GetValueCompressed() + offset, length);
+  } else {
+    CharsToBytes(string->GetValue() + offset, dst, length, maxValidChar);
   }
 
   return javaBytes;
@@ -205,8 +334,32 @@ static jbyteArray CharsetUtils_toUtf8Bytes(JNIEnv* env, jclass, jstring java_str
     return nullptr;
   }
 
+  // Compressed strings hold only ASCII chars, which are one byte each. The string data is read
+  // after the allocations, which may move the string.
+  if (string->IsCompressed()) {
+    jbyte* dst = out.appendUninitialized(length);
+    if (dst == nullptr) {
+      return nullptr;
+    }
+    memcpy(dst, string->GetValueCompressed() + offset, length);
+    return out.toByteArray();
+  }
+
   const int end = offset + length;
   for (int i = offset; i < end; ++i) {
+    // Copy the run of ASCII chars starting here at once.
+    size_t ascii_count = CountAsciiPrefix(string->GetValue() + i, end - i);
+    if (ascii_count != 0u) {
+      jbyte* dst = out.appendUninitialized(ascii_count);
+      if (dst == nullptr) {
+        return nullptr;
+      }
+      CharsToBytes(string->GetValue() + i, reinterpret_cast<uint8_t*>(dst), ascii_count, 0x7f);
+      i += ascii_count;
+      if (i == end) {
+        break;
+      }
+    }
     jint ch = string->CharAt(i);
     if (ch < 0x80) {
       // One byte.
@@ -74,6 +74,8 @@ OatHeader::OatHeader(InstructionSet instruction_set,
       dex_file_count_(dex_file_count),
       oat_dex_files_offset_(0),
       executable_offset_(0),
+      hot_code_offset_(0),
+      hot_code_size_(0),
       interpreter_to_interpreter_bridge_offset_(0),
       interpreter_to_compiled_code_bridge_offset_(0),
       jni_dlsym_lookup_offset_(0),
@@ -170,6 +172,8 @@ void OatHeader::UpdateChecksumWithHeaderData() {
   }
 
   UpdateChecksum(&executable_offset_, sizeof(executable_offset_));
+  UpdateChecksum(&hot_code_offset_, sizeof(hot_code_offset_));
+  UpdateChecksum(&hot_code_size_, sizeof(hot_code_size_));
   UpdateChecksum(&interpreter_to_interpreter_bridge_offset_,
                  sizeof(interpreter_to_interpreter_bridge_offset_));
   UpdateChecksum(&interpreter_to_compiled_code_bridge_offset_,
@@ -235,6 +239,25 @@ void OatHeader::SetExecutableOffset(uint32_t executable_offset) {
   executable_offset_ = executable_offset;
 }
 
+uint32_t OatHeader::GetHotCodeOffset() const {
+  DCHECK(IsValid());
+  return hot_code_offset_;
+}
+
+uint32_t OatHeader::GetHotCodeSize() const {
+  DCHECK(IsValid());
+  return hot_code_size_;
+}
+
+void OatHeader::SetHotCodeRange(uint32_t offset, uint32_t size) {
+  CHECK(size == 0u || offset >= executable_offset_);
+  DCHECK(IsValid());
+  DCHECK_EQ(hot_code_size_, 0u);
+
+  hot_code_offset_ = offset;
+  hot_code_size_ = size;
+}
+
 const void* OatHeader::GetInterpreterToInterpreterBridge() const {
   return reinterpret_cast<const uint8_t*>(this) + GetInterpreterToInterpreterBridgeOffset();
 }
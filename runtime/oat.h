@@ -32,8 +32,8 @@ class InstructionSetFeatures;
 class PACKED(4) OatHeader {
  public:
   static constexpr uint8_t kOatMagic[] = { 'o', 'a', 't', '\n' };
-  // Last oat version changed reason: Add dex section layout info to header.
-  static constexpr uint8_t kOatVersion[] = { '1', '3', '1', '\0' };
+  // Last oat version changed reason: Add the hot code range to the header.
+  static constexpr uint8_t kOatVersion[] = { '1', '3', '2', '\0' };
 
   static constexpr const char* kImageLocationKey = "image-location";
   static constexpr const char* kDex2OatCmdLineKey = "dex2oat-cmdline";
@@ -45,6 +45,7 @@ class PACKED(4) OatHeader {
   static constexpr const char* kClassPathKey = "classpath";
   static constexpr const char* kBootClassPathKey = "bootclasspath";
   static constexpr const char* kConcurrentCopying = "concurrent-copying";
+  static constexpr const char* kDexLocationFingerprintKey = "dex-location-fingerprint";
 
   static constexpr const char kTrueValue[] = "true";
   static constexpr const char kFalseValue[] = "false";
@@ -70,6 +71,12 @@ class PACKED(4) OatHeader {
   uint32_t GetExecutableOffset() const;
   void SetExecutableOffset(uint32_t executable_offset);
 
+  // The code of the startup and hot methods of the profile, which comes first in .text, or an
+  // empty range if there was no profile.
+  uint32_t GetHotCodeOffset() const;
+  uint32_t GetHotCodeSize() const;
+  void SetHotCodeRange(uint32_t offset, uint32_t size);
+
   const void* GetInterpreterToInterpreterBridge() const;
   uint32_t GetInterpreterToInterpreterBridgeOffset() const;
   void SetInterpreterToInterpreterBridgeOffset(uint32_t offset);
@@ -140,6 +147,8 @@ class PACKED(4) OatHeader {
   uint32_t dex_file_count_;
   uint32_t oat_dex_files_offset_;
   uint32_t executable_offset_;
+  uint32_t hot_code_offset_;
+  uint32_t hot_code_size_;
   uint32_t interpreter_to_interpreter_bridge_offset_;
   uint32_t interpreter_to_compiled_code_bridge_offset_;
   uint32_t jni_dlsym_lookup_offset_;
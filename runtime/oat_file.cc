@@ -40,6 +40,7 @@
 #include "base/stl_util.h"
 #include "base/systrace.h"
 #include "base/unix_file/fd_file.h"
+#include "compact_dex_file.h"
 #include "dex_file_types.h"
 #include "elf_file.h"
 #include "elf_utils.h"
@@ -57,6 +58,7 @@
 #include "utils.h"
 #include "utils/dex_cache_arrays_layout-inl.h"
 #include "vdex_file.h"
+#include "zip_archive.h"
 
 namespace art {
 
@@ -145,6 +147,9 @@ class OatFileBase : public OatFile {
   }
 
  private:
+  // Dex files that dex2oat did not copy to the vdex, mapped from their zip.
+  std::vector<std::unique_ptr<MemMap>> uncompressed_dex_maps_;
+
   DISALLOW_COPY_AND_ASSIGN(OatFileBase);
 };
 
@@ -286,7 +291,9 @@ static bool FindDexFileMapItem(const uint8_t* dex_begin,
       BoundsCheckedCast<const DexFile::Header*>(dex_begin, dex_begin, dex_end);
   if (nullptr == header) return false;
 
-  if (!DexFile::IsMagicValid(header->magic_)) return true;  // Not a dex file, not an error.
+  if (!DexFile::IsMagicValid(header->magic_) && !CompactDexFile::IsMagicValid(header->magic_)) {
+    return true;  // Not a dex file, not an error.
+  }
 
   const DexFile::MapList* map_list =
       BoundsCheckedCast<const DexFile::MapList*>(dex_begin + header->map_off_, dex_begin, dex_end);
@@ -306,6 +313,44 @@ static bool FindDexFileMapItem(const uint8_t* dex_begin,
   return true;
 }
 
+// Map the dex file at `dex_file_location` directly from its entry in `zip_archive`, which must
+// be stored uncompressed and match the checksum recorded by dex2oat.
+static MemMap* MapUncompressedDexFile(const ZipArchive& zip_archive,
+                                      const std::string& dex_file_location,
+                                      uint32_t dex_file_checksum,
+                                      std::string* error_msg) {
+  std::string multidex_suffix = DexFile::GetMultiDexSuffix(dex_file_location);
+  std::string entry_name = multidex_suffix.empty()
+      ? DexFile::GetMultiDexClassesDexName(0)
+      : multidex_suffix.substr(1);
+  std::unique_ptr<ZipEntry> zip_entry(zip_archive.Find(entry_name.c_str(), error_msg));
+  if (zip_entry == nullptr) {
+    return nullptr;
+  }
+  if (!zip_entry->IsUncompressed() || !zip_entry->IsAlignedTo(alignof(DexFile::Header))) {
+    *error_msg = StringPrintf("Entry '%s' is not stored uncompressed and aligned",
+                              entry_name.c_str());
+    return nullptr;
+  }
+  if (zip_entry->GetCrc32() != dex_file_checksum) {
+    *error_msg = StringPrintf("Entry '%s' has checksum 0x%08x, expected 0x%08x",
+                              entry_name.c_str(),
+                              zip_entry->GetCrc32(),
+                              dex_file_checksum);
+    return nullptr;
+  }
+  std::unique_ptr<MemMap> map(zip_entry->MapDirectlyFromFile(dex_file_location.c_str(),
+                                                             error_msg));
+  if (map == nullptr) {
+    return nullptr;
+  }
+  if (!map->Protect(PROT_READ)) {
+    *error_msg = StringPrintf("Failed to make '%s' read only", dex_file_location.c_str());
+    return nullptr;
+  }
+  return map.release();
+}
+
 bool OatFileBase::Setup(const char* abs_dex_location, std::string* error_msg) {
   if (!GetOatHeader().IsValid()) {
     std::string cause = GetOatHeader().GetValidationErrorMessage();
@@ -374,6 +419,9 @@ bool OatFileBase::Setup(const char* abs_dex_location, std::string* error_msg) {
   DCHECK_EQ(dex_cache_arrays != nullptr, dex_cache_arrays_end != nullptr);
   uint32_t dex_file_count = GetOatHeader().GetDexFileCount();
   oat_dex_files_storage_.reserve(dex_file_count);
+  // The zip of the last dex file mapped from an uncompressed entry, multidex entries share it.
+  std::unique_ptr<ZipArchive> zip_archive;
+  std::string zip_archive_location;
   for (size_t i = 0; i < dex_file_count; i++) {
     uint32_t dex_file_location_size;
     if (UNLIKELY(!ReadOatDexFileData(*this, &oat, &dex_file_location_size))) {
@@ -422,38 +470,60 @@ bool OatFileBase::Setup(const char* abs_dex_location, std::string* error_msg) {
                                 dex_file_location.c_str());
       return false;
     }
-    if (UNLIKELY(dex_file_offset == 0U)) {
-      *error_msg = StringPrintf("In oat file '%s' found OatDexFile #%zu for '%s' with zero dex "
-                                    "file offset",
-                                GetLocation().c_str(),
-                                i,
-                                dex_file_location.c_str());
-      return false;
-    }
-    if (UNLIKELY(dex_file_offset > DexSize())) {
-      *error_msg = StringPrintf("In oat file '%s' found OatDexFile #%zu for '%s' with dex file "
-                                    "offset %u > %zu",
-                                GetLocation().c_str(),
-                                i,
-                                dex_file_location.c_str(),
-                                dex_file_offset,
-                                DexSize());
-      return false;
+    const uint8_t* dex_file_pointer = nullptr;
+    size_t dex_file_max_size = 0u;
+    if (dex_file_offset == 0U) {
+      // The dex file was not copied to the vdex, it is mapped from its uncompressed zip entry.
+      std::string zip_location = DexFile::GetBaseLocation(dex_file_location);
+      if (zip_archive == nullptr || zip_archive_location != zip_location) {
+        zip_archive.reset(ZipArchive::Open(zip_location.c_str(), error_msg));
+        zip_archive_location = zip_location;
+      }
+      MemMap* dex_file_map = (zip_archive != nullptr)
+          ? MapUncompressedDexFile(*zip_archive, dex_file_location, dex_file_checksum, error_msg)
+          : nullptr;
+      if (UNLIKELY(dex_file_map == nullptr)) {
+        *error_msg = StringPrintf("In oat file '%s' found OatDexFile #%zu for '%s' not in the "
+                                      "oat file and failed to map it from '%s': %s",
+                                  GetLocation().c_str(),
+                                  i,
+                                  dex_file_location.c_str(),
+                                  zip_location.c_str(),
+                                  error_msg->c_str());
+        return false;
+      }
+      uncompressed_dex_maps_.emplace_back(dex_file_map);
+      dex_file_pointer = dex_file_map->Begin();
+      dex_file_max_size = dex_file_map->Size();
+    } else {
+      if (UNLIKELY(dex_file_offset > DexSize())) {
+        *error_msg = StringPrintf("In oat file '%s' found OatDexFile #%zu for '%s' with dex file "
+                                      "offset %u > %zu",
+                                  GetLocation().c_str(),
+                                  i,
+                                  dex_file_location.c_str(),
+                                  dex_file_offset,
+                                  DexSize());
+        return false;
+      }
+      dex_file_pointer = DexBegin() + dex_file_offset;
+      dex_file_max_size = DexSize() - dex_file_offset;
     }
-    if (UNLIKELY(DexSize() - dex_file_offset < sizeof(DexFile::Header))) {
+    if (UNLIKELY(dex_file_max_size < sizeof(DexFile::Header))) {
       *error_msg = StringPrintf("In oat file '%s' found OatDexFile #%zu for '%s' with dex file "
-                                    "offset %u of %zu but the size of dex file header is %zu",
+                                    "offset %u and %zu bytes left but the size of dex file header "
+                                    "is %zu",
                                 GetLocation().c_str(),
                                 i,
                                 dex_file_location.c_str(),
                                 dex_file_offset,
-                                DexSize(),
+                                dex_file_max_size,
                                 sizeof(DexFile::Header));
       return false;
     }
 
-    const uint8_t* dex_file_pointer = DexBegin() + dex_file_offset;
-    if (UNLIKELY(!DexFile::IsMagicValid(dex_file_pointer))) {
+    const bool is_compact_dex = CompactDexFile::IsMagicValid(dex_file_pointer);
+    if (UNLIKELY(!is_compact_dex && !DexFile::IsMagicValid(dex_file_pointer))) {
       *error_msg = StringPrintf("In oat file '%s' found OatDexFile #%zu for '%s' with invalid "
                                     "dex file magic '%s'",
                                 GetLocation().c_str(),
@@ -462,7 +532,8 @@ bool OatFileBase::Setup(const char* abs_dex_location, std::string* error_msg) {
                                 dex_file_pointer);
       return false;
     }
-    if (UNLIKELY(!DexFile::IsVersionValid(dex_file_pointer))) {
+    if (UNLIKELY(is_compact_dex ? !CompactDexFile::IsVersionValid(dex_file_pointer)
+                                : !DexFile::IsVersionValid(dex_file_pointer))) {
       *error_msg = StringPrintf("In oat file '%s' found OatDexFile #%zu for '%s' with invalid "
                                     "dex file version '%s'",
                                 GetLocation().c_str(),
@@ -472,7 +543,7 @@ bool OatFileBase::Setup(const char* abs_dex_location, std::string* error_msg) {
       return false;
     }
     const DexFile::Header* header = reinterpret_cast<const DexFile::Header*>(dex_file_pointer);
-    if (DexSize() - dex_file_offset < header->file_size_) {
+    if (dex_file_max_size < header->file_size_) {
       *error_msg = StringPrintf("In oat file '%s' found OatDexFile #%zu for '%s' with dex file "
                                     "offset %u and size %u truncated at %zu",
                                 GetLocation().c_str(),
@@ -480,7 +551,7 @@ bool OatFileBase::Setup(const char* abs_dex_location, std::string* error_msg) {
                                 dex_file_location.c_str(),
                                 dex_file_offset,
                                 header->file_size_,
-                                DexSize());
+                                dex_file_max_size);
       return false;
     }
 
@@ -611,8 +682,8 @@ bool OatFileBase::Setup(const char* abs_dex_location, std::string* error_msg) {
       // All DexCache types except for CallSite have their instance counts in the
       // DexFile header. For CallSites, we need to read the info from the MapList.
       const DexFile::MapItem* call_sites_item = nullptr;
-      if (!FindDexFileMapItem(DexBegin(),
-                              DexEnd(),
+      if (!FindDexFileMapItem(dex_file_pointer,
+                              dex_file_pointer + header->file_size_,
                               DexFile::MapItemType::kDexTypeCallSiteIdItem,
                               &call_sites_item)) {
         *error_msg = StringPrintf("In oat file '%s' could not read data from truncated DexFile map",
@@ -1262,6 +1333,32 @@ const uint8_t* OatFile::End() const {
   return end_;
 }
 
+void OatFile::MadviseCode(MadviseState state) const {
+  const OatHeader& oat_header = GetOatHeader();
+  if (!IsExecutable() || state != MadviseState::kMadviseStateAtLoad) {
+    return;
+  }
+  const uint8_t* code_begin = Begin() + oat_header.GetExecutableOffset();
+  const uint8_t* code_end = End();
+  const uint8_t* hot_begin = Begin() + oat_header.GetHotCodeOffset();
+  const uint8_t* hot_end = hot_begin + oat_header.GetHotCodeSize();
+  if (oat_header.GetHotCodeSize() == 0u || hot_begin < code_begin || hot_end > code_end) {
+    return;
+  }
+  // Start reading the pages of the startup and hot code, including those it partially covers.
+  const uint8_t* hot_page_begin = AlignDown(hot_begin, kPageSize);
+  const uint8_t* hot_page_end = AlignUp(hot_end, kPageSize);
+  if (madvise(const_cast<uint8_t*>(hot_page_begin), hot_page_end - hot_page_begin,
+              MADV_WILLNEED) != 0) {
+    PLOG(WARNING) << "madvise failed for the hot code of " << GetLocation();
+  }
+  Runtime* const runtime = Runtime::Current();
+  if (runtime->GetHeap()->IsLowMemoryMode() && runtime->MAdviseRandomAccess()) {
+    // As for the dex files, do not read ahead the rest of the code on low ram devices.
+    MadviseLargestPageAlignedRegion(hot_page_end, code_end, MADV_RANDOM);
+  }
+}
+
 const uint8_t* OatFile::BssBegin() const {
   return bss_begin_;
 }
@@ -1368,6 +1465,17 @@ const OatFile::OatDexFile* OatFile::GetOatDexFile(const char* dex_location,
   return oat_dex_file;
 }
 
+// Returns the data section of a compact dex file in `oat_file`, which the dex files of the vdex
+// share, or an empty array for a standard dex file.
+static ArrayRef<const uint8_t> GetCompactDexData(const OatFile* oat_file,
+                                                 const uint8_t* dex_file_pointer) {
+  if (!CompactDexFile::IsMagicValid(dex_file_pointer)) {
+    return ArrayRef<const uint8_t>();
+  }
+  DCHECK(oat_file->GetVdexFile() != nullptr) << oat_file->GetLocation();
+  return oat_file->GetVdexFile()->GetSharedData();
+}
+
 OatFile::OatDexFile::OatDexFile(const OatFile* oat_file,
                                 const std::string& dex_file_location,
                                 const std::string& canonical_dex_file_location,
@@ -1396,7 +1504,10 @@ OatFile::OatDexFile::OatDexFile(const OatFile* oat_file,
     if (lookup_table_data_ + TypeLookupTable::RawDataLength(num_class_defs) > GetOatFile()->End()) {
       LOG(WARNING) << "found truncated lookup table in " << dex_file_location_;
     } else {
-      lookup_table_ = TypeLookupTable::Open(dex_file_pointer_, lookup_table_data_, num_class_defs);
+      ArrayRef<const uint8_t> compact_dex_data = GetCompactDexData(oat_file, dex_file_pointer_);
+      const uint8_t* dex_data =
+          compact_dex_data.empty() ? dex_file_pointer_ : compact_dex_data.data();
+      lookup_table_ = TypeLookupTable::Open(dex_data, lookup_table_data_, num_class_defs);
     }
   }
 }
@@ -1414,8 +1525,11 @@ std::unique_ptr<const DexFile> OatFile::OatDexFile::OpenDexFile(std::string* err
   ScopedTrace trace(__PRETTY_FUNCTION__);
   static constexpr bool kVerify = false;
   static constexpr bool kVerifyChecksum = false;
+  ArrayRef<const uint8_t> compact_dex_data = GetCompactDexData(oat_file_, dex_file_pointer_);
   return DexFile::Open(dex_file_pointer_,
                        FileSize(),
+                       compact_dex_data.data(),
+                       compact_dex_data.size(),
                        dex_file_location_,
                        dex_file_location_checksum_,
                        this,
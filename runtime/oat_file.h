@@ -285,6 +285,9 @@ class OatFile {
   const uint8_t* DexBegin() const;
   const uint8_t* DexEnd() const;
 
+  // Madvise the compiled code based on the state we are moving to.
+  void MadviseCode(MadviseState state) const;
+
   ArrayRef<ArtMethod*> GetBssMethods() const;
   ArrayRef<GcRoot<mirror::Object>> GetBssGcRoots() const;
 
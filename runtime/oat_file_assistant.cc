@@ -16,6 +16,8 @@
 
 #include "oat_file_assistant.h"
 
+#include <inttypes.h>
+
 #include <sstream>
 
 #include <sys/stat.h>
@@ -32,6 +34,7 @@
 #include "gc/space/image_space.h"
 #include "image.h"
 #include "oat.h"
+#include "oat_file_manager.h"
 #include "os.h"
 #include "runtime.h"
 #include "scoped_thread_state_change-inl.h"
@@ -448,6 +451,19 @@ bool OatFileAssistant::DexChecksumUpToDate(const OatFile& file, std::string* err
   return true;
 }
 
+bool OatFileAssistant::DexLocationUnchanged(const OatFile& file) {
+  const char* fingerprint =
+      file.GetOatHeader().GetStoreValueByKey(OatHeader::kDexLocationFingerprintKey);
+  if (fingerprint == nullptr) {
+    return false;
+  }
+  if (!dex_location_fingerprint_attempted_) {
+    dex_location_fingerprint_attempted_ = true;
+    dex_location_fingerprint_ = GetFileFingerprint(dex_location_);
+  }
+  return !dex_location_fingerprint_.empty() && dex_location_fingerprint_ == fingerprint;
+}
+
 OatFileAssistant::OatStatus OatFileAssistant::GivenOatFileStatus(const OatFile& file) {
   // Verify the ART_USE_READ_BARRIER state.
   // TODO: Don't fully reject files due to read barrier state. If they contain
@@ -460,9 +476,12 @@ OatFileAssistant::OatStatus OatFileAssistant::GivenOatFileStatus(const OatFile&
     return kOatCannotOpen;
   }
 
-  // Verify the dex checksum.
+  // Verify the dex checksum, unless the oat file was compiled from the dex location as it is.
   std::string error_msg;
-  if (kIsVdexEnabled) {
+  if (DexLocationUnchanged(file)) {
+    VLOG(oat) << "Dex location " << dex_location_ << " unchanged since compiling "
+              << file.GetLocation();
+  } else if (kIsVdexEnabled) {
     VdexFile* vdex = file.GetVdexFile();
     if (!DexChecksumUpToDate(*vdex, &error_msg)) {
       LOG(ERROR) << error_msg;
@@ -589,6 +608,36 @@ static bool DexLocationToOdexNames(const std::string& location,
   return true;
 }
 
+// The device is left out, its number may change across boots.
+static std::string FingerprintFromStat(const struct stat& st) {
+#if defined(__APPLE__)
+  const struct timespec& mtime = st.st_mtimespec;
+#else
+  const struct timespec& mtime = st.st_mtim;
+#endif
+  return StringPrintf("%" PRIu64 ":%" PRId64 ":%" PRId64 ".%09ld",
+                      static_cast<uint64_t>(st.st_ino),
+                      static_cast<int64_t>(st.st_size),
+                      static_cast<int64_t>(mtime.tv_sec),
+                      static_cast<long>(mtime.tv_nsec));  // NOLINT [runtime/int]
+}
+
+std::string OatFileAssistant::GetFileFingerprint(int fd) {
+  struct stat st;
+  if (TEMP_FAILURE_RETRY(fstat(fd, &st)) != 0) {
+    return std::string();
+  }
+  return FingerprintFromStat(st);
+}
+
+std::string OatFileAssistant::GetFileFingerprint(const std::string& path) {
+  struct stat st;
+  if (TEMP_FAILURE_RETRY(stat(path.c_str(), &st)) != 0) {
+    return std::string();
+  }
+  return FingerprintFromStat(st);
+}
+
 // Prepare a subcomponent of the odex directory.
 // (i.e. create and set the expected permissions on the path `dir`).
 static bool PrepareDirectory(const std::string& dir, std::string* error_msg) {
@@ -863,9 +912,8 @@ const std::vector<uint32_t>* OatFileAssistant::GetRequiredDexChecksums() {
     required_dex_checksums_found_ = false;
     cached_required_dex_checksums_.clear();
     std::string error_msg;
-    if (DexFile::GetMultiDexChecksums(dex_location_.c_str(),
-                                      &cached_required_dex_checksums_,
-                                      &error_msg)) {
+    if (Runtime::Current()->GetOatFileManager().GetMultiDexChecksums(
+            dex_location_, &cached_required_dex_checksums_, &error_msg)) {
       required_dex_checksums_found_ = true;
       has_original_dex_files_ = true;
     } else {
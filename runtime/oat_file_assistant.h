@@ -278,6 +278,14 @@ class OatFileAssistant {
                                         std::string* odex_filename,
                                         std::string* error_msg);
 
+  // Returns a fingerprint of the file `fd` or `path`, made of its inode, size and
+  // modification time, or an empty string if the file cannot be stat'ed. dex2oat records the
+  // fingerprint of a single input dex location in the oat header; an oat file with the
+  // fingerprint of the dex location was compiled from the current dex files, so their
+  // checksums do not need to be read from the zip file to validate it.
+  static std::string GetFileFingerprint(int fd);
+  static std::string GetFileFingerprint(const std::string& path);
+
   // Constructs the oat file name for the given dex location.
   // Returns true on success, in which case oat_filename is set to the oat
   // file name.
@@ -425,6 +433,9 @@ class OatFileAssistant {
   // date, error_msg is updated with a message describing the problem.
   bool DexChecksumUpToDate(const OatFile& file, std::string* error_msg);
 
+  // Returns true if `file` records the fingerprint of the current dex location.
+  bool DexLocationUnchanged(const OatFile& file);
+
   // Return the status for a given opened oat file with respect to the dex
   // location.
   OatStatus GivenOatFileStatus(const OatFile& file);
@@ -474,6 +485,10 @@ class OatFileAssistant {
   bool required_dex_checksums_found_;
   bool has_original_dex_files_;
 
+  // Cached fingerprint of the dex location, accessed only by DexLocationUnchanged().
+  std::string dex_location_fingerprint_;
+  bool dex_location_fingerprint_attempted_ = false;
+
   OatFileInfo odex_;
   OatFileInfo oat_;
 
@@ -16,7 +16,9 @@
 
 #include <string>
 #include <vector>
+#include <fcntl.h>
 #include <sys/param.h>
+#include <sys/stat.h>
 
 #include "android-base/strings.h"
 #include <gtest/gtest.h>
@@ -218,6 +220,47 @@ TEST_F(OatFileAssistantTest, OatUpToDate) {
   EXPECT_TRUE(oat_file_assistant.HasOriginalDexFiles());
 }
 
+// Case: We have a DEX file and an OAT file compiled from it.
+// Expect: The OAT file records the fingerprint of the DEX file, and stays up to
+// date through the dex checksums when the fingerprint changes.
+TEST_F(OatFileAssistantTest, DexLocationFingerprint) {
+  if (IsExecutedAsRoot()) {
+    // We cannot simulate non writable locations when executed as root: b/38000545.
+    LOG(ERROR) << "Test skipped because it's running as root";
+    return;
+  }
+
+  std::string dex_location = GetScratchDir() + "/DexLocationFingerprint.jar";
+  Copy(GetDexSrc1(), dex_location);
+  GenerateOatForTest(dex_location.c_str(), CompilerFilter::kSpeed);
+
+  // For the use of oat location by making the dex parent not writable.
+  ScopedNonWritable scoped_non_writable(dex_location);
+  ASSERT_TRUE(scoped_non_writable.IsSuccessful());
+  const std::string fingerprint = OatFileAssistant::GetFileFingerprint(dex_location);
+  ASSERT_FALSE(fingerprint.empty());
+
+  {
+    OatFileAssistant oat_file_assistant(dex_location.c_str(), kRuntimeISA, false);
+    std::unique_ptr<OatFile> oat_file = oat_file_assistant.GetBestOatFile();
+    ASSERT_TRUE(oat_file.get() != nullptr);
+    const char* recorded_fingerprint =
+        oat_file->GetOatHeader().GetStoreValueByKey(OatHeader::kDexLocationFingerprintKey);
+    ASSERT_TRUE(recorded_fingerprint != nullptr);
+    EXPECT_EQ(fingerprint, recorded_fingerprint);
+  }
+
+  // Touch the dex file without changing it.
+  struct timespec times[2] = { { 0, UTIME_OMIT }, { 12345, 0 } };
+  ASSERT_EQ(0, utimensat(AT_FDCWD, dex_location.c_str(), times, 0));
+  EXPECT_NE(fingerprint, OatFileAssistant::GetFileFingerprint(dex_location));
+
+  OatFileAssistant oat_file_assistant(dex_location.c_str(), kRuntimeISA, false);
+  EXPECT_EQ(OatFileAssistant::kOatUpToDate, oat_file_assistant.OatFileStatus());
+  EXPECT_EQ(OatFileAssistant::kNoDexOptNeeded,
+      oat_file_assistant.GetDexOptNeeded(CompilerFilter::kSpeed));
+}
+
 // Case: We have a DEX file and up-to-date OAT file for it. We load the dex file
 // via a symlink.
 // Expect: The status is kNoDexOptNeeded.
@@ -1125,6 +1168,37 @@ TEST_F(OatFileAssistantTest, RaceToGenerate) {
   }
 }
 
+// Test that the dex checksums are read again when the dex location changes.
+TEST_F(OatFileAssistantTest, CachedDexChecksums) {
+  std::string dex_location = GetScratchDir() + "/CachedDexChecksums.jar";
+  Copy(GetDexSrc1(), dex_location);
+  OatFileManager& oat_file_manager = Runtime::Current()->GetOatFileManager();
+
+  std::string error_msg;
+  std::vector<uint32_t> expected;
+  ASSERT_TRUE(DexFile::GetMultiDexChecksums(dex_location.c_str(), &expected, &error_msg))
+      << error_msg;
+  for (size_t i = 0; i != 2u; ++i) {
+    std::vector<uint32_t> checksums;
+    ASSERT_TRUE(oat_file_manager.GetMultiDexChecksums(dex_location, &checksums, &error_msg))
+        << error_msg;
+    EXPECT_EQ(expected, checksums);
+  }
+
+  Copy(GetMultiDexSrc1(), dex_location);
+  expected.clear();
+  ASSERT_TRUE(DexFile::GetMultiDexChecksums(dex_location.c_str(), &expected, &error_msg))
+      << error_msg;
+  std::vector<uint32_t> checksums;
+  ASSERT_TRUE(oat_file_manager.GetMultiDexChecksums(dex_location, &checksums, &error_msg))
+      << error_msg;
+  EXPECT_EQ(expected, checksums);
+
+  ASSERT_EQ(0, unlink(dex_location.c_str()));
+  checksums.clear();
+  EXPECT_FALSE(oat_file_manager.GetMultiDexChecksums(dex_location, &checksums, &error_msg));
+}
+
 // Case: We have a DEX file and an ODEX file, no OAT file, and dex2oat is
 // disabled.
 // Expect: We should load the odex file non-executable.
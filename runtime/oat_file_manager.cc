@@ -16,6 +16,8 @@
 
 #include "oat_file_manager.h"
 
+#include <sys/stat.h>
+
 #include <memory>
 #include <queue>
 #include <vector>
@@ -31,6 +33,7 @@
 #include "class_loader_context.h"
 #include "dex_file-inl.h"
 #include "dex_file_tracking_registrar.h"
+#include "fault_handler.h"
 #include "gc/scoped_gc_critical_section.h"
 #include "gc/space/image_space.h"
 #include "handle_scope-inl.h"
@@ -40,6 +43,7 @@
 #include "oat_file_assistant.h"
 #include "obj_ptr-inl.h"
 #include "scoped_thread_state_change-inl.h"
+#include "startup_phases.h"
 #include "thread-current-inl.h"
 #include "thread_list.h"
 #include "well_known_classes.h"
@@ -64,6 +68,9 @@ const OatFile* OatFileManager::RegisterOatFile(std::unique_ptr<const OatFile> oa
     }
   }
   have_non_pic_oat_file_ = have_non_pic_oat_file_ || !oat_file->IsPic();
+  if (oat_file->IsExecutable()) {
+    fault_manager.AddGeneratedCodeRange(oat_file->Begin(), oat_file->End() - oat_file->Begin());
+  }
   const OatFile* ret = oat_file.get();
   oat_files_.insert(std::move(oat_file));
   return ret;
@@ -75,6 +82,7 @@ void OatFileManager::UnRegisterAndDeleteOatFile(const OatFile* oat_file) {
   std::unique_ptr<const OatFile> compare(oat_file);
   auto it = oat_files_.find(compare);
   CHECK(it != oat_files_.end());
+  RemoveGeneratedCodeRange(oat_file);
   oat_files_.erase(it);
   compare.release();
 }
@@ -136,9 +144,18 @@ const OatFile* OatFileManager::GetPrimaryOatFile() const {
 OatFileManager::~OatFileManager() {
   // Explicitly clear oat_files_ since the OatFile destructor calls back into OatFileManager for
   // UnRegisterOatFileLocation.
+  for (const std::unique_ptr<const OatFile>& oat_file : oat_files_) {
+    RemoveGeneratedCodeRange(oat_file.get());
+  }
   oat_files_.clear();
 }
 
+void OatFileManager::RemoveGeneratedCodeRange(const OatFile* oat_file) {
+  if (oat_file->IsExecutable()) {
+    fault_manager.RemoveGeneratedCodeRange(oat_file->Begin(), oat_file->End() - oat_file->Begin());
+  }
+}
+
 std::vector<const OatFile*> OatFileManager::RegisterImageOatFiles(
     std::vector<gc::space::ImageSpace*> spaces) {
   std::vector<const OatFile*> oat_files;
@@ -386,6 +403,7 @@ std::vector<std::unique_ptr<const DexFile>> OatFileManager::OpenDexFilesFromOat(
     const OatFile** out_oat_file,
     std::vector<std::string>* error_msgs) {
   ScopedTrace trace(__FUNCTION__);
+  ScopedStartupPhase startup_phase(__FUNCTION__);
   CHECK(dex_location != nullptr);
   CHECK(error_msgs != nullptr);
 
@@ -575,6 +593,7 @@ std::vector<std::unique_ptr<const DexFile>> OatFileManager::OpenDexFilesFromOat(
        for (const std::unique_ptr<const DexFile>& dex_file : dex_files) {
          OatDexFile::MadviseDexFile(*dex_file, MadviseState::kMadviseStateAtLoad);
        }
+       source_oat_file->MadviseCode(MadviseState::kMadviseStateAtLoad);
     }
   }
 
@@ -602,6 +621,55 @@ std::vector<std::unique_ptr<const DexFile>> OatFileManager::OpenDexFilesFromOat(
   return dex_files;
 }
 
+static int64_t TimespecToNs(const timespec& ts) {
+  return static_cast<int64_t>(ts.tv_sec) * INT64_C(1000000000) + ts.tv_nsec;
+}
+
+bool OatFileManager::GetMultiDexChecksums(const std::string& dex_location,
+                                          std::vector<uint32_t>* checksums,
+                                          std::string* error_msg) {
+  struct stat st;
+  if (stat(dex_location.c_str(), &st) != 0) {
+    // Let DexFile::GetMultiDexChecksums() report the error.
+    return DexFile::GetMultiDexChecksums(dex_location.c_str(), checksums, error_msg);
+  }
+  // Take the file id before reading the file, a change while reading shows up as a mismatch
+  // on the next lookup.
+  DexFileId file_id;
+  file_id.dev = st.st_dev;
+  file_id.ino = st.st_ino;
+  file_id.size = st.st_size;
+#if defined(__APPLE__)
+  file_id.mtime_ns = TimespecToNs(st.st_mtimespec);
+  file_id.ctime_ns = TimespecToNs(st.st_ctimespec);
+#else
+  file_id.mtime_ns = TimespecToNs(st.st_mtim);
+  file_id.ctime_ns = TimespecToNs(st.st_ctim);
+#endif
+
+  Thread* const self = Thread::Current();
+  {
+    MutexLock mu(self, dex_checksums_lock_);
+    auto it = dex_checksums_.find(dex_location);
+    if (it != dex_checksums_.end() && it->second.file_id == file_id) {
+      checksums->insert(checksums->end(),
+                        it->second.checksums.begin(),
+                        it->second.checksums.end());
+      return true;
+    }
+  }
+  std::vector<uint32_t> read_checksums;
+  if (!DexFile::GetMultiDexChecksums(dex_location.c_str(), &read_checksums, error_msg)) {
+    return false;
+  }
+  checksums->insert(checksums->end(), read_checksums.begin(), read_checksums.end());
+  MutexLock mu(self, dex_checksums_lock_);
+  CachedDexChecksums& cached = dex_checksums_[dex_location];
+  cached.file_id = file_id;
+  cached.checksums = std::move(read_checksums);
+  return true;
+}
+
 void OatFileManager::DumpForSigQuit(std::ostream& os) {
   ReaderMutexLock mu(Thread::Current(), *Locks::oat_file_manager_lock_);
   std::vector<const OatFile*> boot_oat_files = GetBootOatFiles();
@@ -17,6 +17,9 @@
 #ifndef ART_RUNTIME_OAT_FILE_MANAGER_H_
 #define ART_RUNTIME_OAT_FILE_MANAGER_H_
 
+#include <sys/types.h>
+
+#include <map>
 #include <memory>
 #include <set>
 #include <string>
@@ -45,7 +48,8 @@ class OatFile;
 // pointers returned from functions are always valid.
 class OatFileManager {
  public:
-  OatFileManager() : have_non_pic_oat_file_(false) {}
+  OatFileManager()
+      : have_non_pic_oat_file_(false), dex_checksums_lock_("Dex checksums lock") {}
   ~OatFileManager();
 
   // Add an oat file to the internal accounting, std::aborts if there already exists an oat file
@@ -103,9 +107,21 @@ class OatFileManager {
       /*out*/ std::vector<std::string>* error_msgs)
       REQUIRES(!Locks::oat_file_manager_lock_, !Locks::mutator_lock_);
 
+  // Same as DexFile::GetMultiDexChecksums(), with the checksums of each dex location kept for
+  // as long as the file is not changed. OatFileAssistant reads them each time it checks whether
+  // a dex location is up to date, which happens for the same dex locations over and over in the
+  // system server.
+  bool GetMultiDexChecksums(const std::string& dex_location,
+                            /*out*/ std::vector<uint32_t>* checksums,
+                            /*out*/ std::string* error_msg)
+      REQUIRES(!dex_checksums_lock_);
+
   void DumpForSigQuit(std::ostream& os);
 
  private:
+  // Stop routing faults in the code of `oat_file` through the fault handler fast path.
+  static void RemoveGeneratedCodeRange(const OatFile* oat_file);
+
   // Check that the class loader context of the given oat file matches the given context.
   // This will perform a check that all class loaders in the chain have the same type and
   // classpath.
@@ -123,9 +139,35 @@ class OatFileManager {
   const OatFile* FindOpenedOatFileFromOatLocationLocked(const std::string& oat_location) const
       REQUIRES(Locks::oat_file_manager_lock_);
 
+  // The file a dex location was read from. Files are replaced, or written with a new
+  // modification time, when a dex location changes.
+  struct DexFileId {
+    dev_t dev;
+    ino_t ino;
+    off_t size;
+    int64_t mtime_ns;
+    int64_t ctime_ns;
+
+    bool operator==(const DexFileId& other) const {
+      return dev == other.dev &&
+          ino == other.ino &&
+          size == other.size &&
+          mtime_ns == other.mtime_ns &&
+          ctime_ns == other.ctime_ns;
+    }
+  };
+
+  struct CachedDexChecksums {
+    DexFileId file_id;
+    std::vector<uint32_t> checksums;
+  };
+
   std::set<std::unique_ptr<const OatFile>> oat_files_ GUARDED_BY(Locks::oat_file_manager_lock_);
   bool have_non_pic_oat_file_;
 
+  Mutex dex_checksums_lock_;
+  std::map<std::string, CachedDexChecksums> dex_checksums_ GUARDED_BY(dex_checksums_lock_);
+
   DISALLOW_COPY_AND_ASSIGN(OatFileManager);
 };
 
@@ -801,6 +801,16 @@ class JvmtiFunctions {
     return ObjectUtil::GetObjectSize(env, object, size_ptr);
   }
 
+  static jvmtiError SetHeapSamplingInterval(jvmtiEnv* env, jint sampling_interval) {
+    ENSURE_VALID_ENV(env);
+    ENSURE_HAS_CAP(env, can_generate_sampled_object_alloc_events);
+    if (sampling_interval < 0) {
+      return ERR(ILLEGAL_ARGUMENT);
+    }
+    gEventHandler.SetAllocationSamplingInterval(static_cast<size_t>(sampling_interval));
+    return ERR(NONE);
+  }
+
   static jvmtiError GetObjectHashCode(jvmtiEnv* env, jobject object, jint* hash_code_ptr) {
     ENSURE_VALID_ENV(env);
     return ObjectUtil::GetObjectHashCode(env, object, hash_code_ptr);
@@ -1208,6 +1218,30 @@ class JvmtiFunctions {
       return error;
     }
 
+    error = add_extension(
+        reinterpret_cast<jvmtiExtensionFunction>(HeapExtensions::IterateThroughHeapBatched),
+        "com.android.art.heap.iterate_through_heap_batched",
+        "Iterate through a heap like the standard IterateThroughHeap function, but report the"
+        " objects in batches. The callback has a signature of jint (*)(const jlong* entries,"
+        " jint count, void* user_data), where entries holds a (class_tag, size, tag) triple for"
+        " each of the count objects. Tags cannot be changed, and returning JVMTI_VISIT_ABORT"
+        " stops the iteration.",
+        4,
+        {                                                          // NOLINT [whitespace/braces] [4]
+            { "heap_filter", JVMTI_KIND_IN, JVMTI_TYPE_JINT, false},
+            { "klass", JVMTI_KIND_IN, JVMTI_TYPE_JCLASS, true},
+            { "callback", JVMTI_KIND_IN_PTR, JVMTI_TYPE_CVOID, false},
+            { "user_data", JVMTI_KIND_IN_PTR, JVMTI_TYPE_CVOID, true}
+        },
+        2,
+        {                                                          // NOLINT [whitespace/braces] [4]
+            JVMTI_ERROR_MUST_POSSESS_CAPABILITY,
+            JVMTI_ERROR_NULL_POINTER
+        });
+    if (error != ERR(NONE)) {
+      return error;
+    }
+
     error = add_extension(
         reinterpret_cast<jvmtiExtensionFunction>(AllocUtil::GetGlobalJvmtiAllocationState),
         "com.android.art.alloc.get_global_jvmti_allocation_state",
@@ -1225,6 +1259,31 @@ class JvmtiFunctions {
       return error;
     }
 
+    error = add_extension(
+        reinterpret_cast<jvmtiExtensionFunction>(MethodUtil::SetMethodEventFilter),
+        "com.android.art.method.set_method_event_filter",
+        "Restrict the MethodEntry and MethodExit events of this env to the given methods. While"
+        " every env with these events enabled has a filter only the filtered methods are"
+        " deoptimized, instead of running every method in the interpreter. Set the filter before"
+        " enabling the events; once every method is deoptimized it stays that way. A count of 0"
+        " removes the filter.",
+        2,
+        {                                                          // NOLINT [whitespace/braces] [4]
+            { "count", JVMTI_KIND_IN, JVMTI_TYPE_JINT, false},
+            { "methods", JVMTI_KIND_IN_BUF, JVMTI_TYPE_JMETHODID, true}
+        },
+        5,
+        {                                                          // NOLINT [whitespace/braces] [4]
+            JVMTI_ERROR_MUST_POSSESS_CAPABILITY,
+            JVMTI_ERROR_ILLEGAL_ARGUMENT,
+            JVMTI_ERROR_NULL_POINTER,
+            JVMTI_ERROR_INVALID_METHODID,
+            JVMTI_ERROR_NATIVE_METHOD
+        });
+    if (error != ERR(NONE)) {
+      return error;
+    }
+
     // Copy into output buffer.
 
     *extension_count_ptr = ext_vector.size();
@@ -1344,6 +1403,9 @@ class JvmtiFunctions {
     ADD_CAPABILITY(can_retransform_any_class);
     ADD_CAPABILITY(can_generate_resource_exhaustion_heap_events);
     ADD_CAPABILITY(can_generate_resource_exhaustion_threads_events);
+    ADD_CAPABILITY(can_generate_early_vmstart);
+    ADD_CAPABILITY(can_generate_early_class_hook_events);
+    ADD_CAPABILITY(can_generate_sampled_object_alloc_events);
 #undef ADD_CAPABILITY
     gEventHandler.HandleChangedCapabilities(ArtJvmTiEnv::AsArtJvmTiEnv(env),
                                             changed,
@@ -1408,6 +1470,9 @@ class JvmtiFunctions {
     DEL_CAPABILITY(can_retransform_any_class);
     DEL_CAPABILITY(can_generate_resource_exhaustion_heap_events);
     DEL_CAPABILITY(can_generate_resource_exhaustion_threads_events);
+    DEL_CAPABILITY(can_generate_early_vmstart);
+    DEL_CAPABILITY(can_generate_early_class_hook_events);
+    DEL_CAPABILITY(can_generate_sampled_object_alloc_events);
 #undef DEL_CAPABILITY
     gEventHandler.HandleChangedCapabilities(ArtJvmTiEnv::AsArtJvmTiEnv(env),
                                             changed,
@@ -1898,6 +1963,7 @@ const jvmtiInterface_1 gJvmtiInterface = {
   JvmtiFunctions::GetOwnedMonitorStackDepthInfo,
   JvmtiFunctions::GetObjectSize,
   JvmtiFunctions::GetLocalInstance,
+  JvmtiFunctions::SetHeapSamplingInterval,
 };
 
 };  // namespace openjdkjvmti
@@ -82,6 +82,11 @@ struct ArtJvmTiEnv : public jvmtiEnv {
   // Set of breakpoints is unique to each jvmtiEnv.
   std::unordered_set<Breakpoint> breakpoints;
 
+  // Methods this jvmtiEnv gets MethodEntry and MethodExit events for. Empty means every method.
+  // When every env with these events enabled has a filter only the filtered methods are
+  // deoptimized, instead of running everything in the interpreter.
+  std::unordered_set<art::ArtMethod*> method_event_filter;
+
   ArtJvmTiEnv(art::JavaVMExt* runtime, EventHandler* event_handler);
 
   static ArtJvmTiEnv* AsArtJvmTiEnv(jvmtiEnv* env) {
@@ -254,6 +259,9 @@ const jvmtiCapabilities kPotentialCapabilities = {
     .can_retransform_any_class                       = 0,
     .can_generate_resource_exhaustion_heap_events    = 0,
     .can_generate_resource_exhaustion_threads_events = 0,
+    .can_generate_early_vmstart                      = 0,
+    .can_generate_early_class_hook_events            = 0,
+    .can_generate_sampled_object_alloc_events        = 1,
 };
 
 }  // namespace openjdkjvmti
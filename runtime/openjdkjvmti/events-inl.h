@@ -76,7 +76,8 @@ namespace impl {
   fn(GarbageCollectionStart,  ArtJvmtiEvent::kGarbageCollectionStart)                \
   fn(GarbageCollectionFinish, ArtJvmtiEvent::kGarbageCollectionFinish)               \
   fn(ObjectFree,              ArtJvmtiEvent::kObjectFree)                            \
-  fn(VMObjectAlloc,           ArtJvmtiEvent::kVmObjectAlloc)
+  fn(VMObjectAlloc,           ArtJvmtiEvent::kVmObjectAlloc)                         \
+  fn(SampledObjectAlloc,      ArtJvmtiEvent::kSampledObjectAlloc)
 
 template <ArtJvmtiEvent kEvent>
 struct EventFnType {
@@ -244,6 +245,61 @@ inline void EventHandler::DispatchEvent<ArtJvmtiEvent::kBreakpoint>(art::Thread*
   }
 }
 
+// Need to give custom specializations for MethodEntry and MethodExit since envs can restrict them
+// to the methods in their method event filter.
+inline bool IsInMethodEventFilter(ArtJvmTiEnv* env, jmethodID jmethod) {
+  return env->method_event_filter.empty() ||
+      env->method_event_filter.find(art::jni::DecodeArtMethod(jmethod)) !=
+          env->method_event_filter.end();
+}
+
+template <>
+inline void EventHandler::DispatchEvent<ArtJvmtiEvent::kMethodEntry>(art::Thread* thread,
+                                                                     JNIEnv* jnienv,
+                                                                     jthread jni_thread,
+                                                                     jmethodID jmethod) const {
+  for (ArtJvmTiEnv* env : envs) {
+    if (env != nullptr &&
+        ShouldDispatch<ArtJvmtiEvent::kMethodEntry>(env, thread) &&
+        IsInMethodEventFilter(env, jmethod)) {
+      ScopedLocalRef<jthrowable> thr(jnienv, jnienv->ExceptionOccurred());
+      jnienv->ExceptionClear();
+      auto callback = impl::GetCallback<ArtJvmtiEvent::kMethodEntry>(env);
+      if (callback != nullptr) {
+        (*callback)(env, jnienv, jni_thread, jmethod);
+      }
+      if (thr.get() != nullptr && !jnienv->ExceptionCheck()) {
+        jnienv->Throw(thr.get());
+      }
+    }
+  }
+}
+
+template <>
+inline void EventHandler::DispatchEvent<ArtJvmtiEvent::kMethodExit>(
+    art::Thread* thread,
+    JNIEnv* jnienv,
+    jthread jni_thread,
+    jmethodID jmethod,
+    jboolean was_popped_by_exception,
+    jvalue val) const {
+  for (ArtJvmTiEnv* env : envs) {
+    if (env != nullptr &&
+        ShouldDispatch<ArtJvmtiEvent::kMethodExit>(env, thread) &&
+        IsInMethodEventFilter(env, jmethod)) {
+      ScopedLocalRef<jthrowable> thr(jnienv, jnienv->ExceptionOccurred());
+      jnienv->ExceptionClear();
+      auto callback = impl::GetCallback<ArtJvmtiEvent::kMethodExit>(env);
+      if (callback != nullptr) {
+        (*callback)(env, jnienv, jni_thread, jmethod, was_popped_by_exception, val);
+      }
+      if (thr.get() != nullptr && !jnienv->ExceptionCheck()) {
+        jnienv->Throw(thr.get());
+      }
+    }
+  }
+}
+
 // Need to give custom specializations for FieldAccess and FieldModification since they need to
 // filter out which particular fields agents want to get notified on.
 // TODO The spec allows us to do shortcuts like only allow one agent to ever set these watches. This
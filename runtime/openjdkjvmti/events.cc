@@ -168,6 +168,9 @@ void EventHandler::RemoveArtJvmTiEnv(ArtJvmTiEnv* env) {
          ++i) {
       RecalculateGlobalEventMask(static_cast<ArtJvmtiEvent>(i));
     }
+    if (!filtered_deoptimized_methods_.empty()) {
+      UpdateMethodEventDeoptimization();
+    }
   }
 }
 
@@ -188,18 +191,21 @@ static bool IsThreadControllable(ArtJvmtiEvent event) {
   }
 }
 
+// Dispatches the VMObjectAlloc events as the allocation listener of the heap, or the
+// SampledObjectAlloc events as its allocation sampler.
 class JvmtiAllocationListener : public art::gc::AllocationListener {
  public:
-  explicit JvmtiAllocationListener(EventHandler* handler) : handler_(handler) {}
+  JvmtiAllocationListener(EventHandler* handler, ArtJvmtiEvent event)
+      : handler_(handler), event_(event) {}
 
   void ObjectAllocated(art::Thread* self, art::ObjPtr<art::mirror::Object>* obj, size_t byte_count)
       OVERRIDE REQUIRES_SHARED(art::Locks::mutator_lock_) {
     DCHECK_EQ(self, art::Thread::Current());
 
-    if (handler_->IsEventEnabledAnywhere(ArtJvmtiEvent::kVmObjectAlloc)) {
+    if (handler_->IsEventEnabledAnywhere(event_)) {
       art::StackHandleScope<1> hs(self);
       auto h = hs.NewHandleWrapper(obj);
-      // jvmtiEventVMObjectAlloc parameters:
+      // jvmtiEventVMObjectAlloc and jvmtiEventSampledObjectAlloc parameters:
       //      jvmtiEnv *jvmti_env,
       //      JNIEnv* jni_env,
       //      jthread thread,
@@ -221,17 +227,29 @@ class JvmtiAllocationListener : public art::gc::AllocationListener {
       ScopedLocalRef<jclass> klass(
           jni_env, jni_env->AddLocalReference<jclass>(obj->Ptr()->GetClass()));
 
-      handler_->DispatchEvent<ArtJvmtiEvent::kVmObjectAlloc>(self,
-                                                             reinterpret_cast<JNIEnv*>(jni_env),
-                                                             thread.get(),
-                                                             object.get(),
-                                                             klass.get(),
-                                                             static_cast<jlong>(byte_count));
+      if (event_ == ArtJvmtiEvent::kVmObjectAlloc) {
+        handler_->DispatchEvent<ArtJvmtiEvent::kVmObjectAlloc>(self,
+                                                               reinterpret_cast<JNIEnv*>(jni_env),
+                                                               thread.get(),
+                                                               object.get(),
+                                                               klass.get(),
+                                                               static_cast<jlong>(byte_count));
+      } else {
+        DCHECK(event_ == ArtJvmtiEvent::kSampledObjectAlloc);
+        handler_->DispatchEvent<ArtJvmtiEvent::kSampledObjectAlloc>(
+            self,
+            reinterpret_cast<JNIEnv*>(jni_env),
+            thread.get(),
+            object.get(),
+            klass.get(),
+            static_cast<jlong>(byte_count));
+      }
     }
   }
 
  private:
   EventHandler* handler_;
+  const ArtJvmtiEvent event_;
 };
 
 static void SetupObjectAllocationTracking(art::gc::AllocationListener* listener, bool enable) {
@@ -246,6 +264,25 @@ static void SetupObjectAllocationTracking(art::gc::AllocationListener* listener,
   }
 }
 
+static void SetupObjectAllocationSampling(art::gc::AllocationListener* listener,
+                                          size_t interval,
+                                          bool enable) {
+  // Same workaround as in SetupObjectAllocationTracking.
+  art::ScopedObjectAccess soa(art::Thread::Current());
+  art::ScopedThreadSuspension sts(soa.Self(), art::ThreadState::kSuspended);
+  if (enable) {
+    art::Runtime::Current()->GetHeap()->SetAllocationSampler(listener, interval);
+  } else {
+    art::Runtime::Current()->GetHeap()->RemoveAllocationSampler();
+  }
+}
+
+void EventHandler::SetAllocationSamplingInterval(size_t interval) {
+  // An interval of 0 samples every allocation.
+  alloc_sample_interval_ = std::max<size_t>(interval, 1u);
+  art::Runtime::Current()->GetHeap()->SetAllocationSampleInterval(alloc_sample_interval_);
+}
+
 // Report GC pauses (see spec) as GARBAGE_COLLECTION_START and GARBAGE_COLLECTION_END.
 class JvmtiGcPauseListener : public art::gc::GcPauseListener {
  public:
@@ -588,9 +625,74 @@ static uint32_t GetInstrumentationEventsFor(ArtJvmtiEvent event) {
   }
 }
 
-static void SetupTraceListener(JvmtiMethodTraceListener* listener,
-                               ArtJvmtiEvent event,
-                               bool enable) {
+static bool IsMethodEvent(ArtJvmtiEvent event) {
+  return event == ArtJvmtiEvent::kMethodEntry || event == ArtJvmtiEvent::kMethodExit;
+}
+
+bool EventHandler::CanFilterMethodEvents() const {
+  for (ArtJvmTiEnv* env : envs) {
+    if (env != nullptr &&
+        env->method_event_filter.empty() &&
+        (env->event_masks.IsEnabledAnywhere(ArtJvmtiEvent::kMethodEntry) ||
+         env->event_masks.IsEnabledAnywhere(ArtJvmtiEvent::kMethodExit))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void EventHandler::UpdateFilteredDeoptimization(bool use_filters) {
+  art::instrumentation::Instrumentation* instr = art::Runtime::Current()->GetInstrumentation();
+  if (instr->AreAllMethodsDeoptimized()) {
+    // Everything runs in the interpreter already and we never go back from that.
+    DCHECK(filtered_deoptimized_methods_.empty());
+    return;
+  }
+  // If someone else (e.g. the debugger) owns the deoptimization state we fall back to deoptimizing
+  // everything.
+  bool wants_method_events = IsEventEnabledAnywhere(ArtJvmtiEvent::kMethodEntry) ||
+                             IsEventEnabledAnywhere(ArtJvmtiEvent::kMethodExit);
+  bool filters_usable = CanFilterMethodEvents() &&
+                        (filtered_deoptimization_enabled_ || !instr->IsDeoptimizationEnabled());
+  bool deoptimize_everything = !use_filters || (wants_method_events && !filters_usable);
+  std::unordered_set<art::ArtMethod*> wanted;
+  if (!deoptimize_everything) {
+    for (ArtJvmTiEnv* env : envs) {
+      if (env != nullptr &&
+          (env->event_masks.IsEnabledAnywhere(ArtJvmtiEvent::kMethodEntry) ||
+           env->event_masks.IsEnabledAnywhere(ArtJvmtiEvent::kMethodExit))) {
+        wanted.insert(env->method_event_filter.begin(), env->method_event_filter.end());
+      }
+    }
+  }
+  for (auto it = filtered_deoptimized_methods_.begin();
+       it != filtered_deoptimized_methods_.end();) {
+    if (wanted.find(*it) == wanted.end()) {
+      instr->Undeoptimize(*it);
+      it = filtered_deoptimized_methods_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  if (!wanted.empty() && !filtered_deoptimization_enabled_) {
+    instr->EnableDeoptimization();
+    filtered_deoptimization_enabled_ = true;
+  }
+  for (art::ArtMethod* method : wanted) {
+    if (filtered_deoptimized_methods_.insert(method).second) {
+      instr->Deoptimize(method);
+    }
+  }
+  if (filtered_deoptimized_methods_.empty() && filtered_deoptimization_enabled_) {
+    instr->DisableDeoptimization("jvmti-tracing");
+    filtered_deoptimization_enabled_ = false;
+  }
+  if (deoptimize_everything) {
+    instr->EnableMethodTracing("jvmti-tracing", /*needs_interpreter*/true);
+  }
+}
+
+void EventHandler::SetupTraceListener(ArtJvmtiEvent event, bool enable) {
   art::ScopedThreadStateChange stsc(art::Thread::Current(), art::ThreadState::kNative);
   uint32_t new_events = GetInstrumentationEventsFor(event);
   art::instrumentation::Instrumentation* instr = art::Runtime::Current()->GetInstrumentation();
@@ -599,14 +701,35 @@ static void SetupTraceListener(JvmtiMethodTraceListener* listener,
                                        art::gc::kCollectorTypeInstrumentation);
   art::ScopedSuspendAll ssa("jvmti method tracing installation");
   if (enable) {
+    // MethodEntry and MethodExit events of envs with a method event filter only need the filtered
+    // methods to run in the interpreter. Everything else deoptimizes every method.
     // TODO Depending on the features being used we should be able to avoid deoptimizing everything
-    // like we do here.
-    if (!instr->AreAllMethodsDeoptimized()) {
-      instr->EnableMethodTracing("jvmti-tracing", /*needs_interpreter*/true);
-    }
-    instr->AddListener(listener, new_events);
+    // for the other events too.
+    UpdateFilteredDeoptimization(/*use_filters*/IsMethodEvent(event));
+    instr->AddListener(method_trace_listener_.get(), new_events);
   } else {
-    instr->RemoveListener(listener, new_events);
+    instr->RemoveListener(method_trace_listener_.get(), new_events);
+    if (IsMethodEvent(event)) {
+      UpdateFilteredDeoptimization(/*use_filters*/true);
+    }
+  }
+}
+
+void EventHandler::UpdateMethodEventDeoptimization() {
+  art::ScopedThreadStateChange stsc(art::Thread::Current(), art::ThreadState::kNative);
+  art::gc::ScopedGCCriticalSection gcs(art::Thread::Current(),
+                                       art::gc::kGcCauseInstrumentation,
+                                       art::gc::kCollectorTypeInstrumentation);
+  art::ScopedSuspendAll ssa("jvmti method event filter update");
+  UpdateFilteredDeoptimization(/*use_filters*/true);
+}
+
+void EventHandler::SetMethodEventFilter(ArtJvmTiEnv* env,
+                                        std::unordered_set<art::ArtMethod*>&& methods) {
+  env->method_event_filter = std::move(methods);
+  if (IsEventEnabledAnywhere(ArtJvmtiEvent::kMethodEntry) ||
+      IsEventEnabledAnywhere(ArtJvmtiEvent::kMethodExit)) {
+    UpdateMethodEventDeoptimization();
   }
 }
 
@@ -617,6 +740,10 @@ void EventHandler::HandleEventType(ArtJvmtiEvent event, bool enable) {
       SetupObjectAllocationTracking(alloc_listener_.get(), enable);
       return;
 
+    case ArtJvmtiEvent::kSampledObjectAlloc:
+      SetupObjectAllocationSampling(sampled_alloc_listener_.get(), alloc_sample_interval_, enable);
+      return;
+
     case ArtJvmtiEvent::kGarbageCollectionStart:
     case ArtJvmtiEvent::kGarbageCollectionFinish:
       SetupGcPauseTracking(gc_pause_listener_.get(), event, enable);
@@ -629,7 +756,7 @@ void EventHandler::HandleEventType(ArtJvmtiEvent event, bool enable) {
       // We only need to do anything if there isn't already a listener installed/held-on by the
       // other jvmti event that uses DexPcMoved.
       if (!IsEventEnabledAnywhere(other)) {
-        SetupTraceListener(method_trace_listener_.get(), event, enable);
+        SetupTraceListener(event, enable);
       }
       return;
     }
@@ -637,7 +764,7 @@ void EventHandler::HandleEventType(ArtJvmtiEvent event, bool enable) {
     case ArtJvmtiEvent::kMethodExit:
     case ArtJvmtiEvent::kFieldAccess:
     case ArtJvmtiEvent::kFieldModification:
-      SetupTraceListener(method_trace_listener_.get(), event, enable);
+      SetupTraceListener(event, enable);
       return;
 
     default:
@@ -698,6 +825,9 @@ static bool HasAssociatedCapability(ArtJvmTiEnv* env,
     case ArtJvmtiEvent::kVmObjectAlloc:
       return caps.can_generate_vm_object_alloc_events == 1;
 
+    case ArtJvmtiEvent::kSampledObjectAlloc:
+      return caps.can_generate_sampled_object_alloc_events == 1;
+
     default:
       return true;
   }
@@ -748,6 +878,9 @@ jvmtiError EventHandler::SetEvent(ArtJvmTiEnv* env,
   // Handle any special work required for the event type.
   if (new_state != old_state) {
     HandleEventType(event, mode == JVMTI_ENABLE);
+  } else if (new_state && IsMethodEvent(event) && filtered_deoptimization_enabled_) {
+    // Other envs already get the event but the methods this env wants it for might differ.
+    UpdateMethodEventDeoptimization();
   }
 
   return ERR(NONE);
@@ -764,8 +897,12 @@ void EventHandler::Shutdown() {
   art::Runtime::Current()->GetInstrumentation()->RemoveListener(method_trace_listener_.get(), ~0);
 }
 
-EventHandler::EventHandler() {
-  alloc_listener_.reset(new JvmtiAllocationListener(this));
+EventHandler::EventHandler()
+    : alloc_sample_interval_(kDefaultAllocSampleInterval),
+      filtered_deoptimization_enabled_(false) {
+  alloc_listener_.reset(new JvmtiAllocationListener(this, ArtJvmtiEvent::kVmObjectAlloc));
+  sampled_alloc_listener_.reset(
+      new JvmtiAllocationListener(this, ArtJvmtiEvent::kSampledObjectAlloc));
   gc_pause_listener_.reset(new JvmtiGcPauseListener(this));
   method_trace_listener_.reset(new JvmtiMethodTraceListener(this));
 }
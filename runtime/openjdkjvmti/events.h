@@ -18,6 +18,7 @@
 #define ART_RUNTIME_OPENJDKJVMTI_EVENTS_H_
 
 #include <bitset>
+#include <unordered_set>
 #include <vector>
 
 #include "base/logging.h"
@@ -66,6 +67,7 @@ enum class ArtJvmtiEvent {
     kGarbageCollectionFinish = JVMTI_EVENT_GARBAGE_COLLECTION_FINISH,
     kObjectFree = JVMTI_EVENT_OBJECT_FREE,
     kVmObjectAlloc = JVMTI_EVENT_VM_OBJECT_ALLOC,
+    kSampledObjectAlloc = JVMTI_EVENT_SAMPLED_OBJECT_ALLOC,
     kClassFileLoadHookRetransformable = JVMTI_MAX_EVENT_TYPE_VAL + 1,
     kMaxEventTypeVal = kClassFileLoadHookRetransformable,
 };
@@ -175,6 +177,14 @@ class EventHandler {
   ALWAYS_INLINE
   inline void DispatchEvent(ArtJvmTiEnv* env, art::Thread* thread, Args... args) const;
 
+  // Restrict the MethodEntry and MethodExit events of the env to the given methods. An empty set
+  // removes the restriction.
+  void SetMethodEventFilter(ArtJvmTiEnv* env, std::unordered_set<art::ArtMethod*>&& methods);
+
+  // Set the mean interval in bytes between the SampledObjectAlloc events of a thread, shared by
+  // all envs like in the JVMTI specification.
+  void SetAllocationSamplingInterval(size_t interval);
+
   // Tell the event handler capabilities were added/lost so it can adjust the sent events.If
   // caps_added is true then caps is all the newly set capabilities of the jvmtiEnv. If it is false
   // then caps is the set of all capabilities that were removed from the jvmtiEnv.
@@ -211,6 +221,19 @@ class EventHandler {
 
   void HandleEventType(ArtJvmtiEvent event, bool enable);
 
+  void SetupTraceListener(ArtJvmtiEvent event, bool enable);
+
+  // Returns whether every env that has MethodEntry or MethodExit events enabled also has a method
+  // event filter, so only the filtered methods need to be deoptimized.
+  bool CanFilterMethodEvents() const;
+
+  // Deoptimizes the methods in the method event filters and undeoptimizes the ones that are no
+  // longer in any of them. Must be called with all threads suspended.
+  void UpdateFilteredDeoptimization(bool use_filters) REQUIRES(art::Locks::mutator_lock_);
+
+  // Suspends all threads and calls UpdateFilteredDeoptimization.
+  void UpdateMethodEventDeoptimization();
+
   // List of all JvmTiEnv objects that have been created, in their creation order.
   // NB Some elements might be null representing envs that have been deleted. They should be skipped
   // anytime this list is used.
@@ -220,8 +243,19 @@ class EventHandler {
   EventMask global_mask;
 
   std::unique_ptr<JvmtiAllocationListener> alloc_listener_;
+  std::unique_ptr<JvmtiAllocationListener> sampled_alloc_listener_;
   std::unique_ptr<JvmtiGcPauseListener> gc_pause_listener_;
   std::unique_ptr<JvmtiMethodTraceListener> method_trace_listener_;
+
+  // The default sampling interval of the SampledObjectAlloc events is that of the specification.
+  static constexpr size_t kDefaultAllocSampleInterval = 512 * 1024;
+  size_t alloc_sample_interval_;
+
+  // Methods deoptimized for envs with a method event filter. Only non-empty while deoptimizing
+  // the filtered methods is enough for every enabled event that needs the interpreter.
+  std::unordered_set<art::ArtMethod*> filtered_deoptimized_methods_;
+  // Whether we enabled deoptimization in the instrumentation for the filtered methods.
+  bool filtered_deoptimization_enabled_;
 };
 
 }  // namespace openjdkjvmti
@@ -422,7 +422,8 @@ typedef enum {
     JVMTI_EVENT_GARBAGE_COLLECTION_FINISH = 82,
     JVMTI_EVENT_OBJECT_FREE = 83,
     JVMTI_EVENT_VM_OBJECT_ALLOC = 84,
-    JVMTI_MAX_EVENT_TYPE_VAL = 84
+    JVMTI_EVENT_SAMPLED_OBJECT_ALLOC = 86,
+    JVMTI_MAX_EVENT_TYPE_VAL = 86
 } jvmtiEvent;
 
 
@@ -703,7 +704,10 @@ typedef struct {
     unsigned int can_retransform_any_class : 1;
     unsigned int can_generate_resource_exhaustion_heap_events : 1;
     unsigned int can_generate_resource_exhaustion_threads_events : 1;
-    unsigned int : 7;
+    unsigned int can_generate_early_vmstart : 1;
+    unsigned int can_generate_early_class_hook_events : 1;
+    unsigned int can_generate_sampled_object_alloc_events : 1;
+    unsigned int : 4;
     unsigned int : 16;
     unsigned int : 16;
     unsigned int : 16;
@@ -917,6 +921,14 @@ typedef void (JNICALL *jvmtiEventVMObjectAlloc)
      jclass object_klass,
      jlong size);
 
+typedef void (JNICALL *jvmtiEventSampledObjectAlloc)
+    (jvmtiEnv *jvmti_env,
+     JNIEnv* jni_env,
+     jthread thread,
+     jobject object,
+     jclass object_klass,
+     jlong size);
+
 typedef void (JNICALL *jvmtiEventVMStart)
     (jvmtiEnv *jvmti_env,
      JNIEnv* jni_env);
@@ -994,6 +1006,10 @@ typedef struct {
     jvmtiEventObjectFree ObjectFree;
                               /*   84 : VM Object Allocation */
     jvmtiEventVMObjectAlloc VMObjectAlloc;
+                              /*   85 */
+    jvmtiEventReserved reserved85;
+                              /*   86 : Sampled Object Allocation */
+    jvmtiEventSampledObjectAlloc SampledObjectAlloc;
 } jvmtiEventCallbacks;
 
 
@@ -1781,6 +1797,10 @@ typedef struct jvmtiInterface_1_ {
     jint depth,
     jobject* value_ptr);
 
+  /*   156 : Set Heap Sampling Interval */
+  jvmtiError (JNICALL *SetHeapSamplingInterval) (jvmtiEnv* env,
+    jint sampling_interval);
+
 } jvmtiInterface_1;
 
 struct _jvmtiEnv {
@@ -2044,6 +2064,10 @@ struct _jvmtiEnv {
     return functions->GetLocalInstance(this, thread, depth, value_ptr);
   }
 
+  jvmtiError SetHeapSamplingInterval(jint sampling_interval) {
+    return functions->SetHeapSamplingInterval(this, sampling_interval);
+  }
+
   jvmtiError GetLocalInt(jthread thread,
             jint depth,
             jint slot,
@@ -35,6 +35,7 @@
 #include "jvmti_weak_table.h"
 
 #include <limits>
+#include <vector>
 
 #include "art_jvmti.h"
 #include "base/logging.h"
@@ -104,12 +105,12 @@ bool JvmtiWeakTable<T>::RemoveLocked(art::mirror::Object* obj, T* tag) {
 
 template <typename T>
 bool JvmtiWeakTable<T>::RemoveLocked(art::Thread* self, art::mirror::Object* obj, T* tag) {
-  auto it = tagged_objects_.find(art::GcRoot<art::mirror::Object>(obj));
+  auto it = tagged_objects_.Find(art::GcRoot<art::mirror::Object>(obj));
   if (it != tagged_objects_.end()) {
     if (tag != nullptr) {
       *tag = it->second;
     }
-    tagged_objects_.erase(it);
+    tagged_objects_.Erase(it);
     return true;
   }
 
@@ -149,7 +150,7 @@ bool JvmtiWeakTable<T>::SetLocked(art::mirror::Object* obj, T new_tag) {
 
 template <typename T>
 bool JvmtiWeakTable<T>::SetLocked(art::Thread* self, art::mirror::Object* obj, T new_tag) {
-  auto it = tagged_objects_.find(art::GcRoot<art::mirror::Object>(obj));
+  auto it = tagged_objects_.Find(art::GcRoot<art::mirror::Object>(obj));
   if (it != tagged_objects_.end()) {
     it->second = new_tag;
     return true;
@@ -169,8 +170,7 @@ bool JvmtiWeakTable<T>::SetLocked(art::Thread* self, art::mirror::Object* obj, T
   }
 
   // New element.
-  auto insert_it = tagged_objects_.emplace(art::GcRoot<art::mirror::Object>(obj), new_tag);
-  DCHECK(insert_it.second);
+  tagged_objects_.Insert(std::make_pair(art::GcRoot<art::mirror::Object>(obj), new_tag));
   return false;
 }
 
@@ -209,14 +209,9 @@ void JvmtiWeakTable<T>::SweepImpl(art::IsMarkedVisitor* visitor) {
 template <typename T>
 template <typename Updater, typename JvmtiWeakTable<T>::TableUpdateNullTarget kTargetNull>
 ALWAYS_INLINE inline void JvmtiWeakTable<T>::UpdateTableWith(Updater& updater) {
-  // We optimistically hope that elements will still be well-distributed when re-inserting them.
-  // So play with the map mechanics, and postpone rehashing. This avoids the need of a side
-  // vector and two passes.
-  float original_max_load_factor = tagged_objects_.max_load_factor();
-  tagged_objects_.max_load_factor(std::numeric_limits<float>::max());
-  // For checking that a max load-factor actually does what we expect.
-  size_t original_bucket_count = tagged_objects_.bucket_count();
-
+  // Inserting into the open addressing table while walking it could move entries across the
+  // iterator, so moved objects are re-inserted after the walk.
+  std::vector<std::pair<art::GcRoot<art::mirror::Object>, T>> moved;
   for (auto it = tagged_objects_.begin(); it != tagged_objects_.end();) {
     DCHECK(!it->first.IsNull());
     art::mirror::Object* original_obj = it->first.template Read<art::kWithoutReadBarrier>();
@@ -226,21 +221,22 @@ ALWAYS_INLINE inline void JvmtiWeakTable<T>::UpdateTableWith(Updater& updater) {
         // Ignore null target, don't do anything.
       } else {
         T tag = it->second;
-        it = tagged_objects_.erase(it);
+        // Erase fills the slot with a later entry, or advances the iterator.
+        it = tagged_objects_.Erase(it);
         if (target_obj != nullptr) {
-          tagged_objects_.emplace(art::GcRoot<art::mirror::Object>(target_obj), tag);
-          DCHECK_EQ(original_bucket_count, tagged_objects_.bucket_count());
+          moved.emplace_back(art::GcRoot<art::mirror::Object>(target_obj), tag);
         } else if (kTargetNull == kCallHandleNull) {
           HandleNullSweep(tag);
         }
-        continue;  // Iterator was implicitly updated by erase.
+        continue;
       }
     }
     it++;
   }
 
-  tagged_objects_.max_load_factor(original_max_load_factor);
-  // TODO: consider rehash here.
+  for (const auto& entry : moved) {
+    tagged_objects_.Insert(entry);
+  }
 }
 
 template <typename T>
@@ -335,8 +331,8 @@ jvmtiError JvmtiWeakTable<T>::GetTaggedObjects(jvmtiEnv* jvmti_env,
   size_t initial_object_size;
   size_t initial_tag_size;
   if (tag_count == 0) {
-    initial_object_size = (object_result_ptr != nullptr) ? tagged_objects_.size() : 0;
-    initial_tag_size = (tag_result_ptr != nullptr) ? tagged_objects_.size() : 0;
+    initial_object_size = (object_result_ptr != nullptr) ? tagged_objects_.Size() : 0;
+    initial_tag_size = (tag_result_ptr != nullptr) ? tagged_objects_.Size() : 0;
   } else {
     initial_object_size = initial_tag_size = kDefaultSize;
   }
@@ -32,8 +32,7 @@
 #ifndef ART_RUNTIME_OPENJDKJVMTI_JVMTI_WEAK_TABLE_H_
 #define ART_RUNTIME_OPENJDKJVMTI_JVMTI_WEAK_TABLE_H_
 
-#include <unordered_map>
-
+#include "base/hash_map.h"
 #include "base/macros.h"
 #include "base/mutex.h"
 #include "gc/system_weak.h"
@@ -144,7 +143,7 @@ class JvmtiWeakTable : public art::gc::SystemWeakHolder {
   bool GetTagLocked(art::Thread* self, art::mirror::Object* obj, /* out */ T* result)
       REQUIRES_SHARED(art::Locks::mutator_lock_)
       REQUIRES(allow_disallow_lock_) {
-    auto it = tagged_objects_.find(art::GcRoot<art::mirror::Object>(obj));
+    auto it = tagged_objects_.Find(art::GcRoot<art::mirror::Object>(obj));
     if (it != tagged_objects_.end()) {
       *result = it->second;
       return true;
@@ -198,7 +197,9 @@ class JvmtiWeakTable : public art::gc::SystemWeakHolder {
   struct HashGcRoot {
     size_t operator()(const art::GcRoot<art::mirror::Object>& r) const
         REQUIRES_SHARED(art::Locks::mutator_lock_) {
-      return reinterpret_cast<uintptr_t>(r.Read<art::kWithoutReadBarrier>());
+      // Objects are aligned, drop the bits that are always zero.
+      return reinterpret_cast<uintptr_t>(r.Read<art::kWithoutReadBarrier>()) >>
+          art::kObjectAlignmentShift;
     }
   };
 
@@ -210,12 +211,25 @@ class JvmtiWeakTable : public art::gc::SystemWeakHolder {
     }
   };
 
-  using TagAllocator = JvmtiAllocator<std::pair<const art::GcRoot<art::mirror::Object>, T>>;
-  std::unordered_map<art::GcRoot<art::mirror::Object>,
-                     T,
-                     HashGcRoot,
-                     EqGcRoot,
-                     TagAllocator> tagged_objects_
+  // A null root marks an empty slot of the table.
+  struct EmptyGcRoot {
+    void MakeEmpty(std::pair<art::GcRoot<art::mirror::Object>, T>& item) const {
+      item.first = art::GcRoot<art::mirror::Object>(nullptr);
+    }
+    bool IsEmpty(const std::pair<art::GcRoot<art::mirror::Object>, T>& item) const {
+      return item.first.IsNull();
+    }
+  };
+
+  // An open addressing table, agents tag millions of objects and look up tags for every object
+  // of a heap walk.
+  using TagAllocator = JvmtiAllocator<std::pair<art::GcRoot<art::mirror::Object>, T>>;
+  art::HashMap<art::GcRoot<art::mirror::Object>,
+               T,
+               EmptyGcRoot,
+               HashGcRoot,
+               EqGcRoot,
+               TagAllocator> tagged_objects_
       GUARDED_BY(allow_disallow_lock_)
       GUARDED_BY(art::Locks::mutator_lock_);
   // To avoid repeatedly scanning the whole table, remember if we did that since the last sweep.
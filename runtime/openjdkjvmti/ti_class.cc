@@ -1018,7 +1018,7 @@ jvmtiError ClassUtil::GetClassVersionNumbers(jvmtiEnv* env ATTRIBUTE_UNUSED,
 
   // Note: proxies will show the dex file version of java.lang.reflect.Proxy, as that is
   //       what their dex cache copies from.
-  uint32_t version = klass->GetDexFile().GetHeader().GetVersion();
+  uint32_t version = klass->GetDexFile().GetVersion();
 
   *major_version_ptr = static_cast<jint>(version);
   *minor_version_ptr = 0;
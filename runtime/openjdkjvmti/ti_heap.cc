@@ -653,6 +653,40 @@ void HeapUtil::Unregister() {
   art::Runtime::Current()->RemoveSystemWeakHolder(&gIndexCachingTable);
 }
 
+// Holds the tag table lock for the rest of a heap walk once the first object is visited, instead
+// of taking it for every tag lookup. Heap callbacks are not allowed to call the tag functions.
+// Heap::VisitObjects may suspend all threads before visiting, so the lock cannot be taken
+// before the walk.
+class ScopedHeapWalkTagLock {
+ public:
+  explicit ScopedHeapWalkTagLock(ObjectTagTable* tag_table)
+      : tag_table_(tag_table), locked_(false) {}
+
+  ~ScopedHeapWalkTagLock() NO_THREAD_SAFETY_ANALYSIS {
+    Release();
+  }
+
+  void Acquire() NO_THREAD_SAFETY_ANALYSIS {
+    if (!locked_) {
+      tag_table_->Lock();
+      locked_ = true;
+    }
+  }
+
+  void Release() NO_THREAD_SAFETY_ANALYSIS {
+    if (locked_) {
+      tag_table_->Unlock();
+      locked_ = false;
+    }
+  }
+
+ private:
+  ObjectTagTable* const tag_table_;
+  bool locked_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedHeapWalkTagLock);
+};
+
 template <typename T>
 static jvmtiError DoIterateThroughHeap(T fn,
                                        jvmtiEnv* env,
@@ -671,6 +705,11 @@ static jvmtiError DoIterateThroughHeap(T fn,
   bool stop_reports = false;
   const HeapFilter heap_filter(heap_filter_int);
   art::ObjPtr<art::mirror::Class> filter_klass = soa.Decode<art::mirror::Class>(klass);
+  ScopedHeapWalkTagLock tag_lock(tag_table);
+  // The value reports take the tag table lock themselves.
+  const bool reports_values = callbacks->string_primitive_value_callback != nullptr ||
+                              callbacks->array_primitive_value_callback != nullptr ||
+                              callbacks->primitive_field_callback != nullptr;
   auto visitor = [&](art::mirror::Object* obj) REQUIRES_SHARED(art::Locks::mutator_lock_) {
     // Early return, as we can't really stop visiting.
     if (stop_reports) {
@@ -678,13 +717,12 @@ static jvmtiError DoIterateThroughHeap(T fn,
     }
 
     art::ScopedAssertNoThreadSuspension no_suspension("IterateThroughHeapCallback");
+    tag_lock.Acquire();
+    tag_table->AssertLocked();
 
-    jlong tag = 0;
-    tag_table->GetTag(obj, &tag);
-
-    jlong class_tag = 0;
+    jlong tag = tag_table->GetTagOrZeroLocked(obj);
     art::ObjPtr<art::mirror::Class> klass = obj->GetClass();
-    tag_table->GetTag(klass.Ptr(), &class_tag);
+    jlong class_tag = tag_table->GetTagOrZeroLocked(klass.Ptr());
     // For simplicity, even if we find a tag = 0, assume 0 = not tagged.
 
     if (!heap_filter.ShouldReportByHeapFilter(tag, class_tag)) {
@@ -708,15 +746,18 @@ static jvmtiError DoIterateThroughHeap(T fn,
     jint ret = fn(obj, callbacks, class_tag, size, &tag, length, const_cast<void*>(user_data));
 
     if (tag != saved_tag) {
-      tag_table->Set(obj, tag);
+      tag_table->SetLocked(obj, tag);
     }
 
     stop_reports = (ret & JVMTI_VISIT_ABORT) != 0;
 
-    if (!stop_reports) {
-      jint string_ret = ReportString(obj, env, tag_table, callbacks, user_data);
-      stop_reports = (string_ret & JVMTI_VISIT_ABORT) != 0;
+    if (stop_reports || !reports_values) {
+      return;
     }
+    tag_lock.Release();
+
+    jint string_ret = ReportString(obj, env, tag_table, callbacks, user_data);
+    stop_reports = (string_ret & JVMTI_VISIT_ABORT) != 0;
 
     if (!stop_reports) {
       jint array_ret = ReportPrimitiveArray(obj, env, tag_table, callbacks, user_data);
@@ -728,6 +769,7 @@ static jvmtiError DoIterateThroughHeap(T fn,
     }
   };
   art::Runtime::Current()->GetHeap()->VisitObjects(visitor);
+  tag_lock.Release();
 
   return ERR(NONE);
 }
@@ -1519,4 +1561,71 @@ jvmtiError HeapExtensions::IterateThroughHeapExt(jvmtiEnv* env,
                               user_data);
 }
 
+jvmtiError HeapExtensions::IterateThroughHeapBatched(jvmtiEnv* env,
+                                                     jint heap_filter_int,
+                                                     jclass klass,
+                                                     const void* callback,
+                                                     const void* user_data) {
+  if (ArtJvmTiEnv::AsArtJvmTiEnv(env)->capabilities.can_tag_objects != 1) {
+    return ERR(MUST_POSSESS_CAPABILITY);
+  }
+  if (callback == nullptr) {
+    return ERR(NULL_POINTER);
+  }
+
+  using BatchCallback = jint (*)(const jlong*, jint, void*);
+  BatchCallback batch_callback = reinterpret_cast<BatchCallback>(const_cast<void*>(callback));
+  ObjectTagTable* tag_table = ArtJvmTiEnv::AsArtJvmTiEnv(env)->object_tag_table.get();
+
+  art::Thread* self = art::Thread::Current();
+  art::ScopedObjectAccess soa(self);
+
+  const HeapFilter heap_filter(heap_filter_int);
+  art::ObjPtr<art::mirror::Class> filter_klass = soa.Decode<art::mirror::Class>(klass);
+
+  // Each entry is a (class tag, size, tag) triple.
+  static constexpr size_t kEntriesPerBatch = 512;
+  jlong entries[3 * kEntriesPerBatch];
+  size_t count = 0;
+  bool stop_reports = false;
+  ScopedHeapWalkTagLock tag_lock(tag_table);
+  auto report_batch = [&]() {
+    if (count != 0 && !stop_reports) {
+      jint ret = batch_callback(entries, static_cast<jint>(count), const_cast<void*>(user_data));
+      stop_reports = (ret & JVMTI_VISIT_ABORT) != 0;
+    }
+    count = 0;
+  };
+  auto visitor = [&](art::mirror::Object* obj) REQUIRES_SHARED(art::Locks::mutator_lock_) {
+    if (stop_reports) {
+      return;
+    }
+    art::ScopedAssertNoThreadSuspension no_suspension("IterateThroughHeapBatchedCallback");
+    tag_lock.Acquire();
+    tag_table->AssertLocked();
+    art::ObjPtr<art::mirror::Class> obj_klass = obj->GetClass();
+    if (filter_klass != nullptr && filter_klass != obj_klass) {
+      return;
+    }
+    jlong tag = tag_table->GetTagOrZeroLocked(obj);
+    jlong class_tag = tag_table->GetTagOrZeroLocked(obj_klass.Ptr());
+    if (!heap_filter.ShouldReportByHeapFilter(tag, class_tag)) {
+      return;
+    }
+    jlong* entry = &entries[3 * count];
+    entry[0] = class_tag;
+    entry[1] = static_cast<jlong>(obj->SizeOf());
+    entry[2] = tag;
+    if (++count == kEntriesPerBatch) {
+      report_batch();
+    }
+  };
+  art::Runtime::Current()->GetHeap()->VisitObjects(visitor);
+  // The last batch is reported outside of the walk, without the tag table lock.
+  tag_lock.Release();
+  report_batch();
+
+  return ERR(NONE);
+}
+
 }  // namespace openjdkjvmti
@@ -66,6 +66,14 @@ class HeapExtensions {
                                                   jclass klass,
                                                   const jvmtiHeapCallbacks* callbacks,
                                                   const void* user_data);
+
+  // Like IterateThroughHeap, but reports the (class tag, size, tag) triples of the objects to
+  // the callback in batches instead of calling back for every object. Tags are read-only.
+  static jvmtiError JNICALL IterateThroughHeapBatched(jvmtiEnv* env,
+                                                      jint heap_filter,
+                                                      jclass klass,
+                                                      const void* callback,
+                                                      const void* user_data);
 };
 
 }  // namespace openjdkjvmti
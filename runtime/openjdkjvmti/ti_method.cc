@@ -425,4 +425,38 @@ jvmtiError MethodUtil::IsMethodSynthetic(jvmtiEnv* env, jmethodID m, jboolean* i
   return IsMethodT(env, m, test, is_synthetic_ptr);
 }
 
+jvmtiError MethodUtil::SetMethodEventFilter(jvmtiEnv* env, jint count, const jmethodID* methods) {
+  ArtJvmTiEnv* art_env = ArtJvmTiEnv::AsArtJvmTiEnv(env);
+  if (art_env->capabilities.can_generate_method_entry_events != 1 &&
+      art_env->capabilities.can_generate_method_exit_events != 1) {
+    return ERR(MUST_POSSESS_CAPABILITY);
+  }
+  if (count < 0) {
+    return ERR(ILLEGAL_ARGUMENT);
+  }
+  if (count > 0 && methods == nullptr) {
+    return ERR(NULL_POINTER);
+  }
+  std::unordered_set<art::ArtMethod*> filter;
+  {
+    art::ScopedObjectAccess soa(art::Thread::Current());
+    for (jint i = 0; i < count; i++) {
+      if (methods[i] == nullptr) {
+        return ERR(INVALID_METHODID);
+      }
+      art::ArtMethod* method = art::jni::DecodeArtMethod(methods[i]);
+      // Only methods that run dex code can be deoptimized on their own.
+      if (method->IsNative()) {
+        return ERR(NATIVE_METHOD);
+      }
+      if (method->IsProxyMethod() || !method->IsInvokable()) {
+        return ERR(ILLEGAL_ARGUMENT);
+      }
+      filter.insert(method);
+    }
+  }
+  gMethodCallback.event_handler->SetMethodEventFilter(art_env, std::move(filter));
+  return OK;
+}
+
 }  // namespace openjdkjvmti
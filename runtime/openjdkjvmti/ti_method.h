@@ -80,6 +80,10 @@ class MethodUtil {
   static jvmtiError IsMethodNative(jvmtiEnv* env, jmethodID method, jboolean* is_native_ptr);
   static jvmtiError IsMethodObsolete(jvmtiEnv* env, jmethodID method, jboolean* is_obsolete_ptr);
   static jvmtiError IsMethodSynthetic(jvmtiEnv* env, jmethodID method, jboolean* is_synthetic_ptr);
+
+  // Extension: restricts the MethodEntry and MethodExit events of the env to the given methods.
+  // A count of 0 removes the restriction.
+  static jvmtiError SetMethodEventFilter(jvmtiEnv* env, jint count, const jmethodID* methods);
 };
 
 }  // namespace openjdkjvmti
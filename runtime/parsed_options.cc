@@ -135,6 +135,12 @@ std::unique_ptr<RuntimeParser> ParsedOptions::MakeParser(bool ignore_unrecognize
       .Define("-XX:MaxSpinsBeforeThinLockInflation=_")
           .WithType<unsigned int>()
           .IntoKey(M::MaxSpinsBeforeThinLockInflation)
+      .Define("-XX:SampledHeapVerificationRegions=_")
+          .WithType<unsigned int>()
+          .IntoKey(M::SampledHeapVerificationRegions)
+      .Define("-XX:ClassHistogramSamplingRate=_")
+          .WithType<unsigned int>()
+          .IntoKey(M::ClassHistogramSamplingRate)
       .Define("-XX:LongPauseLogThreshold=_")  // in ms
           .WithType<MillisecondsToNanoseconds>()  // store as ns
           .IntoKey(M::LongPauseLogThreshold)
@@ -143,26 +149,57 @@ std::unique_ptr<RuntimeParser> ParsedOptions::MakeParser(bool ignore_unrecognize
           .IntoKey(M::LongGCLogThreshold)
       .Define("-XX:DumpGCPerformanceOnShutdown")
           .IntoKey(M::DumpGCPerformanceOnShutdown)
+      .Define("-XX:DumpTimingsJsonOnShutdown=_")
+          .WithType<std::string>()
+          .IntoKey(M::DumpTimingsJsonOnShutdown)
+      .Define("-XX:DumpStartupPhases")
+          .IntoKey(M::DumpStartupPhases)
+      .Define("-XX:UseSwitchInterpreter")
+          .IntoKey(M::UseSwitchInterpreter)
       .Define("-XX:DumpJITInfoOnShutdown")
           .IntoKey(M::DumpJITInfoOnShutdown)
       .Define("-XX:IgnoreMaxFootprint")
           .IntoKey(M::IgnoreMaxFootprint)
       .Define("-XX:LowMemoryMode")
           .IntoKey(M::LowMemoryMode)
+      .Define("-XX:UseHugePages")
+          .IntoKey(M::UseHugePages)
       .Define("-XX:UseTLAB")
           .WithValue(true)
           .IntoKey(M::UseTLAB)
+      .Define("-XX:UseRosAllocPerCpuRuns")
+          .WithValue(true)
+          .IntoKey(M::UseRosAllocPerCpuRuns)
       .Define({"-XX:EnableHSpaceCompactForOOM", "-XX:DisableHSpaceCompactForOOM"})
           .WithValues({true, false})
           .IntoKey(M::EnableHSpaceCompactForOOM)
+      .Define({"-XX:EnableGcPacer", "-XX:DisableGcPacer"})
+          .WithValues({true, false})
+          .IntoKey(M::EnableGcPacer)
       .Define("-XX:DumpNativeStackOnSigQuit:_")
           .WithType<bool>()
           .WithValueMap({{"false", false}, {"true", true}})
           .IntoKey(M::DumpNativeStackOnSigQuit)
+      .Define("-XX:ForkHeapDump:_")
+          .WithType<bool>()
+          .WithValueMap({{"false", false}, {"true", true}})
+          .IntoKey(M::ForkHeapDump)
       .Define("-XX:MadviseRandomAccess:_")
           .WithType<bool>()
           .WithValueMap({{"false", false}, {"true", true}})
           .IntoKey(M::MadviseRandomAccess)
+      .Define("-Xverifythreads:_")
+          .WithType<unsigned int>()
+          .IntoKey(M::VerifyThreads)
+      .Define("-Ximagefixupthreads:_")
+          .WithType<unsigned int>()
+          .IntoKey(M::ImageFixupThreads)
+      .Define("-Xreferencequeuethreads:_")
+          .WithType<unsigned int>()
+          .IntoKey(M::ReferenceQueueThreads)
+      .Define({"-Xnuma-local-arenas", "-Xnonuma-local-arenas"})
+          .WithValues({true, false})
+          .IntoKey(M::NumaLocalArenas)
       .Define("-Xusejit:_")
           .WithType<bool>()
           .WithValueMap({{"false", false}, {"true", true}})
@@ -173,6 +210,27 @@ std::unique_ptr<RuntimeParser> ParsedOptions::MakeParser(bool ignore_unrecognize
       .Define("-Xjitmaxsize:_")
           .WithType<MemoryKiB>()
           .IntoKey(M::JITCodeCacheMaxCapacity)
+      .Define("-Xjithugepages")
+          .IntoKey(M::JITCodeCacheHugePages)
+      .Define("-Xjitcodecachecompaction")
+          .IntoKey(M::JITCodeCacheCompaction)
+      .Define("-Xjitthreads:_")
+          .WithType<unsigned int>()
+          .IntoKey(M::JITPoolThreads)
+      .Define("-Xjitwarmstart")
+          .IntoKey(M::JITWarmStart)
+      .Define("-Xjitbaseline")
+          .IntoKey(M::JITBaseline)
+      .Define("-Xjitprofilebranches")
+          .IntoKey(M::JITProfileBranches)
+      .Define("-Xjitimplicitsuspendchecks")
+          .IntoKey(M::JITImplicitSuspendChecks)
+      .Define("-Xjitcpubudget:_")
+          .WithType<unsigned int>()
+          .IntoKey(M::JITCpuBudget)
+      .Define("-Xjitzygoteprofile:_")
+          .WithType<std::string>()
+          .IntoKey(M::JITZygoteProfile)
       .Define("-Xjitthreshold:_")
           .WithType<unsigned int>()
           .IntoKey(M::JITCompileThreshold)
@@ -205,12 +263,18 @@ std::unique_ptr<RuntimeParser> ParsedOptions::MakeParser(bool ignore_unrecognize
       .Define("-Xjnitrace:_")
           .WithType<std::string>()
           .IntoKey(M::JniTrace)
+      .Define("-Xjnioptimizednatives:_")
+          .WithType<std::string>()
+          .IntoKey(M::JniOptimizedNatives)
       .Define("-Xpatchoat:_")
           .WithType<std::string>()
           .IntoKey(M::PatchOat)
       .Define({"-Xrelocate", "-Xnorelocate"})
           .WithValues({true, false})
           .IntoKey(M::Relocate)
+      .Define({"-Xrelocate-in-place", "-Xnorelocate-in-place"})
+          .WithValues({true, false})
+          .IntoKey(M::RelocateInPlace)
       .Define({"-Xdex2oat", "-Xnodex2oat"})
           .WithValues({true, false})
           .IntoKey(M::Dex2Oat)
@@ -227,6 +291,7 @@ std::unique_ptr<RuntimeParser> ParsedOptions::MakeParser(bool ignore_unrecognize
           .WithType<gc::space::LargeObjectSpaceType>()
           .WithValueMap({{"disabled", gc::space::LargeObjectSpaceType::kDisabled},
                          {"freelist", gc::space::LargeObjectSpaceType::kFreeList},
+                         {"segregated", gc::space::LargeObjectSpaceType::kSegregatedFit},
                          {"map",      gc::space::LargeObjectSpaceType::kMap}})
           .IntoKey(M::LargeObjectSpace)
       .Define("-XX:LargeObjectThreshold=_")
@@ -246,6 +311,9 @@ std::unique_ptr<RuntimeParser> ParsedOptions::MakeParser(bool ignore_unrecognize
       .Define("-Xstackdumplockprofthreshold:_")
           .WithType<unsigned int>()
           .IntoKey(M::StackDumpLockProfThreshold)
+      .Define({"-Xlockcontentionstats", "-Xnolockcontentionstats"})
+          .WithValues({true, false})
+          .IntoKey(M::LockContentionStats)
       .Define("-Xusetombstonedtraces")
           .WithValue(true)
           .IntoKey(M::UseTombstonedTraces)
@@ -292,6 +360,9 @@ std::unique_ptr<RuntimeParser> ParsedOptions::MakeParser(bool ignore_unrecognize
       .Define("-Xzygote-max-boot-retry=_")
           .WithType<unsigned int>()
           .IntoKey(M::ZygoteMaxFailedBoots)
+      .Define("-Xzygote-dirty-classes:_")
+          .WithType<std::string>()
+          .IntoKey(M::ZygoteDirtyClasses)
       .Define("-Xno-dex-file-fallback")
           .IntoKey(M::NoDexFileFallback)
       .Define("-Xno-sig-chain")
@@ -680,7 +751,9 @@ void ParsedOptions::Usage(const char* fmt, ...) {
 
   UsageMessage(stream, "The following Dalvik options are supported:\n");
   UsageMessage(stream, "  -Xzygote\n");
+  UsageMessage(stream, "  -Xzygote-dirty-classes:<filename>\n");
   UsageMessage(stream, "  -Xjnitrace:substring (eg NativeClass or nativeMethod)\n");
+  UsageMessage(stream, "  -Xjnioptimizednatives:<filename>\n");
   UsageMessage(stream, "  -Xstacktracefile:<filename>\n");
   UsageMessage(stream, "  -Xgc:[no]preverify\n");
   UsageMessage(stream, "  -Xgc:[no]postverify\n");
@@ -691,6 +764,9 @@ void ParsedOptions::Usage(const char* fmt, ...) {
   UsageMessage(stream, "  -XX:HeapTargetUtilization=doublevalue\n");
   UsageMessage(stream, "  -XX:ForegroundHeapGrowthMultiplier=doublevalue\n");
   UsageMessage(stream, "  -XX:LowMemoryMode\n");
+  UsageMessage(stream, "  -XX:UseHugePages\n");
+  UsageMessage(stream, "  -XX:EnableGcPacer\n");
+  UsageMessage(stream, "  -XX:DisableGcPacer\n");
   UsageMessage(stream, "  -Xprofile:{threadcpuclock,wallclock,dualclock}\n");
   UsageMessage(stream, "  -Xjitthreshold:integervalue\n");
   UsageMessage(stream, "\n");
@@ -700,6 +776,7 @@ void ParsedOptions::Usage(const char* fmt, ...) {
   UsageMessage(stream, "  -Xgc:[no]postsweepingverify_rosalloc\n");
   UsageMessage(stream, "  -Xgc:[no]postverify_rosalloc\n");
   UsageMessage(stream, "  -Xgc:[no]presweepingverify\n");
+  UsageMessage(stream, "  -Xgc:[no]generational_cc\n");
   UsageMessage(stream, "  -Ximage:filename\n");
   UsageMessage(stream, "  -Xbootclasspath-locations:bootclasspath\n"
                        "     (override the dex locations of the -Xbootclasspath files)\n");
@@ -707,17 +784,24 @@ void ParsedOptions::Usage(const char* fmt, ...) {
   UsageMessage(stream, "  -XX:ParallelGCThreads=integervalue\n");
   UsageMessage(stream, "  -XX:ConcGCThreads=integervalue\n");
   UsageMessage(stream, "  -XX:MaxSpinsBeforeThinLockInflation=integervalue\n");
+  UsageMessage(stream, "  -XX:SampledHeapVerificationRegions=integervalue\n");
+  UsageMessage(stream, "  -XX:ClassHistogramSamplingRate=integervalue\n");
   UsageMessage(stream, "  -XX:LongPauseLogThreshold=integervalue\n");
   UsageMessage(stream, "  -XX:LongGCLogThreshold=integervalue\n");
   UsageMessage(stream, "  -XX:ThreadSuspendTimeout=integervalue\n");
   UsageMessage(stream, "  -XX:DumpGCPerformanceOnShutdown\n");
+  UsageMessage(stream, "  -XX:DumpTimingsJsonOnShutdown=filename\n");
+  UsageMessage(stream, "  -XX:DumpStartupPhases\n");
+  UsageMessage(stream, "  -XX:UseSwitchInterpreter\n");
   UsageMessage(stream, "  -XX:DumpJITInfoOnShutdown\n");
   UsageMessage(stream, "  -XX:IgnoreMaxFootprint\n");
   UsageMessage(stream, "  -XX:UseTLAB\n");
+  UsageMessage(stream, "  -XX:UseRosAllocPerCpuRuns\n");
   UsageMessage(stream, "  -XX:BackgroundGC=none\n");
-  UsageMessage(stream, "  -XX:LargeObjectSpace={disabled,map,freelist}\n");
+  UsageMessage(stream, "  -XX:LargeObjectSpace={disabled,map,freelist,segregated}\n");
   UsageMessage(stream, "  -XX:LargeObjectThreshold=N\n");
   UsageMessage(stream, "  -XX:DumpNativeStackOnSigQuit=booleanvalue\n");
+  UsageMessage(stream, "  -XX:ForkHeapDump=booleanvalue\n");
   UsageMessage(stream, "  -XX:MadviseRandomAccess:booleanvalue\n");
   UsageMessage(stream, "  -XX:SlowDebug={false,true}\n");
   UsageMessage(stream, "  -Xmethod-trace\n");
@@ -731,6 +815,7 @@ void ParsedOptions::Usage(const char* fmt, ...) {
   UsageMessage(stream, "  -Xps-min-notification-before-wake:integervalue\n");
   UsageMessage(stream, "  -Xps-max-notification-before-wake:integervalue\n");
   UsageMessage(stream, "  -Xps-profile-path:file-path\n");
+  UsageMessage(stream, "  -Xps-delta-writes\n");
   UsageMessage(stream, "  -Xcompiler:filename\n");
   UsageMessage(stream, "  -Xcompiler-option dex2oat-option\n");
   UsageMessage(stream, "  -Ximage-compiler-option dex2oat-option\n");
@@ -738,9 +823,23 @@ void ParsedOptions::Usage(const char* fmt, ...) {
   UsageMessage(stream, "  -Xusejit:booleanvalue\n");
   UsageMessage(stream, "  -Xjitinitialsize:N\n");
   UsageMessage(stream, "  -Xjitmaxsize:N\n");
+  UsageMessage(stream, "  -Xjithugepages\n");
+  UsageMessage(stream, "  -Xjitcodecachecompaction\n");
+  UsageMessage(stream, "  -Xjitthreads:integervalue\n");
+  UsageMessage(stream, "  -Xjitwarmstart\n");
+  UsageMessage(stream, "  -Xjitbaseline\n");
+  UsageMessage(stream, "  -Xjitprofilebranches\n");
+  UsageMessage(stream, "  -Xjitimplicitsuspendchecks\n");
+  UsageMessage(stream, "  -Xjitcpubudget:integervalue\n");
+  UsageMessage(stream, "  -Xjitzygoteprofile:<filename>\n");
   UsageMessage(stream, "  -Xjitwarmupthreshold:integervalue\n");
   UsageMessage(stream, "  -Xjitosrthreshold:integervalue\n");
   UsageMessage(stream, "  -Xjitprithreadweight:integervalue\n");
+  UsageMessage(stream, "  -Xverifythreads:integervalue\n");
+  UsageMessage(stream, "  -Ximagefixupthreads:integervalue\n");
+  UsageMessage(stream, "  -Xreferencequeuethreads:integervalue\n");
+  UsageMessage(stream, "  -X[no]numa-local-arenas\n");
+  UsageMessage(stream, "  -X[no]lockcontentionstats\n");
   UsageMessage(stream, "  -X[no]relocate\n");
   UsageMessage(stream, "  -X[no]dex2oat (Whether to invoke dex2oat on the application)\n");
   UsageMessage(stream, "  -X[no]image-dex2oat (Whether to create and use a boot image)\n");
@@ -19,6 +19,7 @@
 #include "arch/context.h"
 #include "art_method-inl.h"
 #include "base/enums.h"
+#include "base/time_utils.h"
 #include "dex_instruction.h"
 #include "entrypoints/entrypoint_utils.h"
 #include "entrypoints/quick/quick_entrypoints_enum.h"
@@ -294,7 +295,9 @@ class DeoptimizeStackVisitor FINAL : public StackVisitor {
         single_frame_done_(false),
         single_frame_deopt_method_(nullptr),
         single_frame_deopt_quick_method_header_(nullptr),
-        callee_method_(nullptr) {
+        callee_method_(nullptr),
+        catalog_method_header_(nullptr),
+        number_of_deoptimized_frames_(0u) {
   }
 
   ArtMethod* GetSingleFrameDeoptMethod() const {
@@ -305,6 +308,10 @@ class DeoptimizeStackVisitor FINAL : public StackVisitor {
     return single_frame_deopt_quick_method_header_;
   }
 
+  size_t GetNumberOfDeoptimizedFrames() const {
+    return number_of_deoptimized_frames_;
+  }
+
   void FinishStackWalk() REQUIRES_SHARED(Locks::mutator_lock_) {
     // This is the upcall, or the next full frame in single-frame deopt, or the
     // code isn't deoptimizeable. We remember the frame and last pc so that we
@@ -367,6 +374,7 @@ class DeoptimizeStackVisitor FINAL : public StackVisitor {
         DCHECK(updated_vregs != nullptr);
       }
       HandleOptimizingDeoptimization(method, new_frame, updated_vregs);
+      ++number_of_deoptimized_frames_;
       if (updated_vregs != nullptr) {
         // Calling Thread::RemoveDebuggerShadowFrameMapping will also delete the updated_vregs
         // array so this must come after we processed the frame.
@@ -402,9 +410,8 @@ class DeoptimizeStackVisitor FINAL : public StackVisitor {
       REQUIRES_SHARED(Locks::mutator_lock_) {
     const OatQuickMethodHeader* method_header = GetCurrentOatQuickMethodHeader();
     CodeInfo code_info = method_header->GetOptimizedCodeInfo();
-    uintptr_t native_pc_offset = method_header->NativeQuickPcOffset(GetCurrentQuickFramePc());
     CodeInfoEncoding encoding = code_info.ExtractEncoding();
-    StackMap stack_map = code_info.GetStackMapForNativePcOffset(native_pc_offset, encoding);
+    StackMap stack_map = GetCurrentStackMap(code_info, encoding);
     const size_t number_of_vregs = m->GetCodeItem()->registers_size_;
     uint32_t register_mask = code_info.GetRegisterMaskOf(encoding, stack_map);
     BitMemoryRegion stack_mask = code_info.GetStackMaskOf(encoding, stack_map);
@@ -419,24 +426,31 @@ class DeoptimizeStackVisitor FINAL : public StackVisitor {
       return;
     }
 
+    // Decode the location catalog once for the method and the methods inlined in it, and the
+    // locations of all the vregs in one pass, rather than searching both for each vreg.
+    if (catalog_method_header_ != method_header) {
+      code_info.GetDexRegisterLocationCatalog(encoding).GetDexRegisterLocations(
+          code_info.GetNumberOfLocationCatalogEntries(encoding), &catalog_locations_);
+      catalog_method_header_ = method_header;
+    }
+    vreg_map.GetDexRegisterLocations(number_of_vregs, catalog_locations_, &vreg_locations_);
+
     for (uint16_t vreg = 0; vreg < number_of_vregs; ++vreg) {
       if (updated_vregs != nullptr && updated_vregs[vreg]) {
         // Keep the value set by debugger.
         continue;
       }
 
-      DexRegisterLocation::Kind location =
-          vreg_map.GetLocationKind(vreg, number_of_vregs, code_info, encoding);
+      const DexRegisterLocation vreg_location = vreg_locations_[vreg];
+      DexRegisterLocation::Kind location = vreg_location.GetKind();
       static constexpr uint32_t kDeadValue = 0xEBADDE09;
       uint32_t value = kDeadValue;
       bool is_reference = false;
 
       switch (location) {
         case DexRegisterLocation::Kind::kInStack: {
-          const int32_t offset = vreg_map.GetStackOffsetInBytes(vreg,
-                                                                number_of_vregs,
-                                                                code_info,
-                                                                encoding);
+          // The location holds the offset in bytes.
+          const int32_t offset = vreg_location.GetValue();
           const uint8_t* addr = reinterpret_cast<const uint8_t*>(GetCurrentQuickFrame()) + offset;
           value = *reinterpret_cast<const uint32_t*>(addr);
           uint32_t bit = (offset >> 2);
@@ -449,7 +463,7 @@ class DeoptimizeStackVisitor FINAL : public StackVisitor {
         case DexRegisterLocation::Kind::kInRegisterHigh:
         case DexRegisterLocation::Kind::kInFpuRegister:
         case DexRegisterLocation::Kind::kInFpuRegisterHigh: {
-          uint32_t reg = vreg_map.GetMachineRegister(vreg, number_of_vregs, code_info, encoding);
+          uint32_t reg = vreg_location.GetValue();
           bool result = GetRegisterIfAccessible(reg, ToVRegKind(location), &value);
           CHECK(result);
           if (location == DexRegisterLocation::Kind::kInRegister) {
@@ -460,7 +474,7 @@ class DeoptimizeStackVisitor FINAL : public StackVisitor {
           break;
         }
         case DexRegisterLocation::Kind::kConstant: {
-          value = vreg_map.GetConstant(vreg, number_of_vregs, code_info, encoding);
+          value = vreg_location.GetValue();
           if (value == 0) {
             // Make it a reference for extra safety.
             is_reference = true;
@@ -471,12 +485,7 @@ class DeoptimizeStackVisitor FINAL : public StackVisitor {
           break;
         }
         default: {
-          LOG(FATAL)
-              << "Unexpected location kind "
-              << vreg_map.GetLocationInternalKind(vreg,
-                                                  number_of_vregs,
-                                                  code_info,
-                                                  encoding);
+          LOG(FATAL) << "Unexpected location kind " << vreg_location.GetInternalKind();
           UNREACHABLE();
         }
       }
@@ -500,6 +509,11 @@ class DeoptimizeStackVisitor FINAL : public StackVisitor {
   ArtMethod* single_frame_deopt_method_;
   const OatQuickMethodHeader* single_frame_deopt_quick_method_header_;
   ArtMethod* callee_method_;
+  // The method header whose location catalog is decoded in `catalog_locations_`.
+  const OatQuickMethodHeader* catalog_method_header_;
+  std::vector<DexRegisterLocation> catalog_locations_;
+  std::vector<DexRegisterLocation> vreg_locations_;
+  size_t number_of_deoptimized_frames_;
 
   DISALLOW_COPY_AND_ASSIGN(DeoptimizeStackVisitor);
 };
@@ -525,8 +539,11 @@ void QuickExceptionHandler::DeoptimizeStack() {
     self_->DumpStack(LOG_STREAM(INFO) << "Deoptimizing: ");
   }
 
+  uint64_t start_ns = NanoTime();
   DeoptimizeStackVisitor visitor(self_, context_, this, false);
   visitor.WalkStack(true);
+  Runtime::Current()->AddDeoptimizedFrames(visitor.GetNumberOfDeoptimizedFrames(),
+                                           NanoTime() - start_ns);
   PrepareForLongJumpToInvokeStubOrInterpreterBridge();
 }
 
@@ -538,8 +555,11 @@ void QuickExceptionHandler::DeoptimizeSingleFrame(DeoptimizationKind kind) {
     DumpFramesWithType(self_, true);
   }
 
+  uint64_t start_ns = NanoTime();
   DeoptimizeStackVisitor visitor(self_, context_, this, true);
   visitor.WalkStack(true);
+  Runtime::Current()->AddDeoptimizedFrames(visitor.GetNumberOfDeoptimizedFrames(),
+                                           NanoTime() - start_ns);
 
   // Compiled code made an explicit deoptimization.
   ArtMethod* deopt_method = visitor.GetSingleFrameDeoptMethod();
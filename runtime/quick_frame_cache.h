@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_QUICK_FRAME_CACHE_H_
+#define ART_RUNTIME_QUICK_FRAME_CACHE_H_
+
+#include <stdint.h>
+
+#include "atomic.h"
+#include "base/bit_utils.h"
+#include "base/macros.h"
+#include "stack_map.h"
+
+namespace art {
+
+class ArtMethod;
+class OatQuickMethodHeader;
+
+// Per-thread cache of what the stack walks of the thread decoded for compiled frames, keyed by
+// method and pc: the method header found by ArtMethod::GetOatQuickMethodHeader and the stack
+// map of the pc. Walking the same frames again, as GC root visiting and profilers do, then does
+// not look for the code of the method or search its stack maps.
+//
+// The method and pc of a frame determine the code as long as that code is not freed or moved,
+// and the method not unloaded. Since the caches are those of the walking threads, they are
+// invalidated all at once with InvalidateAll() before any of these, and on deoptimization.
+class QuickFrameCache {
+ public:
+  struct Entry {
+    ArtMethod* method;
+    uintptr_t pc;
+    const OatQuickMethodHeader* method_header;
+    // The stack map of `pc`, which may be invalid, if `has_stack_map`.
+    StackMap stack_map;
+    bool has_stack_map;
+  };
+
+  QuickFrameCache() : epoch_(global_epoch_.LoadRelaxed()) {
+    Clear();
+  }
+
+  // Returns the entry of `method` and `pc`, or null if it is not cached. The entry is valid
+  // until the next call to Add().
+  Entry* Lookup(ArtMethod* method, uintptr_t pc) {
+    uint32_t global_epoch = global_epoch_.LoadAcquire();
+    if (UNLIKELY(epoch_ != global_epoch)) {
+      Clear();
+      epoch_ = global_epoch;
+      return nullptr;
+    }
+    Entry& entry = entries_[IndexOf(method, pc)];
+    return (entry.method == method && entry.pc == pc) ? &entry : nullptr;
+  }
+
+  // Add the method header of `method` and `pc`, returns the new entry. Must only be called
+  // after a Lookup() of the same key.
+  Entry* Add(ArtMethod* method, uintptr_t pc, const OatQuickMethodHeader* method_header) {
+    Entry& entry = entries_[IndexOf(method, pc)];
+    entry.method = method;
+    entry.pc = pc;
+    entry.method_header = method_header;
+    entry.stack_map = StackMap();
+    entry.has_stack_map = false;
+    return &entry;
+  }
+
+  void Clear() {
+    for (Entry& entry : entries_) {
+      entry.method = nullptr;
+    }
+  }
+
+  // Invalidate the caches of all the threads.
+  static void InvalidateAll() {
+    global_epoch_.FetchAndAddSequentiallyConsistent(1u);
+  }
+
+ private:
+  static constexpr size_t kSize = 32;
+  static_assert(IsPowerOfTwo(kSize), "kSize must be a power of two");
+
+  static size_t IndexOf(ArtMethod* method, uintptr_t pc) {
+    uintptr_t hash = (reinterpret_cast<uintptr_t>(method) >> 4) ^ pc;
+    return (hash ^ (hash >> 7)) & (kSize - 1);
+  }
+
+  static Atomic<uint32_t> global_epoch_;
+
+  // The value of `global_epoch_` when the entries were added.
+  uint32_t epoch_;
+  Entry entries_[kSize];
+
+  DISALLOW_COPY_AND_ASSIGN(QuickFrameCache);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_QUICK_FRAME_CACHE_H_
@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "quick_frame_cache.h"
+
+#include "gtest/gtest.h"
+
+namespace art {
+
+// Mocks some methods and method headers.
+#define METHOD1 (reinterpret_cast<ArtMethod*>(8u))
+#define METHOD2 (reinterpret_cast<ArtMethod*>(16u))
+#define HEADER1 (reinterpret_cast<const OatQuickMethodHeader*>(64u))
+#define HEADER2 (reinterpret_cast<const OatQuickMethodHeader*>(128u))
+
+TEST(QuickFrameCacheTest, LookupAndInvalidate) {
+  QuickFrameCache cache;
+  EXPECT_EQ(nullptr, cache.Lookup(METHOD1, 0x1004u));
+
+  cache.Add(METHOD1, 0x1004u, HEADER1);
+  QuickFrameCache::Entry* entry = cache.Lookup(METHOD1, 0x1004u);
+  ASSERT_NE(nullptr, entry);
+  EXPECT_EQ(HEADER1, entry->method_header);
+  EXPECT_FALSE(entry->has_stack_map);
+
+  // Both the method and the pc have to match.
+  EXPECT_EQ(nullptr, cache.Lookup(METHOD2, 0x1004u));
+  EXPECT_EQ(nullptr, cache.Lookup(METHOD1, 0x1008u));
+
+  cache.Add(METHOD2, 0x2004u, HEADER2);
+  ASSERT_NE(nullptr, cache.Lookup(METHOD2, 0x2004u));
+  EXPECT_EQ(HEADER2, cache.Lookup(METHOD2, 0x2004u)->method_header);
+
+  // Invalidating clears the caches of all the threads.
+  QuickFrameCache other_cache;
+  other_cache.Add(METHOD1, 0x1004u, HEADER1);
+  QuickFrameCache::InvalidateAll();
+  EXPECT_EQ(nullptr, cache.Lookup(METHOD1, 0x1004u));
+  EXPECT_EQ(nullptr, cache.Lookup(METHOD2, 0x2004u));
+  EXPECT_EQ(nullptr, other_cache.Lookup(METHOD1, 0x1004u));
+
+  // Entries added after the invalidation are found.
+  cache.Add(METHOD1, 0x1004u, HEADER2);
+  ASSERT_NE(nullptr, cache.Lookup(METHOD1, 0x1004u));
+  EXPECT_EQ(HEADER2, cache.Lookup(METHOD1, 0x1004u)->method_header);
+}
+
+}  // namespace art
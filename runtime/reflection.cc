@@ -38,6 +38,53 @@ namespace art {
 
 using android::base::StringPrintf;
 
+// Reads the value of a boxed primitive. Returns false if `box` is not an instance of one of the
+// java.lang wrapper classes. These have a single instance field holding the value, so its type
+// tells which wrapper class to compare with and one descriptor comparison is enough.
+static bool GetBoxedPrimitive(ObjPtr<mirror::Object> box, Primitive::Type* type, JValue* value)
+    REQUIRES_SHARED(Locks::mutator_lock_) {
+  ObjPtr<mirror::Class> klass = box->GetClass();
+  if (klass->NumInstanceFields() != 1u) {
+    return false;
+  }
+  ArtField* value_field = &klass->GetIFieldsPtr()->At(0);
+  Primitive::Type value_type = value_field->GetTypeAsPrimitiveType();
+  if (value_type == Primitive::kPrimNot ||
+      !klass->DescriptorEquals(Primitive::BoxedDescriptor(value_type))) {
+    return false;
+  }
+  switch (value_type) {
+    case Primitive::kPrimBoolean:
+      value->SetZ(value_field->GetBoolean(box));
+      break;
+    case Primitive::kPrimByte:
+      value->SetB(value_field->GetByte(box));
+      break;
+    case Primitive::kPrimChar:
+      value->SetC(value_field->GetChar(box));
+      break;
+    case Primitive::kPrimShort:
+      value->SetS(value_field->GetShort(box));
+      break;
+    case Primitive::kPrimInt:
+      value->SetI(value_field->GetInt(box));
+      break;
+    case Primitive::kPrimLong:
+      value->SetJ(value_field->GetLong(box));
+      break;
+    case Primitive::kPrimFloat:
+      value->SetF(value_field->GetFloat(box));
+      break;
+    case Primitive::kPrimDouble:
+      value->SetD(value_field->GetDouble(box));
+      break;
+    default:
+      return false;
+  }
+  *type = value_type;
+  return true;
+}
+
 class ArgArray {
  public:
   ArgArray(const char* shorty, uint32_t shorty_len)
@@ -255,99 +302,40 @@ class ArgArray {
         }
       }
 
-#define DO_FIRST_ARG(match_descriptor, get_fn, append) { \
-          if (LIKELY(arg != nullptr && \
-              arg->GetClass()->DescriptorEquals(match_descriptor))) { \
-            ArtField* primitive_field = arg->GetClass()->GetInstanceField(0); \
-            append(primitive_field-> get_fn(arg.Get()));
-
-#define DO_ARG(match_descriptor, get_fn, append) \
-          } else if (LIKELY(arg != nullptr && \
-                            arg->GetClass<>()->DescriptorEquals(match_descriptor))) { \
-            ArtField* primitive_field = arg->GetClass()->GetInstanceField(0); \
-            append(primitive_field-> get_fn(arg.Get()));
-
-#define DO_FAIL(expected) \
-          } else { \
-            if (arg->GetClass<>()->IsPrimitive()) { \
-              std::string temp; \
-              ThrowIllegalPrimitiveArgumentException(expected, \
-                                                     arg->GetClass<>()->GetDescriptor(&temp)); \
-            } else { \
-              ThrowIllegalArgumentException(\
-                  StringPrintf("method %s argument %zd has type %s, got %s", \
-                      ArtMethod::PrettyMethod(m, false).c_str(), \
-                      args_offset + 1, \
-                      expected, \
-                      mirror::Object::PrettyTypeOf(arg.Get()).c_str()).c_str()); \
-            } \
-            return false; \
-          } }
+      if (shorty_[i] == 'L') {
+        Append(arg.Get());
+        continue;
+      }
 
-      switch (shorty_[i]) {
-        case 'L':
-          Append(arg.Get());
-          break;
-        case 'Z':
-          DO_FIRST_ARG("Ljava/lang/Boolean;", GetBoolean, Append)
-          DO_FAIL("boolean")
-          break;
-        case 'B':
-          DO_FIRST_ARG("Ljava/lang/Byte;", GetByte, Append)
-          DO_FAIL("byte")
-          break;
-        case 'C':
-          DO_FIRST_ARG("Ljava/lang/Character;", GetChar, Append)
-          DO_FAIL("char")
-          break;
-        case 'S':
-          DO_FIRST_ARG("Ljava/lang/Short;", GetShort, Append)
-          DO_ARG("Ljava/lang/Byte;", GetByte, Append)
-          DO_FAIL("short")
-          break;
-        case 'I':
-          DO_FIRST_ARG("Ljava/lang/Integer;", GetInt, Append)
-          DO_ARG("Ljava/lang/Character;", GetChar, Append)
-          DO_ARG("Ljava/lang/Short;", GetShort, Append)
-          DO_ARG("Ljava/lang/Byte;", GetByte, Append)
-          DO_FAIL("int")
-          break;
-        case 'J':
-          DO_FIRST_ARG("Ljava/lang/Long;", GetLong, AppendWide)
-          DO_ARG("Ljava/lang/Integer;", GetInt, AppendWide)
-          DO_ARG("Ljava/lang/Character;", GetChar, AppendWide)
-          DO_ARG("Ljava/lang/Short;", GetShort, AppendWide)
-          DO_ARG("Ljava/lang/Byte;", GetByte, AppendWide)
-          DO_FAIL("long")
+      // Unbox the argument, allowing the widening conversions of Method.invoke().
+      const Primitive::Type dst_type = Primitive::GetType(shorty_[i]);
+      Primitive::Type src_type;
+      JValue boxed_value;
+      JValue value;
+      if (UNLIKELY(!GetBoxedPrimitive(arg.Get(), &src_type, &boxed_value) ||
+                   !ConvertPrimitiveValueNoThrow(src_type, dst_type, boxed_value, &value))) {
+        ThrowIllegalArgumentException(
+            StringPrintf("method %s argument %zd has type %s, got %s",
+                ArtMethod::PrettyMethod(m, false).c_str(),
+                args_offset + 1,  // Humans don't count from 0.
+                Primitive::PrettyDescriptor(dst_type),
+                mirror::Object::PrettyTypeOf(arg.Get()).c_str()).c_str());
+        return false;
+      }
+      switch (dst_type) {
+        case Primitive::kPrimLong:
+          AppendWide(value.GetJ());
           break;
-        case 'F':
-          DO_FIRST_ARG("Ljava/lang/Float;", GetFloat, AppendFloat)
-          DO_ARG("Ljava/lang/Long;", GetLong, AppendFloat)
-          DO_ARG("Ljava/lang/Integer;", GetInt, AppendFloat)
-          DO_ARG("Ljava/lang/Character;", GetChar, AppendFloat)
-          DO_ARG("Ljava/lang/Short;", GetShort, AppendFloat)
-          DO_ARG("Ljava/lang/Byte;", GetByte, AppendFloat)
-          DO_FAIL("float")
+        case Primitive::kPrimFloat:
+          AppendFloat(value.GetF());
           break;
-        case 'D':
-          DO_FIRST_ARG("Ljava/lang/Double;", GetDouble, AppendDouble)
-          DO_ARG("Ljava/lang/Float;", GetFloat, AppendDouble)
-          DO_ARG("Ljava/lang/Long;", GetLong, AppendDouble)
-          DO_ARG("Ljava/lang/Integer;", GetInt, AppendDouble)
-          DO_ARG("Ljava/lang/Character;", GetChar, AppendDouble)
-          DO_ARG("Ljava/lang/Short;", GetShort, AppendDouble)
-          DO_ARG("Ljava/lang/Byte;", GetByte, AppendDouble)
-          DO_FAIL("double")
+        case Primitive::kPrimDouble:
+          AppendDouble(value.GetD());
           break;
-#ifndef NDEBUG
         default:
-          LOG(FATAL) << "Unexpected shorty character: " << shorty_[i];
-          UNREACHABLE();
-#endif
+          Append(value.GetI());
+          break;
       }
-#undef DO_FIRST_ARG
-#undef DO_ARG
-#undef DO_FAIL
     }
     return true;
   }
@@ -812,35 +800,8 @@ static bool UnboxPrimitive(ObjPtr<mirror::Object> o,
   }
 
   JValue boxed_value;
-  ObjPtr<mirror::Class> klass = o->GetClass();
-  ObjPtr<mirror::Class> src_class = nullptr;
-  ClassLinker* const class_linker = Runtime::Current()->GetClassLinker();
-  ArtField* primitive_field = &klass->GetIFieldsPtr()->At(0);
-  if (klass->DescriptorEquals("Ljava/lang/Boolean;")) {
-    src_class = class_linker->FindPrimitiveClass('Z');
-    boxed_value.SetZ(primitive_field->GetBoolean(o));
-  } else if (klass->DescriptorEquals("Ljava/lang/Byte;")) {
-    src_class = class_linker->FindPrimitiveClass('B');
-    boxed_value.SetB(primitive_field->GetByte(o));
-  } else if (klass->DescriptorEquals("Ljava/lang/Character;")) {
-    src_class = class_linker->FindPrimitiveClass('C');
-    boxed_value.SetC(primitive_field->GetChar(o));
-  } else if (klass->DescriptorEquals("Ljava/lang/Float;")) {
-    src_class = class_linker->FindPrimitiveClass('F');
-    boxed_value.SetF(primitive_field->GetFloat(o));
-  } else if (klass->DescriptorEquals("Ljava/lang/Double;")) {
-    src_class = class_linker->FindPrimitiveClass('D');
-    boxed_value.SetD(primitive_field->GetDouble(o));
-  } else if (klass->DescriptorEquals("Ljava/lang/Integer;")) {
-    src_class = class_linker->FindPrimitiveClass('I');
-    boxed_value.SetI(primitive_field->GetInt(o));
-  } else if (klass->DescriptorEquals("Ljava/lang/Long;")) {
-    src_class = class_linker->FindPrimitiveClass('J');
-    boxed_value.SetJ(primitive_field->GetLong(o));
-  } else if (klass->DescriptorEquals("Ljava/lang/Short;")) {
-    src_class = class_linker->FindPrimitiveClass('S');
-    boxed_value.SetS(primitive_field->GetShort(o));
-  } else {
+  Primitive::Type src_type;
+  if (!GetBoxedPrimitive(o, &src_type, &boxed_value)) {
     std::string temp;
     ThrowIllegalArgumentException(
         StringPrintf("%s has type %s, got %s", UnboxingFailureKind(f).c_str(),
@@ -850,7 +811,7 @@ static bool UnboxPrimitive(ObjPtr<mirror::Object> o,
   }
 
   return ConvertPrimitiveValue(unbox_for_result,
-                               src_class->GetPrimitiveType(), dst_class->GetPrimitiveType(),
+                               src_type, dst_class->GetPrimitiveType(),
                                boxed_value, unboxed_value);
 }
 
@@ -536,6 +536,39 @@ TEST_F(ReflectionTest, StaticMainMethod) {
   InvokeWithJValues(soa, nullptr, jni::EncodeArtMethod(method), args);
 }
 
+TEST_F(ReflectionTest, UnboxPrimitive) {
+  ScopedObjectAccess soa(Thread::Current());
+  StackHandleScope<2> hs(soa.Self());
+  Handle<mirror::Class> integer_class =
+      hs.NewHandle(class_linker_->FindSystemClass(soa.Self(), "Ljava/lang/Integer;"));
+  ASSERT_TRUE(integer_class != nullptr);
+  Handle<mirror::Object> boxed_int = hs.NewHandle(integer_class->AllocObject(soa.Self()));
+  ASSERT_TRUE(boxed_int != nullptr);
+  integer_class->GetIFieldsPtr()->At(0).SetInt<false>(boxed_int.Get(), 42);
+
+  // Integer widens to long.
+  JValue value;
+  EXPECT_TRUE(UnboxPrimitiveForResult(boxed_int.Get(), class_linker_->FindPrimitiveClass('J'),
+                                      &value));
+  EXPECT_EQ(42, value.GetJ());
+  EXPECT_FALSE(soa.Self()->IsExceptionPending());
+
+  // Integer does not narrow to short.
+  EXPECT_FALSE(UnboxPrimitiveForResult(boxed_int.Get(), class_linker_->FindPrimitiveClass('S'),
+                                       &value));
+  EXPECT_TRUE(soa.Self()->IsExceptionPending());
+  soa.Self()->ClearException();
+
+  // An object of no wrapper class with no instance field.
+  ObjPtr<mirror::Object> object =
+      class_linker_->FindSystemClass(soa.Self(), "Ljava/lang/Object;")->AllocObject(soa.Self());
+  ASSERT_TRUE(object != nullptr);
+  EXPECT_FALSE(UnboxPrimitiveForResult(object, class_linker_->FindPrimitiveClass('I'),
+                                       &value));
+  EXPECT_TRUE(soa.Self()->IsExceptionPending());
+  soa.Self()->ClearException();
+}
+
 TEST_F(ReflectionTest, StaticNopMethod) {
   InvokeNopMethod(true);
 }
@@ -34,6 +34,7 @@
 #include <cstdlib>
 #include <limits>
 #include <memory_representation.h>
+#include <sstream>
 #include <vector>
 #include <fcntl.h>
 
@@ -63,6 +64,7 @@
 #include "base/enums.h"
 #include "base/stl_util.h"
 #include "base/systrace.h"
+#include "base/time_utils.h"
 #include "base/unix_file/fd_file.h"
 #include "class_linker-inl.h"
 #include "compiler_callbacks.h"
@@ -73,12 +75,14 @@
 #include "fault_handler.h"
 #include "gc/accounting/card_table-inl.h"
 #include "gc/heap.h"
+#include "gc/reference_processor.h"
 #include "gc/scoped_gc_critical_section.h"
 #include "gc/space/image_space.h"
 #include "gc/space/space-inl.h"
 #include "gc/system_weak.h"
 #include "handle_scope-inl.h"
 #include "image-inl.h"
+#include "indirect_reference_table.h"
 #include "instrumentation.h"
 #include "intern_table.h"
 #include "interpreter/interpreter.h"
@@ -88,6 +92,8 @@
 #include "jit/profile_saver.h"
 #include "jni_internal.h"
 #include "linear_alloc.h"
+#include "lock_contention_profiler.h"
+#include "mem_map.h"
 #include "mirror/array.h"
 #include "mirror/class-inl.h"
 #include "mirror/class_ext.h"
@@ -147,8 +153,10 @@
 #include "sigchain.h"
 #include "signal_catcher.h"
 #include "signal_set.h"
+#include "startup_phases.h"
 #include "thread.h"
 #include "thread_list.h"
+#include "thread_pool.h"
 #include "ti/agent.h"
 #include "trace.h"
 #include "transaction.h"
@@ -209,6 +217,7 @@ Runtime::Runtime()
       compiler_callbacks_(nullptr),
       is_zygote_(false),
       must_relocate_(false),
+      relocate_in_place_(false),
       is_concurrent_gc_enabled_(true),
       is_explicit_gc_disabled_(false),
       dex2oat_enabled_(true),
@@ -242,6 +251,10 @@ Runtime::Runtime()
       system_thread_group_(nullptr),
       system_class_loader_(nullptr),
       dump_gc_performance_on_shutdown_(false),
+      use_switch_interpreter_(false),
+      verify_threads_(0u),
+      image_fixup_threads_(0u),
+      reference_queue_threads_(0u),
       preinitialization_transaction_(nullptr),
       verify_(verifier::VerifyMode::kNone),
       allow_dex_file_fallback_(true),
@@ -260,6 +273,7 @@ Runtime::Runtime()
       is_low_memory_mode_(false),
       safe_mode_(false),
       dump_native_stack_on_sig_quit_(true),
+      fork_heap_dump_(false),
       pruned_dalvik_cache_(false),
       // Initially assume we perceive jank in case the process state is never updated.
       process_state_(kProcessStateJankPerceptible),
@@ -274,6 +288,12 @@ Runtime::Runtime()
   for (size_t i = 0; i <= static_cast<size_t>(DeoptimizationKind::kLast); ++i) {
     deoptimization_counts_[i] = 0u;
   }
+  deoptimized_frames_ = 0u;
+  deoptimization_time_ns_ = 0u;
+  for (size_t i = 0; i <= kSystemWeakLast; ++i) {
+    system_weak_sweeps_[i] = 0u;
+    system_weak_sweep_time_ns_[i] = 0u;
+  }
 }
 
 Runtime::~Runtime() {
@@ -298,6 +318,14 @@ Runtime::~Runtime() {
     heap_->DumpGcPerformanceInfo(LOG_STREAM(INFO));
   }
 
+  if (!dump_timings_json_on_shutdown_.empty()) {
+    DumpTimingsJson();
+  }
+
+  if (startup_phases_ != nullptr) {
+    startup_phases_->Dump(LOG_STREAM(INFO));
+  }
+
   if (jit_ != nullptr) {
     // Stop the profile saver thread before marking the runtime as shutting down.
     // The saver will try to dump the profiles before being sopped and that
@@ -325,6 +353,11 @@ Runtime::~Runtime() {
 
   Trace::Shutdown();
 
+  // The verification threads may be loading classes, stop them while this thread is attached.
+  class_linker_->DeleteVerificationThreadPool();
+  // The enqueue threads run Cleaners, stop them while this thread is attached as well.
+  heap_->GetReferenceProcessor()->DeleteEnqueueThreadPool();
+
   // Report death. Clients me require a working thread, still, so do it before GC completes and
   // all non-daemon threads are done.
   {
@@ -377,6 +410,8 @@ Runtime::~Runtime() {
     VLOG(jit) << "Deleting jit";
     jit_.reset(nullptr);
   }
+  // The zygote, and the children that did not take over its JIT, still have the zygote's.
+  zygote_jit_.reset(nullptr);
 
   // Shutdown the fault manager if it was initialized.
   fault_manager.Shutdown();
@@ -385,6 +420,7 @@ Runtime::~Runtime() {
   delete monitor_list_;
   delete monitor_pool_;
   delete class_linker_;
+  ArtMethod::SetBootImageHotnessCounters(0u, 0u, nullptr);
   delete heap_;
   delete intern_table_;
   delete oat_file_manager_;
@@ -394,6 +430,7 @@ Runtime::~Runtime() {
 
   // Destroy allocators before shutting down the MemMap because they may use it.
   java_vm_.reset();
+  irt_chunk_pool_.reset();
   linear_alloc_.reset();
   low_4gb_arena_pool_.reset();
   arena_pool_.reset();
@@ -556,9 +593,34 @@ void Runtime::Abort(const char* msg) {
 }
 
 void Runtime::PreZygoteFork() {
+  // Compile before the first fork, which compacts the heap of the zygote: the code pages are then
+  // shared with all the children.
+  if (!heap_->HasZygoteSpace() &&
+      jit_options_->UseJitCompilation() &&
+      !jit_options_->GetZygoteProfile().empty()) {
+    CreateZygoteJit();
+  }
   heap_->PreZygoteFork();
 }
 
+void Runtime::CreateZygoteJit() {
+  ScopedTrace trace(__FUNCTION__);
+  DCHECK(IsZygote());
+  DCHECK(jit_ == nullptr);
+  std::string error_msg;
+  jit_.reset(jit::Jit::Create(jit_options_.get(), /* for_zygote */ true, &error_msg));
+  if (jit_ == nullptr) {
+    LOG(WARNING) << "Failed to create zygote JIT " << error_msg;
+    return;
+  }
+  // The compiler finds the code cache through GetJit(). Otherwise the zygote has no JIT: it does
+  // not profile, and never runs the code it compiled.
+  jit_->CompileZygoteMethods(Thread::Current(), jit_options_->GetZygoteProfile());
+  zygote_jit_ = std::move(jit_);
+  // Don't let the children inherit the compiler's arenas.
+  jit_arena_pool_->TrimMaps();
+}
+
 void Runtime::CallExitHook(jint status) {
   if (exit_ != nullptr) {
     ScopedThreadStateChange tsc(Thread::Current(), kNative);
@@ -567,23 +629,119 @@ void Runtime::CallExitHook(jint status) {
   }
 }
 
+static const char* GetSystemWeakKindName(Runtime::SystemWeakKind kind) {
+  switch (kind) {
+    case Runtime::kSystemWeakInternTable: return "intern table";
+    case Runtime::kSystemWeakMonitorList: return "monitor list";
+    case Runtime::kSystemWeakJniWeakGlobals: return "JNI weak globals";
+    case Runtime::kSystemWeakAllocationRecords: return "allocation records";
+    case Runtime::kSystemWeakJitRootTables: return "JIT root tables";
+    case Runtime::kSystemWeakHolders: return "system weak holders";
+  }
+  LOG(FATAL) << "Unexpected system weak kind " << static_cast<int>(kind);
+  UNREACHABLE();
+}
+
+void Runtime::SweepSystemWeak(SystemWeakKind kind,
+                              gc::AbstractSystemWeakHolder* holder,
+                              IsMarkedVisitor* visitor) {
+  const uint64_t start_time = NanoTime();
+  switch (kind) {
+    case kSystemWeakInternTable:
+      GetInternTable()->SweepInternTableWeaks(visitor);
+      break;
+    case kSystemWeakMonitorList:
+      GetMonitorList()->SweepMonitorList(visitor);
+      break;
+    case kSystemWeakJniWeakGlobals:
+      GetJavaVM()->SweepJniWeakGlobals(visitor);
+      break;
+    case kSystemWeakAllocationRecords:
+      GetHeap()->SweepAllocationRecords(visitor);
+      break;
+    case kSystemWeakJitRootTables:
+      // Visit JIT literal tables. Objects in these tables are classes and strings
+      // and only classes can be affected by class unloading. The strings always
+      // stay alive as they are strongly interned.
+      // TODO: Move this closer to CleanupClassLoaders, to avoid blocking weak accesses
+      // from mutators. See b/32167580.
+      GetJit()->GetCodeCache()->SweepRootTables(visitor);
+      break;
+    case kSystemWeakHolders:
+      holder->Sweep(visitor);
+      break;
+  }
+  system_weak_sweeps_[kind].fetch_add(1u, std::memory_order_relaxed);
+  system_weak_sweep_time_ns_[kind].fetch_add(NanoTime() - start_time, std::memory_order_relaxed);
+}
+
+// Sweeps one of the system weaks on a thread of the heap thread pool.
+class SweepSystemWeakTask : public Task {
+ public:
+  SweepSystemWeakTask(Runtime::SystemWeakKind kind,
+                      gc::AbstractSystemWeakHolder* holder,
+                      IsMarkedVisitor* visitor)
+      : kind_(kind), holder_(holder), visitor_(visitor) {}
+
+  // The GC thread holds the mutator lock and waits for the sweeps to finish.
+  void Run(Thread* self ATTRIBUTE_UNUSED) OVERRIDE NO_THREAD_SAFETY_ANALYSIS {
+    Runtime::Current()->SweepSystemWeak(kind_, holder_, visitor_);
+  }
+
+  void Finalize() OVERRIDE {
+    delete this;
+  }
+
+ private:
+  const Runtime::SystemWeakKind kind_;
+  gc::AbstractSystemWeakHolder* const holder_;
+  IsMarkedVisitor* const visitor_;
+};
+
 void Runtime::SweepSystemWeaks(IsMarkedVisitor* visitor) {
-  GetInternTable()->SweepInternTableWeaks(visitor);
-  GetMonitorList()->SweepMonitorList(visitor);
-  GetJavaVM()->SweepJniWeakGlobals(visitor);
-  GetHeap()->SweepAllocationRecords(visitor);
+  // The system weaks of the runtime, then all other generic system-weak holders. The intern
+  // table is swept by this thread: with the concurrent copying collector, hashing the strings
+  // erased from the weak interns may mark them, which only the GC thread can do.
+  std::vector<std::pair<SystemWeakKind, gc::AbstractSystemWeakHolder*>> sweeps = {
+    { kSystemWeakMonitorList, nullptr },
+    { kSystemWeakJniWeakGlobals, nullptr },
+    { kSystemWeakAllocationRecords, nullptr },
+  };
   if (GetJit() != nullptr) {
-    // Visit JIT literal tables. Objects in these tables are classes and strings
-    // and only classes can be affected by class unloading. The strings always
-    // stay alive as they are strongly interned.
-    // TODO: Move this closer to CleanupClassLoaders, to avoid blocking weak accesses
-    // from mutators. See b/32167580.
-    GetJit()->GetCodeCache()->SweepRootTables(visitor);
+    sweeps.emplace_back(kSystemWeakJitRootTables, nullptr);
   }
-
-  // All other generic system-weak holders.
   for (gc::AbstractSystemWeakHolder* holder : system_weak_holders_) {
-    holder->Sweep(visitor);
+    sweeps.emplace_back(kSystemWeakHolders, holder);
+  }
+
+  ThreadPool* const thread_pool = GetHeap()->GetThreadPool();
+  if (thread_pool == nullptr) {
+    SweepSystemWeak(kSystemWeakInternTable, nullptr, visitor);
+    for (const auto& sweep : sweeps) {
+      SweepSystemWeak(sweep.first, sweep.second, visitor);
+    }
+    return;
+  }
+  // Each holder sweeps under its own locks and the visitor only reads the marks, so the sweeps
+  // do not depend on each other.
+  Thread* const self = Thread::Current();
+  for (const auto& sweep : sweeps) {
+    thread_pool->AddTask(self, new SweepSystemWeakTask(sweep.first, sweep.second, visitor));
+  }
+  thread_pool->SetMaxActiveWorkers(std::min(sweeps.size(), thread_pool->GetThreadCount()));
+  thread_pool->StartWorkers(self);
+  SweepSystemWeak(kSystemWeakInternTable, nullptr, visitor);
+  thread_pool->Wait(self, /* do_work */ true, /* may_hold_locks */ true);
+  thread_pool->StopWorkers(self);
+}
+
+void Runtime::DumpSystemWeakSweeps(std::ostream& os) {
+  for (size_t i = 0; i <= kSystemWeakLast; ++i) {
+    if (system_weak_sweeps_[i] != 0u) {
+      os << "Sweeps of the " << GetSystemWeakKindName(static_cast<SystemWeakKind>(i)) << ": "
+         << system_weak_sweeps_[i] << " in " << PrettyDuration(system_weak_sweep_time_ns_[i])
+         << "\n";
+    }
   }
 }
 
@@ -631,6 +789,7 @@ bool Runtime::Create(const RuntimeOptions& raw_options, bool ignore_unrecognized
 }
 
 static jobject CreateSystemClassLoader(Runtime* runtime) {
+  ScopedStartupPhase startup_phase(__FUNCTION__);
   if (runtime->IsAotCompiler() && !runtime->GetCompilerCallbacks()->IsBootImage()) {
     return nullptr;
   }
@@ -695,6 +854,7 @@ std::string Runtime::GetCompilerExecutable() const {
 
 bool Runtime::Start() {
   VLOG(startup) << "Runtime::Start entering";
+  ScopedStartupPhase startup_phase(__FUNCTION__);
 
   CHECK(!no_sig_chain_) << "A started runtime should have sig chain enabled";
 
@@ -838,6 +998,12 @@ void Runtime::InitNonZygoteOrPostFork(
 
   // Create the thread pools.
   heap_->CreateThreadPool();
+  if (verify_threads_ != 0u && IsVerificationEnabled() && !IsAotCompiler()) {
+    class_linker_->CreateVerificationThreadPool(verify_threads_);
+  }
+  if (reference_queue_threads_ != 0u && !IsAotCompiler()) {
+    heap_->GetReferenceProcessor()->CreateEnqueueThreadPool(reference_queue_threads_);
+  }
   // Reset the gc performance data at zygote fork so that the GCs
   // before fork aren't attributed to an app.
   heap_->ResetGcPerformanceInfo();
@@ -872,6 +1038,7 @@ bool Runtime::IsShuttingDown(Thread* self) {
 
 void Runtime::StartDaemonThreads() {
   ScopedTrace trace(__FUNCTION__);
+  ScopedStartupPhase startup_phase(__FUNCTION__);
   VLOG(startup) << "Runtime::StartDaemonThreads entering";
 
   Thread* self = Thread::Current();
@@ -1040,6 +1207,10 @@ bool Runtime::Init(RuntimeArgumentMap&& runtime_options_in) {
 
   RuntimeArgumentMap runtime_options(std::move(runtime_options_in));
   ScopedTrace trace(__FUNCTION__);
+  if (runtime_options.Exists(RuntimeArgumentMap::DumpStartupPhases)) {
+    startup_phases_.reset(new StartupPhases());
+  }
+  ScopedStartupPhase startup_phase(__FUNCTION__);
   CHECK_EQ(sysconf(_SC_PAGE_SIZE), kPageSize);
 
   MemMap::Init();
@@ -1078,6 +1249,12 @@ bool Runtime::Init(RuntimeArgumentMap&& runtime_options_in) {
   Thread::SetSensitiveThreadHook(runtime_options.GetOrDefault(Opt::HookIsSensitiveThread));
   Monitor::Init(runtime_options.GetOrDefault(Opt::LockProfThreshold),
                 runtime_options.GetOrDefault(Opt::StackDumpLockProfThreshold));
+  if (runtime_options.GetOrDefault(Opt::LockContentionStats)) {
+    BaseMutex::SetContentionStatsEnabled(true);
+  }
+  if (runtime_options.GetOrDefault(Opt::LockProfThreshold) != 0u) {
+    lock_contention_profiler_.reset(new LockContentionProfiler());
+  }
 
   boot_class_path_string_ = runtime_options.ReleaseOrDefault(Opt::BootClassPath);
   class_path_string_ = runtime_options.ReleaseOrDefault(Opt::ClassPath);
@@ -1086,11 +1263,13 @@ bool Runtime::Init(RuntimeArgumentMap&& runtime_options_in) {
   compiler_callbacks_ = runtime_options.GetOrDefault(Opt::CompilerCallbacksPtr);
   patchoat_executable_ = runtime_options.ReleaseOrDefault(Opt::PatchOat);
   must_relocate_ = runtime_options.GetOrDefault(Opt::Relocate);
+  relocate_in_place_ = runtime_options.GetOrDefault(Opt::RelocateInPlace);
   is_zygote_ = runtime_options.Exists(Opt::Zygote);
   is_explicit_gc_disabled_ = runtime_options.Exists(Opt::DisableExplicitGC);
   dex2oat_enabled_ = runtime_options.GetOrDefault(Opt::Dex2Oat);
   image_dex2oat_enabled_ = runtime_options.GetOrDefault(Opt::ImageDex2Oat);
   dump_native_stack_on_sig_quit_ = runtime_options.GetOrDefault(Opt::DumpNativeStackOnSigQuit);
+  fork_heap_dump_ = runtime_options.GetOrDefault(Opt::ForkHeapDump);
 
   vfprintf_ = runtime_options.GetOrDefault(Opt::HookVfprintf);
   exit_ = runtime_options.GetOrDefault(Opt::HookExit);
@@ -1138,6 +1317,7 @@ bool Runtime::Init(RuntimeArgumentMap&& runtime_options_in) {
   }
 
   zygote_max_failed_boots_ = runtime_options.GetOrDefault(Opt::ZygoteMaxFailedBoots);
+  zygote_dirty_classes_file_ = runtime_options.ReleaseOrDefault(Opt::ZygoteDirtyClasses);
   experimental_flags_ = runtime_options.GetOrDefault(Opt::Experimental);
   is_low_memory_mode_ = runtime_options.Exists(Opt::LowMemoryMode);
   madvise_random_access_ = runtime_options.GetOrDefault(Opt::MadviseRandomAccess);
@@ -1182,6 +1362,7 @@ bool Runtime::Init(RuntimeArgumentMap&& runtime_options_in) {
                        runtime_options.GetOrDefault(Opt::LongGCLogThreshold),
                        runtime_options.Exists(Opt::IgnoreMaxFootprint),
                        runtime_options.GetOrDefault(Opt::UseTLAB),
+                       runtime_options.GetOrDefault(Opt::UseRosAllocPerCpuRuns),
                        xgc_option.verify_pre_gc_heap_,
                        xgc_option.verify_pre_sweeping_heap_,
                        xgc_option.verify_post_gc_heap_,
@@ -1191,7 +1372,12 @@ bool Runtime::Init(RuntimeArgumentMap&& runtime_options_in) {
                        xgc_option.gcstress_,
                        xgc_option.measure_,
                        runtime_options.GetOrDefault(Opt::EnableHSpaceCompactForOOM),
-                       runtime_options.GetOrDefault(Opt::HSpaceCompactForOOMMinIntervalsMs));
+                       runtime_options.GetOrDefault(Opt::HSpaceCompactForOOMMinIntervalsMs),
+                       xgc_option.generational_cc_,
+                       runtime_options.GetOrDefault(Opt::SampledHeapVerificationRegions),
+                       runtime_options.Exists(Opt::UseHugePages),
+                       runtime_options.GetOrDefault(Opt::EnableGcPacer),
+                       runtime_options.GetOrDefault(Opt::ClassHistogramSamplingRate));
 
   if (!heap_->HasBootImageSpace() && !allow_dex_file_fallback_) {
     LOG(ERROR) << "Dex file fallback disabled, cannot continue without image.";
@@ -1199,6 +1385,12 @@ bool Runtime::Init(RuntimeArgumentMap&& runtime_options_in) {
   }
 
   dump_gc_performance_on_shutdown_ = runtime_options.Exists(Opt::DumpGCPerformanceOnShutdown);
+  dump_timings_json_on_shutdown_ =
+      runtime_options.GetOrDefault(Opt::DumpTimingsJsonOnShutdown);
+  use_switch_interpreter_ = runtime_options.Exists(Opt::UseSwitchInterpreter);
+  verify_threads_ = runtime_options.GetOrDefault(Opt::VerifyThreads);
+  image_fixup_threads_ = runtime_options.GetOrDefault(Opt::ImageFixupThreads);
+  reference_queue_threads_ = runtime_options.GetOrDefault(Opt::ReferenceQueueThreads);
 
   if (runtime_options.Exists(Opt::JdwpOptions)) {
     Dbg::ConfigureJdwp(runtime_options.GetOrDefault(Opt::JdwpOptions));
@@ -1217,9 +1409,14 @@ bool Runtime::Init(RuntimeArgumentMap&& runtime_options_in) {
   }
 
   // Use MemMap arena pool for jit, malloc otherwise. Malloc arenas are faster to allocate but
-  // can't be trimmed as easily.
+  // can't be trimmed as easily. The compiler threads of dex2oat also get thread caches of
+  // arenas so that they do not all contend on the pool lock.
   const bool use_malloc = IsAotCompiler();
-  arena_pool_.reset(new ArenaPool(use_malloc, /* low_4gb */ false));
+  arena_pool_.reset(new ArenaPool(use_malloc,
+                                  /* low_4gb */ false,
+                                  "LinearAlloc",
+                                  /* use_thread_caches */ IsAotCompiler(),
+                                  runtime_options.GetOrDefault(Opt::NumaLocalArenas)));
   jit_arena_pool_.reset(
       new ArenaPool(/* use_malloc */ false, /* low_4gb */ false, "CompilerMetadata"));
 
@@ -1228,6 +1425,7 @@ bool Runtime::Init(RuntimeArgumentMap&& runtime_options_in) {
     low_4gb_arena_pool_.reset(new ArenaPool(/* use_malloc */ false, /* low_4gb */ true));
   }
   linear_alloc_.reset(CreateLinearAlloc());
+  irt_chunk_pool_.reset(new IrtChunkPool());
 
   BlockSignals();
   InitPlatformSignalHandlers();
@@ -1244,6 +1442,11 @@ bool Runtime::Init(RuntimeArgumentMap&& runtime_options_in) {
       implicit_null_checks_ = true;
       // Installing stack protection does not play well with valgrind.
       implicit_so_checks_ = !(RUNNING_ON_MEMORY_TOOL && kMemoryToolIsValgrind);
+      // The JIT compiler emits implicit suspend checks only for these. AOT compiled code keeps
+      // explicit checks, it may run on a runtime without the suspension handler.
+      implicit_suspend_checks_ = (kRuntimeISA == kArm64 || kRuntimeISA == kX86_64) &&
+          !no_sig_chain_ &&
+          runtime_options.Exists(Opt::JITImplicitSuspendChecks);
       break;
     default:
       // Keep the defaults.
@@ -1337,6 +1540,9 @@ bool Runtime::Init(RuntimeArgumentMap&& runtime_options_in) {
       ScopedTrace trace2("AddImageStringsToTable");
       GetInternTable()->AddImagesStringsToTable(heap_->GetBootImageSpaces());
     }
+    if (!IsAotCompiler()) {
+      InitBootImageHotnessCounters();
+    }
     if (IsJavaDebuggable()) {
       // Now that we have loaded the boot image, deoptimize its methods if we are running
       // debuggable, as the code may have been compiled non-debuggable.
@@ -1534,6 +1740,7 @@ void Runtime::AttachAgent(const std::string& agent_arg) {
 
 void Runtime::InitNativeMethods() {
   VLOG(startup) << "Runtime::InitNativeMethods entering";
+  ScopedStartupPhase startup_phase(__FUNCTION__);
   Thread* self = Thread::Current();
   JNIEnv* env = self->GetJniEnv();
 
@@ -1657,6 +1864,35 @@ void Runtime::DumpDeoptimizations(std::ostream& os) {
          << "\n";
     }
   }
+  if (deoptimized_frames_ != 0u) {
+    os << "Deoptimized frames: " << deoptimized_frames_
+       << " in " << PrettyDuration(deoptimization_time_ns_) << "\n";
+  }
+}
+
+void Runtime::DumpTimingsJson() {
+  TimingJsonWriter writer;
+  heap_->AddGcTimings(&writer);
+  if (jit_ != nullptr) {
+    jit_->AddTimings(&writer);
+  }
+  std::ostringstream oss;
+  writer.Write(oss);
+  const char* filename = dump_timings_json_on_shutdown_.c_str();
+  std::unique_ptr<File> file(OS::CreateEmptyFileWriteOnly(filename));
+  if (file == nullptr) {
+    PLOG(ERROR) << "Failed to create timings file " << filename;
+    return;
+  }
+  std::string json = oss.str();
+  if (!file->WriteFully(json.data(), json.size())) {
+    PLOG(ERROR) << "Failed to write timings file " << filename;
+    file->Erase();
+    return;
+  }
+  if (file->FlushCloseOrErase() != 0) {
+    PLOG(ERROR) << "Failed to flush and close timings file " << filename;
+  }
 }
 
 void Runtime::DumpForSigQuit(std::ostream& os) {
@@ -1664,6 +1900,10 @@ void Runtime::DumpForSigQuit(std::ostream& os) {
   GetInternTable()->DumpForSigQuit(os);
   GetJavaVM()->DumpForSigQuit(os);
   GetHeap()->DumpForSigQuit(os);
+  GetMonitorList()->DumpForSigQuit(os);
+  if (lock_contention_profiler_ != nullptr) {
+    lock_contention_profiler_->Dump(os);
+  }
   oat_file_manager_->DumpForSigQuit(os);
   if (GetJit() != nullptr) {
     GetJit()->DumpForSigQuit(os);
@@ -1671,11 +1911,13 @@ void Runtime::DumpForSigQuit(std::ostream& os) {
     os << "Running non JIT\n";
   }
   DumpDeoptimizations(os);
+  DumpSystemWeakSweeps(os);
   TrackedAllocators::Dump(os);
   os << "\n";
 
   thread_list_->DumpForSigQuit(os);
   BaseMutex::DumpAll(os);
+  BaseMutex::DumpContentionStats(os);
 
   // Inform anyone else who is interested in SigQuit.
   {
@@ -2189,6 +2431,12 @@ void Runtime::RecordWriteArray(mirror::Array* array, size_t index, uint64_t valu
   preinitialization_transaction_->RecordWriteArray(array, index, value);
 }
 
+void Runtime::RecordNewObject(ObjPtr<mirror::Object> obj) const {
+  DCHECK(IsAotCompiler());
+  DCHECK(IsActiveTransaction());
+  preinitialization_transaction_->RecordNewObject(obj.Ptr());
+}
+
 void Runtime::RecordStrongStringInsertion(ObjPtr<mirror::String> s) const {
   DCHECK(IsAotCompiler());
   DCHECK(IsActiveTransaction());
@@ -2246,14 +2494,30 @@ void Runtime::AddCurrentRuntimeFeaturesAsDex2OatArguments(std::vector<std::strin
 
 void Runtime::CreateJit() {
   CHECK(!IsAotCompiler());
+  ScopedStartupPhase startup_phase(__FUNCTION__);
   if (kIsDebugBuild && GetInstrumentation()->IsForcedInterpretOnly()) {
     DCHECK(!jit_options_->UseJitCompilation());
   }
   std::string error_msg;
-  jit_.reset(jit::Jit::Create(jit_options_.get(), &error_msg));
-  if (jit_.get() == nullptr) {
-    LOG(WARNING) << "Failed to create JIT " << error_msg;
-    return;
+  if (zygote_jit_ != nullptr &&
+      jit_options_->UseJitCompilation() &&
+      !IsJavaDebuggable() &&
+      !IsNativeDebuggable()) {
+    // Take over the JIT of the zygote, with the code it compiled before forking. Debuggable
+    // processes need code compiled for debugging, they create their own JIT.
+    if (!zygote_jit_->PostZygoteFork(jit_options_.get(), &error_msg)) {
+      LOG(WARNING) << "Failed to create JIT " << error_msg;
+      return;
+    }
+    jit_ = std::move(zygote_jit_);
+    ScopedObjectAccess soa(Thread::Current());
+    jit_->GetCodeCache()->InstallZygoteCode(soa.Self());
+  } else {
+    jit_.reset(jit::Jit::Create(jit_options_.get(), /* for_zygote */ false, &error_msg));
+    if (jit_.get() == nullptr) {
+      LOG(WARNING) << "Failed to create JIT " << error_msg;
+      return;
+    }
   }
 
   // In case we have a profile path passed as a command line argument,
@@ -2345,6 +2609,9 @@ void Runtime::UpdateProcessState(ProcessState process_state) {
   ProcessState old_process_state = process_state_;
   process_state_ = process_state;
   GetHeap()->UpdateProcessState(old_process_state, process_state);
+  if (jit_ != nullptr) {
+    jit_->UpdateProcessState(process_state == kProcessStateJankPerceptible);
+  }
 }
 
 void Runtime::RegisterSensitiveThread() const {
@@ -2425,6 +2692,44 @@ void Runtime::SetJavaDebuggable(bool value) {
   // Do not call DeoptimizeBootImage just yet, the runtime may still be starting up.
 }
 
+void Runtime::InitBootImageHotnessCounters() {
+  // One range for all the boot image spaces, the counters for the gaps between their method
+  // sections are never touched and take no memory.
+  uintptr_t methods_begin = std::numeric_limits<uintptr_t>::max();
+  uintptr_t methods_end = 0u;
+  for (gc::space::ImageSpace* space : heap_->GetBootImageSpaces()) {
+    const ImageSection& methods = space->GetImageHeader().GetMethodsSection();
+    if (methods.Size() != 0u) {
+      const uintptr_t begin = reinterpret_cast<uintptr_t>(space->Begin()) + methods.Offset();
+      methods_begin = std::min(methods_begin, begin);
+      methods_end = std::max(methods_end, begin + methods.Size());
+    }
+  }
+  if (methods_begin >= methods_end) {
+    return;
+  }
+  const size_t num_counters =
+      (methods_end - methods_begin) / ArtMethod::Size(kRuntimePointerSize) + 1u;
+  std::string error_msg;
+  boot_image_hotness_counters_.reset(
+      MemMap::MapAnonymous("boot image hotness counters",
+                           /* addr */ nullptr,
+                           RoundUp(num_counters * sizeof(uint16_t), kPageSize),
+                           PROT_READ | PROT_WRITE,
+                           /* low_4gb */ false,
+                           /* reuse */ false,
+                           &error_msg));
+  if (boot_image_hotness_counters_ == nullptr) {
+    // Keep the counters in the methods.
+    LOG(WARNING) << "Failed to map the boot image hotness counters: " << error_msg;
+    return;
+  }
+  ArtMethod::SetBootImageHotnessCounters(
+      methods_begin,
+      methods_end - methods_begin,
+      reinterpret_cast<uint16_t*>(boot_image_hotness_counters_->Begin()));
+}
+
 void Runtime::DeoptimizeBootImage() {
   // If we've already started and we are setting this runtime to debuggable,
   // we patch entry points of methods in boot image to interpreter bridge, as
@@ -76,9 +76,11 @@ class ClassLinker;
 class CompilerCallbacks;
 class DexFile;
 class InternTable;
+class IrtChunkPool;
 class IsMarkedVisitor;
 class JavaVMExt;
 class LinearAlloc;
+class LockContentionProfiler;
 class MemMap;
 class MonitorList;
 class MonitorPool;
@@ -89,6 +91,7 @@ struct RuntimeArgumentMap;
 class RuntimeCallbacks;
 class SignalCatcher;
 class StackOverflowHandler;
+class StartupPhases;
 class SuspensionHandler;
 class ThreadList;
 class Trace;
@@ -135,6 +138,16 @@ class Runtime {
     return must_relocate_;
   }
 
+  // Whether a PIC boot image is relocated in memory instead of being patched into the dalvik
+  // cache by patchoat.
+  bool ShouldRelocateInPlace() const {
+    return relocate_in_place_;
+  }
+
+  size_t GetImageFixupThreads() const {
+    return image_fixup_threads_;
+  }
+
   bool IsDex2OatEnabled() const {
     return dex2oat_enabled_ && IsImageDex2OatEnabled();
   }
@@ -274,6 +287,11 @@ class Runtime {
     return monitor_list_;
   }
 
+  // Null unless lock profiling is enabled with -Xlockprofthreshold.
+  LockContentionProfiler* GetLockContentionProfiler() const {
+    return lock_contention_profiler_.get();
+  }
+
   MonitorPool* GetMonitorPool() const {
     return monitor_pool_;
   }
@@ -337,9 +355,31 @@ class Runtime {
 
   // Sweep system weaks, the system weak is deleted if the visitor return null. Otherwise, the
   // system weak is updated to be the visitor's returned value.
+  // The system weaks are independent of each other, they are swept in parallel on the heap
+  // thread pool if there is one.
   void SweepSystemWeaks(IsMarkedVisitor* visitor)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // The system weaks swept by SweepSystemWeaks, with their sweep times recorded separately. The
+  // generic system weak holders are each swept on their own but recorded together.
+  enum SystemWeakKind {
+    kSystemWeakInternTable,
+    kSystemWeakMonitorList,
+    kSystemWeakJniWeakGlobals,
+    kSystemWeakAllocationRecords,
+    kSystemWeakJitRootTables,
+    kSystemWeakHolders,
+    kSystemWeakLast = kSystemWeakHolders
+  };
+
+  // Sweep the system weaks of `kind`, or `holder` for kSystemWeakHolders.
+  void SweepSystemWeak(SystemWeakKind kind,
+                       gc::AbstractSystemWeakHolder* holder,
+                       IsMarkedVisitor* visitor)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
+  void DumpSystemWeakSweeps(std::ostream& os);
+
   // Returns a special method that calls into a trampoline for runtime method resolution
   ArtMethod* GetResolutionMethod();
 
@@ -484,14 +524,12 @@ class Runtime {
       REQUIRES_SHARED(Locks::mutator_lock_);
   void RecordWriteArray(mirror::Array* array, size_t index, uint64_t value) const
       REQUIRES_SHARED(Locks::mutator_lock_);
-  void RecordStrongStringInsertion(ObjPtr<mirror::String> s) const
-      REQUIRES(Locks::intern_table_lock_);
-  void RecordWeakStringInsertion(ObjPtr<mirror::String> s) const
-      REQUIRES(Locks::intern_table_lock_);
-  void RecordStrongStringRemoval(ObjPtr<mirror::String> s) const
-      REQUIRES(Locks::intern_table_lock_);
-  void RecordWeakStringRemoval(ObjPtr<mirror::String> s) const
-      REQUIRES(Locks::intern_table_lock_);
+  void RecordNewObject(ObjPtr<mirror::Object> obj) const
+      REQUIRES_SHARED(Locks::mutator_lock_);
+  void RecordStrongStringInsertion(ObjPtr<mirror::String> s) const;
+  void RecordWeakStringInsertion(ObjPtr<mirror::String> s) const;
+  void RecordStrongStringRemoval(ObjPtr<mirror::String> s) const;
+  void RecordWeakStringRemoval(ObjPtr<mirror::String> s) const;
   void RecordResolveString(ObjPtr<mirror::DexCache> dex_cache, dex::StringIndex string_idx) const
       REQUIRES_SHARED(Locks::mutator_lock_);
 
@@ -508,6 +546,10 @@ class Runtime {
     return !implicit_so_checks_;
   }
 
+  bool ImplicitSuspendChecks() const {
+    return implicit_suspend_checks_;
+  }
+
   bool IsVerificationEnabled() const;
   bool IsVerificationSoftFail() const;
 
@@ -535,6 +577,10 @@ class Runtime {
     return zygote_max_failed_boots_;
   }
 
+  const std::string& GetZygoteDirtyClassesFile() const {
+    return zygote_dirty_classes_file_;
+  }
+
   bool AreExperimentalFlagsEnabled(ExperimentalFlags flags) {
     return (experimental_flags_ & flags) != ExperimentalFlags::kNone;
   }
@@ -551,6 +597,9 @@ class Runtime {
   const ArenaPool* GetArenaPool() const {
     return arena_pool_.get();
   }
+  IrtChunkPool* GetIrtChunkPool() {
+    return irt_chunk_pool_.get();
+  }
 
   void ReclaimArenaPoolMemory();
 
@@ -606,6 +655,10 @@ class Runtime {
     return dump_native_stack_on_sig_quit_;
   }
 
+  bool GetForkHeapDump() const {
+    return fork_heap_dump_;
+  }
+
   bool GetPrunedDalvikCache() const {
     return pruned_dalvik_cache_;
   }
@@ -652,6 +705,16 @@ class Runtime {
 
   RuntimeCallbacks* GetRuntimeCallbacks();
 
+  // The startup phases recorded, or null if the runtime does not record them.
+  StartupPhases* GetStartupPhases() const {
+    return startup_phases_.get();
+  }
+
+  // Whether the interpreter runs the switch implementation instead of mterp.
+  bool UseSwitchInterpreter() const {
+    return use_switch_interpreter_;
+  }
+
   void InitThreadGroups(Thread* self);
 
   void SetDumpGCPerformanceOnShutdown(bool value) {
@@ -663,6 +726,12 @@ class Runtime {
     deoptimization_counts_[static_cast<size_t>(kind)]++;
   }
 
+  // Record that a deoptimization materialized `frames` interpreter frames in `ns` nanoseconds.
+  void AddDeoptimizedFrames(size_t frames, uint64_t ns) {
+    deoptimized_frames_.fetch_add(frames, std::memory_order_relaxed);
+    deoptimization_time_ns_.fetch_add(ns, std::memory_order_relaxed);
+  }
+
   uint32_t GetNumberOfDeoptimizations() const {
     uint32_t result = 0;
     for (size_t i = 0; i <= static_cast<size_t>(DeoptimizationKind::kLast); ++i) {
@@ -692,8 +761,17 @@ class Runtime {
   void StartDaemonThreads();
   void StartSignalCatcher();
 
+  // Writes the GC and JIT timings to dump_timings_json_on_shutdown_.
+  void DumpTimingsJson();
+
+  // Moves the hotness counters of the boot image methods out of the boot image.
+  void InitBootImageHotnessCounters();
+
   void MaybeSaveJitProfilingInfo();
 
+  // Create zygote_jit_, and compile the hot methods of the zygote profile.
+  void CreateZygoteJit();
+
   // Visit all of the thread roots.
   void VisitThreadRoots(RootVisitor* visitor, VisitRootFlags flags)
       REQUIRES_SHARED(Locks::mutator_lock_);
@@ -736,6 +814,7 @@ class Runtime {
   CompilerCallbacks* compiler_callbacks_;
   bool is_zygote_;
   bool must_relocate_;
+  bool relocate_in_place_;
   bool is_concurrent_gc_enabled_;
   bool is_explicit_gc_disabled_;
   bool dex2oat_enabled_;
@@ -766,6 +845,9 @@ class Runtime {
   // since the field arrays are int arrays in this case.
   std::unique_ptr<ArenaPool> low_4gb_arena_pool_;
 
+  // Released chunk maps of the indirect reference tables, reused by the tables of new threads.
+  std::unique_ptr<IrtChunkPool> irt_chunk_pool_;
+
   // Shared linear alloc for now.
   std::unique_ptr<LinearAlloc> linear_alloc_;
 
@@ -795,6 +877,10 @@ class Runtime {
   std::unique_ptr<jit::Jit> jit_;
   std::unique_ptr<jit::JitOptions> jit_options_;
 
+  // With -Xjitzygoteprofile, the JIT that compiled methods before the zygote first forked. The
+  // children that use the JIT take it over, see CreateJit.
+  std::unique_ptr<jit::Jit> zygote_jit_;
+
   // Fault message, printed when we get a SIGSEGV.
   Mutex fault_message_lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
   std::string fault_message_ GUARDED_BY(fault_message_lock_);
@@ -842,6 +928,22 @@ class Runtime {
   // If true, then we dump the GC cumulative timings on shutdown.
   bool dump_gc_performance_on_shutdown_;
 
+  // If not empty, the GC and JIT timings are written to this file as JSON on shutdown.
+  std::string dump_timings_json_on_shutdown_;
+
+  // If true, the interpreter does not use mterp, see -XX:UseSwitchInterpreter.
+  bool use_switch_interpreter_;
+
+  // Number of threads verifying app classes in the background, or 0 to verify them lazily.
+  size_t verify_threads_;
+
+  // Number of worker threads helping to relocate app images, or 0 to relocate them serially.
+  size_t image_fixup_threads_;
+
+  // Number of threads enqueueing the cleared references other than the finalizer references, or 0
+  // to leave them all to the ReferenceQueueDaemon.
+  size_t reference_queue_threads_;
+
   // Transaction used for pre-initializing classes at compilation time.
   Transaction* preinitialization_transaction_;
 
@@ -893,6 +995,10 @@ class Runtime {
   // zygote.
   uint32_t zygote_max_failed_boots_;
 
+  // The file listing the classes whose instances are likely to be written after the zygote forks,
+  // one per line. Empty if there is none.
+  std::string zygote_dirty_classes_file_;
+
   // Enable experimental opcodes that aren't fully specified yet. The intent is to
   // eventually publish them as public-usable opcodes, but they aren't ready yet.
   //
@@ -918,6 +1024,9 @@ class Runtime {
   // Whether threads should dump their native stack on SIGQUIT.
   bool dump_native_stack_on_sig_quit_;
 
+  // Whether hprof heap dumps to a file are written by a forked child process.
+  bool fork_heap_dump_;
+
   // Whether the dalvik cache was pruned when initializing the runtime.
   bool pruned_dalvik_cache_;
 
@@ -946,11 +1055,27 @@ class Runtime {
 
   std::unique_ptr<RuntimeCallbacks> callbacks_;
 
+  // The startup phases recorded for -XX:DumpStartupPhases, null without it.
+  std::unique_ptr<StartupPhases> startup_phases_;
+
   std::atomic<uint32_t> deoptimization_counts_[
       static_cast<uint32_t>(DeoptimizationKind::kLast) + 1];
+  // Frames materialized by the deoptimizations so far, and the time it took.
+  std::atomic<uint64_t> deoptimized_frames_;
+  std::atomic<uint64_t> deoptimization_time_ns_;
+
+  // Number and total time of the sweeps of each SystemWeakKind.
+  std::atomic<uint64_t> system_weak_sweeps_[kSystemWeakLast + 1];
+  std::atomic<uint64_t> system_weak_sweep_time_ns_[kSystemWeakLast + 1];
 
   std::unique_ptr<MemMap> protected_fault_page_;
 
+  // Hotness counters of the boot image methods, see ArtMethod::SetBootImageHotnessCounters().
+  std::unique_ptr<MemMap> boot_image_hotness_counters_;
+
+  // Aggregates sampled lock contention when -Xlockprofthreshold is set.
+  std::unique_ptr<LockContentionProfiler> lock_contention_profiler_;
+
   DISALLOW_COPY_AND_ASSIGN(Runtime);
 };
 
@@ -37,6 +37,7 @@
 #include "mirror/object_array-inl.h"
 #include "oat_quick_method_header.h"
 #include "quick/quick_method_frame_info.h"
+#include "quick_frame_cache.h"
 #include "runtime.h"
 #include "thread.h"
 #include "thread_list.h"
@@ -47,6 +48,12 @@ using android::base::StringPrintf;
 
 static constexpr bool kDebugStackWalk = false;
 
+// Walks decode frames with the cache of the walking thread, so that only one thread uses a cache.
+static QuickFrameCache* GetCurrentQuickFrameCache() {
+  Thread* self = Thread::Current();
+  return (self != nullptr) ? self->GetQuickFrameCache() : nullptr;
+}
+
 StackVisitor::StackVisitor(Thread* thread,
                            Context* context,
                            StackWalkKind walk_kind,
@@ -64,6 +71,7 @@ StackVisitor::StackVisitor(Thread* thread,
       cur_quick_frame_(nullptr),
       cur_quick_frame_pc_(0),
       cur_oat_quick_method_header_(nullptr),
+      frame_cache_(GetCurrentQuickFrameCache()),
       num_frames_(num_frames),
       cur_depth_(0),
       current_inlining_depth_(0),
@@ -74,15 +82,53 @@ StackVisitor::StackVisitor(Thread* thread,
   }
 }
 
-static InlineInfo GetCurrentInlineInfo(const OatQuickMethodHeader* method_header,
-                                       uintptr_t cur_quick_frame_pc)
-    REQUIRES_SHARED(Locks::mutator_lock_) {
-  uint32_t native_pc_offset = method_header->NativeQuickPcOffset(cur_quick_frame_pc);
-  CodeInfo code_info = method_header->GetOptimizedCodeInfo();
-  CodeInfoEncoding encoding = code_info.ExtractEncoding();
+const OatQuickMethodHeader* StackVisitor::FindOatQuickMethodHeader(ArtMethod* method) const {
+  // A pc of 0 is a downcall, whose method header depends on the entry point of the method.
+  if (frame_cache_ == nullptr || cur_quick_frame_pc_ == 0u) {
+    return method->GetOatQuickMethodHeader(cur_quick_frame_pc_);
+  }
+  QuickFrameCache::Entry* entry = frame_cache_->Lookup(method, cur_quick_frame_pc_);
+  if (entry != nullptr) {
+    return entry->method_header;
+  }
+  const OatQuickMethodHeader* method_header = method->GetOatQuickMethodHeader(cur_quick_frame_pc_);
+  if (method_header != nullptr) {
+    frame_cache_->Add(method, cur_quick_frame_pc_, method_header);
+  }
+  return method_header;
+}
+
+StackMap StackVisitor::GetCurrentStackMap(const CodeInfo& code_info,
+                                          const CodeInfoEncoding& encoding) const {
+  if (cur_stack_map_.IsValid()) {
+    return cur_stack_map_;
+  }
+  QuickFrameCache::Entry* entry = nullptr;
+  if (frame_cache_ != nullptr && cur_quick_frame_pc_ != 0u) {
+    entry = frame_cache_->Lookup(*cur_quick_frame_, cur_quick_frame_pc_);
+    if (entry != nullptr && entry->method_header != cur_oat_quick_method_header_) {
+      entry = nullptr;
+    }
+  }
+  if (entry != nullptr && entry->has_stack_map) {
+    return entry->stack_map;
+  }
+  uint32_t native_pc_offset =
+      cur_oat_quick_method_header_->NativeQuickPcOffset(cur_quick_frame_pc_);
   StackMap stack_map = code_info.GetStackMapForNativePcOffset(native_pc_offset, encoding);
-  DCHECK(stack_map.IsValid());
-  return code_info.GetInlineInfoOf(stack_map, encoding);
+  if (entry != nullptr) {
+    entry->stack_map = stack_map;
+    entry->has_stack_map = true;
+  }
+  return stack_map;
+}
+
+InlineInfo StackVisitor::GetCurrentInlineInfo() const {
+  // Inlined frames are only visited after the walk found the stack map of their outer frame.
+  DCHECK(cur_stack_map_.IsValid());
+  CodeInfo code_info = GetCurrentOatQuickMethodHeader()->GetOptimizedCodeInfo();
+  CodeInfoEncoding encoding = code_info.ExtractEncoding();
+  return code_info.GetInlineInfoOf(cur_stack_map_, encoding);
 }
 
 ArtMethod* StackVisitor::GetMethod() const {
@@ -91,8 +137,7 @@ ArtMethod* StackVisitor::GetMethod() const {
   } else if (cur_quick_frame_ != nullptr) {
     if (IsInInlinedFrame()) {
       size_t depth_in_stack_map = current_inlining_depth_ - 1;
-      InlineInfo inline_info = GetCurrentInlineInfo(GetCurrentOatQuickMethodHeader(),
-                                                    cur_quick_frame_pc_);
+      InlineInfo inline_info = GetCurrentInlineInfo();
       const OatQuickMethodHeader* method_header = GetCurrentOatQuickMethodHeader();
       CodeInfoEncoding encoding = method_header->GetOptimizedCodeInfo().ExtractEncoding();
       MethodInfo method_info = method_header->GetOptimizedMethodInfo();
@@ -117,10 +162,14 @@ uint32_t StackVisitor::GetDexPc(bool abort_on_failure) const {
       size_t depth_in_stack_map = current_inlining_depth_ - 1;
       const OatQuickMethodHeader* method_header = GetCurrentOatQuickMethodHeader();
       CodeInfoEncoding encoding = method_header->GetOptimizedCodeInfo().ExtractEncoding();
-      return GetCurrentInlineInfo(GetCurrentOatQuickMethodHeader(), cur_quick_frame_pc_).
-          GetDexPcAtDepth(encoding.inline_info.encoding, depth_in_stack_map);
+      return GetCurrentInlineInfo().GetDexPcAtDepth(encoding.inline_info.encoding,
+                                                    depth_in_stack_map);
     } else if (cur_oat_quick_method_header_ == nullptr) {
       return DexFile::kDexNoIndex;
+    } else if (cur_stack_map_.IsValid()) {
+      CodeInfoEncoding encoding =
+          cur_oat_quick_method_header_->GetOptimizedCodeInfo().ExtractEncoding();
+      return cur_stack_map_.GetDexPc(encoding.stack_map.encoding);
     } else {
       return cur_oat_quick_method_header_->ToDexPc(
           GetMethod(), cur_quick_frame_pc_, abort_on_failure);
@@ -231,8 +280,7 @@ bool StackVisitor::GetVRegFromOptimizedCode(ArtMethod* m, uint16_t vreg, VRegKin
   CodeInfo code_info = method_header->GetOptimizedCodeInfo();
   CodeInfoEncoding encoding = code_info.ExtractEncoding();
 
-  uint32_t native_pc_offset = method_header->NativeQuickPcOffset(cur_quick_frame_pc_);
-  StackMap stack_map = code_info.GetStackMapForNativePcOffset(native_pc_offset, encoding);
+  StackMap stack_map = GetCurrentStackMap(code_info, encoding);
   DCHECK(stack_map.IsValid());
   size_t depth_in_stack_map = current_inlining_depth_ - 1;
 
@@ -734,12 +782,9 @@ QuickMethodFrameInfo StackVisitor::GetCurrentQuickFrameInfo() const {
     return runtime->GetCalleeSaveMethodFrameInfo(CalleeSaveType::kSaveRefsAndArgs);
   }
 
-  // The only remaining case is if the method is native and uses the generic JNI stub.
+  // The only remaining case is if the method is native and uses the generic JNI stub. Its entry
+  // point may have been changed to a compiled JNI stub since the call.
   DCHECK(method->IsNative());
-  ClassLinker* class_linker = runtime->GetClassLinker();
-  const void* entry_point = runtime->GetInstrumentation()->GetQuickCodeFor(method,
-                                                                           kRuntimePointerSize);
-  DCHECK(class_linker->IsQuickGenericJniStub(entry_point)) << method->PrettyMethod();
   // Generic JNI frame.
   uint32_t handle_refs = GetNumberOfReferenceArgsWithoutReceiver(method) + 1;
   size_t scope_size = HandleScope::SizeOf(handle_refs);
@@ -770,13 +815,24 @@ void StackVisitor::WalkStack(bool include_transitions) {
     cur_quick_frame_ = current_fragment->GetTopQuickFrame();
     cur_quick_frame_pc_ = 0;
     cur_oat_quick_method_header_ = nullptr;
+    cur_stack_map_ = StackMap();
+    // The top frame of the fragment may be a frame of the generic JNI trampoline, which has no
+    // method header even if the native method has compiled code by now.
+    bool generic_jni_frame = current_fragment->GetTopQuickFrameTag();
 
     if (cur_quick_frame_ != nullptr) {  // Handle quick stack frames.
       // Can't be both a shadow and a quick fragment.
       DCHECK(current_fragment->GetTopShadowFrame() == nullptr);
       ArtMethod* method = *cur_quick_frame_;
       while (method != nullptr) {
-        cur_oat_quick_method_header_ = method->GetOatQuickMethodHeader(cur_quick_frame_pc_);
+        if (UNLIKELY(generic_jni_frame)) {
+          DCHECK(method->IsNative());
+          cur_oat_quick_method_header_ = nullptr;
+          generic_jni_frame = false;
+        } else {
+          cur_oat_quick_method_header_ = FindOatQuickMethodHeader(method);
+        }
+        cur_stack_map_ = StackMap();
         SanityCheckFrame();
 
         if ((walk_kind_ == StackWalkKind::kIncludeInlinedFrames)
@@ -784,11 +840,10 @@ void StackVisitor::WalkStack(bool include_transitions) {
             && cur_oat_quick_method_header_->IsOptimized()) {
           CodeInfo code_info = cur_oat_quick_method_header_->GetOptimizedCodeInfo();
           CodeInfoEncoding encoding = code_info.ExtractEncoding();
-          uint32_t native_pc_offset =
-              cur_oat_quick_method_header_->NativeQuickPcOffset(cur_quick_frame_pc_);
-          StackMap stack_map = code_info.GetStackMapForNativePcOffset(native_pc_offset, encoding);
-          if (stack_map.IsValid() && stack_map.HasInlineInfo(encoding.stack_map.encoding)) {
-            InlineInfo inline_info = code_info.GetInlineInfoOf(stack_map, encoding);
+          cur_stack_map_ = GetCurrentStackMap(code_info, encoding);
+          if (cur_stack_map_.IsValid() &&
+              cur_stack_map_.HasInlineInfo(encoding.stack_map.encoding)) {
+            InlineInfo inline_info = code_info.GetInlineInfoOf(cur_stack_map_, encoding);
             DCHECK_EQ(current_inlining_depth_, 0u);
             for (current_inlining_depth_ = inline_info.GetDepth(encoding.inline_info.encoding);
                  current_inlining_depth_ != 0;
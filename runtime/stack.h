@@ -23,6 +23,7 @@
 #include "base/macros.h"
 #include "base/mutex.h"
 #include "quick/quick_method_frame_info.h"
+#include "stack_map.h"
 
 namespace art {
 
@@ -34,6 +35,7 @@ class ArtMethod;
 class Context;
 class HandleScope;
 class OatQuickMethodHeader;
+class QuickFrameCache;
 class ShadowFrame;
 class Thread;
 union JValue;
@@ -258,6 +260,11 @@ class StackVisitor {
 
   QuickMethodFrameInfo GetCurrentQuickFrameInfo() const REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Return the stack map of the pc of the current quick frame, which has optimized code
+  // described by `code_info`. Possibly invalid.
+  StackMap GetCurrentStackMap(const CodeInfo& code_info, const CodeInfoEncoding& encoding) const
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
  private:
   // Private constructor known in the case that num_frames_ has already been computed.
   StackVisitor(Thread* thread,
@@ -300,12 +307,23 @@ class StackVisitor {
 
   void SanityCheckFrame() const REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Return the method header of `method` for the pc of the current quick frame.
+  const OatQuickMethodHeader* FindOatQuickMethodHeader(ArtMethod* method) const
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
+  InlineInfo GetCurrentInlineInfo() const REQUIRES_SHARED(Locks::mutator_lock_);
+
   Thread* const thread_;
   const StackWalkKind walk_kind_;
   ShadowFrame* cur_shadow_frame_;
   ArtMethod** cur_quick_frame_;
   uintptr_t cur_quick_frame_pc_;
   const OatQuickMethodHeader* cur_oat_quick_method_header_;
+  // The stack map of the current quick frame, if the walk looked it up to visit inlined frames.
+  // Reading the method and dex pc of the frame from it avoids searching the stack maps again.
+  StackMap cur_stack_map_;
+  // The frame cache of the walking thread, null if it is not attached.
+  QuickFrameCache* const frame_cache_;
   // Lazily computed, number of frames in the stack.
   size_t num_frames_;
   // Depth of the frame we're currently at.
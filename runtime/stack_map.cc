@@ -80,6 +80,36 @@ DexRegisterLocation DexRegisterMap::GetDexRegisterLocation(uint16_t dex_register
   return dex_register_location_catalog.GetDexRegisterLocation(location_catalog_entry_index);
 }
 
+void DexRegisterMap::GetDexRegisterLocations(
+    uint16_t number_of_dex_registers,
+    const std::vector<DexRegisterLocation>& catalog_locations,
+    std::vector<DexRegisterLocation>* locations) const {
+  locations->assign(number_of_dex_registers, DexRegisterLocation::None());
+  size_t number_of_location_catalog_entries = catalog_locations.size();
+  size_t map_locations_offset_in_bits =
+      GetLocationMappingDataOffset(number_of_dex_registers) * kBitsPerByte;
+  size_t map_entry_size_in_bits = SingleEntrySizeInBits(number_of_location_catalog_entries);
+  // Live registers are mapped in order, so keep the index in the map rather than counting the
+  // live registers below each of them.
+  size_t index_in_dex_register_map = 0;
+  for (uint16_t dex_register_number = 0;
+       dex_register_number < number_of_dex_registers;
+       ++dex_register_number) {
+    if (!IsDexRegisterLive(dex_register_number)) {
+      continue;
+    }
+    // There is no map for a single-entry location catalog, the only valid entry index is 0.
+    size_t location_catalog_entry_index = (number_of_location_catalog_entries == 1)
+        ? 0u
+        : region_.LoadBits(
+              map_locations_offset_in_bits + index_in_dex_register_map * map_entry_size_in_bits,
+              map_entry_size_in_bits);
+    DCHECK_LT(location_catalog_entry_index, number_of_location_catalog_entries);
+    (*locations)[dex_register_number] = catalog_locations[location_catalog_entry_index];
+    ++index_in_dex_register_map;
+  }
+}
+
 static void DumpRegisterMapping(std::ostream& os,
                                 size_t dex_register_num,
                                 DexRegisterLocation location,
@@ -18,6 +18,7 @@
 #define ART_RUNTIME_STACK_MAP_H_
 
 #include <limits>
+#include <vector>
 
 #include "arch/code_offset.h"
 #include "base/bit_vector.h"
@@ -273,29 +274,25 @@ class DexRegisterLocationCatalog {
     if (location_catalog_entry_index == kNoLocationEntryIndex) {
       return DexRegisterLocation::None();
     }
-    size_t offset = FindLocationOffset(location_catalog_entry_index);
-    // Read the first byte and inspect its first 3 bits to get the location.
-    ShortLocation first_byte = region_.LoadUnaligned<ShortLocation>(offset);
-    DexRegisterLocation::Kind kind = ExtractKindFromShortLocation(first_byte);
-    if (DexRegisterLocation::IsShortLocationKind(kind)) {
-      // Short location.  Extract the value from the remaining 5 bits.
-      int32_t value = ExtractValueFromShortLocation(first_byte);
-      if (kind == DexRegisterLocation::Kind::kInStack) {
-        // Convert the stack slot (short) offset to a byte offset value.
-        value *= kFrameSlotSize;
-      }
-      return DexRegisterLocation(kind, value);
-    } else {
-      // Large location.  Read the four next bytes to get the value.
-      int32_t value = region_.LoadUnaligned<int32_t>(offset + sizeof(DexRegisterLocation::Kind));
-      if (kind == DexRegisterLocation::Kind::kInStackLargeOffset) {
-        // Convert the stack slot (large) offset to a byte offset value.
-        value *= kFrameSlotSize;
-      }
-      return DexRegisterLocation(kind, value);
+    return GetDexRegisterLocationAtOffset(FindLocationOffset(location_catalog_entry_index));
+  }
+
+  // Decode the first `number_of_entries` entries of the catalog in one pass, rather than
+  // finding the offset of each entry from the beginning of the catalog.
+  void GetDexRegisterLocations(size_t number_of_entries,
+                               std::vector<DexRegisterLocation>* locations) const {
+    locations->clear();
+    locations->reserve(number_of_entries);
+    size_t offset = kFixedSize;
+    for (size_t i = 0; i != number_of_entries; ++i) {
+      locations->push_back(GetDexRegisterLocationAtOffset(offset));
+      offset += DexRegisterLocation::IsShortLocationKind(ExtractKindAtOffset(offset))
+          ? SingleShortEntrySize()
+          : SingleLargeEntrySize();
     }
   }
 
+
   // Compute the compressed kind of `location`.
   static DexRegisterLocation::Kind ComputeCompressedKind(const DexRegisterLocation& location) {
     DexRegisterLocation::Kind kind = location.GetInternalKind();
@@ -379,6 +376,28 @@ class DexRegisterLocationCatalog {
   static constexpr size_t kNoLocationEntryIndex = -1;
 
  private:
+  DexRegisterLocation GetDexRegisterLocationAtOffset(size_t offset) const {
+    // Read the first byte and inspect its first 3 bits to get the location.
+    ShortLocation first_byte = region_.LoadUnaligned<ShortLocation>(offset);
+    DexRegisterLocation::Kind kind = ExtractKindFromShortLocation(first_byte);
+    if (DexRegisterLocation::IsShortLocationKind(kind)) {
+      // Short location.  Extract the value from the remaining 5 bits.
+      int32_t value = ExtractValueFromShortLocation(first_byte);
+      if (kind == DexRegisterLocation::Kind::kInStack) {
+        // Convert the stack slot (short) offset to a byte offset value.
+        value *= kFrameSlotSize;
+      }
+      return DexRegisterLocation(kind, value);
+    } else {
+      // Large location.  Read the four next bytes to get the value.
+      int32_t value = region_.LoadUnaligned<int32_t>(offset + sizeof(DexRegisterLocation::Kind));
+      if (kind == DexRegisterLocation::Kind::kInStackLargeOffset) {
+        // Convert the stack slot (large) offset to a byte offset value.
+        value *= kFrameSlotSize;
+      }
+      return DexRegisterLocation(kind, value);
+    }
+  }
   static constexpr int kFixedSize = 0;
 
   // Width of the kind "field" in a short location, in bits.
@@ -475,6 +494,13 @@ class DexRegisterMap {
                                              const CodeInfo& code_info,
                                              const CodeInfoEncoding& enc) const;
 
+  // Get the locations of all the `number_of_dex_registers` Dex registers in one pass over the
+  // map, given the entries of the location catalog decoded with
+  // DexRegisterLocationCatalog::GetDexRegisterLocations.
+  void GetDexRegisterLocations(uint16_t number_of_dex_registers,
+                               const std::vector<DexRegisterLocation>& catalog_locations,
+                               std::vector<DexRegisterLocation>* locations) const;
+
   int32_t GetStackOffsetInBytes(uint16_t dex_register_number,
                                 uint16_t number_of_dex_registers,
                                 const CodeInfo& code_info,
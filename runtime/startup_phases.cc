@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "startup_phases.h"
+
+#include <sys/resource.h>
+#include <sys/time.h>
+
+#include <ostream>
+
+#include "base/time_utils.h"
+#include "runtime.h"
+#include "thread-current-inl.h"
+
+namespace art {
+
+static uint64_t TimevalToNs(const timeval& time) {
+  return static_cast<uint64_t>(time.tv_sec) * UINT64_C(1000000000) +
+      static_cast<uint64_t>(time.tv_usec) * UINT64_C(1000);
+}
+
+StartupPhases::Usage StartupPhases::Usage::Current() {
+  Usage usage = {};
+  usage.wall_time_ns = NanoTime();
+  rusage process_usage;
+  if (getrusage(RUSAGE_SELF, &process_usage) == 0) {
+    usage.cpu_time_ns = TimevalToNs(process_usage.ru_utime) + TimevalToNs(process_usage.ru_stime);
+    usage.minor_faults = process_usage.ru_minflt;
+    usage.major_faults = process_usage.ru_majflt;
+    usage.input_blocks = process_usage.ru_inblock;
+    usage.output_blocks = process_usage.ru_oublock;
+  }
+  return usage;
+}
+
+StartupPhases::StartupPhases()
+    : start_ns_(NanoTime()), lock_("startup phases lock") {}
+
+bool StartupPhases::BeginOnce(const char* name) {
+  MutexLock mu(Thread::Current(), lock_);
+  return once_phases_.insert(name).second;
+}
+
+void StartupPhases::Add(const char* name, const Usage& start, const Usage& end) {
+  Phase phase;
+  phase.name = name;
+  phase.start_ns = start.wall_time_ns - start_ns_;
+  phase.usage.wall_time_ns = end.wall_time_ns - start.wall_time_ns;
+  phase.usage.cpu_time_ns = end.cpu_time_ns - start.cpu_time_ns;
+  phase.usage.minor_faults = end.minor_faults - start.minor_faults;
+  phase.usage.major_faults = end.major_faults - start.major_faults;
+  phase.usage.input_blocks = end.input_blocks - start.input_blocks;
+  phase.usage.output_blocks = end.output_blocks - start.output_blocks;
+  MutexLock mu(Thread::Current(), lock_);
+  phases_.push_back(phase);
+}
+
+static void DumpUsage(std::ostream& os, const StartupPhases::Usage& usage) {
+  os << " wall-time-ns=" << usage.wall_time_ns
+     << " cpu-time-ns=" << usage.cpu_time_ns
+     << " minor-faults=" << usage.minor_faults
+     << " major-faults=" << usage.major_faults
+     << " input-blocks=" << usage.input_blocks
+     << " output-blocks=" << usage.output_blocks;
+}
+
+void StartupPhases::Dump(std::ostream& os) {
+  MutexLock mu(Thread::Current(), lock_);
+  for (const Phase& phase : phases_) {
+    os << "startup-phase name=" << phase.name << " start-ns=" << phase.start_ns;
+    DumpUsage(os, phase.usage);
+    os << "\n";
+  }
+  // The totals of the process, with the wall time since the creation of the runtime.
+  Usage process = Usage::Current();
+  process.wall_time_ns -= start_ns_;
+  os << "startup-process";
+  DumpUsage(os, process);
+  os << "\n";
+}
+
+ScopedStartupPhase::ScopedStartupPhase(const char* name, bool once)
+    : phases_(nullptr), name_(name), start_() {
+  Runtime* runtime = Runtime::Current();
+  StartupPhases* phases = (runtime != nullptr) ? runtime->GetStartupPhases() : nullptr;
+  if (phases != nullptr && (!once || phases->BeginOnce(name))) {
+    phases_ = phases;
+    start_ = StartupPhases::Usage::Current();
+  }
+}
+
+ScopedStartupPhase::~ScopedStartupPhase() {
+  if (phases_ != nullptr) {
+    phases_->Add(name_, start_, StartupPhases::Usage::Current());
+  }
+}
+
+}  // namespace art
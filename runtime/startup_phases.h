@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ART_RUNTIME_STARTUP_PHASES_H_
+#define ART_RUNTIME_STARTUP_PHASES_H_
+
+#include <stdint.h>
+
+#include <iosfwd>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/mutex.h"
+
+namespace art {
+
+// Breakdown of the startup of the runtime in phases, for -XX:DumpStartupPhases. Every phase
+// records the wall time, and the CPU time, page faults and block I/O of the process while it
+// ran. Since the counters are those of the process, they include the work of the other threads
+// running at the same time.
+class StartupPhases {
+ public:
+  struct Usage {
+    uint64_t wall_time_ns;
+    uint64_t cpu_time_ns;
+    uint64_t minor_faults;
+    uint64_t major_faults;
+    uint64_t input_blocks;
+    uint64_t output_blocks;
+
+    // The usage of the process so far, and the wall time now.
+    static Usage Current();
+  };
+
+  StartupPhases();
+
+  // Returns whether a phase recorded once, see ScopedStartupPhase, should be recorded now.
+  bool BeginOnce(const char* name) REQUIRES(!lock_);
+
+  void Add(const char* name, const Usage& start, const Usage& end) REQUIRES(!lock_);
+
+  // Dump one line of "key=value" fields for every phase, in the order the phases ended, and
+  // one for the process so far.
+  void Dump(std::ostream& os) REQUIRES(!lock_);
+
+ private:
+  struct Phase {
+    std::string name;
+    // Relative to the creation of this object.
+    uint64_t start_ns;
+    // The difference of the usages at the start and at the end of the phase.
+    Usage usage;
+  };
+
+  const uint64_t start_ns_;
+  Mutex lock_ DEFAULT_MUTEX_ACQUIRED_AFTER;
+  std::vector<Phase> phases_ GUARDED_BY(lock_);
+  std::set<std::string> once_phases_ GUARDED_BY(lock_);
+
+  DISALLOW_COPY_AND_ASSIGN(StartupPhases);
+};
+
+// Records the phase `name` from construction to destruction if the runtime records its startup
+// phases. With `once`, only its first run is recorded, e.g. for the first JIT compilation.
+class ScopedStartupPhase {
+ public:
+  explicit ScopedStartupPhase(const char* name, bool once = false);
+  ~ScopedStartupPhase();
+
+ private:
+  StartupPhases* phases_;
+  const char* const name_;
+  StartupPhases::Usage start_;
+
+  DISALLOW_COPY_AND_ASSIGN(ScopedStartupPhase);
+};
+
+}  // namespace art
+
+#endif  // ART_RUNTIME_STARTUP_PHASES_H_
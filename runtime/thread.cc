@@ -42,6 +42,7 @@
 #include "base/memory_tool.h"
 #include "base/mutex.h"
 #include "base/systrace.h"
+#include "base/time_utils.h"
 #include "base/timing_logger.h"
 #include "base/to_str.h"
 #include "class_linker-inl.h"
@@ -52,6 +53,7 @@
 #include "entrypoints/quick/quick_alloc_entrypoints.h"
 #include "gc/accounting/card_table-inl.h"
 #include "gc/accounting/heap_bitmap-inl.h"
+#include "gc/allocation_record.h"
 #include "gc/allocator/rosalloc.h"
 #include "gc/heap.h"
 #include "gc/space/space-inl.h"
@@ -68,6 +70,7 @@
 #include "mirror/object_array-inl.h"
 #include "mirror/stack_trace_element.h"
 #include "monitor.h"
+#include "monitor_pool.h"
 #include "native_stack_dump.h"
 #include "nativehelper/ScopedLocalRef.h"
 #include "nativehelper/ScopedUtfChars.h"
@@ -86,6 +89,7 @@
 #include "stack_map.h"
 #include "thread-inl.h"
 #include "thread_list.h"
+#include "trace.h"
 #include "utils.h"
 #include "verifier/method_verifier.h"
 #include "verify_object.h"
@@ -1291,6 +1295,11 @@ bool Thread::PassActiveSuspendBarriers(Thread* self) {
       tlsPtr_.active_suspend_barriers[i] = nullptr;
     }
     AtomicClearFlag(kActiveSuspendBarrier);
+    if (suspend_barrier_request_ns_ != 0u) {
+      last_time_to_safepoint_ns_ = NanoTime() - suspend_barrier_request_ns_;
+      max_time_to_safepoint_ns_ = std::max(max_time_to_safepoint_ns_, last_time_to_safepoint_ns_);
+      suspend_barrier_request_ns_ = 0u;
+    }
   }
 
   uint32_t barrier_count = 0;
@@ -1715,6 +1724,15 @@ void Thread::DumpState(std::ostream& os, const Thread* thread, pid_t tid) {
     os << "  | stack=" << reinterpret_cast<void*>(thread->tlsPtr_.stack_begin) << "-"
         << reinterpret_cast<void*>(thread->tlsPtr_.stack_end) << " stackSize="
         << PrettySize(thread->tlsPtr_.stack_size) << "\n";
+    if (thread->tlab_refills_ != 0u) {
+      os << "  | tlab refills=" << thread->tlab_refills_
+         << " size=" << PrettySize(thread->tlab_target_size_)
+         << " wasted=" << PrettySize(thread->tlab_wasted_bytes_) << "\n";
+    }
+    if (thread->max_time_to_safepoint_ns_ != 0u) {
+      os << "  | time to safepoint last=" << PrettyDuration(thread->last_time_to_safepoint_ns_)
+         << " max=" << PrettyDuration(thread->max_time_to_safepoint_ns_) << "\n";
+    }
     // Dump the held mutexes.
     os << "  | held mutexes=";
     for (size_t i = 0; i < kLockLevelCount; ++i) {
@@ -2059,6 +2077,8 @@ Thread::Thread(bool daemon)
   }
   tlsPtr_.flip_function = nullptr;
   tlsPtr_.thread_local_mark_stack = nullptr;
+  tlsPtr_.thread_local_evac_region = nullptr;
+  tlsPtr_.thread_local_evac_bytes = 0;
   tls32_.is_transitioning_to_runnable = false;
 }
 
@@ -2178,10 +2198,13 @@ void Thread::Destroy() {
   {
     ScopedObjectAccess soa(self);
     Runtime::Current()->GetHeap()->RevokeThreadLocalBuffers(this);
+    gc::AllocRecordObjectMap::FlushThreadLocalRecords(this);
+    Trace::FlushThreadLocalBuffer(this);
     if (kUseReadBarrier) {
       Runtime::Current()->GetHeap()->ConcurrentCopyingCollector()->RevokeThreadLocalMarkStack(this);
     }
   }
+  MonitorPool::ReleaseThreadCache(this);
 }
 
 Thread::~Thread() {
@@ -2226,6 +2249,8 @@ Thread::~Thread() {
   delete tlsPtr_.instrumentation_stack;
   delete tlsPtr_.name;
   delete tlsPtr_.deps_or_stack_trace_sample.stack_trace_sample;
+  delete alloc_record_buffer_;
+  delete method_trace_buffer_;
 
   Runtime::Current()->GetHeap()->AssertThreadLocalBuffersAreRevoked(this);
 
@@ -3268,10 +3293,9 @@ class ReferenceMapVisitor : public StackVisitor {
       DCHECK(method_header->IsOptimized());
       auto* vreg_base = reinterpret_cast<StackReference<mirror::Object>*>(
           reinterpret_cast<uintptr_t>(cur_quick_frame));
-      uintptr_t native_pc_offset = method_header->NativeQuickPcOffset(GetCurrentQuickFramePc());
       CodeInfo code_info = method_header->GetOptimizedCodeInfo();
       CodeInfoEncoding encoding = code_info.ExtractEncoding();
-      StackMap map = code_info.GetStackMapForNativePcOffset(native_pc_offset, encoding);
+      StackMap map = GetCurrentStackMap(code_info, encoding);
       DCHECK(map.IsValid());
 
       T vreg_info(m, code_info, encoding, map, visitor_);
@@ -3440,6 +3464,8 @@ class RootCallbackVisitor {
 template <bool kPrecise>
 void Thread::VisitRoots(RootVisitor* visitor) {
   const uint32_t thread_id = GetThreadId();
+  // The classes and methods of the cached catch handlers may be moved or freed after this.
+  catch_handler_cache_.Clear();
   visitor->VisitRootIfNonNull(&tlsPtr_.opeer, RootInfo(kRootThreadObject, thread_id));
   if (tlsPtr_.exception != nullptr && tlsPtr_.exception != GetDeoptimizationException()) {
     visitor->VisitRoot(reinterpret_cast<mirror::Object**>(&tlsPtr_.exception),
@@ -3488,6 +3514,9 @@ void Thread::VisitRoots(RootVisitor* visitor) {
   for (auto* verifier = tlsPtr_.method_verifier; verifier != nullptr; verifier = verifier->link_) {
     verifier->VisitRoots(visitor, RootInfo(kRootNativeStack, thread_id));
   }
+  for (auto* context = verification_context_; context != nullptr; context = context->link_) {
+    context->VisitRoots(visitor, RootInfo(kRootNativeStack, thread_id));
+  }
   // Visit roots on this thread's stack
   RuntimeContextType context;
   RootCallbackVisitor visitor_to_callback(visitor, thread_id);
@@ -3549,6 +3578,11 @@ void Thread::SetStackEndForStackOverflow() {
 void Thread::SetTlab(uint8_t* start, uint8_t* end, uint8_t* limit) {
   DCHECK_LE(start, end);
   DCHECK_LE(end, limit);
+  if (tlsPtr_.thread_local_start != nullptr) {
+    const size_t waste = tlsPtr_.thread_local_limit - tlsPtr_.thread_local_pos;
+    tlab_recent_waste_ += waste;
+    tlab_wasted_bytes_ += waste;
+  }
   tlsPtr_.thread_local_start = start;
   tlsPtr_.thread_local_pos  = tlsPtr_.thread_local_start;
   tlsPtr_.thread_local_end = end;
@@ -3632,6 +3666,16 @@ void Thread::PopVerifier(verifier::MethodVerifier* verifier) {
   tlsPtr_.method_verifier = verifier->link_;
 }
 
+void Thread::PushVerificationContext(verifier::ClassVerificationContext* context) {
+  context->link_ = verification_context_;
+  verification_context_ = context;
+}
+
+void Thread::PopVerificationContext(verifier::ClassVerificationContext* context) {
+  CHECK_EQ(verification_context_, context);
+  verification_context_ = context->link_;
+}
+
 size_t Thread::NumberOfHeldMutexes() const {
   size_t count = 0;
   for (BaseMutex* mu : tlsPtr_.held_mutexes) {
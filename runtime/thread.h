@@ -31,6 +31,7 @@
 #include "base/enums.h"
 #include "base/macros.h"
 #include "base/mutex.h"
+#include "catch_handler_cache.h"
 #include "entrypoints/jni/jni_entrypoints.h"
 #include "entrypoints/quick/quick_entrypoints.h"
 #include "globals.h"
@@ -39,6 +40,7 @@
 #include "jvalue.h"
 #include "managed_stack.h"
 #include "offsets.h"
+#include "quick_frame_cache.h"
 #include "runtime_stats.h"
 #include "suspend_reason.h"
 #include "thread_state.h"
@@ -48,6 +50,7 @@ class BacktraceMap;
 namespace art {
 
 namespace gc {
+class AllocRecordThreadLocalBuffer;
 namespace accounting {
   template<class T> class AtomicStack;
 }  // namespace accounting
@@ -70,10 +73,12 @@ namespace mirror {
 }  // namespace mirror
 
 namespace verifier {
+  class ClassVerificationContext;
   class MethodVerifier;
   class VerifierDeps;
 }  // namespace verifier
 
+class ArtField;
 class ArtMethod;
 class BaseMutex;
 class ClassLinker;
@@ -93,6 +98,7 @@ class SingleStepControl;
 class StackedShadowFrameRecord;
 class Thread;
 class ThreadList;
+class TraceThreadLocalBuffer;
 enum VisitRootFlags : uint8_t;
 
 // Thread priorities. These must match the Thread.MIN_PRIORITY,
@@ -275,6 +281,18 @@ class Thread {
     tlsPtr_.thread_local_mark_stack = stack;
   }
 
+  // The evacuation TLAB of a GC thread, only interpreted by RegionSpace.
+  void* GetThreadLocalEvacRegion() const {
+    return tlsPtr_.thread_local_evac_region;
+  }
+  size_t GetThreadLocalEvacBytes() const {
+    return tlsPtr_.thread_local_evac_bytes;
+  }
+  void SetThreadLocalEvacRegion(void* region, size_t bytes) {
+    tlsPtr_.thread_local_evac_region = region;
+    tlsPtr_.thread_local_evac_bytes = bytes;
+  }
+
   // Called when thread detected that the thread_suspend_count_ was non-zero. Gives up share of
   // mutator_lock_ and waits until it is resumed and thread_suspend_count_ is zero.
   void FullSuspendCheck()
@@ -443,6 +461,10 @@ class Thread {
     tlsPtr_.managed_stack.SetTopQuickFrame(top_method);
   }
 
+  void SetTopOfStackTagged(ArtMethod** top_method) {
+    tlsPtr_.managed_stack.SetTopQuickFrameTagged(top_method);
+  }
+
   void SetTopOfShadowStack(ShadowFrame* top) {
     tlsPtr_.managed_stack.SetTopShadowFrame(top);
   }
@@ -927,6 +949,18 @@ class Thread {
     can_call_into_java_ = can_call_into_java;
   }
 
+  // Records that a suspend all request installed its barrier on this runnable thread at
+  // `request_ns`, so that the thread measures how long it takes to pass it.
+  void SetSuspendBarrierRequestTime(uint64_t request_ns)
+      REQUIRES(Locks::thread_suspend_count_lock_) {
+    suspend_barrier_request_ns_ = request_ns;
+  }
+
+  // How long the thread took to pass the last suspend barrier installed while it was runnable.
+  uint64_t GetLastTimeToSafepoint() const REQUIRES(Locks::thread_suspend_count_lock_) {
+    return last_time_to_safepoint_ns_;
+  }
+
   // Activates single step control for debugging. The thread takes the
   // ownership of the given SingleStepControl*. It is deleted by a call
   // to DeactivateSingleStepControl or upon thread destruction.
@@ -1084,6 +1118,90 @@ class Thread {
     return tlsPtr_.thread_local_pos;
   }
 
+  // Sampled allocation records not yet merged into the AllocRecordObjectMap, owned by the thread.
+  gc::AllocRecordThreadLocalBuffer* GetAllocRecordBuffer() const {
+    return alloc_record_buffer_;
+  }
+  void SetAllocRecordBuffer(gc::AllocRecordThreadLocalBuffer* buffer) {
+    alloc_record_buffer_ = buffer;
+  }
+
+  // Countdown of the allocation sampler of the heap, see Heap::SetAllocationSampler().
+  struct AllocSampleState {
+    // Bytes to allocate until the next sample, 0 before the first TLAB or allocation is counted.
+    size_t bytes_until_sample = 0;
+    // State of the xorshift64* generator of the sample intervals, seeded on first use.
+    uint64_t random_state = 0;
+    // Whether the end of the current TLAB was clamped to the next sample point.
+    bool tlab_end_at_sample = false;
+    // Whether the allocation being made by the slow path is to be sampled.
+    bool sample_pending = false;
+  };
+  AllocSampleState* GetAllocSampleState() {
+    return &alloc_sample_state_;
+  }
+
+  // Method trace events not yet written to the trace in streaming mode, owned by the thread.
+  TraceThreadLocalBuffer* GetMethodTraceBuffer() const {
+    return method_trace_buffer_;
+  }
+  void SetMethodTraceBuffer(TraceThreadLocalBuffer* buffer) {
+    method_trace_buffer_ = buffer;
+  }
+
+  // Free monitors the MonitorPool keeps for this thread, linked through Monitor::next_free_.
+  Monitor* GetCachedMonitors() const {
+    return cached_monitors_;
+  }
+  size_t GetNumberOfCachedMonitors() const {
+    return num_cached_monitors_;
+  }
+  void SetCachedMonitors(Monitor* monitors, size_t count) {
+    cached_monitors_ = monitors;
+    num_cached_monitors_ = count;
+  }
+
+  CatchHandlerCache* GetCatchHandlerCache() {
+    return &catch_handler_cache_;
+  }
+
+  QuickFrameCache* GetQuickFrameCache() {
+    return &quick_frame_cache_;
+  }
+
+  // The `cache` fields of the box caches, such as java.lang.Integer$IntegerCache, that the
+  // interpreter intrinsics for the valueOf methods looked up.
+  static constexpr size_t kNumInterpreterBoxCaches = 5u;
+  ArtField** GetInterpreterBoxCacheFields() {
+    return interpreter_box_cache_fields_;
+  }
+
+  // Adaptive TLAB sizing state, see Heap::NextTlabSize(). The size is 0 until the first refill.
+  size_t GetTlabTargetSize() const {
+    return tlab_target_size_;
+  }
+  uint64_t GetTlabRefillCount() const {
+    return tlab_refills_;
+  }
+  uint64_t GetTlabWastedBytes() const {
+    return tlab_wasted_bytes_;
+  }
+  // Bytes of TLABs wasted since the last refill.
+  size_t GetTlabRecentWaste() const {
+    return tlab_recent_waste_;
+  }
+  // Time of the last refill in ns, 0 if there was none.
+  uint64_t GetTlabLastRefillTime() const {
+    return tlab_last_refill_ns_;
+  }
+  // Records a refill at time now_ns with a new target size.
+  void RecordTlabRefill(uint64_t now_ns, size_t target_size) {
+    tlab_recent_waste_ = 0u;
+    tlab_last_refill_ns_ = now_ns;
+    tlab_target_size_ = target_size;
+    ++tlab_refills_;
+  }
+
   // Remove the suspend trigger for this thread by making the suspend_trigger_ TLS value
   // equal to a valid pointer.
   // TODO: does this need to atomic?  I don't think so.
@@ -1172,6 +1290,9 @@ class Thread {
   void PushVerifier(verifier::MethodVerifier* verifier);
   void PopVerifier(verifier::MethodVerifier* verifier);
 
+  void PushVerificationContext(verifier::ClassVerificationContext* context);
+  void PopVerificationContext(verifier::ClassVerificationContext* context);
+
   void InitStringEntryPoints();
 
   void ModifyDebugDisallowReadBarrier(int8_t delta) {
@@ -1505,7 +1626,8 @@ class Thread {
       thread_local_objects(0), mterp_current_ibase(nullptr), mterp_default_ibase(nullptr),
       mterp_alt_ibase(nullptr), thread_local_alloc_stack_top(nullptr),
       thread_local_alloc_stack_end(nullptr),
-      flip_function(nullptr), method_verifier(nullptr), thread_local_mark_stack(nullptr) {
+      flip_function(nullptr), method_verifier(nullptr), thread_local_mark_stack(nullptr),
+      thread_local_evac_region(nullptr), thread_local_evac_bytes(0) {
       std::fill(held_mutexes, held_mutexes + kLockLevelCount, nullptr);
     }
 
@@ -1662,6 +1784,11 @@ class Thread {
 
     // Thread-local mark stack for the concurrent copying collector.
     gc::accounting::AtomicStack<mirror::Object>* thread_local_mark_stack;
+
+    // The region a GC thread of the concurrent copying collector evacuates objects to, and the
+    // bytes it evacuated since the region space handed out the first one.
+    void* thread_local_evac_region;
+    size_t thread_local_evac_bytes;
   } tlsPtr_;
 
   // Guards the 'wait_monitor_' members.
@@ -1689,6 +1816,49 @@ class Thread {
   // By default this is true.
   bool can_call_into_java_;
 
+  // When a suspend all request installed its barrier on this thread while the thread was
+  // runnable, or 0 once the thread has passed it, and how long the thread took to pass the
+  // barrier, the last time and at most. Written with the thread_suspend_count_lock_ held.
+  uint64_t suspend_barrier_request_ns_ = 0;
+  uint64_t last_time_to_safepoint_ns_ = 0;
+  uint64_t max_time_to_safepoint_ns_ = 0;
+
+  // Adaptive TLAB sizing state. The waste is the unused capacity of TLABs when they are replaced
+  // or revoked.
+  size_t tlab_target_size_ = 0;
+  size_t tlab_recent_waste_ = 0;
+  uint64_t tlab_last_refill_ns_ = 0;
+  uint64_t tlab_refills_ = 0;
+  uint64_t tlab_wasted_bytes_ = 0;
+
+  // Sampling state and buffered records of allocation tracking, null until the first sample.
+  gc::AllocRecordThreadLocalBuffer* alloc_record_buffer_ = nullptr;
+
+  // Countdown of the allocation sampler of the heap.
+  AllocSampleState alloc_sample_state_;
+
+  // Buffered method trace events of a streaming trace, null until the first event.
+  TraceThreadLocalBuffer* method_trace_buffer_ = nullptr;
+
+  // Free monitors of the MonitorPool that this thread inflates locks with before taking the
+  // allocated_monitor_ids_lock_. Returned to the pool in Destroy().
+  Monitor* cached_monitors_ = nullptr;
+  size_t num_cached_monitors_ = 0;
+
+  // Catch handlers found by ArtMethod::FindCatchBlock, cleared when the roots are visited.
+  CatchHandlerCache catch_handler_cache_;
+
+  // Method headers and stack maps decoded by the stack walks of this thread.
+  QuickFrameCache quick_frame_cache_;
+
+  // Looked up lazily, so that they are found once the box cache classes are initialized. They
+  // are fields of boot classes, which are never unloaded.
+  ArtField* interpreter_box_cache_fields_[kNumInterpreterBoxCaches] = {};
+
+  // The contexts of the classes this thread is verifying, for the class verification context
+  // root linked list.
+  verifier::ClassVerificationContext* verification_context_ = nullptr;
+
   friend class Dbg;  // For SetStateUnsafe.
   friend class gc::collector::SemiSpace;  // For getting stack traces.
   friend class Runtime;  // For CreatePeer.
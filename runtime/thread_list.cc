@@ -44,6 +44,7 @@
 #include "native_stack_dump.h"
 #include "scoped_thread_state_change-inl.h"
 #include "thread.h"
+#include "thread_pool.h"
 #include "trace.h"
 #include "well_known_classes.h"
 
@@ -64,6 +65,13 @@ static constexpr uint64_t kLongThreadSuspendThreshold = MsToNs(5);
 static constexpr useconds_t kThreadSuspendInitialSleepUs = 0;
 static constexpr useconds_t kThreadSuspendMaxYieldUs = 3000;
 static constexpr useconds_t kThreadSuspendMaxSleepUs = 5000;
+// A suspend all request still waiting for threads after this long logs the threads that have not
+// reached a suspend point yet, with the native stacks of the first few of them.
+static constexpr uint64_t kSlowThreadSuspendReportThreshold = MsToNs(50);
+static constexpr size_t kMaxSlowThreadStackDumps = 4;
+// Below this number of suspended threads, running their checkpoints on the requesting thread is
+// cheaper than handing them to a thread pool.
+static constexpr size_t kMinThreadsForParallelCheckpoints = 8;
 
 // Whether we should try to dump the native stack of unattached threads. See commit ed8b723 for
 // some history.
@@ -305,7 +313,85 @@ static void ThreadSuspendSleep(useconds_t delay_us) {
   }
 }
 
-size_t ThreadList::RunCheckpoint(Closure* checkpoint_function, Closure* callback) {
+// Runs `visitor` for each of `threads`, which the caller keeps suspended, on the calling thread
+// and on the workers of `thread_pool`. The workers hold the mutator lock shared while the caller
+// does, which lets them run the closures the caller would otherwise run itself.
+template <typename Visitor>
+class ParallelSuspendedThreadsTask : public Task {
+ public:
+  ParallelSuspendedThreadsTask(const std::vector<Thread*>* threads,
+                               Atomic<size_t>* next_index,
+                               bool hold_mutator_lock,
+                               const Visitor* visitor)
+      : threads_(threads),
+        next_index_(next_index),
+        hold_mutator_lock_(hold_mutator_lock),
+        visitor_(visitor) {}
+
+  void Run(Thread* self) OVERRIDE NO_THREAD_SAFETY_ANALYSIS {
+    if (hold_mutator_lock_) {
+      Locks::mutator_lock_->SharedLock(self);
+    }
+    VisitThreads(threads_, next_index_, visitor_);
+    if (hold_mutator_lock_) {
+      Locks::mutator_lock_->SharedUnlock(self);
+    }
+  }
+
+  void Finalize() OVERRIDE {
+    delete this;
+  }
+
+  static void VisitThreads(const std::vector<Thread*>* threads,
+                           Atomic<size_t>* next_index,
+                           const Visitor* visitor) {
+    for (size_t i = next_index->FetchAndAddRelaxed(1u);
+         i < threads->size();
+         i = next_index->FetchAndAddRelaxed(1u)) {
+      (*visitor)((*threads)[i]);
+    }
+  }
+
+ private:
+  const std::vector<Thread*>* const threads_;
+  Atomic<size_t>* const next_index_;
+  const bool hold_mutator_lock_;
+  const Visitor* const visitor_;
+};
+
+template <typename Visitor>
+static void VisitSuspendedThreads(Thread* self,
+                                  const std::vector<Thread*>& threads,
+                                  ThreadPool* thread_pool,
+                                  const Visitor& visitor) {
+  if (thread_pool == nullptr ||
+      thread_pool->GetThreadCount() == 0u ||
+      threads.size() < kMinThreadsForParallelCheckpoints) {
+    for (Thread* thread : threads) {
+      visitor(thread);
+    }
+    return;
+  }
+  ScopedTrace trace("Parallel checkpoints of suspended threads");
+  const bool hold_mutator_lock = Locks::mutator_lock_->IsSharedHeld(self);
+  Atomic<size_t> next_index(0u);
+  const size_t num_workers = std::min(thread_pool->GetThreadCount(), threads.size() - 1u);
+  for (size_t i = 0; i != num_workers; ++i) {
+    thread_pool->AddTask(self, new ParallelSuspendedThreadsTask<Visitor>(
+        &threads, &next_index, hold_mutator_lock, &visitor));
+  }
+  thread_pool->SetMaxActiveWorkers(num_workers);
+  thread_pool->StartWorkers(self);
+  // The calling thread already holds the locks the closures expect, so it takes its share of the
+  // threads directly rather than through the pool.
+  ParallelSuspendedThreadsTask<Visitor>::VisitThreads(&threads, &next_index, &visitor);
+  thread_pool->Wait(self, /* do_work */ false, /* may_hold_locks */ true);
+  thread_pool->StopWorkers(self);
+}
+
+size_t ThreadList::RunCheckpoint(Closure* checkpoint_function,
+                                 Closure* callback,
+                                 ThreadPool* thread_pool) {
   Thread* self = Thread::Current();
   Locks::mutator_lock_->AssertNotExclusiveHeld(self);
   Locks::thread_list_lock_->AssertNotHeld(self);
@@ -350,7 +436,7 @@ size_t ThreadList::RunCheckpoint(Closure* checkpoint_function, Closure* callback
   checkpoint_function->Run(self);
 
   // Run the checkpoint on the suspended threads.
-  for (const auto& thread : suspended_count_modified_threads) {
+  auto run_checkpoint = [checkpoint_function](Thread* thread) {
     if (!thread->IsSuspended()) {
       if (ATRACE_ENABLED()) {
         std::ostringstream oss;
@@ -374,11 +460,14 @@ size_t ThreadList::RunCheckpoint(Closure* checkpoint_function, Closure* callback
     // We know for sure that the thread is suspended at this point.
     checkpoint_function->Run(thread);
     {
-      MutexLock mu2(self, *Locks::thread_suspend_count_lock_);
-      bool updated = thread->ModifySuspendCount(self, -1, nullptr, SuspendReason::kInternal);
+      // This is the requesting thread or a worker of the thread pool.
+      Thread* runner = Thread::Current();
+      MutexLock mu2(runner, *Locks::thread_suspend_count_lock_);
+      bool updated = thread->ModifySuspendCount(runner, -1, nullptr, SuspendReason::kInternal);
       DCHECK(updated);
     }
-  }
+  };
+  VisitSuspendedThreads(self, suspended_count_modified_threads, thread_pool, run_checkpoint);
 
   {
     // Imitate ResumeAll, threads may be waiting on Thread::resume_cond_ since we raised their
@@ -531,7 +620,8 @@ size_t ThreadList::RunCheckpointOnRunnableThreads(Closure* checkpoint_function)
 size_t ThreadList::FlipThreadRoots(Closure* thread_flip_visitor,
                                    Closure* flip_callback,
                                    gc::collector::GarbageCollector* collector,
-                                   gc::GcPauseListener* pause_listener) {
+                                   gc::GcPauseListener* pause_listener,
+                                   ThreadPool* thread_pool) {
   TimingLogger::ScopedTiming split("ThreadListFlip", collector->GetTimings());
   Thread* self = Thread::Current();
   Locks::mutator_lock_->AssertNotHeld(self);
@@ -599,12 +689,13 @@ size_t ThreadList::FlipThreadRoots(Closure* thread_flip_visitor,
   {
     TimingLogger::ScopedTiming split3("FlipOtherThreads", collector->GetTimings());
     ReaderMutexLock mu(self, *Locks::mutator_lock_);
-    for (const auto& thread : other_threads) {
+    auto run_flip_function = [](Thread* thread) {
       Closure* flip_func = thread->GetFlipFunction();
       if (flip_func != nullptr) {
         flip_func->Run(thread);
       }
-    }
+    };
+    VisitSuspendedThreads(self, other_threads, thread_pool, run_flip_function);
     // Run it for self.
     Closure* flip_func = self->GetFlipFunction();
     if (flip_func != nullptr) {
@@ -713,6 +804,10 @@ void ThreadList::SuspendAllInternal(Thread* self,
   if (ignore2 != nullptr && ignore1 != ignore2) {
     ++num_ignored;
   }
+  // The threads that were runnable when the barrier was installed. They stay suspended, and so
+  // registered, until the matching resume.
+  std::vector<Thread*> runnable_threads;
+  const uint64_t request_time = NanoTime();
   {
     MutexLock mu(self, *Locks::thread_list_lock_);
     MutexLock mu2(self, *Locks::thread_suspend_count_lock_);
@@ -728,6 +823,7 @@ void ThreadList::SuspendAllInternal(Thread* self,
         continue;
       }
       VLOG(threads) << "requesting thread suspend: " << *thread;
+      thread->SetSuspendBarrierRequestTime(request_time);
       bool updated = thread->ModifySuspendCount(self, +1, &pending_threads, reason);
       DCHECK(updated);
 
@@ -737,16 +833,23 @@ void ThreadList::SuspendAllInternal(Thread* self,
       if (thread->IsSuspended()) {
         // Only clear the counter for the current thread.
         thread->ClearSuspendBarrier(&pending_threads);
+        thread->SetSuspendBarrierRequestTime(0u);
         pending_threads.FetchAndSubSequentiallyConsistent(1);
+      } else {
+        runnable_threads.push_back(thread);
       }
     }
   }
 
   // Wait for the barrier to be passed by all runnable threads. This wait
-  // is done with a timeout so that we can detect problems.
+  // is done with a timeout so that we can detect problems. The first wait ends early to report
+  // the threads holding up the suspension.
+  const uint64_t report_timeout_ns =
+      std::min(kSlowThreadSuspendReportThreshold, thread_suspend_timeout_ns_);
+  bool reported_slow_threads = false;
 #if ART_USE_FUTEXES
   timespec wait_timeout;
-  InitTimeSpec(false, CLOCK_MONOTONIC, NsToMs(thread_suspend_timeout_ns_), 0, &wait_timeout);
+  InitTimeSpec(false, CLOCK_MONOTONIC, NsToMs(report_timeout_ns), 0, &wait_timeout);
 #endif
   const uint64_t start_time = NanoTime();
   while (true) {
@@ -756,7 +859,15 @@ void ThreadList::SuspendAllInternal(Thread* self,
       if (futex(pending_threads.Address(), FUTEX_WAIT, cur_val, &wait_timeout, nullptr, 0) != 0) {
         // EAGAIN and EINTR both indicate a spurious failure, try again from the beginning.
         if ((errno != EAGAIN) && (errno != EINTR)) {
-          if (errno == ETIMEDOUT) {
+          if (errno == ETIMEDOUT && !reported_slow_threads) {
+            reported_slow_threads = true;
+            DumpThreadsNotSuspended(self, ignore1, ignore2, NanoTime() - start_time);
+            InitTimeSpec(false,
+                         CLOCK_MONOTONIC,
+                         NsToMs(thread_suspend_timeout_ns_ - report_timeout_ns),
+                         0,
+                         &wait_timeout);
+          } else if (errno == ETIMEDOUT) {
             LOG(kIsDebugBuild ? ::android::base::FATAL : ::android::base::ERROR)
                 << "Timed out waiting for threads to suspend, waited for "
                 << PrettyDuration(NanoTime() - start_time);
@@ -767,13 +878,78 @@ void ThreadList::SuspendAllInternal(Thread* self,
       }  // else re-check pending_threads in the next iteration (this may be a spurious wake-up).
 #else
       // Spin wait. This is likely to be slow, but on most architecture ART_USE_FUTEXES is set.
-      UNUSED(start_time);
+      if (UNLIKELY(!reported_slow_threads) && NanoTime() - start_time > report_timeout_ns) {
+        reported_slow_threads = true;
+        DumpThreadsNotSuspended(self, ignore1, ignore2, NanoTime() - start_time);
+      }
 #endif
     } else {
       CHECK_EQ(cur_val, 0);
       break;
     }
   }
+  if (UNLIKELY(reported_slow_threads)) {
+    LOG(WARNING) << "Threads reached a suspend point after "
+                 << PrettyDuration(NanoTime() - start_time);
+  }
+  if (NanoTime() - request_time > kLongThreadSuspendThreshold) {
+    DumpSlowestThreadToSuspend(self, runnable_threads);
+  }
+}
+
+void ThreadList::DumpSlowestThreadToSuspend(Thread* self,
+                                            const std::vector<Thread*>& runnable_threads) {
+  Thread* slowest_thread = nullptr;
+  uint64_t slowest_time_ns = 0u;
+  {
+    MutexLock mu(self, *Locks::thread_suspend_count_lock_);
+    for (Thread* thread : runnable_threads) {
+      if (thread->GetLastTimeToSafepoint() >= slowest_time_ns) {
+        slowest_thread = thread;
+        slowest_time_ns = thread->GetLastTimeToSafepoint();
+      }
+    }
+  }
+  if (slowest_thread == nullptr) {
+    return;
+  }
+  std::ostringstream oss;
+  {
+    MutexLock mu(self, *Locks::thread_list_lock_);
+    slowest_thread->ShortDump(oss);
+  }
+  LOG(WARNING) << "Slowest thread to reach a suspend point took "
+               << PrettyDuration(slowest_time_ns) << ": " << oss.str();
+}
+
+void ThreadList::DumpThreadsNotSuspended(Thread* self,
+                                         Thread* ignore1,
+                                         Thread* ignore2,
+                                         uint64_t wait_time_ns) {
+  std::ostringstream oss;
+  oss << "Still waiting for threads to suspend after " << PrettyDuration(wait_time_ns) << ":\n";
+  {
+    MutexLock mu(self, *Locks::thread_list_lock_);
+    std::unique_ptr<BacktraceMap> map;
+    size_t num_stacks_dumped = 0u;
+    for (const auto& thread : list_) {
+      if (thread == ignore1 || thread == ignore2 || thread->IsSuspended()) {
+        continue;
+      }
+      thread->ShortDump(oss);
+      oss << "\n";
+      // The native stack shows what a thread runs instead of reaching a suspend check, for example
+      // a long loop in compiled code or a slow JNI transition.
+      if (num_stacks_dumped != kMaxSlowThreadStackDumps) {
+        if (map == nullptr) {
+          map.reset(BacktraceMap::Create(getpid()));
+        }
+        DumpNativeStack(oss, thread->GetTid(), map.get(), "  ");
+        ++num_stacks_dumped;
+      }
+    }
+  }
+  LOG(WARNING) << oss.str();
 }
 
 void ThreadList::ResumeAll() {
@@ -39,6 +39,7 @@ namespace gc {
 class Closure;
 class RootVisitor;
 class Thread;
+class ThreadPool;
 class TimingLogger;
 enum VisitRootFlags : uint8_t;
 
@@ -106,8 +107,12 @@ class ThreadList {
   // of the suspend check. Returns how many checkpoints that are expected to run, including for
   // already suspended threads for b/24191051. Run the callback, if non-null, inside the
   // thread_list_lock critical section after determining the runnable/suspended states of the
-  // threads.
-  size_t RunCheckpoint(Closure* checkpoint_function, Closure* callback = nullptr)
+  // threads. If thread_pool is non-null, the checkpoints of suspended threads are spread over the
+  // calling thread and the pool workers, which hold the mutator lock shared if the caller does.
+  // The pool must not be in use by anyone else.
+  size_t RunCheckpoint(Closure* checkpoint_function,
+                       Closure* callback = nullptr,
+                       ThreadPool* thread_pool = nullptr)
       REQUIRES(!Locks::thread_list_lock_, !Locks::thread_suspend_count_lock_);
 
   // Run an empty checkpoint on threads. Wait until threads pass the next suspend point or are
@@ -122,11 +127,13 @@ class ThreadList {
       REQUIRES(!Locks::thread_list_lock_, !Locks::thread_suspend_count_lock_);
 
   // Flip thread roots from from-space refs to to-space refs. Used by
-  // the concurrent copying collector.
+  // the concurrent copying collector. If thread_pool is non-null, the flip functions of the
+  // threads that stay suspended after the pause run in parallel on its workers.
   size_t FlipThreadRoots(Closure* thread_flip_visitor,
                          Closure* flip_callback,
                          gc::collector::GarbageCollector* collector,
-                         gc::GcPauseListener* pause_listener)
+                         gc::GcPauseListener* pause_listener,
+                         ThreadPool* thread_pool = nullptr)
       REQUIRES(!Locks::mutator_lock_,
                !Locks::thread_list_lock_,
                !Locks::thread_suspend_count_lock_);
@@ -204,6 +211,18 @@ class ThreadList {
                           SuspendReason reason = SuspendReason::kInternal)
       REQUIRES(!Locks::thread_list_lock_, !Locks::thread_suspend_count_lock_);
 
+  // Logs the threads a suspend all request is still waiting for, with some of their native stacks.
+  void DumpThreadsNotSuspended(Thread* self,
+                               Thread* ignore1,
+                               Thread* ignore2,
+                               uint64_t wait_time_ns)
+      REQUIRES(!Locks::thread_list_lock_, !Locks::thread_suspend_count_lock_);
+
+  // Logs which of the threads that were runnable when a suspend all request was issued took the
+  // longest to pass its barrier, and how long.
+  void DumpSlowestThreadToSuspend(Thread* self, const std::vector<Thread*>& runnable_threads)
+      REQUIRES(!Locks::thread_list_lock_, !Locks::thread_suspend_count_lock_);
+
   void AssertThreadsAreSuspended(Thread* self, Thread* ignore1, Thread* ignore2 = nullptr)
       REQUIRES(!Locks::thread_list_lock_, !Locks::thread_suspend_count_lock_);
 
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "thread_list.h"
+
+#include <map>
+
+#include "atomic.h"
+#include "barrier.h"
+#include "base/mutex.h"
+#include "common_runtime_test.h"
+#include "scoped_thread_state_change-inl.h"
+#include "thread-inl.h"
+#include "thread_pool.h"
+
+namespace art {
+
+class ThreadListTest : public CommonRuntimeTest {};
+
+class RecordingCheckpoint : public Closure {
+ public:
+  RecordingCheckpoint() : barrier_(0), lock_("Recording checkpoint lock") {}
+
+  void Run(Thread* thread) OVERRIDE {
+    Thread* self = Thread::Current();
+    {
+      MutexLock mu(self, lock_);
+      ++runs_[thread];
+    }
+    barrier_.Pass(self);
+  }
+
+  void WaitForRuns(Thread* self, size_t count) {
+    ScopedThreadStateChange tsc(self, kWaitingForCheckPointsToRun);
+    barrier_.Increment(self, count);
+  }
+
+  size_t GetRuns(Thread* self, Thread* thread) {
+    MutexLock mu(self, lock_);
+    auto it = runs_.find(thread);
+    return (it != runs_.end()) ? it->second : 0u;
+  }
+
+  size_t GetNumberOfThreads(Thread* self) {
+    MutexLock mu(self, lock_);
+    return runs_.size();
+  }
+
+ private:
+  Barrier barrier_;
+  Mutex lock_;
+  std::map<Thread*, size_t> runs_ GUARDED_BY(lock_);
+};
+
+class NopTask : public Task {
+ public:
+  void Run(Thread* self ATTRIBUTE_UNUSED) OVERRIDE {}
+
+  void Finalize() OVERRIDE {
+    delete this;
+  }
+};
+
+TEST_F(ThreadListTest, RunCheckpointOnThreadPool) {
+  Thread* self = Thread::Current();
+  // The workers of an idle pool wait for tasks in a suspended state, so there are enough suspended
+  // threads for the checkpoints to be run in parallel.
+  ThreadPool idle_pool("Idle thread pool", 16u);
+  ThreadPool checkpoint_pool("Checkpoint thread pool", 4u);
+  RecordingCheckpoint checkpoint;
+  size_t count = Runtime::Current()->GetThreadList()->RunCheckpoint(
+      &checkpoint, nullptr, &checkpoint_pool);
+  checkpoint.WaitForRuns(self, count);
+
+  EXPECT_EQ(count, checkpoint.GetNumberOfThreads(self));
+  EXPECT_EQ(1u, checkpoint.GetRuns(self, self));
+  for (ThreadPoolWorker* worker : idle_pool.GetWorkers()) {
+    EXPECT_EQ(1u, checkpoint.GetRuns(self, worker->GetThread()));
+  }
+  for (ThreadPoolWorker* worker : checkpoint_pool.GetWorkers()) {
+    EXPECT_EQ(1u, checkpoint.GetRuns(self, worker->GetThread()));
+  }
+
+  // The suspend counts raised for the checkpoint were lowered again.
+  for (ThreadPool* pool : { &idle_pool, &checkpoint_pool }) {
+    pool->AddTask(self, new NopTask());
+    pool->StartWorkers(self);
+    pool->Wait(self, /* do_work */ false, /* may_hold_locks */ false);
+    pool->StopWorkers(self);
+  }
+}
+
+}  // namespace art
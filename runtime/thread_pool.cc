@@ -245,6 +245,94 @@ size_t ThreadPool::GetTaskCount(Thread* self) {
   return tasks_.size();
 }
 
+std::vector<WorkStealingRanges::Range> WorkStealingRanges::SplitByCost(
+    size_t begin,
+    size_t end,
+    size_t num_ranges,
+    const std::function<size_t(size_t)>& cost) {
+  DCHECK_LE(begin, end);
+  DCHECK_NE(num_ranges, 0u);
+  std::vector<size_t> costs;
+  costs.reserve(end - begin);
+  size_t total_cost = 0u;
+  for (size_t i = begin; i != end; ++i) {
+    costs.push_back(cost(i));
+    total_cost += costs.back();
+  }
+  const size_t range_cost = std::max<size_t>((total_cost + num_ranges - 1u) / num_ranges, 1u);
+  std::vector<Range> ranges;
+  size_t range_begin = begin;
+  size_t current_cost = 0u;
+  for (size_t i = begin; i != end; ++i) {
+    size_t index_cost = costs[i - begin];
+    if (current_cost != 0u && current_cost + index_cost > range_cost) {
+      ranges.push_back(Range { range_begin, i });
+      range_begin = i;
+      current_cost = 0u;
+    }
+    current_cost += index_cost;
+  }
+  if (range_begin != end) {
+    ranges.push_back(Range { range_begin, end });
+  }
+  return ranges;
+}
+
+WorkStealingRanges::WorkStealingRanges(std::vector<Range>&& ranges, size_t num_workers)
+    : ranges_(std::move(ranges)), steals_(0u), active_worker_limit_(nullptr) {
+  DCHECK_NE(num_workers, 0u);
+  const size_t ranges_per_worker = (ranges_.size() + num_workers - 1u) / num_workers;
+  for (size_t worker = 0; worker != num_workers; ++worker) {
+    const size_t capacity = RoundUpToPowerOfTwo(std::max<size_t>(ranges_per_worker, 1u));
+    deques_.emplace_back(new gc::accounting::WorkStealingDeque<const Range>(capacity));
+    size_t block_begin = std::min(worker * ranges_per_worker, ranges_.size());
+    size_t block_end = std::min(block_begin + ranges_per_worker, ranges_.size());
+    // The owner pops from the bottom, push the block backwards for it to run in order.
+    for (size_t i = block_end; i != block_begin; --i) {
+      deques_.back()->Push(&ranges_[i - 1u]);
+    }
+  }
+}
+
+const WorkStealingRanges::Range* WorkStealingRanges::Next(size_t worker_index) {
+  DCHECK_LT(worker_index, deques_.size());
+  const Range* range = deques_[worker_index]->Pop();
+  if (range != nullptr) {
+    return range;
+  }
+  // Nothing is pushed once the workers run, so there is no more work when all deques are empty.
+  // A failed Steal() on a non-empty deque lost a race and is retried.
+  bool found_work = true;
+  while (found_work) {
+    found_work = false;
+    for (size_t i = 1; i != deques_.size(); ++i) {
+      gc::accounting::WorkStealingDeque<const Range>* victim =
+          deques_[(worker_index + i) % deques_.size()].get();
+      if (!victim->IsEmpty()) {
+        found_work = true;
+        range = victim->Steal();
+        if (range != nullptr) {
+          steals_.FetchAndAddRelaxed(1u);
+          return range;
+        }
+      }
+    }
+  }
+  return nullptr;
+}
+
+void WorkStealingWorker::Run(Thread* self) {
+  while (ranges_->IsWorkerActive(worker_index_)) {
+    const WorkStealingRanges::Range* range = ranges_->Next(worker_index_);
+    if (range == nullptr) {
+      break;
+    }
+    for (size_t index = range->begin; index != range->end; ++index) {
+      Visit(self, index);
+    }
+  }
+}
+
 void ThreadPool::SetPthreadPriority(int priority) {
   for (ThreadPoolWorker* worker : threads_) {
     worker->SetPthreadPriority(priority);
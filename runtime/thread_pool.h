@@ -18,10 +18,14 @@
 #define ART_RUNTIME_THREAD_POOL_H_
 
 #include <deque>
+#include <functional>
+#include <memory>
 #include <vector>
 
+#include "atomic.h"
 #include "barrier.h"
 #include "base/mutex.h"
+#include "gc/accounting/work_stealing_deque.h"
 #include "mem_map.h"
 
 namespace art {
@@ -48,6 +52,75 @@ class SelfDeletingTask : public Task {
   }
 };
 
+// The ranges of a parallel loop over [begin, end), shared by its WorkStealingWorker tasks. Each
+// worker owns a deque holding a contiguous block of the ranges and runs them in order, then steals
+// the last ranges of the other blocks. One expensive range therefore does not leave the other
+// workers idle, and with a single worker the indexes are visited in order.
+class WorkStealingRanges {
+ public:
+  struct Range {
+    size_t begin;
+    size_t end;
+  };
+
+  // Splits [begin, end) into about `num_ranges` ranges of similar total `cost`. An index costing
+  // more than a range gets a range of its own.
+  static std::vector<Range> SplitByCost(size_t begin,
+                                        size_t end,
+                                        size_t num_ranges,
+                                        const std::function<size_t(size_t)>& cost);
+
+  // Must be created before the workers start.
+  WorkStealingRanges(std::vector<Range>&& ranges, size_t num_workers);
+
+  size_t GetNumberOfWorkers() const {
+    return deques_.size();
+  }
+
+  // Returns the next range for `worker_index`, null once all ranges have been taken.
+  const Range* Next(size_t worker_index);
+
+  size_t GetNumberOfSteals() const {
+    return steals_.LoadRelaxed();
+  }
+
+  // Workers with an index at or above `*limit` stop taking ranges and the remaining workers
+  // steal their ranges. The limit may change while the workers run, worker 0 always runs.
+  void SetActiveWorkerLimit(const Atomic<size_t>* limit) {
+    active_worker_limit_ = limit;
+  }
+
+  bool IsWorkerActive(size_t worker_index) const {
+    return worker_index == 0u ||
+        active_worker_limit_ == nullptr ||
+        worker_index < active_worker_limit_->LoadRelaxed();
+  }
+
+ private:
+  const std::vector<Range> ranges_;
+  std::vector<std::unique_ptr<gc::accounting::WorkStealingDeque<const Range>>> deques_;
+  Atomic<size_t> steals_;
+  const Atomic<size_t>* active_worker_limit_;
+
+  DISALLOW_COPY_AND_ASSIGN(WorkStealingRanges);
+};
+
+// A task running the ranges of one worker of a WorkStealingRanges loop.
+class WorkStealingWorker : public Task {
+ public:
+  WorkStealingWorker(WorkStealingRanges* ranges, size_t worker_index)
+      : ranges_(ranges), worker_index_(worker_index) {}
+
+  void Run(Thread* self) OVERRIDE;
+
+ protected:
+  virtual void Visit(Thread* self, size_t index) = 0;
+
+ private:
+  WorkStealingRanges* const ranges_;
+  const size_t worker_index_;
+};
+
 class ThreadPoolWorker {
  public:
   static const size_t kDefaultStackSize = 1 * MB;
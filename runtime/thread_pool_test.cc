@@ -211,4 +211,61 @@ TEST_F(ThreadPoolTest, PeerTest) {
   }
 }
 
+TEST_F(ThreadPoolTest, SplitByCost) {
+  // Index 5 costs more than a range and gets one of its own.
+  std::vector<WorkStealingRanges::Range> ranges = WorkStealingRanges::SplitByCost(
+      0u, 10u, 4u, [](size_t index) { return (index == 5u) ? 20u : 1u; });
+  ASSERT_EQ(ranges.size(), 3u);
+  EXPECT_EQ(ranges[0].begin, 0u);
+  EXPECT_EQ(ranges[0].end, 5u);
+  EXPECT_EQ(ranges[1].begin, 5u);
+  EXPECT_EQ(ranges[1].end, 6u);
+  EXPECT_EQ(ranges[2].begin, 6u);
+  EXPECT_EQ(ranges[2].end, 10u);
+
+  EXPECT_TRUE(WorkStealingRanges::SplitByCost(3u, 3u, 4u, [](size_t) { return 1u; }).empty());
+}
+
+class VisitTask : public WorkStealingWorker {
+ public:
+  VisitTask(WorkStealingRanges* ranges, size_t worker_index, std::vector<AtomicInteger>* visits)
+      : WorkStealingWorker(ranges, worker_index), visits_(visits) {}
+
+  void Finalize() {
+    delete this;
+  }
+
+ protected:
+  void Visit(Thread* self ATTRIBUTE_UNUSED, size_t index) {
+    // Make the first indexes expensive so that the other workers steal them.
+    if (index < 8u) {
+      usleep(1000);
+    }
+    ++(*visits_)[index];
+  }
+
+ private:
+  std::vector<AtomicInteger>* const visits_;
+};
+
+// Check that work stealing visits each index exactly once.
+TEST_F(ThreadPoolTest, WorkStealing) {
+  Thread* self = Thread::Current();
+  ThreadPool thread_pool("Thread pool test thread pool", num_threads);
+  static constexpr size_t kNumIndexes = 1000u;
+  std::vector<AtomicInteger> visits(kNumIndexes);
+  WorkStealingRanges ranges(
+      WorkStealingRanges::SplitByCost(0u, kNumIndexes, 64u, [](size_t) { return 1u; }),
+      num_threads + 1);
+  for (int32_t i = 0; i != num_threads + 1; ++i) {
+    thread_pool.AddTask(self, new VisitTask(&ranges, i, &visits));
+  }
+  thread_pool.StartWorkers(self);
+  thread_pool.Wait(self, true, false);
+  thread_pool.StopWorkers(self);
+  for (size_t i = 0; i != kNumIndexes; ++i) {
+    EXPECT_EQ(visits[i].LoadRelaxed(), 1) << i;
+  }
+}
+
 }  // namespace art
@@ -22,6 +22,7 @@
 #include "android-base/stringprintf.h"
 
 #include "art_method-inl.h"
+#include "barrier.h"
 #include "base/casts.h"
 #include "base/enums.h"
 #include "base/stl_util.h"
@@ -45,6 +46,7 @@
 #include "stack.h"
 #include "thread.h"
 #include "thread_list.h"
+#include "thread_pool.h"
 #include "utils.h"
 
 namespace art {
@@ -95,7 +97,6 @@ TraceClockSource Trace::default_clock_source_ = kDefaultTraceClockSource;
 
 Trace* volatile Trace::the_trace_ = nullptr;
 pthread_t Trace::sampling_pthread_ = 0U;
-std::unique_ptr<std::vector<ArtMethod*>> Trace::temp_stack_trace_;
 
 // The key identifying the tracer to update instrumentation.
 static constexpr const char* kTracerInstrumentationKey = "Tracer";
@@ -132,13 +133,11 @@ uint32_t Trace::EncodeTraceMethodAndAction(ArtMethod* method, TraceAction action
 }
 
 std::vector<ArtMethod*>* Trace::AllocStackTrace() {
-  return (temp_stack_trace_.get() != nullptr)  ? temp_stack_trace_.release() :
-      new std::vector<ArtMethod*>();
+  return new std::vector<ArtMethod*>();
 }
 
 void Trace::FreeStackTrace(std::vector<ArtMethod*>* stack_trace) {
-  stack_trace->clear();
-  temp_stack_trace_.reset(stack_trace);
+  delete stack_trace;
 }
 
 void Trace::SetDefaultClockSource(TraceClockSource clock_source) {
@@ -226,13 +225,39 @@ static void Append8LE(uint8_t* buf, uint64_t val) {
   *buf++ = static_cast<uint8_t>(val >> 56);
 }
 
-static void GetSample(Thread* thread, void* arg) REQUIRES_SHARED(Locks::mutator_lock_) {
-  BuildStackTraceVisitor build_trace_visitor(thread);
-  build_trace_visitor.WalkStack();
-  std::vector<ArtMethod*>* stack_trace = build_trace_visitor.GetStackTrace();
-  Trace* the_trace = reinterpret_cast<Trace*>(arg);
-  the_trace->CompareAndUpdateStackTrace(thread, stack_trace);
-}
+// Takes a sample of the stack of each thread at its next suspend point, instead of suspending
+// all threads for the duration of the sampling. Suspended threads are sampled by the sampling
+// thread, their stacks do not change while the checkpoint runs.
+class SampleCheckpoint FINAL : public Closure {
+ public:
+  explicit SampleCheckpoint(Trace* trace) : barrier_(0), trace_(trace) {}
+
+  void Run(Thread* thread) OVERRIDE {
+    // Note thread and self may not be equal if thread was already suspended at
+    // the point of the request.
+    Thread* self = Thread::Current();
+    {
+      ScopedObjectAccess soa(self);
+      BuildStackTraceVisitor build_trace_visitor(thread);
+      build_trace_visitor.WalkStack();
+      trace_->CompareAndUpdateStackTrace(thread, build_trace_visitor.GetStackTrace());
+    }
+    barrier_.Pass(self);
+  }
+
+  void WaitForThreadsToRunThroughCheckpoint(size_t threads_running_checkpoint) {
+    Thread* self = Thread::Current();
+    ScopedThreadStateChange tsc(self, kWaitingForCheckPointsToRun);
+    barrier_.Increment(self, threads_running_checkpoint);
+  }
+
+ private:
+  // The barrier to be passed through and for the sampling thread to wait upon.
+  Barrier barrier_;
+  Trace* const trace_;
+
+  DISALLOW_COPY_AND_ASSIGN(SampleCheckpoint);
+};
 
 static void ClearThreadStackTraceAndClockBase(Thread* thread, void* arg ATTRIBUTE_UNUSED) {
   thread->SetTraceClockBase(0);
@@ -241,9 +266,16 @@ static void ClearThreadStackTraceAndClockBase(Thread* thread, void* arg ATTRIBUT
   delete stack_trace;
 }
 
+static void DeleteMethodTraceBuffer(Thread* thread, void* arg ATTRIBUTE_UNUSED) {
+  TraceThreadLocalBuffer* buffer = thread->GetMethodTraceBuffer();
+  thread->SetMethodTraceBuffer(nullptr);
+  delete buffer;
+}
+
 void Trace::CompareAndUpdateStackTrace(Thread* thread,
                                        std::vector<ArtMethod*>* stack_trace) {
-  CHECK_EQ(pthread_self(), sampling_pthread_);
+  // Only the thread itself, or the sampling thread while the thread is suspended, touches the
+  // sample of a thread.
   std::vector<ArtMethod*>* old_stack_trace = thread->GetStackTraceSample();
   // Update the thread's stack trace sample.
   thread->SetStackTraceSample(stack_trace);
@@ -301,10 +333,12 @@ void* Trace::RunSamplingThread(void* arg) {
         break;
       }
     }
-    {
-      ScopedSuspendAll ssa(__FUNCTION__);
-      MutexLock mu(self, *Locks::thread_list_lock_);
-      runtime->GetThreadList()->ForEach(GetSample, the_trace);
+    // Wait for all threads to take their sample, StopTracing deletes the trace once this thread
+    // exits.
+    SampleCheckpoint checkpoint(the_trace);
+    size_t threads_running_checkpoint = runtime->GetThreadList()->RunCheckpoint(&checkpoint);
+    if (threads_running_checkpoint != 0) {
+      checkpoint.WaitForThreadsToRunThroughCheckpoint(threads_running_checkpoint);
     }
   }
 
@@ -434,6 +468,10 @@ void Trace::StopTracing(bool finish_tracing, bool flush_file) {
             instrumentation::Instrumentation::kMethodExited |
             instrumentation::Instrumentation::kMethodUnwind);
       }
+      if (the_trace->trace_output_mode_ == TraceOutputMode::kStreaming) {
+        MutexLock mu(self, *Locks::thread_list_lock_);
+        runtime->GetThreadList()->ForEach(DeleteMethodTraceBuffer, nullptr);
+      }
       if (the_trace->trace_file_.get() != nullptr) {
         // Do not try to erase, so flush and close explicitly.
         if (flush_file) {
@@ -657,6 +695,18 @@ void Trace::FinishTracing() {
 
   std::set<ArtMethod*> visited_methods;
   if (trace_output_mode_ == TraceOutputMode::kStreaming) {
+    // Write out the events the threads still have buffered. The threads are suspended.
+    {
+      Thread* self = Thread::Current();
+      MutexLock mu(self, *Locks::thread_list_lock_);
+      MutexLock mu2(self, *streaming_lock_);
+      for (Thread* thread : Runtime::Current()->GetThreadList()->GetList()) {
+        TraceThreadLocalBuffer* buffer = thread->GetMethodTraceBuffer();
+        if (buffer != nullptr) {
+          WriteThreadLocalBuffer(thread, buffer);
+        }
+      }
+    }
     // Clean up.
     STLDeleteValues(&seen_methods_);
   } else {
@@ -915,21 +965,6 @@ void Trace::LogMethodTraceEvent(Thread* thread, ArtMethod* method,
   // Ensure we always use the non-obsolete version of the method so that entry/exit events have the
   // same pointer value.
   method = method->GetNonObsoleteMethod();
-  // Advance cur_offset_ atomically.
-  int32_t new_offset;
-  int32_t old_offset = 0;
-
-  // We do a busy loop here trying to acquire the next offset.
-  if (trace_output_mode_ != TraceOutputMode::kStreaming) {
-    do {
-      old_offset = cur_offset_.LoadRelaxed();
-      new_offset = old_offset + GetRecordSize(clock_source_);
-      if (static_cast<size_t>(new_offset) > buffer_size_) {
-        overflow_ = true;
-        return;
-      }
-    } while (!cur_offset_.CompareExchangeWeakSequentiallyConsistent(old_offset, new_offset));
-  }
 
   TraceAction action = kTraceMethodEnter;
   switch (event) {
@@ -946,18 +981,53 @@ void Trace::LogMethodTraceEvent(Thread* thread, ArtMethod* method,
       UNIMPLEMENTED(FATAL) << "Unexpected event: " << event;
   }
 
-  uint32_t method_value = EncodeTraceMethodAndAction(method, action);
-
-  // Write data
-  uint8_t* ptr;
-  static constexpr size_t kPacketSize = 14U;  // The maximum size of data in a packet.
-  uint8_t stack_buf[kPacketSize];             // Space to store a packet when in streaming mode.
   if (trace_output_mode_ == TraceOutputMode::kStreaming) {
-    ptr = stack_buf;
-  } else {
-    ptr = buf_.get() + old_offset;
+    // Record the event in the buffer of the thread. The streaming lock is only taken to write out
+    // a full buffer.
+    TraceThreadLocalBuffer* buffer = thread->GetMethodTraceBuffer();
+    if (UNLIKELY(buffer == nullptr)) {
+      buffer = new TraceThreadLocalBuffer();
+      thread->SetMethodTraceBuffer(buffer);
+    }
+    TraceThreadLocalBuffer::Event& record = buffer->events_[buffer->size_++];
+    record.method = method;
+    record.action = action;
+    record.thread_clock_diff = thread_clock_diff;
+    record.wall_clock_diff = wall_clock_diff;
+    if (UNLIKELY(buffer->size_ == TraceThreadLocalBuffer::kCapacity)) {
+      MutexLock mu(Thread::Current(), *streaming_lock_);
+      WriteThreadLocalBuffer(thread, buffer);
+    }
+    return;
   }
 
+  // Advance cur_offset_ atomically.
+  int32_t new_offset;
+  int32_t old_offset = 0;
+
+  // We do a busy loop here trying to acquire the next offset.
+  do {
+    old_offset = cur_offset_.LoadRelaxed();
+    new_offset = old_offset + GetRecordSize(clock_source_);
+    if (static_cast<size_t>(new_offset) > buffer_size_) {
+      overflow_ = true;
+      return;
+    }
+  } while (!cur_offset_.CompareExchangeWeakSequentiallyConsistent(old_offset, new_offset));
+
+  // Write data
+  WriteRecord(buf_.get() + old_offset,
+              thread,
+              EncodeTraceMethodAndAction(method, action),
+              thread_clock_diff,
+              wall_clock_diff);
+}
+
+void Trace::WriteRecord(uint8_t* ptr,
+                        Thread* thread,
+                        uint32_t method_value,
+                        uint32_t thread_clock_diff,
+                        uint32_t wall_clock_diff) {
   Append2LE(ptr, thread->GetTid());
   Append4LE(ptr + 2, method_value);
   ptr += 6;
@@ -969,13 +1039,28 @@ void Trace::LogMethodTraceEvent(Thread* thread, ArtMethod* method,
   if (UseWallClock()) {
     Append4LE(ptr, wall_clock_diff);
   }
-  static_assert(kPacketSize == 2 + 4 + 4 + 4, "Packet size incorrect.");
+}
 
-  if (trace_output_mode_ == TraceOutputMode::kStreaming) {
-    MutexLock mu(Thread::Current(), *streaming_lock_);  // To serialize writing.
-    if (RegisterMethod(method)) {
+void Trace::WriteThreadLocalBuffer(Thread* thread, TraceThreadLocalBuffer* buffer) {
+  if (RegisterThread(thread)) {
+    // It might be better to postpone this. Threads might not have received names...
+    std::string thread_name;
+    thread->GetThreadName(thread_name);
+    uint8_t buf2[7];
+    Append2LE(buf2, 0);
+    buf2[2] = kOpNewThread;
+    Append2LE(buf2 + 3, static_cast<uint16_t>(thread->GetTid()));
+    Append2LE(buf2 + 5, static_cast<uint16_t>(thread_name.length()));
+    WriteToBuf(buf2, sizeof(buf2));
+    WriteToBuf(reinterpret_cast<const uint8_t*>(thread_name.c_str()), thread_name.length());
+  }
+  static constexpr size_t kPacketSize = 14U;  // The maximum size of data in a packet.
+  static_assert(kPacketSize == 2 + 4 + 4 + 4, "Packet size incorrect.");
+  for (size_t i = 0; i != buffer->size_; ++i) {
+    const TraceThreadLocalBuffer::Event& record = buffer->events_[i];
+    if (RegisterMethod(record.method)) {
       // Write a special block with the name.
-      std::string method_line(GetMethodLine(method));
+      std::string method_line(GetMethodLine(record.method));
       uint8_t buf2[5];
       Append2LE(buf2, 0);
       buf2[2] = kOpNewMethod;
@@ -983,20 +1068,31 @@ void Trace::LogMethodTraceEvent(Thread* thread, ArtMethod* method,
       WriteToBuf(buf2, sizeof(buf2));
       WriteToBuf(reinterpret_cast<const uint8_t*>(method_line.c_str()), method_line.length());
     }
-    if (RegisterThread(thread)) {
-      // It might be better to postpone this. Threads might not have received names...
-      std::string thread_name;
-      thread->GetThreadName(thread_name);
-      uint8_t buf2[7];
-      Append2LE(buf2, 0);
-      buf2[2] = kOpNewThread;
-      Append2LE(buf2 + 3, static_cast<uint16_t>(thread->GetTid()));
-      Append2LE(buf2 + 5, static_cast<uint16_t>(thread_name.length()));
-      WriteToBuf(buf2, sizeof(buf2));
-      WriteToBuf(reinterpret_cast<const uint8_t*>(thread_name.c_str()), thread_name.length());
+    uint8_t packet[kPacketSize] = {};
+    WriteRecord(packet,
+                thread,
+                EncodeTraceMethodAndAction(record.method, record.action),
+                record.thread_clock_diff,
+                record.wall_clock_diff);
+    WriteToBuf(packet, sizeof(packet));
+  }
+  buffer->size_ = 0u;
+}
+
+void Trace::FlushThreadLocalBuffer(Thread* thread) {
+  TraceThreadLocalBuffer* buffer = thread->GetMethodTraceBuffer();
+  if (buffer == nullptr) {
+    return;
+  }
+  {
+    MutexLock mu(thread, *Locks::trace_lock_);
+    if (the_trace_ != nullptr) {
+      MutexLock mu2(thread, *the_trace_->streaming_lock_);
+      the_trace_->WriteThreadLocalBuffer(thread, buffer);
     }
-    WriteToBuf(stack_buf, sizeof(stack_buf));
   }
+  thread->SetMethodTraceBuffer(nullptr);
+  delete buffer;
 }
 
 void Trace::GetVisitedMethods(size_t buf_size,
@@ -93,6 +93,31 @@ enum TraceAction {
     kTraceMethodActionMask = 0x03,  // two bits
 };
 
+// Method trace events a thread recorded in streaming mode but did not write to the trace yet.
+// Threads only take the streaming lock to write out a full buffer, and to register the methods
+// and the thread the events refer to. Owned by the thread, see Thread::GetMethodTraceBuffer().
+class TraceThreadLocalBuffer {
+ public:
+  TraceThreadLocalBuffer() : size_(0u) {}
+
+ private:
+  static constexpr size_t kCapacity = 1024u;
+
+  struct Event {
+    ArtMethod* method;
+    TraceAction action;
+    uint32_t thread_clock_diff;
+    uint32_t wall_clock_diff;
+  };
+
+  size_t size_;
+  Event events_[kCapacity];
+
+  friend class Trace;
+
+  DISALLOW_COPY_AND_ASSIGN(TraceThreadLocalBuffer);
+};
+
 class Trace FINAL : public instrumentation::InstrumentationListener {
  public:
   enum TraceFlag {
@@ -192,12 +217,15 @@ class Trace FINAL : public instrumentation::InstrumentationListener {
                                 uint32_t dex_pc,
                                 ArtMethod* callee)
       REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(!*unique_methods_lock_) OVERRIDE;
-  // Reuse an old stack trace if it exists, otherwise allocate a new one.
+  // Allocate a stack trace to fill in. Samples of different threads are taken concurrently.
   static std::vector<ArtMethod*>* AllocStackTrace();
-  // Clear and store an old stack trace for later use.
+  // Free a stack trace that is not a sample of a thread anymore.
   static void FreeStackTrace(std::vector<ArtMethod*>* stack_trace);
   // Save id and name of a thread before it exits.
   static void StoreExitingThreadInfo(Thread* thread);
+  // Write out and free the buffered method trace events of a thread before it exits.
+  static void FlushThreadLocalBuffer(Thread* thread)
+      REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(!Locks::trace_lock_);
 
   static TraceOutputMode GetOutputMode() REQUIRES(!Locks::trace_lock_);
   static TraceMode GetMode() REQUIRES(!Locks::trace_lock_);
@@ -210,7 +238,8 @@ class Trace FINAL : public instrumentation::InstrumentationListener {
   Trace(File* trace_file, const char* trace_name, size_t buffer_size, int flags,
         TraceOutputMode output_mode, TraceMode trace_mode);
 
-  // The sampling interval in microseconds is passed as an argument.
+  // The sampling interval in microseconds is passed as an argument. Threads are sampled with a
+  // checkpoint, so sampling does not suspend all threads.
   static void* RunSamplingThread(void* arg) REQUIRES(!Locks::trace_lock_);
 
   static void StopTracing(bool finish_tracing, bool flush_file)
@@ -230,6 +259,17 @@ class Trace FINAL : public instrumentation::InstrumentationListener {
                            uint32_t thread_clock_diff, uint32_t wall_clock_diff)
       REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(!*unique_methods_lock_, !*streaming_lock_);
 
+  // Fill in a record of the trace at ptr.
+  void WriteRecord(uint8_t* ptr,
+                   Thread* thread,
+                   uint32_t method_value,
+                   uint32_t thread_clock_diff,
+                   uint32_t wall_clock_diff);
+
+  // Write the buffered events of a thread to the stream and empty the buffer. Streaming only.
+  void WriteThreadLocalBuffer(Thread* thread, TraceThreadLocalBuffer* buffer)
+      REQUIRES_SHARED(Locks::mutator_lock_) REQUIRES(streaming_lock_, !*unique_methods_lock_);
+
   // Methods to output traced methods and threads.
   void GetVisitedMethods(size_t end_offset, std::set<ArtMethod*>* visited_methods)
       REQUIRES(!*unique_methods_lock_);
@@ -271,9 +311,6 @@ class Trace FINAL : public instrumentation::InstrumentationListener {
   // Sampling thread, non-zero when sampling.
   static pthread_t sampling_pthread_;
 
-  // Used to remember an unused stack trace to avoid re-allocation during sampling.
-  static std::unique_ptr<std::vector<ArtMethod*>> temp_stack_trace_;
-
   // File to write trace data out to, null if direct to ddms.
   std::unique_ptr<File> trace_file_;
 
@@ -102,6 +102,19 @@ const std::string& Transaction::GetAbortMessage() {
   return abort_message_;
 }
 
+void Transaction::RecordNewObject(mirror::Object* obj) {
+  DCHECK(obj != nullptr);
+  MutexLock mu(Thread::Current(), log_lock_);
+  if (obj->IsArrayInstance() && !obj->IsObjectArray()) {
+    DCHECK(array_logs_.find(obj->AsArray()) == array_logs_.end());
+    array_logs_[obj->AsArray()].MarkAsNewArray();
+  } else {
+    // Object arrays are written through the field setters, so their writes go to object logs.
+    DCHECK(object_logs_.find(obj) == object_logs_.end());
+    object_logs_[obj].MarkAsNewObject();
+  }
+}
+
 void Transaction::RecordWriteFieldBoolean(mirror::Object* obj,
                                           MemberOffset field_offset,
                                           uint8_t value,
@@ -216,7 +229,6 @@ void Transaction::RecordWeakStringRemoval(ObjPtr<mirror::String> s) {
 }
 
 void Transaction::LogInternedString(InternStringLog&& log) {
-  Locks::intern_table_lock_->AssertExclusiveHeld(Thread::Current());
   MutexLock mu(Thread::Current(), log_lock_);
   intern_string_logs_.push_front(std::move(log));
 }
@@ -225,12 +237,17 @@ void Transaction::Rollback() {
   CHECK(!Runtime::Current()->IsActiveTransaction());
   Thread* self = Thread::Current();
   self->AssertNoPendingException();
-  MutexLock mu1(self, *Locks::intern_table_lock_);
-  MutexLock mu2(self, log_lock_);
-  UndoObjectModifications();
-  UndoArrayModifications();
-  UndoInternStringTableModifications();
-  UndoResolveStringModifications();
+  // Undoing the intern table changes takes the intern table stripe locks, which rank above the
+  // log lock. Take the intern string log out and replay it once the log lock is released.
+  std::list<InternStringLog> intern_string_logs;
+  {
+    MutexLock mu(self, log_lock_);
+    UndoObjectModifications();
+    UndoArrayModifications();
+    UndoResolveStringModifications();
+    intern_string_logs.swap(intern_string_logs_);
+  }
+  UndoInternStringTableModifications(intern_string_logs);
 }
 
 void Transaction::UndoObjectModifications() {
@@ -251,14 +268,14 @@ void Transaction::UndoArrayModifications() {
   array_logs_.clear();
 }
 
-void Transaction::UndoInternStringTableModifications() {
+void Transaction::UndoInternStringTableModifications(
+    const std::list<InternStringLog>& intern_string_logs) {
   InternTable* const intern_table = Runtime::Current()->GetInternTable();
   // We want to undo each operation from the most recent to the oldest. List has been filled so the
   // most recent operation is at list begin so just have to iterate over it.
-  for (const InternStringLog& string_log : intern_string_logs_) {
+  for (const InternStringLog& string_log : intern_string_logs) {
     string_log.Undo(intern_table);
   }
-  intern_string_logs_.clear();
 }
 
 void Transaction::UndoResolveStringModifications() {
@@ -377,6 +394,9 @@ void Transaction::ObjectLog::LogValue(ObjectLog::FieldValueKind kind,
                                       MemberOffset offset,
                                       uint64_t value,
                                       bool is_volatile) {
+  if (is_new_object_) {
+    return;
+  }
   auto it = field_values_.find(offset.Uint32Value());
   if (it == field_values_.end()) {
     ObjectLog::FieldValue field_value;
@@ -569,6 +589,9 @@ Transaction::InternStringLog::InternStringLog(ObjPtr<mirror::String> s,
 }
 
 void Transaction::ArrayLog::LogValue(size_t index, uint64_t value) {
+  if (is_new_array_) {
+    return;
+  }
   auto it = array_values_.find(index);
   if (it == array_values_.end()) {
     array_values_.insert(std::make_pair(index, value));
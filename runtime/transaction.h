@@ -54,6 +54,12 @@ class Transaction FINAL {
       REQUIRES_SHARED(Locks::mutator_lock_);
   bool IsAborted() REQUIRES(!log_lock_);
 
+  // Record an object or array allocated during the transaction. Its writes are not logged: once
+  // the writes to the objects that existed before are undone, nothing references it anymore.
+  void RecordNewObject(mirror::Object* obj)
+      REQUIRES(!log_lock_)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
   // Record object field changes.
   void RecordWriteFieldBoolean(mirror::Object* obj,
                                MemberOffset field_offset,
@@ -96,18 +102,15 @@ class Transaction FINAL {
       REQUIRES(!log_lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
-  // Record intern string table changes.
+  // Record intern string table changes. Called with the lock of the intern table stripe that
+  // holds the string.
   void RecordStrongStringInsertion(ObjPtr<mirror::String> s)
-      REQUIRES(Locks::intern_table_lock_)
       REQUIRES(!log_lock_);
   void RecordWeakStringInsertion(ObjPtr<mirror::String> s)
-      REQUIRES(Locks::intern_table_lock_)
       REQUIRES(!log_lock_);
   void RecordStrongStringRemoval(ObjPtr<mirror::String> s)
-      REQUIRES(Locks::intern_table_lock_)
       REQUIRES(!log_lock_);
   void RecordWeakStringRemoval(ObjPtr<mirror::String> s)
-      REQUIRES(Locks::intern_table_lock_)
       REQUIRES(!log_lock_);
 
   // Record resolve string.
@@ -142,6 +145,11 @@ class Transaction FINAL {
       return field_values_.size();
     }
 
+    void MarkAsNewObject() {
+      DCHECK(field_values_.empty());
+      is_new_object_ = true;
+    }
+
     ObjectLog() = default;
     ObjectLog(ObjectLog&& log) = default;
 
@@ -175,6 +183,8 @@ class Transaction FINAL {
 
     // Maps field's offset to its value.
     std::map<uint32_t, FieldValue> field_values_;
+    // Whether the object was allocated during the transaction.
+    bool is_new_object_ = false;
 
     DISALLOW_COPY_AND_ASSIGN(ObjectLog);
   };
@@ -189,6 +199,11 @@ class Transaction FINAL {
       return array_values_.size();
     }
 
+    void MarkAsNewArray() {
+      DCHECK(array_values_.empty());
+      is_new_array_ = true;
+    }
+
     ArrayLog() = default;
     ArrayLog(ArrayLog&& log) = default;
 
@@ -201,6 +216,8 @@ class Transaction FINAL {
     // Maps index to value.
     // TODO use JValue instead ?
     std::map<size_t, uint64_t> array_values_;
+    // Whether the array was allocated during the transaction.
+    bool is_new_array_ = false;
 
     DISALLOW_COPY_AND_ASSIGN(ArrayLog);
   };
@@ -218,8 +235,7 @@ class Transaction FINAL {
     InternStringLog(ObjPtr<mirror::String> s, StringKind kind, StringOp op);
 
     void Undo(InternTable* intern_table) const
-        REQUIRES_SHARED(Locks::mutator_lock_)
-        REQUIRES(Locks::intern_table_lock_);
+        REQUIRES_SHARED(Locks::mutator_lock_);
     void VisitRoots(RootVisitor* visitor) REQUIRES_SHARED(Locks::mutator_lock_);
 
     InternStringLog() = default;
@@ -249,7 +265,6 @@ class Transaction FINAL {
   };
 
   void LogInternedString(InternStringLog&& log)
-      REQUIRES(Locks::intern_table_lock_)
       REQUIRES(!log_lock_);
 
   void UndoObjectModifications()
@@ -258,9 +273,8 @@ class Transaction FINAL {
   void UndoArrayModifications()
       REQUIRES(log_lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
-  void UndoInternStringTableModifications()
-      REQUIRES(Locks::intern_table_lock_)
-      REQUIRES(log_lock_)
+  void UndoInternStringTableModifications(const std::list<InternStringLog>& intern_string_logs)
+      REQUIRES(!log_lock_)
       REQUIRES_SHARED(Locks::mutator_lock_);
   void UndoResolveStringModifications()
       REQUIRES(log_lock_)
@@ -166,6 +166,28 @@ TEST_F(TransactionTest, Array_length) {
   EXPECT_EQ(h_obj->GetLength(), kArraySize);
 }
 
+// Tests writes to arrays allocated during the transaction are not logged.
+TEST_F(TransactionTest, NewArrayWrites) {
+  ScopedObjectAccess soa(Thread::Current());
+  StackHandleScope<2> hs(soa.Self());
+  Handle<mirror::IntArray> h_old_array(hs.NewHandle(mirror::IntArray::Alloc(soa.Self(), 1)));
+  ASSERT_TRUE(h_old_array != nullptr);
+
+  Transaction transaction;
+  Runtime::Current()->EnterTransactionMode(&transaction);
+  Handle<mirror::IntArray> h_new_array(hs.NewHandle(mirror::IntArray::Alloc(soa.Self(), 1)));
+  ASSERT_TRUE(h_new_array != nullptr);
+  transaction.RecordNewObject(h_new_array.Get());
+  h_old_array->SetWithoutChecks<true>(0, 1);
+  h_new_array->SetWithoutChecks<true>(0, 1);
+  Runtime::Current()->ExitTransactionMode();
+
+  // Only the array that existed before the transaction is restored.
+  transaction.Rollback();
+  EXPECT_EQ(0, h_old_array->GetWithoutChecks(0));
+  EXPECT_EQ(1, h_new_array->GetWithoutChecks(0));
+}
+
 // Tests static fields are reset to their default value after transaction rollback.
 TEST_F(TransactionTest, StaticFieldsTest) {
   ScopedObjectAccess soa(Thread::Current());
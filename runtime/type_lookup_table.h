@@ -17,6 +17,8 @@
 #ifndef ART_RUNTIME_TYPE_LOOKUP_TABLE_H_
 #define ART_RUNTIME_TYPE_LOOKUP_TABLE_H_
 
+#include <string.h>
+
 #include "dex_file.h"
 #include "leb128.h"
 #include "utf.h"
@@ -65,7 +67,8 @@ class TypeLookupTable {
 
   // Method opens lookup table from binary data. Lookups will traverse strings and other
   // data contained in dex_file as well.  Lookup table does not own raw_data or dex_file.
-  static std::unique_ptr<TypeLookupTable> Open(const uint8_t* dex_file_pointer,
+  // `dex_data_pointer` is the base of the string data offsets, see DexFile::DataBegin().
+  static std::unique_ptr<TypeLookupTable> Open(const uint8_t* dex_data_pointer,
                                                const uint8_t* raw_data,
                                                uint32_t num_class_defs);
 
@@ -120,17 +123,18 @@ class TypeLookupTable {
   explicit TypeLookupTable(const DexFile& dex_file, uint8_t* storage);
 
   // Construct from a dex file with existing data.
-  TypeLookupTable(const uint8_t* dex_file_pointer,
+  TypeLookupTable(const uint8_t* dex_data_pointer,
                   const uint8_t* raw_data,
                   uint32_t num_class_defs);
 
   bool IsStringsEquals(const char* str, uint32_t str_offset) const {
-    const uint8_t* ptr = dex_file_begin_ + str_offset;
-    CHECK(dex_file_begin_ != nullptr);
+    const uint8_t* ptr = dex_data_begin_ + str_offset;
+    CHECK(dex_data_begin_ != nullptr);
     // Skip string length.
     DecodeUnsignedLeb128(&ptr);
-    return CompareModifiedUtf8ToModifiedUtf8AsUtf16CodePointValues(
-        str, reinterpret_cast<const char*>(ptr)) == 0;
+    // Modified UTF-8 strings with the same code points have the same bytes, so equality does
+    // not need to decode the code points and can use the library's vectorized strcmp().
+    return strcmp(str, reinterpret_cast<const char*>(ptr)) == 0;
   }
 
   // Method extracts hash bits from element's data and compare them with
@@ -158,7 +162,7 @@ class TypeLookupTable {
   // Find the last entry in a chain.
   uint32_t FindLastEntryInBucket(uint32_t cur_pos) const;
 
-  const uint8_t* dex_file_begin_;
+  const uint8_t* dex_data_begin_;
   const uint32_t raw_data_length_;
   const uint32_t mask_;
   std::unique_ptr<Entry[]> entries_;
@@ -16,6 +16,12 @@
 
 #include "utf.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
 #include "base/logging.h"
 #include "mirror/array.h"
 #include "mirror/object-inl.h"
@@ -23,6 +29,90 @@
 
 namespace art {
 
+// The conversions and counts below handle runs of ASCII characters a block at a time. Every byte
+// of an ASCII block of modified UTF-8 is a one-byte encoding and every char of an ASCII block of
+// UTF-16 is in U+0001 - U+007F, so the blocks give the same results as the byte or char loops,
+// also for malformed input.
+static constexpr size_t kAsciiBlockBytes = 16u;
+static constexpr size_t kAsciiBlockChars = 8u;
+
+// Returns whether none of the kAsciiBlockBytes bytes at `utf8` has the high bit set.
+ALWAYS_INLINE static bool IsAsciiBlock(const char* utf8) {
+#if defined(__SSE2__)
+  const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(utf8));
+  return _mm_movemask_epi8(v) == 0;
+#elif defined(__aarch64__)
+  const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(utf8));
+  return vmaxvq_u8(v) < 0x80u;
+#elif defined(__ARM_NEON__)
+  const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(utf8));
+  const uint64x2_t high_bits = vreinterpretq_u64_u8(vandq_u8(v, vdupq_n_u8(0x80u)));
+  return (vgetq_lane_u64(high_bits, 0) | vgetq_lane_u64(high_bits, 1)) == 0u;
+#else
+  uint64_t words[2];
+  memcpy(words, utf8, sizeof(words));
+  return ((words[0] | words[1]) & UINT64_C(0x8080808080808080)) == 0u;
+#endif
+}
+
+// Writes the kAsciiBlockBytes bytes at `utf8` zero-extended to `utf16`.
+ALWAYS_INLINE static void WidenAsciiBlock(const char* utf8, uint16_t* utf16) {
+#if defined(__SSE2__)
+  const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(utf8));
+  const __m128i zero = _mm_setzero_si128();
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(utf16), _mm_unpacklo_epi8(v, zero));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(utf16 + 8u), _mm_unpackhi_epi8(v, zero));
+#elif defined(__ARM_NEON__) || defined(__aarch64__)
+  const uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(utf8));
+  vst1q_u16(utf16, vmovl_u8(vget_low_u8(v)));
+  vst1q_u16(utf16 + 8u, vmovl_u8(vget_high_u8(v)));
+#else
+  for (size_t i = 0; i != kAsciiBlockBytes; ++i) {
+    utf16[i] = static_cast<uint8_t>(utf8[i]);
+  }
+#endif
+}
+
+// Returns whether all of the kAsciiBlockChars chars at `utf16` are in U+0001 - U+007F.
+ALWAYS_INLINE static bool IsAsciiUtf16Block(const uint16_t* utf16) {
+#if defined(__SSE2__)
+  // A char is ASCII if (char - 1) does not exceed 0x7e, U+0000 wraps around.
+  const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(utf16));
+  const __m128i excess =
+      _mm_subs_epu16(_mm_sub_epi16(v, _mm_set1_epi16(1)), _mm_set1_epi16(0x7e));
+  return _mm_movemask_epi8(_mm_cmpeq_epi16(excess, _mm_setzero_si128())) == 0xffff;
+#elif defined(__aarch64__)
+  const uint16x8_t v = vld1q_u16(utf16);
+  return vmaxvq_u16(vsubq_u16(v, vdupq_n_u16(1u))) < 0x7fu;
+#elif defined(__ARM_NEON__)
+  const uint16x8_t v = vld1q_u16(utf16);
+  const uint16x8_t non_ascii = vcgtq_u16(vsubq_u16(v, vdupq_n_u16(1u)), vdupq_n_u16(0x7eu));
+  const uint64x2_t lanes = vreinterpretq_u64_u16(non_ascii);
+  return (vgetq_lane_u64(lanes, 0) | vgetq_lane_u64(lanes, 1)) == 0u;
+#else
+  for (size_t i = 0; i != kAsciiBlockChars; ++i) {
+    if (static_cast<uint16_t>(utf16[i] - 1u) >= 0x7fu) {
+      return false;
+    }
+  }
+  return true;
+#endif
+}
+
+// Writes the low bytes of the kAsciiBlockChars chars at `utf16`, all below U+0100, to `utf8`.
+ALWAYS_INLINE static void NarrowAsciiUtf16Block(const uint16_t* utf16, char* utf8) {
+#if defined(__SSE2__)
+  const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(utf16));
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(utf8), _mm_packus_epi16(v, v));
+#elif defined(__ARM_NEON__) || defined(__aarch64__)
+  vst1_u8(reinterpret_cast<uint8_t*>(utf8), vmovn_u16(vld1q_u16(utf16)));
+#else
+  for (size_t i = 0; i != kAsciiBlockChars; ++i) {
+    utf8[i] = static_cast<char>(utf16[i]);
+  }
+#endif
+}
+
 // This is used only from debugger and test code.
 size_t CountModifiedUtf8Chars(const char* utf8) {
   return CountModifiedUtf8Chars(utf8, strlen(utf8));
@@ -48,6 +138,12 @@ size_t CountModifiedUtf8Chars(const char* utf8, size_t byte_count) {
   size_t len = 0;
   const char* end = utf8 + byte_count;
   for (; utf8 < end; ++utf8) {
+    if (static_cast<size_t>(end - utf8) >= kAsciiBlockBytes && IsAsciiBlock(utf8)) {
+      len += kAsciiBlockBytes;
+      // The loop increment takes care of the last byte.
+      utf8 += kAsciiBlockBytes - 1u;
+      continue;
+    }
     int ic = *utf8;
     len++;
     if (LIKELY((ic & 0x80) == 0)) {
@@ -96,7 +192,12 @@ void ConvertModifiedUtf8ToUtf16(uint16_t* utf16_data_out, size_t out_chars,
 
   if (LIKELY(out_chars == in_bytes)) {
     // Common case where all characters are ASCII.
-    for (const char *p = in_start; p < in_end;) {
+    const char *p = in_start;
+    for (; static_cast<size_t>(in_end - p) >= kAsciiBlockBytes; p += kAsciiBlockBytes) {
+      WidenAsciiBlock(p, out_p);
+      out_p += kAsciiBlockBytes;
+    }
+    while (p < in_end) {
       // Safe even if char is signed because ASCII characters always have
       // the high bit cleared.
       *out_p++ = dchecked_integral_cast<uint16_t>(*p++);
@@ -106,6 +207,14 @@ void ConvertModifiedUtf8ToUtf16(uint16_t* utf16_data_out, size_t out_chars,
 
   // String contains non-ASCII characters.
   for (const char *p = in_start; p < in_end;) {
+    if ((*p & 0x80) == 0 &&
+        static_cast<size_t>(in_end - p) >= kAsciiBlockBytes &&
+        IsAsciiBlock(p)) {
+      WidenAsciiBlock(p, out_p);
+      p += kAsciiBlockBytes;
+      out_p += kAsciiBlockBytes;
+      continue;
+    }
     const uint32_t ch = GetUtf16FromUtf8(&p);
     const uint16_t leading = GetLeadingUtf16Char(ch);
     const uint16_t trailing = GetTrailingUtf16Char(ch);
@@ -122,14 +231,27 @@ void ConvertUtf16ToModifiedUtf8(char* utf8_out, size_t byte_count,
   if (LIKELY(byte_count == char_count)) {
     // Common case where all characters are ASCII.
     const uint16_t *utf16_end = utf16_in + char_count;
-    for (const uint16_t *p = utf16_in; p < utf16_end;) {
+    const uint16_t *p = utf16_in;
+    for (; static_cast<size_t>(utf16_end - p) >= kAsciiBlockChars; p += kAsciiBlockChars) {
+      NarrowAsciiUtf16Block(p, utf8_out);
+      utf8_out += kAsciiBlockChars;
+    }
+    while (p < utf16_end) {
       *utf8_out++ = dchecked_integral_cast<char>(*p++);
     }
     return;
   }
 
   // String contains non-ASCII characters.
-  while (char_count--) {
+  while (char_count != 0u) {
+    if (char_count >= kAsciiBlockChars && IsAsciiUtf16Block(utf16_in)) {
+      NarrowAsciiUtf16Block(utf16_in, utf8_out);
+      utf16_in += kAsciiBlockChars;
+      utf8_out += kAsciiBlockChars;
+      char_count -= kAsciiBlockChars;
+      continue;
+    }
+    --char_count;
     const uint16_t ch = *utf16_in++;
     if (ch > 0 && ch <= 0x7f) {
       *utf8_out++ = ch;
@@ -188,9 +310,34 @@ int32_t ComputeUtf16HashFromModifiedUtf8(const char* utf8, size_t utf16_length)
 }
 
 uint32_t ComputeModifiedUtf8Hash(const char* chars) {
+  // This is `hash = hash * 31 + c` for each char, four chars at a time so that the multiplications
+  // do not wait for each other. The hash is stored in oat files and images, it must not change.
+  static constexpr uint32_t k31Pow2 = 31u * 31u;
+  static constexpr uint32_t k31Pow3 = 31u * 31u * 31u;
+  static constexpr uint32_t k31Pow4 = 31u * 31u * 31u * 31u;
   uint32_t hash = 0;
-  while (*chars != '\0') {
-    hash = hash * 31 + *chars++;
+  while (true) {
+    if (chars[0] == '\0') {
+      break;
+    }
+    const uint32_t c0 = static_cast<uint32_t>(chars[0]);
+    if (chars[1] == '\0') {
+      hash = hash * 31u + c0;
+      break;
+    }
+    const uint32_t c1 = static_cast<uint32_t>(chars[1]);
+    if (chars[2] == '\0') {
+      hash = hash * k31Pow2 + c0 * 31u + c1;
+      break;
+    }
+    const uint32_t c2 = static_cast<uint32_t>(chars[2]);
+    if (chars[3] == '\0') {
+      hash = hash * k31Pow3 + c0 * k31Pow2 + c1 * 31u + c2;
+      break;
+    }
+    const uint32_t c3 = static_cast<uint32_t>(chars[3]);
+    hash = hash * k31Pow4 + c0 * k31Pow3 + c1 * k31Pow2 + c2 * 31u + c3;
+    chars += 4;
   }
   return static_cast<int32_t>(hash);
 }
@@ -235,6 +382,11 @@ size_t CountUtf8Bytes(const uint16_t* chars, size_t char_count) {
   size_t result = 0;
   const uint16_t *end = chars + char_count;
   while (chars < end) {
+    if (static_cast<size_t>(end - chars) >= kAsciiBlockChars && IsAsciiUtf16Block(chars)) {
+      result += kAsciiBlockChars;
+      chars += kAsciiBlockChars;
+      continue;
+    }
     const uint16_t ch = *chars++;
     if (LIKELY(ch != 0 && ch < 0x80)) {
       result++;
@@ -108,6 +108,27 @@ TEST_F(UtfTest, GetUtf16FromUtf8_SurrogatesPassThrough) {
   EXPECT_ARRAY_POSITION(6, ptr, start);
 }
 
+TEST_F(UtfTest, ComputeModifiedUtf8Hash) {
+  // The hash is stored in oat files and images, check it against the plain definition for
+  // every length up to a few steps of the unrolled loop.
+  auto reference_hash = [](const char* chars) {
+    uint32_t hash = 0;
+    while (*chars != '\0') {
+      hash = hash * 31 + *chars++;
+    }
+    return static_cast<uint32_t>(static_cast<int32_t>(hash));
+  };
+  const std::string descriptor = "Ljava/lang/invoke/MethodHandles$Lookup;";
+  for (size_t length = 0; length <= descriptor.size(); ++length) {
+    const std::string prefix = descriptor.substr(0, length);
+    EXPECT_EQ(reference_hash(prefix.c_str()), ComputeModifiedUtf8Hash(prefix.c_str())) << prefix;
+  }
+  const char* const all_sequences = reinterpret_cast<const char*>(kAllSequences);
+  EXPECT_EQ(reference_hash(all_sequences), ComputeModifiedUtf8Hash(all_sequences));
+  const char* const surrogates = reinterpret_cast<const char*>(kSurrogateEncoding);
+  EXPECT_EQ(reference_hash(surrogates), ComputeModifiedUtf8Hash(surrogates));
+}
+
 TEST_F(UtfTest, CountModifiedUtf8Chars) {
   EXPECT_EQ(5u, CountModifiedUtf8Chars(reinterpret_cast<const char *>(kAllSequences)));
   EXPECT_EQ(2u, CountModifiedUtf8Chars(reinterpret_cast<const char *>(kSurrogateEncoding)));
@@ -347,6 +368,48 @@ static void testConversions(uint16_t *buf, int char_count) {
   }
 }
 
+// Checks the conversions of strings with ASCII runs of all lengths around the block sizes
+// of the ASCII fast paths, before and after a non-ASCII character.
+TEST_F(UtfTest, AsciiRuns) {
+  const std::map<std::vector<uint16_t>, std::vector<uint8_t>> non_ascii {
+      {{ }, { }},
+      {{ 0 }, { 0xc0, 0x80 }},
+      {{ 0xe9 }, { 0xc3, 0xa9 }},
+      {{ 0x20ac }, { 0xe2, 0x82, 0xac }},
+      {{ 0xd801, 0xdc00 }, { 0xf0, 0x90, 0x90, 0x80 }},
+  };
+  for (const auto& middle : non_ascii) {
+    for (size_t prefix_length = 0; prefix_length <= 35u; ++prefix_length) {
+      for (size_t suffix_length = 0; suffix_length <= 19u; ++suffix_length) {
+        std::vector<uint16_t> utf16;
+        std::vector<uint8_t> utf8;
+        for (size_t i = 0; i != prefix_length; ++i) {
+          utf16.push_back('a' + i % 26u);
+          utf8.push_back('a' + i % 26u);
+        }
+        utf16.insert(utf16.end(), middle.first.begin(), middle.first.end());
+        utf8.insert(utf8.end(), middle.second.begin(), middle.second.end());
+        for (size_t i = 0; i != suffix_length; ++i) {
+          utf16.push_back('A' + i % 26u);
+          utf8.push_back('A' + i % 26u);
+        }
+        if (utf16.empty()) {
+          continue;
+        }
+        AssertConversion(utf16, utf8);
+
+        utf8.push_back(0u);
+        const char* utf8_chars = reinterpret_cast<const char*>(utf8.data());
+        const size_t byte_count = utf8.size() - 1u;
+        ASSERT_EQ(utf16.size(), CountModifiedUtf8Chars(utf8_chars, byte_count));
+        std::vector<uint16_t> output(utf16.size());
+        ConvertModifiedUtf8ToUtf16(output.data(), output.size(), utf8_chars, byte_count);
+        EXPECT_EQ(utf16, output);
+      }
+    }
+  }
+}
+
 TEST_F(UtfTest, ExhaustiveBidirectionalCodePointCheck) {
   for (int codePoint = 0; codePoint <= 0x10ffff; ++codePoint) {
     uint16_t buf[4] = { 0 };
@@ -74,16 +74,8 @@ constexpr PointerSize GcRootAsPointerSize() {
   return PointerSize::k32;
 }
 
-inline size_t DexCacheArraysLayout::TypeOffset(dex::TypeIndex type_idx) const {
-  return types_offset_ + ElementOffset(PointerSize::k64,
-                                       type_idx.index_ % mirror::DexCache::kDexCacheTypeCacheSize);
-}
-
 inline size_t DexCacheArraysLayout::TypesSize(size_t num_elements) const {
-  size_t cache_size = mirror::DexCache::kDexCacheTypeCacheSize;
-  if (num_elements < cache_size) {
-    cache_size = num_elements;
-  }
+  size_t cache_size = mirror::DexCache::TypeCacheSize(num_elements);
   return PairArraySize(GcRootAsPointerSize<mirror::Class>(), cache_size);
 }
 
@@ -96,10 +88,7 @@ inline size_t DexCacheArraysLayout::MethodOffset(uint32_t method_idx) const {
 }
 
 inline size_t DexCacheArraysLayout::MethodsSize(size_t num_elements) const {
-  size_t cache_size = mirror::DexCache::kDexCacheMethodCacheSize;
-  if (num_elements < cache_size) {
-    cache_size = num_elements;
-  }
+  size_t cache_size = mirror::DexCache::MethodCacheSize(num_elements);
   return PairArraySize(pointer_size_, cache_size);
 }
 
@@ -107,16 +96,8 @@ inline size_t DexCacheArraysLayout::MethodsAlignment() const {
   return 2u * static_cast<size_t>(pointer_size_);
 }
 
-inline size_t DexCacheArraysLayout::StringOffset(uint32_t string_idx) const {
-  uint32_t string_hash = string_idx % mirror::DexCache::kDexCacheStringCacheSize;
-  return strings_offset_ + ElementOffset(PointerSize::k64, string_hash);
-}
-
 inline size_t DexCacheArraysLayout::StringsSize(size_t num_elements) const {
-  size_t cache_size = mirror::DexCache::kDexCacheStringCacheSize;
-  if (num_elements < cache_size) {
-    cache_size = num_elements;
-  }
+  size_t cache_size = mirror::DexCache::StringCacheSize(num_elements);
   return PairArraySize(GcRootAsPointerSize<mirror::String>(), cache_size);
 }
 
@@ -126,16 +107,8 @@ inline size_t DexCacheArraysLayout::StringsAlignment() const {
   return alignof(mirror::StringDexCacheType);
 }
 
-inline size_t DexCacheArraysLayout::FieldOffset(uint32_t field_idx) const {
-  uint32_t field_hash = field_idx % mirror::DexCache::kDexCacheFieldCacheSize;
-  return fields_offset_ + 2u * static_cast<size_t>(pointer_size_) * field_hash;
-}
-
 inline size_t DexCacheArraysLayout::FieldsSize(size_t num_elements) const {
-  size_t cache_size = mirror::DexCache::kDexCacheFieldCacheSize;
-  if (num_elements < cache_size) {
-    cache_size = num_elements;
-  }
+  size_t cache_size = mirror::DexCache::FieldCacheSize(num_elements);
   return PairArraySize(pointer_size_, cache_size);
 }
 
@@ -144,11 +117,7 @@ inline size_t DexCacheArraysLayout::FieldsAlignment() const {
 }
 
 inline size_t DexCacheArraysLayout::MethodTypesSize(size_t num_elements) const {
-  size_t cache_size = mirror::DexCache::kDexCacheMethodTypeCacheSize;
-  if (num_elements < cache_size) {
-    cache_size = num_elements;
-  }
-
+  size_t cache_size = mirror::DexCache::MethodTypeCacheSize(num_elements);
   return ArraySize(PointerSize::k64, cache_size);
 }
 
@@ -43,10 +43,12 @@ bool VdexFile::Header::IsVersionValid() const {
 
 VdexFile::Header::Header(uint32_t number_of_dex_files,
                          uint32_t dex_size,
+                         uint32_t shared_data_size,
                          uint32_t verifier_deps_size,
                          uint32_t quickening_info_size)
     : number_of_dex_files_(number_of_dex_files),
       dex_size_(dex_size),
+      shared_data_size_(shared_data_size),
       verifier_deps_size_(verifier_deps_size),
       quickening_info_size_(quickening_info_size) {
   memcpy(magic_, kVdexMagic, sizeof(kVdexMagic));
@@ -154,6 +156,8 @@ bool VdexFile::OpenAllDexFiles(std::vector<std::unique_ptr<const DexFile>>* dex_
     std::string location = DexFile::GetMultiDexLocation(i, kVdexLocation);
     std::unique_ptr<const DexFile> dex(DexFile::Open(dex_file_start,
                                                      size,
+                                                     GetSharedData().data(),
+                                                     GetSharedData().size(),
                                                      location,
                                                      GetLocationChecksum(i),
                                                      nullptr /*oat_dex_file*/,
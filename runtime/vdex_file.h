@@ -39,6 +39,8 @@ class DexFile;
 //   DEX[1]              the bytecode may have been quickened
 //   ...
 //   DEX[D]
+//   SharedData          data items of the compact dex files, if the dex files are compact
+//   VerifierDeps
 //   QuickeningInfo
 //     uint8[]                     quickening data
 //     unaligned_uint32_t[2][]     table of offsets pair:
@@ -54,6 +56,7 @@ class VdexFile {
    public:
     Header(uint32_t number_of_dex_files_,
            uint32_t dex_size,
+           uint32_t shared_data_size,
            uint32_t verifier_deps_size,
            uint32_t quickening_info_size);
 
@@ -64,6 +67,7 @@ class VdexFile {
     bool IsValid() const { return IsMagicValid() && IsVersionValid(); }
 
     uint32_t GetDexSize() const { return dex_size_; }
+    uint32_t GetSharedDataSize() const { return shared_data_size_; }
     uint32_t GetVerifierDepsSize() const { return verifier_deps_size_; }
     uint32_t GetQuickeningInfoSize() const { return quickening_info_size_; }
     uint32_t GetNumberOfDexFiles() const { return number_of_dex_files_; }
@@ -72,13 +76,14 @@ class VdexFile {
 
    private:
     static constexpr uint8_t kVdexMagic[] = { 'v', 'd', 'e', 'x' };
-    // Last update: Use set for unverified_classes_.
-    static constexpr uint8_t kVdexVersion[] = { '0', '1', '0', '\0' };
+    // Last update: Add the data section shared by compact dex files.
+    static constexpr uint8_t kVdexVersion[] = { '0', '1', '3', '\0' };
 
     uint8_t magic_[4];
     uint8_t version_[4];
     uint32_t number_of_dex_files_;
     uint32_t dex_size_;
+    uint32_t shared_data_size_;
     uint32_t verifier_deps_size_;
     uint32_t quickening_info_size_;
 
@@ -111,9 +116,14 @@ class VdexFile {
     return *reinterpret_cast<const Header*>(Begin());
   }
 
+  // The data section of the compact dex files, empty unless the dex files are compact.
+  ArrayRef<const uint8_t> GetSharedData() const {
+    return ArrayRef<const uint8_t>(DexEnd(), GetHeader().GetSharedDataSize());
+  }
+
   ArrayRef<const uint8_t> GetVerifierDepsData() const {
     return ArrayRef<const uint8_t>(
-        DexBegin() + GetHeader().GetDexSize(), GetHeader().GetVerifierDepsSize());
+        DexEnd() + GetHeader().GetSharedDataSize(), GetHeader().GetVerifierDepsSize());
   }
 
   ArrayRef<const uint8_t> GetQuickeningInfo() const {
@@ -154,13 +164,15 @@ class VdexFile {
   // Return the quickening info of the given code item.
   const uint8_t* GetQuickenedInfoOf(const DexFile& dex_file, uint32_t code_item_offset) const;
 
- private:
-  explicit VdexFile(MemMap* mmap) : mmap_(mmap) {}
-
+  // A vdex has no dex section when dex2oat mapped the dex files from their zip instead of
+  // copying them, see --no-copy-dex-files.
   bool HasDexSection() const {
     return GetHeader().GetDexSize() != 0;
   }
 
+ private:
+  explicit VdexFile(MemMap* mmap) : mmap_(mmap) {}
+
   const uint8_t* DexBegin() const {
     return Begin() + sizeof(Header) + GetSizeOfChecksumsSection();
   }
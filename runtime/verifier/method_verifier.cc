@@ -212,6 +212,7 @@ MethodVerifier::FailureData MethodVerifier::VerifyMethods(Thread* self,
                                                           bool allow_soft_failures,
                                                           HardFailLogMode log_level,
                                                           bool need_precise_constants,
+                                                          ClassVerificationContext* context,
                                                           std::string* error_string) {
   DCHECK(it != nullptr);
 
@@ -253,6 +254,7 @@ MethodVerifier::FailureData MethodVerifier::VerifyMethods(Thread* self,
                                                       allow_soft_failures,
                                                       log_level,
                                                       need_precise_constants,
+                                                      context,
                                                       &hard_failure_msg);
     if (result.kind == FailureKind::kHardFailure) {
       if (failure_data.kind == FailureKind::kHardFailure) {
@@ -284,6 +286,7 @@ FailureKind MethodVerifier::VerifyClass(Thread* self,
                                         HardFailLogMode log_level,
                                         std::string* error) {
   ScopedTrace trace(__FUNCTION__);
+  VerifierDeps::ScopedClassDependencies class_dependencies(*dex_file, class_def.class_idx_);
 
   // A class must not be abstract and final.
   if ((class_def.access_flags_ & (kAccAbstract | kAccFinal)) == (kAccAbstract | kAccFinal)) {
@@ -301,6 +304,7 @@ FailureKind MethodVerifier::VerifyClass(Thread* self,
   ClassDataItemIterator it(*dex_file, class_data);
   it.SkipAllFields();
   ClassLinker* linker = Runtime::Current()->GetClassLinker();
+  ClassVerificationContext context(self, /* can_load_classes */ true);
   // Direct methods.
   MethodVerifier::FailureData data1 = VerifyMethods<true>(self,
                                                           linker,
@@ -313,6 +317,7 @@ FailureKind MethodVerifier::VerifyClass(Thread* self,
                                                           allow_soft_failures,
                                                           log_level,
                                                           false /* need precise constants */,
+                                                          &context,
                                                           error);
   // Virtual methods.
   MethodVerifier::FailureData data2 = VerifyMethods<false>(self,
@@ -326,6 +331,7 @@ FailureKind MethodVerifier::VerifyClass(Thread* self,
                                                            allow_soft_failures,
                                                            log_level,
                                                            false /* need precise constants */,
+                                                           &context,
                                                            error);
 
   data1.Merge(data2);
@@ -374,6 +380,7 @@ MethodVerifier::FailureData MethodVerifier::VerifyMethod(Thread* self,
                                                          bool allow_soft_failures,
                                                          HardFailLogMode log_level,
                                                          bool need_precise_constants,
+                                                         ClassVerificationContext* context,
                                                          std::string* hard_failure_msg) {
   MethodVerifier::FailureData result;
   uint64_t start_ns = kTimeVerifyMethod ? NanoTime() : 0;
@@ -391,7 +398,8 @@ MethodVerifier::FailureData MethodVerifier::VerifyMethod(Thread* self,
                           allow_soft_failures,
                           need_precise_constants,
                           false /* verify to dump */,
-                          true /* allow_thread_suspension */);
+                          true /* allow_thread_suspension */,
+                          context);
   if (verifier.Verify()) {
     // Verification completed, however failures may be pending that didn't cause the verification
     // to hard fail.
@@ -535,6 +543,36 @@ MethodVerifier* MethodVerifier::VerifyMethodAndDump(Thread* self,
   }
 }
 
+ClassVerificationContext::ClassVerificationContext(Thread* self, bool can_load_classes)
+    : self_(self),
+      can_load_classes_(can_load_classes),
+      arena_stack_(Runtime::Current()->GetArenaPool()),
+      reg_types_arena_stack_(Runtime::Current()->GetArenaPool()),
+      link_(nullptr) {
+  self->PushVerificationContext(this);
+}
+
+ClassVerificationContext::~ClassVerificationContext() {
+  self_->PopVerificationContext(this);
+}
+
+RegTypeCache& ClassVerificationContext::GetRegTypesForMethod() {
+  if (reg_types_ == nullptr || reg_types_->GetCacheSize() > kMaxSharedRegTypes) {
+    // Release the old arena allocator before creating the new one on the same arena stack.
+    reg_types_.reset();
+    reg_types_arena_.reset();
+    reg_types_arena_.reset(new ScopedArenaAllocator(&reg_types_arena_stack_));
+    reg_types_.reset(new RegTypeCache(can_load_classes_, *reg_types_arena_));
+  }
+  return *reg_types_;
+}
+
+void ClassVerificationContext::VisitRoots(RootVisitor* visitor, const RootInfo& root_info) {
+  if (reg_types_ != nullptr) {
+    reg_types_->VisitRoots(visitor, root_info);
+  }
+}
+
 MethodVerifier::MethodVerifier(Thread* self,
                                const DexFile* dex_file,
                                Handle<mirror::DexCache> dex_cache,
@@ -548,11 +586,13 @@ MethodVerifier::MethodVerifier(Thread* self,
                                bool allow_soft_failures,
                                bool need_precise_constants,
                                bool verify_to_dump,
-                               bool allow_thread_suspension)
+                               bool allow_thread_suspension,
+                               ClassVerificationContext* context)
     : self_(self),
       arena_stack_(Runtime::Current()->GetArenaPool()),
-      arena_(&arena_stack_),
-      reg_types_(can_load_classes, arena_),
+      arena_(context != nullptr ? context->GetArenaStack() : &arena_stack_),
+      owned_reg_types_(context != nullptr ? nullptr : new RegTypeCache(can_load_classes, arena_)),
+      reg_types_(context != nullptr ? context->GetRegTypesForMethod() : *owned_reg_types_),
       reg_table_(arena_),
       work_insn_idx_(DexFile::kDexNoIndex),
       dex_method_idx_(dex_method_idx),
@@ -3404,6 +3444,8 @@ bool MethodVerifier::CodeFlowVerifyInstruction(uint32_t* start_guess) {
       VerifyQuickFieldAccess<FieldAccessType::kAccGet>(inst, reg_types_.LongLo(), true);
       break;
     case Instruction::IGET_OBJECT_QUICK:
+    case Instruction::IGET_OBJECT_QUICK_IF_EQZ:
+    case Instruction::IGET_OBJECT_QUICK_IF_NEZ:
       VerifyQuickFieldAccess<FieldAccessType::kAccGet>(inst, reg_types_.JavaLangObject(false), false);
       break;
     case Instruction::IGET_BOOLEAN_QUICK:
@@ -3458,7 +3500,7 @@ bool MethodVerifier::CodeFlowVerifyInstruction(uint32_t* start_guess) {
 
     /* These should never appear during verification. */
     case Instruction::UNUSED_3E ... Instruction::UNUSED_43:
-    case Instruction::UNUSED_F3 ... Instruction::UNUSED_F9:
+    case Instruction::UNUSED_F5 ... Instruction::UNUSED_F9:
     case Instruction::UNUSED_FE ... Instruction::UNUSED_FF:
     case Instruction::UNUSED_79:
     case Instruction::UNUSED_7A:
@@ -5417,7 +5459,10 @@ void MethodVerifier::VisitStaticRoots(RootVisitor* visitor) {
 }
 
 void MethodVerifier::VisitRoots(RootVisitor* visitor, const RootInfo& root_info) {
-  reg_types_.VisitRoots(visitor, root_info);
+  // Shared register types are visited through the class verification context.
+  if (owned_reg_types_ != nullptr) {
+    reg_types_.VisitRoots(visitor, root_info);
+  }
 }
 
 const RegType& MethodVerifier::FromClass(const char* descriptor,
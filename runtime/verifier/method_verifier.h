@@ -49,6 +49,7 @@ class DexCache;
 
 namespace verifier {
 
+class ClassVerificationContext;
 class MethodVerifier;
 class RegisterLine;
 using RegisterLineArenaUniquePtr = std::unique_ptr<RegisterLine, RegisterLineArenaDelete>;
@@ -86,6 +87,51 @@ class PcToRegisterLineTable {
   DISALLOW_COPY_AND_ASSIGN(PcToRegisterLineTable);
 };
 
+// The arena and the register types shared by the verifiers of the methods of one class. The
+// verifiers allocate from the same arena stack, which keeps its arenas, and the register lines in
+// them, from one method to the next instead of returning them to the arena pool. Types resolve
+// the same way in all methods of a class, so the verifiers also share the register type cache and
+// resolve each type the class uses once. The context is registered with the thread, so that the
+// GC visits the classes in the cache also between methods.
+class ClassVerificationContext {
+ public:
+  ClassVerificationContext(Thread* self, bool can_load_classes);
+  ~ClassVerificationContext();
+
+  ArenaStack* GetArenaStack() {
+    return &arena_stack_;
+  }
+
+  // Returns the register types for the next method. The cache starts over once it has grown
+  // large enough for its linear lookups to cost more than resolving the types again.
+  RegTypeCache& GetRegTypesForMethod() REQUIRES_SHARED(Locks::mutator_lock_);
+
+  void VisitRoots(RootVisitor* visitor, const RootInfo& roots)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
+ private:
+  static constexpr size_t kMaxSharedRegTypes = 1024;
+
+  Thread* const self_;
+  const bool can_load_classes_;
+
+  // The arena stack of the method verifiers.
+  ArenaStack arena_stack_;
+
+  // The register types outlive the arena allocators of the method verifiers, so they need an
+  // arena stack of their own.
+  ArenaStack reg_types_arena_stack_;
+  std::unique_ptr<ScopedArenaAllocator> reg_types_arena_;
+  std::unique_ptr<RegTypeCache> reg_types_;
+
+  // Link, for the class verification context root linked list.
+  ClassVerificationContext* link_;
+
+  friend class art::Thread;
+
+  DISALLOW_COPY_AND_ASSIGN(ClassVerificationContext);
+};
+
 // The verifier
 class MethodVerifier {
  public:
@@ -239,7 +285,8 @@ class MethodVerifier {
                  bool allow_soft_failures,
                  bool need_precise_constants,
                  bool verify_to_dump,
-                 bool allow_thread_suspension)
+                 bool allow_thread_suspension,
+                 ClassVerificationContext* context = nullptr)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
   void UninstantiableError(const char* descriptor);
@@ -285,6 +332,7 @@ class MethodVerifier {
                                    bool allow_soft_failures,
                                    HardFailLogMode log_level,
                                    bool need_precise_constants,
+                                   ClassVerificationContext* context,
                                    std::string* error_string)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
@@ -312,6 +360,7 @@ class MethodVerifier {
                                   bool allow_soft_failures,
                                   HardFailLogMode log_level,
                                   bool need_precise_constants,
+                                  ClassVerificationContext* context,
                                   std::string* hard_failure_msg)
       REQUIRES_SHARED(Locks::mutator_lock_);
 
@@ -696,11 +745,13 @@ class MethodVerifier {
   // The thread we're verifying on.
   Thread* const self_;
 
-  // Arena allocator.
+  // Arena allocator. The arena stack is only used without a class verification context.
   ArenaStack arena_stack_;
   ScopedArenaAllocator arena_;
 
-  RegTypeCache reg_types_;
+  // The register types, owned by the verifier unless it shares those of a class.
+  std::unique_ptr<RegTypeCache> owned_reg_types_;
+  RegTypeCache& reg_types_;
 
   PcToRegisterLineTable reg_table_;
 
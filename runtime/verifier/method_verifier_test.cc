@@ -21,9 +21,13 @@
 
 #include "android-base/strings.h"
 
+#include "base/time_utils.h"
 #include "class_linker-inl.h"
 #include "common_runtime_test.h"
 #include "dex_file-inl.h"
+#include "gc/heap.h"
+#include "mirror/string.h"
+#include "reg_type-inl.h"
 #include "scoped_thread_state_change-inl.h"
 #include "utils.h"
 #include "verifier_enums.h"
@@ -67,7 +71,24 @@ class MethodVerifierTest : public CommonRuntimeTest {
 TEST_F(MethodVerifierTest, LibCore) {
   ScopedObjectAccess soa(Thread::Current());
   ASSERT_TRUE(java_lang_dex_file_ != nullptr);
+  uint64_t start_ns = NanoTime();
   VerifyDexFile(*java_lang_dex_file_);
+  LOG(INFO) << "Verified " << java_lang_dex_file_->GetLocation() << " in "
+            << PrettyDuration(NanoTime() - start_ns);
+}
+
+TEST_F(MethodVerifierTest, ClassVerificationContext) {
+  ScopedObjectAccess soa(Thread::Current());
+  ClassVerificationContext context(soa.Self(), /* can_load_classes */ true);
+  RegTypeCache& reg_types = context.GetRegTypesForMethod();
+  const RegType& string_type = reg_types.FromDescriptor(nullptr, "Ljava/lang/String;", false);
+  ASSERT_TRUE(string_type.HasClass());
+
+  // The next method shares the types, and the GC keeps their classes up to date.
+  Runtime::Current()->GetHeap()->CollectGarbage(false);
+  EXPECT_EQ(&reg_types, &context.GetRegTypesForMethod());
+  EXPECT_EQ(&string_type, &reg_types.FromDescriptor(nullptr, "Ljava/lang/String;", false));
+  EXPECT_EQ(string_type.GetClass(), mirror::String::GetJavaLangString());
 }
 
 }  // namespace verifier
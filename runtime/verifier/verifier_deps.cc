@@ -34,7 +34,9 @@ namespace art {
 namespace verifier {
 
 VerifierDeps::VerifierDeps(const std::vector<const DexFile*>& dex_files, bool output_only)
-    : output_only_(output_only) {
+    : output_only_(output_only),
+      recording_dex_file_(nullptr),
+      recording_class_(dex::TypeIndex::Invalid()) {
   for (const DexFile* dex_file : dex_files) {
     DCHECK(GetDexFileDeps(*dex_file) == nullptr);
     std::unique_ptr<DexFileDeps> deps(new DexFileDeps());
@@ -60,6 +62,9 @@ void VerifierDeps::MergeWith(const VerifierDeps& other,
     MergeSets(my_deps->fields_, other_deps.fields_);
     MergeSets(my_deps->methods_, other_deps.methods_);
     MergeSets(my_deps->unverified_classes_, other_deps.unverified_classes_);
+    for (const auto& entry : other_deps.class_dependencies_) {
+      MergeSets(my_deps->class_dependencies_[entry.first], entry.second);
+    }
   }
 }
 
@@ -290,7 +295,9 @@ void VerifierDeps::AddClassResolution(const DexFile& dex_file,
     return;
   }
 
-  dex_deps->classes_.emplace(ClassResolution(type_idx, GetAccessFlags(klass)));
+  ClassResolution entry(type_idx, GetAccessFlags(klass));
+  dex_deps->classes_.emplace(entry);
+  RecordClassDependency(dex_file, dex_deps, GetKey(dex_file, entry));
 }
 
 void VerifierDeps::AddFieldResolution(const DexFile& dex_file,
@@ -308,11 +315,11 @@ void VerifierDeps::AddFieldResolution(const DexFile& dex_file,
     return;
   }
 
-  dex_deps->fields_.emplace(FieldResolution(field_idx,
-                                            GetAccessFlags(field),
-                                            GetFieldDeclaringClassStringId(dex_file,
-                                                                           field_idx,
-                                                                           field)));
+  FieldResolution entry(field_idx,
+                        GetAccessFlags(field),
+                        GetFieldDeclaringClassStringId(dex_file, field_idx, field));
+  dex_deps->fields_.emplace(entry);
+  RecordClassDependency(dex_file, dex_deps, GetKey(dex_file, entry));
 }
 
 void VerifierDeps::AddMethodResolution(const DexFile& dex_file,
@@ -334,6 +341,7 @@ void VerifierDeps::AddMethodResolution(const DexFile& dex_file,
                                 GetAccessFlags(method),
                                 GetMethodDeclaringClassStringId(dex_file, method_idx, method));
   dex_deps->methods_.insert(method_tuple);
+  RecordClassDependency(dex_file, dex_deps, GetKey(dex_file, method_tuple));
 }
 
 mirror::Class* VerifierDeps::FindOneClassPathBoundaryForInterface(mirror::Class* destination,
@@ -487,10 +495,59 @@ void VerifierDeps::AddAssignability(const DexFile& dex_file,
   dex::StringIndex destination_id = GetClassDescriptorStringId(dex_file, destination);
   dex::StringIndex source_id = GetClassDescriptorStringId(dex_file, source);
 
+  TypeAssignability entry(destination_id, source_id);
   if (is_assignable) {
-    dex_deps->assignable_types_.emplace(TypeAssignability(destination_id, source_id));
+    dex_deps->assignable_types_.emplace(entry);
   } else {
-    dex_deps->unassignable_types_.emplace(TypeAssignability(destination_id, source_id));
+    dex_deps->unassignable_types_.emplace(entry);
+  }
+  RecordClassDependency(dex_file, dex_deps, GetKey(dex_file, entry));
+}
+
+dex::StringIndex VerifierDeps::GetKey(const DexFile& dex_file, const ClassResolution& entry) {
+  return dex_file.GetTypeId(entry.GetDexTypeIndex()).descriptor_idx_;
+}
+
+dex::StringIndex VerifierDeps::GetKey(const DexFile& dex_file, const FieldResolution& entry) {
+  const DexFile::FieldId& field_id = dex_file.GetFieldId(entry.GetDexFieldIndex());
+  return dex_file.GetTypeId(field_id.class_idx_).descriptor_idx_;
+}
+
+dex::StringIndex VerifierDeps::GetKey(const DexFile& dex_file, const MethodResolution& entry) {
+  const DexFile::MethodId& method_id = dex_file.GetMethodId(entry.GetDexMethodIndex());
+  return dex_file.GetTypeId(method_id.class_idx_).descriptor_idx_;
+}
+
+dex::StringIndex VerifierDeps::GetKey(const DexFile& dex_file ATTRIBUTE_UNUSED,
+                                      const TypeAssignability& entry) {
+  return entry.GetDestination();
+}
+
+void VerifierDeps::RecordClassDependency(const DexFile& dex_file,
+                                         DexFileDeps* dex_deps,
+                                         dex::StringIndex key) {
+  // Record the key even if another class recorded the dependency already, as revalidation
+  // needs all the classes that depend on it.
+  if (recording_dex_file_ == &dex_file) {
+    dex_deps->class_dependencies_[recording_class_].insert(key);
+  }
+}
+
+VerifierDeps::ScopedClassDependencies::ScopedClassDependencies(const DexFile& dex_file,
+                                                               dex::TypeIndex type_idx)
+    : deps_(GetThreadLocalVerifierDeps()),
+      previous_dex_file_(deps_ != nullptr ? deps_->recording_dex_file_ : nullptr),
+      previous_class_(deps_ != nullptr ? deps_->recording_class_ : dex::TypeIndex::Invalid()) {
+  if (deps_ != nullptr) {
+    deps_->recording_dex_file_ = &dex_file;
+    deps_->recording_class_ = type_idx;
+  }
+}
+
+VerifierDeps::ScopedClassDependencies::~ScopedClassDependencies() {
+  if (deps_ != nullptr) {
+    deps_->recording_dex_file_ = previous_dex_file_;
+    deps_->recording_class_ = previous_class_;
   }
 }
 
@@ -594,6 +651,14 @@ static inline void DecodeTuple(const uint8_t** in, const uint8_t* end, dex::Type
   *t = Decode<dex::TypeIndex>(DecodeUint32WithOverflowCheck(in, end));
 }
 
+static inline void EncodeTuple(std::vector<uint8_t>* out, const dex::StringIndex& t) {
+  EncodeUnsignedLeb128(out, Encode(t));
+}
+
+static inline void DecodeTuple(const uint8_t** in, const uint8_t* end, dex::StringIndex* t) {
+  *t = Decode<dex::StringIndex>(DecodeUint32WithOverflowCheck(in, end));
+}
+
 template<typename T1, typename T2>
 static inline void EncodeTuple(std::vector<uint8_t>* out, const std::tuple<T1, T2>& t) {
   EncodeUnsignedLeb128(out, Encode(std::get<0>(t)));
@@ -630,6 +695,15 @@ static inline void EncodeSet(std::vector<uint8_t>* out, const std::set<T>& set)
   }
 }
 
+template<typename K, typename T>
+static inline void EncodeMapOfSets(std::vector<uint8_t>* out, const std::map<K, std::set<T>>& map) {
+  EncodeUnsignedLeb128(out, map.size());
+  for (const auto& entry : map) {
+    EncodeTuple(out, entry.first);
+    EncodeSet(out, entry.second);
+  }
+}
+
 template <typename T>
 static inline void EncodeUint16Vector(std::vector<uint8_t>* out,
                                       const std::vector<T>& vector) {
@@ -650,6 +724,19 @@ static inline void DecodeSet(const uint8_t** in, const uint8_t* end, std::set<T>
   }
 }
 
+template<typename K, typename T>
+static inline void DecodeMapOfSets(const uint8_t** in,
+                                   const uint8_t* end,
+                                   std::map<K, std::set<T>>* map) {
+  DCHECK(map->empty());
+  size_t num_entries = DecodeUint32WithOverflowCheck(in, end);
+  for (size_t i = 0; i < num_entries; ++i) {
+    K key;
+    DecodeTuple(in, end, &key);
+    DecodeSet(in, end, &(*map)[key]);
+  }
+}
+
 template<typename T>
 static inline void DecodeUint16Vector(const uint8_t** in,
                                       const uint8_t* end,
@@ -701,6 +788,7 @@ void VerifierDeps::Encode(const std::vector<const DexFile*>& dex_files,
     EncodeSet(buffer, deps.fields_);
     EncodeSet(buffer, deps.methods_);
     EncodeSet(buffer, deps.unverified_classes_);
+    EncodeMapOfSets(buffer, deps.class_dependencies_);
   }
 }
 
@@ -724,6 +812,7 @@ VerifierDeps::VerifierDeps(const std::vector<const DexFile*>& dex_files,
     DecodeSet(&data_start, data_end, &deps->fields_);
     DecodeSet(&data_start, data_end, &deps->methods_);
     DecodeSet(&data_start, data_end, &deps->unverified_classes_);
+    DecodeMapOfSets(&data_start, data_end, &deps->class_dependencies_);
   }
   CHECK_LE(data_start, data_end);
 }
@@ -761,7 +850,8 @@ bool VerifierDeps::DexFileDeps::Equals(const VerifierDeps::DexFileDeps& rhs) con
          (classes_ == rhs.classes_) &&
          (fields_ == rhs.fields_) &&
          (methods_ == rhs.methods_) &&
-         (unverified_classes_ == rhs.unverified_classes_);
+         (unverified_classes_ == rhs.unverified_classes_) &&
+         (class_dependencies_ == rhs.class_dependencies_);
 }
 
 void VerifierDeps::Dump(VariableIndentationOutputStream* vios) const {
@@ -843,6 +933,16 @@ void VerifierDeps::Dump(VariableIndentationOutputStream* vios) const {
           << dex_file.StringByTypeIdx(type_index)
           << " is expected to be verified at runtime\n";
     }
+
+    for (const auto& entry : dep.second->class_dependencies_) {
+      vios->Stream()
+          << dex_file.StringByTypeIdx(entry.first)
+          << " depends on the resolution of";
+      for (dex::StringIndex key : entry.second) {
+        vios->Stream() << " " << GetStringFromId(dex_file, key);
+      }
+      vios->Stream() << "\n";
+    }
   }
 }
 
@@ -856,6 +956,100 @@ bool VerifierDeps::ValidateDependencies(Handle<mirror::ClassLoader> class_loader
   return true;
 }
 
+template <typename T, typename VerifyFn>
+void VerifierDeps::RemoveInvalidDependencies(const DexFile& dex_file,
+                                             std::set<T>* entries,
+                                             const VerifyFn& verify,
+                                             std::set<dex::StringIndex>* invalid_keys) {
+  for (auto it = entries->begin(); it != entries->end();) {
+    if (verify(std::set<T>({ *it }))) {
+      ++it;
+    } else {
+      invalid_keys->insert(GetKey(dex_file, *it));
+      it = entries->erase(it);
+    }
+  }
+}
+
+bool VerifierDeps::ValidateDependenciesPerClass(Handle<mirror::ClassLoader> class_loader,
+                                                Thread* self,
+                                                ClassesPerDexFile* classes_to_reverify) {
+  for (const auto& entry : dex_deps_) {
+    const DexFile& dex_file = *entry.first;
+    DexFileDeps* deps = entry.second.get();
+    if (VerifyDexFile(class_loader, dex_file, *deps, self)) {
+      continue;
+    }
+
+    // Find the dependencies that no longer hold, one at a time.
+    std::set<dex::StringIndex> invalid_keys;
+    RemoveInvalidDependencies(
+        dex_file,
+        &deps->assignable_types_,
+        [&](const std::set<TypeAssignability>& single) REQUIRES_SHARED(Locks::mutator_lock_) {
+          return VerifyAssignability(
+              class_loader, dex_file, single, /* expected_assignability */ true, self);
+        },
+        &invalid_keys);
+    RemoveInvalidDependencies(
+        dex_file,
+        &deps->unassignable_types_,
+        [&](const std::set<TypeAssignability>& single) REQUIRES_SHARED(Locks::mutator_lock_) {
+          return VerifyAssignability(
+              class_loader, dex_file, single, /* expected_assignability */ false, self);
+        },
+        &invalid_keys);
+    RemoveInvalidDependencies(
+        dex_file,
+        &deps->classes_,
+        [&](const std::set<ClassResolution>& single) REQUIRES_SHARED(Locks::mutator_lock_) {
+          return VerifyClasses(class_loader, dex_file, single, self);
+        },
+        &invalid_keys);
+    RemoveInvalidDependencies(
+        dex_file,
+        &deps->fields_,
+        [&](const std::set<FieldResolution>& single) REQUIRES_SHARED(Locks::mutator_lock_) {
+          return VerifyFields(class_loader, dex_file, single, self);
+        },
+        &invalid_keys);
+    RemoveInvalidDependencies(
+        dex_file,
+        &deps->methods_,
+        [&](const std::set<MethodResolution>& single) REQUIRES_SHARED(Locks::mutator_lock_) {
+          return VerifyMethods(class_loader, dex_file, single, self);
+        },
+        &invalid_keys);
+
+    // Collect the classes that recorded any of them. The keys are per class descriptor, so this
+    // may also pick classes whose own dependencies on that class still hold.
+    std::set<dex::StringIndex> attributed_keys;
+    std::set<dex::TypeIndex>& classes = (*classes_to_reverify)[&dex_file];
+    for (auto it = deps->class_dependencies_.begin(); it != deps->class_dependencies_.end();) {
+      bool depends_on_invalid_key = false;
+      for (dex::StringIndex key : it->second) {
+        if (invalid_keys.find(key) != invalid_keys.end()) {
+          attributed_keys.insert(key);
+          depends_on_invalid_key = true;
+        }
+      }
+      if (depends_on_invalid_key) {
+        classes.insert(it->first);
+        deps->unverified_classes_.erase(it->first);
+        it = deps->class_dependencies_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    if (attributed_keys.size() != invalid_keys.size()) {
+      // Some dependency was recorded outside of the verification of a class, we cannot
+      // tell which classes need to be verified again.
+      return false;
+    }
+  }
+  return true;
+}
+
 // TODO: share that helper with other parts of the compiler that have
 // the same lookup pattern.
 static mirror::Class* FindClassAndClearException(ClassLinker* class_linker,
@@ -57,6 +57,24 @@ namespace verifier {
 // changes in the classpath.
 class VerifierDeps {
  public:
+  // Classes, by the dex file that defines them.
+  using ClassesPerDexFile = std::map<const DexFile*, std::set<dex::TypeIndex>>;
+
+  // Attributes the dependencies that the current thread records while the scope lasts to the
+  // class at `type_idx`, so that they can be revalidated per class.
+  class ScopedClassDependencies {
+   public:
+    ScopedClassDependencies(const DexFile& dex_file, dex::TypeIndex type_idx);
+    ~ScopedClassDependencies();
+
+   private:
+    VerifierDeps* const deps_;
+    const DexFile* const previous_dex_file_;
+    const dex::TypeIndex previous_class_;
+
+    DISALLOW_COPY_AND_ASSIGN(ScopedClassDependencies);
+  };
+
   explicit VerifierDeps(const std::vector<const DexFile*>& dex_files);
 
   VerifierDeps(const std::vector<const DexFile*>& dex_files, ArrayRef<const uint8_t> data);
@@ -117,6 +135,15 @@ class VerifierDeps {
   bool ValidateDependencies(Handle<mirror::ClassLoader> class_loader, Thread* self) const
       REQUIRES_SHARED(Locks::mutator_lock_);
 
+  // Like ValidateDependencies(), but does not fail for dependencies that no longer hold, as long
+  // as the classes that recorded them are known. It drops those dependencies, along with the
+  // unverified status and the dependencies of those classes, and adds the classes to
+  // `classes_to_reverify`. Verifying them again records what their verification depends on now.
+  bool ValidateDependenciesPerClass(Handle<mirror::ClassLoader> class_loader,
+                                    Thread* self,
+                                    ClassesPerDexFile* classes_to_reverify)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
   const std::set<dex::TypeIndex>& GetUnverifiedClasses(const DexFile& dex_file) const {
     return GetDexFileDeps(dex_file)->unverified_classes_;
   }
@@ -199,11 +226,33 @@ class VerifierDeps {
     // List of classes that were not fully verified in that dex file.
     std::set<dex::TypeIndex> unverified_classes_;
 
+    // For each class, the keys of the dependencies above that its verification recorded. The key
+    // of a dependency is the id of the descriptor of the class it is about, see GetKey().
+    std::map<dex::TypeIndex, std::set<dex::StringIndex>> class_dependencies_;
+
     bool Equals(const DexFileDeps& rhs) const;
   };
 
   VerifierDeps(const std::vector<const DexFile*>& dex_files, bool output_only);
 
+  // Returns the key of a dependency, which is what attributes it to classes.
+  static dex::StringIndex GetKey(const DexFile& dex_file, const ClassResolution& entry);
+  static dex::StringIndex GetKey(const DexFile& dex_file, const FieldResolution& entry);
+  static dex::StringIndex GetKey(const DexFile& dex_file, const MethodResolution& entry);
+  static dex::StringIndex GetKey(const DexFile& dex_file, const TypeAssignability& entry);
+
+  // Attributes the dependency with `key` to the class the current thread is verifying, if any.
+  void RecordClassDependency(const DexFile& dex_file, DexFileDeps* dex_deps, dex::StringIndex key);
+
+  // Removes the entries for which `verify` fails on a singleton set, and collects their keys
+  // into `invalid_keys`.
+  template <typename T, typename VerifyFn>
+  static void RemoveInvalidDependencies(const DexFile& dex_file,
+                                        std::set<T>* entries,
+                                        const VerifyFn& verify,
+                                        std::set<dex::StringIndex>* invalid_keys)
+      REQUIRES_SHARED(Locks::mutator_lock_);
+
   // Finds the DexFileDep instance associated with `dex_file`, or nullptr if
   // `dex_file` is not reported as being compiled.
   DexFileDeps* GetDexFileDeps(const DexFile& dex_file);
@@ -330,11 +379,16 @@ class VerifierDeps {
   // Output only signifies if we are using the verifier deps to verify or just to generate them.
   const bool output_only_;
 
+  // The class that the thread owning this `VerifierDeps` is verifying, if any.
+  const DexFile* recording_dex_file_;
+  dex::TypeIndex recording_class_;
+
   friend class VerifierDepsTest;
   ART_FRIEND_TEST(VerifierDepsTest, StringToId);
   ART_FRIEND_TEST(VerifierDepsTest, EncodeDecode);
   ART_FRIEND_TEST(VerifierDepsTest, EncodeDecodeMulti);
   ART_FRIEND_TEST(VerifierDepsTest, VerifyDeps);
+  ART_FRIEND_TEST(VerifierDepsTest, VerifyDepsPerClass);
   ART_FRIEND_TEST(VerifierDepsTest, CompilerDriver);
 };
 
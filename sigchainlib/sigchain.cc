@@ -223,7 +223,7 @@ class SignalChain {
  private:
   bool claimed_;
   struct sigaction action_;
-  SigchainAction special_handlers_[2];
+  SigchainAction special_handlers_[3];
 };
 
 static SignalChain chains[_NSIG];
@@ -232,10 +232,24 @@ void SignalChain::Handler(int signo, siginfo_t* siginfo, void* ucontext_raw) {
   // Try the special handlers first.
   // If one of them crashes, we'll reenter this handler and pass that crash onto the user handler.
   if (!GetHandlingSignal()) {
+    // Fast path handlers run with the mask installed by the kernel, see SIGCHAIN_FAST_PATH.
     for (const auto& handler : chains[signo].special_handlers_) {
       if (handler.sc_sigaction == nullptr) {
         break;
       }
+      if ((handler.sc_flags & SIGCHAIN_FAST_PATH) != 0 &&
+          handler.sc_sigaction(signo, siginfo, ucontext_raw)) {
+        return;
+      }
+    }
+
+    for (const auto& handler : chains[signo].special_handlers_) {
+      if (handler.sc_sigaction == nullptr) {
+        break;
+      }
+      if ((handler.sc_flags & SIGCHAIN_FAST_PATH) != 0) {
+        continue;
+      }
 
       // The native bridge signal handler might not return.
       // Avoid setting the thread local flag in this case, since we'll never
@@ -25,6 +25,12 @@ namespace art {
 // Handlers that exit without returning to their caller (e.g. via siglongjmp) must pass this flag.
 static constexpr uint64_t SIGCHAIN_ALLOW_NORETURN = 0x1UL;
 
+// Handlers passed this flag are tried before all others, directly with the signal mask set up by
+// the kernel (all signals blocked) and without any sigprocmask() call or thread-local bookkeeping.
+// They must cheaply decline signals they do not own, and must not fault, since a nested signal
+// would kill the process instead of reaching the next handler. sc_mask is ignored.
+static constexpr uint64_t SIGCHAIN_FAST_PATH = 0x2UL;
+
 struct SigchainAction {
   bool (*sc_sigaction)(int, siginfo_t*, void*);
   sigset_t sc_mask;
@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "jni.h"
+#include "jvmti.h"
+
+// Test infrastructure
+#include "jvmti_helper.h"
+#include "scoped_local_ref.h"
+#include "test_env.h"
+
+namespace art {
+namespace Test1911MethodEventFilter {
+
+using SetMethodEventFilter = jvmtiError(*)(jvmtiEnv*, jint, const jmethodID*);
+
+static SetMethodEventFilter gSetMethodEventFilterFn = nullptr;
+static std::vector<std::string> gEvents;
+
+static void RecordEvent(jvmtiEnv* jvmti, const char* kind, jmethodID method) {
+  char* name = nullptr;
+  if (jvmti->GetMethodName(method, &name, nullptr, nullptr) != JVMTI_ERROR_NONE) {
+    return;
+  }
+  gEvents.push_back(std::string(kind) + " " + name);
+  jvmti->Deallocate(reinterpret_cast<unsigned char*>(name));
+}
+
+static void JNICALL MethodEntryCB(jvmtiEnv* jvmti, JNIEnv*, jthread, jmethodID method) {
+  RecordEvent(jvmti, "enter", method);
+}
+
+static void JNICALL MethodExitCB(jvmtiEnv* jvmti,
+                                 JNIEnv*,
+                                 jthread,
+                                 jmethodID method,
+                                 jboolean,
+                                 jvalue) {
+  RecordEvent(jvmti, "exit", method);
+}
+
+static bool FindSetMethodEventFilter(JNIEnv* env) {
+  if (gSetMethodEventFilterFn != nullptr) {
+    return true;
+  }
+  jint extension_count;
+  jvmtiExtensionFunctionInfo* extensions;
+  if (JvmtiErrorToException(env,
+                            jvmti_env,
+                            jvmti_env->GetExtensionFunctions(&extension_count, &extensions))) {
+    return false;
+  }
+  for (jint i = 0; i != extension_count; ++i) {
+    if (strcmp("com.android.art.method.set_method_event_filter", extensions[i].id) == 0) {
+      gSetMethodEventFilterFn = reinterpret_cast<SetMethodEventFilter>(extensions[i].func);
+    }
+    jvmti_env->Deallocate(reinterpret_cast<unsigned char*>(extensions[i].id));
+    jvmti_env->Deallocate(reinterpret_cast<unsigned char*>(extensions[i].short_description));
+    for (jint j = 0; j != extensions[i].param_count; ++j) {
+      jvmti_env->Deallocate(reinterpret_cast<unsigned char*>(extensions[i].params[j].name));
+    }
+    jvmti_env->Deallocate(reinterpret_cast<unsigned char*>(extensions[i].params));
+    jvmti_env->Deallocate(reinterpret_cast<unsigned char*>(extensions[i].errors));
+  }
+  jvmti_env->Deallocate(reinterpret_cast<unsigned char*>(extensions));
+  if (gSetMethodEventFilterFn == nullptr) {
+    ScopedLocalRef<jclass> rt_exception(env, env->FindClass("java/lang/RuntimeException"));
+    env->ThrowNew(rt_exception.get(), "Could not find set_method_event_filter extension");
+    return false;
+  }
+  return true;
+}
+
+extern "C" JNIEXPORT void JNICALL Java_art_Test1911_setMethodEventFilter(JNIEnv* env,
+                                                                         jclass,
+                                                                         jobjectArray methods) {
+  if (!FindSetMethodEventFilter(env)) {
+    return;
+  }
+  jsize count = env->GetArrayLength(methods);
+  std::vector<jmethodID> method_ids;
+  for (jsize i = 0; i != count; ++i) {
+    ScopedLocalRef<jobject> method(env, env->GetObjectArrayElement(methods, i));
+    method_ids.push_back(env->FromReflectedMethod(method.get()));
+    if (env->ExceptionCheck()) {
+      return;
+    }
+  }
+  JvmtiErrorToException(env,
+                        jvmti_env,
+                        gSetMethodEventFilterFn(jvmti_env, count, method_ids.data()));
+}
+
+extern "C" JNIEXPORT void JNICALL Java_art_Test1911_enableMethodEvents(JNIEnv* env,
+                                                                       jclass,
+                                                                       jthread thr) {
+  jvmtiEventCallbacks cb;
+  memset(&cb, 0, sizeof(cb));
+  cb.MethodEntry = MethodEntryCB;
+  cb.MethodExit = MethodExitCB;
+  if (JvmtiErrorToException(env, jvmti_env, jvmti_env->SetEventCallbacks(&cb, sizeof(cb)))) {
+    return;
+  }
+  if (JvmtiErrorToException(env,
+                            jvmti_env,
+                            jvmti_env->SetEventNotificationMode(JVMTI_ENABLE,
+                                                                JVMTI_EVENT_METHOD_ENTRY,
+                                                                thr))) {
+    return;
+  }
+  JvmtiErrorToException(env,
+                        jvmti_env,
+                        jvmti_env->SetEventNotificationMode(JVMTI_ENABLE,
+                                                            JVMTI_EVENT_METHOD_EXIT,
+                                                            thr));
+}
+
+extern "C" JNIEXPORT void JNICALL Java_art_Test1911_disableMethodEvents(JNIEnv* env,
+                                                                        jclass,
+                                                                        jthread thr) {
+  if (JvmtiErrorToException(env,
+                            jvmti_env,
+                            jvmti_env->SetEventNotificationMode(JVMTI_DISABLE,
+                                                                JVMTI_EVENT_METHOD_ENTRY,
+                                                                thr))) {
+    return;
+  }
+  JvmtiErrorToException(env,
+                        jvmti_env,
+                        jvmti_env->SetEventNotificationMode(JVMTI_DISABLE,
+                                                            JVMTI_EVENT_METHOD_EXIT,
+                                                            thr));
+}
+
+extern "C" JNIEXPORT jobjectArray JNICALL Java_art_Test1911_getEvents(JNIEnv* env, jclass) {
+  ScopedLocalRef<jclass> string_class(env, env->FindClass("java/lang/String"));
+  if (env->ExceptionCheck()) {
+    return nullptr;
+  }
+  jobjectArray result = env->NewObjectArray(gEvents.size(), string_class.get(), nullptr);
+  if (env->ExceptionCheck()) {
+    return nullptr;
+  }
+  for (size_t i = 0; i != gEvents.size(); ++i) {
+    ScopedLocalRef<jstring> event(env, env->NewStringUTF(gEvents[i].c_str()));
+    if (env->ExceptionCheck()) {
+      return nullptr;
+    }
+    env->SetObjectArrayElement(result, i, event.get());
+  }
+  gEvents.clear();
+  return result;
+}
+
+}  // namespace Test1911MethodEventFilter
+}  // namespace art
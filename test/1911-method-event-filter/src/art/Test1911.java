@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+package art;
+
+import java.lang.reflect.Method;
+
+public class Test1911 {
+  public static void traced() {
+    notTraced(1);
+  }
+
+  public static int notTraced(int value) {
+    return value + 1;
+  }
+
+  public static int tracedThrow(int value) {
+    throw new Error("thrown " + value);
+  }
+
+  public static native void nativeMethod();
+
+  public static void doCalls() {
+    traced();
+    notTraced(2);
+    try {
+      tracedThrow(3);
+    } catch (Error e) {
+      System.out.println("Caught: " + e.getMessage());
+    }
+  }
+
+  public static void printEvents() {
+    for (String event : getEvents()) {
+      System.out.println(event);
+    }
+  }
+
+  public static void run() throws Exception {
+    Method traced = Test1911.class.getDeclaredMethod("traced");
+    Method tracedThrow = Test1911.class.getDeclaredMethod("tracedThrow", Integer.TYPE);
+
+    try {
+      setMethodEventFilter(new Method[] { Test1911.class.getDeclaredMethod("nativeMethod") });
+      System.out.println("Filtering a native method did not fail");
+    } catch (RuntimeException e) {
+      System.out.println("Filtering a native method failed: " + e.getMessage());
+    }
+
+    System.out.println("Filtered");
+    setMethodEventFilter(new Method[] { traced, tracedThrow });
+    enableMethodEvents(Thread.currentThread());
+    doCalls();
+    disableMethodEvents(Thread.currentThread());
+    printEvents();
+
+    System.out.println("Filter changed while enabled");
+    enableMethodEvents(Thread.currentThread());
+    setMethodEventFilter(new Method[] { traced });
+    doCalls();
+    disableMethodEvents(Thread.currentThread());
+    printEvents();
+
+    System.out.println("Disabled");
+    doCalls();
+    printEvents();
+    setMethodEventFilter(new Method[0]);
+  }
+
+  public static native void setMethodEventFilter(Method[] methods);
+  public static native void enableMethodEvents(Thread thr);
+  public static native void disableMethodEvents(Thread thr);
+  public static native String[] getEvents();
+}
@@ -353,6 +353,26 @@ public class Main {
     return sum;
   }
 
+  /// CHECK-START: int Main.test12a(TestClass, TestClass) load_store_elimination (before)
+  /// CHECK: InstanceFieldSet
+  /// CHECK: InstanceFieldGet
+  /// CHECK: InstanceFieldSet
+
+  /// CHECK-START: int Main.test12a(TestClass, TestClass) load_store_elimination (after)
+  /// CHECK: InstanceFieldSet
+  /// CHECK-NOT: InstanceFieldGet
+
+  // Loop with heap writes that cannot alias obj1.i.
+  static int test12a(TestClass obj1, TestClass obj2) {
+    obj1.i = 1;
+    int sum = 0;
+    for (int i = 0; i < 10; i++) {
+      sum += obj1.i;
+      obj2.j = sum;
+    }
+    return sum;
+  }
+
   /// CHECK-START: int Main.test13(TestClass, TestClass2) load_store_elimination (before)
   /// CHECK: InstanceFieldSet
   /// CHECK: InstanceFieldSet
@@ -970,6 +990,7 @@ public class Main {
     assertIntEquals(TestClass.si, 3);
     assertIntEquals(test11(new TestClass()), 10);
     assertIntEquals(test12(new TestClass(), new TestClass()), 10);
+    assertIntEquals(test12a(new TestClass(), new TestClass()), 10);
     assertIntEquals(test13(new TestClass(), new TestClass2()), 3);
     SubTestClass obj3 = new SubTestClass();
     assertIntEquals(test14(obj3, obj3), 2);
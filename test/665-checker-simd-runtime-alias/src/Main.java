@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Tests for vectorization of loops that need runtime disambiguation tests.
+ */
+public class Main {
+
+  // Needs both an x != y and an x != z test.
+  //
+  /// CHECK-START-ARM64: void Main.add(int[], int[], int[]) loop_optimization (after)
+  /// CHECK-DAG: <<Get1:d\d+>> VecLoad                             loop:<<Loop:B\d+>> outer_loop:none
+  /// CHECK-DAG: <<Get2:d\d+>> VecLoad                             loop:<<Loop>>      outer_loop:none
+  /// CHECK-DAG: <<Add:d\d+>>  VecAdd [<<Get1>>,<<Get2>>]          loop:<<Loop>>      outer_loop:none
+  /// CHECK-DAG:               VecStore [{{l\d+}},{{i\d+}},<<Add>>] loop:<<Loop>>     outer_loop:none
+  private static void add(int[] x, int[] y, int[] z) {
+    int n = Math.min(x.length, Math.min(y.length, z.length)) - 1;
+    for (int i = 0; i < n; i++) {
+      x[i] = y[i + 1] + z[i + 1];
+    }
+  }
+
+  // Needs a test that the source and destination ranges do not overlap.
+  //
+  /// CHECK-START-ARM64: void Main.copy(int[], int, int, int) loop_optimization (after)
+  /// CHECK-DAG: <<Get:d\d+>>  VecLoad                             loop:<<Loop:B\d+>> outer_loop:none
+  /// CHECK-DAG:               VecStore [{{l\d+}},{{i\d+}},<<Get>>] loop:<<Loop>>     outer_loop:none
+  private static void copy(int[] a, int src, int dst, int len) {
+    for (int i = 0; i < len; i++) {
+      a[dst + i] = a[src + i];
+    }
+  }
+
+  public static void main(String[] args) {
+    int[] x = new int[100];
+    int[] y = new int[100];
+    for (int i = 0; i < 100; i++) {
+      y[i] = i;
+    }
+    add(x, y, y);
+    for (int i = 0; i < 99; i++) {
+      expectEquals(2 * (i + 1), x[i]);
+    }
+    // Aliased arguments take the sequential path.
+    add(y, y, y);
+    for (int i = 0; i < 99; i++) {
+      expectEquals(2 * (i + 1), y[i]);
+    }
+
+    // Disjoint ranges.
+    int[] a = new int[100];
+    for (int i = 0; i < 100; i++) {
+      a[i] = i;
+    }
+    copy(a, 0, 50, 50);
+    for (int i = 0; i < 50; i++) {
+      expectEquals(i, a[i]);
+      expectEquals(i, a[i + 50]);
+    }
+    // Overlapping ranges must take the sequential path.
+    for (int i = 0; i < 100; i++) {
+      a[i] = i;
+    }
+    copy(a, 0, 1, 99);
+    for (int i = 0; i < 100; i++) {
+      expectEquals(0, a[i]);
+    }
+
+    System.out.println("passed");
+  }
+
+  private static void expectEquals(int expected, int result) {
+    if (expected != result) {
+      throw new Error("Expected: " + expected + ", found: " + result);
+    }
+  }
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * Tests on full unrolling of scalar loops with too few iterations to vectorize.
+ */
+public class Main {
+
+  /// CHECK-START-ARM64: int[] Main.unrollFill(int) loop_optimization (before)
+  /// CHECK-DAG: Phi      loop:<<Loop:B\d+>> outer_loop:none
+  /// CHECK-DAG: ArraySet loop:<<Loop>>      outer_loop:none
+  //
+  /// CHECK-START-ARM64: int[] Main.unrollFill(int) loop_optimization (after)
+  /// CHECK-DAG: <<Par:i\d+>> ParameterValue                      loop:none
+  /// CHECK-DAG: <<One:i\d+>> IntConstant 1                       loop:none
+  /// CHECK-DAG: <<Phi:i\d+>> Phi                                 loop:<<Loop:B\d+>> outer_loop:none
+  /// CHECK-DAG:              ArraySet [{{l\d+}},<<Phi>>,<<Par>>] loop:<<Loop>>      outer_loop:none
+  /// CHECK-DAG: <<Id1:i\d+>> Add [<<Phi>>,<<One>>]               loop:<<Loop>>      outer_loop:none
+  /// CHECK-DAG:              ArraySet [{{l\d+}},<<Id1>>,<<Par>>] loop:<<Loop>>      outer_loop:none
+  /// CHECK-DAG: <<Id2:i\d+>> Add [<<Id1>>,<<One>>]               loop:<<Loop>>      outer_loop:none
+  /// CHECK-DAG:              ArraySet [{{l\d+}},<<Id2>>,<<Par>>] loop:<<Loop>>      outer_loop:none
+  //
+  /// CHECK-START-ARM64: int[] Main.unrollFill(int) loop_optimization (after)
+  /// CHECK-NOT: VecStore
+  static int[] unrollFill(int x) {
+    int[] a = new int[3];
+    for (int i = 0; i < 3; i++) {
+      a[i] = x;
+    }
+    return a;
+  }
+
+  /// CHECK-START-ARM64: char[] Main.unrollAdd(int) loop_optimization (after)
+  /// CHECK-DAG: Phi      loop:<<Loop:B\d+>> outer_loop:none
+  /// CHECK-DAG: ArrayGet loop:<<Loop>>      outer_loop:none
+  /// CHECK-DAG: ArrayGet loop:<<Loop>>      outer_loop:none
+  /// CHECK-DAG: ArrayGet loop:<<Loop>>      outer_loop:none
+  /// CHECK-DAG: ArrayGet loop:<<Loop>>      outer_loop:none
+  /// CHECK-DAG: ArrayGet loop:<<Loop>>      outer_loop:none
+  /// CHECK-DAG: ArraySet loop:<<Loop>>      outer_loop:none
+  /// CHECK-DAG: ArraySet loop:<<Loop>>      outer_loop:none
+  /// CHECK-DAG: ArraySet loop:<<Loop>>      outer_loop:none
+  /// CHECK-DAG: ArraySet loop:<<Loop>>      outer_loop:none
+  /// CHECK-DAG: ArraySet loop:<<Loop>>      outer_loop:none
+  //
+  /// CHECK-START-ARM64: char[] Main.unrollAdd(int) loop_optimization (after)
+  /// CHECK-NOT: VecLoad
+  static char[] unrollAdd(int x) {
+    char[] a = { 'a', 'b', 'c', 'd', 'e' };
+    for (int i = 0; i < 5; i++) {
+      a[i] += x;
+    }
+    return a;
+  }
+
+  public static void main(String[] args) {
+    int[] a = unrollFill(7);
+    for (int i = 0; i < a.length; i++) {
+      expectEquals(7, a[i]);
+    }
+    char[] c = unrollAdd(2);
+    for (int i = 0; i < c.length; i++) {
+      expectEquals('c' + i, c[i]);
+    }
+    System.out.println("passed");
+  }
+
+  private static void expectEquals(int expected, int result) {
+    if (expected != result) {
+      throw new Error("Expected: " + expected + ", found: " + result);
+    }
+  }
+}
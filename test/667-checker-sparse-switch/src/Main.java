@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * Tests on binary search lowering of large sparse switches.
+ */
+public class Main {
+
+  // Twelve keys split into leaves of three keys below three inner nodes.
+  //
+  /// CHECK-START: int Main.sparse(int) builder (after)
+  /// CHECK-DAG: <<Par:i\d+>> ParameterValue
+  /// CHECK-DAG: <<K1:i\d+>>  IntConstant -7
+  /// CHECK-DAG: <<K2:i\d+>>  IntConstant 70
+  /// CHECK-DAG: <<K3:i\d+>>  IntConstant 100000
+  /// CHECK-DAG: <<L1:z\d+>>  LessThan [<<Par>>,<<K2>>]
+  /// CHECK-DAG:              If [<<L1>>]
+  /// CHECK-DAG: <<L2:z\d+>>  LessThan [<<Par>>,<<K1>>]
+  /// CHECK-DAG:              If [<<L2>>]
+  /// CHECK-DAG: <<L3:z\d+>>  LessThan [<<Par>>,<<K3>>]
+  /// CHECK-DAG:              If [<<L3>>]
+  //
+  /// CHECK-START: int Main.sparse(int) builder (after)
+  /// CHECK:     LessThan
+  /// CHECK:     LessThan
+  /// CHECK:     LessThan
+  /// CHECK-NOT: LessThan
+  private static int sparse(int x) {
+    switch (x) {
+      case Integer.MIN_VALUE: return 1;
+      case -100000: return 2;
+      case -1000: return 3;
+      case -7: return 4;
+      case 0: return 5;
+      case 13: return 6;
+      case 70: return 7;
+      case 512: return 8;
+      case 9999: return 9;
+      case 100000: return 10;
+      case 123456789: return 11;
+      case Integer.MAX_VALUE: return 12;
+      default: return 0;
+    }
+  }
+
+  // Several keys with the same target.
+  private static int shared(int x) {
+    switch (x) {
+      case 3: case 30: case 300:
+        return 1;
+      case 5: case 50: case 500: case 5000:
+        return 2;
+      case 7: case 70: case 700:
+        return 3;
+      default:
+        return 4;
+    }
+  }
+
+  public static void main(String[] args) {
+    int[] keys = { Integer.MIN_VALUE, -100000, -1000, -7, 0, 13,
+                   70, 512, 9999, 100000, 123456789, Integer.MAX_VALUE };
+    for (int i = 0; i < keys.length; i++) {
+      expectEquals(i + 1, sparse(keys[i]));
+      if (i < keys.length - 1) {
+        expectEquals(0, sparse(keys[i] + 1));
+      }
+    }
+    expectEquals(0, sparse(Integer.MIN_VALUE + 1));
+    expectEquals(0, sparse(Integer.MAX_VALUE - 1));
+    expectEquals(0, sparse(71));
+    expectEquals(0, sparse(69));
+    expectEquals(1, shared(3));
+    expectEquals(1, shared(300));
+    expectEquals(2, shared(5));
+    expectEquals(2, shared(5000));
+    expectEquals(3, shared(70));
+    expectEquals(4, shared(0));
+    expectEquals(4, shared(6));
+    expectEquals(4, shared(7000));
+    System.out.println("passed");
+  }
+
+  private static void expectEquals(int expected, int result) {
+    if (expected != result) {
+      throw new Error("Expected: " + expected + ", found: " + result);
+    }
+  }
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import java.util.Arrays;
+
+/**
+ * Tests on the Arrays.equals intrinsics, covering lengths around the
+ * vector width so that every tail path is exercised.
+ */
+public class Main {
+
+  /// CHECK-START: boolean Main.equalsByte(byte[], byte[]) intrinsics_recognition (after)
+  /// CHECK-DAG: InvokeStaticOrDirect method_name:java.util.Arrays.equals intrinsic:ArraysEqualsByte
+  static boolean equalsByte(byte[] a, byte[] b) {
+    return Arrays.equals(a, b);
+  }
+
+  /// CHECK-START: boolean Main.equalsChar(char[], char[]) intrinsics_recognition (after)
+  /// CHECK-DAG: InvokeStaticOrDirect method_name:java.util.Arrays.equals intrinsic:ArraysEqualsChar
+  static boolean equalsChar(char[] a, char[] b) {
+    return Arrays.equals(a, b);
+  }
+
+  /// CHECK-START: boolean Main.equalsInt(int[], int[]) intrinsics_recognition (after)
+  /// CHECK-DAG: InvokeStaticOrDirect method_name:java.util.Arrays.equals intrinsic:ArraysEqualsInt
+  static boolean equalsInt(int[] a, int[] b) {
+    return Arrays.equals(a, b);
+  }
+
+  /// CHECK-START: boolean Main.equalsLong(long[], long[]) intrinsics_recognition (after)
+  /// CHECK-DAG: InvokeStaticOrDirect method_name:java.util.Arrays.equals intrinsic:ArraysEqualsLong
+  static boolean equalsLong(long[] a, long[] b) {
+    return Arrays.equals(a, b);
+  }
+
+  public static void main(String[] args) {
+    expectEquals(true, equalsByte(null, null));
+    expectEquals(false, equalsByte(new byte[0], null));
+    expectEquals(false, equalsByte(null, new byte[0]));
+    expectEquals(true, equalsInt(null, null));
+    expectEquals(false, equalsLong(new long[1], null));
+    expectEquals(false, equalsChar(new char[1], new char[2]));
+
+    for (int n = 0; n <= 40; n++) {
+      byte[] b1 = new byte[n];
+      byte[] b2 = new byte[n];
+      char[] c1 = new char[n];
+      char[] c2 = new char[n];
+      int[] i1 = new int[n];
+      int[] i2 = new int[n];
+      long[] l1 = new long[n];
+      long[] l2 = new long[n];
+      for (int i = 0; i < n; i++) {
+        b1[i] = b2[i] = (byte) (i * 7);
+        c1[i] = c2[i] = (char) (i * 1001);
+        i1[i] = i2[i] = i * 100003;
+        l1[i] = l2[i] = i * 10000000019L;
+      }
+      expectEquals(true, equalsByte(b1, b1));
+      expectEquals(true, equalsByte(b1, b2));
+      expectEquals(true, equalsChar(c1, c2));
+      expectEquals(true, equalsInt(i1, i2));
+      expectEquals(true, equalsLong(l1, l2));
+      // A difference at any position, including the last element of every tail.
+      for (int i = 0; i < n; i++) {
+        b2[i]++;
+        c2[i]++;
+        i2[i]++;
+        l2[i] += 1L << 40;
+        expectEquals(false, equalsByte(b1, b2));
+        expectEquals(false, equalsChar(c1, c2));
+        expectEquals(false, equalsInt(i1, i2));
+        expectEquals(false, equalsLong(l1, l2));
+        b2[i]--;
+        c2[i]--;
+        i2[i]--;
+        l2[i] -= 1L << 40;
+      }
+      expectEquals(true, equalsLong(l1, l2));
+    }
+
+    System.out.println("passed");
+  }
+
+  private static void expectEquals(boolean expected, boolean result) {
+    if (expected != result) {
+      throw new Error("Expected: " + expected + ", found: " + result);
+    }
+  }
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import java.util.zip.CRC32;
+
+/**
+ * Compares java.util.zip.CRC32 against a table-driven reference implementation,
+ * for all update paths and a range of offsets and lengths.
+ */
+public class Main {
+
+  private static final int[] TABLE = new int[256];
+
+  static {
+    for (int i = 0; i < 256; i++) {
+      int c = i;
+      for (int k = 0; k < 8; k++) {
+        c = (c & 1) != 0 ? 0xedb88320 ^ (c >>> 1) : c >>> 1;
+      }
+      TABLE[i] = c;
+    }
+  }
+
+  private static int reference(int crc, byte[] b, int off, int len) {
+    int c = ~crc;
+    for (int i = off; i < off + len; i++) {
+      c = TABLE[(c ^ b[i]) & 0xff] ^ (c >>> 8);
+    }
+    return ~c;
+  }
+
+  public static void main(String[] args) {
+    // Known value for "123456789".
+    CRC32 check = new CRC32();
+    check.update("123456789".getBytes());
+    expectEquals(0xcbf43926L, check.getValue());
+
+    byte[] data = new byte[64];
+    for (int i = 0; i < data.length; i++) {
+      data[i] = (byte) (i * 37 + 11);
+    }
+    for (int off = 0; off < 9; off++) {
+      for (int len = 0; off + len <= data.length; len++) {
+        CRC32 crc = new CRC32();
+        crc.update(data, off, len);
+        expectEquals(reference(0, data, off, len) & 0xffffffffL, crc.getValue());
+      }
+    }
+
+    // Single byte updates, only the low eight bits of the argument are used.
+    CRC32 bytewise = new CRC32();
+    for (int i = 0; i < data.length; i++) {
+      bytewise.update(data[i] | 0x5a00);
+    }
+    expectEquals(reference(0, data, 0, data.length) & 0xffffffffL, bytewise.getValue());
+
+    System.out.println("passed");
+  }
+
+  private static void expectEquals(long expected, long result) {
+    if (expected != result) {
+      throw new Error("Expected: " + expected + ", found: " + result);
+    }
+  }
+}
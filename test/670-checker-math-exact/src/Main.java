@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Tests on the Math exact arithmetic intrinsics, on both sides of the
+ * overflow boundary.
+ */
+public class Main {
+
+  /// CHECK-START: int Main.addExact(int, int) intrinsics_recognition (after)
+  /// CHECK-DAG: InvokeStaticOrDirect intrinsic:MathAddExactInt
+  static int addExact(int a, int b) {
+    return Math.addExact(a, b);
+  }
+
+  /// CHECK-START: long Main.addExact(long, long) intrinsics_recognition (after)
+  /// CHECK-DAG: InvokeStaticOrDirect intrinsic:MathAddExactLong
+  static long addExact(long a, long b) {
+    return Math.addExact(a, b);
+  }
+
+  /// CHECK-START: int Main.subtractExact(int, int) intrinsics_recognition (after)
+  /// CHECK-DAG: InvokeStaticOrDirect intrinsic:MathSubtractExactInt
+  static int subtractExact(int a, int b) {
+    return Math.subtractExact(a, b);
+  }
+
+  /// CHECK-START: long Main.subtractExact(long, long) intrinsics_recognition (after)
+  /// CHECK-DAG: InvokeStaticOrDirect intrinsic:MathSubtractExactLong
+  static long subtractExact(long a, long b) {
+    return Math.subtractExact(a, b);
+  }
+
+  /// CHECK-START: int Main.multiplyExact(int, int) intrinsics_recognition (after)
+  /// CHECK-DAG: InvokeStaticOrDirect intrinsic:MathMultiplyExactInt
+  static int multiplyExact(int a, int b) {
+    return Math.multiplyExact(a, b);
+  }
+
+  /// CHECK-START: long Main.multiplyExact(long, long) intrinsics_recognition (after)
+  /// CHECK-DAG: InvokeStaticOrDirect intrinsic:MathMultiplyExactLong
+  static long multiplyExact(long a, long b) {
+    return Math.multiplyExact(a, b);
+  }
+
+  /// CHECK-START: int Main.negateExact(int) intrinsics_recognition (after)
+  /// CHECK-DAG: InvokeStaticOrDirect intrinsic:MathNegateExactInt
+  static int negateExact(int a) {
+    return Math.negateExact(a);
+  }
+
+  /// CHECK-START: long Main.negateExact(long) intrinsics_recognition (after)
+  /// CHECK-DAG: InvokeStaticOrDirect intrinsic:MathNegateExactLong
+  static long negateExact(long a) {
+    return Math.negateExact(a);
+  }
+
+  public static void main(String[] args) {
+    expectEquals(Integer.MAX_VALUE, addExact(Integer.MAX_VALUE - 1, 1));
+    expectEquals(Long.MIN_VALUE, addExact(Long.MIN_VALUE + 1, -1L));
+    expectEquals(Integer.MIN_VALUE, subtractExact(Integer.MIN_VALUE + 1, 1));
+    expectEquals(Long.MAX_VALUE, subtractExact(Long.MAX_VALUE - 1, -1L));
+    expectEquals(-2147385345, multiplyExact(-65535, 32767));
+    expectEquals(Integer.MIN_VALUE, multiplyExact(-65536, 32768));
+    expectEquals(Long.MIN_VALUE, multiplyExact(-4294967296L, 2147483648L));
+    expectEquals(-6L, multiplyExact(-2L, 3L));
+    expectEquals(-Integer.MAX_VALUE, negateExact(Integer.MAX_VALUE));
+    expectEquals(-Long.MAX_VALUE, negateExact(Long.MAX_VALUE));
+
+    int overflows = 0;
+    try {
+      addExact(Integer.MAX_VALUE, 1);
+    } catch (ArithmeticException e) {
+      overflows++;
+    }
+    try {
+      addExact(Long.MIN_VALUE, -1L);
+    } catch (ArithmeticException e) {
+      overflows++;
+    }
+    try {
+      subtractExact(Integer.MIN_VALUE, 1);
+    } catch (ArithmeticException e) {
+      overflows++;
+    }
+    try {
+      subtractExact(Long.MAX_VALUE, -1L);
+    } catch (ArithmeticException e) {
+      overflows++;
+    }
+    try {
+      multiplyExact(65536, 32768);
+    } catch (ArithmeticException e) {
+      overflows++;
+    }
+    try {
+      multiplyExact(4294967296L, 2147483648L);
+    } catch (ArithmeticException e) {
+      overflows++;
+    }
+    try {
+      negateExact(Integer.MIN_VALUE);
+    } catch (ArithmeticException e) {
+      overflows++;
+    }
+    try {
+      negateExact(Long.MIN_VALUE);
+    } catch (ArithmeticException e) {
+      overflows++;
+    }
+    expectEquals(8, overflows);
+
+    System.out.println("passed");
+  }
+
+  private static void expectEquals(int expected, int result) {
+    if (expected != result) {
+      throw new Error("Expected: " + expected + ", found: " + result);
+    }
+  }
+
+  private static void expectEquals(long expected, long result) {
+    if (expected != result) {
+      throw new Error("Expected: " + expected + ", found: " + result);
+    }
+  }
+}
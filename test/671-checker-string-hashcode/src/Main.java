@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * Tests on the String.hashCode intrinsic, for compressed and uncompressed
+ * strings of lengths around the unrolling factor.
+ */
+public class Main {
+
+  /// CHECK-START: int Main.hash(java.lang.String) intrinsics_recognition (after)
+  /// CHECK-DAG: InvokeVirtual intrinsic:StringHashCode
+  static int hash(String s) {
+    return s.hashCode();
+  }
+
+  private static int reference(String s) {
+    int h = 0;
+    for (int i = 0; i < s.length(); i++) {
+      h = 31 * h + s.charAt(i);
+    }
+    return h;
+  }
+
+  public static void main(String[] args) {
+    expectEquals(0, hash(""));
+    expectEquals(97, hash("a"));
+    expectEquals(-1783698813, hash("foobarbaz1"));
+
+    StringBuilder ascii = new StringBuilder();
+    StringBuilder wide = new StringBuilder();
+    for (int n = 0; n < 40; n++) {
+      // Build fresh strings, so the hash code is not cached yet.
+      String a = new String(ascii.toString().toCharArray());
+      String w = new String(wide.toString().toCharArray());
+      expectEquals(reference(a), hash(a));
+      // Cached now.
+      expectEquals(reference(a), hash(a));
+      expectEquals(reference(w), hash(w));
+      expectEquals(reference(w), hash(w));
+      ascii.append((char) ('!' + (n * 7) % 90));
+      wide.append((char) (0x100 + n * 1234));
+    }
+
+    System.out.println("passed");
+  }
+
+  private static void expectEquals(int expected, int result) {
+    if (expected != result) {
+      throw new Error("Expected: " + expected + ", found: " + result);
+    }
+  }
+}
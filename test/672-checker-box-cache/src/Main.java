@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * Tests on the Long, Short, Character and Byte valueOf intrinsics, which return
+ * the cached boxes, and on the simplification of unboxing a fresh box.
+ */
+public class Main {
+
+  /// CHECK-START: java.lang.Long Main.boxLong(long) intrinsics_recognition (after)
+  /// CHECK-DAG: InvokeStaticOrDirect intrinsic:LongValueOf
+  static Long boxLong(long value) {
+    return Long.valueOf(value);
+  }
+
+  /// CHECK-START: java.lang.Short Main.boxShort(short) intrinsics_recognition (after)
+  /// CHECK-DAG: InvokeStaticOrDirect intrinsic:ShortValueOf
+  static Short boxShort(short value) {
+    return Short.valueOf(value);
+  }
+
+  /// CHECK-START: java.lang.Character Main.boxChar(char) intrinsics_recognition (after)
+  /// CHECK-DAG: InvokeStaticOrDirect intrinsic:CharacterValueOf
+  static Character boxChar(char value) {
+    return Character.valueOf(value);
+  }
+
+  /// CHECK-START: java.lang.Byte Main.boxByte(byte) intrinsics_recognition (after)
+  /// CHECK-DAG: InvokeStaticOrDirect intrinsic:ByteValueOf
+  static Byte boxByte(byte value) {
+    return Byte.valueOf(value);
+  }
+
+  /// CHECK-START: int Main.roundTripInt(int) instruction_simplifier$after_inlining (before)
+  /// CHECK-DAG:              InvokeStaticOrDirect intrinsic:IntegerValueOf
+  /// CHECK-DAG:              InstanceFieldGet
+  //
+  /// CHECK-START: int Main.roundTripInt(int) instruction_simplifier$after_inlining (after)
+  /// CHECK-DAG: <<Arg:i\d+>> ParameterValue
+  /// CHECK-DAG:              Return [<<Arg>>]
+  //
+  /// CHECK-START: int Main.roundTripInt(int) instruction_simplifier$after_inlining (after)
+  /// CHECK-NOT:              InstanceFieldGet
+  //
+  /// CHECK-START: int Main.roundTripInt(int) dead_code_elimination$after_inlining (after)
+  /// CHECK-NOT:              InvokeStaticOrDirect
+  static int roundTripInt(int value) {
+    Integer box = value;
+    return box;
+  }
+
+  /// CHECK-START: long Main.roundTripLong(long) instruction_simplifier$after_inlining (after)
+  /// CHECK-NOT:              InstanceFieldGet
+  static long roundTripLong(long value) {
+    Long box = value;
+    return box;
+  }
+
+  /// CHECK-START: char Main.roundTripChar(char) instruction_simplifier$after_inlining (after)
+  /// CHECK-NOT:              InstanceFieldGet
+  static char roundTripChar(char value) {
+    Character box = value;
+    return box;
+  }
+
+  static long sumLongs(long from, long to) {
+    long sum = 0;
+    for (long i = from; i <= to; i++) {
+      Long box = boxLong(i);
+      sum += box.longValue();
+    }
+    return sum;
+  }
+
+  public static void main(String[] args) {
+    // The cached boxes are shared, the others are fresh.
+    for (long i = -128; i <= 127; i++) {
+      expectTrue(boxLong(i) == boxLong(i));
+      expectTrue(boxShort((short) i) == boxShort((short) i));
+      expectTrue(boxByte((byte) i) == boxByte((byte) i));
+      expectEquals(i, boxLong(i).longValue());
+      expectEquals(i, boxShort((short) i).shortValue());
+      expectEquals(i, boxByte((byte) i).byteValue());
+    }
+    for (char c = 0; c <= 127; c++) {
+      expectTrue(boxChar(c) == boxChar(c));
+      expectEquals(c, boxChar(c).charValue());
+    }
+    long[] uncachedLongs = { -129L, 128L, 1L << 32, -(1L << 40), Long.MIN_VALUE, Long.MAX_VALUE };
+    for (long i : uncachedLongs) {
+      expectTrue(boxLong(i) != boxLong(i));
+      expectEquals(i, boxLong(i).longValue());
+    }
+    short[] uncachedShorts = { -129, 128, Short.MIN_VALUE, Short.MAX_VALUE };
+    for (short s : uncachedShorts) {
+      expectTrue(boxShort(s) != boxShort(s));
+      expectEquals(s, boxShort(s).shortValue());
+    }
+    char[] uncachedChars = { 128, 0x1234, Character.MAX_VALUE };
+    for (char c : uncachedChars) {
+      expectTrue(boxChar(c) != boxChar(c));
+      expectEquals(c, boxChar(c).charValue());
+    }
+    // Constant inputs, inside and outside of the caches.
+    expectTrue(Long.valueOf(42L) == Long.valueOf(42L));
+    expectEquals(1L << 33, Long.valueOf(1L << 33).longValue());
+    expectEquals(-1000, Short.valueOf((short) -1000).shortValue());
+    expectEquals(0xffff, Character.valueOf((char) 0xffff).charValue());
+
+    expectEquals(-1, roundTripInt(-1));
+    expectEquals(Long.MIN_VALUE, roundTripLong(Long.MIN_VALUE));
+    expectEquals(0xabcd, roundTripChar((char) 0xabcd));
+    expectEquals(0L, sumLongs(-1000, 1000));
+
+    System.out.println("passed");
+  }
+
+  private static void expectTrue(boolean value) {
+    if (!value) {
+      throw new Error("Expected true");
+    }
+  }
+
+  private static void expectEquals(long expected, long result) {
+    if (expected != result) {
+      throw new Error("Expected: " + expected + ", found: " + result);
+    }
+  }
+}
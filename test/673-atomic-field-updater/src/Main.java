@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+import java.util.concurrent.atomic.AtomicIntegerFieldUpdater;
+import java.util.concurrent.atomic.AtomicLongFieldUpdater;
+
+/**
+ * Concurrent updates through the atomic field updaters must not lose any
+ * increment, and getAndSet must hand out every value exactly once.
+ */
+public class Main {
+  private static final AtomicIntegerFieldUpdater<Main> INT_UPDATER =
+      AtomicIntegerFieldUpdater.newUpdater(Main.class, "intCounter");
+  private static final AtomicLongFieldUpdater<Main> LONG_UPDATER =
+      AtomicLongFieldUpdater.newUpdater(Main.class, "longCounter");
+  private static final AtomicIntegerFieldUpdater<Main> TOKEN_UPDATER =
+      AtomicIntegerFieldUpdater.newUpdater(Main.class, "token");
+
+  private static final int THREADS = 4;
+  private static final int ITERATIONS = 100000;
+
+  private volatile int intCounter;
+  private volatile long longCounter;
+  private volatile int token = -1;
+
+  public static void main(String[] args) throws Exception {
+    final Main main = new Main();
+    final int[][] received = new int[THREADS][ITERATIONS];
+    Thread[] threads = new Thread[THREADS];
+    for (int t = 0; t < THREADS; t++) {
+      final int id = t;
+      threads[t] = new Thread() {
+        public void run() {
+          for (int i = 0; i < ITERATIONS; i++) {
+            INT_UPDATER.getAndIncrement(main);
+            // Wider than 32 bits, to catch a truncated 64-bit add.
+            LONG_UPDATER.getAndAdd(main, 1L << 33);
+            // Hand in a unique token, take out whatever was there.
+            received[id][i] = TOKEN_UPDATER.getAndSet(main, id * ITERATIONS + i);
+          }
+        }
+      };
+      threads[t].start();
+    }
+    for (Thread thread : threads) {
+      thread.join();
+    }
+    expectEquals(THREADS * ITERATIONS, main.intCounter);
+    expectEquals((long) THREADS * ITERATIONS << 33, main.longCounter);
+    // Every token but the last one handed in was taken out exactly once, along with the
+    // initial one.
+    int[] seen = new int[THREADS * ITERATIONS + 1];
+    seen[main.token + 1]++;
+    for (int[] tokens : received) {
+      for (int t : tokens) {
+        seen[t + 1]++;
+      }
+    }
+    for (int count : seen) {
+      expectEquals(1, count);
+    }
+
+    // Single threaded semantics.
+    main.intCounter = 5;
+    expectEquals(5, INT_UPDATER.getAndAdd(main, -7));
+    expectEquals(-2, INT_UPDATER.getAndSet(main, Integer.MAX_VALUE));
+    expectEquals(Integer.MAX_VALUE, INT_UPDATER.getAndIncrement(main));
+    expectEquals(Integer.MIN_VALUE, main.intCounter);
+    main.longCounter = Long.MAX_VALUE;
+    expectEquals(Long.MAX_VALUE, LONG_UPDATER.getAndIncrement(main));
+    expectEquals(Long.MIN_VALUE, LONG_UPDATER.getAndSet(main, 42L));
+    expectEquals(42L, LONG_UPDATER.getAndAdd(main, 1L << 40));
+    expectEquals(42L + (1L << 40), main.longCounter);
+
+    System.out.println("passed");
+  }
+
+  private static void expectEquals(long expected, long result) {
+    if (expected != result) {
+      throw new Error("Expected: " + expected + ", found: " + result);
+    }
+  }
+}
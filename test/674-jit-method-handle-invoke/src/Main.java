@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import java.lang.invoke.MethodHandle;
+import java.lang.invoke.MethodHandles;
+import java.lang.invoke.MethodType;
+
+class Base {
+  int field;
+
+  int get(int value) {
+    return value + 1;
+  }
+
+  private int secret() {
+    return field * 2;
+  }
+
+  static final MethodHandle SECRET;
+
+  static {
+    try {
+      SECRET = MethodHandles.lookup().findSpecial(
+          Base.class, "secret", MethodType.methodType(int.class), Base.class);
+    } catch (Exception e) {
+      throw new Error(e);
+    }
+  }
+}
+
+class Derived extends Base {
+  @Override
+  int get(int value) {
+    return value + 2;
+  }
+}
+
+public class Main {
+  static final MethodHandle ADD;
+  static final MethodHandle GET;
+  static final MethodHandle GETTER;
+  static final MethodHandle SETTER;
+  static final MethodHandle ADAPTED;
+
+  static {
+    try {
+      MethodHandles.Lookup lookup = MethodHandles.lookup();
+      ADD = lookup.findStatic(
+          Main.class, "add", MethodType.methodType(long.class, long.class, long.class));
+      GET = lookup.findVirtual(Base.class, "get", MethodType.methodType(int.class, int.class));
+      GETTER = lookup.findGetter(Base.class, "field", int.class);
+      SETTER = lookup.findSetter(Base.class, "field", int.class);
+      ADAPTED = ADD.asType(MethodType.methodType(long.class, int.class, int.class));
+    } catch (Exception e) {
+      throw new Error(e);
+    }
+  }
+
+  static long add(long a, long b) {
+    return a + b;
+  }
+
+  static long $noinline$invokeExactStatic(long a, long b) throws Throwable {
+    return (long) ADD.invokeExact(a, b);
+  }
+
+  static long $noinline$invokeWidening(int a, int b) throws Throwable {
+    // The arguments are widened to long.
+    return (long) ADD.invoke(a, b);
+  }
+
+  static long $noinline$invokeAdapted(int a, int b) throws Throwable {
+    return (long) ADAPTED.invokeExact(a, b);
+  }
+
+  static int $noinline$invokeVirtual(Base base, int value) throws Throwable {
+    return (int) GET.invokeExact(base, value);
+  }
+
+  static Object $noinline$invokeVirtualBoxed(Base base, int value) throws Throwable {
+    // Boxing the result is left to the runtime.
+    return GET.invoke(base, value);
+  }
+
+  static int $noinline$invokeDirect(Base base) throws Throwable {
+    return (int) Base.SECRET.invokeExact(base);
+  }
+
+  static int $noinline$getAndSet(Base base, int value) throws Throwable {
+    int old = (int) GETTER.invokeExact(base);
+    SETTER.invokeExact(base, value);
+    return old;
+  }
+
+  static void expectEquals(long expected, long actual) {
+    if (expected != actual) {
+      throw new Error("Expected " + expected + ", got " + actual);
+    }
+  }
+
+  static void test(Base base, Derived derived, int i) throws Throwable {
+    expectEquals(i + 3L, $noinline$invokeExactStatic(i, 3L));
+    expectEquals(i + (1L << 40), $noinline$invokeExactStatic(i, 1L << 40));
+    expectEquals(i + 4L, $noinline$invokeWidening(i, 4));
+    expectEquals(i + 5L, $noinline$invokeAdapted(i, 5));
+    expectEquals(i + 1, $noinline$invokeVirtual(base, i));
+    expectEquals(i + 2, $noinline$invokeVirtual(derived, i));
+    expectEquals(i + 2, (Integer) $noinline$invokeVirtualBoxed(derived, i));
+    base.field = i;
+    expectEquals(2 * i, $noinline$invokeDirect(base));
+    expectEquals(i, $noinline$getAndSet(base, i + 1));
+    expectEquals(i + 1, base.field);
+  }
+
+  public static void main(String[] args) throws Throwable {
+    System.loadLibrary(args[0]);
+    Base base = new Base();
+    Derived derived = new Derived();
+    for (int i = 0; i < 10000; ++i) {
+      test(base, derived, i);
+    }
+    ensureJitCompiled(Main.class, "test");
+    test(base, derived, 42);
+
+    try {
+      $noinline$invokeVirtual(null, 0);
+      throw new Error("Expected NullPointerException");
+    } catch (NullPointerException expected) {
+    }
+    try {
+      $noinline$getAndSet(null, 0);
+      throw new Error("Expected NullPointerException");
+    } catch (NullPointerException expected) {
+    }
+    System.out.println("passed");
+  }
+
+  private static native void ensureJitCompiled(Class<?> cls, String methodName);
+}
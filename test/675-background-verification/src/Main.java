@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+class Good {
+  static int value = 42;
+
+  int get() {
+    return value;
+  }
+}
+
+class Subclass extends Good {
+  @Override
+  int get() {
+    return super.get() + 1;
+  }
+}
+
+public class Main {
+  public static final String staticFinalField = null;
+
+  public static void main(String[] args) throws Exception {
+    ClassLoader loader = Main.class.getClassLoader();
+    // Define the classes without initializing them, so that the verification threads get to
+    // verify them before, or while, they are first used.
+    Class<?> good = Class.forName("Good", false, loader);
+    Class<?> subclass = Class.forName("Subclass", false, loader);
+    Class<?> bad = Class.forName("Bad", false, loader);
+    Thread.sleep(100);
+
+    if (((Good) good.newInstance()).get() == 42) {
+      System.out.println("passed Good");
+    }
+    if (((Good) subclass.newInstance()).get() == 43) {
+      System.out.println("passed Subclass");
+    }
+    // The verification failure must still be reported to the thread using the class.
+    for (int i = 0; i < 2; ++i) {
+      try {
+        bad.newInstance();
+        throw new Error("Expected LinkageError");
+      } catch (LinkageError expected) {
+      }
+    }
+    System.out.println("passed Bad");
+  }
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+public class Main {
+  static void expectEquals(long expected, long actual) {
+    if (expected != actual) {
+      throw new Error("Expected " + expected + ", got " + actual);
+    }
+  }
+
+  static void expectEquals(double expected, double actual) {
+    // Compare the bits, to tell -0.0 from 0.0 and check NaNs.
+    expectEquals(Double.doubleToRawLongBits(expected), Double.doubleToRawLongBits(actual));
+  }
+
+  static void expectTrue(boolean value) {
+    if (!value) {
+      throw new Error("Expected true");
+    }
+  }
+
+  static void testBoxing() {
+    for (int i = -128; i <= 127; ++i) {
+      expectTrue(Integer.valueOf(i) == Integer.valueOf(i));
+      expectTrue(Long.valueOf(i) == Long.valueOf(i));
+      expectTrue(Short.valueOf((short) i) == Short.valueOf((short) i));
+      expectTrue(Byte.valueOf((byte) i) == Byte.valueOf((byte) i));
+      expectEquals(i, Integer.valueOf(i).intValue());
+      expectEquals(i, Long.valueOf(i).longValue());
+    }
+    for (char c = 0; c <= 127; ++c) {
+      expectTrue(Character.valueOf(c) == Character.valueOf(c));
+    }
+    // Values outside of the caches get new boxes.
+    int[] values = { Integer.MIN_VALUE, -129, 128, 1000, Integer.MAX_VALUE };
+    for (int value : values) {
+      Integer box = Integer.valueOf(value);
+      expectTrue(box != Integer.valueOf(value));
+      expectEquals(value, box.intValue());
+      expectTrue(box.equals(Integer.valueOf(value)));
+    }
+    Long big = Long.valueOf(Long.MIN_VALUE);
+    expectEquals(Long.MIN_VALUE, big.longValue());
+    expectEquals(-129, Short.valueOf((short) -129).shortValue());
+    expectEquals(0xffff, Character.valueOf((char) 0xffff).charValue());
+    expectTrue(Character.valueOf((char) 128) != Character.valueOf((char) 128));
+  }
+
+  static void testMath() {
+    expectEquals(-0.0, Math.min(0.0, -0.0));
+    expectEquals(-0.0, Math.min(-0.0, 0.0));
+    expectEquals(0.0, Math.max(0.0, -0.0));
+    expectEquals(0.0, Math.max(-0.0, 0.0));
+    expectTrue(Double.isNaN(Math.min(1.0, Double.NaN)));
+    expectTrue(Double.isNaN(Math.max(Double.NaN, 1.0)));
+    expectTrue(Float.isNaN(Math.min(Float.NaN, 1.0f)));
+    expectEquals(1.0f, Math.min(1.0f, 2.0f));
+    expectEquals(2.0f, Math.max(1.0f, 2.0f));
+    expectEquals(2.0, Math.rint(2.5));
+    expectEquals(4.0, Math.rint(3.5));
+    expectEquals(3.0, Math.cbrt(27.0));
+    expectEquals(5.0, Math.hypot(3.0, 4.0));
+
+    expectEquals(0x7fc00000, Float.floatToIntBits(Float.intBitsToFloat(0x7fc00001)));
+    expectEquals(0x7fc00001, Float.floatToRawIntBits(Float.intBitsToFloat(0x7fc00001)));
+    expectEquals(0x7ff8000000000000L,
+                 Double.doubleToLongBits(Double.longBitsToDouble(0x7ff8000000000001L)));
+    expectTrue(Double.isInfinite(Double.NEGATIVE_INFINITY));
+    expectTrue(!Float.isInfinite(Float.NaN));
+
+    expectEquals(3, Math.addExact(1, 2));
+    expectEquals(-1L, Math.subtractExact(1L, 2L));
+    expectEquals(Integer.MAX_VALUE, Math.negateExact(-Integer.MAX_VALUE));
+    try {
+      Math.addExact(Integer.MAX_VALUE, 1);
+      throw new Error("Expected ArithmeticException");
+    } catch (ArithmeticException expected) {
+    }
+    try {
+      Math.multiplyExact(Long.MAX_VALUE, 2L);
+      throw new Error("Expected ArithmeticException");
+    } catch (ArithmeticException expected) {
+    }
+    try {
+      Math.negateExact(Integer.MIN_VALUE);
+      throw new Error("Expected ArithmeticException");
+    } catch (ArithmeticException expected) {
+    }
+  }
+
+  static void testString() {
+    String s = "interpreter" + System.currentTimeMillis();
+    int hash = 0;
+    for (int i = 0; i < s.length(); ++i) {
+      hash = 31 * hash + s.charAt(i);
+    }
+    expectEquals(hash, s.hashCode());
+    expectEquals(hash, s.hashCode());
+    expectEquals(0, "".hashCode());
+  }
+
+  public static void main(String[] args) {
+    testBoxing();
+    testMath();
+    testString();
+    System.out.println("passed");
+  }
+}
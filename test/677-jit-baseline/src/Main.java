@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+interface Shape {
+  int area();
+}
+
+class Square implements Shape {
+  final int side;
+
+  Square(int side) {
+    this.side = side;
+  }
+
+  public int area() {
+    return side * side;
+  }
+}
+
+class Rectangle implements Shape {
+  final int width;
+  final int height;
+
+  Rectangle(int width, int height) {
+    this.width = width;
+    this.height = height;
+  }
+
+  public int area() {
+    return width * height;
+  }
+}
+
+public class Main {
+  static int $noinline$sumAreas(Shape[] shapes) {
+    int sum = 0;
+    for (Shape shape : shapes) {
+      sum += shape.area();
+    }
+    return sum;
+  }
+
+  static long $noinline$mix(long value, int rounds) {
+    for (int i = 0; i < rounds; ++i) {
+      value ^= value << 13;
+      value ^= value >>> 7;
+      value ^= value << 17;
+    }
+    return value;
+  }
+
+  static long mixReference(long value, int rounds) {
+    long result = value;
+    int i = 0;
+    while (i < rounds) {
+      result = result ^ (result << 13);
+      result = result ^ (result >>> 7);
+      result = result ^ (result << 17);
+      i = i + 1;
+    }
+    return result;
+  }
+
+  static void expectEquals(long expected, long actual) {
+    if (expected != actual) {
+      throw new Error("Expected " + expected + ", got " + actual);
+    }
+  }
+
+  static void test(Shape[] shapes, int i) {
+    int expected = 0;
+    for (int j = 0; j < shapes.length; ++j) {
+      expected += (j % 2 == 0) ? (i + j) * (i + j) : (i + j) * 3;
+    }
+    expectEquals(expected, $noinline$sumAreas(shapes));
+    expectEquals(mixReference(i, i % 17), $noinline$mix(i, i % 17));
+  }
+
+  public static void main(String[] args) {
+    System.loadLibrary(args[0]);
+    Shape[] shapes = new Shape[4];
+    // Run long enough for the baseline code to be replaced by optimized code.
+    for (int i = 0; i < 100000; ++i) {
+      for (int j = 0; j < shapes.length; ++j) {
+        shapes[j] = (j % 2 == 0) ? new Square(i + j) : new Rectangle(i + j, 3);
+      }
+      test(shapes, i);
+    }
+    ensureJitCompiled(Main.class, "$noinline$sumAreas");
+    ensureJitCompiled(Main.class, "$noinline$mix");
+    test(shapes, 99999);
+    System.out.println("passed");
+  }
+
+  private static native void ensureJitCompiled(Class<?> cls, String methodName);
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+import java.io.File;
+import java.io.FileInputStream;
+import java.lang.reflect.Method;
+
+public class Main {
+  static Object[] retained;
+
+  public static void main(String[] args) throws Exception {
+    Method dumpHprofData;
+    try {
+      dumpHprofData = Class.forName("dalvik.system.VMDebug").getMethod(
+          "dumpHprofData", String.class);
+    } catch (ClassNotFoundException e) {
+      // Not running on ART.
+      System.out.println("passed");
+      return;
+    }
+    retained = new Object[1000];
+    for (int i = 0; i < retained.length; ++i) {
+      retained[i] = new int[i];
+    }
+
+    File dump = File.createTempFile("test-678-hprof-fork", "dump");
+    try {
+      dumpHprofData.invoke(null, dump.getAbsolutePath());
+      byte[] header = new byte[18];
+      try (FileInputStream in = new FileInputStream(dump)) {
+        if (in.read(header) != header.length) {
+          throw new Error("Truncated dump");
+        }
+      }
+      String magic = new String(header, "US-ASCII");
+      if (!magic.equals("JAVA PROFILE 1.0.3")) {
+        throw new Error("Unexpected header " + magic);
+      }
+      // The dump holds at least the retained arrays.
+      long minimumSize = 0;
+      for (int i = 0; i < retained.length; ++i) {
+        minimumSize += 4 * i;
+      }
+      if (dump.length() < minimumSize) {
+        throw new Error("Dump too small: " + dump.length());
+      }
+    } finally {
+      dump.delete();
+    }
+
+    // The threads of this process resumed after the fork.
+    Thread thread = new Thread(() -> { retained = null; });
+    thread.start();
+    thread.join();
+    if (retained != null) {
+      throw new Error("Thread did not run");
+    }
+    System.out.println("passed");
+  }
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+public class Main {
+
+  static class Ints {
+    int i1;
+    int i2;
+  }
+
+  static class Longs {
+    long l1;
+    long l2;
+  }
+
+  static class Doubles {
+    double d1;
+    double d2;
+  }
+
+  static class Volatiles {
+    volatile int v1;
+    volatile int v2;
+  }
+
+  /// CHECK-START-ARM64: int Main.$noinline$sumInts(Main$Ints) disassembly (after)
+  /// CHECK:             InstanceFieldGet
+  /// CHECK-NEXT:        ldp w{{[0-9]+}}, w{{[0-9]+}}, [x{{[0-9]+}}, #{{[0-9]+}}]
+
+  public static int $noinline$sumInts(Ints ints) {
+    return ints.i1 + ints.i2;
+  }
+
+  /// CHECK-START-ARM64: void Main.$noinline$setLongs(Main$Longs, long, long) disassembly (after)
+  /// CHECK:             InstanceFieldSet
+  /// CHECK-NEXT:        stp x{{[0-9]+}}, x{{[0-9]+}}, [x{{[0-9]+}}, #{{[0-9]+}}]
+
+  public static void $noinline$setLongs(Longs longs, long a, long b) {
+    longs.l1 = a;
+    longs.l2 = b;
+  }
+
+  /// CHECK-START-ARM64: double Main.$noinline$sumDoubles(Main$Doubles) disassembly (after)
+  /// CHECK:             InstanceFieldGet
+  /// CHECK-NEXT:        ldp d{{[0-9]+}}, d{{[0-9]+}}, [x{{[0-9]+}}, #{{[0-9]+}}]
+
+  public static double $noinline$sumDoubles(Doubles doubles) {
+    return doubles.d1 + doubles.d2;
+  }
+
+  /// CHECK-START-ARM64: void Main.$noinline$clearInts(Main$Ints) disassembly (after)
+  /// CHECK:             InstanceFieldSet
+  /// CHECK-NEXT:        stp wzr, wzr, [x{{[0-9]+}}, #{{[0-9]+}}]
+
+  public static void $noinline$clearInts(Ints ints) {
+    ints.i1 = 0;
+    ints.i2 = 0;
+  }
+
+  // Volatile accesses are never paired.
+
+  /// CHECK-START-ARM64: int Main.$noinline$sumVolatiles(Main$Volatiles) disassembly (after)
+  /// CHECK-NOT:         ldp
+
+  public static int $noinline$sumVolatiles(Volatiles volatiles) {
+    return volatiles.v1 + volatiles.v2;
+  }
+
+  public static void main(String[] args) {
+    Ints ints = new Ints();
+    ints.i1 = 1;
+    ints.i2 = 2;
+    System.out.println($noinline$sumInts(ints));
+
+    Longs longs = new Longs();
+    $noinline$setLongs(longs, 10L, 20L);
+    System.out.println(longs.l1 + longs.l2);
+
+    Doubles doubles = new Doubles();
+    doubles.d1 = 2.5;
+    doubles.d2 = 5.0;
+    System.out.println($noinline$sumDoubles(doubles));
+
+    $noinline$clearInts(ints);
+    System.out.println(ints.i1 + ints.i2);
+
+    Volatiles volatiles = new Volatiles();
+    volatiles.v1 = 1;
+    volatiles.v2 = 2;
+    System.out.println($noinline$sumVolatiles(volatiles));
+
+    try {
+      $noinline$sumInts(null);
+      throw new Error("Expected NullPointerException");
+    } catch (NullPointerException expected) {
+      // The implicit null check of the pair is taken.
+    }
+  }
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+class Base {
+  static int baseValue = 1;
+
+  static {
+    System.out.println("Base.<clinit>");
+  }
+}
+
+class Derived extends Base {
+  static int derivedValue = 2;
+
+  static {
+    System.out.println("Derived.<clinit>");
+  }
+}
+
+public class Main {
+
+  /// CHECK-START: int Main.$noinline$derivedThenBase() clinit_check_elimination (before)
+  /// CHECK:                        ClinitCheck
+  /// CHECK:                        ClinitCheck
+
+  /// CHECK-START: int Main.$noinline$derivedThenBase() clinit_check_elimination (after)
+  /// CHECK:                        ClinitCheck
+  /// CHECK-NOT:                    ClinitCheck
+  static int $noinline$derivedThenBase() {
+    // Initializing Derived initializes Base.
+    return Derived.derivedValue + Base.baseValue;
+  }
+
+  /// CHECK-START: int Main.$noinline$baseThenDerived() clinit_check_elimination (after)
+  /// CHECK:                        ClinitCheck
+  /// CHECK:                        ClinitCheck
+  static int $noinline$baseThenDerived() {
+    // Initializing Base does not initialize Derived.
+    return Base.baseValue + Derived.derivedValue;
+  }
+
+  public static void main(String[] args) {
+    System.out.println($noinline$derivedThenBase());
+    System.out.println($noinline$baseThenDerived());
+  }
+}
@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+//
+// Test on loop-based dynamic bounds check elimination for non-unit strides.
+//
+public class Main {
+
+  /// CHECK-START: int Main.sumPairs(int[], int) BCE (before)
+  /// CHECK-DAG: BoundsCheck loop:<<Loop:B\d+>>
+  /// CHECK-DAG: BoundsCheck loop:<<Loop>>
+  //
+  /// CHECK-START: int Main.sumPairs(int[], int) BCE (after)
+  /// CHECK-DAG: Deoptimize loop:none
+  //
+  /// CHECK-START: int Main.sumPairs(int[], int) BCE (after)
+  /// CHECK-NOT: BoundsCheck
+  private static int sumPairs(int[] a, int n) {
+    int result = 0;
+    for (int i = 0; i < n; i += 2) {
+      result += a[i] * a[i + 1];
+    }
+    return result;
+  }
+
+  /// CHECK-START: int Main.sumRgb(int[], int) BCE (before)
+  /// CHECK-DAG: BoundsCheck loop:<<Loop:B\d+>>
+  /// CHECK-DAG: BoundsCheck loop:<<Loop>>
+  /// CHECK-DAG: BoundsCheck loop:<<Loop>>
+  //
+  /// CHECK-START: int Main.sumRgb(int[], int) BCE (after)
+  /// CHECK-DAG: Deoptimize loop:none
+  //
+  /// CHECK-START: int Main.sumRgb(int[], int) BCE (after)
+  /// CHECK-NOT: BoundsCheck
+  private static int sumRgb(int[] a, int lo) {
+    int result = 0;
+    for (int i = lo; i < a.length; i += 3) {
+      result += a[i] + a[i + 1] + a[i + 2];
+    }
+    return result;
+  }
+
+  /// CHECK-START: int Main.sumDown(int[], int) BCE (before)
+  /// CHECK-DAG: BoundsCheck loop:{{B\d+}}
+  //
+  /// CHECK-START: int Main.sumDown(int[], int) BCE (after)
+  /// CHECK-DAG: Deoptimize loop:none
+  //
+  /// CHECK-START: int Main.sumDown(int[], int) BCE (after)
+  /// CHECK-NOT: BoundsCheck
+  private static int sumDown(int[] a, int hi) {
+    int result = 0;
+    for (int i = hi; i >= 0; i -= 2) {
+      result += a[i];
+    }
+    return result;
+  }
+
+  /// CHECK-START: int Main.sumRows(int[][], int) BCE (before)
+  /// CHECK-DAG: BoundsCheck loop:{{B\d+}}
+  //
+  /// CHECK-START: int Main.sumRows(int[][], int) BCE (after)
+  /// CHECK-DAG: Deoptimize
+  //
+  /// CHECK-START: int Main.sumRows(int[][], int) BCE (after)
+  /// CHECK-NOT: BoundsCheck
+  private static int sumRows(int[][] a, int n) {
+    int result = 0;
+    for (int i = 0; i < a.length; i++) {
+      for (int j = 0; j < n; j += 2) {
+        result += a[i][j];
+      }
+    }
+    return result;
+  }
+
+  private static int sumPairsOOB(int[] a, int n) {
+    try {
+      return sumPairs(a, n);
+    } catch (ArrayIndexOutOfBoundsException e) {
+      return -1;
+    }
+  }
+
+  private static int sumRgbOOB(int[] a, int lo) {
+    try {
+      return sumRgb(a, lo);
+    } catch (ArrayIndexOutOfBoundsException e) {
+      return -1;
+    }
+  }
+
+  private static int sumDownOOB(int[] a, int hi) {
+    try {
+      return sumDown(a, hi);
+    } catch (ArrayIndexOutOfBoundsException e) {
+      return -1;
+    }
+  }
+
+  public static void main(String[] args) {
+    int[] x = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12 };
+    int[][] y = { { 1, 2, 3, 4 }, { 5, 6, 7, 8 } };
+
+    expectEquals(0, sumPairs(x, 0));
+    expectEquals(2 + 12 + 30 + 56 + 90 + 132, sumPairs(x, 12));
+    expectEquals(2 + 12 + 30, sumPairs(x, 5));
+    expectEquals(-1, sumPairsOOB(x, 13));
+    // The loop control would wrap around, but an exception is thrown before.
+    expectEquals(-1, sumPairsOOB(x, Integer.MAX_VALUE));
+
+    expectEquals(78, sumRgb(x, 0));
+    expectEquals(78 - 6, sumRgb(x, 3));
+    expectEquals(0, sumRgb(x, 12));
+    expectEquals(-1, sumRgbOOB(x, 1));
+    expectEquals(-1, sumRgbOOB(x, -3));
+    expectEquals(-1, sumRgbOOB(x, Integer.MIN_VALUE));
+
+    expectEquals(0, sumDown(x, -1));
+    expectEquals(12 + 10 + 8 + 6 + 4 + 2, sumDown(x, 11));
+    expectEquals(11 + 9 + 7 + 5 + 3 + 1, sumDown(x, 10));
+    expectEquals(-1, sumDownOOB(x, 12));
+    expectEquals(-1, sumDownOOB(x, Integer.MAX_VALUE));
+
+    expectEquals(1 + 3 + 5 + 7, sumRows(y, 4));
+    expectEquals(1 + 5, sumRows(y, 1));
+
+    System.out.println("passed");
+  }
+
+  private static void expectEquals(int expected, int result) {
+    if (expected != result) {
+      throw new Error("Expected: " + expected + ", found: " + result);
+    }
+  }
+}
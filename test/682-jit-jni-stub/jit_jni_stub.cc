@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <unistd.h>
+
+#include "jni.h"
+
+#include "art_method-inl.h"
+#include "atomic.h"
+#include "jit/jit.h"
+#include "jit/jit_code_cache.h"
+#include "mirror/class-inl.h"
+#include "nativehelper/ScopedUtfChars.h"
+#include "runtime.h"
+#include "scoped_thread_state_change-inl.h"
+
+namespace art {
+
+static Atomic<bool> gWaitingInNative(false);
+static Atomic<bool> gReleaseNative(false);
+
+extern "C" JNIEXPORT jint JNICALL Java_JniStubs_addInts(JNIEnv*, jclass, jint a, jint b) {
+  return a + b;
+}
+
+extern "C" JNIEXPORT jint JNICALL Java_JniStubs_subInts(JNIEnv*, jclass, jint a, jint b) {
+  return a - b;
+}
+
+extern "C" JNIEXPORT jint JNICALL Java_JniStubs_mulInts(JNIEnv*, jobject, jint a, jint b) {
+  return a * b;
+}
+
+extern "C" JNIEXPORT void JNICALL Java_JniStubs_throwRuntimeException(JNIEnv* env,
+                                                                      jclass,
+                                                                      jstring message) {
+  ScopedUtfChars chars(env, message);
+  CHECK(chars.c_str() != nullptr);
+  env->ThrowNew(env->FindClass("java/lang/RuntimeException"), chars.c_str());
+}
+
+extern "C" JNIEXPORT void JNICALL Java_JniStubs_callBack(JNIEnv* env,
+                                                         jclass,
+                                                         jobject runnable) {
+  jclass runnable_class = env->FindClass("java/lang/Runnable");
+  CHECK(runnable_class != nullptr);
+  jmethodID run = env->GetMethodID(runnable_class, "run", "()V");
+  CHECK(run != nullptr);
+  // Any exception thrown by run() is left pending for the stub to deliver.
+  env->CallVoidMethod(runnable, run);
+}
+
+extern "C" JNIEXPORT jint JNICALL Java_JniStubs_waitInNative(JNIEnv*, jclass, jint value) {
+  gWaitingInNative.StoreSequentiallyConsistent(true);
+  while (!gReleaseNative.LoadSequentiallyConsistent()) {
+    usleep(1000);
+  }
+  gReleaseNative.StoreSequentiallyConsistent(false);
+  gWaitingInNative.StoreSequentiallyConsistent(false);
+  return value + 1;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL Java_JniStubs_isWaitingInNative(JNIEnv*, jclass) {
+  return gWaitingInNative.LoadSequentiallyConsistent() ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C" JNIEXPORT void JNICALL Java_JniStubs_releaseNative(JNIEnv*, jclass) {
+  gReleaseNative.StoreSequentiallyConsistent(true);
+}
+
+static ArtMethod* FindMethod(ScopedObjectAccess& soa, jclass cls, const char* name)
+    REQUIRES_SHARED(Locks::mutator_lock_) {
+  ObjPtr<mirror::Class> klass = soa.Decode<mirror::Class>(cls);
+  ArtMethod* method = klass->FindDeclaredDirectMethodByName(name, kRuntimePointerSize);
+  if (method == nullptr) {
+    method = klass->FindDeclaredVirtualMethodByName(name, kRuntimePointerSize);
+  }
+  CHECK(method != nullptr) << "Unable to find method called " << name;
+  return method;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL Java_Main_haveSameEntrypoint(JNIEnv* env,
+                                                                  jclass,
+                                                                  jclass cls,
+                                                                  jstring first_name,
+                                                                  jstring second_name) {
+  ScopedUtfChars first_chars(env, first_name);
+  ScopedUtfChars second_chars(env, second_name);
+  CHECK(first_chars.c_str() != nullptr);
+  CHECK(second_chars.c_str() != nullptr);
+  ScopedObjectAccess soa(env);
+  ArtMethod* first = FindMethod(soa, cls, first_chars.c_str());
+  ArtMethod* second = FindMethod(soa, cls, second_chars.c_str());
+  return (first->GetEntryPointFromQuickCompiledCode() ==
+          second->GetEntryPointFromQuickCompiledCode()) ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C" JNIEXPORT void JNICALL Java_Main_collectJitCodeCache(JNIEnv* env, jclass) {
+  if (!Runtime::Current()->UseJitCompilation()) {
+    return;
+  }
+  jit::JitCodeCache* code_cache = Runtime::Current()->GetJit()->GetCodeCache();
+  ScopedObjectAccess soa(env);
+  // ensureJitCompiled() turns off code collections, allow this one.
+  code_cache->SetGarbageCollectCode(true);
+  code_cache->GarbageCollectCache(soa.Self());
+  code_cache->SetGarbageCollectCode(false);
+}
+
+}  // namespace art
@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+class JniStubs {
+  // The same shorty and flags, these share a JNI stub.
+  static native int addInts(int a, int b);
+  static native int subInts(int a, int b);
+  // The same shorty but not static, this one has its own JNI stub.
+  native int mulInts(int a, int b);
+
+  static native void throwRuntimeException(String message);
+  static native void callBack(Runnable runnable);
+
+  static native int waitInNative(int value);
+  static native boolean isWaitingInNative();
+  static native void releaseNative();
+}
+
+public class Main {
+  static final String[] NATIVE_METHODS = {
+    "addInts", "subInts", "mulInts", "throwRuntimeException", "callBack", "waitInNative"
+  };
+
+  public static void main(String[] args) throws Exception {
+    System.loadLibrary(args[0]);
+    // Through the generic JNI trampoline.
+    runTests();
+    if (hasJit()) {
+      for (String name : NATIVE_METHODS) {
+        ensureJitCompiled(JniStubs.class, name);
+      }
+      expectTrue(haveSameEntrypoint(JniStubs.class, "addInts", "subInts"));
+      expectFalse(haveSameEntrypoint(JniStubs.class, "addInts", "mulInts"));
+    }
+    // Through the compiled JNI stubs.
+    runTests();
+    testCollectionWhileInNative();
+    // Through whatever the entry points are after the collections.
+    runTests();
+    System.out.println("passed");
+  }
+
+  static void runTests() {
+    testCalls();
+    testExceptions();
+    testStackWalk();
+  }
+
+  static void testCalls() {
+    expectEquals(5, JniStubs.addInts(2, 3));
+    expectEquals(-1, JniStubs.subInts(2, 3));
+    expectEquals(6, new JniStubs().mulInts(2, 3));
+  }
+
+  static void testExceptions() {
+    try {
+      JniStubs.throwRuntimeException("from native");
+      throw new Error("Expected RuntimeException");
+    } catch (RuntimeException e) {
+      expectEquals("from native", e.getMessage());
+    }
+    try {
+      JniStubs.callBack(new Runnable() {
+        public void run() {
+          throw new IllegalStateException("from Java");
+        }
+      });
+      throw new Error("Expected IllegalStateException");
+    } catch (IllegalStateException e) {
+      expectEquals("from Java", e.getMessage());
+    }
+  }
+
+  static void testStackWalk() {
+    final StackTraceElement[][] trace = new StackTraceElement[1][];
+    JniStubs.callBack(new Runnable() {
+      public void run() {
+        trace[0] = new Throwable().getStackTrace();
+      }
+    });
+    expectEquals("run", trace[0][0].getMethodName());
+    expectEquals("callBack", trace[0][1].getMethodName());
+    expectTrue(trace[0][1].isNativeMethod());
+    expectEquals("testStackWalk", trace[0][2].getMethodName());
+    expectEquals("runTests", trace[0][3].getMethodName());
+  }
+
+  static void testCollectionWhileInNative() throws Exception {
+    final int[] result = new int[1];
+    Thread thread = new Thread() {
+      public void run() {
+        result[0] = JniStubs.waitInNative(41);
+      }
+    };
+    thread.start();
+    while (!JniStubs.isWaitingInNative()) {
+      Thread.sleep(1);
+    }
+    // Collect enough times for the JNI stubs to be polled and freed, except the one the waiting
+    // thread returns to.
+    for (int i = 0; i < 16; ++i) {
+      collectJitCodeCache();
+    }
+    JniStubs.releaseNative();
+    thread.join();
+    expectEquals(42, result[0]);
+  }
+
+  static void expectEquals(int expected, int actual) {
+    if (expected != actual) {
+      throw new Error("Expected " + expected + ", got " + actual);
+    }
+  }
+
+  static void expectEquals(String expected, String actual) {
+    if (!expected.equals(actual)) {
+      throw new Error("Expected " + expected + ", got " + actual);
+    }
+  }
+
+  static void expectTrue(boolean value) {
+    if (!value) {
+      throw new Error("Expected true");
+    }
+  }
+
+  static void expectFalse(boolean value) {
+    if (value) {
+      throw new Error("Expected false");
+    }
+  }
+
+  private static native boolean hasJit();
+  private static native void ensureJitCompiled(Class<?> cls, String methodName);
+  private static native boolean haveSameEntrypoint(Class<?> cls, String first, String second);
+  private static native void collectJitCodeCache();
+}
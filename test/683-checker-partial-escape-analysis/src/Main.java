@@ -0,0 +1,201 @@
+/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+class Point {
+  int x;
+  int y;
+}
+
+public class Main {
+
+  public static void main(String[] args) {
+    assertIntEquals(-3, $noinline$mergedAllocations(true, 2, 5));
+    assertIntEquals(3, $noinline$mergedAllocations(false, 2, 5));
+
+    assertIntEquals(7, $noinline$escapeOnBranch(false, 7));
+    assertIntEquals(8, $noinline$escapeOnBranch(true, 7));
+    assertIntEquals(8, ((Point) sink).x);
+
+    assertIntEquals(1, $noinline$loopAccumulator(0));
+    assertIntEquals(45, $noinline$loopAccumulator(10));
+
+    assertIntEquals(2 + 6 + 2, $noinline$smallArray(true, 3));
+    assertIntEquals(7 + 0 + 2, $noinline$smallArray(false, 3));
+
+    sink = null;
+    assertIntEquals(2000 * 2001 / 2, $noinline$escapeInLoop(2000));
+    assertIntEquals(1000, ((Point) sink).x);
+
+    assertIntEquals(5, $noinline$storeAfterEscape(true, 5));
+    assertIntEquals(5, ((Point) sink).x);
+    assertIntEquals(6, $noinline$storeAfterEscape(false, 6));
+    assertIntEquals(5, ((Point) sink).x);
+  }
+
+  /// CHECK-START: int Main.$noinline$mergedAllocations(boolean, int, int) partial_escape_analysis (before)
+  /// CHECK:     NewInstance
+  /// CHECK:     NewInstance
+  /// CHECK:     Phi
+  /// CHECK:     InstanceFieldGet
+
+  /// CHECK-START: int Main.$noinline$mergedAllocations(boolean, int, int) partial_escape_analysis (after)
+  /// CHECK-NOT: NewInstance
+  /// CHECK-NOT: InstanceFieldSet
+  /// CHECK-NOT: InstanceFieldGet
+  /// CHECK-NOT: ConstructorFence
+
+  /// CHECK-START: int Main.$noinline$mergedAllocations(boolean, int, int) partial_escape_analysis (after)
+  /// CHECK-DAG: <<X:i\d+>>    Phi
+  /// CHECK-DAG: <<Y:i\d+>>    Phi
+  /// CHECK-DAG: <<Sub:i\d+>>  Sub [<<X>>,<<Y>>]
+  /// CHECK-DAG:               Return [<<Sub>>]
+  static int $noinline$mergedAllocations(boolean cond, int a, int b) {
+    Point p;
+    if (cond) {
+      p = new Point();
+      p.x = a;
+      p.y = b;
+    } else {
+      p = new Point();
+      p.x = b;
+      p.y = a;
+    }
+    return p.x - p.y;
+  }
+
+  // The allocation is only needed on the branch that publishes it. The call in that
+  // branch may modify the object, so the merge reads the field back from it.
+
+  /// CHECK-START: int Main.$noinline$escapeOnBranch(boolean, int) partial_escape_analysis (before)
+  /// CHECK:                     NewInstance
+  /// CHECK:                     If
+
+  /// CHECK-START: int Main.$noinline$escapeOnBranch(boolean, int) partial_escape_analysis (after)
+  /// CHECK-NOT:                 NewInstance
+  /// CHECK:                     If
+  /// CHECK:                     begin_block
+  /// CHECK:     <<New:l\d+>>    NewInstance
+  /// CHECK:                     InstanceFieldSet [<<New>>,{{i\d+}}]
+  /// CHECK:                     StaticFieldSet [{{l\d+}},<<New>>]
+  /// CHECK:                     InvokeStaticOrDirect method_name:Main.$noinline$clobber
+  /// CHECK:     <<Get:i\d+>>    InstanceFieldGet [<<New>>]
+  /// CHECK:                     Phi [{{.*}}<<Get>>{{.*}}]
+  /// CHECK-NOT:                 NewInstance
+  static int $noinline$escapeOnBranch(boolean escape, int value) {
+    Point p = new Point();
+    p.x = value;
+    if (escape) {
+      sink = p;
+      $noinline$clobber();
+    }
+    return p.x;
+  }
+
+  static void $noinline$clobber() {
+    ((Point) sink).x++;
+  }
+
+  /// CHECK-START: int Main.$noinline$loopAccumulator(int) partial_escape_analysis (before)
+  /// CHECK:     NewInstance
+  /// CHECK:     InstanceFieldGet
+
+  /// CHECK-START: int Main.$noinline$loopAccumulator(int) partial_escape_analysis (after)
+  /// CHECK-NOT: NewInstance
+  /// CHECK-NOT: InstanceFieldSet
+  /// CHECK-NOT: InstanceFieldGet
+  static int $noinline$loopAccumulator(int n) {
+    Point p = new Point();
+    p.y = 1;
+    for (int i = 0; i < n; i++) {
+      p.x += i;
+      p.y ^= i & 1;
+    }
+    return p.x + p.y;
+  }
+
+  /// CHECK-START: int Main.$noinline$smallArray(boolean, int) partial_escape_analysis (before)
+  /// CHECK:     NewArray
+  /// CHECK:     ArrayGet
+
+  /// CHECK-START: int Main.$noinline$smallArray(boolean, int) partial_escape_analysis (after)
+  /// CHECK-NOT: NewArray
+  /// CHECK-NOT: ArraySet
+  /// CHECK-NOT: ArrayGet
+  static int $noinline$smallArray(boolean cond, int value) {
+    int[] array = new int[2];
+    array[0] = value;
+    if (cond) {
+      array[0] = value - 1;
+      array[1] = value * 2;
+    } else {
+      array[0] = 7;
+    }
+    return array[0] + array[1] + array.length;
+  }
+
+  // The allocation in the loop body only escapes on a rarely taken branch, so it is
+  // moved there.
+
+  /// CHECK-START: int Main.$noinline$escapeInLoop(int) partial_escape_analysis (before)
+  /// CHECK:                     If
+  /// CHECK:                     NewInstance
+  /// CHECK:                     If
+
+  /// CHECK-START: int Main.$noinline$escapeInLoop(int) partial_escape_analysis (after)
+  /// CHECK:                     If
+  /// CHECK-NOT:                 NewInstance
+  /// CHECK:                     If
+  /// CHECK:                     begin_block
+  /// CHECK:     <<New:l\d+>>    NewInstance
+  /// CHECK:                     StaticFieldSet [{{l\d+}},<<New>>]
+  /// CHECK-NOT:                 NewInstance
+  static int $noinline$escapeInLoop(int n) {
+    int sum = 0;
+    for (int i = 1; i <= n; i++) {
+      Point p = new Point();
+      p.x = i;
+      p.y = i;
+      if (i == 1000) {
+        sink = p;
+      }
+      sum += p.y;
+    }
+    return sum;
+  }
+
+  // The store after the merge must write to the published object, so the allocation
+  // cannot be moved into the branch.
+
+  /// CHECK-START: int Main.$noinline$storeAfterEscape(boolean, int) partial_escape_analysis (after)
+  /// CHECK:     NewInstance
+  /// CHECK:     If
+  static int $noinline$storeAfterEscape(boolean escape, int value) {
+    Point p = new Point();
+    if (escape) {
+      sink = p;
+    }
+    p.x = value;
+    return p.x;
+  }
+
+  static void assertIntEquals(int expected, int result) {
+    if (expected != result) {
+      throw new Error("Expected: " + expected + ", found: " + result);
+    }
+  }
+
+  static Object sink;
+}
@@ -0,0 +1,79 @@
+#! /usr/bin/python3
+#
+# Copyright (C) 2017 The Android Open Source Project
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""
+Generate the Java test file for test 684-osr-huge-method.
+
+The method under test has a hot loop followed by enough straight-line code to
+be above the default huge method threshold of 10000 code units. Each generated
+statement is a mul-int/lit8 and an add-int/lit8, four code units.
+"""
+
+import sys
+from pathlib import Path
+
+NUMBER_OF_STATEMENTS = 3000
+
+MAIN_CLASS_TEMPLATE = """/*
+ * Copyright (C) 2017 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+public class Main {{
+  public static void main(String[] args) {{
+    System.loadLibrary(args[0]);
+    System.out.println($noinline$hugeMethod(0));
+  }}
+
+  public static int $noinline$hugeMethod(int x) {{
+    for (int i = 0; i < 100000; ++i) {{
+      x = x * 31 + i;
+    }}
+    // The interpreter requests an OSR compilation of this method for the hot loop, even
+    // though the method is too big to be compiled otherwise.
+    while (!isInOsrCode("$noinline$hugeMethod")) {{}}
+{statements}
+    return x;
+  }}
+
+  public static native boolean isInOsrCode(String methodName);
+}}
+"""
+
+def main(argv):
+  output_dir = Path(argv[1])
+  if not output_dir.is_dir():
+    print("{} is not a directory".format(output_dir), file=sys.stderr)
+    sys.exit(1)
+  statements = []
+  for i in range(NUMBER_OF_STATEMENTS):
+    statements.append("    x = x * 31 + {};".format(i % 100))
+  with open(output_dir / "Main.java", "w") as main_file:
+    print(MAIN_CLASS_TEMPLATE.format(statements="\n".join(statements)), file=main_file)
+
+if __name__ == "__main__":
+  main(sys.argv)
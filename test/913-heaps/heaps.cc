@@ -830,6 +830,9 @@ using IterateThroughHeapExt = jvmtiError(*)(jvmtiEnv*,
                                             const void*);
 static IterateThroughHeapExt gIterateThroughHeapExt = nullptr;
 
+using IterateThroughHeapBatched = jvmtiError(*)(jvmtiEnv*, jint, jclass, const void*, const void*);
+static IterateThroughHeapBatched gIterateThroughHeapBatched = nullptr;
+
 
 static void FreeExtensionFunctionInfo(jvmtiExtensionFunctionInfo* extensions, jint count) {
   for (size_t i = 0; i != static_cast<size_t>(count); ++i) {
@@ -926,6 +929,24 @@ extern "C" JNIEXPORT void JNICALL Java_art_Test913_checkForExtensionApis(
       CHECK(extensions[i].errors[1] == JVMTI_ERROR_INVALID_CLASS);
       CHECK(extensions[i].errors[2] == JVMTI_ERROR_NULL_POINTER);
     }
+
+    if (strcmp("com.android.art.heap.iterate_through_heap_batched", extensions[i].id) == 0) {
+      CHECK(gIterateThroughHeapBatched == nullptr);
+      gIterateThroughHeapBatched =
+          reinterpret_cast<IterateThroughHeapBatched>(extensions[i].func);
+
+      CHECK_EQ(extensions[i].param_count, 4);
+
+      CHECK_EQ(strcmp("callback", extensions[i].params[2].name), 0);
+      CHECK_EQ(extensions[i].params[2].base_type, JVMTI_TYPE_CVOID);
+      CHECK_EQ(extensions[i].params[2].kind, JVMTI_KIND_IN_PTR);
+      CHECK_EQ(extensions[i].params[2].null_ok, false);
+
+      CHECK_EQ(extensions[i].error_count, 2);
+      CHECK(extensions[i].errors != nullptr);
+      CHECK(extensions[i].errors[0] == JVMTI_ERROR_MUST_POSSESS_CAPABILITY);
+      CHECK(extensions[i].errors[1] == JVMTI_ERROR_NULL_POINTER);
+    }
   }
 
   CHECK(gGetObjectHeapIdFn != nullptr);
@@ -1078,6 +1099,38 @@ extern "C" JNIEXPORT void JNICALL Java_art_Test913_iterateThroughHeapExt(
   CHECK(gFoundExt);
 }
 
+static jint JNICALL HeapIterationBatchedCallback(const jlong* entries,
+                                                 jint count,
+                                                 void* user_data) {
+  // Count the objects tagged at or above the threshold of the extension test.
+  constexpr jlong kThreshold = 30000000;
+  CHECK_GT(count, 0);
+  jint* found = reinterpret_cast<jint*>(user_data);
+  for (jint i = 0; i != count; ++i) {
+    const jlong* entry = &entries[3 * i];
+    CHECK_GT(entry[1], 0);
+    if (entry[2] >= kThreshold) {
+      ++*found;
+    }
+  }
+  return 0;
+}
+
+extern "C" JNIEXPORT jint JNICALL Java_art_Test913_iterateThroughHeapBatched(
+    JNIEnv* env, jclass klass ATTRIBUTE_UNUSED) {
+  CHECK(gIterateThroughHeapBatched != nullptr);
+
+  jint found = 0;
+  jvmtiError ret = gIterateThroughHeapBatched(
+      jvmti_env,
+      JVMTI_HEAP_FILTER_UNTAGGED,
+      nullptr,
+      reinterpret_cast<const void*>(HeapIterationBatchedCallback),
+      &found);
+  JvmtiErrorToException(env, jvmti_env, ret);
+  return found;
+}
+
 extern "C" JNIEXPORT jboolean JNICALL Java_art_Test913_checkInitialized(JNIEnv* env, jclass, jclass c) {
   jint status;
   jvmtiError error = jvmti_env->GetClassStatus(c, &status);
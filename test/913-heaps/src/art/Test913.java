@@ -290,6 +290,12 @@ public class Test913 {
 
     iterateThroughHeapExt();
 
+    // The three objects tagged above are reported in the batches.
+    int batched = iterateThroughHeapBatched();
+    if (batched < 3) {
+      throw new RuntimeException("Expected 3 tagged objects in batches, got " + batched);
+    }
+
     extensionTestHolder = null;
   }
 
@@ -751,4 +757,5 @@ public class Test913 {
   public static native String followReferencesPrimitiveFields(Object initialObject);
 
   private static native void iterateThroughHeapExt();
+  private static native int iterateThroughHeapBatched();
 }
@@ -25,12 +25,24 @@
 #include <assert.h>
 #include <errno.h>
 #include <inttypes.h>
+#include <fcntl.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 #include <time.h>
 #include <unistd.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
 
 /* Version number in the key file.
  * Version 1 uses one byte for the thread id.
@@ -225,6 +237,9 @@ typedef struct Options {
   int32_t outputHtml;
   const char* sortableUrl;
   int32_t threshold;
+  int32_t callTree;
+  const char* foldedFileName;
+  int32_t numThreads;
 } Options;
 
 typedef struct TraceData {
@@ -816,6 +831,24 @@ void sortMethodList(DataKeys* pKeys) {
   qsort(pKeys->methods, pKeys->numMethods, sizeof(MethodEntry), compareMethods);
 }
 
+/*
+ * Parse the key section in pKeys->fileData, and sort the threads and methods.
+ *
+ * Returns the offset of the data section, or -1 if something is wrong.
+ */
+int64_t parseKeyData(DataKeys* pKeys, int32_t verbose) {
+  int64_t offset = 0;
+  offset = parseVersion(pKeys, offset, verbose);
+  offset = parseThreads(pKeys, offset);
+  offset = parseMethods(pKeys, offset);
+  offset = parseEnd(pKeys, offset);
+  if (offset < 0) return -1;
+
+  sortThreadList(pKeys);
+  sortMethodList(pKeys);
+  return offset;
+}
+
 /*
  * Parse the key section, and return a copy of the parsed contents.
  */
@@ -855,11 +888,7 @@ DataKeys* parseKeys(FILE* fp, int32_t verbose) {
     return nullptr;
   }
 
-  offset = 0;
-  offset = parseVersion(pKeys, offset, verbose);
-  offset = parseThreads(pKeys, offset);
-  offset = parseMethods(pKeys, offset);
-  offset = parseEnd(pKeys, offset);
+  offset = parseKeyData(pKeys, verbose);
   if (offset < 0) {
     freeDataKeys(pKeys);
     return nullptr;
@@ -875,9 +904,6 @@ DataKeys* parseKeys(FILE* fp, int32_t verbose) {
   /* Leave fp pointing to the beginning of the data section. */
   fseek(fp, offset, SEEK_SET);
 
-  sortThreadList(pKeys);
-  sortMethodList(pKeys);
-
   /*
    * Dump list of threads.
    */
@@ -2506,18 +2532,545 @@ void createDiff(DataKeys* d1, DataKeys* d2) {
   if (gOptions.outputHtml) printf("</body></html\n");
 }
 
+/*
+ * Fast analysis of large traces.
+ *
+ * The trace is mapped instead of read, the records are sorted into per-thread event arrays by
+ * several threads, and the calls of each thread are aggregated into a call tree whose children
+ * are found through a hash map. The trees can be printed, or written as folded stacks for
+ * flame graph tools.
+ */
+
+/* Two bytes of thread id give at most this many threads. */
+#define MAX_TRACE_THREAD_IDS 65536
+
+typedef struct MappedTrace {
+  const uint8_t* data;
+  size_t size;
+#ifdef _WIN32
+  std::vector<uint8_t> storage;
+#endif
+} MappedTrace;
+
+/*
+ * An event of one thread, as decoded from a data record.
+ */
+typedef struct TraceEvent {
+  uint32_t methodVal;
+  uint32_t time;
+} TraceEvent;
+
+typedef struct CallNode {
+  uint32_t methodId; /* METHOD_ID of the method, 0 for the thread's root */
+  uint32_t depth;
+  uint64_t inclusive;
+  uint64_t exclusive;
+  uint64_t numCalls;
+  std::vector<uint32_t> children;
+} CallNode;
+
+typedef struct MethodStats {
+  uint64_t inclusive; /* not counting recursive calls twice */
+  uint64_t exclusive;
+  uint64_t numCalls;
+} MethodStats;
+
+typedef struct ThreadCallTree {
+  int32_t threadId;
+  uint64_t unmatchedExits;
+  std::vector<CallNode> nodes; /* nodes[0] is the root */
+  std::unordered_map<uint32_t, MethodStats> methods;
+} ThreadCallTree;
+
+bool mapTrace(const char* fileName, MappedTrace* pTrace) {
+#ifdef _WIN32
+  FILE* fp = fopen(fileName, "rb");
+  if (fp == nullptr) return false;
+  if (fseek(fp, 0L, SEEK_END) != 0) {
+    fclose(fp);
+    return false;
+  }
+  long length = ftell(fp);
+  rewind(fp);
+  pTrace->storage.resize(length > 0 ? length : 0);
+  bool ok = length > 0 && fread(pTrace->storage.data(), 1, length, fp) == (size_t) length;
+  fclose(fp);
+  pTrace->data = pTrace->storage.data();
+  pTrace->size = pTrace->storage.size();
+  return ok;
+#else
+  int fd = open(fileName, O_RDONLY);
+  if (fd < 0) return false;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    close(fd);
+    return false;
+  }
+  void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    perror("mmap");
+    return false;
+  }
+  madvise(data, st.st_size, MADV_SEQUENTIAL);
+  pTrace->data = reinterpret_cast<const uint8_t*>(data);
+  pTrace->size = st.st_size;
+  return true;
+#endif
+}
+
+void unmapTrace(MappedTrace* pTrace) {
+#ifndef _WIN32
+  munmap(const_cast<uint8_t*>(pTrace->data), pTrace->size);
+#endif
+  pTrace->data = nullptr;
+  pTrace->size = 0;
+}
+
+/*
+ * Parse the key section at the start of the mapped trace. Only the key section is copied, as
+ * the parser replaces whitespace with NULs.
+ *
+ * Returns the offset of the data section, or -1 if something is wrong.
+ */
+int64_t parseMappedKeys(const MappedTrace* pTrace, DataKeys* pKeys) {
+  const char* text = reinterpret_cast<const char*>(pTrace->data);
+  size_t lineStart = 0;
+  while (lineStart < pTrace->size) {
+    const char* nl = reinterpret_cast<const char*>(
+        memchr(text + lineStart, '\n', pTrace->size - lineStart));
+    if (nl == nullptr) break;
+    size_t lineEnd = nl - text;
+    if (lineEnd - lineStart == 4 && text[lineStart] == TOKEN_CHAR &&
+        strncmp(text + lineStart + 1, "end", 3) == 0) {
+      pKeys->fileLen = lineEnd + 1;
+      pKeys->fileData = new char[pKeys->fileLen];
+      memcpy(pKeys->fileData, text, pKeys->fileLen);
+      return parseKeyData(pKeys, 0);
+    }
+    lineStart = lineEnd + 1;
+  }
+  fprintf(stderr, "ERROR: end of the key section not found\n");
+  return -1;
+}
+
+template <typename T>
+T readLE(const uint8_t* data) {
+  T val = 0;
+  for (size_t i = 0; i < sizeof(T); ++i) {
+    val |= static_cast<T>(data[i]) << (8 * i);
+  }
+  return val;
+}
+
+/*
+ * Run fn(0) to fn(numWorkers - 1), on as many threads.
+ */
+template <typename Fn>
+void runWorkers(int32_t numWorkers, Fn fn) {
+  std::vector<std::thread> workers;
+  for (int32_t i = 1; i < numWorkers; ++i) {
+    workers.emplace_back(fn, i);
+  }
+  fn(0);
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+}
+
+/*
+ * Build the call tree of a thread from its events, in trace order.
+ */
+void buildCallTree(const TraceEvent* events, size_t numEvents, ThreadCallTree* pTree) {
+  typedef struct Frame {
+    uint32_t node;
+    uint32_t entryTime;
+  } Frame;
+  std::vector<CallNode>& nodes = pTree->nodes;
+  std::unordered_map<uint64_t, uint32_t> childIndex;
+  std::vector<Frame> stack;
+
+  nodes.emplace_back();
+  nodes[0] = CallNode{0, 0, 0, 0, 0, {}};
+  pTree->unmatchedExits = 0;
+  if (numEvents == 0) return;
+
+  uint32_t startTime = events[0].time;
+  uint32_t lastTime = startTime;
+  for (size_t i = 0; i < numEvents; ++i) {
+    const TraceEvent& event = events[i];
+    uint32_t current = stack.empty() ? 0 : stack.back().node;
+    /* The times are 32-bit and wrap around; differences are still right. */
+    nodes[current].exclusive += static_cast<uint32_t>(event.time - lastTime);
+    lastTime = event.time;
+
+    uint32_t methodId = METHOD_ID(event.methodVal);
+    if (METHOD_ACTION(event.methodVal) == METHOD_TRACE_ENTER) {
+      uint64_t key = (static_cast<uint64_t>(current) << 32) | methodId;
+      auto it = childIndex.emplace(key, static_cast<uint32_t>(nodes.size()));
+      uint32_t child = it.first->second;
+      if (it.second) {
+        uint32_t depth = nodes[current].depth + 1;
+        nodes.push_back(CallNode{methodId, depth, 0, 0, 0, {}});
+        nodes[current].children.push_back(child);
+      }
+      nodes[child].numCalls++;
+      stack.push_back(Frame{child, event.time});
+    } else if (!stack.empty() && nodes[stack.back().node].methodId == methodId) {
+      const Frame& frame = stack.back();
+      nodes[frame.node].inclusive += static_cast<uint32_t>(event.time - frame.entryTime);
+      stack.pop_back();
+    } else {
+      /* An exit from a method entered before tracing started, or a mismatched record. */
+      pTree->unmatchedExits++;
+    }
+  }
+
+  /* Close the calls that are still on the stack at the end of the trace. */
+  for (const Frame& frame : stack) {
+    nodes[frame.node].inclusive += static_cast<uint32_t>(lastTime - frame.entryTime);
+  }
+  nodes[0].inclusive = static_cast<uint32_t>(lastTime - startTime);
+  nodes[0].numCalls = 1;
+}
+
+/*
+ * Aggregate the nodes of a call tree by method. A recursive call only adds to the inclusive time
+ * of its method if no caller on its path is the same method.
+ */
+void aggregateMethods(ThreadCallTree* pTree) {
+  std::unordered_map<uint32_t, int32_t> onPath;
+  std::vector<std::pair<uint32_t, size_t>> work; /* node, index of the next child to visit */
+  work.emplace_back(0, 0);
+  while (!work.empty()) {
+    uint32_t nodeIndex = work.back().first;
+    size_t nextChild = work.back().second;
+    const CallNode& node = pTree->nodes[nodeIndex];
+    if (nextChild == 0 && nodeIndex != 0) {
+      MethodStats& stats = pTree->methods[node.methodId];
+      stats.exclusive += node.exclusive;
+      stats.numCalls += node.numCalls;
+      if (onPath[node.methodId]++ == 0) {
+        stats.inclusive += node.inclusive;
+      }
+    }
+    if (nextChild < node.children.size()) {
+      work.back().second++;
+      work.emplace_back(node.children[nextChild], 0);
+    } else {
+      if (nodeIndex != 0) onPath[node.methodId]--;
+      work.pop_back();
+    }
+  }
+}
+
+/*
+ * Decode the records of the mapped trace into per-thread call trees, using numWorkers threads.
+ */
+bool analyzeMappedTrace(const MappedTrace* pTrace, int64_t dataOffset, int32_t numWorkers,
+                        std::vector<ThreadCallTree>* pTrees) {
+  if (dataOffset + 16 > static_cast<int64_t>(pTrace->size)) {
+    fprintf(stderr, "ERROR: trace has no data header\n");
+    return false;
+  }
+  const uint8_t* header = pTrace->data + dataOffset;
+  DataHeader dataHeader;
+  dataHeader.magic = readLE<uint32_t>(header);
+  dataHeader.version = readLE<uint16_t>(header + 4);
+  dataHeader.offsetToData = readLE<uint16_t>(header + 6);
+  dataHeader.startWhen = readLE<uint64_t>(header + 8);
+  if (dataHeader.version == 1) {
+    dataHeader.recordSize = 9;
+  } else if (dataHeader.version == 2) {
+    dataHeader.recordSize = 10;
+  } else if (dataHeader.version == 3 && dataOffset + 18 <= static_cast<int64_t>(pTrace->size)) {
+    dataHeader.recordSize = readLE<uint16_t>(header + 16);
+  } else {
+    fprintf(stderr, "Unsupported trace file version: %d\n", dataHeader.version);
+    return false;
+  }
+  const int32_t idSize = dataHeader.version == 1 ? 1 : 2;
+  if (dataHeader.recordSize < idSize + 8) {
+    fprintf(stderr, "ERROR: bad record size %d\n", dataHeader.recordSize);
+    return false;
+  }
+
+  const uint8_t* records = header + dataHeader.offsetToData;
+  const uint8_t* end = pTrace->data + pTrace->size;
+  if (records > end) return false;
+  const size_t recordSize = dataHeader.recordSize;
+  const size_t numRecords = (end - records) / recordSize;
+  if (records + numRecords * recordSize != end) {
+    fprintf(stderr, "WARNING: hit EOF mid-record\n");
+  }
+
+  auto threadIdOf = [&](size_t record) -> uint32_t {
+    const uint8_t* data = records + record * recordSize;
+    return idSize == 1 ? data[0] : readLE<uint16_t>(data);
+  };
+  auto chunkBegin = [&](int32_t worker) -> size_t {
+    return numRecords / numWorkers * worker + std::min<size_t>(worker, numRecords % numWorkers);
+  };
+
+  /* Count the records of each thread in each worker's chunk of records. */
+  std::vector<std::vector<size_t>> offsets(numWorkers);
+  runWorkers(numWorkers, [&](int32_t worker) {
+    std::vector<size_t>& counts = offsets[worker];
+    counts.assign(MAX_TRACE_THREAD_IDS, 0);
+    for (size_t i = chunkBegin(worker), e = chunkBegin(worker + 1); i < e; ++i) {
+      counts[threadIdOf(i)]++;
+    }
+  });
+
+  /* Lay out the events of each thread back to back, keeping the record order. */
+  std::vector<size_t> threadBegin(MAX_TRACE_THREAD_IDS + 1);
+  size_t total = 0;
+  for (int32_t threadId = 0; threadId < MAX_TRACE_THREAD_IDS; ++threadId) {
+    threadBegin[threadId] = total;
+    for (int32_t worker = 0; worker < numWorkers; ++worker) {
+      size_t count = offsets[worker][threadId];
+      offsets[worker][threadId] = total;
+      total += count;
+    }
+  }
+  threadBegin[MAX_TRACE_THREAD_IDS] = total;
+
+  std::vector<TraceEvent> events(numRecords);
+  runWorkers(numWorkers, [&](int32_t worker) {
+    std::vector<size_t>& next = offsets[worker];
+    for (size_t i = chunkBegin(worker), e = chunkBegin(worker + 1); i < e; ++i) {
+      const uint8_t* data = records + i * recordSize;
+      TraceEvent& event = events[next[threadIdOf(i)]++];
+      event.methodVal = readLE<uint32_t>(data + idSize);
+      event.time = readLE<uint32_t>(data + idSize + 4);
+    }
+  });
+
+  for (int32_t threadId = 0; threadId < MAX_TRACE_THREAD_IDS; ++threadId) {
+    if (threadBegin[threadId + 1] != threadBegin[threadId]) {
+      pTrees->emplace_back();
+      pTrees->back().threadId = threadId;
+    }
+  }
+
+  /* Build the call trees, handing out threads to the workers as they become idle. */
+  std::atomic<size_t> nextTree(0);
+  runWorkers(numWorkers, [&](int32_t) {
+    for (size_t i = nextTree++; i < pTrees->size(); i = nextTree++) {
+      ThreadCallTree* pTree = &(*pTrees)[i];
+      size_t begin = threadBegin[pTree->threadId];
+      buildCallTree(&events[begin], threadBegin[pTree->threadId + 1] - begin, pTree);
+      aggregateMethods(pTree);
+    }
+  });
+  return true;
+}
+
+const char* lookupThreadName(DataKeys* pKeys, int32_t threadId) {
+  for (int32_t i = 0; i < pKeys->numThreads; ++i) {
+    if (pKeys->threads[i].threadId == threadId) return pKeys->threads[i].threadName;
+  }
+  return nullptr;
+}
+
+/*
+ * Returns "class.method" for the method.
+ */
+std::string methodDisplayName(DataKeys* pKeys, uint32_t methodId) {
+  MethodEntry* method = lookupMethod(pKeys, methodId);
+  std::string name;
+  if (method == nullptr) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "(unknown 0x%x)", methodId);
+    name = buf;
+  } else if (method->methodName != nullptr) {
+    name = std::string(method->className) + "." + method->methodName;
+  } else {
+    name = method->className;
+  }
+  return name;
+}
+
+std::string threadDisplayName(DataKeys* pKeys, int32_t threadId) {
+  const char* threadName = lookupThreadName(pKeys, threadId);
+  char buf[32];
+  snprintf(buf, sizeof(buf), "[%d]", threadId);
+  return threadName != nullptr ? std::string(threadName) + " " + buf : buf;
+}
+
+/*
+ * Returns the name with ';' replaced, so that it can be a frame of a folded stack.
+ */
+std::string foldedFrameName(std::string name) {
+  std::replace(name.begin(), name.end(), ';', ':');
+  return name;
+}
+
+/*
+ * Print the methods by exclusive time, then each thread's call tree with the most expensive
+ * calls first.
+ */
+void printCallTrees(FILE* out, DataKeys* pKeys, std::vector<ThreadCallTree>& trees) {
+  std::unordered_map<uint32_t, MethodStats> methods;
+  uint64_t sumThreadTime = 0;
+  for (ThreadCallTree& tree : trees) {
+    sumThreadTime += tree.nodes[0].inclusive;
+    for (const auto& entry : tree.methods) {
+      MethodStats& stats = methods[entry.first];
+      stats.inclusive += entry.second.inclusive;
+      stats.exclusive += entry.second.exclusive;
+      stats.numCalls += entry.second.numCalls;
+    }
+  }
+  std::vector<std::pair<uint32_t, MethodStats>> sorted(methods.begin(), methods.end());
+  std::sort(sorted.begin(), sorted.end(),
+            [](const std::pair<uint32_t, MethodStats>& a,
+               const std::pair<uint32_t, MethodStats>& b) {
+              return a.second.exclusive > b.second.exclusive;
+            });
+  double total = sumThreadTime != 0 ? sumThreadTime : 1;
+  fprintf(out, "Total cycles: %" PRIu64 "\n\n", sumThreadTime);
+  fprintf(out, "   Excl    Excl%%     Incl    Incl%%      Calls  Method\n");
+  for (const auto& entry : sorted) {
+    fprintf(out, "%7" PRIu64 " %7.2f%% %8" PRIu64 " %7.2f%% %10" PRIu64 "  %s\n",
+            entry.second.exclusive, 100.0 * entry.second.exclusive / total,
+            entry.second.inclusive, 100.0 * entry.second.inclusive / total,
+            entry.second.numCalls, methodDisplayName(pKeys, entry.first).c_str());
+  }
+
+  std::unordered_map<uint32_t, std::string> names;
+  for (ThreadCallTree& tree : trees) {
+    std::vector<CallNode>& nodes = tree.nodes;
+    fprintf(out, "\n%s: %" PRIu64 " cycles", threadDisplayName(pKeys, tree.threadId).c_str(),
+            nodes[0].inclusive);
+    if (tree.unmatchedExits != 0) {
+      fprintf(out, " (%" PRIu64 " unmatched exits)", tree.unmatchedExits);
+    }
+    fprintf(out, "\n      Incl     Excl      Calls  Method\n");
+    std::vector<uint32_t> work(nodes[0].children.rbegin(), nodes[0].children.rend());
+    while (!work.empty()) {
+      CallNode& node = nodes[work.back()];
+      work.pop_back();
+      auto it = names.find(node.methodId);
+      if (it == names.end()) {
+        it = names.emplace(node.methodId, methodDisplayName(pKeys, node.methodId)).first;
+      }
+      fprintf(out, "%10" PRIu64 " %8" PRIu64 " %10" PRIu64 "  %*s%s\n", node.inclusive,
+              node.exclusive, node.numCalls, 2 * (node.depth - 1), "", it->second.c_str());
+      std::sort(node.children.begin(), node.children.end(), [&](uint32_t a, uint32_t b) {
+        return nodes[a].inclusive < nodes[b].inclusive;
+      });
+      work.insert(work.end(), node.children.begin(), node.children.end());
+    }
+  }
+}
+
+/*
+ * Write one "thread;caller;...;callee exclusive-time" line per call path, the input format of
+ * flamegraph.pl and most other flame graph tools.
+ */
+void writeFoldedStacks(FILE* out, DataKeys* pKeys, const std::vector<ThreadCallTree>& trees) {
+  std::unordered_map<uint32_t, std::string> names;
+  for (const ThreadCallTree& tree : trees) {
+    const std::vector<CallNode>& nodes = tree.nodes;
+    std::string path = foldedFrameName(threadDisplayName(pKeys, tree.threadId));
+    std::vector<size_t> pathLengths;
+    std::vector<std::pair<uint32_t, size_t>> work; /* node, index of the next child to visit */
+    if (nodes[0].exclusive != 0) {
+      fprintf(out, "%s %" PRIu64 "\n", path.c_str(), nodes[0].exclusive);
+    }
+    work.emplace_back(0, 0);
+    while (!work.empty()) {
+      const CallNode& node = nodes[work.back().first];
+      size_t nextChild = work.back().second;
+      if (nextChild == node.children.size()) {
+        work.pop_back();
+        if (!pathLengths.empty()) {
+          path.resize(pathLengths.back());
+          pathLengths.pop_back();
+        }
+        continue;
+      }
+      work.back().second++;
+      uint32_t childIndex = node.children[nextChild];
+      const CallNode& child = nodes[childIndex];
+      auto it = names.find(child.methodId);
+      if (it == names.end()) {
+        std::string name = foldedFrameName(methodDisplayName(pKeys, child.methodId));
+        it = names.emplace(child.methodId, name).first;
+      }
+      pathLengths.push_back(path.size());
+      path += ';';
+      path += it->second;
+      if (child.exclusive != 0) {
+        fprintf(out, "%s %" PRIu64 "\n", path.c_str(), child.exclusive);
+      }
+      work.emplace_back(childIndex, 0);
+    }
+  }
+}
+
+/*
+ * Analyze the trace with the fast path, and print the requested call trees and folded stacks.
+ */
+int32_t analyzeTrace() {
+  MappedTrace trace;
+  if (!mapTrace(gOptions.traceFileName, &trace)) {
+    fprintf(stderr, "Cannot read \"%s\".\n", gOptions.traceFileName);
+    return 1;
+  }
+  DataKeys* pKeys = new DataKeys();
+  memset(pKeys, 0, sizeof(DataKeys));
+  int64_t dataOffset = parseMappedKeys(&trace, pKeys);
+  std::vector<ThreadCallTree> trees;
+  int32_t numWorkers = gOptions.numThreads;
+  if (numWorkers <= 0) {
+    numWorkers = std::max<int32_t>(1, std::thread::hardware_concurrency());
+  }
+  if (dataOffset < 0 || !analyzeMappedTrace(&trace, dataOffset, numWorkers, &trees)) {
+    freeDataKeys(pKeys);
+    unmapTrace(&trace);
+    return 1;
+  }
+  unmapTrace(&trace);
+
+  int32_t result = 0;
+  if (gOptions.foldedFileName != nullptr) {
+    FILE* out = fopen(gOptions.foldedFileName, "w");
+    if (out == nullptr) {
+      fprintf(stderr, "Cannot write \"%s\".\n", gOptions.foldedFileName);
+      result = 1;
+    } else {
+      writeFoldedStacks(out, pKeys, trees);
+      fclose(out);
+    }
+  }
+  if (gOptions.callTree) {
+    printCallTrees(stdout, pKeys, trees);
+  }
+  freeDataKeys(pKeys);
+  return result;
+}
+
 int32_t usage(const char* program) {
   fprintf(stderr, "Copyright (C) 2006 The Android Open Source Project\n\n");
   fprintf(stderr,
-          "usage: %s [-ho] [-s sortable] [-d trace-file-name] [-g outfile] "
-          "trace-file-name\n",
+          "usage: %s [-cho] [-s sortable] [-d trace-file-name] [-g outfile] "
+          "[-f outfile] [-j threads] trace-file-name\n",
           program);
+  fprintf(stderr, "  -c                  - Print the call tree of each thread\n");
   fprintf(stderr, "  -d trace-file-name  - Diff with this trace\n");
+  fprintf(stderr,
+          "  -f outfile          - Write folded stacks for flame graphs to "
+          "'outfile'\n");
   fprintf(stderr, "  -g outfile          - Write graph to 'outfile'\n");
   fprintf(stderr,
           "  -k                  - When writing a graph, keep the intermediate "
           "DOT file\n");
   fprintf(stderr, "  -h                  - Turn on HTML output\n");
+  fprintf(stderr,
+          "  -j threads          - Number of threads for -c and -f (default: "
+          "one per CPU)\n");
   fprintf(
       stderr,
       "  -o                  - Dump the dmtrace file instead of profiling\n");
@@ -2533,12 +3086,18 @@ int32_t usage(const char* program) {
 // Returns true if there was an error
 int32_t parseOptions(int32_t argc, char** argv) {
   while (1) {
-    int32_t opt = getopt(argc, argv, "d:hg:kos:t:");
+    int32_t opt = getopt(argc, argv, "cd:f:hg:j:kos:t:");
     if (opt == -1) break;
     switch (opt) {
+      case 'c':
+        gOptions.callTree = 1;
+        break;
       case 'd':
         gOptions.diffFileName = optarg;
         break;
+      case 'f':
+        gOptions.foldedFileName = optarg;
+        break;
       case 'g':
         gOptions.graphFileName = optarg;
         break;
@@ -2548,6 +3107,9 @@ int32_t parseOptions(int32_t argc, char** argv) {
       case 'h':
         gOptions.outputHtml = 1;
         break;
+      case 'j':
+        gOptions.numThreads = atoi(optarg);
+        break;
       case 'o':
         gOptions.dump = 1;
         break;
@@ -2584,6 +3146,10 @@ int32_t main(int32_t argc, char** argv) {
     return 0;
   }
 
+  if (gOptions.callTree || gOptions.foldedFileName != nullptr) {
+    return analyzeTrace();
+  }
+
   uint64_t sumThreadTime = 0;
 
   TraceData data1;